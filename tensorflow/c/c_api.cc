@@ -55,6 +55,7 @@ limitations under the License.
 #include "tensorflow/core/framework/full_type.pb.h"
 #include "tensorflow/core/framework/kernel_def.pb.h"
 #include "tensorflow/core/framework/log_memory.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -70,6 +71,7 @@ limitations under the License.
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -435,6 +437,7 @@ static void TF_Run_Helper(
   const int noutputs = output_tensor_names.size();
   std::vector<Tensor> outputs(noutputs);
   Status result;
+  const uint64_t run_start_usecs = tensorflow::Env::Default()->NowMicros();
 
   if (handle == nullptr) {
     RunOptions run_options_proto;
@@ -466,8 +469,13 @@ static void TF_Run_Helper(
     status->status = result;
     return;
   }
+  const uint64_t outputs_start_usecs = tensorflow::Env::Default()->NowMicros();
+  tensorflow::metrics::RecordCApiSessionRunStage(
+      "run", outputs_start_usecs - run_start_usecs);
+  tensorflow::metrics::RecordCApiTensors("fed", input_pairs.size());
+  tensorflow::metrics::RecordCApiTensors("fetched", noutputs);
 
-  // Store results in c_outputs[]
+  // Store results in c_outputs[]. They share the buffers of the outputs.
   for (int i = 0; i < noutputs; ++i) {
     const Tensor& src = outputs[i];
     if (!src.IsInitialized() || src.NumElements() == 0) {
@@ -478,6 +486,8 @@ static void TF_Run_Helper(
     c_outputs[i] = TF_TensorFromTensor(src, &status->status);
     if (!status->status.ok()) return;
   }
+  tensorflow::metrics::RecordCApiSessionRunStage(
+      "outputs", tensorflow::Env::Default()->NowMicros() - outputs_start_usecs);
 }
 
 extern "C" {
@@ -2342,9 +2352,14 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
 
   TF_Run_Setup(noutputs, output_values, status);
 
-  // Convert from TF_Output and TF_Tensor to a string and Tensor.
+  // Convert from TF_Output and TF_Tensor to a string and Tensor. The tensors
+  // share the buffers of the TF_Tensors.
+  const uint64_t inputs_start_usecs = tensorflow::Env::Default()->NowMicros();
   std::vector<std::pair<string, Tensor>> input_pairs(ninputs);
   if (!TF_Run_Inputs(input_values, &input_pairs, status)) return;
+  const uint64_t names_start_usecs = tensorflow::Env::Default()->NowMicros();
+  tensorflow::metrics::RecordCApiSessionRunStage(
+      "inputs", names_start_usecs - inputs_start_usecs);
   for (int i = 0; i < ninputs; ++i) {
     input_pairs[i].first = OutputName(inputs[i]);
   }
@@ -2360,6 +2375,8 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
   for (int i = 0; i < ntargets; ++i) {
     target_names[i] = target_opers[i]->node.name();
   }
+  tensorflow::metrics::RecordCApiSessionRunStage(
+      "names", tensorflow::Env::Default()->NowMicros() - names_start_usecs);
 
   // Actually run.
   TF_Run_Helper(session->session, nullptr, run_options, input_pairs,
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/pluggable_device/pluggable_device_plugin_init.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_server_lib.h"
 #include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -764,3 +765,37 @@ void TF_GraphRemoveFunction(TF_Graph* g, const char* func_name,
   tensorflow::mutex_lock l(g->mu);
   status->status = g->graph.mutable_flib_def()->RemoveFunction(func_name);
 }
+
+void TF_GetSessionRunStageLatencies(const char* stage, TF_Buffer* histogram,
+                                    TF_Status* status) {
+  const tensorflow::StringPiece name(stage);
+  if (name != "inputs" && name != "names" && name != "run" &&
+      name != "outputs") {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Unknown session run stage: ", name);
+    return;
+  }
+  status->status = MessageToBuffer(
+      tensorflow::metrics::GetCApiSessionRunStageLatencies(string(name)),
+      histogram);
+}
+
+int64_t TF_GetSessionRunCount(const char* name) {
+  const tensorflow::StringPiece count(name);
+  if (count == "fed_tensors") {
+    return tensorflow::metrics::GetCApiTensors("fed");
+  } else if (count == "fetched_tensors") {
+    return tensorflow::metrics::GetCApiTensors("fetched");
+  } else if (count == "copied_tensors") {
+    return tensorflow::metrics::GetCApiTensors("copied");
+  } else if (count == "run_executors_reused") {
+    return tensorflow::metrics::GetSessionExecutorsLookups("run", true);
+  } else if (count == "run_executors_created") {
+    return tensorflow::metrics::GetSessionExecutorsLookups("run", false);
+  } else if (count == "callable_executors_reused") {
+    return tensorflow::metrics::GetSessionExecutorsLookups("callable", true);
+  } else if (count == "callable_executors_created") {
+    return tensorflow::metrics::GetSessionExecutorsLookups("callable", false);
+  }
+  return -1;
+}
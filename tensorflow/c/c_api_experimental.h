@@ -317,6 +317,31 @@ TF_CAPI_EXPORT extern void TF_GraphRemoveFunction(TF_Graph* g,
                                                   const char* func_name,
                                                   TF_Status* status);
 
+// Sets `histogram` to a serialized HistogramProto of the time in microseconds
+// that the session runs of the process spent in `stage` of the C API:
+// "inputs" (converting the feeds) and "names" (building the feed, fetch and
+// target names), which TF_SessionRun records, and "run" (running the session)
+// and "outputs" (converting the fetches), which all the run functions record.
+// Fails if `stage` is not one of those.
+TF_CAPI_EXPORT extern void TF_GetSessionRunStageLatencies(const char* stage,
+                                                          TF_Buffer* histogram,
+                                                          TF_Status* status);
+
+// Returns the count `name` of the session runs of the process, or -1 if there
+// is no such count:
+//   "fed_tensors", "fetched_tensors": tensors fed to and fetched from session
+//     runs through the C API.
+//   "copied_tensors": buffers that TF_NewTensor copied because they were not
+//     aligned to TF_TensorDefaultAlignment(). Aligned buffers are used without
+//     a copy.
+//   "run_executors_reused", "run_executors_created": runs that reused the
+//     executors of an earlier run with the same feeds, fetches and targets, or
+//     created them.
+//   "callable_executors_reused", "callable_executors_created": runs of
+//     callables, which reuse the executors of the callable, and callables
+//     made, which create them.
+TF_CAPI_EXPORT extern int64_t TF_GetSessionRunCount(const char* name);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
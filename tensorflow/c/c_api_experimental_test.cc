@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/c/c_test_util.h"
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/c_api_test_util.h"
+#include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -361,5 +362,50 @@ TEST_F(CApiExperimentalFunctionTest, GraphRemoveNonExistentFunction) {
   TF_DeleteFunction(funcs[0]);
 }
 
+TEST(CAPI_EXPERIMENTAL, SessionRunMetrics) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  const int64_t fed = TF_GetSessionRunCount("fed_tensors");
+  const int64_t fetched = TF_GetSessionRunCount("fetched_tensors");
+  const int64_t reused = TF_GetSessionRunCount("run_executors_reused");
+  CSession csession(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  for (int i = 0; i < 2; ++i) {
+    csession.SetInputs({{feed, Int32Tensor(i)}});
+    csession.SetOutputs({add});
+    csession.Run(s);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    EXPECT_EQ(i + 2, *static_cast<int32_t*>(
+                         TF_TensorData(csession.output_tensor(0))));
+  }
+  EXPECT_EQ(fed + 2, TF_GetSessionRunCount("fed_tensors"));
+  EXPECT_EQ(fetched + 2, TF_GetSessionRunCount("fetched_tensors"));
+  EXPECT_GT(TF_GetSessionRunCount("run_executors_reused"), reused);
+  EXPECT_EQ(-1, TF_GetSessionRunCount("unknown"));
+
+  TF_Buffer* buffer = TF_NewBuffer();
+  TF_GetSessionRunStageLatencies("run", buffer, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  HistogramProto histogram;
+  ASSERT_TRUE(histogram.ParseFromArray(buffer->data, buffer->length));
+  EXPECT_GE(histogram.num(), 2);
+  TF_DeleteBuffer(buffer);
+
+  TF_GetSessionRunStageLatencies("unknown", nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s));
+
+  csession.CloseAndDelete(s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 }  // namespace
 }  // namespace tensorflow
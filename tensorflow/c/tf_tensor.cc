@@ -30,6 +30,12 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/platform/casts.h"
+// Required for IS_MOBILE_PLATFORM
+#include "tensorflow/core/platform/platform.h"  // NOLINT
+
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/framework/metrics.h"
+#endif  // !defined(IS_MOBILE_PLATFORM)
 
 using tensorflow::Status;
 using tensorflow::Tensor;
@@ -122,6 +128,9 @@ TF_Tensor* TF_NewTensor(TF_DataType dtype, const int64_t* dims, int num_dims,
     std::memcpy(buf->data(), data, len);
     // Free the original buffer.
     deallocator(data, len, deallocator_arg);
+#if !defined(IS_MOBILE_PLATFORM)
+    tensorflow::metrics::RecordCApiTensors("copied", 1);
+#endif  // !defined(IS_MOBILE_PLATFORM)
   } else {
     buf = new TF_ManagedBuffer(data, len, deallocator, deallocator_arg,
                                /*owns_memory=*/false);
@@ -0,0 +1,376 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/direct_restore.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/resource_handle.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/protobuf/saver.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace internal {
+namespace {
+
+// The checkpoint is read with reads of about this size, on this many threads.
+constexpr int64_t kReadSize = 16 << 20;
+constexpr int kNumReadThreads = 8;
+
+// The nodes of the graph of the MetaGraphDef, or of the body of a function
+// called by the restore op.
+struct Scope {
+  absl::flat_hash_map<absl::string_view, const NodeDef*> nodes;
+  // For a function body, the scope of the call of the function, and the
+  // inputs of the call by the names of the arguments of the function.
+  const Scope* caller = nullptr;
+  absl::flat_hash_map<absl::string_view, absl::string_view> args;
+};
+
+// An output of a node of a scope.
+struct Output {
+  const Scope* scope = nullptr;
+  const NodeDef* node = nullptr;
+  int index = 0;
+};
+
+// A variable assigned by the restore op.
+struct RestoredVariable {
+  const NodeDef* handle;  // The VarHandleOp of the variable.
+  std::string container;
+  std::string shared_name;
+  DataType dtype;
+  std::string key;  // The key of the tensor of the variable in the checkpoint.
+};
+
+// Collects the variables restored by the restore op of a SaverDef.
+class RestoreAnalyzer {
+ public:
+  explicit RestoreAnalyzer(const MetaGraphDef& meta_graph)
+      : meta_graph_(meta_graph) {
+    for (const NodeDef& node : meta_graph.graph_def().node()) {
+      graph_.nodes[node.name()] = &node;
+    }
+    for (const FunctionDef& fdef :
+         meta_graph.graph_def().library().function()) {
+      functions_[fdef.signature().name()] = &fdef;
+    }
+  }
+
+  // Returns false if the restore op does anything but assigning the tensors
+  // of the checkpoint to resource variables.
+  bool Analyze(std::vector<RestoredVariable>* variables);
+
+ private:
+  // Returns the output that `input` of a node of `scope` refers to, looking
+  // through Identity nodes and arguments of functions, or an Output without a
+  // node if it isn't a data input of a known node.
+  Output Resolve(const Scope& scope, absl::string_view input) const;
+
+  // Returns the value of the string Const that `input` refers to, or nullptr.
+  const Tensor* GetStringConst(const Scope& scope, absl::string_view input);
+
+  bool AddAssign(const Scope& scope, const NodeDef& assign);
+  bool AddCall(const Scope& scope, const NodeDef& call);
+
+  const MetaGraphDef& meta_graph_;
+  Scope graph_;
+  absl::flat_hash_map<absl::string_view, const FunctionDef*> functions_;
+  // The bodies of the called functions. A deque keeps them in place.
+  std::deque<Scope> bodies_;
+  // The node of the filename tensor of the SaverDef.
+  const NodeDef* filename_ = nullptr;
+  absl::flat_hash_map<const NodeDef*, Tensor> consts_;
+  std::vector<RestoredVariable> variables_;
+};
+
+bool RestoreAnalyzer::Analyze(std::vector<RestoredVariable>* variables) {
+  const SaverDef& saver_def = meta_graph_.saver_def();
+  const auto filename_it = graph_.nodes.find(
+      ParseTensorName(saver_def.filename_tensor_name()).node());
+  if (filename_it == graph_.nodes.end()) return false;
+  filename_ = filename_it->second;
+
+  // Goes through the restore op and its control dependencies. The data inputs
+  // of the assignments and calls are checked by AddAssign() and AddCall().
+  std::vector<absl::string_view> stack = {saver_def.restore_op_name()};
+  absl::flat_hash_set<absl::string_view> visited;
+  while (!stack.empty()) {
+    const absl::string_view name = ParseTensorName(stack.back()).node();
+    stack.pop_back();
+    if (!visited.insert(name).second) continue;
+    const auto it = graph_.nodes.find(name);
+    if (it == graph_.nodes.end()) return false;
+    const NodeDef& node = *it->second;
+    if (node.op() == "AssignVariableOp") {
+      if (!AddAssign(graph_, node)) return false;
+    } else if (node.op() == "StatefulPartitionedCall" ||
+               node.op() == "PartitionedCall") {
+      if (!AddCall(graph_, node)) return false;
+    } else if (node.op() != "NoOp") {
+      return false;
+    }
+    for (const std::string& input : node.input()) {
+      if (absl::StartsWith(input, "^")) stack.push_back(input);
+    }
+  }
+  *variables = std::move(variables_);
+  return true;
+}
+
+Output RestoreAnalyzer::Resolve(const Scope& scope,
+                                absl::string_view input) const {
+  const Scope* current = &scope;
+  while (!absl::StartsWith(input, "^")) {
+    absl::string_view name;
+    int index = 0;
+    if (current->caller == nullptr) {
+      const TensorId id = ParseTensorName(input);
+      name = id.node();
+      index = id.index();
+    } else {
+      // In a function body, an input is an argument of the function, or of
+      // the form "node:output:index".
+      const std::vector<absl::string_view> parts = absl::StrSplit(input, ':');
+      if (parts.size() == 1) {
+        const auto it = current->args.find(input);
+        if (it == current->args.end()) return {};
+        input = it->second;
+        current = current->caller;
+        continue;
+      }
+      if (parts.size() != 3 || !absl::SimpleAtoi(parts[2], &index)) return {};
+      name = parts[0];
+    }
+    const auto it = current->nodes.find(name);
+    if (it == current->nodes.end()) return {};
+    const NodeDef* node = it->second;
+    if (node->op() == "Identity" && index == 0 && node->input_size() > 0) {
+      input = node->input(0);
+      continue;
+    }
+    return {current, node, index};
+  }
+  return {};
+}
+
+const Tensor* RestoreAnalyzer::GetStringConst(const Scope& scope,
+                                              absl::string_view input) {
+  const Output output = Resolve(scope, input);
+  if (output.node == nullptr || output.node->op() != "Const") return nullptr;
+  auto it = consts_.find(output.node);
+  if (it == consts_.end()) {
+    Tensor value;
+    if (!GetNodeAttr(*output.node, "value", &value).ok() ||
+        value.dtype() != DT_STRING) {
+      return nullptr;
+    }
+    it = consts_.emplace(output.node, std::move(value)).first;
+  }
+  return &it->second;
+}
+
+bool RestoreAnalyzer::AddAssign(const Scope& scope, const NodeDef& assign) {
+  if (assign.input_size() < 2) return false;
+  const Output handle = Resolve(scope, assign.input(0));
+  if (handle.node == nullptr || handle.node->op() != "VarHandleOp") {
+    return false;
+  }
+  RestoredVariable variable;
+  variable.handle = handle.node;
+  DataType dtype;
+  if (!TryGetNodeAttr(*handle.node, "container", &variable.container) ||
+      !TryGetNodeAttr(*handle.node, "shared_name", &variable.shared_name) ||
+      variable.shared_name == ResourceHandle::ANONYMOUS_NAME ||
+      !GetNodeAttr(*handle.node, "dtype", &variable.dtype).ok() ||
+      !GetNodeAttr(assign, "dtype", &dtype).ok() || dtype != variable.dtype) {
+    return false;
+  }
+
+  // The value must be a full tensor read from the checkpoint.
+  const Output value = Resolve(scope, assign.input(1));
+  if (value.node == nullptr || value.node->op() != "RestoreV2" ||
+      value.node->input_size() < 3 || value.index < 0) {
+    return false;
+  }
+  if (Resolve(*value.scope, value.node->input(0)).node != filename_) {
+    return false;
+  }
+  const Tensor* names = GetStringConst(*value.scope, value.node->input(1));
+  const Tensor* slices = GetStringConst(*value.scope, value.node->input(2));
+  if (names == nullptr || slices == nullptr ||
+      value.index >= names->NumElements() ||
+      value.index >= slices->NumElements() ||
+      !slices->flat<tstring>()(value.index).empty()) {
+    return false;
+  }
+  variable.key = names->flat<tstring>()(value.index);
+  variables_.push_back(std::move(variable));
+  return true;
+}
+
+bool RestoreAnalyzer::AddCall(const Scope& scope, const NodeDef& call) {
+  const NameAttrList* f;
+  if (!TryGetNodeAttr(call, "f", &f)) return false;
+  const auto it = functions_.find(f->name());
+  if (it == functions_.end()) return false;
+  const FunctionDef& fdef = *it->second;
+  const OpDef& signature = fdef.signature();
+  if (call.input_size() < signature.input_arg_size()) return false;
+
+  Scope& body = bodies_.emplace_back();
+  body.caller = &scope;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    const OpDef::ArgDef& arg = signature.input_arg(i);
+    if (!arg.number_attr().empty() || !arg.type_list_attr().empty()) {
+      return false;
+    }
+    body.args[arg.name()] = call.input(i);
+  }
+  for (const NodeDef& node : fdef.node_def()) {
+    body.nodes[node.name()] = &node;
+  }
+  // As functions run all of their stateful nodes, every node of the body is
+  // checked, rather than those the outputs depend on.
+  for (const NodeDef& node : fdef.node_def()) {
+    if (node.op() == "AssignVariableOp") {
+      if (!AddAssign(body, node)) return false;
+    } else if (node.op() != "NoOp" && node.op() != "Identity" &&
+               node.op() != "Const" && node.op() != "RestoreV2") {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the CPU device of `device_mgr` on which `handle` is placed, or
+// nullptr if it may be placed on another device.
+Device* FindCpuDevice(const DeviceMgr& device_mgr, const NodeDef& handle,
+                      bool cpu_only) {
+  Device* device = nullptr;
+  if (!handle.device().empty()) {
+    if (!device_mgr.LookupDevice(handle.device(), &device).ok()) {
+      return nullptr;
+    }
+  } else if (cpu_only) {
+    device = device_mgr.HostCPU();
+  }
+  // Colocation constraints may place the variable elsewhere.
+  if (!cpu_only && handle.attr().count(kColocationAttrName) > 0) return nullptr;
+  if (device == nullptr || device->device_type() != DEVICE_CPU) return nullptr;
+  return device;
+}
+
+}  // namespace
+
+Status DirectRestore(const MetaGraphDef& meta_graph,
+                     const std::string& variables_path, Session* session,
+                     bool* restored) {
+  *restored = false;
+  std::vector<RestoredVariable> variables;
+  RestoreAnalyzer analyzer(meta_graph);
+  if (!analyzer.Analyze(&variables)) return absl::OkStatus();
+
+  const DeviceMgr* device_mgr = nullptr;
+  if (!session->LocalDeviceManager(&device_mgr).ok()) return absl::OkStatus();
+  bool cpu_only = true;
+  for (const Device* device : device_mgr->ListDevices()) {
+    if (device->device_type() != DEVICE_CPU) cpu_only = false;
+  }
+  std::vector<Device*> devices;
+  for (const RestoredVariable& variable : variables) {
+    Device* device = FindCpuDevice(*device_mgr, *variable.handle, cpu_only);
+    if (device == nullptr) return absl::OkStatus();
+    devices.push_back(device);
+  }
+
+  BundleReader reader(Env::Default(), variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+  std::vector<std::string> keys;
+  std::vector<Tensor> tensors(variables.size());
+  std::vector<Tensor*> vals;
+  for (int i = 0; i < variables.size(); ++i) {
+    DataType dtype;
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        reader.LookupDtypeAndShape(variables[i].key, &dtype, &shape));
+    if (dtype != variables[i].dtype) {
+      return errors::InvalidArgument(
+          "tensor_name = ", variables[i].key, "; expected dtype ",
+          DataTypeString(variables[i].dtype), " does not equal original dtype ",
+          DataTypeString(dtype));
+    }
+    keys.push_back(variables[i].key);
+    vals.push_back(&tensors[i]);
+  }
+  thread::ThreadPool pool(Env::Default(), "saved_model_restore",
+                          kNumReadThreads);
+  TF_RETURN_IF_ERROR(reader.LookupMany(keys, vals, &pool, kReadSize));
+
+  // As AssignVariableOp does, creates the variables that the VarHandleOps
+  // will refer to.
+  for (int i = 0; i < variables.size(); ++i) {
+    ResourceMgr* rm = devices[i]->resource_manager();
+    const RestoredVariable& variable = variables[i];
+    Var* var = nullptr;
+    TF_RETURN_IF_ERROR(rm->LookupOrCreate<Var>(
+        variable.container.empty() ? rm->default_container()
+                                   : variable.container,
+        variable.shared_name, &var, [&variable](Var** ptr) {
+          *ptr = new Var(variable.dtype);
+          return absl::OkStatus();
+        }));
+    core::ScopedUnref unref(var);
+    mutex_lock ml(*var->mu());
+    *var->tensor() = std::move(tensors[i]);
+    var->is_initialized = true;
+  }
+  LOG(INFO) << "Restored " << variables.size()
+            << " variables without running the restore op.";
+  *restored = true;
+  return absl::OkStatus();
+}
+
+}  // namespace internal
+}  // namespace tensorflow
@@ -0,0 +1,46 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_DIRECT_RESTORE_H_
+#define TENSORFLOW_CC_SAVED_MODEL_DIRECT_RESTORE_H_
+
+#include <string>
+
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace internal {
+
+// Restores the resource variables of `meta_graph` from the checkpoint at
+// `variables_path` as running the restore op of its SaverDef in `session`
+// would, but straight into the resource managers of the devices of `session`,
+// without building and running the restore subgraph.
+//
+// This is only done when the restore op is a plain restore of resource
+// variables on CPU: NoOps and calls of functions (as in TF2 SavedModels) that
+// only assign the full tensors read by RestoreV2 ops from the checkpoint to
+// VarHandleOps. Otherwise, e.g. for reference variables, tables or sliced
+// variables, `*restored` is set to false and nothing is restored, so that the
+// caller runs the restore op instead.
+Status DirectRestore(const MetaGraphDef& meta_graph,
+                     const std::string& variables_path, Session* session,
+                     bool* restored);
+
+}  // namespace internal
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_DIRECT_RESTORE_H_
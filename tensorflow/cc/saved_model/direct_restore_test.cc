@@ -0,0 +1,107 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/direct_restore.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace internal {
+namespace {
+
+// A TF1 SavedModel of a resource variable of value 1.
+constexpr char kTestSimpleV1Model[] = "cc/saved_model/testdata/SimpleV1Model";
+// A TF1 SavedModel of reference variables.
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+std::string VariablesPath(const std::string& export_dir) {
+  return io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                      kSavedModelVariablesFilename);
+}
+
+TEST(DirectRestoreTest, RestoresResourceVariables) {
+  const std::string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestSimpleV1Model);
+  MetaGraphDef meta_graph;
+  TF_ASSERT_OK(ReadMetaGraphDefFromSavedModel(export_dir, {kSavedModelTagServe},
+                                              &meta_graph));
+  std::unique_ptr<Session> session;
+  TF_ASSERT_OK(
+      LoadMetagraphIntoSession(SessionOptions(), meta_graph, &session));
+
+  bool restored = false;
+  TF_ASSERT_OK(DirectRestore(meta_graph, VariablesPath(export_dir),
+                             session.get(), &restored));
+  EXPECT_TRUE(restored);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(
+      session->Run({}, {"Variable/Read/ReadVariableOp:0"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<float>(outputs[0], test::AsScalar<float>(1));
+}
+
+TEST(DirectRestoreTest, SkipsReferenceVariables) {
+  const std::string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  MetaGraphDef meta_graph;
+  TF_ASSERT_OK(ReadMetaGraphDefFromSavedModel(export_dir, {kSavedModelTagServe},
+                                              &meta_graph));
+  std::unique_ptr<Session> session;
+  TF_ASSERT_OK(
+      LoadMetagraphIntoSession(SessionOptions(), meta_graph, &session));
+
+  bool restored = true;
+  TF_ASSERT_OK(DirectRestore(meta_graph, VariablesPath(export_dir),
+                             session.get(), &restored));
+  EXPECT_FALSE(restored);
+}
+
+TEST(DirectRestoreTest, LoadSavedModel) {
+  setenv("TF_SAVED_MODEL_DIRECT_RESTORE", "1", /*overwrite=*/1);
+  const std::string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestSimpleV1Model);
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  unsetenv("TF_SAVED_MODEL_DIRECT_RESTORE");
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"Variable/Read/ReadVariableOp:0"}, {},
+                                   &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<float>(outputs[0], test::AsScalar<float>(1));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace tensorflow
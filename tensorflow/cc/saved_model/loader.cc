@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/direct_restore.h"
 #include "tensorflow/cc/saved_model/fingerprinting.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
 #include "tensorflow/cc/saved_model/metrics.h"
@@ -48,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 
 namespace tensorflow {
@@ -229,6 +231,7 @@ Status RunInitOp(const RunOptions& run_options, const string& export_dir,
 }
 
 Status RunRestore(const RunOptions& run_options, const string& export_dir,
+                  const MetaGraphDef& meta_graph,
                   const StringPiece restore_op_name,
                   const StringPiece variable_filename_const_op_name,
                   const std::vector<AssetFileDef>& asset_file_defs,
@@ -254,6 +257,20 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
   const string variables_path =
       io::JoinPath(variables_directory, kSavedModelVariablesFilename);
 
+  // If TF_SAVED_MODEL_DIRECT_RESTORE is set, the variables are restored
+  // without running the restore op when possible. See DirectRestore().
+  bool direct_restore = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_SAVED_MODEL_DIRECT_RESTORE",
+                                        false, &direct_restore));
+  if (direct_restore) {
+    bool restored = false;
+    TF_RETURN_IF_ERROR(internal::DirectRestore(meta_graph, variables_path,
+                                               session, &restored));
+    if (restored) return absl::OkStatus();
+    LOG(INFO) << "The variables of the SavedModel can't be restored directly; "
+                 "running the restore op.";
+  }
+
   // Add variables to the graph.
   Tensor variables_path_tensor(DT_STRING, TensorShape({}));
   variables_path_tensor.scalar<tstring>()() = variables_path;
@@ -490,7 +507,7 @@ Status RestoreSession(const RunOptions& run_options,
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(internal::GetAssetFileDefs(meta_graph, &asset_file_defs));
   if (meta_graph.has_saver_def()) {
-    TF_RETURN_IF_ERROR(RunRestore(run_options, export_dir,
+    TF_RETURN_IF_ERROR(RunRestore(run_options, export_dir, meta_graph,
                                   meta_graph.saver_def().restore_op_name(),
                                   meta_graph.saver_def().filename_tensor_name(),
                                   asset_file_defs, session->get()));
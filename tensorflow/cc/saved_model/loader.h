@@ -130,6 +130,12 @@ Status LoadSavedModel(const SessionOptions& session_options,
 ///
 /// This overload creates a SavedModelBundleLite, which consumes less RAM than
 /// an equivalent SavedModelBundle.
+///
+/// For serving models whose variables are not updated, setting
+/// `session_options.config.experimental().mmap_restored_tensors()` restores
+/// the variables as tensors that alias the memory-mapped variables data files.
+/// Loading then doesn't copy the variables, and the models loaded from the
+/// same files share their memory.
 Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
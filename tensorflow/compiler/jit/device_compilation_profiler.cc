@@ -21,6 +21,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -62,9 +63,6 @@ void RegisterExecutionForCluster(
 // signature before  we attempt to compile it.
 constexpr int64_t kDefaultCompilationThreshold = 2;
 
-// Maximum number of ongoing compilations.
-constexpr int64_t kMaxNumOngoingCompilations = kNumAsyncDeviceCompilerThreads;
-
 }  // namespace
 
 DeviceCompilationProfiler::~DeviceCompilationProfiler() {
@@ -96,7 +94,7 @@ void DeviceCompilationProfiler::RegisterExecution(
 
 Status DeviceCompilationProfiler::RegisterCompilation(
     const NameAttrList& function, int64_t compile_time_us,
-    bool used_persistent_cache) {
+    bool used_persistent_cache, const CompilationDetails& details) {
   metrics::UpdateXlaCompilationTime(compile_time_us);
 
   const std::string& function_name = function.name();
@@ -127,6 +125,11 @@ Status DeviceCompilationProfiler::RegisterCompilation(
   jit_compilation_activity.set_cumulative_compile_time_us(
       it->second.cumulative_compile_time_us);
   jit_compilation_activity.set_used_persistent_cache(used_persistent_cache);
+  jit_compilation_activity.set_tf_to_hlo_time_us(details.tf_to_hlo_time_us);
+  jit_compilation_activity.set_build_executable_time_us(
+      details.build_executable_time_us);
+  jit_compilation_activity.set_executable_size_bytes(
+      details.executable_size_bytes);
   return BroadcastXlaActivity(std::move(jit_compilation_activity));
 }
 
@@ -181,7 +184,8 @@ bool DeviceCompilationProfiler::ShouldCompileCluster(
 
   if (compile_mode == DeviceCompileMode::kAsync) {
     // Asynchronous compilation is enabled.
-    if (num_ongoing_compilations_ >= kMaxNumOngoingCompilations) {
+    if (num_ongoing_compilations_ >=
+        GetXlaOpsCommonFlags()->tf_xla_max_pending_async_compilations) {
       VLOG(2) << "Not asynchronously compiling cluster " << function.name()
               << " because of too many ongoing compilations.";
       return false;
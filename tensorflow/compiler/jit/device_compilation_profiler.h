@@ -55,6 +55,17 @@ class DeviceCompilationProfiler : public ResourceBase {
     }
   };
 
+  // Details of a single compilation of a cluster.
+  struct CompilationDetails {
+    // Microseconds spent compiling the TF graph to HLO.
+    int64_t tf_to_hlo_time_us = 0;
+    // Microseconds spent building the executable from the HLO, i.e. in the HLO
+    // passes and code generation, or loading it from the persistent cache.
+    int64_t build_executable_time_us = 0;
+    // The size of the code generated for the executable, in bytes.
+    int64_t executable_size_bytes = 0;
+  };
+
   // Returns the compilation statistics for the given cluster.
   absl::StatusOr<ClusterCompileStats> GetCompileStats(
       const NameAttrList& function) const;
@@ -73,10 +84,11 @@ class DeviceCompilationProfiler : public ResourceBase {
 
   // Registers a cluster compilation. Increments the compilation count and
   // accumulates the compile time for the given cluster. Also broadcasts an
-  // XlaJitCompilationActivity.
+  // XlaJitCompilationActivity carrying `details`.
   virtual Status RegisterCompilation(const NameAttrList& function,
                                      int64_t compile_time_us,
-                                     bool used_persistent_cache);
+                                     bool used_persistent_cache,
+                                     const CompilationDetails& details);
 
   void IncrementOngoingAsyncCompilations();
   void DecrementOngoingAsyncCompilations();
@@ -55,7 +55,13 @@ TEST(DeviceCompilationProfilerTest, RegisterCompilation) {
 
   std::vector<XlaJitCompilationActivity> expected_activities;
   for (int i = 0; i < 5; ++i) {
-    EXPECT_TRUE(profiler->RegisterCompilation(function, 4, false).ok());
+    EXPECT_TRUE(profiler
+                    ->RegisterCompilation(
+                        function, 4, false,
+                        {.tf_to_hlo_time_us = 1,
+                         .build_executable_time_us = 3,
+                         .executable_size_bytes = 1024})
+                    .ok());
 
     TF_ASSERT_OK_AND_ASSIGN(auto stats, profiler->GetCompileStats(function));
     XlaJitCompilationActivity expected_activity;
@@ -65,6 +71,9 @@ TEST(DeviceCompilationProfilerTest, RegisterCompilation) {
     expected_activity.set_cumulative_compile_time_us(
         stats.cumulative_compile_time_us);
     expected_activity.set_used_persistent_cache(false);
+    expected_activity.set_tf_to_hlo_time_us(1);
+    expected_activity.set_build_executable_time_us(3);
+    expected_activity.set_executable_size_bytes(1024);
     expected_activities.push_back(expected_activity);
   }
 
@@ -148,7 +157,7 @@ TEST(DeviceCompilationProfilerTest, ShouldCompileClusterMegamorphic) {
   // Register compilation enough times (without registering executions enough
   // times) so that the function is marked megamorphic.
   for (int i = 0; i < kCompileThreshold + 1; ++i) {
-    EXPECT_TRUE(profiler->RegisterCompilation(function, 1, false).ok());
+    EXPECT_TRUE(profiler->RegisterCompilation(function, 1, false, {}).ok());
   }
   profiler->RegisterExecution(function);
 
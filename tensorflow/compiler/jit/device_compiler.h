@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_DEVICE_COMPILER_H_
 #define TENSORFLOW_COMPILER_JIT_DEVICE_COMPILER_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <numeric>
 #include <optional>
@@ -38,11 +41,14 @@ limitations under the License.
 #include "tensorflow/compiler/jit/xla_compile_util.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "xla/client/local_client.h"
+#include "xla/pjrt/pjrt_client.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 namespace tensorflow {
 
@@ -126,6 +132,10 @@ class DeviceCompiler : public ResourceBase {
     return compiler_client_.get();
   }
 
+  // Returns the number of asynchronous compilations waiting for a compiler
+  // thread.
+  int64_t NumPendingAsyncCompilations();
+
   string DebugString() const override;
 
  private:
@@ -152,13 +162,20 @@ class DeviceCompiler : public ResourceBase {
       DeviceCompilationProfiler* profiler, mutex* mu)
       TF_EXCLUSIVE_LOCKS_REQUIRED(*mu);
 
+  // Queues the compilation of `sig`, which was requested `request_count`
+  // times, for a compiler thread.
   Status CompileAsynchronous(const DeviceCompilationClusterSignature& sig,
                              const XlaCompiler::CompileOptions& compile_options,
                              const XlaCompiler::Options& options,
                              const std::vector<XlaCompiler::Argument>& args,
                              const NameAttrList& function, CompileScope scope,
                              OpKernelContext* ctx,
-                             DeviceCompilationProfiler* profiler);
+                             DeviceCompilationProfiler* profiler,
+                             int64_t request_count);
+
+  // Runs the queued asynchronous compilation whose signature was requested
+  // most often. Each queued compilation schedules one call of this.
+  void RunNextAsyncCompilation();
 
   std::unique_ptr<DeviceExecutablePersistor<ExecutableType, ClientType>>
       persistor_;
@@ -169,6 +186,17 @@ class DeviceCompiler : public ResourceBase {
   // Pool of threads for asynchronous compilations.
   std::unique_ptr<thread::ThreadPool> async_compiler_threads_;
 
+  // An asynchronous compilation waiting for a compiler thread.
+  struct PendingCompilation {
+    // How many times the signature was requested, including while queued.
+    int64_t request_count;
+    std::function<void()> compile;
+  };
+  mutex pending_compilations_mu_;
+  absl::flat_hash_map<DeviceCompilationClusterSignature, PendingCompilation,
+                      DeviceCompilationClusterSignature::Hash>
+      pending_compilations_ TF_GUARDED_BY(pending_compilations_mu_);
+
   mutex cluster_mutexes_mu_;
   absl::flat_hash_map<DeviceCompilationClusterSignature, std::unique_ptr<mutex>,
                       DeviceCompilationClusterSignature::Hash>
@@ -203,6 +231,14 @@ inline Status EligibleToPersist(DeviceCompileState compile_state,
   }
   return absl::OkStatus();
 }
+
+// Returns the size of the code generated for `executable`, in bytes.
+inline int64_t GeneratedCodeSize(const xla::LocalExecutable& executable) {
+  return executable.executable()->SizeOfGeneratedCodeInBytes();
+}
+inline int64_t GeneratedCodeSize(const xla::PjRtLoadedExecutable& executable) {
+  return executable.SizeOfGeneratedCodeInBytes();
+}
 }  // namespace device_compiler_internal
 
 template <typename ExecutableType, typename ClientType>
@@ -216,7 +252,8 @@ DeviceCompiler<ExecutableType, ClientType>::DeviceCompiler(
   cache_ = std::make_unique<DeviceCompilationCache<ExecutableType>>();
   async_compiler_threads_ = std::make_unique<tensorflow::thread::ThreadPool>(
       tensorflow::Env::Default(), "async_compiler_threads",
-      kNumAsyncDeviceCompilerThreads);
+      std::max<int32_t>(
+          1, GetXlaOpsCommonFlags()->tf_xla_async_compilation_threads));
 }
 
 template <typename ExecutableType, typename ClientType>
@@ -288,8 +325,13 @@ DeviceCompiler<ExecutableType, ClientType>::CompileStrict(
     typename DeviceCompilationCache<ExecutableType>::Value cache_value,
     CompileScope scope, OpKernelContext* ctx,
     DeviceCompilationProfiler* profiler, mutex* mu) {
+  tensorflow::profiler::TraceMe trace([&] {
+    return tensorflow::profiler::TraceMeEncode("DeviceCompiler::CompileStrict",
+                                               {{"cluster", function.name()}});
+  });
   tensorflow::Env* env = tensorflow::Env::Default();
   const uint64 compile_start_us = env->NowMicros();
+  DeviceCompilationProfiler::CompilationDetails details;
 
   TfGraphToHloCompiler compiler(options);
   cache_value.compile_state = DeviceCompileState::kCompiled;
@@ -309,6 +351,8 @@ DeviceCompiler<ExecutableType, ClientType>::CompileStrict(
   TF_RETURN_IF_ERROR(cache_value.compilation_status);
   TF_RET_CHECK(cache_value.executable == nullptr);
   TF_RET_CHECK(out_compilation_result->computation != nullptr);
+  const uint64 build_start_us = env->NowMicros();
+  details.tf_to_hlo_time_us = build_start_us - compile_start_us;
 
   auto loaded_executable = persistor_->TryToLoadExecutable(
       DeviceCompilationClusterSignature::Hash()(sig), sig.HumanString(),
@@ -335,6 +379,12 @@ DeviceCompiler<ExecutableType, ClientType>::CompileStrict(
         compiler_client_.get()));
   }
 
+  details.build_executable_time_us = env->NowMicros() - build_start_us;
+  if (out_executable != nullptr) {
+    details.executable_size_bytes =
+        device_compiler_internal::GeneratedCodeSize(*out_executable);
+  }
+
   cache_value.compilation_result = out_compilation_result.get();
   cache_value.executable = out_executable.get();
   cache_->Store(sig, cache_value.compile_state, cache_value.compilation_status,
@@ -345,7 +395,7 @@ DeviceCompiler<ExecutableType, ClientType>::CompileStrict(
 
   device_compiler_internal::LogOnceXlaCompiledFirstCluster();
   TF_RETURN_IF_ERROR(profiler->RegisterCompilation(
-      function, compile_time_us, loaded_executable.has_value()));
+      function, compile_time_us, loaded_executable.has_value(), details));
   return cache_value;
 }
 
@@ -356,7 +406,7 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
     const XlaCompiler::Options& options,
     const std::vector<XlaCompiler::Argument>& args,
     const NameAttrList& function, CompileScope scope, OpKernelContext* ctx,
-    DeviceCompilationProfiler* profiler) {
+    DeviceCompilationProfiler* profiler, int64_t request_count) {
   // Explicitly capture all required data by value for async compilation.
   // Update compilation state in cache.
   cache_->Store(signature, DeviceCompileState::kCompiling, std::nullopt,
@@ -372,7 +422,7 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
   // All values are captured by value. Make sure that all pointer values (like
   // entry) do not get freed until the lambda has finished.
   const std::string& function_name = function.name();
-  async_compiler_threads_->Schedule([=] {
+  std::function<void()> compile = [=] {
     VLOG(2) << "Starting asynchronous compilation of cluster " << function_name
             << '.';
     // We don't need to lock mu, but do it anyway to satisfy thread safety
@@ -390,10 +440,47 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileAsynchronous(
       cache_->Store(signature, std::nullopt, s.status(), std::nullopt,
                     std::nullopt);
     }
-  });
+  };
+  {
+    mutex_lock lock(pending_compilations_mu_);
+    pending_compilations_.emplace(
+        signature, PendingCompilation{request_count, std::move(compile)});
+  }
+  metrics::UpdateXlaPendingAsyncCompilations(1);
+  async_compiler_threads_->Schedule([this] { RunNextAsyncCompilation(); });
   return absl::OkStatus();
 }
 
+template <typename ExecutableType, typename ClientType>
+void DeviceCompiler<ExecutableType, ClientType>::RunNextAsyncCompilation() {
+  std::function<void()> compile;
+  {
+    mutex_lock lock(pending_compilations_mu_);
+    auto next = pending_compilations_.end();
+    for (auto it = pending_compilations_.begin();
+         it != pending_compilations_.end(); ++it) {
+      if (next == pending_compilations_.end() ||
+          it->second.request_count > next->second.request_count) {
+        next = it;
+      }
+    }
+    // There is a call of this per queued compilation.
+    DCHECK(next != pending_compilations_.end());
+    if (next == pending_compilations_.end()) return;
+    compile = std::move(next->second.compile);
+    pending_compilations_.erase(next);
+  }
+  metrics::UpdateXlaPendingAsyncCompilations(-1);
+  compile();
+}
+
+template <typename ExecutableType, typename ClientType>
+int64_t
+DeviceCompiler<ExecutableType, ClientType>::NumPendingAsyncCompilations() {
+  mutex_lock lock(pending_compilations_mu_);
+  return pending_compilations_.size();
+}
+
 template <typename ExecutableType, typename ClientType>
 Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
     const XlaCompiler::CompileOptions& compile_options,
@@ -464,6 +551,11 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
     return errors::Internal("XLA compilation disabled");
   }
 
+  metrics::RecordXlaCompilationCacheLookup(
+      state == DeviceCompileState::kCompiled    ? "hit"
+      : state == DeviceCompileState::kCompiling ? "pending"
+                                                : "miss");
+
   if (state == DeviceCompileState::kUncompiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
     if (!profiler->ShouldCompileCluster(function, compile_mode,
@@ -473,9 +565,9 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
     } else if (compile_mode == DeviceCompileMode::kAsync) {
       VLOG(2) << "Queueing asynchronous compilation for signature: "
               << human_signature;
-      TF_RETURN_IF_ERROR(CompileAsynchronous(signature, compile_options,
-                                             options, args, function, scope,
-                                             ctx, profiler));
+      TF_RETURN_IF_ERROR(CompileAsynchronous(
+          signature, compile_options, options, args, function, scope, ctx,
+          profiler, current_request_count));
       return absl::OkStatus();
     } else {
       VLOG(2) << "Instantly compiling for signature: " << human_signature;
@@ -487,6 +579,12 @@ Status DeviceCompiler<ExecutableType, ClientType>::CompileImpl(
   } else if (state == DeviceCompileState::kCompiling) {
     VLOG(2) << "Ongoing asynchronous compilation for signature: "
             << human_signature;
+    // Signatures requested more often while queued are compiled earlier.
+    mutex_lock lock(pending_compilations_mu_);
+    auto it = pending_compilations_.find(signature);
+    if (it != pending_compilations_.end()) {
+      it->second.request_count = current_request_count;
+    }
     return absl::OkStatus();
   } else if (state == DeviceCompileState::kCompiled) {
     VLOG(2) << "Already Compiled for signature: " << human_signature;
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/core/util/determinism.h"
 
@@ -40,6 +41,12 @@ xla::ExecutableBuildOptions GetExecutableBuildOptions(
   if (tensorflow::OpDeterminismRequired()) {
     build_options.mutable_debug_options()->set_xla_gpu_deterministic_ops(true);
   }
+  const int32_t min_graph_size =
+      GetXlaOpsCommonFlags()->tf_xla_gpu_command_buffer_min_graph_size;
+  if (min_graph_size >= 0) {
+    build_options.mutable_debug_options()->set_xla_gpu_graph_min_graph_size(
+        min_graph_size);
+  }
   return build_options;
 }
 
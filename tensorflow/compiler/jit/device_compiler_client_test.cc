@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/device_compiler_client.h"
 
 #include <gtest/gtest.h>
+#include "tensorflow/compiler/jit/flags.h"
 
 namespace tensorflow {
 namespace {
@@ -72,5 +73,27 @@ TEST(GetExecutableOptionTest, DumpingWithoutDetailedLogging) {
   EXPECT_TRUE(build_option.debug_options().xla_enable_dumping());
 }
 
+TEST(GetExecutableOptionTest, CommandBufferMinGraphSize) {
+  XlaCompiler::Options options;
+  XlaCompiler::CompilationResult result;
+  const int32_t default_size =
+      GetExecutableBuildOptions(options, result, /*default_device_ordinal=*/-1)
+          .debug_options()
+          .xla_gpu_graph_min_graph_size();
+
+  XlaOpsCommonFlags* flags = GetXlaOpsCommonFlags();
+  flags->tf_xla_gpu_command_buffer_min_graph_size = 1;
+  auto build_option =
+      GetExecutableBuildOptions(options, result, /*default_device_ordinal=*/-1);
+  flags->tf_xla_gpu_command_buffer_min_graph_size = -1;
+
+  EXPECT_EQ(build_option.debug_options().xla_gpu_graph_min_graph_size(), 1);
+  EXPECT_EQ(
+      GetExecutableBuildOptions(options, result, /*default_device_ordinal=*/-1)
+          .debug_options()
+          .xla_gpu_graph_min_graph_size(),
+      default_size);
+}
+
 }  // namespace
 }  // namespace tensorflow
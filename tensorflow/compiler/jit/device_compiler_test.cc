@@ -126,7 +126,8 @@ class MockDeviceCompilationProfiler : public DeviceCompilationProfiler {
               (override));
   MOCK_METHOD(Status, RegisterCompilation,
               (const NameAttrList& function, int64_t compile_time_us,
-               bool used_persistent_cache),
+               bool used_persistent_cache,
+               const CompilationDetails& details),
               (override));
 };
 
@@ -283,7 +284,7 @@ TEST_F(DeviceCompilerTest, CompileAsyncSuccess) {
   EXPECT_CALL(*mock_profiler_,
               ShouldCompileCluster(_, DeviceCompileMode::kAsync, 1))
       .WillOnce(Return(true));
-  EXPECT_CALL(*mock_profiler_, RegisterCompilation(_, _, false))
+  EXPECT_CALL(*mock_profiler_, RegisterCompilation(_, _, false, _))
       .WillOnce([&done] {
         done.Notify();
         return absl::OkStatus();
@@ -310,6 +311,8 @@ TEST_F(DeviceCompilerTest, CompileAsyncSuccess) {
 
   // Wait for async compilation to complete.
   done.WaitForNotification();
+  // The compilation was taken off the queue when it started.
+  EXPECT_EQ(xla_device_compiler_->NumPendingAsyncCompilations(), 0);
   cache_value = xla_cache->Lookup(signature);
   EXPECT_TRUE(cache_value);
   EXPECT_TRUE(cache_value->compile_state == DeviceCompileState::kCompiled);
@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_DEVICE_EXECUTABLE_PERSISTOR_H_
 #define TENSORFLOW_COMPILER_JIT_DEVICE_EXECUTABLE_PERSISTOR_H_
 
+#include <cstdlib>
 #include <optional>
 #include <string>
 
 #include "absl/log/log.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
 #include "tensorflow/compiler/jit/xla_device_compiler_client.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
@@ -27,7 +30,9 @@ limitations under the License.
 #include "xla/service/hlo.pb.h"
 #include "xla/util.h"
 #include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
@@ -74,6 +79,10 @@ class DeviceExecutablePersistor {
 
     // Cache is read-only if set to true.
     bool persistent_cache_directory_read_only = false;
+
+    // Identifies the device executables are compiled for, e.g. its model and
+    // driver version. Executables persisted for other devices aren't loaded.
+    std::string device_fingerprint;
   };
 
   DeviceExecutablePersistor(const Config& config,
@@ -104,6 +113,12 @@ class DeviceExecutablePersistor {
       const ExecutableType& executable,
       DeviceCompilerClient<ExecutableType, ClientType>* client) const;
 
+  // Returns the fingerprint of `device_fingerprint` and of the XLA flags of
+  // this process. It is part of the cache keys and file names, so that
+  // processes compiling differently, e.g. replicas on other devices, can share
+  // a cache directory without loading each other's executables.
+  static uint64 GetCompilerFingerprint(absl::string_view device_fingerprint);
+
   const DeviceType& device_type() const { return device_type_; }
   const std::string& persistence_prefix() const { return persistence_prefix_; }
   const std::string& persistent_cache_directory() const {
@@ -157,6 +172,8 @@ class DeviceExecutablePersistor {
   // Cache is read-only if set to true.
   const bool persistent_cache_directory_read_only_;
 
+  const uint64 compiler_fingerprint_;
+
   DeviceExecutablePersistor(const DeviceExecutablePersistor&) = delete;
   void operator=(const DeviceExecutablePersistor&) = delete;
 };
@@ -170,7 +187,18 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::
       persistence_prefix_(config.persistence_prefix),
       persistent_cache_directory_(config.persistent_cache_directory),
       persistent_cache_directory_read_only_(
-          config.persistent_cache_directory_read_only) {}
+          config.persistent_cache_directory_read_only),
+      compiler_fingerprint_(
+          GetCompilerFingerprint(config.device_fingerprint)) {}
+
+template <typename ExecutableType, typename ClientType>
+uint64
+DeviceExecutablePersistor<ExecutableType, ClientType>::GetCompilerFingerprint(
+    absl::string_view device_fingerprint) {
+  const char* xla_flags = std::getenv("XLA_FLAGS");
+  return Fingerprint64(absl::StrCat(device_fingerprint, "\n",
+                                    xla_flags == nullptr ? "" : xla_flags));
+}
 
 template <typename ExecutableType, typename ClientType>
 std::string DeviceExecutablePersistor<ExecutableType, ClientType>::
@@ -181,6 +209,10 @@ std::string DeviceExecutablePersistor<ExecutableType, ClientType>::
       key.signature_fingerprint(), kXlaSerializedCacheKeySeparator,
       key.cluster_fingerprint(), kXlaSerializedCacheKeySeparator,
       key.device_type(),
+      key.compiler_fingerprint() == 0
+          ? ""
+          : absl::StrCat(kXlaSerializedCacheKeySeparator,
+                         key.compiler_fingerprint()),
       key.compiled_using_pjrt()
           ? absl::StrCat(kXlaSerializedCacheKeySeparator, "pjrt")
           : "");
@@ -205,6 +237,7 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::BuildSerializedCacheKey(
   key.set_device_type(device_type().type_string());
   key.set_prefix(persistence_prefix());
   key.set_compiled_using_pjrt(compiled_using_pjrt);
+  key.set_compiler_fingerprint(compiler_fingerprint_);
   return key;
 }
 
@@ -369,15 +402,22 @@ DeviceExecutablePersistor<ExecutableType, ClientType>::TryToLoadExecutable(
   }
 
   if (!serialized_entry.has_value()) {
+    metrics::RecordXlaPersistentCacheLookup("miss");
     return std::nullopt;
   }
 
-  TF_RETURN_IF_ERROR(
-      VerifyLoadedCacheEntry(cache_key, hlo_module, *serialized_entry));
+  if (Status s =
+          VerifyLoadedCacheEntry(cache_key, hlo_module, *serialized_entry);
+      !s.ok()) {
+    metrics::RecordXlaPersistentCacheLookup("invalid");
+    return s;
+  }
 
   VLOG(1) << "Loading cached entry for: " << signature_str;
-  return compiler_client->LoadExecutable(options, compilation_result,
-                                         serialized_entry->executable());
+  auto executable = compiler_client->LoadExecutable(
+      options, compilation_result, serialized_entry->executable());
+  metrics::RecordXlaPersistentCacheLookup(executable.ok() ? "hit" : "invalid");
+  return executable;
 }
 
 template <typename ExecutableType, typename ClientType>
@@ -202,7 +202,8 @@ std::string GetFilePath(XlaSerializedCacheKey key,
       key.prefix(), key.prefix().empty() ? "" : kXlaSerializedCacheKeySeparator,
       key.signature_fingerprint(), kXlaSerializedCacheKeySeparator,
       key.cluster_fingerprint(), kXlaSerializedCacheKeySeparator,
-      key.device_type(),
+      key.device_type(), kXlaSerializedCacheKeySeparator,
+      key.compiler_fingerprint(),
       key.compiled_using_pjrt()
           ? absl::StrCat(kXlaSerializedCacheKeySeparator, "pjrt")
           : "",
@@ -231,6 +232,9 @@ XlaSerializedCacheKey CreateCacheKey(
   key.set_device_type(device_type.type_string());
   key.set_prefix(persistence_prefix);
   key.set_compiled_using_pjrt(compiled_using_pjrt);
+  key.set_compiler_fingerprint(
+      XlaDeviceExecutablePersistor::GetCompilerFingerprint(
+          /*device_fingerprint=*/""));
   return key;
 }
 
@@ -428,6 +432,36 @@ TEST_F(DeviceExecutionPersistorTest, LoadFileDoesntExist) {
   EXPECT_FALSE(loaded_executable.has_value());
 }
 
+TEST_F(DeviceExecutionPersistorTest, LoadPersistedForOtherDevice) {
+  XlaDeviceExecutablePersistor::Config config(
+      /*persistent_cache_directory=*/cache_dir_,
+      /*disable_strict_signature_checks=*/false,
+      /*persistence_prefix=*/"xla");
+  config.device_fingerprint = "device_a";
+  XlaDeviceExecutablePersistor persistor(config,
+                                         DefaultXlaOptions().device_type);
+
+  MockXlaCompilerClient mock_client;
+  EXPECT_CALL(mock_client, SerializeExecutable(_))
+      .WillOnce(
+          Return(absl::StatusOr<std::string>(serialized_xla_executable_)));
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, BuildSampleExecutable());
+  TF_EXPECT_OK(persistor.TryToPersistExecutable(
+      /*signature_hash=*/789, "signature_string", DefaultXlaOptions(),
+      compilation_result_add_, *executable, &mock_client));
+
+  // A persistor for another device doesn't find the entry.
+  config.device_fingerprint = "device_b";
+  XlaDeviceExecutablePersistor other_persistor(config,
+                                               DefaultXlaOptions().device_type);
+  EXPECT_FALSE(other_persistor
+                   .TryToLoadExecutable(
+                       /*signature_hash=*/789, "signature_string",
+                       DefaultXlaOptions(), compilation_result_add_,
+                       &mock_client)
+                   .has_value());
+}
+
 TEST_F(DeviceExecutionPersistorTest, LoadSerializedKeyMismatch) {
   XlaDeviceExecutablePersistor::Config config(
       /*persistent_cache_directory=*/cache_dir_,
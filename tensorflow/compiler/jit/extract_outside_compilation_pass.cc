@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/extract_outside_compilation_pass.h"
 
+#include <map>
+#include <vector>
+
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/jit/encapsulate_subgraphs_pass.h"
 #include "tensorflow/compiler/jit/encapsulate_util.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/tf2xla/side_effect_util.h"
 #include "tensorflow/compiler/tf2xla/tf2xla_util.h"
 #include "xla/status_macros.h"
@@ -2153,6 +2158,83 @@ Status ExtractOutsideCompilationForNodesWithAssociatedFunctions(
   return absl::OkStatus();
 }
 
+// Merges the outside compilation clusters of `g` between which there is no
+// path, so that each group of them is extracted into a single host computation
+// and takes a single device-host round trip, e.g. for independent host ops run
+// at every step of a loop. A cluster joins the first group none of whose
+// clusters it depends on or is depended on by, which keeps the graph acyclic
+// once each group is encapsulated.
+Status MergeIndependentOutsideCompilationClusters(
+    Graph* g, const string& outside_compilation_attr_name) {
+  // Clusters are ordered by name for determinism.
+  std::map<string, std::vector<Node*>> cluster_nodes;
+  for (Node* n : g->op_nodes()) {
+    string cluster;
+    if (TryGetNodeAttr(n->attrs(), outside_compilation_attr_name, &cluster)) {
+      cluster_nodes[cluster].push_back(n);
+    }
+  }
+  if (cluster_nodes.size() < 2) return absl::OkStatus();
+
+  std::vector<const string*> names;
+  std::vector<const std::vector<Node*>*> clusters;
+  std::vector<int> node_cluster(g->num_node_ids(), -1);
+  for (const auto& [name, nodes] : cluster_nodes) {
+    for (Node* n : nodes) node_cluster[n->id()] = clusters.size();
+    names.push_back(&name);
+    clusters.push_back(&nodes);
+  }
+
+  // reaches[i][j] is true if there is a path from cluster i to cluster j.
+  const int num_clusters = clusters.size();
+  std::vector<std::vector<bool>> reaches(num_clusters,
+                                         std::vector<bool>(num_clusters));
+  for (int i = 0; i < num_clusters; ++i) {
+    std::vector<bool> visited(g->num_node_ids());
+    std::vector<Node*> stack(clusters[i]->begin(), clusters[i]->end());
+    while (!stack.empty()) {
+      Node* n = stack.back();
+      stack.pop_back();
+      for (Node* dst : n->out_nodes()) {
+        if (visited[dst->id()]) continue;
+        visited[dst->id()] = true;
+        const int dst_cluster = node_cluster[dst->id()];
+        if (dst_cluster >= 0 && dst_cluster != i) {
+          reaches[i][dst_cluster] = true;
+        }
+        stack.push_back(dst);
+      }
+    }
+  }
+
+  std::vector<std::vector<int>> groups;
+  for (int i = 0; i < num_clusters; ++i) {
+    auto independent = [&](const std::vector<int>& group) {
+      return absl::c_none_of(
+          group, [&](int j) { return reaches[i][j] || reaches[j][i]; });
+    };
+    auto it = absl::c_find_if(groups, independent);
+    if (it == groups.end()) {
+      groups.push_back({i});
+    } else {
+      it->push_back(i);
+    }
+  }
+
+  for (const std::vector<int>& group : groups) {
+    const string& merged_name = *names[group[0]];
+    for (int i = 1; i < group.size(); ++i) {
+      VLOG(2) << "Merging outside compilation cluster " << *names[group[i]]
+              << " into " << merged_name;
+      for (Node* n : *clusters[group[i]]) {
+        n->ClearAttr(outside_compilation_attr_name);
+        n->AddAttr(outside_compilation_attr_name, merged_name);
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 Status CopyOutsideCompilationConstNodes(
     Graph* g, const string& outside_compilation_attr_name) {
   for (Node* n : g->op_nodes()) {
@@ -2347,6 +2429,12 @@ Status ExtractOutsideCompilationForFunction(
   std::vector<string> outside_compilation_host_graphs;
   std::vector<string> shape_inference_graphs_to_rewrite;
   if (*has_outside_compilation) {
+    if (GetBuildXlaOpsPassFlags()
+            ->tf_xla_merge_independent_outside_compilation) {
+      TF_RETURN_IF_ERROR(MergeIndependentOutsideCompilationClusters(
+          fbody->graph, outside_compilation_attr_name));
+    }
+
     // Copy outside compilation Const nodes with non outside compilation users.
     TF_RETURN_IF_ERROR(CopyOutsideCompilationConstNodes(
         fbody->graph, outside_compilation_attr_name));
@@ -175,6 +175,22 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
            &mark_for_compilation_flags->tf_xla_persistent_cache_prefix,
            "Specifies the persistance cache prefix. Default is "
            "\"xla_compile_cache\""),
+      Flag("tf_xla_batch_size_buckets",
+           &mark_for_compilation_flags->tf_xla_batch_size_buckets,
+           "If non-empty, the batch sizes (comma separated) to which the "
+           "inputs of clusters are padded along an unknown dimension 0, when "
+           "this doesn't change the outputs of the cluster. Bounds the number "
+           "of compilations for dynamic batch sizes. Empty by default."),
+      Flag("tf_xla_cluster_step_stats_profile",
+           &mark_for_compilation_flags->tf_xla_cluster_step_stats_profile,
+           "If non-empty, the path of a StepStats proto (binary or text) "
+           "profiling the graph without auto-clustering. Clusters whose ops "
+           "ran for less than --tf_xla_min_profiled_cluster_time_us in it "
+           "are declustered."),
+      Flag("tf_xla_min_profiled_cluster_time_us",
+           &mark_for_compilation_flags->tf_xla_min_profiled_cluster_time_us,
+           "Clusters whose ops ran for less than this many microseconds in "
+           "--tf_xla_cluster_step_stats_profile are declustered."),
       Flag("tf_xla_sparse_core_disable_table_stacking",
            &sparse_core_flags->tf_xla_sparse_core_disable_table_stacking,
            "Disable table stacking for all the tables passed to the SparseCore"
@@ -222,6 +238,7 @@ void AllocateAndParseFlags() {
   build_ops_flags->tf_xla_disable_constant_folding = false;
   build_ops_flags->tf_xla_disable_full_embedding_pipelining = false;
   build_ops_flags->tf_xla_embedding_parallel_iterations = 0;
+  build_ops_flags->tf_xla_merge_independent_outside_compilation = false;
 
   mark_for_compilation_flags = new MarkForCompilationPassFlags;
   mark_for_compilation_flags->xla_auto_jit_flag.optimization_level_single_gpu =
@@ -245,6 +262,9 @@ void AllocateAndParseFlags() {
   mark_for_compilation_flags->tf_xla_disable_strict_signature_checks = false;
   mark_for_compilation_flags->tf_xla_persistent_cache_prefix =
       "xla_compile_cache";
+  mark_for_compilation_flags->tf_xla_batch_size_buckets = "";
+  mark_for_compilation_flags->tf_xla_cluster_step_stats_profile = "";
+  mark_for_compilation_flags->tf_xla_min_profiled_cluster_time_us = 50;
 
   device_flags = new XlaDeviceFlags;
   device_flags->tf_xla_compile_on_demand = false;
@@ -263,6 +283,9 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_async_compilation_threads = 10;
+  ops_flags->tf_xla_max_pending_async_compilations = 10;
+  ops_flags->tf_xla_gpu_command_buffer_min_graph_size = -1;
   ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_on_demand_ = true;
   ops_flags->tf_xla_use_device_api.enabled_for_compile_and_run_ = true;
@@ -318,6 +341,11 @@ void AllocateAndParseFlags() {
             "If >0 then use this many parallel iterations in "
             "embedding_pipelining and embedding_sequency. By default, use the "
             "parallel_iterations on the original model WhileOp."),
+       Flag("tf_xla_merge_independent_outside_compilation",
+            &build_ops_flags->tf_xla_merge_independent_outside_compilation,
+            "If true then outside compilation clusters with no path between "
+            "them are merged, so that each group of them takes a single "
+            "device-host round trip."),
 
        Flag("tf_xla_compile_on_demand", &device_flags->tf_xla_compile_on_demand,
             "Switch a device into 'on-demand' mode, where instead of "
@@ -335,6 +363,22 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_async_compilation_threads",
+            &ops_flags->tf_xla_async_compilation_threads,
+            "The number of threads compiling clusters in the background when "
+            "asynchronous compilation is enabled."),
+       Flag("tf_xla_max_pending_async_compilations",
+            &ops_flags->tf_xla_max_pending_async_compilations,
+            "The maximum number of asynchronous compilations queued or "
+            "running. Queued compilations run in order of how often their "
+            "signature was requested."),
+       Flag("tf_xla_gpu_command_buffer_min_graph_size",
+            &ops_flags->tf_xla_gpu_command_buffer_min_graph_size,
+            "The minimum number of kernels that XLA captures into a command "
+            "buffer (CUDA graph) when compiling clusters for GPU, which "
+            "replays them on later runs with a single launch. Lower values "
+            "cut the launch overhead of small steps. If negative, XLA's "
+            "default is used."),
        Flag("tf_xla_use_device_api_for_xla_launch",
             &ops_flags->tf_xla_use_device_api.enabled_for_xla_launch_,
             "If true, uses Device API (PjRt) for single device compilation and "
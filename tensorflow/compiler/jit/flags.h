@@ -111,6 +111,18 @@ struct MarkForCompilationPassFlags {
 
   // Specifies the persistance cache prefix. Default is "xla_compile_cache"
   string tf_xla_persistent_cache_prefix;
+
+  // If non-empty, the batch sizes (comma separated) to which the inputs of
+  // clusters are padded along dimension 0 when it is unknown and padding
+  // doesn't change the outputs.  This bounds the number of compilations of
+  // auto-clustered graphs run with dynamic batch sizes.
+  string tf_xla_batch_size_buckets;
+
+  // If non-empty, a StepStats profile (binary or text proto) of the graph run
+  // without auto-clustering.  Clusters whose ops ran for less than
+  // tf_xla_min_profiled_cluster_time_us in total in it are declustered.
+  string tf_xla_cluster_step_stats_profile;
+  int64_t tf_xla_min_profiled_cluster_time_us;
 };
 
 // Flags associated with XLA Sparse Core.
@@ -151,6 +163,19 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // The number of threads compiling clusters asynchronously, per device
+  // compiler.
+  int32_t tf_xla_async_compilation_threads;
+  // The maximum number of asynchronous compilations queued or running. New
+  // signatures take the fallback path without being queued while there are
+  // this many. Queued compilations run in order of how often their signature
+  // was requested.
+  int32_t tf_xla_max_pending_async_compilations;
+  // The minimum number of kernels in a run of commands that XLA records into
+  // a command buffer (a CUDA graph) of the compiled GPU clusters. The command
+  // buffers are replayed on later runs of the same executable, and other
+  // shapes compile other executables. If negative, XLA's default is used.
+  int32_t tf_xla_gpu_command_buffer_min_graph_size;
 
   class PjRtForSingleDeviceCompilationRollout {
    public:
@@ -280,6 +305,11 @@ struct BuildXlaOpsPassFlags {
   // Force the WhileOps in embedding_pipelining and embedding_sequencing to use
   // this many parallel_iterations
   int tf_xla_embedding_parallel_iterations;
+
+  // If true, outside compilation clusters of a computation with no path
+  // between them are extracted into a single host computation, which saves a
+  // device-host round trip per merged cluster.
+  bool tf_xla_merge_independent_outside_compilation;
 };
 
 // Flags for common MLIR configurations.
@@ -15,21 +15,34 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/increase_dynamism_for_auto_jit_pass.h"
 #include <iterator>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
+#include "absl/strings/str_split.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/cc/framework/scope_internal.h"
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/cc/ops/xla_ops.h"
 #include "xla/status_macros.h"
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/control_flow.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
@@ -370,6 +383,360 @@ Status FindAndRewriteSlices(Graph* g, bool* changed) {
 
   return absl::OkStatus();
 }
+
+// Parses the comma separated batch sizes of --tf_xla_batch_size_buckets into
+// `buckets`, sorted in increasing order.
+Status ParseBatchSizeBuckets(absl::string_view flag,
+                             std::vector<int32>* buckets) {
+  buckets->clear();
+  for (absl::string_view size : absl::StrSplit(flag, ',', absl::SkipEmpty())) {
+    int32_t bucket;
+    if (!absl::SimpleAtoi(size, &bucket) || bucket <= 0) {
+      return errors::InvalidArgument(
+          "Invalid batch size in --tf_xla_batch_size_buckets: ", size);
+    }
+    buckets->push_back(bucket);
+  }
+  absl::c_sort(*buckets);
+  buckets->erase(std::unique(buckets->begin(), buckets->end()),
+                 buckets->end());
+  return absl::OkStatus();
+}
+
+// Ops computing each row (the elements with the same index in dimension 0) of
+// their output from the same row of their only input.
+bool IsRowwiseUnaryOp(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>(
+      {"Abs", "Cast", "Ceil", "Cos", "Elu", "Erf", "Exp", "Floor", "Identity",
+       "LeakyRelu", "Log", "Neg", "Reciprocal", "Relu", "Relu6", "Round",
+       "Rsqrt", "Selu", "Sigmoid", "Sin", "Softplus", "Sqrt", "Square",
+       "Tanh"});
+  return kOps->contains(n.type_string());
+}
+
+// Ops broadcasting their two inputs against each other elementwise.  Integer
+// divisions are left out, the zero rows of a padded divisor would divide by 0.
+bool IsRowwiseBinaryOp(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>(
+      {"Add", "AddV2", "Equal", "Greater", "GreaterEqual", "Less", "LessEqual",
+       "LogicalAnd", "LogicalOr", "Maximum", "Minimum", "Mul", "NotEqual",
+       "Pow", "RealDiv", "SquaredDifference", "Sub"});
+  return kOps->contains(n.type_string());
+}
+
+// Returns the rank of the output of `n` if appending rows to its `batched`
+// inputs only appends rows to its output, i.e. if slicing the output of `n` on
+// inputs padded along dimension 0 gives its output on the inputs.  Returns
+// nullopt otherwise.  `shapes` are the shapes of the inputs of `n`.
+std::optional<int> GetBatchedOutputRank(
+    const Node& n, absl::Span<const PartialTensorShape> shapes,
+    const std::vector<bool>& batched) {
+  if (n.num_outputs() != 1) return std::nullopt;
+  if (IsRowwiseUnaryOp(n) && shapes.size() == 1) return shapes[0].dims();
+
+  const string& op = n.type_string();
+  if (op == "Softmax" || op == "LogSoftmax") {
+    // These normalize along the last dimension, which must not be the batch.
+    if (shapes[0].dims() < 2) return std::nullopt;
+    return shapes[0].dims();
+  }
+  if (op == "MatMul" || op == "BiasAdd") {
+    bool transpose_a = false;
+    if (op == "MatMul" &&
+        (!TryGetNodeAttr(n.attrs(), "transpose_a", &transpose_a) ||
+         transpose_a)) {
+      return std::nullopt;
+    }
+    if (batched[1] || shapes[0].dims() < 2) return std::nullopt;
+    return shapes[0].dims();
+  }
+  if (!IsRowwiseBinaryOp(n) || shapes.size() != 2) return std::nullopt;
+
+  // Both batched inputs have their batch in dimension 0, and an unbatched
+  // input must broadcast along it.
+  int rank = -1;
+  for (int i = 0; i < 2; ++i) {
+    if (!batched[i]) continue;
+    if (rank >= 0 && shapes[i].dims() != rank) return std::nullopt;
+    rank = shapes[i].dims();
+  }
+  for (int i = 0; i < 2; ++i) {
+    if (batched[i]) continue;
+    const PartialTensorShape& shape = shapes[i];
+    if (shape.unknown_rank() || shape.dims() > rank ||
+        (shape.dims() == rank && shape.dim_size(0) != 1)) {
+      return std::nullopt;
+    }
+  }
+  return rank;
+}
+
+// A tensor read or computed by a cluster with its batch in dimension 0.
+struct BatchedTensor {
+  Output tensor;
+  int rank;
+  // The edges carrying the tensor into the cluster, for inputs, or out of the
+  // cluster, for outputs.
+  std::vector<const Edge*> edges;
+};
+
+struct BucketableCluster {
+  // The inputs of the cluster with an unknown dimension 0.
+  std::vector<BatchedTensor> inputs;
+  // The outputs of the cluster computed from its batched inputs.
+  std::vector<BatchedTensor> outputs;
+};
+
+PartialTensorShape GetInferredShape(const GraphShapeInfo& shape_info,
+                                    const Node& n, int output) {
+  auto it = shape_info.find(n.name());
+  if (it == shape_info.end() || output >= it->second.size()) {
+    return PartialTensorShape();
+  }
+  return it->second[output].shape;
+}
+
+// Returns the batched inputs and outputs of the cluster with nodes `nodes`, in
+// topological order, if padding its batched inputs along dimension 0 doesn't
+// affect the rows of its outputs for the original inputs.  Returns nullopt
+// otherwise.
+std::optional<BucketableCluster> GetBucketableCluster(
+    absl::Span<Node* const> nodes, const GraphShapeInfo& shape_info,
+    const std::vector<ControlFlowInfo>& control_flow_info) {
+  const absl::flat_hash_set<const Node*> cluster(nodes.begin(), nodes.end());
+  // Maps the batched tensors to their ranks.
+  absl::flat_hash_map<std::pair<const Node*, int>, int> ranks;
+  // Maps the batched inputs of the cluster to their index in `inputs`.
+  absl::flat_hash_map<std::pair<const Node*, int>, int> input_index;
+  BucketableCluster result;
+
+  for (Node* n : nodes) {
+    // The ops computing the paddings would have to enter the loop frames.
+    if (!control_flow_info[n->id()].frame_name.empty()) return std::nullopt;
+
+    std::vector<PartialTensorShape> shapes(n->num_inputs());
+    std::vector<bool> batched(n->num_inputs());
+    bool has_batched_input = false;
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      const Node* src = e->src();
+      const std::pair<const Node*, int> tensor(src, e->src_output());
+      PartialTensorShape& shape = shapes[e->dst_input()];
+      if (cluster.contains(src)) {
+        auto it = ranks.find(tensor);
+        if (it != ranks.end()) {
+          // Only the ranks of batched tensors matter below.
+          batched[e->dst_input()] = true;
+          shape = PartialTensorShape(std::vector<int64_t>(it->second, -1));
+        } else {
+          shape = GetInferredShape(shape_info, *src, e->src_output());
+        }
+      } else {
+        shape = GetInferredShape(shape_info, *src, e->src_output());
+        const DataType dtype = src->output_type(e->src_output());
+        if (shape.dims() >= 1 && shape.dim_size(0) < 0 &&
+            !IsRefType(dtype) && dtype != DT_RESOURCE &&
+            dtype != DT_VARIANT && dtype != DT_STRING) {
+          batched[e->dst_input()] = true;
+          auto [it, inserted] =
+              input_index.emplace(tensor, result.inputs.size());
+          if (inserted) {
+            ranks.emplace(tensor, shape.dims());
+            result.inputs.push_back(
+                {Output(e->src(), e->src_output()), shape.dims(), {}});
+          }
+          result.inputs[it->second].edges.push_back(e);
+        }
+      }
+      has_batched_input |= batched[e->dst_input()];
+    }
+    if (!has_batched_input) continue;
+
+    std::optional<int> rank = GetBatchedOutputRank(*n, shapes, batched);
+    if (!rank.has_value() || *rank < 1) {
+      VLOG(3) << "Not bucketing the batch size of cluster "
+              << *GetXlaClusterForNode(*n) << " because of " << n->name();
+      return std::nullopt;
+    }
+    ranks.emplace(std::make_pair(n, 0), *rank);
+  }
+  if (result.inputs.empty()) return std::nullopt;
+
+  for (Node* n : nodes) {
+    auto it = ranks.find(std::make_pair(n, 0));
+    if (it == ranks.end()) continue;
+    BatchedTensor output{Output(n, 0), it->second, {}};
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() && !cluster.contains(e->dst())) {
+        output.edges.push_back(e);
+      }
+    }
+    if (!output.edges.empty()) result.outputs.push_back(std::move(output));
+  }
+  return result;
+}
+
+// Returns an int32 vector holding `values`.
+Tensor MakeInt32Vector(absl::Span<const int32> values) {
+  Tensor tensor(DT_INT32, TensorShape({static_cast<int64_t>(values.size())}));
+  absl::c_copy(values, tensor.flat<int32>().data());
+  return tensor;
+}
+
+// Returns the paddings of a tensor of rank `rank` appending `padding` rows.
+Output MakeBatchPaddings(const Scope& host_scope, const Output& zero,
+                         const Output& padding, int rank) {
+  Output paddings = ops::Concat(host_scope.WithOpName("paddings"),
+                                {zero, padding}, /*axis=*/0);
+  if (rank > 1) {
+    Output other_paddings =
+        ops::Const(host_scope.WithOpName("other_paddings"),
+                   MakeInt32Vector(std::vector<int32>(2 * (rank - 1), 0)));
+    paddings = ops::Concat(host_scope.WithOpName("paddings"),
+                           {paddings, other_paddings}, /*axis=*/0);
+  }
+  return ops::Reshape(host_scope.WithOpName("paddings"), paddings,
+                      ops::Const(host_scope.WithOpName("paddings_shape"),
+                                 {rank, 2}));
+}
+
+// Pads the batched inputs of `cluster` along dimension 0 to the first of
+// `buckets` larger than the batch size, so that they take one of a bounded
+// number of shapes, and slices the padding off its batched outputs.
+Status PadClusterBatch(Graph* g, absl::string_view cluster_name,
+                       const BucketableCluster& cluster,
+                       absl::Span<const int32> buckets) {
+  const string& device_name =
+      cluster.inputs[0].edges[0]->dst()->assigned_device_name();
+  string host_name;
+  TF_RETURN_IF_ERROR(
+      DeviceNameUtils::DeviceNameToCpuDeviceName(device_name, &host_name));
+
+  Status status;
+  Scope device_scope =
+      NewInternalScope(g, &status, /*refiner=*/nullptr)
+          .NewSubScope(absl::StrCat(cluster_name, "/bucketed_batch"))
+          .WithAssignedDevice(device_name);
+  Scope host_scope = device_scope.WithAssignedDevice(host_name);
+
+  // Shape runs on the device of the cluster, to not copy its input to the
+  // host, and outputs to host memory.
+  auto dim_0 = [&](const Output& tensor) {
+    return ops::Slice(host_scope.WithOpName("dim_0"),
+                      ops::Shape(device_scope.WithOpName("shape"), tensor),
+                      {0}, {1});
+  };
+  Output zero = ops::Const(host_scope.WithOpName("zero"), {0});
+  Output batch_size = dim_0(cluster.inputs[0].tensor);
+
+  // The padding to the smallest bucket at least as large as the batch, or 0
+  // if the batch is larger than all the buckets.
+  const int32 kNoBucket = std::numeric_limits<int32>::max();
+  Output no_bucket = ops::Const(host_scope.WithOpName("no_bucket"), kNoBucket);
+  Output bucket_paddings =
+      ops::Sub(host_scope.WithOpName("bucket_paddings"),
+               ops::Const(host_scope.WithOpName("buckets"),
+                          MakeInt32Vector(buckets)),
+               batch_size);
+  Output padding = ops::Min(
+      host_scope.WithOpName("min_padding"),
+      ops::SelectV2(host_scope.WithOpName("valid_paddings"),
+                    ops::GreaterEqual(host_scope.WithOpName("fits_bucket"),
+                                      bucket_paddings, zero),
+                    bucket_paddings, no_bucket),
+      /*axis=*/0, ops::Min::KeepDims(true));
+  padding = ops::SelectV2(
+      host_scope.WithOpName("padding"),
+      ops::Equal(host_scope.WithOpName("no_bucket_fits"), padding, no_bucket),
+      zero, padding);
+
+  for (int i = 0; i < cluster.inputs.size(); ++i) {
+    const BatchedTensor& input = cluster.inputs[i];
+    // Inputs with another dimension 0 than the first can only broadcast to the
+    // batch, and are left unpadded.
+    Output input_padding =
+        i == 0 ? padding
+               : ops::SelectV2(host_scope.WithOpName("input_padding"),
+                               ops::Equal(host_scope.WithOpName("is_batch"),
+                                          dim_0(input.tensor), batch_size),
+                               padding, zero);
+    Output padded = ops::Pad(
+        device_scope.WithOpName("padded_input_", i), input.tensor,
+        MakeBatchPaddings(host_scope, zero, input_padding, input.rank));
+    TF_RETURN_IF_ERROR(device_scope.status());
+    for (const Edge* e : input.edges) {
+      Node* dst = e->dst();
+      const int dst_input = e->dst_input();
+      g->RemoveEdge(e);
+      g->AddEdge(padded.node(), 0, dst, dst_input);
+    }
+  }
+
+  for (int i = 0; i < cluster.outputs.size(); ++i) {
+    const BatchedTensor& output = cluster.outputs[i];
+    Output size = batch_size;
+    if (output.rank > 1) {
+      size = ops::Concat(
+          host_scope.WithOpName("output_size"),
+          {batch_size, ops::Const(host_scope.WithOpName("all_rows"),
+                                  MakeInt32Vector(std::vector<int32>(
+                                      output.rank - 1, -1)))},
+          /*axis=*/0);
+    }
+    Output sliced = ops::Slice(
+        device_scope.WithOpName("sliced_output_", i), output.tensor,
+        ops::Const(host_scope.WithOpName("output_begin"),
+                   MakeInt32Vector(std::vector<int32>(output.rank, 0))),
+        size);
+    TF_RETURN_IF_ERROR(device_scope.status());
+    for (const Edge* e : output.edges) {
+      Node* dst = e->dst();
+      const int dst_input = e->dst_input();
+      g->RemoveEdge(e);
+      g->AddEdge(sliced.node(), 0, dst, dst_input);
+    }
+  }
+  return status;
+}
+
+Status FindAndPadClusterBatches(Graph* g, absl::Span<const int32> buckets,
+                                bool* changed) {
+  *changed = false;
+  GraphShapeInfo shape_info;
+  Status status = InferShapes(g, /*arg_shapes=*/{}, /*fnlib_def=*/nullptr,
+                              &shape_info);
+  if (!status.ok()) {
+    VLOG(2) << "Not bucketing batch sizes, shape inference failed: "
+            << status;
+    return absl::OkStatus();
+  }
+  std::vector<ControlFlowInfo> control_flow_info;
+  TF_RETURN_IF_ERROR(BuildControlFlowInfo(g, &control_flow_info));
+
+  // The nodes of each cluster in topological order.
+  std::map<std::string, std::vector<Node*>> clusters;
+  std::vector<Node*> order;
+  GetReversePostOrder(*g, &order, NodeComparatorName());
+  for (Node* n : order) {
+    std::optional<absl::string_view> cluster = GetXlaClusterForNode(*n);
+    if (cluster.has_value()) clusters[std::string(*cluster)].push_back(n);
+  }
+
+  for (const auto& [name, nodes] : clusters) {
+    std::optional<BucketableCluster> cluster =
+        GetBucketableCluster(nodes, shape_info, control_flow_info);
+    if (!cluster.has_value()) continue;
+    VLOG(2) << "Bucketing the batch size of cluster " << name;
+    TF_RETURN_IF_ERROR(PadClusterBatch(g, name, *cluster, buckets));
+    *changed = true;
+  }
+
+  if (*changed) {
+    // We've added constants to the graph; hook them up to _SOURCE.
+    FixupSourceAndSinkEdges(g);
+  }
+  return absl::OkStatus();
+}
 }  // namespace
 
 Status IncreaseDynamismForAutoJitPass::Run(
@@ -382,6 +749,16 @@ Status IncreaseDynamismForAutoJitPass::Run(
 
   bool changed;
   TF_RETURN_IF_ERROR(FindAndRewriteSlices(options.graph->get(), &changed));
+
+  std::vector<int32> buckets;
+  TF_RETURN_IF_ERROR(
+      ParseBatchSizeBuckets(flags->tf_xla_batch_size_buckets, &buckets));
+  if (!buckets.empty()) {
+    bool padded;
+    TF_RETURN_IF_ERROR(
+        FindAndPadClusterBatches(options.graph->get(), buckets, &padded));
+    changed |= padded;
+  }
   if (changed && flags->tf_xla_clustering_debug) {
     DumpGraphToFile("increase_dynamism_for_auto_jit_pass", **options.graph,
                     options.flib_def);
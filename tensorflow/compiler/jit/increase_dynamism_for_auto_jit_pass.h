@@ -43,6 +43,20 @@ namespace tensorflow {
 // only on the actual size of the XlaDynamicSlice.  This avoids recompilation
 // due to superficial changes that don't affect tensor shapes.
 //
+// Batch size bucketing
+// --------------------
+//
+// If --tf_xla_batch_size_buckets lists batch sizes, clusters whose inputs with
+// an unknown dimension 0 (the batch) only flow through ops computing each row
+// of their output from the same row of their inputs (elementwise ops, MatMul,
+// BiasAdd, Softmax, ...) are rewritten to
+//
+//   bucket = smallest bucket >= batch, or batch if there is none
+//   cluster(Pad(input, bucket - batch)...) => Slice(output, 0, batch)...
+//
+// with the Pad and Slice outside the cluster.  The cluster is then compiled
+// for at most one batch size per bucket instead of once per batch size.
+//
 // Future Work TODO(b/111210515)
 // -----------------------------
 //
@@ -18,6 +18,9 @@ limitations under the License.
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -454,5 +457,64 @@ TEST(SliceToDynamicSliceRewriteTest, DontRewriteSliceWithConstBegin) {
                                            Out(NodeWith(Op("Const"))))));
 }
 
+class BatchSizeBucketingTest : public ::testing::Test {
+ protected:
+  BatchSizeBucketingTest() {
+    GetMarkForCompilationPassFlags()->tf_xla_batch_size_buckets = "32,8";
+  }
+  ~BatchSizeBucketingTest() override {
+    GetMarkForCompilationPassFlags()->tf_xla_batch_size_buckets = "";
+  }
+};
+
+TEST_F(BatchSizeBucketingTest, PadsInputsAndSlicesOutputs) {
+  Scope root =
+      Scope::NewRootScope().ExitOnError().WithAssignedDevice(kDeviceName);
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(root.WithOpName("input"), DT_FLOAT,
+                                  ops::Placeholder::Shape({-1, 4}));
+  Output bias =
+      ops::Const(cluster.WithOpName("bias"), {1.0f, 2.0f, 3.0f, 4.0f});
+  Output add = ops::AddV2(cluster.WithOpName("add"), input, bias);
+  Output relu = ops::Relu(cluster.WithOpName("relu"), add);
+  Output output = ops::Identity(root.WithOpName("output"), relu);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(IncreaseDynamismForAutoJit(root, &result));
+
+  auto m_input = Out(NodeWith(Op("Placeholder"), Name("input")));
+  auto m_padded_input =
+      Out(NodeWith(Op("Pad"), AssignedDevice(kDeviceName), Inputs(m_input, _)));
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "add"),
+              NodeWith(Op("AddV2"), Inputs(m_padded_input, _)));
+
+  auto m_relu = Out(NodeWith(Op("Relu"), Name("relu")));
+  auto m_sliced_relu = Out(
+      NodeWith(Op("Slice"), AssignedDevice(kDeviceName), Inputs(m_relu, _, _)));
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "output"),
+              NodeWith(Op("Identity"), Inputs(m_sliced_relu)));
+}
+
+TEST_F(BatchSizeBucketingTest, DontPadClustersMixingRows) {
+  Scope root =
+      Scope::NewRootScope().ExitOnError().WithAssignedDevice(kDeviceName);
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(root.WithOpName("input"), DT_FLOAT,
+                                  ops::Placeholder::Shape({-1, 4}));
+  Output relu = ops::Relu(cluster.WithOpName("relu"), input);
+  Output sum = ops::Sum(cluster.WithOpName("sum"), relu, {0});
+  Output output = ops::Identity(root.WithOpName("output"), sum);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(IncreaseDynamismForAutoJit(root, &result));
+
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "relu"),
+              NodeWith(Op("Relu"), Inputs(Out(NodeWith(Name("input"))))));
+  EXPECT_THAT(testing::FindNodeByName(result.get(), "output"),
+              NodeWith(Op("Identity"), Inputs(Out(NodeWith(Name("sum"))))));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include <variant>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
@@ -423,20 +424,22 @@ Status CompileToLocalExecutable(
       compilation_result, executable);
 }
 
-Status GetUpdatedVariables(
-    const OpKernelContext* ctx, absl::Span<const Tensor* const> inputs,
-    absl::Span<const int> variable_indices,
+// Marks the variables of `variable_infos` that `compilation_result` doesn't
+// update as read only, so that running it only reader-locks them.
+void SetReadOnlyUnlessUpdated(
     const XlaCompiler::CompilationResult& compilation_result,
-    std::vector<VariableInfo>* variable_infos) {
-  std::set<int> variables_updated;
+    absl::Span<VariableInfo> variable_infos) {
+  absl::flat_hash_set<int> variables_updated;
   for (const auto& resource_update : compilation_result.resource_updates) {
     if (resource_update.modified) {
       variables_updated.insert(resource_update.input_index);
     }
   }
-  return GetVariableInfosFromInputs(ctx->resource_manager(), ctx->device(),
-                                    inputs, variable_indices,
-                                    &variables_updated, variable_infos);
+  for (VariableInfo& variable_info : variable_infos) {
+    if (!variables_updated.contains(variable_info.index())) {
+      variable_info.set_read_only();
+    }
+  }
 }
 
 // Get-or-create thread pool for a given collective.
@@ -505,7 +508,9 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   // Note that here we assume the shape of the variables don't change between
   // compilation and execution. The locks on the variables are released before
   // compilation so that we can achieve parallel compilation of different batch
-  // sizes during warm-up.
+  // sizes during warm-up. The variables are looked up once, and locked again
+  // through `run_variable_infos` to run the cluster.
+  auto run_variable_infos = std::make_shared<std::vector<VariableInfo>>();
   {
     // Creating a scope so that the locks on the variables are released when
     // variable_infos goes out of scope.
@@ -517,6 +522,7 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
         ctx->resource_manager(), ctx->device(), inputs, resources_,
         &variables_updated, &variable_infos);
     OP_REQUIRES_OK_ASYNC(ctx, status, done);
+    *run_variable_infos = CopyVariableInfos(variable_infos);
     status = LockVariables(absl::MakeSpan(variable_infos));
     OP_REQUIRES_OK_ASYNC(ctx, status, done);
     auto status_or_xla_compiler_args =
@@ -547,16 +553,14 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
 
     auto run_pjrt_cluster = [ctx, pjrt_client, pjrt_executable,
                              compilation_result, done, inputs,
-                             resources = resources_]() {
+                             run_variable_infos]() {
       // Separate scope so that VariableInfo locks are released before done() is
       // called.
       {
-        std::vector<VariableInfo> variable_infos;
-        OP_REQUIRES_OK_ASYNC(
-            ctx,
-            GetUpdatedVariables(ctx, inputs, resources, *compilation_result,
-                                &variable_infos),
-            done);
+        std::vector<VariableInfo> variable_infos =
+            std::move(*run_variable_infos);
+        SetReadOnlyUnlessUpdated(*compilation_result,
+                                 absl::MakeSpan(variable_infos));
         OP_REQUIRES_OK_ASYNC(ctx, LockVariables(absl::MakeSpan(variable_infos)),
                              done);
         OP_REQUIRES_OK_ASYNC(
@@ -582,17 +586,14 @@ void XlaLocalLaunchBase::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
 
   // Continuation of the execution, may be run in a different thread.
   auto run_xla_cluster = [ctx, client, executable, compilation_result, done,
-                          inputs, resources = resources_]() {
+                          run_variable_infos, resources = resources_]() {
     // Separate scope so that VariableInfo locks are released before done is
     // called.
     {
       auto platform_info = XlaPlatformInfoFromDevice(ctx->device());
-      std::vector<VariableInfo> variable_infos;
-      OP_REQUIRES_OK_ASYNC(
-          ctx,
-          GetUpdatedVariables(ctx, inputs, resources, *compilation_result,
-                              &variable_infos),
-          done);
+      std::vector<VariableInfo> variable_infos = std::move(*run_variable_infos);
+      SetReadOnlyUnlessUpdated(*compilation_result,
+                               absl::MakeSpan(variable_infos));
       OP_REQUIRES_OK_ASYNC(ctx, LockVariables(absl::MakeSpan(variable_infos)),
                            done);
       std::map<int, const Tensor*> resource_var_ptrs;
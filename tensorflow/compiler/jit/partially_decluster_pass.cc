@@ -15,10 +15,16 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/partially_decluster_pass.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/jit/device_util.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/const_analysis.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
@@ -27,8 +33,10 @@ limitations under the License.
 #include "tensorflow/core/framework/memory_types.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/graph_node_util.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -400,6 +408,65 @@ Status PartiallyDeclusterGraph(Graph* graph) {
   return absl::OkStatus();
 }
 }  // namespace decluster_root_shape_consumers
+
+namespace decluster_unprofitable_clusters {
+// Sets `node_times` to the total time each node took in the StepStats in the
+// file `path`, a binary or text proto.
+Status ReadNodeTimes(Env* env, const string& path,
+                     absl::flat_hash_map<string, int64_t>* node_times) {
+  StepStats step_stats;
+  TF_RETURN_IF_ERROR(ReadTextOrBinaryProto(env, path, &step_stats));
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      (*node_times)[node_stats.node_name()] += node_stats.all_end_rel_micros();
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Declusters the clusters whose ops ran for less than `min_cluster_time_us` in
+// total in the profile `node_times`, which was collected without
+// auto-clustering.  XLA can't make these clusters much faster, while it adds a
+// launch and possibly host-device copies for their inputs and outputs, so they
+// are faster as TensorFlow kernels.  Clusters with ops missing from the profile
+// are left alone.
+Status PartiallyDeclusterGraph(
+    Graph* graph, const absl::flat_hash_map<string, int64_t>& node_times,
+    int64_t min_cluster_time_us) {
+  // The nodes of each cluster, in a deterministic order.
+  std::map<absl::string_view, std::vector<Node*>> clusters;
+  for (Node* n : graph->op_nodes()) {
+    std::optional<absl::string_view> cluster = GetXlaClusterForNode(*n);
+    if (cluster.has_value()) clusters[*cluster].push_back(n);
+  }
+
+  std::vector<Node*> to_decluster;
+  for (const auto& [cluster, nodes] : clusters) {
+    int64_t cluster_time_us = 0;
+    bool can_decluster = true;
+    for (Node* n : nodes) {
+      auto it = node_times.find(n->name());
+      bool must_compile_node;
+      TF_RETURN_IF_ERROR(
+          reduce_recompilation::MustCompileNode(n, &must_compile_node));
+      if (it == node_times.end() || must_compile_node) {
+        can_decluster = false;
+        break;
+      }
+      cluster_time_us += it->second;
+    }
+    if (!can_decluster || cluster_time_us >= min_cluster_time_us) continue;
+
+    VLOG(2) << "Declustering " << cluster << " because its ops ran for "
+            << cluster_time_us << "us";
+    to_decluster.insert(to_decluster.end(), nodes.begin(), nodes.end());
+  }
+  // Declustering a node frees the name of its cluster, so this can't be done in
+  // the loop above.
+  for (Node* n : to_decluster) RemoveFromXlaCluster(n);
+  return absl::OkStatus();
+}
+}  // namespace decluster_unprofitable_clusters
 }  // namespace
 
 Status PartiallyDeclusterPass::Run(
@@ -430,6 +497,16 @@ Status PartiallyDeclusterPass::Run(
   TF_RETURN_IF_ERROR(
       decluster_root_shape_consumers::PartiallyDeclusterGraph(graph));
 
+  const MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  if (!flags->tf_xla_cluster_step_stats_profile.empty()) {
+    absl::flat_hash_map<string, int64_t> node_times;
+    TF_RETURN_IF_ERROR(decluster_unprofitable_clusters::ReadNodeTimes(
+        options.session_options->env, flags->tf_xla_cluster_step_stats_profile,
+        &node_times));
+    TF_RETURN_IF_ERROR(decluster_unprofitable_clusters::PartiallyDeclusterGraph(
+        graph, node_times, flags->tf_xla_min_profiled_cluster_time_us));
+  }
+
   return absl::OkStatus();
 }
 }  // namespace tensorflow
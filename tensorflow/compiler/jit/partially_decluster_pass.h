@@ -21,10 +21,13 @@ limitations under the License.
 namespace tensorflow {
 
 // Clones or moves nodes from within a cluster to outside the cluster if
-// profitable.  There are two reasons why we do this:
+// profitable.  There are three reasons why we do this:
 //
 //  - Reducing device-to-host copies.
 //  - Reducing the number of XLA recompilations.
+//  - Running clusters that are too cheap to profit from XLA as TensorFlow
+//    kernels, going by the per-node runtimes in the StepStats profile of
+//    --tf_xla_cluster_step_stats_profile.
 class PartiallyDeclusterPass : public GraphOptimizationPass {
  public:
   Status Run(const GraphOptimizationPassOptions& options) override;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/test_util.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/cc/ops/xla_ops.h"
@@ -35,9 +36,12 @@ limitations under the License.
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -557,5 +561,45 @@ TEST(PartiallyDeclusterPassTest,
   EXPECT_EQ(GetXlaClusterForNode(*n_c), "cluster_0");
 }
 
+TEST(PartiallyDeclusterPassTest, ClustersCheaperThanProfiledTimeDeclustered) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::Scope cheap_cluster = root.WithXlaCluster("cluster_0");
+  tensorflow::Scope costly_cluster = root.WithXlaCluster("cluster_1");
+  tensorflow::Scope unprofiled_cluster = root.WithXlaCluster("cluster_2");
+  auto graph = std::make_unique<Graph>(OpRegistry::Global());
+  Output a = ops::Placeholder(root.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Add(cheap_cluster.WithOpName("b"), a, a);
+  Output c = ops::Mul(cheap_cluster.WithOpName("c"), b, b);
+  Output d = ops::Add(costly_cluster.WithOpName("d"), a, a);
+  Output e = ops::Mul(costly_cluster.WithOpName("e"), d, d);
+  Output f = ops::Add(unprofiled_cluster.WithOpName("f"), a, a);
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  for (const auto& [name, time_us] :
+       std::vector<std::pair<string, int64_t>>{{"b", 10}, {"c", 20},
+                                               {"d", 40}, {"e", 30}}) {
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_node_name(name);
+    node_stats->set_all_end_rel_micros(time_us);
+  }
+  const string profile_path =
+      io::JoinPath(testing::TmpDir(), "partially_decluster_profile.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), profile_path, step_stats));
+
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  flags->tf_xla_cluster_step_stats_profile = profile_path;
+  Status status = PartiallyDecluster(&graph);
+  flags->tf_xla_cluster_step_stats_profile = "";
+  TF_ASSERT_OK(status);
+
+  EXPECT_EQ(GetXlaClusterForNode(*FindNodeByName(*graph, "b")), std::nullopt);
+  EXPECT_EQ(GetXlaClusterForNode(*FindNodeByName(*graph, "c")), std::nullopt);
+  EXPECT_EQ(GetXlaClusterForNode(*FindNodeByName(*graph, "d")), "cluster_1");
+  EXPECT_EQ(GetXlaClusterForNode(*FindNodeByName(*graph, "e")), "cluster_1");
+  EXPECT_EQ(GetXlaClusterForNode(*FindNodeByName(*graph, "f")), "cluster_2");
+}
+
 }  // namespace
 }  // namespace tensorflow
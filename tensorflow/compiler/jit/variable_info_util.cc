@@ -85,6 +85,19 @@ Status GetVariableInfosFromInputs(ResourceMgr* rm, DeviceBase* dev,
   return absl::OkStatus();
 }
 
+std::vector<VariableInfo> CopyVariableInfos(
+    absl::Span<VariableInfo const> variable_infos) {
+  std::vector<VariableInfo> result;
+  result.reserve(variable_infos.size());
+  for (const VariableInfo& variable_info : variable_infos) {
+    Var* variable = variable_info.var();
+    if (variable != nullptr) variable->Ref();
+    result.emplace_back(variable_info.index(), variable_info.name(), variable,
+                        variable_info.definition_stack_trace());
+  }
+  return result;
+}
+
 Status LockVariables(absl::Span<VariableInfo*> variables) {
   std::vector<int> lock_order(variables.size());
   std::iota(lock_order.begin(), lock_order.end(), 0);
@@ -82,6 +82,13 @@ Status GetVariableInfosFromInputs(ResourceMgr* rm, DeviceBase* dev,
                                   const std::set<int>* variables_updated,
                                   std::vector<VariableInfo>* result);
 
+// Returns unlocked VariableInfo instances for the variables of
+// `variable_infos`, each holding a new reference to its variable. Callers that
+// lock the variables again later, e.g. to run a cluster once it is compiled,
+// use this instead of looking them up in the resource manager a second time.
+std::vector<VariableInfo> CopyVariableInfos(
+    absl::Span<VariableInfo const> variable_infos);
+
 std::vector<int> GetResourceVariableIndicesFromContext(OpKernelContext* ctx);
 
 Status CreateVariableInfoLookup(
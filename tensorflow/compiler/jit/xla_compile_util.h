@@ -23,7 +23,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 
 namespace tensorflow {
-// The number of compiler threads to use for asynchronous device compilation.
+// The default number of compiler threads to use for asynchronous device
+// compilation (see XlaOpsCommonFlags::tf_xla_async_compilation_threads).
 inline constexpr int64_t kNumAsyncDeviceCompilerThreads = 10;
 
 enum class DeviceCompileMode {
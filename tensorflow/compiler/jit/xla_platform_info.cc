@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/compiler/jit/device_executable_persistor.h"
@@ -34,7 +35,9 @@ limitations under the License.
 #include "xla/client/client_library.h"
 #include "xla/client/local_client.h"
 #include "xla/pjrt/pjrt_client.h"
+#include "xla/service/backend.h"
 #include "xla/service/compiler.h"
+#include "xla/stream_executor/device_description.h"
 #include "xla/stream_executor/platform_manager.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -68,6 +71,25 @@ XlaDeviceCompiler* CreateXlaDeviceCompiler(
       std::make_unique<XlaDeviceCompilerClient>(local_client));
 }
 
+// Identifies the device `client` compiles for in the keys of the persistent
+// cache.
+std::string GetDeviceFingerprint(xla::LocalClient* client) {
+  const se::DeviceDescription& description =
+      client->backend().default_stream_executor()->GetDeviceDescription();
+  return absl::StrCat(client->platform()->Name(), ":", description.model_str(),
+                      ":", description.platform_version());
+}
+
+std::string GetDeviceFingerprint(xla::PjRtClient* client) {
+  std::string fingerprint =
+      absl::StrCat(client->platform_name(), ":", client->platform_version());
+  if (!client->addressable_devices().empty()) {
+    absl::StrAppend(&fingerprint, ":",
+                    client->addressable_devices()[0]->device_kind());
+  }
+  return fingerprint;
+}
+
 PjRtDeviceCompiler* CreatePjRtDeviceCompiler(DeviceType compilation_device_type,
                                              xla::PjRtClient* pjrt_client) {
   std::string persistent_cache_directory =
@@ -78,6 +100,9 @@ PjRtDeviceCompiler* CreatePjRtDeviceCompiler(DeviceType compilation_device_type,
       GetMarkForCompilationPassFlags()->tf_xla_disable_strict_signature_checks,
       GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_prefix,
       GetMarkForCompilationPassFlags()->tf_xla_persistent_cache_read_only);
+  if (pjrt_client != nullptr) {
+    persistor_config.device_fingerprint = GetDeviceFingerprint(pjrt_client);
+  }
 
   return new PjRtDeviceCompiler(
       std::make_unique<PjRtDeviceExecutablePersistor>(
@@ -289,6 +314,7 @@ Status BuildXlaDeviceCompiler(DeviceBase* device, FunctionLibraryRuntime* flr,
 
   TF_ASSIGN_OR_RETURN(
       auto client, xla::ClientLibrary::GetOrCreateLocalClient(client_options));
+  persistor_config.device_fingerprint = GetDeviceFingerprint(client);
 
   *xla_device_compiler = CreateXlaDeviceCompiler(
       persistor_config, compilation_device_type, client);
@@ -102,6 +102,10 @@ struct PassConfig {
 
   // Enables the attempt to directly lower composites into tflite ops.
   bool enable_composite_direct_lowering = false;
+
+  // If not empty, the backend whose delegate the model is optimized for, one
+  // of "xnnpack", "gpu" or "nnapi".
+  std::string target_backend;
 };
 
 inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
@@ -131,6 +135,7 @@ inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
             << "\nlegalize_custom_tensor_list_ops: "
             << pass_config.legalize_custom_tensor_list_ops
             << "\nreduce_type_precision: " << pass_config.reduce_type_precision
+            << "\ntarget_backend: " << pass_config.target_backend
             << "\nconvert_qdq_format: "
             << GetQDQQuantModeString(pass_config.qdq_conversion_mode) << "\n";
 }
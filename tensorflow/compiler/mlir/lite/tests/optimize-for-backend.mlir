@@ -0,0 +1,91 @@
+// RUN: tf-opt %s -tfl-optimize-for-backend="target-backend=xnnpack" --split-input-file | FileCheck %s --check-prefixes=CHECK,XNNPACK
+// RUN: tf-opt %s -tfl-optimize-for-backend="target-backend=gpu" --split-input-file | FileCheck %s --check-prefixes=CHECK,GPU
+
+// CHECK-LABEL: fuseSamePadIntoConv
+func.func @fuseSamePadIntoConv(%arg0: tensor<1x8x8x3xf32>, %arg1: tensor<16x3x3x3xf32>, %arg2: tensor<16xf32>) -> tensor<1x8x8x16xf32> {
+  %paddings = arith.constant dense<[[0, 0], [1, 1], [1, 1], [0, 0]]> : tensor<4x2xi32>
+  %0 = "tfl.pad"(%arg0, %paddings) : (tensor<1x8x8x3xf32>, tensor<4x2xi32>) -> tensor<1x10x10x3xf32>
+  %1 = "tfl.conv_2d"(%0, %arg1, %arg2) {dilation_h_factor = 1 : i32, dilation_w_factor = 1 : i32, fused_activation_function = "NONE", padding = "VALID", stride_h = 1 : i32, stride_w = 1 : i32} : (tensor<1x10x10x3xf32>, tensor<16x3x3x3xf32>, tensor<16xf32>) -> tensor<1x8x8x16xf32>
+  func.return %1 : tensor<1x8x8x16xf32>
+
+  // CHECK-NOT: tfl.pad
+  // CHECK: %[[CONV:.*]] = "tfl.conv_2d"(%arg0, %arg1, %arg2)
+  // CHECK-SAME: padding = "SAME"
+  // CHECK: return %[[CONV]]
+}
+
+// -----
+
+// CHECK-LABEL: fuseSamePadIntoStridedDepthwiseConv
+func.func @fuseSamePadIntoStridedDepthwiseConv(%arg0: tensor<1x8x8x3xf32>, %arg1: tensor<1x3x3x3xf32>, %arg2: tensor<3xf32>) -> tensor<1x4x4x3xf32> {
+  %paddings = arith.constant dense<[[0, 0], [0, 1], [0, 1], [0, 0]]> : tensor<4x2xi32>
+  %0 = "tfl.pad"(%arg0, %paddings) : (tensor<1x8x8x3xf32>, tensor<4x2xi32>) -> tensor<1x9x9x3xf32>
+  %1 = "tfl.depthwise_conv_2d"(%0, %arg1, %arg2) {depth_multiplier = 1 : i32, dilation_h_factor = 1 : i32, dilation_w_factor = 1 : i32, fused_activation_function = "NONE", padding = "VALID", stride_h = 2 : i32, stride_w = 2 : i32} : (tensor<1x9x9x3xf32>, tensor<1x3x3x3xf32>, tensor<3xf32>) -> tensor<1x4x4x3xf32>
+  func.return %1 : tensor<1x4x4x3xf32>
+
+  // CHECK-NOT: tfl.pad
+  // CHECK: %[[CONV:.*]] = "tfl.depthwise_conv_2d"(%arg0, %arg1, %arg2)
+  // CHECK-SAME: padding = "SAME"
+  // CHECK: return %[[CONV]]
+}
+
+// -----
+
+// CHECK-LABEL: doNotFuseAsymmetricPadIntoConv
+func.func @doNotFuseAsymmetricPadIntoConv(%arg0: tensor<1x8x8x3xf32>, %arg1: tensor<16x3x3x3xf32>, %arg2: tensor<16xf32>) -> tensor<1x8x8x16xf32> {
+  %paddings = arith.constant dense<[[0, 0], [2, 0], [1, 1], [0, 0]]> : tensor<4x2xi32>
+  %0 = "tfl.pad"(%arg0, %paddings) : (tensor<1x8x8x3xf32>, tensor<4x2xi32>) -> tensor<1x10x10x3xf32>
+  %1 = "tfl.conv_2d"(%0, %arg1, %arg2) {dilation_h_factor = 1 : i32, dilation_w_factor = 1 : i32, fused_activation_function = "NONE", padding = "VALID", stride_h = 1 : i32, stride_w = 1 : i32} : (tensor<1x10x10x3xf32>, tensor<16x3x3x3xf32>, tensor<16xf32>) -> tensor<1x8x8x16xf32>
+  func.return %1 : tensor<1x8x8x16xf32>
+
+  // CHECK: %[[PAD:.*]] = "tfl.pad"(%arg0
+  // CHECK: "tfl.conv_2d"(%[[PAD]], %arg1, %arg2)
+  // CHECK-SAME: padding = "VALID"
+}
+
+// -----
+
+// CHECK-LABEL: lowerTransposeRank
+func.func @lowerTransposeRank(%arg0: tensor<2x3x4x5x6xf32>) -> tensor<2x5x6x3x4xf32> {
+  %perm = arith.constant dense<[0, 3, 4, 1, 2]> : tensor<5xi32>
+  %0 = "tfl.transpose"(%arg0, %perm) : (tensor<2x3x4x5x6xf32>, tensor<5xi32>) -> tensor<2x5x6x3x4xf32>
+  func.return %0 : tensor<2x5x6x3x4xf32>
+
+  // XNNPACK: %[[TRANSPOSE:.*]] = "tfl.transpose"(%arg0, %{{.*}}) : (tensor<2x3x4x5x6xf32>, tensor<5xi32>) -> tensor<2x5x6x3x4xf32>
+  // XNNPACK: return %[[TRANSPOSE]]
+
+  // GPU-DAG: %[[INPUT_SHAPE:.*]] = arith.constant dense<[2, 12, 30]> : tensor<3xi32>
+  // GPU-DAG: %[[PERM:.*]] = arith.constant dense<[0, 2, 1]> : tensor<3xi32>
+  // GPU-DAG: %[[OUTPUT_SHAPE:.*]] = arith.constant dense<[2, 5, 6, 3, 4]> : tensor<5xi32>
+  // GPU: %[[RESHAPE:.*]] = "tfl.reshape"(%arg0, %[[INPUT_SHAPE]]) : (tensor<2x3x4x5x6xf32>, tensor<3xi32>) -> tensor<2x12x30xf32>
+  // GPU: %[[TRANSPOSE:.*]] = "tfl.transpose"(%[[RESHAPE]], %[[PERM]]) : (tensor<2x12x30xf32>, tensor<3xi32>) -> tensor<2x30x12xf32>
+  // GPU: %[[RESULT:.*]] = "tfl.reshape"(%[[TRANSPOSE]], %[[OUTPUT_SHAPE]]) : (tensor<2x30x12xf32>, tensor<5xi32>) -> tensor<2x5x6x3x4xf32>
+  // GPU: return %[[RESULT]]
+}
+
+// -----
+
+// CHECK-LABEL: lowerTransposeOfUnitDimensions
+func.func @lowerTransposeOfUnitDimensions(%arg0: tensor<1x3x1x5x1xf32>) -> tensor<1x1x3x5x1xf32> {
+  %perm = arith.constant dense<[2, 0, 1, 3, 4]> : tensor<5xi32>
+  %0 = "tfl.transpose"(%arg0, %perm) : (tensor<1x3x1x5x1xf32>, tensor<5xi32>) -> tensor<1x1x3x5x1xf32>
+  func.return %0 : tensor<1x1x3x5x1xf32>
+
+  // XNNPACK: "tfl.transpose"
+
+  // GPU-NOT: "tfl.transpose"
+  // GPU: %[[RESULT:.*]] = "tfl.reshape"(%arg0, %{{.*}}) : (tensor<1x3x1x5x1xf32>, tensor<5xi32>) -> tensor<1x1x3x5x1xf32>
+  // GPU: return %[[RESULT]]
+}
+
+// -----
+
+// CHECK-LABEL: doNotLowerIrreducibleTranspose
+func.func @doNotLowerIrreducibleTranspose(%arg0: tensor<2x3x4x5x6xf32>) -> tensor<6x5x4x3x2xf32> {
+  %perm = arith.constant dense<[4, 3, 2, 1, 0]> : tensor<5xi32>
+  %0 = "tfl.transpose"(%arg0, %perm) : (tensor<2x3x4x5x6xf32>, tensor<5xi32>) -> tensor<6x5x4x3x2xf32>
+  func.return %0 : tensor<6x5x4x3x2xf32>
+
+  // CHECK-NOT: "tfl.reshape"
+  // CHECK: "tfl.transpose"(%arg0
+}
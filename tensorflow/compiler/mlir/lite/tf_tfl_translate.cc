@@ -295,6 +295,7 @@ int main(int argc, char **argv) {
   pass_config.enable_hlo_to_tf_conversion = enable_hlo_to_tf_conversion;
   pass_config.disable_hlo_to_tfl_conversion = disable_hlo_to_tfl_conversion;
   pass_config.reduce_type_precision = reduce_type_precision;
+  pass_config.target_backend = target_backend;
 
   toco::TocoFlags toco_flags;
   toco_flags.set_force_select_tf_ops(!emit_builtin_tflite_ops);
@@ -209,3 +209,10 @@ opt<bool> reduce_type_precision(
                    "within the reduced precision range. This could have side "
                    "effects triggered by downstream packing algorithms."),
     llvm::cl::init(false));
+
+// NOLINTNEXTLINE
+opt<std::string> target_backend(
+    "target-backend",
+    llvm::cl::desc("Optimize the model for the delegate of this backend, one "
+                   "of xnnpack, gpu or nnapi."),
+    llvm::cl::init(""));
@@ -48,6 +48,7 @@ extern llvm::cl::opt<bool> enable_dynamic_update_slice;
 extern llvm::cl::opt<bool> preserve_assert_op;
 extern llvm::cl::opt<bool> legalize_custom_tensor_list_ops;
 extern llvm::cl::opt<bool> reduce_type_precision;
+extern llvm::cl::opt<std::string> target_backend;
 
 // Import saved model.
 extern llvm::cl::opt<bool> import_saved_model_object_graph;
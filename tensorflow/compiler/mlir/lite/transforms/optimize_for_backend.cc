@@ -0,0 +1,299 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// This transformation pass rewrites TFL ops into forms that a delegate runs
+// without materializing extra tensors.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Casting.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"  // from @llvm-project
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
+#include "mlir/Dialect/Quant/QuantTypes.h"  // from @llvm-project
+#include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
+#include "mlir/IR/BuiltinTypes.h"  // from @llvm-project
+#include "mlir/IR/Matchers.h"  // from @llvm-project
+#include "mlir/IR/MLIRContext.h"  // from @llvm-project
+#include "mlir/IR/PatternMatch.h"  // from @llvm-project
+#include "mlir/IR/Value.h"  // from @llvm-project
+#include "mlir/Pass/Pass.h"  // from @llvm-project
+#include "mlir/Support/LogicalResult.h"  // from @llvm-project
+#include "mlir/Support/TypeID.h"  // from @llvm-project
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"  // from @llvm-project
+#include "tensorflow/compiler/mlir/lite/ir/tfl_ops.h"
+#include "tensorflow/compiler/mlir/lite/transforms/passes.h"
+
+namespace mlir {
+namespace TFL {
+namespace {
+#define GEN_PASS_DEF_OPTIMIZEFORBACKENDPASS
+#include "tensorflow/compiler/mlir/lite/transforms/passes.h.inc"
+
+// What the patterns need to know about the delegate of a target backend.
+struct BackendProfile {
+  // The highest rank of the transposes that the delegate runs. Higher rank
+  // transposes are left to the CPU kernels, which splits the delegated graph.
+  int max_transpose_rank;
+};
+
+std::optional<BackendProfile> GetBackendProfile(llvm::StringRef backend) {
+  if (backend == "xnnpack") {
+    return BackendProfile{/*max_transpose_rank=*/6};
+  }
+  if (backend == "gpu" || backend == "nnapi") {
+    return BackendProfile{/*max_transpose_rank=*/4};
+  }
+  return std::nullopt;
+}
+
+class OptimizeForBackendPass
+    : public impl::OptimizeForBackendPassBase<OptimizeForBackendPass> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(OptimizeForBackendPass)
+
+  OptimizeForBackendPass() = default;
+  OptimizeForBackendPass(const OptimizeForBackendPass &) {}
+  explicit OptimizeForBackendPass(llvm::StringRef target_backend) {
+    this->target_backend_ = target_backend.str();
+  }
+
+  void runOnOperation() override;
+};
+
+// Returns whether `value` is a constant, and appends its values to `values`.
+bool GetConstantInts(Value value, llvm::SmallVectorImpl<int64_t> &values) {
+  DenseIntElementsAttr attr;
+  if (!matchPattern(value, m_Constant(&attr))) return false;
+  for (const llvm::APInt &element : attr.getValues<llvm::APInt>()) {
+    values.push_back(element.getSExtValue());
+  }
+  return true;
+}
+
+// Returns the padding before and after a spatial dimension of `size` with the
+// SAME padding of a convolution.
+std::pair<int64_t, int64_t> GetSamePadding(int64_t size, int64_t filter_size,
+                                           int64_t stride, int64_t dilation) {
+  const int64_t effective_filter_size = (filter_size - 1) * dilation + 1;
+  const int64_t output_size = (size + stride - 1) / stride;
+  const int64_t total = std::max<int64_t>(
+      (output_size - 1) * stride + effective_filter_size - size, 0);
+  return {total / 2, total - total / 2};
+}
+
+// conv(pad(x), VALID) -> conv(x, SAME)
+//   iff the pad only pads the spatial dimensions, as SAME padding would.
+//
+// The padded tensor isn't materialized anymore, and the convolution reads the
+// zeros of its padding from its input directly.
+template <typename ConvOp>
+class FuseSamePadIntoConv : public OpRewritePattern<ConvOp> {
+ public:
+  using OpRewritePattern<ConvOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ConvOp conv,
+                                PatternRewriter &rewriter) const override {
+    if (conv.getPadding() != "VALID") return failure();
+    auto pad = conv.getInput().template getDefiningOp<TFL::PadOp>();
+    if (!pad) return failure();
+
+    auto input_type =
+        llvm::dyn_cast<RankedTensorType>(pad.getInput().getType());
+    auto filter_type =
+        llvm::dyn_cast<RankedTensorType>(conv.getFilter().getType());
+    if (!input_type || !filter_type || !input_type.hasStaticShape() ||
+        !filter_type.hasStaticShape() || input_type.getRank() != 4 ||
+        filter_type.getRank() != 4) {
+      return failure();
+    }
+
+    // Both filters are [*, height, width, *].
+    llvm::SmallVector<int64_t, 8> paddings;
+    if (!GetConstantInts(pad.getPadding(), paddings) || paddings.size() != 8 ||
+        paddings[0] != 0 || paddings[1] != 0 || paddings[6] != 0 ||
+        paddings[7] != 0) {
+      return failure();
+    }
+    const std::pair<int64_t, int64_t> height_padding = GetSamePadding(
+        input_type.getDimSize(1), filter_type.getDimSize(1),
+        conv.getStrideH(), conv.getDilationHFactor());
+    const std::pair<int64_t, int64_t> width_padding = GetSamePadding(
+        input_type.getDimSize(2), filter_type.getDimSize(2),
+        conv.getStrideW(), conv.getDilationWFactor());
+    if (paddings[2] != height_padding.first ||
+        paddings[3] != height_padding.second ||
+        paddings[4] != width_padding.first ||
+        paddings[5] != width_padding.second) {
+      return failure();
+    }
+
+    rewriter.modifyOpInPlace(conv, [&] {
+      conv->setOperand(0, pad.getInput());
+      conv->setAttr("padding", rewriter.getStringAttr("SAME"));
+    });
+    return success();
+  }
+};
+
+// transpose(x) -> reshape(transpose(reshape(x)))
+//   iff the transpose has a higher rank than the delegate runs, and its rank
+//   can be lowered enough by dropping the unit dimensions and merging the
+//   dimensions that stay next to each other.
+class LowerTransposeRank : public OpRewritePattern<TFL::TransposeOp> {
+ public:
+  LowerTransposeRank(MLIRContext *context, int max_rank)
+      : OpRewritePattern<TFL::TransposeOp>(context), max_rank_(max_rank) {}
+
+  LogicalResult matchAndRewrite(TFL::TransposeOp transpose,
+                                PatternRewriter &rewriter) const override {
+    auto input_type =
+        llvm::dyn_cast<RankedTensorType>(transpose.getInput().getType());
+    auto output_type = llvm::dyn_cast<RankedTensorType>(transpose.getType());
+    if (!input_type || !output_type || !input_type.hasStaticShape() ||
+        !output_type.hasStaticShape() || input_type.getRank() <= max_rank_ ||
+        llvm::isa<quant::UniformQuantizedPerAxisType>(
+            input_type.getElementType())) {
+      return failure();
+    }
+    llvm::SmallVector<int64_t> perm;
+    if (!GetConstantInts(transpose.getPerm(), perm)) return failure();
+
+    // The positions of the non-unit dimensions in the input, and their sizes.
+    llvm::ArrayRef<int64_t> shape = input_type.getShape();
+    llvm::SmallVector<int64_t> positions(shape.size(), -1);
+    llvm::SmallVector<int64_t> sizes;
+    const int64_t rank = shape.size();
+    for (int64_t dim = 0; dim < rank; ++dim) {
+      if (shape[dim] == 1) continue;
+      positions[dim] = sizes.size();
+      sizes.push_back(shape[dim]);
+    }
+
+    // The groups of the non-unit dimensions that stay next to each other, in
+    // the order of the output, as their first position and size.
+    llvm::SmallVector<std::pair<int64_t, int64_t>> groups;
+    int64_t previous_position = -2;
+    for (int64_t dim : perm) {
+      if (dim < 0 || dim >= rank) return failure();
+      const int64_t position = positions[dim];
+      if (position < 0) continue;
+      if (position == previous_position + 1) {
+        groups.back().second *= sizes[position];
+      } else {
+        groups.push_back({position, sizes[position]});
+      }
+      previous_position = position;
+    }
+    if (groups.size() > static_cast<size_t>(max_rank_)) return failure();
+
+    Location loc = transpose.getLoc();
+    if (groups.size() <= 1) {
+      // Only the unit dimensions moved.
+      rewriter.replaceOpWithNewOp<TFL::ReshapeOp>(
+          transpose, output_type, transpose.getInput(),
+          CreateShape(rewriter, loc, output_type.getShape()));
+      return success();
+    }
+
+    // The groups in the order of the input.
+    llvm::SmallVector<int64_t> input_order(groups.size());
+    std::iota(input_order.begin(), input_order.end(), 0);
+    std::sort(input_order.begin(), input_order.end(),
+              [&groups](int64_t a, int64_t b) {
+                return groups[a].first < groups[b].first;
+              });
+    llvm::SmallVector<int64_t> reshaped_input_shape;
+    llvm::SmallVector<int32_t> reshaped_perm(groups.size());
+    for (int64_t i = 0; i < static_cast<int64_t>(input_order.size()); ++i) {
+      reshaped_input_shape.push_back(groups[input_order[i]].second);
+      reshaped_perm[input_order[i]] = i;
+    }
+    llvm::SmallVector<int64_t> reshaped_output_shape;
+    for (const std::pair<int64_t, int64_t> &group : groups) {
+      reshaped_output_shape.push_back(group.second);
+    }
+
+    auto reshaped_input = rewriter.create<TFL::ReshapeOp>(
+        loc, input_type.clone(reshaped_input_shape), transpose.getInput(),
+        CreateShape(rewriter, loc, reshaped_input_shape));
+    auto perm_type = RankedTensorType::get(
+        {static_cast<int64_t>(reshaped_perm.size())}, rewriter.getI32Type());
+    auto reshaped_transpose = rewriter.create<TFL::TransposeOp>(
+        loc, output_type.clone(reshaped_output_shape), reshaped_input,
+        rewriter.create<arith::ConstantOp>(
+            loc, DenseIntElementsAttr::get(perm_type, reshaped_perm)));
+    rewriter.replaceOpWithNewOp<TFL::ReshapeOp>(
+        transpose, output_type, reshaped_transpose,
+        CreateShape(rewriter, loc, output_type.getShape()));
+    return success();
+  }
+
+ private:
+  static Value CreateShape(PatternRewriter &rewriter, Location loc,
+                           llvm::ArrayRef<int64_t> shape) {
+    llvm::SmallVector<int32_t> values(shape.begin(), shape.end());
+    auto type = RankedTensorType::get({static_cast<int64_t>(values.size())},
+                                      rewriter.getI32Type());
+    return rewriter.create<arith::ConstantOp>(
+        loc, DenseIntElementsAttr::get(type, values));
+  }
+
+  int max_rank_;
+};
+
+void OptimizeForBackendPass::runOnOperation() {
+  const std::optional<BackendProfile> profile =
+      GetBackendProfile(target_backend_);
+  if (!profile) {
+    getOperation().emitError()
+        << "unknown target backend '" << target_backend_
+        << "', expected one of xnnpack, gpu or nnapi";
+    return signalPassFailure();
+  }
+
+  MLIRContext *context = &getContext();
+  RewritePatternSet patterns(context);
+  patterns.add<FuseSamePadIntoConv<TFL::Conv2DOp>,
+               FuseSamePadIntoConv<TFL::DepthwiseConv2DOp>>(context);
+  patterns.add<LowerTransposeRank>(context, profile->max_transpose_rank);
+  if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                          std::move(patterns)))) {
+    signalPassFailure();
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizeForBackendPass(
+    llvm::StringRef target_backend) {
+  return std::make_unique<OptimizeForBackendPass>(target_backend);
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizeForBackendPass() {
+  return std::make_unique<OptimizeForBackendPass>();
+}
+
+}  // namespace TFL
+}  // namespace mlir
@@ -20,6 +20,7 @@ limitations under the License.
 #include <string>
 
 #include "absl/container/flat_hash_set.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/Pass/Pass.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/quantization/common/quantization_lib/quantization_config.h"
 
@@ -64,6 +65,13 @@ std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizePass(
     bool enable_canonicalization, bool disable_fuse_mul_and_fc = false);
 std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizePass();
 
+// Creates an instance of the TensorFlow Lite dialect pass that optimizes the
+// ops for the delegate of `target_backend`, one of "xnnpack", "gpu" or
+// "nnapi".
+std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizeForBackendPass(
+    llvm::StringRef target_backend);
+std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizeForBackendPass();
+
 // Creates an instance of the Tensorflow Lite batch matmul Optimize pass.
 std::unique_ptr<OperationPass<func::FuncOp>> CreateOptimizeBatchMatmulPass();
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/compiler/tf2tensorrt/convert/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_allocator.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_utils.h"
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_experimental_features.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_logger.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_lru_cache.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_shape_optimization_profiles.h"
@@ -40,8 +42,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
@@ -276,6 +280,10 @@ class TRTEngineOp : public AsyncOpKernel {
 
   // Whether to use explicit precision (QDQ) mode.
   bool use_explicit_precision_;
+
+  // If non-empty, the key under which the engine cache is shared with the
+  // TRTEngineOps of other sessions building the same engines.
+  string shared_cache_key_;
 };
 
 #define TYPECASE(dt, X)                                       \
@@ -395,6 +403,34 @@ StatusOr<FunctionLibraryRuntime::Handle> TRTEngineOp::ConstructFunctionHandle(
   return status;
 }
 
+// Returns a key identifying the engines that TRTEngineOp `def` on `device_name`
+// builds from `segment_graph_def`, or loads from its serialized segment: a
+// fingerprint of the segment with its weights and of the attributes
+// configuring the conversion. The name of the native segment function is left
+// out, it may differ across loads of the same model.
+static string GetSharedEngineCacheKey(const NodeDef& def,
+                                      const GraphDef& segment_graph_def,
+                                      const string& device_name) {
+  const std::map<string, AttrValue> attrs(def.attr().begin(),
+                                          def.attr().end());
+  string serialized_attrs;
+  for (const auto& [name, value] : attrs) {
+    if (name == "segment_func") continue;
+    string serialized_value;
+    SerializeToStringDeterministic(value, &serialized_value);
+    absl::StrAppend(&serialized_attrs, name, "=", serialized_value.size(), ":",
+                    serialized_value, ";");
+  }
+  string serialized_segment;
+  SerializeToStringDeterministic(segment_graph_def, &serialized_segment);
+  const Fprint128 attrs_fingerprint = Fingerprint128(serialized_attrs);
+  const Fprint128 segment_fingerprint = Fingerprint128(serialized_segment);
+  return absl::StrCat(device_name, "/", absl::Hex(attrs_fingerprint.high64),
+                      absl::Hex(attrs_fingerprint.low64), "_",
+                      absl::Hex(segment_fingerprint.high64),
+                      absl::Hex(segment_fingerprint.low64));
+}
+
 Status TRTEngineOp::ImportSegmentGraphDef(FunctionLibraryRuntime* lib,
                                           const string& device_name) {
   tensorflow::profiler::TraceMe activity(
@@ -550,6 +586,16 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
       [](PartialTensorShape shape) { return !shape.IsFullyDefined(); });
   VLOG(2) << "TRTEngineOp has_dynamic_shape_input_: "
           << has_dynamic_shape_input_;
+
+  // Calibration state is per op, so only engines built or loaded without
+  // calibrating are shared. Dynamic engines are identified by their segment,
+  // which is missing if the model was saved without native segments.
+  if (isExperimentalFeatureActivated("share_engine_caches") &&
+      !calibration_mode_ &&
+      (static_engine_ || !segment_graph_def_.node().empty())) {
+    shared_cache_key_ = GetSharedEngineCacheKey(def(), segment_graph_def_,
+                                                context->device()->name());
+  }
 }
 
 // Copies input tensor ctx->input(i) (which is in device memory) to the host,
@@ -1079,7 +1125,14 @@ Status TRTEngineOp::GetEngineCacheResource(OpKernelContext* ctx,
   return ctx->resource_manager()->LookupOrCreate(
       std::string(kTfTrtContainerName), std::string(resource_name), cache_res,
       {[this, ctx](TRTEngineCacheResource** cr) -> Status {
-        *cr = new TRTEngineCacheResource(ctx, this->max_cached_engines_);
+        auto create = [this, ctx]() {
+          return new TRTEngineCacheResource(ctx, this->max_cached_engines_);
+        };
+        if (!shared_cache_key_.empty()) {
+          return TRTEngineCacheResource::LookupOrCreateShared(
+              shared_cache_key_, create, cr);
+        }
+        *cr = create();
         return OkStatus();
       }});
 }
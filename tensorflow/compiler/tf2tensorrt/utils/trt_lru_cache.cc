@@ -70,8 +70,51 @@ TRTEngineCacheResource::TRTEngineCacheResource(OpKernelContext* ctx,
   }
 }
 
+namespace {
+// The cache resources shared by LookupOrCreateShared(), by key.
+struct SharedCacheResources {
+  mutex mu;
+  std::unordered_map<string, TRTEngineCacheResource*> resources
+      TF_GUARDED_BY(mu);
+};
+
+SharedCacheResources& GetSharedCacheResources() {
+  static SharedCacheResources* shared = new SharedCacheResources();
+  return *shared;
+}
+}  // namespace
+
+Status TRTEngineCacheResource::LookupOrCreateShared(
+    const string& key, const std::function<TRTEngineCacheResource*()>& create,
+    TRTEngineCacheResource** resource) {
+  SharedCacheResources& shared = GetSharedCacheResources();
+  mutex_lock lock(shared.mu);
+  TRTEngineCacheResource*& shared_resource = shared.resources[key];
+  // A resource whose last reference is being released can't be shared again.
+  if (shared_resource != nullptr && shared_resource->TryRef()) {
+    VLOG(1) << "Sharing the TRTEngineCacheResource for " << key;
+    *resource = shared_resource;
+    return OkStatus();
+  }
+  *resource = create();
+  if (*resource == nullptr) {
+    return errors::Internal("Failed to create a TRTEngineCacheResource");
+  }
+  (*resource)->shared_key_ = key;
+  shared_resource = *resource;
+  return OkStatus();
+}
+
 TRTEngineCacheResource::~TRTEngineCacheResource() {
   VLOG(1) << "Destroying TRTEngineCacheResource...";
+  if (!shared_key_.empty()) {
+    SharedCacheResources& shared = GetSharedCacheResources();
+    mutex_lock lock(shared.mu);
+    auto it = shared.resources.find(shared_key_);
+    if (it != shared.resources.end() && it->second == this) {
+      shared.resources.erase(it);
+    }
+  }
 }
 
 string TRTEngineCacheResource::DebugString() const {
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_TF2TENSORRT_UTILS_TRT_LRU_CACHE_H_
 #define TENSORFLOW_COMPILER_TF2TENSORRT_UTILS_TRT_LRU_CACHE_H_
 
+#include <functional>
 #include <list>
+#include <string>
 #include <thread>
 #include <unordered_map>
 
@@ -223,6 +225,16 @@ class TRTEngineCacheResource : public ResourceBase {
 
   ~TRTEngineCacheResource() override;
 
+  // Sets `resource` to a new reference to the cache resource shared in the
+  // process under `key`, created with `create` if there is none. The
+  // TRTEngineOps of different sessions, e.g. of two versions of a model loaded
+  // side by side, that run the same segment with the same weights share their
+  // engines this way instead of building them again. The resource is owned by
+  // the resource managers holding it, and is no longer shared once destroyed.
+  static Status LookupOrCreateShared(
+      const string& key, const std::function<TRTEngineCacheResource*()>& create,
+      TRTEngineCacheResource** resource);
+
   string DebugString() const override;
 
   // Returns the EngineContext that is compatible with input_shapes.
@@ -251,6 +263,10 @@ class TRTEngineCacheResource : public ResourceBase {
   // generation and engine build. During runtime the list of profiles is used to
   // look up a matching profile for the input data.
   TrtShapeOptimizationProfile profiles_;
+
+ private:
+  // The key of the resource if it is shared by LookupOrCreateShared().
+  string shared_key_;
 };
 
 #endif  // GOOGLE_CUDA && GOOGLE_TENSORRT
@@ -15,6 +15,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_lru_cache.h"
 
+#include <memory>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -53,5 +60,105 @@ TEST(LRUCacheTest, Basic) {
   EXPECT_EQ(cache.count(40), 1);
 }
 
+#if GOOGLE_CUDA && GOOGLE_TENSORRT
+
+class SharedCacheResourceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    device_ = DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0");
+    ASSERT_NE(device_, nullptr);
+    params_.device = device_.get();
+    ctx_ = std::make_unique<OpKernelContext>(&params_, /*num_outputs=*/0);
+  }
+
+  // Looks up the resource shared under `key`, and counts the resources
+  // created.
+  TRTEngineCacheResource* LookupOrCreate(const string& key) {
+    TRTEngineCacheResource* resource = nullptr;
+    TF_CHECK_OK(TRTEngineCacheResource::LookupOrCreateShared(
+        key,
+        [this]() {
+          ++num_created_;
+          return new TRTEngineCacheResource(ctx_.get(), /*capacity=*/1);
+        },
+        &resource));
+    return resource;
+  }
+
+  std::unique_ptr<Device> device_;
+  OpKernelContext::Params params_;
+  std::unique_ptr<OpKernelContext> ctx_;
+  int num_created_ = 0;
+};
+
+TEST_F(SharedCacheResourceTest, SharesResourceOfSameKey) {
+  TRTEngineCacheResource* resource = LookupOrCreate("same_key");
+  EXPECT_EQ(LookupOrCreate("same_key"), resource);
+  EXPECT_EQ(num_created_, 1);
+  TRTEngineCacheResource* other_resource = LookupOrCreate("other_key");
+  EXPECT_NE(other_resource, resource);
+  EXPECT_EQ(num_created_, 2);
+  EXPECT_FALSE(resource->Unref());
+  EXPECT_TRUE(resource->Unref());
+  EXPECT_TRUE(other_resource->Unref());
+}
+
+TEST_F(SharedCacheResourceTest, ReleasingLastReferenceErasesKey) {
+  TRTEngineCacheResource* resource = LookupOrCreate("released_key");
+  EXPECT_TRUE(resource->Unref());
+  // The key no longer refers to the destroyed resource.
+  resource = LookupOrCreate("released_key");
+  EXPECT_EQ(num_created_, 2);
+  EXPECT_TRUE(resource->Unref());
+}
+
+// Blocks in its destructor, while its key still refers to it.
+class BlockingCacheResource : public TRTEngineCacheResource {
+ public:
+  BlockingCacheResource(OpKernelContext* ctx, Notification* destroying,
+                        Notification* resume)
+      : TRTEngineCacheResource(ctx, /*capacity=*/1),
+        destroying_(destroying),
+        resume_(resume) {}
+
+  ~BlockingCacheResource() override {
+    destroying_->Notify();
+    resume_->WaitForNotification();
+  }
+
+ private:
+  Notification* const destroying_;
+  Notification* const resume_;
+};
+
+TEST_F(SharedCacheResourceTest, DoesNotShareResourceBeingDestroyed) {
+  Notification destroying, resume;
+  TRTEngineCacheResource* resource = nullptr;
+  TF_ASSERT_OK(TRTEngineCacheResource::LookupOrCreateShared(
+      "destroyed_key",
+      [&]() {
+        return new BlockingCacheResource(ctx_.get(), &destroying, &resume);
+      },
+      &resource));
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "unref", [resource]() { resource->Unref(); }));
+  destroying.WaitForNotification();
+
+  // TryRef() fails on the resource being destroyed, so a new one is created.
+  TRTEngineCacheResource* new_resource = LookupOrCreate("destroyed_key");
+  EXPECT_NE(new_resource, resource);
+  EXPECT_EQ(num_created_, 1);
+  resume.Notify();
+  thread.reset();
+
+  // Destroying the old resource leaves the key to the new one.
+  EXPECT_EQ(LookupOrCreate("destroyed_key"), new_resource);
+  EXPECT_EQ(num_created_, 1);
+  EXPECT_FALSE(new_resource->Unref());
+  EXPECT_TRUE(new_resource->Unref());
+}
+
+#endif  // GOOGLE_CUDA && GOOGLE_TENSORRT
+
 }  // namespace tensorrt
 }  // namespace tensorflow
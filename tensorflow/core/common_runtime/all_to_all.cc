@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/all_to_all.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
@@ -38,24 +39,48 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
+namespace {
+
+// The number of pairwise exchange steps that may be in flight.
+constexpr int kMaxStepsInFlight = 8;
+
+}  // namespace
 
 AllToAll::AllToAll()
-    : col_ctx_(nullptr), col_params_(nullptr), done_(nullptr), counter_(0) {}
+    : col_ctx_(nullptr),
+      col_params_(nullptr),
+      done_(nullptr),
+      counter_(0),
+      next_step_(0) {}
 
-StatusCallback AllToAll::CheckCounterAndCallDone() {
-  return [this](const Status& s) {
+StatusCallback AllToAll::CheckCounterAndCallDone(int step) {
+  return [this, step](const Status& s) {
     Status final_status;
+    int next_step = -1;
+    bool all_done = false;
     {
       mutex_lock l(mu_);
       status_.Update(s);
       ++counter_;
+      // Steps keep being started after an error, so that every transfer the
+      // peers wait on is posted, and fails once the executor is aborted.
+      if (--pending_transfers_[step] == 0 &&
+          next_step_ < col_params_->group.group_size) {
+        next_step = next_step_++;
+      }
       // For all devices other than itself, there's a send and a receive. We
       // wait until all of them complete.
-      if (counter_ < 2 * col_params_->group.group_size) {
-        return;
+      if (counter_ == 2 * col_params_->group.group_size) {
+        all_done = true;
+        final_status = status_;
       }
       CHECK_LE(counter_, 2 * col_params_->group.group_size);  // Crash ok.
-      final_status = status_;
+    }
+    if (next_step >= 0) {
+      StartStep(next_step);
+    }
+    if (!all_done) {
+      return;
     }
     if (!final_status.ok()) {
       done_(final_status);
@@ -110,14 +135,30 @@ void AllToAll::Run(StatusCallback done) {
     output_chunks_.push_back(output_buffer_.SubSlice(output_index));
   }
 
-  for (int i = 0; i < col_params_->group.group_size; ++i) {
-    auto default_rank = col_params_->default_rank;
-    // Issue send request from current device to all devices in group.
-    DispatchSend(default_rank, i, &input_chunks_[i], CheckCounterAndCallDone());
-    // Issue receive requests from all devices to current device.
-    DispatchRecv(i, default_rank, &output_chunks_[i],
-                 CheckCounterAndCallDone());
+  const int group_size = col_params_->group.group_size;
+  int num_steps;
+  {
+    mutex_lock l(mu_);
+    pending_transfers_.assign(group_size, 2);
+    next_step_ = std::min(group_size, kMaxStepsInFlight);
+    num_steps = next_step_;
   }
+  for (int step = 0; step < num_steps; ++step) {
+    StartStep(step);
+  }
+}
+
+void AllToAll::StartStep(int step) {
+  const int group_size = col_params_->group.group_size;
+  const int default_rank = col_params_->default_rank;
+  const int target_rank = (default_rank + step) % group_size;
+  const int src_rank = (default_rank - step + group_size) % group_size;
+  // Issue send request from current device to the target of this step.
+  DispatchSend(default_rank, target_rank, &input_chunks_[target_rank],
+               CheckCounterAndCallDone(step));
+  // Issue receive request from the source of this step to current device.
+  DispatchRecv(src_rank, default_rank, &output_chunks_[src_rank],
+               CheckCounterAndCallDone(step));
 }
 
 void AllToAll::DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
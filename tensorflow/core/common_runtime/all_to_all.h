@@ -27,6 +27,14 @@ limitations under the License.
 namespace tensorflow {
 
 // Implementation of collective all-to-all.
+//
+// The chunks are exchanged pairwise: in step k, each device sends to the
+// device k ranks after it and receives from the device k ranks before it, so
+// that every transfer of a step has its peer waiting on it. At most
+// kMaxStepsInFlight steps are in flight, and a step is started whenever one
+// completes. This keeps sends and receives overlapped without posting all
+// 2 * group_size transfers at once, which, in large groups, floods the
+// network with requests that mostly wait on their peers.
 class AllToAll : public CollectiveImplementationInterface {
  public:
   AllToAll();
@@ -52,6 +60,10 @@ class AllToAll : public CollectiveImplementationInterface {
   mutex mu_;
   Status status_ TF_GUARDED_BY(mu_);
   int counter_ TF_GUARDED_BY(mu_);
+  // The next step to start.
+  int next_step_ TF_GUARDED_BY(mu_);
+  // The number of transfers of each step that haven't completed.
+  std::vector<int> pending_transfers_ TF_GUARDED_BY(mu_);
 
   void DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
                     const StatusCallback& done);
@@ -59,10 +71,15 @@ class AllToAll : public CollectiveImplementationInterface {
   void DispatchRecv(int src_rank, int target_rank, Tensor* tensor,
                     const StatusCallback& done);
 
+  // Starts the send and the receive of `step`.
+  void StartStep(int step);
+
+  // Returns the callback of a transfer of `step`, which starts the next step
+  // once both transfers of `step` are done.
   // Atomically increments counter_ by one for sending, one for receiving.
-  // Invokes done when counter_ reaches 2.
+  // Invokes done when counter_ reaches 2 * group_size.
   // The purpose of checking counter_ is to ensure that done_ is called once.
-  StatusCallback CheckCounterAndCallDone();
+  StatusCallback CheckCounterAndCallDone(int step);
 };
 
 }  // namespace tensorflow
@@ -95,6 +95,43 @@ TEST_F(AllToAllTest, SuccessDifferentRank) {
                                   test::AsTensor<double>({9., 6., 3.}));
 }
 
+TEST_F(AllToAllTest, MoreDevicesThanStepsInFlight) {
+  const int kGroupSize = 12;
+  test_env_ = CreateCollectiveTestEnv(/*num_workers*/ 1,
+                                      /*num_devices_per_worker*/ kGroupSize,
+                                      DEVICE_CPU);
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < kGroupSize; ++i) {
+    Tensor tensor(DT_DOUBLE, TensorShape({kGroupSize, 2}));
+    for (int j = 0; j < kGroupSize; ++j) {
+      tensor.matrix<double>()(j, 0) = i * kGroupSize + j;
+      tensor.matrix<double>()(j, 1) = -(i * kGroupSize + j);
+    }
+    tensors.push_back(tensor);
+  }
+  BlockingCounter counter(kGroupSize);
+  for (int i = 0; i < kGroupSize; ++i) {
+    SchedClosure([this, &tensors, i, &counter]() {
+      auto col_params = CreateCollectiveParams(*test_env_, i, "AllToAll",
+                                               ALL_TO_ALL_COLLECTIVE, DT_DOUBLE,
+                                               tensors[i].shape());
+      Device* device = nullptr;
+      TF_CHECK_OK(test_env_->device_mgr->LookupDevice(
+          col_params->group.members[i].device.name(), &device));
+      TF_CHECK_OK(RunCollective(test_env_.get(), col_params.get(), device,
+                                &tensors[i], &tensors[i]));
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (int i = 0; i < kGroupSize; ++i) {
+    for (int j = 0; j < kGroupSize; ++j) {
+      EXPECT_EQ(tensors[i].matrix<double>()(j, 0), j * kGroupSize + i);
+      EXPECT_EQ(tensors[i].matrix<double>()(j, 1), -(j * kGroupSize + i));
+    }
+  }
+}
+
 TEST_F(AllToAllTest, Failure) {
   test_env_ = CreateCollectiveTestEnv(/*num_workers*/ 1,
                                       /*num_devices_per_worker*/ 3, DEVICE_CPU);
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/refcount.h"
@@ -227,6 +228,35 @@ CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
   }
 }
 
+std::shared_ptr<CollectiveInstanceScratch> CollectiveInstanceCache::Get(
+    const CollectiveParams& col_params, const string& device_name) {
+  uint64 membership = col_params.group.group_size;
+  for (const CollGroupMember& member : col_params.group.members) {
+    membership = Hash64Combine(membership, Hash64(member.device.name()));
+    membership = Hash64Combine(membership, member.device.incarnation());
+  }
+  mutex_lock l(mu_);
+  Entry& entry = entries_[std::make_tuple(col_params.group.group_key,
+                                          col_params.instance.instance_key,
+                                          device_name)];
+  if (entry.scratch == nullptr || entry.membership != membership) {
+    if (entry.scratch != nullptr) {
+      VLOG(1) << "Dropping the scratch state of collective instance "
+              << col_params.instance.instance_key << " on " << device_name
+              << " after the members of group " << col_params.group.group_key
+              << " changed";
+    }
+    entry.membership = membership;
+    entry.scratch = std::make_shared<CollectiveInstanceScratch>();
+  }
+  return entry.scratch;
+}
+
+void CollectiveInstanceCache::Clear() {
+  mutex_lock l(mu_);
+  entries_.clear();
+}
+
 BaseCollectiveExecutor::~BaseCollectiveExecutor() {}
 
 void BaseCollectiveExecutor::StartAbort(const Status& s) {
@@ -247,6 +277,7 @@ void BaseCollectiveExecutor::StartAbort(const Status& s) {
     status = status_;
   }
   LOG(ERROR) << "BaseCollectiveExecutor::StartAbort " << s;
+  if (instance_cache_ != nullptr) instance_cache_->Clear();
   cem_->GetParamResolver()->StartAbort(status);
   remote_access_->StartAbort(status);
   if (cem_->GetNcclCommunicator() != nullptr) {
@@ -324,6 +355,9 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   auto col_ctx = std::make_shared<CollectiveContext>(
       this, cem_->GetNcclCommunicator(), dev_mgr_, ctx, CtxParams(ctx),
       col_params, exec_key, step_id_, input, output);
+  if (instance_cache_ != nullptr) {
+    col_ctx->scratch = instance_cache_->Get(*col_params, col_ctx->device_name);
+  }
   status = col_impl->InitializeCollectiveContext(col_ctx);
   if (!status.ok()) {
     done_safe(status);
@@ -17,10 +17,13 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <tuple>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 
 namespace tensorflow {
@@ -90,6 +93,32 @@ CollectiveAdapter* MakeCollectiveAdapter(Tensor* output, int num_chunks,
                                          Allocator* allocator,
                                          bool align_chunks = true);
 
+// Keeps the scratch state of the collective instances across the steps that
+// execute them, by instance and device. The state of an instance is replaced
+// when the members of its group or their incarnations change, and all of it
+// is dropped when the collectives abort.
+class CollectiveInstanceCache {
+ public:
+  // Returns the scratch state of the instance of `col_params` on
+  // `device_name`.
+  std::shared_ptr<CollectiveInstanceScratch> Get(
+      const CollectiveParams& col_params, const string& device_name)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  void Clear() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    uint64 membership;
+    std::shared_ptr<CollectiveInstanceScratch> scratch;
+  };
+
+  mutex mu_;
+  // (group key, instance key, device name) -> entry.
+  absl::flat_hash_map<std::tuple<int32, int32, string>, Entry> entries_
+      TF_GUARDED_BY(mu_);
+};
+
 // Default implementation of CollectiveExecutor.  Delegates the actual
 // work of moving data to a class specialized for the operation type,
 // arguments and device+interconnect topology.
@@ -98,12 +127,15 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   BaseCollectiveExecutor(CollectiveExecutorMgrInterface* cem,
                          CollectiveRemoteAccess* remote_access, int64_t step_id,
                          const DeviceMgr* dev_mgr,
-                         std::shared_ptr<UnboundedWorkQueue> work_queue)
+                         std::shared_ptr<UnboundedWorkQueue> work_queue,
+                         std::shared_ptr<CollectiveInstanceCache>
+                             instance_cache = nullptr)
       : CollectiveExecutor(cem),
         step_id_(step_id),
         dev_mgr_(dev_mgr),
         remote_access_(remote_access),
-        work_queue_(std::move(work_queue)) {}
+        work_queue_(std::move(work_queue)),
+        instance_cache_(std::move(instance_cache)) {}
 
   ~BaseCollectiveExecutor() override;
 
@@ -141,6 +173,9 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // Ownership of `work_queue_` is shared between `this` and
   // `CollectiveExecutorMgr`.
   std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  // Shared with the CollectiveExecutorMgr and the executors of the other
+  // steps. May be null.
+  std::shared_ptr<CollectiveInstanceCache> instance_cache_;
   mutex launch_mu_;
   condition_variable launch_cv_;
   // collective instance key -> number of local devices for which NCCL ops have
@@ -0,0 +1,249 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace {
+
+// Rounds the values to a 16 bit float type T.
+template <typename T>
+class Float16Codec : public CompressionCodec {
+ public:
+  explicit Float16Codec(absl::string_view name) : name_(name) {}
+
+  absl::string_view name() const override { return name_; }
+
+  int64_t EncodedBytes(int64_t num_elements) const override {
+    return num_elements * sizeof(T);
+  }
+
+  void Encode(const float* values, int64_t num_elements,
+              uint8_t* encoded) const override {
+    for (int64_t i = 0; i < num_elements; ++i) {
+      const T value(values[i]);
+      std::memcpy(encoded + i * sizeof(T), &value, sizeof(T));
+    }
+  }
+
+  void Decode(const uint8_t* encoded, int64_t num_elements, bool accumulate,
+              float* values) const override {
+    for (int64_t i = 0; i < num_elements; ++i) {
+      T value;
+      std::memcpy(&value, encoded + i * sizeof(T), sizeof(T));
+      values[i] = (accumulate ? values[i] : 0.0f) + static_cast<float>(value);
+    }
+  }
+
+ private:
+  const absl::string_view name_;
+};
+
+// Quantizes the values linearly to int8, with a float scale that maps the
+// largest magnitude to 127.
+class Int8Codec : public CompressionCodec {
+ public:
+  absl::string_view name() const override { return "int8"; }
+
+  int64_t EncodedBytes(int64_t num_elements) const override {
+    return num_elements == 0 ? 0 : sizeof(float) + num_elements;
+  }
+
+  void Encode(const float* values, int64_t num_elements,
+              uint8_t* encoded) const override {
+    if (num_elements == 0) return;
+    float max_abs = 0.0f;
+    for (int64_t i = 0; i < num_elements; ++i) {
+      max_abs = std::max(max_abs, std::abs(values[i]));
+    }
+    const float scale = max_abs / 127.0f;
+    std::memcpy(encoded, &scale, sizeof(float));
+    int8_t* quantized = reinterpret_cast<int8_t*>(encoded + sizeof(float));
+    for (int64_t i = 0; i < num_elements; ++i) {
+      quantized[i] =
+          scale == 0.0f
+              ? 0
+              : static_cast<int8_t>(std::clamp(
+                    std::round(values[i] / scale), -127.0f, 127.0f));
+    }
+  }
+
+  void Decode(const uint8_t* encoded, int64_t num_elements, bool accumulate,
+              float* values) const override {
+    if (num_elements == 0) return;
+    float scale;
+    std::memcpy(&scale, encoded, sizeof(float));
+    const int8_t* quantized =
+        reinterpret_cast<const int8_t*>(encoded + sizeof(float));
+    for (int64_t i = 0; i < num_elements; ++i) {
+      values[i] = (accumulate ? values[i] : 0.0f) + quantized[i] * scale;
+    }
+  }
+};
+
+// Keeps one bit per value, its sign, and a float scale, the mean magnitude of
+// the values.
+class OneBitCodec : public CompressionCodec {
+ public:
+  absl::string_view name() const override { return "1bit"; }
+
+  int64_t EncodedBytes(int64_t num_elements) const override {
+    return num_elements == 0 ? 0 : sizeof(float) + (num_elements + 7) / 8;
+  }
+
+  void Encode(const float* values, int64_t num_elements,
+              uint8_t* encoded) const override {
+    if (num_elements == 0) return;
+    double sum_abs = 0.0;
+    for (int64_t i = 0; i < num_elements; ++i) {
+      sum_abs += std::abs(values[i]);
+    }
+    const float scale = sum_abs / num_elements;
+    std::memcpy(encoded, &scale, sizeof(float));
+    uint8_t* bits = encoded + sizeof(float);
+    std::memset(bits, 0, (num_elements + 7) / 8);
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (values[i] >= 0.0f) bits[i / 8] |= 1 << (i % 8);
+    }
+  }
+
+  void Decode(const uint8_t* encoded, int64_t num_elements, bool accumulate,
+              float* values) const override {
+    if (num_elements == 0) return;
+    float scale;
+    std::memcpy(&scale, encoded, sizeof(float));
+    const uint8_t* bits = encoded + sizeof(float);
+    for (int64_t i = 0; i < num_elements; ++i) {
+      const float value = (bits[i / 8] >> (i % 8)) & 1 ? scale : -scale;
+      values[i] = (accumulate ? values[i] : 0.0f) + value;
+    }
+  }
+};
+
+// Keeps the `ratio` fraction of the values with the largest magnitude, at
+// least one, as pairs of an int32 index and a float value.
+class TopKCodec : public CompressionCodec {
+ public:
+  explicit TopKCodec(double ratio) : ratio_(ratio) {}
+
+  absl::string_view name() const override { return "topk"; }
+
+  int64_t EncodedBytes(int64_t num_elements) const override {
+    return NumKept(num_elements) * (sizeof(int32_t) + sizeof(float));
+  }
+
+  void Encode(const float* values, int64_t num_elements,
+              uint8_t* encoded) const override {
+    const int64_t k = NumKept(num_elements);
+    if (k == 0) return;
+    std::vector<int32_t> indices(num_elements);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::nth_element(indices.begin(), indices.begin() + k - 1, indices.end(),
+                     [values](int32_t a, int32_t b) {
+                       return std::abs(values[a]) > std::abs(values[b]);
+                     });
+    indices.resize(k);
+    std::sort(indices.begin(), indices.end());
+    std::memcpy(encoded, indices.data(), k * sizeof(int32_t));
+    float* kept = reinterpret_cast<float*>(encoded + k * sizeof(int32_t));
+    for (int64_t i = 0; i < k; ++i) {
+      kept[i] = values[indices[i]];
+    }
+  }
+
+  void Decode(const uint8_t* encoded, int64_t num_elements, bool accumulate,
+              float* values) const override {
+    if (!accumulate) std::fill(values, values + num_elements, 0.0f);
+    const int64_t k = NumKept(num_elements);
+    const int32_t* indices = reinterpret_cast<const int32_t*>(encoded);
+    const float* kept =
+        reinterpret_cast<const float*>(encoded + k * sizeof(int32_t));
+    for (int64_t i = 0; i < k; ++i) {
+      values[indices[i]] += kept[i];
+    }
+  }
+
+ private:
+  int64_t NumKept(int64_t num_elements) const {
+    if (num_elements == 0) return 0;
+    const int64_t k = std::ceil(ratio_ * num_elements);
+    return std::clamp<int64_t>(k, 1, num_elements);
+  }
+
+  const double ratio_;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<CompressionCodec>> CompressionCodecFromHint(
+    absl::string_view communication_hint) {
+  if (!absl::ConsumePrefix(&communication_hint,
+                           kCompressedCommunicationHintPrefix)) {
+    return errors::InvalidArgument("Communication hint \"", communication_hint,
+                                   "\" doesn't select a compressed reduction");
+  }
+  const std::vector<absl::string_view> parts =
+      absl::StrSplit(communication_hint, ':');
+  const absl::string_view codec = parts[0];
+  if (codec == "topk") {
+    double ratio = 0.01;
+    if (parts.size() > 2 ||
+        (parts.size() == 2 && !absl::SimpleAtod(parts[1], &ratio)) ||
+        !(ratio > 0.0 && ratio <= 1.0)) {
+      return errors::InvalidArgument(
+          "The topk compression takes a ratio in (0, 1], got \"",
+          communication_hint, "\"");
+    }
+    return std::unique_ptr<CompressionCodec>(new TopKCodec(ratio));
+  }
+  if (parts.size() != 1) {
+    return errors::InvalidArgument("The ", codec,
+                                   " compression takes no ratio, got \"",
+                                   communication_hint, "\"");
+  }
+  if (codec == "fp16") {
+    return std::unique_ptr<CompressionCodec>(
+        new Float16Codec<Eigen::half>("fp16"));
+  }
+  if (codec == "bf16") {
+    return std::unique_ptr<CompressionCodec>(
+        new Float16Codec<bfloat16>("bf16"));
+  }
+  if (codec == "int8") {
+    return std::unique_ptr<CompressionCodec>(new Int8Codec());
+  }
+  if (codec == "1bit") {
+    return std::unique_ptr<CompressionCodec>(new OneBitCodec());
+  }
+  return errors::InvalidArgument("Unknown compression \"", codec,
+                                 "\", expected one of fp16, bf16, int8, 1bit "
+                                 "and topk");
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,67 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+
+// Lossy encoding of float vectors, used by CompressedRingReducer to shrink the
+// chunks it sends. The encoding of n floats always has EncodedBytes(n) bytes,
+// so that receivers can size their buffers without a header exchange.
+class CompressionCodec {
+ public:
+  virtual ~CompressionCodec() = default;
+
+  // Name of the codec, used in metrics and logs.
+  virtual absl::string_view name() const = 0;
+
+  // Returns the size of the encoding of `num_elements` floats.
+  virtual int64_t EncodedBytes(int64_t num_elements) const = 0;
+
+  // Encodes `values[0, num_elements)` into `encoded`, which has
+  // EncodedBytes(num_elements) bytes.
+  virtual void Encode(const float* values, int64_t num_elements,
+                      uint8_t* encoded) const = 0;
+
+  // Decodes `encoded` into `values[0, num_elements)`, adding to them if
+  // `accumulate` is set and overwriting them otherwise.
+  virtual void Decode(const uint8_t* encoded, int64_t num_elements,
+                      bool accumulate, float* values) const = 0;
+};
+
+// Prefix of the communication hints that select CompressedRingReducer.
+inline constexpr absl::string_view kCompressedCommunicationHintPrefix =
+    "compressed:";
+
+// Returns the codec selected by a communication hint of the form
+// "compressed:<codec>[:<ratio>]", where <codec> is one of
+//  - "fp16" and "bf16", which round the values to 16 bit floats;
+//  - "int8", which quantizes them linearly to 8 bits;
+//  - "1bit", which keeps their signs, scaled by their mean magnitude;
+//  - "topk", which keeps the fraction <ratio> of the values with the largest
+//    magnitude, 0.01 by default.
+StatusOr<std::unique_ptr<CompressionCodec>> CompressionCodecFromHint(
+    absl::string_view communication_hint);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
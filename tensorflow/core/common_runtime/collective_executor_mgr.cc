@@ -38,7 +38,8 @@ CollectiveExecutorMgr::CollectiveExecutorMgr(
           config.gpu_options().experimental().collective_ring_order()),
       nccl_communicator_(std::move(nccl_communicator)),
       work_queue_(std::make_shared<UnboundedWorkQueue>(Env::Default(),
-                                                       "collective_ops")) {}
+                                                       "collective_ops")),
+      instance_cache_(std::make_shared<CollectiveInstanceCache>()) {}
 
 CollectiveExecutorMgr::~CollectiveExecutorMgr() {
   for (auto iter : executor_table_) {
@@ -65,7 +66,8 @@ CollectiveExecutor* CollectiveExecutorMgr::FindOrCreate(int64_t step_id) {
 CollectiveExecutor* CollectiveExecutorMgr::Create(int64_t step_id) {
   CollectiveRemoteAccessLocal* rma =
       new CollectiveRemoteAccessLocal(dev_mgr_, dev_resolver_.get(), step_id);
-  return new BaseCollectiveExecutor(this, rma, step_id, dev_mgr_, work_queue_);
+  return new BaseCollectiveExecutor(this, rma, step_id, dev_mgr_, work_queue_,
+                                    instance_cache_);
 }
 
 void CollectiveExecutorMgr::Cleanup(int64_t step_id) {
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 
 namespace tensorflow {
+class CollectiveInstanceCache;
 class ConfigProto;
 class DeviceMgr;
 
@@ -77,6 +78,9 @@ class CollectiveExecutorMgr : public CollectiveExecutorMgrInterface {
   // collective op execution.  Ownership is shared between `this` and
   // `CollectiveRemoteAccessLocal`.
   std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  // Scratch state of the collective instances, kept across steps. Ownership
+  // is shared between `this` and the BaseCollectiveExecutors.
+  std::shared_ptr<CollectiveInstanceCache> instance_cache_;
 
  private:
   mutex exec_mu_;
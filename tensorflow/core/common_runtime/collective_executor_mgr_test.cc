@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 
+#include <memory>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -22,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/nccl/collective_communicator.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
@@ -106,5 +110,42 @@ TEST_F(CollectiveExecutorMgrTest, StepSequenceRelated) {
             "CollectiveExecutorMgr does not implement GetStepSequence.");
 }
 
+TEST(CollectiveInstanceCacheTest, KeepsScratchUntilMembersChange) {
+  auto* cp = new CollectiveParams();
+  core::ScopedUnref unref(cp);
+  cp->group.group_key = 1;
+  cp->group.group_size = 2;
+  cp->instance.instance_key = 7;
+  for (int i = 0; i < 2; ++i) {
+    CollGroupMember member;
+    member.device.set_name(
+        strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i));
+    member.device.set_incarnation(i + 1);
+    cp->group.members.push_back(member);
+  }
+  const string device = cp->group.members[0].device.name();
+
+  CollectiveInstanceCache cache;
+  std::shared_ptr<CollectiveInstanceScratch> scratch = cache.Get(*cp, device);
+  ASSERT_NE(scratch, nullptr);
+  EXPECT_EQ(cache.Get(*cp, device), scratch);
+  // Each instance has its own state on each device.
+  EXPECT_NE(cache.Get(*cp, cp->group.members[1].device.name()), scratch);
+  cp->instance.instance_key = 8;
+  EXPECT_NE(cache.Get(*cp, device), scratch);
+  cp->instance.instance_key = 7;
+  EXPECT_EQ(cache.Get(*cp, device), scratch);
+
+  // A restarted member has a new incarnation.
+  cp->group.members[1].device.set_incarnation(3);
+  std::shared_ptr<CollectiveInstanceScratch> restarted =
+      cache.Get(*cp, device);
+  EXPECT_NE(restarted, scratch);
+  EXPECT_EQ(cache.Get(*cp, device), restarted);
+
+  cache.Clear();
+  EXPECT_NE(cache.Get(*cp, device), restarted);
+}
+
 }  // namespace
 }  // namespace tensorflow
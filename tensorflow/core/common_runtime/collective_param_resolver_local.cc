@@ -68,7 +68,16 @@ const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       return nccl ? "NcclBroadcast" : "HierarchicalTreeBroadcast";
 
     case REDUCTION_COLLECTIVE:
-      return nccl ? "NcclReduce" : "RingReduce";
+      if (nccl) return "NcclReduce";
+      if (cp->instance.impl_details.communication_hint == "hierarchical" &&
+          cp->group.device_type == DEVICE_CPU) {
+        return "HierarchicalRingReduce";
+      }
+      if (str_util::StartsWith(cp->instance.impl_details.communication_hint,
+                               "compressed:")) {
+        return "CompressedRingReduce";
+      }
+      return "RingReduce";
 
     case GATHER_COLLECTIVE:
       return nccl ? "NcclGather" : "RingGather";
@@ -0,0 +1,313 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/compressed_ring_reducer.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Resource container of the residuals.
+constexpr char kResidualContainer[] = "_compressed_ring_reduce";
+
+// The error feedback of one collective instance on one device.
+class CompressionResidual : public ResourceBase {
+ public:
+  string DebugString() const override {
+    tf_shared_lock l(mu);
+    return strings::StrCat("CompressionResidual of ", residual.NumElements(),
+                           " elements");
+  }
+
+  // Held for the whole reduction, which serializes the runs of an instance.
+  mutable mutex mu;
+  Tensor residual TF_GUARDED_BY(mu);
+};
+
+}  // namespace
+
+Status CompressedRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("CompressedRingReduce only implements reductions");
+  }
+  if (col_params->group.device_type != DEVICE_CPU ||
+      col_params->instance.data_type != DT_FLOAT) {
+    return errors::InvalidArgument(
+        "CompressedRingReduce only supports float tensors on CPU devices, got ",
+        DataTypeString(col_params->instance.data_type), " on ",
+        col_params->group.device_type.type_string());
+  }
+  return CompressionCodecFromHint(
+             col_params->instance.impl_details.communication_hint)
+      .status();
+}
+
+Status CompressedRingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  const OpKernel* merge_op = col_params_->merge_op;
+  if (merge_op == nullptr || (merge_op->type_string() != "Add" &&
+                              merge_op->type_string() != "AddV2")) {
+    return errors::InvalidArgument(
+        "CompressedRingReduce only supports sums, got merge op ",
+        merge_op == nullptr ? "<none>" : merge_op->type_string());
+  }
+  TF_ASSIGN_OR_RETURN(
+      codec_, CompressionCodecFromHint(
+                  col_params_->instance.impl_details.communication_hint));
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void CompressedRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like RingReducer, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+  if (col_ctx_->output->NumElements() == 0) {
+    done(absl::OkStatus());
+    return;
+  }
+
+  ResourceMgr* resource_mgr = col_ctx_->device->resource_manager();
+  CompressionResidual* residual = nullptr;
+  Status s = resource_mgr->LookupOrCreate<CompressionResidual>(
+      kResidualContainer,
+      strings::StrCat(col_params_->group.group_key, ":",
+                      col_params_->instance.instance_key),
+      &residual, [](CompressionResidual** r) {
+        *r = new CompressionResidual;
+        return absl::OkStatus();
+      });
+  if (s.ok()) {
+    core::ScopedUnref unref(residual);
+    mutex_lock l(residual->mu);
+    const int64_t num_elements = col_ctx_->output->NumElements();
+    if (residual->residual.NumElements() != num_elements) {
+      // Either the first run of the instance, or one with a new shape, whose
+      // residual doesn't carry over.
+      residual->residual = Tensor(DT_FLOAT, TensorShape({num_elements}));
+      residual->residual.flat<float>().setZero();
+    }
+    s = RunRing(&residual->residual);
+  }
+  if (s.ok() && col_params_->final_op != nullptr) {
+    Tensor group_size(static_cast<float>(col_params_->group.group_size));
+    s = collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                      col_ctx_->device, col_params_->final_op,
+                                      col_ctx_->output, &group_size);
+  }
+  if (!s.ok()) {
+    StartAbort(s);
+  }
+  done(s);
+}
+
+int64_t CompressedRingReducer::ChunkStart(int i) const {
+  return std::min(i * chunk_elements_, col_ctx_->output->NumElements());
+}
+
+int64_t CompressedRingReducer::ChunkElements(int i) const {
+  return std::min(chunk_elements_,
+                  col_ctx_->output->NumElements() - ChunkStart(i));
+}
+
+Status CompressedRingReducer::RunRing(Tensor* residual) {
+  const int n = col_params_->group.group_size;
+  const int rank = col_params_->default_rank;
+  if (n == 1) return absl::OkStatus();
+  chunk_elements_ = (col_ctx_->output->NumElements() + n - 1) / n;
+  VLOG(1) << "CompressedRingReducer::Run for device " << col_ctx_->device_name
+          << " default_rank " << rank << " codec " << codec_->name()
+          << " chunk_elements " << chunk_elements_;
+
+  Allocator* allocator = col_ctx_->device->GetAllocator(
+      col_ctx_->op_ctx->output_alloc_attr(0));
+  std::vector<Tensor> encoded;
+  encoded.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    encoded.emplace_back(allocator, DT_UINT8,
+                         TensorShape({codec_->EncodedBytes(ChunkElements(i))}));
+  }
+  int64_t sent_bytes = 0;
+  int64_t uncompressed_bytes = 0;
+  auto send_recv = [&](int phase, int step, int send_idx, int recv_idx) {
+    sent_bytes += encoded[send_idx].TotalBytes();
+    uncompressed_bytes += ChunkElements(send_idx) * sizeof(float);
+    return SendRecv(phase, step, &encoded[send_idx], &encoded[recv_idx]);
+  };
+  auto decode = [&](int i, bool accumulate) {
+    codec_->Decode(encoded[i].flat<uint8>().data(), ChunkElements(i),
+                   accumulate,
+                   col_ctx_->output->flat<float>().data() + ChunkStart(i));
+  };
+
+  // Reduce-scatter, after which this device holds the sum of chunk `rank`.
+  for (int step = 0; step < n - 1; ++step) {
+    const int send_idx = (rank - step - 1 + 2 * n) % n;
+    const int recv_idx = (rank - step - 2 + 2 * n) % n;
+    EncodeChunk(send_idx, /*decode=*/false, residual, &encoded[send_idx]);
+    TF_RETURN_IF_ERROR(send_recv(/*phase=*/0, step, send_idx, recv_idx));
+    decode(recv_idx, /*accumulate=*/true);
+  }
+  // All-gather, forwarding the encodings as they are received, so that every
+  // device decodes the same values.
+  EncodeChunk(rank, /*decode=*/true, residual, &encoded[rank]);
+  for (int step = 0; step < n - 1; ++step) {
+    const int send_idx = (rank - step + n) % n;
+    const int recv_idx = (rank - step - 1 + n) % n;
+    TF_RETURN_IF_ERROR(send_recv(/*phase=*/1, step, send_idx, recv_idx));
+    decode(recv_idx, /*accumulate=*/false);
+  }
+  metrics::RecordCollectiveCompression(string(codec_->name()), sent_bytes,
+                                       uncompressed_bytes);
+  return absl::OkStatus();
+}
+
+void CompressedRingReducer::EncodeChunk(int i, bool decode, Tensor* residual,
+                                        Tensor* encoded) {
+  const int64_t num_elements = ChunkElements(i);
+  float* values = col_ctx_->output->flat<float>().data() + ChunkStart(i);
+  float* error = residual->flat<float>().data() + ChunkStart(i);
+  for (int64_t j = 0; j < num_elements; ++j) {
+    error[j] += values[j];
+  }
+  uint8* data = encoded->flat<uint8>().data();
+  codec_->Encode(error, num_elements, data);
+  std::vector<float> decoded(num_elements);
+  codec_->Decode(data, num_elements, /*accumulate=*/false, decoded.data());
+  for (int64_t j = 0; j < num_elements; ++j) {
+    error[j] -= decoded[j];
+  }
+  if (decode) {
+    std::copy(decoded.begin(), decoded.end(), values);
+  }
+}
+
+Status CompressedRingReducer::SendRecv(int phase, int step, const Tensor* send,
+                                       Tensor* recv) {
+  const int n = col_params_->group.group_size;
+  const int rank = col_params_->default_rank;
+  const int send_to = (rank + 1) % n;
+  const int recv_from = (rank + n - 1) % n;
+  const CollGroupMember& send_member = col_params_->group.members[send_to];
+  const CollGroupMember& recv_member = col_params_->group.members[recv_from];
+  auto buf_key = [this, phase, step](int sender) {
+    return strings::StrCat("CompressedRingReduce:", col_ctx_->exec_key, ":",
+                           phase, ":", step, ":", sender);
+  };
+
+  Notification send_done;
+  Notification recv_done;
+  Status send_status;
+  Status recv_status;
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      send_member.device.name(), send_member.task, buf_key(rank),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), send, col_ctx_->device_locality,
+      col_ctx_->op_ctx->cancellation_manager(),
+      [this, &send_done, &send_status](const Status& s) {
+        if (!s.ok()) StartAbort(s);
+        send_status = s;
+        send_done.Notify();
+      });
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      recv_member.device.name(), recv_member.task, recv_member.is_local,
+      buf_key(recv_from), col_ctx_->device,
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), recv, col_ctx_->device_locality,
+      /*dev_to_dev_stream_index=*/0, col_ctx_->op_ctx->cancellation_manager(),
+      [this, &recv_done, &recv_status](const Status& s) {
+        if (!s.ok()) StartAbort(s);
+        recv_status = s;
+        recv_done.Notify();
+      });
+  send_done.WaitForNotification();
+  recv_done.WaitForNotification();
+  TF_RETURN_IF_ERROR(send_status);
+  return recv_status;
+}
+
+void CompressedRingReducer::StartAbort(const Status& s) {
+  {
+    mutex_lock l(status_mu_);
+    if (!status_.ok()) return;
+    LOG(ERROR) << "Aborting CompressedRingReduce with " << s;
+    status_ = s;
+  }
+  // A cancellation already cancels all the pending sends and recvs.
+  CancellationManager* cancel_mgr = col_ctx_->op_ctx->cancellation_manager();
+  if (cancel_mgr == nullptr ||
+      (!cancel_mgr->IsCancelled() && !cancel_mgr->IsCancelling())) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+namespace {
+REGISTER_COLLECTIVE(CompressedRingReduce, CompressedRingReducer);
+}  // namespace
+
+}  // namespace tensorflow
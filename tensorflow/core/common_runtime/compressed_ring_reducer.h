@@ -0,0 +1,92 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COMPRESSED_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COMPRESSED_RING_REDUCER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_compression.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Ring all-reduce of float CPU tensors that sends its chunks compressed, for
+// sums of gradients over bandwidth-bound links. It is selected with a
+// communication hint of the form "compressed:<codec>[:<ratio>]", see
+// CompressionCodecFromHint.
+//
+// The chunks are reduce-scattered and then all-gathered over a ring of the
+// whole group, like RingReducer. Every chunk that a device sends is encoded,
+// except in the all-gather where the devices forward the encodings they
+// received. As the compression is lossy, every device keeps the difference
+// between what it meant to send and what it sent, its residual, and adds it to
+// what it sends in the next run of the same collective instance (error
+// feedback). The residuals live in the resource manager of the device.
+//
+// The merge op must be an addition. The devices end up with identical values.
+class CompressedRingReducer : public CollectiveImplementationInterface {
+ public:
+  CompressedRingReducer() = default;
+  ~CompressedRingReducer() override = default;
+
+  // Checks that the reduction is of float CPU tensors and that the
+  // communication hint selects a known codec.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Runs the all-reduce. Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Runs the all-reduce on the output, using and updating `residual`, which
+  // has the shape of the output.
+  Status RunRing(Tensor* residual);
+
+  // Encodes chunk `i` of the output plus the same chunk of `residual` into
+  // `encoded`, and moves the encoding error into `residual`. If `decode` is
+  // set, the chunk of the output is also set to the decoded values.
+  void EncodeChunk(int i, bool decode, Tensor* residual, Tensor* encoded);
+
+  // Sends `send` to the next device of the ring and receives `recv` from the
+  // previous one, and waits for both.
+  Status SendRecv(int phase, int step, const Tensor* send, Tensor* recv);
+
+  // Returns the first element and the number of elements of chunk `i` of the
+  // output.
+  int64_t ChunkStart(int i) const;
+  int64_t ChunkElements(int i) const;
+
+  // Aborts the collective executor on the first error, so that the other
+  // members stop waiting for this one.
+  void StartAbort(const Status& s);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_ = nullptr;  // Not owned
+  std::unique_ptr<CompressionCodec> codec_;
+  int64_t chunk_elements_ = 0;
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COMPRESSED_RING_REDUCER_H_
@@ -0,0 +1,261 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/compressed_ring_reducer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/collective_compression.h"
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<float> RoundTrip(const std::string& hint,
+                             const std::vector<float>& values) {
+  auto codec = CompressionCodecFromHint(hint);
+  TF_CHECK_OK(codec.status());
+  std::vector<uint8_t> encoded((*codec)->EncodedBytes(values.size()));
+  (*codec)->Encode(values.data(), values.size(), encoded.data());
+  std::vector<float> decoded(values.size(), 1.0f);
+  (*codec)->Decode(encoded.data(), values.size(), /*accumulate=*/false,
+                   decoded.data());
+  return decoded;
+}
+
+TEST(CompressionCodecTest, Float16) {
+  const std::vector<float> values = {1.0f, -2.5f, 1024.0f, 0.0f};
+  EXPECT_EQ(RoundTrip("compressed:fp16", values), values);
+  EXPECT_EQ(RoundTrip("compressed:bf16", values), values);
+  EXPECT_EQ((*CompressionCodecFromHint("compressed:fp16"))->EncodedBytes(4), 8);
+}
+
+TEST(CompressionCodecTest, Int8) {
+  const std::vector<float> decoded =
+      RoundTrip("compressed:int8", {127.0f, -63.0f, 0.2f, 0.0f});
+  EXPECT_EQ(decoded, std::vector<float>({127.0f, -63.0f, 0.0f, 0.0f}));
+  EXPECT_EQ((*CompressionCodecFromHint("compressed:int8"))->EncodedBytes(4),
+            8);
+}
+
+TEST(CompressionCodecTest, OneBit) {
+  const std::vector<float> decoded =
+      RoundTrip("compressed:1bit", {3.0f, -1.0f, -2.0f, 2.0f, 2.0f});
+  EXPECT_EQ(decoded, std::vector<float>({2.0f, -2.0f, -2.0f, 2.0f, 2.0f}));
+  EXPECT_EQ((*CompressionCodecFromHint("compressed:1bit"))->EncodedBytes(9),
+            6);
+}
+
+TEST(CompressionCodecTest, TopK) {
+  const std::vector<float> decoded =
+      RoundTrip("compressed:topk:0.25",
+                {1.0f, -8.0f, 2.0f, 3.0f, 7.0f, 0.0f, 1.0f, 0.0f});
+  EXPECT_EQ(decoded, std::vector<float>(
+                         {0.0f, -8.0f, 0.0f, 0.0f, 7.0f, 0.0f, 0.0f, 0.0f}));
+  // At least one value is kept.
+  EXPECT_EQ(RoundTrip("compressed:topk", {1.0f, -2.0f}),
+            std::vector<float>({0.0f, -2.0f}));
+}
+
+TEST(CompressionCodecTest, RejectsBadHints) {
+  for (const char* hint :
+       {"ring", "compressed:fp8", "compressed:topk:0", "compressed:topk:2",
+        "compressed:topk:x", "compressed:fp16:0.5"}) {
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        CompressionCodecFromHint(hint).status()))
+        << hint;
+  }
+}
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, Device* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder(absl::StrCat(op, "_node"), op)
+                  .Attr("T", DT_FLOAT)
+                  .Input(FakeInput(DT_FLOAT))
+                  .Input(FakeInput(DT_FLOAT))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+class CompressedRingReducerTest : public ::testing::Test {
+ protected:
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, const std::string& hint, int tensor_len,
+                   CollectiveTestEnv* test_env)
+        : test_env_(test_env), tensor_(DT_FLOAT, TensorShape({tensor_len})) {
+      col_params_ = CreateCollectiveParams(
+          *test_env_, rank, "CompressedRingReduce", REDUCTION_COLLECTIVE,
+          DT_FLOAT, TensorShape({tensor_len}));
+      col_params_->instance.impl_details.communication_hint = hint;
+      string dev_name = col_params_->group.members[rank].device.name();
+      TF_CHECK_OK(test_env_->device_mgr->LookupDevice(dev_name, &device_));
+      merge_op_ = GetBinOp("Add", device_);
+      final_op_ = GetBinOp("Div", device_);
+      col_params_->merge_op = merge_op_.get();
+      col_params_->final_op = final_op_.get();
+    }
+
+    void DoReduce() {
+      status_ = RunCollective(test_env_, col_params_.get(), device_, &tensor_,
+                              &tensor_);
+    }
+
+    CollectiveTestEnv* test_env_;
+    Tensor tensor_;
+    Device* device_;
+    core::RefCountPtr<CollectiveParams> col_params_;
+    std::unique_ptr<OpKernel> merge_op_;
+    std::unique_ptr<OpKernel> final_op_;
+    Status status_;
+  };
+
+  void Init(int num_workers, int num_devices, const std::string& hint,
+            int tensor_len) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    for (int rank = 0; rank < num_workers * num_devices; ++rank) {
+      instances_.push_back(std::make_unique<DeviceInstance>(
+          rank, hint, tensor_len, test_env_.get()));
+    }
+  }
+
+  // Sets the input of every device to small integers and returns their mean.
+  std::vector<float> InitInputs() {
+    const int tensor_len = instances_[0]->tensor_.NumElements();
+    std::vector<float> expected(tensor_len);
+    for (int rank = 0; rank < instances_.size(); ++rank) {
+      auto flat = instances_[rank]->tensor_.flat<float>();
+      for (int i = 0; i < tensor_len; ++i) {
+        flat(i) = (rank + 1) * ((i % 7) - 3);
+        expected[i] += flat(i) / instances_.size();
+      }
+    }
+    return expected;
+  }
+
+  void Reduce() {
+    std::atomic<int> done(0);
+    for (auto& instance : instances_) {
+      SchedClosure([&instance, &done] {
+        instance->DoReduce();
+        ++done;
+      });
+    }
+    while (done < static_cast<int>(instances_.size())) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (const auto& instance : instances_) {
+      TF_ASSERT_OK(instance->status_);
+      test::ExpectTensorEqual<float>(instances_[0]->tensor_,
+                                     instance->tensor_);
+    }
+  }
+
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+  std::vector<std::unique_ptr<DeviceInstance>> instances_;
+};
+
+TEST_F(CompressedRingReducerTest, LosslessOnSmallIntegers) {
+  for (const char* hint : {"compressed:fp16", "compressed:bf16",
+                           "compressed:topk:1"}) {
+    instances_.clear();
+    Init(/*num_workers=*/2, /*num_devices=*/2, hint, /*tensor_len=*/1001);
+    const std::vector<float> expected = InitInputs();
+    Reduce();
+    test::ExpectTensorEqual<float>(test::AsTensor<float>(expected),
+                                   instances_[0]->tensor_);
+  }
+}
+
+TEST_F(CompressedRingReducerTest, TensorSmallerThanGroup) {
+  Init(/*num_workers=*/2, /*num_devices=*/2, "compressed:int8",
+       /*tensor_len=*/3);
+  InitInputs();
+  Reduce();
+}
+
+TEST_F(CompressedRingReducerTest, ErrorFeedbackDeliversEverything) {
+  // Every encoding keeps a single value of a chunk. With error feedback, the
+  // rest is delivered by the following reductions, of zeros.
+  Init(/*num_workers=*/2, /*num_devices=*/1, "compressed:topk:0.25",
+       /*tensor_len=*/8);
+  const std::vector<float> expected = InitInputs();
+  std::vector<float> total(expected.size());
+  for (int run = 0; run < 12; ++run) {
+    if (run > 0) {
+      for (auto& instance : instances_) {
+        instance->tensor_.flat<float>().setZero();
+      }
+    }
+    Reduce();
+    for (int i = 0; i < total.size(); ++i) {
+      total[i] += instances_[0]->tensor_.flat<float>()(i);
+    }
+    if (run == 0) {
+      EXPECT_NE(total, expected);
+    }
+  }
+  EXPECT_EQ(total, expected);
+}
+
+TEST(CompressedRingReducerInitParamsTest, RejectsUnsupportedReductions) {
+  auto test_env = CreateCollectiveTestEnv(/*num_workers=*/2,
+                                          /*num_devices_per_worker=*/1,
+                                          DEVICE_CPU);
+  auto cp = CreateCollectiveParams(*test_env, /*rank=*/0,
+                                   "CompressedRingReduce",
+                                   REDUCTION_COLLECTIVE, DT_FLOAT,
+                                   TensorShape({8}));
+  core::RefCountPtr<CompressedRingReducer> reducer(new CompressedRingReducer());
+  cp->instance.impl_details.communication_hint = "compressed:int8";
+  TF_EXPECT_OK(reducer->InitializeCollectiveParams(cp.get()));
+
+  cp->instance.impl_details.communication_hint = "compressed:zip";
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reducer->InitializeCollectiveParams(cp.get())));
+
+  cp->instance.impl_details.communication_hint = "compressed:int8";
+  cp->instance.data_type = DT_INT32;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reducer->InitializeCollectiveParams(cp.get())));
+}
+
+}  // namespace
+}  // namespace tensorflow
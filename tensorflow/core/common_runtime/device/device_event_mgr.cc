@@ -18,10 +18,13 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/status/status.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tsl/platform/thread_annotations.h"
 
 namespace tensorflow {
@@ -33,6 +36,13 @@ namespace {
 //  - Should EventMgrs be shared between devices on a machine with multiple
 //  devices of the same type?
 static const int kNumThreads = 2;
+
+bool UseHostCallbacks() {
+  bool use_host_callbacks;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_EVENT_MGR_USE_HOST_CALLBACKS",
+                                 /*default_val=*/false, &use_host_callbacks));
+  return use_host_callbacks;
+}
 }  // namespace
 
 namespace device_event_mgr {
@@ -100,6 +110,7 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      use_host_callbacks_(UseHostCallbacks()),
       threadpool_(Env::Default(), "Device_Event_Manager", kNumThreads) {
   device_event_mgr::InitThreadpoolLabels(&threadpool_);
   StartPollingLoop();
@@ -108,6 +119,15 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
 EventMgr::~EventMgr() {
   StopPollingLoop();
 
+  {
+    // The streams still hold pointers to this EventMgr in the host callbacks
+    // they haven't run.
+    mutex_lock l(mu_);
+    while (num_pending_host_callbacks_ > 0) {
+      host_callbacks_done_.wait(l);
+    }
+  }
+
   for (auto& [stream, stream_callbacks] : callbacks_) {
     for (auto& [event, callback] : stream_callbacks) {
       threadpool_.Schedule(std::move(callback));
@@ -189,6 +209,57 @@ void EventMgr::EnqueueCallback(se::Stream* stream, std::function<void()> func) {
   }
 }
 
+bool EventMgr::EnqueueHostCallback(se::Stream* stream,
+                                   std::function<void()>* func) {
+  // The host callback owns the function once it runs. It doesn't run if
+  // DoHostCallback fails, in which case `*func` is given back.
+  auto* callback = new std::function<void()>(std::move(*func));
+  absl::Status s = stream->DoHostCallback([this, callback]() {
+    std::unique_ptr<std::function<void()>> owned_callback(callback);
+    OnHostCallback(std::move(*owned_callback));
+  });
+  if (!s.ok()) {
+    VLOG(1) << "Falling back to polling an event: " << s;
+    *func = std::move(*callback);
+    delete callback;
+    return false;
+  }
+  ++num_pending_host_callbacks_;
+  return true;
+}
+
+void EventMgr::OnHostCallback(std::function<void()> func) {
+  // This runs on a thread of the driver that must not call into it, so the
+  // callback itself runs in the threadpool.
+  mutex_lock l(mu_);
+  ready_callbacks_.push_back(std::move(func));
+  if (!running_ready_callbacks_) {
+    running_ready_callbacks_ = true;
+    threadpool_.Schedule([this]() { RunReadyCallbacks(); });
+  }
+  if (--num_pending_host_callbacks_ == 0) {
+    host_callbacks_done_.notify_all();
+  }
+}
+
+void EventMgr::RunReadyCallbacks() {
+  std::vector<std::function<void()>> callbacks;
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (ready_callbacks_.empty()) {
+        running_ready_callbacks_ = false;
+        return;
+      }
+      callbacks.swap(ready_callbacks_);
+    }
+    for (std::function<void()>& callback : callbacks) {
+      callback();
+    }
+    callbacks.clear();
+  }
+}
+
 // This function must be called periodically to check whether pending
 // events have recorded, and then retire them.  Initial observations
 // suggest that typical behavior in a TensorFlow program is to have
@@ -69,6 +69,7 @@ class EventMgr {
   // such callbacks and also buffer deletions.
   void ThenExecute(se::Stream* stream, std::function<void()> func) {
     mutex_lock l(mu_);
+    if (use_host_callbacks_ && EnqueueHostCallback(stream, &func)) return;
     EnqueueCallback(stream, std::move(func));
     PollEvents(stream);
   }
@@ -80,6 +81,10 @@ class EventMgr {
 
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  // If true, the streams call back the host when they reach the callbacks
+  // instead of the polling loop checking events for them. Set by the
+  // TF_EVENT_MGR_USE_HOST_CALLBACKS environment variable.
+  const bool use_host_callbacks_;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
@@ -90,6 +95,17 @@ class EventMgr {
   void EnqueueCallback(se::Stream* stream, std::function<void()> func)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Like EnqueueCallback, but enqueues a host callback on `stream` that hands
+  // `*func` to the threadpool. Returns false and leaves `*func` unchanged if
+  // the stream can't call back the host.
+  bool EnqueueHostCallback(se::Stream* stream, std::function<void()>* func)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called by the streams from their host callbacks. The callbacks that become
+  // ready while the threadpool runs earlier ones are run in one batch.
+  void OnHostCallback(std::function<void()> func);
+  void RunReadyCallbacks();
+
   // This function should be called at roughly the same tempo as QueueTensors()
   // to check whether pending events have recorded, and then retire them.
   //
@@ -115,6 +131,14 @@ class EventMgr {
       std::deque<std::pair<std::unique_ptr<se::Event>, std::function<void()>>>>
       callbacks_ TF_GUARDED_BY(mu_);
 
+  // Callbacks whose host callbacks ran, in the order they ran.
+  std::vector<std::function<void()>> ready_callbacks_ TF_GUARDED_BY(mu_);
+  // True while RunReadyCallbacks is scheduled or running.
+  bool running_ready_callbacks_ TF_GUARDED_BY(mu_) = false;
+  // The host callbacks enqueued that haven't run yet.
+  int64_t num_pending_host_callbacks_ TF_GUARDED_BY(mu_) = 0;
+  condition_variable host_callbacks_done_;
+
   bool stop_polling_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
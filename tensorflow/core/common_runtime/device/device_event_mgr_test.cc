@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
 #include <atomic>
+#include <vector>
 
 #include "xla/stream_executor/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -134,6 +136,30 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+TEST(EventMgr, HostCallbacks) {
+  setenv("TF_EVENT_MGR_USE_HOST_CALLBACKS", "true", 1);
+  auto stream_exec = se::GPUMachineManager()->ExecutorForDevice(0).value();
+  TF_ASSERT_OK_AND_ASSIGN(auto stream, stream_exec->CreateStream());
+  std::vector<int> order;
+  {
+    TEST_EventMgr em(stream_exec, GPUOptions());
+    TEST_EventMgrHelper th(&em);
+    BlockingCounter counter(10);
+    for (int i = 0; i < 10; ++i) {
+      em.ThenExecute(stream.get(), [i, &order, &counter]() {
+        // The callbacks still run in the EventMgr's threads.
+        device_event_mgr::WarnIfInCallback([i, &order] { order.push_back(i); });
+        counter.DecrementCount();
+      });
+    }
+    // None of the callbacks wait for an event to be polled.
+    EXPECT_EQ(0, th.queue_size());
+    counter.Wait();
+  }
+  unsetenv("TF_EVENT_MGR_USE_HOST_CALLBACKS");
+  EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
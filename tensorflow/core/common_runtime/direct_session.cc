@@ -20,6 +20,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -63,6 +65,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/threadpool_options.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -365,6 +368,11 @@ DirectSession::DirectSession(const SessionOptions& options,
   if (!status.ok()) {
     LOG(ERROR) << status.message();
   }
+  const Status arena_status = ReadBoolFromEnvVar(
+      "TF_DIRECT_SESSION_STEP_ARENA", false, &use_step_arena_);
+  if (!arena_status.ok()) {
+    LOG(ERROR) << arena_status.message();
+  }
   session_handle_ =
       strings::StrCat("direct", strings::FpToString(random::New64()));
   if (options.config.log_device_placement()) {
@@ -448,8 +456,13 @@ Status DirectSession::ExtendLocked(GraphDef&& graph) {
     options.device_set = &device_set_;
     options.session_options = &options_;
     options.session_handle = session_handle_;
-    TF_RETURN_IF_ERROR(GraphExecutionState::MakeForBaseGraph(
-        std::move(graph), options, &execution_state_));
+    if (options_.config.experimental().share_base_graphs()) {
+      TF_RETURN_IF_ERROR(GraphExecutionState::MakeForSharedBaseGraph(
+          std::move(graph), options, &execution_state_));
+    } else {
+      TF_RETURN_IF_ERROR(GraphExecutionState::MakeForBaseGraph(
+          std::move(graph), options, &execution_state_));
+    }
     // NOTE(mrry): The function library created here will be used for
     // all subsequent extensions of the graph. Also, note how using the copy
     // constructor of FunctionLibraryDefinition avoids duplicating the memory
@@ -697,6 +710,21 @@ Status DirectSession::RunInternal(
     args.stats_collector = run_state.collector.get();
   }
 
+  // Sample the node times of steps that are not traced otherwise.
+  SampledStepStatsCollector* sampled_collector = nullptr;
+  const int64_t sample_interval =
+      options_.config.experimental().step_stats_sample_interval();
+  if (args.stats_collector == nullptr && sample_interval > 0 &&
+      executors_and_keys->sampled_collector != nullptr &&
+      (executor_step_count + 1) % sample_interval == 0 &&
+      executors_and_keys->sampled_collector->Start()) {
+    sampled_collector = executors_and_keys->sampled_collector.get();
+    args.stats_collector = sampled_collector;
+  }
+  auto finish_sampling = gtl::MakeCleanup([&sampled_collector]() {
+    if (sampled_collector != nullptr) sampled_collector->Finish(nullptr);
+  });
+
   std::unique_ptr<DeviceProfilerSession> device_profiler_session;
   if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
     device_profiler_session = DeviceProfilerSession::Create();
@@ -712,9 +740,28 @@ Status DirectSession::RunInternal(
 
   Status run_status;
 
+  // Serve the tensors that CPU kernels allocate during this step from a
+  // per-device arena if requested. The arenas are released once every executor
+  // has finished; tensors that outlive the step keep their chunk alive.
+  absl::flat_hash_map<const Device*, StepArenaAllocator*> step_arenas;
+  auto end_step_arenas = gtl::MakeCleanup([&step_arenas]() {
+    for (const auto& it : step_arenas) {
+      it.second->EndStep();
+    }
+  });
+  if (use_step_arena_) {
+    for (const auto& item : executors_and_keys->items) {
+      if (item.device->device_type() == DEVICE_CPU &&
+          !step_arenas.contains(item.device)) {
+        step_arenas[item.device] = StepArenaAllocator::Create(
+            item.device->GetAllocator(AllocatorAttributes()));
+      }
+    }
+  }
+
   auto set_threadpool_args_for_item =
-      [&default_runner, &handler](const PerPartitionExecutorsAndLib& item,
-                                  Executor::Args* args) {
+      [&default_runner, &handler, &step_arenas](
+          const PerPartitionExecutorsAndLib& item, Executor::Args* args) {
         // TODO(azaks): support partial run.
         // TODO(azaks): if the device picks its own threadpool, we need to
         // assign
@@ -734,6 +781,9 @@ Status DirectSession::RunInternal(
           args->user_intra_op_threadpool =
               handler->AsIntraThreadPoolInterface();
         }
+        auto arena = step_arenas.find(item.device);
+        args->step_allocator =
+            arena == step_arenas.end() ? nullptr : arena->second;
       };
 
   if (can_execute_synchronously) {
@@ -796,6 +846,12 @@ Status DirectSession::RunInternal(
     run_state.collector->Finalize();
   }
 
+  if (sampled_collector != nullptr) {
+    mutex_lock l(executor_lock_);
+    sampled_collector->Finish(&cost_model_manager_);
+    sampled_collector = nullptr;
+  }
+
   // Build and return the cost model as instructed.
   if (update_cost_model) {
     // Build the cost model
@@ -1445,11 +1501,22 @@ Status DirectSession::CreateExecutors(
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
     if (!options_.config.experimental().disable_output_partition_graphs() ||
-        options_.config.graph_options().build_cost_model() > 0) {
+        options_.config.graph_options().build_cost_model() > 0 ||
+        options_.config.experimental().step_stats_sample_interval() > 0) {
       item->graph = std::move(partition_graph);
     }
   }
 
+  if (options_.config.experimental().step_stats_sample_interval() > 0 &&
+      !run_state_args->is_partial_run) {
+    std::unordered_map<string, const Graph*> device_to_graph;
+    for (const PerPartitionExecutorsAndLib& item : ek->items) {
+      device_to_graph[item.device->name()] = item.graph.get();
+    }
+    ek->sampled_collector =
+        std::make_unique<SampledStepStatsCollector>(device_to_graph);
+  }
+
   // Cache the mapping from input/output names to graph elements to
   // avoid recomputing it every time.
   if (!run_state_args->is_partial_run) {
@@ -1520,6 +1587,7 @@ Status DirectSession::GetOrCreateExecutors(
     auto it = executors_.find(key);
     if (it != executors_.end()) {
       *executors_and_keys = it->second.get();
+      metrics::RecordSessionExecutorsLookup("run", /*reused=*/true);
       return absl::OkStatus();
     }
   }
@@ -1553,11 +1621,13 @@ Status DirectSession::GetOrCreateExecutors(
     auto it = executors_.find(sorted_key);
     if (it != executors_.end()) {
       *executors_and_keys = it->second.get();
+      metrics::RecordSessionExecutorsLookup("run", /*reused=*/true);
       return absl::OkStatus();
     }
   }
 
   // Nothing found, so create the executors and store in the cache.
+  metrics::RecordSessionExecutorsLookup("run", /*reused=*/false);
   // The executor_lock_ is intentionally released while executors are
   // being created.
   CallableOptions callable_options;
@@ -1877,6 +1947,7 @@ Status DirectSession::MakeCallable(const CallableOptions& callable_options,
   RunStateArgs run_state_args(callable_options.run_options().debug_options());
   TF_RETURN_IF_ERROR(
       CreateExecutors(callable_options, &ek, &func_info, &run_state_args));
+  metrics::RecordSessionExecutorsLookup("callable", /*reused=*/false);
   {
     mutex_lock l(callables_lock_);
     *out_handle = next_callable_handle_++;
@@ -1958,6 +2029,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     return errors::InvalidArgument(
         "Attempted to run callable after handle was released: ", handle);
   }
+  metrics::RecordSessionExecutorsLookup("callable", /*reused=*/true);
 
   // NOTE(mrry): Debug options are not currently supported in the
   // callable interface.
@@ -157,6 +157,57 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_StepArena) {
+  Initialize({3, 2, -1, 0});
+  // The option is read when the session is created.
+  setenv("TF_DIRECT_SESSION_STEP_ARENA", "true", /*overwrite=*/1);
+  auto session = CreateSession();
+  unsetenv("TF_DIRECT_SESSION_STEP_ARENA");
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The fetched tensors outlive the steps that allocated them.
+  std::vector<Tensor> fetched;
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", z_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    fetched.insert(fetched.end(), outputs.begin(), outputs.end());
+  }
+  for (size_t i = 0; i < fetched.size(); i += 2) {
+    EXPECT_FLOAT_EQ(5.0, fetched[i].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, fetched[i + 1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_SampledStepStats) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options = DefaultSessionOptions();
+  options.config.mutable_experimental()->set_step_stats_sample_interval(2);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", z_ + ":0"}, {}, &outputs));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+  }
+
+  // The second and the fourth steps are sampled.
+  CostModelManager::CostModelMap cost_models;
+  static_cast<DirectSession*>(session.get())->ExportCostModels(&cost_models);
+  int64_t num_samples = 0;
+  for (const auto& it : cost_models) {
+    for (const Node* node : it.first->op_nodes()) {
+      if (node->name() == y_) {
+        num_samples += it.second->NumExecutionTimeSamples(node);
+      }
+    }
+  }
+  EXPECT_EQ(num_samples, 2);
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -838,6 +889,52 @@ TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   EXPECT_EQ(20.0, outputs[0].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, SessionsSharingBaseGraphKeepTheirOwnState) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+  Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({}));
+  Node* init = test::graph::Assign(
+      &g, var, test::graph::Constant(&g, test::AsScalar<float>(20.0)));
+  g.ToGraphDef(&def);
+
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_share_base_graphs(true);
+  constexpr int kNumSessions = 4;
+  std::vector<std::unique_ptr<Session>> sessions(kNumSessions);
+  std::vector<Status> statuses(kNumSessions);
+  {
+    // The sessions of a model are created concurrently.
+    thread::ThreadPool tp(Env::Default(), "test", kNumSessions);
+    for (int i = 0; i < kNumSessions; ++i) {
+      tp.Schedule([&, i]() {
+        sessions[i].reset(NewSession(options));
+        statuses[i] = sessions[i]->Create(def);
+      });
+    }
+  }
+  for (const Status& s : statuses) TF_ASSERT_OK(s);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(sessions[0]->Run({}, {init->name()}, {}, &outputs));
+  TF_ASSERT_OK(sessions[0]->Run({}, {var->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(20.0, outputs[0].scalar<float>()());
+  // The variables of the other sessions are not initialized.
+  for (int i = 1; i < kNumSessions; ++i) {
+    Status s = sessions[i]->Run({}, {var->name() + ":0"}, {}, &outputs);
+    EXPECT_TRUE(errors::IsFailedPrecondition(s)) << s;
+  }
+
+  // Sessions created after the others are closed place the graph again.
+  for (auto& session : sessions) {
+    TF_ASSERT_OK(session->Close());
+    session.reset();
+  }
+  auto session = absl::WrapUnique(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+  TF_ASSERT_OK(session->Run({}, {init->name()}, {}, &outputs));
+}
+
 TEST(DirectSessionTest, MultipleFeedTest) {
   GraphDef def;
   Graph g(OpRegistry::Global());
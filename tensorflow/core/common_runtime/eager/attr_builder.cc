@@ -260,6 +260,20 @@ void AttrBuilder::CopyAttributes(const AttrBuilder& other) {
                         other.encoded_attrs_.end());
 }
 
+bool AttrBuilder::HasSameAttributes(const AttrBuilder& other) const {
+  if (op_name_ != other.op_name_ ||
+      encoded_attrs_.size() != other.encoded_attrs_.size()) {
+    return false;
+  }
+  for (const auto& entry : encoded_attrs_) {
+    auto it = other.encoded_attrs_.find(entry.first);
+    if (it == other.encoded_attrs_.end() || it->second != entry.second) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
                       TF_AttrType* out, unsigned char* is_list) {
   auto* t = gtl::FindOrNull(m, attr_name);
@@ -171,6 +171,9 @@ class AttrBuilder : public AbstractOpAttrs {
   // AttrValueMap.
   void CopyAttributes(const AttrBuilder& other);
 
+  // Returns true if `other` is for the same op and has the same attributes.
+  bool HasSameAttributes(const AttrBuilder& other) const;
+
   void GetNameAttrList(tensorflow::NameAttrList* name_and_attrs) const override;
 
   bool GetInt(absl::string_view attr_name, int64_t* result) const override;
@@ -141,6 +141,25 @@ TEST(AttrBuilder, GetTypeList) {
   ASSERT_EQ(DT_INT64, type_list[1]) << type_list[1];
 }
 
+TEST(AttrBuilder, HasSameAttributes) {
+  AttrBuilder a("MatMul");
+  a.Set("transpose_a", true).Set("T", DT_FLOAT);
+  AttrBuilder b("MatMul");
+  b.Set("T", DT_FLOAT).Set("transpose_a", true);
+  EXPECT_TRUE(a.HasSameAttributes(b));
+
+  b.Set("transpose_b", true);
+  EXPECT_FALSE(a.HasSameAttributes(b));
+
+  AttrBuilder c("MatMul");
+  c.Set("transpose_a", false).Set("T", DT_FLOAT);
+  EXPECT_FALSE(a.HasSameAttributes(c));
+
+  AttrBuilder d("BatchMatMul");
+  d.Set("transpose_a", true).Set("T", DT_FLOAT);
+  EXPECT_FALSE(a.HasSameAttributes(d));
+}
+
 TEST(AttrBuilder, BuildNodeDef) {
   AttrBuilder a("MatMul");
   a.Set("transpose_a", true);
@@ -473,6 +473,7 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
     mutex_lock ml(cache_mu_);
     default_executor_.WaitForAllPendingNodes().IgnoreError();
     kernel_cache_.clear();
+    kernel_cache_generation_.fetch_add(1, std::memory_order_acq_rel);
     for (auto& entry : registered_functions_) {
       entry.second->cached_kernel_keys->clear();
     }
@@ -1134,6 +1135,7 @@ Status EagerContext::RemoveFunction(const string& func) {
       for (auto& key : *registered_function->cached_kernel_keys) {
         kernel_cache_.erase(key);
       }
+      kernel_cache_generation_.fetch_add(1, std::memory_order_acq_rel);
       registered_functions_.erase(func);
     }
     registered_function->Unref();
@@ -1225,6 +1227,17 @@ core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
   return new_ref;
 }
 
+core::RefCountPtr<KernelAndDevice> EagerContext::RefCachedKernel(
+    KernelAndDevice* kernel, int64_t generation) {
+  tf_shared_lock l(cache_mu_);
+  if (kernel_cache_generation_.load(std::memory_order_acquire) != generation) {
+    return nullptr;
+  }
+  core::RefCountPtr<KernelAndDevice> new_ref(kernel);
+  new_ref->Ref();
+  return new_ref;
+}
+
 Device* EagerContext::GetCachedDevice(Fprint128 device_cache_key) {
   tf_shared_lock l(device_cache_mu_);
   auto iter = device_cache_.find(device_cache_key);
@@ -297,6 +297,18 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       Fprint128 cache_key, core::RefCountPtr<KernelAndDevice> kernel);
   void AddDeviceToCache(Fprint128 device_cache_key, Device* device);
 
+  // Returns a number that changes whenever kernels are removed from the kernel
+  // cache. A kernel found in or added to the cache stays in it as long as this
+  // number is the one returned before the lookup.
+  int64_t KernelCacheGeneration() const {
+    return kernel_cache_generation_.load(std::memory_order_acquire);
+  }
+  // Returns a new reference to `kernel`, which was found in or added to the
+  // kernel cache at `generation`, or nullptr if kernels were removed from the
+  // cache since.
+  core::RefCountPtr<KernelAndDevice> RefCachedKernel(KernelAndDevice* kernel,
+                                                     int64_t generation);
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   void SetLogDevicePlacement(bool enable) override {
     log_device_placement_ = enable;
@@ -786,6 +798,8 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
                      Fprint128Hasher>
       kernel_cache_ TF_GUARDED_BY(cache_mu_);
+  // Only changes while `cache_mu_` is held exclusively.
+  std::atomic<int64_t> kernel_cache_generation_{0};
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
 
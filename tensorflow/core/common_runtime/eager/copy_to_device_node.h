@@ -15,8 +15,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_COPY_TO_DEVICE_NODE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_COPY_TO_DEVICE_NODE_H_
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
@@ -56,17 +59,48 @@ class CopyToDeviceNode : public EagerNode {
         "eager::CopyToDeviceNode", "dynamic", tensor.dtype(),
         [&tensor]() { return tensor.shape().DebugString(); });
     TF_RETURN_IF_ERROR(src_->CopyToDevice(ctx_, dstd_, &tensor));
-    if (!async_ && mirror_) {
-      Status s = dst_->AddLocalMirror(std::move(tensor), dstd_);
-      // If a mirror was added since we called HasLocalMirror then just return
-      // and ignore the error.
-      if (s.ok() || (s.code() == error::Code::ALREADY_EXISTS)) {
-        return absl::OkStatus();
+    return SetCopy(std::move(tensor));
+  }
+
+  // Runs the copies queued right after this one to the same device with it,
+  // so that they share the device syncs and transfer latency (see
+  // TensorHandle::BatchCopyToDevice), up to the first copy that isn't to
+  // that device or that reads the result of one of the batched copies.
+  Status RunFused(absl::Span<EagerNode* const> next_nodes,
+                  int* num_fused) override {
+    *num_fused = 0;
+    std::vector<CopyToDeviceNode*> nodes = {this};
+    std::vector<const TensorHandle*> srcs = {src_};
+    for (EagerNode* next_node : next_nodes) {
+      CopyToDeviceNode* node = next_node->AsCopyToDeviceNode();
+      if (node == nullptr || node->dstd_ != dstd_ || &node->ctx_ != &ctx_ ||
+          node->async_ != async_ || node->mirror_ != mirror_ ||
+          std::any_of(nodes.begin(), nodes.end(),
+                      [node](const CopyToDeviceNode* batched) {
+                        return batched->dst_ == node->src_ &&
+                               batched->src_ != batched->dst_;
+                      })) {
+        break;
       }
-      return s;
-    } else {
-      return dst_->SetTensor(std::move(tensor), dstd_);
+      nodes.push_back(node);
+      srcs.push_back(node->src_);
+    }
+    if (nodes.size() < 2) {
+      return Run();
+    }
+
+    VLOG(3) << "Running " << nodes.size() << " copies to "
+            << (dstd_ ? dstd_->name() : "[]") << " batched";
+    std::vector<tensorflow::Tensor> tensors;
+    *num_fused = nodes.size() - 1;
+    // On errors, the executor aborts the other nodes.
+    TF_RETURN_IF_ERROR(
+        TensorHandle::BatchCopyToDevice(ctx_, srcs, dstd_, &tensors));
+    Status status;
+    for (int i = 0; i < nodes.size(); ++i) {
+      status.Update(nodes[i]->SetCopy(std::move(tensors[i])));
     }
+    return status;
   }
 
   void Abort(Status status) override { dst_->Poison(status, dstd_); }
@@ -79,9 +113,25 @@ class CopyToDeviceNode : public EagerNode {
     return out;
   }
 
+  CopyToDeviceNode* AsCopyToDeviceNode() override { return this; }
+
   TensorHandle* dst() { return dst_; }
 
  private:
+  Status SetCopy(tensorflow::Tensor tensor) {
+    if (!async_ && mirror_) {
+      Status s = dst_->AddLocalMirror(std::move(tensor), dstd_);
+      // If a mirror was added since we called HasLocalMirror then just return
+      // and ignore the error.
+      if (s.ok() || (s.code() == error::Code::ALREADY_EXISTS)) {
+        return absl::OkStatus();
+      }
+      return s;
+    } else {
+      return dst_->SetTensor(std::move(tensor), dstd_);
+    }
+  }
+
   TensorHandle* src_;
   TensorHandle* dst_;
   Device* dstd_;
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <forward_list>
 #include <functional>
 #include <memory>
@@ -32,6 +34,27 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+bool IsOpFusionEnabled() {
+  bool enabled = false;
+  TF_CHECK_OK(
+      ReadBoolFromEnvVar("TF_EAGER_ASYNC_OP_FUSION", false, &enabled));
+  return enabled;
+}
+
+bool IsRemoteBatchingEnabled() {
+  bool enabled = false;
+  TF_CHECK_OK(
+      ReadBoolFromEnvVar("TF_EAGER_BATCH_REMOTE_OPS", false, &enabled));
+  return enabled;
+}
+
+int64_t RemoteBatchFlushLatencyUsecs() {
+  int64_t latency_us = 0;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_REMOTE_BATCH_FLUSH_LATENCY_US", 0,
+                                  &latency_us));
+  return latency_us;
+}
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async, bool enable_streaming_enqueue,
@@ -46,6 +69,10 @@ EagerExecutor::EagerExecutor(bool async, bool enable_streaming_enqueue,
       enable_async_wait_for_remote_function_(
           IsAsyncWaitForRemoteFunctionEnabled()),
       enable_streaming_enqueue_(enable_streaming_enqueue),
+      enable_op_fusion_(async && IsOpFusionEnabled()),
+      enable_remote_batching_(async && IsRemoteBatchingEnabled()),
+      remote_batch_flush_latency_us_(
+          enable_remote_batching_ ? RemoteBatchFlushLatencyUsecs() : 0),
       in_flight_nodes_limit_(in_flight_nodes_limit) {
   if (async && in_flight_nodes_limit_ > 0) {
     VLOG(4) << "EagerExecutor InFlightNodes limit is set to "
@@ -160,10 +187,11 @@ Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
     } else {
       status = status_;
       if (status.ok()) {
-        node_queue_.push(std::move(item));
+        node_queue_.push_back(std::move(item));
         // If there were no previous nodes pending, wake the run thread to
-        // start processing requests again.
-        if (node_queue_.size() == 1) {
+        // start processing requests again. The run thread may also be waiting
+        // for more remote nodes to batch.
+        if (node_queue_.size() == 1 || remote_batch_flush_latency_us_ > 0) {
           nodes_pending_.notify_all();
         }
         if (in_flight_nodes_limit_ == 0) {
@@ -211,6 +239,8 @@ tensorflow::Status EagerExecutor::WaitForAllPendingNodesLocked(
   auto last_id = next_node_id_ - 1;
   DVLOG(3) << "Wait for Node: [id " << last_id << "] ";
   node_done_notifications_.insert(std::make_pair(last_id, &cond));
+  // Don't let the run thread wait for more remote nodes to batch.
+  if (remote_batch_flush_latency_us_ > 0) nodes_pending_.notify_all();
   cond.wait(*lock);
   // Note that we could be woken up if an error occurs, even though the node has
   // not actually executed.
@@ -256,7 +286,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
     if (from_queue) {
       // Since this was from the async queue, pop it from the front of the queue
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-      node_queue_.pop();
+      node_queue_.pop_front();
     } else if (async) {
       // If it is an Async node then we will find the node in the unfinished
       // nodes list. However we only notify if we are at the front of the list
@@ -290,7 +320,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       }
       while (!node_queue_.empty()) {
         items_to_destroy.push_front(std::move(node_queue_.front()));
-        node_queue_.pop();
+        node_queue_.pop_front();
       }
       for (auto& it : unfinished_nodes_) {
         items_to_destroy.push_front(std::move(it.second));
@@ -349,6 +379,7 @@ void EagerExecutor::Run() {
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
     core::RefCountPtr<NodeItem> curr_item;
+    std::vector<core::RefCountPtr<NodeItem>> next_items;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
@@ -364,8 +395,36 @@ void EagerExecutor::Run() {
       // and register a notification for its completion.
       curr_item.reset(node_queue_.front().get());
       curr_item->Ref();
+      if (enable_op_fusion_ && curr_item->node->AsAsync() == nullptr) {
+        for (auto it = node_queue_.begin() + 1;
+             it != node_queue_.end() && next_items.size() < kMaxFusedNodes;
+             ++it) {
+          next_items.emplace_back(it->get());
+          (*it)->Ref();
+        }
+      } else if (enable_remote_batching_ &&
+                 curr_item->node->AsAsyncRemoteExecuteNode() != nullptr) {
+        WaitForRemoteBatchLocked(&l);
+        // The queue is cleared if a node failed while waiting.
+        if (!node_queue_.empty() &&
+            node_queue_.front().get() == curr_item.get()) {
+          for (auto it = node_queue_.begin() + 1;
+               it != node_queue_.end() && next_items.size() < kMaxBatchedNodes;
+               ++it) {
+            next_items.emplace_back(it->get());
+            (*it)->Ref();
+          }
+        }
+      }
+    }
+    Status status;
+    if (next_items.empty()) {
+      status = RunItem(std::move(curr_item), /*from_queue=*/true);
+    } else if (curr_item->node->AsAsync() != nullptr) {
+      status = RunBatchedItems(std::move(curr_item), std::move(next_items));
+    } else {
+      status = RunFusedItems(std::move(curr_item), std::move(next_items));
     }
-    Status status = RunItem(std::move(curr_item), /*from_queue=*/true);
     if (!status.ok()) {
       VLOG(1) << "Failed to run item: " << status;
     }
@@ -378,28 +437,12 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
            << item->node->DebugString();
   AsyncRemoteExecuteNode* async_remote_node =
       item->node->AsAsyncRemoteExecuteNode();
-  if (enable_async_wait_for_remote_function_) {
-    if (async_remote_node != nullptr) {
-      if (last_eager_client_ != nullptr &&
-          async_remote_node->eager_client() != nullptr &&
-          last_eager_client_ != async_remote_node->eager_client()) {
-        // Running a remote function, need to sync if the function is going to
-        // different device than last time we run remote distributed function.
-        DVLOG(3) << "Executing Sync Executor for node" << item->id;
-        tensorflow::Status status = async_remote_node->SyncExecutors();
-        if (!status.ok()) {
-          NodeDone(item, status, from_queue);
-          return status;
-        }
-        last_eager_client_ = nullptr;
-      }
-      if (async_remote_node->eager_client() != nullptr &&
-          async_remote_node->needs_remote_inputs() &&
-          async_remote_node->allow_multiple_pending_requests()) {
-        // We are running remote distributed function, update
-        // last_remote_device_name_.
-        last_eager_client_ = async_remote_node->eager_client();
-      }
+  if (async_remote_node != nullptr) {
+    tensorflow::Status status =
+        MaybeSyncExecutorsForRemoteNode(async_remote_node);
+    if (!status.ok()) {
+      NodeDone(item, status, from_queue);
+      return status;
     }
   }
 
@@ -425,6 +468,134 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
   return status();
 }
 
+Status EagerExecutor::RunFusedItems(
+    core::RefCountPtr<NodeItem> item,
+    std::vector<core::RefCountPtr<NodeItem>> next_items) {
+  DVLOG(3) << "Running Node: [id " << item->id << "] "
+           << item->node->DebugString() << " with " << next_items.size()
+           << " next nodes";
+  std::vector<EagerNode*> next_nodes;
+  next_nodes.reserve(next_items.size());
+  for (const auto& next_item : next_items) {
+    next_nodes.push_back(next_item->node.get());
+  }
+  int num_fused = 0;
+  Status status = item->node->RunFused(next_nodes, &num_fused);
+  NodeDone(item, status, /*from_queue=*/true);
+  // If `status` is an error, the fused nodes were aborted with the rest of the
+  // queue and this does nothing.
+  for (int i = 0; i < num_fused; ++i) {
+    NodeDone(next_items[i], status, /*from_queue=*/true);
+  }
+  return status;
+}
+
+Status EagerExecutor::RunBatchedItems(
+    core::RefCountPtr<NodeItem> item,
+    std::vector<core::RefCountPtr<NodeItem>> next_items) {
+  AsyncRemoteExecuteNode* remote_node = item->node->AsAsyncRemoteExecuteNode();
+  std::vector<EagerNode*> next_nodes;
+  next_nodes.reserve(next_items.size());
+  for (const auto& next_item : next_items) {
+    next_nodes.push_back(next_item->node.get());
+  }
+  const int num_batched = remote_node->NumBatchable(next_nodes);
+  if (num_batched == 0) {
+    return RunItem(std::move(item), /*from_queue=*/true);
+  }
+  DVLOG(3) << "Running Node: [id " << item->id << "] "
+           << item->node->DebugString() << " with " << num_batched
+           << " batched nodes";
+  next_items.resize(num_batched);
+  next_nodes.resize(num_batched);
+
+  Status status = MaybeSyncExecutorsForRemoteNode(remote_node);
+  if (!status.ok()) {
+    NodeDone(item, status, /*from_queue=*/true);
+    return status;
+  }
+
+  // Moves the nodes, which are at the front of the queue, to the unfinished
+  // nodes all at once, so that they are either all run or none is.
+  std::vector<NodeItem*> batched_items;
+  batched_items.reserve(num_batched + 1);
+  {
+    tensorflow::mutex_lock l(node_queue_mutex_);
+    if (!status_.ok()) return status_;
+    item->state = NodeState::kSCHEDULED;
+    for (const auto& next_item : next_items) {
+      next_item->state = NodeState::kSCHEDULED;
+    }
+    batched_items.push_back(item.get());
+    for (auto& next_item : next_items) {
+      batched_items.push_back(next_item.get());
+    }
+    for (NodeItem* batched_item : batched_items) {
+      DCHECK(!node_queue_.empty() &&
+             batched_item == node_queue_.front().get());
+      DVLOG(3) << "Add Node: [id " << batched_item->id
+               << "] to unfinished map.";
+      node_queue_.pop_front();
+      batched_item->Ref();
+      unfinished_nodes_.emplace_hint(
+          unfinished_nodes_.end(), batched_item->id,
+          core::RefCountPtr<NodeItem>(batched_item));
+    }
+  }
+
+  // The items are referenced until they are all done.
+  for (NodeItem* batched_item : batched_items) {
+    batched_item->Ref();
+  }
+  remote_node->RunAsyncBatched(
+      next_nodes, [this, batched_items](const Status& status) {
+        for (NodeItem* batched_item : batched_items) {
+          core::RefCountPtr<NodeItem> async_item(batched_item);
+          NodeDone(async_item, status, false);
+        }
+      });
+
+  // Return the status of the executor in case we are in an error state.
+  return this->status();
+}
+
+Status EagerExecutor::MaybeSyncExecutorsForRemoteNode(
+    AsyncRemoteExecuteNode* node) {
+  if (!enable_async_wait_for_remote_function_) return absl::OkStatus();
+  if (last_eager_client_ != nullptr && node->eager_client() != nullptr &&
+      last_eager_client_ != node->eager_client()) {
+    // Running a remote function, need to sync if the function is going to
+    // different device than last time we run remote distributed function.
+    DVLOG(3) << "Executing Sync Executor for node " << node->DebugString();
+    TF_RETURN_IF_ERROR(node->SyncExecutors());
+    last_eager_client_ = nullptr;
+  }
+  if (node->eager_client() != nullptr && node->needs_remote_inputs() &&
+      node->allow_multiple_pending_requests()) {
+    // We are running remote distributed function, update
+    // last_remote_device_name_.
+    last_eager_client_ = node->eager_client();
+  }
+  return absl::OkStatus();
+}
+
+void EagerExecutor::WaitForRemoteBatchLocked(mutex_lock* lock) {
+  if (remote_batch_flush_latency_us_ <= 0) return;
+  const uint64 deadline_us =
+      Env::Default()->NowMicros() + remote_batch_flush_latency_us_;
+  while (status_.ok() && state_ == ExecutorState::kActive &&
+         node_queue_.size() <= kMaxBatchedNodes &&
+         node_done_notifications_.empty() &&
+         (in_flight_nodes_limit_ == 0 ||
+          node_queue_.size() + unfinished_nodes_.size() <
+              in_flight_nodes_limit_)) {
+    const uint64 now_us = Env::Default()->NowMicros();
+    if (now_us >= deadline_us) break;
+    nodes_pending_.wait_for(*lock,
+                            std::chrono::microseconds(deadline_us - now_us));
+  }
+}
+
 Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
                                        bool from_queue) {
   tensorflow::mutex_lock l(node_queue_mutex_);
@@ -434,7 +605,7 @@ Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
 
   if (from_queue) {
     DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-    node_queue_.pop();
+    node_queue_.pop_front();
   }
 
   DVLOG(3) << "Add Node: [id " << item->id << "] to unfinished map.";
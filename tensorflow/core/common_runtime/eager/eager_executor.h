@@ -18,15 +18,16 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
@@ -43,7 +44,9 @@ limitations under the License.
 namespace tensorflow {
 
 class AsyncEagerNode;
+class AsyncExecuteNode;
 class AsyncRemoteExecuteNode;
+class CopyToDeviceNode;
 namespace eager {
 class EagerClient;
 }
@@ -65,6 +68,16 @@ class EagerNode {
   // execution is done.
   virtual Status Run() = 0;
 
+  // Runs this node like Run(), possibly together with some of `next_nodes`,
+  // the nodes queued right after it in order, and sets `*num_fused` to the
+  // number of those it ran. Async executors with op fusion enabled call this
+  // instead of Run() for synchronous nodes.
+  virtual Status RunFused(absl::Span<EagerNode* const> next_nodes,
+                          int* num_fused) {
+    *num_fused = 0;
+    return Run();
+  }
+
   // Called when this node will not be run due to some error contained in
   // `status`. `status` must not be OK.
   // For example, if the node would have computed some tensors in the Run(),
@@ -74,6 +87,8 @@ class EagerNode {
   // Returns nullptr iff this Eager node is synchronous.
   virtual AsyncEagerNode* AsAsync() { return nullptr; }
   virtual AsyncRemoteExecuteNode* AsAsyncRemoteExecuteNode() { return nullptr; }
+  virtual AsyncExecuteNode* AsAsyncExecuteNode() { return nullptr; }
+  virtual CopyToDeviceNode* AsCopyToDeviceNode() { return nullptr; }
 
   virtual string DebugString() const = 0;
 
@@ -103,6 +118,22 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
   virtual bool needs_remote_inputs() const = 0;
   virtual bool allow_multiple_pending_requests() const = 0;
   virtual Status SyncExecutors() = 0;
+
+  // Returns how many of `next_nodes`, the nodes queued right after this one in
+  // order, RunAsyncBatched() can send to the remote worker in the same request
+  // as this node.
+  virtual int NumBatchable(absl::Span<EagerNode* const> next_nodes) const {
+    return 0;
+  }
+
+  // Runs this node like RunAsync(), together with `batched_nodes`, the first
+  // nodes counted by NumBatchable(), and calls `done` once all of them are
+  // done.
+  virtual void RunAsyncBatched(absl::Span<EagerNode* const> batched_nodes,
+                               StatusCallback done) {
+    DCHECK(batched_nodes.empty());
+    RunAsync(std::move(done));
+  }
 };
 
 // A class for handling async execution (see TFE_ContextSetAsync).
@@ -211,6 +242,23 @@ class EagerExecutor {
   void Run();
 
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Runs `item`, the front of the queue, together with the first nodes of
+  // `next_items`, the items queued after it, that it can be fused with.
+  Status RunFusedItems(core::RefCountPtr<NodeItem> item,
+                       std::vector<core::RefCountPtr<NodeItem>> next_items);
+  // Runs `item`, a remote node at the front of the queue, together with the
+  // first nodes of `next_items` that can be sent in the same request.
+  Status RunBatchedItems(core::RefCountPtr<NodeItem> item,
+                         std::vector<core::RefCountPtr<NodeItem>> next_items);
+  // Syncs the executors before running `node` if needed, see
+  // enable_async_wait_for_remote_function_.
+  Status MaybeSyncExecutorsForRemoteNode(AsyncRemoteExecuteNode* node);
+  // Waits up to `remote_batch_flush_latency_us_` for more nodes to be queued
+  // after the remote node at the front of the queue, so that they can be sent
+  // with it. Stops waiting early once a batch is full or a thread waits for
+  // nodes to be done.
+  void WaitForRemoteBatchLocked(mutex_lock* lock)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
 
   // The impl of WaitForAllPendingNodes
@@ -230,7 +278,7 @@ class EagerExecutor {
   condition_variable nodes_done_ TF_GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending NodeItems. Ordered by NodeItem::id.
-  std::queue<core::RefCountPtr<NodeItem>> node_queue_
+  std::deque<core::RefCountPtr<NodeItem>> node_queue_
       TF_GUARDED_BY(node_queue_mutex_);
 
   // Ordered by NodeItem::id.
@@ -270,6 +318,19 @@ class EagerExecutor {
   // Enable sending remote executions through streaming enqueue.
   const bool enable_streaming_enqueue_;
 
+  // Whether to let synchronous nodes run the nodes queued after them, e.g. to
+  // fuse consecutive elementwise ops or to batch consecutive copies to a
+  // device. See EagerNode::RunFused.
+  const bool enable_op_fusion_;
+  static constexpr int kMaxFusedNodes = 16;
+
+  // Whether to send consecutive remote nodes to the same worker in a single
+  // request. See AsyncRemoteExecuteNode::RunAsyncBatched.
+  const bool enable_remote_batching_;
+  // How long to wait for more remote nodes before sending a batch.
+  const int64_t remote_batch_flush_latency_us_;
+  static constexpr int kMaxBatchedNodes = 64;
+
   // Callbacks to run on destruction.
   absl::flat_hash_map<intptr_t, std::vector<std::function<void()>>> cleanups_;
 
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include <cstdlib>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
@@ -102,6 +104,44 @@ class TestAsyncEagerNode : public AsyncEagerNode {
   Status run_return_status_;
 };
 
+// A remote node that can be batched with any other TestRemoteNode, and records
+// the size of the batches it runs in `batch_sizes`.
+class TestRemoteNode : public AsyncRemoteExecuteNode {
+ public:
+  explicit TestRemoteNode(std::vector<int>* batch_sizes)
+      : batch_sizes_(batch_sizes) {}
+
+  void RunAsync(StatusCallback done) override {
+    batch_sizes_->push_back(1);
+    done(absl::OkStatus());
+  }
+
+  int NumBatchable(absl::Span<EagerNode* const> next_nodes) const override {
+    int num_batchable = 0;
+    while (num_batchable < next_nodes.size() &&
+           next_nodes[num_batchable]->AsAsyncRemoteExecuteNode() != nullptr) {
+      ++num_batchable;
+    }
+    return num_batchable;
+  }
+
+  void RunAsyncBatched(absl::Span<EagerNode* const> batched_nodes,
+                       StatusCallback done) override {
+    batch_sizes_->push_back(batched_nodes.size() + 1);
+    done(absl::OkStatus());
+  }
+
+  const eager::EagerClient* eager_client() const override { return nullptr; }
+  bool needs_remote_inputs() const override { return false; }
+  bool allow_multiple_pending_requests() const override { return true; }
+  Status SyncExecutors() override { return absl::OkStatus(); }
+  void Abort(Status status) override {}
+  string DebugString() const override { return "testRemoteNode"; }
+
+ private:
+  std::vector<int>* batch_sizes_;
+};
+
 TEST(EagerExecutorTest, TestSyncExecutorWithEagerNode) {
   auto sync_executor = std::make_unique<EagerExecutor>(
       /*async=*/false, /*enable_streaming_enqueue=*/true);
@@ -269,6 +309,38 @@ TEST(EagerExecutorTest, TestAsyncExecutorFailRunWithAsyncNode) {
   ASSERT_EQ(state->read_state(), TestState::State::kFailure);
 }
 
+TEST(EagerExecutorTest, TestAsyncExecutorBatchesRemoteNodes) {
+  setenv("TF_EAGER_BATCH_REMOTE_OPS", "true", 1);
+  // Long enough for the nodes to be batched until they are waited for.
+  setenv("TF_EAGER_REMOTE_BATCH_FLUSH_LATENCY_US", "60000000", 1);
+  auto async_executor = std::make_unique<EagerExecutor>(
+      /*async=*/true, /*enable_streaming_enqueue=*/true);
+  unsetenv("TF_EAGER_BATCH_REMOTE_OPS");
+  unsetenv("TF_EAGER_REMOTE_BATCH_FLUSH_LATENCY_US");
+
+  std::vector<int> batch_sizes;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(async_executor->AddOrExecute(
+        std::make_unique<TestRemoteNode>(&batch_sizes)));
+  }
+  TF_ASSERT_OK(async_executor->WaitForAllPendingNodes());
+  EXPECT_EQ(batch_sizes, std::vector<int>({3}));
+
+  // A node that isn't remote ends a batch.
+  auto state = std::make_unique<TestState>();
+  batch_sizes.clear();
+  TF_ASSERT_OK(async_executor->AddOrExecute(
+      std::make_unique<TestRemoteNode>(&batch_sizes)));
+  TF_ASSERT_OK(async_executor->AddOrExecute(
+      std::make_unique<TestAsyncEagerNode>(state.get())));
+  TF_ASSERT_OK(async_executor->AddOrExecute(
+      std::make_unique<TestRemoteNode>(&batch_sizes)));
+  TF_ASSERT_OK(async_executor->WaitForAllPendingNodes());
+  EXPECT_EQ(batch_sizes, std::vector<int>({1, 1}));
+  EXPECT_EQ(state->read_state(), TestState::State::kSuccess);
+  TF_ASSERT_OK(async_executor->ShutDown());
+}
+
 TEST(EagerExecutorTest, TestAsyncExecutorAddNodesAfterShutdown) {
   auto async_executor = std::make_unique<EagerExecutor>(
       /*async=*/true, /*enable_streaming_enqueue=*/true);
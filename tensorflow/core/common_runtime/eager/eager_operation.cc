@@ -36,6 +36,46 @@ limitations under the License.
 
 namespace tensorflow {
 
+const InlineKernelCache::Entry* InlineKernelCache::Find(
+    const AttrBuilder& attrs, absl::string_view requested_device_name,
+    Device* requested_device, bool allow_soft_placement) const {
+  for (const Entry& entry : entries_) {
+    if (entry.requested_device == requested_device &&
+        entry.allow_soft_placement == allow_soft_placement &&
+        entry.requested_device_name == requested_device_name &&
+        entry.attrs.HasSameAttributes(attrs)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void InlineKernelCache::Add(const AttrBuilder& attrs,
+                            absl::string_view requested_device_name,
+                            Device* requested_device, bool allow_soft_placement,
+                            Device* device, KernelAndDevice* kernel,
+                            int64_t kernel_cache_generation) {
+  Entry* entry = const_cast<Entry*>(Find(attrs, requested_device_name,
+                                         requested_device,
+                                         allow_soft_placement));
+  if (entry == nullptr) {
+    if (entries_.size() < kMaxEntries) {
+      entry = &entries_.emplace_back();
+    } else {
+      entry = &entries_[oldest_entry_];
+      oldest_entry_ = (oldest_entry_ + 1) % kMaxEntries;
+    }
+    entry->attrs.Reset(attrs.op_name().c_str());
+    entry->attrs.CopyAttributes(attrs);
+    entry->requested_device_name = string(requested_device_name);
+    entry->requested_device = requested_device;
+    entry->allow_soft_placement = allow_soft_placement;
+  }
+  entry->device = device;
+  entry->kernel = kernel;
+  entry->kernel_cache_generation = kernel_cache_generation;
+}
+
 // An EagerOperation object can be reused for a different op by calling
 // Clear(), and then Reset(...) with the same arguments that would have
 // been provided to the constructor.
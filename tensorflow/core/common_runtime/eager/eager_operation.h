@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_EAGER_OPERATION_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_EAGER_OPERATION_H_
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <variant>
@@ -22,6 +23,7 @@ limitations under the License.
 
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "tensorflow/c/eager/abstract_tensor_handle.h"
@@ -40,6 +42,48 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Remembers the kernels that the last few executions of an EagerOperation
+// found in the kernel cache of its EagerContext. When a primitive op is
+// executed again with the same attributes on the same requested device, this
+// saves building its NodeDef and computing and looking up its device and
+// kernel cache keys. Language bindings reuse a single EagerOperation for most
+// ops, so a few entries cover the ops of a typical loop body.
+class InlineKernelCache {
+ public:
+  struct Entry {
+    AttrBuilder attrs;
+    // The device name and device of the operation before placement.
+    string requested_device_name;
+    Device* requested_device = nullptr;
+    bool allow_soft_placement = false;
+
+    // The device the operation was placed on.
+    Device* device = nullptr;
+    // Owned by the kernel cache of the context, see
+    // EagerContext::RefCachedKernel.
+    KernelAndDevice* kernel = nullptr;
+    int64_t kernel_cache_generation = 0;
+  };
+
+  // Returns the entry for executing an operation with `attrs` on the requested
+  // device, or nullptr.
+  const Entry* Find(const AttrBuilder& attrs,
+                    absl::string_view requested_device_name,
+                    Device* requested_device, bool allow_soft_placement) const;
+
+  // Adds an entry, replacing the one with the same attributes and requested
+  // device or else the oldest one.
+  void Add(const AttrBuilder& attrs, absl::string_view requested_device_name,
+           Device* requested_device, bool allow_soft_placement, Device* device,
+           KernelAndDevice* kernel, int64_t kernel_cache_generation);
+
+ private:
+  static constexpr int kMaxEntries = 4;
+
+  std::vector<Entry> entries_;
+  int oldest_entry_ = 0;
+};
+
 class EagerOperation : public ImmediateExecutionOperation {
  public:
   explicit EagerOperation(tensorflow::EagerContext* ctx)
@@ -75,6 +119,11 @@ class EagerOperation : public ImmediateExecutionOperation {
   // updated to that device.
   Status SetDeviceName(const char* name) override;
 
+  // Kept by Reset, see InlineKernelCache.
+  InlineKernelCache* MutableInlineKernelCache() {
+    return &inline_kernel_cache_;
+  }
+
   void SetDevice(VariantDevice device) {
     device_ = device;
     device_name_ = std::visit(
@@ -314,6 +363,8 @@ class EagerOperation : public ImmediateExecutionOperation {
   int inference_arg_idx_;  // arg definition index for the next input to be
                            // added
   gtl::FlatSet<std::string> inference_attrs_;  // attributes inferred so far
+
+  InlineKernelCache inline_kernel_cache_;
 };
 
 inline void EagerOperation::UpdateInput(int i, TensorHandle* h) {
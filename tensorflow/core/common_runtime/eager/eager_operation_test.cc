@@ -79,5 +79,42 @@ TEST(EagerOperationTest, EagerFunctionParamsAndStepId) {
   ctx->Unref();
 }
 
+TEST(InlineKernelCacheTest, FindsEntriesByAttributesAndDevice) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  Device* device = device_mgr.HostCPU();
+  InlineKernelCache cache;
+  AttrBuilder float_attrs("Identity");
+  float_attrs.Set("T", DT_FLOAT);
+  AttrBuilder int_attrs("Identity");
+  int_attrs.Set("T", DT_INT32);
+  cache.Add(float_attrs, "", nullptr, /*allow_soft_placement=*/true, device,
+            /*kernel=*/nullptr, /*kernel_cache_generation=*/3);
+
+  const InlineKernelCache::Entry* entry =
+      cache.Find(float_attrs, "", nullptr, /*allow_soft_placement=*/true);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->device, device);
+  EXPECT_EQ(entry->kernel_cache_generation, 3);
+  EXPECT_EQ(cache.Find(int_attrs, "", nullptr, true), nullptr);
+  EXPECT_EQ(cache.Find(float_attrs, "/device:CPU:0", nullptr, true), nullptr);
+  EXPECT_EQ(cache.Find(float_attrs, "", device, true), nullptr);
+  EXPECT_EQ(cache.Find(float_attrs, "", nullptr, false), nullptr);
+
+  // Adding the same attributes again replaces the entry.
+  cache.Add(float_attrs, "", nullptr, true, device, nullptr, 4);
+  EXPECT_EQ(cache.Find(float_attrs, "", nullptr, true)->kernel_cache_generation,
+            4);
+
+  // Four other entries evict it.
+  for (const char* op : {"Neg", "Abs", "Sign", "Square"}) {
+    AttrBuilder attrs(op);
+    attrs.Set("T", DT_FLOAT);
+    cache.Add(attrs, "", nullptr, true, device, nullptr, 4);
+    EXPECT_NE(cache.Find(attrs, "", nullptr, true), nullptr);
+  }
+  EXPECT_EQ(cache.Find(float_attrs, "", nullptr, true), nullptr);
+}
+
 }  // namespace
 }  // namespace tensorflow
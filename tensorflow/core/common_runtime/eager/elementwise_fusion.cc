@@ -0,0 +1,242 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/elementwise_fusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace {
+
+// The number of elements of each value computed before moving on to the next
+// op, small enough for the operands of an op to stay in the L1 cache.
+constexpr int64_t kBlockSize = 1024;
+
+template <typename T, typename F>
+void ApplyUnary(const T* a, bool a_is_scalar, T* out, int64_t size, F f) {
+  if (a_is_scalar) {
+    std::fill(out, out + size, f(a[0]));
+    return;
+  }
+  for (int64_t i = 0; i < size; ++i) out[i] = f(a[i]);
+}
+
+template <typename T, typename F>
+void ApplyBinary(const T* a, bool a_is_scalar, const T* b, bool b_is_scalar,
+                 T* out, int64_t size, F f) {
+  if (a_is_scalar && b_is_scalar) {
+    std::fill(out, out + size, f(a[0], b[0]));
+  } else if (a_is_scalar) {
+    const T a0 = a[0];
+    for (int64_t i = 0; i < size; ++i) out[i] = f(a0, b[i]);
+  } else if (b_is_scalar) {
+    const T b0 = b[0];
+    for (int64_t i = 0; i < size; ++i) out[i] = f(a[i], b0);
+  } else {
+    for (int64_t i = 0; i < size; ++i) out[i] = f(a[i], b[i]);
+  }
+}
+
+}  // namespace
+
+bool ElementwiseFusion::IsFusible(absl::string_view op_type, DataType dtype) {
+  int num_operands;
+  return (dtype == DT_FLOAT || dtype == DT_DOUBLE) &&
+         GetOpKind(op_type, &num_operands).has_value();
+}
+
+std::optional<ElementwiseFusion::OpKind> ElementwiseFusion::GetOpKind(
+    absl::string_view op_type, int* num_operands) {
+  *num_operands = 2;
+  if (op_type == "Add" || op_type == "AddV2") return OpKind::kAdd;
+  if (op_type == "Sub") return OpKind::kSub;
+  if (op_type == "Mul") return OpKind::kMul;
+  if (op_type == "Maximum") return OpKind::kMaximum;
+  if (op_type == "Minimum") return OpKind::kMinimum;
+  *num_operands = 1;
+  if (op_type == "Neg") return OpKind::kNeg;
+  if (op_type == "Abs") return OpKind::kAbs;
+  if (op_type == "Square") return OpKind::kSquare;
+  if (op_type == "Relu") return OpKind::kRelu;
+  return std::nullopt;
+}
+
+ElementwiseFusion::Value ElementwiseFusion::AddInput(const Tensor& tensor) {
+  ValueInfo& info = values_.emplace_back();
+  info.shape = tensor.shape();
+  info.input = tensor;
+  return values_.size() - 1;
+}
+
+std::optional<ElementwiseFusion::Value> ElementwiseFusion::AddOp(
+    absl::string_view op_type, absl::Span<const Value> operands) {
+  int num_operands;
+  std::optional<OpKind> kind = GetOpKind(op_type, &num_operands);
+  if (!kind.has_value() || operands.size() != num_operands) {
+    return std::nullopt;
+  }
+  std::optional<TensorShape> shape = shape_;
+  bool is_scalar = true;
+  for (Value operand : operands) {
+    const ValueInfo& info = values_[operand];
+    if (info.input.IsInitialized() && info.input.dtype() != dtype_) {
+      return std::nullopt;
+    }
+    if (info.shape.dims() == 0) continue;
+    if (!shape.has_value()) {
+      shape = info.shape;
+    } else if (info.shape != *shape) {
+      return std::nullopt;
+    }
+    is_scalar = false;
+  }
+  shape_ = shape;
+
+  Op& op = ops_.emplace_back();
+  op.kind = *kind;
+  std::copy(operands.begin(), operands.end(), op.operands);
+  op.num_operands = num_operands;
+  op.output = values_.size();
+  ValueInfo& info = values_.emplace_back();
+  if (!is_scalar) info.shape = *shape_;
+  info.op = ops_.size() - 1;
+  return op.output;
+}
+
+template <typename T>
+void ElementwiseFusion::EvaluateOps(bool scalar_ops, absl::Span<T* const> data,
+                                    int64_t begin, int64_t size) const {
+  for (const Op& op : ops_) {
+    const bool output_is_scalar = values_[op.output].shape.dims() == 0;
+    if (output_is_scalar != scalar_ops) continue;
+    const Value a = op.operands[0];
+    const bool a_is_scalar = values_[a].shape.dims() == 0;
+    const T* a_data = data[a] + (a_is_scalar ? 0 : begin);
+    T* out = data[op.output] + begin;
+    if (op.num_operands == 1) {
+      switch (op.kind) {
+        case OpKind::kNeg:
+          ApplyUnary(a_data, a_is_scalar, out, size, [](T x) { return -x; });
+          break;
+        case OpKind::kAbs:
+          ApplyUnary(a_data, a_is_scalar, out, size,
+                     [](T x) { return std::abs(x); });
+          break;
+        case OpKind::kSquare:
+          ApplyUnary(a_data, a_is_scalar, out, size,
+                     [](T x) { return x * x; });
+          break;
+        case OpKind::kRelu:
+          ApplyUnary(a_data, a_is_scalar, out, size,
+                     [](T x) { return x < T(0) ? T(0) : x; });
+          break;
+        default:
+          break;
+      }
+      continue;
+    }
+    const Value b = op.operands[1];
+    const bool b_is_scalar = values_[b].shape.dims() == 0;
+    const T* b_data = data[b] + (b_is_scalar ? 0 : begin);
+    switch (op.kind) {
+      case OpKind::kAdd:
+        ApplyBinary(a_data, a_is_scalar, b_data, b_is_scalar, out, size,
+                    [](T x, T y) { return x + y; });
+        break;
+      case OpKind::kSub:
+        ApplyBinary(a_data, a_is_scalar, b_data, b_is_scalar, out, size,
+                    [](T x, T y) { return x - y; });
+        break;
+      case OpKind::kMul:
+        ApplyBinary(a_data, a_is_scalar, b_data, b_is_scalar, out, size,
+                    [](T x, T y) { return x * y; });
+        break;
+      // Like the Maximum and Minimum kernels, these propagate NaNs.
+      case OpKind::kMaximum:
+        ApplyBinary(a_data, a_is_scalar, b_data, b_is_scalar, out, size,
+                    [](T x, T y) { return std::isnan(x) || x > y ? x : y; });
+        break;
+      case OpKind::kMinimum:
+        ApplyBinary(a_data, a_is_scalar, b_data, b_is_scalar, out, size,
+                    [](T x, T y) { return std::isnan(x) || x < y ? x : y; });
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+template <typename T>
+Status ElementwiseFusion::EvaluateAs(Allocator* allocator,
+                                     std::vector<Tensor>* outputs) const {
+  outputs->clear();
+  outputs->reserve(ops_.size());
+  std::vector<T*> data(values_.size());
+  for (int i = 0; i < values_.size(); ++i) {
+    const ValueInfo& info = values_[i];
+    if (info.op < 0) {
+      // Inputs that no op reads may have another dtype.
+      if (info.input.dtype() == dtype_) {
+        data[i] = const_cast<T*>(info.input.flat<T>().data());
+      }
+      continue;
+    }
+    Tensor& output = outputs->emplace_back(allocator, dtype_, info.shape);
+    if (!output.IsInitialized()) {
+      return errors::ResourceExhausted(
+          "Failed to allocate the output of a fused elementwise op with shape ",
+          info.shape.DebugString());
+    }
+    data[i] = output.flat<T>().data();
+  }
+
+  // Ops on scalars only are computed once, the others a block at a time.
+  EvaluateOps<T>(/*scalar_ops=*/true, data, 0, 1);
+  if (shape_.has_value()) {
+    const int64_t num_elements = shape_->num_elements();
+    for (int64_t begin = 0; begin < num_elements; begin += kBlockSize) {
+      EvaluateOps<T>(/*scalar_ops=*/false, data, begin,
+                     std::min(kBlockSize, num_elements - begin));
+    }
+  }
+  return absl::OkStatus();
+}
+
+Status ElementwiseFusion::Evaluate(Allocator* allocator,
+                                   std::vector<Tensor>* outputs) const {
+  switch (dtype_) {
+    case DT_FLOAT:
+      return EvaluateAs<float>(allocator, outputs);
+    case DT_DOUBLE:
+      return EvaluateAs<double>(allocator, outputs);
+    default:
+      return errors::InvalidArgument("Can't fuse elementwise ops on ",
+                                     DataTypeString(dtype_));
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,110 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_ELEMENTWISE_FUSION_H_
+
+#include <optional>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// Computes a sequence of elementwise ops, each of which reads inputs of the
+// sequence or outputs of earlier ops in it, in a single pass over blocks of
+// their elements. Async EagerExecutors use this to run consecutive eager
+// elementwise ops together (see AsyncExecuteNode::RunFused), which saves
+// dispatching a kernel per op and re-reading the intermediate results.
+//
+// All the values have the same dtype. Values that aren't scalars must all have
+// the same shape, and scalars are broadcast to it.
+class ElementwiseFusion {
+ public:
+  // An input of the fusion or the output of one of its ops.
+  using Value = int;
+
+  // Returns true if ops of type `op_type` on values of `dtype` can be fused.
+  static bool IsFusible(absl::string_view op_type, DataType dtype);
+
+  explicit ElementwiseFusion(DataType dtype) : dtype_(dtype) {}
+
+  // Adds `tensor` as an input of the fusion.
+  Value AddInput(const Tensor& tensor);
+
+  // Appends an op of type `op_type` that computes from `operands` and returns
+  // its output, or nullopt if the op can't be fused with the previous ones,
+  // e.g. because its operands have different shapes.
+  std::optional<Value> AddOp(absl::string_view op_type,
+                             absl::Span<const Value> operands);
+
+  int num_ops() const { return ops_.size(); }
+
+  // Sets `outputs` to the outputs of the ops, in order, allocated with
+  // `allocator`.
+  Status Evaluate(Allocator* allocator, std::vector<Tensor>* outputs) const;
+
+ private:
+  enum class OpKind {
+    kAdd,
+    kSub,
+    kMul,
+    kMaximum,
+    kMinimum,
+    kNeg,
+    kAbs,
+    kSquare,
+    kRelu,
+  };
+
+  struct Op {
+    OpKind kind;
+    Value operands[2];
+    int num_operands;
+    Value output;
+  };
+
+  struct ValueInfo {
+    TensorShape shape;
+    // The tensor of an input, or the index of the op computing the value.
+    Tensor input;
+    int op = -1;
+  };
+
+  static std::optional<OpKind> GetOpKind(absl::string_view op_type,
+                                         int* num_operands);
+
+  template <typename T>
+  void EvaluateOps(bool scalar_ops, absl::Span<T* const> data, int64_t begin,
+                   int64_t size) const;
+
+  template <typename T>
+  Status EvaluateAs(Allocator* allocator, std::vector<Tensor>* outputs) const;
+
+  const DataType dtype_;
+  std::vector<ValueInfo> values_;
+  std::vector<Op> ops_;
+  // The shape of the values that aren't scalars, once one was added.
+  std::optional<TensorShape> shape_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_ELEMENTWISE_FUSION_H_
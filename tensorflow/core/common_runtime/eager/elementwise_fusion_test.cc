@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/elementwise_fusion.h"
+
+#include <optional>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ElementwiseFusionTest, IsFusible) {
+  EXPECT_TRUE(ElementwiseFusion::IsFusible("AddV2", DT_FLOAT));
+  EXPECT_TRUE(ElementwiseFusion::IsFusible("Relu", DT_DOUBLE));
+  EXPECT_FALSE(ElementwiseFusion::IsFusible("AddV2", DT_INT32));
+  EXPECT_FALSE(ElementwiseFusion::IsFusible("MatMul", DT_FLOAT));
+}
+
+TEST(ElementwiseFusionTest, ComputesChainWithBroadcastScalars) {
+  ElementwiseFusion fusion(DT_FLOAT);
+  auto x = fusion.AddInput(
+      test::AsTensor<float>({-1, 2, -3, 4}, TensorShape({2, 2})));
+  auto two = fusion.AddInput(test::AsScalar<float>(2));
+  auto one = fusion.AddInput(test::AsScalar<float>(1));
+
+  // relu(x * 2 + (2 - 1)), and max(-x, 2).
+  std::optional<ElementwiseFusion::Value> mul = fusion.AddOp("Mul", {x, two});
+  ASSERT_TRUE(mul.has_value());
+  std::optional<ElementwiseFusion::Value> sub = fusion.AddOp("Sub", {two, one});
+  ASSERT_TRUE(sub.has_value());
+  std::optional<ElementwiseFusion::Value> add =
+      fusion.AddOp("AddV2", {*mul, *sub});
+  ASSERT_TRUE(add.has_value());
+  ASSERT_TRUE(fusion.AddOp("Relu", {*add}).has_value());
+  std::optional<ElementwiseFusion::Value> neg = fusion.AddOp("Neg", {x});
+  ASSERT_TRUE(neg.has_value());
+  ASSERT_TRUE(fusion.AddOp("Maximum", {*neg, two}).has_value());
+  EXPECT_EQ(fusion.num_ops(), 6);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(fusion.Evaluate(cpu_allocator(), &outputs));
+  ASSERT_EQ(outputs.size(), 6);
+  test::ExpectTensorEqual<float>(
+      outputs[0], test::AsTensor<float>({-2, 4, -6, 8}, TensorShape({2, 2})));
+  test::ExpectTensorEqual<float>(outputs[1], test::AsScalar<float>(1));
+  test::ExpectTensorEqual<float>(
+      outputs[3], test::AsTensor<float>({0, 5, 0, 9}, TensorShape({2, 2})));
+  test::ExpectTensorEqual<float>(
+      outputs[5], test::AsTensor<float>({2, 2, 3, 2}, TensorShape({2, 2})));
+}
+
+TEST(ElementwiseFusionTest, ComputesValuesLargerThanABlock) {
+  const int size = 3000;
+  std::vector<double> values(size);
+  std::vector<double> expected(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = i - 1500;
+    expected[i] = values[i] * values[i] - values[i];
+  }
+  ElementwiseFusion fusion(DT_DOUBLE);
+  auto x =
+      fusion.AddInput(test::AsTensor<double>(values, TensorShape({size})));
+  std::optional<ElementwiseFusion::Value> square = fusion.AddOp("Square", {x});
+  ASSERT_TRUE(square.has_value());
+  ASSERT_TRUE(fusion.AddOp("Sub", {*square, x}).has_value());
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(fusion.Evaluate(cpu_allocator(), &outputs));
+  test::ExpectTensorEqual<double>(
+      outputs[1], test::AsTensor<double>(expected, TensorShape({size})));
+}
+
+TEST(ElementwiseFusionTest, DoesNotFuseOpsOnOtherShapesOrDtypes) {
+  ElementwiseFusion fusion(DT_FLOAT);
+  auto x = fusion.AddInput(test::AsTensor<float>({1, 2}, TensorShape({2})));
+  auto y = fusion.AddInput(test::AsTensor<float>({1, 2, 3}, TensorShape({3})));
+  auto z = fusion.AddInput(test::AsTensor<int32>({1, 2}, TensorShape({2})));
+  ASSERT_TRUE(fusion.AddOp("Abs", {x}).has_value());
+  EXPECT_FALSE(fusion.AddOp("Abs", {y}).has_value());
+  EXPECT_FALSE(fusion.AddOp("Mul", {x, y}).has_value());
+  EXPECT_FALSE(fusion.AddOp("Mul", {x, z}).has_value());
+  EXPECT_FALSE(fusion.AddOp("Mul", {x}).has_value());
+  EXPECT_FALSE(fusion.AddOp("Tanh", {x}).has_value());
+  EXPECT_EQ(fusion.num_ops(), 1);
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(fusion.Evaluate(cpu_allocator(), &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<float>(outputs[0],
+                                 test::AsTensor<float>({1, 2}, {2}));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -1338,6 +1338,22 @@ Fprint128 GetDeviceCacheKey(EagerOperation* op, const EagerContext& ctx) {
   return device_cache_key;
 }
 
+// Checks that `kernel` has at most `*num_retvals` outputs, sets `*num_retvals`
+// to their number and passes `kernel` to `out_kernel`.
+Status SetOutKernel(core::RefCountPtr<KernelAndDevice> kernel,
+                    int* num_retvals,
+                    core::RefCountPtr<KernelAndDevice>* out_kernel) {
+  int num_outputs = kernel->num_outputs();
+  if (num_outputs > *num_retvals) {
+    return errors::InvalidArgument("Expecting ", num_outputs,
+                                   " outputs, but *num_retvals is ",
+                                   *num_retvals);
+  }
+  *num_retvals = num_outputs;
+  *out_kernel = std::move(kernel);
+  return absl::OkStatus();
+}
+
 Status GetOrCreateKernelAndDevice(
     EagerOperation* op, TensorHandle** retvals, int* num_retvals,
     core::RefCountPtr<KernelAndDevice>* out_kernel) {
@@ -1363,6 +1379,36 @@ Status GetOrCreateKernelAndDevice(
     op->UpdateName(summary_optimizer::StrippedFunctionName(op->Name()));
   }
 
+  // The kernel cache key of a primitive op that isn't run as a function only
+  // depends on its attributes, its device and the soft placement policy, so
+  // the kernel of a repeated execution can be found without computing it.
+  const bool use_inline_kernel_cache =
+      !op->is_function() && !ctx.RunEagerOpAsFunction();
+  Device* const requested_device = device;
+  const bool allow_soft_placement = ctx.AllowSoftPlacement();
+  string requested_device_name;
+  int64_t kernel_cache_generation = 0;
+  if (use_inline_kernel_cache) {
+    const InlineKernelCache::Entry* entry =
+        op->MutableInlineKernelCache()->Find(*op->MutableAttrs(),
+                                             op->DeviceName(), device,
+                                             allow_soft_placement);
+    if (entry != nullptr) {
+      core::RefCountPtr<KernelAndDevice> kernel =
+          ctx.RefCachedKernel(entry->kernel, entry->kernel_cache_generation);
+      if (kernel != nullptr) {
+        if (device == nullptr) {
+          op->SetDevice(entry->device);
+        }
+        return SetOutKernel(std::move(kernel), num_retvals, out_kernel);
+      }
+    }
+    requested_device_name = op->DeviceName();
+    // Read before the lookups below, so that kernels removed after them are
+    // not found in the inline cache.
+    kernel_cache_generation = ctx.KernelCacheGeneration();
+  }
+
   // Set the EagerOperation's device prior to extracting the input_device_ptrs
   // to avoid any redundant H2D/D2H copies.
   if (device == nullptr && !op->is_function()) {
@@ -1403,6 +1449,7 @@ Status GetOrCreateKernelAndDevice(
                         input_resource_variable_dtypes_and_shapes,
                         reuse_rendezvous_for_functions));
   core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  bool kernel_is_cached = kernel != nullptr;
   AbstractOperationPtr wrapped_op_releaser;
   // We can eliminate some overhead by running simple functions using regular
   // CallOp kernel. However, it is tricky to figure out which functions should
@@ -1580,20 +1627,16 @@ Status GetOrCreateKernelAndDevice(
       // If the kernel is already in the cache, this discards the passed-in
       // kernel and returns the cached kernel.
       kernel = ctx.AddKernelToCache(cache_key, std::move(kernel));
+      kernel_is_cached = true;
     }
   }
 
-  int num_outputs = kernel->num_outputs();
-  if (num_outputs > *num_retvals) {
-    return errors::InvalidArgument("Expecting ", num_outputs,
-                                   " outputs, but *num_retvals is ",
-                                   *num_retvals);
+  if (use_inline_kernel_cache && kernel_is_cached) {
+    op->MutableInlineKernelCache()->Add(
+        *op->MutableAttrs(), requested_device_name, requested_device,
+        allow_soft_placement, device, kernel.get(), kernel_cache_generation);
   }
-  *num_retvals = num_outputs;
-
-  kernel->Ref();  // Ownership of reference is passed to out_kernel.
-  out_kernel->reset(kernel.get());
-  return absl::OkStatus();
+  return SetOutKernel(std::move(kernel), num_retvals, out_kernel);
 }
 
 Status CreateUnshapedOutput(
@@ -14,8 +14,17 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "xla/tsl/util/env_var.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/elementwise_fusion.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -143,4 +152,92 @@ Status ExecuteNodeArgs::GetLocalArg(const FunctionArgIndex& index,
   }
 }
 
+DataType AsyncExecuteNode::FusibleDtype() const {
+  const OpKernel* op_kernel = kernel_->kernel();
+  Device* device = kernel_->device();
+  if (op_kernel == nullptr || device == nullptr ||
+      device->device_type() != DEVICE_CPU || graph_collector_ != nullptr ||
+      cancellation_manager_ != nullptr || eager_func_params_.has_value() ||
+      kernel_->num_outputs() != 1 || retvals_.size() != 1) {
+    return DT_INVALID;
+  }
+  const DataType dtype = kernel_->output_dtypes()[0];
+  for (DataType input_dtype : kernel_->input_dtypes()) {
+    if (input_dtype != dtype) return DT_INVALID;
+  }
+  return ElementwiseFusion::IsFusible(op_kernel->type_string(), dtype)
+             ? dtype
+             : DT_INVALID;
+}
+
+Status AsyncExecuteNode::RunFused(absl::Span<EagerNode* const> next_nodes,
+                                  int* num_fused) {
+  *num_fused = 0;
+  const DataType dtype = FusibleDtype();
+  if (dtype == DT_INVALID || next_nodes.empty()) {
+    return Run();
+  }
+
+  // Adds the nodes to the fusion until one can't be fused, e.g. because it
+  // isn't elementwise or because its inputs have another shape.
+  ElementwiseFusion fusion(dtype);
+  std::vector<AsyncExecuteNode*> nodes;
+  absl::flat_hash_map<TensorHandle*, ElementwiseFusion::Value> fused_outputs;
+  for (int i = -1; i < static_cast<int>(next_nodes.size()); ++i) {
+    AsyncExecuteNode* node =
+        i < 0 ? this : next_nodes[i]->AsAsyncExecuteNode();
+    if (node == nullptr || node->FusibleDtype() != dtype ||
+        node->kernel_->device() != kernel_->device()) {
+      break;
+    }
+    absl::InlinedVector<ElementwiseFusion::Value, 2> operands;
+    for (int j = 0; j < node->inputs_.size(); ++j) {
+      TensorHandle* input = node->inputs_[j];
+      auto it = fused_outputs.find(input);
+      if (it != fused_outputs.end()) {
+        operands.push_back(it->second);
+        continue;
+      }
+      // This waits for inputs computed by earlier async nodes.
+      const Tensor* tensor = nullptr;
+      if (input->Type() != TensorHandle::LOCAL ||
+          !input
+               ->TensorFromDevice(
+                   ctx_->CanonicalDevice(node->kernel_->InputDevice(j)),
+                   &tensor)
+               .ok()) {
+        break;
+      }
+      operands.push_back(fusion.AddInput(*tensor));
+    }
+    if (operands.size() != node->inputs_.size()) break;
+    std::optional<ElementwiseFusion::Value> output =
+        fusion.AddOp(node->kernel_->kernel()->type_string(), operands);
+    if (!output.has_value()) break;
+    fused_outputs[node->retvals_[0]] = *output;
+    nodes.push_back(node);
+  }
+  if (nodes.size() < 2) {
+    return Run();
+  }
+
+  VLOG(3) << "Running " << nodes.size() << " elementwise ops fused";
+  std::vector<Tensor> outputs;
+  Status status = fusion.Evaluate(
+      kernel_->device()->GetAllocator(AllocatorAttributes()), &outputs);
+  *num_fused = nodes.size() - 1;
+  if (!status.ok()) {
+    // The executor aborts the other nodes.
+    Abort(status);
+    return status;
+  }
+  for (int i = 0; i < nodes.size(); ++i) {
+    AsyncExecuteNode* node = nodes[i];
+    TF_RETURN_IF_ERROR(node->retvals_[0]->SetTensor(
+        std::move(outputs[i]),
+        ctx_->CanonicalDevice(node->kernel_->OutputDevice(0))));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace tensorflow
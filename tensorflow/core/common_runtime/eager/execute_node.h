@@ -219,6 +219,14 @@ class AsyncExecuteNode : public EagerNode {
     return absl::OkStatus();
   }
 
+  // Runs this node together with the next nodes if they are all elementwise
+  // ops on the same CPU device, which are then computed by an
+  // ElementwiseFusion.
+  Status RunFused(absl::Span<EagerNode* const> next_nodes,
+                  int* num_fused) override;
+
+  AsyncExecuteNode* AsAsyncExecuteNode() override { return this; }
+
   void Abort(Status status) override {
     int i = 0;
     for (auto handle : retvals_) {
@@ -234,6 +242,10 @@ class AsyncExecuteNode : public EagerNode {
   }
 
  private:
+  // Returns the dtype of the elementwise op this node runs if it can be fused,
+  // or DT_INVALID.
+  DataType FusibleDtype() const;
+
   EagerContext* ctx_;
   absl::InlinedVector<TensorHandle*, 4> inputs_;
   const absl::optional<EagerFunctionParams> eager_func_params_;
@@ -15,41 +15,144 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/shape_inference.h"
 
+#include <algorithm>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 namespace eager {
+namespace {
+
+// The number of op signatures whose output shapes are remembered. The cache is
+// cleared when it is full, so that programs whose shapes change over time
+// don't keep the shapes of the ops they no longer run.
+constexpr int kMaxShapeCacheEntries = 4096;
+
+// Remembers the output shapes inferred for ops, keyed by the op, its attrs and
+// its input shapes. Shape functions only see those (RunShapeInference doesn't
+// give them input tensors), so a hit is exactly what running the shape function
+// again would compute, without building an InferenceContext for it.
+class ShapeInferenceCache {
+ public:
+  static ShapeInferenceCache* Global() {
+    static ShapeInferenceCache* cache = new ShapeInferenceCache();
+    return cache;
+  }
+
+  bool Lookup(const Fprint128& key, std::vector<PartialTensorShape>* outputs) {
+    tf_shared_lock l(mu_);
+    auto it = outputs_.find(key);
+    if (it == outputs_.end()) return false;
+    *outputs = it->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key, std::vector<PartialTensorShape> outputs) {
+    mutex_lock l(mu_);
+    if (outputs_.size() >= kMaxShapeCacheEntries) outputs_.clear();
+    outputs_.emplace(key, std::move(outputs));
+  }
+
+ private:
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::vector<PartialTensorShape>,
+                      Fprint128Hasher>
+      outputs_ TF_GUARDED_BY(mu_);
+};
+
+Status GetShapeCacheKey(const NodeDef& ndef,
+                        const std::vector<PartialTensorShape>& input_shapes,
+                        Fprint128* key) {
+  std::string signature = ndef.op();
+  // The attr map of the NodeDef has no defined iteration order.
+  std::vector<const std::pair<const std::string, AttrValue>*> attrs;
+  attrs.reserve(ndef.attr_size());
+  for (const auto& attr : ndef.attr()) attrs.push_back(&attr);
+  std::sort(attrs.begin(), attrs.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  std::string serialized;
+  for (const auto* attr : attrs) {
+    if (!SerializeToStringDeterministic(attr->second, &serialized)) {
+      return errors::Internal("Failed to serialize attr ", attr->first,
+                              " of ", ndef.op());
+    }
+    absl::StrAppend(&signature, ";", attr->first, ":", serialized.size(), ":",
+                    serialized);
+  }
+  for (const PartialTensorShape& shape : input_shapes) {
+    absl::StrAppend(&signature, ";", shape.DebugString());
+  }
+  *key = Fingerprint128(signature);
+  return absl::OkStatus();
+}
+
+}  // namespace
 
 Status RunShapeInference(const NodeDef& ndef,
                          const FunctionLibraryDefinition& lib_def,
                          const gtl::InlinedVector<TensorHandle*, 4>& inputs,
                          const gtl::InlinedVector<TensorHandle*, 2>& retvals) {
   const tensorflow::OpRegistrationData* op_reg_data;
-  // TODO(b/141209983): Consider adding a shape inference cache.
   // FunctionLibraryDefinition::LookUp delegates to global OpRegistry
   // if op is not a function.
   TF_RETURN_IF_ERROR(lib_def.LookUp(ndef.op(), &op_reg_data));
   if (op_reg_data->shape_inference_fn == nullptr) return absl::OkStatus();
 
+  std::vector<PartialTensorShape> input_shapes(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    TF_RETURN_IF_ERROR(inputs[i]->InferenceShape(&input_shapes[i]));
+  }
+
+  // Functions of different libraries may share a name, so only the shapes of
+  // primitive ops are cached.
+  const bool use_cache = !op_reg_data->is_function_op;
+  Fprint128 key;
+  std::vector<PartialTensorShape> output_shapes;
+  if (use_cache) {
+    TF_RETURN_IF_ERROR(GetShapeCacheKey(ndef, input_shapes, &key));
+    if (ShapeInferenceCache::Global()->Lookup(key, &output_shapes)) {
+      CHECK_EQ(output_shapes.size(), retvals.size());
+      for (int i = 0; i < output_shapes.size(); i++) {
+        retvals[i]->SetInferenceShape(output_shapes[i]);
+      }
+      return absl::OkStatus();
+    }
+  }
+
   shape_inference::InferenceContext ic(
       TF_GRAPH_DEF_VERSION, ndef, op_reg_data->op_def,
       std::vector<shape_inference::ShapeHandle>(inputs.size()), {}, {}, {});
   for (size_t i = 0; i < inputs.size(); i++) {
     shape_inference::ShapeHandle shape;
-    TF_RETURN_IF_ERROR(inputs[i]->InferenceShape(&ic, &shape));
+    TF_RETURN_IF_ERROR(
+        ic.MakeShapeFromPartialTensorShape(input_shapes[i], &shape));
     ic.SetInput(i, shape);
   }
 
   TF_RETURN_IF_ERROR(ic.Run(op_reg_data->shape_inference_fn));
   CHECK_EQ(ic.num_outputs(), retvals.size());
+  output_shapes.resize(ic.num_outputs());
   for (int i = 0; i < ic.num_outputs(); i++) {
     shape_inference::ShapeHandle shape_handle = ic.output(i);
     retvals[i]->SetInferenceShape(&ic, shape_handle);
+    TF_RETURN_IF_ERROR(retvals[i]->InferenceShape(&output_shapes[i]));
+  }
+  if (use_cache) {
+    ShapeInferenceCache::Global()->Insert(key, std::move(output_shapes));
   }
   // TODO(slebedev): populate TensorHandle::handle_dtypes_and_shapes.
   return absl::OkStatus();
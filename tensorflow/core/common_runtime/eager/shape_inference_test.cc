@@ -0,0 +1,104 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/shape_inference.h"
+
+#include <utility>
+
+#include "absl/cleanup/cleanup.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+class ShapeInferenceTest : public ::testing::Test {
+ protected:
+  ShapeInferenceTest()
+      : device_mgr_(DeviceFactory::NewDevice(
+            "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0")),
+        lib_def_(OpRegistry::Global(), FunctionDefLibrary()) {
+    ctx_ = new EagerContext(
+        SessionOptions(),
+        tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+        false, &device_mgr_, false, nullptr, nullptr, nullptr,
+        /*run_eager_op_as_function=*/true);
+  }
+
+  ~ShapeInferenceTest() override { ctx_->Unref(); }
+
+  // Infers the output shape of a MatMul of two float matrices of the given
+  // shapes.
+  PartialTensorShape InferMatMulShape(const TensorShape& a_shape,
+                                      const TensorShape& b_shape,
+                                      bool transpose_a) {
+    NodeDef ndef;
+    ndef.set_op("MatMul");
+    AddNodeAttr("T", DT_FLOAT, &ndef);
+    AddNodeAttr("transpose_a", transpose_a, &ndef);
+    AddNodeAttr("transpose_b", false, &ndef);
+
+    TensorHandle* a = TensorHandle::CreateLocalHandle(
+        Tensor(DT_FLOAT, a_shape), nullptr, nullptr, ctx_);
+    absl::Cleanup a_cleanup = [&]() { a->Unref(); };
+    TensorHandle* b = TensorHandle::CreateLocalHandle(
+        Tensor(DT_FLOAT, b_shape), nullptr, nullptr, ctx_);
+    absl::Cleanup b_cleanup = [&]() { b->Unref(); };
+    TensorHandle* retval = TensorHandle::CreateEmptyLocalHandle(
+        nullptr, nullptr, nullptr, DT_FLOAT, ctx_);
+    absl::Cleanup retval_cleanup = [&]() { retval->Unref(); };
+
+    TF_EXPECT_OK(RunShapeInference(ndef, lib_def_, {a, b}, {retval}));
+    PartialTensorShape shape;
+    TF_EXPECT_OK(retval->InferenceShape(&shape));
+    return shape;
+  }
+
+  StaticDeviceMgr device_mgr_;
+  FunctionLibraryDefinition lib_def_;
+  EagerContext* ctx_;
+};
+
+TEST_F(ShapeInferenceTest, InfersOutputShapes) {
+  PartialTensorShape shape =
+      InferMatMulShape({2, 3}, {3, 4}, /*transpose_a=*/false);
+  EXPECT_TRUE(shape.IsIdenticalTo(PartialTensorShape({2, 4})));
+}
+
+TEST_F(ShapeInferenceTest, CachedShapesDependOnInputShapesAndAttrs) {
+  // The second inference of each signature comes from the cache.
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(InferMatMulShape({2, 3}, {3, 4}, /*transpose_a=*/false)
+                    .IsIdenticalTo(PartialTensorShape({2, 4})));
+    EXPECT_TRUE(InferMatMulShape({5, 3}, {3, 4}, /*transpose_a=*/false)
+                    .IsIdenticalTo(PartialTensorShape({5, 4})));
+    EXPECT_TRUE(InferMatMulShape({3, 2}, {3, 4}, /*transpose_a=*/true)
+                    .IsIdenticalTo(PartialTensorShape({2, 4})));
+  }
+}
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
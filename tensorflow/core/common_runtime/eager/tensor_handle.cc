@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
@@ -66,8 +67,69 @@ string SafeDeviceDebugString(Device* device) {
   }
 }
 
+// Keeps the memory of TensorHandles deleted on a thread for the next ones
+// created on it. Handles are often deleted on another thread than the one
+// which created them, e.g. in async mode, and each thread caches the memory it
+// freed.
+class TensorHandleMemoryCache {
+ public:
+  ~TensorHandleMemoryCache() {
+    destroyed_ = true;
+    for (void* block : blocks_) {
+      ::operator delete(block);
+    }
+  }
+
+  // Returns the cache of the calling thread, or nullptr if it was destroyed
+  // because the thread is exiting.
+  static TensorHandleMemoryCache* Get() {
+    if (destroyed_) return nullptr;
+    thread_local TensorHandleMemoryCache cache;
+    return &cache;
+  }
+
+  void* Allocate() {
+    if (blocks_.empty()) return nullptr;
+    void* block = blocks_.back();
+    blocks_.pop_back();
+    return block;
+  }
+
+  bool Deallocate(void* block) {
+    if (blocks_.size() >= kMaxBlocks) return false;
+    blocks_.push_back(block);
+    return true;
+  }
+
+ private:
+  static constexpr int kMaxBlocks = 256;
+  // Trivially destructible, so that it can be read at any time on the thread.
+  static thread_local bool destroyed_;
+
+  std::vector<void*> blocks_;
+};
+
+thread_local bool TensorHandleMemoryCache::destroyed_ = false;
+
 }  // namespace
 
+void* TensorHandle::operator new(size_t size) {
+  if (size == sizeof(TensorHandle)) {
+    TensorHandleMemoryCache* cache = TensorHandleMemoryCache::Get();
+    void* block = cache == nullptr ? nullptr : cache->Allocate();
+    if (block != nullptr) return block;
+  }
+  return ::operator new(size);
+}
+
+void TensorHandle::operator delete(void* ptr, size_t size) {
+  if (size == sizeof(TensorHandle)) {
+    TensorHandleMemoryCache* cache = TensorHandleMemoryCache::Get();
+    if (cache != nullptr && cache->Deallocate(ptr)) return;
+  }
+  ::operator delete(ptr);
+}
+
 TensorHandle::PackedTensorHandleData::PackedTensorHandleData(
     std::vector<TensorHandle*>&& handles, const TensorShape& shape)
     : handles_(std::move(handles)), shape_(shape) {
@@ -591,6 +653,21 @@ void TensorHandle::SetInferenceShape(
   TF_DCHECK_OK(s);
 }
 
+Status TensorHandle::InferenceShape(PartialTensorShape* shape) {
+  if (!IsReady()) {
+    *shape = inference_shape_;
+    return absl::OkStatus();
+  }
+  TensorShape tensor_shape;
+  TF_RETURN_IF_ERROR(Shape(&tensor_shape));
+  *shape = tensor_shape;
+  return absl::OkStatus();
+}
+
+void TensorHandle::SetInferenceShape(const PartialTensorShape& shape) {
+  inference_shape_ = shape;
+}
+
 Status TensorHandle::CopyInferenceShape(TensorHandle* other) {
   if (IsReady()) {
     return absl::OkStatus();
@@ -1012,56 +1089,85 @@ void TensorHandle::Poison(Status status, const Device* d) {
 Status TensorHandle::CopyToDevice(const EagerContext& ctx,
                                   tensorflow::Device* d,
                                   tensorflow::Tensor* output) const {
+  std::vector<tensorflow::Tensor> outputs;
+  TF_RETURN_IF_ERROR(BatchCopyToDevice(ctx, {this}, d, &outputs));
+  *output = std::move(outputs[0]);
+  return absl::OkStatus();
+}
+
+Status TensorHandle::BatchCopyToDevice(
+    const EagerContext& ctx, absl::Span<const TensorHandle* const> handles,
+    tensorflow::Device* d, std::vector<tensorflow::Tensor>* outputs) {
   tensorflow::Device* dstd = (d == nullptr) ? ctx.HostCPU() : d;
-  tensorflow::Device* srcd = DeviceOrHostCPU(ctx);
   const bool dst_cpu = dstd->tensorflow_accelerator_device_info() == nullptr;
-  const bool src_cpu = srcd->tensorflow_accelerator_device_info() == nullptr;
-  bool is_same_device =
-      (srcd == dstd) || (srcd->name() == dstd->name()) || (dst_cpu && src_cpu);
-
-  const tensorflow::Tensor* src = nullptr;
-  TF_RETURN_IF_ERROR(Tensor(&src));
-  if (is_same_device) {
-    *output = *src;
-    return absl::OkStatus();
-  }
-  if (!dst_cpu && (src->dtype() != tensorflow::DT_VARIANT &&
-                   !tensorflow::DataTypeCanUseMemcpy(src->dtype()))) {
-    return tensorflow::errors::InvalidArgument(
-        "Can't copy Tensor with type ",
-        tensorflow::DataTypeString(src->dtype()), " to device ", dstd->name(),
-        ".");
-  }
-  tensorflow::AllocatorAttributes attr;
-  if (src->dtype() == tensorflow::DT_VARIANT) {
-    attr.set_on_host(true);
-  }
   const auto* dstd_info = dstd->tensorflow_accelerator_device_info();
-  tensorflow::Tensor dst(dstd->GetAllocator(attr), src->dtype(), src->shape());
-  if (src->shape().num_elements() == 0) {
-    *output = dst;
-    return absl::OkStatus();
-  }
-  tensorflow::DeviceContext* src_device_context = nullptr;
-  if (!src_cpu) {
-    src_device_context =
-        srcd->tensorflow_accelerator_device_info()->default_context;
-  }
-  tensorflow::DeviceContext* dst_device_context = nullptr;
-  if (!dst_cpu) {
-    // PJRT will soon pack int4 tensors when transferring them to device (once
-    // XLA int4 support is implemented), but TF currently represents int4 as
-    // unpacked, so do not use PJRT for int4 tensors.
-    // TODO(b/226482736): Either pack int4, or support unpacked int4 tensors in
-    // PJRT. Also update beginning of comment from future to present tense once
-    // PJRT packs int4 tensors.
-    if (dstd_info->use_pjrt_tensor_buffer && DataType() != DT_INT4 &&
-        DataType() != DT_UINT4) {
-      dst_device_context = dstd_info->pjrt_context;
-    } else {
-      dst_device_context = dstd_info->default_context;
+
+  // The copies that go through CopyTensor::ViaDMA.
+  struct DmaCopy {
+    int index;
+    const tensorflow::Tensor* src;
+    tensorflow::Device* srcd;
+    tensorflow::DeviceContext* src_device_context;
+    tensorflow::DeviceContext* dst_device_context;
+  };
+  std::vector<DmaCopy> copies;
+  outputs->clear();
+  outputs->resize(handles.size());
+  for (int i = 0; i < handles.size(); ++i) {
+    const TensorHandle* handle = handles[i];
+    tensorflow::Device* srcd = handle->DeviceOrHostCPU(ctx);
+    const bool src_cpu = srcd->tensorflow_accelerator_device_info() == nullptr;
+    bool is_same_device = (srcd == dstd) || (srcd->name() == dstd->name()) ||
+                          (dst_cpu && src_cpu);
+
+    const tensorflow::Tensor* src = nullptr;
+    TF_RETURN_IF_ERROR(handle->Tensor(&src));
+    if (is_same_device) {
+      (*outputs)[i] = *src;
+      continue;
+    }
+    if (!dst_cpu && (src->dtype() != tensorflow::DT_VARIANT &&
+                     !tensorflow::DataTypeCanUseMemcpy(src->dtype()))) {
+      return tensorflow::errors::InvalidArgument(
+          "Can't copy Tensor with type ",
+          tensorflow::DataTypeString(src->dtype()), " to device ",
+          dstd->name(), ".");
     }
+    tensorflow::AllocatorAttributes attr;
+    if (src->dtype() == tensorflow::DT_VARIANT) {
+      attr.set_on_host(true);
+    }
+    (*outputs)[i] = tensorflow::Tensor(dstd->GetAllocator(attr), src->dtype(),
+                                       src->shape());
+    if (src->shape().num_elements() == 0) {
+      continue;
+    }
+    tensorflow::DeviceContext* src_device_context = nullptr;
+    if (!src_cpu) {
+      src_device_context =
+          srcd->tensorflow_accelerator_device_info()->default_context;
+    }
+    tensorflow::DeviceContext* dst_device_context = nullptr;
+    if (!dst_cpu) {
+      // PJRT will soon pack int4 tensors when transferring them to device
+      // (once XLA int4 support is implemented), but TF currently represents
+      // int4 as unpacked, so do not use PJRT for int4 tensors.
+      // TODO(b/226482736): Either pack int4, or support unpacked int4 tensors
+      // in PJRT. Also update beginning of comment from future to present tense
+      // once PJRT packs int4 tensors.
+      if (dstd_info->use_pjrt_tensor_buffer &&
+          handle->DataType() != DT_INT4 && handle->DataType() != DT_UINT4) {
+        dst_device_context = dstd_info->pjrt_context;
+      } else {
+        dst_device_context = dstd_info->default_context;
+      }
+    }
+    copies.push_back({i, src, srcd, src_device_context, dst_device_context});
+  }
+  if (copies.empty()) {
+    return absl::OkStatus();
   }
+
   // TODO(ashankar): The Sync() call below may be more aggressive than
   // necessary. It is based on knowledge of implementation details - that
   // GPU devices are implemented using 3 streams - one for host->device copies,
@@ -1069,22 +1175,36 @@ Status TensorHandle::CopyToDevice(const EagerContext& ctx,
   // With that setup, Sync()ing across all 3 streams should be sufficient
   // but more than necessary (since it waits for operations that might have
   // nothing to do with this tensor to complete).
-  TF_RETURN_IF_ERROR(srcd->Sync());
-  tensorflow::Notification n;
-  tensorflow::Status status;
-  tensorflow::CopyTensor::ViaDMA("copy", src_device_context, dst_device_context,
-                                 srcd, dstd, tensorflow::AllocatorAttributes(),
-                                 tensorflow::AllocatorAttributes(), src, &dst,
-                                 0 /*dev_to_dev_stream_index*/,
-                                 [&status, &n](const tensorflow::Status& s) {
-                                   status = s;
-                                   n.Notify();
-                                 });
-  n.WaitForNotification();
-  if (status.ok()) {
-    *output = dst;
-    return absl::OkStatus();
+  // Each source device is synced once, and all the copies are issued before
+  // waiting for any of them, so that they share the latency of the sync and
+  // of the transfers.
+  std::vector<tensorflow::Device*> synced_devices;
+  for (const DmaCopy& copy : copies) {
+    if (std::find(synced_devices.begin(), synced_devices.end(), copy.srcd) !=
+        synced_devices.end()) {
+      continue;
+    }
+    TF_RETURN_IF_ERROR(copy.srcd->Sync());
+    synced_devices.push_back(copy.srcd);
   }
+  tensorflow::BlockingCounter counter(copies.size());
+  tensorflow::mutex mu;
+  tensorflow::Status status;
+  for (const DmaCopy& copy : copies) {
+    tensorflow::CopyTensor::ViaDMA(
+        "copy", copy.src_device_context, copy.dst_device_context, copy.srcd,
+        dstd, tensorflow::AllocatorAttributes(),
+        tensorflow::AllocatorAttributes(), copy.src, &(*outputs)[copy.index],
+        0 /*dev_to_dev_stream_index*/,
+        [&status, &mu, &counter](const tensorflow::Status& s) {
+          {
+            tensorflow::mutex_lock l(mu);
+            status.Update(s);
+          }
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
   return status;
 }
 
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/platform.h"
 // clang-format on
 
+#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "tensorflow/c/eager/immediate_execution_tensor_handle.h"
 #include "tensorflow/core/common_runtime/device.h"
@@ -123,6 +124,11 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
                                               EagerContext* ctx);
 #endif  // IS_MOBILE_PLATFORM
 
+  // Every eager op creates a TensorHandle per output, so their memory is
+  // reused from a small cache per thread instead of the heap when possible.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   // Templated struct `AutoReleaser` in
   // core/runtime_fallback/runtime/kernel_utils.h needs a Release() method
   // defined.
@@ -239,12 +245,24 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // Copies to the tensor on the given device `d`, or to host iff `d` is null.
   Status CopyToDevice(const EagerContext& ctx, tensorflow::Device* d,
                       tensorflow::Tensor* output) const;
+  // Like CopyToDevice, for several handles at once. Sets `outputs` to their
+  // copies in order. All the transfers are started before waiting for any of
+  // them, so that copying many small tensors doesn't pay the latency of a
+  // device sync and of a transfer for each.
+  static Status BatchCopyToDevice(
+      const EagerContext& ctx, absl::Span<const TensorHandle* const> handles,
+      tensorflow::Device* d, std::vector<tensorflow::Tensor>* outputs);
 
   Status InferenceShape(shape_inference::InferenceContext* inference_context,
                         shape_inference::ShapeHandle* shape_handle);
   void SetInferenceShape(shape_inference::InferenceContext* inference_context,
                          const shape_inference::ShapeHandle& shape_handle);
   Status CopyInferenceShape(TensorHandle* other);
+  // Like the above, without an InferenceContext. Unlike Shape(), these never
+  // wait for the handle to be ready: the shape is unknown if neither the
+  // tensor nor an inferred shape is available yet.
+  Status InferenceShape(PartialTensorShape* shape);
+  void SetInferenceShape(const PartialTensorShape& shape);
 
   // dtype for the handle. It must be the same as t.dtype() once the handle is
   // ready.
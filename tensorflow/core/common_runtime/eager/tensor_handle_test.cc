@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
@@ -297,6 +298,53 @@ TEST_F(PackedTensorHandleTest, PoisonHandle) {
                        std::string(fake_failure_status.message())));
 }
 
+TEST(TensorHandle_MemoryTest, ReusesMemoryOfDeletedHandles) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr, nullptr,
+      /*run_eager_op_as_function=*/true);
+  absl::Cleanup ctx_cleanup = [&]() { ctx->Unref(); };
+
+  TensorHandle* first = TensorHandle::CreateLocalHandle(
+      Tensor(DT_FLOAT, TensorShape({2})), nullptr, nullptr, ctx);
+  const void* first_memory = first;
+  first->Unref();
+  TensorHandle* second = TensorHandle::CreateEmptyLocalHandle(
+      nullptr, nullptr, nullptr, DT_FLOAT, ctx);
+  EXPECT_EQ(static_cast<const void*>(second), first_memory);
+  second->Unref();
+}
+
+TEST(TensorHandle_CopyTest, BatchCopyToDevice) {
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr, nullptr,
+      /*run_eager_op_as_function=*/true);
+  absl::Cleanup ctx_cleanup = [&]() { ctx->Unref(); };
+
+  Tensor t0(DT_FLOAT, TensorShape({2}));
+  t0.flat<float>().setConstant(1.0f);
+  Tensor t1(DT_INT32, TensorShape({3, 1}));
+  t1.flat<int32>().setConstant(2);
+  TensorHandle* h0 = TensorHandle::CreateLocalHandle(t0, nullptr, nullptr, ctx);
+  absl::Cleanup h0_cleanup = [&]() { h0->Unref(); };
+  TensorHandle* h1 = TensorHandle::CreateLocalHandle(t1, nullptr, nullptr, ctx);
+  absl::Cleanup h1_cleanup = [&]() { h1->Unref(); };
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(
+      TensorHandle::BatchCopyToDevice(*ctx, {h0, h1}, nullptr, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  test::ExpectTensorEqual<float>(outputs[0], t0);
+  test::ExpectTensorEqual<int32>(outputs[1], t1);
+}
+
 TEST(TensorHandle_ResourceDeviceTest, OnLocalDevice) {
   std::unique_ptr<Device> d0(
       CreateDevice("CPU", "/job:localhost/replica:0/task:0/device:CPU:0"));
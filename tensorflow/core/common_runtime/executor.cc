@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -62,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -145,13 +148,25 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Identifies the work-stealing lane that the current thread owns, if it is
+// running as a work-stealing worker for some `ExecutorState`. `owner` is an
+// opaque pointer to the per-step work-stealing state.
+struct WorkStealingLane {
+  const void* owner = nullptr;
+  int lane = -1;
+};
+thread_local WorkStealingLane current_work_stealing_lane;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool work_stealing = false)
+      : immutable_state_(p), work_stealing_(work_stealing) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
-    kernel_stats_.Initialize(immutable_state_.graph_view());
+    kernel_stats_.Initialize(immutable_state_.graph_view(),
+                             immutable_state_.params().adaptive_inlining_steps);
     return absl::OkStatus();
   }
 
@@ -166,7 +181,11 @@ class ExecutorImpl : public Executor {
    public:
     KernelStats() = default;
 
-    void Initialize(const GraphView& gview) {
+    // If `adaptive_steps > 0`, the cost of every synchronous kernel is
+    // measured during the first `adaptive_steps` steps, after which each
+    // measured node is classified as expensive or inexpensive by its mean
+    // cost alone. See `LocalExecutorParams::adaptive_inlining_steps`.
+    void Initialize(const GraphView& gview, int adaptive_steps) {
       is_expensive_.resize(gview.num_nodes());
       cost_estimates_ =
           std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
@@ -177,15 +196,91 @@ class ExecutorImpl : public Executor {
           cost_estimates_[i] = kInitialCostEstimateCycles;
         }
       }
+      if (adaptive_steps > 0) {
+        adaptive_steps_ = adaptive_steps;
+        learned_cycles_ =
+            std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+        learned_samples_ =
+            std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+        for (int32_t i = 0; i < gview.num_nodes(); ++i) {
+          learned_cycles_[i] = 0;
+          learned_samples_[i] = 0;
+        }
+        learning_.store(true, std::memory_order_relaxed);
+      }
+    }
+
+    // Called at the start of each step. In adaptive mode, ends the learning
+    // phase when `adaptive_steps` steps have started.
+    void StartStep(const GraphView& gview) {
+      if (adaptive_steps_ == 0 || adapted_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      // Exactly one step observes the count reaching `adaptive_steps_`.
+      if (num_steps_.fetch_add(1, std::memory_order_relaxed) !=
+          adaptive_steps_) {
+        return;
+      }
+      learning_.store(false, std::memory_order_relaxed);
+      adaptive_expensive_.resize(gview.num_nodes());
+      for (int32_t i = 0; i < gview.num_nodes(); ++i) {
+        const NodeItem* item = gview.node(i);
+        if (item == nullptr) continue;
+        const uint64 samples = learned_samples_[i].load();
+        adaptive_expensive_[i] =
+            samples > 0 ? learned_cycles_[i].load() / samples >
+                              kOpIsExpensiveThresholdCycles
+                        : IsExpensiveStatic(*item);
+      }
+      adapted_.store(true, std::memory_order_release);
+      if (VLOG_IS_ON(1)) {
+        VLOG(1) << "Adaptive inlining decisions after " << adaptive_steps_
+                << " steps:\n"
+                << DebugString(gview);
+      }
     }
 
     // Returns true iff the given node is considered "expensive". The
     // executor uses this flag to optimize graph execution, for example
     // by "inlining" inexpensive kernels.
     bool IsExpensive(const NodeItem& node) const {
-      return is_expensive_[node.node_id] &&
-             (cost_estimates_[node.node_id].load(std::memory_order_relaxed) >
-              kOpIsExpensiveThresholdCycles);
+      if (TF_PREDICT_FALSE(adapted_.load(std::memory_order_acquire))) {
+        return adaptive_expensive_[node.node_id];
+      }
+      return IsExpensiveStatic(node);
+    }
+
+    // Returns true if the cost of each synchronous kernel invocation should
+    // be reported through `RecordLearnedCost()`.
+    bool IsLearning() const {
+      return learning_.load(std::memory_order_relaxed);
+    }
+
+    void RecordLearnedCost(const NodeItem& node, uint64 elapsed_cycles) {
+      learned_cycles_[node.node_id].fetch_add(elapsed_cycles,
+                                              std::memory_order_relaxed);
+      learned_samples_[node.node_id].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns one line per kernel with its measured mean cost and whether it
+    // is currently run inline or scheduled on the thread pool.
+    std::string DebugString(const GraphView& gview) const {
+      std::string result;
+      for (int32_t i = 0; i < gview.num_nodes(); ++i) {
+        const NodeItem* item = gview.node(i);
+        if (item == nullptr || item->kernel == nullptr) continue;
+        const uint64 samples =
+            learned_samples_ ? learned_samples_[i].load() : 0;
+        strings::StrAppend(
+            &result, item->kernel->name(), " (", item->kernel->type_string(),
+            "): ",
+            samples > 0 ? strings::StrCat(learned_cycles_[i].load() / samples,
+                                          " cycles over ", samples, " runs")
+                        : "not measured",
+            ", marked ", is_expensive_[i] ? "expensive" : "inexpensive",
+            ", ", IsExpensive(*item) ? "scheduled" : "inline", "\n");
+      }
+      return result;
     }
 
     // Returns the value of kernel->IsExpensive().
@@ -218,14 +313,36 @@ class ExecutorImpl : public Executor {
     static constexpr uint64 kOpIsExpensiveThresholdCycles = 8000;
     static constexpr uint64 kCostDecay = 10;
 
+    bool IsExpensiveStatic(const NodeItem& node) const {
+      return is_expensive_[node.node_id] &&
+             (cost_estimates_[node.node_id].load(std::memory_order_relaxed) >
+              kOpIsExpensiveThresholdCycles);
+    }
+
     std::vector<bool> is_expensive_;
     // std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+
+    // Adaptive mode. The total measured cycles, and number of measurements,
+    // of each node during the learning phase.
+    int adaptive_steps_ = 0;
+    std::unique_ptr<std::atomic_uint_fast64_t[]> learned_cycles_;
+    std::unique_ptr<std::atomic_uint_fast64_t[]> learned_samples_;
+    std::atomic<int> num_steps_{0};
+    std::atomic<bool> learning_{false};
+    // Set once `adaptive_expensive_` holds the final classification, which
+    // then replaces the static one.
+    std::atomic<bool> adapted_{false};
+    std::vector<bool> adaptive_expensive_;
   };
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // If true, ready nodes are distributed through per-worker deques drained by
+  // a bounded number of worker closures, instead of one closure per node.
+  const bool work_stealing_;
+
   ExecutorImpl(const ExecutorImpl&) = delete;
   void operator=(const ExecutorImpl&) = delete;
 };
@@ -284,7 +401,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                bool work_stealing = false);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -298,6 +416,32 @@ class ExecutorState {
 
   struct AsyncState;
 
+  // A ready node waiting in a work-stealing lane.
+  struct WorkStealingItem {
+    TaggedNode tagged_node;
+    int64_t scheduled_nsec;
+  };
+
+  // State shared between this `ExecutorState` and the worker closures it
+  // schedules when work stealing is enabled. The workers hold a reference,
+  // because `this` may be deleted by the last node to complete while a worker
+  // is still checking the lanes for more work.
+  struct WorkStealingState {
+    explicit WorkStealingState(int num_lanes) : queues(num_lanes) {}
+    ~WorkStealingState() {
+      metrics::RecordExecutorWorkStealing(queues.local_hits(),
+                                          queues.steals());
+    }
+
+    WorkStealingQueues<WorkStealingItem> queues;
+    // Number of worker closures that are scheduled or running. At most
+    // `queues.num_lanes()`.
+    std::atomic<int> num_active_workers{0};
+    // Used to spread pushes from non-worker threads, and worker lane
+    // assignment, across the lanes.
+    std::atomic<int> next_lane{0};
+  };
+
   // Process a ready node in current thread.
   void Process(const TaggedNode& node, int64_t scheduled_nsec);
 
@@ -332,6 +476,29 @@ class ExecutorState {
                 NodeExecStatsInterface* stats,
                 TaggedNodeReadyQueue* inline_ready);
 
+  // Records the end of a node in `stats`, if not null, and deletes it.
+  void NodeStatsDone(NodeExecStatsInterface* stats);
+
+  // An async kernel completion whose outputs have been processed, but not yet
+  // propagated.
+  struct AsyncCompletion {
+    AsyncState* state;
+    EntryVector outputs;
+    Status status;
+  };
+
+  // Propagates the outputs of a completed async kernel and calls `NodeDone()`
+  // for it, taking ownership of `state`. When async completions are batched
+  // and another thread is already propagating completions of this step, the
+  // completion is queued and propagated by that thread instead.
+  void AsyncNodeDone(AsyncState* state, EntryVector* outputs, const Status& s);
+
+  // Propagates the outputs of `*batch`, then schedules all the nodes they make
+  // ready and updates `num_outstanding_ops_` once for the whole batch. The
+  // caller must hold an outstanding op of its own, so that this cannot
+  // complete the step.
+  void PropagateAsyncCompletions(std::vector<AsyncCompletion>* batch);
+
   // Schedule all the expensive nodes in '*ready', and put all the inexpensive
   // nodes in 'ready' into 'inline_ready'.
   //
@@ -340,6 +507,23 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Like the default branch of `ScheduleReady()`, but pushes the nodes that
+  // are not run inline onto the work-stealing lanes.
+  void ScheduleReadyWorkStealing(TaggedNodeSeq* ready,
+                                 TaggedNodeReadyQueue* inline_ready,
+                                 int64_t scheduled_nsec);
+
+  // Schedules up to `num_new_items` additional work-stealing workers, without
+  // exceeding one worker per lane.
+  void MaybeStartWorkStealingWorkers(size_t num_new_items);
+
+  // Body of a work-stealing worker closure. Runs nodes from its own lane and
+  // steals from the others until all lanes are empty. `state` is only
+  // dereferenced while the worker holds a popped node, which keeps the step
+  // alive.
+  static void RunWorkStealingWorker(std::shared_ptr<WorkStealingState> ws,
+                                    ExecutorState* state);
+
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
   // directly.
@@ -399,6 +583,9 @@ class ExecutorState {
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
 
+  // Non-null iff work stealing is enabled for this step.
+  std::shared_ptr<WorkStealingState> work_stealing_;
+
   PropagatorStateType propagator_;
 
   // Invoked when the execution finishes.
@@ -414,12 +601,23 @@ class ExecutorState {
 
   mutex mu_;
   Status status_ TF_GUARDED_BY(mu_);
+
+  // True if async kernel completions are batched. See
+  // `LocalExecutorParams::batch_async_completions`.
+  const bool batch_async_completions_;
+  mutex completions_mu_;
+  // Async completions waiting for the thread that is propagating completions,
+  // if `propagating_completions_`.
+  std::vector<AsyncCompletion> pending_completions_
+      TF_GUARDED_BY(completions_mu_);
+  bool propagating_completions_ TF_GUARDED_BY(completions_mu_) = false;
+  int64_t num_coalesced_completions_ TF_GUARDED_BY(completions_mu_) = 0;
 };
 
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, bool work_stealing)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -449,11 +647,24 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
       propagator_(immutable_state, step_id_, vlog_),
-      num_outstanding_ops_(0) {
-  if (args.user_intra_op_threadpool != nullptr) {
+      num_outstanding_ops_(0),
+      batch_async_completions_(
+          immutable_state.params().batch_async_completions &&
+          !run_all_kernels_inline_) {
+  if (args.user_intra_op_threadpool != nullptr ||
+      args.step_allocator != nullptr) {
     Device* device = immutable_state_.params().device;
     user_device_ = RenamedDevice::NewRenamedDevice(
-        device->name(), device, false, false, args.user_intra_op_threadpool);
+        device->name(), device, false, false, args.user_intra_op_threadpool,
+        args.step_allocator);
+  }
+  if (work_stealing && !run_all_kernels_inline_) {
+    int num_lanes = port::MaxParallelism();
+    if (session_config_ != nullptr &&
+        session_config_->inter_op_parallelism_threads() > 0) {
+      num_lanes = session_config_->inter_op_parallelism_threads();
+    }
+    work_stealing_ = std::make_shared<WorkStealingState>(num_lanes);
   }
 }
 
@@ -463,6 +674,10 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
     device_context_->Unref();
   }
   delete slice_reader_cache_;
+  if (batch_async_completions_) {
+    mutex_lock l(completions_mu_);
+    metrics::RecordExecutorCoalescedCompletions(num_coalesced_completions_);
+  }
 }
 
 template <class PropagatorStateType>
@@ -603,6 +818,10 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
         },
         profiler::GetTFTraceMeLevel(is_expensive));
     device->Compute(op_kernel, &ctx);
+  } else if (TF_PREDICT_FALSE(kernel_stats_->IsLearning())) {
+    KernelTimer timer;
+    device->Compute(op_kernel, &ctx);
+    kernel_stats_->RecordLearnedCost(item, timer.ElapsedCycles());
   } else if (kernel_stats_->HasExpensiveMarker(item)) {
     KernelTimer timer;
     device->Compute(op_kernel, &ctx);
@@ -692,14 +911,7 @@ void ExecutorState<PropagatorStateType>::ProcessAsync(
       }
       propagator_.MaybeMarkCompleted(state->tagged_node);
       activity_watcher::ActivityEnd(activity_id);
-      TaggedNodeSeq ready;
-      if (s.ok()) {
-        propagator_.PropagateOutputs(state->tagged_node, &outputs, &ready);
-      }
-      outputs.clear();
-      const bool completed = NodeDone(s, &ready, stats, nullptr);
-      delete state;
-      if (completed) ScheduleFinish();
+      AsyncNodeDone(state, &outputs, s);
     };
 
     immutable_state_.params().device->ComputeAsync(async_kernel, &state->ctx,
@@ -796,9 +1008,6 @@ void ExecutorState<PropagatorStateType>::ProcessInline(
     if (finish_when_deferred_ops_done) Finish();
   };
 
-  // Set the device_context for this device, if it exists.
-  params->op_device_context = device_context_;
-
   Status s;
   NodeExecStatsInterface* stats = nullptr;
 
@@ -832,6 +1041,12 @@ void ExecutorState<PropagatorStateType>::ProcessInline(
     const NodeItem& item = tagged_node.get_node_item();
     const int id = item.node_id;
 
+    // Set the device_context for this node, if it exists.
+    DeviceContext* node_device_context = immutable_state_.device_context(id);
+    params->op_device_context = node_device_context != nullptr
+                                    ? node_device_context
+                                    : device_context_;
+
     propagator_.MaybeMarkStarted(tagged_node);
     const activity_watcher::ActivityId activity_id =
         activity_watcher::ActivityStart(
@@ -1184,14 +1399,20 @@ Status ExecutorState<PropagatorStateType>::ProcessOutputs(
 }
 
 template <class PropagatorStateType>
-bool ExecutorState<PropagatorStateType>::NodeDone(
-    const Status& s, TaggedNodeSeq* ready, NodeExecStatsInterface* stats,
-    TaggedNodeReadyQueue* inline_ready) {
+void ExecutorState<PropagatorStateType>::NodeStatsDone(
+    NodeExecStatsInterface* stats) {
   if (stats) {
     nodestats::SetAllEnd(stats);
     DCHECK_NE(stats_collector_, nullptr);
     stats->Done(immutable_state_.params().device->name());
   }
+}
+
+template <class PropagatorStateType>
+bool ExecutorState<PropagatorStateType>::NodeDone(
+    const Status& s, TaggedNodeSeq* ready, NodeExecStatsInterface* stats,
+    TaggedNodeReadyQueue* inline_ready) {
+  NodeStatsDone(stats);
 
   if (TF_PREDICT_TRUE(s.ok())) {
     const size_t ready_size = ready->size();
@@ -1262,6 +1483,89 @@ bool ExecutorState<PropagatorStateType>::NodeDone(
   }
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::AsyncNodeDone(AsyncState* state,
+                                                       EntryVector* outputs,
+                                                       const Status& s) {
+  if (!batch_async_completions_) {
+    TaggedNodeSeq ready;
+    if (s.ok()) {
+      propagator_.PropagateOutputs(state->tagged_node, outputs, &ready);
+    }
+    outputs->clear();
+    const bool completed = NodeDone(s, &ready, state->stats, nullptr);
+    delete state;
+    if (completed) ScheduleFinish();
+    return;
+  }
+
+  {
+    mutex_lock l(completions_mu_);
+    pending_completions_.push_back({state, std::move(*outputs), s});
+    if (propagating_completions_) {
+      // The propagating thread will pick up this completion before it stops.
+      ++num_coalesced_completions_;
+      return;
+    }
+    propagating_completions_ = true;
+  }
+
+  // Hold an outstanding op while draining the queue, so that the nodes that a
+  // batch makes ready cannot finish the step, and delete `this`, while this
+  // thread still reads the queue. The completion just queued has not been
+  // released yet, so the count is positive here.
+  num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+  std::vector<AsyncCompletion> batch;
+  while (true) {
+    {
+      mutex_lock l(completions_mu_);
+      if (pending_completions_.empty()) {
+        propagating_completions_ = false;
+        break;
+      }
+      batch.swap(pending_completions_);
+    }
+    PropagateAsyncCompletions(&batch);
+    batch.clear();
+  }
+  // `this` may be deleted as soon as the op is released.
+  if (num_outstanding_ops_.fetch_sub(1) == 1) ScheduleFinish();
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::PropagateAsyncCompletions(
+    std::vector<AsyncCompletion>* batch) {
+  TaggedNodeSeq ready;
+  TaggedNodeSeq node_ready;
+  int64_t num_ok = 0;
+  for (AsyncCompletion& completion : *batch) {
+    AsyncState* state = completion.state;
+    if (completion.status.ok()) {
+      propagator_.PropagateOutputs(state->tagged_node, &completion.outputs,
+                                   &node_ready);
+      ready.insert(ready.end(), node_ready.begin(), node_ready.end());
+      node_ready.clear();
+      completion.outputs.clear();
+      NodeStatsDone(state->stats);
+      ++num_ok;
+    } else {
+      // The caller's outstanding op keeps this from completing the step.
+      completion.outputs.clear();
+      NodeDone(completion.status, &node_ready, state->stats, nullptr);
+    }
+    delete state;
+  }
+  if (num_ok == 0) return;
+
+  // Account for the newly ready nodes before the completed ones are released,
+  // so that the count cannot reach zero while nodes are still runnable.
+  if (!ready.empty()) {
+    num_outstanding_ops_.fetch_add(ready.size(), std::memory_order_relaxed);
+    ScheduleReady(&ready, nullptr);
+  }
+  num_outstanding_ops_.fetch_sub(num_ok);
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleReady(
     TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
@@ -1281,7 +1585,9 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     scheduled_nsec = nodestats::NowInNsec();
   }
 
-  if (run_all_kernels_inline_) {
+  if (work_stealing_ != nullptr) {
+    ScheduleReadyWorkStealing(ready, inline_ready, scheduled_nsec);
+  } else if (run_all_kernels_inline_) {
     if (inline_ready == nullptr) {
       // Schedule all ready kernels from a single closure. This ensure that,
       // regardless of the `runner_` implementation, all kernels will run
@@ -1374,6 +1680,115 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyWorkStealing(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+    int64_t scheduled_nsec) {
+  WorkStealingState* ws = work_stealing_.get();
+  int lane;
+  if (current_work_stealing_lane.owner == ws) {
+    // Keep successors on the lane of the worker that produced them.
+    lane = current_work_stealing_lane.lane;
+  } else {
+    lane = ws->next_lane.fetch_add(1, std::memory_order_relaxed) %
+           ws->queues.num_lanes();
+  }
+
+  // Hold an outstanding op while pushing, so that workers draining the lanes
+  // cannot finish the step (and delete `this`) before the new workers are
+  // scheduled.
+  num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+  size_t num_pushed = 0;
+  if (inline_ready == nullptr) {
+    for (auto& tagged_node : *ready) {
+      ws->queues.Push(lane, {tagged_node, scheduled_nsec});
+      ++num_pushed;
+    }
+  } else {
+    const TaggedNode* curr_expensive_node = nullptr;
+    for (auto& tagged_node : *ready) {
+      const NodeItem& item = *tagged_node.node_item;
+      if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+        // Inline this inexpensive node.
+        inline_ready->push_back(tagged_node);
+      } else {
+        if (curr_expensive_node) {
+          ws->queues.Push(lane, {*curr_expensive_node, scheduled_nsec});
+          ++num_pushed;
+        }
+        curr_expensive_node = &tagged_node;
+      }
+    }
+    if (curr_expensive_node) {
+      if (inline_ready->empty()) {
+        inline_ready->push_back(*curr_expensive_node);
+      } else {
+        // There are inline nodes to run already. Leave this expensive node
+        // on the lane for this worker, or a thief, to pick up.
+        ws->queues.Push(lane, {*curr_expensive_node, scheduled_nsec});
+        ++num_pushed;
+      }
+    }
+  }
+  if (num_pushed > 0) {
+    MaybeStartWorkStealingWorkers(num_pushed);
+  }
+  if (num_outstanding_ops_.fetch_sub(1) == 1) {
+    // All of the pushed nodes completed concurrently. Our caller cannot be
+    // holding any other ready nodes, so it will not touch `this` again.
+    ScheduleFinish();
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::MaybeStartWorkStealingWorkers(
+    size_t num_new_items) {
+  WorkStealingState* ws = work_stealing_.get();
+  const int max_workers = ws->queues.num_lanes();
+  for (size_t i = 0; i < num_new_items; ++i) {
+    int num_active = ws->num_active_workers.load();
+    do {
+      // Every lane already has a worker, which will steal the new items.
+      if (num_active >= max_workers) return;
+    } while (!ws->num_active_workers.compare_exchange_weak(num_active,
+                                                           num_active + 1));
+    RunTask([ws = work_stealing_, this]() { RunWorkStealingWorker(ws, this); },
+            /*sample_rate=*/num_new_items);
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorkStealingWorker(
+    std::shared_ptr<WorkStealingState> ws, ExecutorState* state) {
+  const int max_workers = ws->queues.num_lanes();
+  const WorkStealingLane saved_lane = current_work_stealing_lane;
+  current_work_stealing_lane.owner = ws.get();
+  current_work_stealing_lane.lane =
+      ws->next_lane.fetch_add(1, std::memory_order_relaxed) % max_workers;
+  while (true) {
+    while (std::optional<WorkStealingItem> item =
+               ws->queues.Pop(current_work_stealing_lane.lane)) {
+      state->Process(item->tagged_node, item->scheduled_nsec);
+    }
+    ws->num_active_workers.fetch_sub(1);
+    // A producer that observed every worker slot taken relies on an active
+    // worker to pick up its items, so re-check the lanes after giving up the
+    // slot and reclaim it if anything arrived in the meantime.
+    if (ws->queues.Empty()) break;
+    int num_active = ws->num_active_workers.load();
+    bool reclaimed = false;
+    while (num_active < max_workers) {
+      if (ws->num_active_workers.compare_exchange_weak(num_active,
+                                                       num_active + 1)) {
+        reclaimed = true;
+        break;
+      }
+    }
+    if (!reclaimed) break;
+  }
+  current_work_stealing_lane = saved_lane;
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1511,16 +1926,18 @@ void ExecutorState<PropagatorStateType>::Finish() {
 }
 
 void ExecutorImpl::RunAsyncInternal(const Args& args, DoneCallback done) {
+  kernel_stats_.StartStep(immutable_state_.graph_view());
   if (OpOrderDeterminismRequired()) {
     (new ExecutorState<OrderedPropagatorState>(args, immutable_state_,
-                                               &kernel_stats_))
+                                               &kernel_stats_, work_stealing_))
         ->RunAsync(std::move(done));
   } else if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        work_stealing_))
         ->RunAsync(std::move(done));
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_, work_stealing_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1574,6 +1991,108 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "WORK_STEALING" executor: the default executor with
+// work-stealing dispatch of ready nodes. Select it by setting
+// `ConfigProto.Experimental.executor_type` (or a function's `_executor`
+// attribute) to "WORK_STEALING".
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl =
+          std::make_unique<ExecutorImpl>(params, /*work_stealing=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return absl::OkStatus();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
+// Registers the "FLAT_SCHEDULE" executor: the default executor with
+// `LocalExecutorParams::build_flat_schedule` set, so that graphs without
+// control flow propagate outputs through a precompiled successor array.
+class FlatScheduleExecutorRegistrar {
+ public:
+  FlatScheduleExecutorRegistrar() {
+    ExecutorFactory::Register("FLAT_SCHEDULE", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams flat_params = params;
+      flat_params.build_flat_schedule = true;
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(flat_params, graph, &ret));
+      out_executor->reset(ret);
+      return absl::OkStatus();
+    }
+  };
+};
+static FlatScheduleExecutorRegistrar flat_schedule_registrar;
+
+// Registers the "BATCHED_ASYNC_COMPLETIONS" executor: the default executor with
+// `LocalExecutorParams::batch_async_completions` set, for graphs in which many
+// async kernels, e.g. Recv or collective ops, complete at the same time.
+class BatchedAsyncCompletionsExecutorRegistrar {
+ public:
+  BatchedAsyncCompletionsExecutorRegistrar() {
+    ExecutorFactory::Register("BATCHED_ASYNC_COMPLETIONS", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams batched_params = params;
+      batched_params.batch_async_completions = true;
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(batched_params, graph, &ret));
+      out_executor->reset(ret);
+      return absl::OkStatus();
+    }
+  };
+};
+static BatchedAsyncCompletionsExecutorRegistrar
+    batched_async_completions_registrar;
+
+// Registers the "ADAPTIVE_INLINING" executor: the default executor with
+// `LocalExecutorParams::adaptive_inlining_steps` set, if it is not already, so
+// that kernels are run inline or scheduled based on their measured cost.
+class AdaptiveInliningExecutorRegistrar {
+ public:
+  AdaptiveInliningExecutorRegistrar() {
+    ExecutorFactory::Register("ADAPTIVE_INLINING", new Factory);
+  }
+
+ private:
+  static constexpr int kDefaultAdaptiveInliningSteps = 16;
+
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams adaptive_params = params;
+      if (adaptive_params.adaptive_inlining_steps <= 0) {
+        adaptive_params.adaptive_inlining_steps =
+            kDefaultAdaptiveInliningSteps;
+      }
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewLocalExecutor(adaptive_params, graph, &ret));
+      out_executor->reset(ret);
+      return absl::OkStatus();
+    }
+  };
+};
+static AdaptiveInliningExecutorRegistrar adaptive_inlining_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
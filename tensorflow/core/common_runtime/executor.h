@@ -109,6 +109,10 @@ class Executor {
     ScopedStepContainer* step_container = nullptr;
     CollectiveExecutor* collective_executor = nullptr;
     thread::ThreadPoolInterface* user_intra_op_threadpool = nullptr;
+    // If not null, kernels allocate from this allocator instead of the
+    // device's allocator whenever they request default allocator attributes.
+    // Not owned, and must outlive the tensors allocated during the step.
+    Allocator* step_allocator = nullptr;
     tsl::CoordinationServiceAgent* coordination_service_agent = nullptr;
     int64_t start_time_usecs = 0;
     // The deadline for the kernel to complete by. Empty if unspecified.
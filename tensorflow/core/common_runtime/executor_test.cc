@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
@@ -42,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
@@ -77,8 +79,10 @@ class ExecutorTest : public ::testing::Test {
     delete exec_;
   }
 
-  // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  // Resets executor_ with a new executor based on a graph 'gdef'. An empty
+  // `executor_type` selects the default executor.
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -93,7 +97,9 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type, params, *graph, &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -266,6 +272,149 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeFlatSchedule) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), "FLAT_SCHEDULE");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, ManyRecvsBatchedAsyncCompletions) {
+  constexpr int kNumRecvs = 256;
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  std::vector<Node*> nodes;
+  for (int i = 0; i < kNumRecvs; ++i) {
+    nodes.push_back(test::graph::Recv(g.get(), strings::StrCat("a", i),
+                                      "float", ALICE, 1, BOB));
+  }
+  while (nodes.size() > 1) {
+    Node* sum = test::graph::Add(g.get(), nodes[nodes.size() - 2],
+                                 nodes.back());
+    nodes.resize(nodes.size() - 2);
+    nodes.insert(nodes.begin(), sum);
+  }
+  test::graph::Send(g.get(), nodes[0], "b", BOB, 1, ALICE);
+  Create(std::move(g), "BATCHED_ASYNC_COMPLETIONS");
+
+  // Half of the inputs are available before the step starts, the rest arrive
+  // concurrently while it runs.
+  Rendezvous::Args args;
+  for (int i = 0; i < kNumRecvs / 2; ++i) {
+    TF_ASSERT_OK(rendez_->Send(
+        Key(ALICE, kIncarnation, BOB, strings::StrCat("a", i)), args, V(1.0),
+        false));
+  }
+  for (int i = kNumRecvs / 2; i < kNumRecvs; ++i) {
+    rendez_->Ref();
+    SchedClosure([this, i]() {
+      TF_CHECK_OK(rendez_->Send(
+          Key(ALICE, kIncarnation, BOB, strings::StrCat("a", i)),
+          Rendezvous::Args(), V(1.0), false));
+      rendez_->Unref();
+    });
+  }
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(static_cast<float>(kNumRecvs), V(out));
+}
+
+TEST_F(ExecutorTest, BatchedAsyncCompletionsRaceSyncSuccessors) {
+  // Each Recv has a sync successor that runs on the pool as soon as the
+  // batch of its completion is propagated, so the last successor can finish
+  // the step while the propagating thread is still draining the queue.
+  constexpr int kNumRecvs = 32;
+  constexpr int kNumSteps = 100;
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  for (int i = 0; i < kNumRecvs; ++i) {
+    test::graph::Identity(g.get(),
+                          test::graph::Recv(g.get(), strings::StrCat("a", i),
+                                            "float", ALICE, 1, BOB));
+  }
+  Create(std::move(g), "BATCHED_ASYNC_COMPLETIONS");
+
+  for (int step = 0; step < kNumSteps; ++step) {
+    BlockingCounter sent(kNumRecvs);
+    for (int i = 0; i < kNumRecvs; ++i) {
+      rendez_->Ref();
+      SchedClosure([this, i, &sent]() {
+        TF_CHECK_OK(rendez_->Send(
+            Key(ALICE, kIncarnation, BOB, strings::StrCat("a", i)),
+            Rendezvous::Args(), V(1.0), false));
+        rendez_->Unref();
+        sent.DecrementCount();
+      });
+    }
+    TF_ASSERT_OK(Run(rendez_));
+    sent.Wait();
+  }
+}
+
+TEST_F(ExecutorTest, AbortBatchedAsyncCompletions) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g.get(), "b", "float", ALICE, 1, BOB);
+  auto add = test::graph::Add(g.get(), in0, in1);
+  test::graph::Send(g.get(), add, "c", BOB, 1, ALICE);
+  Create(std::move(g), "BATCHED_ASYNC_COMPLETIONS");
+
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"),
+                             Rendezvous::Args(), V(1.0), false));
+  rendez_->Ref();
+  SchedClosure([this]() {
+    Env::Default()->SleepForMicroseconds(100 * 1000);
+    rendez_->StartAbort(errors::Aborted(""));
+    rendez_->Unref();
+  });
+  EXPECT_TRUE(errors::IsAborted(Run(rendez_)));
+}
+
+TEST_F(ExecutorTest, RandomTreeAdaptiveInlining) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(256, g.get());
+  Create(std::move(g), "ADAPTIVE_INLINING");
+  // Run past the end of the learning phase, after which the nodes are
+  // classified by their measured costs.
+  for (int iters = 0; iters < 24; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(256.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -443,7 +592,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(::testing::benchmark::State& state) {
+static void BM_executor_helper(::testing::benchmark::State& state,
+                               const char* executor_type) {
   const int width = state.range(0);
   const int depth = state.range(1);
 
@@ -477,12 +627,19 @@ static void BM_executor(::testing::benchmark::State& state) {
   }
 
   FixupSourceAndSinkEdges(g);
-  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type,
+                  /*old_benchmark_api=*/false)
+      .Run(state);
 
   state.SetLabel(strings::StrCat("Nodes = ", cur));
   state.SetItemsProcessed(cur * static_cast<int64_t>(state.iterations()));
 }
 
+static void BM_executor(::testing::benchmark::State& state) {
+  BM_executor_helper(state, "");
+}
+
 // Tall skinny graphs
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(32, 8192);
@@ -494,6 +651,17 @@ BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 1024);
 
+// Same graphs as `BM_executor`, propagating through the flat schedule.
+static void BM_executor_flat_schedule(::testing::benchmark::State& state) {
+  BM_executor_helper(state, "FLAT_SCHEDULE");
+}
+
+BENCHMARK(BM_executor_flat_schedule)->UseRealTime()->ArgPair(16, 1024);
+BENCHMARK(BM_executor_flat_schedule)->UseRealTime()->ArgPair(32, 8192);
+BENCHMARK(BM_executor_flat_schedule)->UseRealTime()->ArgPair(1024, 16);
+BENCHMARK(BM_executor_flat_schedule)->UseRealTime()->ArgPair(8192, 32);
+BENCHMARK(BM_executor_flat_schedule)->UseRealTime()->ArgPair(1024, 1024);
+
 static void BM_const_identity(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int outputs_per_const = state.range(1);
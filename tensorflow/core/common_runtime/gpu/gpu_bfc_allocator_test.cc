@@ -221,6 +221,25 @@ TEST_P(GPUBFCAllocatorTest, AllocatedVsRequested) {
   a.DeallocateRaw(t1);
 }
 
+TEST_P(GPUBFCAllocatorTest, StatsReportLargestFreeBlock) {
+  // Configure a 1MiB byte limit, all of which is a single region.
+  GPUBFCAllocator a(GetParam()(1ull << 32), 1 << 20, "GPU_0_bfc", {});
+  void* first_ptr = a.AllocateRaw(Allocator::kAllocatorAlignment, 256 << 10);
+  void* second_ptr = a.AllocateRaw(Allocator::kAllocatorAlignment, 256 << 10);
+  void* third_ptr = a.AllocateRaw(Allocator::kAllocatorAlignment, 256 << 10);
+  EXPECT_EQ(a.GetStats()->largest_free_block_bytes, 256 << 10);
+
+  // Freeing the second chunk leaves two free blocks of the same size.
+  a.DeallocateRaw(second_ptr);
+  EXPECT_EQ(a.GetStats()->largest_free_block_bytes, 256 << 10);
+
+  // Freeing the third chunk merges it with both of them.
+  a.DeallocateRaw(third_ptr);
+  EXPECT_EQ(a.GetStats()->largest_free_block_bytes, 768 << 10);
+  a.DeallocateRaw(first_ptr);
+  EXPECT_EQ(a.GetStats()->largest_free_block_bytes, 1 << 20);
+}
+
 TEST_P(GPUBFCAllocatorTest, TestCustomMemoryLimit) {
   // Configure a 2MiB byte limit
   GPUBFCAllocator a(GetParam()(1ull << 32), 2 << 20, "GPU_0_bfc", {});
@@ -489,6 +508,11 @@ class GPUBFCAllocatorPrivateMethodsTest
     {
       mutex_lock l(a.lock_);
       bin_infos = a.get_bin_debug_info();
+      for (int i = 0; i < BFCAllocator::kNumBins; i++) {
+        EXPECT_EQ(a.BinFromIndex(i)->free_bytes,
+                  bin_infos[i].total_bytes_in_bin -
+                      bin_infos[i].total_bytes_in_use);
+      }
     }
     for (int i = 0; i < BFCAllocator::kNumBins; i++) {
       const BFCAllocator::BinDebugInfo& bin_info = bin_infos[i];
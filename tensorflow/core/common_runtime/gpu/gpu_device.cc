@@ -42,6 +42,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_split.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -62,6 +63,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -446,6 +448,90 @@ class BaseGPUDevice::StreamGroupFactory {
   void operator=(const StreamGroupFactory&) = delete;
 };
 
+namespace {
+
+// The most compute streams a GPU device may run ops on, so that sets of them
+// fit in a uint32 mask.
+constexpr int kMaxComputeStreams = 8;
+
+// Wraps the GPU allocator of a device with several compute streams. Memory
+// freed by an op may still be used by kernels queued on any of the streams, so
+// unless the caller already sets `freed_by_func`, an allocation only reuses
+// memory freed before all the streams terminated the kernels queued at the
+// time, see BaseGPUDevice::SafeAllocFrontier.
+class MultiStreamAllocator : public Allocator {
+ public:
+  MultiStreamAllocator(Allocator* allocator, BaseGPUDevice* device)
+      : allocator_(allocator), device_(device) {}
+
+  std::string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    if (allocation_attr.freed_by_func != nullptr) {
+      return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+    }
+    uint64 safe_alloc_frontier = 0;
+    std::function<uint64()> freed_by_func = [this, &safe_alloc_frontier]() {
+      safe_alloc_frontier = device_->SafeAllocFrontier(safe_alloc_frontier);
+      // A count of 0 would let any memory be reused.
+      return std::max<uint64>(safe_alloc_frontier, 1);
+    };
+    AllocationAttributes attr(allocation_attr.retry_on_failure,
+                              allocation_attr.allocation_will_be_logged,
+                              &freed_by_func);
+    return allocator_->AllocateRaw(alignment, num_bytes, attr);
+  }
+
+  void DeallocateRaw(void* ptr) override { allocator_->DeallocateRaw(ptr); }
+
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+  int64_t AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+  bool ClearStats() override { return allocator_->ClearStats(); }
+  void SetSafeFrontier(uint64 count) override {
+    allocator_->SetSafeFrontier(count);
+  }
+  AllocatorMemoryType GetMemoryType() const override {
+    return allocator_->GetMemoryType();
+  }
+
+ private:
+  Allocator* allocator_;   // not owned
+  BaseGPUDevice* device_;  // not owned
+};
+
+// Returns true if `n` has side effects, or passes tensors to or from other
+// graphs or devices, so it has to run after all the work queued on the compute
+// streams of its device.
+bool RunsAfterAllComputeStreams(const Node& n) {
+  if (n.op_def().is_stateful() || n.IsArg() || n.IsRetval() || n.IsSend() ||
+      n.IsRecv() || n.IsFunctionCall() || n.IsIfNode() || n.IsWhileNode() ||
+      n.IsCaseNode()) {
+    return true;
+  }
+  return absl::c_linear_search(n.input_types(), DT_RESOURCE) ||
+         absl::c_linear_search(n.output_types(), DT_RESOURCE);
+}
+
+}  // namespace
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              tsl::TfDeviceId tf_device_id,
@@ -480,6 +566,8 @@ BaseGPUDevice::~BaseGPUDevice() {
   delete accelerator_device_info_;
   if (scratch_) gpu_allocator_->DeallocateRaw(scratch_);
   device_context_->Unref();
+  mutex_lock l(multi_stream_mu_);
+  for (auto& [key, context] : multi_stream_contexts_) context->Unref();
 }
 
 // This should be idempotent if already initialized.
@@ -549,6 +637,28 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
       tf_device_id_, 0, executor_, options.config.gpu_options());
 #endif  // TF_GPU_USE_PJRT
 
+  // The number of compute streams to run independent ops on. This option is
+  // experimental, see FillContextMap().
+  int64_t num_compute_streams;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_GPU_NUM_COMPUTE_STREAMS", 1,
+                                         &num_compute_streams));
+  if (num_compute_streams < 1 || num_compute_streams > kMaxComputeStreams) {
+    return errors::InvalidArgument(
+        "TF_GPU_NUM_COMPUTE_STREAMS must be between 1 and ", kMaxComputeStreams,
+        ", got ", num_compute_streams);
+  }
+#ifdef TF_GPU_USE_PJRT
+  if (num_compute_streams > 1) {
+    LOG(WARNING) << "Ignoring TF_GPU_NUM_COMPUTE_STREAMS with PJRT.";
+    num_compute_streams = 1;
+  }
+#endif  // TF_GPU_USE_PJRT
+  compute_stream_groups_.push_back(stream_);
+  for (int i = 1; i < num_compute_streams; ++i) {
+    compute_stream_groups_.push_back(StreamGroupFactory::Global().GetOrCreate(
+        tf_device_id_, i, executor_, options.config.gpu_options()));
+  }
+
   // Get an allocator that allocates pinned memory on host.
   AllocatorAttributes attr;
   attr.set_on_host(true);
@@ -572,6 +682,14 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
       options.config.gpu_options().experimental().kernel_tracker_max_pending());
   timestamped_allocator_ =
       options.config.gpu_options().experimental().timestamped_allocator();
+  // Memory freed by the ops of one compute stream can only be reused by the
+  // others once they are done with it, which the timestamped allocator tracks.
+  const bool multi_stream = compute_stream_groups_.size() > 1;
+  if (multi_stream && !timestamped_allocator_) {
+    return errors::InvalidArgument(
+        "TF_GPU_NUM_COMPUTE_STREAMS > 1 requires "
+        "GPUOptions.experimental.timestamped_allocator");
+  }
   pending_cap_ = tracker_params.max_pending;
   if (timestamped_allocator_ ||
       (tracker_params.max_interval > 0 || tracker_params.max_bytes > 0 ||
@@ -586,9 +704,25 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
           GPUProcessState::singleton()->GPUAllocatorCounter(tf_device_id_);
       DCHECK(timing_counter);
     }
+    // With several compute streams, SafeAllocFrontier() sets the safe frontier
+    // of the allocator from all the trackers instead.
     kernel_tracker_.reset(new GPUKernelTracker(
         tracker_params, Env::Default(), stream_->compute, timing_counter,
-        timestamped_allocator_ ? gpu_allocator_ : nullptr, em_));
+        timestamped_allocator_ && !multi_stream ? gpu_allocator_ : nullptr,
+        em_));
+    for (int i = 1; i < compute_stream_groups_.size(); ++i) {
+      extra_kernel_trackers_.push_back(std::make_unique<GPUKernelTracker>(
+          tracker_params, Env::Default(), compute_stream_groups_[i]->compute,
+          timing_counter, /*allocator=*/nullptr, em_));
+    }
+  }
+  if (multi_stream) {
+    // MultiStreamAllocator reuses memory freed at a count of 1 even before any
+    // stream terminated a kernel, so no memory may be freed at that count.
+    GPUProcessState::singleton()->GPUAllocatorCounter(tf_device_id_)->next();
+    multi_stream_allocator_ =
+        std::make_unique<MultiStreamAllocator>(gpu_allocator_, this);
+    gpu_allocator_ = multi_stream_allocator_.get();
   }
 
   accelerator_device_info_ = new DeviceBase::AcceleratorDeviceInfo;
@@ -782,12 +916,16 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
             << ComputeOpKernelDebugString(*op_kernel, stream_id);
   }
 
-  if (kernel_tracker_.get()) {
+  GPUKernelTracker* kernel_tracker = KernelTracker(stream_id);
+  if (kernel_tracker) {
     context->set_record_memory_consumption(true);
     if (pending_cap_ > 0) {
-      kernel_tracker_->PauseWhilePendingExceeds(pending_cap_);
+      kernel_tracker->PauseWhilePendingExceeds(pending_cap_);
     }
   }
+  for (se::Stream* input_stream : gpu_device_context->input_streams()) {
+    OP_REQUIRES_OK(context, stream->WaitFor(input_stream));
+  }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
   profiler::ScopedMemoryDebugAnnotation op_annotation(
       op_kernel->name_view().data(), context->step_id());
@@ -818,9 +956,8 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
       VLOG(1) << "GpuDevice::ComputeHelper scheduled "
               << ComputeOpKernelDebugString(*op_kernel, stream_id);
     }
-    if (kernel_tracker_) {
-      GPUKernelTracker* tracker = kernel_tracker_.get();
-      DCHECK(tracker);
+    if (kernel_tracker) {
+      GPUKernelTracker* tracker = kernel_tracker;
       uint64 queued_count = tracker->MaybeQueue(context);
       if (queued_count > 0) {
         em_->ThenExecute(stream, [tracker, queued_count]() {
@@ -848,11 +985,14 @@ Status BaseGPUDevice::Sync() {
 
   // Device::Sync is supposed to block until all operations queued on the device
   // at the time of the call have completed.  On GPUs, only operations enqueued
-  // on the compute stream can remain pending after the (Async)OpKernel that
+  // on the compute streams can remain pending after the (Async)OpKernel that
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
-  return stream_->compute->BlockHostUntilDone();
+  for (StreamGroup* group : compute_stream_groups_) {
+    TF_RETURN_IF_ERROR(group->compute->BlockHostUntilDone());
+  }
+  return OkStatus();
 }
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
@@ -882,10 +1022,94 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
     };
   }
 
+  for (se::Stream* input_stream : gpu_device_context->input_streams()) {
+    OP_REQUIRES_OK_ASYNC(context, stream->WaitFor(input_stream), done);
+  }
   ScopedActivateExecutorContext scoped_activation{stream->parent()};
   op_kernel->ComputeAsync(context, std::move(done));
 }
 
+Status BaseGPUDevice::FillContextMap(
+    const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+  const int num_streams = compute_stream_groups_.size();
+  if (num_streams <= 1) return OkStatus();
+  // Loops would need their back edges to be synchronized too.
+  for (const Node* n : graph->op_nodes()) {
+    if (n->IsControlFlow()) {
+      VLOG(1) << "Running graph with control flow on a single compute stream";
+      return OkStatus();
+    }
+  }
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph, &order);
+  const uint32 all_streams = (1u << num_streams) - 1;
+  // The compute stream of each op, and whether one of its consumers runs on it
+  // too, so that a chain of ops stays on one stream while branches of the
+  // graph run on different streams.
+  std::vector<int> node_stream(graph->num_node_ids(), -1);
+  std::vector<bool> stream_continued(graph->num_node_ids(), false);
+  int next_stream = 1;
+  device_context_map->resize(graph->num_node_ids(), nullptr);
+  for (const Node* n : order) {
+    if (!n->IsOp()) continue;
+    int stream = -1;
+    uint32 input_streams = 0;
+    if (RunsAfterAllComputeStreams(*n)) {
+      stream = 0;
+      input_streams = all_streams;
+    } else {
+      for (const Edge* e : n->in_edges()) {
+        const int src = e->src()->id();
+        if (node_stream[src] < 0) continue;
+        input_streams |= 1u << node_stream[src];
+        if (stream < 0 && !stream_continued[src]) {
+          stream = node_stream[src];
+          stream_continued[src] = true;
+        }
+      }
+      if (stream < 0) {
+        stream = next_stream;
+        next_stream = (next_stream + 1) % num_streams;
+      }
+    }
+    node_stream[n->id()] = stream;
+    input_streams &= ~(1u << stream);
+    GPUDeviceContext* context = GetMultiStreamContext(stream, input_streams);
+    context->Ref();
+    (*device_context_map)[n->id()] = context;
+  }
+  return OkStatus();
+}
+
+GPUDeviceContext* BaseGPUDevice::GetMultiStreamContext(int stream_id,
+                                                       uint32 input_streams) {
+  if (stream_id == 0 && input_streams == 0) return device_context_;
+  mutex_lock l(multi_stream_mu_);
+  GPUDeviceContext*& context =
+      multi_stream_contexts_[std::make_pair(stream_id, input_streams)];
+  if (context == nullptr) {
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    attr.set_gpu_compatible(true);
+    const StreamGroup* group = compute_stream_groups_[stream_id];
+    context = new GPUDeviceContext(stream_id, group->compute,
+#if TENSORFLOW_USE_ROCM
+                                   group->nccl,
+#endif
+                                   group->host_to_device, group->device_to_host,
+                                   group->device_to_device, GetAllocator(attr));
+    gtl::InlinedVector<se::Stream*, 4> streams;
+    for (int i = 0; i < compute_stream_groups_.size(); ++i) {
+      if (input_streams & (1u << i)) {
+        streams.push_back(compute_stream_groups_[i]->compute);
+      }
+    }
+    context->set_input_streams(std::move(streams));
+  }
+  return context;
+}
+
 Status BaseGPUDevice::MaybeCopyTensorToGPU(
     const AllocatorAttributes& alloc_attrs, const Tensor& from, Tensor* to,
     StatusCallback done) {
@@ -1287,9 +1511,11 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, compute_stream_groups_.size());
   const gpuStream_t gpu_stream = reinterpret_cast<gpuStream_t>(
-      stream_->compute->platform_specific_handle().stream);
+      compute_stream_groups_[stream_id]
+          ->compute->platform_specific_handle()
+          .stream);
   concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
                                 scratch_);
 }
@@ -1308,7 +1534,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
@@ -2453,7 +2678,15 @@ Status BaseGPUDeviceFactory::GetValidDeviceIds(
 
 uint64 BaseGPUDevice::SafeAllocFrontier(uint64 old_value) {
   if (timestamped_allocator_) {
-    return kernel_tracker_->LastTerminatedCount(old_value);
+    uint64 frontier = kernel_tracker_->LastTerminatedCount(old_value);
+    if (extra_kernel_trackers_.empty()) return frontier;
+    // Memory freed at some count is only safe to reuse once every compute
+    // stream terminated the kernels queued before it.
+    for (const auto& tracker : extra_kernel_trackers_) {
+      frontier = std::min(frontier, tracker->LastTerminatedCount(old_value));
+    }
+    gpu_allocator_->SetSafeFrontier(frontier);
+    return frontier;
   } else {
     return 0;
   }
@@ -35,6 +35,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #ifdef TF_GPU_USE_PJRT
 #include "tensorflow/compiler/jit/pjrt_device_context.h"
@@ -124,6 +125,14 @@ class BaseGPUDevice : public LocalDevice {
   void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
                     AsyncOpKernel::DoneCallback done) override;
 
+  // If TF_GPU_NUM_COMPUTE_STREAMS is greater than 1, spreads the independent
+  // ops of `graph` over that many compute streams. Ops with side effects or
+  // that pass tensors to or from other graphs run on the first stream, after
+  // the work queued on the others, so they are ordered as on a single stream.
+  Status FillContextMap(
+      const Graph* graph,
+      std::vector<DeviceContext*>* device_context_map) override;
+
   Status MakeTensorFromProto(const TensorProto& tensor_proto,
                              AllocatorAttributes alloc_attrs,
                              Tensor* tensor) override;
@@ -194,6 +203,9 @@ class BaseGPUDevice : public LocalDevice {
 
   core::RefCountPtr<DeviceContext> pjrt_device_context_;
   StreamGroup* stream_;
+  // The stream groups whose compute streams run ops, indexed by stream id. The
+  // first one is `stream_`.
+  std::vector<StreamGroup*> compute_stream_groups_;
   mutex scratch_init_mutex_;
   char* scratch_ = nullptr;
   GPUDeviceContext* device_context_;
@@ -204,6 +216,17 @@ class BaseGPUDevice : public LocalDevice {
   EventMgr* em_ = nullptr;
   std::unique_ptr<thread::ThreadPool> thread_pool_;
   std::unique_ptr<GPUKernelTracker> kernel_tracker_;
+  // The kernel trackers of the compute streams after the first one, whose
+  // tracker is `kernel_tracker_`.
+  std::vector<std::unique_ptr<GPUKernelTracker>> extra_kernel_trackers_;
+  // With several compute streams, wraps the GPU allocator so that memory is
+  // only reused once all the streams are done with it.
+  std::unique_ptr<Allocator> multi_stream_allocator_;
+  mutex multi_stream_mu_;
+  // The device contexts of each compute stream, keyed by the stream id and the
+  // mask of its input streams, see FillContextMap().
+  absl::flat_hash_map<std::pair<int, uint32>, GPUDeviceContext*>
+      multi_stream_contexts_ TF_GUARDED_BY(multi_stream_mu_);
   int32 pending_cap_ = 0;
   bool timestamped_allocator_ = false;
   NodeFileWriter* node_file_writer_ = nullptr;  // not owned
@@ -211,6 +234,16 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns the kernel tracker of the compute stream `stream_id`, if any.
+  GPUKernelTracker* KernelTracker(int stream_id) {
+    return stream_id == 0 ? kernel_tracker_.get()
+                          : extra_kernel_trackers_[stream_id - 1].get();
+  }
+
+  // Returns the device context of the compute stream `stream_id` whose ops
+  // wait for the compute streams in the mask `input_streams`.
+  GPUDeviceContext* GetMultiStreamContext(int stream_id, uint32 input_streams);
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
@@ -24,6 +24,8 @@ limitations under the License.
 #include "xla/stream_executor/gpu/gpu_cudamallocasync_allocator.h"
 #include "xla/stream_executor/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/random.h"
@@ -606,6 +608,54 @@ TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   }
 }
 
+#ifndef TF_GPU_USE_PJRT
+TEST_F(GPUDeviceTest, MultipleComputeStreamsRequireTimestampedAllocator) {
+  SessionOptions opts = MakeSessionOptions("0");
+  setenv("TF_GPU_NUM_COMPUTE_STREAMS", "2", 1);
+  std::vector<std::unique_ptr<Device>> devices;
+  Status status = DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices);
+  unsetenv("TF_GPU_NUM_COMPUTE_STREAMS");
+  EXPECT_EQ(status.code(), error::INVALID_ARGUMENT);
+  ExpectErrorMessageSubstr(status, "timestamped_allocator");
+}
+
+TEST_F(GPUDeviceTest, MultipleComputeStreams) {
+  SessionOptions opts = MakeSessionOptions("0");
+  opts.config.mutable_gpu_options()
+      ->mutable_experimental()
+      ->set_timestamped_allocator(true);
+  setenv("TF_GPU_NUM_COMPUTE_STREAMS", "2", 1);
+  std::vector<std::unique_ptr<Device>> devices;
+  Status status = DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices);
+  unsetenv("TF_GPU_NUM_COMPUTE_STREAMS");
+  TF_ASSERT_OK(status);
+
+  // Two independent branches joined by an add.
+  Graph graph(OpRegistry::Global());
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1;
+  Node* square = test::graph::Unary(
+      &graph, "Square", test::graph::Constant(&graph, value, "a"));
+  Node* neg = test::graph::Unary(&graph, "Neg",
+                                 test::graph::Constant(&graph, value, "b"));
+  Node* add = test::graph::Binary(&graph, "AddV2", square, neg);
+
+  std::vector<DeviceContext*> device_context_map;
+  TF_ASSERT_OK(devices[0]->FillContextMap(&graph, &device_context_map));
+  ASSERT_EQ(device_context_map.size(), graph.num_node_ids());
+  auto context = [&](const Node* n) {
+    return static_cast<GPUDeviceContext*>(device_context_map[n->id()]);
+  };
+  EXPECT_NE(context(square)->stream_id(), context(neg)->stream_id());
+  EXPECT_EQ(context(add)->input_streams().size(), 1);
+  for (DeviceContext* device_context : device_context_map) {
+    if (device_context != nullptr) device_context->Unref();
+  }
+}
+#endif  // TF_GPU_USE_PJRT
+
 TEST_F(GPUDeviceTest, DeviceDetails) {
   DeviceFactory* factory = DeviceFactory::GetFactory("GPU");
   std::vector<string> devices;
@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
@@ -346,6 +347,18 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
     mem_limit_bytes = limit_mb * (1LL << 20);
   }
 
+  // Pinning host memory is slow, so the memory that steps are expected to use
+  // can be pinned up front, when the devices are created. The allocator keeps
+  // the regions it pinned for reuse.
+  int64_t preallocate_mb = 0;
+  Status status = tsl::ReadInt64FromEnvVar("TF_GPU_HOST_MEM_PREALLOCATE_IN_MB",
+                                           0, &preallocate_mb);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetGpuHostAllocator: " << status.message();
+  }
+  const int64_t preallocate_bytes =
+      std::min(preallocate_mb * (1LL << 20), mem_limit_bytes);
+
   while (static_cast<int>(gpu_host_allocators_.size()) <= numa_node) {
     while (gpu_host_alloc_visitors_.size() <= numa_node) {
       gpu_host_alloc_visitors_.push_back({});
@@ -363,6 +376,19 @@ Allocator* GPUProcessState::GetGpuHostAllocator(const GPUOptions& options,
     tsl::Allocator* allocator =
         new tsl::BFCAllocator(absl::WrapUnique(sub_allocator), mem_limit_bytes,
                               /*name=*/"gpu_host_bfc", allocator_opts);
+    if (preallocate_bytes > 0) {
+      void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                         preallocate_bytes);
+      if (ptr == nullptr) {
+        LOG(WARNING) << "Failed to preallocate " << preallocate_bytes
+                     << " bytes of pinned host memory.";
+      } else {
+        allocator->DeallocateRaw(ptr);
+        VLOG(1) << "Preallocated " << preallocate_bytes
+                << " bytes of pinned host memory for NUMA node "
+                << gpu_host_allocators_.size();
+      }
+    }
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
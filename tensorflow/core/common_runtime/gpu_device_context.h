@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <utility>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -60,6 +62,15 @@ class GPUDeviceContext : public DeviceContext {
     return device_to_device_stream_[index % device_to_device_stream_.size()];
   }
   int stream_id() const { return stream_id_; }
+
+  // The other compute streams that ops using this context wait for before
+  // running, because they run producers of the inputs of the ops.
+  const gtl::InlinedVector<se::Stream*, 4>& input_streams() const {
+    return input_streams_;
+  }
+  void set_input_streams(gtl::InlinedVector<se::Stream*, 4> input_streams) {
+    input_streams_ = std::move(input_streams);
+  }
   Allocator* host_memory_allocator() const override {
     return host_memory_allocator_;
   }
@@ -97,6 +108,8 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  // See input_streams().
+  gtl::InlinedVector<se::Stream*, 4> input_streams_;
   // The allocator to use for allocating pinned host memory.
   // Not owned.
   Allocator* host_memory_allocator_;
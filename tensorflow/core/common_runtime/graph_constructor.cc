@@ -675,6 +675,7 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 
 Status GraphConstructor::BuildNodeIndex() {
   // Validate the node names and add them to gdef_nodes_ and gdef_prefixes_.
+  gdef_nodes_.reserve(node_def_count());
   for (int n = 0; n < node_def_count(); ++n) {
     const NodeDef& node_def = get_node_def(n);
     if (!IsValidNodeName(node_def.name(), opts_.allow_internal_ops)) {
@@ -730,9 +731,11 @@ Status GraphConstructor::InitFromEdges() {
   }
 
   // Parse the inputs for each node.
+  int num_inputs = 0;
   for (int n = 0; n < num_nodes; ++n) {
     const NodeDef& node_def = get_node_def(n);
     int pending_count = node_def.input_size();
+    num_inputs += node_def.input_size();
     if (IsMerge(node_def)) {
       // Cycles in the graph are only allowed for while loops. A while loop is
       // identified by an edge from a NextIteration node to a Merge node. For
@@ -781,6 +784,9 @@ Status GraphConstructor::InitFromEdges() {
     }
     pending_count_.push_back(pending_count);
   }
+  // Each input becomes an edge, and nodes without inputs get one from the
+  // source node.
+  g_->Reserve(num_nodes, num_inputs + ready_.size());
   return absl::OkStatus();
 }
 
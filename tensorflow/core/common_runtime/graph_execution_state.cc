@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
 
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
@@ -22,6 +23,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_join.h"
@@ -49,8 +51,13 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/util.h"
@@ -69,6 +76,103 @@ bool IsCollectiveV2(const string& op) {
          op == "CollectiveBcastRecvV2" || op == "CollectiveBcastSendV2" ||
          op == "ColectiveReduceScatterV2" || op == "ColectiveAllToAllV2";
 }
+
+// A placed and optimized base graph, and the function library that it was
+// optimized with.
+struct SharedBaseGraph {
+  SharedBaseGraph(std::shared_ptr<const Graph> graph,
+                  const FunctionLibraryDefinition& flib_def)
+      : graph(std::move(graph)), flib_def(flib_def) {}
+
+  const std::shared_ptr<const Graph> graph;
+  const FunctionLibraryDefinition flib_def;
+};
+
+// The base graphs of the states made by MakeForSharedBaseGraph(), by the
+// fingerprints of their graphs, devices and session configs. A base graph is
+// kept as long as a state refers to it.
+class SharedBaseGraphs {
+ public:
+  using Factory =
+      std::function<absl::StatusOr<std::shared_ptr<const SharedBaseGraph>>()>;
+
+  static SharedBaseGraphs* Global() {
+    static SharedBaseGraphs* shared_base_graphs = new SharedBaseGraphs;
+    return shared_base_graphs;
+  }
+
+  // Returns the base graph of `key`, made by `factory` if there is none. Calls
+  // for the same key wait for each other, and calls for other keys don't.
+  absl::StatusOr<std::shared_ptr<const SharedBaseGraph>> GetOrCreate(
+      const string& key, const Factory& factory) {
+    std::shared_ptr<Entry> entry;
+    {
+      mutex_lock l(mu_);
+      std::shared_ptr<Entry>& slot = entries_[key];
+      if (slot == nullptr) {
+        EraseExpiredEntries();
+        slot = std::make_shared<Entry>();
+      }
+      entry = slot;
+    }
+    mutex_lock l(entry->mu);
+    std::shared_ptr<const SharedBaseGraph> base_graph = entry->graph.lock();
+    if (base_graph == nullptr) {
+      TF_ASSIGN_OR_RETURN(base_graph, factory());
+      entry->graph = base_graph;
+    }
+    return base_graph;
+  }
+
+ private:
+  struct Entry {
+    mutex mu;
+    std::weak_ptr<const SharedBaseGraph> graph TF_GUARDED_BY(mu);
+  };
+
+  // Erases the entries of the graphs that no state refers to any more.
+  void EraseExpiredEntries() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      // Other references to an entry are held by the calls that use it.
+      if (it->second != nullptr && it->second.use_count() == 1 &&
+          IsExpired(*it->second)) {
+        entries_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  static bool IsExpired(Entry& entry) {
+    mutex_lock l(entry.mu);
+    return entry.graph.expired();
+  }
+
+  mutex mu_;
+  absl::flat_hash_map<string, std::shared_ptr<Entry>> entries_
+      TF_GUARDED_BY(mu_);
+};
+
+// Returns the key of the base graph of `graph_def` in `options`, or an empty
+// string if `graph_def` can't be serialized.
+string SharedBaseGraphKey(const GraphDef& graph_def,
+                          const GraphExecutionStateOptions& options) {
+  string serialized;
+  if (!SerializeToStringDeterministic(graph_def, &serialized)) return "";
+  const Fprint128 graph_fingerprint = Fingerprint128(serialized);
+  if (!SerializeToStringDeterministic(options.session_options->config,
+                                      &serialized)) {
+    return "";
+  }
+  string key = strings::StrCat(graph_fingerprint.high64, ":",
+                               graph_fingerprint.low64, ":",
+                               Fingerprint64(serialized));
+  for (const Device* device : options.device_set->devices()) {
+    strings::StrAppend(&key, ";", device->name(), "=", device->device_type());
+  }
+  return key;
+}
+
 }  // namespace
 
 GraphExecutionState::GraphExecutionState(
@@ -86,7 +190,6 @@ GraphExecutionState::GraphExecutionState(
 
 GraphExecutionState::~GraphExecutionState() {
   node_name_to_cost_id_map_.clear();
-  delete graph_;
 }
 
 /* static */ Status GraphExecutionState::MakeForBaseGraph(
@@ -130,6 +233,48 @@ GraphExecutionState::~GraphExecutionState() {
   return absl::OkStatus();
 }
 
+/* static */ Status GraphExecutionState::MakeForSharedBaseGraph(
+    GraphDef&& graph_def, const GraphExecutionStateOptions& options,
+    std::unique_ptr<GraphExecutionState>* out_state) {
+  const ConfigProto& config = options.session_options->config;
+  const string key =
+      config.graph_options().place_pruned_graph() ||
+              config.experimental().disable_optimize_for_static_graph()
+          ? ""
+          : SharedBaseGraphKey(graph_def, options);
+  if (key.empty()) {
+    return MakeForBaseGraph(std::move(graph_def), options, out_state);
+  }
+
+  // The state that places the graph, if this call does.
+  std::unique_ptr<GraphExecutionState> ret;
+  auto make_base_graph =
+      [&]() -> absl::StatusOr<std::shared_ptr<const SharedBaseGraph>> {
+    TF_RETURN_IF_ERROR(MakeForBaseGraph(std::move(graph_def), options, &ret));
+    return std::make_shared<const SharedBaseGraph>(ret->graph_,
+                                                   *ret->flib_def_);
+  };
+  TF_ASSIGN_OR_RETURN(
+      std::shared_ptr<const SharedBaseGraph> base_graph,
+      SharedBaseGraphs::Global()->GetOrCreate(key, make_base_graph));
+  if (ret == nullptr) {
+    VLOG(1) << "Sharing the base graph of " << key;
+    ret = absl::WrapUnique(new GraphExecutionState(
+        nullptr,
+        std::make_unique<FunctionLibraryDefinition>(base_graph->flib_def),
+        options));
+    for (const Node* n : base_graph->graph->nodes()) {
+      ret->node_name_to_cost_id_map_[n->name()] = n->cost_id();
+    }
+    ret->SaveStatefulNodes(base_graph->graph.get());
+  }
+  // The state keeps the entry of the graph alive.
+  ret->graph_ =
+      std::shared_ptr<const Graph>(base_graph, base_graph->graph.get());
+  *out_state = std::move(ret);
+  return absl::OkStatus();
+}
+
 /* static */ Status GraphExecutionState::MakeForPrunedGraph(
     const GraphExecutionState& base_execution_state,
     const GraphExecutionStateOptions& options,
@@ -288,7 +433,7 @@ Status GraphExecutionState::Extend(
   return absl::OkStatus();
 }
 
-void GraphExecutionState::SaveStatefulNodes(Graph* graph) {
+void GraphExecutionState::SaveStatefulNodes(const Graph* graph) {
   for (Node* n : graph->nodes()) {
     if (n->op_def().is_stateful()) {
       VLOG(2) << "Saving " << n->DebugString();
@@ -645,7 +790,7 @@ Status GraphExecutionState::InitBaseGraph(std::unique_ptr<Graph>&& new_graph) {
   }
 
   SaveStatefulNodes(new_graph.get());
-  graph_ = new_graph.release();
+  graph_ = std::move(new_graph);
   return absl::OkStatus();
 }
 
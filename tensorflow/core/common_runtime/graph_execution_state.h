@@ -105,6 +105,20 @@ class GraphExecutionState {
       GraphDef&& graph_def, const GraphExecutionStateOptions& options,
       std::unique_ptr<GraphExecutionState>* out_state);
 
+  // Like `MakeForBaseGraph()`, but shares the placed and optimized base graph
+  // with the other live `GraphExecutionState`s made by this function for the
+  // same `graph_def`, devices and session config. Concurrent calls for the
+  // same graph wait for one of them to place it. The base graph is read-only
+  // after it's made, and `BuildGraph()` copies it, so the states only share
+  // the work of placing it and running the pre- and post-placement passes.
+  //
+  // Falls back to `MakeForBaseGraph()` when the state has to keep the
+  // GraphDef, that is if `place_pruned_graph` or
+  // `disable_optimize_for_static_graph` is set.
+  static Status MakeForSharedBaseGraph(
+      GraphDef&& graph_def, const GraphExecutionStateOptions& options,
+      std::unique_ptr<GraphExecutionState>* out_state);
+
   // Creates a new `GraphExecutionState` and `SimpleClientGraph`
   // for the subgraph of `original_graph_def` defined by
   // `subgraph_options`.
@@ -152,7 +166,7 @@ class GraphExecutionState {
 
   // The graph returned by BuildGraph may contain only the pruned
   // graph, whereas some clients may want access to the full graph.
-  const Graph* full_graph() { return graph_; }
+  const Graph* full_graph() { return graph_.get(); }
 
   // The original graph.
   GraphDef* original_graph_def() { return original_graph_def_.get(); }
@@ -190,7 +204,7 @@ class GraphExecutionState {
   // device names.
   std::unordered_map<string, string> stateful_placements_;  // Immutable after
                                                             // ctor.
-  void SaveStatefulNodes(Graph* graph);
+  void SaveStatefulNodes(const Graph* graph);
   void RestoreStatefulNodes(Graph* graph);
 
   // Extract the subset of the graph that needs to be run, adding feed/fetch
@@ -222,8 +236,9 @@ class GraphExecutionState {
   // objects created by `MakeForPrunedGraph()`.
   std::unique_ptr<subgraph::RewriteGraphMetadata> rewrite_metadata_;
 
-  // The dataflow graph owned by this object.
-  Graph* graph_;
+  // The dataflow graph, owned by this object or shared with the other states
+  // made by `MakeForSharedBaseGraph()`. Not modified after it's initialized.
+  std::shared_ptr<const Graph> graph_;
 
   // Whether to run Placer.
   bool run_placer_;
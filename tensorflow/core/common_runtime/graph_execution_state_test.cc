@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/graph_execution_state.h"
+
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/framework/device_factory.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class SharedBaseGraphTest : public ::testing::Test {
+ protected:
+  SharedBaseGraphTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")) {
+    device_set_.AddDevice(device_.get());
+    options_.device_set = &device_set_;
+    options_.session_options = &session_options_;
+  }
+
+  // Returns a graph that assigns `value` to a variable.
+  static GraphDef MakeGraph(float value) {
+    Graph g(OpRegistry::Global());
+    Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({}));
+    test::graph::Assign(
+        &g, var, test::graph::Constant(&g, test::AsScalar<float>(value)));
+    GraphDef def;
+    g.ToGraphDef(&def);
+    return def;
+  }
+
+  std::unique_ptr<GraphExecutionState> MakeState(GraphDef def) {
+    std::unique_ptr<GraphExecutionState> state;
+    TF_CHECK_OK(GraphExecutionState::MakeForSharedBaseGraph(std::move(def),
+                                                             options_, &state));
+    return state;
+  }
+
+  std::unique_ptr<Device> device_;
+  DeviceSet device_set_;
+  SessionOptions session_options_;
+  GraphExecutionStateOptions options_;
+};
+
+TEST_F(SharedBaseGraphTest, SharesPlacedGraphOfSameGraph) {
+  std::unique_ptr<GraphExecutionState> a = MakeState(MakeGraph(1.0));
+  std::unique_ptr<GraphExecutionState> b = MakeState(MakeGraph(1.0));
+  std::unique_ptr<GraphExecutionState> c = MakeState(MakeGraph(2.0));
+  ASSERT_NE(a->full_graph(), nullptr);
+  EXPECT_EQ(a->full_graph(), b->full_graph());
+  EXPECT_NE(a->full_graph(), c->full_graph());
+  EXPECT_EQ(a->GetStatefulPlacements(), b->GetStatefulPlacements());
+  for (const Node* n : b->full_graph()->op_nodes()) {
+    EXPECT_EQ(n->assigned_device_name(), device_->name());
+  }
+
+  // The graph is kept as long as a state refers to it.
+  const Graph* graph = a->full_graph();
+  a.reset();
+  EXPECT_EQ(MakeState(MakeGraph(1.0))->full_graph(), graph);
+}
+
+TEST_F(SharedBaseGraphTest, DoesNotShareGraphOfOtherConfig) {
+  std::unique_ptr<GraphExecutionState> a = MakeState(MakeGraph(1.0));
+  session_options_.config.set_allow_soft_placement(true);
+  std::unique_ptr<GraphExecutionState> b = MakeState(MakeGraph(1.0));
+  EXPECT_NE(a->full_graph(), b->full_graph());
+
+  // Nor when the state keeps the GraphDef.
+  session_options_.config.mutable_graph_options()->set_place_pruned_graph(
+      true);
+  EXPECT_EQ(MakeState(MakeGraph(1.0))->full_graph(), nullptr);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,299 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// Phases of the all-reduce, which tell apart the buffer keys of their steps.
+enum Phase {
+  kTaskReduceScatter = 0,
+  kCrossTaskReduceScatter = 1,
+  kCrossTaskAllGather = 2,
+  kTaskAllGather = 3,
+};
+
+// Returns the indices in `members` of the members of each task, with the tasks
+// and their members in the order of `members`.
+std::vector<std::vector<int>> MembersByTask(
+    const std::vector<CollGroupMember>& members) {
+  std::vector<std::vector<int>> tasks;
+  std::vector<const string*> task_names;
+  for (int i = 0; i < members.size(); ++i) {
+    int task = 0;
+    while (task < task_names.size() && *task_names[task] != members[i].task) {
+      ++task;
+    }
+    if (task == task_names.size()) {
+      task_names.push_back(&members[i].task);
+      tasks.emplace_back();
+    }
+    tasks[task].push_back(i);
+  }
+  return tasks;
+}
+
+}  // namespace
+
+Status HierarchicalRingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal(
+        "HierarchicalRingReduce only implements reductions");
+  }
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::InvalidArgument(
+        "HierarchicalRingReduce only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  const std::vector<std::vector<int>> tasks =
+      MembersByTask(col_params->group.members);
+  for (const std::vector<int>& task : tasks) {
+    if (task.size() != tasks[0].size()) {
+      return errors::InvalidArgument(
+          "HierarchicalRingReduce requires the same number of devices on "
+          "every task, but task ",
+          col_params->group.members[task[0]].task, " has ", task.size(),
+          " devices and task ", col_params->group.members[tasks[0][0]].task,
+          " has ", tasks[0].size());
+    }
+  }
+  return absl::OkStatus();
+}
+
+Status HierarchicalRingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalRingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like RingReducer, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+
+  Status s;
+  if (col_ctx_->output->NumElements() > 0) {
+    s = RunLevels();
+  }
+  if (!s.ok()) {
+    StartAbort(s);
+  }
+  done(s);
+}
+
+Status HierarchicalRingReducer::RunLevels() {
+  const std::vector<std::vector<int>> tasks =
+      MembersByTask(col_params_->group.members);
+  const int rank = col_params_->default_rank;
+  Ring task_ring;
+  Ring cross_task_ring;
+  for (int t = 0; t < tasks.size(); ++t) {
+    for (int d = 0; d < tasks[t].size(); ++d) {
+      if (tasks[t][d] != rank) continue;
+      task_ring.members = tasks[t];
+      task_ring.position = d;
+      for (const std::vector<int>& task : tasks) {
+        cross_task_ring.members.push_back(task[d]);
+      }
+      cross_task_ring.position = t;
+    }
+  }
+  if (task_ring.members.empty()) {
+    return errors::Internal("Rank ", rank, " is not in the group");
+  }
+  VLOG(1) << "HierarchicalRingReducer::Run for device "
+          << col_ctx_->device_name << " default_rank " << rank << " task "
+          << cross_task_ring.position << " of " << tasks.size()
+          << " position " << task_ring.position << " of "
+          << task_ring.members.size();
+
+  Allocator* allocator = col_ctx_->device->GetAllocator(
+      col_ctx_->op_ctx->output_alloc_attr(0));
+  std::unique_ptr<CollectiveAdapter> task_ca(MakeCollectiveAdapter(
+      col_ctx_->output, task_ring.members.size(), allocator));
+  Status s = ReduceScatter(task_ring, kTaskReduceScatter, task_ca.get());
+  // The tail shards of a small tensor can be empty, for all the members of
+  // the cross-task ring alike.
+  Tensor shard = task_ca->ChunkAlias(task_ring.position);
+  if (s.ok() && shard.NumElements() > 0) {
+    std::unique_ptr<CollectiveAdapter> cross_task_ca(MakeCollectiveAdapter(
+        &shard, cross_task_ring.members.size(), allocator));
+    s = ReduceScatter(cross_task_ring, kCrossTaskReduceScatter,
+                      cross_task_ca.get());
+    if (s.ok() && col_params_->final_op != nullptr) {
+      Tensor chunk = cross_task_ca->ChunkAlias(cross_task_ring.position);
+      Tensor group_size = cross_task_ca->Scalar(col_params_->group.group_size);
+      if (chunk.NumElements() > 0) {
+        s = collective_util::ComputeBinOp(
+            col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+            col_params_->final_op, &chunk, &group_size);
+      }
+    }
+    if (s.ok()) {
+      s = AllGather(cross_task_ring, kCrossTaskAllGather, cross_task_ca.get());
+    }
+  }
+  if (s.ok()) {
+    s = AllGather(task_ring, kTaskAllGather, task_ca.get());
+  }
+  task_ca->ConsumeFinalValue(col_ctx_->output);
+  return s;
+}
+
+Status HierarchicalRingReducer::ReduceScatter(const Ring& ring, int phase,
+                                              CollectiveAdapter* ca) {
+  const int n = ring.members.size();
+  // At each step, pass on the chunk reduced in the previous step and reduce
+  // the chunk before it, so that the last chunk reduced is this member's.
+  for (int step = 0; step < n - 1; ++step) {
+    const int send_idx = (ring.position - step - 1 + 2 * n) % n;
+    const int recv_idx = (ring.position - step - 2 + 2 * n) % n;
+    Tensor send_chunk = ca->ChunkAlias(send_idx);
+    Tensor recv_chunk = ca->ChunkAlias(recv_idx);
+    Tensor tmp_chunk = ca->TempChunk(recv_idx);
+    TF_RETURN_IF_ERROR(SendRecv(ring, phase, step, &send_chunk, &tmp_chunk));
+    if (recv_chunk.NumElements() == 0) continue;
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->merge_op, &recv_chunk, &tmp_chunk));
+  }
+  return absl::OkStatus();
+}
+
+Status HierarchicalRingReducer::AllGather(const Ring& ring, int phase,
+                                          CollectiveAdapter* ca) {
+  const int n = ring.members.size();
+  for (int step = 0; step < n - 1; ++step) {
+    Tensor send_chunk = ca->ChunkAlias((ring.position - step + n) % n);
+    Tensor recv_chunk = ca->ChunkAlias((ring.position - step - 1 + n) % n);
+    TF_RETURN_IF_ERROR(SendRecv(ring, phase, step, &send_chunk, &recv_chunk));
+  }
+  return absl::OkStatus();
+}
+
+Status HierarchicalRingReducer::SendRecv(const Ring& ring, int phase, int step,
+                                         const Tensor* send, Tensor* recv) {
+  const int n = ring.members.size();
+  const int self = ring.members[ring.position];
+  const int send_to = ring.members[(ring.position + 1) % n];
+  const int recv_from = ring.members[(ring.position + n - 1) % n];
+  const CollGroupMember& send_member = col_params_->group.members[send_to];
+  const CollGroupMember& recv_member = col_params_->group.members[recv_from];
+  auto buf_key = [this, phase, step](int sender) {
+    return strings::StrCat("HierarchicalRingReduce:", col_ctx_->exec_key, ":",
+                           phase, ":", step, ":", sender);
+  };
+
+  Notification send_done;
+  Notification recv_done;
+  Status send_status;
+  Status recv_status;
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      send_member.device.name(), send_member.task, buf_key(self),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), send, col_ctx_->device_locality,
+      col_ctx_->op_ctx->cancellation_manager(),
+      [this, &send_done, &send_status](const Status& s) {
+        if (!s.ok()) StartAbort(s);
+        send_status = s;
+        send_done.Notify();
+      });
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      recv_member.device.name(), recv_member.task, recv_member.is_local,
+      buf_key(recv_from), col_ctx_->device,
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), recv, col_ctx_->device_locality,
+      /*dev_to_dev_stream_index=*/0, col_ctx_->op_ctx->cancellation_manager(),
+      [this, &recv_done, &recv_status](const Status& s) {
+        if (!s.ok()) StartAbort(s);
+        recv_status = s;
+        recv_done.Notify();
+      });
+  send_done.WaitForNotification();
+  recv_done.WaitForNotification();
+  TF_RETURN_IF_ERROR(send_status);
+  return recv_status;
+}
+
+void HierarchicalRingReducer::StartAbort(const Status& s) {
+  {
+    mutex_lock l(status_mu_);
+    if (!status_.ok()) return;
+    LOG(ERROR) << "Aborting HierarchicalRingReduce with " << s;
+    status_ = s;
+  }
+  // A cancellation already cancels all the pending sends and recvs.
+  CancellationManager* cancel_mgr = col_ctx_->op_ctx->cancellation_manager();
+  if (cancel_mgr == nullptr ||
+      (!cancel_mgr->IsCancelled() && !cancel_mgr->IsCancelling())) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalRingReduce, HierarchicalRingReducer);
+}  // namespace
+
+}  // namespace tensorflow
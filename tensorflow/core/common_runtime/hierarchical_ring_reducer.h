@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Hierarchical implementation of collective all-reduce for CPU devices spread
+// over several tasks, selected with the "hierarchical" communication hint.
+//
+// The all-reduce runs in three levels:
+//  1. The tensor is reduce-scattered over a ring of the devices of each task,
+//     so that each device holds the task's sum of one shard.
+//  2. Each shard is all-reduced over a ring of the devices that hold it, one
+//     per task.
+//  3. The shards are all-gathered over the ring of each task.
+// Compared to a flat ring over the whole group, the data crossing the links
+// between tasks has the same volume, but it is sent over num_devices_per_task
+// independent rings in 2 * (num_tasks - 1) steps instead of
+// 2 * (group_size - 1).
+//
+// Devices on the same task share a host, so the rings of level 1 and 3 only
+// use intra-host links. Within a task, the devices are taken in the order of
+// the group ranks, which the param resolver derives from the device locality.
+class HierarchicalRingReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalRingReducer() = default;
+  ~HierarchicalRingReducer() override = default;
+
+  // Checks that the group is made of CPU devices, with the same number of
+  // devices on every task.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Runs the all-reduce. Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // A ring of members of the group.
+  struct Ring {
+    // Indices in col_params_->group.members, in ring order.
+    std::vector<int> members;
+    // Position of this device in `members`.
+    int position = 0;
+  };
+
+  // Runs the three levels of the all-reduce on the output.
+  Status RunLevels();
+
+  // Reduce-scatters the chunks of `ca` over `ring`, which has as many members
+  // as `ca` has chunks. Afterwards, the member at position p of `ring` holds
+  // the reduction of chunk p.
+  Status ReduceScatter(const Ring& ring, int phase, CollectiveAdapter* ca);
+
+  // All-gathers the chunks of `ca` over `ring`, the member at position p of
+  // `ring` providing chunk p.
+  Status AllGather(const Ring& ring, int phase, CollectiveAdapter* ca);
+
+  // Sends `send` to the next member of `ring` and receives `recv` from the
+  // previous one, and waits for both.
+  Status SendRecv(const Ring& ring, int phase, int step, const Tensor* send,
+                  Tensor* recv);
+
+  // Aborts the collective executor on the first error, so that the other
+  // members stop waiting for this one.
+  void StartAbort(const Status& s);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_ = nullptr;  // Not owned
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_RING_REDUCER_H_
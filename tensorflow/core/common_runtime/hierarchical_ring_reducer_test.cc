@@ -0,0 +1,197 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_ring_reducer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   Device* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder(absl::StrCat(op, "_node"), op)
+                  .Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+class HierarchicalRingReducerTest : public ::testing::Test {
+ protected:
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, DataType dtype, const TensorShape& shape,
+                   CollectiveTestEnv* test_env)
+        : test_env_(test_env), tensor_(dtype, shape) {
+      col_params_ =
+          CreateCollectiveParams(*test_env_, rank, "HierarchicalRingReduce",
+                                 REDUCTION_COLLECTIVE, dtype, shape);
+      string dev_name = col_params_->group.members[rank].device.name();
+      TF_CHECK_OK(test_env_->device_mgr->LookupDevice(dev_name, &device_));
+      merge_op_ = GetBinOp("Add", dtype, device_);
+      final_op_ = GetBinOp("Div", dtype, device_);
+      col_params_->merge_op = merge_op_.get();
+      col_params_->final_op = final_op_.get();
+    }
+
+    void DoReduce() {
+      status_ = RunCollective(test_env_, col_params_.get(), device_, &tensor_,
+                              &tensor_);
+    }
+
+    CollectiveTestEnv* test_env_;
+    Tensor tensor_;
+    Device* device_;
+    core::RefCountPtr<CollectiveParams> col_params_;
+    std::unique_ptr<OpKernel> merge_op_;
+    std::unique_ptr<OpKernel> final_op_;
+    Status status_;
+  };
+
+  template <typename T>
+  void RunTest(DataType dtype, int num_workers, int num_devices,
+               int tensor_len, int fail_after) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    test_env_->remote_access->set_fail_after(fail_after);
+    const int group_size = num_workers * num_devices;
+    std::vector<T> expected(tensor_len);
+    for (int rank = 0; rank < group_size; ++rank) {
+      instances_.push_back(std::make_unique<DeviceInstance>(
+          rank, dtype, TensorShape({tensor_len}), test_env_.get()));
+      auto flat = instances_.back()->tensor_.flat<T>();
+      for (int i = 0; i < tensor_len; ++i) {
+        // Small integer values, so that the floating point sums are exact
+        // whatever the order of the additions.
+        flat(i) = static_cast<T>(rank * 1000 + i);
+        expected[i] += flat(i);
+      }
+    }
+    for (int i = 0; i < tensor_len; ++i) {
+      expected[i] /= static_cast<T>(group_size);
+    }
+
+    std::atomic<int> done(0);
+    for (auto& instance : instances_) {
+      SchedClosure([&instance, &done] {
+        instance->DoReduce();
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+
+    for (const auto& instance : instances_) {
+      if (fail_after > 0) {
+        EXPECT_NE(instance->status_.message().find("Deliberate failure"),
+                  string::npos);
+      } else {
+        TF_EXPECT_OK(instance->status_);
+        test::ExpectTensorEqual<T>(test::AsTensor<T>(expected),
+                                   instance->tensor_);
+      }
+    }
+  }
+
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+  std::vector<std::unique_ptr<DeviceInstance>> instances_;
+};
+
+#define DEF_TEST(B, T, W, D, L, A)                                      \
+  TEST_F(HierarchicalRingReducerTest,                                   \
+         DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {                \
+    RunTest<T>(DT_##B, W, D, L, A);                                     \
+  }
+
+// Single task, which is a plain ring reduction.
+DEF_TEST(FLOAT, float, 1, 2, 1001, 0)
+// Single device per task, which is a plain ring reduction across tasks.
+DEF_TEST(FLOAT, float, 4, 1, 1001, 0)
+// Tensors smaller than the number of shards.
+DEF_TEST(FLOAT, float, 2, 2, 1, 0)
+DEF_TEST(FLOAT, float, 2, 4, 3, 0)
+DEF_TEST(FLOAT, float, 2, 2, 1001, 0)
+DEF_TEST(FLOAT, float, 3, 2, 4095, 0)
+DEF_TEST(FLOAT, float, 2, 4, 9408, 0)
+DEF_TEST(DOUBLE, double, 3, 3, 1001, 0)
+DEF_TEST(INT32, int32, 2, 3, 1001, 0)
+DEF_TEST(INT64, int64_t, 4, 2, 4096, 0)
+// Failure injection.
+DEF_TEST(FLOAT, float, 2, 2, 1001, 1)
+DEF_TEST(FLOAT, float, 2, 4, 9408, 7)
+
+TEST(HierarchicalRingReducerInitParamsTest, RejectsUnevenTasks) {
+  auto test_env = CreateCollectiveTestEnv(/*num_workers=*/2,
+                                          /*num_devices_per_worker=*/2,
+                                          DEVICE_CPU);
+  auto cp = CreateCollectiveParams(*test_env, /*rank=*/0,
+                                   "HierarchicalRingReduce",
+                                   REDUCTION_COLLECTIVE, DT_FLOAT,
+                                   TensorShape({8}));
+  core::RefCountPtr<HierarchicalRingReducer> reducer(
+      new HierarchicalRingReducer());
+  TF_EXPECT_OK(reducer->InitializeCollectiveParams(cp.get()));
+
+  cp->group.members.pop_back();
+  cp->group.group_size--;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reducer->InitializeCollectiveParams(cp.get())));
+}
+
+TEST(HierarchicalRingReducerInitParamsTest, RejectsNonCpuDevices) {
+  auto test_env = CreateCollectiveTestEnv(/*num_workers=*/2,
+                                          /*num_devices_per_worker=*/2,
+                                          DEVICE_CPU);
+  auto cp = CreateCollectiveParams(*test_env, /*rank=*/0,
+                                   "HierarchicalRingReduce",
+                                   REDUCTION_COLLECTIVE, DT_FLOAT,
+                                   TensorShape({8}));
+  cp->group.device_type = DeviceType(DEVICE_GPU);
+  core::RefCountPtr<HierarchicalRingReducer> reducer(
+      new HierarchicalRingReducer());
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reducer->InitializeCollectiveParams(cp.get())));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -40,6 +40,9 @@ ImmutableExecutorState::~ImmutableExecutorState() {
       params_.delete_kernel(item->kernel);
     }
   }
+  for (DeviceContext* device_context : device_context_map_) {
+    if (device_context != nullptr) device_context->Unref();
+  }
 }
 
 namespace {
@@ -259,9 +262,57 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
+  if (params_.build_flat_schedule && !requires_control_flow_) {
+    TF_RETURN_IF_ERROR(BuildFlatSchedule());
+  }
+  TF_RETURN_IF_ERROR(
+      params_.device->FillContextMap(&graph, &device_context_map_));
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
+Status ImmutableExecutorState::BuildFlatSchedule() {
+  DCHECK(!requires_control_flow_);
+  const int32_t num_nodes = gview_.num_nodes();
+  auto schedule = std::make_unique<FlatSchedule>();
+
+  // Lay out the successors of every node contiguously, in node ID order.
+  schedule->successor_offsets.resize(num_nodes + 1);
+  size_t num_successors = 0;
+  for (int32_t id = 0; id < num_nodes; ++id) {
+    schedule->successor_offsets[id] = num_successors;
+    const NodeItem* item = gview_.node(id);
+    if (item == nullptr) continue;
+    num_successors += item->num_output_edges + item->num_output_control_edges;
+  }
+  schedule->successor_offsets[num_nodes] = num_successors;
+  schedule->successors.reserve(num_successors);
+  for (int32_t id = 0; id < num_nodes; ++id) {
+    const NodeItem* item = gview_.node(id);
+    if (item == nullptr) continue;
+    for (const EdgeInfo& e : item->output_edges()) {
+      FlatSchedule::Successor s;
+      s.dst = &gview_.node_ref(e.dst_id);
+      s.dst_id = e.dst_id;
+      s.input_slot = e.input_slot;
+      s.output_slot = e.output_slot;
+      s.is_last = e.is_last;
+      schedule->successors.push_back(s);
+    }
+    for (const ControlEdgeInfo& e : item->output_control_edges()) {
+      FlatSchedule::Successor s;
+      s.dst = &gview_.node_ref(e.dst_id);
+      s.dst_id = e.dst_id;
+      s.input_slot = -1;
+      s.output_slot = 0;
+      s.is_last = false;
+      schedule->successors.push_back(s);
+    }
+  }
+
+  flat_schedule_ = std::move(schedule);
+  return absl::OkStatus();
+}
+
 namespace {
 // If a Node has been marked to use a ScopedAllocator x for output i, then
 // sc_attr will contain the subsequence (i, x) at an even offset.  This function
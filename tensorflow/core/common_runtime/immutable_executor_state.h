@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/platform/macros.h"
@@ -74,6 +75,40 @@ class ImmutableExecutorState {
     int32 parallel_iterations;
   };
 
+  // A compact representation of a graph without v1 control flow, built once
+  // when the executor is created. All successors are stored contiguously in a
+  // single array ordered by source node ID, so propagating the outputs of a
+  // node reads one contiguous range without touching the variable-length
+  // `NodeItem` records of the node or its successors.
+  struct FlatSchedule {
+    struct Successor {
+      // The destination node, and its ID.
+      const NodeItem* dst;
+      int32 dst_id;
+      // The location in the input tensor array that this edge writes to, or -1
+      // for a control edge.
+      int32 input_slot;
+      // The index of the source output that produces the value on this edge.
+      int32 output_slot : 31;
+      // True if this is the last data edge consuming `output_slot`, which
+      // allows the value to be moved instead of copied.
+      bool is_last : 1;
+    };
+
+    // Returns the successors of the node with the given ID. Data edges come
+    // before control edges.
+    gtl::ArraySlice<Successor> successors_of(int32 node_id) const {
+      return gtl::ArraySlice<Successor>(
+          successors.data() + successor_offsets[node_id],
+          successor_offsets[node_id + 1] - successor_offsets[node_id]);
+    }
+
+    // `successor_offsets[i]` is the index in `successors` of the first
+    // successor of node `i`. Has `num_nodes + 1` entries.
+    std::vector<int32> successor_offsets;
+    std::vector<Successor> successors;
+  };
+
   explicit ImmutableExecutorState(const LocalExecutorParams& p)
       : params_(p), gview_() {}
   ~ImmutableExecutorState();
@@ -101,6 +136,17 @@ class ImmutableExecutorState {
 
   bool requires_control_flow_support() const { return requires_control_flow_; }
 
+  // Returns the device context to execute the node with id `id` with, or
+  // nullptr if it uses the device context of the step.
+  DeviceContext* device_context(int id) const {
+    return id < device_context_map_.size() ? device_context_map_[id] : nullptr;
+  }
+
+  // Returns the flat schedule for this graph, or nullptr if
+  // `params().build_flat_schedule` is false or the graph requires control flow
+  // support.
+  const FlatSchedule* flat_schedule() const { return flat_schedule_.get(); }
+
   // Copies the pending counts for nodes in this graph to the given array.
   //
   // This method provides a more efficient way of initializing
@@ -125,6 +171,7 @@ class ImmutableExecutorState {
   static Status BuildControlFlowInfo(const Graph* graph,
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
+  Status BuildFlatSchedule();
 
   FrameInfo* EnsureFrameInfo(const string& fname);
 
@@ -144,6 +191,11 @@ class ImmutableExecutorState {
       frame_info_;
   const FrameInfo* root_frame_info_;  // Not owned.
 
+  // The device contexts of the nodes, indexed by node ID, from
+  // Device::FillContextMap(). Empty if all the nodes use the device context of
+  // the step. Owns one reference on each context.
+  std::vector<DeviceContext*> device_context_map_;
+
   // If the graph contains any "Enter" or "RefEnter" nodes, this vector maps
   // dense node IDs to the corresponding FrameInfo.
   std::vector<FrameInfo*> enter_frame_info_;
@@ -152,6 +204,9 @@ class ImmutableExecutorState {
   // pending counts for the nodes in the graph, indexed by node ID.
   std::unique_ptr<std::atomic<int32>[]> atomic_pending_counts_;
 
+  // See `flat_schedule()`.
+  std::unique_ptr<FlatSchedule> flat_schedule_;
+
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
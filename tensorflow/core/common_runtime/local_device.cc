@@ -152,10 +152,16 @@ LocalDevice::LocalDevice(const SessionOptions& options,
     }
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
-    // computations.
-    // TODO(tucker): NUMA for these too?
+    // computations, pinned to the device's NUMA node if NUMA affinity is
+    // enabled.
+    int numa_node = port::kNUMANoAffinity;
+    Allocator* numa_allocator = nullptr;
+    if (options.config.experimental().use_numa_affinity()) {
+      numa_node = attributes.locality().numa_node();
+      numa_allocator = ProcessState::singleton()->GetCPUAllocator(numa_node);
+    }
     owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
-        options, port::kNUMANoAffinity, nullptr));
+        options, numa_node, numa_allocator));
     tp_info = owned_tp_info_.get();
   }
 
@@ -50,6 +50,30 @@ struct LocalExecutorParams {
 
   // Whether control flow nodes are allowed to be executed synchronously.
   bool allow_control_flow_sync_execution = false;
+
+  // If true, and the graph does not require control flow support, the
+  // executor builds a compact `ImmutableExecutorState::FlatSchedule` that the
+  // propagator uses instead of walking each `NodeItem`'s edge trailers.
+  bool build_flat_schedule = false;
+
+  // If true, async kernel completions that arrive while another completion of
+  // the same step is being propagated are queued, and the propagating thread
+  // processes them as one batch with a single update of the outstanding-op
+  // count and a single `ScheduleReady()` call. Ignored when all kernels run
+  // inline.
+  bool batch_async_completions = false;
+
+  // If positive, the executor measures the cost of every synchronous kernel
+  // during the first `adaptive_inlining_steps` steps, and from then on runs a
+  // node inline iff its mean measured cost is below the threshold used for
+  // `OpKernel::IsExpensive()` kernels, regardless of what the kernel declares.
+  // The decisions are logged at VLOG(1).
+  int adaptive_inlining_steps = 0;
+
+  // If true, an executor that runs nodes in a fixed sequential order records
+  // the output sizes of its first step, plans the lifetimes of the outputs into
+  // a single arena, and serves outputs from that arena in later steps.
+  bool plan_memory = false;
 };
 
 }  // end namespace tensorflow
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/cc/client/client_session.h"
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
+#include "tensorflow/core/config/flag_defs.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
@@ -56,10 +58,10 @@ SessionOptions SessionOptionsWithInlining() {
   return session_options;
 }
 
-Status Rewrite(std::unique_ptr<Graph>* graph) {
+Status Rewrite(std::unique_ptr<Graph>* graph,
+               SessionOptions session_options = SessionOptionsWithInlining()) {
   FunctionLibraryDefinition flib_def((*graph)->flib_def());
   GraphOptimizationPassOptions opt_options;
-  SessionOptions session_options = SessionOptionsWithInlining();
   opt_options.session_options = &session_options;
   opt_options.graph = graph;
   opt_options.flib_def = &flib_def;
@@ -133,6 +135,64 @@ TEST(LowerFunctionCallTest, InlineFunctionCall) {
   }
 }
 
+TEST(LowerFunctionCallTest, InlineSmallSingleDeviceFunctionCalls) {
+  using FDH = FunctionDefHelper;
+  flags::Global().inline_small_function_calls.reset(true);
+
+  FunctionDefLibrary f_lib_proto;
+  *(f_lib_proto.add_function()) =
+      FDH::Create("AddAndMul", {"i: int32"}, {"o: int32"}, {},
+                  {{{"add"}, "Add", {"i", "i"}, {{"T", DT_INT32}}},
+                   {{"ret"}, "Mul", {"add:z:0", "i"}, {{"T", DT_INT32}}}},
+                  /*ret_def=*/{{"o", "ret:z:0"}});
+  *(f_lib_proto.add_function()) = FDH::Create(
+      "AddAndMulOnTwoDevices", {"i: int32"}, {"o: int32"}, {},
+      {{{"add"}, "Add", {"i", "i"}, {{"T", DT_INT32}}, {}, "/device:CPU:0"},
+       {{"ret"},
+        "Mul",
+        {"add:z:0", "i"},
+        {{"T", DT_INT32}},
+        {},
+        "/device:CPU:1"}},
+      /*ret_def=*/{{"o", "ret:z:0"}});
+
+  // Construct a graph:
+  //   A = Placeholder[dtype=int32]
+  //   B = PartitionedCall[f=AddAndMul](A)
+  //   C = PartitionedCall[f=AddAndMulOnTwoDevices](A)
+  Scope root = Scope::NewRootScope().ExitOnError();
+  TF_ASSERT_OK(root.graph()->AddFunctionLibrary(f_lib_proto));
+  auto a = ops::Placeholder(root.WithOpName("A"), DT_INT32);
+  std::vector<NodeBuilder::NodeOut> inputs({NodeBuilder::NodeOut(a.node())});
+  for (const char* name : {"AddAndMul", "AddAndMulOnTwoDevices"}) {
+    Node* function_call;
+    TF_ASSERT_OK(NodeBuilder(absl::StrCat("Call", name), "PartitionedCall",
+                             &root.graph()->flib_def())
+                     .Input(inputs)
+                     .Attr("Tin", {DT_INT32})
+                     .Attr("Tout", {DT_INT32})
+                     .Attr("f", FuncAttr(name))
+                     .Finalize(root.graph(), &function_call));
+    TF_ASSERT_OK(root.DoShapeInference(function_call));
+  }
+
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+  // Without do_function_inlining, only the single-device call is inlined.
+  TF_ASSERT_OK(Rewrite(&graph, SessionOptions()));
+  flags::Global().inline_small_function_calls.reset(false);
+
+  std::vector<string> partitioned_calls;
+  int mul_count = 0;
+  for (const auto* op : graph->op_nodes()) {
+    if (op->IsPartitionedCall()) partitioned_calls.push_back(op->name());
+    if (op->type_string() == "Mul") mul_count++;
+  }
+  EXPECT_EQ(partitioned_calls,
+            std::vector<string>({"CallAddAndMulOnTwoDevices"}));
+  EXPECT_EQ(mul_count, 1);
+}
+
 TEST(LowerFunctionCallTest, DoNotInlineTpuOrXlaFunctions) {
   std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/lower_function_call_op.h"
 #include "tensorflow/core/common_runtime/lower_if_op.h"
 #include "tensorflow/core/common_runtime/lower_while_op.h"
+#include "tensorflow/core/config/flag_defs.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -43,6 +44,10 @@ constexpr const char* const kTpuReplicateAttr = "_tpu_replicate";
 constexpr const char* const kXlaClusterAttr = "_xla_compile_id";
 constexpr const char* const kXlaMustCompileAttr = "_XlaMustCompile";
 
+// The maximum number of nodes of the functions whose calls are inlined with
+// the `inline_small_function_calls` flag.
+constexpr int kMaxSmallFunctionNodes = 16;
+
 // Checks if boolean attribute is defined and it's value is 'true'.
 bool CheckBoolAttr(const Node* n, absl::string_view attr_name) {
   bool match;
@@ -74,6 +79,38 @@ bool MarkedForXlaCompilation(const Node* n) {
          CheckBoolAttr(n, kXlaMustCompileAttr);
 }
 
+// Returns true if `n` is a PartitionedCall of a function with at most
+// kMaxSmallFunctionNodes nodes, all on the same device if any, that calls no
+// other function. Running such a function through the function library
+// runtime, with its own executor, costs more than running its few ops in the
+// executor of the caller.
+bool IsSmallSingleDeviceFunctionCall(
+    const Node* n, const FunctionLibraryDefinition& flib_def) {
+  if (!n->IsPartitionedCall()) return false;
+  const NameAttrList* func;
+  if (!TryGetNodeAttr(n->attrs(), "f", &func)) return false;
+  const FunctionDef* fdef = flib_def.Find(func->name());
+  if (fdef == nullptr || fdef->node_def_size() > kMaxSmallFunctionNodes) {
+    return false;
+  }
+  const string* device = nullptr;
+  for (const NodeDef& node : fdef->node_def()) {
+    if (flib_def.Contains(node.op())) return false;
+    for (const auto& attr : node.attr()) {
+      if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+        return false;
+      }
+    }
+    if (node.device().empty()) continue;
+    if (device == nullptr) {
+      device = &node.device();
+    } else if (*device != node.device()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool HasArgsOrRetvals(const Graph& g) {
   for (const Node* n : g.op_nodes()) {
     if (n->IsArg() || n->IsRetval()) return true;
@@ -125,6 +162,9 @@ Status LowerFunctionalOpsPass::Run(
       options.session_options && options.session_options->config.graph_options()
                                      .optimizer_options()
                                      .do_function_inlining();
+  // Otherwise, optionally inline only the calls of small functions.
+  const bool inline_small_function_calls =
+      flags::Global().inline_small_function_calls.value();
 
   // If graph is a function instantiation, it will have `_Arg` and `_Retval`
   // nodes for input and output tensors. Otherwise it's unsafe to remove any of
@@ -170,7 +210,9 @@ Status LowerFunctionalOpsPass::Run(
 
     // Always lower function calls produced by lowering If/While nodes.
     if (IsFunctionCall(*flib_def, *n) && !used_by_xla(n) &&
-        (lower_function_calls || LowerAsMultiDeviceFunctionIsOn(n))) {
+        (lower_function_calls || LowerAsMultiDeviceFunctionIsOn(n) ||
+         (inline_small_function_calls &&
+          IsSmallSingleDeviceFunctionCall(n, *flib_def)))) {
       TF_RETURN_IF_ERROR(RewriteFunctionCallNode(n, g, *flib_def,
                                                  keep_lowered_nodes_fetchable));
       continue;
@@ -0,0 +1,183 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t multiple) {
+  return (n + multiple - 1) & ~(multiple - 1);
+}
+
+}  // namespace
+
+size_t PlanArenaOffsets(std::vector<PlannedBuffer>* buffers,
+                        size_t alignment) {
+  std::vector<int> order(buffers->size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [buffers](int a, int b) {
+    return (*buffers)[a].size > (*buffers)[b].size;
+  });
+
+  size_t arena_bytes = 0;
+  std::vector<int> placed;
+  placed.reserve(order.size());
+  std::vector<const PlannedBuffer*> conflicts;
+  for (int index : order) {
+    PlannedBuffer& buffer = (*buffers)[index];
+    // Collect the placed buffers that are live at the same time, in order of
+    // offset, and take the first gap between them that is large enough.
+    conflicts.clear();
+    for (int other_index : placed) {
+      const PlannedBuffer& other = (*buffers)[other_index];
+      if (other.first_use <= buffer.last_use &&
+          buffer.first_use <= other.last_use) {
+        conflicts.push_back(&other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const PlannedBuffer* a, const PlannedBuffer* b) {
+                return a->offset < b->offset;
+              });
+    size_t offset = 0;
+    for (const PlannedBuffer* other : conflicts) {
+      if (offset + buffer.size <= other->offset) break;
+      offset = std::max(offset, RoundUp(other->offset + other->size, alignment));
+    }
+    buffer.offset = offset;
+    arena_bytes = std::max(arena_bytes, offset + buffer.size);
+    placed.push_back(index);
+  }
+  return RoundUp(arena_bytes, alignment);
+}
+
+/* static */
+PlannedArenaAllocator* PlannedArenaAllocator::Create(
+    std::shared_ptr<const MemoryPlan> plan, Allocator* underlying) {
+  char* arena = nullptr;
+  if (plan->arena_bytes > 0) {
+    arena = static_cast<char*>(underlying->AllocateRaw(
+        Allocator::kAllocatorAlignment, plan->arena_bytes));
+    if (arena == nullptr) return nullptr;
+  }
+  return new PlannedArenaAllocator(std::move(plan), underlying, arena);
+}
+
+PlannedArenaAllocator::PlannedArenaAllocator(
+    std::shared_ptr<const MemoryPlan> plan, Allocator* underlying, char* arena)
+    : plan_(std::move(plan)), underlying_(underlying), arena_(arena) {}
+
+PlannedArenaAllocator::~PlannedArenaAllocator() {
+  if (arena_ != nullptr) {
+    underlying_->DeallocateRaw(arena_);
+  }
+}
+
+void PlannedArenaAllocator::BeginNode(int node) {
+  mutex_lock l(mu_);
+  DCHECK_LT(node, plan_->node_slots.size());
+  node_slots_ = &plan_->node_slots[node];
+  slot_used_.assign(node_slots_->size(), false);
+}
+
+void PlannedArenaAllocator::EndStep() {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!step_ended_);
+    step_ended_ = true;
+    node_slots_ = nullptr;
+    delete_self = num_outstanding_ == 0;
+    VLOG(2) << "Planned arena of " << plan_->arena_bytes << " bytes served "
+            << num_planned_ << " allocations; " << num_unplanned_
+            << " were forwarded to " << underlying_->Name();
+  }
+  if (delete_self) delete this;
+}
+
+bool PlannedArenaAllocator::OverlapsLive(size_t offset, size_t size) const {
+  // `live_` holds disjoint ranges, so only the last one that starts before the
+  // end of the candidate can overlap it.
+  auto it = live_.lower_bound(offset + size);
+  if (it == live_.begin()) return false;
+  --it;
+  return it->first + it->second > offset;
+}
+
+void* PlannedArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  {
+    mutex_lock l(mu_);
+    DCHECK(!step_ended_);
+    ++num_outstanding_;
+    if (node_slots_ != nullptr && num_bytes > 0 &&
+        alignment <= Allocator::kAllocatorAlignment) {
+      for (size_t i = 0; i < node_slots_->size(); ++i) {
+        const MemoryPlan::Slot& slot = (*node_slots_)[i];
+        if (slot_used_[i] || slot.size < num_bytes ||
+            OverlapsLive(slot.offset, num_bytes)) {
+          continue;
+        }
+        slot_used_[i] = true;
+        live_.emplace(slot.offset, num_bytes);
+        ++num_planned_;
+        return arena_ + slot.offset;
+      }
+    }
+    ++num_unplanned_;
+  }
+  void* ptr = underlying_->AllocateRaw(alignment, num_bytes);
+  if (ptr == nullptr) {
+    mutex_lock l(mu_);
+    --num_outstanding_;
+  }
+  return ptr;
+}
+
+void PlannedArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  char* p = static_cast<char*>(ptr);
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    if (arena_ != nullptr && p >= arena_ && p < arena_ + plan_->arena_bytes) {
+      const size_t erased = live_.erase(p - arena_);
+      DCHECK_EQ(erased, 1);
+    } else {
+      underlying_->DeallocateRaw(ptr);
+    }
+    --num_outstanding_;
+    delete_self = step_ended_ && num_outstanding_ == 0;
+  }
+  if (delete_self) delete this;
+}
+
+int64_t PlannedArenaAllocator::num_planned() const {
+  mutex_lock l(mu_);
+  return num_planned_;
+}
+
+int64_t PlannedArenaAllocator::num_unplanned() const {
+  mutex_lock l(mu_);
+  return num_unplanned_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A buffer whose lifetime is known ahead of time, in terms of the positions of
+// the nodes of a sequential schedule that first and last use it.
+struct PlannedBuffer {
+  int first_use = 0;
+  int last_use = 0;
+  size_t size = 0;
+
+  // Set by `PlanArenaOffsets()`.
+  size_t offset = 0;
+};
+
+// Assigns an offset within a single arena to each of `buffers`, such that no
+// two buffers whose lifetimes overlap share memory, and returns the total
+// size of the arena. Offsets are multiples of `alignment`, a power of two.
+//
+// Like TensorFlow Lite's ArenaPlanner, buffers are placed greedily in order
+// of decreasing size, each at the lowest offset that fits between the buffers
+// already placed with overlapping lifetimes.
+size_t PlanArenaOffsets(std::vector<PlannedBuffer>* buffers, size_t alignment);
+
+// The arena layout of the outputs of a sequentially executed graph.
+struct MemoryPlan {
+  struct Slot {
+    size_t offset;
+    size_t size;
+  };
+  // `node_slots[i]` holds the arena regions reserved for the outputs of the
+  // node at position `i` of the schedule.
+  std::vector<std::vector<Slot>> node_slots;
+  size_t arena_bytes = 0;
+};
+
+// An allocator that serves the outputs of each node of one step from the
+// regions of a single arena that a `MemoryPlan` reserves for that node.
+//
+// The executor calls `BeginNode(i)` before running the node at position `i`.
+// An allocation made while node `i` runs takes the first of its unused slots
+// that is large enough, unless that region still holds a tensor that is live
+// beyond its planned lifetime, e.g. because it was forwarded to a later
+// output or stored in a resource. Every other request, including those that
+// need more than `Allocator::kAllocatorAlignment` alignment, is forwarded to
+// the underlying allocator. Misplanned sizes or lifetimes therefore cost
+// locality, never correctness.
+//
+// The executor calls `EndStep()` once the step is done; the allocator deletes
+// itself, and frees the arena, when its last outstanding allocation has been
+// deallocated. This class is thread-safe, but `BeginNode()` assumes that nodes
+// run one at a time.
+class PlannedArenaAllocator : public Allocator {
+ public:
+  // Returns nullptr if the arena cannot be allocated from `underlying`.
+  static PlannedArenaAllocator* Create(std::shared_ptr<const MemoryPlan> plan,
+                                       Allocator* underlying);
+
+  PlannedArenaAllocator(const PlannedArenaAllocator&) = delete;
+  void operator=(const PlannedArenaAllocator&) = delete;
+
+  void BeginNode(int node) TF_LOCKS_EXCLUDED(mu_);
+  void EndStep() TF_LOCKS_EXCLUDED(mu_);
+
+  std::string Name() override { return "planned_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override
+      TF_LOCKS_EXCLUDED(mu_);
+  void DeallocateRaw(void* ptr) override TF_LOCKS_EXCLUDED(mu_);
+  AllocatorMemoryType GetMemoryType() const override {
+    return underlying_->GetMemoryType();
+  }
+
+  // The number of allocations that were served from the arena, and that were
+  // forwarded to the underlying allocator.
+  int64_t num_planned() const TF_LOCKS_EXCLUDED(mu_);
+  int64_t num_unplanned() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  PlannedArenaAllocator(std::shared_ptr<const MemoryPlan> plan,
+                        Allocator* underlying, char* arena);
+  ~PlannedArenaAllocator() override;
+
+  // Returns true if [offset, offset + size) overlaps a live arena allocation.
+  bool OverlapsLive(size_t offset, size_t size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::shared_ptr<const MemoryPlan> plan_;
+  Allocator* const underlying_;  // Not owned.
+  char* const arena_;
+
+  mutable mutex mu_;
+  // The slots of the current node, and which of them have been handed out.
+  const std::vector<MemoryPlan::Slot>* node_slots_ TF_GUARDED_BY(mu_) =
+      nullptr;
+  std::vector<bool> slot_used_ TF_GUARDED_BY(mu_);
+  // Live arena allocations, by offset, with their sizes.
+  std::map<size_t, size_t> live_ TF_GUARDED_BY(mu_);
+  int64_t num_outstanding_ TF_GUARDED_BY(mu_) = 0;
+  bool step_ended_ TF_GUARDED_BY(mu_) = false;
+  int64_t num_planned_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_unplanned_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
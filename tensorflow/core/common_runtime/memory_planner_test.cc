@@ -0,0 +1,133 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+PlannedBuffer Buffer(int first_use, int last_use, size_t size) {
+  PlannedBuffer buffer;
+  buffer.first_use = first_use;
+  buffer.last_use = last_use;
+  buffer.size = size;
+  return buffer;
+}
+
+TEST(PlanArenaOffsetsTest, ReusesMemoryOfDisjointLifetimes) {
+  std::vector<PlannedBuffer> buffers = {Buffer(0, 1, 128), Buffer(1, 2, 128),
+                                        Buffer(2, 3, 128)};
+  EXPECT_EQ(256u, PlanArenaOffsets(&buffers, 64));
+  EXPECT_NE(buffers[0].offset, buffers[1].offset);
+  EXPECT_NE(buffers[1].offset, buffers[2].offset);
+  EXPECT_EQ(buffers[0].offset, buffers[2].offset);
+}
+
+TEST(PlanArenaOffsetsTest, FillsGaps) {
+  // The largest buffer is placed first; the two small ones do not overlap
+  // each other and share the region after it.
+  std::vector<PlannedBuffer> buffers = {Buffer(0, 0, 64), Buffer(0, 2, 256),
+                                        Buffer(1, 2, 64)};
+  EXPECT_EQ(320u, PlanArenaOffsets(&buffers, 64));
+  EXPECT_EQ(0u, buffers[1].offset);
+  EXPECT_EQ(256u, buffers[0].offset);
+  EXPECT_EQ(256u, buffers[2].offset);
+}
+
+TEST(PlanArenaOffsetsTest, AlignsOffsets) {
+  std::vector<PlannedBuffer> buffers = {Buffer(0, 1, 100), Buffer(0, 1, 10),
+                                        Buffer(0, 1, 1)};
+  const size_t arena_bytes = PlanArenaOffsets(&buffers, 64);
+  EXPECT_EQ(0u, arena_bytes % 64);
+  for (const PlannedBuffer& buffer : buffers) {
+    EXPECT_EQ(0u, buffer.offset % 64);
+    EXPECT_LE(buffer.offset + buffer.size, arena_bytes);
+  }
+}
+
+std::shared_ptr<const MemoryPlan> TwoNodePlan() {
+  auto plan = std::make_shared<MemoryPlan>();
+  // Both nodes were planned to reuse the same region.
+  plan->node_slots = {{{0, 256}}, {{0, 256}}};
+  plan->arena_bytes = 256;
+  return plan;
+}
+
+TEST(PlannedArenaAllocatorTest, ServesPlannedSlots) {
+  PlannedArenaAllocator* a =
+      PlannedArenaAllocator::Create(TwoNodePlan(), cpu_allocator());
+  ASSERT_NE(a, nullptr);
+  a->BeginNode(0);
+  void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 200);
+  ASSERT_NE(p0, nullptr);
+  memset(p0, 0, 200);
+  // The only slot of node 0 has been handed out.
+  void* extra = a->AllocateRaw(Allocator::kAllocatorAlignment, 16);
+  a->DeallocateRaw(p0);
+  a->BeginNode(1);
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  EXPECT_EQ(p0, p1);
+  EXPECT_EQ(2, a->num_planned());
+  EXPECT_EQ(1, a->num_unplanned());
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(extra);
+  a->EndStep();
+}
+
+TEST(PlannedArenaAllocatorTest, ForwardsWhenSlotIsStillLive) {
+  PlannedArenaAllocator* a =
+      PlannedArenaAllocator::Create(TwoNodePlan(), cpu_allocator());
+  ASSERT_NE(a, nullptr);
+  a->BeginNode(0);
+  void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  a->BeginNode(1);
+  // `p0` outlived its planned lifetime, so node 1 may not reuse its region.
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  EXPECT_NE(p0, p1);
+  // Oversized and overaligned requests are forwarded as well.
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  void* p3 = a->AllocateRaw(2 * Allocator::kAllocatorAlignment, 16);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p3) %
+                (2 * Allocator::kAllocatorAlignment));
+  EXPECT_EQ(1, a->num_planned());
+  EXPECT_EQ(3, a->num_unplanned());
+  for (void* p : {p0, p1, p2, p3}) a->DeallocateRaw(p);
+  a->EndStep();
+}
+
+TEST(PlannedArenaAllocatorTest, TensorOutlivesStep) {
+  PlannedArenaAllocator* a =
+      PlannedArenaAllocator::Create(TwoNodePlan(), cpu_allocator());
+  ASSERT_NE(a, nullptr);
+  a->BeginNode(0);
+  Tensor t(a, DT_FLOAT, TensorShape({4}));
+  a->EndStep();
+  // `t` keeps the arena alive, and deletes the allocator when destroyed.
+  auto flat = t.flat<float>();
+  for (int i = 0; i < 4; ++i) flat(i) = i;
+  EXPECT_EQ(flat(3), 3.0f);
+}
+
+}  // namespace
+}  // namespace tensorflow
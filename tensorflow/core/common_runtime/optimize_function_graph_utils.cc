@@ -18,14 +18,18 @@ limitations under the License.
 #include <cstdlib>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/composite_device.h"
@@ -48,7 +52,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/util/debug_data_dumper.h"
 #include "tsl/platform/env.h"
@@ -257,6 +264,98 @@ string GetFileCacheName(const string& dir_name, const string& function_name,
                       fdef->node_def_size());
 }
 
+// The maximum number of optimized function graphs kept in memory. Functions
+// instantiated once the cache is full are optimized every time.
+constexpr int kMaxInMemoryCacheEntries = 256;
+
+// Optimized function graphs of the whole process, keyed by
+// GetInMemoryCacheKey(). The graphs are stored as protos since
+// OptimizedFunctionGraphInfo can't be copied.
+class InMemoryFunctionGraphCache {
+ public:
+  static InMemoryFunctionGraphCache* Global() {
+    static InMemoryFunctionGraphCache* cache = new InMemoryFunctionGraphCache;
+    return cache;
+  }
+
+  // Returns a copy of the graph cached for `key`, or nullopt if there's none.
+  std::optional<OptimizedFunctionGraph> Find(const Fprint128& key) {
+    tf_shared_lock l(mu_);
+    auto it = graphs_.find(key);
+    if (it == graphs_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  void Insert(const Fprint128& key, OptimizedFunctionGraph&& graph) {
+    mutex_lock l(mu_);
+    if (graphs_.size() >= kMaxInMemoryCacheEntries) return;
+    graphs_.emplace(key, std::move(graph));
+  }
+
+ private:
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, OptimizedFunctionGraph, Fprint128Hasher>
+      graphs_ TF_GUARDED_BY(mu_);
+};
+
+bool InMemoryGraphCachingEnabled() {
+  const char* value = getenv(kInMemoryGraphCachingEnvVariableName);
+  if (value == nullptr) return false;
+  const string lower_value = absl::AsciiStrToLower(value);
+  return lower_value == "1" || lower_value == "true";
+}
+
+// Returns the key of the optimized graph of `fdef` in the in-memory cache.
+// The function library is fingerprinted by content rather than by address, so
+// that the ProcessFunctionLibraryRuntimes of the replicas of a model, each with
+// its own copy of the library, share the optimized graphs.
+Fprint128 GetInMemoryCacheKey(
+    const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    const FunctionDef& fdef, const FunctionLibraryDefinition& lib_def,
+    const DeviceSet& dev_set,
+    const std::vector<CompositeDevice*>& composite_devices,
+    const Device* cpu_device, const Device* default_device) {
+  // Neither the address of the library nor the state handle are read by the
+  // optimization passes.
+  FunctionLibraryRuntime::InstantiateOptions key_options = options;
+  key_options.lib_def = nullptr;
+  key_options.state_handle.clear();
+  string key = Canonicalize(function_name, attrs, key_options);
+
+  // Sorts the reachable functions so that the key doesn't depend on the order
+  // in which they were added to the library.
+  FunctionDefLibrary library = lib_def.ReachableDefinitions(fdef).ToProto();
+  *library.add_function() = fdef;
+  std::sort(library.mutable_function()->begin(),
+            library.mutable_function()->end(),
+            [](const FunctionDef& a, const FunctionDef& b) {
+              return a.signature().name() < b.signature().name();
+            });
+  std::sort(library.mutable_gradient()->begin(),
+            library.mutable_gradient()->end(),
+            [](const GradientDef& a, const GradientDef& b) {
+              return a.function_name() < b.function_name();
+            });
+  string serialized_library;
+  SerializeToStringDeterministic(library, &serialized_library);
+  absl::StrAppend(&key, "|", serialized_library);
+
+  std::vector<string> device_names;
+  device_names.reserve(dev_set.devices().size());
+  for (const Device* device : dev_set.devices()) {
+    device_names.push_back(device->name());
+  }
+  std::sort(device_names.begin(), device_names.end());
+  absl::StrAppend(&key, "|", absl::StrJoin(device_names, ","), "|");
+  for (const CompositeDevice* device : composite_devices) {
+    absl::StrAppend(&key, device->name(), ",");
+  }
+  absl::StrAppend(&key, "|", cpu_device ? cpu_device->name() : "", "|",
+                  default_device ? default_device->name() : "");
+  return Fingerprint128(key);
+}
+
 // Generates graph and return information given the input function name,
 // attributes and function definition.
 Status GetGraphAndArgRets(const string& function_name, AttrSlice attrs,
@@ -664,12 +763,16 @@ OptimizeFunctionGraphOrReadFromFileCache(
   // (1) This function is not eligible for caching.
   // (2) This function is eligible for caching and its cache exists.
   // (3) This function is eligible for caching and its cache does not exist.
+  // The in-memory cache is checked before the file cache, and is filled with
+  // the graphs read from the file cache or optimized.
 
   // Get the caching directory from Env variable.
   const string dir_name = absl::StrCat(getenv(kGraphCachingEnvVariableName));
+  const bool in_memory_caching = InMemoryGraphCachingEnabled();
 
   // Scenario (1): Not eligible for caching. Run the optimization passes.
-  if (dir_name.empty() || options.is_component_function) {
+  if ((dir_name.empty() && !in_memory_caching) ||
+      options.is_component_function) {
     return OptimizeFunctionGraph(function_name, attrs, options, dev_set,
                                  input_lib_def, composite_devices, cpu_device,
                                  default_device, env,
@@ -686,6 +789,54 @@ OptimizeFunctionGraphOrReadFromFileCache(
         "Failed to find function ", function_name,
         " in function library: ", lib_def->ToProto().DebugString()));
   }
+
+  std::optional<Fprint128> in_memory_cache_key;
+  if (in_memory_caching) {
+    in_memory_cache_key = GetInMemoryCacheKey(
+        function_name, attrs, options, *fdef, *lib_def, dev_set,
+        composite_devices, cpu_device, default_device);
+    std::optional<OptimizedFunctionGraph> cached_graph =
+        InMemoryFunctionGraphCache::Global()->Find(*in_memory_cache_key);
+    if (cached_graph.has_value()) {
+      absl::StatusOr<OptimizedFunctionGraphInfo> optimized_function_graph_info =
+          OptimizedFunctionGraphInfo::FromProto(std::move(*cached_graph));
+      if (optimized_function_graph_info.ok()) {
+        metrics::UpdateFunctionGraphOptimizationSavingTime(
+            optimized_function_graph_info->optimization_duration_usecs,
+            metrics::GraphOptimizationSource::kJit);
+        metrics::IncrementFunctionGraphOptimizationCacheHitCount(
+            1, metrics::GraphOptimizationSource::kJit);
+        VLOG(3) << "Restored the Tensorflow optimized graph from the in-memory "
+                   "cache for the function: "
+                << function_name;
+        return optimized_function_graph_info;
+      }
+      metrics::IncrementFunctionGraphOptimizationCacheFailureCount(
+          1, metrics::GraphOptimizationSource::kJit);
+      LOG(ERROR) << "Reading from the in-memory Tensorflow graph optimization "
+                    "cache failed. Error: "
+                 << optimized_function_graph_info.status();
+    }
+  }
+  // Adds successfully optimized or restored graphs to the in-memory cache.
+  auto cache_in_memory = [&in_memory_cache_key](
+                             absl::StatusOr<OptimizedFunctionGraphInfo> info)
+      -> absl::StatusOr<OptimizedFunctionGraphInfo> {
+    if (in_memory_cache_key.has_value() && info.ok()) {
+      InMemoryFunctionGraphCache::Global()->Insert(
+          *in_memory_cache_key, OptimizedFunctionGraphInfo::ToProto(*info));
+    }
+    return info;
+  };
+
+  if (dir_name.empty()) {
+    metrics::IncrementFunctionGraphOptimizationCacheMissCount(
+        1, metrics::GraphOptimizationSource::kJit);
+    return cache_in_memory(OptimizeFunctionGraph(
+        function_name, attrs, options, dev_set, input_lib_def,
+        composite_devices, cpu_device, default_device, env,
+        OptimizedFunctionGraph::JIT));
+  }
   const string file_name = GetFileCacheName(dir_name, function_name, fdef);
 
   // Scenario (2): File cache exists for this function; restore from the cache.
@@ -709,7 +860,7 @@ OptimizeFunctionGraphOrReadFromFileCache(
           << absl::ToInt64Milliseconds(absl::Microseconds(
                  optimized_function_graph_info->optimization_duration_usecs))
           << " msecs";
-      return optimized_function_graph_info;
+      return cache_in_memory(std::move(optimized_function_graph_info));
     }
 
     // Run the optimization passes if reading from cache fails.
@@ -719,10 +870,10 @@ OptimizeFunctionGraphOrReadFromFileCache(
         << "Reading from Tensorflow graph optimization cache failed. Continue "
            "to run the Tensorflow graph optimization passes instead. Error: "
         << optimized_function_graph_info.status();
-    return OptimizeFunctionGraph(function_name, attrs, options, dev_set,
-                                 input_lib_def, composite_devices, cpu_device,
-                                 default_device, env,
-                                 OptimizedFunctionGraph::JIT);
+    return cache_in_memory(OptimizeFunctionGraph(
+        function_name, attrs, options, dev_set, input_lib_def,
+        composite_devices, cpu_device, default_device, env,
+        OptimizedFunctionGraph::JIT));
   }
 
   // Scenario (3): No file cache exists for this function.
@@ -768,7 +919,7 @@ OptimizeFunctionGraphOrReadFromFileCache(
               << ") msecs";
   }
 
-  return optimized_function_graph_info;
+  return cache_in_memory(std::move(optimized_function_graph_info));
 }
 
 absl::StatusOr<
@@ -38,6 +38,12 @@ static const char kGraphCachingEnvVariableName[] = "TF_GRAPH_CACHING";
 // The threshold of the graph optimization duration to be cached.
 // Note: setting this threshold to 0 means to cache for every function.
 constexpr absl::Duration kCachingThresholdDuration = absl::Seconds(3);
+// The env variable that, when set to "1" or "true", keeps the optimized graphs
+// of functions in memory, shared by all the ProcessFunctionLibraryRuntimes of
+// the process, so that instantiating the same function again (e.g. for another
+// replica of a model) skips the graph optimization passes.
+static const char kInMemoryGraphCachingEnvVariableName[] =
+    "TF_IN_MEMORY_GRAPH_CACHING";
 
 // TODO(iga): Reword
 // Pins each arg that emits a `DT_RESOURCE` tensor to the device on which the
@@ -64,9 +70,13 @@ absl::StatusOr<OptimizedFunctionGraphInfo> OptimizeFunctionGraph(
 
 // Outputs graph optimization results (as OptimizedFunctionGraphInfo proto),
 // either by running the actual graph optimization passes,  or by reloading from
-// the file cache if existent. If cache loading fails, it goes ahead and runs
-// the graph optimization passes. Returns error if running the optimization
-// passes fails.
+// the in-memory or file cache if existent. If cache loading fails, it goes
+// ahead and runs the graph optimization passes. Returns error if running the
+// optimization passes fails.
+//
+// The in-memory cache is keyed by the fingerprint of the function and the
+// functions it calls, `attrs`, `options` and the devices, so it is shared by
+// instantiations of the same function from different function libraries.
 absl::StatusOr<OptimizedFunctionGraphInfo>
 OptimizeFunctionGraphOrReadFromFileCache(
     const string& function_name, AttrSlice attrs,
@@ -246,5 +246,73 @@ TEST(OptimizeFunctionGraphTest, OptimizeFunctionGraphAndWriteToCache) {
   ASSERT_TRUE(empty_file_list.empty());
 }
 
+TEST(OptimizeFunctionGraphTest, SharesInMemoryCacheAcrossFunctionLibraries) {
+  unsetenv(kGraphCachingEnvVariableName);
+  setenv(kInMemoryGraphCachingEnvVariableName, "1", 1);
+
+  FunctionLibraryRuntime::InstantiateOptions opts;
+  opts.is_multi_device_function = true;
+  FunctionDefLibrary proto;
+  *(proto.add_function()) = test::function::FindDevice();
+  // Two libraries with the same functions, as loaded by two replicas.
+  auto lib_def =
+      std::make_unique<FunctionLibraryDefinition>(OpRegistry::Global(), proto);
+  auto other_lib_def =
+      std::make_unique<FunctionLibraryDefinition>(OpRegistry::Global(), proto);
+  std::vector<std::unique_ptr<Device>> devices;
+  CreateCpuDeviceList(kDevicePrefix, 3, devices);
+  DeviceSet device_set;
+  for (const auto& device : devices) {
+    device_set.AddDevice(device.get());
+  }
+  DeviceSet other_device_set;
+  other_device_set.AddDevice(devices[0].get());
+
+  const int64_t hit_count = metrics::GetFunctionGraphOptimizationCacheHitCount(
+      metrics::GraphOptimizationSource::kJit);
+  const int64_t miss_count =
+      metrics::GetFunctionGraphOptimizationCacheMissCount(
+          metrics::GraphOptimizationSource::kJit);
+
+  absl::StatusOr<OptimizedFunctionGraphInfo> optimized_info =
+      OptimizeFunctionGraphOrReadFromFileCache(
+          "FindDevice", {}, opts, device_set, lib_def.get(),
+          /*composite_devices=*/{}, devices[0].get(), devices[1].get(),
+          Env::Default());
+  TF_ASSERT_OK(optimized_info.status());
+  EXPECT_EQ(metrics::GetFunctionGraphOptimizationCacheMissCount(
+                metrics::GraphOptimizationSource::kJit),
+            miss_count + 1);
+
+  // The same function on the same devices is restored from the cache, even
+  // from another library.
+  optimized_info = OptimizeFunctionGraphOrReadFromFileCache(
+      "FindDevice", {}, opts, device_set, other_lib_def.get(),
+      /*composite_devices=*/{}, devices[0].get(), devices[1].get(),
+      Env::Default());
+  TF_ASSERT_OK(optimized_info.status());
+  EXPECT_EQ(metrics::GetFunctionGraphOptimizationCacheHitCount(
+                metrics::GraphOptimizationSource::kJit),
+            hit_count + 1);
+  EXPECT_EQ(optimized_info->name, "FindDevice");
+  EXPECT_EQ(optimized_info->num_return_nodes, 1);
+  EXPECT_THAT(optimized_info->ret_types, ElementsAre(DT_STRING));
+
+  // Other devices are a different key.
+  optimized_info = OptimizeFunctionGraphOrReadFromFileCache(
+      "FindDevice", {}, opts, other_device_set, lib_def.get(),
+      /*composite_devices=*/{}, devices[0].get(), devices[0].get(),
+      Env::Default());
+  TF_ASSERT_OK(optimized_info.status());
+  EXPECT_EQ(metrics::GetFunctionGraphOptimizationCacheHitCount(
+                metrics::GraphOptimizationSource::kJit),
+            hit_count + 1);
+  EXPECT_EQ(metrics::GetFunctionGraphOptimizationCacheMissCount(
+                metrics::GraphOptimizationSource::kJit),
+            miss_count + 2);
+
+  unsetenv(kInMemoryGraphCachingEnvVariableName);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -22,10 +22,16 @@ limitations under the License.
 #include <sys/mman.h>  // for munmap
 #endif
 
+#include <algorithm>
+#include <functional>
 #include <map>
+#include <thread>  // NOLINT
 #include <utility>
 
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -37,21 +43,45 @@ namespace tensorflow {
 
 PoolAllocator::PoolAllocator(size_t pool_size_limit, bool auto_resize,
                              SubAllocator* allocator,
-                             RoundUpInterface* size_rounder, string name)
+                             RoundUpInterface* size_rounder, string name,
+                             int num_shards)
     : name_(std::move(name)),
       has_size_limit_(pool_size_limit > 0),
       auto_resize_(auto_resize),
       pool_size_limit_(pool_size_limit),
       allocator_(allocator),
-      size_rounder_(size_rounder) {
+      size_rounder_(size_rounder),
+      num_shards_(num_shards) {
   if (auto_resize) {
     CHECK_LT(size_t{0}, pool_size_limit)
         << "size limit must be > 0 if auto_resize is true.";
   }
+  if (num_shards_ > 0) {
+    CHECK_LT(size_t{0}, pool_size_limit)
+        << "size limit must be > 0 if num_shards > 0.";
+    shards_.reset(new Shard[num_shards_]);
+    for (int i = 0; i < num_shards_; ++i) {
+      const string shard = strings::StrCat(i);
+      shards_[i].hit_cell =
+          metrics::GetPoolAllocatorShardCounter(name_, shard, "hit");
+      shards_[i].miss_cell =
+          metrics::GetPoolAllocatorShardCounter(name_, shard, "miss");
+      shards_[i].eviction_cell =
+          metrics::GetPoolAllocatorShardCounter(name_, shard, "eviction");
+    }
+  }
 }
 
 PoolAllocator::~PoolAllocator() { Clear(); }
 
+PoolAllocator::Shard::Shard() {
+  for (auto& size_class : slots) {
+    for (std::atomic<void*>& slot : size_class) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
 namespace {
 // Pools contain Chunks allocated from the underlying Allocator.
 // Chunk alignment is always on kPoolAlignment boundaries.  Each Chunk
@@ -105,6 +135,14 @@ void* PoolAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
   }
   num_bytes += sizeof(ChunkPrefix);
   num_bytes = size_rounder_->RoundUp(num_bytes);
+  if (num_shards_ > 0) {
+    num_bytes = std::max(num_bytes, size_t{1} << kMinShardedSizeClass);
+    num_bytes = size_t{1} << Log2Ceiling64(num_bytes);
+    if (void* chunk = GetFromShard(num_bytes)) {
+      return PrepareChunk(chunk, alignment,
+                          reinterpret_cast<ChunkPrefix*>(chunk)->num_bytes);
+    }
+  }
   PtrRecord* pr = nullptr;
   if (has_size_limit_) {
     {
@@ -141,6 +179,8 @@ void PoolAllocator::DeallocateRaw(void* ptr) {
   CHECK_LE((void*)cp, (void*)ptr);
   if (!has_size_limit_ && !auto_resize_) {
     allocator_->Free(cp, cp->num_bytes);
+  } else if (num_shards_ > 0 && PutToShard(cp, cp->num_bytes)) {
+    return;
   } else {
     mutex_lock lock(mutex_);
     ++put_count_;
@@ -156,6 +196,9 @@ void PoolAllocator::DeallocateRaw(void* ptr) {
 }
 
 void PoolAllocator::Clear() {
+  if (num_shards_ > 0) {
+    ClearShards();
+  }
   if (has_size_limit_) {
     mutex_lock lock(mutex_);
     for (auto iter : pool_) {
@@ -173,6 +216,77 @@ void PoolAllocator::Clear() {
   }
 }
 
+PoolAllocator::Shard& PoolAllocator::CurrentShard() {
+  int cpu = port::GetCurrentCPU();
+  if (cpu < 0) {
+    cpu = static_cast<int>(
+        std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff);
+  }
+  return shards_[cpu % num_shards_];
+}
+
+void* PoolAllocator::GetFromShard(size_t num_bytes) {
+  const int size_class = Log2Floor64(num_bytes);
+  if (size_class > kMaxShardedSizeClass) return nullptr;
+  Shard& shard = CurrentShard();
+  for (std::atomic<void*>& slot :
+       shard.slots[size_class - kMinShardedSizeClass]) {
+    // Check before the compare-and-swap so that empty slots are only read.
+    void* chunk = slot.load(std::memory_order_relaxed);
+    if (chunk != nullptr &&
+        slot.compare_exchange_strong(chunk, nullptr,
+                                     std::memory_order_acquire)) {
+      shard.hits.fetch_add(1, std::memory_order_relaxed);
+      shard.hit_cell->IncrementBy(1);
+      return chunk;
+    }
+  }
+  shard.misses.fetch_add(1, std::memory_order_relaxed);
+  shard.miss_cell->IncrementBy(1);
+  return nullptr;
+}
+
+bool PoolAllocator::PutToShard(void* chunk, size_t num_bytes) {
+  // A chunk can be larger than its size class, e.g. if the sub-allocator
+  // returned more than was requested, so file it under the largest class that
+  // it can satisfy.
+  const int size_class = Log2Floor64(num_bytes);
+  if (size_class < kMinShardedSizeClass || size_class > kMaxShardedSizeClass) {
+    return false;
+  }
+  Shard& shard = CurrentShard();
+  for (std::atomic<void*>& slot :
+       shard.slots[size_class - kMinShardedSizeClass]) {
+    void* expected = slot.load(std::memory_order_relaxed);
+    if (expected == nullptr &&
+        slot.compare_exchange_strong(expected, chunk,
+                                     std::memory_order_release)) {
+      return true;
+    }
+  }
+  shard.evictions.fetch_add(1, std::memory_order_relaxed);
+  shard.eviction_cell->IncrementBy(1);
+  return false;
+}
+
+void PoolAllocator::ClearShards() {
+  for (int i = 0; i < num_shards_; ++i) {
+    Shard& shard = shards_[i];
+    for (auto& size_class : shard.slots) {
+      for (std::atomic<void*>& slot : size_class) {
+        void* chunk = slot.exchange(nullptr, std::memory_order_acquire);
+        if (chunk != nullptr) {
+          allocator_->Free(chunk,
+                           reinterpret_cast<ChunkPrefix*>(chunk)->num_bytes);
+        }
+      }
+    }
+    shard.hits.store(0, std::memory_order_relaxed);
+    shard.misses.store(0, std::memory_order_relaxed);
+    shard.evictions.store(0, std::memory_order_relaxed);
+  }
+}
+
 void PoolAllocator::RemoveFromList(PtrRecord* pr) {
   if (pr->prev == nullptr) {
     DCHECK_EQ(lru_head_, pr);
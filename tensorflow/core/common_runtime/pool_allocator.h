@@ -21,10 +21,12 @@ limitations under the License.
 #include <atomic>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -55,7 +57,21 @@ class PoolAllocator : public Allocator {
   // malloc/free operations.  This object takes ownership of allocator.
   PoolAllocator(size_t pool_size_limit, bool auto_resize,
                 SubAllocator* allocator, RoundUpInterface* size_rounder,
-                string name);
+                string name)
+      : PoolAllocator(pool_size_limit, auto_resize, allocator, size_rounder,
+                      std::move(name), /*num_shards=*/0) {}
+
+  // As above, but if "num_shards" > 0, the pool is fronted by that many
+  // shards of lock-free free lists, one list per power-of-two size class up
+  // to kMaxShardedBytes. Each thread uses the shard of the CPU it is running
+  // on, so concurrent Get() and Put() calls rarely touch the same cache line,
+  // and only fall back to the mutex-guarded LRU pool when their shard's list
+  // for the size class is empty (a miss) or full (an eviction). Sharding
+  // requires a pool, i.e. "pool_size_limit" > 0, and rounds every request up
+  // to a power of two.
+  PoolAllocator(size_t pool_size_limit, bool auto_resize,
+                SubAllocator* allocator, RoundUpInterface* size_rounder,
+                string name, int num_shards);
   ~PoolAllocator() override;
 
   string Name() override { return name_; }
@@ -100,11 +116,68 @@ class PoolAllocator : public Allocator {
     return pool_size_limit_;
   }
 
+  // Per-shard counters of a sharded pool, which are also exported as the
+  // "/tensorflow/core/pool_allocator_shard_ops" metric. The counters above
+  // only count requests that reach the mutex-guarded pool.
+  int num_shards() const { return num_shards_; }
+  // Number of Get() requests satisfied from the shard's free lists.
+  int64_t shard_hit_count(int shard) const {
+    return shards_[shard].hits.load(std::memory_order_relaxed);
+  }
+  // Number of Get() requests passed on to the mutex-guarded pool.
+  int64_t shard_miss_count(int shard) const {
+    return shards_[shard].misses.load(std::memory_order_relaxed);
+  }
+  // Number of Put() requests passed on to the mutex-guarded pool because the
+  // shard's free list for the size class was full.
+  int64_t shard_eviction_count(int shard) const {
+    return shards_[shard].evictions.load(std::memory_order_relaxed);
+  }
+
+  // The largest chunk size, including the chunk prefix, that is cached in the
+  // shards of a sharded pool.
+  static constexpr size_t kMaxShardedBytes = size_t{1} << 18;
+
   AllocatorMemoryType GetMemoryType() const override {
     return allocator_->GetMemoryType();
   }
 
  private:
+  static constexpr int kMinShardedSizeClass = 6;
+  static constexpr int kMaxShardedSizeClass = 18;
+  static constexpr int kNumShardedSizeClasses =
+      kMaxShardedSizeClass - kMinShardedSizeClass + 1;
+  static constexpr int kSlotsPerSizeClass = 4;
+
+  // A fixed-capacity free list per size class. A slot holds a chunk pointer,
+  // or nullptr if it is empty, and is claimed with a single compare-and-swap,
+  // so shards need no lock and are immune to ABA.
+  struct alignas(64) Shard {
+    Shard();
+
+    std::atomic<void*> slots[kNumShardedSizeClasses][kSlotsPerSizeClass];
+    std::atomic<int64_t> hits{0};
+    std::atomic<int64_t> misses{0};
+    std::atomic<int64_t> evictions{0};
+    monitoring::CounterCell* hit_cell = nullptr;
+    monitoring::CounterCell* miss_cell = nullptr;
+    monitoring::CounterCell* eviction_cell = nullptr;
+  };
+
+  // Returns the shard for the calling thread.
+  Shard& CurrentShard();
+
+  // Returns a cached chunk of "num_bytes" (a power of two) from the calling
+  // thread's shard, or nullptr.
+  void* GetFromShard(size_t num_bytes);
+
+  // Caches "chunk", whose prefix records its size, in the calling thread's
+  // shard. Returns false if the chunk must be returned to the pool instead.
+  bool PutToShard(void* chunk, size_t num_bytes);
+
+  // Frees every chunk cached in the shards.
+  void ClearShards();
+
   struct PtrRecord {
     void* ptr;
     size_t num_bytes;
@@ -127,6 +200,8 @@ class PoolAllocator : public Allocator {
   size_t pool_size_limit_;
   std::unique_ptr<SubAllocator> allocator_;
   std::unique_ptr<RoundUpInterface> size_rounder_;
+  const int num_shards_;
+  std::unique_ptr<Shard[]> shards_;
   mutex mutex_;
   std::multimap<const size_t, PtrRecord*> pool_ TF_GUARDED_BY(mutex_);
   PtrRecord* lru_head_ TF_GUARDED_BY(mutex_) = nullptr;
@@ -0,0 +1,138 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+PoolAllocator* NewShardedPool(int num_shards) {
+  return new PoolAllocator(
+      /*pool_size_limit=*/2, /*auto_resize=*/false,
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), new NoopRounder,
+      "sharded_pool", num_shards);
+}
+
+TEST(ShardedPoolAllocatorTest, ReusesFromShard) {
+  std::unique_ptr<PoolAllocator> pool(NewShardedPool(/*num_shards=*/1));
+  void* p = pool->AllocateRaw(4, 100);
+  ASSERT_NE(nullptr, p);
+  pool->DeallocateRaw(p);
+  // Requests in the same power-of-two size class share the cached chunk.
+  void* q = pool->AllocateRaw(4, 90);
+  EXPECT_EQ(p, q);
+  pool->DeallocateRaw(q);
+
+  EXPECT_EQ(1, pool->shard_hit_count(0));
+  EXPECT_EQ(1, pool->shard_miss_count(0));
+  EXPECT_EQ(0, pool->shard_eviction_count(0));
+  // Neither deallocation reached the shared pool.
+  EXPECT_EQ(0, pool->put_count());
+  EXPECT_EQ(1, pool->allocated_count());
+}
+
+TEST(ShardedPoolAllocatorTest, RespectsAlignment) {
+  std::unique_ptr<PoolAllocator> pool(NewShardedPool(/*num_shards=*/1));
+  for (int i = 0; i < 3; ++i) {
+    for (size_t alignment : {4, 16, 64, 256}) {
+      void* p = pool->AllocateRaw(alignment, 40);
+      ASSERT_NE(nullptr, p);
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignment);
+      memset(p, 0, 40);
+      pool->DeallocateRaw(p);
+    }
+  }
+  EXPECT_GT(pool->shard_hit_count(0), 0);
+}
+
+TEST(ShardedPoolAllocatorTest, EvictsToSharedPoolWhenShardIsFull) {
+  std::unique_ptr<PoolAllocator> pool(NewShardedPool(/*num_shards=*/1));
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 6; ++i) {
+    ptrs.push_back(pool->AllocateRaw(4, 1000));
+  }
+  for (void* p : ptrs) {
+    pool->DeallocateRaw(p);
+  }
+  // The shard holds 4 chunks per size class; the rest go to the shared pool,
+  // which holds up to 2.
+  EXPECT_EQ(2, pool->shard_eviction_count(0));
+  EXPECT_EQ(2, pool->put_count());
+  EXPECT_EQ(0, pool->evicted_count());
+
+  ptrs.clear();
+  for (int i = 0; i < 6; ++i) {
+    ptrs.push_back(pool->AllocateRaw(4, 1000));
+  }
+  EXPECT_EQ(4, pool->shard_hit_count(0));
+  EXPECT_EQ(2, pool->get_from_pool_count());
+  for (void* p : ptrs) {
+    pool->DeallocateRaw(p);
+  }
+  pool->Clear();
+  EXPECT_EQ(0, pool->shard_hit_count(0));
+}
+
+TEST(ShardedPoolAllocatorTest, LargeRequestsBypassShards) {
+  std::unique_ptr<PoolAllocator> pool(NewShardedPool(/*num_shards=*/1));
+  void* p = pool->AllocateRaw(4, PoolAllocator::kMaxShardedBytes);
+  pool->DeallocateRaw(p);
+  EXPECT_EQ(0, pool->shard_hit_count(0));
+  EXPECT_EQ(1, pool->put_count());
+}
+
+TEST(ShardedPoolAllocatorTest, Concurrent) {
+  constexpr int kNumThreads = 8;
+  constexpr int kIterations = 2000;
+  std::unique_ptr<PoolAllocator> pool(NewShardedPool(/*num_shards=*/4));
+  {
+    thread::ThreadPool threads(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      threads.Schedule([&pool, t]() {
+        std::vector<void*> live;
+        for (int i = 0; i < kIterations; ++i) {
+          const size_t num_bytes = 16 << ((i + t) % 8);
+          char* p = static_cast<char*>(pool->AllocateRaw(8, num_bytes));
+          CHECK(p != nullptr);
+          p[0] = p[num_bytes - 1] = static_cast<char>(t);
+          live.push_back(p);
+          if (live.size() > 4) {
+            pool->DeallocateRaw(live.front());
+            live.erase(live.begin());
+          }
+        }
+        for (void* p : live) pool->DeallocateRaw(p);
+      });
+    }
+  }
+  int64_t hits = 0;
+  for (int i = 0; i < pool->num_shards(); ++i) {
+    hits += pool->shard_hit_count(i);
+  }
+  EXPECT_GT(hits, 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -742,6 +742,7 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     };
 
     FunctionLibraryRuntime* flr = GetFLR(opts.target);
+    comp_data->flr = flr;
     if (flr != nullptr) {
       // Initialize local function synchronously.
       Status s = flr->Instantiate(comp_data->name, AttrSlice(&attrs), opts,
@@ -802,6 +803,12 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   }
   TF_RETURN_IF_ERROR(group.as_summary_status());
 
+  if (data->enable_sync_execution) {
+    for (const string& target : GetOrderedSubgraphs(data.get())) {
+      data->sync_run_order_.push_back(&*data->glue_.find(target));
+    }
+  }
+
   std::vector<core::RefCountPtr<FunctionRecord>> function_records;
   const bool should_publish_function_graphs =
       flags::Global().publish_function_graphs.value();
@@ -952,10 +959,10 @@ Status ProcessFunctionLibraryRuntime::RunMultiDeviceSync(
   //
   // We assume that the partitioning has a valid deadlock-free ordering and the
   // safety of running synchronously has already been confirmed by this point.
-  std::vector<string> subgraph_keys = GetOrderedSubgraphs(data);
-
-  for (const string& target : subgraph_keys) {
-    const ComponentFunctionData& comp_data = data->glue_.at(target);
+  // The order is computed once at instantiation.
+  for (const auto* entry : data->sync_run_order_) {
+    const string& target = entry->first;
+    const ComponentFunctionData& comp_data = entry->second;
     FunctionLibraryRuntime::Handle comp_handle = comp_data.handle;
 
     opts_copy.args_alloc_attrs = comp_data.arg_alloc_attrs;
@@ -971,7 +978,7 @@ Status ProcessFunctionLibraryRuntime::RunMultiDeviceSync(
 
     VLOG(1) << "Running component function on device " << target << " from "
             << data->function_name_ << " with handle " << comp_handle;
-    FunctionLibraryRuntime* flr = GetFLR(target);
+    FunctionLibraryRuntime* flr = comp_data.flr;
     if (flr != nullptr) {
       opts_copy.remote_execution = false;
       // When target device has private thread pool, use the target device
@@ -1069,9 +1076,12 @@ void ProcessFunctionLibraryRuntime::RunMultiDeviceAsync(
     std::vector<FunctionRet>* comp_rets = new std::vector<FunctionRet>;
     rets->resize(data->num_outputs_);
 
-    auto component_fn_callback = [comp_rets, rets, comp_data, refcounted_done,
-                                  cm, local_cm, data, comp_handle,
-                                  target](const Status& status) {
+    // `comp_data` and `target` live in `data`, which outlives the call, so
+    // they are captured by reference rather than copied for every call.
+    auto component_fn_callback = [comp_rets, rets, &comp_data = comp_data,
+                                  refcounted_done, cm, local_cm, data,
+                                  comp_handle,
+                                  &target = target](const Status& status) {
       if (!status.ok()) {
         VLOG(2) << "Component function execution on target " << target
                 << " from " << data->function_name_ << " with handle "
@@ -1096,7 +1106,7 @@ void ProcessFunctionLibraryRuntime::RunMultiDeviceAsync(
       refcounted_done->Unref();
     };
 
-    FunctionLibraryRuntime* flr = GetFLR(target);
+    FunctionLibraryRuntime* flr = comp_data.flr;
     if (flr != nullptr) {
       opts_copy.remote_execution = false;
       // When target device has private thread pool, use the target device
@@ -268,6 +268,10 @@ class ProcessFunctionLibraryRuntime {
     FunctionLibraryRuntime::Handle handle;
     // The name for the component function.
     string name;
+    // The runtime of the local device the component function runs on, or
+    // nullptr if it runs on a remote device. Resolved once at instantiation so
+    // that running the function doesn't look up the device every time.
+    FunctionLibraryRuntime* flr = nullptr;
     // arg_indices.size() is the number of arguments to the component function.
     // The i-th argument of the component function comes from the
     // `arg_indices[i]`-th argument of the multi-device function.
@@ -320,6 +324,11 @@ class ProcessFunctionLibraryRuntime {
     // Maps the device name to the information about the component function
     // be run on this device.
     std::unordered_map<string, ComponentFunctionData> glue_;
+
+    // The entries of `glue_` in the order RunMultiDeviceSync runs them (see
+    // GetOrderedSubgraphs). Only filled if `enable_sync_execution`.
+    std::vector<const std::pair<const string, ComponentFunctionData>*>
+        sync_run_order_;
   };
 
   struct CleanUpItem {
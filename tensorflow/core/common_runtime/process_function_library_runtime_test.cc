@@ -1389,6 +1389,68 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, PartitionedGraphRequiresAsync) {
   EXPECT_GT(async_recv_only.Get(), 0);
 }
 
+// Returns a function which squares its input on CPU:1, so that its input is
+// sent there from the component function on CPU:0.
+FunctionDef SquareOnCpu1() {
+  return FunctionDefHelper::Create(
+      // Name
+      "SquareOnCpu1",
+      // Args
+      {"x: float"},
+      // Return values
+      {"y: float"},
+      // Attr def
+      {},
+      // Nodes
+      {
+          {{"square"},
+           "Mul",
+           {"x", "x"},
+           {{"T", DT_FLOAT}},
+           {},
+           "/device:CPU:1"},
+      },
+      {{"y", "square:z:0"}});
+}
+
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_RunSyncSendsFirst) {
+  Init({SquareOnCpu1()});
+  auto async_send_only =
+      metrics::TestDelta("subgraph_async_summary", "send_only");
+  auto async_recv_only =
+      metrics::TestDelta("subgraph_async_summary", "recv_only");
+  auto sync_runs = metrics::TestDelta("pflr_runsync", "sync");
+  FunctionLibraryRuntime::InstantiateOptions inst_opts =
+      MakeOptions("CPU:0", {"CPU:0"}, {});
+  inst_opts.allow_small_function_optimizations = true;
+  FunctionLibraryRuntime::Handle handle;
+  TF_ASSERT_OK(Instantiate("SquareOnCpu1", {}, inst_opts, &handle));
+  EXPECT_GT(async_send_only.Get(), 0);
+  EXPECT_GT(async_recv_only.Get(), 0);
+
+  std::function<void(std::function<void()>)> runner =
+      [](std::function<void()> fn) {
+        test::function::FunctionTestSchedClosure(fn);
+      };
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = &runner;
+  const Tensor x = test::AsTensor<float>({1, 2, 3});
+  // The components run one after the other. Running the component that
+  // receives `x` before the one that sends it would block forever.
+  std::vector<Tensor> sync_rets;
+  TF_ASSERT_OK(proc_flr_->RunSync(opts, handle, {x}, &sync_rets));
+  EXPECT_GT(sync_runs.Get(), 0);
+  ASSERT_EQ(sync_rets.size(), 1);
+  test::ExpectTensorEqual<float>(sync_rets[0],
+                                 test::AsTensor<float>({1, 4, 9}));
+
+  // The components run concurrently.
+  Tensor async_y;
+  TF_ASSERT_OK(RunInstantiated(handle, FunctionLibraryRuntime::Options(), {x},
+                               {&async_y}));
+  test::ExpectTensorEqual<float>(async_y, test::AsTensor<float>({1, 4, 9}));
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, RecordAotSavingTimeAndHitCount) {
   FunctionLibraryRuntime::InstantiateOptions opts =
       MakeOptions("CPU:0", {}, {});
@@ -111,12 +111,18 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
       DCHECK(sub_allocator);
-      allocator =
-          new PoolAllocator(/*pool_size_limit=*/100, /*auto_resize=*/true,
-                            sub_allocator, new NoopRounder, "cpu_pool");
+      int64_t num_shards = 0;
+      Status status = ReadInt64FromEnvVar("TF_CPU_POOL_ALLOCATOR_NUM_SHARDS",
+                                          0, &num_shards);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.message();
+      }
+      allocator = new PoolAllocator(
+          /*pool_size_limit=*/100, /*auto_resize=*/true, sub_allocator,
+          new NoopRounder, "cpu_pool", static_cast<int>(num_shards));
       VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
               << "numa_enabled_=" << numa_enabled_
-              << " numa_node=" << numa_node;
+              << " numa_node=" << numa_node << " num_shards=" << num_shards;
     } else {
       DCHECK(!sub_allocator);
       allocator = cpu_allocator_base();
@@ -27,12 +27,19 @@ namespace tensorflow {
 // This class is used to wrap local devices when using clusterspec propagation
 // where the name of a particular device may change in the context of a given
 // session.
+//
+// It is also used by executors to override the intra-op thread pool or the
+// default allocator of a device for the duration of a step.
 class RenamedDevice : public Device {
  public:
+  // If `default_allocator` is not null, it is returned instead of the
+  // underlying device's allocator for requests with default attributes. It is
+  // not owned, and must outlive the returned device.
   static std::unique_ptr<Device> NewRenamedDevice(
       const string& new_base, Device* underlying, bool owns_underlying,
       bool isolate_session_state,
-      thread::ThreadPoolInterface* underlying_threadpool = nullptr);
+      thread::ThreadPoolInterface* underlying_threadpool = nullptr,
+      Allocator* default_allocator = nullptr);
 
   ~RenamedDevice() override;
 
@@ -56,6 +63,9 @@ class RenamedDevice : public Device {
   }
 
   Allocator* GetAllocator(AllocatorAttributes attr) override {
+    if (default_allocator_ != nullptr && attr.value == 0) {
+      return default_allocator_;
+    }
     return underlying_device_->GetAllocator(attr);
   }
 
@@ -139,6 +149,12 @@ class RenamedDevice : public Device {
     return underlying_device_->TryGetDeviceContext(out_context);
   }
 
+  Status FillContextMap(
+      const Graph* graph,
+      std::vector<DeviceContext*>* device_context_map) override {
+    return underlying_device_->FillContextMap(graph, device_context_map);
+  }
+
   // Returns the resource manager associated w/ this device.
   ResourceMgr* resource_manager() override {
     if (isolate_session_state_) {
@@ -157,10 +173,12 @@ class RenamedDevice : public Device {
  private:
   RenamedDevice(Device* underlying, const DeviceAttributes& attributes,
                 bool owns_underlying, bool isolate_session_state,
-                thread::ThreadPoolInterface* underlying_threadpool);
+                thread::ThreadPoolInterface* underlying_threadpool,
+                Allocator* default_allocator);
   Device* const underlying_device_;
   const bool owns_underlying_device_;
   const bool isolate_session_state_;
+  Allocator* const default_allocator_;  // Not owned.
 
   std::unique_ptr<thread::ThreadPool> underlying_threadpool_;
   // eigen_worker_threads_ is stored here so that we can pass the pointer
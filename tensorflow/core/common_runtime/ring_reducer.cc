@@ -38,10 +38,17 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
 namespace tensorflow {
+namespace {
+
+// The on-device group size in the scratch state of the instance.
+constexpr char kGroupSizeTensor[] = "group_size";
+
+}  // namespace
 
 RingReducer::~RingReducer() { group_size_tensor_ready_.WaitForNotification(); }
 
@@ -122,11 +129,23 @@ void RingReducer::ContinueAfterInputCopy() {
 
   if (col_params_->final_op) {
     // Create an on-device scalar value from group_size_ that may be needed
-    // later.
-    // TODO(tucker): Cache and reuse across invocations? Or maybe the scalar
-    // can be provided to the kernel in host memory?
+    // later. It is copied to the device once per instance if the executor
+    // keeps scratch state, and reused by the next executions.
     Tensor group_size_val = ca_->Scalar(group_size_);
-    if (col_params_->group.device_type != "CPU") {
+    CollectiveInstanceScratch* scratch = col_ctx_->scratch.get();
+    bool cached = false;
+    if (scratch != nullptr && col_params_->group.device_type != "CPU") {
+      mutex_lock l(scratch->mu);
+      auto it = scratch->tensors.find(kGroupSizeTensor);
+      if (it != scratch->tensors.end() &&
+          it->second.dtype() == group_size_val.dtype()) {
+        group_size_tensor_ = it->second;
+        cached = true;
+      }
+    }
+    if (cached) {
+      group_size_tensor_ready_.Notify();
+    } else if (col_params_->group.device_type != "CPU") {
       uint64 safe_alloc_frontier = col_ctx_->device->SafeAllocFrontier(0);
       AllocationAttributes aa;
       std::function<uint64()> freed_by_func = [this, &safe_alloc_frontier]() {
@@ -143,9 +162,12 @@ void RingReducer::ContinueAfterInputCopy() {
       DeviceContext* op_dev_ctx = col_ctx_->op_ctx->op_device_context();
       op_dev_ctx->CopyCPUTensorToDevice(
           &group_size_val, col_ctx_->device, &group_size_tensor_,
-          [this](const Status& s) {
+          [this, scratch](const Status& s) {
             if (!s.ok()) {
               StartAbort(s);
+            } else if (scratch != nullptr) {
+              mutex_lock l(scratch->mu);
+              scratch->tensors.emplace(kGroupSizeTensor, group_size_tensor_);
             }
             group_size_tensor_ready_.Notify();
           },
@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/sampled_step_stats_collector.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/graph/costmodel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/env_time.h"
+
+namespace tensorflow {
+
+// The compute times of one execution of a node.
+class SampledStepStatsCollector::NodeTimes : public NodeExecStatsInterface {
+ public:
+  void Reset(const NodeInfo* info) {
+    info_ = info;
+    compute_start_nanos_ = 0;
+    compute_end_nanos_ = 0;
+  }
+
+  const NodeInfo* info() const { return info_; }
+
+  // Returns the compute time, or a negative time if the node did not finish.
+  int64_t compute_nanos() const {
+    return compute_end_nanos_ == 0 ? -1
+                                   : compute_end_nanos_ - compute_start_nanos_;
+  }
+
+  // The records belong to the collector.
+  void Done(const string& device) override {}
+  void RecordExecutorStarted() override {}
+  void RecordComputeStarted() override {
+    compute_start_nanos_ = EnvTime::NowNanos();
+  }
+  void RecordComputeEnded() override {
+    compute_end_nanos_ = EnvTime::NowNanos();
+  }
+  void RecordExecutorEnded() override {}
+  bool TrackAllocations() const override { return false; }
+  void SetMemory(OpKernelContext* ctx) override {}
+  void SetOutput(int slot, const Tensor* tensor) override {}
+  void SetScheduled(int64_t nanos) override {}
+
+ private:
+  const NodeInfo* info_ = nullptr;
+  int64_t compute_start_nanos_ = 0;
+  int64_t compute_end_nanos_ = 0;
+};
+
+SampledStepStatsCollector::SampledStepStatsCollector(
+    const std::unordered_map<std::string, const Graph*>& device_map) {
+  for (const auto& it : device_map) {
+    const Graph* graph = it.second;
+    for (const Node* node : graph->op_nodes()) {
+      nodes_.emplace(node->name(), NodeInfo{graph, node});
+    }
+  }
+  num_records_ = nodes_.size();
+  records_ = std::make_unique<NodeTimes[]>(num_records_);
+}
+
+SampledStepStatsCollector::~SampledStepStatsCollector() = default;
+
+bool SampledStepStatsCollector::Start() {
+  return !in_step_.exchange(true, std::memory_order_acquire);
+}
+
+void SampledStepStatsCollector::Finish(CostModelManager* cost_model_manager) {
+  if (cost_model_manager != nullptr) {
+    const int64_t num_records =
+        std::min(num_used_.load(std::memory_order_relaxed), num_records_);
+    const Graph* graph = nullptr;
+    CostModel* cost_model = nullptr;
+    for (int64_t i = 0; i < num_records; ++i) {
+      const NodeTimes& record = records_[i];
+      const int64_t compute_nanos = record.compute_nanos();
+      if (compute_nanos < 0) continue;
+      if (record.info()->graph != graph) {
+        graph = record.info()->graph;
+        cost_model = cost_model_manager->FindOrCreateCostModel(graph);
+      }
+      cost_model->RecordExecutionTimeSample(
+          record.info()->node, Microseconds(compute_nanos / 1000));
+    }
+  }
+  num_used_.store(0, std::memory_order_relaxed);
+  in_step_.store(false, std::memory_order_release);
+}
+
+NodeExecStatsInterface* SampledStepStatsCollector::CreateNodeExecStats(
+    const NodeDef* node) {
+  auto it = nodes_.find(node->name());
+  if (it == nodes_.end()) return nullptr;
+  const int64_t index = num_used_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= num_records_) return nullptr;
+  NodeTimes* record = &records_[index];
+  record->Reset(&it->second);
+  return record;
+}
+
+std::string SampledStepStatsCollector::ReportAllocsOnResourceExhausted(
+    absl::string_view err) {
+  return "";
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,89 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+
+namespace tensorflow {
+
+class CostModelManager;
+class Graph;
+class Node;
+
+// SampledStepStatsCollector records the compute times of the nodes of the
+// steps that a session samples, so that steps of production jobs can be
+// sampled all the time. Unlike StepStatsCollector, it allocates the records of
+// all the nodes of its graphs once, does not track allocations or outputs,
+// and does not produce StepStats: Finish() adds the times of the sampled step
+// to the execution time histograms of the cost models of the graphs.
+//
+// A collector collects one step at a time. Nodes are looked up in the graphs
+// by name, as in StepStatsCollector::BuildCostModel(), and the nodes that are
+// not found, such as most nodes of functions, are not sampled. Neither are the
+// executions of nodes beyond the number of nodes in the graphs, as in loops.
+class SampledStepStatsCollector : public StepStatsCollectorInterface {
+ public:
+  // `device_map` maps the devices to the graphs that run on them. The graphs
+  // must outlive the collector.
+  explicit SampledStepStatsCollector(
+      const std::unordered_map<std::string, const Graph*>& device_map);
+  ~SampledStepStatsCollector() override;
+
+  // Claims the collector for a step. Returns false if another step is being
+  // collected.
+  bool Start();
+
+  // Adds the times of the nodes of the step to `cost_model_manager` if it is
+  // not null, and releases the collector for the next step. Must be called
+  // after all the nodes of the step are done, and is not thread-safe with
+  // other updates of the cost models.
+  void Finish(CostModelManager* cost_model_manager);
+
+  NodeExecStatsInterface* CreateNodeExecStats(const NodeDef* node) override;
+  std::string ReportAllocsOnResourceExhausted(absl::string_view err) override;
+
+ private:
+  class NodeTimes;
+
+  struct NodeInfo {
+    const Graph* graph;
+    const Node* node;
+  };
+
+  // The nodes of the graphs by name.
+  absl::flat_hash_map<absl::string_view, NodeInfo> nodes_;
+
+  int64_t num_records_ = 0;
+  std::unique_ptr<NodeTimes[]> records_;
+  // The number of records claimed in the step, which may exceed
+  // `num_records_`.
+  std::atomic<int64_t> num_used_{0};
+  std::atomic<bool> in_step_{false};
+
+  SampledStepStatsCollector(const SampledStepStatsCollector&) = delete;
+  void operator=(const SampledStepStatsCollector&) = delete;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_STATS_COLLECTOR_H_
@@ -0,0 +1,134 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/sampled_step_stats_collector.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/costmodel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+REGISTER_OP("SampledInput").Output("o: float").SetIsStateful();
+
+std::unique_ptr<Graph> CreateGraph() {
+  GraphDef graph_def;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      "node { name: 'A' op: 'SampledInput'}"
+      "node { name: 'B' op: 'SampledInput'}"
+      "node { name: 'C' op: 'Mul' attr { key: 'T' value { type: DT_FLOAT } }"
+      " input: ['A', 'B'] }",
+      &graph_def));
+  auto graph = std::make_unique<Graph>(OpRegistry::Global());
+  TF_CHECK_OK(ConvertGraphDefToGraph(GraphConstructorOptions(), graph_def,
+                                     graph.get()));
+  return graph;
+}
+
+Node* FindNode(const Graph& graph, const std::string& name) {
+  for (Node* node : graph.op_nodes()) {
+    if (node->name() == name) return node;
+  }
+  return nullptr;
+}
+
+// Runs `node` through `collector` as the executor does.
+bool ExecuteNode(SampledStepStatsCollector* collector, const NodeDef& node) {
+  NodeExecStatsInterface* stats = collector->CreateNodeExecStats(&node);
+  if (stats == nullptr) return false;
+  EXPECT_FALSE(stats->TrackAllocations());
+  stats->RecordExecutorStarted();
+  stats->RecordComputeStarted();
+  stats->RecordComputeEnded();
+  stats->RecordExecutorEnded();
+  stats->Done("/device:CPU:0");
+  return true;
+}
+
+TEST(SampledStepStatsCollectorTest, AddsSampledTimesToCostModel) {
+  auto graph = CreateGraph();
+  const std::unordered_map<std::string, const Graph*> device_map = {
+      {"/device:CPU:0", graph.get()}};
+  SampledStepStatsCollector collector(device_map);
+  CostModelManager cost_model_manager;
+  Node* c = FindNode(*graph, "C");
+
+  for (int step = 0; step < 3; ++step) {
+    ASSERT_TRUE(collector.Start());
+    // A step is collected at a time.
+    EXPECT_FALSE(collector.Start());
+    for (Node* node : graph->op_nodes()) {
+      EXPECT_TRUE(ExecuteNode(&collector, node->def()));
+    }
+    collector.Finish(&cost_model_manager);
+  }
+  CostModel* cost_model = cost_model_manager.FindOrCreateCostModel(graph.get());
+  for (Node* node : graph->op_nodes()) {
+    EXPECT_EQ(cost_model->NumExecutionTimeSamples(node), 3);
+  }
+  EXPECT_GT(cost_model->ExecutionTimeQuantile(c, 0.5), Microseconds(0));
+
+  // Steps finished without a cost model manager are dropped.
+  ASSERT_TRUE(collector.Start());
+  EXPECT_TRUE(ExecuteNode(&collector, c->def()));
+  collector.Finish(nullptr);
+  EXPECT_EQ(cost_model->NumExecutionTimeSamples(c), 3);
+}
+
+TEST(SampledStepStatsCollectorTest, SkipsUnknownNodesAndExtraExecutions) {
+  auto graph = CreateGraph();
+  const std::unordered_map<std::string, const Graph*> device_map = {
+      {"/device:CPU:0", graph.get()}};
+  SampledStepStatsCollector collector(device_map);
+  CostModelManager cost_model_manager;
+  Node* c = FindNode(*graph, "C");
+
+  ASSERT_TRUE(collector.Start());
+  NodeDef unknown = c->def();
+  unknown.set_name("F/C");
+  EXPECT_FALSE(ExecuteNode(&collector, unknown));
+  // Nodes that don't finish computing are not recorded.
+  NodeExecStatsInterface* unfinished = collector.CreateNodeExecStats(&c->def());
+  ASSERT_NE(unfinished, nullptr);
+  unfinished->RecordComputeStarted();
+  // There are as many records as nodes in the graph.
+  EXPECT_TRUE(ExecuteNode(&collector, c->def()));
+  EXPECT_TRUE(ExecuteNode(&collector, c->def()));
+  EXPECT_FALSE(ExecuteNode(&collector, c->def()));
+  collector.Finish(&cost_model_manager);
+
+  CostModel* cost_model = cost_model_manager.FindOrCreateCostModel(graph.get());
+  EXPECT_EQ(cost_model->NumExecutionTimeSamples(c), 2);
+
+  // The records are reused by the next step.
+  ASSERT_TRUE(collector.Start());
+  EXPECT_TRUE(ExecuteNode(&collector, c->def()));
+  collector.Finish(&cost_model_manager);
+  EXPECT_EQ(cost_model->NumExecutionTimeSamples(c), 3);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -33,6 +33,7 @@ SimplePropagatorState::SimplePropagatorState(
     : immutable_state_(immutable_state),
       step_id_(step_id),
       vlog_(vlog || VLOG_IS_ON(1)),
+      flat_schedule_(immutable_state.flat_schedule()),
       input_tensors_(finfo.total_inputs),
       pending_(
           new std::atomic<int32>[immutable_state.graph_view().num_nodes()]),
@@ -74,6 +75,25 @@ void SimplePropagatorState::PropagateOutputs(const TaggedNode& tagged_node,
   const GraphView& gview = immutable_state_.graph_view();
   const NodeItem* item = tagged_node.node_item;
 
+  if (flat_schedule_ != nullptr) {
+    for (const ImmutableExecutorState::FlatSchedule::Successor& s :
+         flat_schedule_->successors_of(item->node_id)) {
+      if (s.input_slot >= 0) {
+        // As below, the input must be written before the pending count is
+        // decremented.
+        if (s.is_last) {
+          input_tensors_[s.input_slot] = std::move((*outputs)[s.output_slot]);
+        } else {
+          input_tensors_[s.input_slot] = (*outputs)[s.output_slot];
+        }
+      }
+      int32_t previous_num_pending =
+          pending_[s.dst_id].fetch_sub(1, std::memory_order_release);
+      if (previous_num_pending == 1) ready->emplace_back(s.dst);
+    }
+    return;
+  }
+
   for (const EdgeInfo& e : item->output_edges()) {
     const int dst_id = e.dst_id;
     const int src_slot = e.output_slot;
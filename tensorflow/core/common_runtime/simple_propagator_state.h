@@ -165,6 +165,10 @@ class SimplePropagatorState {
   const int64_t step_id_;
   const bool vlog_;
 
+  // If not null, `PropagateOutputs()` reads successors from this schedule
+  // instead of from the `NodeItem` edge trailers. Not owned.
+  const ImmutableExecutorState::FlatSchedule* const flat_schedule_;
+
   // The i-th node's j-th input is stored at
   // `input_tensors[impl_->nodes[i].input_start + j]`.
   //
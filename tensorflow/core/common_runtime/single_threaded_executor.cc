@@ -15,18 +15,26 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/single_threaded_executor.h"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -40,9 +48,9 @@ Status ValidateOpIsSafeForSyncExecution(
           DataTypeString(dt), " in outputs of node ", n.name());
     }
   }
-  // Executing Switch nodes requires propagating deadness which is
-  // not currently supported in the SingleThreadedExecutor.
-  if (n.IsSwitch()) {
+  // Executing Switch nodes requires propagating deadness, which the
+  // SingleThreadedExecutor only does for graphs that may contain control flow.
+  if (n.IsSwitch() && !allow_control_flow_sync_execution) {
     return errors::FailedPrecondition(
         "Single-threaded executor does not support switch op, but saw node ",
         n.name(),
@@ -67,6 +75,501 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
 static const string& kSingleThreadedExecutor =
     *new string("SINGLE_THREADED_EXECUTOR");
+static const string& kSingleThreadedPlannedMemoryExecutor =
+    *new string("SINGLE_THREADED_PLANNED_MEMORY_EXECUTOR");
+
+// Static information about a node of a graph that contains control flow.
+struct ControlFlowNode {
+  // The kernel object. Not owned.
+  //
+  // This pointer is managed by `params_.create_kernel()` and
+  // `params_.delete_kernel()`.
+  OpKernel* kernel = nullptr;
+  int num_inputs = 0;
+  int num_outputs = 0;
+
+  // The static frame that this node runs in, the index of this node among the
+  // nodes of that frame, and the location of its first input in the input
+  // array of each iteration of the frame.
+  int frame = 0;
+  int local_id = 0;
+  int input_start = 0;
+
+  // For Enter nodes, the static frame that this node enters.
+  int enter_frame = -1;
+
+  bool is_merge = false;
+  bool is_enter = false;
+  bool is_constant_enter = false;
+  bool is_exit = false;
+  bool is_next_iteration = false;
+  bool is_control_trigger = false;
+
+  struct OutputEdge {
+    // The index of the destination node.
+    int dst;
+    // The location in the destination's iteration input array.
+    int input_slot;
+    int output_slot;
+    // True if this is the last edge that consumes `output_slot`, which allows
+    // the value to be moved instead of copied.
+    bool is_last;
+  };
+  std::vector<OutputEdge> output_edges;
+  std::vector<int> output_control_edges;
+
+  // Memory space information for each output of `kernel`.
+  std::vector<AllocatorAttributes> output_alloc_attrs;
+};
+
+// Static information about a frame of a graph that contains control flow.
+struct ControlFlowFrameInfo {
+  string name;
+  int parallel_iterations = 1;
+  // The number of Enter nodes that enter this frame.
+  int num_enters = 0;
+  // The total number of inputs of the nodes in this frame.
+  int total_inputs = 0;
+  // The initial pending count of each node in this frame, by `local_id`.
+  // Merge nodes use bit 0 to indicate whether a live data input is pending.
+  std::vector<int> initial_pending;
+};
+
+// The per-step execution state of a graph that contains control flow.
+//
+// This is a single-threaded counterpart of `PropagatorState`, which
+// implements the same semantics for frames, iterations and dead tensors. Since
+// nodes run one at a time, it needs neither locks nor atomic counters, and
+// keeps its ready nodes in a LIFO stack to execute the graph depth-first.
+class ControlFlowState {
+ public:
+  struct Iteration {
+    Iteration(int64_t iter_num, const ControlFlowFrameInfo& info)
+        : iter_num(iter_num),
+          inputs(info.total_inputs),
+          pending(info.initial_pending),
+          dead_count(info.initial_pending.size(), 0) {}
+
+    const int64_t iter_num;
+    std::vector<Entry> inputs;
+    std::vector<int> pending;
+    std::vector<int> dead_count;
+    // The number of nodes of this iteration that are ready or running.
+    int outstanding_ops = 0;
+    // The number of child frames that were entered from this iteration and
+    // are not done.
+    int outstanding_frame_count = 0;
+  };
+
+  struct Frame {
+    const ControlFlowFrameInfo* info;
+    uint64 id;
+    Frame* parent;
+    Iteration* parent_iter;
+    int num_pending_inputs;
+    int num_outstanding_iterations = 1;
+    int64_t iteration_count = 0;
+    // The iterations that are not done, starting with `first_iter`.
+    std::deque<std::unique_ptr<Iteration>> iterations;
+    int64_t first_iter = 0;
+
+    // Dead Exit nodes of the current iteration, which are propagated to the
+    // parent frame when this frame is done.
+    std::vector<int> dead_exits;
+    // NextIteration values that wait for the number of outstanding iterations
+    // to drop below `info->parallel_iterations`.
+    std::vector<std::pair<int, Entry>> next_iter_roots;
+    // The values of constant Enter nodes, which feed every iteration.
+    std::vector<std::pair<int, Entry>> inv_values;
+
+    Iteration* GetIteration(int64_t iter_num) {
+      if (iter_num < first_iter ||
+          iter_num - first_iter >= static_cast<int64_t>(iterations.size())) {
+        return nullptr;
+      }
+      return iterations[iter_num - first_iter].get();
+    }
+  };
+
+  struct TaggedNode {
+    int node;
+    Frame* frame;
+    Iteration* iter;
+    bool is_dead;
+  };
+
+  ControlFlowState(const std::vector<ControlFlowNode>& nodes,
+                   const std::vector<ControlFlowFrameInfo>& frames)
+      : nodes_(nodes), frames_(frames) {
+    auto root = std::make_unique<Frame>();
+    root->info = &frames_[0];
+    root->id = 0;
+    root->parent = nullptr;
+    root->parent_iter = nullptr;
+    root->num_pending_inputs = 0;
+    root->iterations.push_back(std::make_unique<Iteration>(0, frames_[0]));
+    root_frame_ = root.get();
+    outstanding_frames_.emplace(0, std::move(root));
+  }
+
+  void ActivateRoots(const std::vector<int>& roots) {
+    Iteration* iter = root_frame_->GetIteration(0);
+    for (int node : roots) {
+      ready_.push_back({node, root_frame_, iter, false});
+    }
+    iter->outstanding_ops = roots.size();
+  }
+
+  // Pops the next ready node into `*tagged_node`, or returns false if there
+  // are none.
+  bool PopReady(TaggedNode* tagged_node) {
+    if (ready_.empty()) return false;
+    *tagged_node = ready_.back();
+    ready_.pop_back();
+    return true;
+  }
+
+  // Propagates the `outputs` of `tagged_node`, which has finished executing,
+  // and marks the nodes that become ready.
+  void PropagateOutputs(const TaggedNode& tagged_node, EntryVector* outputs);
+
+ private:
+  int ActivateNodes(const ControlFlowNode& node, bool is_dead, Frame* frame,
+                    Iteration* iter, EntryVector* outputs);
+  Frame* FindOrCreateChildFrame(Frame* frame, Iteration* iter,
+                                const ControlFlowNode& node);
+  void DeleteFrame(Frame* frame);
+  void CleanupFramesIterations(Frame* frame, Iteration* iter);
+  bool AdjustOutstandingOps(Frame* frame, Iteration* iter, int delta);
+  bool CleanupIterations(Frame* frame, Iteration* iter);
+  bool IsIterationDone(Frame* frame, Iteration* iter);
+  Iteration* IncrementIteration(Frame* frame);
+  void AddLoopInv(Frame* frame, int node, const Entry& entry);
+  void ActivateEntries(Frame* frame, Iteration* iter,
+                       const std::vector<std::pair<int, Entry>>& entries);
+
+  void AddReady(const ControlFlowNode& dst, int dst_index, Frame* frame,
+                Iteration* iter, bool dst_dead) {
+    if (dst.is_control_trigger) dst_dead = false;
+    ready_.push_back({dst_index, frame, iter, dst_dead});
+  }
+
+  const std::vector<ControlFlowNode>& nodes_;
+  const std::vector<ControlFlowFrameInfo>& frames_;
+  Frame* root_frame_;
+  absl::flat_hash_map<uint64, std::unique_ptr<Frame>> outstanding_frames_;
+  std::vector<TaggedNode> ready_;
+};
+
+int ControlFlowState::ActivateNodes(const ControlFlowNode& node, bool is_dead,
+                                    Frame* frame, Iteration* iter,
+                                    EntryVector* outputs) {
+  int activated = 0;
+  for (const ControlFlowNode::OutputEdge& e : node.output_edges) {
+    const ControlFlowNode& dst = nodes_[e.dst];
+    int& pending = iter->pending[dst.local_id];
+    int& dead_count = iter->dead_count[dst.local_id];
+    Entry& output = (*outputs)[e.output_slot];
+    bool dst_ready;
+    bool dst_dead;
+    if (dst.is_merge) {
+      // A Merge node is ready when all of its control inputs have arrived,
+      // and either its first live data input arrives or all of its data
+      // inputs are dead.
+      if (output.state != Entry::State::NO_VALUE) {
+        dst_ready = pending == 1;
+        dst_dead = false;
+        if (pending & 1) {
+          pending &= ~1;
+          if (e.is_last) {
+            iter->inputs[e.input_slot] = std::move(output);
+          } else {
+            iter->inputs[e.input_slot] = output;
+          }
+        }
+      } else {
+        // A dead Enter makes the Merge dead, which handles a loop on the
+        // untaken branch of a conditional.
+        ++dead_count;
+        dst_dead = dead_count == dst.num_inputs || node.is_enter;
+        dst_ready = pending == 1 && dst_dead;
+      }
+    } else {
+      if (is_dead || output.state == Entry::State::NO_VALUE) {
+        ++dead_count;
+      } else if (e.is_last) {
+        iter->inputs[e.input_slot] = std::move(output);
+      } else {
+        iter->inputs[e.input_slot] = output;
+      }
+      dst_dead = dead_count > 0;
+      dst_ready = --pending == 0;
+    }
+    if (dst_ready) {
+      AddReady(dst, e.dst, frame, iter, dst_dead);
+      ++activated;
+    }
+  }
+
+  for (int dst_index : node.output_control_edges) {
+    const ControlFlowNode& dst = nodes_[dst_index];
+    int& pending = iter->pending[dst.local_id];
+    int& dead_count = iter->dead_count[dst.local_id];
+    bool dst_ready;
+    bool dst_dead;
+    if (dst.is_merge) {
+      pending -= 2;
+      dst_dead = dead_count == dst.num_inputs;
+      dst_ready = pending == 0 || (pending == 1 && dst_dead);
+    } else {
+      if (is_dead) ++dead_count;
+      dst_dead = dead_count > 0;
+      dst_ready = --pending == 0;
+    }
+    if (dst_ready) {
+      AddReady(dst, dst_index, frame, iter, dst_dead);
+      ++activated;
+    }
+  }
+  return activated;
+}
+
+void ControlFlowState::PropagateOutputs(const TaggedNode& tagged_node,
+                                        EntryVector* outputs) {
+  const ControlFlowNode& node = nodes_[tagged_node.node];
+  Frame* const input_frame = tagged_node.frame;
+  Iteration* const input_iter = tagged_node.iter;
+  const bool is_dead = tagged_node.is_dead;
+
+  bool is_frame_done;
+  if (node.is_enter) {
+    Frame* child = FindOrCreateChildFrame(input_frame, input_iter, node);
+    if (node.is_constant_enter) {
+      // Propagate loop invariants to all active iterations.
+      AddLoopInv(child, tagged_node.node, (*outputs)[0]);
+    } else {
+      Iteration* iter = child->GetIteration(0);
+      AdjustOutstandingOps(child, iter,
+                           ActivateNodes(node, is_dead, child, iter, outputs));
+    }
+    --child->num_pending_inputs;
+    is_frame_done = AdjustOutstandingOps(input_frame, input_iter, -1);
+  } else if (node.is_exit) {
+    if (is_dead) {
+      // Remember dead exits of the last iteration, and propagate them to the
+      // parent frame when this frame is done.
+      if (input_iter->iter_num == input_frame->iteration_count) {
+        input_frame->dead_exits.push_back(tagged_node.node);
+      }
+    } else {
+      Frame* parent = input_frame->parent;
+      Iteration* parent_iter = input_frame->parent_iter;
+      AdjustOutstandingOps(
+          parent, parent_iter,
+          ActivateNodes(node, is_dead, parent, parent_iter, outputs));
+    }
+    is_frame_done = AdjustOutstandingOps(input_frame, input_iter, -1);
+  } else if (node.is_next_iteration) {
+    // A dead NextIteration stops the propagation of deadness.
+    if (!is_dead) {
+      Iteration* next_iter = nullptr;
+      if (input_iter->iter_num < input_frame->iteration_count) {
+        next_iter = input_frame->GetIteration(input_iter->iter_num + 1);
+      } else if (input_frame->num_outstanding_iterations <
+                 input_frame->info->parallel_iterations) {
+        next_iter = IncrementIteration(input_frame);
+      } else {
+        // Defer the value until an earlier iteration is done.
+        input_frame->next_iter_roots.emplace_back(tagged_node.node,
+                                                  (*outputs)[0]);
+      }
+      if (next_iter != nullptr) {
+        AdjustOutstandingOps(
+            input_frame, next_iter,
+            ActivateNodes(node, is_dead, input_frame, next_iter, outputs));
+      }
+    }
+    is_frame_done = AdjustOutstandingOps(input_frame, input_iter, -1);
+  } else {
+    is_frame_done = AdjustOutstandingOps(
+        input_frame, input_iter,
+        ActivateNodes(node, is_dead, input_frame, input_iter, outputs) - 1);
+  }
+
+  if (is_frame_done) {
+    Frame* parent = input_frame->parent;
+    Iteration* parent_iter = input_frame->parent_iter;
+    DeleteFrame(input_frame);
+    if (parent != nullptr) {
+      CleanupFramesIterations(parent, parent_iter);
+    }
+  }
+}
+
+ControlFlowState::Frame* ControlFlowState::FindOrCreateChildFrame(
+    Frame* frame, Iteration* iter, const ControlFlowNode& node) {
+  const ControlFlowFrameInfo& info = frames_[node.enter_frame];
+  const uint64 child_id = Hash64Combine(
+      frame->id, Hash64Combine(iter->iter_num, Hash64(info.name)));
+  auto it = outstanding_frames_.find(child_id);
+  if (it != outstanding_frames_.end()) {
+    return it->second.get();
+  }
+  auto child = std::make_unique<Frame>();
+  child->info = &info;
+  child->id = child_id;
+  child->parent = frame;
+  child->parent_iter = iter;
+  child->num_pending_inputs = info.num_enters;
+  child->iterations.push_back(std::make_unique<Iteration>(0, info));
+  ++iter->outstanding_frame_count;
+  Frame* ret = child.get();
+  outstanding_frames_.emplace(child_id, std::move(child));
+  return ret;
+}
+
+void ControlFlowState::DeleteFrame(Frame* frame) {
+  // Propagate the dead exits (if any) to the parent frame.
+  Frame* parent = frame->parent;
+  Iteration* parent_iter = frame->parent_iter;
+  if (parent != nullptr) {
+    for (int exit : frame->dead_exits) {
+      const ControlFlowNode& node = nodes_[exit];
+      for (const ControlFlowNode::OutputEdge& e : node.output_edges) {
+        const ControlFlowNode& dst = nodes_[e.dst];
+        int& pending = parent_iter->pending[dst.local_id];
+        int& dead_count = parent_iter->dead_count[dst.local_id];
+        ++dead_count;
+        bool dst_ready;
+        bool dst_dead = true;
+        if (dst.is_merge) {
+          dst_dead = dead_count == dst.num_inputs;
+          dst_ready = pending == 1 && dst_dead;
+        } else {
+          dst_ready = --pending == 0;
+        }
+        if (dst_ready) {
+          AddReady(dst, e.dst, parent, parent_iter, dst_dead);
+          ++parent_iter->outstanding_ops;
+        }
+      }
+      for (int dst_index : node.output_control_edges) {
+        const ControlFlowNode& dst = nodes_[dst_index];
+        int& pending = parent_iter->pending[dst.local_id];
+        int& dead_count = parent_iter->dead_count[dst.local_id];
+        bool dst_ready;
+        bool dst_dead = true;
+        if (dst.is_merge) {
+          pending -= 2;
+          dst_dead = dead_count == dst.num_inputs;
+          dst_ready = pending == 0 || (pending == 1 && dst_dead);
+        } else {
+          ++dead_count;
+          dst_ready = --pending == 0;
+        }
+        if (dst_ready) {
+          AddReady(dst, dst_index, parent, parent_iter, dst_dead);
+          ++parent_iter->outstanding_ops;
+        }
+      }
+    }
+  }
+  outstanding_frames_.erase(frame->id);
+}
+
+void ControlFlowState::CleanupFramesIterations(Frame* frame, Iteration* iter) {
+  --iter->outstanding_frame_count;
+  if (CleanupIterations(frame, iter)) {
+    Frame* parent = frame->parent;
+    Iteration* parent_iter = frame->parent_iter;
+    DeleteFrame(frame);
+    if (parent != nullptr) {
+      // The completion of a frame may complete its parent frame.
+      CleanupFramesIterations(parent, parent_iter);
+    }
+  }
+}
+
+bool ControlFlowState::AdjustOutstandingOps(Frame* frame, Iteration* iter,
+                                            int delta) {
+  iter->outstanding_ops += delta;
+  DCHECK_GE(iter->outstanding_ops, 0);
+  if (iter->outstanding_ops != 0) return false;
+  return CleanupIterations(frame, iter);
+}
+
+bool ControlFlowState::IsIterationDone(Frame* frame, Iteration* iter) {
+  if (iter->outstanding_ops != 0 || iter->outstanding_frame_count != 0) {
+    return false;
+  }
+  if (iter->iter_num == 0) {
+    // The enclosing frame has no pending input.
+    return frame->num_pending_inputs == 0;
+  }
+  // The preceding iteration is done, and has been deleted.
+  return frame->GetIteration(iter->iter_num - 1) == nullptr;
+}
+
+bool ControlFlowState::CleanupIterations(Frame* frame, Iteration* iter) {
+  int64_t curr_iter = iter->iter_num;
+  while (curr_iter <= frame->iteration_count && IsIterationDone(frame, iter)) {
+    DCHECK_EQ(frame->first_iter, curr_iter);
+    frame->iterations.pop_front();
+    ++frame->first_iter;
+    --frame->num_outstanding_iterations;
+    ++curr_iter;
+
+    // Start a deferred iteration, now that there is room for it.
+    if (!frame->next_iter_roots.empty()) {
+      IncrementIteration(frame);
+    }
+    if (curr_iter <= frame->iteration_count) {
+      iter = frame->GetIteration(curr_iter);
+    }
+  }
+  return frame->num_pending_inputs == 0 &&
+         frame->num_outstanding_iterations == 0;
+}
+
+ControlFlowState::Iteration* ControlFlowState::IncrementIteration(
+    Frame* frame) {
+  ++frame->iteration_count;
+  frame->iterations.push_back(
+      std::make_unique<Iteration>(frame->iteration_count, *frame->info));
+  Iteration* next_iter = frame->iterations.back().get();
+  ++frame->num_outstanding_iterations;
+  frame->dead_exits.clear();
+
+  // Activate the successors of the deferred NextIteration nodes, and the loop
+  // invariants, in the new iteration.
+  std::vector<std::pair<int, Entry>> next_iter_roots;
+  next_iter_roots.swap(frame->next_iter_roots);
+  ActivateEntries(frame, next_iter, next_iter_roots);
+  ActivateEntries(frame, next_iter, frame->inv_values);
+  return next_iter;
+}
+
+void ControlFlowState::AddLoopInv(Frame* frame, int node, const Entry& entry) {
+  frame->inv_values.emplace_back(node, entry);
+  std::vector<std::pair<int, Entry>> inv_value = {{node, entry}};
+  for (int64_t i = frame->first_iter; i <= frame->iteration_count; ++i) {
+    ActivateEntries(frame, frame->GetIteration(i), inv_value);
+  }
+}
+
+void ControlFlowState::ActivateEntries(
+    Frame* frame, Iteration* iter,
+    const std::vector<std::pair<int, Entry>>& entries) {
+  int activated = 0;
+  for (const auto& node_entry : entries) {
+    EntryVector outputs{node_entry.second};
+    activated += ActivateNodes(
+        nodes_[node_entry.first],
+        node_entry.second.state == Entry::State::NO_VALUE, frame, iter,
+        &outputs);
+  }
+  AdjustOutstandingOps(frame, iter, activated);
+}
 
 class SingleThreadedExecutorImpl : public Executor {
  public:
@@ -80,9 +583,21 @@ class SingleThreadedExecutorImpl : public Executor {
     for (const ConstTensorKernelState& kernel_state : const_tensor_kernels_) {
       params_.delete_kernel(kernel_state.kernel);
     }
+    for (const ControlFlowNode& node : control_flow_nodes_) {
+      params_.delete_kernel(node.kernel);
+    }
   }
 
   Status Initialize(const Graph& graph) {
+    if (params_.allow_control_flow_sync_execution) {
+      for (const Node* n : graph.nodes()) {
+        if (n->IsSwitch() || n->IsMerge() || n->IsEnter() || n->IsExit() ||
+            n->IsNextIteration()) {
+          return InitializeControlFlow(graph);
+        }
+      }
+    }
+
     // Topologicially sort `graph` to get a sequence of OpKernels.
     std::vector<Node*> ordered_nodes;
     ordered_nodes.reserve(graph.num_nodes());
@@ -210,11 +725,15 @@ class SingleThreadedExecutorImpl : public Executor {
       Node* n = nodes_with_kernels[i];
       KernelState& kernel_state = kernels_[i];
       kernel_state.output_locations.resize(kernel_state.num_outputs);
+      kernel_state.output_last_use.assign(kernel_state.num_outputs, i);
       for (const Edge* e : n->out_edges()) {
         if (!e->IsControlEdge()) {
+          const size_t dst_index = node_to_index_map[e->dst()];
           kernel_state.output_locations[e->src_output()].push_back(
-              kernels_[node_to_index_map[e->dst()]].input_start_index +
-              e->dst_input());
+              kernels_[dst_index].input_start_index + e->dst_input());
+          kernel_state.output_last_use[e->src_output()] =
+              std::max(kernel_state.output_last_use[e->src_output()],
+                       dst_index);
         }
       }
 
@@ -295,13 +814,43 @@ class SingleThreadedExecutorImpl : public Executor {
     TensorValueVec node_inputs;
     AllocatorAttributeVec input_alloc_attrs;
 
-    // Override intra op thread pool if requested.
+    // If memory planning is enabled, the first step records the size of each
+    // output, and later steps serve outputs from the resulting arena plan.
+    std::shared_ptr<const MemoryPlan> memory_plan;
+    std::vector<std::vector<size_t>> output_bytes;
+    PlannedArenaAllocator* planned_allocator = nullptr;
+    if (params_.plan_memory && !has_control_flow_) {
+      {
+        mutex_lock l(memory_plan_mu_);
+        memory_plan = memory_plan_;
+      }
+      if (memory_plan == nullptr) {
+        output_bytes.resize(kernels_.size());
+      } else {
+        planned_allocator = PlannedArenaAllocator::Create(
+            memory_plan, args.step_allocator != nullptr
+                             ? args.step_allocator
+                             : params_.device->GetAllocator({}));
+      }
+    }
+    auto planned_allocator_cleanup = gtl::MakeCleanup([planned_allocator] {
+      if (planned_allocator != nullptr) {
+        planned_allocator->EndStep();
+      }
+    });
+    Allocator* step_allocator = planned_allocator != nullptr
+                                    ? planned_allocator
+                                    : args.step_allocator;
+
+    // Override intra op thread pool and default allocator if requested.
     Device* device = params_.device;
     std::unique_ptr<Device> user_device;
-    if (args.user_intra_op_threadpool != nullptr) {
+    if (args.user_intra_op_threadpool != nullptr ||
+        step_allocator != nullptr) {
       user_device = RenamedDevice::NewRenamedDevice(
           device->name(), device, /*owns_underlying=*/false,
-          /*isolate_session_state=*/false, args.user_intra_op_threadpool);
+          /*isolate_session_state=*/false, args.user_intra_op_threadpool,
+          step_allocator);
       device = user_device.get();
     }
 
@@ -344,6 +893,10 @@ class SingleThreadedExecutorImpl : public Executor {
     // TODO(mrry): Consider implementing forwarding.
     params.forward_from_array = nullptr;
 
+    if (has_control_flow_) {
+      return RunWithControlFlow(&params, device);
+    }
+
     const size_t received_args =
         args.call_frame ? args.call_frame->num_args() : 0;
     if (TF_PREDICT_FALSE(arg_output_locations_.size() > received_args)) {
@@ -443,6 +996,9 @@ class SingleThreadedExecutorImpl : public Executor {
       OpKernelContext ctx(&params, num_outputs);
 
       // Actually execute the kernel.
+      if (planned_allocator != nullptr) {
+        planned_allocator->BeginNode(i);
+      }
       device->Compute(kernel_state.kernel, &ctx);
       TF_RETURN_IF_ERROR(ctx.status());
 
@@ -454,6 +1010,13 @@ class SingleThreadedExecutorImpl : public Executor {
       // Forward the outputs of the kernel to the inputs of subsequent kernels.
       for (size_t j = 0; j < num_outputs; ++j) {
         TensorValue val = ctx.release_output(j);
+        if (!output_bytes.empty()) {
+          output_bytes[i].push_back(
+              val.tensor != nullptr &&
+                      DataTypeCanUseMemcpy(val.tensor->dtype())
+                  ? val.tensor->TotalBytes()
+                  : 0);
+        }
         const size_t num_destinations = kernel_state.output_locations[j].size();
         if (num_destinations > 0) {
           // TODO(mrry): Consider flattening the `output_locations` vector
@@ -482,6 +1045,9 @@ class SingleThreadedExecutorImpl : public Executor {
         delete val.tensor;
       }
     }
+    if (!output_bytes.empty()) {
+      BuildMemoryPlan(output_bytes);
+    }
     return absl::OkStatus();
   }
 
@@ -495,6 +1061,259 @@ class SingleThreadedExecutorImpl : public Executor {
     args.runner([this, args, done]() { done(Run(args)); });
   }
 
+  // Initializes the executor for a graph that contains Switch, Merge, Enter,
+  // Exit or NextIteration nodes. Such graphs are executed by
+  // `RunWithControlFlow()`, which tracks the frames and iterations of each
+  // node, and propagates deadness, instead of running the kernels in a fixed
+  // order.
+  Status InitializeControlFlow(const Graph& graph) {
+    has_control_flow_ = true;
+    total_num_inputs_ = 0;
+
+    // Assign every node to the static frame that it runs in. As in the full
+    // executor, an Enter node runs in the frame of its input and an Exit node
+    // runs in the frame that it exits.
+    absl::flat_hash_map<string, int> frame_indices;
+    control_flow_frames_.emplace_back();
+    frame_indices[""] = 0;
+    std::vector<int> node_frame(graph.num_node_ids(), -1);
+    std::vector<const Node*> parent_enter(graph.num_node_ids(), nullptr);
+    std::deque<const Node*> ready;
+    for (const Node* n : graph.nodes()) {
+      if (n->in_edges().empty()) {
+        node_frame[n->id()] = 0;
+        ready.push_back(n);
+      }
+    }
+    while (!ready.empty()) {
+      const Node* n = ready.front();
+      ready.pop_front();
+      int frame = node_frame[n->id()];
+      const Node* parent = parent_enter[n->id()];
+      if (n->IsEnter()) {
+        string frame_name;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "frame_name", &frame_name));
+        auto it = frame_indices.emplace(
+            frame_name, static_cast<int>(frame_indices.size()));
+        if (it.second) {
+          control_flow_frames_.emplace_back();
+          control_flow_frames_.back().name = frame_name;
+        }
+        frame = it.first->second;
+        parent = n;
+      } else if (n->IsExit()) {
+        if (parent == nullptr) {
+          return errors::InvalidArgument(
+              "Invalid Exit op: Cannot find a corresponding Enter op.");
+        }
+        frame = node_frame[parent->id()];
+        parent = parent_enter[parent->id()];
+      }
+      for (const Node* out : n->out_nodes()) {
+        if (out->IsSink() || node_frame[out->id()] != -1) continue;
+        node_frame[out->id()] = frame;
+        parent_enter[out->id()] = parent;
+        ready.push_back(out);
+      }
+    }
+
+    // Create the kernel and the static state of each node.
+    std::vector<int> node_to_index(graph.num_node_ids(), -1);
+    std::vector<const Node*> index_to_node;
+    for (const Node* n : graph.nodes()) {
+      if (n->IsSource() || n->IsSink()) {
+        continue;
+      }
+      TF_RETURN_IF_ERROR(ValidateOpIsSafeForSyncExecution(
+          *n, params_.allow_control_flow_sync_execution));
+      if (node_frame[n->id()] == -1) {
+        return errors::InvalidArgument("Node ", n->name(),
+                                       " is not reachable from the source.");
+      }
+      OpKernel* kernel;
+      TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
+      node_to_index[n->id()] = control_flow_nodes_.size();
+      index_to_node.push_back(n);
+      control_flow_nodes_.emplace_back();
+      ControlFlowNode& node = control_flow_nodes_.back();
+      node.kernel = kernel;
+      node.num_inputs = n->num_inputs();
+      node.num_outputs = n->num_outputs();
+      node.is_merge = n->IsMerge();
+      node.is_enter = n->IsEnter();
+      node.is_exit = n->IsExit();
+      node.is_next_iteration = n->IsNextIteration();
+      node.is_control_trigger = n->IsControlTrigger();
+
+      node.frame = node_frame[n->id()];
+      ControlFlowFrameInfo& frame_info = control_flow_frames_[node.frame];
+      node.input_start = frame_info.total_inputs;
+      frame_info.total_inputs += node.num_inputs;
+
+      // Nodes without inputs other than the source node are the roots.
+      int num_control_edges = 0;
+      int num_in_edges = 0;
+      for (const Edge* e : n->in_edges()) {
+        if (e->src()->IsSource()) continue;
+        ++num_in_edges;
+        if (e->IsControlEdge()) ++num_control_edges;
+      }
+      node.local_id = frame_info.initial_pending.size();
+      frame_info.initial_pending.push_back(
+          node.is_merge ? 1 + 2 * num_control_edges : num_in_edges);
+      if (num_in_edges == 0) {
+        control_flow_roots_.push_back(index_to_node.size() - 1);
+      }
+
+      if (node.is_enter) {
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "is_constant",
+                                       &node.is_constant_enter));
+        string frame_name;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "frame_name", &frame_name));
+        int parallel_iterations;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "parallel_iterations",
+                                       &parallel_iterations));
+        node.enter_frame = frame_indices[frame_name];
+        ControlFlowFrameInfo& enter_frame_info =
+            control_flow_frames_[node.enter_frame];
+        if (enter_frame_info.num_enters++ == 0) {
+          enter_frame_info.parallel_iterations =
+              std::max(parallel_iterations, 1);
+        }
+      }
+
+      node.output_alloc_attrs.resize(node.num_outputs);
+      for (int out = 0; out < node.num_outputs; ++out) {
+        if (node.kernel->output_memory_types()[out] == HOST_MEMORY) {
+          node.output_alloc_attrs[out].set_on_host(true);
+        }
+      }
+    }
+
+    // Build the edges between nodes, once the input locations are known.
+    for (size_t i = 0; i < control_flow_nodes_.size(); ++i) {
+      ControlFlowNode& node = control_flow_nodes_[i];
+      std::vector<int> last_edge(node.num_outputs, -1);
+      for (const Edge* e : index_to_node[i]->out_edges()) {
+        if (e->dst()->IsSink()) continue;
+        const int dst = node_to_index[e->dst()->id()];
+        if (e->IsControlEdge()) {
+          node.output_control_edges.push_back(dst);
+        } else {
+          last_edge[e->src_output()] = node.output_edges.size();
+          node.output_edges.push_back(
+              {dst, control_flow_nodes_[dst].input_start + e->dst_input(),
+               e->src_output(), false});
+        }
+      }
+      for (int edge : last_edge) {
+        if (edge != -1) node.output_edges[edge].is_last = true;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Runs a graph that was initialized by `InitializeControlFlow()`.
+  Status RunWithControlFlow(OpKernelContext::Params* params, Device* device) {
+    ControlFlowState state(control_flow_nodes_, control_flow_frames_);
+    state.ActivateRoots(control_flow_roots_);
+
+    TensorValueVec node_inputs;
+    AllocatorAttributeVec input_alloc_attrs;
+    EntryVector outputs;
+    ControlFlowState::TaggedNode tagged_node;
+    while (state.PopReady(&tagged_node)) {
+      const ControlFlowNode& node = control_flow_nodes_[tagged_node.node];
+      Entry* inputs = tagged_node.iter->inputs.data() + node.input_start;
+      outputs.clear();
+      outputs.resize(node.num_outputs);
+
+      // Dead nodes do not run, and all of their outputs are dead.
+      if (!tagged_node.is_dead) {
+        node_inputs.clear();
+        node_inputs.resize(node.num_inputs);
+        input_alloc_attrs.clear();
+        input_alloc_attrs.resize(node.num_inputs);
+        for (int j = 0; j < node.num_inputs; ++j) {
+          Entry& input = inputs[j];
+          if (input.state == Entry::State::HAS_VALUE) {
+            node_inputs[j].tensor = input.val.get();
+          } else if (!node.is_merge) {
+            // Only the inputs of a Merge node may be missing.
+            return errors::Internal("Input ", j, " of node ",
+                                    node.kernel->name(), " was not valid.");
+          }
+          input_alloc_attrs[j] = input.alloc_attr;
+        }
+        params->inputs = node_inputs;
+        params->input_alloc_attrs = input_alloc_attrs;
+        params->op_kernel = node.kernel;
+        params->output_attr_array = node.output_alloc_attrs.data();
+        params->frame_iter = FrameAndIter(tagged_node.frame->id,
+                                          tagged_node.iter->iter_num);
+        OpKernelContext ctx(params, node.num_outputs);
+        device->Compute(node.kernel, &ctx);
+        TF_RETURN_IF_ERROR(ctx.status());
+
+        for (int j = 0; j < node.num_outputs; ++j) {
+          TensorValue val = ctx.release_output(j);
+          if (val.tensor != nullptr) {
+            Entry& output = outputs[j];
+            output.state = Entry::State::HAS_VALUE;
+            output.val.Init(std::move(*val.tensor));
+            output.alloc_attr = node.output_alloc_attrs[j];
+            delete val.tensor;
+          }
+        }
+      }
+
+      // Free the inputs to the current node.
+      for (int j = 0; j < node.num_inputs; ++j) {
+        inputs[j].ClearVal();
+      }
+      state.PropagateOutputs(tagged_node, &outputs);
+    }
+    return absl::OkStatus();
+  }
+
+  // Plans an arena for the outputs of the kernels, given the size in bytes of
+  // each output in one step, and installs the plan unless another step has
+  // already done so.
+  void BuildMemoryPlan(const std::vector<std::vector<size_t>>& output_bytes) {
+    std::vector<PlannedBuffer> buffers;
+    std::vector<std::pair<size_t, size_t>> buffer_outputs;
+    for (size_t i = 0; i < kernels_.size(); ++i) {
+      const KernelState& kernel_state = kernels_[i];
+      for (size_t j = 0; j < output_bytes[i].size(); ++j) {
+        // Only outputs allocated with default attributes use the arena.
+        if (output_bytes[i][j] == 0 ||
+            kernel_state.output_alloc_attrs[j].value != 0) {
+          continue;
+        }
+        PlannedBuffer buffer;
+        buffer.first_use = i;
+        buffer.last_use = kernel_state.output_last_use[j];
+        buffer.size = output_bytes[i][j];
+        buffers.push_back(buffer);
+        buffer_outputs.emplace_back(i, j);
+      }
+    }
+    auto plan = std::make_shared<MemoryPlan>();
+    plan->arena_bytes =
+        PlanArenaOffsets(&buffers, Allocator::kAllocatorAlignment);
+    plan->node_slots.resize(kernels_.size());
+    for (size_t b = 0; b < buffers.size(); ++b) {
+      plan->node_slots[buffer_outputs[b].first].push_back(
+          {buffers[b].offset, buffers[b].size});
+    }
+    VLOG(1) << "Planned a " << plan->arena_bytes << " byte arena for "
+            << buffers.size() << " outputs";
+    mutex_lock l(memory_plan_mu_);
+    if (memory_plan_ == nullptr) {
+      memory_plan_ = std::move(plan);
+    }
+  }
+
   const LocalExecutorParams params_;
 
   // All following members are read-only after Initialize().
@@ -504,6 +1323,15 @@ class SingleThreadedExecutorImpl : public Executor {
   // `RunAsync()` for details.
   size_t total_num_inputs_;
 
+  // True if the graph contains control flow, in which case only the following
+  // `control_flow_*` members are used.
+  bool has_control_flow_ = false;
+  std::vector<ControlFlowNode> control_flow_nodes_;
+  // The static frames of the graph. The root frame comes first.
+  std::vector<ControlFlowFrameInfo> control_flow_frames_;
+  // The indices of the nodes that have no inputs.
+  std::vector<int> control_flow_roots_;
+
   // Represents cached graph structure state for each kernel.
   struct KernelState {
     // The kernel object. Not owned.
@@ -528,6 +1356,10 @@ class SingleThreadedExecutorImpl : public Executor {
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
         output_alloc_attrs;  // Length = `num_outputs`.
+
+    // For the `j`th output of `kernel`, the index of the last kernel that
+    // consumes it, or the index of `kernel` if it has no consumers.
+    std::vector<size_t> output_last_use;  // Length = `num_outputs`.
   };
   std::vector<KernelState> kernels_;
 
@@ -568,6 +1400,12 @@ class SingleThreadedExecutorImpl : public Executor {
   // `RunAsync()` for details.
   std::vector<AllocatorAttributes>
       input_alloc_attrs_;  // Length = `total_num_inputs_`.
+
+  // The arena plan for the kernel outputs if `params_.plan_memory` is true,
+  // built after the first successful step.
+  mutex memory_plan_mu_;
+  std::shared_ptr<const MemoryPlan> memory_plan_
+      TF_GUARDED_BY(memory_plan_mu_);
 };
 
 class SingleThreadedExecutorRegistrar {
@@ -589,6 +1427,29 @@ class SingleThreadedExecutorRegistrar {
 };
 static SingleThreadedExecutorRegistrar registrar;
 
+class SingleThreadedPlannedMemoryExecutorRegistrar {
+ public:
+  SingleThreadedPlannedMemoryExecutorRegistrar() {
+    ExecutorFactory::Register(kSingleThreadedPlannedMemoryExecutor,
+                              new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      LocalExecutorParams planned_params = params;
+      planned_params.plan_memory = true;
+      Executor* ret;
+      TF_RETURN_IF_ERROR(
+          NewSingleThreadedExecutor(planned_params, graph, &ret));
+      out_executor->reset(ret);
+      return absl::OkStatus();
+    }
+  };
+};
+static SingleThreadedPlannedMemoryExecutorRegistrar planned_memory_registrar;
+
 }  // namespace
 
 Status NewSingleThreadedExecutor(const LocalExecutorParams& params,
@@ -34,10 +34,10 @@ namespace tensorflow {
 //
 // 1. Reference-typed tensors are not supported and will not be supported in
 //    future.
-// 2. Graphs with control flow (containing "Switch" and "Merge" nodes) are not
-//    currently supported. The current plan is to extend support to "functional"
-//    control flow after the TensorFlow APIs transition to building graphs in
-//    that form (e.g. `tf.cond_v2()`).
+// 2. Graphs with control flow (containing "Switch" and "Merge" nodes) are only
+//    supported if `params.allow_control_flow_sync_execution` is true. They are
+//    executed with a lightweight single-threaded frame stack, which does not
+//    support the memory planning of `params.plan_memory`.
 // 3. Partitioned graphs (containing "_Recv" nodes) are not currently supported.
 //    The present implementation executes kernels one at a time in topological
 //    order, and cannot currently distinguish between disconnected subgraphs
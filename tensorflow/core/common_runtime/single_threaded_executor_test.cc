@@ -104,12 +104,15 @@ class ExecutorTest : public ::testing::Test {
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
-    TF_CHECK_OK(
-        NewExecutor("SINGLE_THREADED_EXECUTOR", params, *graph, &exec_));
+    params.allow_control_flow_sync_execution = allow_control_flow_;
+    TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &exec_));
     runner_ = [](const std::function<void()>& fn) { fn(); };
     rendez_ = NewLocalRendezvous();
   }
 
+  string executor_type_ = "SINGLE_THREADED_EXECUTOR";
+  bool allow_control_flow_ = false;
+
   Status Run(Rendezvous* rendez) {
     Executor::Args args;
     args.rendezvous = rendez;
@@ -277,6 +280,113 @@ TEST_F(ExecutorTest, SelfAdd) {
   EXPECT_EQ(1024.0, V(retvals[0]));  // b=v10=2*v9=4*v8=...=1024*a=1024.0
 }
 
+TEST_F(ExecutorTest, Cond) {
+  allow_control_flow_ = true;
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto s = test::graph::Switch(g.get(), x, pred);
+  auto if_false = test::graph::Identity(g.get(), s, 0);
+  auto if_true = test::graph::Identity(g.get(), s, 1);
+  auto m = test::graph::Merge(g.get(), if_false,
+                              test::graph::Add(g.get(), if_true, if_true));
+  test::graph::Retval(g.get(), 0, m);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (bool taken : {false, true}) {
+    Tensor pred_value(DT_BOOL, TensorShape({}));
+    pred_value.scalar<bool>()() = taken;
+    FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(3.0), pred_value}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(taken ? 6.0 : 3.0, V(retvals[0]));
+  }
+}
+
+Node* LoopEnter(Graph* g, Node* input, bool is_constant,
+                int parallel_iterations) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("enter"), "Enter")
+                  .Input(input)
+                  .Attr("frame_name", "loop")
+                  .Attr("is_constant", is_constant)
+                  .Attr("parallel_iterations", parallel_iterations)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+// Builds a while loop that counts from 0 to the first argument, and returns
+// the final count.
+void BuildCountingLoop(Graph* g, int parallel_iterations) {
+  auto limit = test::graph::Arg(g, 0, DT_FLOAT);
+  auto counter = LoopEnter(g, test::graph::Constant(g, V(0.0)),
+                           /*is_constant=*/false, parallel_iterations);
+  auto loop_limit =
+      LoopEnter(g, limit, /*is_constant=*/true, parallel_iterations);
+  auto one = LoopEnter(g, test::graph::Constant(g, V(1.0)),
+                       /*is_constant=*/true, parallel_iterations);
+  // The second input is replaced by the NextIteration back edge below.
+  auto m = test::graph::Merge(g, counter, counter);
+  auto cond = test::graph::LoopCond(g, test::graph::Less(g, m, loop_limit));
+  auto s = test::graph::Switch(g, m, cond);
+  auto body = test::graph::Identity(g, s, 1);
+  auto next = test::graph::Next(g, g->NewName("next"),
+                                test::graph::Add(g, body, one));
+  TF_CHECK_OK(g->UpdateEdge(next, 0, m, 1));
+  test::graph::Retval(g, 0, test::graph::Exit(g, s));
+  FixupSourceAndSinkEdges(g);
+}
+
+class WhileLoopTest : public ExecutorTest,
+                      public ::testing::WithParamInterface<int> {};
+
+TEST_P(WhileLoopTest, CountsToLimit) {
+  allow_control_flow_ = true;
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildCountingLoop(g.get(), /*parallel_iterations=*/GetParam());
+  Create(std::move(g));
+  for (float limit : {0.0, 1.0, 100.0}) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(limit)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(limit, V(retvals[0]));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(ParallelIterations, WhileLoopTest,
+                         ::testing::Values(1, 10));
+
+TEST_F(ExecutorTest, PlannedMemory) {
+  executor_type_ = "SINGLE_THREADED_PLANNED_MEMORY_EXECUTOR";
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto v = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g.get(), v, v);
+  }
+  test::graph::Retval(g.get(), 0, v);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  // The first step records the output sizes; later steps run from the plan,
+  // and their results must outlive the step.
+  std::vector<Tensor> results;
+  for (int step = 0; step < 3; ++step) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(step + 1.0)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    results.push_back(retvals[0]);
+  }
+  for (int step = 0; step < 3; ++step) {
+    EXPECT_EQ(1024.0 * (step + 1), V(results[step]));
+  }
+}
+
 // Builds a graph which adds N copies of one variable "in". I.e.,
 //     a + a + a + ... + a
 // The returned graph is parenthesized ramdonly. I.e.,
@@ -0,0 +1,543 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/entry.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/common_runtime/single_threaded_executor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace {
+
+typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+static const string& kStaticScheduleExecutor =
+    *new string("STATIC_SCHEDULE");
+
+// The maximum number of lanes that a schedule is partitioned into.
+constexpr int kMaxLanes = 8;
+
+// Estimated node costs, in microseconds. Executors are created before any step
+// runs, so there are no measured costs to schedule with.
+constexpr int64_t kDefaultNodeCostMicros = 1;
+constexpr int64_t kDefaultExpensiveNodeCostMicros = 10;
+
+// Estimated delay, in microseconds, that an edge between two lanes adds to the
+// start of its destination node.
+constexpr int64_t kCrossLaneEdgeCostMicros = 2;
+
+class StaticScheduleExecutorImpl : public Executor {
+ public:
+  explicit StaticScheduleExecutorImpl(const LocalExecutorParams& params)
+      : params_(params) {}
+
+  ~StaticScheduleExecutorImpl() override {
+    for (const NodeState& node : nodes_) {
+      params_.delete_kernel(node.kernel);
+    }
+  }
+
+  Status Initialize(const Graph& graph);
+
+ private:
+  struct StepState;
+
+  void RunAsyncInternal(const Args& args, DoneCallback done) override;
+
+  // Runs the nodes of `lane` in order, starting at `position`, until the lane
+  // completes or reaches a node whose cross-lane inputs are not ready. If
+  // `resumed` is true, the inputs of the node at `position` are known to be
+  // ready.
+  void RunLane(StepState* step, int lane, size_t position, bool resumed) const;
+
+  // Runs the kernel of `nodes_[index]` (or skips it if the step has failed),
+  // forwards its outputs, and signals its cross-lane successors.
+  void ProcessNode(StepState* step, int32 index,
+                   OpKernelContext::Params* params, TensorValueVec* node_inputs,
+                   AllocatorAttributeVec* input_alloc_attrs) const;
+
+  // Records that a lane has run to completion, and finishes the step if it was
+  // the last one.
+  void FinishLane(StepState* step) const;
+
+  const LocalExecutorParams params_;
+
+  // All following members are read-only after Initialize().
+
+  // Cached graph structure state for each node, in topological order.
+  struct NodeState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params_.create_kernel()` and
+    // `params_.delete_kernel()`.
+    OpKernel* kernel = nullptr;
+
+    // The lane that runs this node, and the index of this node within
+    // `lanes_[lane]`.
+    int lane = 0;
+    size_t lane_position = 0;
+
+    // These fields determine the range of elements in the flat inputs vector
+    // that corresponds to the inputs of `kernel`.
+    size_t input_start_index = 0;
+    size_t num_inputs = 0;
+
+    size_t num_outputs = 0;
+
+    // For the `j`th output of `kernel`, `output_locations[j]` contains the
+    // locations in the flat inputs vector to which that output must be
+    // copied.
+    std::vector<std::vector<size_t>> output_locations;
+
+    // Memory space information for each output of `kernel`.
+    std::vector<AllocatorAttributes> output_alloc_attrs;
+
+    // The indices of the nodes in other lanes that depend on this node, with
+    // one entry per data or control edge.
+    std::vector<int32> cross_lane_successors;
+
+    // The number of data or control edges into this node from nodes in other
+    // lanes.
+    int32 num_cross_lane_inputs = 0;
+  };
+  std::vector<NodeState> nodes_;
+
+  // `lanes_[i]` contains the indices in `nodes_` of the nodes that lane `i`
+  // runs, in order.
+  std::vector<std::vector<int32>> lanes_;
+
+  // The sum of the number of inputs for each node in the graph.
+  size_t total_num_inputs_ = 0;
+
+  // Memory space information for each input, in the same order as the flat
+  // inputs vector.
+  std::vector<AllocatorAttributes> input_alloc_attrs_;
+};
+
+// The state of one invocation of `RunAsync()`. Deleted by the last lane to
+// complete.
+struct StaticScheduleExecutorImpl::StepState {
+  StepState(const Args& args, DoneCallback done, size_t num_inputs)
+      : runner(args.runner),
+        cancellation_manager(args.cancellation_manager),
+        done(std::move(done)),
+        inputs(num_inputs) {}
+
+  ~StepState() {
+    if (params.op_device_context != nullptr) {
+      params.op_device_context->Unref();
+    }
+  }
+
+  void SetError(const Status& s) {
+    mutex_lock l(mu);
+    if (status.ok()) status = s;
+    failed.store(true, std::memory_order_release);
+  }
+
+  Args::Runner runner;
+  CancellationManager* const cancellation_manager;
+  DoneCallback done;
+
+  // The device that runs the kernels, and its renamed wrapper if the caller
+  // overrides the intra-op thread pool.
+  Device* device = nullptr;
+  std::unique_ptr<Device> user_device;
+
+  // The parameters that are the same for all kernels in the step.
+  OpKernelContext::Params params;
+
+  // The inputs of every node, laid out contiguously by node.
+  std::vector<Entry> inputs;
+
+  // For each node with cross-lane inputs, the number of those inputs that are
+  // not yet available, plus one for the arrival of the node's own lane.
+  std::unique_ptr<std::atomic<int32>[]> pending;
+
+  std::atomic<int> num_running_lanes{0};
+
+  // Set once any node fails. Later nodes are skipped, but still signal their
+  // cross-lane successors so that every lane runs to completion.
+  std::atomic<bool> failed{false};
+
+  mutex mu;
+  Status status TF_GUARDED_BY(mu);
+};
+
+Status StaticScheduleExecutorImpl::Initialize(const Graph& graph) {
+  // Topologically sort `graph`; the lanes preserve this order.
+  std::vector<Node*> ordered_nodes;
+  ordered_nodes.reserve(graph.num_nodes());
+  GetReversePostOrder(graph, &ordered_nodes);
+  int ordered_nodes_size = ordered_nodes.size();
+  if (ordered_nodes_size != graph.num_nodes()) {
+    return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                   " but reverse post-order had ",
+                                   ordered_nodes.size());
+  }
+
+  std::vector<int32> node_to_index(graph.num_node_ids(), -1);
+  std::vector<const Node*> index_to_node;
+  index_to_node.reserve(ordered_nodes.size());
+  nodes_.reserve(ordered_nodes.size());
+  for (const Node* n : ordered_nodes) {
+    if (n->IsSource() || n->IsSink()) {
+      continue;
+    }
+    TF_RETURN_IF_ERROR(ValidateOpIsSafeForSyncExecution(
+        *n, params_.allow_control_flow_sync_execution));
+    if (n->IsSwitch()) {
+      return errors::FailedPrecondition(
+          "Static-schedule executor does not support switch op, but saw node ",
+          n->name());
+    }
+    if (n->IsRecv()) {
+      return errors::Unimplemented(
+          "Static-schedule executor does not support partitioned graphs, but "
+          "saw receive node ",
+          n->name());
+    }
+    OpKernel* kernel;
+    TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
+    node_to_index[n->id()] = nodes_.size();
+    index_to_node.push_back(n);
+    nodes_.emplace_back();
+    NodeState& node = nodes_.back();
+    node.kernel = kernel;
+    node.input_start_index = total_num_inputs_;
+    node.num_inputs = n->num_inputs();
+    node.num_outputs = n->num_outputs();
+    total_num_inputs_ += node.num_inputs;
+  }
+
+  // Assign each node, in topological order, to the lane on which it can start
+  // the earliest given the estimated finish times of its inputs. Ties go to the
+  // lowest lane, so the lanes that are used form a prefix.
+  const int num_lanes =
+      std::max(1, std::min(kMaxLanes, port::MaxParallelism()));
+  std::vector<int64_t> lane_available(num_lanes, 0);
+  std::vector<int64_t> finish_time(nodes_.size(), 0);
+  lanes_.resize(num_lanes);
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const Node* n = index_to_node[i];
+    NodeState& node = nodes_[i];
+    const int64_t cost = node.kernel->IsExpensive()
+                             ? kDefaultExpensiveNodeCostMicros
+                             : kDefaultNodeCostMicros;
+
+    int best_lane = 0;
+    int64_t best_start = std::numeric_limits<int64_t>::max();
+    for (int lane = 0; lane < num_lanes; ++lane) {
+      int64_t start = lane_available[lane];
+      for (const Edge* e : n->in_edges()) {
+        const int32 src = node_to_index[e->src()->id()];
+        if (src < 0) continue;
+        const int64_t delay =
+            nodes_[src].lane == lane ? 0 : kCrossLaneEdgeCostMicros;
+        start = std::max(start, finish_time[src] + delay);
+      }
+      if (start < best_start) {
+        best_start = start;
+        best_lane = lane;
+      }
+    }
+    node.lane = best_lane;
+    node.lane_position = lanes_[best_lane].size();
+    lanes_[best_lane].push_back(i);
+    finish_time[i] = best_start + cost;
+    lane_available[best_lane] = finish_time[i];
+  }
+  while (!lanes_.empty() && lanes_.back().empty()) {
+    lanes_.pop_back();
+  }
+
+  // Build the mapping from each node output to the input slot for the
+  // corresponding destination node, and record the edges that cross lanes.
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const Node* n = index_to_node[i];
+    NodeState& node = nodes_[i];
+    node.output_locations.resize(node.num_outputs);
+    for (const Edge* e : n->out_edges()) {
+      const int32 dst = node_to_index[e->dst()->id()];
+      if (dst < 0) continue;
+      NodeState& dst_node = nodes_[dst];
+      if (!e->IsControlEdge()) {
+        node.output_locations[e->src_output()].push_back(
+            dst_node.input_start_index + e->dst_input());
+      }
+      if (dst_node.lane != node.lane) {
+        node.cross_lane_successors.push_back(dst);
+        ++dst_node.num_cross_lane_inputs;
+      }
+    }
+
+    // Compute allocator attributes for each node output, and corresponding
+    // node input.
+    node.output_alloc_attrs.resize(node.num_outputs);
+    for (size_t out = 0; out < node.num_outputs; ++out) {
+      DCHECK_LT(out, node.kernel->output_memory_types().size());
+      if (node.kernel->output_memory_types()[out] == HOST_MEMORY) {
+        AllocatorAttributes h;
+        h.set_on_host(true);
+        node.output_alloc_attrs[out].Merge(h);
+      }
+    }
+  }
+
+  input_alloc_attrs_.resize(total_num_inputs_);
+  for (const NodeState& node : nodes_) {
+    for (size_t j = 0; j < node.output_locations.size(); ++j) {
+      for (size_t output_location : node.output_locations[j]) {
+        input_alloc_attrs_[output_location] = node.output_alloc_attrs[j];
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+void StaticScheduleExecutorImpl::RunAsyncInternal(const Args& args,
+                                                  DoneCallback done) {
+  if (lanes_.empty()) {
+    args.runner([done = std::move(done)]() { done(absl::OkStatus()); });
+    return;
+  }
+
+  auto* step = new StepState(args, std::move(done), total_num_inputs_);
+
+  // Override intra op thread pool and default allocator if requested.
+  step->device = params_.device;
+  if (args.user_intra_op_threadpool != nullptr ||
+      args.step_allocator != nullptr) {
+    step->user_device = RenamedDevice::NewRenamedDevice(
+        step->device->name(), step->device, /*owns_underlying=*/false,
+        /*isolate_session_state=*/false, args.user_intra_op_threadpool,
+        args.step_allocator);
+    step->device = step->user_device.get();
+  }
+
+  // Prepare the parameters that will be the same for all kernels.
+  OpKernelContext::Params& params = step->params;
+  params.step_id = args.step_id;
+  params.device = step->device;
+  params.log_memory = false;
+  params.rendezvous = args.rendezvous;
+  params.session_state = args.session_state;
+  params.session_metadata = params_.session_metadata;
+  params.tensor_store = args.tensor_store;
+  params.cancellation_manager = args.cancellation_manager;
+  params.session_config = args.session_config;
+  params.call_frame = args.call_frame;
+  params.function_library = params_.function_library;
+  params.resource_manager = step->device->resource_manager();
+  params.step_container = args.step_container;
+  params.collective_executor = args.collective_executor;
+  params.stack_trace = args.stack_trace;
+  params.slice_reader_cache = nullptr;
+  params.runner = &step->runner;
+  params.run_all_kernels_inline = args.run_all_kernels_inline;
+  params.stats_collector = args.stats_collector;
+  params.executor_type = &kStaticScheduleExecutor;
+  params.frame_iter = FrameAndIter(0, 0);
+  params.is_input_dead = false;
+  params.forward_from_array = nullptr;
+  step->device->TryGetDeviceContext(&params.op_device_context).IgnoreError();
+
+  step->pending.reset(new std::atomic<int32>[nodes_.size()]);
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    step->pending[i].store(nodes_[i].num_cross_lane_inputs + 1,
+                           std::memory_order_relaxed);
+  }
+  step->num_running_lanes.store(lanes_.size(), std::memory_order_release);
+
+  // NOTE: `step` may be deleted as soon as the last lane is scheduled, so use
+  // the caller's runner rather than `step->runner` here.
+  for (int lane = 0; lane < static_cast<int>(lanes_.size()); ++lane) {
+    args.runner([this, step, lane]() {
+      RunLane(step, lane, /*position=*/0, /*resumed=*/false);
+    });
+  }
+}
+
+void StaticScheduleExecutorImpl::RunLane(StepState* step, int lane,
+                                         size_t position, bool resumed) const {
+  const std::vector<int32>& lane_nodes = lanes_[lane];
+  OpKernelContext::Params params = step->params;
+  TensorValueVec node_inputs;
+  AllocatorAttributeVec input_alloc_attrs;
+  for (; position < lane_nodes.size(); ++position) {
+    const int32 index = lane_nodes[position];
+    if (!resumed && nodes_[index].num_cross_lane_inputs > 0 &&
+        step->pending[index].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      // Yield. The producer of the last missing input resumes this lane at
+      // `position`.
+      return;
+    }
+    resumed = false;
+    ProcessNode(step, index, &params, &node_inputs, &input_alloc_attrs);
+  }
+  FinishLane(step);
+}
+
+void StaticScheduleExecutorImpl::ProcessNode(
+    StepState* step, int32 index, OpKernelContext::Params* params,
+    TensorValueVec* node_inputs,
+    AllocatorAttributeVec* input_alloc_attrs) const {
+  const NodeState& node = nodes_[index];
+  Entry* inputs = step->inputs.data() + node.input_start_index;
+
+  if (TF_PREDICT_FALSE(step->cancellation_manager != nullptr &&
+                       step->cancellation_manager->IsCancelled())) {
+    step->SetError(errors::Cancelled("Step was cancelled"));
+  }
+
+  if (!step->failed.load(std::memory_order_acquire)) {
+    node_inputs->clear();
+    node_inputs->resize(node.num_inputs);
+    input_alloc_attrs->clear();
+    input_alloc_attrs->resize(node.num_inputs);
+    for (size_t j = 0; j < node.num_inputs; ++j) {
+      Entry& input = inputs[j];
+      DCHECK(input.state == Entry::State::HAS_VALUE)
+          << "Input did not have a valid value.";
+      (*node_inputs)[j].tensor = input.val.get();
+      (*input_alloc_attrs)[j] = input_alloc_attrs_[node.input_start_index + j];
+    }
+    params->inputs = *node_inputs;
+    params->input_alloc_attrs = *input_alloc_attrs;
+    params->op_kernel = node.kernel;
+    params->output_attr_array = node.output_alloc_attrs.data();
+    OpKernelContext ctx(params, node.num_outputs);
+
+    // Actually execute the kernel.
+    step->device->Compute(node.kernel, &ctx);
+
+    // Free the inputs to the current kernel.
+    for (size_t j = 0; j < node.num_inputs; ++j) {
+      inputs[j].ClearVal();
+    }
+
+    if (TF_PREDICT_FALSE(!ctx.status().ok())) {
+      step->SetError(ctx.status());
+    } else {
+      // Forward the outputs of the kernel to the inputs of subsequent kernels.
+      for (size_t j = 0; j < node.num_outputs; ++j) {
+        TensorValue val = ctx.release_output(j);
+        const std::vector<size_t>& locations = node.output_locations[j];
+        const size_t num_destinations = locations.size();
+        if (num_destinations > 0) {
+          for (size_t k = 0; k < num_destinations - 1; ++k) {
+            Entry& input = step->inputs[locations[k]];
+            input.state = Entry::State::HAS_VALUE;
+            if (val.tensor != nullptr) {
+              input.val.Init(*val.tensor);
+            } else {
+              input.val.Init(Tensor(node.kernel->output_type(j)));
+            }
+          }
+          // Move the value to the last consumer to avoid the cost of copying.
+          Entry& input = step->inputs[locations[num_destinations - 1]];
+          input.state = Entry::State::HAS_VALUE;
+          if (val.tensor != nullptr) {
+            input.val.Init(std::move(*val.tensor));
+          } else {
+            input.val.Init(Tensor(node.kernel->output_type(j)));
+          }
+        }
+        delete val.tensor;
+      }
+    }
+  } else {
+    for (size_t j = 0; j < node.num_inputs; ++j) {
+      inputs[j].ClearVal();
+    }
+  }
+
+  // The writes to the successors' inputs above must happen before the pending
+  // count update, which releases them to the consuming lane.
+  for (int32 dst : node.cross_lane_successors) {
+    if (step->pending[dst].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // The consuming lane has already arrived at `dst` and yielded. This
+      // lane is still running, so `step` outlives the call to the runner.
+      const NodeState& dst_node = nodes_[dst];
+      step->runner([this, step, lane = dst_node.lane,
+                    position = dst_node.lane_position]() {
+        RunLane(step, lane, position, /*resumed=*/true);
+      });
+    }
+  }
+}
+
+void StaticScheduleExecutorImpl::FinishLane(StepState* step) const {
+  if (step->num_running_lanes.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  Status status;
+  {
+    mutex_lock l(step->mu);
+    status = step->status;
+  }
+  DoneCallback done = std::move(step->done);
+  delete step;
+  done(status);
+}
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register(kStaticScheduleExecutor, new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret;
+      TF_RETURN_IF_ERROR(NewStaticScheduleExecutor(params, graph, &ret));
+      out_executor->reset(ret);
+      return absl::OkStatus();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph, Executor** executor) {
+  auto impl = std::make_unique<StaticScheduleExecutorImpl>(params);
+  TF_RETURN_IF_ERROR(impl->Initialize(graph));
+  *executor = impl.release();
+  return absl::OkStatus();
+}
+
+}  // namespace tensorflow
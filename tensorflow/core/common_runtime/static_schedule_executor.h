@@ -0,0 +1,47 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that runs `graph` according to a schedule that is
+// fixed when the executor is created.
+//
+// The nodes are partitioned into a small number of "lanes" by list scheduling
+// in topological order, with a fixed cost estimate per node that only tells
+// expensive kernels apart from cheap ones.
+// Each step runs every lane sequentially on one closure from `Args::runner`.
+// Dependencies between nodes in the same lane are satisfied by the lane order,
+// so only edges that cross lanes are synchronized at run time, with one atomic
+// counter per node that has cross-lane inputs. A lane that reaches a node whose
+// cross-lane inputs are not ready yields, and is resumed by the producer of the
+// last missing input.
+//
+// The executor targets static, loop-free inference graphs that run many times,
+// and has the same limitations as the single-threaded executor (see
+// "./single_threaded_executor.h"): reference-typed tensors, v1 control flow and
+// "_Recv" nodes are not supported, and kernels run synchronously on their lane.
+//
+// The executor is registered under the type "STATIC_SCHEDULE".
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph, Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
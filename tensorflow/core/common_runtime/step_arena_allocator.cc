@@ -0,0 +1,162 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t multiple) {
+  return (n + multiple - 1) & ~(multiple - 1);
+}
+
+}  // namespace
+
+/* static */
+StepArenaAllocator* StepArenaAllocator::Create(Allocator* underlying,
+                                               size_t chunk_bytes) {
+  return new StepArenaAllocator(underlying, chunk_bytes);
+}
+
+StepArenaAllocator::StepArenaAllocator(Allocator* underlying,
+                                       size_t chunk_bytes)
+    : underlying_(underlying), chunk_bytes_(chunk_bytes) {
+  CHECK(underlying_ != nullptr);
+  CHECK_GT(chunk_bytes_, 0);
+}
+
+std::string StepArenaAllocator::Name() {
+  return strings::StrCat("step_arena_", underlying_->Name());
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  // Every returned pointer is preceded by its `Header`, padded so that the
+  // pointer keeps the requested alignment.
+  alignment = std::max(alignment, alignof(Header));
+  const size_t header_bytes = RoundUp(sizeof(Header), alignment);
+  const size_t total_bytes = header_bytes + num_bytes;
+
+  mutex_lock l(mu_);
+  DCHECK(!step_ended_) << "Allocation from " << Name() << " after EndStep()";
+  Header* header;
+  char* ptr;
+  if (alignment > Allocator::kAllocatorAlignment ||
+      total_bytes > chunk_bytes_ / 4) {
+    void* base = underlying_->AllocateRaw(alignment, total_bytes);
+    if (base == nullptr) return nullptr;
+    ptr = static_cast<char*>(base) + header_bytes;
+    header = reinterpret_cast<Header*>(ptr) - 1;
+    header->chunk = nullptr;
+    header->base = base;
+    header->total_bytes = total_bytes;
+    bytes_in_use_ += total_bytes;
+  } else {
+    size_t offset = 0;
+    if (current_ != nullptr) {
+      offset = RoundUp(current_->offset, alignment);
+    }
+    if (current_ == nullptr || offset + total_bytes > chunk_bytes_) {
+      // Retire the current chunk. It is freed when its last allocation is.
+      if (current_ != nullptr && current_->num_live == 0) {
+        FreeChunk(current_);
+      }
+      current_ = nullptr;
+      void* data = underlying_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                            chunk_bytes_);
+      if (data == nullptr) return nullptr;
+      current_ = new Chunk{static_cast<char*>(data), 0, 0};
+      ++num_chunks_;
+      bytes_in_use_ += chunk_bytes_;
+      offset = 0;
+    }
+    ptr = current_->data + offset + header_bytes;
+    header = reinterpret_cast<Header*>(ptr) - 1;
+    header->chunk = current_;
+    header->base = nullptr;
+    header->total_bytes = total_bytes;
+    current_->offset = offset + total_bytes;
+    ++current_->num_live;
+  }
+  ++num_outstanding_;
+  ++num_allocs_;
+  peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const Header* header = static_cast<const Header*>(ptr) - 1;
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    Chunk* chunk = header->chunk;
+    if (chunk == nullptr) {
+      bytes_in_use_ -= header->total_bytes;
+      underlying_->DeallocateRaw(header->base);
+    } else if (--chunk->num_live == 0) {
+      if (chunk == current_) {
+        // Nothing in the chunk is live, so the whole chunk can be reused.
+        chunk->offset = 0;
+      } else {
+        FreeChunk(chunk);
+      }
+    }
+    --num_outstanding_;
+    delete_self = step_ended_ && num_outstanding_ == 0;
+  }
+  if (delete_self) delete this;
+}
+
+void StepArenaAllocator::EndStep() {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!step_ended_);
+    step_ended_ = true;
+    if (current_ != nullptr && current_->num_live == 0) {
+      FreeChunk(current_);
+    }
+    current_ = nullptr;
+    delete_self = num_outstanding_ == 0;
+    VLOG(2) << Name() << " served " << num_allocs_ << " allocations from "
+            << num_chunks_ << " chunks; " << num_outstanding_
+            << " outlive the step";
+  }
+  if (delete_self) delete this;
+}
+
+void StepArenaAllocator::FreeChunk(Chunk* chunk) {
+  DCHECK_EQ(chunk->num_live, 0);
+  underlying_->DeallocateRaw(chunk->data);
+  bytes_in_use_ -= chunk_bytes_;
+  delete chunk;
+}
+
+std::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  mutex_lock l(mu_);
+  AllocatorStats stats;
+  stats.num_allocs = num_allocs_;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.peak_bytes_in_use = peak_bytes_in_use_;
+  return stats;
+}
+
+}  // namespace tensorflow
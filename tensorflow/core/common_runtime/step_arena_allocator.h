@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// An allocator that serves the allocations of a single step from large chunks
+// obtained from an underlying allocator, by bumping an offset into the current
+// chunk.
+//
+// A chunk is returned to the underlying allocator as soon as every allocation
+// carved from it has been deallocated and it is no longer the chunk being
+// filled, so most of the per-tensor malloc/free traffic of a step is replaced
+// by a few chunk-sized allocations. Requests that are large relative to the
+// chunk size, or that need a stricter alignment than the chunks provide, are
+// forwarded to the underlying allocator.
+//
+// Tensors may outlive the step, e.g. when they are fetched or assigned to a
+// variable. Such a tensor keeps the chunk that holds it alive until it is
+// deallocated, so no copy is needed at the end of the step; the cost is that
+// the rest of that chunk is not released until then.
+//
+// Usage:
+//   StepArenaAllocator* a = StepArenaAllocator::Create(underlying);
+//   ... allocate and deallocate from `a` during the step ...
+//   a->EndStep();
+//
+// After `EndStep()` no new allocations may be made, and the allocator deletes
+// itself once its last outstanding allocation is deallocated. This class is
+// thread-safe.
+class StepArenaAllocator : public Allocator {
+ public:
+  static constexpr size_t kDefaultChunkBytes = 1 << 20;
+
+  // Returns a new allocator that obtains its chunks from `underlying`, which
+  // must outlive every allocation made from the returned allocator.
+  static StepArenaAllocator* Create(Allocator* underlying,
+                                    size_t chunk_bytes = kDefaultChunkBytes);
+
+  StepArenaAllocator(const StepArenaAllocator&) = delete;
+  void operator=(const StepArenaAllocator&) = delete;
+
+  // Marks the end of the step. Must be called exactly once, after which the
+  // caller must not use this object except to deallocate.
+  void EndStep() TF_LOCKS_EXCLUDED(mu_);
+
+  std::string Name() override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override
+      TF_LOCKS_EXCLUDED(mu_);
+  void DeallocateRaw(void* ptr) override TF_LOCKS_EXCLUDED(mu_);
+  std::optional<AllocatorStats> GetStats() override TF_LOCKS_EXCLUDED(mu_);
+  AllocatorMemoryType GetMemoryType() const override {
+    return underlying_->GetMemoryType();
+  }
+
+ private:
+  struct Chunk {
+    char* data;
+    size_t offset;
+    // The number of allocations carved from this chunk that have not been
+    // deallocated.
+    int64_t num_live;
+  };
+
+  // Stored immediately before each pointer returned by `AllocateRaw()`.
+  struct Header {
+    // The chunk that holds the allocation, or nullptr if it was forwarded to
+    // `underlying_`.
+    Chunk* chunk;
+    // For forwarded allocations, the pointer returned by `underlying_`.
+    void* base;
+    // The number of bytes reserved for the allocation, including the header.
+    size_t total_bytes;
+  };
+
+  StepArenaAllocator(Allocator* underlying, size_t chunk_bytes);
+  ~StepArenaAllocator() override = default;
+
+  void FreeChunk(Chunk* chunk) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const underlying_;  // Not owned.
+  const size_t chunk_bytes_;
+
+  mutex mu_;
+  // The chunk that new allocations are carved from, if any.
+  Chunk* current_ TF_GUARDED_BY(mu_) = nullptr;
+  int64_t num_outstanding_ TF_GUARDED_BY(mu_) = 0;
+  bool step_ended_ TF_GUARDED_BY(mu_) = false;
+
+  int64_t num_allocs_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_chunks_ TF_GUARDED_BY(mu_) = 0;
+  int64_t bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+  int64_t peak_bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64_t kChunkBytes = 4096;
+
+TEST(StepArenaAllocatorTest, RespectsAlignment) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  std::vector<void*> ptrs;
+  for (size_t alignment : {1, 8, 16, 32, 64, 128}) {
+    void* p = a->AllocateRaw(alignment, 3);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0u) << alignment;
+    memset(p, 0xff, 3);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  a->EndStep();
+}
+
+TEST(StepArenaAllocatorTest, BumpsWithinChunk) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_GT(p1, p0);
+  EXPECT_LT(static_cast<char*>(p1) - static_cast<char*>(p0), kChunkBytes);
+  std::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->num_allocs, 2);
+  EXPECT_EQ(stats->bytes_in_use, kChunkBytes);
+  a->DeallocateRaw(p0);
+  a->DeallocateRaw(p1);
+  a->EndStep();
+}
+
+TEST(StepArenaAllocatorTest, ReusesEmptyChunk) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  void* p0 = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  a->DeallocateRaw(p0);
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_EQ(p0, p1);
+  a->DeallocateRaw(p1);
+  a->EndStep();
+}
+
+TEST(StepArenaAllocatorTest, ForwardsLargeAllocations) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, kChunkBytes);
+  ASSERT_NE(p, nullptr);
+  memset(p, 0, kChunkBytes);
+  std::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_GE(stats->bytes_in_use, kChunkBytes);
+  a->DeallocateRaw(p);
+  stats = a->GetStats();
+  EXPECT_EQ(stats->bytes_in_use, 0);
+  a->EndStep();
+}
+
+TEST(StepArenaAllocatorTest, FreesRetiredChunks) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  // With its header, each allocation takes 576 bytes, so 7 fit in a chunk.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 512));
+  }
+  std::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->bytes_in_use, 10 * kChunkBytes);
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  // Only the chunk that is still being filled is retained.
+  stats = a->GetStats();
+  EXPECT_EQ(stats->bytes_in_use, kChunkBytes);
+  EXPECT_EQ(stats->peak_bytes_in_use, 10 * kChunkBytes);
+  a->EndStep();
+}
+
+TEST(StepArenaAllocatorTest, TensorOutlivesStep) {
+  StepArenaAllocator* a = StepArenaAllocator::Create(cpu_allocator(),
+                                                     kChunkBytes);
+  Tensor t(a, DT_FLOAT, TensorShape({4}));
+  Tensor scratch(a, DT_FLOAT, TensorShape({4}));
+  scratch = Tensor();
+  a->EndStep();
+  // `t` keeps the allocator alive, and deletes it when it is destroyed.
+  auto flat = t.flat<float>();
+  for (int i = 0; i < 4; ++i) flat(i) = i;
+  EXPECT_EQ(flat(3), 3.0f);
+}
+
+}  // namespace
+}  // namespace tensorflow
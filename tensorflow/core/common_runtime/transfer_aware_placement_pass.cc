@@ -0,0 +1,383 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/transfer_aware_placement_pass.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/config/flag_defs.h"
+#include "tensorflow/core/config/flags.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/memory_types.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/dump_graph.h"
+#include "tsl/platform/errors.h"
+
+namespace tensorflow {
+namespace {
+
+// Maximum number of passes over the graph. Each pass moves every node that
+// can reduce the bytes copied, so that most graphs settle in a few passes.
+constexpr int kMaxRounds = 8;
+
+// Interns the names of the memory spaces, which are the devices for device
+// memory and the tasks for host memory.
+class MemorySpaces {
+ public:
+  int Get(const std::string& name) {
+    auto it = ids_.try_emplace(name, names_.size());
+    if (it.second) names_.push_back(name);
+    return it.first->second;
+  }
+  const std::string& Name(int id) const { return names_[id]; }
+
+ private:
+  absl::flat_hash_map<std::string, int> ids_;
+  std::vector<std::string> names_;
+};
+
+// A device for a node, with the memory spaces of its inputs and outputs.
+struct Placement {
+  std::string device;
+  std::vector<int> input_spaces;
+  std::vector<int> output_spaces;
+};
+
+// Returns the placement of `node` on `device_name`. The inputs and outputs in
+// host memory, and all those on CPUs, are in the host memory of the task.
+Status MakePlacement(const OpRegistryInterface* op_registry, const Node* node,
+                     const std::string& device_name,
+                     const DeviceSet& device_set, MemorySpaces* spaces,
+                     Placement* placement) {
+  placement->device = device_name;
+  const int device_space = spaces->Get(device_name);
+  placement->input_spaces.assign(node->num_inputs(), device_space);
+  placement->output_spaces.assign(node->num_outputs(), device_space);
+
+  const Device* device = device_set.FindDeviceByName(device_name);
+  DeviceNameUtils::ParsedName parsed;
+  std::string task;
+  if (device == nullptr ||
+      !DeviceNameUtils::ParseFullName(device_name, &parsed) ||
+      !DeviceNameUtils::GetTaskName(parsed, &task)) {
+    return absl::OkStatus();
+  }
+  const int host_space = spaces->Get(absl::StrCat(task, "/host"));
+  if (device->device_type() == DEVICE_CPU) {
+    placement->input_spaces.assign(node->num_inputs(), host_space);
+    placement->output_spaces.assign(node->num_outputs(), host_space);
+    return absl::OkStatus();
+  }
+  MemoryTypeVector input_types;
+  MemoryTypeVector output_types;
+  TF_RETURN_IF_ERROR(MemoryTypesForNode(op_registry,
+                                        DeviceType(device->device_type()),
+                                        node->def(), &input_types,
+                                        &output_types));
+  for (size_t i = 0;
+       i < input_types.size() && i < placement->input_spaces.size(); ++i) {
+    if (input_types[i] == HOST_MEMORY) placement->input_spaces[i] = host_space;
+  }
+  for (size_t i = 0;
+       i < output_types.size() && i < placement->output_spaces.size(); ++i) {
+    if (output_types[i] == HOST_MEMORY) {
+      placement->output_spaces[i] = host_space;
+    }
+  }
+  return absl::OkStatus();
+}
+
+bool HasRefOrResource(const DataTypeVector& types) {
+  for (DataType type : types) {
+    if (IsRefType(type) || type == DT_RESOURCE) return true;
+  }
+  return false;
+}
+
+// Returns whether the pass may move `node` off the device the Placer chose.
+// `colocated` holds the names of the nodes that other nodes are colocated
+// with.
+bool IsMovable(const Node* node,
+               const absl::flat_hash_set<absl::string_view>& colocated) {
+  if (!node->IsOp() || node->IsArg() || node->IsRetval() || node->IsSend() ||
+      node->IsRecv() || node->IsControlFlow() || node->IsFunctionCall()) {
+    return false;
+  }
+  if (!node->requested_device().empty() || node->op_def().is_stateful()) {
+    return false;
+  }
+  if (node->attrs().Find(kColocationAttrName) != nullptr ||
+      colocated.contains(node->name())) {
+    return false;
+  }
+  return !HasRefOrResource(node->input_types()) &&
+         !HasRefOrResource(node->output_types());
+}
+
+// The placements of the nodes of a graph, by node id. The first placement of
+// a node is the device the Placer assigned to it.
+class Placements {
+ public:
+  explicit Placements(const Graph& graph)
+      : options_(graph.num_node_ids()), chosen_(graph.num_node_ids(), 0) {}
+
+  std::vector<Placement>& options(const Node* node) {
+    return options_[node->id()];
+  }
+  const std::vector<Placement>& options(const Node* node) const {
+    return options_[node->id()];
+  }
+  int chosen(const Node* node) const { return chosen_[node->id()]; }
+  void Choose(const Node* node, int option) { chosen_[node->id()] = option; }
+
+  // Returns the chosen placement of `node`, or null if it has none.
+  const Placement* Get(const Node* node) const {
+    const std::vector<Placement>& options = options_[node->id()];
+    return options.empty() ? nullptr : &options[chosen_[node->id()]];
+  }
+
+ private:
+  std::vector<std::vector<Placement>> options_;
+  std::vector<int> chosen_;
+};
+
+// Returns the bytes copied between memory spaces to and from `node` if it is
+// placed as `placement`, and the other nodes as `placements`.
+int64_t NodeTransferBytes(const Node* node, const Placement& placement,
+                          const Placements& placements,
+                          const std::vector<int64_t>& edge_bytes) {
+  int64_t bytes = 0;
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    const Placement* src = placements.Get(e->src());
+    if (src != nullptr && src->output_spaces[e->src_output()] !=
+                              placement.input_spaces[e->dst_input()]) {
+      bytes += edge_bytes[e->id()];
+    }
+  }
+  for (const Edge* e : node->out_edges()) {
+    if (e->IsControlEdge()) continue;
+    const Placement* dst = placements.Get(e->dst());
+    if (dst != nullptr && placement.output_spaces[e->src_output()] !=
+                              dst->input_spaces[e->dst_input()]) {
+      bytes += edge_bytes[e->id()];
+    }
+  }
+  return bytes;
+}
+
+// Logs the bytes copied between each pair of memory spaces.
+void LogTransfers(absl::string_view when, const Graph& graph,
+                  const Placements& placements,
+                  const std::vector<int64_t>& edge_bytes,
+                  const MemorySpaces& spaces) {
+  absl::btree_map<std::pair<int, int>, int64_t> transfers;
+  int64_t total = 0;
+  for (const Edge* e : graph.edges()) {
+    if (e->IsControlEdge()) continue;
+    const Placement* src = placements.Get(e->src());
+    const Placement* dst = placements.Get(e->dst());
+    if (src == nullptr || dst == nullptr) continue;
+    const int src_space = src->output_spaces[e->src_output()];
+    const int dst_space = dst->input_spaces[e->dst_input()];
+    if (src_space == dst_space) continue;
+    transfers[{src_space, dst_space}] += edge_bytes[e->id()];
+    total += edge_bytes[e->id()];
+  }
+  VLOG(1) << "transfer_aware_placement_pass: " << total
+          << " bytes copied between memory spaces " << when << " the pass.";
+  for (const auto& it : transfers) {
+    VLOG(1) << "  " << spaces.Name(it.first.first) << " -> "
+            << spaces.Name(it.first.second) << ": " << it.second << " bytes";
+  }
+}
+
+}  // namespace
+
+Status TransferAwarePlacementPass::Run(
+    const GraphOptimizationPassOptions& options) {
+  if (!flags::Global().enable_transfer_aware_placement.value()) {
+    return absl::OkStatus();
+  }
+  if (options.graph == nullptr || options.device_set == nullptr) {
+    VLOG(1) << "No graph or devices in transfer_aware_placement_pass.";
+    return absl::OkStatus();
+  }
+  Graph* graph = options.graph->get();
+  const DeviceSet& device_set = *options.device_set;
+
+  // Estimate the sizes of the tensors. The graph is left as placed if its
+  // shapes can't be inferred.
+  grappler::GrapplerItem item;
+  item.id = "transfer_aware_placement";
+  graph->ToGraphDef(&item.graph);
+  grappler::GraphProperties properties(item);
+  Status status = properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false);
+  if (!status.ok()) {
+    VLOG(1) << "transfer_aware_placement_pass could not infer shapes: "
+            << status;
+    return absl::OkStatus();
+  }
+  std::vector<int64_t> edge_bytes(graph->num_edge_ids(), 0);
+  for (const Edge* e : graph->edges()) {
+    if (e->IsControlEdge()) continue;
+    const Node* src = e->src();
+    int64_t bytes = DataTypeSize(BaseType(src->output_type(e->src_output())));
+    if (properties.HasOutputProperties(src->name())) {
+      const auto& outputs = properties.GetOutputProperties(src->name());
+      if (e->src_output() < static_cast<int>(outputs.size())) {
+        bytes = grappler::CalculateTensorSize(outputs[e->src_output()]);
+      }
+    }
+    edge_bytes[e->id()] = bytes;
+  }
+
+  absl::flat_hash_set<absl::string_view> colocated;
+  for (const Node* node : graph->op_nodes()) {
+    const AttrValue* attr = node->attrs().Find(kColocationAttrName);
+    if (attr == nullptr) continue;
+    for (const std::string& group : attr->list().s()) {
+      if (absl::StartsWith(group, kColocationGroupPrefix)) {
+        colocated.insert(
+            absl::string_view(group).substr(strlen(kColocationGroupPrefix)));
+      }
+    }
+  }
+
+  // Collect the devices each movable node may move to: those of its data
+  // neighbors in the same task that have a kernel for it.
+  MemorySpaces spaces;
+  Placements placements(*graph);
+  for (const Node* node : graph->op_nodes()) {
+    if (!node->has_assigned_device_name()) continue;
+    const std::string& device = node->assigned_device_name();
+    Placement current;
+    if (!MakePlacement(graph->op_registry(), node, device, device_set, &spaces,
+                       &current)
+             .ok()) {
+      continue;
+    }
+    std::vector<Placement>& node_options = placements.options(node);
+    node_options.push_back(std::move(current));
+    if (device_set.FindDeviceByName(device) == nullptr ||
+        !IsMovable(node, colocated)) {
+      continue;
+    }
+    absl::flat_hash_set<absl::string_view> candidates = {device};
+    auto add_candidate = [&](const Node* neighbor) {
+      const std::string& candidate = neighbor->assigned_device_name();
+      if (candidate.empty() || !candidates.insert(candidate).second) return;
+      const Device* d = device_set.FindDeviceByName(candidate);
+      if (d == nullptr ||
+          !DeviceNameUtils::IsSameAddressSpace(device, candidate) ||
+          !FindKernelDef(DeviceType(d->device_type()), node->def(), nullptr,
+                         nullptr)
+               .ok()) {
+        return;
+      }
+      Placement placement;
+      if (MakePlacement(graph->op_registry(), node, candidate, device_set,
+                        &spaces, &placement)
+              .ok()) {
+        node_options.push_back(std::move(placement));
+      }
+    };
+    for (const Edge* e : node->in_edges()) {
+      if (!e->IsControlEdge()) add_candidate(e->src());
+    }
+    for (const Edge* e : node->out_edges()) {
+      if (!e->IsControlEdge()) add_candidate(e->dst());
+    }
+  }
+
+  if (VLOG_IS_ON(1)) {
+    VLOG(1) << DumpGraphToFile("before_transfer_aware_placement_pass", *graph,
+                               options.flib_def);
+    LogTransfers("before", *graph, placements, edge_bytes, spaces);
+  }
+
+  // Move one node at a time to the device that copies the fewest bytes to and
+  // from it, as long as that reduces the bytes copied.
+  for (int round = 0; round < kMaxRounds; ++round) {
+    bool moved = false;
+    for (const Node* node : graph->op_nodes()) {
+      const std::vector<Placement>& node_options = placements.options(node);
+      if (node_options.size() <= 1) continue;
+      const int num_options = node_options.size();
+      int best = placements.chosen(node);
+      int64_t best_bytes =
+          NodeTransferBytes(node, node_options[best], placements, edge_bytes);
+      for (int i = 0; i < num_options && best_bytes > 0; ++i) {
+        const int64_t bytes =
+            NodeTransferBytes(node, node_options[i], placements, edge_bytes);
+        if (bytes < best_bytes) {
+          best = i;
+          best_bytes = bytes;
+        }
+      }
+      if (best != placements.chosen(node)) {
+        placements.Choose(node, best);
+        moved = true;
+      }
+    }
+    if (!moved) break;
+  }
+
+  int num_moved = 0;
+  for (Node* node : graph->op_nodes()) {
+    if (placements.options(node).empty() || placements.chosen(node) == 0) {
+      continue;
+    }
+    node->set_assigned_device_name(placements.Get(node)->device);
+    ++num_moved;
+  }
+
+  if (VLOG_IS_ON(1)) {
+    VLOG(1) << "transfer_aware_placement_pass moved " << num_moved
+            << " nodes.";
+    LogTransfers("after", *graph, placements, edge_bytes, spaces);
+    VLOG(1) << DumpGraphToFile("after_transfer_aware_placement_pass", *graph,
+                               options.flib_def);
+  }
+  return absl::OkStatus();
+}
+
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PLACEMENT, 10,
+                      TransferAwarePlacementPass);
+
+}  // namespace tensorflow
@@ -0,0 +1,49 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_TRANSFER_AWARE_PLACEMENT_PASS_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_TRANSFER_AWARE_PLACEMENT_PASS_H_
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+
+// Moves the nodes that the Placer placed freely to the devices of their
+// neighbors when that reduces the estimated number of bytes copied between
+// memory spaces. The Placer only follows constraints, so that a small host op
+// between two GPU ops, for example, adds two copies between the host and the
+// GPU, which this pass saves by moving the op to the GPU if it has a GPU
+// kernel.
+//
+// The sizes of the tensors are estimated by grappler's static shape inference,
+// and the memory spaces of the inputs and outputs of the nodes by their memory
+// types on their devices. Nodes only move within their tasks, and only if they
+// have no requested device, colocation constraints, state, or reference or
+// resource inputs or outputs, and are not control flow or function calls. The
+// pass moves one node at a time while that reduces the bytes copied, for a few
+// rounds over the graph.
+//
+// The pass runs after placement if the enable_transfer_aware_placement flag is
+// set, and logs the bytes copied between each pair of memory spaces before and
+// after it at VLOG level 1.
+
+namespace tensorflow {
+
+class TransferAwarePlacementPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_TRANSFER_AWARE_PLACEMENT_PASS_H_
@@ -0,0 +1,196 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/transfer_aware_placement_pass.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/common_runtime/graph_def_builder_util.h"
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/config/flag_defs.h"
+#include "tensorflow/core/config/flags.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/errors.h"
+
+namespace tensorflow {
+namespace {
+
+const char kCpu[] = "/job:a/replica:0/task:0/device:FakeCPU:0";
+const char kGpu[] = "/job:a/replica:0/task:0/device:FakeGPU:0";
+
+class DummyOp : public OpKernel {
+ public:
+  explicit DummyOp(OpKernelConstruction* context) : OpKernel(context) {}
+  void Compute(OpKernelContext* context) override {}
+};
+
+class FakeDevice : public Device {
+ public:
+  explicit FakeDevice(const DeviceAttributes& device_attributes)
+      : Device(nullptr, device_attributes) {}
+
+  Status Sync() override { return errors::Unimplemented("FakeDevice::Sync()"); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override { return nullptr; }
+
+  static std::unique_ptr<Device> MakeDevice(const string& name,
+                                            const string& device_type) {
+    DeviceAttributes device_attributes;
+    device_attributes.set_name(name);
+    device_attributes.set_device_type(device_type);
+    return std::make_unique<FakeDevice>(device_attributes);
+  }
+};
+
+REGISTER_OP("TransferTestSource")
+    .Output("o: float")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      c->set_output(0, c->MakeShape({1024}));
+      return absl::OkStatus();
+    });
+REGISTER_KERNEL_BUILDER(Name("TransferTestSource").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("TransferTestSource").Device("FakeGPU"), DummyOp);
+
+REGISTER_OP("TransferTestUnary")
+    .Input("i: float")
+    .Output("o: float")
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(Name("TransferTestUnary").Device("FakeCPU"), DummyOp);
+REGISTER_KERNEL_BUILDER(Name("TransferTestUnary").Device("FakeGPU"), DummyOp);
+
+REGISTER_OP("TransferTestUnaryCPU")
+    .Input("i: float")
+    .Output("o: float")
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(Name("TransferTestUnaryCPU").Device("FakeCPU"),
+                        DummyOp);
+
+class TransferAwarePlacementPassTest : public ::testing::Test {
+ protected:
+  TransferAwarePlacementPassTest()
+      : cpu_(FakeDevice::MakeDevice(kCpu, "FakeCPU")),
+        gpu_(FakeDevice::MakeDevice(kGpu, "FakeGPU")) {
+    device_set_.AddDevice(cpu_.get());
+    device_set_.AddDevice(gpu_.get());
+    flags::Global().enable_transfer_aware_placement.reset(true);
+  }
+
+  ~TransferAwarePlacementPassTest() override {
+    flags::Global().enable_transfer_aware_placement.reset(false);
+  }
+
+  // Builds src -> `op` -> dst, with src and dst requested on `src_device` and
+  // `dst_device`, and all the nodes assigned to their requested devices or
+  // the CPU.
+  void BuildChain(const std::string& op, const std::string& src_device,
+                  const std::string& dst_device) {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* src = ops::SourceOp("TransferTestSource",
+                              builder.opts().WithName("src").WithDevice(
+                                  src_device));
+    Node* middle = ops::UnaryOp(op, src, builder.opts().WithName("middle"));
+    ops::UnaryOp("TransferTestUnary", middle,
+                 builder.opts().WithName("dst").WithDevice(dst_device));
+    graph_ = std::make_unique<Graph>(OpRegistry::Global());
+    TF_ASSERT_OK(GraphDefBuilderToGraph(builder, graph_.get()));
+    for (Node* node : graph_->op_nodes()) {
+      node->set_assigned_device_name(
+          node->requested_device().empty() ? kCpu : node->requested_device());
+    }
+  }
+
+  Status RunPass() {
+    GraphOptimizationPassOptions options;
+    options.graph = &graph_;
+    options.device_set = &device_set_;
+    TransferAwarePlacementPass pass;
+    return pass.Run(options);
+  }
+
+  const std::string& AssignedDevice(const std::string& name) {
+    for (Node* node : graph_->op_nodes()) {
+      if (node->name() == name) return node->assigned_device_name();
+    }
+    static const std::string* const kNotFound = new std::string("not found");
+    return *kNotFound;
+  }
+
+  std::unique_ptr<Device> cpu_;
+  std::unique_ptr<Device> gpu_;
+  DeviceSet device_set_;
+  std::unique_ptr<Graph> graph_;
+};
+
+TEST_F(TransferAwarePlacementPassTest, MovesNodeBetweenNodesOnOtherDevice) {
+  BuildChain("TransferTestUnary", kGpu, kGpu);
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kGpu);
+  EXPECT_EQ(AssignedDevice("src"), kGpu);
+  EXPECT_EQ(AssignedDevice("dst"), kGpu);
+}
+
+TEST_F(TransferAwarePlacementPassTest, SkippedWhenFlagIsFalse) {
+  flags::Global().enable_transfer_aware_placement.reset(false);
+  BuildChain("TransferTestUnary", kGpu, kGpu);
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kCpu);
+}
+
+TEST_F(TransferAwarePlacementPassTest, DoesNotMoveWithoutSavingCopies) {
+  // The tensor is copied once wherever the node runs.
+  BuildChain("TransferTestUnary", kCpu, kGpu);
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kCpu);
+}
+
+TEST_F(TransferAwarePlacementPassTest, DoesNotMoveToDeviceWithoutKernel) {
+  BuildChain("TransferTestUnaryCPU", kGpu, kGpu);
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kCpu);
+}
+
+TEST_F(TransferAwarePlacementPassTest, DoesNotMoveConstrainedNodes) {
+  BuildChain("TransferTestUnary", kGpu, kGpu);
+  for (Node* node : graph_->op_nodes()) {
+    if (node->name() == "middle") node->set_requested_device(kCpu);
+  }
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kCpu);
+
+  // Nor the nodes colocated with others.
+  BuildChain("TransferTestUnary", kGpu, kGpu);
+  for (Node* node : graph_->op_nodes()) {
+    if (node->name() == "middle") {
+      node->AddAttr(kColocationAttrName, std::vector<string>{"loc:@other"});
+    }
+  }
+  TF_ASSERT_OK(RunPass());
+  EXPECT_EQ(AssignedDevice("middle"), kCpu);
+}
+
+}  // namespace
+}  // namespace tensorflow
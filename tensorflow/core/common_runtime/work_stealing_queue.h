@@ -0,0 +1,127 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A fixed set of per-worker double-ended queues ("lanes") used to hand work
+// between the threads that execute a single step.
+//
+// The owner of a lane pushes and pops at the back of its own deque, so the
+// most recently produced item (typically a successor of the node that just
+// finished) is run next while its inputs are still cache-warm. A worker whose
+// own lane is empty steals from the front of the other lanes, taking the
+// oldest item.
+//
+// Each lane is guarded by its own mutex, which is only contended when a thief
+// and the owner race on the same lane. This class is thread-safe.
+template <typename T>
+class WorkStealingQueues {
+ public:
+  explicit WorkStealingQueues(int num_lanes)
+      : num_lanes_(num_lanes), lanes_(new Lane[num_lanes]) {
+    CHECK_GT(num_lanes, 0);
+  }
+
+  WorkStealingQueues(const WorkStealingQueues&) = delete;
+  void operator=(const WorkStealingQueues&) = delete;
+
+  int num_lanes() const { return num_lanes_; }
+
+  // Adds `item` to the back of the deque owned by `lane`.
+  void Push(int lane, T item) {
+    DCHECK_GE(lane, 0);
+    DCHECK_LT(lane, num_lanes_);
+    Lane& l = lanes_[lane];
+    {
+      mutex_lock ml(l.mu);
+      l.items.push_back(std::move(item));
+    }
+    num_items_.fetch_add(1);
+  }
+
+  // Removes and returns the most recently pushed item from `lane`, or, if that
+  // lane is empty, the oldest item from another lane. Returns `std::nullopt`
+  // if every lane was observed empty.
+  std::optional<T> Pop(int lane) {
+    DCHECK_GE(lane, 0);
+    DCHECK_LT(lane, num_lanes_);
+    if (num_items_.load(std::memory_order_acquire) == 0) return std::nullopt;
+    {
+      Lane& l = lanes_[lane];
+      mutex_lock ml(l.mu);
+      if (!l.items.empty()) {
+        std::optional<T> item(std::move(l.items.back()));
+        l.items.pop_back();
+        num_items_.fetch_sub(1);
+        local_hits_.fetch_add(1, std::memory_order_relaxed);
+        return item;
+      }
+    }
+    for (int i = 1; i < num_lanes_; ++i) {
+      Lane& victim = lanes_[(lane + i) % num_lanes_];
+      mutex_lock ml(victim.mu);
+      if (!victim.items.empty()) {
+        std::optional<T> item(std::move(victim.items.front()));
+        victim.items.pop_front();
+        num_items_.fetch_sub(1);
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return item;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Returns true if no lane holds an item. The result may be stale by the time
+  // it is used unless the caller synchronizes with all producers.
+  bool Empty() const { return num_items_.load() == 0; }
+
+  // Number of items popped from the caller's own lane.
+  int64_t local_hits() const {
+    return local_hits_.load(std::memory_order_relaxed);
+  }
+
+  // Number of items taken from a lane other than the caller's own.
+  int64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+ private:
+  // Aligned to avoid false sharing between lanes owned by different threads.
+  struct alignas(64) Lane {
+    mutex mu;
+    std::deque<T> items TF_GUARDED_BY(mu);
+  };
+
+  const int num_lanes_;
+  std::unique_ptr<Lane[]> lanes_;
+  std::atomic<int64_t> num_items_{0};
+  std::atomic<int64_t> local_hits_{0};
+  std::atomic<int64_t> steals_{0};
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
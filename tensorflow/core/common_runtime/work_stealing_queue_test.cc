@@ -0,0 +1,90 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueuesTest, OwnerPopsMostRecent) {
+  WorkStealingQueues<int> queues(2);
+  queues.Push(0, 1);
+  queues.Push(0, 2);
+  queues.Push(0, 3);
+  EXPECT_EQ(3, *queues.Pop(0));
+  EXPECT_EQ(2, *queues.Pop(0));
+  EXPECT_EQ(1, *queues.Pop(0));
+  EXPECT_FALSE(queues.Pop(0).has_value());
+  EXPECT_TRUE(queues.Empty());
+  EXPECT_EQ(3, queues.local_hits());
+  EXPECT_EQ(0, queues.steals());
+}
+
+TEST(WorkStealingQueuesTest, ThiefTakesOldest) {
+  WorkStealingQueues<int> queues(3);
+  queues.Push(2, 1);
+  queues.Push(2, 2);
+  EXPECT_FALSE(queues.Empty());
+  EXPECT_EQ(1, *queues.Pop(0));
+  EXPECT_EQ(2, *queues.Pop(1));
+  EXPECT_FALSE(queues.Pop(0).has_value());
+  EXPECT_EQ(0, queues.local_hits());
+  EXPECT_EQ(2, queues.steals());
+}
+
+TEST(WorkStealingQueuesTest, ConcurrentPushAndPop) {
+  constexpr int kNumLanes = 4;
+  constexpr int kItemsPerLane = 10000;
+  WorkStealingQueues<int> queues(kNumLanes);
+  std::vector<std::atomic<int>> seen(kNumLanes * kItemsPerLane);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumLanes);
+    for (int lane = 0; lane < kNumLanes; ++lane) {
+      pool.Schedule([&queues, &seen, lane]() {
+        for (int i = 0; i < kItemsPerLane; ++i) {
+          queues.Push(lane, lane * kItemsPerLane + i);
+          if (i % 2 == 0) {
+            if (std::optional<int> item = queues.Pop(lane)) {
+              seen[*item].fetch_add(1);
+            }
+          }
+        }
+        while (std::optional<int> item = queues.Pop(lane)) {
+          seen[*item].fetch_add(1);
+        }
+      });
+    }
+  }
+  while (std::optional<int> item = queues.Pop(0)) {
+    seen[*item].fetch_add(1);
+  }
+  EXPECT_TRUE(queues.Empty());
+  for (int i = 0; i < kNumLanes * kItemsPerLane; ++i) {
+    EXPECT_EQ(1, seen[i].load()) << i;
+  }
+  EXPECT_EQ(kNumLanes * kItemsPerLane, queues.local_hits() + queues.steals());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -61,6 +61,14 @@ class Flags {
                   "propagated during while op lowering to switch/merge ops.")
   TF_DECLARE_FLAG(enable_tf2min_ici_weight, false,
                   "If true, ici weight optimization will be used in tf2/min.")
+  TF_DECLARE_FLAG(enable_transfer_aware_placement, false,
+                  "If true, nodes without placement constraints are moved "
+                  "after placement to the devices of their neighbors when "
+                  "that reduces the bytes copied between devices.")
+  TF_DECLARE_FLAG(inline_small_function_calls, false,
+                  "If true, PartitionedCalls of small single-device functions "
+                  "are inlined into the calling graph when lowering "
+                  "functional ops, even if function inlining is disabled.")
   // LINT.ThenChange(//tensorflow/core/config/flags_api_wrapper.cc)
 };
 
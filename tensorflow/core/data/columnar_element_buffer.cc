@@ -0,0 +1,161 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/columnar_element_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */
+bool ColumnarElementBuffer::CanStore(
+    const DataTypeVector& dtypes,
+    const std::vector<PartialTensorShape>& shapes) {
+  if (dtypes.empty() || dtypes.size() != shapes.size()) return false;
+  for (size_t i = 0; i < dtypes.size(); ++i) {
+    if (!DataTypeCanUseMemcpy(dtypes[i]) || !shapes[i].IsFullyDefined()) {
+      return false;
+    }
+    if (shapes[i].num_elements() * DataTypeSize(dtypes[i]) >
+        kMaxComponentBytes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ColumnarElementBuffer::ColumnarElementBuffer(
+    const DataTypeVector& dtypes,
+    const std::vector<PartialTensorShape>& shapes) {
+  DCHECK(CanStore(dtypes, shapes));
+  columns_.reserve(dtypes.size());
+  for (size_t i = 0; i < dtypes.size(); ++i) {
+    Column column;
+    column.dtype = dtypes[i];
+    shapes[i].AsTensorShape(&column.shape);
+    column.stride = column.shape.num_elements() * DataTypeSize(dtypes[i]);
+    columns_.push_back(std::move(column));
+  }
+}
+
+void ColumnarElementBuffer::Resize(size_t size) {
+  for (Column& column : columns_) {
+    column.data.resize(size * column.stride);
+  }
+  size_ = size;
+}
+
+void ColumnarElementBuffer::Clear() {
+  for (Column& column : columns_) {
+    column.data.clear();
+    column.data.shrink_to_fit();
+  }
+  size_ = 0;
+}
+
+Status ColumnarElementBuffer::CheckElement(
+    const std::vector<Tensor>& element) const {
+  if (element.size() != columns_.size()) {
+    return errors::InvalidArgument("Expected an element with ",
+                                   columns_.size(), " components, got ",
+                                   element.size());
+  }
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (element[i].dtype() != columns_[i].dtype ||
+        element[i].shape() != columns_[i].shape) {
+      return errors::InvalidArgument(
+          "Component ", i, " of the element has type ",
+          DataTypeString(element[i].dtype()), " and shape ",
+          element[i].shape().DebugString(), ", expected ",
+          DataTypeString(columns_[i].dtype), " and ",
+          columns_[i].shape.DebugString());
+    }
+  }
+  return absl::OkStatus();
+}
+
+Status ColumnarElementBuffer::Append(const std::vector<Tensor>& element) {
+  TF_RETURN_IF_ERROR(CheckElement(element));
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    const char* data = element[i].tensor_data().data();
+    columns_[i].data.insert(columns_[i].data.end(), data,
+                            data + columns_[i].stride);
+  }
+  ++size_;
+  return absl::OkStatus();
+}
+
+Status ColumnarElementBuffer::Set(size_t index,
+                                  const std::vector<Tensor>& element) {
+  DCHECK_LT(index, size_);
+  TF_RETURN_IF_ERROR(CheckElement(element));
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    Column& column = columns_[i];
+    if (column.stride == 0) continue;
+    std::memcpy(column.data.data() + index * column.stride,
+                element[i].tensor_data().data(), column.stride);
+  }
+  return absl::OkStatus();
+}
+
+void ColumnarElementBuffer::Get(size_t index,
+                                std::vector<Tensor>* out_tensors) const {
+  DCHECK_LT(index, size_);
+  out_tensors->reserve(out_tensors->size() + columns_.size());
+  for (const Column& column : columns_) {
+    Tensor tensor(column.dtype, column.shape);
+    if (column.stride > 0) {
+      std::memcpy(const_cast<char*>(tensor.tensor_data().data()),
+                  column.data.data() + index * column.stride, column.stride);
+    }
+    out_tensors->push_back(std::move(tensor));
+  }
+}
+
+void ColumnarElementBuffer::Swap(size_t i, size_t j) {
+  DCHECK_LT(i, size_);
+  DCHECK_LT(j, size_);
+  if (i == j) return;
+  for (Column& column : columns_) {
+    std::swap_ranges(column.data.begin() + i * column.stride,
+                     column.data.begin() + (i + 1) * column.stride,
+                     column.data.begin() + j * column.stride);
+  }
+}
+
+std::vector<std::vector<Tensor>> ColumnarElementBuffer::ToElements() const {
+  std::vector<std::vector<Tensor>> elements(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    Get(i, &elements[i]);
+  }
+  return elements;
+}
+
+int64_t ColumnarElementBuffer::AllocatedBytes() const {
+  int64_t bytes = 0;
+  for (const Column& column : columns_) {
+    bytes += column.data.capacity();
+  }
+  return bytes;
+}
+
+}  // namespace data
+}  // namespace tensorflow
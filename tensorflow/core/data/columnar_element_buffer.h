@@ -0,0 +1,109 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_COLUMNAR_ELEMENT_BUFFER_H_
+#define TENSORFLOW_CORE_DATA_COLUMNAR_ELEMENT_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// Stores a sequence of dataset elements column by column.
+//
+// Buffering stages normally hold each element as a `std::vector<Tensor>`. For
+// elements made of many small components, such as hundreds of scalar
+// features, the tensor headers and reference-counted buffers take up several
+// times more memory than the values themselves. This class instead copies the
+// bytes of component `i` of every element into one contiguous column, and
+// materializes new tensors for an element only when it is read.
+//
+// Only elements whose components all have a POD type and a fully defined
+// shape of at most `kMaxComponentBytes` bytes can be stored; see `CanStore`.
+//
+// This class is not thread-safe.
+class ColumnarElementBuffer {
+ public:
+  // Components larger than this are cheaper to keep as tensors, since copying
+  // them in and out of a column would dominate the saved overhead.
+  static constexpr int64_t kMaxComponentBytes = 64;
+
+  // Returns whether elements with the given component types and shapes can be
+  // stored in a `ColumnarElementBuffer`.
+  static bool CanStore(const DataTypeVector& dtypes,
+                       const std::vector<PartialTensorShape>& shapes);
+
+  // Requires `CanStore(dtypes, shapes)`.
+  ColumnarElementBuffer(const DataTypeVector& dtypes,
+                        const std::vector<PartialTensorShape>& shapes);
+
+  ColumnarElementBuffer(const ColumnarElementBuffer&) = delete;
+  ColumnarElementBuffer& operator=(const ColumnarElementBuffer&) = delete;
+
+  // The number of element slots in the buffer.
+  size_t size() const { return size_; }
+
+  // Resizes the buffer to `size` slots. New slots hold zero-initialized
+  // elements.
+  void Resize(size_t size);
+
+  // Removes all elements and releases the memory of the columns.
+  void Clear();
+
+  // Appends `element` to the buffer.
+  Status Append(const std::vector<Tensor>& element);
+
+  // Overwrites the element at `index` with `element`.
+  Status Set(size_t index, const std::vector<Tensor>& element);
+
+  // Appends new tensors holding the components of the element at `index` to
+  // `out_tensors`.
+  void Get(size_t index, std::vector<Tensor>* out_tensors) const;
+
+  // Swaps the elements at `i` and `j`.
+  void Swap(size_t i, size_t j);
+
+  // Materializes all elements, e.g. to write them to a checkpoint.
+  std::vector<std::vector<Tensor>> ToElements() const;
+
+  // The number of bytes allocated for the columns.
+  int64_t AllocatedBytes() const;
+
+ private:
+  struct Column {
+    DataType dtype;
+    TensorShape shape;
+    // The number of bytes of each value in the column.
+    size_t stride;
+    std::vector<char> data;
+  };
+
+  Status CheckElement(const std::vector<Tensor>& element) const;
+
+  std::vector<Column> columns_;
+  size_t size_ = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_COLUMNAR_ELEMENT_BUFFER_H_
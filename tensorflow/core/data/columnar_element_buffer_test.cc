@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/columnar_element_buffer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> Element(int64_t i) {
+  return {test::AsScalar<int64_t>(i),
+          test::AsTensor<float>({1.0f * i, 2.0f * i})};
+}
+
+void ExpectElement(const std::vector<Tensor>& element, int64_t i) {
+  ASSERT_EQ(element.size(), 2);
+  test::ExpectTensorEqual<int64_t>(element[0], test::AsScalar<int64_t>(i));
+  test::ExpectTensorEqual<float>(element[1],
+                                 test::AsTensor<float>({1.0f * i, 2.0f * i}));
+}
+
+ColumnarElementBuffer MakeBuffer() {
+  return ColumnarElementBuffer(
+      {DT_INT64, DT_FLOAT}, {PartialTensorShape({}), PartialTensorShape({2})});
+}
+
+TEST(ColumnarElementBufferTest, CanStore) {
+  EXPECT_TRUE(ColumnarElementBuffer::CanStore(
+      {DT_INT64, DT_FLOAT}, {PartialTensorShape({}), PartialTensorShape({2})}));
+  EXPECT_FALSE(ColumnarElementBuffer::CanStore({DT_STRING},
+                                               {PartialTensorShape({})}));
+  EXPECT_FALSE(ColumnarElementBuffer::CanStore({DT_INT64},
+                                               {PartialTensorShape({-1})}));
+  EXPECT_FALSE(ColumnarElementBuffer::CanStore({DT_FLOAT},
+                                               {PartialTensorShape({1024})}));
+  EXPECT_FALSE(ColumnarElementBuffer::CanStore({}, {}));
+}
+
+TEST(ColumnarElementBufferTest, AppendAndGet) {
+  ColumnarElementBuffer buffer = MakeBuffer();
+  for (int64_t i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(buffer.Append(Element(i)));
+  }
+  EXPECT_EQ(buffer.size(), 10);
+  for (int64_t i : {3, 0, 9}) {
+    std::vector<Tensor> element;
+    buffer.Get(i, &element);
+    ExpectElement(element, i);
+  }
+}
+
+TEST(ColumnarElementBufferTest, SetAndSwap) {
+  ColumnarElementBuffer buffer = MakeBuffer();
+  buffer.Resize(3);
+  TF_ASSERT_OK(buffer.Set(0, Element(5)));
+  TF_ASSERT_OK(buffer.Set(2, Element(7)));
+  buffer.Swap(0, 2);
+  std::vector<std::vector<Tensor>> elements = buffer.ToElements();
+  ASSERT_EQ(elements.size(), 3);
+  ExpectElement(elements[0], 7);
+  ExpectElement(elements[1], 0);
+  ExpectElement(elements[2], 5);
+}
+
+TEST(ColumnarElementBufferTest, ElementsOutliveBuffer) {
+  std::vector<Tensor> element;
+  {
+    ColumnarElementBuffer buffer = MakeBuffer();
+    TF_ASSERT_OK(buffer.Append(Element(4)));
+    buffer.Get(0, &element);
+    buffer.Clear();
+    EXPECT_EQ(buffer.size(), 0);
+  }
+  ExpectElement(element, 4);
+}
+
+TEST(ColumnarElementBufferTest, RejectsMismatchedElements) {
+  ColumnarElementBuffer buffer = MakeBuffer();
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      buffer.Append({test::AsScalar<int64_t>(1)})));
+  EXPECT_TRUE(errors::IsInvalidArgument(buffer.Append(
+      {test::AsScalar<int64_t>(1), test::AsTensor<float>({1.0f})})));
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+TEST(ColumnarElementBufferTest, StoresValuesContiguously) {
+  ColumnarElementBuffer buffer = MakeBuffer();
+  buffer.Resize(1000);
+  // 8 bytes for the scalar and 8 for the vector of each element.
+  EXPECT_EQ(buffer.AllocatedBytes(), 1000 * 16);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -190,7 +190,12 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
     cancellation_manager_ = std::make_unique<CancellationManager>();
   }
 
-  ~Iterator() override { cancellation_manager_->StartCancel(); }
+  ~Iterator() override {
+    cancellation_manager_->StartCancel();
+    if (ram_budget_manager_) {
+      model::RamBudgetArbiter::Global().Deregister(ram_budget_manager_.get());
+    }
+  }
 
   bool SymbolicCheckpointCompatible() const override { return true; }
 
@@ -216,6 +221,12 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
       if (experiments.contains("autotune_buffer_optimization")) {
         model_->AddExperiment("autotune_buffer_optimization");
       }
+      // A RAM budget set through the options is owned by this pipeline alone,
+      // so it is not shared with the other pipelines of the process.
+      if (experiments.contains("ram_budget_arbiter") &&
+          dataset()->params_.autotune_ram_budget_from_options <= 0) {
+        model::RamBudgetArbiter::Global().Register(ram_budget_manager_.get());
+      }
     }
     IteratorContext iter_ctx(CreateParams(ctx));
     if (model_) {
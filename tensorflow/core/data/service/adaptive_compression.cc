@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/adaptive_compression.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr ElementCompression kCompressions[] = {ELEMENT_COMPRESSION_NONE,
+                                                ELEMENT_COMPRESSION_SNAPPY};
+
+// Weight of the newest sample in the moving averages once the warmup is over.
+constexpr double kSmoothing = 0.1;
+
+}  // namespace
+
+ElementCompression AdaptiveCompressionSelector::Next() {
+  mutex_lock l(mu_);
+  ++num_requests_;
+  ElementCompression compression = Pick();
+  estimates_[compression].last_picked = num_requests_;
+  return compression;
+}
+
+ElementCompression AdaptiveCompressionSelector::Pick() {
+  ElementCompression least_sampled = kCompressions[0];
+  ElementCompression least_recent = kCompressions[0];
+  ElementCompression cheapest = kCompressions[0];
+  for (ElementCompression compression : kCompressions) {
+    const Estimate& estimate = estimates_[compression];
+    if (estimate.num_samples < estimates_[least_sampled].num_samples) {
+      least_sampled = compression;
+    }
+    if (estimate.last_picked < estimates_[least_recent].last_picked) {
+      least_recent = compression;
+    }
+    if (estimate.cost_us_per_byte < estimates_[cheapest].cost_us_per_byte) {
+      cheapest = compression;
+    }
+  }
+  if (estimates_[least_sampled].num_samples < kWarmupElements) {
+    return least_sampled;
+  }
+  if (num_requests_ % kExplorationInterval == 0) {
+    return least_recent;
+  }
+  return cheapest;
+}
+
+void AdaptiveCompressionSelector::Record(const Sample& sample) {
+  if (sample.uncompressed_bytes <= 0) {
+    return;
+  }
+  const int64_t time_us =
+      std::max<int64_t>(0, sample.transfer_time_us) +
+      sample.compression_time_us + sample.uncompression_time_us;
+  const double cost_us_per_byte =
+      static_cast<double>(time_us) / sample.uncompressed_bytes;
+  mutex_lock l(mu_);
+  Estimate& estimate = estimates_[sample.compression];
+  ++estimate.num_samples;
+  // Averages the warmup samples equally, so one slow element doesn't decide
+  // the compression.
+  const double weight = std::max(kSmoothing, 1.0 / estimate.num_samples);
+  estimate.cost_us_per_byte +=
+      weight * (cost_us_per_byte - estimate.cost_us_per_byte);
+}
+
+double AdaptiveCompressionSelector::EstimatedCost(
+    ElementCompression compression) const {
+  mutex_lock l(mu_);
+  auto it = estimates_.find(compression);
+  if (it == estimates_.end() || it->second.num_samples == 0) {
+    return -1.0;
+  }
+  return it->second.cost_us_per_byte;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_ADAPTIVE_COMPRESSION_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_ADAPTIVE_COMPRESSION_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// Chooses how a worker compresses the elements it sends to one client.
+//
+// Compressing an element costs CPU on the worker and the client, and saves
+// transfer time in proportion to its compression ratio and the bandwidth
+// between them. The selector keeps a moving average of the cost per
+// uncompressed byte of each compression, measured from the elements read
+// with it, and picks the cheapest one. Every `kExplorationInterval` elements,
+// it picks the one it has not picked for the longest time instead, so it
+// follows changes in the data and the network.
+//
+// This class is thread-safe.
+class AdaptiveCompressionSelector {
+ public:
+  // The costs of transferring one element.
+  struct Sample {
+    ElementCompression compression = ELEMENT_COMPRESSION_NONE;
+    // The size of the element before compression.
+    int64_t uncompressed_bytes = 0;
+    // The time the element spent on the network, excluding the processing on
+    // the worker.
+    int64_t transfer_time_us = 0;
+    // The time the worker spent compressing the element.
+    int64_t compression_time_us = 0;
+    // The time the client spent uncompressing the element.
+    int64_t uncompression_time_us = 0;
+  };
+
+  // The number of elements read with each compression before the selector
+  // starts picking the cheapest one.
+  static constexpr int64_t kWarmupElements = 8;
+  // Every this many elements, one is read with the least recently picked
+  // compression.
+  static constexpr int64_t kExplorationInterval = 64;
+
+  // Returns the compression to request for the next element.
+  ElementCompression Next() TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the costs of an element read with `sample.compression`.
+  void Record(const Sample& sample) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the estimated cost per uncompressed byte of `compression`, or a
+  // negative number if it has no samples yet.
+  double EstimatedCost(ElementCompression compression) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Estimate {
+    int64_t num_samples = 0;
+    double cost_us_per_byte = 0.0;
+    // The request for which the compression was last picked.
+    int64_t last_picked = 0;
+  };
+
+  // Picks the compression for request `num_requests_`.
+  ElementCompression Pick() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  int64_t num_requests_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<ElementCompression, Estimate> estimates_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_ADAPTIVE_COMPRESSION_H_
@@ -0,0 +1,116 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/adaptive_compression.h"
+
+#include <cstdint>
+
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using Sample = AdaptiveCompressionSelector::Sample;
+
+constexpr int64_t kElementBytes = 1 << 20;
+
+// Reads `num_elements` elements with the compressions chosen by `selector`,
+// where uncompressed elements take `uncompressed_transfer_us` to transfer and
+// compressed ones take `compressed_transfer_us` plus 100us of compression
+// and 50us of uncompression. Returns the number of compressed elements.
+int64_t ReadElements(AdaptiveCompressionSelector& selector,
+                     int64_t num_elements, int64_t uncompressed_transfer_us,
+                     int64_t compressed_transfer_us) {
+  int64_t num_compressed = 0;
+  for (int64_t i = 0; i < num_elements; ++i) {
+    Sample sample;
+    sample.compression = selector.Next();
+    sample.uncompressed_bytes = kElementBytes;
+    if (sample.compression == ELEMENT_COMPRESSION_SNAPPY) {
+      sample.transfer_time_us = compressed_transfer_us;
+      sample.compression_time_us = 100;
+      sample.uncompression_time_us = 50;
+      ++num_compressed;
+    } else {
+      sample.transfer_time_us = uncompressed_transfer_us;
+    }
+    selector.Record(sample);
+  }
+  return num_compressed;
+}
+
+TEST(AdaptiveCompressionSelectorTest, SamplesEachCompressionFirst) {
+  AdaptiveCompressionSelector selector;
+  EXPECT_LT(selector.EstimatedCost(ELEMENT_COMPRESSION_NONE), 0);
+  EXPECT_EQ(ReadElements(selector,
+                         2 * AdaptiveCompressionSelector::kWarmupElements,
+                         /*uncompressed_transfer_us=*/1000,
+                         /*compressed_transfer_us=*/1000),
+            AdaptiveCompressionSelector::kWarmupElements);
+  EXPECT_DOUBLE_EQ(selector.EstimatedCost(ELEMENT_COMPRESSION_NONE),
+                   1000.0 / kElementBytes);
+  EXPECT_DOUBLE_EQ(selector.EstimatedCost(ELEMENT_COMPRESSION_SNAPPY),
+                   1150.0 / kElementBytes);
+}
+
+TEST(AdaptiveCompressionSelectorTest, CompressesOnSlowNetwork) {
+  AdaptiveCompressionSelector selector;
+  ReadElements(selector, 2 * AdaptiveCompressionSelector::kWarmupElements,
+               /*uncompressed_transfer_us=*/1000,
+               /*compressed_transfer_us=*/200);
+  const int64_t num_elements =
+      10 * AdaptiveCompressionSelector::kExplorationInterval;
+  EXPECT_GE(ReadElements(selector, num_elements,
+                         /*uncompressed_transfer_us=*/1000,
+                         /*compressed_transfer_us=*/200),
+            num_elements - 10);
+}
+
+TEST(AdaptiveCompressionSelectorTest, DoesNotCompressOnFastNetwork) {
+  AdaptiveCompressionSelector selector;
+  ReadElements(selector, 2 * AdaptiveCompressionSelector::kWarmupElements,
+               /*uncompressed_transfer_us=*/100,
+               /*compressed_transfer_us=*/50);
+  EXPECT_LE(ReadElements(selector,
+                         10 * AdaptiveCompressionSelector::kExplorationInterval,
+                         /*uncompressed_transfer_us=*/100,
+                         /*compressed_transfer_us=*/50),
+            10);
+}
+
+TEST(AdaptiveCompressionSelectorTest, FollowsNetworkChanges) {
+  AdaptiveCompressionSelector selector;
+  ReadElements(selector, 2 * AdaptiveCompressionSelector::kWarmupElements,
+               /*uncompressed_transfer_us=*/100,
+               /*compressed_transfer_us=*/50);
+  // The network slows down, which the exploration notices.
+  ReadElements(selector, 20 * AdaptiveCompressionSelector::kExplorationInterval,
+               /*uncompressed_transfer_us=*/1000,
+               /*compressed_transfer_us=*/200);
+  EXPECT_EQ(selector.Next(), ELEMENT_COMPRESSION_SNAPPY);
+}
+
+TEST(AdaptiveCompressionSelectorTest, IgnoresEmptyElements) {
+  AdaptiveCompressionSelector selector;
+  Sample sample;
+  sample.transfer_time_us = 1000;
+  selector.Record(sample);
+  EXPECT_LT(selector.EstimatedCost(ELEMENT_COMPRESSION_NONE), 0);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/append_only_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// The log is split in this many segments, so discarding the oldest segment
+// frees a fraction of the log at a time.
+constexpr size_t kNumSegments = 4;
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<AppendOnlyLog>> AppendOnlyLog::Create(
+    Env* env, const std::string& parent_directory, size_t max_size_bytes) {
+  if (max_size_bytes == 0) {
+    return errors::InvalidArgument(
+        "The size limit of an append-only log must be positive.");
+  }
+  const std::string directory = io::JoinPath(
+      parent_directory, absl::StrCat("append_only_log_", env->NowMicros(), "_",
+                                     absl::Hex(random::New64())));
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  std::unique_ptr<AppendOnlyLog> log(
+      new AppendOnlyLog(env, directory, max_size_bytes));
+  mutex_lock l(log->append_mu_);
+  TF_RETURN_IF_ERROR(log->StartSegment());
+  return log;
+}
+
+AppendOnlyLog::AppendOnlyLog(Env* env, std::string directory,
+                             size_t max_size_bytes)
+    : env_(env),
+      directory_(std::move(directory)),
+      max_size_bytes_(max_size_bytes),
+      max_segment_size_bytes_(
+          std::max<size_t>(1, max_size_bytes / kNumSegments)) {}
+
+AppendOnlyLog::~AppendOnlyLog() {
+  {
+    mutex_lock l(append_mu_);
+    if (writer_ != nullptr) {
+      writer_->Close().IgnoreError();
+      writer_ = nullptr;
+    }
+    file_ = nullptr;
+  }
+  int64_t undeleted_files = 0;
+  int64_t undeleted_dirs = 0;
+  Status s =
+      env_->DeleteRecursively(directory_, &undeleted_files, &undeleted_dirs);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete append-only log " << directory_ << ": "
+                 << s;
+  }
+}
+
+Status AppendOnlyLog::Append(absl::string_view record) {
+  mutex_lock append_lock(append_mu_);
+  bool segment_full = false;
+  {
+    mutex_lock l(mu_);
+    segment_full = segments_.back()->size_bytes >= max_segment_size_bytes_;
+  }
+  if (segment_full) {
+    TF_RETURN_IF_ERROR(StartSegment());
+  }
+  const uint64_t offset = next_offset_;
+  TF_RETURN_IF_ERROR(writer_->WriteRecord(record));
+  // Readers go through `RandomAccessFile`, which only sees flushed data.
+  TF_RETURN_IF_ERROR(writer_->Flush());
+  const size_t record_size_bytes = io::RecordWriter::kHeaderSize +
+                                   record.size() +
+                                   io::RecordWriter::kFooterSize;
+  next_offset_ += record_size_bytes;
+
+  mutex_lock l(mu_);
+  Segment& segment = *segments_.back();
+  segment.offsets.push_back(offset);
+  segment.size_bytes += record_size_bytes;
+  size_bytes_ += record_size_bytes;
+  ++end_index_;
+  DiscardSegments();
+  return absl::OkStatus();
+}
+
+Status AppendOnlyLog::StartSegment() {
+  if (writer_ != nullptr) {
+    TF_RETURN_IF_ERROR(writer_->Close());
+    writer_ = nullptr;
+    TF_RETURN_IF_ERROR(file_->Close());
+  }
+  auto segment = std::make_shared<Segment>();
+  segment->filename = io::JoinPath(
+      directory_, absl::StrCat("segment_", next_segment_id_++, ".tfrecord"));
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(segment->filename, &file_));
+  TF_RETURN_IF_ERROR(
+      env_->NewRandomAccessFile(segment->filename, &segment->file));
+  writer_ = std::make_unique<io::RecordWriter>(file_.get());
+  next_offset_ = 0;
+  mutex_lock l(mu_);
+  segment->start_index = end_index_;
+  segments_.push_back(std::move(segment));
+  return absl::OkStatus();
+}
+
+void AppendOnlyLog::DiscardSegments() {
+  while (segments_.size() > 1 && size_bytes_ > max_size_bytes_) {
+    std::shared_ptr<Segment> segment = std::move(segments_.front());
+    segments_.pop_front();
+    size_bytes_ -= segment->size_bytes;
+    start_index_ = segments_.front()->start_index;
+    // On file systems that support it, reads in progress keep reading from
+    // their open file.
+    Status s = env_->DeleteFile(segment->filename);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete append-only log segment "
+                   << segment->filename << ": " << s;
+    }
+    VLOG(3) << "Discarded append-only log segment " << segment->filename
+            << ". Records now start at index " << start_index_ << ".";
+  }
+}
+
+Status AppendOnlyLog::Read(size_t index, tstring& record) const {
+  std::shared_ptr<Segment> segment;
+  uint64_t offset = 0;
+  {
+    mutex_lock l(mu_);
+    if (index < start_index_ || index >= end_index_) {
+      return errors::OutOfRange("Record ", index,
+                                " is not in the append-only log, which holds "
+                                "records [",
+                                start_index_, ", ", end_index_, ").");
+    }
+    auto it = std::upper_bound(
+        segments_.begin(), segments_.end(), index,
+        [](size_t index, const std::shared_ptr<Segment>& segment) {
+          return index < segment->start_index;
+        });
+    segment = *std::prev(it);
+    offset = segment->offsets[index - segment->start_index];
+  }
+  io::RecordReader reader(segment->file.get());
+  Status s = reader.ReadRecord(&offset, &record);
+  if (errors::IsOutOfRange(s)) {
+    // The record was written, so its file must not end before it.
+    return errors::DataLoss("Failed to read record ", index,
+                            " of the append-only log from ",
+                            segment->filename, ": ", s);
+  }
+  return s;
+}
+
+size_t AppendOnlyLog::start_index() const {
+  mutex_lock l(mu_);
+  return start_index_;
+}
+
+size_t AppendOnlyLog::end_index() const {
+  mutex_lock l(mu_);
+  return end_index_;
+}
+
+size_t AppendOnlyLog::size_bytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+}  // namespace data
+}  // namespace tensorflow
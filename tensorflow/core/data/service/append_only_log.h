@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_APPEND_ONLY_LOG_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_APPEND_ONLY_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+
+// A size-bounded log of records on local storage, with random reads by record
+// index. The first appended record has index 0.
+//
+// Records are written as TFRecords to a sequence of segment files in a
+// directory owned by the log. When the log grows beyond its size limit, its
+// oldest segment is deleted, so the log keeps a suffix of the appended
+// records. Only the offsets of the records are kept in memory. The directory
+// is deleted when the log is destroyed.
+//
+// This class is thread-safe. Appends may run concurrently with reads, but are
+// expected to come from one thread at a time.
+class AppendOnlyLog {
+ public:
+  // Creates an empty log in a new directory under `parent_directory`, which
+  // holds at most about `max_size_bytes` of records.
+  static absl::StatusOr<std::unique_ptr<AppendOnlyLog>> Create(
+      Env* env, const std::string& parent_directory, size_t max_size_bytes);
+  ~AppendOnlyLog();
+
+  AppendOnlyLog(const AppendOnlyLog&) = delete;
+  AppendOnlyLog& operator=(const AppendOnlyLog&) = delete;
+
+  // Appends `record` to the log.
+  Status Append(absl::string_view record) TF_LOCKS_EXCLUDED(append_mu_, mu_);
+
+  // Reads the record with `index`. Returns an `OutOfRange` error if it has
+  // been discarded or not been appended yet.
+  Status Read(size_t index, tstring& record) const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the index of the oldest record that has not been discarded.
+  size_t start_index() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the index that the next appended record will have.
+  size_t end_index() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of bytes in the segment files.
+  size_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Segment {
+    std::string filename;
+    // Read handle to the file, which stays valid after a concurrent append
+    // completes.
+    std::unique_ptr<RandomAccessFile> file;
+    // The index of the first record in the segment.
+    size_t start_index = 0;
+    // The offsets of the records in the file.
+    std::vector<uint64_t> offsets;
+    size_t size_bytes = 0;
+  };
+
+  AppendOnlyLog(Env* env, std::string directory, size_t max_size_bytes);
+
+  // Starts a new segment for the next appended record.
+  Status StartSegment() TF_EXCLUSIVE_LOCKS_REQUIRED(append_mu_)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Deletes the oldest segments until the log fits in `max_size_bytes_`,
+  // always keeping the current segment.
+  void DiscardSegments() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const std::string directory_;
+  const size_t max_size_bytes_;
+  // A segment is closed when it reaches this size.
+  const size_t max_segment_size_bytes_;
+
+  // Serializes appends.
+  mutex append_mu_;
+  std::unique_ptr<WritableFile> file_ TF_GUARDED_BY(append_mu_);
+  std::unique_ptr<io::RecordWriter> writer_ TF_GUARDED_BY(append_mu_);
+  // The offset of the next record in the current segment.
+  uint64_t next_offset_ TF_GUARDED_BY(append_mu_) = 0;
+  int64_t next_segment_id_ TF_GUARDED_BY(append_mu_) = 0;
+
+  mutable mutex mu_;
+  // Segments are shared with reads in progress, which may outlive their
+  // removal from the log.
+  std::deque<std::shared_ptr<Segment>> segments_ TF_GUARDED_BY(mu_);
+  size_t start_index_ TF_GUARDED_BY(mu_) = 0;
+  size_t end_index_ TF_GUARDED_BY(mu_) = 0;
+  size_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_APPEND_ONLY_LOG_H_
@@ -0,0 +1,111 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/append_only_log.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status_matchers.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tensorflow::testing::StatusIs;
+using ::testing::IsEmpty;
+
+std::string TestDirectory(const std::string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+std::string Record(int i) { return absl::StrCat("record ", i); }
+
+TEST(AppendOnlyLogTest, AppendAndRead) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AppendOnlyLog> log,
+      AppendOnlyLog::Create(Env::Default(), TestDirectory("append_and_read"),
+                            /*max_size_bytes=*/1 << 20));
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(log->Append(Record(i)));
+  }
+  EXPECT_EQ(log->start_index(), 0);
+  EXPECT_EQ(log->end_index(), 10);
+  for (int i : {3, 0, 9, 5}) {
+    tstring record;
+    TF_ASSERT_OK(log->Read(i, record));
+    EXPECT_EQ(record, Record(i));
+  }
+  tstring record;
+  EXPECT_THAT(log->Read(10, record), StatusIs(error::OUT_OF_RANGE));
+}
+
+TEST(AppendOnlyLogTest, DiscardsOldestSegments) {
+  // Each record takes 16 bytes of framing and 8 or 9 bytes of data.
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<AppendOnlyLog> log,
+      AppendOnlyLog::Create(Env::Default(), TestDirectory("discard"),
+                            /*max_size_bytes=*/400));
+  for (int i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(log->Append(Record(i)));
+    EXPECT_LE(log->size_bytes(), 400 + 100);
+  }
+  EXPECT_GT(log->start_index(), 0);
+  EXPECT_EQ(log->end_index(), 100);
+
+  tstring record;
+  EXPECT_THAT(log->Read(log->start_index() - 1, record),
+              StatusIs(error::OUT_OF_RANGE));
+  for (size_t i = log->start_index(); i < log->end_index(); ++i) {
+    TF_ASSERT_OK(log->Read(i, record));
+    EXPECT_EQ(record, Record(i));
+  }
+}
+
+TEST(AppendOnlyLogTest, DeletesDirectory) {
+  const std::string parent_directory = TestDirectory("delete");
+  {
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<AppendOnlyLog> log,
+        AppendOnlyLog::Create(Env::Default(), parent_directory,
+                              /*max_size_bytes=*/1 << 20));
+    TF_ASSERT_OK(log->Append(Record(0)));
+    std::vector<std::string> children;
+    TF_ASSERT_OK(Env::Default()->GetChildren(parent_directory, &children));
+    EXPECT_EQ(children.size(), 1);
+  }
+  std::vector<std::string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(parent_directory, &children));
+  EXPECT_THAT(children, IsEmpty());
+}
+
+TEST(AppendOnlyLogTest, SizeMustBePositive) {
+  EXPECT_THAT(AppendOnlyLog::Create(Env::Default(), TestDirectory("empty"),
+                                    /*max_size_bytes=*/0)
+                  .status(),
+              StatusIs(error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
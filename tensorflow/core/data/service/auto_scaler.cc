@@ -130,6 +130,14 @@ std::optional<int64_t> AutoScaler::GetOptimalNumberOfWorkers() const
   return std::max(int64_t{1}, optimal_number_of_workers);
 }
 
+std::optional<double> AutoScaler::GetWorkerThroughput(
+    const std::string& worker_address) const TF_LOCKS_EXCLUDED(mu_) {
+  tsl::tf_shared_lock l(mu_);
+  auto it = worker_throughputs_.find(worker_address);
+  if (it == worker_throughputs_.end()) return std::nullopt;
+  return it->second;
+}
+
 absl::Status AutoScaler::ReportProcessingTime(const std::string& worker_address,
                                               absl::Duration processing_time)
     TF_LOCKS_EXCLUDED(mu_) {
@@ -263,6 +271,15 @@ std::optional<int64_t> MultipleIterationsAutoScaler::GetOptimalNumberOfWorkers()
     return optimal_number_of_workers;
 }
 
+std::optional<double> MultipleIterationsAutoScaler::GetWorkerThroughput(
+    int64_t iteration_id, const std::string& worker_address) const
+    TF_LOCKS_EXCLUDED(mu_) {
+  tsl::tf_shared_lock l(mu_);
+  auto it = auto_scalers_.find(iteration_id);
+  if (it == auto_scalers_.end()) return std::nullopt;
+  return it->second->GetWorkerThroughput(worker_address);
+}
+
 absl::Status MultipleIterationsAutoScaler::ReportProcessingTime(
     int64_t iteration_id, const std::string& worker_address,
     absl::Duration processing_time) TF_LOCKS_EXCLUDED(mu_) {
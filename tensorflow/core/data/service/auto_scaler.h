@@ -73,6 +73,11 @@ class AutoScaler {
   // target processing times, returns nullopt.
   std::optional<int64_t> GetOptimalNumberOfWorkers() const
       TF_LOCKS_EXCLUDED(mu_);
+  // Returns the latest throughput, in elements per second, reported by the
+  // worker with `worker_address`, or nullopt if the worker has not reported
+  // any processing time.
+  std::optional<double> GetWorkerThroughput(
+      const std::string& worker_address) const TF_LOCKS_EXCLUDED(mu_);
   // Reports the latest observed processing time from the worker with
   // `worker_address`. Returns an error if `processing_time` is ZeroDuration or
   // negative.
@@ -131,6 +136,12 @@ class MultipleIterationsAutoScaler {
   // target processing times for at least one iteration, returns nullopt.
   std::optional<int64_t> GetOptimalNumberOfWorkers() const
       TF_LOCKS_EXCLUDED(mu_);
+  // Returns the latest throughput, in elements per second, reported by the
+  // worker with `worker_address` for iteration with `iteration_id`, or nullopt
+  // if there is no such report.
+  std::optional<double> GetWorkerThroughput(
+      int64_t iteration_id, const std::string& worker_address) const
+      TF_LOCKS_EXCLUDED(mu_);
   // Reports the latest observed processing time from the worker with
   // `worker_address` for iteration with `iteration_id`. Returns an error if
   // `processing_time` is ZeroDuration or negative.
@@ -170,6 +170,20 @@ TEST(AutoScalerTest, GetOptimalNumberOfWorkersRemoveOutliersPT) {
   EXPECT_EQ(auto_scaler.GetOptimalNumberOfWorkers(), 244);
 }
 
+TEST(AutoScalerTest, GetWorkerThroughput) {
+  AutoScaler auto_scaler;
+  EXPECT_EQ(auto_scaler.GetWorkerThroughput("/worker/task/0:20000"),
+            std::nullopt);
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Microseconds(10)));
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
+                                                absl::Microseconds(20)));
+  EXPECT_DOUBLE_EQ(*auto_scaler.GetWorkerThroughput("/worker/task/0:20000"),
+                   50000.0);
+  EXPECT_EQ(auto_scaler.GetWorkerThroughput("/worker/task/1:20000"),
+            std::nullopt);
+}
+
 TEST(AutoScalerTest, ReportProcessingTimeNewWorker) {
   AutoScaler auto_scaler;
   TF_ASSERT_OK(auto_scaler.ReportProcessingTime("/worker/task/0:20000",
@@ -534,6 +548,18 @@ TEST(MultipleIterationsAutoScalerTest,
   EXPECT_EQ(auto_scaler.GetOptimalNumberOfWorkers(), 20);
 }
 
+TEST(MultipleIterationsAutoScalerTest, GetWorkerThroughput) {
+  MultipleIterationsAutoScaler auto_scaler;
+  EXPECT_EQ(auto_scaler.GetWorkerThroughput(0, "/worker/task/0:20000"),
+            std::nullopt);
+  TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
+                                                absl::Microseconds(10)));
+  EXPECT_DOUBLE_EQ(*auto_scaler.GetWorkerThroughput(0, "/worker/task/0:20000"),
+                   100000.0);
+  EXPECT_EQ(auto_scaler.GetWorkerThroughput(1, "/worker/task/0:20000"),
+            std::nullopt);
+}
+
 TEST(MultipleIterationsAutoScalerTest, ReportProcessingTimeNewIteration) {
   MultipleIterationsAutoScaler auto_scaler;
   TF_ASSERT_OK(auto_scaler.ReportProcessingTime(0, "/worker/task/0:20000",
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/client/data_service_client.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -29,8 +30,10 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/service/client/common.h"
 #include "tensorflow/core/data/service/client/validate_utils.h"
 #include "tensorflow/core/data/service/common.h"
@@ -60,12 +63,32 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+// In weighted task selection, tasks whose workers are in the same topology as
+// the client count this many times as much as other tasks.
+constexpr double kSameTopologyWeight = 4.0;
+
 bool IsColocatedTask(const TaskInfo& task) {
   return absl::c_any_of(task.worker_tags(), [](std::string_view worker_tag) {
     return absl::AsciiStrToUpper(worker_tag) == kColocatedWorkerTag;
   });
 }
 
+std::string GetClientTopology() {
+  const char* topology = std::getenv("TF_DATA_SERVICE_TOPOLOGY");
+  return topology == nullptr ? "" : topology;
+}
+
+bool IsSameTopologyTask(const TaskInfo& task, const std::string& topology) {
+  if (topology.empty()) {
+    return false;
+  }
+  const std::string tag = absl::StrCat(kTopologyWorkerTagPrefix, topology);
+  return absl::c_any_of(task.worker_tags(),
+                        [&tag](std::string_view worker_tag) {
+                          return worker_tag == tag;
+                        });
+}
+
 absl::StatusOr<DataTransferServerInfo> GetTransferServer(
     const std::string& protocol, const TaskInfo& task_info) {
   for (const auto& transfer_server : task_info.transfer_servers()) {
@@ -82,6 +105,9 @@ absl::StatusOr<DataTransferServerInfo> GetTransferServer(
 
 DataServiceClient::DataServiceClient(const DataServiceParams& params)
     : params_(params),
+      weighted_task_selection_(
+          GetExperiments().contains("weighted_task_selection")),
+      topology_(GetClientTopology()),
       max_outstanding_requests_(params.max_outstanding_requests) {}
 
 DataServiceClient::~DataServiceClient() {
@@ -420,7 +446,10 @@ Status DataServiceClient::AddTask(const TaskInfo& task_info)
   metrics::RecordTFDataServiceDataTransferProtocolUsed(
       worker->GetDataTransferProtocol(),
       /*user_specified=*/!params_.data_transfer_protocol.empty());
-  tasks_.push_back(std::make_shared<Task>(task_info, std::move(worker)));
+  auto task = std::make_shared<Task>(task_info, std::move(worker));
+  task->worker_throughput = task_info.worker_throughput();
+  task->same_topology = IsSameTopologyTask(task_info, topology_);
+  tasks_.push_back(std::move(task));
   worker_thread_cv_.notify_one();
   if (IsCoordinatedRead()) {
     VLOG(1) << "Consumer " << params_.consumer_index.value() << " adding task "
@@ -495,10 +524,12 @@ void DataServiceClient::UpdateTasks(const ClientHeartbeatResponse& resp)
   int index = 0;
   while (index < tasks_.size()) {
     std::shared_ptr<Task> task = tasks_[index];
-    if (task_id_to_task.contains(task->info.task_id())) {
+    auto it = task_id_to_task.find(task->info.task_id());
+    if (it != task_id_to_task.end()) {
+      task->worker_throughput = it->second.worker_throughput();
       // Remove already-known tasks from `task_id_to_task`, so that at the
       // end of the loop, only new tasks remain.
-      task_id_to_task.erase(task->info.task_id());
+      task_id_to_task.erase(it);
       ++index;
     } else {
       // Task has been removed.
@@ -711,6 +742,9 @@ std::shared_ptr<DataServiceClient::Task> DataServiceClient::GetTaskToProcess()
   if (!ShouldProcessTask()) {
     return nullptr;
   }
+  if (weighted_task_selection_ && !IsCoordinatedRead()) {
+    return GetWeightedTaskToProcess();
+  }
 
   for (int i = 0; i < tasks_.size(); ++i) {
     std::shared_ptr<Task>& task = tasks_[next_task_index_];
@@ -742,6 +776,55 @@ std::shared_ptr<DataServiceClient::Task> DataServiceClient::GetTaskToProcess()
   return nullptr;
 }
 
+// Uses smooth weighted round-robin: every available task earns its weight in
+// credit, and the task with the most credit is picked and pays back the total
+// weight of the available tasks. Over time, each task is picked in proportion
+// to its weight, without long runs of the same task.
+std::shared_ptr<DataServiceClient::Task>
+DataServiceClient::GetWeightedTaskToProcess() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  double throughput_sum = 0;
+  int64_t num_throughputs = 0;
+  for (const std::shared_ptr<Task>& task : tasks_) {
+    if (task->worker_throughput > 0) {
+      throughput_sum += task->worker_throughput;
+      ++num_throughputs;
+    }
+  }
+  // Workers that have not reported a throughput yet are assumed to be average.
+  const double default_throughput =
+      num_throughputs > 0 ? throughput_sum / num_throughputs : 1.0;
+
+  std::shared_ptr<Task> selected;
+  double total_weight = 0;
+  for (const std::shared_ptr<Task>& task : tasks_) {
+    if (task->in_use || task->end_of_sequence || task->removed) {
+      continue;
+    }
+    const double weight = TaskWeight(*task, default_throughput);
+    task->selection_credit += weight;
+    total_weight += weight;
+    if (selected == nullptr ||
+        task->selection_credit > selected->selection_credit) {
+      selected = task;
+    }
+  }
+  if (selected != nullptr) {
+    selected->selection_credit -= total_weight;
+  }
+  return selected;
+}
+
+double DataServiceClient::TaskWeight(const Task& task,
+                                     double default_throughput) const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  double weight = task.worker_throughput > 0 ? task.worker_throughput
+                                             : default_throughput;
+  if (task.same_topology) {
+    weight *= kSameTopologyWeight;
+  }
+  return weight;
+}
+
 // Increments the next task index, starting over if all tasks have been
 // processed.
 void DataServiceClient::AdvanceTaskIndex() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
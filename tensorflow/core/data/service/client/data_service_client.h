@@ -113,6 +113,13 @@ class DataServiceClient {
     // Number of retries. The more it is retried, the longer it should wait
     // before the next retry.
     int64_t num_retries = 0;
+    // The latest throughput reported by the task's worker, in elements per
+    // second, or 0 if it is unknown.
+    double worker_throughput TF_GUARDED_BY(&DataServiceClient::mu_) = 0;
+    // Whether the task's worker has the same topology tag as the client.
+    bool same_topology = false;
+    // The weight accumulated by the task in weighted task selection.
+    double selection_credit TF_GUARDED_BY(&DataServiceClient::mu_) = 0;
   };
 
   struct Result {
@@ -173,6 +180,13 @@ class DataServiceClient {
   // Searches for a task to process, visiting tasks in-order and giving every
   // task a chance to proceed.
   std::shared_ptr<Task> GetTaskToProcess();
+  // Searches for a task to process for reads that are not coordinated,
+  // picking tasks in proportion to their `TaskWeight`.
+  std::shared_ptr<Task> GetWeightedTaskToProcess();
+  // Returns the weight of `task` in weighted task selection, where
+  // `default_throughput` is used for workers that have not reported a
+  // throughput.
+  double TaskWeight(const Task& task, double default_throughput) const;
   void AdvanceTaskIndex();
   Status TryGetElement(const Task& task, bool allow_skip,
                        GetElementResult& result);
@@ -191,6 +205,12 @@ class DataServiceClient {
   std::string DebugString() const;
 
   const DataServiceParams params_;
+  // Whether reads that are not coordinated prefer faster workers, and
+  // workers in the same topology, over strict round-robin.
+  const bool weighted_task_selection_;
+  // The topology of the client, from the `TF_DATA_SERVICE_TOPOLOGY`
+  // environment variable.
+  const std::string topology_;
 
   mutable mutex mu_;
   condition_variable get_next_cv_ TF_GUARDED_BY(mu_);
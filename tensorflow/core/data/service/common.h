@@ -39,6 +39,12 @@ constexpr int kDataServiceVersion = 9;
 // workers on other TF hosts when the host runs a local tf.data service worker.
 constexpr absl::string_view kColocatedWorkerTag = "COLOCATED";
 
+// Workers may be tagged with "TOPOLOGY:<name>", e.g. the rack they run in.
+// Clients whose `TF_DATA_SERVICE_TOPOLOGY` environment variable is set to
+// the same name prefer reading from those workers when the
+// "weighted_task_selection" experiment is enabled.
+constexpr absl::string_view kTopologyWorkerTagPrefix = "TOPOLOGY:";
+
 // Container to hold the result of a `GetNext` call.
 struct GetNextResult final {
   explicit GetNextResult() = default;
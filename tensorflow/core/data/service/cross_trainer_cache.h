@@ -22,6 +22,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/byte_size.h"
@@ -46,6 +47,11 @@ namespace data {
 // collected when the cache becomes full. Consequently, trainers read from a
 // sliding window through the dataset and may not read the full dataset.
 //
+// Optionally, elements that are garbage collected from memory are moved to an
+// `EvictedElementStore`, e.g. on local disk. Trainers that fall behind the
+// in-memory window then keep reading the shared sequence from the store, as
+// long as it still holds their next element.
+//
 // The `CrossTrainerCache` class is thread-safe.
 //
 // Example usage:
@@ -91,6 +97,28 @@ class CachableSequence {
   virtual size_t GetElementSizeBytes(const ElementType&) const = 0;
 };
 
+// A second tier for a `CrossTrainerCache`, which keeps the elements evicted
+// from memory. Elements are appended in the order of the sequence, so the
+// first appended element has index 0. The store may discard its oldest
+// elements to bound its size.
+//
+// Implementations must be thread-safe.
+template <class ElementType>
+class EvictedElementStore {
+ public:
+  virtual ~EvictedElementStore() = default;
+
+  // Appends the element that follows the previously appended elements.
+  virtual Status Append(const ElementType& element) = 0;
+
+  // Reads the element with `index`. Returns an `OutOfRange` error if the
+  // element has been discarded.
+  virtual StatusOr<ElementType> Read(size_t index) = 0;
+
+  // Returns the index of the oldest element that has not been discarded.
+  virtual size_t start_index() const = 0;
+};
+
 // Sliding-window cache shared across concurrent trainers.
 template <class ElementType>
 class CrossTrainerCache {
@@ -98,9 +126,13 @@ class CrossTrainerCache {
   // Creates a `CrossTrainerCache` with `max_cache_size_bytes` of memory budget.
   // The cache should be able to hold at least one element, i.e.:
   // REQUIRES: `max_cache_size_bytes >= max(GetElementSizeBytes(*))`
+  // If `evicted_elements` is not null, elements evicted from memory are moved
+  // to it.
   explicit CrossTrainerCache(
       size_t max_cache_size_bytes,
-      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence);
+      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+      std::unique_ptr<EvictedElementStore<ElementType>> evicted_elements =
+          nullptr);
   virtual ~CrossTrainerCache() = default;
   CrossTrainerCache(const CrossTrainerCache&) = delete;
   CrossTrainerCache& operator=(const CrossTrainerCache&) = delete;
@@ -138,6 +170,11 @@ class CrossTrainerCache {
   // the cached elements).
   size_t GetElementIndex(const std::string& trainer_id);
 
+  // Reads the element with `element_index` from `evicted_elements_`.
+  StatusOr<std::shared_ptr<const ElementType>> ReadEvictedElement(
+      std::shared_ptr<EvictedElementStore<ElementType>> evicted_elements,
+      size_t element_index);
+
   // Returns the next element for `trainer_id`.
   StatusOr<std::shared_ptr<const ElementType>> GetElement(
       const std::string& trainer_id);
@@ -145,6 +182,10 @@ class CrossTrainerCache {
   // Reads a new element and writes it into the cache.
   Status ExtendCache();
 
+  // Returns the number of old elements that need to be freed to insert an
+  // element of `new_element_size_bytes`.
+  size_t NumElementsToFree(size_t new_element_size_bytes);
+
   // Frees old elements to keep the cache size below `max_cache_size_bytes_`.
   // `new_element_size_bytes` is the size of the new element being inserted.
   void FreeSpace(size_t new_element_size_bytes);
@@ -173,6 +214,13 @@ class CrossTrainerCache {
   // True if one thread is extending the cache.
   bool extending_cache_ TF_GUARDED_BY(mu_) = false;
 
+  // Holds the elements before `cache_start_index_`, if set. It is reset if
+  // appending to it fails. Since only the thread extending the cache appends
+  // to it, it holds exactly the elements in [start_index(),
+  // cache_start_index_).
+  std::shared_ptr<EvictedElementStore<ElementType>> evicted_elements_
+      TF_GUARDED_BY(mu_);
+
   // Maps trainer IDs to element indices. The indices are absolute indices
   // within the dataset. The actual index to use with `cache_` would be
   // `trainer_to_element_index_map_[trainer_id] - cache_start_index_`.
@@ -183,9 +231,11 @@ class CrossTrainerCache {
 template <class ElementType>
 CrossTrainerCache<ElementType>::CrossTrainerCache(
     size_t max_cache_size_bytes,
-    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence)
+    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+    std::unique_ptr<EvictedElementStore<ElementType>> evicted_elements)
     : max_cache_size_bytes_(max_cache_size_bytes),
-      cachable_sequence_(std::move(cachable_sequence)) {
+      cachable_sequence_(std::move(cachable_sequence)),
+      evicted_elements_(std::move(evicted_elements)) {
   DCHECK_GT(max_cache_size_bytes, 0)
       << "CrossTrainerCache size must be greater than 0.";
   VLOG(2) << "Initialized tf.data service cross-trainer cache with "
@@ -212,20 +262,28 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
     const std::string& trainer_id) {
   bool should_extend_cache = false;
   while (true) {
+    std::shared_ptr<EvictedElementStore<ElementType>> evicted_elements;
+    size_t evicted_element_index = 0;
     {
       mutex_lock l(mu_);
       TF_RETURN_IF_ERROR(status_);
       if (IsElementReady(trainer_id)) {
-        TF_ASSIGN_OR_RETURN(std::shared_ptr<const ElementType> element,
-                            GetElement(trainer_id));
-        return CacheQueryResult{element,
-                                /*is_cache_hit=*/!should_extend_cache};
-      }
-
-      // Extends the cache or waits for another thread to extend the cache. When
-      // concurrent trainers wait for the next element, only one of them should
-      // extend the cache.
-      if (extending_cache_) {
+        if (GetElementIndex(trainer_id) >= cache_start_index_) {
+          TF_ASSIGN_OR_RETURN(std::shared_ptr<const ElementType> element,
+                              GetElement(trainer_id));
+          return CacheQueryResult{element,
+                                  /*is_cache_hit=*/!should_extend_cache};
+        }
+        // The element has been evicted from memory. It is read after
+        // releasing `mu_`, since reading from the store may be slow.
+        evicted_elements = evicted_elements_;
+        evicted_element_index = GetElementIndex(trainer_id);
+        trainer_to_element_index_map_[trainer_id] = evicted_element_index + 1;
+        should_extend_cache = false;
+      } else if (extending_cache_) {
+        // Extends the cache or waits for another thread to extend the cache.
+        // When concurrent trainers wait for the next element, only one of them
+        // should extend the cache.
         should_extend_cache = false;
         cv_.wait(l);
       } else {
@@ -234,6 +292,20 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
       }
     }
 
+    if (evicted_elements != nullptr) {
+      StatusOr<std::shared_ptr<const ElementType>> element =
+          ReadEvictedElement(evicted_elements, evicted_element_index);
+      if (element.ok()) {
+        return CacheQueryResult{*std::move(element), /*is_cache_hit=*/true};
+      }
+      if (!errors::IsOutOfRange(element.status())) {
+        return element.status();
+      }
+      // The element was discarded after it was looked up. The next iteration
+      // moves on to the oldest remaining element.
+      continue;
+    }
+
     if (should_extend_cache) {
       Status s = ExtendCache();
       mutex_lock l(mu_);
@@ -271,12 +343,25 @@ template <class ElementType>
 size_t CrossTrainerCache<ElementType>::GetElementIndex(
     const std::string& trainer_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   size_t element_index = trainer_to_element_index_map_[trainer_id];
-  if (element_index < cache_start_index_) {
-    element_index = cache_start_index_;
+  const size_t start_index = evicted_elements_ != nullptr
+                                 ? evicted_elements_->start_index()
+                                 : cache_start_index_;
+  if (element_index < start_index) {
+    element_index = start_index;
   }
   return element_index;
 }
 
+template <class ElementType>
+StatusOr<std::shared_ptr<const ElementType>>
+CrossTrainerCache<ElementType>::ReadEvictedElement(
+    std::shared_ptr<EvictedElementStore<ElementType>> evicted_elements,
+    size_t element_index) TF_LOCKS_EXCLUDED(mu_) {
+  TF_ASSIGN_OR_RETURN(ElementType element,
+                      evicted_elements->Read(element_index));
+  return std::make_shared<const ElementType>(std::move(element));
+}
+
 template <class ElementType>
 Status CrossTrainerCache<ElementType>::ExtendCache() TF_LOCKS_EXCLUDED(mu_) {
   TF_ASSIGN_OR_RETURN(ElementType element, cachable_sequence_->GetNext());
@@ -289,14 +374,56 @@ Status CrossTrainerCache<ElementType>::ExtendCache() TF_LOCKS_EXCLUDED(mu_) {
         " and cache size: ", max_cache_size_bytes_);
   }
 
+  // Elements are appended to the store before they leave memory, so that
+  // every element after the store's start index is in one of the two tiers.
+  std::shared_ptr<EvictedElementStore<ElementType>> evicted_elements;
+  std::vector<std::shared_ptr<const ElementType>> elements_to_evict;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(status_);
+    evicted_elements = evicted_elements_;
+    if (evicted_elements != nullptr) {
+      size_t num_elements_to_free = NumElementsToFree(new_element_size_bytes);
+      elements_to_evict.assign(cache_.begin(),
+                               cache_.begin() + num_elements_to_free);
+    }
+  }
+  Status append_status = absl::OkStatus();
+  for (const auto& element_to_evict : elements_to_evict) {
+    append_status = evicted_elements->Append(*element_to_evict);
+    if (!append_status.ok()) {
+      break;
+    }
+  }
+
   mutex_lock l(mu_);
   TF_RETURN_IF_ERROR(status_);
+  if (!append_status.ok()) {
+    LOG(WARNING) << "Failed to move elements evicted from the tf.data service "
+                 << "cross-trainer cache to its second tier. Evicted elements "
+                 << "will be discarded from now on: " << append_status;
+    evicted_elements_ = nullptr;
+  }
   FreeSpace(new_element_size_bytes);
   cache_.push_back(std::make_shared<ElementType>(std::move(element)));
   cache_size_bytes_ += new_element_size_bytes;
   return absl::OkStatus();
 }
 
+template <class ElementType>
+size_t CrossTrainerCache<ElementType>::NumElementsToFree(
+    size_t new_element_size_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  size_t num_elements = 0;
+  size_t cache_size_bytes = cache_size_bytes_;
+  while (num_elements < cache_.size() &&
+         cache_size_bytes + new_element_size_bytes > max_cache_size_bytes_) {
+    cache_size_bytes -=
+        cachable_sequence_->GetElementSizeBytes(*cache_[num_elements]);
+    ++num_elements;
+  }
+  return num_elements;
+}
+
 template <class ElementType>
 void CrossTrainerCache<ElementType>::FreeSpace(size_t new_element_size_bytes)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 
 namespace tensorflow {
@@ -121,6 +122,41 @@ size_t ElementOrErrorDataset<Tensor>::GetElementSizeBytes(
   return element.TotalBytes();
 }
 
+// Keeps the evicted elements in memory, discarding all but the most recent
+// `capacity` elements.
+class InMemoryEvictedElementStore : public EvictedElementStore<int64_t> {
+ public:
+  explicit InMemoryEvictedElementStore(size_t capacity) : capacity_(capacity) {}
+
+  Status Append(const int64_t& element) override {
+    mutex_lock l(mu_);
+    elements_.push_back(element);
+    if (elements_.size() - start_index_ > capacity_) {
+      ++start_index_;
+    }
+    return absl::OkStatus();
+  }
+
+  StatusOr<int64_t> Read(size_t index) override {
+    mutex_lock l(mu_);
+    if (index < start_index_ || index >= elements_.size()) {
+      return errors::OutOfRange("Element ", index, " has been discarded.");
+    }
+    return elements_[index];
+  }
+
+  size_t start_index() const override {
+    mutex_lock l(mu_);
+    return start_index_;
+  }
+
+ private:
+  const size_t capacity_;
+  mutable mutex mu_;
+  std::vector<int64_t> elements_ TF_GUARDED_BY(mu_);
+  size_t start_index_ TF_GUARDED_BY(mu_) = 0;
+};
+
 std::vector<int64_t> GetRange(const size_t range) {
   std::vector<int64_t> result;
   for (int64_t i = 0; i < range; ++i) {
@@ -190,6 +226,31 @@ TEST(CrossTrainerCacheTest, SlowTrainersSkipData) {
   EXPECT_THAT(cache.Get("Slow trainer 2"), IsOkAndHolds(Pointee(Gt(94))));
 }
 
+TEST(CrossTrainerCacheTest, SlowTrainersReadEvictedElements) {
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<InfiniteRange>(),
+      std::make_unique<InMemoryEvictedElementStore>(/*capacity=*/50));
+  EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(0)));
+  EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(0)));
+  for (int i = 1; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  // The elements evicted from memory are still in the store.
+  for (int i = 1; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  for (int i = 20; i < 100; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  // When 99 is cached, the store holds the 50 elements before the ones in
+  // memory.
+  EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(Gt(44))));
+}
+
 TEST(CrossTrainerCacheTest, NewTrainersStartLate) {
   CrossTrainerCache<int64_t> cache(
       /*max_cache_size_bytes=*/5 * sizeof(int64_t),
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DATA_TRANSFER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DATA_TRANSFER_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -71,6 +72,19 @@ class DataTransferClient {
     absl::string_view protocol;
     std::string address;
     Allocator* allocator;
+    // If positive, elements of reads that are not coordinated are streamed
+    // from the server, with at most this many elements in flight per stream.
+    // Otherwise, each element is fetched with its own request. Clients that
+    // don't support streaming ignore this.
+    int64_t stream_window = 0;
+    // If true, the compression of uncompressed elements is chosen at runtime
+    // from the measured costs of reading them. Clients that don't support it
+    // ignore this.
+    bool adaptive_compression = false;
+    // If greater than 1, the server may batch up to this many elements of
+    // reads that are not coordinated in one response, which the client splits
+    // again. Clients that don't support batching ignore this.
+    int64_t max_batch_size = 0;
   };
   using ClientFactoryT =
       std::function<Status(Config, std::unique_ptr<DataTransferClient>*)>;
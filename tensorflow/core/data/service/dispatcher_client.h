@@ -67,6 +67,13 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
                   int64_t split_provider_index, Tensor& split,
                   bool& end_of_splits);
 
+  // Gets up to `max_splits` next splits for the specified iteration id,
+  // repetition, and split provider index. Returns at least one split unless
+  // `end_of_splits` is true.
+  Status GetSplits(int64_t iteration_id, int64_t repetition,
+                   int64_t split_provider_index, int64_t max_splits,
+                   std::vector<Tensor>& splits, bool& end_of_splits);
+
   // Gets the next split for the specified source of a stream of the snapshot in
   // `base_path`. If `end_of_splits` returns true, then there are no more splits
   // to be processed for the specified stream source.
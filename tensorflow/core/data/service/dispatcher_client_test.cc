@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
@@ -55,7 +56,9 @@ using ::tensorflow::data::testing::LocalTempFilename;
 using ::tensorflow::data::testing::RangeDataset;
 using ::tensorflow::testing::StatusIs;
 using ::testing::AllOf;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 
 constexpr const char kProtocol[] = "grpc";
 
@@ -332,6 +335,51 @@ TEST_F(DispatcherClientTest, EnableCrossTrainerCache) {
   EXPECT_TRUE(worker_heartbeat_response.new_tasks(0).use_cross_trainer_cache());
 }
 
+TEST_F(DispatcherClientTest, GetSplitsInBatches) {
+  TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/0));
+  DataServiceMetadata metadata = GetDefaultMetadata();
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id,
+                          RegisterDataset(RangeDataset(10), metadata));
+  ProcessingModeDef processing_mode;
+  processing_mode.set_sharding_policy(ProcessingModeDef::DYNAMIC);
+  int64_t job_id;
+  TF_ASSERT_OK(dispatcher_client_->GetOrCreateJob(
+      dataset_id, processing_mode, /*job_name=*/std::nullopt,
+      /*num_consumers=*/std::nullopt,
+      /*use_cross_trainer_cache=*/false, TARGET_WORKERS_AUTO, job_id));
+  int64_t iteration_client_id;
+  TF_ASSERT_OK(dispatcher_client_->GetOrCreateIteration(
+      job_id, /*repetition=*/0, iteration_client_id));
+  WorkerHeartbeatRequest worker_heartbeat_request;
+  worker_heartbeat_request.set_worker_address("localhost:0");
+  TF_ASSERT_OK_AND_ASSIGN(
+      WorkerHeartbeatResponse worker_heartbeat_response,
+      dispatcher_client_->WorkerHeartbeat(worker_heartbeat_request));
+  ASSERT_EQ(worker_heartbeat_response.new_tasks_size(), 1);
+  const int64_t iteration_id =
+      worker_heartbeat_response.new_tasks(0).iteration_id();
+
+  std::vector<int64_t> batch_sizes;
+  std::vector<int64_t> split_values;
+  while (true) {
+    std::vector<Tensor> splits;
+    bool end_of_splits = false;
+    TF_ASSERT_OK(dispatcher_client_->GetSplits(
+        iteration_id, /*repetition=*/0, /*split_provider_index=*/0,
+        /*max_splits=*/4, splits, end_of_splits));
+    if (end_of_splits) {
+      EXPECT_THAT(splits, IsEmpty());
+      break;
+    }
+    batch_sizes.push_back(splits.size());
+    for (const Tensor& split : splits) {
+      split_values.push_back(split.scalar<int64_t>()());
+    }
+  }
+  EXPECT_THAT(batch_sizes, ElementsAre(4, 4, 2));
+  EXPECT_THAT(split_values, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
 TEST_F(DispatcherClientTest, CreateNamedJob) {
   TF_ASSERT_OK(SetUpTfDataService(/*num_workers=*/1));
   DataServiceMetadata metadata = GetDefaultMetadata();
@@ -104,6 +104,7 @@ constexpr absl::Duration kDefaultIterationGcCheckInterval = absl::Minutes(10);
 constexpr absl::Duration kDefaultIterationGcTimeout = absl::Minutes(5);
 constexpr absl::Duration kDefaultClientTimeout = absl::Minutes(5);
 constexpr absl::Duration kDefaultWorkerTimeout = absl::Minutes(10);
+constexpr int64_t kDefaultJournalCheckpointIntervalBytes = 64 << 20;  // 64MB
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -183,6 +184,10 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
     new_config.set_worker_max_concurrent_snapshots(
         kDefaultWorkerMaxConcurrentSnapshots);
   }
+  if (new_config.journal_checkpoint_interval_bytes() == 0) {
+    new_config.set_journal_checkpoint_interval_bytes(
+        kDefaultJournalCheckpointIntervalBytes);
+  }
   return new_config;
 }
 }  // namespace
@@ -247,6 +252,7 @@ Status DataServiceDispatcherImpl::Start() {
     int64_t start = env_->NowMicros();
     while (!end_of_journal) {
       TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+      journal_bytes_since_checkpoint_ += update.ByteSizeLong();
       TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
     }
     absl::Duration duration = absl::Microseconds(env_->NowMicros() - start);
@@ -530,9 +536,10 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
   int64_t iteration_id = request->iteration_id();
   int64_t repetition = request->repetition();
   int64_t provider_index = request->split_provider_index();
+  int64_t max_splits = std::max<int64_t>(request->max_splits(), 1);
   VLOG(3) << "Received GetSplit request for iteration " << iteration_id
           << ", repetition " << repetition << ", split provider index "
-          << provider_index;
+          << provider_index << ", max splits " << max_splits;
   mutex_lock l(get_split_mu_);
   int64_t current_repetition = 0;
   SplitProvider* split_provider = nullptr;
@@ -563,20 +570,38 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
     // repetition.
     TF_RETURN_IF_ERROR(split_provider->Reset());
   }
-  Tensor split;
+  std::vector<Tensor> splits;
   bool end_of_splits = false;
-  TF_RETURN_IF_ERROR(split_provider->GetNext(&split, &end_of_splits));
-  TF_RETURN_IF_ERROR(RecordSplitProduced(iteration_id, repetition,
-                                         provider_index, end_of_splits));
-  response->set_end_of_splits(end_of_splits);
+  while (static_cast<int64_t>(splits.size()) < max_splits) {
+    Tensor split;
+    TF_RETURN_IF_ERROR(split_provider->GetNext(&split, &end_of_splits));
+    if (end_of_splits) {
+      break;
+    }
+    splits.push_back(std::move(split));
+  }
+  // A batch of splits is journaled as one update.
+  if (!splits.empty()) {
+    TF_RETURN_IF_ERROR(RecordSplitProduced(iteration_id, repetition,
+                                           provider_index, /*finished=*/false,
+                                           /*num_splits=*/splits.size()));
+  }
   if (end_of_splits) {
+    TF_RETURN_IF_ERROR(RecordSplitProduced(iteration_id, repetition,
+                                           provider_index, /*finished=*/true,
+                                           /*num_splits=*/0));
     // Reset the split provider to prepare for the next iteration.
     TF_RETURN_IF_ERROR(split_provider->Reset());
-  } else {
-    split.AsProtoTensorContent(response->mutable_split());
   }
-  VLOG(3) << "Returning from GetSplit, split=" << split
-          << ", end_of_splits=" << end_of_splits;
+  // If the split provider ended after some splits, the next request for this
+  // repetition returns `end_of_splits`.
+  response->set_end_of_splits(splits.empty());
+  for (size_t i = 0; i < splits.size(); ++i) {
+    splits[i].AsProtoTensorContent(i == 0 ? response->mutable_split()
+                                          : response->add_additional_splits());
+  }
+  VLOG(3) << "Returning from GetSplit, num_splits=" << splits.size()
+          << ", end_of_splits=" << response->end_of_splits();
   return absl::OkStatus();
 }
 
@@ -1158,6 +1183,11 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
     task_info->set_iteration_id(iteration->iteration_id);
     task_info->set_worker_uid(task->worker_uid);
     task_info->set_starting_round(task->starting_round);
+    std::optional<double> worker_throughput = auto_scaler_.GetWorkerThroughput(
+        iteration->iteration_id, task->worker_address);
+    if (worker_throughput.has_value()) {
+      task_info->set_worker_throughput(*worker_throughput);
+    }
   }
   response->set_iteration_finished(iteration->finished);
   response->set_deployment_mode(config_.deployment_mode());
@@ -1356,7 +1386,7 @@ Status DataServiceDispatcherImpl::CheckStarted() TF_LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceDispatcherImpl::RecordSplitProduced(
     int64_t iteration_id, int64_t repetition, int64_t split_provider_index,
-    bool finished) TF_LOCKS_EXCLUDED(mu_) {
+    bool finished, int64_t num_splits) TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   Update update;
   ProduceSplitUpdate* produce_split = update.mutable_produce_split();
@@ -1364,6 +1394,9 @@ Status DataServiceDispatcherImpl::RecordSplitProduced(
   produce_split->set_repetition(repetition);
   produce_split->set_split_provider_index(split_provider_index);
   produce_split->set_finished(finished);
+  if (num_splits > 1) {
+    produce_split->set_num_splits(num_splits);
+  }
   return Apply(update);
 }
 
@@ -1376,8 +1409,43 @@ Status DataServiceDispatcherImpl::Apply(const Update& update)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   if (journal_writer_.has_value()) {
     TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+    journal_bytes_since_checkpoint_ += update.ByteSizeLong();
   }
-  return state_.Apply(update);
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  MaybeCheckpointJournal();
+  return absl::OkStatus();
+}
+
+void DataServiceDispatcherImpl::MaybeCheckpointJournal()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Checkpoints are written at most once per their own size of journaled
+  // updates, so that writing them costs no more than the journaling itself.
+  if (!journal_writer_.has_value() ||
+      config_.journal_checkpoint_interval_bytes() < 0 ||
+      journal_bytes_since_checkpoint_ <
+          std::max(config_.journal_checkpoint_interval_bytes(),
+                   last_checkpoint_size_bytes_)) {
+    return;
+  }
+  int64_t start = env_->NowMicros();
+  std::vector<Update> checkpoint = state_.Checkpoint();
+  int64_t checkpoint_size_bytes = 0;
+  for (const auto& update : checkpoint) {
+    checkpoint_size_bytes += update.ByteSizeLong();
+  }
+  // On failure, the journal is still complete, and the next attempt is made
+  // after another interval.
+  journal_bytes_since_checkpoint_ = 0;
+  Status s = journal_writer_.value()->WriteCheckpoint(checkpoint);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write a checkpoint of the dispatcher journal: "
+                 << s;
+    return;
+  }
+  last_checkpoint_size_bytes_ = checkpoint_size_bytes;
+  VLOG(1) << "Wrote a " << checkpoint_size_bytes
+          << " byte checkpoint of the dispatcher journal in "
+          << absl::Microseconds(env_->NowMicros() - start) << ".";
 }
 
 void DataServiceDispatcherImpl::MaintenanceThread() {
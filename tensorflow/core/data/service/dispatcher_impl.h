@@ -310,16 +310,20 @@ class DataServiceDispatcherImpl {
   Status CheckStarted() TF_LOCKS_EXCLUDED(mu_);
   // Restores ongoing tf.data snapshots.
   absl::Status RestoreSnapshots();
-  // Records that a split was produced by a call to `GetSplit`.
+  // Records that `num_splits` splits were produced by a call to `GetSplit`, or
+  // that the split provider reached its end if `finished` is true.
   Status RecordSplitProduced(int64_t iteration_id, int64_t repetition,
-                             int64_t split_provider_index, bool finished)
-      TF_LOCKS_EXCLUDED(mu_);
+                             int64_t split_provider_index, bool finished,
+                             int64_t num_splits) TF_LOCKS_EXCLUDED(mu_);
   // Applies a state update, updating both the journal and the in-memory state.
   Status Apply(const Update& update) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Applies a state update, but doesn't update the journal. Only meant to be
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Replaces the journal with a checkpoint of `state_` once enough updates have
+  // been journaled since the last checkpoint.
+  void MaybeCheckpointJournal() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Removes the client with `client_id` from `auto_scaler_`
   void RemoveClientFromAutoScaler(int64_t client_id)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -391,6 +395,10 @@ class DataServiceDispatcherImpl {
 
   std::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
+  // Bytes of updates in the journal since the last checkpoint, which recovery
+  // needs to replay.
+  int64_t journal_bytes_since_checkpoint_ TF_GUARDED_BY(mu_) = 0;
+  int64_t last_checkpoint_size_bytes_ TF_GUARDED_BY(mu_) = 0;
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the gc thread.
   condition_variable maintenance_thread_cv_;
@@ -17,9 +17,11 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <optional>
+#include <queue>
 #include <string>
 #include <vector>
 
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -33,6 +35,20 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+// Sets the worker of a `CreateTaskUpdate` or `CreatePendingTaskUpdate`.
+template <class T>
+void SetTaskWorker(const DispatcherState::Task& task, T& update) {
+  update.set_worker_address(task.worker_address);
+  update.mutable_transfer_servers()->Add(task.transfer_servers.begin(),
+                                         task.transfer_servers.end());
+  update.mutable_worker_tags()->Add(task.worker_tags.begin(),
+                                    task.worker_tags.end());
+  update.set_worker_uid(task.worker_uid);
+}
+
+}  // namespace
 
 DispatcherState::DispatcherState()
     : worker_index_resolver_(std::vector<std::string>{}) {}
@@ -88,6 +104,12 @@ Status DispatcherState::Apply(const Update& update) {
     case Update::kCompressionDisabledAtRuntime:
       CompressionDisabledAtRuntime(update.compression_disabled_at_runtime());
       break;
+    case Update::kRestoreIteration:
+      RestoreIteration(update.restore_iteration());
+      break;
+    case Update::kNextAvailableIds:
+      NextAvailableIds(update.next_available_ids());
+      break;
     case Update::UPDATE_TYPE_NOT_SET:
       return errors::Internal("Update type not set.");
   }
@@ -110,6 +132,7 @@ void DispatcherState::RegisterWorker(
   std::string address = register_worker.worker_address();
   DCHECK(!workers_.contains(address));
   workers_[address] = std::make_shared<Worker>(register_worker);
+  workers_in_registration_order_.push_back(workers_[address]);
   tasks_by_worker_[address] =
       absl::flat_hash_map<int64_t, std::shared_ptr<Task>>();
   worker_index_resolver_.AddWorker(address);
@@ -187,7 +210,8 @@ void DispatcherState::ProduceSplit(const ProduceSplitUpdate& produce_split) {
     state.indices[provider_index] = 0;
     return;
   }
-  state.indices[provider_index]++;
+  state.indices[provider_index] +=
+      std::max<int64_t>(produce_split.num_splits(), 1);
 }
 
 void DispatcherState::AcquireIterationClient(
@@ -289,6 +313,7 @@ void DispatcherState::CreateTask(const CreateTaskUpdate& create_task) {
   auto& iteration = iterations_[create_task.iteration_id()];
   DCHECK_NE(iteration, nullptr);
   task = std::make_shared<Task>(create_task, iteration);
+  task->starting_round = create_task.starting_round();
   tasks_by_iteration_[create_task.iteration_id()].push_back(task);
   tasks_by_worker_[create_task.worker_address()][task->task_id] = task;
   next_available_task_id_ = std::max(next_available_task_id_, task_id + 1);
@@ -313,6 +338,184 @@ void DispatcherState::FinishTask(const FinishTaskUpdate& finish_task) {
   iterations_[task->iteration->iteration_id]->finished = all_finished;
 }
 
+void DispatcherState::RestoreIteration(
+    const RestoreIterationUpdate& restore_iteration) {
+  auto& iteration = iterations_[restore_iteration.iteration_id()];
+  DCHECK_NE(iteration, nullptr);
+  if (iteration->distributed_epoch_state.has_value()) {
+    DistributedEpochState& state = iteration->distributed_epoch_state.value();
+    DCHECK_EQ(restore_iteration.split_repetitions_size(),
+              state.repetitions.size());
+    DCHECK_EQ(restore_iteration.split_indices_size(), state.indices.size());
+    state.repetitions.assign(restore_iteration.split_repetitions().begin(),
+                             restore_iteration.split_repetitions().end());
+    state.indices.assign(restore_iteration.split_indices().begin(),
+                         restore_iteration.split_indices().end());
+  }
+  iteration->last_client_released_micros =
+      restore_iteration.last_client_released_micros();
+  iteration->finished = restore_iteration.finished();
+  iteration->garbage_collected = restore_iteration.garbage_collected();
+  if (!iteration->pending_tasks.empty()) {
+    PendingTask& task = iteration->pending_tasks.front();
+    task.failures = restore_iteration.pending_task_failures();
+    task.ready_consumers.clear();
+    task.ready_consumers.insert(
+        restore_iteration.pending_task_ready_consumers().begin(),
+        restore_iteration.pending_task_ready_consumers().end());
+  }
+}
+
+void DispatcherState::NextAvailableIds(
+    const NextAvailableIdsUpdate& next_available_ids) {
+  next_available_iteration_client_id_ =
+      std::max(next_available_iteration_client_id_,
+               next_available_ids.iteration_client_id());
+  next_available_task_id_ =
+      std::max(next_available_task_id_, next_available_ids.task_id());
+}
+
+std::vector<Update> DispatcherState::Checkpoint() const {
+  std::vector<Update> updates;
+  // Ordered maps keep checkpoints deterministic, and objects created before
+  // the objects that refer to them.
+  absl::btree_map<std::string, std::shared_ptr<const Dataset>> datasets(
+      datasets_by_id_.begin(), datasets_by_id_.end());
+  for (const auto& [dataset_id, dataset] : datasets) {
+    RegisterDatasetUpdate* register_dataset =
+        updates.emplace_back().mutable_register_dataset();
+    register_dataset->set_dataset_id(dataset_id);
+    *register_dataset->mutable_metadata() = dataset->metadata;
+  }
+  for (const auto& worker : workers_in_registration_order_) {
+    RegisterWorkerUpdate* register_worker =
+        updates.emplace_back().mutable_register_worker();
+    register_worker->set_worker_address(worker->address);
+    register_worker->mutable_transfer_servers()->Add(
+        worker->transfer_servers.begin(), worker->transfer_servers.end());
+    register_worker->mutable_worker_tags()->Add(worker->tags.begin(),
+                                                worker->tags.end());
+    register_worker->set_worker_uid(worker->uid);
+  }
+  absl::btree_map<int64_t, std::shared_ptr<const Job>> jobs(
+      jobs_by_id_.begin(), jobs_by_id_.end());
+  for (const auto& [job_id, job] : jobs) {
+    CreateJobUpdate* create_job = updates.emplace_back().mutable_create_job();
+    create_job->set_job_id(job_id);
+    create_job->set_job_name(job->job_name);
+    create_job->set_dataset_id(job->dataset_id);
+    *create_job->mutable_processing_mode_def() = job->processing_mode;
+    if (job->num_consumers.has_value()) {
+      create_job->set_num_consumers(job->num_consumers.value());
+    }
+    create_job->set_target_workers(job->target_workers);
+    create_job->set_use_cross_trainer_cache(job->use_cross_trainer_cache);
+  }
+  absl::btree_map<int64_t, std::shared_ptr<const Iteration>> iterations(
+      iterations_.begin(), iterations_.end());
+  for (const auto& [iteration_id, iteration] : iterations) {
+    // Each iteration is fully restored before the next one is created, which
+    // may reuse the key of a garbage collected iteration.
+    CreateIterationUpdate* create_iteration =
+        updates.emplace_back().mutable_create_iteration();
+    create_iteration->set_iteration_id(iteration_id);
+    create_iteration->set_job_id(iteration->job->id);
+    create_iteration->set_repetition(iteration->iteration_key.repetition);
+    if (iteration->distributed_epoch_state.has_value()) {
+      create_iteration->set_num_split_providers(
+          iteration->distributed_epoch_state->repetitions.size());
+    }
+    auto tasks = tasks_by_iteration_.find(iteration_id);
+    if (tasks != tasks_by_iteration_.end()) {
+      for (const auto& task : tasks->second) {
+        CreateTaskUpdate* create_task =
+            updates.emplace_back().mutable_create_task();
+        create_task->set_task_id(task->task_id);
+        create_task->set_iteration_id(iteration_id);
+        SetTaskWorker(*task, *create_task);
+        create_task->set_starting_round(task->starting_round);
+        if (task->finished) {
+          updates.emplace_back().mutable_finish_task()->set_task_id(
+              task->task_id);
+        }
+      }
+    }
+    std::queue<PendingTask> pending_tasks = iteration->pending_tasks;
+    for (; !pending_tasks.empty(); pending_tasks.pop()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      const Task& task = *pending_task.task;
+      CreatePendingTaskUpdate* create_pending_task =
+          updates.emplace_back().mutable_create_pending_task();
+      create_pending_task->set_task_id(task.task_id);
+      create_pending_task->set_iteration_id(iteration_id);
+      SetTaskWorker(task, *create_pending_task);
+      create_pending_task->set_starting_round(pending_task.target_round);
+      if (task.removed) {
+        updates.emplace_back().mutable_remove_task()->set_task_id(task.task_id);
+      }
+    }
+
+    RestoreIterationUpdate* restore_iteration =
+        updates.emplace_back().mutable_restore_iteration();
+    restore_iteration->set_iteration_id(iteration_id);
+    if (iteration->distributed_epoch_state.has_value()) {
+      const DistributedEpochState& state =
+          iteration->distributed_epoch_state.value();
+      restore_iteration->mutable_split_repetitions()->Add(
+          state.repetitions.begin(), state.repetitions.end());
+      restore_iteration->mutable_split_indices()->Add(state.indices.begin(),
+                                                      state.indices.end());
+    }
+    restore_iteration->set_last_client_released_micros(
+        iteration->last_client_released_micros);
+    restore_iteration->set_finished(iteration->finished);
+    restore_iteration->set_garbage_collected(iteration->garbage_collected);
+    if (!iteration->pending_tasks.empty()) {
+      const PendingTask& pending_task = iteration->pending_tasks.front();
+      restore_iteration->set_pending_task_failures(pending_task.failures);
+      restore_iteration->mutable_pending_task_ready_consumers()->Add(
+          pending_task.ready_consumers.begin(),
+          pending_task.ready_consumers.end());
+    }
+  }
+  absl::btree_map<int64_t, std::shared_ptr<const Iteration>> clients;
+  for (const auto& [iteration_client_id, iteration] :
+       iterations_for_client_ids_) {
+    // Lookups of unknown client ids leave null entries behind.
+    if (iteration != nullptr) {
+      clients[iteration_client_id] = iteration;
+    }
+  }
+  for (const auto& [iteration_client_id, iteration] : clients) {
+    AcquireIterationClientUpdate* acquire_iteration_client =
+        updates.emplace_back().mutable_acquire_iteration_client();
+    acquire_iteration_client->set_iteration_id(iteration->iteration_id);
+    acquire_iteration_client->set_iteration_client_id(iteration_client_id);
+  }
+  absl::btree_map<std::string, bool> compression_disabled_at_runtime(
+      compression_disabled_at_runtime_.begin(),
+      compression_disabled_at_runtime_.end());
+  for (const auto& [dataset_id, compression_disabled] :
+       compression_disabled_at_runtime) {
+    CompressionDisabledAtRuntimeUpdate* update =
+        updates.emplace_back().mutable_compression_disabled_at_runtime();
+    update->set_dataset_id(dataset_id);
+    update->set_compression_disabled(compression_disabled);
+  }
+  std::vector<std::string> snapshot_paths(snapshot_paths_.begin(),
+                                          snapshot_paths_.end());
+  std::sort(snapshot_paths.begin(), snapshot_paths.end());
+  for (const auto& path : snapshot_paths) {
+    updates.emplace_back().mutable_snapshot()->set_path(path);
+  }
+  NextAvailableIdsUpdate* next_available_ids =
+      updates.emplace_back().mutable_next_available_ids();
+  next_available_ids->set_iteration_client_id(
+      next_available_iteration_client_id_);
+  next_available_ids->set_task_id(next_available_task_id_);
+  return updates;
+}
+
 std::string DispatcherState::NextAvailableDatasetId() const {
   return absl::StrCat(next_available_dataset_id_);
 }
@@ -73,6 +73,12 @@ class DispatcherState {
   // Applies the given update to the dispatcher's state.
   Status Apply(const Update& update);
 
+  // Returns updates which rebuild the current state when applied to a new
+  // dispatcher state. Their size is proportional to the size of the state,
+  // rather than to the number of updates applied so far, so they can replace
+  // the journal.
+  std::vector<Update> Checkpoint() const;
+
   // A dataset registered with the dispatcher.
   struct Dataset {
     explicit Dataset(const std::string& dataset_id,
@@ -325,6 +331,8 @@ class DispatcherState {
   void Snapshot(const SnapshotUpdate& snapshot);
   void CompressionDisabledAtRuntime(const CompressionDisabledAtRuntimeUpdate&
                                         compression_disabled_at_runtime);
+  void RestoreIteration(const RestoreIterationUpdate& restore_iteration);
+  void NextAvailableIds(const NextAvailableIdsUpdate& next_available_ids);
 
   // Updates the next available dataset ID.
   void UpdateNextAvailableDatasetId();
@@ -335,6 +343,9 @@ class DispatcherState {
 
   // Registered workers, keyed by address.
   absl::flat_hash_map<std::string, std::shared_ptr<Worker>> workers_;
+  // Registered workers, in registration order. Checkpoints register workers in
+  // the same order, so that they resolve to the same worker indices.
+  std::vector<std::shared_ptr<Worker>> workers_in_registration_order_;
 
   // Assigns an index to each worker according to worker addresses list
   // specified in the dispatcher config.
@@ -134,6 +134,24 @@ Status Snapshot(const std::string& path, DispatcherState& state) {
   return state.Apply(update);
 }
 
+Status ProduceSplit(int64_t iteration_id, int64_t repetition, bool finished,
+                    DispatcherState& state) {
+  Update update;
+  ProduceSplitUpdate* produce_split = update.mutable_produce_split();
+  produce_split->set_iteration_id(iteration_id);
+  produce_split->set_repetition(repetition);
+  produce_split->set_finished(finished);
+  return state.Apply(update);
+}
+
+Status RestoreFromCheckpoint(const DispatcherState& state,
+                             DispatcherState& restored_state) {
+  for (const Update& update : state.Checkpoint()) {
+    TF_RETURN_IF_ERROR(restored_state.Apply(update));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 TEST(DispatcherState, RegisterDataset) {
@@ -652,5 +670,157 @@ TEST(DispatcherState, GetNumberOfRegisteredWorkers) {
   EXPECT_EQ(state.GetNumberOfRegisteredWorkers(), 2);
 }
 
+TEST(DispatcherState, ProduceSplitBatch) {
+  std::string dataset_id = "dataset_id";
+  int64_t job_id = 5;
+  int64_t iteration_id = 3;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  Update create_job;
+  create_job.mutable_create_job()->set_job_id(job_id);
+  create_job.mutable_create_job()->set_job_name("job_name");
+  create_job.mutable_create_job()->set_dataset_id(dataset_id);
+  create_job.mutable_create_job()
+      ->mutable_processing_mode_def()
+      ->set_sharding_policy(ProcessingModeDef::DYNAMIC);
+  TF_EXPECT_OK(state.Apply(create_job));
+  Update create_iteration;
+  create_iteration.mutable_create_iteration()->set_iteration_id(iteration_id);
+  create_iteration.mutable_create_iteration()->set_job_id(job_id);
+  create_iteration.mutable_create_iteration()->set_num_split_providers(1);
+  TF_EXPECT_OK(state.Apply(create_iteration));
+  Update produce_splits;
+  produce_splits.mutable_produce_split()->set_iteration_id(iteration_id);
+  produce_splits.mutable_produce_split()->set_num_splits(5);
+  TF_EXPECT_OK(state.Apply(produce_splits));
+  TF_EXPECT_OK(ProduceSplit(iteration_id, /*repetition=*/0,
+                            /*finished=*/false, state));
+
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(state.IterationFromId(iteration_id, iteration));
+  EXPECT_EQ(iteration->distributed_epoch_state->indices[0], 6);
+}
+
+TEST(DispatcherState, CheckpointRestoresTasksAndClients) {
+  std::string dataset_id = "dataset_id";
+  std::string worker_address = "worker_address";
+  int64_t iteration_id = 3;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  TF_EXPECT_OK(RegisterWorker(worker_address, state));
+  TF_EXPECT_OK(CreateIteration(iteration_id, dataset_id, state));
+  TF_EXPECT_OK(CreateTask(/*task_id=*/8, iteration_id, worker_address, state));
+  TF_EXPECT_OK(CreateTask(/*task_id=*/9, iteration_id, worker_address, state));
+  TF_EXPECT_OK(CreateTask(/*task_id=*/10, iteration_id, worker_address, state));
+  TF_EXPECT_OK(FinishTask(/*task_id=*/9, state));
+  Update remove_task;
+  remove_task.mutable_remove_task()->set_task_id(10);
+  TF_EXPECT_OK(state.Apply(remove_task));
+  TF_EXPECT_OK(AcquireIterationClientId(iteration_id, 6, state));
+  TF_EXPECT_OK(AcquireIterationClientId(iteration_id, 7, state));
+  TF_EXPECT_OK(ReleaseIterationClientId(7, /*release_time=*/100, state));
+  TF_EXPECT_OK(Snapshot("snapshot_path", state));
+
+  DispatcherState restored_state;
+  TF_ASSERT_OK(RestoreFromCheckpoint(state, restored_state));
+  std::shared_ptr<const Dataset> dataset;
+  TF_EXPECT_OK(restored_state.DatasetFromId(dataset_id, dataset));
+  EXPECT_EQ(restored_state.NextAvailableDatasetId(),
+            state.NextAvailableDatasetId());
+  EXPECT_EQ(restored_state.GetNumberOfRegisteredWorkers(), 1);
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(restored_state.IterationFromId(iteration_id, iteration));
+  EXPECT_EQ(iteration->num_clients, 1);
+  EXPECT_EQ(iteration->last_client_released_micros, 100);
+  EXPECT_FALSE(iteration->finished);
+  EXPECT_THAT(restored_state.ListActiveClientIds(), UnorderedElementsAre(6));
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_EXPECT_OK(restored_state.TasksForIteration(iteration_id, tasks));
+  EXPECT_THAT(tasks, SizeIs(2));
+  TF_EXPECT_OK(restored_state.TasksForWorker(worker_address, tasks));
+  ASSERT_THAT(tasks, SizeIs(1));
+  EXPECT_EQ(tasks[0]->task_id, 8);
+  std::shared_ptr<const Task> task;
+  EXPECT_THAT(restored_state.TaskFromId(10, task),
+              StatusIs(error::NOT_FOUND));
+  EXPECT_EQ(restored_state.NextAvailableTaskId(), state.NextAvailableTaskId());
+  EXPECT_EQ(restored_state.NextAvailableIterationClientId(),
+            state.NextAvailableIterationClientId());
+  EXPECT_EQ(restored_state.ListSnapshotPaths(), state.ListSnapshotPaths());
+}
+
+TEST(DispatcherState, CheckpointRestoresSplitsAndGarbageCollection) {
+  std::string dataset_id = "dataset_id";
+  int64_t job_id = 5;
+  int64_t iteration_id = 3;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  Update create_job;
+  create_job.mutable_create_job()->set_job_id(job_id);
+  create_job.mutable_create_job()->set_job_name("job_name");
+  create_job.mutable_create_job()->set_dataset_id(dataset_id);
+  create_job.mutable_create_job()
+      ->mutable_processing_mode_def()
+      ->set_sharding_policy(ProcessingModeDef::DYNAMIC);
+  TF_EXPECT_OK(state.Apply(create_job));
+  Update create_iteration;
+  create_iteration.mutable_create_iteration()->set_iteration_id(iteration_id);
+  create_iteration.mutable_create_iteration()->set_job_id(job_id);
+  create_iteration.mutable_create_iteration()->set_num_split_providers(1);
+  TF_EXPECT_OK(state.Apply(create_iteration));
+  TF_EXPECT_OK(ProduceSplit(iteration_id, /*repetition=*/0,
+                            /*finished=*/false, state));
+  TF_EXPECT_OK(ProduceSplit(iteration_id, /*repetition=*/0,
+                            /*finished=*/true, state));
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(ProduceSplit(iteration_id, /*repetition=*/1,
+                              /*finished=*/false, state));
+  }
+  Update garbage_collect;
+  garbage_collect.mutable_garbage_collect_iteration()->set_iteration_id(
+      iteration_id);
+  TF_EXPECT_OK(state.Apply(garbage_collect));
+
+  DispatcherState restored_state;
+  TF_ASSERT_OK(RestoreFromCheckpoint(state, restored_state));
+  std::shared_ptr<const Job> job;
+  TF_ASSERT_OK(restored_state.JobByName("job_name", job));
+  EXPECT_EQ(job->processing_mode.sharding_policy(), ProcessingModeDef::DYNAMIC);
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(restored_state.IterationByKey(IterationKey("job_name", 0),
+                                             iteration));
+  EXPECT_EQ(iteration->iteration_id, iteration_id);
+  ASSERT_TRUE(iteration->distributed_epoch_state.has_value());
+  EXPECT_EQ(iteration->distributed_epoch_state->repetitions[0], 1);
+  EXPECT_EQ(iteration->distributed_epoch_state->indices[0], 3);
+  EXPECT_TRUE(iteration->finished);
+  EXPECT_TRUE(iteration->garbage_collected);
+  EXPECT_EQ(restored_state.NextAvailableJobId(), state.NextAvailableJobId());
+  EXPECT_EQ(restored_state.NextAvailableIterationId(),
+            state.NextAvailableIterationId());
+}
+
+TEST(DispatcherState, CheckpointOfCheckpointIsUnchanged) {
+  std::string dataset_id = "dataset_id";
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, state));
+  TF_EXPECT_OK(RegisterWorker("worker_1", state));
+  TF_EXPECT_OK(RegisterWorker("worker_2", state));
+  TF_EXPECT_OK(CreateIteration(/*iteration_id=*/3, dataset_id, state));
+  TF_EXPECT_OK(
+      CreateTask(/*task_id=*/8, /*iteration_id=*/3, "worker_2", state));
+  TF_EXPECT_OK(AcquireIterationClientId(/*iteration_id=*/3, 6, state));
+
+  DispatcherState restored_state;
+  TF_ASSERT_OK(RestoreFromCheckpoint(state, restored_state));
+  std::vector<Update> checkpoint = state.Checkpoint();
+  std::vector<Update> restored_checkpoint = restored_state.Checkpoint();
+  ASSERT_EQ(restored_checkpoint.size(), checkpoint.size());
+  for (int i = 0; i < checkpoint.size(); ++i) {
+    EXPECT_EQ(restored_checkpoint[i].SerializeAsString(),
+              checkpoint[i].SerializeAsString());
+  }
+}
+
 }  // namespace data
 }  // namespace tensorflow
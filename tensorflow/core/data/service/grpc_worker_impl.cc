@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/grpc_worker_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "grpcpp/server_builder.h"
 #include "grpcpp/server_context.h"
+#include "grpcpp/support/sync_stream.h"
 #include "tensorflow/core/data/service/export.pb.h"
 #include "tensorflow/core/data/service/worker_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
@@ -33,6 +35,7 @@ namespace data {
 
 using ::grpc::ServerBuilder;
 using ::grpc::ServerContext;
+using ::grpc::ServerReaderWriter;
 
 GrpcWorkerImpl::GrpcWorkerImpl(const experimental::WorkerConfig& config,
                                ServerBuilder& server_builder)
@@ -71,5 +74,44 @@ HANDLER(GetWorkerTasks);
 HANDLER(GetSnapshotTaskProgresses);
 #undef HANDLER
 
+::grpc::Status GrpcWorkerImpl::GetElementStream(
+    ServerContext* context,
+    ServerReaderWriter<GetElementResponse, GetElementStreamRequest>* stream) {
+  GetElementStreamRequest stream_request;
+  if (!stream->Read(&stream_request) || !stream_request.has_request()) {
+    return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT,
+                          "The first message of an element stream must hold "
+                          "the element request.");
+  }
+  GetElementRequest request = stream_request.request();
+  if (request.has_round_index()) {
+    return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT,
+                          "Coordinated reads do not support element streams.");
+  }
+  request.set_allow_skip(false);
+  int64_t credits = stream_request.credits();
+  while (!context->IsCancelled()) {
+    // Only wait for more credits once the granted ones have been used, so
+    // that credit messages don't delay the production of elements.
+    while (credits <= 0) {
+      if (!stream->Read(&stream_request)) {
+        return ::grpc::Status::OK;
+      }
+      credits += stream_request.credits();
+    }
+    GetElementResponse response;
+    if (Status s = impl_->GetElement(&request, &response); !s.ok()) {
+      return ToGrpcStatus(s);
+    }
+    const bool end_of_sequence = response.end_of_sequence();
+    if (!stream->Write(response) || end_of_sequence) {
+      return ::grpc::Status::OK;
+    }
+    --credits;
+  }
+  return ::grpc::Status(::grpc::StatusCode::CANCELLED,
+                        "The element stream was cancelled.");
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -64,6 +64,11 @@ class GrpcWorkerImpl : public WorkerService::Service {
   HANDLER(GetSnapshotTaskProgresses);
 #undef HANDLER
 
+  ::grpc::Status GetElementStream(
+      ::grpc::ServerContext* context,
+      ::grpc::ServerReaderWriter<GetElementResponse, GetElementStreamRequest>*
+          stream) override;
+
  private:
   std::string worker_address_;
   // A std::shared_ptr allows clients to access local servers and directly call
@@ -16,12 +16,15 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -35,6 +38,9 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kCheckpoint = "checkpoint";
+// Suffix of checkpoints which are still being written.
+constexpr StringPiece kTempSuffix = ".tmp";
 
 Status ParseSequenceNumber(const std::string& journal_file,
                            int64_t* sequence_number) {
@@ -44,6 +50,40 @@ Status ParseSequenceNumber(const std::string& journal_file,
   }
   return absl::OkStatus();
 }
+
+// Lists the sequence numbers of the journal files and of the checkpoints in
+// `journal_dir`, in increasing order.
+Status ListJournalDir(Env* env, const std::string& journal_dir,
+                      std::vector<int64_t>& journal_files,
+                      std::vector<int64_t>& checkpoints) {
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &children));
+  for (const auto& file : children) {
+    if (absl::EndsWith(file, kTempSuffix)) {
+      // Left behind by a dispatcher which failed while writing a checkpoint.
+      continue;
+    }
+    int64_t sequence_number;
+    TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
+    if (absl::StartsWith(file, kCheckpoint)) {
+      checkpoints.push_back(sequence_number);
+    } else {
+      journal_files.push_back(sequence_number);
+    }
+  }
+  std::sort(journal_files.begin(), journal_files.end());
+  std::sort(checkpoints.begin(), checkpoints.end());
+  return absl::OkStatus();
+}
+
+Status WriteUpdate(const Update& update, io::RecordWriter& writer) {
+  std::string s = update.SerializeAsString();
+  if (s.empty()) {
+    return errors::Internal("Failed to serialize update ", update.DebugString(),
+                            " to string");
+  }
+  return writer.WriteRecord(s);
+}
 }  // namespace
 
 std::string DataServiceJournalFile(const std::string& journal_dir,
@@ -52,6 +92,12 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DataServiceJournalCheckpointFile(const std::string& journal_dir,
+                                             int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kCheckpoint, "_", sequence_number));
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -59,31 +105,41 @@ Status FileJournalWriter::EnsureInitialized() {
   if (writer_) {
     return absl::OkStatus();
   }
-  std::vector<std::string> journal_files;
+  std::vector<int64_t> journal_files;
+  std::vector<int64_t> checkpoints;
   TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(journal_dir_));
-  TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
-  int64_t latest_sequence_number = -1;
-  for (const auto& file : journal_files) {
-    int64_t sequence_number;
-    TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
-    latest_sequence_number = std::max(latest_sequence_number, sequence_number);
+  TF_RETURN_IF_ERROR(
+      ListJournalDir(env_, journal_dir_, journal_files, checkpoints));
+  int64_t sequence_number = 0;
+  if (!journal_files.empty()) {
+    sequence_number = journal_files.back() + 1;
+  }
+  if (!checkpoints.empty()) {
+    // The journal file which follows the latest checkpoint may not have been
+    // created yet.
+    sequence_number = std::max(sequence_number, checkpoints.back());
+  }
+  return OpenFile(sequence_number);
+}
+
+Status FileJournalWriter::OpenFile(int64_t sequence_number) {
+  if (writer_) {
+    TF_RETURN_IF_ERROR(writer_->Close());
+    writer_ = nullptr;
+    TF_RETURN_IF_ERROR(file_->Close());
   }
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = std::make_unique<io::RecordWriter>(file_.get());
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return absl::OkStatus();
 }
 
 Status FileJournalWriter::Write(const Update& update) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
-  std::string s = update.SerializeAsString();
-  if (s.empty()) {
-    return errors::Internal("Failed to serialize update ", update.DebugString(),
-                            " to string");
-  }
-  TF_RETURN_IF_ERROR(writer_->WriteRecord(s));
+  TF_RETURN_IF_ERROR(WriteUpdate(update, *writer_));
   TF_RETURN_IF_ERROR(writer_->Flush());
   TF_RETURN_IF_ERROR(file_->Sync());
   if (VLOG_IS_ON(4)) {
@@ -92,6 +148,61 @@ Status FileJournalWriter::Write(const Update& update) {
   return absl::OkStatus();
 }
 
+Status FileJournalWriter::WriteCheckpoint(const std::vector<Update>& updates) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  const int64_t sequence_number = sequence_number_ + 1;
+  const std::string checkpoint_file =
+      DataServiceJournalCheckpointFile(journal_dir_, sequence_number);
+  // Write to a temporary file first, so that the checkpoint only replaces the
+  // journal once it is complete.
+  const std::string temp_file = absl::StrCat(checkpoint_file, kTempSuffix);
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(temp_file, &file));
+    io::RecordWriter writer(file.get());
+    for (const auto& update : updates) {
+      TF_RETURN_IF_ERROR(WriteUpdate(update, writer));
+    }
+    TF_RETURN_IF_ERROR(writer.Close());
+    TF_RETURN_IF_ERROR(file->Sync());
+    TF_RETURN_IF_ERROR(file->Close());
+  }
+  TF_RETURN_IF_ERROR(env_->RenameFile(temp_file, checkpoint_file));
+  TF_RETURN_IF_ERROR(OpenFile(sequence_number));
+  VLOG(1) << "Wrote journal checkpoint with " << updates.size()
+          << " updates to " << checkpoint_file;
+  DeleteFilesBefore(sequence_number);
+  return absl::OkStatus();
+}
+
+void FileJournalWriter::DeleteFilesBefore(int64_t sequence_number) {
+  std::vector<int64_t> journal_files;
+  std::vector<int64_t> checkpoints;
+  Status s = ListJournalDir(env_, journal_dir_, journal_files, checkpoints);
+  std::vector<std::string> files_to_delete;
+  for (int64_t journal_file : journal_files) {
+    if (journal_file < sequence_number) {
+      files_to_delete.push_back(
+          DataServiceJournalFile(journal_dir_, journal_file));
+    }
+  }
+  for (int64_t checkpoint : checkpoints) {
+    if (checkpoint < sequence_number) {
+      files_to_delete.push_back(
+          DataServiceJournalCheckpointFile(journal_dir_, checkpoint));
+    }
+  }
+  for (const auto& file : files_to_delete) {
+    s.Update(env_->DeleteFile(file));
+  }
+  // Recovery never reads these files again, so they are deleted again after
+  // the next checkpoint if this fails.
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete journal files replaced by checkpoint "
+                 << sequence_number << " in " << journal_dir_ << ": " << s;
+  }
+}
+
 FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -99,6 +210,16 @@ Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return absl::OkStatus();
   }
+  std::vector<int64_t> journal_files;
+  std::vector<int64_t> checkpoints;
+  TF_RETURN_IF_ERROR(
+      ListJournalDir(env_, journal_dir_, journal_files, checkpoints));
+  if (!checkpoints.empty()) {
+    sequence_number_ = checkpoints.back();
+    reading_checkpoint_ = true;
+    return UpdateFile(
+        DataServiceJournalCheckpointFile(journal_dir_, sequence_number_));
+  }
   return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
 }
 
@@ -108,7 +229,11 @@ Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
     tstring record;
     Status s = reader_->ReadRecord(&record);
     if (absl::IsOutOfRange(s)) {
-      sequence_number_++;
+      if (reading_checkpoint_) {
+        reading_checkpoint_ = false;
+      } else {
+        sequence_number_++;
+      }
       std::string next_journal_file =
           DataServiceJournalFile(journal_dir_, sequence_number_);
       if (absl::IsNotFound(env_->FileExists(next_journal_file))) {
@@ -15,8 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -31,6 +33,11 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the checkpoint which precedes the journal file with
+// `sequence_number`.
+std::string DataServiceJournalCheckpointFile(const std::string& journal_dir,
+                                             int64_t sequence_number);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
@@ -39,6 +46,10 @@ class JournalWriter {
   virtual Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
+  // Writes and syncs a checkpoint of `updates`, which must rebuild the state
+  // built by all updates written so far. The journal then starts from the
+  // checkpoint, and the updates written before it are discarded.
+  virtual Status WriteCheckpoint(const std::vector<Update>& updates) = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -57,6 +68,12 @@ class JournalWriter {
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
 // can be stored durably in case of machine failure.
+//
+// A checkpoint closes the current journal file. It is written to
+// "checkpoint_<n>", where n is the sequence number of the next journal file,
+// after which the older journal files and checkpoints are deleted. For example,
+// a checkpoint written while writing to "journal_3" leaves "checkpoint_4" and
+// then "journal_4" in the directory.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -68,10 +85,20 @@ class FileJournalWriter : public JournalWriter {
 
   Status Write(const Update& update) override;
   Status EnsureInitialized() override;
+  Status WriteCheckpoint(const std::vector<Update>& updates) override;
 
  private:
+  // Closes the current journal file, if any, and opens the journal file with
+  // `sequence_number`.
+  Status OpenFile(int64_t sequence_number);
+  // Deletes the journal files and checkpoints that precede the checkpoint
+  // with `sequence_number`.
+  void DeleteFilesBefore(int64_t sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of current journal file.
+  int64_t sequence_number_ = -1;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -89,7 +116,9 @@ class JournalReader {
 // used by multiple threads.
 //
 // The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// directory, in order of their sequence numbers. If the directory has
+// checkpoints, the reader starts from the latest one and reads the journal
+// files that follow it. See FileJournalWriter above.
 class FileJournalReader : public JournalReader {
  public:
   explicit FileJournalReader(Env* env, StringPiece journal_dir);
@@ -108,6 +137,9 @@ class FileJournalReader : public JournalReader {
   const std::string journal_dir_;
   // Sequence number of current journal file.
   int64_t sequence_number_ = 0;
+  // Whether the current file is the checkpoint which precedes the journal file
+  // with `sequence_number_`.
+  bool reading_checkpoint_ = false;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::SequentialRecordReader> reader_;
 };
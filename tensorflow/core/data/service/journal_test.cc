@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -33,6 +34,7 @@ namespace data {
 
 namespace {
 using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
 
 bool NewJournalDir(std::string& journal_dir) {
   std::string filename = testing::TmpDir();
@@ -165,5 +167,62 @@ TEST(Journal, InvalidRecordData) {
   EXPECT_THAT(s.message(), HasSubstr("Failed to parse journal record"));
   EXPECT_EQ(s.code(), error::DATA_LOSS);
 }
+
+TEST(Journal, CheckpointReplacesEarlierUpdates) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+  TF_EXPECT_OK(writer.WriteCheckpoint({MakeRegisterDatasetUpdate()}));
+  TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeRegisterDatasetUpdate(), MakeCreateIterationUpdate()}));
+  std::vector<std::string> files;
+  TF_ASSERT_OK(Env::Default()->GetChildren(journal_dir, &files));
+  EXPECT_THAT(files, UnorderedElementsAre("checkpoint_1", "journal_1"));
+}
+
+TEST(Journal, AppendAfterCheckpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+    TF_EXPECT_OK(writer.WriteCheckpoint({MakeRegisterDatasetUpdate()}));
+  }
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+  }
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_EXPECT_OK(writer.WriteCheckpoint(
+        {MakeRegisterDatasetUpdate(), MakeFinishTaskUpdate()}));
+    TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+  }
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeRegisterDatasetUpdate(), MakeFinishTaskUpdate(),
+                    MakeCreateIterationUpdate()}));
+}
+
+TEST(Journal, IgnoresIncompleteCheckpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  std::vector<Update> updates = {MakeCreateIterationUpdate(),
+                                 MakeFinishTaskUpdate()};
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  for (const auto& update : updates) {
+    TF_EXPECT_OK(writer.Write(update));
+  }
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(),
+      absl::StrCat(DataServiceJournalCheckpointFile(journal_dir, 1), ".tmp"),
+      "incomplete checkpoint"));
+
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
+}
 }  // namespace data
 }  // namespace tensorflow
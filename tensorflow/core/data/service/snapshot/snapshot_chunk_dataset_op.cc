@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
@@ -20,6 +21,7 @@ limitations under the License.
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/data/utils.h"
@@ -29,6 +31,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/path.h"
 #include "tsl/platform/tstring.h"
@@ -45,6 +49,9 @@ constexpr const char* const kOutputShapes = "output_shapes";
 constexpr const char* const kSnapshotChunkDataset = "SnapshotChunkDataset";
 
 constexpr int64_t kTFRecordReaderOutputBufferSize = 512 << 20;  // 512MB
+constexpr char kSnapshotChunkReadahead[] = "snapshot_chunk_readahead";
+// The bytes of elements that are buffered for each chunk that is read ahead.
+constexpr int64_t kReadaheadBufferBytes = 8LL << 20;  // 8MB.
 
 absl::string_view GetSnapshotPath(absl::string_view chunk_file) {
   // Snapshot chunks are placed in snapshot_path/chunks/chunk_x.
@@ -52,6 +59,95 @@ absl::string_view GetSnapshotPath(absl::string_view chunk_file) {
   return tsl::io::Dirname(chunk_dir);
 }
 
+// Reads the elements of one chunk on a background thread into a bounded
+// buffer, from which `GetNext()` returns them in order. Records are read,
+// decompressed, and parsed on the background thread.
+class ChunkReadahead {
+ public:
+  explicit ChunkReadahead(
+      std::unique_ptr<snapshot_util::TFRecordReader> reader)
+      : reader_(std::move(reader)) {}
+
+  ~ChunkReadahead() {
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+    }
+    cond_var_.notify_all();
+    thread_.reset();
+  }
+
+  void Start(IteratorContext* ctx) {
+    thread_ = ctx->StartThread("tf_data_snapshot_chunk_readahead",
+                               [this]() { Read(); });
+  }
+
+  // Blocks until the next element of the chunk is available. Returns
+  // `OutOfRange` at the end of the chunk, or the error that ended reading it.
+  absl::Status GetNext(std::vector<Tensor>* element) {
+    mutex_lock l(mu_);
+    while (elements_.empty() && !done_) {
+      cond_var_.wait(l);
+    }
+    if (elements_.empty()) {
+      return status_;
+    }
+    *element = std::move(elements_.front().first);
+    buffered_bytes_ -= elements_.front().second;
+    elements_.pop_front();
+    cond_var_.notify_all();
+    return absl::OkStatus();
+  }
+
+  uint64_t BytesRead() {
+    mutex_lock l(mu_);
+    return bytes_read_;
+  }
+
+ private:
+  void Read() {
+    absl::Status s;
+    while (true) {
+      std::vector<Tensor> element;
+      s = reader_->ReadTensors(&element);
+      if (!s.ok()) break;
+      int64_t element_bytes = 0;
+      for (const Tensor& tensor : element) {
+        element_bytes += tensor.TotalBytes();
+      }
+      mutex_lock l(mu_);
+      while (!cancelled_ && buffered_bytes_ >= kReadaheadBufferBytes) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) return;
+      bytes_read_ = reader_->BytesRead();
+      buffered_bytes_ += element_bytes;
+      elements_.emplace_back(std::move(element), element_bytes);
+      cond_var_.notify_all();
+    }
+    mutex_lock l(mu_);
+    bytes_read_ = reader_->BytesRead();
+    status_ = s;
+    done_ = true;
+    cond_var_.notify_all();
+  }
+
+  // Only used by the background thread.
+  const std::unique_ptr<snapshot_util::TFRecordReader> reader_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  // Elements that have been read but not consumed, with their sizes.
+  std::deque<std::pair<std::vector<Tensor>, int64_t>> elements_
+      TF_GUARDED_BY(mu_);
+  int64_t buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t bytes_read_ TF_GUARDED_BY(mu_) = 0;
+  bool done_ TF_GUARDED_BY(mu_) = false;
+  absl::Status status_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+};
+
 // A reader dataset is responsible for reading one chunk file of a snapshot.
 // TODO(b/250921378): Merge this with `snapshot_util::Reader::Dataset`.
 class SnapshotChunkDatasetOp : public DatasetOpKernel {
@@ -77,7 +173,8 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
         chunk_file_(chunk_file),
         compression_(compression),
         dtypes_(dtypes),
-        shapes_(shapes) {}
+        shapes_(shapes),
+        readahead_(GetExperiments().contains(kSnapshotChunkReadahead)) {}
 
   const DataTypeVector& output_dtypes() const override { return dtypes_; }
 
@@ -128,10 +225,9 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     ~Iterator() override { RecordBytesRead(); }
 
     absl::Status Initialize(IteratorContext* ctx) override {
-      reader_ = std::make_unique<snapshot_util::TFRecordReader>(
-          TranslateFileName(dataset()->chunk_file_), dataset()->compression_,
-          dataset()->dtypes_, kTFRecordReaderOutputBufferSize);
-      return reader_->Initialize(ctx->env());
+      TF_RETURN_IF_ERROR(InitializeReader(ctx));
+      MaybeStartReadahead(ctx);
+      return absl::OkStatus();
     }
 
    protected:
@@ -139,7 +235,9 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) override {
       *end_of_sequence = false;
-      absl::Status status = reader_->ReadTensors(out_tensors);
+      absl::Status status = readahead_ != nullptr
+                                ? readahead_->GetNext(out_tensors)
+                                : reader_->ReadTensors(out_tensors);
       if (absl::IsOutOfRange(status)) {
         *end_of_sequence = true;
         return absl::OkStatus();
@@ -162,11 +260,31 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
                                  IteratorStateReader* reader) override {
       TF_RETURN_IF_ERROR(
           reader->ReadScalar(full_name(kStartIndex), &start_index_));
-      TF_RETURN_IF_ERROR(Initialize(ctx));
-      return AdvanceToStartIndex(ctx);
+      readahead_.reset();
+      TF_RETURN_IF_ERROR(InitializeReader(ctx));
+      TF_RETURN_IF_ERROR(AdvanceToStartIndex(ctx));
+      MaybeStartReadahead(ctx);
+      return absl::OkStatus();
     }
 
    private:
+    absl::Status InitializeReader(IteratorContext* ctx) {
+      reader_ = std::make_unique<snapshot_util::TFRecordReader>(
+          TranslateFileName(dataset()->chunk_file_), dataset()->compression_,
+          dataset()->dtypes_, kTFRecordReaderOutputBufferSize);
+      return reader_->Initialize(ctx->env());
+    }
+
+    // If the dataset reads ahead, hands `reader_` over to a `ChunkReadahead`
+    // that reads from the current position.
+    void MaybeStartReadahead(IteratorContext* ctx) {
+      if (!dataset()->readahead_) {
+        return;
+      }
+      readahead_ = std::make_unique<ChunkReadahead>(std::move(reader_));
+      readahead_->Start(ctx);
+    }
+
     // TODO(b/250921378): Optimize this to not parse every single element. We
     // may consider switching the data format to ArrayRecords so we can use the
     // index to jump straight to the starting record.
@@ -179,12 +297,16 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     }
 
     void RecordBytesRead() {
-      uint64_t bytes_read = reader_->BytesRead();
+      uint64_t bytes_read = readahead_ != nullptr ? readahead_->BytesRead()
+                            : reader_ != nullptr   ? reader_->BytesRead()
+                                                   : 0;
       metrics::GetTFDataBytesReadCounter(kSnapshotChunkDataset)
           ->IncrementBy(bytes_read);
     }
 
+    // Null while `readahead_` reads the chunk.
     std::unique_ptr<snapshot_util::TFRecordReader> reader_;
+    std::unique_ptr<ChunkReadahead> readahead_;
     int64_t start_index_ = 0;
   };
 
@@ -192,6 +314,10 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
   const tstring compression_;
   const DataTypeVector dtypes_;
   const std::vector<PartialTensorShape> shapes_;
+  // If true, each iterator reads its chunk ahead of the consumer on a
+  // background thread. Enabled by the "snapshot_chunk_readahead" tf.data
+  // experiment.
+  const bool readahead_;
 };
 
 SnapshotChunkDatasetOp::SnapshotChunkDatasetOp(OpKernelConstruction* ctx)
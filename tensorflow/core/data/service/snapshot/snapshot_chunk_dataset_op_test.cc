@@ -0,0 +1,191 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdlib.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tsl/lib/io/compression.h"
+#include "tsl/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "snapshot_chunk_dataset";
+
+class SnapshotChunkDatasetParams : public DatasetParams {
+ public:
+  SnapshotChunkDatasetParams(tstring chunk_file, DataTypeVector output_dtypes,
+                             std::vector<PartialTensorShape> output_shapes,
+                             string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        chunk_file_(std::move(chunk_file)) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<tstring>(TensorShape({}), {chunk_file_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"chunk_file"};
+    return absl::OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"output_types", output_dtypes_},
+                    {"output_shapes", output_shapes_},
+                    {"compression", tsl::io::compression::kNone}};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override { return "SnapshotChunk"; }
+
+ private:
+  tstring chunk_file_;
+};
+
+// Runs with the "snapshot_chunk_readahead" experiment, which reads the chunk
+// on a background thread.
+class SnapshotChunkDatasetOpReadaheadTest : public DatasetOpsTestBase {
+ protected:
+  void SetUp() override {
+    setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+    setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+    setenv("TF_DATA_EXPERIMENT_OPT_IN", "snapshot_chunk_readahead",
+           /*overwrite=*/1);
+  }
+
+  void TearDown() override {
+    unsetenv("TF_JOB_NAME");
+    unsetenv("TF_TASK_ID");
+    unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+  }
+
+  // Writes a chunk of `num_elements` int64 vectors of `element_size` values,
+  // where the values of element `i` are all `i`. Returns the elements.
+  std::vector<Tensor> WriteChunk(const std::string& name, int64_t num_elements,
+                                 int64_t element_size) {
+    chunk_file_ = absl::StrCat(testing::TmpDir(), "/", name);
+    snapshot_util::TFRecordWriter writer(chunk_file_,
+                                         tsl::io::compression::kNone);
+    TF_CHECK_OK(writer.Initialize(Env::Default()));
+    std::vector<Tensor> elements;
+    for (int64_t i = 0; i < num_elements; ++i) {
+      Tensor element(DT_INT64, TensorShape({element_size}));
+      element.flat<int64_t>().setConstant(i);
+      TF_CHECK_OK(writer.WriteTensors({element}));
+      elements.push_back(std::move(element));
+    }
+    TF_CHECK_OK(writer.Close());
+    return elements;
+  }
+
+  SnapshotChunkDatasetParams ChunkParams() const {
+    return SnapshotChunkDatasetParams(chunk_file_, {DT_INT64},
+                                      {PartialTensorShape({-1})}, kNodeName);
+  }
+
+  std::string chunk_file_;
+};
+
+TEST_F(SnapshotChunkDatasetOpReadaheadTest, GetNext) {
+  std::vector<Tensor> elements =
+      WriteChunk("get_next", /*num_elements=*/100, /*element_size=*/3);
+  auto dataset_params = ChunkParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(elements, /*compare_order=*/true));
+}
+
+TEST_F(SnapshotChunkDatasetOpReadaheadTest, SaveAndRestore) {
+  std::vector<Tensor> elements =
+      WriteChunk("save_and_restore", /*num_elements=*/10, /*element_size=*/3);
+  auto dataset_params = ChunkParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  // Restoring mid-chunk restarts the readahead from the restored element.
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(), elements,
+      /*breakpoints=*/{0, 1, 4, 9, 12}, /*compare_order=*/true));
+}
+
+TEST_F(SnapshotChunkDatasetOpReadaheadTest, BuffersUpTo8MB) {
+  // Elements of 1MB.
+  constexpr int64_t kElementSize = (1 << 20) / sizeof(int64_t);
+  constexpr int64_t kElementBytes = 1 << 20;
+  WriteChunk("buffers_up_to_8mb", /*num_elements=*/32, kElementSize);
+  auto dataset_params = ChunkParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  auto* bytes_read = metrics::GetTFDataBytesReadCounter("SnapshotChunkDataset");
+  const int64_t bytes_read_before = bytes_read->value();
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  // Give the background thread time to fill its buffer. The iterator records
+  // the bytes it read when it is destroyed.
+  Env::Default()->SleepForMicroseconds(500 * 1000);
+  iterator_.reset();
+  const int64_t chunk_bytes_read = bytes_read->value() - bytes_read_before;
+  EXPECT_GE(chunk_bytes_read, kElementBytes);
+  // The consumed element, 8MB of buffered elements, and the framing of the
+  // records.
+  EXPECT_LT(chunk_bytes_read, 10 * kElementBytes);
+}
+
+TEST_F(SnapshotChunkDatasetOpReadaheadTest, ReadErrorIsReturned) {
+  std::vector<Tensor> elements =
+      WriteChunk("read_error", /*num_elements=*/10, /*element_size=*/3);
+  // Truncates the last record.
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), chunk_file_, &contents));
+  contents.resize(contents.size() - 10);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), chunk_file_, contents));
+  auto dataset_params = ChunkParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  for (int i = 0; i < elements.size() - 1; ++i) {
+    std::vector<Tensor> out_tensors;
+    bool end_of_sequence = false;
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    TF_ASSERT_OK(ExpectEqual(out_tensors[0], elements[i]));
+  }
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kDataLoss);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -15,15 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/split_provider.h"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/dispatcher_client.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
@@ -33,23 +37,55 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+// Adds `delta` to the number of prefetched splits of all split providers in
+// the process, and reports the total.
+void UpdateSplitsInFlight(int64_t delta) {
+  static std::atomic<int64_t>* splits_in_flight = new std::atomic<int64_t>(0);
+  if (delta != 0) {
+    metrics::RecordTFDataServiceSplitsInFlight(*splits_in_flight += delta);
+  }
+}
+
+}  // namespace
+
+DataServiceSplitProvider::~DataServiceSplitProvider() {
+  mutex_lock l(mu_);
+  UpdateSplitsInFlight(-static_cast<int64_t>(prefetched_splits_.size()));
+}
 
 Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
     TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
+  if (!prefetched_splits_.empty()) {
+    *split = std::move(prefetched_splits_.front());
+    prefetched_splits_.pop_front();
+    UpdateSplitsInFlight(-1);
+    *end_of_splits = false;
+    return absl::OkStatus();
+  }
   if (!dispatcher_) {
     dispatcher_ =
         std::make_unique<DataServiceDispatcherClient>(address_, protocol_);
   }
+  std::vector<Tensor> splits;
   TF_RETURN_IF_ERROR(grpc_util::Retry(
-      [this, split, end_of_splits]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-        return dispatcher_->GetSplit(iteration_id_, repetition_,
-                                     split_provider_index_, *split,
-                                     *end_of_splits);
+      [this, &splits, end_of_splits]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return dispatcher_->GetSplits(iteration_id_, repetition_,
+                                      split_provider_index_, split_batch_size_,
+                                      splits, *end_of_splits);
       },
       "get next split",
       /*deadline_micros=*/Env::Default()->NowMicros() +
           (timeout_ms_ * EnvTime::kMillisToMicros)));
+  if (!*end_of_splits) {
+    *split = std::move(splits[0]);
+    for (size_t i = 1; i < splits.size(); ++i) {
+      prefetched_splits_.push_back(std::move(splits[i]));
+    }
+    UpdateSplitsInFlight(splits.size() - 1);
+  }
   if (*end_of_splits) {
     VLOG(1) << "Reached end of splits for iteration_id=" << iteration_id_
             << ", repetition=" << repetition_;
@@ -64,6 +100,10 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits)
 Status DataServiceSplitProvider::Reset() TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   repetition_++;
+  // The dispatcher skips the rest of the previous repetition, like it does for
+  // splits which were not fetched yet.
+  UpdateSplitsInFlight(-static_cast<int64_t>(prefetched_splits_.size()));
+  prefetched_splits_.clear();
   return absl::OkStatus();
 }
 
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_SPLIT_PROVIDER_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_SPLIT_PROVIDER_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -33,16 +36,22 @@ namespace tensorflow {
 namespace data {
 
 // SplitProvider which reads splits from a tf.data service dispatcher over RPC.
+//
+// If `split_batch_size` is greater than one, each RPC fetches up to that many
+// splits, and the splits after the first are buffered until they are read.
 class DataServiceSplitProvider : public SplitProvider {
  public:
   DataServiceSplitProvider(const std::string& address,
                            const std::string& protocol, int64_t iteration_id,
-                           int64_t split_provider_index, int64_t timeout_ms)
+                           int64_t split_provider_index, int64_t timeout_ms,
+                           int64_t split_batch_size = 1)
       : address_(address),
         protocol_(protocol),
         iteration_id_(iteration_id),
         split_provider_index_(split_provider_index),
-        timeout_ms_(timeout_ms) {}
+        timeout_ms_(timeout_ms),
+        split_batch_size_(std::max<int64_t>(split_batch_size, 1)) {}
+  ~DataServiceSplitProvider() override;
 
   Status GetNext(Tensor* split, bool* end_of_splits) override;
   Status Reset() override;
@@ -57,10 +66,13 @@ class DataServiceSplitProvider : public SplitProvider {
   const int64_t iteration_id_;
   const int64_t split_provider_index_;
   const int64_t timeout_ms_;
+  const int64_t split_batch_size_;
 
   mutex mu_;
   int64_t repetition_ TF_GUARDED_BY(mu_) = 0;
   std::unique_ptr<DataServiceDispatcherClient> dispatcher_ TF_GUARDED_BY(mu_);
+  // Splits of the current repetition which were fetched but not read yet.
+  std::deque<Tensor> prefetched_splits_ TF_GUARDED_BY(mu_);
 };
 
 // Makes split providers for `dataset_def` and stores them in `split_providers`.
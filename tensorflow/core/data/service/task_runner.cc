@@ -17,9 +17,12 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "tensorflow/core/data/service/append_only_log.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
@@ -31,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/env.h"
@@ -39,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/protobuf/service_config.pb.h"
 
 namespace tensorflow {
@@ -48,6 +53,8 @@ namespace {
 constexpr int64_t kWaitBeforeSkipUs = 100 * 1000;  // 100ms.
 constexpr size_t kDefaultCrossTrainerCacheSizeBytes =
     10 * (size_t{1} << 30);  // 10GB
+constexpr size_t kDefaultCrossTrainerCacheSpillSizeBytes =
+    100 * (size_t{1} << 30);  // 100GB
 
 }  // namespace
 
@@ -100,8 +107,21 @@ Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
         worker_config.cross_trainer_cache_size_bytes() > 0
             ? worker_config.cross_trainer_cache_size_bytes()
             : kDefaultCrossTrainerCacheSizeBytes;
-    out = std::make_unique<CachingTaskRunner>(std::move(iterator),
-                                              max_cache_size_bytes);
+    std::unique_ptr<EvictedElementStore<GetElementResult>> evicted_elements;
+    const std::string& spill_directory =
+        worker_config.cross_trainer_cache_spill_directory();
+    if (!spill_directory.empty()) {
+      const size_t max_spill_size_bytes =
+          worker_config.cross_trainer_cache_spill_size_bytes() > 0
+              ? worker_config.cross_trainer_cache_spill_size_bytes()
+              : kDefaultCrossTrainerCacheSpillSizeBytes;
+      TF_ASSIGN_OR_RETURN(
+          evicted_elements,
+          DiskEvictedElementStore::Create(Env::Default(), spill_directory,
+                                          max_spill_size_bytes));
+    }
+    out = std::make_unique<CachingTaskRunner>(
+        std::move(iterator), max_cache_size_bytes, std::move(evicted_elements));
   } else {
     out = std::make_unique<FirstComeFirstServedTaskRunner>(std::move(iterator));
   }
@@ -177,11 +197,67 @@ std::shared_ptr<model::Model> FirstComeFirstServedTaskRunner::model() const {
   return model_;
 }
 
-CachingTaskRunner::CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                                     size_t max_cache_size_bytes)
+/* static */
+StatusOr<std::unique_ptr<DiskEvictedElementStore>>
+DiskEvictedElementStore::Create(Env* env, const std::string& parent_directory,
+                                size_t max_size_bytes) {
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<AppendOnlyLog> log,
+      AppendOnlyLog::Create(env, parent_directory, max_size_bytes));
+  LOG(INFO) << "Spilling tf.data service cross-trainer cache elements to "
+            << parent_directory << ", using up to "
+            << ByteSize::Bytes(max_size_bytes) << " of disk.";
+  return absl::WrapUnique(new DiskEvictedElementStore(std::move(log)));
+}
+
+DiskEvictedElementStore::DiskEvictedElementStore(
+    std::unique_ptr<AppendOnlyLog> log)
+    : log_(std::move(log)) {}
+
+Status DiskEvictedElementStore::Append(const GetElementResult& element) {
+  GetElementResponse response;
+  for (const Tensor& component : element.components) {
+    component.AsProtoTensorContent(
+        response.mutable_uncompressed()->add_components());
+  }
+  response.set_element_index(element.element_index);
+  return log_->Append(response.SerializeAsString());
+}
+
+StatusOr<GetElementResult> DiskEvictedElementStore::Read(size_t index) {
+  tstring record;
+  TF_RETURN_IF_ERROR(log_->Read(index, record));
+  GetElementResponse response;
+  if (!response.ParseFromArray(record.data(), record.size())) {
+    return errors::DataLoss("Failed to parse spilled cross-trainer cache "
+                            "element ",
+                            index);
+  }
+  GetElementResult result;
+  for (const TensorProto& proto : response.uncompressed().components()) {
+    Tensor component;
+    if (!component.FromProto(proto)) {
+      return errors::DataLoss("Failed to parse a component of spilled "
+                              "cross-trainer cache element ",
+                              index);
+    }
+    result.components.push_back(std::move(component));
+  }
+  result.element_index = response.element_index();
+  return result;
+}
+
+size_t DiskEvictedElementStore::start_index() const {
+  return log_->start_index();
+}
+
+CachingTaskRunner::CachingTaskRunner(
+    std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+    std::unique_ptr<EvictedElementStore<GetElementResult>> evicted_elements)
     : fcfs_task_runner_(std::move(iterator)),
       cache_(max_cache_size_bytes,
-             std::make_unique<GetElementResultSequence>(fcfs_task_runner_)) {
+             std::make_unique<GetElementResultSequence>(fcfs_task_runner_),
+             std::move(evicted_elements)) {
   LOG(INFO) << "Initialized tf.data service cross-trainer cache with "
             << ByteSize::Bytes(max_cache_size_bytes) << " of memory.";
 }
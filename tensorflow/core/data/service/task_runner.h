@@ -17,8 +17,10 @@ limitations under the License.
 
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
+#include "tensorflow/core/data/service/append_only_log.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
 #include "tensorflow/core/data/service/data_transfer.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -145,6 +148,25 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
   void operator=(const FirstComeFirstServedTaskRunner&) = delete;
 };
 
+// Keeps the elements evicted from a `CachingTaskRunner`'s memory in an
+// `AppendOnlyLog` on local disk.
+class DiskEvictedElementStore : public EvictedElementStore<GetElementResult> {
+ public:
+  // Creates a store in a new directory under `parent_directory`, which holds
+  // at most about `max_size_bytes` of serialized elements.
+  static StatusOr<std::unique_ptr<DiskEvictedElementStore>> Create(
+      Env* env, const std::string& parent_directory, size_t max_size_bytes);
+
+  Status Append(const GetElementResult& element) override;
+  StatusOr<GetElementResult> Read(size_t index) override;
+  size_t start_index() const override;
+
+ private:
+  explicit DiskEvictedElementStore(std::unique_ptr<AppendOnlyLog> log);
+
+  const std::unique_ptr<AppendOnlyLog> log_;
+};
+
 // A task runner which prefetches elements on a first-come first-served basis
 // and caches elements in a sliding-window `CrossTrainerCache`. The cache has a
 // bounded size and progresses when a trainer that has consumed all elements in
@@ -152,8 +174,12 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
 // read the full dataset.
 class CachingTaskRunner : public TaskRunner {
  public:
-  explicit CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                             size_t max_cache_size_bytes);
+  // If `evicted_elements` is not null, elements evicted from the in-memory
+  // cache are moved to it, so trainers that fall behind can still read them.
+  explicit CachingTaskRunner(
+      std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+      std::unique_ptr<EvictedElementStore<GetElementResult>> evicted_elements =
+          nullptr);
   ~CachingTaskRunner() override;
 
   // Gets the next element from the cross-trainer cache, blocking if the data is
@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -357,6 +358,49 @@ TEST(CachingTaskRunnerTest, SlowClientSkipsData) {
   EXPECT_THAT(slow_trainer_output[0], Gt(0));
 }
 
+TEST(CachingTaskRunnerTest, SlowClientReadsSpilledData) {
+  size_t range = 1000;
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DiskEvictedElementStore> evicted_elements,
+      DiskEvictedElementStore::Create(Env::Default(), testing::TmpDir(),
+                                      /*max_size_bytes=*/1 << 20));
+  CachingTaskRunner runner(std::make_unique<InfiniteRangeIterator>(),
+                           /*max_cache_size_bytes=*/kSmallCache,
+                           std::move(evicted_elements));
+
+  GetElementRequest request;
+  request.set_trainer_id("Fast trainer");
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> fast_trainer_output,
+      GetElementsFromTaskRunner<int64_t>(runner, request, range));
+  EXPECT_THAT(fast_trainer_output, ElementsAreArray(GetRange(range)));
+
+  request.set_trainer_id("Slow trainer");
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> slow_trainer_output,
+      GetElementsFromTaskRunner<int64_t>(runner, request, range));
+  EXPECT_THAT(slow_trainer_output, ElementsAreArray(GetRange(range)));
+}
+
+TEST(DiskEvictedElementStoreTest, AppendAndRead) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DiskEvictedElementStore> store,
+      DiskEvictedElementStore::Create(Env::Default(), testing::TmpDir(),
+                                      /*max_size_bytes=*/1 << 20));
+  for (int64_t i = 0; i < 10; ++i) {
+    GetElementResult element;
+    element.components = {Tensor(i), Tensor(tstring(absl::StrCat("s", i)))};
+    element.element_index = i;
+    TF_ASSERT_OK(store->Append(element));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(GetElementResult element, store->Read(7));
+  EXPECT_EQ(element.element_index, 7);
+  ASSERT_THAT(element.components, SizeIs(2));
+  test::ExpectEqual(element.components[0], Tensor(int64_t{7}));
+  test::ExpectEqual(element.components[1], Tensor(tstring("s7")));
+  EXPECT_THAT(store->Read(10), StatusIs(error::OUT_OF_RANGE));
+}
+
 TEST(CachingTaskRunnerTest, ConcurrentTrainers) {
   size_t range = 100;
   size_t num_readers = 10;
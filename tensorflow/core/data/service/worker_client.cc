@@ -14,7 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/worker_client.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -26,10 +28,15 @@ limitations under the License.
 #include "grpcpp/security/credentials.h"
 #include "grpcpp/support/channel_arguments.h"
 #include "grpcpp/support/status.h"
+#include "grpcpp/support/sync_stream.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/service/adaptive_compression.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/grpc_util.h"
@@ -50,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/batch_util.h"
 #include "tsl/platform/errors.h"
 
 namespace tensorflow {
@@ -81,8 +89,21 @@ Status DataServiceWorkerClient::EnsureInitialized() {
   if (client_) {
     return absl::OkStatus();
   }
+  const int64_t stream_window =
+      GetExperiments().contains("data_service_streaming_transfer")
+          ? kElementStreamWindow
+          : 0;
+  const bool adaptive_compression =
+      GetExperiments().contains("adaptive_element_compression");
+  const int64_t max_batch_size =
+      GetExperiments().contains("data_service_element_batching")
+          ? kElementBatchSize
+          : 0;
   TF_RETURN_IF_ERROR(DataTransferClient::Build(
-      GetDataTransferProtocol(), {protocol_, address_, allocator_}, &client_));
+      GetDataTransferProtocol(),
+      {protocol_, address_, allocator_, stream_window, adaptive_compression,
+       max_batch_size},
+      &client_));
   return absl::OkStatus();
 }
 
@@ -98,23 +119,53 @@ void DataServiceWorkerClient::TryCancel() { client_->TryCancel(); }
 class GrpcDataTransferClient : public DataTransferClient {
  public:
   GrpcDataTransferClient(std::shared_ptr<grpc::ChannelCredentials> credentials,
-                         std::string address) {
+                         std::string address, int64_t stream_window,
+                         bool adaptive_compression, int64_t max_batch_size)
+      : stream_window_(stream_window), max_batch_size_(max_batch_size) {
     VLOG(2) << "Create GrpcDataTransferClient for worker " << address << ".";
+    if (adaptive_compression) {
+      compression_selector_ = std::make_unique<AdaptiveCompressionSelector>();
+    }
     grpc::ChannelArguments args;
     args.SetMaxReceiveMessageSize(-1);
     auto channel = grpc::CreateCustomChannel(address, credentials, args);
     stub_ = WorkerService::NewStub(channel);
   }
 
-  Status GetElement(const GetElementRequest& req,
+  ~GrpcDataTransferClient() override {
+    mutex_lock l(stream_mu_);
+    CloseStream();
+  }
+
+  Status GetElement(const GetElementRequest& original_req,
                     GetElementResult& result) override {
-    VLOG(3) << "GetElement for task " << req.task_id() << " from gRPC worker "
-            << "server.";
+    VLOG(3) << "GetElement for task " << original_req.task_id()
+            << " from gRPC worker server.";
     {
       mutex_lock l(mu_);
       if (cancelled_) {
         return errors::Cancelled("Client was cancelled.");
       }
+      auto it = batched_elements_.find(original_req.task_id());
+      if (it != batched_elements_.end()) {
+        result.components = std::move(it->second.front());
+        it->second.pop_front();
+        if (it->second.empty()) {
+          batched_elements_.erase(it);
+        }
+        return absl::OkStatus();
+      }
+    }
+    GetElementRequest req = original_req;
+    if (max_batch_size_ > 1 && !req.has_round_index() &&
+        req.trainer_id().empty()) {
+      req.set_max_batch_size(max_batch_size_);
+    }
+    if (compression_selector_ != nullptr) {
+      req.set_compression(compression_selector_->Next());
+    }
+    if (stream_window_ > 0 && !req.has_round_index()) {
+      return GetElementFromStream(req, result);
     }
     grpc::ClientContext ctx;
     gtl::Cleanup<std::function<void()>> cleanup;
@@ -135,8 +186,59 @@ class GrpcDataTransferClient : public DataTransferClient {
     }
     metrics::RecordTFDataServiceGetElementDuration(kGrpcTransferProtocol,
                                                    end_time_us - start_time_us);
+    return ResponseToResult(req, resp, end_time_us - start_time_us, result);
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel GrpcDataTransferClient.";
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (const auto& ctx : active_contexts_) {
+      ctx->TryCancel();
+    }
+  }
+
+ private:
+  // An open `GetElementStream` call for the elements of a task.
+  struct ElementStream {
+    int64_t task_id = 0;
+    grpc::ClientContext ctx;
+    std::unique_ptr<
+        grpc::ClientReaderWriter<GetElementStreamRequest, GetElementResponse>>
+        stream;
+    // The number of elements received since credits were last granted.
+    int64_t unacknowledged = 0;
+    // Whether `stream->Finish()` has been called.
+    bool finished = false;
+  };
+
+  // Converts the response `resp` to `req`, which took `read_time_us` to read,
+  // to `result`. Batches are split, and their elements after the first are
+  // buffered for the next requests.
+  Status ResponseToResult(const GetElementRequest& req,
+                          GetElementResponse& resp, int64_t read_time_us,
+                          GetElementResult& result) {
+    TF_RETURN_IF_ERROR(ResponseToComponents(resp, read_time_us, result));
+    if (resp.batch_size() > 1) {
+      return UnbatchResult(req.task_id(), resp, result);
+    }
+    return absl::OkStatus();
+  }
+
+  // Elements the worker compressed for the transfer are uncompressed, and
+  // their costs are recorded for choosing the compression of later elements.
+  Status ResponseToComponents(GetElementResponse& resp, int64_t read_time_us,
+                              GetElementResult& result) {
     result.end_of_sequence = resp.end_of_sequence();
     result.skip = resp.skip_task();
+    if (resp.transfer_compression() == ELEMENT_COMPRESSION_SNAPPY) {
+      const int64_t start_time_us = env_->NowMicros();
+      TF_RETURN_IF_ERROR(
+          UncompressElement(resp.compressed(), &result.components));
+      RecordCompressionSample(resp, read_time_us,
+                              env_->NowMicros() - start_time_us, result);
+      return absl::OkStatus();
+    }
     switch (resp.element_case()) {
       case GetElementResponse::kCompressed: {
         Tensor tensor(DT_VARIANT, TensorShape{});
@@ -155,19 +257,164 @@ class GrpcDataTransferClient : public DataTransferClient {
       case GetElementResponse::ELEMENT_NOT_SET:
         break;
     }
+    if (resp.has_uncompressed()) {
+      RecordCompressionSample(resp, read_time_us,
+                              /*uncompression_time_us=*/0, result);
+    }
     return absl::OkStatus();
   }
 
-  void TryCancel() override {
-    VLOG(2) << "Cancel GrpcDataTransferClient.";
+  // Splits the batch of `resp.batch_size()` elements in `result`, keeping
+  // the first element in `result`.
+  Status UnbatchResult(int64_t task_id, const GetElementResponse& resp,
+                       GetElementResult& result) TF_LOCKS_EXCLUDED(mu_) {
+    const int64_t batch_size = resp.batch_size();
+    std::vector<Tensor> batch = std::move(result.components);
+    std::vector<std::vector<Tensor>> elements(batch_size);
+    if (resp.batch_stacked()) {
+      for (Tensor& component : batch) {
+        if (component.dims() == 0 || component.dim_size(0) != batch_size) {
+          return errors::Internal("Expected a batch of ", batch_size,
+                                  " elements, but got a component of shape ",
+                                  component.shape().DebugString());
+        }
+        TensorShape shape = component.shape();
+        shape.RemoveDim(0);
+        for (int64_t i = 0; i < batch_size; ++i) {
+          Tensor slice(component.dtype(), shape);
+          TF_RETURN_IF_ERROR(
+              batch_util::MaybeMoveSliceToElement(&component, &slice, i));
+          elements[i].push_back(std::move(slice));
+        }
+      }
+    } else {
+      if (batch.size() % batch_size != 0) {
+        return errors::Internal("Expected a batch of ", batch_size,
+                                " elements, but got ", batch.size(),
+                                " components");
+      }
+      const size_t num_components = batch.size() / batch_size;
+      for (size_t i = 0; i < batch.size(); ++i) {
+        elements[i / num_components].push_back(std::move(batch[i]));
+      }
+    }
+    result.components = std::move(elements[0]);
     mutex_lock l(mu_);
-    cancelled_ = true;
-    for (const auto& ctx : active_contexts_) {
-      ctx->TryCancel();
+    std::deque<std::vector<Tensor>>& buffer = batched_elements_[task_id];
+    for (int64_t i = 1; i < batch_size; ++i) {
+      buffer.push_back(std::move(elements[i]));
     }
+    return absl::OkStatus();
   }
 
- private:
+  void RecordCompressionSample(const GetElementResponse& resp,
+                               int64_t read_time_us,
+                               int64_t uncompression_time_us,
+                               const GetElementResult& result) {
+    if (compression_selector_ == nullptr) {
+      return;
+    }
+    AdaptiveCompressionSelector::Sample sample;
+    sample.compression = resp.transfer_compression() ==
+                                 ELEMENT_COMPRESSION_UNSPECIFIED
+                             ? ELEMENT_COMPRESSION_NONE
+                             : resp.transfer_compression();
+    for (const Tensor& component : result.components) {
+      sample.uncompressed_bytes += component.TotalBytes();
+    }
+    sample.transfer_time_us = read_time_us - resp.processing_time_us();
+    sample.compression_time_us = resp.compression_time_us();
+    sample.uncompression_time_us = uncompression_time_us;
+    compression_selector_->Record(sample);
+  }
+
+  // Reads the next element of the task of `req` from its element stream,
+  // opening the stream if needed. Credits are granted back to the server in
+  // batches of half the window, which keeps the stream full while sending
+  // one small message for every few elements. The elements of a stream keep
+  // the compression requested when it was opened.
+  Status GetElementFromStream(const GetElementRequest& req,
+                              GetElementResult& result)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(stream_mu_);
+    if (stream_ != nullptr && stream_->task_id != req.task_id()) {
+      CloseStream();
+    }
+    if (stream_ == nullptr) {
+      TF_RETURN_IF_ERROR(OpenStream(req));
+    }
+    GetElementResponse resp;
+    int64_t start_time_us = env_->NowMicros();
+    if (!stream_->stream->Read(&resp)) {
+      grpc::Status s = stream_->stream->Finish();
+      stream_->finished = true;
+      CloseStream();
+      if (s.ok()) {
+        return errors::Unavailable("The element stream for task ",
+                                   req.task_id(),
+                                   " ended before the end of sequence.");
+      }
+      return grpc_util::WrapError("Failed to get element", s);
+    }
+    int64_t end_time_us = env_->NowMicros();
+    metrics::RecordTFDataServiceGetElementDuration(kGrpcTransferProtocol,
+                                                   end_time_us - start_time_us);
+    if (resp.end_of_sequence()) {
+      CloseStream();
+    } else if (++stream_->unacknowledged >=
+               std::max<int64_t>(1, stream_window_ / 2)) {
+      GetElementStreamRequest credits;
+      credits.set_credits(stream_->unacknowledged);
+      stream_->unacknowledged = 0;
+      // A failed write means that the stream is broken, which the next read
+      // reports.
+      stream_->stream->Write(credits);
+    }
+    return ResponseToResult(req, resp, end_time_us - start_time_us, result);
+  }
+
+  Status OpenStream(const GetElementRequest& req)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(stream_mu_) TF_LOCKS_EXCLUDED(mu_) {
+    auto stream = std::make_unique<ElementStream>();
+    stream->task_id = req.task_id();
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
+      active_contexts_.insert(&stream->ctx);
+    }
+    stream->stream = stub_->GetElementStream(&stream->ctx);
+    GetElementStreamRequest stream_req;
+    *stream_req.mutable_request() = req;
+    stream_req.set_credits(stream_window_);
+    // As above, a failed write is reported by the first read.
+    stream->stream->Write(stream_req);
+    stream_ = std::move(stream);
+    return absl::OkStatus();
+  }
+
+  void CloseStream() TF_EXCLUSIVE_LOCKS_REQUIRED(stream_mu_)
+      TF_LOCKS_EXCLUDED(mu_) {
+    if (stream_ == nullptr) {
+      return;
+    }
+    {
+      mutex_lock l(mu_);
+      active_contexts_.erase(&stream_->ctx);
+    }
+    if (!stream_->finished) {
+      stream_->ctx.TryCancel();
+      stream_->stream->Finish();
+    }
+    stream_ = nullptr;
+  }
+
+  const int64_t stream_window_;
+  const int64_t max_batch_size_;
+  // Chooses the compression of the requested elements, if their compression
+  // is adaptive.
+  std::unique_ptr<AdaptiveCompressionSelector> compression_selector_;
   mutex mu_;
   std::unique_ptr<WorkerService::Stub> stub_;
   // Set of all currently active clients contexts. Used to support
@@ -177,6 +424,15 @@ class GrpcDataTransferClient : public DataTransferClient {
   // Indicates that the client has been cancelled, so no further requests should
   // be accepted.
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // The elements of received batches that have not been returned yet, by
+  // task ID.
+  absl::flat_hash_map<int64_t, std::deque<std::vector<Tensor>>>
+      batched_elements_ TF_GUARDED_BY(mu_);
+
+  // Held while reading from the element stream, which may block, so it is
+  // separate from `mu_` to let `TryCancel` cancel the read.
+  mutex stream_mu_;
+  std::unique_ptr<ElementStream> stream_ TF_GUARDED_BY(stream_mu_);
 };
 
 class GrpcTransferClientRegistrar {
@@ -188,8 +444,9 @@ class GrpcTransferClientRegistrar {
           std::shared_ptr<grpc::ChannelCredentials> credentials;
           TF_RETURN_IF_ERROR(CredentialsFactory::CreateClientCredentials(
               config.protocol, &credentials));
-          *out = std::make_unique<GrpcDataTransferClient>(credentials,
-                                                          config.address);
+          *out = std::make_unique<GrpcDataTransferClient>(
+              credentials, config.address, config.stream_window,
+              config.adaptive_compression, config.max_batch_size);
           return absl::OkStatus();
         });
   }
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_CLIENT_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_CLIENT_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -34,6 +35,14 @@ namespace data {
 constexpr const char kLocalTransferProtocol[] = "local";
 constexpr const char kGrpcTransferProtocol[] = "grpc";
 
+// The number of elements in flight per element stream when the
+// "data_service_streaming_transfer" experiment is enabled.
+constexpr int64_t kElementStreamWindow = 32;
+
+// The maximum number of elements per response when the
+// "data_service_element_batching" experiment is enabled.
+constexpr int64_t kElementBatchSize = 16;
+
 // Client for communicating with the tf.data service worker.
 class DataServiceWorkerClient : public DataServiceClientBase {
  public:
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/optional.h"
+#include "tensorflow/core/data/service/adaptive_compression.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_transfer.h"
@@ -200,6 +201,94 @@ TEST_F(WorkerClientTest, GrpcRead) {
                        MatchesRegex("Local worker.*is no longer available.*")));
 }
 
+TEST_F(WorkerClientTest, GrpcStreamRead) {
+  const int64_t range = 5;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  // A window smaller than the dataset makes the client grant credits while
+  // reading.
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(DataTransferClient::Build(
+      kGrpcTransferProtocol,
+      {kProtocol, GetWorkerAddress(), /*allocator=*/nullptr,
+       /*stream_window=*/2},
+      &client));
+  GetElementRequest request;
+  request.set_task_id(task_id);
+  for (int64_t i = 0; i < range; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    test::ExpectEqual(result.components[0], Tensor(int64_t{i * i}));
+    EXPECT_FALSE(result.end_of_sequence);
+  }
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  EXPECT_TRUE(result.end_of_sequence);
+
+  client->TryCancel();
+  EXPECT_THAT(client->GetElement(request, result),
+              StatusIs(error::CANCELLED));
+}
+
+TEST_F(WorkerClientTest, GrpcAdaptiveCompressionRead) {
+  const int64_t range = 2 * AdaptiveCompressionSelector::kWarmupElements;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  // The warmup reads half of the elements compressed, which the client must
+  // uncompress.
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(DataTransferClient::Build(
+      kGrpcTransferProtocol,
+      {kProtocol, GetWorkerAddress(), /*allocator=*/nullptr,
+       /*stream_window=*/0, /*adaptive_compression=*/true},
+      &client));
+  GetElementRequest request;
+  request.set_task_id(task_id);
+  for (int64_t i = 0; i < range; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    ASSERT_EQ(result.components.size(), 1);
+    test::ExpectEqual(result.components[0], Tensor(int64_t{i * i}));
+  }
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  EXPECT_TRUE(result.end_of_sequence);
+}
+
+TEST_F(WorkerClientTest, GrpcBatchedRead) {
+  const int64_t range = 20;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  std::unique_ptr<DataTransferClient> client;
+  TF_ASSERT_OK(DataTransferClient::Build(
+      kGrpcTransferProtocol,
+      {kProtocol, GetWorkerAddress(), /*allocator=*/nullptr,
+       /*stream_window=*/0, /*adaptive_compression=*/false,
+       /*max_batch_size=*/4},
+      &client));
+  GetElementRequest request;
+  request.set_task_id(task_id);
+  for (int64_t i = 0; i < range; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    ASSERT_EQ(result.components.size(), 1);
+    test::ExpectEqual(result.components[0], Tensor(int64_t{i * i}));
+    EXPECT_FALSE(result.end_of_sequence);
+  }
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(request, result));
+  EXPECT_TRUE(result.end_of_sequence);
+}
+
 TEST_F(WorkerClientTest, LocalServerShutsDown) {
   TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id,
                           RegisterDataset(/*range=*/5));
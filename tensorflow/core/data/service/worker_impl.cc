@@ -29,6 +29,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
@@ -63,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/service_config.pb.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/batch_util.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/status_to_from_proto.h"
@@ -79,13 +81,44 @@ constexpr absl::Duration kDefaultDispatcherTimeout = absl::Hours(1);
 
 using WorkerConfig = experimental::WorkerConfig;
 
+// Returns true if `element` is a single CompressedElement variant, as produced
+// by datasets that compress their elements.
+bool IsCompressedElement(const std::vector<Tensor>& element) {
+  return element.size() == 1 && element[0].dtype() == DT_VARIANT &&
+         TensorShapeUtils::IsScalar(element[0].shape());
+}
+
+// Returns true if all `elements` have the same component dtypes and shapes.
+bool HaveSameShapes(const std::vector<std::vector<Tensor>>& elements) {
+  for (const std::vector<Tensor>& element : elements) {
+    if (element.size() != elements[0].size()) {
+      return false;
+    }
+    for (size_t i = 0; i < element.size(); ++i) {
+      if (element[i].dtype() != elements[0][i].dtype() ||
+          element[i].shape() != elements[0][i].shape()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 // Moves the element into the response. If the tensor contains a single
-// CompressedElement variant, the move will be zero-copy. Otherwise, the tensor
-// data will be serialized as TensorProtos.
+// CompressedElement variant, the move will be zero-copy. Otherwise, the
+// element is compressed as requested by `compression`, or its tensor data
+// will be serialized as TensorProtos.
 Status MoveElementToResponse(std::vector<Tensor>&& element,
+                             ElementCompression compression,
                              GetElementResponse& resp) {
-  if (element.size() != 1 || element[0].dtype() != DT_VARIANT ||
-      !TensorShapeUtils::IsScalar(element[0].shape())) {
+  if (!IsCompressedElement(element)) {
+    if (compression == ELEMENT_COMPRESSION_SNAPPY) {
+      const int64_t start_us = EnvTime::NowMicros();
+      TF_RETURN_IF_ERROR(CompressElement(element, resp.mutable_compressed()));
+      resp.set_transfer_compression(ELEMENT_COMPRESSION_SNAPPY);
+      resp.set_compression_time_us(EnvTime::NowMicros() - start_us);
+      return absl::OkStatus();
+    }
     for (const auto& component : element) {
       UncompressedElement* uncompressed = resp.mutable_uncompressed();
       component.AsProtoTensorContent(uncompressed->add_components());
@@ -451,7 +484,8 @@ DataServiceWorkerImpl::MakeDatasetIterator(standalone::Dataset& dataset,
     for (int i = 0; i < task_def.num_split_providers(); ++i) {
       split_providers.push_back(std::make_unique<DataServiceSplitProvider>(
           config_.dispatcher_address(), config_.protocol(),
-          task_def.iteration_id(), i, config_.dispatcher_timeout_ms()));
+          task_def.iteration_id(), i, config_.dispatcher_timeout_ms(),
+          config_.split_batch_size()));
     }
     TF_RETURN_IF_ERROR(
         dataset.MakeIterator(std::move(split_providers), &iterator));
@@ -479,15 +513,79 @@ void DataServiceWorkerImpl::StopTask(Task& task) TF_LOCKS_EXCLUDED(mu_) {
 Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
                                          GetElementResponse* response) {
   VLOG(3) << "Received GetElement request for task " << request->task_id();
+  const int64_t start_us = EnvTime::NowMicros();
   struct GetElementResult result;
   TF_RETURN_IF_ERROR(GetElementResult(request, &result));
   response->set_end_of_sequence(result.end_of_sequence);
   response->set_skip_task(result.skip);
   if (!response->end_of_sequence() && !response->skip_task()) {
-    TF_RETURN_IF_ERROR(
-        MoveElementToResponse(std::move(result.components), *response));
+    if (request->max_batch_size() > 1) {
+      TF_RETURN_IF_ERROR(
+          BatchElements(*request, result.components, *response));
+    }
+    TF_RETURN_IF_ERROR(MoveElementToResponse(
+        std::move(result.components), request->compression(), *response));
     VLOG(3) << "Producing an element for task " << request->task_id();
   }
+  response->set_processing_time_us(EnvTime::NowMicros() - start_us);
+  return absl::OkStatus();
+}
+
+Status DataServiceWorkerImpl::BatchElements(const GetElementRequest& request,
+                                            std::vector<Tensor>& element,
+                                            GetElementResponse& response) {
+  // Coordinated reads and cross-trainer caches hand out elements per
+  // consumer, and compressed elements are sent as they are.
+  if (request.has_round_index() || !request.trainer_id().empty() ||
+      IsCompressedElement(element)) {
+    return absl::OkStatus();
+  }
+  GetElementRequest next_request = request;
+  next_request.set_allow_skip(true);
+  std::vector<std::vector<Tensor>> elements;
+  elements.push_back(std::move(element));
+  while (static_cast<int64_t>(elements.size()) < request.max_batch_size()) {
+    struct GetElementResult next;
+    Status s = GetElementResult(&next_request, &next);
+    if (!s.ok()) {
+      // The elements read so far are still sent. The next request reports
+      // the error if it persists.
+      VLOG(1) << "Stopped batching the elements of task " << request.task_id()
+              << ": " << s;
+      break;
+    }
+    // The task runner returns the end of sequence again to the next request.
+    if (next.end_of_sequence || next.skip) {
+      break;
+    }
+    elements.push_back(std::move(next.components));
+  }
+  if (elements.size() == 1) {
+    element = std::move(elements[0]);
+    return absl::OkStatus();
+  }
+
+  response.set_batch_size(elements.size());
+  element.clear();
+  if (!HaveSameShapes(elements)) {
+    for (std::vector<Tensor>& batched_element : elements) {
+      for (Tensor& component : batched_element) {
+        element.push_back(std::move(component));
+      }
+    }
+    return absl::OkStatus();
+  }
+  response.set_batch_stacked(true);
+  for (size_t i = 0; i < elements[0].size(); ++i) {
+    TensorShape shape = elements[0][i].shape();
+    shape.InsertDim(0, elements.size());
+    Tensor batch(elements[0][i].dtype(), shape);
+    for (size_t j = 0; j < elements.size(); ++j) {
+      TF_RETURN_IF_ERROR(
+          batch_util::CopyElementToSlice(std::move(elements[j][i]), &batch, j));
+    }
+    element.push_back(std::move(batch));
+  }
   return absl::OkStatus();
 }
 
@@ -134,6 +134,12 @@ class DataServiceWorkerImpl {
   // Stops a task, cancelling the task's outstanding requests and waiting for
   // them to finish.
   void StopTask(Task& task) TF_LOCKS_EXCLUDED(mu_);
+  // Adds up to `request.max_batch_size() - 1` more elements of the task of
+  // `request` that are ready to `element`, and describes the batch in
+  // `response`. See worker.proto for the batch layout.
+  Status BatchElements(const GetElementRequest& request,
+                       std::vector<Tensor>& element,
+                       GetElementResponse& response) TF_LOCKS_EXCLUDED(mu_);
   // A thread for notifying the dispatcher when tasks complete.
   void TaskCompletionThread() TF_LOCKS_EXCLUDED(mu_);
   // A thread for doing periodic heartbeats to the dispatcher.
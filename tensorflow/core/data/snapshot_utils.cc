@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <climits>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -24,9 +26,11 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -43,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -65,6 +70,10 @@ constexpr const char* const kVersion = "version";
 constexpr const char* const kCurrentCheckpointID = "current_checkpoint_id";
 constexpr const char* const kIndex = "index";
 constexpr const char* const kStartIndex = "start_index";
+constexpr int64_t kColumnarReaderBufferSizeBytes = 16 << 20;  // 16MB
+
+using ::tensorflow::data::experimental::ColumnarBlockMetadata;
+using ::tensorflow::data::experimental::ColumnMetadata;
 
 std::string ProtoSerializationErrorMessage(const TensorProto& proto,
                                            const std::string& output_file) {
@@ -78,8 +87,288 @@ std::string ProtoSerializationErrorMessage(const TensorProto& proto,
   return error_message;
 }
 
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutLengthPrefixed(absl::string_view value, std::string* output) {
+  core::PutVarint64(output, value.size());
+  output->append(value.data(), value.size());
+}
+
+Status GetLengthPrefixed(StringPiece* input, StringPiece* value) {
+  uint64 length = 0;
+  if (!core::GetVarint64(input, &length) || length > input->size()) {
+    return errors::DataLoss("Corrupted length-prefixed value.");
+  }
+  *value = StringPiece(input->data(), length);
+  input->remove_prefix(length);
+  return absl::OkStatus();
+}
+
+Status GetVarint(StringPiece* input, uint64* value) {
+  if (!core::GetVarint64(input, value)) {
+    return errors::DataLoss("Corrupted varint.");
+  }
+  return absl::OkStatus();
+}
+
+// Returns the zigzag varints of the differences between consecutive values of
+// the tensors in `column`.
+template <typename T>
+std::string DeltaEncode(const std::vector<Tensor>& column) {
+  std::string encoded;
+  uint64_t previous = 0;
+  for (const Tensor& tensor : column) {
+    auto values = tensor.flat<T>();
+    for (int64_t i = 0; i < values.size(); ++i) {
+      // Differences wrap around, so they round trip for any values.
+      const uint64_t current = static_cast<int64_t>(values(i));
+      core::PutVarint64(&encoded,
+                        ZigZagEncode(static_cast<int64_t>(current - previous)));
+      previous = current;
+    }
+  }
+  return encoded;
+}
+
+template <typename T>
+Status DeltaDecode(StringPiece* input, std::vector<Tensor>& column) {
+  uint64_t previous = 0;
+  for (Tensor& tensor : column) {
+    auto values = tensor.flat<T>();
+    for (int64_t i = 0; i < values.size(); ++i) {
+      uint64 delta = 0;
+      TF_RETURN_IF_ERROR(GetVarint(input, &delta));
+      previous += static_cast<uint64_t>(ZigZagDecode(delta));
+      values(i) = static_cast<T>(static_cast<int64_t>(previous));
+    }
+  }
+  return absl::OkStatus();
+}
+
+std::string PlainEncodeStrings(const std::vector<Tensor>& column) {
+  std::string encoded;
+  for (const Tensor& tensor : column) {
+    auto values = tensor.flat<tstring>();
+    for (int64_t i = 0; i < values.size(); ++i) {
+      PutLengthPrefixed(values(i), &encoded);
+    }
+  }
+  return encoded;
+}
+
+std::string DictionaryEncode(const std::vector<Tensor>& column) {
+  absl::flat_hash_map<absl::string_view, uint64_t> indices;
+  std::vector<absl::string_view> dictionary;
+  std::string encoded_indices;
+  for (const Tensor& tensor : column) {
+    auto values = tensor.flat<tstring>();
+    for (int64_t i = 0; i < values.size(); ++i) {
+      auto [it, inserted] =
+          indices.try_emplace(absl::string_view(values(i)), dictionary.size());
+      if (inserted) {
+        dictionary.push_back(it->first);
+      }
+      core::PutVarint64(&encoded_indices, it->second);
+    }
+  }
+  std::string encoded;
+  core::PutVarint64(&encoded, dictionary.size());
+  for (absl::string_view value : dictionary) {
+    PutLengthPrefixed(value, &encoded);
+  }
+  encoded.append(encoded_indices);
+  return encoded;
+}
+
+// Encodes the tensors of `column`, which have type `dtype`, and records their
+// shapes and encoding in `metadata`.
+Status EncodeColumn(const std::vector<Tensor>& column, DataType dtype,
+                    ColumnMetadata* metadata, std::string* encoded) {
+  bool uniform_shape = true;
+  for (const Tensor& tensor : column) {
+    if (tensor.shape() != column.front().shape()) {
+      uniform_shape = false;
+      break;
+    }
+  }
+  metadata->set_uniform_shape(uniform_shape);
+  if (uniform_shape) {
+    column.front().shape().AsProto(metadata->mutable_shape());
+  } else {
+    for (const Tensor& tensor : column) {
+      tensor.shape().AsProto(metadata->add_element_shapes());
+    }
+  }
+  metadata->set_encoding(ColumnMetadata::PLAIN);
+
+  if (dtype == DT_STRING) {
+    *encoded = PlainEncodeStrings(column);
+    std::string dictionary_encoded = DictionaryEncode(column);
+    if (dictionary_encoded.size() < encoded->size()) {
+      metadata->set_encoding(ColumnMetadata::DICTIONARY);
+      *encoded = std::move(dictionary_encoded);
+    }
+    return absl::OkStatus();
+  }
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    for (const Tensor& tensor : column) {
+      TensorProto proto;
+      tensor.AsProtoTensorContent(&proto);
+      std::string serialized;
+      if (!proto.SerializeToString(&serialized)) {
+        return errors::DataLoss(
+            ProtoSerializationErrorMessage(proto, "columnar snapshot file"));
+      }
+      PutLengthPrefixed(serialized, encoded);
+    }
+    return absl::OkStatus();
+  }
+
+  for (const Tensor& tensor : column) {
+    const StringPiece data = tensor.tensor_data();
+    encoded->append(data.data(), data.size());
+  }
+  std::string delta_encoded;
+  if (dtype == DT_INT32) {
+    delta_encoded = DeltaEncode<int32_t>(column);
+  } else if (dtype == DT_INT64) {
+    delta_encoded = DeltaEncode<int64_t>(column);
+  } else {
+    return absl::OkStatus();
+  }
+  if (delta_encoded.size() < encoded->size()) {
+    metadata->set_encoding(ColumnMetadata::DELTA);
+    *encoded = std::move(delta_encoded);
+  }
+  return absl::OkStatus();
+}
+
+// Decodes the `num_elements` tensors of a column encoded by `EncodeColumn`.
+Status DecodeColumn(StringPiece input, DataType dtype,
+                    const ColumnMetadata& metadata, int64_t num_elements,
+                    std::vector<Tensor>& column) {
+  if (!metadata.uniform_shape() &&
+      metadata.element_shapes_size() != num_elements) {
+    return errors::DataLoss("Expected ", num_elements,
+                            " element shapes in a column of a block, got ",
+                            metadata.element_shapes_size());
+  }
+  column.clear();
+  column.reserve(num_elements);
+  if (metadata.encoding() == ColumnMetadata::PLAIN &&
+      dtype != DT_STRING && !DataTypeCanUseMemcpy(dtype)) {
+    for (int64_t i = 0; i < num_elements; ++i) {
+      StringPiece serialized;
+      TF_RETURN_IF_ERROR(GetLengthPrefixed(&input, &serialized));
+      TensorProto proto;
+      Tensor tensor;
+      if (!proto.ParseFromArray(serialized.data(), serialized.size()) ||
+          !tensor.FromProto(proto)) {
+        return errors::DataLoss("Failed to parse a tensor of a column.");
+      }
+      column.push_back(std::move(tensor));
+    }
+    return input.empty() ? absl::OkStatus()
+                         : errors::DataLoss("Unexpected data after a column.");
+  }
+
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(
+        metadata.uniform_shape() ? metadata.shape()
+                                 : metadata.element_shapes(i),
+        &shape));
+    column.emplace_back(dtype, shape);
+  }
+  switch (metadata.encoding()) {
+    case ColumnMetadata::PLAIN:
+      for (Tensor& tensor : column) {
+        if (dtype == DT_STRING) {
+          auto values = tensor.flat<tstring>();
+          for (int64_t i = 0; i < values.size(); ++i) {
+            StringPiece data;
+            TF_RETURN_IF_ERROR(GetLengthPrefixed(&input, &data));
+            values(i).assign(data.data(), data.size());
+          }
+          continue;
+        }
+        const size_t size = tensor.TotalBytes();
+        if (size > input.size()) {
+          return errors::DataLoss("Column is shorter than its tensors.");
+        }
+        if (size > 0) {
+          memcpy(DMAHelper::base(&tensor), input.data(), size);
+        }
+        input.remove_prefix(size);
+      }
+      break;
+    case ColumnMetadata::DELTA:
+      if (dtype == DT_INT32) {
+        TF_RETURN_IF_ERROR(DeltaDecode<int32_t>(&input, column));
+      } else if (dtype == DT_INT64) {
+        TF_RETURN_IF_ERROR(DeltaDecode<int64_t>(&input, column));
+      } else {
+        return errors::DataLoss("Delta encoding is not supported for ",
+                                DataTypeString(dtype));
+      }
+      break;
+    case ColumnMetadata::DICTIONARY: {
+      if (dtype != DT_STRING) {
+        return errors::DataLoss("Dictionary encoding is not supported for ",
+                                DataTypeString(dtype));
+      }
+      uint64 dictionary_size = 0;
+      TF_RETURN_IF_ERROR(GetVarint(&input, &dictionary_size));
+      std::vector<StringPiece> dictionary;
+      for (uint64 i = 0; i < dictionary_size; ++i) {
+        StringPiece value;
+        TF_RETURN_IF_ERROR(GetLengthPrefixed(&input, &value));
+        dictionary.push_back(value);
+      }
+      for (Tensor& tensor : column) {
+        auto values = tensor.flat<tstring>();
+        for (int64_t i = 0; i < values.size(); ++i) {
+          uint64 index = 0;
+          TF_RETURN_IF_ERROR(GetVarint(&input, &index));
+          if (index >= dictionary.size()) {
+            return errors::DataLoss("Dictionary index ", index,
+                                    " is out of range.");
+          }
+          values(i).assign(dictionary[index].data(), dictionary[index].size());
+        }
+      }
+      break;
+    }
+    default:
+      return errors::DataLoss("Unknown column encoding ",
+                              metadata.encoding());
+  }
+  return input.empty() ? absl::OkStatus()
+                       : errors::DataLoss("Unexpected data after a column.");
+}
+
+Status CheckColumnarCompression(const std::string& compression_type) {
+  if (compression_type != io::compression::kNone &&
+      compression_type != io::compression::kSnappy) {
+    return errors::InvalidArgument(
+        "Columnar snapshot files support snappy compression or no "
+        "compression, got compression: ",
+        compression_type);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
+/* static */ constexpr const int64_t ColumnarWriter::kMaxBlockElements;
+/* static */ constexpr const int64_t ColumnarWriter::kMaxBlockSizeBytes;
 /* static */ constexpr const int64_t
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64_t
@@ -128,6 +417,10 @@ Status Writer::Create(Env* env, const std::string& filename,
       *out_writer =
           std::make_unique<TFRecordWriter>(filename, compression_type);
       break;
+    case 3:
+      *out_writer =
+          std::make_unique<ColumnarWriter>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot writer version: ", version,
                                      " is not supported.");
@@ -142,6 +435,8 @@ TFRecordWriter::TFRecordWriter(const std::string& filename,
 
 Status TFRecordWriter::Initialize(tensorflow::Env* env) {
   TF_RETURN_IF_ERROR(env->NewAppendableFile(filename_, &dest_));
+  // Snapshots are only read back by later epochs or jobs.
+  TF_RETURN_IF_ERROR(dest_->AvoidPageCache());
 
   record_writer_ = std::make_unique<io::RecordWriter>(
       dest_.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
@@ -209,6 +504,7 @@ CustomWriter::CustomWriter(const std::string& filename,
 
 Status CustomWriter::Initialize(tensorflow::Env* env) {
   TF_RETURN_IF_ERROR(env->NewAppendableFile(filename_, &dest_));
+  TF_RETURN_IF_ERROR(dest_->AvoidPageCache());
 #if defined(IS_SLIM_BUILD)
   if (compression_type_ != io::compression::kNone) {
     LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
@@ -361,6 +657,107 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
 }
 #endif  // TF_CORD_SUPPORT
 
+ColumnarWriter::ColumnarWriter(const std::string& filename,
+                               const std::string& compression_type,
+                               const DataTypeVector& dtypes)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes),
+      columns_(dtypes.size()) {}
+
+Status ColumnarWriter::Initialize(tensorflow::Env* env) {
+  TF_RETURN_IF_ERROR(CheckColumnarCompression(compression_type_));
+  TF_RETURN_IF_ERROR(env->NewAppendableFile(filename_, &dest_));
+  return dest_->AvoidPageCache();
+}
+
+Status ColumnarWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (tensors.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected ", dtypes_.size(),
+                                   " tensors per snapshot element, got ",
+                                   tensors.size());
+  }
+  for (int i = 0; i < tensors.size(); ++i) {
+    if (tensors[i].dtype() != dtypes_[i]) {
+      return errors::InvalidArgument(
+          "Expected component ", i, " of snapshot elements to have type ",
+          DataTypeString(dtypes_[i]), ", got ",
+          DataTypeString(tensors[i].dtype()));
+    }
+    buffered_bytes_ += tensors[i].TotalBytes();
+    columns_[i].push_back(tensors[i]);
+  }
+  ++num_buffered_elements_;
+  if (num_buffered_elements_ >= kMaxBlockElements ||
+      buffered_bytes_ >= kMaxBlockSizeBytes) {
+    return WriteBlock();
+  }
+  return absl::OkStatus();
+}
+
+Status ColumnarWriter::WriteBlock() {
+  if (num_buffered_elements_ == 0) {
+    return absl::OkStatus();
+  }
+  profiler::TraceMe activity("ColumnarWriter::WriteBlock",
+                             profiler::TraceMeLevel::kInfo);
+  ColumnarBlockMetadata metadata;
+  metadata.set_num_elements(num_buffered_elements_);
+  std::vector<std::string> records(columns_.size());
+  for (int i = 0; i < columns_.size(); ++i) {
+    ColumnMetadata* column_metadata = metadata.add_columns();
+    std::string encoded;
+    TF_RETURN_IF_ERROR(
+        EncodeColumn(columns_[i], dtypes_[i], column_metadata, &encoded));
+    if (compression_type_ == io::compression::kSnappy) {
+      if (!tsl::port::Snappy_Compress(encoded.data(), encoded.size(),
+                                      &records[i])) {
+        return errors::Internal("Failed to compress using snappy.");
+      }
+    } else {
+      records[i] = std::move(encoded);
+    }
+    column_metadata->set_size_bytes(records[i].size());
+    columns_[i].clear();
+  }
+  num_buffered_elements_ = 0;
+  buffered_bytes_ = 0;
+
+  TF_RETURN_IF_ERROR(WriteRecord(metadata.SerializeAsString()));
+  for (const std::string& record : records) {
+    TF_RETURN_IF_ERROR(WriteRecord(record));
+  }
+  return absl::OkStatus();
+}
+
+Status ColumnarWriter::WriteRecord(const StringPiece& data) {
+  char header[CustomWriter::kHeaderSize];
+  core::EncodeFixed64(header, data.size());
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+  return dest_->Append(data);
+}
+
+Status ColumnarWriter::Sync() {
+  TF_RETURN_IF_ERROR(WriteBlock());
+  return dest_->Sync();
+}
+
+Status ColumnarWriter::Close() {
+  if (dest_ != nullptr) {
+    TF_RETURN_IF_ERROR(WriteBlock());
+    TF_RETURN_IF_ERROR(dest_->Close());
+    dest_ = nullptr;
+  }
+  return absl::OkStatus();
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  Status s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << "Failed to close snapshot file " << filename_ << ": " << s;
+  }
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -378,6 +775,10 @@ Status Reader::Create(Env* env, const std::string& filename,
       *out_reader =
           std::make_unique<TFRecordReader>(filename, compression_type, dtypes);
       break;
+    case 3:
+      *out_reader =
+          std::make_unique<ColumnarReader>(filename, compression_type, dtypes);
+      break;
     default:
       return errors::InvalidArgument("Snapshot reader version: ", version,
                                      " is not supported.");
@@ -1008,6 +1409,120 @@ Status CustomReader::ReadRecord(absl::Cord* record) {
 }
 #endif  // TF_CORD_SUPPORT
 
+ColumnarReader::ColumnarReader(const std::string& filename,
+                               const string& compression_type,
+                               const DataTypeVector& dtypes,
+                               std::vector<int64_t> projection)
+    : filename_(filename),
+      compression_type_(compression_type),
+      dtypes_(dtypes),
+      projection_(std::move(projection)) {
+  if (projection_.empty()) {
+    for (int64_t i = 0; i < dtypes_.size(); ++i) {
+      projection_.push_back(i);
+    }
+  }
+}
+
+Status ColumnarReader::Initialize(Env* env) {
+  TF_RETURN_IF_ERROR(CheckColumnarCompression(compression_type_));
+  for (int64_t index : projection_) {
+    if (index < 0 || index >= dtypes_.size()) {
+      return errors::InvalidArgument("Projected component ", index,
+                                     " is out of range for elements with ",
+                                     dtypes_.size(), " components.");
+    }
+  }
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
+  input_stream_ = std::make_unique<io::BufferedInputStream>(
+      file_.get(), kColumnarReaderBufferSizeBytes);
+  return absl::OkStatus();
+}
+
+Status ColumnarReader::ReadTensors(std::vector<Tensor>* read_tensors) {
+  while (next_block_element_ >= num_block_elements_) {
+    TF_RETURN_IF_ERROR(ReadBlock());
+  }
+  read_tensors->clear();
+  read_tensors->reserve(columns_.size());
+  for (std::vector<Tensor>& column : columns_) {
+    read_tensors->push_back(std::move(column[next_block_element_]));
+  }
+  ++next_block_element_;
+  return absl::OkStatus();
+}
+
+Status ColumnarReader::ReadBlock() {
+  profiler::TraceMe activity("ColumnarReader::ReadBlock",
+                             profiler::TraceMeLevel::kInfo);
+  tstring record;
+  TF_RETURN_IF_ERROR(ReadRecord(&record));
+  ColumnarBlockMetadata metadata;
+  if (!metadata.ParseFromArray(record.data(), record.size())) {
+    return errors::DataLoss("Failed to parse a block of snapshot file ",
+                            filename_);
+  }
+  if (metadata.columns_size() != dtypes_.size()) {
+    return errors::DataLoss("Expected ", dtypes_.size(),
+                            " columns in a block of snapshot file ", filename_,
+                            ", got ", metadata.columns_size());
+  }
+
+  std::vector<bool> projected(dtypes_.size(), false);
+  for (int64_t index : projection_) {
+    projected[index] = true;
+  }
+  std::vector<std::vector<Tensor>> columns(dtypes_.size());
+  for (int i = 0; i < dtypes_.size(); ++i) {
+    const ColumnMetadata& column_metadata = metadata.columns(i);
+    if (!projected[i]) {
+      TF_RETURN_IF_ERROR(input_stream_->SkipNBytes(
+          CustomReader::kHeaderSize + column_metadata.size_bytes()));
+      continue;
+    }
+    TF_RETURN_IF_ERROR(ReadRecord(&record));
+    StringPiece data = record;
+    std::string uncompressed;
+    if (compression_type_ == io::compression::kSnappy) {
+      size_t size = 0;
+      if (!tsl::port::Snappy_GetUncompressedLength(record.data(),
+                                                   record.size(), &size)) {
+        return errors::DataLoss("Failed to get the uncompressed size of a "
+                                "column of snapshot file ",
+                                filename_);
+      }
+      uncompressed.resize(size);
+      if (!tsl::port::Snappy_Uncompress(record.data(), record.size(),
+                                        uncompressed.data())) {
+        return errors::DataLoss("Failed to uncompress a column of snapshot "
+                                "file ",
+                                filename_);
+      }
+      data = uncompressed;
+    }
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(
+        DecodeColumn(data, dtypes_[i], column_metadata,
+                     metadata.num_elements(), columns[i]),
+        " Failed to decode column ", i, " of snapshot file ", filename_);
+  }
+
+  columns_.clear();
+  for (int64_t index : projection_) {
+    columns_.push_back(columns[index]);
+  }
+  num_block_elements_ = metadata.num_elements();
+  next_block_element_ = 0;
+  return absl::OkStatus();
+}
+
+Status ColumnarReader::ReadRecord(tstring* record) {
+  tstring header;
+  TF_RETURN_IF_ERROR(
+      input_stream_->ReadNBytes(CustomReader::kHeaderSize, &header));
+  uint64 length = core::DecodeFixed64(header.data());
+  return input_stream_->ReadNBytes(length, record);
+}
+
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata) {
   string metadata_filename = io::JoinPath(dir, kMetadataFilename);
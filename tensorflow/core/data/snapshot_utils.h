@@ -173,6 +173,52 @@ class CustomWriter : public Writer {
   int num_complex_ = 0;
 };
 
+// Writes snapshots with a columnar file format (version 3).
+//
+// Elements are buffered into blocks of up to `kMaxBlockElements` elements or
+// `kMaxBlockSizeBytes` bytes. Each block is written as a
+// `ColumnarBlockMetadata` record followed by one record per component, in
+// component order, which holds that component of all the elements of the
+// block. Each column is encoded with the encoding that makes it smallest:
+// integer columns may be delta encoded, and string columns may be dictionary
+// encoded. Columns are then compressed separately, so readers can skip the
+// columns they do not need. Records are framed as in `CustomWriter`.
+class ColumnarWriter : public Writer {
+ public:
+  static constexpr const int64_t kMaxBlockElements = 1024;
+  static constexpr const int64_t kMaxBlockSizeBytes = 16 << 20;  // 16MB
+
+  ColumnarWriter(const std::string& filename,
+                 const std::string& compression_type,
+                 const DataTypeVector& dtypes);
+
+  Status WriteTensors(const std::vector<Tensor>& tensors) override;
+
+  // Writes the buffered elements as a block, then flushes the file.
+  Status Sync() override;
+
+  Status Close() override;
+
+  ~ColumnarWriter() override;
+
+ protected:
+  Status Initialize(tensorflow::Env* env) override;
+
+ private:
+  // Writes the buffered elements as a block.
+  Status WriteBlock();
+  Status WriteRecord(const StringPiece& data);
+
+  const std::string filename_;
+  const std::string compression_type_;
+  const DataTypeVector dtypes_;
+  std::unique_ptr<WritableFile> dest_;
+  // The components of the buffered elements, by component.
+  std::vector<std::vector<Tensor>> columns_;
+  int64_t num_buffered_elements_ = 0;
+  int64_t buffered_bytes_ = 0;
+};
+
 // Interface class for reading snapshot files previous written with Writer.
 class Reader {
  public:
@@ -363,6 +409,40 @@ class CustomReader : public Reader {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
 };
 
+// Reads snapshots previously written with `ColumnarWriter`.
+class ColumnarReader : public Reader {
+ public:
+  // If `projection` is not empty, `ReadTensors` only returns the components
+  // with these indices, in this order, and the other columns are skipped
+  // without being decompressed or decoded.
+  ColumnarReader(const std::string& filename, const string& compression_type,
+                 const DataTypeVector& dtypes,
+                 std::vector<int64_t> projection = {});
+
+  Status Initialize(Env* env) override;
+
+  Status ReadTensors(std::vector<Tensor>* read_tensors) override;
+
+  ~ColumnarReader() override = default;
+
+ private:
+  // Reads and decodes the next block into `columns_`.
+  Status ReadBlock();
+  Status ReadRecord(tstring* record);
+
+  const std::string filename_;
+  const string compression_type_;
+  const DataTypeVector dtypes_;
+  // The indices of the components to return.
+  std::vector<int64_t> projection_;
+  std::unique_ptr<RandomAccessFile> file_;
+  std::unique_ptr<io::InputStreamInterface> input_stream_;
+  // The projected columns of the current block, in `projection_` order.
+  std::vector<std::vector<Tensor>> columns_;
+  int64_t num_block_elements_ = 0;
+  int64_t next_block_element_ = 0;
+};
+
 // Writes snapshot metadata to the given directory.
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata);
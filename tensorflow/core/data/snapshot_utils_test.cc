@@ -19,11 +19,14 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/test_util.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -97,6 +100,102 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kNone, 2);
   SnapshotRoundTrip(io::compression::kGzip, 2);
   SnapshotRoundTrip(io::compression::kSnappy, 2);
+
+  SnapshotRoundTrip(io::compression::kNone, 3);
+  SnapshotRoundTrip(io::compression::kSnappy, 3);
+}
+
+// Returns an element with a sequential int64 ID, a low-cardinality string, and
+// a float vector whose length varies.
+std::vector<Tensor> TabularElement(int64_t i) {
+  return {test::AsScalar<int64_t>(1000 + i),
+          test::AsTensor<tstring>({absl::StrCat("category_", i % 3)}),
+          test::AsTensor<float>(std::vector<float>(i % 4, 0.5f * i))};
+}
+
+void WriteTabularSnapshot(const std::string& filename,
+                          const std::string& compression_type,
+                          int64_t num_elements) {
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename, compression_type,
+                              /*version=*/3, {DT_INT64, DT_STRING, DT_FLOAT},
+                              &writer));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TF_ASSERT_OK(writer->WriteTensors(TabularElement(i)));
+  }
+  TF_ASSERT_OK(writer->Close());
+}
+
+TEST(SnapshotUtilTest, ColumnarRoundTrip) {
+  // Spans several blocks.
+  const int64_t num_elements = 3 * ColumnarWriter::kMaxBlockElements + 7;
+  std::string filename = LocalTempFilename();
+  WriteTabularSnapshot(filename, io::compression::kSnappy, num_elements);
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename,
+                              io::compression::kSnappy, /*version=*/3,
+                              {DT_INT64, DT_STRING, DT_FLOAT}, &reader));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader->ReadTensors(&element));
+    std::vector<Tensor> expected = TabularElement(i);
+    ASSERT_EQ(element.size(), expected.size());
+    for (int j = 0; j < element.size(); ++j) {
+      test::ExpectEqual(element[j], expected[j]);
+    }
+  }
+  std::vector<Tensor> element;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&element)));
+}
+
+TEST(SnapshotUtilTest, ColumnarProjection) {
+  const int64_t num_elements = 100;
+  std::string filename = LocalTempFilename();
+  WriteTabularSnapshot(filename, io::compression::kNone, num_elements);
+
+  ColumnarReader reader(filename, io::compression::kNone,
+                        {DT_INT64, DT_STRING, DT_FLOAT},
+                        /*projection=*/{2, 0});
+  TF_ASSERT_OK(reader.Initialize(Env::Default()));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader.ReadTensors(&element));
+    std::vector<Tensor> expected = TabularElement(i);
+    ASSERT_EQ(element.size(), 2);
+    test::ExpectEqual(element[0], expected[2]);
+    test::ExpectEqual(element[1], expected[0]);
+  }
+}
+
+TEST(SnapshotUtilTest, ColumnarEncodingIsSmallerThanRecords) {
+  const int64_t num_elements = 1000;
+  std::string columnar_filename = LocalTempFilename();
+  WriteTabularSnapshot(columnar_filename, io::compression::kNone,
+                       num_elements);
+  std::string record_filename = LocalTempFilename();
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), record_filename,
+                              io::compression::kNone, /*version=*/2,
+                              {DT_INT64, DT_STRING, DT_FLOAT}, &writer));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TF_ASSERT_OK(writer->WriteTensors(TabularElement(i)));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  uint64 columnar_size = 0;
+  uint64 record_size = 0;
+  TF_ASSERT_OK(Env::Default()->GetFileSize(columnar_filename, &columnar_size));
+  TF_ASSERT_OK(Env::Default()->GetFileSize(record_filename, &record_size));
+  EXPECT_LT(columnar_size, record_size);
+}
+
+TEST(SnapshotUtilTest, ColumnarRejectsStreamCompression) {
+  std::unique_ptr<Writer> writer;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      Writer::Create(Env::Default(), LocalTempFilename(),
+                     io::compression::kGzip, /*version=*/3, {DT_INT64},
+                     &writer)));
 }
 
 TEST(SnapshotUtilTest, MetadataFileRoundTrip) {
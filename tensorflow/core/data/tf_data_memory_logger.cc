@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "absl/base/call_once.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/tfdataz_metrics.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/numbers.h"
@@ -38,6 +39,7 @@ const int64_t kLogFrequencyS = 30;  // How often to log.
 struct IteratorMemoryUsage {
   std::optional<std::string> dataset_name;
   int64_t memory_usage;
+  int64_t ram_budget;
   std::string model_proto;
 };
 
@@ -61,9 +63,9 @@ void LogDatasetMemoryUsage() {
     if (!s.ok()) {
       LOG(ERROR) << "Failed to convert model to proto: " << s;
     }
-    usages.push_back(IteratorMemoryUsage{metric_collector->DatasetName(),
-                                         total_buffered_bytes,
-                                         model_proto.ShortDebugString()});
+    usages.push_back(IteratorMemoryUsage{
+        metric_collector->DatasetName(), total_buffered_bytes,
+        metric_collector->GetRamBudget(), model_proto.ShortDebugString()});
   }
   std::sort(usages.begin(), usages.end(), [](const auto& a, const auto& b) {
     return a.memory_usage > b.memory_usage;
@@ -76,8 +78,9 @@ void LogDatasetMemoryUsage() {
     if (i >= usages.size()) {
       break;
     }
-    std::string usage_string =
-        strings::HumanReadableNumBytes(usages[i].memory_usage);
+    std::string usage_string = absl::StrCat(
+        strings::HumanReadableNumBytes(usages[i].memory_usage), " of ",
+        strings::HumanReadableNumBytes(usages[i].ram_budget), " budget");
     if (usages[i].dataset_name.has_value()) {
       VLOG(4) << "Dataset " << usages[i].dataset_name.value() << ": "
               << usage_string;
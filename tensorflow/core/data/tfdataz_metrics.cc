@@ -134,6 +134,10 @@ int64_t TfDatazMetricsCollector::GetIteratorTotalMemoryUsage() {
   return iterator_->TotalBufferedBytes();
 }
 
+int64_t TfDatazMetricsCollector::GetRamBudget() {
+  return model_->LatestRamBudget();
+}
+
 std::shared_ptr<model::Model> TfDatazMetricsCollector::GetModel() {
   return model_;
 }
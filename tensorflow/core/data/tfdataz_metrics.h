@@ -118,6 +118,11 @@ class TfDatazMetricsCollector {
   // buffered in all nodes in the subtree.
   int64_t GetIteratorTotalMemoryUsage();
 
+  // Returns the RAM budget (in bytes) that the latest autotuning round of the
+  // iterator used. When the RAM budget of the process is split between its
+  // iterators, this is the share allocated to the iterator.
+  int64_t GetRamBudget();
+
   std::shared_ptr<model::Model> GetModel();
 
  private:
@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
 
@@ -43,6 +44,17 @@ std::string LocalityOptimizedPath(const std::string& path) { return path; }
 
 absl::StatusOr<bool> DisableCompressionAtRuntime(
     const std::string& data_transfer_protocol, DeploymentMode deployment_mode) {
+  // Elements read from a worker in the same process are handed to the trainer
+  // without being serialized, so compressing them only costs CPU on both
+  // sides.
+  if (data_transfer_protocol == "local") {
+    return GetExperiments().contains("uncompressed_local_transfer");
+  }
+  // gRPC clients choose the compression of each worker's elements from the
+  // measured costs of reading them, so the dataset must not compress them.
+  if (data_transfer_protocol.empty() || data_transfer_protocol == "grpc") {
+    return GetExperiments().contains("adaptive_element_compression");
+  }
   return false;
 }
 
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/utils.h"
 
+#include <stdlib.h>
+
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -25,6 +27,24 @@ TEST(Util, DefaultDataTransferProtocol) {
   EXPECT_EQ(DefaultDataTransferProtocol(), "grpc");
 }
 
+TEST(Util, DisableCompressionAtRuntime) {
+  // Compression is only disabled for local transfers under an experiment.
+  EXPECT_FALSE(*DisableCompressionAtRuntime("grpc", DEPLOYMENT_MODE_COLOCATED));
+  EXPECT_FALSE(*DisableCompressionAtRuntime("local", DEPLOYMENT_MODE_REMOTE));
+}
+
+TEST(Util, DisableCompressionAtRuntimeForLocalTransfers) {
+  setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+  setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+  setenv("TF_DATA_EXPERIMENT_OPT_IN", "uncompressed_local_transfer",
+         /*overwrite=*/1);
+  EXPECT_TRUE(*DisableCompressionAtRuntime("local", DEPLOYMENT_MODE_COLOCATED));
+  EXPECT_FALSE(*DisableCompressionAtRuntime("grpc", DEPLOYMENT_MODE_COLOCATED));
+  unsetenv("TF_JOB_NAME");
+  unsetenv("TF_TASK_ID");
+  unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+}
+
 TEST(TranslateFileName, NoOp) {
   constexpr char file[] = "/home/tfdata/file1";
   EXPECT_EQ(TranslateFileName(file), file);
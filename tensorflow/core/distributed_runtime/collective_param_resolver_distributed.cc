@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 
+#include <utility>
+#include <vector>
+
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -51,6 +54,27 @@ class CompleteGroupCall : public CancellableCall {
   CompleteGroupResponse resp_;
 };
 
+CompleteInstanceRequest MakeCompleteInstanceRequest(
+    const CollGroupParams& group, const CollInstanceParams& instance,
+    const string& node_name, const string& device_name, bool is_source) {
+  CompleteInstanceRequest req;
+  req.set_name(node_name);
+  req.set_type(instance.type);
+  req.set_step_id(instance.step_id);
+  req.set_data_type(instance.data_type);
+  instance.shape.AsProto(req.mutable_shape());
+  req.set_group_key(group.group_key);
+  req.set_group_size(group.group_size);
+  req.set_instance_key(instance.instance_key);
+  req.set_device_type(group.device_type.type_string());
+  for (int32_t offset : instance.impl_details.subdiv_offsets) {
+    req.add_subdiv_offset(offset);
+  }
+  req.set_device(device_name);
+  req.set_is_source(is_source);
+  return req;
+}
+
 class CompleteInstanceCall : public CancellableCall {
  public:
   CompleteInstanceCall(const CollGroupParams& group,
@@ -58,22 +82,9 @@ class CompleteInstanceCall : public CancellableCall {
                        const string& node_name, const string& device_name,
                        bool is_source, CancellationManager* cancel_mgr,
                        const string& remote_worker, WorkerCacheInterface* wc)
-      : CancellableCall(cancel_mgr, remote_worker, wc) {
-    req_.set_name(node_name);
-    req_.set_type(instance.type);
-    req_.set_step_id(instance.step_id);
-    req_.set_data_type(instance.data_type);
-    instance.shape.AsProto(req_.mutable_shape());
-    req_.set_group_key(group.group_key);
-    req_.set_group_size(group.group_size);
-    req_.set_instance_key(instance.instance_key);
-    req_.set_device_type(group.device_type.type_string());
-    for (int32_t offset : instance.impl_details.subdiv_offsets) {
-      req_.add_subdiv_offset(offset);
-    }
-    req_.set_device(device_name);
-    req_.set_is_source(is_source);
-  }
+      : CancellableCall(cancel_mgr, remote_worker, wc),
+        req_(MakeCompleteInstanceRequest(group, instance, node_name,
+                                         device_name, is_source)) {}
 
   ~CompleteInstanceCall() override {}
 
@@ -85,6 +96,39 @@ class CompleteInstanceCall : public CancellableCall {
   CompleteInstanceResponse resp_;
 };
 
+class CompleteInstancesCall : public CancellableCall {
+ public:
+  CompleteInstancesCall(const std::vector<CompleteInstanceRequest>& requests,
+                        const string& remote_worker, WorkerCacheInterface* wc)
+      : CancellableCall(/*cancel_mgr=*/nullptr, remote_worker, wc) {
+    for (const CompleteInstanceRequest& request : requests) {
+      *req_.add_request() = request;
+    }
+  }
+
+  ~CompleteInstancesCall() override {}
+
+  void IssueCall(const StatusCallback& done) override {
+    wi_->CompleteInstancesAsync(&opts_, &req_, &resp_, done);
+  }
+
+  // Returns the status of the index-th instance.
+  Status InstanceStatus(int index) const {
+    if (resp_.response_size() != req_.request_size() ||
+        resp_.status_code_size() != req_.request_size() ||
+        resp_.status_error_message_size() != req_.request_size()) {
+      return errors::Internal("CompleteInstancesResponse has ",
+                              resp_.response_size(), " responses for ",
+                              req_.request_size(), " requests");
+    }
+    return Status(static_cast<absl::StatusCode>(resp_.status_code(index)),
+                  resp_.status_error_message(index));
+  }
+
+  CompleteInstancesRequest req_;
+  CompleteInstancesResponse resp_;
+};
+
 }  // namespace
 
 CollectiveParamResolverDistributed::CollectiveParamResolverDistributed(
@@ -371,33 +415,139 @@ void CollectiveParamResolverDistributed::CompleteInstanceDistributed(
     return CompleteInstanceLocal(device, cp, done);
   } else if (InstanceIsCached(cp->group.group_key, cp->instance)) {
     return CompleteInstanceLocal(device, cp, done);
-  } else {
-    CompleteInstanceCall* call = new CompleteInstanceCall(
-        cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
-        group_leader_, worker_cache_);
-    CancellationToken abortion_token =
-        abortion_cancel_mgr_.get_cancellation_token();
-    bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
-        abortion_token, [call] { call->Cancel(); });
-    if (already_aborted) {
-      done(errors::Cancelled("collective ops already aborted"));
-      delete call;
-      return;
+  } else if (cp->instance.type == BROADCAST_COLLECTIVE) {
+    // The leader only answers once the source of the broadcast is known,
+    // which may depend on other instances, so it is never batched.
+    return CompleteInstanceRemote(device, cp, cancel_mgr, done);
+  }
+  std::vector<PendingInstance> batch;
+  {
+    mutex_lock l(batch_mu_);
+    if (leader_completes_batches_) {
+      // Instances that arrive while a call is in flight are sent together
+      // when it returns.
+      pending_instances_.push_back({device, cp, cancel_mgr, done});
+      if (instance_call_in_flight_) return;
+      instance_call_in_flight_ = true;
+      batch.swap(pending_instances_);
     }
-    call->Start([this, device, cp, call, abortion_token, done](Status s) {
-      abortion_cancel_mgr_.DeregisterCallback(abortion_token);
-      if (s.ok()) {
-        s = UpdateInstanceCache(cp, call->resp_);
+  }
+  if (batch.empty()) {
+    return CompleteInstanceRemote(device, cp, cancel_mgr, done);
+  }
+  SendInstanceBatch(std::move(batch));
+}
+
+void CollectiveParamResolverDistributed::SendPendingInstances() {
+  std::vector<PendingInstance> batch;
+  bool send_batch;
+  {
+    mutex_lock l(batch_mu_);
+    batch.swap(pending_instances_);
+    send_batch = !batch.empty() && leader_completes_batches_;
+    instance_call_in_flight_ = send_batch;
+  }
+  if (send_batch) return SendInstanceBatch(std::move(batch));
+  for (PendingInstance& instance : batch) {
+    CompleteInstanceRemote(instance.device, instance.cp, instance.cancel_mgr,
+                           instance.done);
+  }
+}
+
+void CollectiveParamResolverDistributed::SendInstanceBatch(
+    std::vector<PendingInstance> batch) {
+  if (batch.size() == 1) {
+    PendingInstance& instance = batch[0];
+    CompleteInstanceRemote(
+        instance.device, instance.cp, instance.cancel_mgr,
+        [this, done = std::move(instance.done)](const Status& s) {
+          done(s);
+          SendPendingInstances();
+        });
+    return;
+  }
+  VLOG(1) << "Completing " << batch.size() << " instances at "
+          << group_leader_;
+  std::vector<CompleteInstanceRequest> requests;
+  requests.reserve(batch.size());
+  for (const PendingInstance& instance : batch) {
+    requests.push_back(MakeCompleteInstanceRequest(
+        instance.cp->group, instance.cp->instance, instance.cp->name,
+        instance.device, instance.cp->is_source));
+  }
+  CompleteInstancesCall* call =
+      new CompleteInstancesCall(requests, group_leader_, worker_cache_);
+  CancellationToken abortion_token =
+      abortion_cancel_mgr_.get_cancellation_token();
+  bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
+      abortion_token, [call] { call->Cancel(); });
+  if (already_aborted) {
+    for (PendingInstance& instance : batch) {
+      instance.done(errors::Cancelled("collective ops already aborted"));
+    }
+    delete call;
+    SendPendingInstances();
+    return;
+  }
+  call->Start([this, call, abortion_token,
+               batch = std::move(batch)](const Status& s) mutable {
+    abortion_cancel_mgr_.DeregisterCallback(abortion_token);
+    if (errors::IsUnimplemented(s)) {
+      // The leader predates CompleteInstances.
+      {
+        mutex_lock l(batch_mu_);
+        leader_completes_batches_ = false;
       }
-      if (s.ok()) {
-        CompleteInstanceLocal(device, cp, done);
-      } else {
-        done(s);
+      for (PendingInstance& instance : batch) {
+        CompleteInstanceRemote(instance.device, instance.cp,
+                               instance.cancel_mgr, instance.done);
       }
-      delete call;
-    });
+    } else {
+      for (int i = 0; i < batch.size(); ++i) {
+        PendingInstance& instance = batch[i];
+        Status status = s.ok() ? call->InstanceStatus(i) : s;
+        if (status.ok()) {
+          status = UpdateInstanceCache(instance.cp, call->resp_.response(i));
+        }
+        if (status.ok()) {
+          CompleteInstanceLocal(instance.device, instance.cp, instance.done);
+        } else {
+          instance.done(status);
+        }
+      }
+    }
+    delete call;
+    SendPendingInstances();
+  });
+}
+
+void CollectiveParamResolverDistributed::CompleteInstanceRemote(
+    const string& device, CollectiveParams* cp, CancellationManager* cancel_mgr,
+    const StatusCallback& done) {
+  CompleteInstanceCall* call = new CompleteInstanceCall(
+      cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
+      group_leader_, worker_cache_);
+  CancellationToken abortion_token =
+      abortion_cancel_mgr_.get_cancellation_token();
+  bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
+      abortion_token, [call] { call->Cancel(); });
+  if (already_aborted) {
+    done(errors::Cancelled("collective ops already aborted"));
+    delete call;
     return;
   }
+  call->Start([this, device, cp, call, abortion_token, done](Status s) {
+    abortion_cancel_mgr_.DeregisterCallback(abortion_token);
+    if (s.ok()) {
+      s = UpdateInstanceCache(cp, call->resp_);
+    }
+    if (s.ok()) {
+      CompleteInstanceLocal(device, cp, done);
+    } else {
+      done(s);
+    }
+    delete call;
+  });
 }
 
 void CollectiveParamResolverDistributed::StartAbort(const Status& s) {
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
@@ -87,9 +89,40 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
                                    const StatusCallback& done)
       TF_LOCKS_EXCLUDED(instance_mu_, group_mu_);
 
+  // Gets the instance of *cp from the group leader and completes it locally.
+  void CompleteInstanceRemote(const string& device, CollectiveParams* cp,
+                              CancellationManager* cancel_mgr,
+                              const StatusCallback& done)
+      TF_LOCKS_EXCLUDED(instance_mu_, group_mu_);
+
+  // An instance waiting to be sent to the group leader.
+  struct PendingInstance {
+    string device;
+    CollectiveParams* cp;
+    CancellationManager* cancel_mgr;
+    StatusCallback done;
+  };
+
+  // Gets the instances of `batch` from the group leader in one call, then
+  // sends the instances that queued up meanwhile.
+  void SendInstanceBatch(std::vector<PendingInstance> batch)
+      TF_LOCKS_EXCLUDED(batch_mu_);
+
+  // Sends the queued instances once the call in flight is done.
+  void SendPendingInstances() TF_LOCKS_EXCLUDED(batch_mu_);
+
   WorkerCacheInterface* worker_cache_;  // Not owned
   const string group_leader_;
   CancellationManager abortion_cancel_mgr_;
+
+  // Instances that don't wait for a broadcast source are resolved by the
+  // leader at once, so the ones that are requested while a call to the
+  // leader is in flight are queued and sent together in the next call.
+  mutex batch_mu_;
+  std::vector<PendingInstance> pending_instances_ TF_GUARDED_BY(batch_mu_);
+  bool instance_call_in_flight_ TF_GUARDED_BY(batch_mu_) = false;
+  // Whether the leader implements CompleteInstances.
+  bool leader_completes_batches_ TF_GUARDED_BY(batch_mu_) = true;
 };
 
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -380,5 +381,47 @@ TEST_F(DeviceResDistTest, Workers4Devices3) {
   ValidateCollectiveParams(num_workers, num_devices);
 }
 
+TEST_F(DeviceResDistTest, ConcurrentInstances) {
+  const int num_workers = 2;
+  const int num_devices = 2;
+  DefineWorkers(num_workers, num_devices, "CPU", false);
+  DefineCollectiveParams(num_workers, num_devices, "CPU");
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+
+  // Once the group is known, the instances requested by the non-leader
+  // worker while a call to the leader is in flight are sent in batches.
+  const int kNumInstances = 50;
+  const string task_name = "/job:worker/replica:0/task:1";
+  const string device_name = strings::StrCat(task_name, "/device:CPU:0");
+  Device* device = nullptr;
+  TF_ASSERT_OK(device_mgrs_[task_name]->LookupDevice(device_name, &device));
+  std::vector<CollectiveParams*> cps;
+  std::vector<Status> statuses(kNumInstances);
+  BlockingCounter counter(kNumInstances);
+  for (int i = 0; i < kNumInstances; ++i) {
+    CollectiveParams* cp = CreateCollectiveParams(
+        num_workers, num_devices, "CPU", REDUCTION_COLLECTIVE, false);
+    cp->instance.instance_key = 100 + i;
+    cps.push_back(cp);
+  }
+  for (int i = 0; i < kNumInstances; ++i) {
+    cp_resolvers_[task_name]->CompleteParamsAsync(
+        device->attributes(), cps[i], &cm_,
+        [&statuses, &counter, i](const Status& s) {
+          statuses[i] = s;
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
+  for (int i = 0; i < kNumInstances; ++i) {
+    TF_EXPECT_OK(statuses[i]);
+    EXPECT_EQ(cps[i]->instance.instance_key, 100 + i);
+    EXPECT_EQ(cps[i]->default_rank, 2);
+    EXPECT_EQ(cps[i]->group.members.size(), num_workers * num_devices);
+    cps[i]->Unref();
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
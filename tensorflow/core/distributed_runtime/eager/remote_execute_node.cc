@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/eager/remote_execute_node.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
@@ -24,19 +25,89 @@ limitations under the License.
 namespace tensorflow {
 namespace eager {
 
+namespace {
+
+// The handles of a node sent in an EnqueueRequest, which are referenced until
+// the request is done.
+struct EnqueuedNode {
+  gtl::InlinedVector<TensorHandle*, 4> inputs;
+  gtl::InlinedVector<TensorHandle*, 2> retvals;
+  Device* device;
+  // The index of the response to the operation of the node.
+  int response_index;
+};
+
+}  // namespace
+
+bool RemoteExecuteNode::CanBatchWith(const RemoteExecuteNode& other) const {
+  return !needs_remote_inputs_ && !other.needs_remote_inputs_ &&
+         eager_context_ == other.eager_context_ &&
+         eager_client_ == other.eager_client_ &&
+         context_view_id_ == other.context_view_id_ &&
+         cancellation_manager_ == other.cancellation_manager_ &&
+         request_->context_id() == other.request_->context_id();
+}
+
+int RemoteExecuteNode::NumBatchable(
+    absl::Span<EagerNode* const> next_nodes) const {
+  int num_batchable = 0;
+  for (EagerNode* node : next_nodes) {
+    AsyncRemoteExecuteNode* remote_node = node->AsAsyncRemoteExecuteNode();
+    // RemoteExecuteNode is the only AsyncRemoteExecuteNode.
+    if (remote_node == nullptr ||
+        !CanBatchWith(*static_cast<RemoteExecuteNode*>(remote_node))) {
+      break;
+    }
+    ++num_batchable;
+  }
+  return num_batchable;
+}
+
 void RemoteExecuteNode::RunAsync(StatusCallback done) {
+  RunAsyncBatched({}, std::move(done));
+}
+
+void RemoteExecuteNode::RunAsyncBatched(
+    absl::Span<EagerNode* const> batched_nodes, StatusCallback done) {
   auto response = std::make_shared<EnqueueResponse>();
 
-  const gtl::InlinedVector<TensorHandle*, 4>& inputs = inputs_;
-  const gtl::InlinedVector<TensorHandle*, 2>& retvals = retvals_;
-  Device* device = device_;
+  std::vector<RemoteExecuteNode*> nodes;
+  nodes.reserve(batched_nodes.size() + 1);
+  nodes.push_back(this);
+  for (EagerNode* node : batched_nodes) {
+    nodes.push_back(
+        static_cast<RemoteExecuteNode*>(node->AsAsyncRemoteExecuteNode()));
+  }
+
+  // The operations of batched nodes are moved to a single request, since the
+  // requests of the nodes aren't used after they were sent.
+  std::shared_ptr<EnqueueRequest> batched_request;
+  const EnqueueRequest* request = request_.get();
+  if (!batched_nodes.empty()) {
+    batched_request = std::make_shared<EnqueueRequest>();
+    batched_request->set_context_id(request_->context_id());
+    request = batched_request.get();
+  }
+  std::vector<EnqueuedNode> enqueued_nodes;
+  enqueued_nodes.reserve(nodes.size());
+  int num_queue_items = 0;
+  for (RemoteExecuteNode* node : nodes) {
+    enqueued_nodes.push_back(
+        {node->inputs_, node->retvals_, node->device_, num_queue_items});
+    num_queue_items += node->request_->queue_size();
+    if (batched_request != nullptr) {
+      for (QueueItem& item : *node->request_->mutable_queue()) {
+        *batched_request->add_queue() = std::move(item);
+      }
+    }
+  }
 
   // Filled and used only when VLOG(3) is on.
   string rpc_description;
   if (VLOG_IS_ON(3)) {
     std::vector<string> ops;
-    ops.reserve(request_->queue_size());
-    for (const QueueItem& item : request_->queue()) {
+    ops.reserve(request->queue_size());
+    for (const QueueItem& item : request->queue()) {
       if (item.has_operation()) {
         ops.push_back(item.operation().name());
       } else {
@@ -61,62 +132,70 @@ void RemoteExecuteNode::RunAsync(StatusCallback done) {
         token, [call_opts, response, done]() { call_opts->StartCancel(); });
     if (already_cancelled) {
       Status s = errors::Cancelled("RemoteExecuteNode::RunAsync");
-      for (size_t i = 0; i < retvals.size(); ++i) {
-        retvals[i]->PoisonRemote(s, device, context_view_id_);
+      for (const EnqueuedNode& node : enqueued_nodes) {
+        for (TensorHandle* retval : node.retvals) {
+          retval->PoisonRemote(s, node.device, context_view_id_);
+        }
       }
       done(s);
       return;
     }
   }
 
-  for (auto handle : inputs_) {
-    handle->Ref();
-  }
-  for (auto handle : retvals) {
-    handle->Ref();
+  for (const EnqueuedNode& node : enqueued_nodes) {
+    for (auto handle : node.inputs) {
+      handle->Ref();
+    }
+    for (auto handle : node.retvals) {
+      handle->Ref();
+    }
   }
 
   eager_client_->StreamingEnqueueAsync(
-      eager_context_->Executor().StreamingEnqueue(), call_opts.get(),
-      request_.get(), response.get(),
-      [inputs, retvals, call_opts, response, device,
-       context_view_id = context_view_id_, rpc_description, cm, token,
-       done](const Status& status) {
+      eager_context_->Executor().StreamingEnqueue(), call_opts.get(), request,
+      response.get(),
+      [enqueued_nodes = std::move(enqueued_nodes), batched_request, call_opts,
+       response, context_view_id = context_view_id_, rpc_description, cm,
+       token, done](const Status& status) {
         if (cm != nullptr) {
           cm->TryDeregisterCallback(token);
         }
-        for (auto handle : inputs) {
-          handle->Unref();
-        }
         if (status.ok()) {
           VLOG(3) << "Completed successfully: " << rpc_description;
         } else {
           VLOG(3) << "Failed: " << rpc_description << " with status "
                   << status.ToString();
         }
-        for (size_t i = 0; i < retvals.size(); ++i) {
-          if (status.ok()) {
-            const string output_device =
-                response->queue_response(0).device().empty()
-                    ? ""
-                    : response->queue_response(0).device(i);
-            Status s = retvals[i]->SetRemoteShapeAndDevice(
-                response->queue_response(0).shape(i), device, context_view_id,
-                output_device);
-
-            if (!s.ok()) {
-              LOG(ERROR) << "Ignoring an error encountered when setting "
-                            "remote shape of tensor handle: "
-                         << retvals[i]
-                         << " with execute status: " << status.ToString()
-                         << " and SetRemoteShape status: " << s.ToString()
-                         << "\nThis should never happen. "
-                            "Please file an issue with the TensorFlow Team.";
+        for (const EnqueuedNode& node : enqueued_nodes) {
+          for (auto handle : node.inputs) {
+            handle->Unref();
+          }
+          const gtl::InlinedVector<TensorHandle*, 2>& retvals = node.retvals;
+          for (size_t i = 0; i < retvals.size(); ++i) {
+            if (status.ok()) {
+              const QueueResponse& queue_response =
+                  response->queue_response(node.response_index);
+              const string output_device = queue_response.device().empty()
+                                               ? ""
+                                               : queue_response.device(i);
+              Status s = retvals[i]->SetRemoteShapeAndDevice(
+                  queue_response.shape(i), node.device, context_view_id,
+                  output_device);
+
+              if (!s.ok()) {
+                LOG(ERROR) << "Ignoring an error encountered when setting "
+                              "remote shape of tensor handle: "
+                           << retvals[i]
+                           << " with execute status: " << status.ToString()
+                           << " and SetRemoteShape status: " << s.ToString()
+                           << "\nThis should never happen. "
+                              "Please file an issue with the TensorFlow Team.";
+              }
+            } else {
+              retvals[i]->PoisonRemote(status, node.device, context_view_id);
             }
-          } else {
-            retvals[i]->PoisonRemote(status, device, context_view_id);
+            retvals[i]->Unref();
           }
-          retvals[i]->Unref();
         }
         done(status);
       });
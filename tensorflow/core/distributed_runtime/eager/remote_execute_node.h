@@ -98,6 +98,16 @@ class RemoteExecuteNode : public AsyncRemoteExecuteNode {
 
   void RunAsync(StatusCallback done) override;
 
+  // Consecutive RemoteExecuteNodes are batched if they run on the same worker
+  // and context view with the same cancellation manager, and don't need remote
+  // inputs (which may make the executor sync before running them).
+  int NumBatchable(absl::Span<EagerNode* const> next_nodes) const override;
+
+  // Sends the operations of this node and `batched_nodes` in a single
+  // EnqueueRequest.
+  void RunAsyncBatched(absl::Span<EagerNode* const> batched_nodes,
+                       StatusCallback done) override;
+
   Status SyncExecutors() override { return eager_context_->SyncExecutors(); }
 
   void Abort(Status status) override {
@@ -124,6 +134,8 @@ class RemoteExecuteNode : public AsyncRemoteExecuteNode {
   }
 
  private:
+  bool CanBatchWith(const RemoteExecuteNode& other) const;
+
   EagerContext* eager_context_;  // Not owned, and must outlive this node.
   std::unique_ptr<EnqueueRequest> request_;
   Device* device_;             // Not owned
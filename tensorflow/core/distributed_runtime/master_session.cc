@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -68,6 +69,61 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Issues the RunGraph calls of concurrent steps to one partition in the order
+// of their tickets, with a bounded number of calls in flight. A step takes
+// one ticket for all partitions, so that every worker receives the steps in
+// the same order, and a step blocked on a full partition never holds a slot
+// needed by an earlier step.
+class PartitionPipeline {
+ public:
+  explicit PartitionPipeline(int max_inflight) : max_inflight_(max_inflight) {}
+
+  // Calls `issue` once the calls of all earlier tickets have been issued and
+  // fewer than max_inflight calls are running. Done() must be called when the
+  // call completes. Every ticket must be issued.
+  void Issue(int64_t ticket, std::function<void()> issue) {
+    std::vector<std::function<void()>> ready;
+    {
+      mutex_lock l(mu_);
+      pending_.emplace(ticket, std::move(issue));
+      TakeReady(&ready);
+    }
+    for (auto& f : ready) f();
+  }
+
+  void Done() {
+    std::vector<std::function<void()>> ready;
+    {
+      mutex_lock l(mu_);
+      --inflight_;
+      TakeReady(&ready);
+    }
+    for (auto& f : ready) f();
+  }
+
+ private:
+  void TakeReady(std::vector<std::function<void()>>* ready)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (inflight_ < max_inflight_ && !pending_.empty() &&
+           pending_.begin()->first == next_ticket_) {
+      ready->push_back(std::move(pending_.begin()->second));
+      pending_.erase(pending_.begin());
+      ++next_ticket_;
+      ++inflight_;
+    }
+  }
+
+  const int max_inflight_;
+  mutex mu_;
+  int64_t next_ticket_ TF_GUARDED_BY(mu_) = 0;
+  int inflight_ TF_GUARDED_BY(mu_) = 0;
+  std::map<int64_t, std::function<void()>> pending_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -255,6 +311,8 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const bool should_deregister_;
   const int64_t collective_graph_key_;
   std::atomic<int64_t> execution_count_ = {0};
+  // Ticket of the next step issued to the partition pipelines.
+  std::atomic<int64_t> next_pipeline_ticket_ = {0};
 
   // Graph partitioned into per-location subgraphs.
   struct Part {
@@ -274,6 +332,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     // this partition on the worker.
     string graph_handle;
 
+    // Orders the RunGraph calls of concurrent steps if
+    // max_inflight_steps_per_partition is set.
+    std::unique_ptr<PartitionPipeline> pipeline;
+
     Part() : feed_key(3), key_fetch(3) {}
   };
 
@@ -460,6 +522,11 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
       s = errors::NotFound("worker ", part->name);
       break;
     }
+    const int max_inflight =
+        session_opts_.config.experimental().max_inflight_steps_per_partition();
+    if (max_inflight > 0 && !is_partial_) {
+      part->pipeline = std::make_unique<PartitionPipeline>(max_inflight);
+    }
   }
   if (!s.ok()) {
     for (Part& part : partitions_) {
@@ -738,14 +805,32 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
     }
   }
 
-  // Issues RunGraph calls.
+  // Issues RunGraph calls. The ticket is taken once nothing can fail, as
+  // every partition waits for it.
+  const int64_t ticket =
+      num > 0 && partitions_[0].pipeline ? next_pipeline_ticket_++ : -1;
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     RunManyGraphs::Call* call = calls.get(i);
     TRACEPRINTF("Partition %d %s", i, part.name.c_str());
-    part.worker->RunGraphAsync(
-        &call->opts, call->req.get(), call->resp.get(),
-        std::bind(&RunManyGraphs::WhenDone, &calls, i, std::placeholders::_1));
+    if (!part.pipeline) {
+      part.worker->RunGraphAsync(
+          &call->opts, call->req.get(), call->resp.get(),
+          std::bind(&RunManyGraphs::WhenDone, &calls, i,
+                    std::placeholders::_1));
+      continue;
+    }
+    PartitionPipeline* pipeline = part.pipeline.get();
+    pipeline->Issue(ticket, [&part, call, &calls, i, pipeline]() {
+      part.worker->RunGraphAsync(
+          &call->opts, call->req.get(), call->resp.get(),
+          [&calls, i, pipeline](const Status& s) {
+            // The pipeline is released first, as `this` may be deleted once
+            // the step is done.
+            pipeline->Done();
+            calls.WhenDone(i, s);
+          });
+    });
   }
 
   // Waits for the RunGraph calls.
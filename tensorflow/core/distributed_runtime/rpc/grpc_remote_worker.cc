@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "grpcpp/generic/generic_stub.h"
 #include "grpcpp/grpcpp.h"
@@ -43,11 +46,13 @@ namespace tensorflow {
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
+                            std::vector<SharedGrpcChannelPtr> bulk_channels,
                             ::grpc::CompletionQueue* completion_queue,
                             thread::ThreadPool* callback_threadpool,
                             WorkerCacheLogger* logger, const string& target)
       : channel_(std::move(channel)),
         stub_(channel_),
+        bulk_channels_(std::move(bulk_channels)),
         cq_(completion_queue),
         callback_threadpool_(callback_threadpool),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
@@ -66,8 +71,15 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
+        completeinstances_(Method(GrpcWorkerMethod::kCompleteInstances)),
         logger_(logger),
-        target_(target) {}
+        target_(target) {
+    for (const SharedGrpcChannelPtr& bulk_channel : bulk_channels_) {
+      bulk_stubs_.push_back(
+          std::make_unique<::grpc::GenericStub>(bulk_channel));
+    }
+  }
 
   ~GrpcRemoteWorker() override {}
 
@@ -172,7 +184,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvbuf_, callback, call_opts);
+    IssueRequest(request, response, recvbuf_, callback, call_opts,
+                 /*fail_fast=*/true, BulkStub());
   }
 
   void CompleteGroupAsync(CallOptions* call_opts,
@@ -191,6 +204,14 @@ class GrpcRemoteWorker : public WorkerInterface {
                  call_opts);
   }
 
+  void CompleteInstancesAsync(CallOptions* call_opts,
+                              const CompleteInstancesRequest* request,
+                              CompleteInstancesResponse* response,
+                              StatusCallback done) override {
+    IssueRequest(request, response, completeinstances_, std::move(done),
+                 call_opts);
+  }
+
   void GetStepSequenceAsync(const GetStepSequenceRequest* request,
                             GetStepSequenceResponse* response,
                             StatusCallback done) override {
@@ -255,7 +276,18 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    IssueRequest(request, response, recvtensor_, callback, call_opts,
+                 BulkStub());
+  }
+
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override {
+    VLOG(1) << "RecvTensorsAsync of " << request->request_size()
+            << " tensors";
+    IssueRequest(request, response, recvtensors_, std::move(done), call_opts,
+                 /*fail_fast=*/true, BulkStub());
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -270,22 +302,26 @@ class GrpcRemoteWorker : public WorkerInterface {
 
  private:
   // Utility method for issuing a generic asynchronous request. The
-  // given callback, `done`, will be called when the RPC completes.
+  // given callback, `done`, will be called when the RPC completes. The
+  // request goes on `stub` if set, and on the main channel otherwise.
   void IssueRequest(const protobuf::Message* request,
                     protobuf::Message* response, const ::grpc::string& method,
                     StatusCallback done, CallOptions* call_opts = nullptr,
-                    bool fail_fast = true) {
+                    bool fail_fast = true,
+                    ::grpc::GenericStub* stub = nullptr) {
     new RPCState<protobuf::Message>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(), fail_fast, &target_);
+        stub != nullptr ? stub : &stub_, cq_, method, *request, response,
+        std::move(done), call_opts, callback_threadpool_, MaxRetries(),
+        fail_fast, &target_);
   }
 
   void IssueRequest(const protobuf::Message* request, TensorResponse* response,
                     const ::grpc::string& method, StatusCallback done,
-                    CallOptions* call_opts = nullptr) {
+                    CallOptions* call_opts = nullptr,
+                    ::grpc::GenericStub* stub = nullptr) {
     new RPCState<TensorResponse>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(),
+        stub != nullptr ? stub : &stub_, cq_, method, *request, response,
+        std::move(done), call_opts, callback_threadpool_, MaxRetries(),
         /*fail_fast=*/true, &target_,
         // Use optimized proto parse function that avoids a copy.
         GrpcMaybeParseTensorResponse);
@@ -301,6 +337,14 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(&request, response, markrecvfinished_, done);
   }
 
+  // Returns the stub of the next bulk channel, or nullptr if there are none.
+  ::grpc::GenericStub* BulkStub() {
+    if (bulk_stubs_.empty()) return nullptr;
+    return bulk_stubs_[next_bulk_stub_.fetch_add(1, std::memory_order_relaxed) %
+                       bulk_stubs_.size()]
+        .get();
+  }
+
   // Helper function for initializing the RpcMethod objects below.
   const char* Method(GrpcWorkerMethod id) { return GrpcWorkerMethodName(id); }
 
@@ -314,6 +358,10 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   SharedGrpcChannelPtr channel_;
   ::grpc::GenericStub stub_;
+  // Channels dedicated to the RPCs that transfer tensors.
+  const std::vector<SharedGrpcChannelPtr> bulk_channels_;
+  std::vector<std::unique_ptr<::grpc::GenericStub>> bulk_stubs_;
+  std::atomic<size_t> next_bulk_stub_{0};
   ::grpc::CompletionQueue* cq_;
   thread::ThreadPool* callback_threadpool_;
 
@@ -333,6 +381,8 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensors_;
+  const ::grpc::string completeinstances_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -347,8 +397,20 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger,
                                      const string& target) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue,
-                              callback_threadpool, logger, target);
+  return new GrpcRemoteWorker(std::move(channel), /*bulk_channels=*/{},
+                              completion_queue, callback_threadpool, logger,
+                              target);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel,
+    std::vector<SharedGrpcChannelPtr> bulk_channels,
+    ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+    const string& target) {
+  return new GrpcRemoteWorker(std::move(channel), std::move(bulk_channels),
+                              completion_queue, callback_threadpool, logger,
+                              target);
 }
 
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
 
 #include <memory>
+#include <vector>
 
 #include "grpcpp/completion_queue.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
@@ -32,6 +33,15 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      WorkerCacheLogger* logger,
                                      const string& target);
 
+// As above, but the RPCs that transfer tensors are issued on `bulk_channels`
+// in turn, leaving `channel` to the other RPCs.
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel,
+    std::vector<SharedGrpcChannelPtr> bulk_channels,
+    ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+    const string& target);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
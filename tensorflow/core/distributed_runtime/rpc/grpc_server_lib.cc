@@ -20,12 +20,14 @@ limitations under the License.
 #include <limits>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "grpcpp/grpcpp.h"
 #include "grpcpp/security/credentials.h"
 #include "grpcpp/server_builder.h"
+#include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -91,11 +93,6 @@ class ReusePortOption : public ::grpc::ServerBuilderOption {
                          plugins) override {}
 };
 
-// static utility function
-RendezvousMgrInterface* NewRpcRendezvousMgr(const WorkerEnv* env) {
-  return new RpcRendezvousMgr(env);
-}
-
 }  // namespace
 
 GrpcServer::GrpcServer(const ServerDef& server_def, Env* env)
@@ -229,9 +226,15 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
   master_env_.experimental_num_shards = std::max(1, num_tasks);
   worker_env_.experimental_num_shards = master_env_.experimental_num_shards;
 
-  worker_env_.rendezvous_mgr = opts.rendezvous_mgr_func == nullptr
-                                   ? new RpcRendezvousMgr(&worker_env_)
-                                   : opts.rendezvous_mgr_func(&worker_env_);
+  RpcRendezvousMgrOptions rendezvous_options;
+  rendezvous_options.recv_coalescing_window_us =
+      server_def_.default_session_config()
+          .rpc_options()
+          .recv_tensor_coalescing_window_us();
+  worker_env_.rendezvous_mgr =
+      opts.rendezvous_mgr_func == nullptr
+          ? new RpcRendezvousMgr(&worker_env_, rendezvous_options)
+          : opts.rendezvous_mgr_func(&worker_env_);
   string unused;
   string default_worker_name;
   if (!DeviceNameUtils::SplitDeviceName(master_env_.local_devices[0]->name(),
@@ -427,8 +430,16 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
     return errors::InvalidArgument("Requested port ", requested_port,
                                    " differs from expected port ", bound_port_);
   }
-  *worker_cache = NewGrpcWorkerCacheWithLocalWorker(
-      channel_cache, grpc_worker_env(), worker_impl(), name_prefix);
+  const int num_bulk_channels =
+      options.rpc_options.num_bulk_channels_per_target();
+  if (num_bulk_channels > 0) {
+    *worker_cache = NewGrpcWorkerCacheWithBulkChannels(
+        channel_cache, grpc_worker_env(), worker_impl(), name_prefix,
+        GetBulkChannelCreationFunction(), num_bulk_channels);
+  } else {
+    *worker_cache = NewGrpcWorkerCacheWithLocalWorker(
+        channel_cache, grpc_worker_env(), worker_impl(), name_prefix);
+  }
   return absl::OkStatus();
 }
 
@@ -597,19 +608,84 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+ChannelCreationFunction GrpcServer::GetBulkChannelCreationFunction() const {
+  // Channels that share a subchannel pool share their connection, so each
+  // bulk channel gets its own pool.
+  RPCOptions rpc_options;
+  rpc_options.set_disable_session_connection_sharing(true);
+  return [rpc_options](const string& target) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel;
+    if (!NewHostPortGrpcChannel(target, &rpc_options, &channel).ok()) {
+      return nullptr;
+    }
+    return channel;
+  };
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
 
+namespace {
+
+constexpr char kTensorTransportPrefix[] = "grpc+";
+
+mutex* get_tensor_transport_lock() {
+  static mutex tensor_transport_lock(LINKER_INITIALIZED);
+  return &tensor_transport_lock;
+}
+
+typedef std::unordered_map<string, GrpcTensorTransport> TensorTransports;
+TensorTransports* tensor_transports() {
+  static TensorTransports* transports = new TensorTransports;
+  return transports;
+}
+
+// Returns the tensor transport of `protocol`, or nullptr if it does not name
+// a registered transport. Transports are never unregistered, so the result
+// stays valid.
+const GrpcTensorTransport* FindTensorTransport(const string& protocol) {
+  if (!absl::StartsWith(protocol, kTensorTransportPrefix)) return nullptr;
+  mutex_lock l(*get_tensor_transport_lock());
+  auto it = tensor_transports()->find(
+      protocol.substr(strlen(kTensorTransportPrefix)));
+  return it == tensor_transports()->end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+/* static */
+void GrpcServer::RegisterTensorTransport(const string& name,
+                                         GrpcTensorTransport transport) {
+  mutex_lock l(*get_tensor_transport_lock());
+  if (!tensor_transports()->emplace(name, std::move(transport)).second) {
+    LOG(ERROR) << "Two tensor transports are being registered under " << name;
+  }
+}
+
+/* static */
+bool GrpcServer::AcceptsProtocol(const string& protocol) {
+  return protocol == "grpc" || FindTensorTransport(protocol) != nullptr;
+}
+
 /* static */
 Status GrpcServer::Create(const ServerDef& server_def, Env* env,
                           DeviceMgr* local_device_mgr,
                           std::unique_ptr<ServerInterface>* out_server) {
-  std::unique_ptr<GrpcServer> ret(
-      new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   GrpcServerOptions options;
-  options.rendezvous_mgr_func = NewRpcRendezvousMgr;
   options.local_device_mgr = local_device_mgr;
+  if (absl::StartsWith(server_def.protocol(), kTensorTransportPrefix)) {
+    const GrpcTensorTransport* transport =
+        FindTensorTransport(server_def.protocol());
+    if (transport == nullptr) {
+      return errors::InvalidArgument("No tensor transport is registered for ",
+                                     server_def.protocol());
+    }
+    options.rendezvous_mgr_func = transport->rendezvous_mgr_func;
+    options.service_func = transport->service_func;
+  }
+  std::unique_ptr<GrpcServer> ret(
+      new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   Status s = ret->Init(options);
   if (!s.ok()) {
     LOG(ERROR) << s;
@@ -642,7 +718,7 @@ namespace {
 class GrpcServerFactory : public ServerFactory {
  public:
   bool AcceptsOptions(const ServerDef& server_def) override {
-    return server_def.protocol() == "grpc";
+    return GrpcServer::AcceptsProtocol(server_def.protocol());
   }
 
   Status NewServer(const ServerDef& server_def, const Options& options,
@@ -74,6 +74,19 @@ struct GrpcServerOptions {
   DeviceMgr* local_device_mgr = nullptr;
 };
 
+// A transport for the tensors that workers send each other, used instead of
+// the RecvTensor RPC of RpcRendezvousMgr. A transport is selected by the
+// protocol "grpc+<name>" in the ServerDef. gRPC is still used for all other
+// messages. For example, an RDMA transport would register the device memory
+// with its NIC when its RendezvousMgr is created. It would exchange the
+// memory keys through a service added by `service_func`. It would then write
+// each tensor directly into the memory of the receiving worker.
+struct GrpcTensorTransport {
+  RendezvousMgrCreationFunction rendezvous_mgr_func = nullptr;
+  // Optional. Registers the services of the transport on the server.
+  ServiceInitFunction service_func = nullptr;
+};
+
 class GrpcServer : public ServerInterface {
  protected:
   GrpcServer(const ServerDef& server_def, Env* env);
@@ -96,6 +109,15 @@ class GrpcServer : public ServerInterface {
                        DeviceMgr* local_device_mgr,
                        std::unique_ptr<ServerInterface>* out_server);
 
+  // Registers the tensor transport `name`, used by the servers whose protocol
+  // is "grpc+<name>". Typically called from a static initializer.
+  static void RegisterTensorTransport(const string& name,
+                                      GrpcTensorTransport transport);
+
+  // Returns true if `protocol` is "grpc", or "grpc+<name>" for a registered
+  // tensor transport.
+  static bool AcceptsProtocol(const string& protocol);
+
   // Destruction is only supported in the factory method. Clean
   // shutdown is not currently implemented for this server type.
   virtual ~GrpcServer();
@@ -134,6 +156,13 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Returns the function that creates the channels dedicated to tensor
+  // transfers when RPCOptions.num_bulk_channels_per_target is set. Each
+  // channel must have its own connection. A subclass that overrides
+  // GetChannelCreationFunction() to use secure credentials should override
+  // this method too.
+  virtual ChannelCreationFunction GetBulkChannelCreationFunction() const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_server_lib.h"
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+
+namespace tensorflow {
+namespace {
+
+std::atomic<int> num_test_rendezvous_mgrs{0};
+std::atomic<int> num_test_services{0};
+
+class TestTransportRegistrar {
+ public:
+  TestTransportRegistrar() {
+    GrpcTensorTransport transport;
+    transport.rendezvous_mgr_func = [](const WorkerEnv* env) {
+      ++num_test_rendezvous_mgrs;
+      return new RpcRendezvousMgr(env);
+    };
+    transport.service_func = [](const WorkerEnv* env,
+                                ::grpc::ServerBuilder* builder) {
+      ++num_test_services;
+    };
+    GrpcServer::RegisterTensorTransport("test_transport", transport);
+  }
+};
+static TestTransportRegistrar registrar;
+
+ServerDef LocalServerDef(const string& protocol) {
+  ServerDef server_def;
+  server_def.set_protocol(protocol);
+  server_def.set_job_name("localhost");
+  server_def.set_task_index(0);
+  JobDef* job_def = server_def.mutable_cluster()->add_job();
+  job_def->set_name("localhost");
+  (*job_def->mutable_tasks())[0] =
+      strings::StrCat("localhost:", testing::PickUnusedPortOrDie());
+  return server_def;
+}
+
+TEST(GrpcServerTest, AcceptsRegisteredTensorTransports) {
+  EXPECT_TRUE(GrpcServer::AcceptsProtocol("grpc"));
+  EXPECT_TRUE(GrpcServer::AcceptsProtocol("grpc+test_transport"));
+  EXPECT_FALSE(GrpcServer::AcceptsProtocol("grpc+unknown_transport"));
+  EXPECT_FALSE(GrpcServer::AcceptsProtocol("test_transport"));
+
+  ServerFactory* factory;
+  TF_EXPECT_OK(ServerFactory::GetFactory(
+      LocalServerDef("grpc+test_transport"), &factory));
+  EXPECT_FALSE(ServerFactory::GetFactory(
+                   LocalServerDef("grpc+unknown_transport"), &factory)
+                   .ok());
+}
+
+TEST(GrpcServerTest, CreatesServerWithTensorTransport) {
+  const int num_rendezvous_mgrs = num_test_rendezvous_mgrs;
+  const int num_services = num_test_services;
+  std::unique_ptr<ServerInterface> server;
+  TF_ASSERT_OK(NewServer(LocalServerDef("grpc+test_transport"), &server));
+  EXPECT_EQ(num_test_rendezvous_mgrs, num_rendezvous_mgrs + 1);
+  EXPECT_EQ(num_test_services, num_services + 1);
+  EXPECT_NE(server->worker_env()->rendezvous_mgr, nullptr);
+}
+
+TEST(GrpcServerTest, RejectsUnknownTensorTransport) {
+  std::unique_ptr<ServerInterface> server;
+  EXPECT_TRUE(errors::IsInvalidArgument(GrpcServer::Create(
+      LocalServerDef("grpc+unknown_transport"), Env::Default(), &server)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/port.h"
@@ -315,6 +316,41 @@ TEST(GrpcSessionTest, FetchMultipleTimes) {
   TF_ASSERT_OK(session->Close());
 }
 
+TEST(GrpcSessionTest, PipelinedConcurrentSteps) {
+  GraphDef graph;
+  string node_names[3];
+  // c = a * b
+  CreateGraphDef(&graph, node_names);
+
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_ASSERT_OK(test::TestCluster::MakeTestCluster(
+      TestClusterConfig()
+          .Options(Devices(1, 0))
+          .Jobs({TestJob{"localhost", /*num_tasks=*/2}}),
+      &cluster));
+  SessionOptions options = Options(cluster->targets()[0], 1);
+  options.config.mutable_experimental()->set_max_inflight_steps_per_partition(
+      1);
+  std::unique_ptr<Session> session(NewRemote(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(graph));
+  {
+    thread::ThreadPool pool(Env::Default(), "steps", 4);
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([&session, &node_names]() {
+        for (int step = 0; step < 10; ++step) {
+          std::vector<Tensor> outputs;
+          TF_ASSERT_OK(
+              session->Run({}, {node_names[2] + ":0"}, {}, &outputs));
+          ASSERT_EQ(outputs.size(), 1);
+          IsSingleFloatValue(outputs[0], 4.0);
+        }
+      });
+    }
+  }
+  TF_ASSERT_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, DisableOutputPartitionGraphs) {
   GraphDef graph;
   string node_names[3];
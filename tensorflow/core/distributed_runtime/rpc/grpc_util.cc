@@ -15,9 +15,52 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
+#include <utility>
+#include <vector>
+
+#include "grpcpp/support/slice.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 
 namespace tensorflow {
+namespace {
+
+// A TensorBuffer that aliases received data and keeps the grpc::Slice that
+// holds it alive.
+class GrpcSliceTensorBuffer : public TensorBuffer {
+ public:
+  GrpcSliceTensorBuffer(::grpc::Slice slice, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        slice_(std::move(slice)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("grpc_slice");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const ::grpc::Slice slice_;
+  const size_t size_;
+};
+
+}  // namespace
+
+TensorBuffer* GrpcByteSource::ShareBuffer(const char* data, size_t size) {
+  std::vector<::grpc::Slice> slices;
+  if (!buffer_->Dump(&slices).ok()) return nullptr;
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
+  for (::grpc::Slice& slice : slices) {
+    if (begin >= slice.begin() && begin + size <= slice.end()) {
+      return new GrpcSliceTensorBuffer(std::move(slice), data, size);
+    }
+  }
+  return nullptr;
+}
 
 bool GrpcMaybeParseTensorResponse(::grpc::ByteBuffer* src,
                                   TensorResponse* dst) {
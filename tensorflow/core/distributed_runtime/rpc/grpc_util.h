@@ -50,6 +50,10 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the data if it lies in one of the slices of the buffer, which is
+  // not the case if the buffer is compressed.
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override;
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/rpc/coordination/grpc_coordination_client.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
@@ -35,11 +40,15 @@ class GrpcWorkerCache : public WorkerCachePartial {
   explicit GrpcWorkerCache(std::shared_ptr<GrpcChannelCache> channel_cache,
                            WorkerInterface* local_worker,
                            const string& local_target,
-                           GrpcWorkerEnv* worker_env)
+                           GrpcWorkerEnv* worker_env,
+                           ChannelCreationFunction bulk_channel_func = nullptr,
+                           int num_bulk_channels = 0)
       : local_target_(local_target),
         local_worker_(local_worker),
         channel_cache_(channel_cache),
         worker_env_(worker_env),
+        bulk_channel_func_(std::move(bulk_channel_func)),
+        num_bulk_channels_(bulk_channel_func_ ? num_bulk_channels : 0),
         next_round_robin_assignment_(0) {}
 
   void ListWorkers(std::vector<string>* workers) const override {
@@ -61,7 +70,8 @@ class GrpcWorkerCache : public WorkerCachePartial {
       }
       size_t index = AssignWorkerToThread(target);
       return NewGrpcRemoteWorker(
-          channel, worker_env_->GetCompletionQueue(index),
+          channel, FindBulkChannels(target),
+          worker_env_->GetCompletionQueue(index),
           worker_env_->GetThreadPool(), &logger_, target);
     }
   }
@@ -112,11 +122,41 @@ class GrpcWorkerCache : public WorkerCachePartial {
     return it->second;
   }
 
+  // Returns the bulk channels to `target`, which are created on first use and
+  // shared by all its workers.
+  std::vector<SharedGrpcChannelPtr> FindBulkChannels(const string& target) {
+    if (num_bulk_channels_ <= 0) return {};
+    mutex_lock lock(bulk_channels_mu_);
+    auto it = bulk_channels_.find(target);
+    if (it != bulk_channels_.end()) return it->second;
+    const string host_port = channel_cache_->TranslateTask(target);
+    std::vector<SharedGrpcChannelPtr> channels;
+    for (int i = 0; i < num_bulk_channels_; ++i) {
+      SharedGrpcChannelPtr channel = bulk_channel_func_(host_port);
+      if (!channel) {
+        LOG(WARNING) << "Could not create bulk channel to " << target
+                     << "; its tensors will share its main channel";
+        return {};
+      }
+      channels.push_back(std::move(channel));
+    }
+    VLOG(2) << "Created " << channels.size() << " bulk channels to "
+            << target;
+    bulk_channels_.emplace(target, channels);
+    return channels;
+  }
+
   const string local_target_;
   WorkerInterface* const local_worker_;  // Not owned.
   std::shared_ptr<GrpcChannelCache> channel_cache_;
   WorkerCacheLogger logger_;
   GrpcWorkerEnv* worker_env_;  // Not owned
+  const ChannelCreationFunction bulk_channel_func_;
+  const int num_bulk_channels_;
+
+  mutex bulk_channels_mu_;
+  std::unordered_map<std::string, std::vector<SharedGrpcChannelPtr>>
+      bulk_channels_ TF_GUARDED_BY(bulk_channels_mu_);
 
   mutex assignment_mu_;
   std::unordered_map<std::string, size_t> target_assignments_
@@ -180,4 +220,12 @@ WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
   return new GrpcWorkerCache(cc, local_worker, local_target, worker_env);
 }
 
+WorkerCacheInterface* NewGrpcWorkerCacheWithBulkChannels(
+    std::shared_ptr<GrpcChannelCache> cc, GrpcWorkerEnv* worker_env,
+    WorkerInterface* local_worker, const string& local_target,
+    ChannelCreationFunction bulk_channel_func, int num_bulk_channels) {
+  return new GrpcWorkerCache(cc, local_worker, local_target, worker_env,
+                             std::move(bulk_channel_func), num_bulk_channels);
+}
+
 }  // namespace tensorflow
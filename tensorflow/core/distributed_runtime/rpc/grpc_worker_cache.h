@@ -72,5 +72,13 @@ WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
     std::shared_ptr<GrpcChannelCache> cc, GrpcWorkerEnv* worker_env,
     WorkerInterface* local_worker, const string& local_target);
 
+// As above, but the RecvTensor and RecvBuf RPCs to each remote worker are
+// spread over `num_bulk_channels` channels created by `bulk_channel_func` for
+// its host and port, so that they don't delay its other RPCs.
+WorkerCacheInterface* NewGrpcWorkerCacheWithBulkChannels(
+    std::shared_ptr<GrpcChannelCache> cc, GrpcWorkerEnv* worker_env,
+    WorkerInterface* local_worker, const string& local_target,
+    ChannelCreationFunction bulk_channel_func, int num_bulk_channels);
+
 }  // namespace tensorflow
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_CACHE_H_
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "tensorflow/c/tf_status.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
@@ -62,6 +66,47 @@ TEST(GrpcWorkerCacheTest, NewGrpcWorkerCache) {
   EXPECT_EQ(wi, local_wi.get());
 }
 
+TEST(GrpcWorkerCacheTest, BulkChannels) {
+  GrpcChannelSpec spec;
+  TF_ASSERT_OK(spec.AddHostPortsJob("worker", {{0, "a:0"}, {1, "b:1"}}));
+  ChannelCreationFunction channel_func =
+      ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
+  auto channel_cache = std::shared_ptr<GrpcChannelCache>(
+      NewGrpcChannelCache(spec, channel_func));
+  std::unique_ptr<GrpcWorkerEnv> grpc_worker_env(CreateGrpcWorkerEnv());
+
+  std::vector<string> bulk_targets;
+  ChannelCreationFunction bulk_channel_func =
+      [&bulk_targets, channel_func](const string& target) {
+        bulk_targets.push_back(target);
+        return channel_func(target);
+      };
+  std::unique_ptr<WorkerCacheInterface> worker_cache(
+      NewGrpcWorkerCacheWithBulkChannels(
+          channel_cache, grpc_worker_env.get(), /*local_worker=*/nullptr,
+          /*local_target=*/"", bulk_channel_func, /*num_bulk_channels=*/3));
+
+  // The bulk channels to a worker are created once.
+  for (int i = 0; i < 2; ++i) {
+    WorkerInterface* wi =
+        worker_cache->GetOrCreateWorker("/job:worker/replica:0/task:1");
+    EXPECT_NE(wi, nullptr);
+    worker_cache->ReleaseWorker("/job:worker/replica:0/task:1", wi);
+  }
+  EXPECT_EQ(bulk_targets, std::vector<string>({"b:1", "b:1", "b:1"}));
+
+  // Workers are still returned when the bulk channels can't be created.
+  worker_cache.reset(NewGrpcWorkerCacheWithBulkChannels(
+      channel_cache, grpc_worker_env.get(), /*local_worker=*/nullptr,
+      /*local_target=*/"",
+      [](const string& target) { return SharedGrpcChannelPtr(); },
+      /*num_bulk_channels=*/3));
+  WorkerInterface* wi =
+      worker_cache->GetOrCreateWorker("/job:worker/replica:0/task:0");
+  EXPECT_NE(wi, nullptr);
+  worker_cache->ReleaseWorker("/job:worker/replica:0/task:0", wi);
+}
+
 TEST(GrpcWorkerCacheTest, DestructWorkerCacheInThreadPool) {
   GrpcChannelSpec spec;
   TF_ASSERT_OK(
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_map>
@@ -143,11 +144,13 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(Tracing, 1, false);
     SETUP_FOR_REQUEST(CompleteGroup, 10, true);
     SETUP_FOR_REQUEST(CompleteInstance, 10, true);
+    SETUP_FOR_REQUEST(CompleteInstances, 10, true);
     SETUP_FOR_REQUEST(GetStepSequence, 10, true);
     SETUP_FOR_REQUEST(RecvBuf, 500, true);
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    SETUP_FOR_REQUEST(RecvTensors, 100, true);
 
     // TODO(ncteisen): Determine a better policy for enqueuing the
     // appropriate number of each request type.
@@ -284,6 +287,25 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandler(
+      WorkerCall<RecvTensorsRequest, RecvTensorsResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorsAsync(call_opts, &call->request, &call->response,
+                                [call, call_opts](const Status& s) {
+                                  call->ClearCancelCallback();
+                                  delete call_opts;
+                                  if (!s.ok()) {
+                                    VLOG(3) << "Bad response from RecvTensors:"
+                                            << s;
+                                  }
+                                  call->SendResponse(ToGrpcStatus(s));
+                                });
+    });
+    ENQUEUE_REQUEST(RecvTensors, true);
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -338,6 +360,25 @@ class GrpcWorkerServiceThread {
     });
     ENQUEUE_REQUEST(CompleteInstance, false);
   }
+
+  void CompleteInstancesHandler(
+      WorkerCall<CompleteInstancesRequest, CompleteInstancesResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->CompleteInstancesAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from CompleteInstances:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(CompleteInstances, false);
+  }
 #undef ENQUEUE_REQUEST
 
   void EnqueueRecvTensorRequestRaw() {
@@ -487,16 +528,23 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
     return;
   }
 
+  RecvHostTensorAsync(opts, request, rendezvous_done);
+}
+
+void GrpcWorker::RecvHostTensorAsync(CallOptions* opts,
+                                     const RecvTensorRequest* request,
+                                     HostTensorCallback done) {
+  const int64_t step_id = request->step_id();
   const string& key = request->rendezvous_key();
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
-  s = Rendezvous::ParseKey(key, &parsed);
+  Status s = Rendezvous::ParseKey(key, &parsed);
   Device* src_dev = nullptr;
   if (s.ok()) {
     s = PrepareRecvTensor(parsed, &src_dev);
   }
   if (!s.ok()) {
-    fail(s);
+    done(Tensor(), false, s);
     return;
   }
 
@@ -508,24 +556,28 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // failures, and the client might not observe any errors or cancellations but
   // simply waits for the responses. Aborting the step would report an error to
   // the client, and avoid permanent hanging in distributed function execution.
-  opts->SetCancelCallback([this, step_id]() {
-    LOG(WARNING) << "RecvTensor cancelled for " << step_id;
-    AbortStep(step_id);
-  });
+  if (opts != nullptr) {
+    opts->SetCancelCallback([this, step_id]() {
+      LOG(WARNING) << "RecvTensor cancelled for " << step_id;
+      AbortStep(step_id);
+    });
+  }
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, rendezvous_done, src_dev, request](
-          const Status& status, const Rendezvous::Args& send_args,
-          const Rendezvous::Args& recv_args, const Tensor& val,
-          const bool is_dead) {
-        opts->ClearCancelCallback();
+      [opts, done, src_dev, request](const Status& status,
+                                     const Rendezvous::Args& send_args,
+                                     const Rendezvous::Args& recv_args,
+                                     const Tensor& val, const bool is_dead) {
+        if (opts != nullptr) {
+          opts->ClearCancelCallback();
+        }
         if (!status.ok()) {
-          return rendezvous_done(val, is_dead, status);
+          return done(val, is_dead, status);
         }
 
         const bool on_host = send_args.alloc_attrs.on_host();
         if (!src_dev->tensorflow_accelerator_device_info() || on_host) {
-          return rendezvous_done(val, is_dead, status);
+          return done(val, is_dead, status);
         }
 
         DeviceContext* send_dev_context = send_args.device_context;
@@ -542,10 +594,9 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
             << "send dev name: " << src_dev->name()
             << " gpu_info: " << src_dev->tensorflow_accelerator_device_info();
 
-        StatusCallback copy_ready = [rendezvous_done, copy,
-                                     is_dead](const Status& s) {
+        StatusCallback copy_ready = [done, copy, is_dead](const Status& s) {
           // The value is now ready to be returned on the wire.
-          rendezvous_done(*copy, is_dead, s);
+          done(*copy, is_dead, s);
           delete copy;
         };
 
@@ -554,6 +605,120 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+namespace {
+// Appends the content of `tensors` to `response`, as described in
+// RecvTensorsResponse.
+void EncodeRecvTensorsResponse(const std::vector<Tensor>& tensors,
+                               const std::vector<bool>& is_dead,
+                               int64_t send_start_micros,
+                               RecvTensorsResponse* response) {
+  size_t content_bytes = 0;
+  for (const Tensor& tensor : tensors) {
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      content_bytes += tensor.TotalBytes();
+    }
+  }
+  string* content = response->mutable_content();
+  content->reserve(content_bytes);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const Tensor& tensor = tensors[i];
+    RecvTensorResponse* tensor_response = response->add_response();
+    tensor_response->set_is_dead(is_dead[i]);
+    tensor_response->set_send_start_micros(send_start_micros);
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      TensorProto* proto = tensor_response->mutable_tensor();
+      proto->set_dtype(tensor.dtype());
+      tensor.shape().AsProto(proto->mutable_tensor_shape());
+      response->add_content_offset(content->size());
+      content->append(reinterpret_cast<const char*>(DMAHelper::base(&tensor)),
+                      tensor.TotalBytes());
+    } else {
+      tensor.AsProtoField(tensor_response->mutable_tensor());
+      response->add_content_offset(-1);
+    }
+  }
+}
+}  // namespace
+
+void GrpcWorker::RecvTensorsAsync(CallOptions* opts,
+                                  const RecvTensorsRequest* request,
+                                  RecvTensorsResponse* response,
+                                  StatusCallback done) {
+  VLOG(3) << "RecvTensorsAsync of " << request->request_size() << " tensors";
+  // The batched tensors are not kept in the response cache, so a failed
+  // batch fails the step like a RecvTensor without the cache does.
+  std::vector<int64_t> step_ids;
+  for (const RecvTensorRequest& recv_request : request->request()) {
+    Status s = recent_request_ids_.TrackUnique(
+        recv_request.request_id(), "RecvTensors (GrpcWorker)", recv_request);
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+    if (std::find(step_ids.begin(), step_ids.end(), recv_request.step_id()) ==
+        step_ids.end()) {
+      step_ids.push_back(recv_request.step_id());
+    }
+  }
+  const int num_tensors = request->request_size();
+  if (num_tensors == 0) {
+    done(absl::OkStatus());
+    return;
+  }
+
+  struct BatchState {
+    explicit BatchState(int num_tensors)
+        : pending(num_tensors), tensors(num_tensors), is_dead(num_tensors) {}
+
+    mutex mu;
+    int pending TF_GUARDED_BY(mu);
+    Status status TF_GUARDED_BY(mu);
+    std::vector<Tensor> tensors TF_GUARDED_BY(mu);
+    std::vector<bool> is_dead TF_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<BatchState>(num_tensors);
+
+  // A cancelled batch aborts the steps of all its tensors, as for RecvTensor.
+  opts->SetCancelCallback([this, step_ids]() {
+    for (int64_t step_id : step_ids) {
+      LOG(WARNING) << "RecvTensors cancelled for " << step_id;
+      AbortStep(step_id);
+    }
+  });
+  for (int i = 0; i < num_tensors; ++i) {
+    const RecvTensorRequest& recv_request = request->request(i);
+    RecvHostTensorAsync(
+        /*opts=*/nullptr, &recv_request,
+        [this, state, i, step_id = recv_request.step_id(), opts, response,
+         done](const Tensor& tensor, bool is_dead, const Status& status) {
+          {
+            mutex_lock l(state->mu);
+            if (status.ok()) {
+              state->tensors[i] = tensor;
+              state->is_dead[i] = is_dead;
+            } else if (state->status.ok()) {
+              // The other tensors of the step may never be sent, so abort
+              // the step for the batch to finish.
+              AbortStep(step_id);
+            }
+            state->status.Update(status);
+            if (--state->pending > 0) return;
+          }
+          opts->ClearCancelCallback();
+          Status s;
+          {
+            mutex_lock l(state->mu);
+            s = state->status;
+            if (s.ok()) {
+              EncodeRecvTensorsResponse(state->tensors, state->is_dead,
+                                        env_->env->NowMicros(), response);
+            }
+          }
+          done(s);
+        });
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
 
@@ -51,6 +52,13 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Receives the tensors of several RecvTensor requests in one RPC. The
+  // tensors are copied to host memory and their content is packed together
+  // in the response.
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override;
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -68,6 +76,15 @@ class GrpcWorker : public Worker {
   void RemoveCacheEntryForId(int64_t request_id);
 
  private:
+  using HostTensorCallback = std::function<void(
+      const Tensor& tensor, bool is_dead, const Status& status)>;
+
+  // Receives the tensor of `request` from the local rendezvous and copies it
+  // to host memory if it is on an accelerator. If `opts` is not null, it is
+  // cancelled by aborting the step until the tensor has been sent.
+  void RecvHostTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                           HostTensorCallback done);
+
   std::unique_ptr<RpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
 };
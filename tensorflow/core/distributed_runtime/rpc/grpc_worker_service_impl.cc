@@ -60,6 +60,10 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/GetStepSequence";
     case GrpcWorkerMethod::kMarkRecvFinished:
       return "/tensorflow.WorkerService/MarkRecvFinished";
+    case GrpcWorkerMethod::kRecvTensors:
+      return "/tensorflow.WorkerService/RecvTensors";
+    case GrpcWorkerMethod::kCompleteInstances:
+      return "/tensorflow.WorkerService/CompleteInstances";
   }
   // Shouldn't be reached.
   LOG(FATAL) << "Invalid id: this line shouldn't be reached.";
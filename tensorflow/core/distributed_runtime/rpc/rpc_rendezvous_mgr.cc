@@ -15,6 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -23,23 +31,33 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
 
 namespace {
 
+class RpcRecvTensorCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id,
+                      const RpcRendezvousMgrOptions& options)
+      : BaseRemoteRendezvous(env, step_id), options_(options) {}
+
+  // Queues `call` to be sent in one RecvTensors RPC with the other recvs from
+  // its source worker that start within the coalescing window.
+  void EnqueueBatchedCall(RpcRecvTensorCall* call, StatusCallback done);
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -47,8 +65,35 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
                            DoneCallback done) override;
 
  private:
+  struct BatchedCall {
+    RpcRecvTensorCall* call;
+    StatusCallback done;
+  };
+
+  struct RecvTensorsBatch {
+    CallOptions opts;
+    RecvTensorsRequest request;
+    RecvTensorsResponse response;
+    std::vector<BatchedCall> calls;
+  };
+
   ~RpcRemoteRendezvous() override {}
 
+  // Sends the recvs queued for `src_worker`.
+  void FlushBatch(const string& src_worker);
+
+  // Finishes the calls of `batch` with the tensors of its response and
+  // deletes it.
+  void FinishBatch(RecvTensorsBatch* batch, const Status& s);
+
+  const RpcRendezvousMgrOptions options_;
+
+  mutex batch_mu_;
+  absl::flat_hash_map<string, std::vector<BatchedCall>> batches_
+      TF_GUARDED_BY(batch_mu_);
+  // Workers that do not support the RecvTensors RPC.
+  absl::flat_hash_set<string> unbatched_workers_ TF_GUARDED_BY(batch_mu_);
+
   RpcRemoteRendezvous(const RpcRemoteRendezvous&) = delete;
   void operator=(const RpcRemoteRendezvous&) = delete;
 };
@@ -79,6 +124,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    batcher_ = nullptr;
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -133,21 +179,32 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
  private:
   friend class RpcRemoteRendezvous;
 
-  // Start the main RecvTensor call, checking for an async abort.
+  // Start the main RecvTensor call, either on its own or in a batch.
   void StartRTCall(std::function<void()> recv_done) {
     resp_.InitAlloc(dst_device_, alloc_attrs_);
-    auto abort_checked = std::make_shared<Notification>();
-    auto cb = [this, abort_checked,
-               recv_done = std::move(recv_done)](const Status& s) {
-      // Make sure the Rendezvous abort checking is finished before running the
-      // callback, which might destroy the current call object.
-      abort_checked->WaitForNotification();
+    auto cb = [this, recv_done = std::move(recv_done)](const Status& s) {
       if (!s.ok()) {
         mutex_lock l(mu_);
         status_.Update(s);
       }
       recv_done();
     };
+    if (batcher_ != nullptr) {
+      batcher_->EnqueueBatchedCall(this, std::move(cb));
+    } else {
+      SendRecvTensor(std::move(cb));
+    }
+  }
+
+  // Send the RecvTensor RPC of this call, checking for an async abort.
+  void SendRecvTensor(StatusCallback done) {
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [abort_checked, done = std::move(done)](const Status& s) {
+      // Make sure the Rendezvous abort checking is finished before running the
+      // callback, which might destroy the current call object.
+      abort_checked->WaitForNotification();
+      done(s);
+    };
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
 
     // NOTE: Check if the rendezvous was aborted after sending out the RPC. The
@@ -167,9 +224,39 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     abort_checked->Notify();
   }
 
+  // Fills the tensor of this call from its entry in a RecvTensors response.
+  // `content` is the content of the tensor if `content_offset` is not -1.
+  Status DecodeBatchedResponse(RecvTensorResponse* response,
+                               int64_t content_offset,
+                               absl::string_view content) {
+    if (content_offset < 0) {
+      return resp_.InitFrom(response);
+    }
+    if (!TensorShape::IsValid(response->tensor().tensor_shape()) ||
+        !DataTypeCanUseMemcpy(response->tensor().dtype())) {
+      return errors::Internal("Invalid tensor in RecvTensors response for ",
+                              req_.rendezvous_key());
+    }
+    resp_.InitPartial(*response, AllocationAttributes());
+    const Tensor& tensor = resp_.tensor();
+    if (content.size() != tensor.TotalBytes()) {
+      return errors::Internal("RecvTensors response has ", content.size(),
+                              " bytes for the ", tensor.TotalBytes(),
+                              " bytes of ", req_.rendezvous_key());
+    }
+    if (!content.empty()) {
+      // The tensor was just allocated and is not shared yet.
+      std::memcpy(const_cast<char*>(tensor.tensor_data().data()),
+                  content.data(), content.size());
+    }
+    return absl::OkStatus();
+  }
+
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;  // Not owned.
+  // If set, the rendezvous that batches this call with others.
+  RpcRemoteRendezvous* batcher_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
   CallOptions opts_;
@@ -271,6 +358,13 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
+  // Only host tensors are batched, since their content can be copied out of
+  // the batched response directly.
+  if (options_.recv_coalescing_window_us > 0 &&
+      (recv_args.alloc_attrs.on_host() ||
+       dst_device->tensorflow_accelerator_device_info() == nullptr)) {
+    call->batcher_ = this;
+  }
 
   // Record "call" in calls_ so that it can be aborted cleanly.
   RegisterCall(call, recv_args);
@@ -305,15 +399,152 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::EnqueueBatchedCall(RpcRecvTensorCall* call,
+                                             StatusCallback done) {
+  const string src_worker = call->src_worker_;
+  bool first_in_batch = false;
+  bool batch_full = false;
+  {
+    mutex_lock l(batch_mu_);
+    if (!unbatched_workers_.contains(src_worker)) {
+      std::vector<BatchedCall>& batch = batches_[src_worker];
+      batch.push_back({call, std::move(done)});
+      first_in_batch = batch.size() == 1;
+      batch_full = batch.size() >=
+                   static_cast<size_t>(options_.max_recv_batch_size);
+      call = nullptr;
+    }
+  }
+  if (call != nullptr) {
+    call->SendRecvTensor(std::move(done));
+  } else if (batch_full) {
+    FlushBatch(src_worker);
+  } else if (first_in_batch) {
+    Ref();
+    env_->env->SchedClosureAfter(options_.recv_coalescing_window_us,
+                                 [this, src_worker]() {
+                                   FlushBatch(src_worker);
+                                   Unref();
+                                 });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker) {
+  std::vector<BatchedCall> calls;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = batches_.find(src_worker);
+    if (it == batches_.end()) return;
+    calls = std::move(it->second);
+    batches_.erase(it);
+  }
+  metrics::RecordRecvTensorBatchSize(calls.size());
+  if (calls.size() == 1) {
+    calls[0].call->SendRecvTensor(std::move(calls[0].done));
+    return;
+  }
+
+  auto* batch = new RecvTensorsBatch;
+  batch->calls = std::move(calls);
+  for (BatchedCall& batched : batch->calls) {
+    // The calls of a batch belong to the same step, so aborting one of them
+    // cancels the whole batch.
+    batched.call->opts_.SetCancelCallback(
+        [batch]() { batch->opts.StartCancel(); });
+    *batch->request.add_request() = batched.call->req_;
+  }
+  auto abort_checked = std::make_shared<Notification>();
+  // All the calls hold a reference to the worker until they are done.
+  batch->calls[0].call->wi_->RecvTensorsAsync(
+      &batch->opts, &batch->request, &batch->response,
+      [this, batch, abort_checked](const Status& s) {
+        abort_checked->WaitForNotification();
+        FinishBatch(batch, s);
+      });
+
+  // NOTE: As in `SendRecvTensor`, check for an abort after sending out the RPC
+  // since a call may have been aborted before the RPC could be cancelled.
+  for (const BatchedCall& batched : batch->calls) {
+    if (!batched.call->status().ok()) {
+      batch->opts.StartCancel();
+      break;
+    }
+  }
+  abort_checked->Notify();
+}
+
+void RpcRemoteRendezvous::FinishBatch(RecvTensorsBatch* batch,
+                                      const Status& s) {
+  for (BatchedCall& batched : batch->calls) {
+    batched.call->opts_.ClearCancelCallback();
+  }
+  if (errors::IsUnimplemented(s)) {
+    // The source worker does not support RecvTensors, so fall back to
+    // sending the recvs one by one.
+    {
+      mutex_lock l(batch_mu_);
+      unbatched_workers_.insert(batch->calls[0].call->src_worker_);
+    }
+    for (BatchedCall& batched : batch->calls) {
+      batched.call->SendRecvTensor(std::move(batched.done));
+    }
+    delete batch;
+    return;
+  }
+
+  RecvTensorsResponse& response = batch->response;
+  const int num_calls = batch->calls.size();
+  Status batch_status = s;
+  if (batch_status.ok() && (response.response_size() != num_calls ||
+                            response.content_offset_size() != num_calls)) {
+    batch_status = errors::Internal("RecvTensors response has ",
+                                    response.response_size(),
+                                    " tensors, expected ", num_calls);
+  }
+  // The content of a tensor ends where the content of the next one starts.
+  std::vector<int64_t> content_end(num_calls, response.content().size());
+  for (int i = num_calls - 2; batch_status.ok() && i >= 0; --i) {
+    const int64_t next_offset = response.content_offset(i + 1);
+    content_end[i] = next_offset >= 0 ? next_offset : content_end[i + 1];
+  }
+  // NOTE: The done callback of the last call can delete this rendezvous.
+  for (int i = 0; i < num_calls; ++i) {
+    BatchedCall& batched = batch->calls[i];
+    Status call_status = batch_status;
+    if (call_status.ok()) {
+      const int64_t offset = response.content_offset(i);
+      if (offset > content_end[i] ||
+          content_end[i] > static_cast<int64_t>(response.content().size())) {
+        call_status = errors::Internal("Invalid content offset ", offset,
+                                       " in RecvTensors response");
+      } else {
+        absl::string_view content;
+        if (offset >= 0) {
+          content = absl::string_view(response.content())
+                        .substr(offset, content_end[i] - offset);
+        }
+        call_status = batched.call->DecodeBatchedResponse(
+            response.mutable_response(i), offset, content);
+      }
+    }
+    batched.done(call_status);
+  }
+  delete batch;
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : RpcRendezvousMgr(env, RpcRendezvousMgrOptions()) {}
+
+RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env,
+                                   const RpcRendezvousMgrOptions& options)
+    : BaseRendezvousMgr(env), options_(options) {}
 
 tsl::core::RefCountPtr<BaseRemoteRendezvous> RpcRendezvousMgr::Create(
     int64_t step_id, const WorkerEnv* worker_env) {
   return tsl::core::RefCountPtr<BaseRemoteRendezvous>(
-      new RpcRemoteRendezvous(worker_env, step_id));
+      new RpcRemoteRendezvous(worker_env, step_id, options_));
 }
 
 }  // end namespace tensorflow
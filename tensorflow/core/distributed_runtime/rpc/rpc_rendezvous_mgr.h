@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 
+#include <cstdint>
+
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/platform/macros.h"
@@ -24,6 +26,17 @@ namespace tensorflow {
 
 class DeviceMgr;
 
+struct RpcRendezvousMgrOptions {
+  // If positive, the recvs of host tensors from the same worker that start
+  // within this many microseconds of the first are sent together in one
+  // RecvTensors RPC, which saves the per-RPC overhead of many small tensors.
+  int64_t recv_coalescing_window_us = 0;
+
+  // The maximum number of recvs sent in one RecvTensors RPC. A batch is sent
+  // as soon as it is full.
+  int max_recv_batch_size = 64;
+};
+
 // RendezvousMgr keeps track of a set of local rendezvous instances.
 // All tensors sent by this worker are buffered in a RendezvousMgr
 // until the tensor is received.  Each global unique "step_id"
@@ -45,12 +58,16 @@ class DeviceMgr;
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
+  RpcRendezvousMgr(const WorkerEnv* env,
+                   const RpcRendezvousMgrOptions& options);
 
  protected:
   tsl::core::RefCountPtr<BaseRemoteRendezvous> Create(
       int64_t step_id, const WorkerEnv* worker_env) override;
 
  private:
+  const RpcRendezvousMgrOptions options_;
+
   RpcRendezvousMgr(const RpcRendezvousMgr&) = delete;
   void operator=(const RpcRendezvousMgr&) = delete;
 };
@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -66,6 +71,49 @@ class DummyWorker : public TestWorkerInterface {
       done(absl::OkStatus());
     });
   }
+
+  // Returns the edge number of each key as a float tensor, e.g. 3.0 for
+  // "foo3".
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override {
+    if (!support_batching_) {
+      done(errors::Unimplemented("RecvTensorsAsync"));
+      return;
+    }
+    {
+      mutex_lock l(mu_);
+      batch_sizes_.push_back(request->request_size());
+    }
+    for (const RecvTensorRequest& recv_request : request->request()) {
+      Rendezvous::ParsedKey key;
+      TF_CHECK_OK(Rendezvous::ParseKey(recv_request.rendezvous_key(), &key));
+      int32_t edge = 0;
+      CHECK(strings::safe_strto32(key.edge_name.substr(3), &edge));
+      const float value = edge;
+      TensorProto* proto = response->add_response()->mutable_tensor();
+      proto->set_dtype(DT_FLOAT);
+      proto->mutable_tensor_shape()->add_dim()->set_size(1);
+      response->add_content_offset(response->content().size());
+      response->mutable_content()->append(reinterpret_cast<const char*>(&value),
+                                          sizeof(value));
+    }
+    SchedClosure([done = std::move(done)]() { done(absl::OkStatus()); });
+  }
+
+  void set_support_batching(bool support_batching) {
+    support_batching_ = support_batching;
+  }
+
+  std::vector<int> batch_sizes() {
+    mutex_lock l(mu_);
+    return batch_sizes_;
+  }
+
+ private:
+  bool support_batching_ = true;
+  mutex mu_;
+  std::vector<int> batch_sizes_ TF_GUARDED_BY(mu_);
 };
 
 // Fake cache implementation for WorkerEnv.
@@ -80,6 +128,10 @@ class DummyWorkerCache : public WorkerCacheInterface {
     }
     return dummy_remote_worker_;
   }
+  DummyWorker* worker() {
+    GetOrCreateWorker("");
+    return dummy_remote_worker_;
+  }
   Status GetEagerClientCache(
       std::unique_ptr<eager::EagerClientCache>* eager_client_cache) override {
     return errors::Unimplemented("Unimplemented.");
@@ -104,7 +156,9 @@ static Device* CreateDevice(const char* type, const char* name) {
    public:
     explicit FakeDevice(const DeviceAttributes& attr) : Device(nullptr, attr) {}
     Status Sync() override { return absl::OkStatus(); }
-    Allocator* GetAllocator(AllocatorAttributes) override { return nullptr; }
+    Allocator* GetAllocator(AllocatorAttributes) override {
+      return cpu_allocator();
+    }
   };
   DeviceAttributes attr;
   attr.set_name(name);
@@ -342,4 +396,87 @@ TEST_F(RpcRendezvousMgrTest, RemoteRecvAsyncMany) {
   rmgr_.Cleanup(step_id);
 }
 
+TEST_F(RpcRendezvousMgrTest, RemoteRecvCoalesced) {
+  constexpr int64_t kWindowUs = 100000;
+  RpcRendezvousMgrOptions options;
+  options.recv_coalescing_window_us = kWindowUs;
+  options.max_recv_batch_size = 4;
+  RpcRendezvousMgr rmgr(&env, options);
+  const int64_t step_id = 123;
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    constexpr int kNumRecvs = 8;
+    std::vector<Tensor> vals(kNumRecvs);
+    mutex mu;
+    Status status;
+    BlockingCounter counter(kNumRecvs);
+    for (int i = 0; i < kNumRecvs; ++i) {
+      const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+          "/job:worker/replica:1/task:2/cpu:0", 7890,
+          "/job:mnist/replica:1/task:2/cpu:1", strings::StrCat("foo", i),
+          FrameAndIter(0, 0)));
+      rendez->RecvAsync(key, Rendezvous::Args(),
+                        [&, i](const Status& s, const Rendezvous::Args&,
+                               const Rendezvous::Args&, const Tensor& val,
+                               const bool) {
+                          {
+                            mutex_lock l(mu);
+                            status.Update(s);
+                            vals[i] = val;
+                          }
+                          counter.DecrementCount();
+                        });
+    }
+    counter.Wait();
+    TF_ASSERT_OK(status);
+    for (int i = 0; i < kNumRecvs; ++i) {
+      ASSERT_EQ(vals[i].dtype(), DT_FLOAT);
+      EXPECT_EQ(vals[i].flat<float>()(0), i);
+    }
+    EXPECT_EQ(cache_->worker()->batch_sizes(), std::vector<int>({4, 4}));
+  }
+  rmgr.Cleanup(step_id);
+  // Wait for the flush timers, which hold a reference to the rendezvous.
+  Env::Default()->SleepForMicroseconds(3 * kWindowUs);
+}
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvCoalescedFallsBack) {
+  constexpr int64_t kWindowUs = 1000;
+  cache_->worker()->set_support_batching(false);
+  RpcRendezvousMgrOptions options;
+  options.recv_coalescing_window_us = kWindowUs;
+  RpcRendezvousMgr rmgr(&env, options);
+  const int64_t step_id = 123;
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr.Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    constexpr int kNumRecvs = 16;
+    mutex mu;
+    Status status;
+    BlockingCounter counter(kNumRecvs);
+    for (int i = 0; i < kNumRecvs; ++i) {
+      const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+          "/job:worker/replica:1/task:2/cpu:0", 7890,
+          "/job:mnist/replica:1/task:2/cpu:1", strings::StrCat("foo", i),
+          FrameAndIter(0, 0)));
+      rendez->RecvAsync(key, Rendezvous::Args(),
+                        [&](const Status& s, const Rendezvous::Args&,
+                            const Rendezvous::Args&, const Tensor&,
+                            const bool) {
+                          {
+                            mutex_lock l(mu);
+                            status.Update(s);
+                          }
+                          counter.DecrementCount();
+                        });
+    }
+    counter.Wait();
+    TF_ASSERT_OK(status);
+    EXPECT_TRUE(cache_->worker()->batch_sizes().empty());
+  }
+  rmgr.Cleanup(step_id);
+  Env::Default()->SleepForMicroseconds(3 * kWindowUs);
+}
+
 }  // namespace tensorflow
@@ -20,8 +20,16 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
+namespace {
+
+// Tensor contents smaller than this are copied rather than shared with the
+// source, since the copy is cheaper than keeping the source buffer alive.
+constexpr int kMinSharedTensorBytes = 1024;
+
+}  // namespace
 
 TensorResponse::Source::~Source() {}
 
@@ -81,6 +89,11 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 
 Status TensorResponse::ParseFrom(Source* source) {
   if (!on_host_) {
+    const DeviceBase::AcceleratorDeviceInfo* device_info =
+        device_->tensorflow_accelerator_device_info();
+    if (device_info != nullptr && device_info->default_context != nullptr) {
+      return ParseToDevice(source, device_info->default_context);
+    }
     protobuf::io::CodedInputStream input(source->contents());
 
     // Pre-parse into local storage, then delegate to device.
@@ -101,12 +114,58 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return absl::OkStatus();
+  // The content can only be used in place if it needs no particular memory.
+  const bool share_buffers =
+      !alloc_attrs_.gpu_compatible() && !alloc_attrs_.nic_compatible();
+  if (ParseFast(source, allocator_, share_buffers)) return absl::OkStatus();
   meta_.Clear();
   if (ParseSlow(source)) return absl::OkStatus();
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
 
+Status TensorResponse::ParseToDevice(Source* source,
+                                     DeviceContext* device_context) {
+  ClearTensor();
+  AllocatorAttributes host_attrs;
+  host_attrs.set_on_host(true);
+  host_attrs.set_gpu_compatible(true);
+  if (!ParseFast(source, device_->GetAllocator(host_attrs),
+                 /*share_buffers=*/false)) {
+    // Only tensors that can be memcpy'ed are parsed this way, let the device
+    // parse the others.
+    meta_.Clear();
+    protobuf::io::CodedInputStream input(source->contents());
+    if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
+      return errors::InvalidArgument("Cannot parse tensor from response");
+    }
+    Status s =
+        device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    // Reduce memory usage for big tensors.
+    {
+      TensorProto empty;
+      meta_.mutable_tensor()->Swap(&empty);
+    }
+    meta_.clear_tensor();
+    return s;
+  }
+
+  Tensor host_tensor = std::move(tensor_);
+  tensor_ = Tensor(allocator_, host_tensor.dtype(), host_tensor.shape());
+  if (host_tensor.NumElements() == 0) return absl::OkStatus();
+  Notification n;
+  Status status;
+  // TensorResponse is initialized with the devices of the worker, so the
+  // device is a Device.
+  device_context->CopyCPUTensorToDevice(&host_tensor,
+                                        static_cast<Device*>(device_), &tensor_,
+                                        [&n, &status](const Status& s) {
+                                          status = s;
+                                          n.Notify();
+                                        });
+  n.WaitForNotification();
+  return status;
+}
+
 // Define some helper routines for decoding protocol buffer wire format data
 namespace {
 // We only need some of the wiretype values for this code
@@ -144,7 +203,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Allocator* allocator, Source* share_source) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -155,7 +215,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -195,12 +255,29 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        if (share_source != nullptr && num_bytes >= kMinSharedTensorBytes &&
+            static_cast<size_t>(num_bytes) ==
+                shape.num_elements() * DataTypeSize(tensor_meta->dtype())) {
+          // Use the content in place if it is contiguous and aligned in the
+          // buffer of the source.
+          const void* data;
+          int size;
+          if (input->GetDirectBufferPointer(&data, &size) &&
+              size >= num_bytes &&
+              reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0) {
+            TensorBuffer* buffer = share_source->ShareBuffer(
+                static_cast<const char*>(data), num_bytes);
+            if (buffer != nullptr) {
+              tensor_ = Tensor(tensor_meta->dtype(), shape, buffer);
+              buffer->Unref();
+              if (!input->Skip(num_bytes)) return false;
+              break;
+            }
+          }
+        }
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -215,7 +292,8 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator,
+                               bool share_buffers) {
   protobuf::io::CodedInputStream input(source->contents());
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
@@ -233,7 +311,8 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(), allocator,
+                                   share_buffers ? source : nullptr)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -26,6 +26,7 @@ limitations under the License.
 namespace tensorflow {
 
 class DeviceBase;
+class DeviceContext;
 class TensorProto;
 
 // TensorResponse can be used as the destination of an RPC that returns
@@ -63,6 +64,16 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // If the "size" bytes at "data", read from the last stream returned by
+    // contents(), lie in memory that can outlive the stream, returns a
+    // TensorBuffer that aliases them and keeps them alive, so that the
+    // tensor content can be used without copying it. The caller owns a ref
+    // on the result. Returns nullptr, the default, if the bytes must be
+    // copied.
+    virtual TensorBuffer* ShareBuffer(const char* data, size_t size) {
+      return nullptr;
+    }
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -91,10 +102,17 @@ class TensorResponse {
   DeviceBase* device() const { return device_; }
 
  private:
+  // Parses the tensor content into memory from "allocator". If
+  // "share_source" is not null, the content is used in place when it can be
+  // shared with it.
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
+                             TensorProto* tensor_meta, Allocator* allocator,
+                             Source* share_source);
+  bool ParseFast(Source* source, Allocator* allocator, bool share_buffers);
   bool ParseSlow(Source* source);
+  // Parses the tensor content into host memory that "device_context" can
+  // copy from, and copies it to a tensor allocated on the device.
+  Status ParseToDevice(Source* source, DeviceContext* device_context);
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
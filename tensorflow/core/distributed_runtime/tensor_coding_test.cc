@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <optional>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -156,6 +160,88 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// A TensorBuffer that aliases memory owned by the test.
+class AliasingTensorBuffer : public TensorBuffer {
+ public:
+  AliasingTensorBuffer(const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {}
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+};
+
+// Yields data in a single block, and shares it.
+class SharingArraySource : public TensorResponse::Source {
+ public:
+  SharingArraySource(const char* data, int size) : data_(data), size_(size) {}
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_.emplace(data_, size_);
+    return &*stream_;
+  }
+
+  TensorBuffer* ShareBuffer(const char* data, size_t size) override {
+    return new AliasingTensorBuffer(data, size);
+  }
+
+ private:
+  const char* data_;
+  const int size_;
+  std::optional<protobuf::io::ArrayInputStream> stream_;
+};
+
+// Parses "src" from a buffer whose tensor content starts "misalignment"
+// bytes after an aligned address, and returns whether it was shared.
+bool ParsesSharedTensor(const Tensor& src, int misalignment) {
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  // The tensor content is the last field of the encoding.
+  const size_t content_offset = encoded.size() - src.TotalBytes();
+
+  string storage(encoded.size() + 2 * EIGEN_MAX_ALIGN_BYTES, '\0');
+  const intptr_t content_address =
+      reinterpret_cast<intptr_t>(storage.data()) + content_offset;
+  const size_t start = (EIGEN_MAX_ALIGN_BYTES -
+                        content_address % EIGEN_MAX_ALIGN_BYTES) %
+                           EIGEN_MAX_ALIGN_BYTES +
+                       misalignment;
+  storage.replace(start, encoded.size(), encoded);
+  SharingArraySource source(storage.data() + start, encoded.size());
+
+  TensorResponse response;
+  DummyDevice cpu_device(Env::Default());
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  test::ExpectTensorEqual<float>(response.tensor(), src);
+  return response.tensor().tensor_data().data() ==
+         storage.data() + start + content_offset;
+}
+
+TEST(TensorResponseSharingTest, SharesAlignedContent) {
+  Tensor src(DT_FLOAT, TensorShape({4, 256}));
+  src.flat<float>().setRandom();
+  EXPECT_TRUE(ParsesSharedTensor(src, /*misalignment=*/0));
+}
+
+TEST(TensorResponseSharingTest, CopiesMisalignedContent) {
+  Tensor src(DT_FLOAT, TensorShape({4, 256}));
+  src.flat<float>().setRandom();
+  EXPECT_FALSE(ParsesSharedTensor(src, /*misalignment=*/1));
+}
+
+TEST(TensorResponseSharingTest, CopiesSmallContent) {
+  Tensor src(DT_FLOAT, TensorShape({4, 4}));
+  src.flat<float>().setRandom();
+  EXPECT_FALSE(ParsesSharedTensor(src, /*misalignment=*/0));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
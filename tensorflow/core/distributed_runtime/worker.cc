@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/worker.h"
 
+#include <atomic>
+#include <string>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
@@ -455,6 +457,45 @@ void Worker::CompleteInstanceAsync(CallOptions* opts,
   }
 }
 
+void Worker::CompleteInstancesAsync(CallOptions* opts,
+                                    const CompleteInstancesRequest* request,
+                                    CompleteInstancesResponse* response,
+                                    StatusCallback done) {
+  if (!env_->collective_executor_mgr) {
+    done(
+        errors::Internal("Runtime not initialized with CollectiveExecutorMgr"));
+    return;
+  }
+  const int num = request->request_size();
+  if (num == 0) {
+    done(absl::OkStatus());
+    return;
+  }
+  for (int i = 0; i < num; ++i) {
+    response->add_response();
+    response->add_status_code(error::OK);
+    response->add_status_error_message("");
+  }
+  // Counts the instances left to complete.
+  auto* pending = new std::atomic<int>(num);
+  for (int i = 0; i < num; ++i) {
+    env_->collective_executor_mgr->GetParamResolver()->CompleteInstanceAsync(
+        &request->request(i), response->mutable_response(i),
+        &cancellation_manager_, [response, pending, i, done](const Status& s) {
+          if (!s.ok()) {
+            response->mutable_response(i)->Clear();
+            response->set_status_code(
+                i, static_cast<error::Code>(s.code()));
+            response->set_status_error_message(i, std::string(s.message()));
+          }
+          if (pending->fetch_sub(1) == 1) {
+            delete pending;
+            done(absl::OkStatus());
+          }
+        });
+  }
+}
+
 void Worker::GetStepSequenceAsync(const GetStepSequenceRequest* request,
                                   GetStepSequenceResponse* response,
                                   StatusCallback done) {
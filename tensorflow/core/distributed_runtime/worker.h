@@ -104,6 +104,11 @@ class Worker : public WorkerInterface {
                              CompleteInstanceResponse* response,
                              StatusCallback done) override;
 
+  void CompleteInstancesAsync(CallOptions* opts,
+                              const CompleteInstancesRequest* request,
+                              CompleteInstancesResponse* response,
+                              StatusCallback done) override;
+
   void GetStepSequenceAsync(const GetStepSequenceRequest* request,
                             GetStepSequenceResponse* response,
                             StatusCallback done) override;
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -106,6 +107,16 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  // Receives the tensors of several RecvTensor requests in one call. Workers
+  // that do not support it return Unimplemented, and the caller should send
+  // the requests one at a time instead.
+  virtual void RecvTensorsAsync(CallOptions* opts,
+                                const RecvTensorsRequest* request,
+                                RecvTensorsResponse* response,
+                                StatusCallback done) {
+    done(errors::Unimplemented("RecvTensorsAsync is not supported."));
+  }
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -125,6 +136,16 @@ class WorkerInterface {
                                      CompleteInstanceResponse* response,
                                      StatusCallback done) = 0;
 
+  // Completes several collective instances in one call, with one status per
+  // instance. Workers that do not support it return Unimplemented, and the
+  // caller should complete the instances one at a time instead.
+  virtual void CompleteInstancesAsync(CallOptions* opts,
+                                      const CompleteInstancesRequest* request,
+                                      CompleteInstancesResponse* response,
+                                      StatusCallback done) {
+    done(errors::Unimplemented("CompleteInstancesAsync is not supported."));
+  }
+
   virtual void GetStepSequenceAsync(const GetStepSequenceRequest* request,
                                     GetStepSequenceResponse* response,
                                     StatusCallback done) = 0;
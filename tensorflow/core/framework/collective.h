@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_COLLECTIVE_H_
 #define TENSORFLOW_CORE_FRAMEWORK_COLLECTIVE_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/intrusive_ptr.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -396,6 +399,16 @@ class CollectiveExecutor : public core::RefCounted {
   void operator=(const CollectiveExecutor&) = delete;
 };
 
+// State that collective implementations may keep across the executions of the
+// same instance on the same device, such as constant tensors already copied to
+// the device. The collective executor drops it when the membership of the
+// group changes. Executions of the instance may run concurrently, so that
+// cached tensors must not be modified.
+struct CollectiveInstanceScratch {
+  mutex mu;
+  std::unordered_map<string, Tensor> tensors TF_GUARDED_BY(mu);
+};
+
 struct CollectiveContext {
   CollectiveExecutor* col_exec;                  // Not owned
   NcclCommunicatorInterface* nccl_communicator;  // Not owned
@@ -410,6 +423,8 @@ struct CollectiveContext {
   Device* device;       // The device for which this instance labors
   const string device_name;
   DeviceLocality device_locality;
+  // Kept across the executions of the instance. May be null.
+  std::shared_ptr<CollectiveInstanceScratch> scratch;
 
   CollectiveContext(CollectiveExecutor* col_exec,
                     NcclCommunicatorInterface* nccl_communicator,
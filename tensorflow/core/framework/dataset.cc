@@ -1128,7 +1128,59 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
     node_->record_start(now_nanos);
   }
   out_tensors->clear();
-  Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
+  Status s = FinishGetNext(ctx, out_tensors, end_of_sequence,
+                           GetNextInternal(ctx, out_tensors, end_of_sequence));
+  if (collect_resource_usage(ctx)) {
+    int64_t now_nanos = EnvTime::NowNanos();
+    node_->record_stop(now_nanos);
+    if (output_was_recording) {
+      node_->output()->record_start(now_nanos);
+    }
+  }
+  DVLOG(3) << prefix() << " GetNext exit";
+  return s;
+}
+
+void DatasetBaseIterator::GetNextAsync(IteratorContext* ctx,
+                                       std::vector<Tensor>* out_tensors,
+                                       bool* end_of_sequence,
+                                       GetNextDoneCallback done) {
+  profiler::TraceMe activity([&] { return BuildTraceMeName(); },
+                             profiler::TraceMeLevel::kInfo);
+  DVLOG(3) << prefix() << " GetNextAsync enter";
+  // Processing time is recorded per thread, so only the time spent on the
+  // calling thread is attributed to this iterator. `ctx` may no longer be
+  // valid once `done` has been invoked.
+  const bool collect_resource_usage = this->collect_resource_usage(ctx);
+  bool output_was_recording =
+      node_ && node_->output() && node_->output()->is_recording();
+  if (collect_resource_usage) {
+    int64_t now_nanos = EnvTime::NowNanos();
+    if (output_was_recording) {
+      node_->output()->record_stop(now_nanos);
+    }
+    node_->record_start(now_nanos);
+  }
+  out_tensors->clear();
+  GetNextAsyncInternal(
+      ctx, out_tensors, end_of_sequence,
+      [this, ctx, out_tensors, end_of_sequence,
+       done = std::move(done)](Status s) {
+        done(FinishGetNext(ctx, out_tensors, end_of_sequence, std::move(s)));
+      });
+  if (collect_resource_usage) {
+    int64_t now_nanos = EnvTime::NowNanos();
+    node_->record_stop(now_nanos);
+    if (output_was_recording) {
+      node_->output()->record_start(now_nanos);
+    }
+  }
+  DVLOG(3) << prefix() << " GetNextAsync exit";
+}
+
+Status DatasetBaseIterator::FinishGetNext(IteratorContext* ctx,
+                                          std::vector<Tensor>* out_tensors,
+                                          bool* end_of_sequence, Status s) {
   ctx->SaveCheckpoint(this);
   if (!SymbolicCheckpointCompatible()) {
     ctx->UpdateCheckpointStatus([this]() {
@@ -1144,13 +1196,6 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
       out_tensors->clear();
     }
   }
-  if (collect_resource_usage(ctx)) {
-    int64_t now_nanos = EnvTime::NowNanos();
-    node_->record_stop(now_nanos);
-    if (output_was_recording) {
-      node_->output()->record_start(now_nanos);
-    }
-  }
   if (TF_PREDICT_FALSE(errors::IsOutOfRange(s))) {
     s = errors::Internal("Iterator \"", params_.prefix,
                          "\" returned `OutOfRange`. This indicates an "
@@ -1159,7 +1204,6 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
                          s.message());
     LOG(ERROR) << s;
   }
-  DVLOG(3) << prefix() << " GetNext exit";
   return s;
 }
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstdlib>
 #include <deque>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <optional>
@@ -1034,9 +1035,6 @@ class IteratorBase : public Checkpointable {
   // before they are assigned.
   //
   // This method is thread-safe.
-  //
-  // TODO(mrry): Define `GetNextAsync()` or `GetNextManyAsync()`, and
-  // potentially remove this method.
   virtual Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
 
@@ -1045,6 +1043,30 @@ class IteratorBase : public Checkpointable {
     return GetNext(&ctx, out_tensors, end_of_sequence);
   }
 
+  // Invoked with the status of a `GetNextAsync` call.
+  using GetNextDoneCallback = std::function<void(Status)>;
+
+  // Asynchronous version of `GetNext`, with the same contract for
+  // `out_tensors` and `end_of_sequence`.
+  //
+  // Instead of blocking the calling thread until an element is available,
+  // iterators that buffer elements produced by background threads register
+  // the call and invoke `done` from the thread that produces the element.
+  // `done` may also be invoked on the calling thread before this method
+  // returns, and it should not block. Other iterators compute the element
+  // with `GetNext` before returning.
+  //
+  // `ctx`, `out_tensors`, and `end_of_sequence` must remain valid, and the
+  // iterator must not be destroyed, until `done` has been invoked and this
+  // method has returned.
+  //
+  // This method is thread-safe.
+  virtual void GetNextAsync(IteratorContext* ctx,
+                            std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence, GetNextDoneCallback done) {
+    done(GetNext(ctx, out_tensors, end_of_sequence));
+  }
+
   // If a dataset needs to provide its own index mapper behavior to support
   // global shuffling, implement this method.
   virtual IndexMapperFn GetIndexMapper(
@@ -1497,6 +1519,9 @@ class DatasetBaseIterator : public IteratorBase {
     return GetNext(&ctx, out_tensors, end_of_sequence);
   }
 
+  void GetNextAsync(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                    bool* end_of_sequence, GetNextDoneCallback done) final;
+
   Status Skip(IteratorContext* ctx, int num_to_skip, bool* end_of_sequence,
               int* num_skipped) final;
 
@@ -1532,6 +1557,18 @@ class DatasetBaseIterator : public IteratorBase {
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) = 0;
 
+  // Internal implementation of GetNextAsync that is wrapped in tracing logic.
+  //
+  // Iterators that would otherwise block waiting for background work should
+  // override this to invoke `done` once the element is available. By default,
+  // `GetNextInternal` is run on the calling thread.
+  virtual void GetNextAsyncInternal(IteratorContext* ctx,
+                                    std::vector<Tensor>* out_tensors,
+                                    bool* end_of_sequence,
+                                    GetNextDoneCallback done) {
+    done(GetNextInternal(ctx, out_tensors, end_of_sequence));
+  }
+
   // Internal implementation of Skip that is wrapped in tracing logic
   virtual Status SkipInternal(IteratorContext* ctx, int num_to_skip,
                               bool* end_of_sequence, int* num_skipped);
@@ -1627,6 +1664,11 @@ class DatasetBaseIterator : public IteratorBase {
     return ctx->model() && node_;
   }
 
+  // Bookkeeping shared by `GetNext` and `GetNextAsync` once the element has
+  // been produced with status `s`. Returns the status to report to the caller.
+  Status FinishGetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                       bool* end_of_sequence, Status s);
+
   string traceme_metadata_;
   BaseParams params_;
 };
@@ -31,6 +31,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/control_flow.h"
@@ -156,6 +157,19 @@ class Device : public DeviceBase {
     return OkStatus();
   }
 
+  // Sets `device_context_map`, indexed by node id, to the DeviceContext* to
+  // execute each node of `graph` with, for devices that execute the nodes of a
+  // graph on different streams. Nodes without a context in the map, or all of
+  // them if the device leaves it empty, use the context from
+  // TryGetDeviceContext().
+  //
+  // The caller takes ownership of one reference on each DeviceContext* in the
+  // map, and should call Unref().
+  virtual Status FillContextMap(
+      const Graph* graph, std::vector<DeviceContext*>* device_context_map) {
+    return OkStatus();
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
@@ -140,14 +140,10 @@ LocalRendezvous::~LocalRendezvous() {
   }
 }
 
-namespace {
-uint64 KeyHash(const StringPiece& k) { return Hash64(k.data(), k.size()); }
-}  // namespace
-
 Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
                              const Rendezvous::Args& send_args,
                              const Tensor& val, const bool is_dead) {
-  uint64 key_hash = KeyHash(key.FullKey());
+  const uint64 key_hash = key.hash();
   DVLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
 
   if (is_dead) {
@@ -166,7 +162,7 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
   auto& bucket = table_buckets_[bucket_index];
   bucket.mu.lock();
 
-  auto it = bucket.table.insert({key_hash, ItemQueue()}).first;
+  auto it = bucket.table.try_emplace(key_hash).first;
   ItemQueue* queue = &it->second;
   if (queue->head == nullptr || queue->head->type == Item::kSend) {
     // There is no waiter for this message. Append the message
@@ -226,7 +222,7 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
 void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
                                 const Rendezvous::Args& recv_args,
                                 Rendezvous::DoneCallback done) {
-  uint64 key_hash = KeyHash(key.FullKey());
+  const uint64 key_hash = key.hash();
   DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
   tsl::core::RefCountPtr<Rendezvous> rc_keep_alive;
 
@@ -241,7 +237,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   auto& bucket = table_buckets_[bucket_index];
   bucket.mu.lock();
 
-  auto it = bucket.table.insert({key_hash, ItemQueue()}).first;
+  auto it = bucket.table.try_emplace(key_hash).first;
   ItemQueue* queue = &it->second;
   if (queue->head == nullptr || queue->head->type == Item::kRecv) {
     // There is no message to pick up.
@@ -256,7 +252,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
         Item* item = nullptr;
         {
           mutex_lock l(bucket.mu);
-          auto it = bucket.table.insert({key_hash, ItemQueue()}).first;
+          auto it = bucket.table.try_emplace(key_hash).first;
           ItemQueue* queue = &it->second;
           // Find an item in the queue with a cancellation token that matches
           // `token`, and remove it.
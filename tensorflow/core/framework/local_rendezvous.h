@@ -16,14 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -43,8 +44,10 @@ class LocalRendezvous {
   // Rendezvous), pass in its pointer in constructor so the LocalRendezvous
   // can make sure it outlives the async recv requests.
   // Pass in nullptr if the wrapping class is not refcounted.
+  // The keys are spread over at least kMinNumBuckets buckets, each with its own
+  // lock, or over `num_shards` if that is more.
   explicit LocalRendezvous(Rendezvous* owner, int num_shards)
-      : num_buckets_(num_shards > 0 ? num_shards : 1),
+      : num_buckets_(std::max(num_shards, kMinNumBuckets)),
         rc_owner_(owner),
         table_buckets_(std::make_unique<TableBucket[]>(num_buckets_)) {}
   ~LocalRendezvous();
@@ -82,14 +85,20 @@ class LocalRendezvous {
     Item* tail = nullptr;
   };
 
-  typedef gtl::FlatMap<uint64, ItemQueue> Table;
+  // Keyed by Rendezvous::ParsedKey::hash(). Empty tables don't allocate, so
+  // that the buckets of a per-step rendezvous are cheap to create.
+  typedef absl::flat_hash_map<uint64, ItemQueue> Table;
+
+  static constexpr int kMinNumBuckets = 16;
 
   const int num_buckets_;
   // Pointer to the owner class of this LocalRendezvous if it is refcounted,
   // nullptr otherwise.
   Rendezvous* rc_owner_;
 
-  struct TableBucket {
+  // Buckets are on separate cache lines, so that Send and Recv calls on
+  // different buckets don't contend.
+  struct alignas(64) TableBucket {
     mutex mu;
     Table table TF_GUARDED_BY(mu);
 
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/metrics.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -37,6 +39,15 @@ auto* persistent_cache_load_count = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/persistent_cache_load_count",
     "The number of times a binary is loaded from the persistent cache.");
 
+auto* xla_persistent_cache_lookups = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_persistent_cache_lookups",
+    "The number of lookups of the persistent XLA executable cache.", "result");
+
+auto* xla_compilation_cache_lookups = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_compilation_cache_lookups",
+    "The number of lookups of the XLA compilation cache of a device.",
+    "result");
+
 auto* aot_bef_mlir_load_count = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/aot_bef_mlir_load_count",
     "The number of times BEF and MLIR are deserialized instead of generated "
@@ -57,6 +68,22 @@ auto* graph_run_time_usecs_histogram = tsl::monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 20 (> 17 minutes)
     {tsl::monitoring::Buckets::Exponential(1000, 2, 20)});
 
+auto* checkpoint_restore_bytes = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/checkpoint/restore/bytes",
+    "The number of bytes restored from checkpoints by the RestoreV2 ops of a "
+    "task.",
+    "task");
+
+auto* checkpoint_restore_time_usecs = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/checkpoint/restore/time_usecs",
+    "The time spent in the RestoreV2 ops of a task in microseconds.", "task");
+
+auto* checkpoint_restore_throughput = tsl::monitoring::Sampler<1>::New(
+    {"/tensorflow/core/checkpoint/restore/throughput",
+     "The throughput of the RestoreV2 ops of a task in MB/s.", "task"},
+    // Power of 2 with bucket count 16 (> 32 GB/s)
+    {tsl::monitoring::Buckets::Exponential(1, 2, 16)});
+
 auto* graph_pending_queue_length_histogram = tsl::monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_pending_queue_length_histogram",
      "The number of pending (ready but not running) tasks in graph executor."},
@@ -75,6 +102,69 @@ auto* graph_run_output_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 14 (256MB)
     {tsl::monitoring::Buckets::Exponential(1, 4, 14)});
 
+auto* executor_work_stealing_pops = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/executor_work_stealing_pops",
+    "The number of ready nodes taken from a work-stealing executor lane, "
+    "by whether they came from the worker's own lane or were stolen.",
+    "source");
+
+auto* executor_coalesced_completions = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/executor_coalesced_async_completions",
+    "The number of async kernel completions that were queued while another "
+    "thread was propagating completions of the same step, and were propagated "
+    "in its batch.");
+
+auto* recv_tensor_batch_size = tsl::monitoring::Sampler<0>::New(
+    {"/tensorflow/core/recv_tensor_batch_size",
+     "The number of recvs from a remote worker sent in one RPC."},
+    // Power of 2 with bucket count 10 (512)
+    {tsl::monitoring::Buckets::Exponential(1, 2, 10)});
+
+auto* collective_compression_sent_bytes = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/collective_compression_sent_bytes",
+    "The number of bytes sent by compressed collective reductions.", "codec");
+
+auto* collective_compression_saved_bytes = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/collective_compression_saved_bytes",
+    "The number of bytes that compressed collective reductions saved "
+    "compared to sending uncompressed tensors.",
+    "codec");
+
+auto* tiered_lookup_table_lookups = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/tiered_lookup_table_lookups",
+    "The number of keys looked up in tiered lookup tables, by where they "
+    "were found.",
+    "result");
+
+auto* c_api_session_run_stage_usecs = tsl::monitoring::Sampler<1>::New(
+    {"/tensorflow/c/session_run_stage_usecs",
+     "The time in microseconds that session runs through the C API spent in "
+     "each stage.",
+     "stage"},
+    // Power of 2 with bucket count 24 (>8s)
+    {tsl::monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* c_api_tensors = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/c/tensors",
+    "The number of tensors fed to and fetched from session runs through the "
+    "C API, and of the buffers copied by TF_NewTensor because they were not "
+    "aligned.",
+    "kind");
+
+auto* session_executors_lookups = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/session_executors_lookups",
+    "The number of session runs that reused or created their executors, by "
+    "whether they ran through Session::Run or callables.",
+    "api", "result");
+
+auto* pool_allocator_shard_ops = tsl::monitoring::Counter<3>::New(
+    "/tensorflow/core/pool_allocator_shard_ops",
+    "The number of requests served by a shard of a sharded pool allocator, "
+    "by whether they hit the shard's free lists, missed and went to the "
+    "shared pool, or were evicted to the shared pool because the shard was "
+    "full.",
+    "allocator", "shard", "result");
+
 auto* graph_unused_outputs = tsl::monitoring::Counter<1>::New(
     "/tensorflow/core/graph_unused_outputs",
     "The number of unused outputs for ops of a given type.", "name");
@@ -269,6 +359,12 @@ auto* tf_data_service_optimal_number_of_workers =
         "Estimated optimal number of tf.data service workers based on the "
         "current workload.");
 
+auto* tf_data_service_splits_in_flight =
+    tsl::monitoring::Gauge<int64_t, 0>::New(
+        "/tensorflow/data/service/splits_in_flight",
+        "Number of dynamic sharding splits fetched by a tf.data service "
+        "worker from the dispatcher but not yet processed.");
+
 auto* tf_data_filename_counter = tsl::monitoring::Counter<2>::New(
     "/tensorflow/data/filename", "The file name read by a tf.data Dataset.",
     "name", "filename");
@@ -330,6 +426,12 @@ auto* tf_data_autotune_stopping_criteria_counter =
         "algorithm stopping criterion is met.",
         "name");
 
+auto* tf_data_bottleneck_counter = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/data/bottleneck",
+    "The number of times the analysis of a tf.data model finds each reason "
+    "for which the critical stage, by its root, limits the input pipeline.",
+    "reason", "stage");
+
 auto* tf_data_debug = tsl::monitoring::Counter<1>::New(
     "/tensorflow/data/debug",
     "The number of times this event occured, for debugging.", "event");
@@ -409,6 +511,49 @@ auto* graph_optimization_cache_load_count = tsl::monitoring::Counter<1>::New(
     "source"  // graph optimization source
 );
 
+auto* grappler_pass_runs = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/grappler/pass_runs",
+    "The number of times a Grappler optimizer ran on a graph of a model.",
+    "model", "pass");
+
+auto* grappler_pass_time_usecs = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/grappler/pass_time_usecs",
+    "The wall time spent running a Grappler optimizer on the graphs of a "
+    "model, in microseconds.",
+    "model", "pass");
+
+auto* grappler_pass_nodes_added = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/grappler/pass_nodes_added",
+    "The number of nodes a Grappler optimizer added to the graphs of a model, "
+    "for the runs that increased the number of nodes.",
+    "model", "pass");
+
+auto* grappler_pass_nodes_removed = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/grappler/pass_nodes_removed",
+    "The number of nodes a Grappler optimizer removed from the graphs of a "
+    "model, for the runs that decreased the number of nodes.",
+    "model", "pass");
+
+auto* grappler_pass_predicted_cost_added_usecs =
+    tsl::monitoring::Counter<2>::New(
+        "/tensorflow/core/grappler/pass_predicted_cost_added_usecs",
+        "The predicted run time a Grappler optimizer added to the graphs of a "
+        "model, in microseconds, for the runs that increased it.",
+        "model", "pass");
+
+auto* grappler_pass_predicted_cost_removed_usecs =
+    tsl::monitoring::Counter<2>::New(
+        "/tensorflow/core/grappler/pass_predicted_cost_removed_usecs",
+        "The predicted run time a Grappler optimizer removed from the graphs "
+        "of a model, in microseconds, for the runs that decreased it.",
+        "model", "pass");
+
+auto* grappler_pass_skipped = tsl::monitoring::Counter<2>::New(
+    "/tensorflow/core/grappler/pass_skipped",
+    "The number of times a Grappler optimizer was skipped on a graph of a "
+    "model because it was found to be unprofitable.",
+    "model", "pass");
+
 auto* xla_compilations = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilations",
     "The number of XLA compilations used to collect "
@@ -418,6 +563,11 @@ auto* xla_compilation_time_usecs = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_pending_async_compilations = tsl::monitoring::Gauge<int64_t, 0>::New(
+    "/tensorflow/core/xla_pending_async_compilations",
+    "The number of asynchronous XLA compilations waiting for a compiler "
+    "thread.");
+
 auto* xla_tpu_spmd_cores_per_replica = tsl::monitoring::Counter<1>::New(
     "/tensorflow/tpu/xla_spmd_cores_per_replica",
     "The number of cores used by XLA SPMD-replicated models.", "cores");
@@ -516,6 +666,11 @@ tsl::monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
 
+tsl::monitoring::CounterCell* GetPoolAllocatorShardCounter(
+    const string& allocator, const string& shard, const string& result) {
+  return pool_allocator_shard_ops->GetCell(allocator, shard, result);
+}
+
 tsl::monitoring::GaugeCell<std::function<std::string()>>* GetTFDataModelGauge(
     const string& id) {
   return tf_data_model_gauge->GetCell(id);
@@ -688,6 +843,10 @@ void RecordTFDataServiceOptimalNumberOfWorkers(int64_t number_of_workers) {
   tf_data_service_optimal_number_of_workers->GetCell()->Set(number_of_workers);
 }
 
+void RecordTFDataServiceSplitsInFlight(int64_t num_splits) {
+  tf_data_service_splits_in_flight->GetCell()->Set(num_splits);
+}
+
 void RecordTFDataFilename(const string& name, const string& filename) {
   tf_data_filename_counter->GetCell(name, filename)->IncrementBy(1);
 }
@@ -738,6 +897,10 @@ void RecordTFDataAutotuneStoppingCriteria(const string& name) {
   tf_data_autotune_stopping_criteria_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataBottleneck(const string& reason, const string& stage) {
+  tf_data_bottleneck_counter->GetCell(reason, stage)->IncrementBy(1);
+}
+
 void RecordTFDataDebug(const string& event) {
   tf_data_debug->GetCell(event)->IncrementBy(1);
 }
@@ -791,6 +954,14 @@ void UpdatePersistentCacheLoadCount() {
   persistent_cache_load_count_cell->IncrementBy(1);
 }
 
+void RecordXlaPersistentCacheLookup(const string& result) {
+  xla_persistent_cache_lookups->GetCell(result)->IncrementBy(1);
+}
+
+void RecordXlaCompilationCacheLookup(const string& result) {
+  xla_compilation_cache_lookups->GetCell(result)->IncrementBy(1);
+}
+
 void UpdateAotBefMlirLoadCount() {
   static auto* aot_bef_mlir_load_count_cell =
       aot_bef_mlir_load_count->GetCell();
@@ -904,6 +1075,34 @@ int64_t GetFunctionGraphOptimizationCacheLoadCount(
   return graph_optimization_cache_load_count->GetCell(mapped_source)->value();
 }
 
+void RecordGrapplerPassRun(const std::string& model, const std::string& pass,
+                           const uint64 time_usecs,
+                           const int64_t node_count_delta,
+                           std::optional<int64_t> predicted_cost_delta_usecs) {
+  grappler_pass_runs->GetCell(model, pass)->IncrementBy(1);
+  grappler_pass_time_usecs->GetCell(model, pass)->IncrementBy(time_usecs);
+  if (node_count_delta > 0) {
+    grappler_pass_nodes_added->GetCell(model, pass)->IncrementBy(
+        node_count_delta);
+  } else if (node_count_delta < 0) {
+    grappler_pass_nodes_removed->GetCell(model, pass)->IncrementBy(
+        -node_count_delta);
+  }
+  if (!predicted_cost_delta_usecs.has_value()) return;
+  if (*predicted_cost_delta_usecs > 0) {
+    grappler_pass_predicted_cost_added_usecs->GetCell(model, pass)
+        ->IncrementBy(*predicted_cost_delta_usecs);
+  } else if (*predicted_cost_delta_usecs < 0) {
+    grappler_pass_predicted_cost_removed_usecs->GetCell(model, pass)
+        ->IncrementBy(-*predicted_cost_delta_usecs);
+  }
+}
+
+void IncrementGrapplerPassSkippedCount(const std::string& model,
+                                       const std::string& pass) {
+  grappler_pass_skipped->GetCell(model, pass)->IncrementBy(1);
+}
+
 void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs) {
   if (distribution_time_usecs > 0) {
     tpu_variable_distribution_time_usecs->GetCell()->IncrementBy(
@@ -921,10 +1120,91 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void UpdateXlaPendingAsyncCompilations(int64_t delta) {
+  static std::atomic<int64_t> num_pending(0);
+  xla_pending_async_compilations->GetCell()->Set(num_pending += delta);
+}
+
+void RecordCheckpointRestore(const string& task, int64_t num_bytes,
+                             uint64 duration_usecs) {
+  checkpoint_restore_bytes->GetCell(task)->IncrementBy(num_bytes);
+  checkpoint_restore_time_usecs->GetCell(task)->IncrementBy(duration_usecs);
+  if (duration_usecs > 0) {
+    // Bytes per microsecond are MB/s.
+    checkpoint_restore_throughput->GetCell(task)->Add(
+        static_cast<double>(num_bytes) / duration_usecs);
+  }
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
 
+void RecordExecutorWorkStealing(int64_t local_hits, int64_t steals) {
+  static auto* local_cell = executor_work_stealing_pops->GetCell("local");
+  static auto* steal_cell = executor_work_stealing_pops->GetCell("steal");
+  if (local_hits > 0) local_cell->IncrementBy(local_hits);
+  if (steals > 0) steal_cell->IncrementBy(steals);
+}
+
+void RecordExecutorCoalescedCompletions(int64_t num_coalesced) {
+  static auto* cell = executor_coalesced_completions->GetCell();
+  if (num_coalesced > 0) cell->IncrementBy(num_coalesced);
+}
+
+void RecordRecvTensorBatchSize(int64_t batch_size) {
+  static auto* cell = recv_tensor_batch_size->GetCell();
+  cell->Add(batch_size);
+}
+
+void RecordCollectiveCompression(const string& codec, int64_t sent_bytes,
+                                 int64_t uncompressed_bytes) {
+  collective_compression_sent_bytes->GetCell(codec)->IncrementBy(sent_bytes);
+  if (uncompressed_bytes > sent_bytes) {
+    collective_compression_saved_bytes->GetCell(codec)->IncrementBy(
+        uncompressed_bytes - sent_bytes);
+  }
+}
+
+void RecordTieredLookupTableLookups(int64_t cache_hits, int64_t store_hits,
+                                    int64_t misses) {
+  if (cache_hits > 0) {
+    tiered_lookup_table_lookups->GetCell("cache_hit")->IncrementBy(cache_hits);
+  }
+  if (store_hits > 0) {
+    tiered_lookup_table_lookups->GetCell("store_hit")->IncrementBy(store_hits);
+  }
+  if (misses > 0) {
+    tiered_lookup_table_lookups->GetCell("miss")->IncrementBy(misses);
+  }
+}
+
+void RecordCApiSessionRunStage(const string& stage, uint64 duration_usecs) {
+  c_api_session_run_stage_usecs->GetCell(stage)->Add(duration_usecs);
+}
+
+HistogramProto GetCApiSessionRunStageLatencies(const string& stage) {
+  return c_api_session_run_stage_usecs->GetCell(stage)->value();
+}
+
+void RecordCApiTensors(const string& kind, int64_t num_tensors) {
+  if (num_tensors > 0) c_api_tensors->GetCell(kind)->IncrementBy(num_tensors);
+}
+
+int64_t GetCApiTensors(const string& kind) {
+  return c_api_tensors->GetCell(kind)->value();
+}
+
+void RecordSessionExecutorsLookup(const string& api, bool reused) {
+  session_executors_lookups->GetCell(api, reused ? "reused" : "created")
+      ->IncrementBy(1);
+}
+
+int64_t GetSessionExecutorsLookups(const string& api, bool reused) {
+  return session_executors_lookups->GetCell(api, reused ? "reused" : "created")
+      ->value();
+}
+
 void RecordPipelineProcessingTime(const string& id,
                                   double pipeline_processing_time_usec) {
   GetTFDataPipelineProcessingTimeGauge(id)->Set(pipeline_processing_time_usec);
@@ -17,9 +17,11 @@ limitations under the License.
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 
 #include "tensorflow/core/framework/dataset_options.pb.h"
+#include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/env.h"
@@ -72,6 +74,15 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 // The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 
+// Returns a counter that can be used to record the outcome of requests served
+// by one shard of a sharded PoolAllocator.
+//
+// The `allocator` argument is the name of the allocator, `shard` is the index
+// of the shard, and `result` is "hit", "miss" or "eviction".
+monitoring::CounterCell* GetPoolAllocatorShardCounter(const string& allocator,
+                                                      const string& shard,
+                                                      const string& result);
+
 // Returns a gauge than can be used to record the performance model information.
 //
 // The `id` argument represents the (unique) model ID.
@@ -192,6 +203,10 @@ void RecordTFDataServiceSnapshotOp(const std::string& path,
 // Records the current estimated optimal number of tf.data service workers.
 void RecordTFDataServiceOptimalNumberOfWorkers(int64_t number_of_workers);
 
+// Records the number of dynamic sharding splits which a tf.data service worker
+// has fetched from the dispatcher but not yet processed.
+void RecordTFDataServiceSplitsInFlight(int64_t num_splits);
+
 // Records the file name read by a tf.data Dataset.
 //
 // The `name` argument identifies the Dataset type (e.g. "TFRecordDataset").
@@ -235,6 +250,10 @@ void RecordTFDataAutoShardRewriteBatchSize(
 // criterion is met.
 void RecordTFDataAutotuneStoppingCriteria(const string& name);
 
+// Records the bottleneck of a tf.data input pipeline found by the periodic
+// analysis of its model: the reason and the root of the critical stage.
+void RecordTFDataBottleneck(const string& reason, const string& stage);
+
 // Records the number of times this event occured, for debugging.
 void RecordTFDataDebug(const string& event);
 
@@ -269,6 +288,49 @@ void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the nodes that a work-stealing executor step took from each
+// worker's own lane (`local_hits`) and from other workers' lanes (`steals`).
+void RecordExecutorWorkStealing(int64_t local_hits, int64_t steals);
+
+// Records async kernel completions that an executor step propagated in the
+// same batch as an earlier completion, instead of on their own.
+void RecordExecutorCoalescedCompletions(int64_t num_coalesced);
+
+// Records the number of recvs from a remote worker that were sent together in
+// one RecvTensors RPC, when recv coalescing is enabled. A recv that was sent
+// on its own counts as a batch of one.
+void RecordRecvTensorBatchSize(int64_t batch_size);
+
+// Records the bytes that a compressed collective reduction sent with `codec`,
+// and the bytes it would have sent uncompressed.
+void RecordCollectiveCompression(const string& codec, int64_t sent_bytes,
+                                 int64_t uncompressed_bytes);
+
+// Records lookups in tiered lookup tables: those served by the in-memory
+// cache, those served by the on-disk store, and those of absent keys.
+void RecordTieredLookupTableLookups(int64_t cache_hits, int64_t store_hits,
+                                    int64_t misses);
+
+// Records the time in microseconds that a run of a session through the C API
+// spent in `stage`: "inputs" (converting the feeds), "names" (building the
+// feed, fetch and target names), "run" (running the session) or "outputs"
+// (converting the fetches).
+void RecordCApiSessionRunStage(const string& stage, uint64 duration_usecs);
+HistogramProto GetCApiSessionRunStageLatencies(const string& stage);
+
+// Records the tensors that the C API fed to and fetched from a session run,
+// and, separately, the buffers that TF_NewTensor copied because they were not
+// aligned for zero-copy use. `kind` is "fed", "fetched" or "copied".
+void RecordCApiTensors(const string& kind, int64_t num_tensors);
+int64_t GetCApiTensors(const string& kind);
+
+// Records whether a session run reused the executors of an earlier run with
+// the same feeds, fetches and targets, or created them. `api` is "run" for
+// Session::Run and partial runs, and "callable" for callables, whose executors
+// are created by MakeCallable and reused by RunCallable.
+void RecordSessionExecutorsLookup(const string& api, bool reused);
+int64_t GetSessionExecutorsLookups(const string& api, bool reused);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -279,6 +341,15 @@ void RecordPipelineProcessingTime(const string& id,
 // Increments the count of binaries loaded from the persistent cache.
 void UpdatePersistentCacheLoadCount();
 
+// Records a lookup of the persistent XLA executable cache, whose `result` is
+// "hit", "miss" or "invalid" (an entry was found but couldn't be loaded).
+void RecordXlaPersistentCacheLookup(const string& result);
+
+// Records a lookup of the in-memory XLA compilation cache of a device, whose
+// `result` is "hit", "miss" or "pending" (the entry is being compiled
+// asynchronously).
+void RecordXlaCompilationCacheLookup(const string& result);
+
 // Increments the count of BEF and MLIR deserialized.
 void UpdateAotBefMlirLoadCount();
 
@@ -339,6 +410,20 @@ void IncrementFunctionGraphOptimizationCacheLoadCount(
 int64_t GetFunctionGraphOptimizationCacheLoadCount(
     GraphOptimizationSource source);
 
+// Records a run of the Grappler optimizer `pass` on a graph of `model`, that
+// took `time_usecs` and added `node_count_delta` nodes to the graph (a negative
+// value means nodes were removed). `predicted_cost_delta_usecs` is the change
+// in the run time of the graph predicted by the cost model, if it was
+// estimated.
+void RecordGrapplerPassRun(const std::string& model, const std::string& pass,
+                           uint64 time_usecs, int64_t node_count_delta,
+                           std::optional<int64_t> predicted_cost_delta_usecs);
+
+// Increments the number of times the Grappler optimizer `pass` was skipped on
+// a graph of `model` because it was found to be unprofitable.
+void IncrementGrapplerPassSkippedCount(const std::string& model,
+                                       const std::string& pass);
+
 // Records the activity of the first phase of the mlir bridge using the
 // tf_metadata.tf_mlir_bridge_first_phase_count metric.
 // bridge_type: replicated, nonreplicated, etc.
@@ -522,6 +607,18 @@ void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs);
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Adds `delta` to the number of asynchronous XLA compilations waiting for a
+// compiler thread.
+void UpdateXlaPendingAsyncCompilations(int64_t delta);
+
+// Records that a RestoreV2 op of `task` restored `num_bytes` from a checkpoint
+// in `duration_usecs` microseconds. The metrics of the tasks of a job compare
+// their restore throughputs.
+//
+// The `task` argument is the task name, ie. "/job:ps/replica:0/task:1".
+void RecordCheckpointRestore(const string& task, int64_t num_bytes,
+                             uint64 duration_usecs);
+
 // Increments (by 1) a simple integer counter that is exposed for testing.
 void IncrementTestCounter(const string& name, const string& label);
 
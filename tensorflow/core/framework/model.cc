@@ -23,6 +23,7 @@ limitations under the License.
 #include <optional>
 #include <queue>
 
+#include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 #include "tsl/platform/protobuf.h"
 
 namespace tensorflow {
@@ -280,6 +282,33 @@ inline bool IsAsyncInterleaveManyNode(const Node* node) {
   return absl::StartsWith(node->name(), kParallelInterleave);
 }
 
+// Returns whether the node runs a user-defined function on its elements.
+bool IsUdfNode(const Node& node) {
+  // The prefixes also cover the versions and fused variants of the
+  // transformations, such as `ParallelMapV2` and `MapAndBatch`.
+  for (absl::string_view prefix :
+       {"Map", "ParallelMap", kFlatMap, kInterleave, kParallelInterleave,
+        "LegacyParallelInterleave", "Filter", "ParallelFilter", "Scan"}) {
+    if (absl::StartsWith(node.name(), prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns whether the buffer of an asynchronous node ran empty after it filled
+// up since its watermarks were reset, which also makes the buffer a candidate
+// for upsizing.
+bool IsBufferStarved(const Node& node) {
+  if (!node.IsAsync() || node.num_elements() <= 0) {
+    return false;
+  }
+  absl::StatusOr<double> buffer_size = node.ParameterValue(kBufferSize);
+  return buffer_size.ok() &&
+         node.buffered_elements_low() <= kBufferLowWatermarkThreshold &&
+         node.buffered_elements_high() >= *buffer_size;
+}
+
 // Wrapper for the square function to reduce verbosity.
 inline double Square(double x) { return x * x; }
 
@@ -694,6 +723,15 @@ class AsyncInterleaveMany : public Node {
     if (parameter) {
       parallelism = std::min(parallelism, (*parameter)->value);
     }
+    // A tunable cycle length bounds the number of inputs that are processed
+    // in parallel.
+    auto* cycle_length = gtl::FindOrNull(parameters_, kCycleLength);
+    const bool tunable_cycle_length =
+        cycle_length && (*cycle_length)->state &&
+        (*cycle_length)->state->tunable;
+    if (tunable_cycle_length) {
+      parallelism = std::min(parallelism, (*cycle_length)->value);
+    }
     double output_time_for_inputs =
         OutputTimeForInputs(*output_times) -
         (*output_times)[inputs_.front()->long_name()];
@@ -728,10 +766,19 @@ class AsyncInterleaveMany : public Node {
       for (auto& pair : inputs_.front()->CollectTunableParameters()) {
         (*gradients)[std::make_pair(pair.first, pair.second->name)] = 0.0L;
       }
-      // Add derivative w.r.t. own parallelism parameter.
+      // Add derivative w.r.t. own parallelism and cycle length parameters.
+      // Only the one that bounds the effective parallelism has an effect.
+      const double parallelism_der =
+          buffer_size_der - producer_time_der * producer_time / parallelism;
+      const bool bound_by_cycle_length =
+          tunable_cycle_length && (*cycle_length)->value <= parallelism;
       if (parameter && (*parameter)->state->tunable) {
         (*gradients)[std::make_pair(long_name(), (*parameter)->name)] =
-            buffer_size_der - producer_time_der * producer_time / parallelism;
+            bound_by_cycle_length ? 0.0L : parallelism_der;
+      }
+      if (tunable_cycle_length) {
+        (*gradients)[std::make_pair(long_name(), (*cycle_length)->name)] =
+            bound_by_cycle_length ? parallelism_der : 0.0L;
       }
     } else {
       wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
@@ -2352,9 +2399,22 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
                        (port::AvailableRam() + TotalBufferedBytes(snapshot));
   }
 
+  RamBudgetArbiter& ram_budget_arbiter = RamBudgetArbiter::Global();
+  std::optional<int64_t> arbitrated_ram_budget =
+      ram_budget_arbiter.UpdateBudget(&ram_budget_manager, total_ram_budget,
+                                      ram_budget_manager.TotalAllocated());
+  if (arbitrated_ram_budget.has_value()) {
+    VLOG(2) << "Arbitrated ram budget: " << *arbitrated_ram_budget << " of "
+            << total_ram_budget;
+    total_ram_budget = *arbitrated_ram_budget;
+  }
   ram_budget_manager.UpdateBudget(total_ram_budget);
   int64_t model_ram_budget = ram_budget_manager.AvailableModelRam();
   int64_t original_model_bytes = TotalMaximumBufferedBytes(snapshot);
+  const double original_output_time =
+      arbitrated_ram_budget.has_value()
+          ? OutputTime(snapshot, model_input_time, /*gradients=*/nullptr)
+          : 0;
   if (!port::JobName().empty()) {
     RecordAutotuneRamUsage(model_ram_budget, original_model_bytes);
   }
@@ -2394,6 +2454,12 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
   if (experiments_.contains("autotune_buffer_optimization")) {
     OptimizeBuffers(snapshot, optimization_params.ram_budget());
   }
+  if (arbitrated_ram_budget.has_value()) {
+    ram_budget_arbiter.RecordOptimization(
+        &ram_budget_manager, original_model_bytes, original_output_time,
+        TotalMaximumBufferedBytes(snapshot),
+        OutputTime(snapshot, model_input_time, /*gradients=*/nullptr));
+  }
   {
     // Save the snapshot of the model proto including the parameters used by
     // autotune. This will be used as the model proto returned in `tfstreamz`.
@@ -2567,6 +2633,7 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm,
              model_input_time, ram_budget_manager, cancellation_manager);
     int64_t end_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
     VLOG(2) << "Optimized for " << end_ms - start_ms << " ms.";
+    RecordBottlenecks();
 
     // Exponentially increase the period of running the optimization until a
     // threshold is reached.
@@ -2786,6 +2853,46 @@ double Model::ComputeExperimentalTargetTimeNsec() {
          1.0e3;
 }
 
+int64_t Model::LatestRamBudget() const {
+  tf_shared_lock l(mu_);
+  return optimization_params_.ram_budget();
+}
+
+BottleneckAnalysis Model::AnalyzeBottlenecks() {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock l(mu_);
+    snapshot = snapshot_;
+  }
+  if (snapshot == nullptr) {
+    return BottleneckAnalysis();
+  }
+  return model::AnalyzeBottlenecks(snapshot, ComputeTargetTimeNsec());
+}
+
+void Model::RecordBottlenecks() {
+  profiler::TraceMe traceme("TfDataBottleneckAnalysis",
+                            profiler::TraceMeLevel::kInfo);
+  const BottleneckAnalysis analysis = AnalyzeBottlenecks();
+  if (analysis.stages.empty()) {
+    return;
+  }
+  const BottleneckAnalysis::Stage& critical_stage = analysis.stages.front();
+  const absl::string_view reason = BottleneckReasonName(analysis.reason);
+  // Removes the `<index>` of `[<index>]` to reduce the number of labels.
+  metrics::RecordTFDataBottleneck(std::string(reason),
+                                  RemoveArrayIndices(critical_stage.root));
+  traceme.AppendMetadata([&]() {
+    return profiler::TraceMeEncode(
+        {{"id", model_id_},
+         {"critical_stage", critical_stage.root},
+         {"max_throughput", critical_stage.max_throughput},
+         {"reason", reason},
+         {"analysis", analysis.DebugString()}});
+  });
+  VLOG(2) << "Bottlenecks: " << analysis.DebugString();
+}
+
 double Model::ComputeSnapshotProcessingTimeNsec() const {
   std::unique_ptr<ModelTiming> model_timing = nullptr;
   {
@@ -3491,6 +3598,201 @@ std::vector<std::shared_ptr<Node>> ModelTiming::GetStageNodes(
   return CollectNodes(stage_root, TraversalOrder::BFS, IsSyncNode);
 }
 
+absl::string_view BottleneckReasonName(BottleneckReason reason) {
+  switch (reason) {
+    case BottleneckReason::kNone:
+      return "none";
+    case BottleneckReason::kCpuBoundUdf:
+      return "cpu_bound_udf";
+    case BottleneckReason::kIoWait:
+      return "io_wait";
+    case BottleneckReason::kBufferStarvation:
+      return "buffer_starvation";
+    case BottleneckReason::kOther:
+      return "other";
+  }
+  return "unknown";
+}
+
+std::string BottleneckAnalysis::DebugString() const {
+  std::string result = absl::StrCat("reason: ", BottleneckReasonName(reason),
+                                    ", target_time_nsec: ", target_time_nsec);
+  if (!starved_node.empty()) {
+    absl::StrAppend(&result, ", starved_node: ", starved_node);
+  }
+  for (const Stage& stage : stages) {
+    absl::StrAppend(&result, "\n  stage: ", stage.root,
+                    ", parallelism: ", stage.parallelism,
+                    ", time_nsec: ", stage.time_nsec,
+                    ", max_throughput: ", stage.max_throughput,
+                    ", slowest_node: ", stage.slowest_node);
+  }
+  return result;
+}
+
+BottleneckAnalysis AnalyzeBottlenecks(std::shared_ptr<Node> root,
+                                      double target_time_nsec) {
+  BottleneckAnalysis analysis;
+  analysis.target_time_nsec = target_time_nsec;
+  if (root == nullptr) {
+    return analysis;
+  }
+  ModelTiming model_timing(root);
+  // The stages with their slowest nodes.
+  std::vector<std::pair<BottleneckAnalysis::Stage, std::shared_ptr<Node>>>
+      stages;
+  for (const std::shared_ptr<Node>& stage_root :
+       model_timing.GetStageRoots()) {
+    const ModelTiming::NodeTiming* root_timing =
+        model_timing.GetTiming(stage_root.get());
+    if (root_timing == nullptr) {
+      continue;
+    }
+    BottleneckAnalysis::Stage stage;
+    stage.root = stage_root->long_name();
+    stage.parallelism = stage_root->ParameterValue(kParallelism).value_or(1.0);
+    stage.time_nsec =
+        root_timing->total_time_nsec * root_timing->pipeline_ratio;
+    if (stage.time_nsec > 0) {
+      stage.max_throughput = EnvTime::kSecondsToNanos / stage.time_nsec;
+    }
+    std::shared_ptr<Node> slowest_node;
+    double slowest_time_nsec = 0.0;
+    for (const std::shared_ptr<Node>& node :
+         model_timing.GetStageNodes(stage_root)) {
+      const ModelTiming::NodeTiming* timing =
+          model_timing.GetTiming(node.get());
+      if (timing == nullptr) {
+        continue;
+      }
+      const double time_nsec = timing->self_time_nsec * timing->pipeline_ratio;
+      if (slowest_node == nullptr || time_nsec > slowest_time_nsec) {
+        slowest_node = node;
+        slowest_time_nsec = time_nsec;
+      }
+    }
+    if (slowest_node != nullptr) {
+      stage.slowest_node = slowest_node->long_name();
+    }
+    stages.emplace_back(std::move(stage), std::move(slowest_node));
+  }
+  if (stages.empty()) {
+    return analysis;
+  }
+  std::stable_sort(stages.begin(), stages.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.first.time_nsec > b.first.time_nsec;
+                   });
+
+  const auto& [critical_stage, slowest_node] = stages.front();
+  if (target_time_nsec > 0 && critical_stage.time_nsec <= target_time_nsec) {
+    // The pipeline keeps up on average, so that its consumer only waits when
+    // a buffer runs empty.
+    const Node::NodeVector nodes =
+        root->CollectNodes(TraversalOrder::BFS, IsAnyNode);
+    for (const std::shared_ptr<Node>& node : nodes) {
+      if (IsBufferStarved(*node)) {
+        analysis.reason = BottleneckReason::kBufferStarvation;
+        analysis.starved_node = node->long_name();
+        break;
+      }
+    }
+  } else if (slowest_node != nullptr && slowest_node->inputs().empty()) {
+    analysis.reason = BottleneckReason::kIoWait;
+  } else if (slowest_node != nullptr && IsUdfNode(*slowest_node)) {
+    analysis.reason = BottleneckReason::kCpuBoundUdf;
+  } else {
+    analysis.reason = BottleneckReason::kOther;
+  }
+  for (auto& [stage, unused] : stages) {
+    analysis.stages.push_back(std::move(stage));
+  }
+  return analysis;
+}
+
+/* static */
+RamBudgetArbiter& RamBudgetArbiter::Global() {
+  static RamBudgetArbiter* arbiter = new RamBudgetArbiter();
+  return *arbiter;
+}
+
+void RamBudgetArbiter::Register(const RamBudgetManager* manager) {
+  mutex_lock l(mu_);
+  pipelines_.try_emplace(manager);
+}
+
+void RamBudgetArbiter::Deregister(const RamBudgetManager* manager) {
+  mutex_lock l(mu_);
+  pipelines_.erase(manager);
+}
+
+std::optional<int64_t> RamBudgetArbiter::UpdateBudget(
+    const RamBudgetManager* manager, int64_t process_budget,
+    int64_t allocated_bytes) {
+  // Fraction of the best marginal gain given to every pipeline as weight, so
+  // that pipelines without any measured gain are not starved.
+  constexpr double kMinWeightFraction = 0.05;
+  mutex_lock l(mu_);
+  auto it = pipelines_.find(manager);
+  if (it == pipelines_.end()) {
+    return std::nullopt;
+  }
+  it->second.allocated_bytes = std::max<int64_t>(allocated_bytes, 0);
+  if (process_budget <= 0) {
+    return process_budget;
+  }
+  const int64_t even_share =
+      process_budget / static_cast<int64_t>(pipelines_.size());
+  int64_t spare_budget = process_budget;
+  double max_gain = 0;
+  for (const auto& [unused, pipeline] : pipelines_) {
+    spare_budget -= std::min(pipeline.allocated_bytes, even_share);
+    max_gain = std::max(max_gain, pipeline.marginal_gain);
+  }
+  const double min_weight = max_gain > 0 ? kMinWeightFraction * max_gain : 1;
+  double total_weight = 0;
+  double weight = 0;
+  for (const auto& [key, pipeline] : pipelines_) {
+    const double pipeline_weight =
+        (pipeline.marginal_gain < 0 ? max_gain : pipeline.marginal_gain) +
+        min_weight;
+    total_weight += pipeline_weight;
+    if (key == manager) {
+      weight = pipeline_weight;
+    }
+  }
+  return std::min(it->second.allocated_bytes, even_share) +
+         static_cast<int64_t>(spare_budget * (weight / total_weight));
+}
+
+void RamBudgetArbiter::RecordOptimization(const RamBudgetManager* manager,
+                                          int64_t bytes_before,
+                                          double output_time_before,
+                                          int64_t bytes_after,
+                                          double output_time_after) {
+  // Weight of the previous measurement in the moving average of the gain.
+  constexpr double kGainDecay = 0.5;
+  if (bytes_after <= bytes_before) {
+    return;
+  }
+  const double gain = std::max(output_time_before - output_time_after, 0.0) /
+                      (bytes_after - bytes_before);
+  mutex_lock l(mu_);
+  auto it = pipelines_.find(manager);
+  if (it == pipelines_.end()) {
+    return;
+  }
+  double& marginal_gain = it->second.marginal_gain;
+  marginal_gain = marginal_gain < 0
+                      ? gain
+                      : kGainDecay * marginal_gain + (1 - kGainDecay) * gain;
+}
+
+int64_t RamBudgetArbiter::num_registered() const {
+  tf_shared_lock l(mu_);
+  return pipelines_.size();
+}
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -31,6 +31,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -237,6 +238,13 @@ class RamBudgetManager {
     VLOG(2) << "Updated ram budget to " << budget;
   }
 
+  // The total number of bytes allocated by the model and legacy prefetch
+  // autotuners.
+  int64_t TotalAllocated() const {
+    tf_shared_lock l(mu_);
+    return legacy_prefetch_allocated_ + model_allocated_;
+  }
+
   std::string DebugString() {
     mutex_lock l(mu_);
     return absl::StrCat("RamBudgetManager: budget_: ", budget_,
@@ -253,6 +261,53 @@ class RamBudgetManager {
   int64_t model_allocated_ TF_GUARDED_BY(mu_) = 0;
 };
 
+// Splits the RAM budget of the process between the input pipelines that run
+// in it, instead of letting each of them budget for all of the process memory.
+//
+// Every pipeline keeps at least the smaller of its current allocation and an
+// even share of the budget. The rest of the budget goes to the pipelines in
+// proportion to the marginal gain of their buffer memory, i.e. the decrease of
+// their modeled output time per byte added by their latest optimizations.
+// Pipelines whose gain has not been measured yet are weighted as the best
+// measured one, so that they get a chance to grow.
+//
+// This class is thread-safe.
+class RamBudgetArbiter {
+ public:
+  // Returns the arbiter shared by all pipelines of the process.
+  static RamBudgetArbiter& Global();
+
+  void Register(const RamBudgetManager* manager);
+  void Deregister(const RamBudgetManager* manager);
+
+  // Updates the RAM budget of the process and the current allocation of
+  // `manager`, and returns the share of the budget of `manager`. Returns
+  // `std::nullopt` if `manager` is not registered.
+  std::optional<int64_t> UpdateBudget(const RamBudgetManager* manager,
+                                      int64_t process_budget,
+                                      int64_t allocated_bytes);
+
+  // Records that an optimization of the pipeline of `manager` changed its
+  // maximum buffered bytes from `bytes_before` to `bytes_after` and its
+  // modeled output time from `output_time_before` to `output_time_after`.
+  void RecordOptimization(const RamBudgetManager* manager, int64_t bytes_before,
+                          double output_time_before, int64_t bytes_after,
+                          double output_time_after);
+
+  int64_t num_registered() const;
+
+ private:
+  struct Pipeline {
+    int64_t allocated_bytes = 0;
+    // Output time decrease in nanoseconds per byte, or -1 if not measured.
+    double marginal_gain = -1;
+  };
+
+  mutable mutex mu_;
+  absl::flat_hash_map<const RamBudgetManager*, Pipeline> pipelines_
+      TF_GUARDED_BY(mu_);
+};
+
 // Abstract representation of a TensorFlow input pipeline node. It collects
 // information about inputs to this node, processing time spent executing the
 // node logic, number of elements produced by the node, various other
@@ -899,6 +954,60 @@ std::shared_ptr<Node> MakeAsyncUnknownRatioNode(
 // as pass-through between inputs and output.
 std::shared_ptr<Node> MakeUnknownNode(Node::Args args);
 
+// Reasons for which the critical stage of an input pipeline, i.e. its slowest
+// stage, limits the throughput of the pipeline.
+enum class BottleneckReason {
+  // The pipeline produces elements as fast as they are consumed.
+  kNone = 0,
+  // The slowest node of the critical stage runs a user-defined function, as
+  // `Map` and `Interleave` do.
+  kCpuBoundUdf,
+  // The slowest node of the critical stage is a source, such as a file reader,
+  // which waits on I/O.
+  kIoWait,
+  // The stages keep up with the consumer on average, but the buffer of an
+  // asynchronous node fills up and runs empty, so that the consumer waits on
+  // bursts of slow elements.
+  kBufferStarvation,
+  // The slowest node of the critical stage is none of the above.
+  kOther,
+};
+
+// Returns the name of `reason` in metrics and traces, e.g. "cpu_bound_udf".
+absl::string_view BottleneckReasonName(BottleneckReason reason);
+
+// Analysis of the bottlenecks of an input pipeline.
+struct BottleneckAnalysis {
+  // A stage of the pipeline, i.e. an asynchronous node, or the pipeline root,
+  // and the synchronous nodes it runs.
+  struct Stage {
+    // Long name of the root of the stage.
+    std::string root;
+    // Parallelism of the root of the stage, 1 without parallelism.
+    double parallelism = 1.0;
+    // Time in nanoseconds the stage takes to produce the elements that one
+    // element of the pipeline needs.
+    double time_nsec = 0.0;
+    // Maximum number of elements of the pipeline per second that the stage can
+    // produce, or 0 if the stage has not produced elements.
+    double max_throughput = 0.0;
+    // Long name of the node of the stage with the largest self time.
+    std::string slowest_node;
+  };
+  // The stages, slowest first: the first stage is the critical one.
+  std::vector<Stage> stages;
+
+  // Time in nanoseconds between the requests of the consumer of the pipeline,
+  // or 0 if unknown, in which case the reason is that of the critical stage.
+  double target_time_nsec = 0.0;
+  BottleneckReason reason = BottleneckReason::kNone;
+  // Long name of the node whose buffer runs empty, for `kBufferStarvation`.
+  std::string starved_node;
+
+  // Returns a human-readable representation of the analysis.
+  std::string DebugString() const;
+};
+
 // Abstract representation of a TensorFlow input pipeline that can be used
 // for collecting runtime information and optimizing performance. It collects
 // runtime information about execution of the input pipeline that is used to
@@ -1025,6 +1134,16 @@ class Model {
   // having executed an optimization round before.
   double ComputeSnapshotProcessingTimeNsec() const;
 
+  // Returns the RAM budget in bytes used by the latest optimization, or 0 if
+  // no optimization has run yet.
+  int64_t LatestRamBudget() const;
+
+  // Analyzes the bottlenecks of the pipeline according to the latest model
+  // snapshot obtained from optimization, against the target time computed
+  // from the recorded iterator gap times. Returns an analysis without stages if
+  // no optimization has run yet.
+  BottleneckAnalysis AnalyzeBottlenecks();
+
  private:
   // Determines whether optimization should stop given total processing time,
   // estimated output time, and estimated number of buffers bytes.
@@ -1065,6 +1184,10 @@ class Model {
   // Flushes metrics recorded by the model.
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
+  // Records the bottlenecks found by `AnalyzeBottlenecks` in the metrics and
+  // in a trace event for the profiler.
+  void RecordBottlenecks();
+
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then improves current parameters by
   // making a step in the direction opposite to the gradient of `OutputTime` and
@@ -1271,6 +1394,12 @@ class ModelTiming {
   absl::flat_hash_map<const Node*, NodeTiming> timing_nodes_;
 };
 
+// Analyzes the bottlenecks of the pipeline rooted at `root`, whose consumer
+// requests an element every `target_time_nsec` nanoseconds, or at an unknown
+// rate if it is 0.
+BottleneckAnalysis AnalyzeBottlenecks(std::shared_ptr<Node> root,
+                                      double target_time_nsec);
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -40,6 +41,7 @@ namespace {
 using ::tensorflow::monitoring::testing::CellReader;
 using ::testing::AllOf;
 using ::testing::HasSubstr;
+using ::testing::Optional;
 
 std::function<int64_t()> CpuBudgetFunc(int64_t budget) {
   return [budget]() { return budget; };
@@ -149,6 +151,62 @@ INSTANTIATE_TEST_SUITE_P(Test, AsyncInterleaveManyTest,
                                             ::testing::Values(0, 50, 100,
                                                               200)));
 
+TEST(AsyncInterleaveManyTest, TunableCycleLengthBoundsParallelism) {
+  std::shared_ptr<Node> async_interleave_many =
+      model::MakeAsyncInterleaveManyNode(
+          {0, "async_interleave_many", nullptr},
+          {model::MakeParameter(kParallelism,
+                                std::make_shared<SharedState>(
+                                    /*value=*/2, nullptr, nullptr),
+                                /*min=*/1, /*max=*/2),
+           model::MakeParameter(kCycleLength,
+                                std::make_shared<SharedState>(
+                                    /*value=*/model::kAutotune, nullptr,
+                                    nullptr),
+                                /*min=*/1, /*max=*/2)});
+  std::shared_ptr<Node> meta_source =
+      model::MakeSourceNode({1, "meta_source", async_interleave_many});
+  async_interleave_many->add_input(meta_source);
+  std::shared_ptr<Node> source1 =
+      model::MakeSourceNode({2, "source1", async_interleave_many});
+  async_interleave_many->add_input(source1);
+  std::shared_ptr<Node> source2 =
+      model::MakeSourceNode({3, "source2", async_interleave_many});
+  async_interleave_many->add_input(source2);
+  auto cleanup = gtl::MakeCleanup([&]() {
+    async_interleave_many->remove_input(meta_source);
+    async_interleave_many->remove_input(source1);
+    async_interleave_many->remove_input(source2);
+  });
+  source1->add_processing_time(200);
+  source1->record_element();
+  source2->add_processing_time(300);
+  source2->record_element();
+
+  Model::ModelParameters parameters =
+      async_interleave_many->CollectTunableParameters();
+  ASSERT_EQ(parameters.size(), 1);
+  std::shared_ptr<Parameter> cycle_length = parameters[0].second;
+  EXPECT_EQ(cycle_length->name, kCycleLength);
+  Model::NodeValues input_times;
+  input_times[kModelInputTimeKey] = 0;
+  cycle_length->value = 1;
+  const double output_time_1 =
+      async_interleave_many->OutputTime(&input_times, nullptr);
+  cycle_length->value = 2;
+  const double output_time_2 =
+      async_interleave_many->OutputTime(&input_times, nullptr);
+  // The sources take 250ns on average, and are processed one or two at a
+  // time.
+  EXPECT_DOUBLE_EQ(output_time_1 - output_time_2, 250 - 125);
+
+  Model::ParameterGradients gradients;
+  async_interleave_many->OutputTime(&input_times, &gradients);
+  EXPECT_LT(gradients[std::make_pair(async_interleave_many->long_name(),
+                                     std::string(kCycleLength))],
+            0);
+}
+
 class AsyncKnownRatioTest
     : public ::testing::TestWithParam<std::tuple<int64_t, double, int64_t>> {};
 
@@ -3505,6 +3563,175 @@ TEST_F(ModelTimingTest, SelfTime) {
   EXPECT_DOUBLE_EQ(910, node_2->ComputeSelfTime());
 }
 
+TEST_F(ModelTimingTest, AnalyzeBottlenecksCpuBoundUdf) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 2
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 100000
+        node_class: KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 50000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 4
+        parameters: {
+          name: "parallelism"
+          value: 2
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 4
+      value: {
+        id: 4
+        name: "Map"
+        autotune: true
+        num_elements: 100
+        processing_time: 100000
+        node_class: KNOWN_RATIO
+        ratio: 1
+      }
+    }
+    output: 1
+  )pb");
+  // No optimization has run yet.
+  EXPECT_TRUE(model_->AnalyzeBottlenecks().stages.empty());
+
+  const BottleneckAnalysis analysis =
+      AnalyzeBottlenecks(model_->output(), /*target_time_nsec=*/0);
+  EXPECT_EQ(analysis.reason, BottleneckReason::kCpuBoundUdf);
+  ASSERT_EQ(analysis.stages.size(), 2);
+  EXPECT_EQ(analysis.stages[0].root, "ParallelMapV2(id:3)");
+  EXPECT_DOUBLE_EQ(analysis.stages[0].parallelism, 2);
+  EXPECT_DOUBLE_EQ(analysis.stages[0].time_nsec, 1250);
+  EXPECT_DOUBLE_EQ(analysis.stages[0].max_throughput, 800000);
+  EXPECT_EQ(analysis.stages[0].slowest_node, "Map(id:4)");
+  EXPECT_EQ(analysis.stages[1].root, "ParallelMapV2(id:1)");
+  EXPECT_DOUBLE_EQ(analysis.stages[1].time_nsec, 1100);
+  EXPECT_EQ(analysis.stages[1].slowest_node, "SSTable(id:2)");
+}
+
+class BottleneckAnalysisTest : public ModelTimingTest {
+ public:
+  // Builds a pipeline that maps the records of a file.
+  void BuildReaderModel() {
+    BuildModelFromProto(R"pb(
+      nodes: {
+        key: 1
+        value: {
+          id: 1
+          name: "ParallelMapV2"
+          autotune: true
+          num_elements: 100
+          processing_time: 20000
+          node_class: ASYNC_KNOWN_RATIO
+          ratio: 1
+          inputs: 2
+          parameters: {
+            name: "parallelism"
+            value: 2
+            min: 1
+            max: 16
+            tunable: true
+          }
+          parameters: {
+            name: "buffer_size"
+            value: 4
+            min: 1
+            max: 16
+            tunable: true
+          }
+        }
+      }
+      nodes: {
+        key: 2
+        value: {
+          id: 2
+          name: "TFRecord"
+          autotune: true
+          num_elements: 100
+          processing_time: 500000
+          node_class: KNOWN_RATIO
+          ratio: 1
+        }
+      }
+      output: 1
+    )pb");
+  }
+};
+
+TEST_F(BottleneckAnalysisTest, IoWait) {
+  BuildReaderModel();
+  const BottleneckAnalysis analysis =
+      AnalyzeBottlenecks(model_->output(), /*target_time_nsec=*/0);
+  EXPECT_EQ(analysis.reason, BottleneckReason::kIoWait);
+  ASSERT_EQ(analysis.stages.size(), 1);
+  EXPECT_DOUBLE_EQ(analysis.stages[0].time_nsec, 5100);
+  EXPECT_EQ(analysis.stages[0].slowest_node, "TFRecord(id:2)");
+
+  // The reader keeps up with a slower consumer.
+  EXPECT_EQ(AnalyzeBottlenecks(model_->output(), /*target_time_nsec=*/6000)
+                .reason,
+            BottleneckReason::kNone);
+}
+
+TEST_F(BottleneckAnalysisTest, BufferStarvation) {
+  BuildReaderModel();
+  // The buffer fills up and runs empty.
+  Node* map = MutableGetNode(/*node_id=*/1);
+  map->record_buffer_event(/*bytes_delta=*/400, /*elements_delta=*/4);
+  map->record_buffer_event(/*bytes_delta=*/-400, /*elements_delta=*/-4);
+
+  const BottleneckAnalysis analysis =
+      AnalyzeBottlenecks(model_->output(), /*target_time_nsec=*/6000);
+  EXPECT_EQ(analysis.reason, BottleneckReason::kBufferStarvation);
+  EXPECT_EQ(analysis.starved_node, "ParallelMapV2(id:1)");
+  EXPECT_EQ(BottleneckReasonName(analysis.reason), "buffer_starvation");
+
+  // Stages slower than the consumer are the bottleneck, whatever the buffers.
+  EXPECT_EQ(AnalyzeBottlenecks(model_->output(), /*target_time_nsec=*/1000)
+                .reason,
+            BottleneckReason::kIoWait);
+}
+
 TEST(RamBudgetManagerTest, Ctor) {
   RamBudgetManager rbm(10);
   EXPECT_EQ(rbm.AvailableModelRam(), 10);
@@ -3548,6 +3775,65 @@ TEST(RamBudgetManagerTest, RequestAllocationsWithBudgetAdjustment) {
   EXPECT_TRUE(rbm.RequestLegacyPrefetchBytes(4));
 }
 
+TEST(RamBudgetArbiterTest, Registration) {
+  RamBudgetArbiter arbiter;
+  RamBudgetManager rbm(0);
+  EXPECT_EQ(arbiter.UpdateBudget(&rbm, 100, 0), std::nullopt);
+  arbiter.Register(&rbm);
+  EXPECT_EQ(arbiter.num_registered(), 1);
+  // A single pipeline gets the whole budget.
+  EXPECT_THAT(arbiter.UpdateBudget(&rbm, 100, 0), Optional(100));
+  arbiter.Deregister(&rbm);
+  EXPECT_EQ(arbiter.num_registered(), 0);
+  EXPECT_EQ(arbiter.UpdateBudget(&rbm, 100, 0), std::nullopt);
+}
+
+TEST(RamBudgetArbiterTest, SplitsEvenlyWithoutMeasurements) {
+  RamBudgetArbiter arbiter;
+  RamBudgetManager rbm_1(0), rbm_2(0);
+  arbiter.Register(&rbm_1);
+  arbiter.Register(&rbm_2);
+  EXPECT_THAT(arbiter.UpdateBudget(&rbm_1, 1000, 0), Optional(500));
+  EXPECT_THAT(arbiter.UpdateBudget(&rbm_2, 1000, 0), Optional(500));
+}
+
+TEST(RamBudgetArbiterTest, SplitsByMarginalGain) {
+  RamBudgetArbiter arbiter;
+  RamBudgetManager rbm_1(0), rbm_2(0);
+  arbiter.Register(&rbm_1);
+  arbiter.Register(&rbm_2);
+  // 10 bytes decreased the output time by 10ns and 1ns respectively.
+  arbiter.RecordOptimization(&rbm_1, 0, 100, 10, 90);
+  arbiter.RecordOptimization(&rbm_2, 0, 100, 10, 99);
+  // Optimizations that did not add memory are not measured.
+  arbiter.RecordOptimization(&rbm_2, 10, 99, 10, 50);
+  // Weights are 1 + 0.05 and 0.1 + 0.05.
+  std::optional<int64_t> budget_1 = arbiter.UpdateBudget(&rbm_1, 1200, 0);
+  std::optional<int64_t> budget_2 = arbiter.UpdateBudget(&rbm_2, 1200, 0);
+  ASSERT_TRUE(budget_1.has_value() && budget_2.has_value());
+  EXPECT_NEAR(*budget_1, 1050, 1);
+  EXPECT_NEAR(*budget_2, 150, 1);
+}
+
+TEST(RamBudgetArbiterTest, KeepsAllocationsUpToEvenShare) {
+  RamBudgetArbiter arbiter;
+  RamBudgetManager rbm_1(0), rbm_2(0);
+  arbiter.Register(&rbm_1);
+  arbiter.Register(&rbm_2);
+  // The first pipeline does not benefit from its memory.
+  arbiter.RecordOptimization(&rbm_1, 0, 100, 10, 100);
+  arbiter.RecordOptimization(&rbm_2, 0, 100, 10, 90);
+  // The first pipeline keeps its even share of 500 bytes, and the second one
+  // its 100 allocated bytes. Weights of the remaining 400 bytes are 0.05 and
+  // 1 + 0.05.
+  std::optional<int64_t> budget_1 = arbiter.UpdateBudget(&rbm_1, 1000, 800);
+  std::optional<int64_t> budget_2 = arbiter.UpdateBudget(&rbm_2, 1000, 100);
+  ASSERT_TRUE(budget_1.has_value() && budget_2.has_value());
+  EXPECT_NEAR(*budget_1, 518, 1);
+  EXPECT_NEAR(*budget_2, 481, 1);
+  EXPECT_LE(*budget_1 + *budget_2, 1000);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -71,11 +71,17 @@ class RendezvousInterface {
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
 
+    // Returns the hash of FullKey(), computed by ParseKey(), so that the
+    // Send and Recv kernels that parse their keys once don't hash them on
+    // every step.
+    uint64 hash() const { return hash_; }
+
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     std::string buf_;
+    uint64 hash_ = 0;
   };
 
   // The caller is a tensor producer and it sends a message (a tensor
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/strings/scanner.h"
@@ -332,6 +333,37 @@ Status ResourceMgr::Cleanup(const string& container) {
   return OkStatus();
 }
 
+Status ResourceMgr::FreezeContainer(const string& container) {
+  const uint64 var_hash_code = TypeIndex::Make<Var>().hash_code();
+  std::vector<std::pair<string, core::RefCountPtr<ResourceBase>>> vars;
+  {
+    tf_shared_lock l(mu_);
+    auto iter = containers_.find(container);
+    if (iter == containers_.end()) {
+      return errors::NotFound("Container ", container,
+                              " does not exist. (Could not be found in "
+                              "ResourceMgr)");
+    }
+    for (const auto& p : *iter->second) {
+      if (p.first.first != var_hash_code) continue;
+      core::RefCountPtr<ResourceBase> resource = p.second.GetResource();
+      if (resource) vars.emplace_back(p.first.second, std::move(resource));
+    }
+  }
+  for (const auto& p : vars) {
+    Var* var = static_cast<Var*>(p.second.get());
+    // Waits for the writes in flight.
+    mutex_lock l(*var->mu());
+    if (!var->is_initialized) {
+      return errors::FailedPrecondition("Can't freeze variable ", p.first,
+                                        " of container ", container,
+                                        ", it's uninitialized");
+    }
+    var->frozen.store(true);
+  }
+  return OkStatus();
+}
+
 static bool IsValidContainerName(StringPiece s) {
   using ::tensorflow::strings::Scanner;
   return Scanner(s)
@@ -234,6 +234,11 @@ class ResourceMgr {
   // Deletes all resources in all containers.
   void Clear();
 
+  // Freezes the variables (see `Var`) of "container", which must all be
+  // initialized. Reads of the variables then take no lock and never copy them,
+  // and writes fail with FailedPrecondition.
+  Status FreezeContainer(const std::string& container) TF_MUST_USE_RESULT;
+
   // Returns a text description for all resources.
   std::string DebugString() const;
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/resource_handle.pb.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -276,6 +277,25 @@ string Policy(const string& attr_container, const string& attr_shared_name,
   return ret;
 }
 
+TEST(ResourceMgrTest, FreezeContainer) {
+  ResourceMgr rm;
+  Var* var = new Var(DT_FLOAT);
+  *var->tensor() = Tensor(DT_FLOAT, TensorShape({2}));
+  var->is_initialized = true;
+  TF_CHECK_OK(rm.Create("foo", "var", var));
+  TF_CHECK_OK(rm.Create("foo", "bar", new Resource("cat")));
+  Var* other_var = new Var(DT_FLOAT);
+  TF_CHECK_OK(rm.Create("bar", "var", other_var));
+
+  HasError(rm.FreezeContainer("baz"), error::NOT_FOUND, "Container baz");
+  TF_CHECK_OK(rm.FreezeContainer("foo"));
+  EXPECT_TRUE(var->frozen.load());
+  EXPECT_FALSE(other_var->frozen.load());
+  // Uninitialized variables can't be frozen.
+  HasError(rm.FreezeContainer("bar"), error::FAILED_PRECONDITION,
+           "Can't freeze variable var of container bar");
+}
+
 TEST(ContainerInfo, Basic) {
   // Correct cases.
   EXPECT_TRUE(RE2::FullMatch(Policy("", "", false),
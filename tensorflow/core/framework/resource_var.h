@@ -65,6 +65,11 @@ namespace tensorflow {
 // mutex as desired. To access the variable in dense mode grab the mutex either
 // directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
 // modified and then call `PrepareToUpdateVariable` on them in any order.
+//
+// Variables of inference graphs, which are never written after they're loaded,
+// can be frozen with `ResourceMgr::FreezeContainer()`. Reads of a frozen
+// variable, dense or sparse, alias its tensor without grabbing its mutex, and
+// writes fail.
 class Var : public ResourceBase {
  public:
   explicit Var(DataType dtype) : tensor_(dtype) {}
@@ -110,6 +115,10 @@ class Var : public ResourceBase {
   // so desired.
   std::atomic<bool> copy_on_read_mode{false};
 
+  // Set, under an exclusive lock of mu_, once the variable is frozen. The
+  // tensor is then never modified again, so reading it needs no lock.
+  std::atomic<bool> frozen{false};
+
  private:
   mutex mu_;
   Tensor tensor_;
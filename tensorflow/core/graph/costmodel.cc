@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -368,6 +369,44 @@ Microseconds CostModel::MaxExecutionTime(const Node* node) const {
   return max_exec_time_[id];
 }
 
+void CostModel::RecordExecutionTimeSample(const Node* node,
+                                          Microseconds time) {
+  const int id = Id(node);
+  if (id < 0) return;
+  if (exec_time_hist_.size() <= static_cast<size_t>(id)) {
+    exec_time_hist_.resize(id + 1);
+  }
+  const int64_t micros = time.value();
+  const int bucket =
+      micros < 1
+          ? 0
+          : std::min(Log2Floor64(micros) + 1, kNumExecutionTimeBuckets - 1);
+  ++exec_time_hist_[id][bucket];
+}
+
+int64_t CostModel::NumExecutionTimeSamples(const Node* node) const {
+  const int id = Id(node);
+  if (id < 0 || static_cast<size_t>(id) >= exec_time_hist_.size()) return 0;
+  int64_t num_samples = 0;
+  for (int64_t count : exec_time_hist_[id]) num_samples += count;
+  return num_samples;
+}
+
+Microseconds CostModel::ExecutionTimeQuantile(const Node* node,
+                                              double q) const {
+  const int64_t num_samples = NumExecutionTimeSamples(node);
+  if (num_samples == 0) return Microseconds(0);
+  const auto& hist = exec_time_hist_[Id(node)];
+  const double rank = std::max(1.0, q * num_samples);
+  int64_t count = 0;
+  int bucket = 0;
+  for (; bucket < kNumExecutionTimeBuckets - 1; ++bucket) {
+    count += hist[bucket];
+    if (count >= rank) break;
+  }
+  return Microseconds(int64_t{1} << bucket);
+}
+
 void CostModel::RecordAllocationId(const Node* node, int output_slot,
                                    int64_t alloc_id) {
   const int id = Id(node);
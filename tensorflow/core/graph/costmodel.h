@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPH_COSTMODEL_H_
 #define TENSORFLOW_CORE_GRAPH_COSTMODEL_H_
 
+#include <array>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -41,6 +42,7 @@ class StepStats;
 //    * The total number of times a node has executed.
 //    * The accumulated execution time (in microseconds) of a node.
 //    * The accumulated size (in bytes) of each node's output.
+//    * A histogram of sampled execution times of a node.
 //
 // This class is NOT thread-safe.
 class CostModel {
@@ -154,6 +156,21 @@ class CostModel {
   // Returns the maximum execution time (in microseconds) of "node".
   Microseconds MaxExecutionTime(const Node* node) const;
 
+  // The execution time histograms have one bucket for times under 1us and one
+  // for each power of two microseconds from there, the last of which also
+  // counts all longer times.
+  static constexpr int kNumExecutionTimeBuckets = 32;
+
+  // Records a sampled execution of "node" that took "time".
+  void RecordExecutionTimeSample(const Node* node, Microseconds time);
+
+  // Returns the number of sampled executions of "node".
+  int64_t NumExecutionTimeSamples(const Node* node) const;
+
+  // Returns the upper bound of the histogram bucket of the q-th quantile of
+  // the sampled execution times of "node", or 0 if it has no samples.
+  Microseconds ExecutionTimeQuantile(const Node* node, double q) const;
+
   // Record the unique id of the tensor generated by "output_slot" of "node".
   // Any other tensor sharing the same id will be an alias, i.e. it will share
   // the same underlying memory storage area.
@@ -212,6 +229,10 @@ class CostModel {
   // Maximum execution time
   std::vector<Microseconds> max_exec_time_;
 
+  // Histograms of sampled execution times, only sized for the nodes that
+  // have samples.
+  std::vector<std::array<int64_t, kNumExecutionTimeBuckets>> exec_time_hist_;
+
   // Maximum memory usage
   struct MemUsage {
     MemUsage() : temp_memory_size(0), persistent_memory_size(0) {}
@@ -378,6 +378,40 @@ TEST(CostModelTest, RecordMaxExecutionTime) {
   EXPECT_EQ(cm.MaxExecutionTime(E), Microseconds(0));
 }
 
+TEST(CostModelTest, RecordExecutionTimeSample) {
+  auto graph = CreateBasicTestGraph();
+  CostModel cm(/*is_global=*/false);
+  InitModelFromGraph(*graph, cm);
+  Node* C = FindNode(*graph, "C");
+  Node* D = FindNode(*graph, "D");
+
+  EXPECT_EQ(cm.NumExecutionTimeSamples(C), 0);
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 0.5), Microseconds(0));
+
+  // 90 samples in [8us, 16us) and 10 in [512us, 1024us).
+  for (int i = 0; i < 90; ++i) {
+    cm.RecordExecutionTimeSample(C, Microseconds(8 + i % 8));
+  }
+  for (int i = 0; i < 10; ++i) {
+    cm.RecordExecutionTimeSample(C, Microseconds(1000));
+  }
+  EXPECT_EQ(cm.NumExecutionTimeSamples(C), 100);
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 0), Microseconds(16));
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 0.5), Microseconds(16));
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 0.9), Microseconds(16));
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 0.95), Microseconds(1024));
+  EXPECT_EQ(cm.ExecutionTimeQuantile(C, 1), Microseconds(1024));
+
+  // Times under 1us and very long times go to the first and last buckets.
+  cm.RecordExecutionTimeSample(D, Microseconds(0));
+  cm.RecordExecutionTimeSample(D, Microseconds(int64_t{1} << 40));
+  EXPECT_EQ(cm.NumExecutionTimeSamples(D), 2);
+  EXPECT_EQ(cm.ExecutionTimeQuantile(D, 0.5), Microseconds(1));
+  EXPECT_EQ(cm.ExecutionTimeQuantile(D, 1),
+            Microseconds(int64_t{1} << (CostModel::kNumExecutionTimeBuckets -
+                                        1)));
+}
+
 TEST(CostModelTest, RecordMemoryStats) {
   auto graph = CreateBasicTestGraph();
   CostModel cm(/*is_global=*/false);
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -542,6 +543,23 @@ absl::StatusOr<Node*> Graph::AddNode(NodeDef node_def) {
   return out;
 }
 
+namespace {
+
+template <typename T>
+void ReserveAtLeast(std::vector<T>* v, size_t num_more) {
+  const size_t size = v->size() + num_more;
+  if (size > v->capacity()) {
+    v->reserve(std::max(size, 2 * v->capacity()));
+  }
+}
+
+}  // namespace
+
+void Graph::Reserve(int num_nodes, int num_edges) {
+  ReserveAtLeast(&nodes_, num_nodes);
+  ReserveAtLeast(&edges_, num_edges);
+}
+
 Node* Graph::AddNode(NodeDef node_def, Status* status) {
   const OpRegistrationData* op_reg_data;
   status->Update(ops_.LookUp(node_def.op(), &op_reg_data));
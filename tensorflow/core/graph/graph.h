@@ -557,6 +557,13 @@ class Graph {
   const VersionDef& versions() const;
   void set_versions(const VersionDef& versions);
 
+  // Reserves room for `num_nodes` more nodes and `num_edges` more edges, so
+  // that building a large graph doesn't repeatedly grow the tables of nodes
+  // and edges. The tables still grow geometrically, so that calling this
+  // before each of many small additions, as importing GraphDefs into a graph
+  // one at a time does, doesn't copy them each time.
+  void Reserve(int num_nodes, int num_edges);
+
   // Adds a new node to this graph, and returns it. Infers the Op and
   // input/output types for the node. *this owns the returned instance.
   // Returns nullptr and sets *status on error.
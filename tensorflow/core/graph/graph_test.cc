@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 #include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -942,6 +943,31 @@ BENCHMARK(BM_GraphCreation)->ArgPair(1 << 9, 16);
 BENCHMARK(BM_GraphCreation)->ArgPair(1 << 12, 16);
 BENCHMARK(BM_GraphCreation)->ArgPair(1 << 15, 16);
 
+void BM_GraphCreationFromMovedGraphDef(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const int num_edges_per_node = state.range(1);
+  const GraphDef graph_def =
+      test::CreateGraphDef(num_nodes, num_edges_per_node);
+  const auto registry = OpRegistry::Global();
+  GraphConstructorOptions opts;
+  int64_t sum = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    GraphDef graph_def_copy = graph_def;
+    state.ResumeTiming();
+    Graph graph(registry);
+    TF_CHECK_OK(
+        ConvertGraphDefToGraph(opts, std::move(graph_def_copy), &graph));
+    sum += graph.num_node_ids();
+  }
+  VLOG(1) << sum;
+}
+BENCHMARK(BM_GraphCreationFromMovedGraphDef)->ArgPair(1 << 9, 2);
+BENCHMARK(BM_GraphCreationFromMovedGraphDef)->ArgPair(1 << 12, 2);
+BENCHMARK(BM_GraphCreationFromMovedGraphDef)->ArgPair(1 << 15, 2);
+BENCHMARK(BM_GraphCreationFromMovedGraphDef)->ArgPair(1 << 15, 8);
+BENCHMARK(BM_GraphCreationFromMovedGraphDef)->ArgPair(1 << 19, 2);
+
 void BM_ToGraphDef(::testing::benchmark::State& state) {
   const int num_nodes = state.range(0);
   const int num_edges_per_node = state.range(1);
@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Runs a catalog of ops at the shapes models run them at on the CPU of this
+// machine, with each of the numbers of threads of the catalog, and writes the
+// throughput they attained against the roofline of the machine as a
+// KernelBenchmarkReport. The report is written as JSON if the output file ends
+// in .json and as a text proto otherwise, so that it can be compared with the
+// report of a baseline to catch regressions of kernels.
+// ./benchmark_kernel_rooflines \
+//   --catalog_file_path=kernel_benchmark_catalog.pbtxt \
+//   --output_file_path=/tmp/kernel_rooflines.json
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/grappler/costs/kernel_roofline_benchmark.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Status WriteReport(const std::string& output_file_path,
+                   const KernelBenchmarkReport& report) {
+  if (!absl::EndsWith(output_file_path, ".json")) {
+    return WriteTextProto(Env::Default(), output_file_path, report);
+  }
+  std::string json;
+  protobuf::util::JsonPrintOptions json_options;
+  json_options.add_whitespace = true;
+  json_options.always_print_primitive_fields = true;
+  const auto status =
+      protobuf::util::MessageToJsonString(report, &json, json_options);
+  if (!status.ok()) {
+    return errors::Internal("Failed to convert the report to JSON: ",
+                            status.ToString());
+  }
+  return WriteStringToFile(Env::Default(), output_file_path, json);
+}
+
+Status RealMain(int argc, char** argv) {
+  std::string catalog_file_path;
+  std::string output_file_path;
+  OpCostCalibrationOptions roofline_options;
+  const std::vector<Flag> flag_list = {
+      Flag("catalog_file_path", &catalog_file_path,
+           "Location of the KernelBenchmarkCatalog text proto to run."),
+      Flag("output_file_path", &output_file_path,
+           "Location to write the report, as JSON if it ends in .json."),
+      Flag("roofline_num_runs", &roofline_options.num_runs,
+           "Number of timed runs of the roofline microbenchmarks."),
+      Flag("roofline_matmul_size", &roofline_options.matmul_size,
+           "Size of the square matrices of the roofline matmul."),
+      Flag("roofline_num_elements", &roofline_options.num_elements,
+           "Number of elements of the memory-bound roofline microbenchmarks."),
+  };
+  if (!Flags::Parse(&argc, argv, flag_list)) {
+    return errors::FailedPrecondition("Invalid flags passed");
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (catalog_file_path.empty() || output_file_path.empty()) {
+    return errors::FailedPrecondition(
+        "catalog_file_path and output_file_path are required flags.");
+  }
+  KernelBenchmarkCatalog catalog;
+  TF_RETURN_IF_ERROR(
+      ReadTextProto(Env::Default(), catalog_file_path, &catalog));
+  TF_ASSIGN_OR_RETURN(const KernelBenchmarkReport report,
+                      RunKernelBenchmarks(catalog, roofline_options));
+  return WriteReport(output_file_path, report);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  TF_CHECK_OK(tensorflow::grappler::RealMain(argc, argv));
+  return 0;
+}
@@ -0,0 +1,78 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the throughput of common op classes on the CPU of this machine and
+// writes it as an OpCostCalibration text proto, which OpLevelCostEstimator
+// loads when TF_GRAPPLER_OP_COST_CALIBRATION names it.
+// ./calibrate_op_costs --output_file_path=/tmp/op_cost_calibration.pbtxt
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Status RealMain(int argc, char** argv) {
+  std::string output_file_path;
+  OpCostCalibrationOptions options;
+  const std::vector<Flag> flag_list = {
+      Flag("output_file_path", &output_file_path,
+           "Location to write the calibration."),
+      Flag("num_runs", &options.num_runs,
+           "Number of timed runs of each microbenchmark."),
+      Flag("num_threads", &options.num_threads,
+           "Number of threads to run the microbenchmarks on, 0 for a few."),
+      Flag("matmul_size", &options.matmul_size,
+           "Size of the square matrices of the matmul."),
+      Flag("conv_batch_size", &options.conv_batch_size,
+           "Number of images of the conv."),
+      Flag("conv_image_size", &options.conv_image_size,
+           "Height and width of the images of the conv."),
+      Flag("conv_channels", &options.conv_channels,
+           "Number of input and output channels of the conv."),
+      Flag("num_elements", &options.num_elements,
+           "Number of elements of the memory-bound microbenchmarks."),
+  };
+  if (!Flags::Parse(&argc, argv, flag_list)) {
+    return errors::FailedPrecondition("Invalid flags passed");
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (output_file_path.empty()) {
+    return errors::FailedPrecondition("output_file_path is a required flag.");
+  }
+  TF_ASSIGN_OR_RETURN(OpCostCalibration calibration,
+                      CalibrateOpCosts(options));
+  return WriteTextProto(Env::Default(), output_file_path, calibration);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  TF_CHECK_OK(tensorflow::grappler::RealMain(argc, argv));
+  return 0;
+}
@@ -0,0 +1,237 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/kernel_roofline_benchmark.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr int kDefaultNumRuns = 10;
+
+template <typename T>
+Tensor RandomTensor(DataType dtype, const TensorShape& shape) {
+  Tensor tensor(dtype, shape);
+  if constexpr (std::is_same_v<T, bfloat16>) {
+    // Eigen has no random bfloat16s.
+    Tensor floats(DT_FLOAT, shape);
+    floats.flat<float>().setRandom();
+    tensor.flat<T>() = floats.flat<float>().template cast<T>();
+  } else {
+    tensor.flat<T>().setRandom();
+  }
+  return tensor;
+}
+
+template <typename T>
+Tensor IndicesTensor(DataType dtype, const TensorShape& shape, int64_t bound,
+                     bool sorted) {
+  Tensor tensor(dtype, shape);
+  auto flat = tensor.flat<T>();
+  const int64_t size = flat.size();
+  for (int64_t i = 0; i < size; ++i) {
+    flat(i) = static_cast<T>(sorted ? i * bound / size : (i * 7919) % bound);
+  }
+  return tensor;
+}
+
+absl::StatusOr<Tensor> MakeInput(const KernelBenchmarkCatalog::Input& input) {
+  const OpInfo::TensorProperties& properties = input.tensor();
+  if (properties.has_value()) {
+    Tensor tensor;
+    if (!tensor.FromProto(properties.value())) {
+      return errors::InvalidArgument("Invalid input value ",
+                                     properties.value().ShortDebugString());
+    }
+    return tensor;
+  }
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(
+      TensorShape::BuildTensorShape(properties.shape(), &shape));
+  const DataType dtype = properties.dtype();
+  if (input.fill() != KernelBenchmarkCatalog::Input::RANDOM) {
+    if (input.index_bound() <= 0) {
+      return errors::InvalidArgument(
+          "Indices need a positive index_bound, got ", input.index_bound());
+    }
+    const bool sorted =
+        input.fill() == KernelBenchmarkCatalog::Input::SORTED_INDICES;
+    switch (dtype) {
+      case DT_INT32:
+        return IndicesTensor<int32_t>(dtype, shape, input.index_bound(),
+                                      sorted);
+      case DT_INT64:
+        return IndicesTensor<int64_t>(dtype, shape, input.index_bound(),
+                                      sorted);
+      default:
+        return errors::InvalidArgument("Indices must be integers, got ",
+                                       DataTypeString(dtype));
+    }
+  }
+  switch (dtype) {
+    case DT_FLOAT:
+      return RandomTensor<float>(dtype, shape);
+    case DT_DOUBLE:
+      return RandomTensor<double>(dtype, shape);
+    case DT_HALF:
+      return RandomTensor<Eigen::half>(dtype, shape);
+    case DT_BFLOAT16:
+      return RandomTensor<bfloat16>(dtype, shape);
+    case DT_INT32:
+      return RandomTensor<int32_t>(dtype, shape);
+    case DT_INT64:
+      return RandomTensor<int64_t>(dtype, shape);
+    default:
+      return errors::Unimplemented("Random inputs of type ",
+                                   DataTypeString(dtype), " are unsupported");
+  }
+}
+
+absl::StatusOr<NodeDef> MakeNode(
+    const KernelBenchmarkCatalog::Benchmark& benchmark) {
+  NodeDef node;
+  node.set_name(benchmark.name());
+  node.set_op(benchmark.op());
+  node.mutable_attr()->insert(benchmark.attr().begin(), benchmark.attr().end());
+  for (int i = 0; i < benchmark.inputs_size(); ++i) {
+    node.add_input(absl::StrCat("input", i));
+  }
+  const OpDef* op_def = nullptr;
+  TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+  AddDefaultsToNodeDef(*op_def, &node);
+  return node;
+}
+
+absl::StatusOr<KernelBenchmarkReport::Roofline> MeasureRoofline(
+    int num_threads, OpCostCalibrationOptions options) {
+  options.num_threads = num_threads;
+  TF_ASSIGN_OR_RETURN(const OpCostCalibration calibration,
+                      CalibrateOpCosts(options));
+  KernelBenchmarkReport::Roofline roofline;
+  roofline.set_num_threads(num_threads);
+  for (const auto& [op_class, throughput] : calibration.op_classes()) {
+    roofline.set_peak_gigaops(
+        std::max(roofline.peak_gigaops(), throughput.gigaops()));
+    roofline.set_peak_gb_per_sec(
+        std::max(roofline.peak_gb_per_sec(), throughput.gb_per_sec()));
+  }
+  return roofline;
+}
+
+void SetThroughputs(const MeasuredNodeCost& cost,
+                    const KernelBenchmarkReport::Roofline& roofline,
+                    KernelBenchmarkReport::Result* result) {
+  result->set_runtime_ns(cost.runtime_ns);
+  result->set_num_compute_ops(cost.num_compute_ops);
+  result->set_num_bytes_accessed(cost.num_bytes_accessed);
+  result->set_inaccurate(cost.inaccurate);
+  // Ops and bytes per nanosecond are billions per second.
+  result->set_gigaops(static_cast<double>(cost.num_compute_ops) /
+                      cost.runtime_ns);
+  result->set_gb_per_sec(static_cast<double>(cost.num_bytes_accessed) /
+                         cost.runtime_ns);
+  if (cost.num_compute_ops > 0) {
+    double roofline_gigaops = roofline.peak_gigaops();
+    if (cost.num_bytes_accessed > 0) {
+      roofline_gigaops = std::min(
+          roofline_gigaops, static_cast<double>(cost.num_compute_ops) /
+                                cost.num_bytes_accessed *
+                                roofline.peak_gb_per_sec());
+    }
+    result->set_roofline_gigaops(roofline_gigaops);
+    if (roofline_gigaops > 0) {
+      result->set_roofline_fraction(result->gigaops() / roofline_gigaops);
+    }
+  } else if (roofline.peak_gb_per_sec() > 0) {
+    result->set_roofline_fraction(result->gb_per_sec() /
+                                  roofline.peak_gb_per_sec());
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<KernelBenchmarkReport> RunKernelBenchmarks(
+    const KernelBenchmarkCatalog& catalog,
+    const OpCostCalibrationOptions& roofline_options) {
+  const int num_runs =
+      catalog.num_runs() > 0 ? catalog.num_runs() : kDefaultNumRuns;
+  std::vector<int> thread_counts(catalog.num_threads().begin(),
+                                 catalog.num_threads().end());
+  if (thread_counts.empty()) thread_counts.push_back(port::MaxParallelism());
+
+  std::vector<std::pair<NodeDef, std::vector<Tensor>>> benchmarks;
+  for (const KernelBenchmarkCatalog::Benchmark& benchmark :
+       catalog.benchmarks()) {
+    std::vector<Tensor> inputs;
+    for (const KernelBenchmarkCatalog::Input& input : benchmark.inputs()) {
+      TF_ASSIGN_OR_RETURN(Tensor tensor, MakeInput(input));
+      inputs.push_back(std::move(tensor));
+    }
+    TF_ASSIGN_OR_RETURN(NodeDef node, MakeNode(benchmark));
+    benchmarks.emplace_back(std::move(node), std::move(inputs));
+  }
+
+  KernelBenchmarkReport report;
+  for (const int num_threads : thread_counts) {
+    if (num_threads <= 0) {
+      return errors::InvalidArgument("Benchmarks need a positive number of ",
+                                     "threads, got ", num_threads);
+    }
+    TF_ASSIGN_OR_RETURN(const KernelBenchmarkReport::Roofline roofline,
+                        MeasureRoofline(num_threads, roofline_options));
+    *report.add_rooflines() = roofline;
+    VLOG(1) << "Roofline: " << roofline.ShortDebugString();
+
+    DeviceSimple device(num_threads);
+    for (const auto& [node, inputs] : benchmarks) {
+      TF_ASSIGN_OR_RETURN(const MeasuredNodeCost cost,
+                          MeasureNodeCost(node, inputs, num_runs, &device));
+      KernelBenchmarkReport::Result* result = report.add_results();
+      result->set_name(node.name());
+      result->set_op(node.op());
+      result->set_num_threads(num_threads);
+      SetThroughputs(cost, roofline, result);
+      VLOG(1) << "Benchmarked " << result->ShortDebugString();
+    }
+  }
+  return report;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
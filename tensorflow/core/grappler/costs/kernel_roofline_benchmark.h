@@ -0,0 +1,39 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_KERNEL_ROOFLINE_BENCHMARK_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_KERNEL_ROOFLINE_BENCHMARK_H_
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Runs the benchmarks of `catalog` on the CPU with each of its numbers of
+// threads and reports the throughput they attained against the roofline of
+// the machine for that number of threads. The roofline is measured with
+// CalibrateOpCosts, with the sizes of `roofline_options`: its peak ops per
+// second are those of the matmul and conv, and its peak bandwidth that of the
+// memory-bound op classes.
+absl::StatusOr<KernelBenchmarkReport> RunKernelBenchmarks(
+    const KernelBenchmarkCatalog& catalog,
+    const OpCostCalibrationOptions& roofline_options);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_KERNEL_ROOFLINE_BENCHMARK_H_
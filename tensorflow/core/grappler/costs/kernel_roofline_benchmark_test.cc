@@ -0,0 +1,179 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/kernel_roofline_benchmark.h"
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpCostCalibrationOptions SmallRooflineOptions() {
+  OpCostCalibrationOptions options;
+  options.num_runs = 2;
+  options.matmul_size = 32;
+  options.conv_batch_size = 1;
+  options.conv_image_size = 8;
+  options.conv_channels = 4;
+  options.num_elements = 1024;
+  return options;
+}
+
+KernelBenchmarkCatalog ParseCatalog(const char* text) {
+  KernelBenchmarkCatalog catalog;
+  CHECK(protobuf::TextFormat::ParseFromString(text, &catalog));
+  return catalog;
+}
+
+TEST(KernelRooflineBenchmarkTest, RunsBenchmarksWithEachNumThreads) {
+  const KernelBenchmarkCatalog catalog = ParseCatalog(R"pb(
+    num_threads: [ 1, 2 ]
+    num_runs: 2
+    benchmarks {
+      name: "matmul"
+      op: "MatMul"
+      attr {
+        key: "T"
+        value { type: DT_FLOAT }
+      }
+      inputs {
+        tensor {
+          dtype: DT_FLOAT
+          shape {
+            dim { size: 16 }
+            dim { size: 32 }
+          }
+        }
+      }
+      inputs {
+        tensor {
+          dtype: DT_FLOAT
+          shape {
+            dim { size: 32 }
+            dim { size: 8 }
+          }
+        }
+      }
+    }
+    benchmarks {
+      name: "sparse_segment_sum"
+      op: "SparseSegmentSum"
+      attr {
+        key: "T"
+        value { type: DT_FLOAT }
+      }
+      inputs {
+        tensor {
+          dtype: DT_FLOAT
+          shape {
+            dim { size: 100 }
+            dim { size: 8 }
+          }
+        }
+      }
+      inputs {
+        tensor {
+          dtype: DT_INT32
+          shape { dim { size: 64 } }
+        }
+        fill: INDICES
+        index_bound: 100
+      }
+      inputs {
+        tensor {
+          dtype: DT_INT32
+          shape { dim { size: 64 } }
+        }
+        fill: SORTED_INDICES
+        index_bound: 4
+      }
+    }
+  )pb");
+  TF_ASSERT_OK_AND_ASSIGN(
+      const KernelBenchmarkReport report,
+      RunKernelBenchmarks(catalog, SmallRooflineOptions()));
+
+  ASSERT_EQ(report.rooflines_size(), 2);
+  for (const KernelBenchmarkReport::Roofline& roofline : report.rooflines()) {
+    EXPECT_GT(roofline.peak_gigaops(), 0);
+    EXPECT_GT(roofline.peak_gb_per_sec(), 0);
+  }
+  EXPECT_EQ(report.rooflines(0).num_threads(), 1);
+  EXPECT_EQ(report.rooflines(1).num_threads(), 2);
+
+  ASSERT_EQ(report.results_size(), 4);
+  for (int i = 0; i < report.results_size(); ++i) {
+    const KernelBenchmarkReport::Result& result = report.results(i);
+    EXPECT_EQ(result.num_threads(), i < 2 ? 1 : 2);
+    EXPECT_GT(result.runtime_ns(), 0);
+    EXPECT_GT(result.gb_per_sec(), 0);
+    EXPECT_GT(result.roofline_fraction(), 0);
+    if (result.op() == "MatMul") {
+      EXPECT_EQ(result.name(), "matmul");
+      EXPECT_FALSE(result.inaccurate());
+      EXPECT_GT(result.gigaops(), 0);
+      EXPECT_GT(result.roofline_gigaops(), 0);
+    } else {
+      EXPECT_EQ(result.name(), "sparse_segment_sum");
+      EXPECT_EQ(result.gigaops(), 0);
+    }
+  }
+}
+
+TEST(KernelRooflineBenchmarkTest, RequiresIndexBound) {
+  const KernelBenchmarkCatalog catalog = ParseCatalog(R"pb(
+    benchmarks {
+      name: "gather"
+      op: "GatherV2"
+      attr {
+        key: "Tparams"
+        value { type: DT_FLOAT }
+      }
+      attr {
+        key: "Tindices"
+        value { type: DT_INT32 }
+      }
+      attr {
+        key: "Taxis"
+        value { type: DT_INT32 }
+      }
+      inputs {
+        tensor {
+          dtype: DT_FLOAT
+          shape { dim { size: 10 } }
+        }
+      }
+      inputs {
+        tensor {
+          dtype: DT_INT32
+          shape { dim { size: 4 } }
+        }
+        fill: INDICES
+      }
+    }
+  )pb");
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      RunKernelBenchmarks(catalog, SmallRooflineOptions()).status()));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
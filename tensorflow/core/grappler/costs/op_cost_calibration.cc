@@ -0,0 +1,283 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Tensors with at most this many elements are passed to the estimator with
+// their value, like the axis of a gather.
+constexpr int64_t kMaxDescribedValueSize = 16;
+
+// Counts the ops and bytes of the microbenchmarks the way the estimator does
+// when predicting their cost.
+class CountingOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  using OpLevelCostEstimator::PredictNodeCosts;
+};
+
+struct Microbenchmark {
+  std::string op_class;
+  NodeDef node;
+  std::vector<Tensor> inputs;
+};
+
+Tensor RandomFloatTensor(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  return tensor;
+}
+
+Tensor Int32Scalar(int32_t value) {
+  Tensor tensor(DT_INT32, TensorShape({}));
+  tensor.scalar<int32_t>()() = value;
+  return tensor;
+}
+
+// Adds `inputs` to the node built by `builder` and finalizes it.
+absl::StatusOr<NodeDef> BuildNode(const std::vector<Tensor>& inputs,
+                                  NodeDefBuilder& builder) {
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    builder.Input(NodeDefBuilder::NodeOut(absl::StrCat("input", i), 0,
+                                          inputs[i].dtype()));
+  }
+  NodeDef node;
+  TF_RETURN_IF_ERROR(builder.Finalize(&node));
+  return node;
+}
+
+absl::StatusOr<std::vector<Microbenchmark>> MakeMicrobenchmarks(
+    const OpCostCalibrationOptions& options) {
+  std::vector<Microbenchmark> microbenchmarks;
+
+  {
+    Microbenchmark matmul{"matmul"};
+    const TensorShape shape({options.matmul_size, options.matmul_size});
+    matmul.inputs = {RandomFloatTensor(shape), RandomFloatTensor(shape)};
+    NodeDefBuilder builder("matmul", "MatMul");
+    builder.Attr("T", DT_FLOAT);
+    TF_ASSIGN_OR_RETURN(matmul.node, BuildNode(matmul.inputs, builder));
+    microbenchmarks.push_back(std::move(matmul));
+  }
+
+  {
+    Microbenchmark conv{"conv"};
+    conv.inputs = {
+        RandomFloatTensor(TensorShape(
+            {options.conv_batch_size, options.conv_image_size,
+             options.conv_image_size, options.conv_channels})),
+        RandomFloatTensor(TensorShape(
+            {3, 3, options.conv_channels, options.conv_channels}))};
+    NodeDefBuilder builder("conv", "Conv2D");
+    builder.Attr("T", DT_FLOAT)
+        .Attr("strides", {1, 1, 1, 1})
+        .Attr("padding", "SAME");
+    TF_ASSIGN_OR_RETURN(conv.node, BuildNode(conv.inputs, builder));
+    microbenchmarks.push_back(std::move(conv));
+  }
+
+  const TensorShape vector_shape({options.num_elements});
+  {
+    Microbenchmark elementwise{"elementwise"};
+    elementwise.inputs = {RandomFloatTensor(vector_shape),
+                          RandomFloatTensor(vector_shape)};
+    NodeDefBuilder builder("elementwise", "AddV2");
+    builder.Attr("T", DT_FLOAT);
+    TF_ASSIGN_OR_RETURN(elementwise.node,
+                        BuildNode(elementwise.inputs, builder));
+    microbenchmarks.push_back(std::move(elementwise));
+  }
+
+  {
+    // Gathers rows of 64 floats in a scattered order.
+    constexpr int64_t kRowSize = 64;
+    const int64_t num_rows =
+        std::max<int64_t>(1, options.num_elements / kRowSize);
+    Microbenchmark gather{"gather"};
+    Tensor indices(DT_INT32, TensorShape({num_rows}));
+    auto indices_flat = indices.flat<int32_t>();
+    for (int64_t i = 0; i < num_rows; ++i) {
+      indices_flat(i) = (i * 7919) % num_rows;
+    }
+    gather.inputs = {RandomFloatTensor(TensorShape({num_rows, kRowSize})),
+                     indices, Int32Scalar(0)};
+    NodeDefBuilder builder("gather", "GatherV2");
+    builder.Attr("Tparams", DT_FLOAT)
+        .Attr("Tindices", DT_INT32)
+        .Attr("Taxis", DT_INT32);
+    TF_ASSIGN_OR_RETURN(gather.node, BuildNode(gather.inputs, builder));
+    microbenchmarks.push_back(std::move(gather));
+  }
+
+  {
+    Microbenchmark reduction{"reduction"};
+    Tensor reduction_indices(DT_INT32, TensorShape({1}));
+    reduction_indices.flat<int32_t>()(0) = 0;
+    reduction.inputs = {RandomFloatTensor(vector_shape), reduction_indices};
+    NodeDefBuilder builder("reduction", "Sum");
+    builder.Attr("T", DT_FLOAT).Attr("Tidx", DT_INT32);
+    TF_ASSIGN_OR_RETURN(reduction.node, BuildNode(reduction.inputs, builder));
+    microbenchmarks.push_back(std::move(reduction));
+  }
+
+  return microbenchmarks;
+}
+
+void DescribeTensor(const Tensor& tensor,
+                    OpInfo::TensorProperties* properties) {
+  properties->set_dtype(tensor.dtype());
+  tensor.shape().AsProto(properties->mutable_shape());
+  if (tensor.NumElements() <= kMaxDescribedValueSize) {
+    tensor.AsProtoTensorContent(properties->mutable_value());
+  }
+}
+
+// Runs `node` and returns its median runtime in nanoseconds. The outputs of
+// the warm-up run are described in `op_info`.
+absl::StatusOr<int64_t> MedianRuntimeNs(const NodeDef& node,
+                                        const std::vector<Tensor>& tensors,
+                                        int num_runs, DeviceBase* device,
+                                        ResourceMgr* resource_mgr,
+                                        OpInfo* op_info) {
+  gtl::InlinedVector<TensorValue, 4> inputs;
+  for (const Tensor& input : tensors) {
+    inputs.emplace_back(const_cast<Tensor*>(&input));
+  }
+  std::vector<int64_t> runtimes;
+  for (int run = 0; run <= num_runs; ++run) {
+    gtl::InlinedVector<TensorValue, 4> outputs;
+    const uint64_t start = Env::Default()->NowNanos();
+    const Status s =
+        EvaluateNode(node, inputs, device, resource_mgr, &outputs);
+    const uint64_t end = Env::Default()->NowNanos();
+    for (const TensorValue& output : outputs) {
+      if (run == 0 && s.ok()) {
+        DescribeTensor(*output.tensor, op_info->add_outputs());
+      }
+      delete output.tensor;
+    }
+    TF_RETURN_IF_ERROR(s);
+    if (run > 0) runtimes.push_back(end - start);
+  }
+  std::nth_element(runtimes.begin(), runtimes.begin() + runtimes.size() / 2,
+                   runtimes.end());
+  return std::max<int64_t>(1, runtimes[runtimes.size() / 2]);
+}
+
+}  // namespace
+
+absl::StatusOr<MeasuredNodeCost> MeasureNodeCost(
+    const NodeDef& node, const std::vector<Tensor>& inputs, int num_runs,
+    DeviceBase* device) {
+  if (num_runs <= 0) {
+    return errors::InvalidArgument("Measuring the cost of ", node.name(),
+                                   " needs at least one run, got ", num_runs);
+  }
+  OpContext op_context;
+  OpInfo& op_info = op_context.op_info;
+  op_info.set_op(node.op());
+  *op_info.mutable_attr() = node.attr();
+  op_info.mutable_device()->set_type("CPU");
+  for (const Tensor& input : inputs) {
+    DescribeTensor(input, op_info.add_inputs());
+  }
+  ResourceMgr resource_mgr;
+  MeasuredNodeCost cost;
+  TF_ASSIGN_OR_RETURN(cost.runtime_ns,
+                      MedianRuntimeNs(node, inputs, num_runs, device,
+                                      &resource_mgr, &op_info));
+
+  CountingOpLevelCostEstimator estimator;
+  NodeCosts node_costs;
+  TF_RETURN_IF_ERROR(estimator.PredictNodeCosts(op_context, &node_costs));
+  cost.num_compute_ops = node_costs.num_compute_ops;
+  cost.num_bytes_accessed = node_costs.num_bytes_accessed();
+  cost.inaccurate = node_costs.inaccurate;
+  return cost;
+}
+
+absl::StatusOr<OpCostCalibration> CalibrateOpCosts(
+    const OpCostCalibrationOptions& options) {
+  if (options.num_runs <= 0) {
+    return errors::InvalidArgument(
+        "The op cost calibration needs at least one run, got ",
+        options.num_runs);
+  }
+  TF_ASSIGN_OR_RETURN(std::vector<Microbenchmark> microbenchmarks,
+                      MakeMicrobenchmarks(options));
+
+  std::unique_ptr<DeviceSimple> device =
+      options.num_threads > 0
+          ? std::make_unique<DeviceSimple>(options.num_threads)
+          : std::make_unique<DeviceSimple>();
+  OpCostCalibration calibration;
+  calibration.set_device_type("CPU");
+  for (const Microbenchmark& microbenchmark : microbenchmarks) {
+    TF_ASSIGN_OR_RETURN(
+        const MeasuredNodeCost cost,
+        MeasureNodeCost(microbenchmark.node, microbenchmark.inputs,
+                        options.num_runs, device.get()));
+    if (cost.inaccurate) {
+      LOG(WARNING) << "The cost estimate of the " << microbenchmark.op_class
+                   << " microbenchmark is inaccurate.";
+    }
+
+    // The throughputs are in ops and bytes per nanosecond, that is in
+    // billions per second.
+    OpClassThroughput& throughput =
+        (*calibration.mutable_op_classes())[microbenchmark.op_class];
+    if (microbenchmark.op_class == "matmul" ||
+        microbenchmark.op_class == "conv") {
+      throughput.set_gigaops(static_cast<double>(cost.num_compute_ops) /
+                             cost.runtime_ns);
+    } else {
+      throughput.set_gb_per_sec(
+          static_cast<double>(cost.num_bytes_accessed) / cost.runtime_ns);
+    }
+    VLOG(1) << "Calibrated " << microbenchmark.op_class << " in "
+            << cost.runtime_ns << " ns: " << throughput.ShortDebugString();
+  }
+  return calibration;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,84 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Sizes of the microbenchmarks run by CalibrateOpCosts. They should be large
+// enough for kernel launch overheads to be negligible.
+struct OpCostCalibrationOptions {
+  // Number of timed runs of each microbenchmark, after a warm-up run. The
+  // median runtime is used.
+  int num_runs = 10;
+
+  // Number of threads the microbenchmarks run on. 0 runs them on the few
+  // threads of DeviceSimple.
+  int num_threads = 0;
+
+  // The matmul multiplies two square matrices of this size.
+  int64_t matmul_size = 1024;
+
+  // The conv runs a 3x3 filter over a batch of square NHWC images.
+  int64_t conv_batch_size = 8;
+  int64_t conv_image_size = 56;
+  int64_t conv_channels = 64;
+
+  // Number of float elements of the inputs of the elementwise, gather and
+  // reduction.
+  int64_t num_elements = 1 << 24;
+};
+
+// Runs a microbenchmark of each op class of OpCostCalibration on the CPU and
+// returns the throughput it attained. The throughput of the matmul and conv is
+// measured in ops per second and that of the other, memory-bound, classes in
+// bytes per second, with the ops and bytes counted by OpLevelCostEstimator.
+absl::StatusOr<OpCostCalibration> CalibrateOpCosts(
+    const OpCostCalibrationOptions& options);
+
+// The runtime of a node, with the ops and bytes OpLevelCostEstimator counts
+// for it.
+struct MeasuredNodeCost {
+  int64_t runtime_ns = 0;
+  int64_t num_compute_ops = 0;
+  int64_t num_bytes_accessed = 0;
+  // Whether the estimator doesn't count the ops and bytes of the node exactly,
+  // as for the ops it has no estimate of, whose bytes are those of their
+  // inputs and outputs.
+  bool inaccurate = false;
+};
+
+// Runs `node` on `inputs` on the CPU `device` `num_runs` times after a warm-up
+// run and returns its median runtime and counted costs. The inputs of `node`
+// are matched with `inputs` by position.
+absl::StatusOr<MeasuredNodeCost> MeasureNodeCost(
+    const NodeDef& node, const std::vector<Tensor>& inputs, int num_runs,
+    DeviceBase* device);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
@@ -0,0 +1,67 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <string>
+
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpCostCalibrationOptions SmallOptions() {
+  OpCostCalibrationOptions options;
+  options.num_runs = 2;
+  options.matmul_size = 32;
+  options.conv_batch_size = 1;
+  options.conv_image_size = 8;
+  options.conv_channels = 4;
+  options.num_elements = 1024;
+  return options;
+}
+
+TEST(OpCostCalibrationTest, MeasuresOpClasses) {
+  TF_ASSERT_OK_AND_ASSIGN(OpCostCalibration calibration,
+                          CalibrateOpCosts(SmallOptions()));
+  EXPECT_EQ(calibration.device_type(), "CPU");
+  EXPECT_EQ(calibration.op_classes_size(), 5);
+  for (const std::string op_class : {"matmul", "conv"}) {
+    ASSERT_TRUE(calibration.op_classes().contains(op_class)) << op_class;
+    EXPECT_GT(calibration.op_classes().at(op_class).gigaops(), 0) << op_class;
+    EXPECT_EQ(calibration.op_classes().at(op_class).gb_per_sec(), 0)
+        << op_class;
+  }
+  for (const std::string op_class : {"elementwise", "gather", "reduction"}) {
+    ASSERT_TRUE(calibration.op_classes().contains(op_class)) << op_class;
+    EXPECT_EQ(calibration.op_classes().at(op_class).gigaops(), 0) << op_class;
+    EXPECT_GT(calibration.op_classes().at(op_class).gb_per_sec(), 0)
+        << op_class;
+  }
+}
+
+TEST(OpCostCalibrationTest, RequiresRuns) {
+  OpCostCalibrationOptions options = SmallOptions();
+  options.num_runs = 0;
+  EXPECT_TRUE(errors::IsInvalidArgument(CalibrateOpCosts(options).status()));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -45,9 +46,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/overflow.h"
 #include "tensorflow/core/util/padding.h"
 #include "tsl/platform/statusor.h"
@@ -151,6 +154,28 @@ static const int64_t kMinComputeOp = 1;
 
 namespace {
 
+// Returns the calibration named by TF_GRAPPLER_OP_COST_CALIBRATION, which is
+// loaded once per process, or nullptr if there is none.
+const OpCostCalibration* GetDefaultCalibration() {
+  static const OpCostCalibration* calibration =
+      []() -> const OpCostCalibration* {
+    std::string filename;
+    absl::Status s = ReadStringFromEnvVar("TF_GRAPPLER_OP_COST_CALIBRATION",
+                                          "", &filename);
+    if (!s.ok() || filename.empty()) return nullptr;
+    auto* calibration = new OpCostCalibration();
+    s = ReadTextOrBinaryProto(Env::Default(), filename, calibration);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to load the op cost calibration " << filename
+                   << ": " << s;
+      delete calibration;
+      return nullptr;
+    }
+    return calibration;
+  }();
+  return calibration;
+}
+
 std::string GetDataFormat(const OpInfo& op_info) {
   std::string data_format = "NHWC";  // Default format.
   if (op_info.attr().find("data_format") != op_info.attr().end()) {
@@ -655,6 +680,37 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  if (const OpCostCalibration* calibration = GetDefaultCalibration()) {
+    SetCalibration(*calibration);
+  }
+}
+
+void OpLevelCostEstimator::SetCalibration(
+    const OpCostCalibration& calibration) {
+  calibration_ = calibration;
+}
+
+std::string OpLevelCostEstimator::GetOpCalibrationClass(
+    const std::string& op) const {
+  static const auto* const kMatMulOps = new absl::flat_hash_set<std::string>(
+      {kMatMul, kSparseMatMul, kBatchMatMul, kBatchMatMulV2, "_FusedMatMul"});
+  static const auto* const kConvOps = new absl::flat_hash_set<std::string>(
+      {kConv2d, kConv2dBackpropFilter, kConv2dBackpropInput,
+       kFusedConv2dBiasActivation, kDepthwiseConv2dNative,
+       kDepthwiseConv2dNativeBackpropFilter,
+       kDepthwiseConv2dNativeBackpropInput, "_FusedConv2D"});
+  static const auto* const kGatherOps = new absl::flat_hash_set<std::string>(
+      {kGather, kGatherNd, kGatherV2, "ResourceGather"});
+  static const auto* const kReductionOps =
+      new absl::flat_hash_set<std::string>(
+          {"All", "Any", "EuclideanNorm", "Max", "Mean", "Min", "Prod", "Sum"});
+  if (kMatMulOps->contains(op)) return "matmul";
+  if (kConvOps->contains(op)) return "conv";
+  if (kGatherOps->contains(op)) return "gather";
+  if (kReductionOps->contains(op)) return "reduction";
+  if (elementwise_ops_.find(op) != elementwise_ops_.end()) return "elementwise";
+  return "";
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
@@ -850,7 +906,22 @@ Costs OpLevelCostEstimator::PredictOpCountBasedCost(
     double operations, double input_io_bytes, double output_io_bytes,
     const OpInfo& op_info) const {
   double total_io_bytes = input_io_bytes + output_io_bytes;
-  const DeviceInfo device_info = GetDeviceInfo(op_info.device());
+  DeviceInfo device_info = GetDeviceInfo(op_info.device());
+  if (!calibration_.op_classes().empty() &&
+      calibration_.device_type() == op_info.device().type()) {
+    auto it =
+        calibration_.op_classes().find(GetOpCalibrationClass(op_info.op()));
+    if (it != calibration_.op_classes().end()) {
+      const OpClassThroughput& throughput = it->second;
+      device_info.gigaops =
+          throughput.gigaops() > 0 ? throughput.gigaops() : INFINITY;
+      device_info.gb_per_sec =
+          throughput.gb_per_sec() > 0 ? throughput.gb_per_sec() : INFINITY;
+      VLOG(1) << "Op:" << op_info.op() << " calibrated gigaops:"
+              << device_info.gigaops
+              << " gb_per_sec:" << device_info.gb_per_sec;
+    }
+  }
   if (device_info.gigaops <= 0 || device_info.gb_per_sec <= 0 ||
       device_info.intermediate_read_gb_per_sec <= 0 ||
       device_info.intermediate_write_gb_per_sec <= 0) {
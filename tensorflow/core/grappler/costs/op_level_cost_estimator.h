@@ -106,6 +106,16 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Predicts the ops of the classes in `calibration` that run on its device
+  // type with the measured throughputs instead of the peak throughput of the
+  // device. The estimator starts with the calibration in the file named by the
+  // TF_GRAPPLER_OP_COST_CALIBRATION environment variable, if set.
+  void SetCalibration(const OpCostCalibration& calibration);
+
+  // Returns the class of `op` in an OpCostCalibration, or an empty string if
+  // `op` doesn't belong to any.
+  std::string GetOpCalibrationClass(const std::string& op) const;
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -335,6 +345,7 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  OpCostCalibration calibration_;
 
  private:
   friend class OpLevelCostEstimatorTest;
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 
+#include <cmath>
+#include <cstdint>
 #include <unordered_set>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -540,6 +542,10 @@ class OpLevelCostEstimatorTest : public ::testing::Test {
     estimator_.compute_memory_overlap_ = value;
   }
 
+  void SetCalibration(const OpCostCalibration& calibration) {
+    estimator_.SetCalibration(calibration);
+  }
+
   void ValidateOpDimensionsFromInputs(const int n, const int h, const int w,
                                       const int c, const int kx, const int ky,
                                       const int sx, const int sy,
@@ -1169,6 +1175,39 @@ TEST_F(OpLevelCostEstimatorTest, BroadcastAddExecutionTime) {
   EXPECT_EQ(cost.persistent_memory, 0);
 }
 
+TEST_F(OpLevelCostEstimatorTest, CalibratedMatMul) {
+  const OpContext op_context = DescribeMatMul(2, 4, 7, 7);
+  bool found_unknown_shapes = false;
+  const int64_t ops =
+      CountMatMulOperations(op_context.op_info, &found_unknown_shapes);
+  const Costs uncalibrated_cost = PredictCosts(op_context);
+
+  OpCostCalibration calibration;
+  calibration.set_device_type("GPU");
+  (*calibration.mutable_op_classes())["matmul"].set_gigaops(2);
+  SetCalibration(calibration);
+  // The calibration is for another device type.
+  EXPECT_EQ(uncalibrated_cost.execution_time,
+            PredictCosts(op_context).execution_time);
+
+  calibration.set_device_type("CPU");
+  SetCalibration(calibration);
+  const Costs cost = PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(std::ceil(ops / 2.0)), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(0), cost.memory_time);
+  EXPECT_EQ(cost.compute_time, cost.execution_time);
+  EXPECT_FALSE(cost.inaccurate);
+
+  // Ops of other classes keep the throughput of the device.
+  const OpContext add_context =
+      DescribeBinaryOp("AddV2", /*size1=*/1000, /*size2=*/1000);
+  SetCalibration(OpCostCalibration());
+  const Costs uncalibrated_add_cost = PredictCosts(add_context);
+  SetCalibration(calibration);
+  EXPECT_EQ(uncalibrated_add_cost.execution_time,
+            PredictCosts(add_context).execution_time);
+}
+
 TEST_F(OpLevelCostEstimatorTest, UnknownOrPartialShape) {
   {
     auto cost = PredictCosts(DescribeMatMul(2, 4, 7, 7));
@@ -0,0 +1,295 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/collective_bucketing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// The bucket size of PyTorch DDP.
+constexpr int64_t kDefaultBucketSizeBytes = 25 << 20;
+
+// Suffix of the name of the collective that reduces a bucket, after the name
+// of the first reduction of the bucket. Its helper nodes are named after it.
+constexpr char kBucketSuffix[] = "/bucket";
+
+struct Reduction {
+  const NodeDef* node;
+  TensorShape shape;
+};
+
+struct Bucket {
+  std::vector<Reduction> reductions;
+  int64_t num_bytes = 0;
+};
+
+// Returns a key shared by the reductions that may be bucketed together, or
+// the empty string if `node` can't be bucketed.
+std::string BucketKey(const NodeDef& node, const GraphProperties& properties,
+                      const FrameView& frames, TensorShape* shape) {
+  // The ordering tokens are inputs after the instance key.
+  if (node.op() != "CollectiveReduceV2" || NumNonControlInputs(node) != 4 ||
+      frames.IsInFrame(node)) {
+    return "";
+  }
+  const std::vector<OpInfo::TensorProperties>& inputs =
+      properties.GetInputProperties(node.name());
+  if (inputs.empty() ||
+      !PartialTensorShape(inputs[0].shape()).AsTensorShape(shape)) {
+    return "";
+  }
+  std::vector<std::string> attrs;
+  for (const auto& attr : node.attr()) {
+    attrs.push_back(absl::StrCat(attr.first, "=",
+                                 SummarizeAttrValue(attr.second)));
+  }
+  std::sort(attrs.begin(), attrs.end());
+  // The group size and group key are the same tensors, so that the bucket
+  // can use them.
+  return absl::StrCat(node.device(), ";", node.input(1), ";", node.input(2),
+                      ";", absl::StrJoin(attrs, ","));
+}
+
+// Returns whether `node` depends on a reduction of `bucket`, in which case its
+// input can't be reduced with them.
+bool DependsOnBucket(
+    const NodeDef& node, const Bucket& bucket,
+    const absl::flat_hash_map<std::string, const NodeDef*>& nodes,
+    const absl::flat_hash_map<const NodeDef*, int>& topo_index) {
+  absl::flat_hash_set<const NodeDef*> reductions;
+  int min_index = topo_index.at(&node);
+  for (const Reduction& reduction : bucket.reductions) {
+    reductions.insert(reduction.node);
+    min_index = std::min(min_index, topo_index.at(reduction.node));
+  }
+  std::vector<const NodeDef*> stack = {&node};
+  absl::flat_hash_set<const NodeDef*> visited = {&node};
+  while (!stack.empty()) {
+    const NodeDef* current = stack.back();
+    stack.pop_back();
+    for (const std::string& input : current->input()) {
+      auto it = nodes.find(NodeName(input));
+      if (it == nodes.end()) continue;
+      const NodeDef* fanin = it->second;
+      if (reductions.contains(fanin)) return true;
+      // Nodes before the first reduction can't depend on it.
+      if (topo_index.at(fanin) > min_index && visited.insert(fanin).second) {
+        stack.push_back(fanin);
+      }
+    }
+  }
+  return false;
+}
+
+NodeDef* AddNode(const std::string& name, const std::string& op,
+                 const std::string& device, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  node->set_device(device);
+  return node;
+}
+
+void AddConst(const std::string& name, const Tensor& value,
+              const std::string& device, GraphDef* graph) {
+  NodeDef* node = AddNode(name, "Const", device, graph);
+  AddNodeAttr("dtype", value.dtype(), node);
+  value.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+}
+
+Tensor Int32Vector(const std::vector<int32_t>& values) {
+  Tensor tensor(DT_INT32, TensorShape({static_cast<int64_t>(values.size())}));
+  std::copy(values.begin(), values.end(), tensor.flat<int32_t>().data());
+  return tensor;
+}
+
+// Replaces the reductions of `bucket` by one reduction of their concatenated
+// inputs.
+void RewriteBucket(const Bucket& bucket,
+                   const absl::flat_hash_map<std::string, NodeDef*>& outputs,
+                   GraphDef* graph) {
+  const NodeDef& first = *bucket.reductions[0].node;
+  const std::string prefix = absl::StrCat(first.name(), kBucketSuffix);
+  const std::string& device = first.device();
+  const DataType dtype = first.attr().at("T").type();
+  const int num_reductions = bucket.reductions.size();
+
+  AddConst(absl::StrCat(prefix, "/flat_shape"), Int32Vector({-1}), device,
+           graph);
+  AddConst(absl::StrCat(prefix, "/axis"), Tensor(int32_t{0}), device, graph);
+  NodeDef* concat =
+      AddNode(absl::StrCat(prefix, "/concat"), "ConcatV2", device, graph);
+  Tensor sizes(DT_INT64, TensorShape({num_reductions}));
+  for (int i = 0; i < num_reductions; ++i) {
+    const Reduction& reduction = bucket.reductions[i];
+    NodeDef* flatten = AddNode(absl::StrCat(prefix, "/flatten_", i), "Reshape",
+                               device, graph);
+    flatten->add_input(reduction.node->input(0));
+    flatten->add_input(absl::StrCat(prefix, "/flat_shape"));
+    AddNodeAttr("T", dtype, flatten);
+    AddNodeAttr("Tshape", DT_INT32, flatten);
+    concat->add_input(flatten->name());
+    sizes.flat<int64_t>()(i) = reduction.shape.num_elements();
+  }
+  concat->add_input(absl::StrCat(prefix, "/axis"));
+  AddNodeAttr("N", num_reductions, concat);
+  AddNodeAttr("T", dtype, concat);
+  AddNodeAttr("Tidx", DT_INT32, concat);
+
+  // The bucket is reduced with the instance key of its first reduction, whose
+  // control dependencies it keeps, with those of the other reductions.
+  NodeDef* reduce = graph->add_node();
+  *reduce = first;
+  reduce->set_name(prefix);
+  reduce->set_input(0, concat->name());
+  absl::flat_hash_set<std::string> control_inputs(reduce->input().begin(),
+                                                  reduce->input().end());
+  for (const Reduction& reduction : bucket.reductions) {
+    for (const std::string& input : reduction.node->input()) {
+      if (IsControlInput(input) && control_inputs.insert(input).second) {
+        reduce->add_input(input);
+      }
+    }
+  }
+
+  AddConst(absl::StrCat(prefix, "/sizes"), sizes, device, graph);
+  NodeDef* split =
+      AddNode(absl::StrCat(prefix, "/split"), "SplitV", device, graph);
+  split->add_input(prefix);
+  split->add_input(absl::StrCat(prefix, "/sizes"));
+  split->add_input(absl::StrCat(prefix, "/axis"));
+  AddNodeAttr("num_split", num_reductions, split);
+  AddNodeAttr("T", dtype, split);
+  AddNodeAttr("Tlen", DT_INT64, split);
+
+  for (int i = 0; i < num_reductions; ++i) {
+    const Reduction& reduction = bucket.reductions[i];
+    std::vector<int32_t> dims;
+    for (int64_t dim : reduction.shape.dim_sizes()) dims.push_back(dim);
+    const std::string shape_name = absl::StrCat(prefix, "/shape_", i);
+    AddConst(shape_name, Int32Vector(dims), device, graph);
+    NodeDef* node = outputs.at(reduction.node->name());
+    node->set_op("Reshape");
+    node->clear_input();
+    node->add_input(absl::StrCat(split->name(), ":", i));
+    node->add_input(shape_name);
+    node->clear_attr();
+    AddNodeAttr("T", dtype, node);
+    AddNodeAttr("Tshape", DT_INT32, node);
+  }
+}
+
+}  // namespace
+
+Status CollectiveBucketing::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* output) {
+  *output = item.graph;
+  const int64_t bucket_size_bytes = options_.bucket_size_bytes() > 0
+                                        ? options_.bucket_size_bytes()
+                                        : kDefaultBucketSizeBytes;
+
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item.graph, &topo_order));
+  absl::flat_hash_map<std::string, const NodeDef*> nodes;
+  absl::flat_hash_map<const NodeDef*, int> topo_index;
+  bool has_reductions = false;
+  for (int i = 0; i < topo_order.size(); ++i) {
+    nodes[topo_order[i]->name()] = topo_order[i];
+    topo_index[topo_order[i]] = i;
+    has_reductions |= topo_order[i]->op() == "CollectiveReduceV2";
+  }
+  if (!has_reductions) return errors::Aborted("Nothing to do.");
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_input_tensor_values=*/false,
+      /*include_output_tensor_values=*/false));
+  FrameView frames;
+  TF_RETURN_IF_ERROR(frames.InferFromGraph(item.graph));
+
+  // Buckets are filled in topological order, and a new one is opened when a
+  // reduction doesn't fit or depends on the open one.
+  std::vector<Bucket> buckets;
+  absl::flat_hash_map<std::string, int> open_buckets;
+  for (const NodeDef* node : topo_order) {
+    TensorShape shape;
+    const std::string key = BucketKey(*node, properties, frames, &shape);
+    if (key.empty()) continue;
+    auto it = open_buckets.find(key);
+    if (it != open_buckets.end() &&
+        DependsOnBucket(*node, buckets[it->second], nodes, topo_index)) {
+      open_buckets.erase(it);
+      it = open_buckets.end();
+    }
+    if (it == open_buckets.end()) {
+      it = open_buckets.emplace(key, buckets.size()).first;
+      buckets.emplace_back();
+    }
+    Bucket& bucket = buckets[it->second];
+    bucket.reductions.push_back({node, shape});
+    bucket.num_bytes +=
+        shape.num_elements() * DataTypeSize(node->attr().at("T").type());
+    if (bucket.num_bytes >= bucket_size_bytes) open_buckets.erase(it);
+  }
+
+  absl::flat_hash_map<std::string, NodeDef*> outputs;
+  for (NodeDef& node : *output->mutable_node()) {
+    outputs[node.name()] = &node;
+  }
+  int num_bucketed = 0;
+  int num_buckets = 0;
+  for (const Bucket& bucket : buckets) {
+    if (bucket.reductions.size() < 2 ||
+        outputs.contains(absl::StrCat(bucket.reductions[0].node->name(),
+                                      kBucketSuffix))) {
+      continue;
+    }
+    RewriteBucket(bucket, outputs, output);
+    num_bucketed += bucket.reductions.size();
+    ++num_buckets;
+  }
+  if (num_buckets == 0) return errors::Aborted("Nothing to do.");
+  VLOG(1) << "Bucketed " << num_bucketed << " collective reductions into "
+          << num_buckets << " buckets";
+  return absl::OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
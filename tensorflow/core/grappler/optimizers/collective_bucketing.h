@@ -0,0 +1,59 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Packs CollectiveReduceV2 nodes into buckets reduced by a single collective,
+// so that small gradients don't each pay the latency of a collective.
+//
+// Reductions are compatible if they share their device, attributes, group
+// size and group key, and have static shapes. They are taken in topological
+// order, which is the order in which backprop produces the gradients, and
+// added to the open bucket of their kind until it holds bucket_size_bytes.
+// The inputs of a bucket are flattened and concatenated, reduced with the
+// instance key of its first reduction, and split back. Each original
+// reduction node becomes the Reshape of its piece, so its consumers are left
+// unchanged. As a bucket only waits for its own inputs, its communication
+// overlaps with the rest of backprop, unlike ScopedAllocatorOptimizer, which
+// only merges ops that are already adjacent.
+class CollectiveBucketing : public GraphOptimizer {
+ public:
+  explicit CollectiveBucketing(const CollectiveBucketingOptions& options)
+      : options_(options) {}
+
+  ~CollectiveBucketing() override {}
+
+  string name() const override { return "collective_bucketing"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+ private:
+  const CollectiveBucketingOptions options_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_COLLECTIVE_BUCKETING_H_
@@ -0,0 +1,201 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/collective_bucketing.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+NodeDef Placeholder(const std::string& name, DataType dtype,
+                    const TensorShape& shape) {
+  return NDef(name, "Placeholder", {}, {{"dtype", dtype}, {"shape", shape}});
+}
+
+NodeDef Int32Const(const std::string& name, int32_t value) {
+  return NDef(name, "Const", {},
+              {{"dtype", DT_INT32}, {"value", test::AsScalar<int32_t>(value)}});
+}
+
+NodeDef Reduce(const std::string& name, const std::string& input,
+               DataType dtype, const std::string& instance_key) {
+  return NDef(name, "CollectiveReduceV2",
+              {input, "group_size", "group_key", instance_key},
+              {{"T", dtype},
+               {"merge_op", "Add"},
+               {"final_op", "Div"},
+               {"communication_hint", "auto"},
+               {"Nordering_token", 0}});
+}
+
+// Turns a reduction into an Identity of its input.
+void ToIdentity(NodeDef* node) {
+  const DataType dtype = node->attr().at("T").type();
+  node->set_op("Identity");
+  node->mutable_input()->DeleteSubrange(1, node->input_size() - 1);
+  node->clear_attr();
+  (*node->mutable_attr())["T"].set_type(dtype);
+}
+
+class CollectiveBucketingTest : public GrapplerTest {
+ protected:
+  // Reductions of a float [2, 3], [4] and scalar, and an int32 [5].
+  GrapplerItem MakeItem() {
+    GrapplerItem item;
+    std::vector<NodeDef> nodes = {
+        Placeholder("x0", DT_FLOAT, TensorShape({2, 3})),
+        Placeholder("x1", DT_FLOAT, TensorShape({4})),
+        Placeholder("x2", DT_FLOAT, TensorShape({})),
+        Placeholder("x3", DT_INT32, TensorShape({5})),
+        Int32Const("group_size", 2),
+        Int32Const("group_key", 1)};
+    for (int i = 0; i < 4; ++i) {
+      const std::string index = std::to_string(i);
+      nodes.push_back(Int32Const("instance_key" + index, 10 + i));
+      nodes.push_back(Reduce("reduce" + index, "x" + index,
+                             i == 3 ? DT_INT32 : DT_FLOAT,
+                             "instance_key" + index));
+      nodes.push_back(NDef("out" + index, "Identity", {"reduce" + index},
+                           {{"T", i == 3 ? DT_INT32 : DT_FLOAT}}));
+      item.fetch.push_back("out" + index);
+    }
+    item.graph = test::function::GDef(nodes);
+    return item;
+  }
+
+  static CollectiveBucketingOptions Options(int64_t bucket_size_bytes) {
+    CollectiveBucketingOptions options;
+    options.set_enable(true);
+    options.set_bucket_size_bytes(bucket_size_bytes);
+    return options;
+  }
+};
+
+TEST_F(CollectiveBucketingTest, BucketsCompatibleReductions) {
+  GrapplerItem item = MakeItem();
+  CollectiveBucketing optimizer(Options(/*bucket_size_bytes=*/0));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* bucket = node_map.GetNode("reduce0/bucket");
+  ASSERT_NE(bucket, nullptr);
+  EXPECT_EQ(bucket->op(), "CollectiveReduceV2");
+  ASSERT_EQ(bucket->input_size(), 4);
+  EXPECT_EQ(bucket->input(0), "reduce0/bucket/concat");
+  EXPECT_EQ(bucket->input(3), "instance_key0");
+  const NodeDef* concat = node_map.GetNode("reduce0/bucket/concat");
+  ASSERT_NE(concat, nullptr);
+  EXPECT_EQ(concat->input_size(), 4);
+  for (int i = 0; i < 3; ++i) {
+    const NodeDef* reduce = node_map.GetNode("reduce" + std::to_string(i));
+    ASSERT_NE(reduce, nullptr);
+    EXPECT_EQ(reduce->op(), "Reshape");
+    EXPECT_EQ(reduce->input(0), "reduce0/bucket/split:" + std::to_string(i));
+  }
+  // The int32 reduction is left alone.
+  EXPECT_EQ(node_map.GetNode("reduce3")->op(), "CollectiveReduceV2");
+  EXPECT_EQ(node_map.GetNode("reduce3/bucket"), nullptr);
+
+  // With the collective replaced by an identity, the pieces of the bucket are
+  // the inputs of the original reductions.
+  ToIdentity(node_map.GetNode("reduce0/bucket"));
+  ToIdentity(node_map.GetNode("reduce3"));
+
+  const Tensor x0 = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3});
+  const Tensor x1 = test::AsTensor<float>({7, 8, 9, 10});
+  const Tensor x2 = test::AsScalar<float>(11);
+  const Tensor x3 = test::AsTensor<int32_t>({1, 2, 3, 4, 5});
+  const std::vector<Tensor> tensors = EvaluateNodes(
+      output, item.fetch, {{"x0", x0}, {"x1", x1}, {"x2", x2}, {"x3", x3}});
+  ASSERT_EQ(tensors.size(), 4);
+  test::ExpectTensorEqual<float>(tensors[0], x0);
+  test::ExpectTensorEqual<float>(tensors[1], x1);
+  test::ExpectTensorEqual<float>(tensors[2], x2);
+  test::ExpectTensorEqual<int32_t>(tensors[3], x3);
+}
+
+TEST_F(CollectiveBucketingTest, ClosesFullBuckets) {
+  GrapplerItem item = MakeItem();
+  // The first reduction fills a bucket on its own.
+  CollectiveBucketing optimizer(Options(/*bucket_size_bytes=*/24));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(node_map.GetNode("reduce0")->op(), "CollectiveReduceV2");
+  EXPECT_EQ(node_map.GetNode("reduce0/bucket"), nullptr);
+  ASSERT_NE(node_map.GetNode("reduce1/bucket"), nullptr);
+  EXPECT_EQ(node_map.GetNode("reduce1")->op(), "Reshape");
+  EXPECT_EQ(node_map.GetNode("reduce2")->op(), "Reshape");
+}
+
+TEST_F(CollectiveBucketingTest, KeepsDependentReductionsApart) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {Placeholder("x", DT_FLOAT, TensorShape({4})),
+       Int32Const("group_size", 2), Int32Const("group_key", 1),
+       Int32Const("instance_key0", 10), Int32Const("instance_key1", 11),
+       Reduce("reduce0", "x", DT_FLOAT, "instance_key0"),
+       NDef("scaled", "Mul", {"reduce0", "x"}, {{"T", DT_FLOAT}}),
+       Reduce("reduce1", "scaled", DT_FLOAT, "instance_key1")});
+  item.fetch = {"reduce1"};
+
+  CollectiveBucketing optimizer(Options(/*bucket_size_bytes=*/0));
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+TEST_F(CollectiveBucketingTest, SkipsIncompatibleReductions) {
+  GrapplerItem item;
+  NodeDef reduce2 = Reduce("reduce2", "y", DT_FLOAT, "instance_key2");
+  (*reduce2.mutable_attr())["communication_hint"].set_s("nccl");
+  item.graph = test::function::GDef(
+      {// The shape of x is unknown.
+       NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       Placeholder("y", DT_FLOAT, TensorShape({4})),
+       Int32Const("group_size", 2), Int32Const("group_key", 1),
+       Int32Const("instance_key0", 10), Int32Const("instance_key1", 11),
+       Int32Const("instance_key2", 12),
+       Reduce("reduce0", "x", DT_FLOAT, "instance_key0"),
+       Reduce("reduce1", "y", DT_FLOAT, "instance_key1"), reduce2});
+  item.fetch = {"reduce0", "reduce1", "reduce2"};
+
+  CollectiveBucketing optimizer(Options(/*bucket_size_bytes=*/0));
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -23,9 +26,16 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -33,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/canonicalizer.h"
+#include "tensorflow/core/grappler/utils/frame.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
@@ -273,6 +284,539 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
   return absl::OkStatus();
 }
 
+namespace {
+
+// Prefix of the canonical inputs that refer to the value of a body node, as
+// "v<value id>:<output>:<index>", and to a tensor of the graph passed to a
+// body as an input, as "g<tensor>".
+constexpr char kValuePrefix[] = "v";
+constexpr char kGraphTensorPrefix[] = "g";
+
+// A value computed by the body nodes of one or more function calls.
+struct FunctionValue {
+  // The body node with its inputs replaced by canonical inputs.
+  std::unique_ptr<NodeDef> node;
+  // Name of the first body node that computes the value.
+  string body_name;
+  // Whether the value depends on an input of the function.
+  bool depends_on_input = false;
+  // Indices of the calls whose bodies compute the value.
+  std::set<int> calls;
+};
+
+// A call from the graph to a function that is a candidate for cross function
+// dedup.
+struct FunctionCall {
+  NodeDef* node;
+  const FunctionDef* function;
+  // Value ids of the body nodes that were numbered.
+  absl::flat_hash_map<string, int> node_values;
+};
+
+// Numbers the values computed by the bodies of function calls. Body nodes get
+// the same value id if they have the same op, device and attributes and their
+// inputs have the same value ids or are passed the same tensors of the graph.
+class FunctionValueNumbering {
+ public:
+  // Numbers the body nodes of `call`. Returns false if the function can't be
+  // numbered, e.g. because it has polymorphic inputs.
+  bool AddCall(int call_index, FunctionCall* call);
+
+  const FunctionValue& value(int id) const { return values_[id]; }
+
+  // Returns the type of the tensor of the graph `tensor` as passed to a call.
+  DataType graph_tensor_type(const string& tensor) const {
+    return graph_tensor_types_.at(tensor);
+  }
+
+ private:
+  std::vector<FunctionValue> values_;
+  absl::flat_hash_map<const NodeDef*, int> value_ids_;
+  absl::flat_hash_map<string, DataType> graph_tensor_types_;
+  UniqueNodes unique_nodes_;
+};
+
+// Splits a data input of a function body node, either "<node>:<output>:<index>"
+// or "<input arg>", into the node or arg name and the rest.
+std::pair<absl::string_view, absl::string_view> SplitBodyInput(
+    absl::string_view input) {
+  const size_t pos = input.find(':');
+  if (pos == absl::string_view::npos) return {input, ""};
+  return {input.substr(0, pos), input.substr(pos + 1)};
+}
+
+// Returns true if the body node may be computed once for several calls.
+bool CanDedupBodyNode(const NodeDef& node) {
+  if (IsEnter(node) || IsExit(node)) {
+    return false;
+  }
+  if (node.device().find("SPU") != string::npos) {
+    return false;
+  }
+  for (const auto& attr : node.attr()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+  }
+  return IsFreeOfSideEffect(node);
+}
+
+bool FunctionValueNumbering::AddCall(int call_index, FunctionCall* call) {
+  const FunctionDef& function = *call->function;
+  const OpDef& signature = function.signature();
+  if (signature.attr_size() > 0 ||
+      NumNonControlInputs(*call->node) != signature.input_arg_size()) {
+    return false;
+  }
+  absl::flat_hash_map<string, string> graph_tensors;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    const OpDef::ArgDef& arg = signature.input_arg(i);
+    if (arg.type() == DT_INVALID || !arg.number_attr().empty() ||
+        !arg.type_list_attr().empty()) {
+      return false;
+    }
+    const string tensor = ParseTensorName(call->node->input(i)).ToString();
+    graph_tensors[arg.name()] = tensor;
+    graph_tensor_types_[tensor] = arg.type();
+  }
+
+  // Visit the body nodes in topological order.
+  absl::flat_hash_map<absl::string_view, int> node_index;
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    node_index[function.node_def(i).name()] = i;
+  }
+  std::vector<int> num_pending_inputs(function.node_def_size(), 0);
+  std::vector<std::vector<int>> fanouts(function.node_def_size());
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    for (const string& input : function.node_def(i).input()) {
+      absl::string_view name = SplitBodyInput(input).first;
+      absl::ConsumePrefix(&name, "^");
+      auto it = node_index.find(name);
+      if (it == node_index.end()) continue;
+      ++num_pending_inputs[i];
+      fanouts[it->second].push_back(i);
+    }
+  }
+  std::vector<int> ready;
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    if (num_pending_inputs[i] == 0) ready.push_back(i);
+  }
+  while (!ready.empty()) {
+    const int index = ready.back();
+    ready.pop_back();
+    for (int fanout : fanouts[index]) {
+      if (--num_pending_inputs[fanout] == 0) ready.push_back(fanout);
+    }
+
+    const NodeDef& node = function.node_def(index);
+    if (!CanDedupBodyNode(node)) continue;
+    auto canonical = std::make_unique<NodeDef>();
+    canonical->set_name(StrCat(kValuePrefix, values_.size()));
+    canonical->set_op(node.op());
+    canonical->set_device(node.device());
+    *canonical->mutable_attr() = node.attr();
+    bool depends_on_input = false;
+    bool inputs_numbered = true;
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) {
+        inputs_numbered = false;
+        break;
+      }
+      const auto [name, rest] = SplitBodyInput(input);
+      auto tensor = graph_tensors.find(name);
+      if (rest.empty() && tensor != graph_tensors.end()) {
+        canonical->add_input(
+            StrCat(kGraphTensorPrefix, tensor->second));
+        depends_on_input = true;
+        continue;
+      }
+      auto value = call->node_values.find(name);
+      if (value == call->node_values.end()) {
+        inputs_numbered = false;
+        break;
+      }
+      canonical->add_input(
+          StrCat(kValuePrefix, value->second, ":", rest));
+      depends_on_input |= values_[value->second].depends_on_input;
+    }
+    if (!inputs_numbered) continue;
+    if (IsCommutative(*canonical)) {
+      std::sort(canonical->mutable_input()->begin(),
+                canonical->mutable_input()->end());
+    }
+
+    NodeDef* rep = unique_nodes_.FindOrAddRepresentative(canonical.get());
+    int id;
+    if (rep == canonical.get()) {
+      id = values_.size();
+      value_ids_[rep] = id;
+      FunctionValue& value = values_.emplace_back();
+      value.node = std::move(canonical);
+      value.body_name = node.name();
+      value.depends_on_input = depends_on_input;
+    } else {
+      id = value_ids_.at(rep);
+      unique_nodes_.RemoveRepresentative(canonical.get());
+    }
+    values_[id].calls.insert(call_index);
+    call->node_values[node.name()] = id;
+  }
+  return true;
+}
+
+// Returns the value id referred to by the canonical input `input`, or -1 if it
+// refers to a tensor of the graph.
+int CanonicalInputValue(absl::string_view input) {
+  if (!absl::ConsumePrefix(&input, kValuePrefix)) return -1;
+  int id = -1;
+  CHECK(absl::SimpleAtoi(SplitBodyInput(input).first, &id));
+  return id;
+}
+
+// Returns the type of the output "<output>:<index>" of the value.
+Status ValueOutputType(const FunctionValue& value, absl::string_view output,
+                       DataType* type) {
+  const OpDef* op_def = nullptr;
+  TF_RETURN_IF_ERROR(
+      OpRegistry::Global()->LookUpOpDef(value.node->op(), &op_def));
+  NameRangeMap output_ranges;
+  NodeDef node = *value.node;
+  AddDefaultsToNodeDef(*op_def, &node);
+  TF_RETURN_IF_ERROR(NameRangesForNode(node, *op_def, nullptr, &output_ranges));
+  const auto [output_name, index] = SplitBodyInput(output);
+  auto range = output_ranges.find(output_name);
+  int port = 0;
+  if (range == output_ranges.end() ||
+      (!index.empty() && !absl::SimpleAtoi(index, &port))) {
+    return errors::InvalidArgument("Unknown output ", output, " of ",
+                                   value.body_name);
+  }
+  return OutputTypeForNode(node, *op_def, range->second.first + port, type);
+}
+
+// Returns `prefix`, with a suffix if needed to make it unique in `names`, and
+// adds it to `names`.
+string UniqueName(absl::string_view prefix,
+                  absl::flat_hash_set<string>* names) {
+  string name(prefix);
+  for (int i = 1; !names->insert(name).second; ++i) {
+    name = StrCat(prefix, "_", i);
+  }
+  return name;
+}
+
+// Hoists the values that are computed by the bodies of several of the
+// functions called by `call_nodes` into a new function that is called once
+// from `graph`. All the calls must be placed on `device`.
+Status HoistSharedValues(const std::vector<NodeDef*>& call_nodes,
+                         const string& device,
+                         FunctionLibraryDefinition* flib, GraphDef* graph,
+                         bool* changed) {
+  FunctionValueNumbering numbering;
+  std::vector<FunctionCall> calls;
+  for (NodeDef* node : call_nodes) {
+    FunctionCall call{node, flib->Find(node->attr().at("f").func().name())};
+    if (numbering.AddCall(calls.size(), &call)) {
+      calls.push_back(std::move(call));
+    }
+  }
+  const auto is_hoisted = [&](int id) {
+    const FunctionValue& value = numbering.value(id);
+    return value.calls.size() > 1 && value.depends_on_input;
+  };
+  // Returns the value id of the data input of a body node of `call` if it
+  // is hoisted, or -1.
+  const auto hoisted_input = [&](const FunctionCall& call,
+                                 absl::string_view input) {
+    if (IsControlInput(input)) return -1;
+    auto value = call.node_values.find(SplitBodyInput(input).first);
+    if (value == call.node_values.end() || !is_hoisted(value->second)) {
+      return -1;
+    }
+    return value->second;
+  };
+
+  // The outputs of the new function are the hoisted values that are used by
+  // the nodes and outputs of the bodies that stay in the functions.
+  std::map<std::pair<int, string>, int> outputs;
+  std::vector<std::set<std::pair<int, string>>> call_outputs(calls.size());
+  for (size_t i = 0; i < calls.size(); ++i) {
+    const FunctionCall& call = calls[i];
+    const auto add_output = [&](absl::string_view input) {
+      const int id = hoisted_input(call, input);
+      if (id < 0) return;
+      std::pair<int, string> output(id, SplitBodyInput(input).second);
+      outputs.emplace(output, 0);
+      call_outputs[i].insert(std::move(output));
+    };
+    for (const NodeDef& node : call.function->node_def()) {
+      auto value = call.node_values.find(node.name());
+      if (value != call.node_values.end() && is_hoisted(value->second)) {
+        continue;
+      }
+      for (const string& input : node.input()) add_output(input);
+    }
+    for (const auto& ret : call.function->ret()) add_output(ret.second);
+  }
+  if (outputs.empty()) return absl::OkStatus();
+
+  // Collect the values the hoisted outputs depend on. Values are numbered in
+  // topological order.
+  std::set<int> body_values;
+  std::map<string, int> inputs;
+  std::vector<int> to_visit;
+  for (const auto& output : outputs) to_visit.push_back(output.first.first);
+  while (!to_visit.empty()) {
+    const int id = to_visit.back();
+    to_visit.pop_back();
+    if (!body_values.insert(id).second) continue;
+    for (const string& input : numbering.value(id).node->input()) {
+      const int input_id = CanonicalInputValue(input);
+      if (input_id < 0) {
+        inputs.emplace(input.substr(1), 0);
+      } else {
+        to_visit.push_back(input_id);
+      }
+    }
+  }
+  bool has_computation = false;
+  for (int id : body_values) {
+    const NodeDef& node = *numbering.value(id).node;
+    has_computation |= !IsConstant(node) && !IsIdentity(node);
+  }
+  if (!has_computation) return absl::OkStatus();
+
+  // The new function is fed by the inputs of the calls, so the calls must
+  // not feed them.
+  NodeMap node_map(graph);
+  absl::flat_hash_set<const NodeDef*> fanouts;
+  std::vector<const NodeDef*> fanouts_to_visit;
+  for (size_t i = 0; i < calls.size(); ++i) {
+    if (!call_outputs[i].empty()) fanouts_to_visit.push_back(calls[i].node);
+  }
+  while (!fanouts_to_visit.empty()) {
+    const NodeDef* node = fanouts_to_visit.back();
+    fanouts_to_visit.pop_back();
+    for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      if (fanouts.insert(fanout).second) fanouts_to_visit.push_back(fanout);
+    }
+  }
+  for (const auto& input : inputs) {
+    const NodeDef* input_node =
+        node_map.GetNode(string(ParseTensorName(input.first).node()));
+    if (input_node == nullptr || fanouts.contains(input_node)) {
+      VLOG(2) << "Not hoisting the subgraph shared by the calls to "
+              << calls[0].function->signature().name()
+              << " because they feed its input " << input.first;
+      return absl::OkStatus();
+    }
+  }
+
+  // Build the function that computes the hoisted values.
+  FunctionDef shared;
+  OpDef* signature = shared.mutable_signature();
+  string shared_name = "common_subgraph";
+  for (int i = 1; flib->Find(shared_name) != nullptr; ++i) {
+    shared_name = StrCat("common_subgraph_", i);
+  }
+  signature->set_name(shared_name);
+  absl::flat_hash_set<string> body_names;
+  AttrValue input_types;
+  for (auto& input : inputs) {
+    input.second = signature->input_arg_size();
+    OpDef::ArgDef* arg = signature->add_input_arg();
+    arg->set_name(UniqueName(StrCat("input_", input.second), &body_names));
+    arg->set_type(numbering.graph_tensor_type(input.first));
+    input_types.mutable_list()->add_type(arg->type());
+  }
+  absl::flat_hash_map<int, string> value_names;
+  for (int id : body_values) {
+    const FunctionValue& value = numbering.value(id);
+    NodeDef* node = shared.add_node_def();
+    *node = *value.node;
+    node->set_name(UniqueName(value.body_name, &body_names));
+    value_names[id] = node->name();
+    for (string& input : *node->mutable_input()) {
+      const int input_id = CanonicalInputValue(input);
+      if (input_id < 0) {
+        input = signature->input_arg(inputs.at(input.substr(1))).name();
+      } else {
+        input = StrCat(value_names.at(input_id), ":",
+                       SplitBodyInput(input.substr(1)).second);
+      }
+    }
+  }
+  AttrValue output_types;
+  for (auto& output : outputs) {
+    const auto& [id, index] = output.first;
+    DataType type;
+    Status status = ValueOutputType(numbering.value(id), index, &type);
+    if (!status.ok()) {
+      VLOG(2) << "Not hoisting the subgraph shared by the calls to "
+              << calls[0].function->signature().name() << ": " << status;
+      return absl::OkStatus();
+    }
+    output.second = signature->output_arg_size();
+    OpDef::ArgDef* arg = signature->add_output_arg();
+    arg->set_name(StrCat("output_", output.second));
+    arg->set_type(type);
+    output_types.mutable_list()->add_type(type);
+    (*shared.mutable_ret())[arg->name()] =
+        StrCat(value_names.at(id), ":", index);
+  }
+  VLOG(1) << "Hoisting " << body_values.size() << " nodes shared by "
+          << calls.size() << " function calls into " << shared_name;
+
+  NodeDef* shared_call = graph->add_node();
+  string shared_call_name = shared_name;
+  for (int i = 1; node_map.NodeExists(shared_call_name); ++i) {
+    shared_call_name = StrCat(shared_name, "_", i);
+  }
+  shared_call->set_name(shared_call_name);
+  shared_call->set_op("PartitionedCall");
+  shared_call->set_device(device);
+  for (const auto& input : inputs) shared_call->add_input(input.first);
+  (*shared_call->mutable_attr())["Tin"] = input_types;
+  (*shared_call->mutable_attr())["Tout"] = output_types;
+  (*shared_call->mutable_attr())["f"].mutable_func()->set_name(shared_name);
+
+  // Redirect the calls to copies of their functions that take the hoisted
+  // values as inputs, and drop the body nodes that are no longer used.
+  for (size_t i = 0; i < calls.size(); ++i) {
+    if (call_outputs[i].empty()) continue;
+    const FunctionCall& call = calls[i];
+    FunctionDef function = *call.function;
+    string function_name =
+        StrCat(function.signature().name(), "_", shared_name);
+    while (flib->Find(function_name) != nullptr) {
+      function_name = StrCat(function_name, "_");
+    }
+    function.mutable_signature()->set_name(function_name);
+
+    absl::flat_hash_set<string> names;
+    for (const auto& arg : function.signature().input_arg()) {
+      names.insert(arg.name());
+    }
+    for (const NodeDef& node : function.node_def()) names.insert(node.name());
+    absl::flat_hash_map<std::pair<int, string>, string> hoisted_args;
+    std::vector<string> call_inputs;
+    for (const auto& output : call_outputs[i]) {
+      const int index = outputs.at(output);
+      OpDef::ArgDef* arg = function.mutable_signature()->add_input_arg();
+      arg->set_name(UniqueName(StrCat(shared_name, "_", index), &names));
+      arg->set_type(output_types.list().type(index));
+      hoisted_args[output] = arg->name();
+      call_inputs.push_back(index == 0 ? shared_call_name
+                                       : StrCat(shared_call_name, ":", index));
+    }
+    const auto replace_input = [&](string* input) {
+      const int id = hoisted_input(call, *input);
+      if (id < 0) return;
+      *input = hoisted_args.at({id, string(SplitBodyInput(*input).second)});
+    };
+
+    // Body nodes that are used once the hoisted values are replaced by the
+    // new inputs.
+    absl::flat_hash_set<string> used;
+    std::vector<string> used_to_visit;
+    const auto mark_used = [&](absl::string_view input) {
+      absl::string_view name = SplitBodyInput(input).first;
+      absl::ConsumePrefix(&name, "^");
+      if (used.insert(string(name)).second) {
+        used_to_visit.push_back(string(name));
+      }
+    };
+    absl::flat_hash_map<string, NodeDef*> body_nodes;
+    for (NodeDef& node : *function.mutable_node_def()) {
+      body_nodes[node.name()] = &node;
+      if (call.node_values.contains(node.name()) &&
+          is_hoisted(call.node_values.at(node.name()))) {
+        continue;
+      }
+      mark_used(node.name());
+      for (string& input : *node.mutable_input()) replace_input(&input);
+    }
+    for (auto& ret : *function.mutable_ret()) {
+      replace_input(&ret.second);
+      mark_used(ret.second);
+    }
+    for (const auto& control_ret : function.control_ret()) {
+      mark_used(control_ret.second);
+    }
+    while (!used_to_visit.empty()) {
+      const string name = used_to_visit.back();
+      used_to_visit.pop_back();
+      auto node = body_nodes.find(name);
+      if (node == body_nodes.end()) continue;
+      for (const string& input : node->second->input()) mark_used(input);
+    }
+    function.mutable_node_def()->erase(
+        std::remove_if(
+            function.mutable_node_def()->begin(),
+            function.mutable_node_def()->end(),
+            [&](const NodeDef& node) { return !used.contains(node.name()); }),
+        function.mutable_node_def()->end());
+    TF_RETURN_IF_ERROR(flib->AddFunctionDef(function));
+
+    NodeDef* call_node = call.node;
+    (*call_node->mutable_attr())["f"].mutable_func()->set_name(function_name);
+    for (const auto& output : call_outputs[i]) {
+      (*call_node->mutable_attr())["Tin"].mutable_list()->add_type(
+          output_types.list().type(outputs.at(output)));
+    }
+    const int num_inputs = NumNonControlInputs(*call_node);
+    for (const string& input : call_inputs) call_node->add_input(input);
+    std::rotate(call_node->mutable_input()->begin() + num_inputs,
+                call_node->mutable_input()->end() - call_inputs.size(),
+                call_node->mutable_input()->end());
+  }
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(shared));
+  *changed = true;
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+Status CommonSubgraphElimination::HoistSharedFunctionSubgraphs(
+    GraphDef* optimized_graph) {
+  if (optimized_graph->library().function_size() == 0) {
+    return absl::OkStatus();
+  }
+  FunctionLibraryDefinition flib(OpRegistry::Global(),
+                                 optimized_graph->library());
+  FrameView frame_view;
+  if (!frame_view.InferFromGraph(*optimized_graph).ok()) {
+    LOG(WARNING) << "Failed to infer the frames of the graph.";
+    return absl::OkStatus();
+  }
+
+  // Values are only shared by calls placed on the same device.
+  std::map<string, std::vector<NodeDef*>> calls_by_device;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    if (!IsPartitionedCall(node) && !IsStatefulPartitionedCall(node)) {
+      continue;
+    }
+    auto f = node.attr().find("f");
+    if (f == node.attr().end() || f->second.func().attr_size() > 0 ||
+        flib.Find(f->second.func().name()) == nullptr ||
+        frame_view.IsInFrame(node)) {
+      continue;
+    }
+    calls_by_device[node.device()].push_back(&node);
+  }
+
+  bool changed = false;
+  for (const auto& [device, calls] : calls_by_device) {
+    if (calls.size() < 2) continue;
+    TF_RETURN_IF_ERROR(
+        HoistSharedValues(calls, device, &flib, optimized_graph, &changed));
+  }
+  if (changed) {
+    *optimized_graph->mutable_library() = flib.ToProto();
+  }
+  return absl::OkStatus();
+}
+
 Status CommonSubgraphElimination::Optimize(Cluster* /*cluster*/,
                                            const GrapplerItem& item,
                                            GraphDef* optimized_graph) {
@@ -286,7 +830,12 @@ Status CommonSubgraphElimination::Optimize(Cluster* /*cluster*/,
   TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
   GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
-  return DedupComputations(optimized_graph);
+  TF_RETURN_IF_ERROR(DedupComputations(optimized_graph));
+  if (cross_function_) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    TF_RETURN_IF_ERROR(HoistSharedFunctionSubgraphs(optimized_graph));
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace grappler
@@ -37,14 +37,18 @@ class CommonSubgraphElimination : public GraphOptimizer {
  public:
   CommonSubgraphElimination() {}
 
-  explicit CommonSubgraphElimination(RewriterConfig::Toggle opt_level)
-      : opt_level_(opt_level) {}
+  // If `cross_function` is true, pure subgraphs that are repeated in the
+  // bodies of several functions called from the graph are also deduped, see
+  // HoistSharedFunctionSubgraphs.
+  explicit CommonSubgraphElimination(RewriterConfig::Toggle opt_level,
+                                     bool cross_function = false)
+      : opt_level_(opt_level), cross_function_(cross_function) {}
 
   ~CommonSubgraphElimination() override {}
 
   string name() const override { return "common_subgraph_elimination"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  bool UsesFunctionLibrary() const override { return cross_function_; }
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -58,7 +62,16 @@ class CommonSubgraphElimination : public GraphOptimizer {
   // Dedup redundant nodes in the graph.
   Status DedupComputations(GraphDef* optimized_graph);
 
+  // Finds the pure nodes that compute the same values from the same inputs in
+  // the bodies of several functions that are called from the graph, e.g. the
+  // preprocessing repeated in every signature of a SavedModel. The shared
+  // nodes are moved to a new function that is called once from the graph, and
+  // the calls are redirected to copies of their functions that take the
+  // shared values as extra inputs.
+  Status HoistSharedFunctionSubgraphs(GraphDef* optimized_graph);
+
   RewriterConfig::Toggle opt_level_;
+  bool cross_function_ = false;
 
   bool fetch_nodes_known_ = false;
   std::unordered_set<string> nodes_to_preserve_;
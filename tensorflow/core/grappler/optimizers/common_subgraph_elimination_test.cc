@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -48,6 +50,37 @@ void VerifyGraphsMatch(const GraphDef& original_graph,
     }
   }
 }
+
+// Returns a function that returns `op`(2 * x), with the nodes named after
+// `prefix`.
+FunctionDef ScaleAndApply(const string& name, const string& prefix,
+                          const string& op) {
+  return FunctionDefHelper::Create(
+      name, {"x: float"}, {"y: float"}, {},
+      {{{absl::StrCat(prefix, "two")},
+        "Const",
+        {},
+        {{"value", test::AsScalar<float>(2.0f)}, {"dtype", DT_FLOAT}}},
+       {{absl::StrCat(prefix, "scale")},
+        "Mul",
+        {"x", absl::StrCat(prefix, "two:output:0")},
+        {{"T", DT_FLOAT}}},
+       {{absl::StrCat(prefix, "apply")},
+        op,
+        {absl::StrCat(prefix, "scale:z:0")},
+        {{"T", DT_FLOAT}}}},
+      {{"y", absl::StrCat(prefix, "apply:y:0")}});
+}
+
+NodeDef Call(const string& name, const string& input,
+             const string& function) {
+  return test::function::NDef(
+      name, "PartitionedCall", {input},
+      {{"Tin", DataTypeSlice{DT_FLOAT}},
+       {"Tout", DataTypeSlice{DT_FLOAT}},
+       {"f", FunctionDefHelper::FunctionRef(function)}});
+}
+
 }  // namespace
 
 class CommonSubgraphEliminationTest : public ArithmeticOptimizerTest {};
@@ -174,5 +207,76 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(CommonSubgraphEliminationTest, HoistsSubgraphSharedByFunctions) {
+  using test::function::NDef;
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       Call("sqrt", "x", "ScaleAndSqrt"),
+       Call("square", "x", "ScaleAndSquare")},
+      {ScaleAndApply("ScaleAndSqrt", "", "Sqrt"),
+       ScaleAndApply("ScaleAndSquare", "square_", "Square")});
+  item.fetch = {"sqrt", "square"};
+  item.feed.emplace_back("x", test::AsScalar<float>(8.0f));
+
+  CommonSubgraphElimination optimizer(RewriterConfig::ON,
+                                      /*cross_function=*/true);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* shared = node_map.GetNode("common_subgraph");
+  ASSERT_NE(shared, nullptr);
+  EXPECT_EQ(shared->op(), "PartitionedCall");
+  ASSERT_EQ(shared->input_size(), 1);
+  EXPECT_EQ(shared->input(0), "x");
+  for (const string& call : {"sqrt", "square"}) {
+    const NodeDef* node = node_map.GetNode(call);
+    ASSERT_NE(node, nullptr);
+    ASSERT_EQ(node->input_size(), 2);
+    EXPECT_EQ(node->input(0), "x");
+    EXPECT_EQ(node->input(1), "common_subgraph");
+    EXPECT_EQ(node->attr().at("Tin").list().type_size(), 2);
+  }
+
+  FunctionLibraryDefinition flib(OpRegistry::Global(), output.library());
+  const FunctionDef* shared_function = flib.Find("common_subgraph");
+  ASSERT_NE(shared_function, nullptr);
+  EXPECT_EQ(shared_function->node_def_size(), 2);
+  EXPECT_EQ(shared_function->signature().output_arg_size(), 1);
+  const FunctionDef* sqrt_function =
+      flib.Find(node_map.GetNode("sqrt")->attr().at("f").func().name());
+  ASSERT_NE(sqrt_function, nullptr);
+  ASSERT_EQ(sqrt_function->node_def_size(), 1);
+  EXPECT_EQ(sqrt_function->node_def(0).op(), "Sqrt");
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  auto tensors = EvaluateFetchNodes(item.WithGraph(std::move(output)));
+  ASSERT_EQ(tensors.size(), 2);
+  ASSERT_EQ(tensors_expected.size(), 2);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectTensorNear<float>(tensors[1], tensors_expected[1], 1e-6);
+}
+
+TEST_F(CommonSubgraphEliminationTest, KeepsFunctionsWithDifferentInputs) {
+  using test::function::NDef;
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("y", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       Call("sqrt", "x", "ScaleAndSqrt"),
+       Call("square", "y", "ScaleAndSquare")},
+      {ScaleAndApply("ScaleAndSqrt", "", "Sqrt"),
+       ScaleAndApply("ScaleAndSquare", "", "Square")});
+  item.fetch = {"sqrt", "square"};
+
+  CommonSubgraphElimination optimizer(RewriterConfig::ON,
+                                      /*cross_function=*/true);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(output.library().function_size(), 2);
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -17,7 +17,11 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
@@ -49,11 +53,13 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/platform/tensor_coding.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/bcast.h"
 #include "tensorflow/core/util/overflow.h"
@@ -66,6 +72,10 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 // We only fold/materialize constants smaller than 100kB.
 const int64_t kMaxConstantSize = 100 * 1024;
 
+// Folded constants at least this large keep their evaluated tensor around for
+// folding their fanout, since decoding them again is not cheap.
+constexpr int64_t kMinSharedFoldedValueSize = 4 * 1024;
+
 namespace {
 template <typename T>
 bool AllValuesAre(const TensorProto& proto, const T& value) {
@@ -193,21 +203,26 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_emulation)
+                                 bool fold_quantization_emulation,
+                                 int num_threads, int64_t output_budget_bytes)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       disable_compressed_tensor_optimization_(
           disable_compressed_tensor_optimization),
-      fold_quantization_emulation_(fold_quantization_emulation) {
+      fold_quantization_emulation_(fold_quantization_emulation),
+      num_threads_(num_threads),
+      output_budget_bytes_(output_budget_bytes) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
 ConstantFolding::ConstantFolding(DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_ops)
+                                 bool fold_quantization_ops, int num_threads,
+                                 int64_t output_budget_bytes)
     : ConstantFolding(RewriterConfig::ON, cpu_device,
                       disable_compressed_tensor_optimization,
-                      fold_quantization_ops) {}
+                      fold_quantization_ops, num_threads,
+                      output_budget_bytes) {}
 
 // static
 string ConstantFolding::AddControlDependency(const string& input_name,
@@ -1343,7 +1358,8 @@ Status ConstantFolding::EvaluateNode(const NodeDef& node,
 
 Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
                                             std::vector<NodeDef>* outputs,
-                                            bool* result_too_large) {
+                                            bool* result_too_large,
+                                            std::vector<Tensor>* values) {
   TensorVector inputs;
   TensorVector output_tensors;
   auto inputs_cleanup = gtl::MakeCleanup([&inputs, &output_tensors] {
@@ -1370,6 +1386,12 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
                     strings::StrCat("Can't fold ", node.name(), ", its ", input,
                                     " isn't constant"));
     }
+    auto folded_value = folded_values_.find(input_node->name());
+    if (folded_value != folded_values_.end()) {
+      inputs.emplace_back(new Tensor(folded_value->second));
+      total_inputs_size += folded_value->second.TotalBytes();
+      continue;
+    }
     TF_RETURN_IF_ERROR(CheckAttrExists(*input_node, "value"));
     const TensorProto& raw_val = input_node->attr().at("value").tensor();
     if (raw_val.dtype() == DT_INVALID) {
@@ -1402,6 +1424,9 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
   }
 
   outputs->resize(output_tensors.size());
+  if (values != nullptr) {
+    values->assign(output_tensors.size(), Tensor());
+  }
   for (size_t i = 0; i < output_tensors.size(); i++) {
     string node_name = OptimizedNodeName(node, "-folded");
     if (output_tensors.size() > 1) {
@@ -1414,6 +1439,9 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
         *result_too_large = true;
         return s;
       }
+      if (values != nullptr) {
+        values->at(i) = *output_tensors[i].tensor;
+      }
     } else {
       // Create an empty NodeDef to identify dead outputs (e.g. the output of a
       // switch that's not selected by the switch predicate).
@@ -1515,16 +1543,28 @@ Status ConstantFolding::FoldMergeNode(NodeDef* node, GraphDef* output_graph) {
   return absl::OkStatus();
 }
 
-Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
+Status ConstantFolding::FoldNode(NodeDef* node,
+                                 std::vector<NodeDef>* const_nodes_ptr,
+                                 const std::vector<Tensor>& values,
+                                 GraphDef* output_graph,
                                  bool* result_too_large) {
-  *result_too_large = false;
-  if (IsMerge(*node)) {
-    return FoldMergeNode(node, output_graph);
+  std::vector<NodeDef>& const_nodes = *const_nodes_ptr;
+  if (output_budget_bytes_ > 0) {
+    int64_t bytes = 0;
+    for (const NodeDef& const_node : const_nodes) {
+      if (const_node.name().empty()) continue;
+      bytes += const_node.attr().at("value").tensor().ByteSizeLong();
+    }
+    if (folded_bytes_ + bytes > output_budget_bytes_) {
+      *result_too_large = true;
+      return errors::ResourceExhausted(
+          "Folding ", node->name(), " into ", bytes,
+          " bytes of constants exceeds the constant folding budget of ",
+          output_budget_bytes_, " bytes, of which ", folded_bytes_,
+          " are used.");
+    }
+    folded_bytes_ += bytes;
   }
-
-  std::vector<NodeDef> const_nodes;
-  TF_RETURN_IF_ERROR(
-      EvaluateOneFoldable(*node, &const_nodes, result_too_large));
   VLOG(2) << "Folded node: " << SummarizeNodeDef(*node);
 
   NodeDef* constant_output = nullptr;
@@ -1638,6 +1678,17 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
       node->clear_input();
     }
   }
+
+  for (int i = 0, end = std::min(const_nodes.size(), values.size()); i < end;
+       i++) {
+    if (const_nodes[i].name().empty() ||
+        values[i].TotalBytes() < kMinSharedFoldedValueSize) {
+      continue;
+    }
+    const string& name =
+        const_nodes.size() == 1 ? node->name() : const_nodes[i].name();
+    folded_values_[name] = values[i];
+  }
   return absl::OkStatus();
 }
 
@@ -1655,30 +1706,86 @@ Status ConstantFolding::FoldGraph(
       queue.push_back(graph_->mutable_node(i));
     }
   }
+  std::unique_ptr<thread::ThreadPool> pool;
+  if (num_threads_ > 1) {
+    pool = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "constant_folding", num_threads_);
+  }
+  folded_values_.clear();
+  auto folded_values_cleanup =
+      gtl::MakeCleanup([this] { folded_values_.clear(); });
+  struct FoldedNode {
+    NodeDef* node;
+    Status status;
+    bool result_too_large = false;
+    std::vector<NodeDef> const_nodes;
+    std::vector<Tensor> values;
+  };
   while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
+    // All the nodes in the queue only have constant inputs, so none of them
+    // depends on the folding of another. They are evaluated together, in
+    // parallel if there are threads to spare, and then folded in queue order,
+    // which keeps the output deterministic.
+    std::vector<FoldedNode> folded_nodes;
+    absl::flat_hash_set<string> queued_nodes;
+    for (NodeDef* node : queue) {
+      if (!processed_nodes.count(node->name()) &&
+          queued_nodes.insert(node->name()).second) {
+        folded_nodes.push_back({node});
+      }
     }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    std::vector<NodeDef*> fanout =
-        node_map_->GetOutputsOrderedByNodeName(node->name());
-    bool result_too_large = false;
-    Status s = FoldNode(node, optimized_graph, &result_too_large);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
-      if (result_too_large) {
-        nodes_to_not_simplify->emplace(node->name());
+    queue.clear();
+    const auto evaluate = [this](FoldedNode* folded) {
+      folded->status =
+          EvaluateOneFoldable(*folded->node, &folded->const_nodes,
+                              &folded->result_too_large, &folded->values);
+    };
+    if (pool != nullptr && folded_nodes.size() > 1) {
+      BlockingCounter counter(folded_nodes.size());
+      for (FoldedNode& folded : folded_nodes) {
+        if (IsMerge(*folded.node)) {
+          counter.DecrementCount();
+          continue;
+        }
+        pool->Schedule([&evaluate, &counter, folded = &folded] {
+          evaluate(folded);
+          counter.DecrementCount();
+        });
       }
+      counter.Wait();
     } else {
-      for (auto& fanout_node : fanout) {
-        if (IsFoldable(*fanout_node, &properties) &&
-            !nodes_to_not_simplify->count(fanout_node->name())) {
-          queue.push_back(fanout_node);
+      for (FoldedNode& folded : folded_nodes) {
+        if (!IsMerge(*folded.node)) evaluate(&folded);
+      }
+    }
+
+    for (FoldedNode& folded : folded_nodes) {
+      NodeDef* node = folded.node;
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted
+      // deterministically.
+      std::vector<NodeDef*> fanout =
+          node_map_->GetOutputsOrderedByNodeName(node->name());
+      Status s = folded.status;
+      if (IsMerge(*node)) {
+        s = FoldMergeNode(node, optimized_graph);
+      } else if (s.ok()) {
+        s = FoldNode(node, &folded.const_nodes, folded.values, optimized_graph,
+                     &folded.result_too_large);
+      }
+      processed_nodes.insert(node->name());
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+        if (folded.result_too_large) {
+          nodes_to_not_simplify->emplace(node->name());
+        }
+      } else {
+        for (auto& fanout_node : fanout) {
+          if (IsFoldable(*fanout_node, &properties) &&
+              !nodes_to_not_simplify->count(fanout_node->name())) {
+            queue.push_back(fanout_node);
+          }
         }
       }
     }
@@ -4082,6 +4189,7 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   has_fetch_ = !item.fetch.empty();
+  folded_bytes_ = 0;
   GrapplerItem item_to_optimize = item;
   GraphProperties properties(item_to_optimize);
   // It's possible to feed a placeholder with a tensor of any shape: make sure
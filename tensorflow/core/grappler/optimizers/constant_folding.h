@@ -16,12 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_CONSTANT_FOLDING_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_CONSTANT_FOLDING_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
@@ -45,12 +49,19 @@ class ConstantFolding : public GraphOptimizer {
   static string AddControlDependency(const string& input_name, GraphDef* graph,
                                      NodeMap* node_map);
 
+  // Nodes whose inputs are all constant are evaluated on `num_threads`
+  // threads, or sequentially if `num_threads` is 0 or 1. If
+  // `output_budget_bytes` is positive, nodes are left unfolded once the
+  // constants added to the graph reach that size.
   explicit ConstantFolding(DeviceBase* cpu_device,
                            bool disable_compressed_tensor_optimization = false,
-                           bool fold_quantization_emulation = true);
+                           bool fold_quantization_emulation = true,
+                           int num_threads = 0,
+                           int64_t output_budget_bytes = 0);
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
                   bool disable_compressed_tensor_optimization = false,
-                  bool fold_quantization_emulation = true);
+                  bool fold_quantization_emulation = true,
+                  int num_threads = 0, int64_t output_budget_bytes = 0);
 
   ~ConstantFolding() override {}
 
@@ -92,11 +103,18 @@ class ConstantFolding : public GraphOptimizer {
                       const gtl::InlinedVector<TensorValue, 4>& inputs,
                       gtl::InlinedVector<TensorValue, 4>* output) const;
 
+  // Evaluates `node` into the constants in `outputs`. If `values` is not
+  // null, it is set to the values of the constants, which share the buffers
+  // of the evaluated tensors.
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
-                             bool* result_too_large);
+                             bool* result_too_large,
+                             std::vector<Tensor>* values = nullptr);
 
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
-  Status FoldNode(NodeDef* node, GraphDef* output_graph,
+  // Replaces `node` with `const_nodes`, the constants it was evaluated into,
+  // whose values are `values`.
+  Status FoldNode(NodeDef* node, std::vector<NodeDef>* const_nodes,
+                  const std::vector<Tensor>& values, GraphDef* output_graph,
                   bool* result_too_large);
 
   bool IsOnes(const NodeDef& node) const;
@@ -335,11 +353,19 @@ class ConstantFolding : public GraphOptimizer {
   absl::flat_hash_set<string> nodes_allowlist_;
   absl::flat_hash_set<string> feed_nodes_;
   absl::flat_hash_map<string, bool> maybe_foldable_nodes_;
+  // The values of the large constants folded by FoldGraph, keyed by node
+  // name, so that folding their fanout reuses the tensor buffers instead of
+  // decoding the constants again.
+  absl::flat_hash_map<string, Tensor> folded_values_;
+  // Total size of the constants folded into the graph being optimized.
+  int64_t folded_bytes_ = 0;
   bool has_fetch_;
   bool graph_modified_;
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
   bool fold_quantization_emulation_;
+  int num_threads_;
+  int64_t output_budget_bytes_;
 };
 
 }  // end namespace grappler
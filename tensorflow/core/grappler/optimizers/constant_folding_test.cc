@@ -315,6 +315,92 @@ TEST_F(ConstantFoldingTest, SimpleFolding) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, ParallelFolding) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Independent chains of large foldable nodes, so that each wave of the
+  // folding evaluates several nodes whose inputs reuse the values of folded
+  // constants.
+  std::vector<string> fetch;
+  for (int i = 0; i < 4; ++i) {
+    const string suffix = strings::StrCat(i);
+    Output a = ops::Const(s.WithOpName("a" + suffix), static_cast<float>(i),
+                          {4096});
+    Output b = ops::AddN(s.WithOpName("b" + suffix), {a, a});
+    Output c = ops::AddN(s.WithOpName("c" + suffix), {a, b});
+    Output d = ops::AddN(s.WithOpName("d" + suffix), {b, c});
+    fetch.push_back("d" + suffix);
+  }
+
+  GrapplerItem item;
+  item.fetch = fetch;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ConstantFolding sequential_optimizer(/*cpu_device=*/nullptr);
+  GraphDef sequential_output;
+  TF_EXPECT_OK(sequential_optimizer.Optimize(/*cluster=*/nullptr, item,
+                                             &sequential_output));
+
+  ConstantFolding parallel_optimizer(
+      /*cpu_device=*/nullptr, /*disable_compressed_tensor_optimization=*/false,
+      /*fold_quantization_emulation=*/true, /*num_threads=*/4);
+  GraphDef parallel_output;
+  TF_EXPECT_OK(parallel_optimizer.Optimize(/*cluster=*/nullptr, item,
+                                           &parallel_output));
+
+  EXPECT_EQ(4, parallel_output.node_size());
+  for (const NodeDef& node : parallel_output.node()) {
+    EXPECT_EQ("Const", node.op());
+  }
+  CompareGraphs(sequential_output, parallel_output);
+
+  auto tensors_expected = EvaluateNodes(item.graph, fetch);
+  auto tensors = EvaluateNodes(parallel_output, fetch);
+  ASSERT_EQ(fetch.size(), tensors_expected.size());
+  ASSERT_EQ(fetch.size(), tensors.size());
+  for (size_t i = 0; i < fetch.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
+TEST_F(ConstantFoldingTest, OutputBudget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {1});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {1});
+  Output c = ops::AddN(s.WithOpName("c"), {a, b});
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output d = ops::AddN(s.WithOpName("d"), {c, x});
+
+  GrapplerItem item;
+  item.fetch.push_back("d");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // The constant that "c" folds into is larger than the budget.
+  ConstantFolding optimizer(
+      /*cpu_device=*/nullptr, /*disable_compressed_tensor_optimization=*/false,
+      /*fold_quantization_emulation=*/true, /*num_threads=*/0,
+      /*output_budget_bytes=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  bool found_c = false;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "c") {
+      found_c = true;
+      EXPECT_EQ("AddN", node.op());
+    }
+  }
+  EXPECT_TRUE(found_c);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>(TensorShape({1}));
+  auto tensors_expected = EvaluateNodes(item.graph, {"d"}, {{"x", x_t}});
+  auto tensors = EvaluateNodes(output, {"d"}, {{"x", x_t}});
+  ASSERT_EQ(1, tensors_expected.size());
+  ASSERT_EQ(1, tensors.size());
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 TEST_F(ConstantFoldingTest, AddTree) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
@@ -0,0 +1,343 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/parse_and_batch_fusion.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kFusedOpName[] = "ParseExampleDatasetV2";
+constexpr char kParseExampleV2[] = "ParseExampleV2";
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+
+// The inputs of `ParseExampleV2`.
+constexpr int kSerializedInput = 0;
+constexpr int kNamesInput = 1;
+constexpr int kSparseKeysInput = 2;
+constexpr int kDenseKeysInput = 3;
+constexpr int kRaggedKeysInput = 4;
+constexpr int kDenseDefaultsInput = 5;
+
+// The parse of dense features that a map function consists of.
+struct DenseParse {
+  // The `ParseExampleV2` node in the function body.
+  const NodeDef* parse_node = nullptr;
+  std::vector<string> dense_keys;
+  // The `Const` nodes in the function body that hold the default values.
+  std::vector<const NodeDef*> dense_defaults;
+};
+
+// Returns the values of the string `Const` node `node`, if it is one.
+bool GetStringConstValues(const NodeDef& node, std::vector<string>* values) {
+  if (node.op() != "Const" || !node.attr().contains("value")) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.dtype() != DT_STRING || tensor.dims() > 1) {
+    return false;
+  }
+  values->clear();
+  for (const tstring& value : tensor.flat<tstring>()) {
+    values->push_back(value);
+  }
+  return true;
+}
+
+// Indexes the body of a function, and follows references to tensors in it
+// through `Identity` nodes.
+class FunctionBodyIndex {
+ public:
+  explicit FunctionBodyIndex(const FunctionDef& function) {
+    for (const NodeDef& node : function.node_def()) {
+      nodes_[node.name()] = &node;
+    }
+  }
+
+  // Returns the node that the tensor reference `input` is produced by, after
+  // following `Identity` nodes, and the output name and index of the tensor
+  // in `output`. Returns nullptr if `input` refers to a function argument or
+  // a control input.
+  const NodeDef* Resolve(string input, string* output) const {
+    while (true) {
+      if (absl::StartsWith(input, "^")) return nullptr;
+      std::vector<string> parts = absl::StrSplit(input, ':');
+      auto it = nodes_.find(parts[0]);
+      if (it == nodes_.end()) {
+        *output = input;
+        return nullptr;
+      }
+      const NodeDef* node = it->second;
+      if (node->op() != "Identity" || node->input_size() != 1) {
+        *output = parts.size() == 3 ? absl::StrCat(parts[1], ":", parts[2])
+                                    : "output:0";
+        return node;
+      }
+      input = node->input(0);
+    }
+  }
+
+ private:
+  absl::flat_hash_map<string, const NodeDef*> nodes_;
+};
+
+// Checks whether `function` does nothing but parse its only argument, a
+// serialized `Example`, into dense features of fully defined shapes, and
+// returns those features in the order of their keys. That order is the order
+// in which `ParseExampleDatasetV2` returns the features.
+bool GetDenseParse(const FunctionDef& function, DenseParse* parse) {
+  const OpDef& signature = function.signature();
+  if (signature.input_arg_size() != 1 ||
+      signature.input_arg(0).type() != DT_STRING ||
+      signature.output_arg_size() == 0 || !function.control_ret().empty()) {
+    return false;
+  }
+  FunctionBodyIndex body(function);
+  for (const NodeDef& node : function.node_def()) {
+    if (node.op() == kParseExampleV2) {
+      if (parse->parse_node != nullptr) return false;
+      parse->parse_node = &node;
+    } else if (node.op() != "Const" && node.op() != "Identity") {
+      return false;
+    }
+    for (const string& input : node.input()) {
+      if (absl::StartsWith(input, "^")) return false;
+    }
+  }
+  const NodeDef* parse_node = parse->parse_node;
+  if (parse_node == nullptr) return false;
+
+  int64_t num_sparse;
+  std::vector<DataType> ragged_value_types;
+  std::vector<PartialTensorShape> dense_shapes;
+  if (!TryGetNodeAttr(*parse_node, "num_sparse", &num_sparse) ||
+      num_sparse != 0 ||
+      !TryGetNodeAttr(*parse_node, "ragged_value_types",
+                      &ragged_value_types) ||
+      !ragged_value_types.empty() ||
+      !GetNodeAttr(*parse_node, "dense_shapes", &dense_shapes).ok()) {
+    return false;
+  }
+  // A variable-length dense feature would be padded to the longest example
+  // of the batch, which batching the parsed examples does not do.
+  for (const PartialTensorShape& shape : dense_shapes) {
+    if (!shape.IsFullyDefined()) return false;
+  }
+  const int num_dense = dense_shapes.size();
+  if (parse_node->input_size() != kDenseDefaultsInput + num_dense) {
+    return false;
+  }
+
+  string output;
+  if (body.Resolve(parse_node->input(kSerializedInput), &output) != nullptr ||
+      output != signature.input_arg(0).name()) {
+    return false;
+  }
+  std::vector<string> values;
+  for (int input : {kNamesInput, kSparseKeysInput, kRaggedKeysInput}) {
+    const NodeDef* node = body.Resolve(parse_node->input(input), &output);
+    if (node == nullptr || !GetStringConstValues(*node, &values) ||
+        !values.empty()) {
+      return false;
+    }
+  }
+  const NodeDef* dense_keys_node =
+      body.Resolve(parse_node->input(kDenseKeysInput), &output);
+  std::vector<string> dense_keys;
+  if (dense_keys_node == nullptr ||
+      !GetStringConstValues(*dense_keys_node, &dense_keys) ||
+      dense_keys.size() != static_cast<size_t>(num_dense)) {
+    return false;
+  }
+  parse->dense_defaults.clear();
+  for (int i = 0; i < num_dense; ++i) {
+    const NodeDef* node =
+        body.Resolve(parse_node->input(kDenseDefaultsInput + i), &output);
+    if (node == nullptr || node->op() != "Const") return false;
+    parse->dense_defaults.push_back(node);
+  }
+
+  // Each output of the function must be a parsed feature, in key order.
+  if (signature.output_arg_size() != num_dense) return false;
+  parse->dense_keys.clear();
+  for (const OpDef::ArgDef& output_arg : signature.output_arg()) {
+    auto it = function.ret().find(output_arg.name());
+    if (it == function.ret().end()) return false;
+    const NodeDef* node = body.Resolve(it->second, &output);
+    if (node != parse_node || !absl::StartsWith(output, "dense_values:")) {
+      return false;
+    }
+    int index;
+    if (!absl::SimpleAtoi(output.substr(strlen("dense_values:")), &index) ||
+        index < 0 || index >= num_dense) {
+      return false;
+    }
+    if (!parse->dense_keys.empty() &&
+        parse->dense_keys.back() >= dense_keys[index]) {
+      return false;
+    }
+    parse->dense_keys.push_back(dense_keys[index]);
+  }
+  return true;
+}
+
+NodeDef MakeStringBatchNode(const NodeDef& map_node, const NodeDef& batch_node,
+                            MutableGraphView* graph) {
+  NodeDef new_node = batch_node;
+  graph_utils::SetUniqueGraphNodeName(batch_node.op(), graph->graph(),
+                                      &new_node);
+  new_node.set_input(0, map_node.input(0));
+
+  // The batch now holds the serialized examples, with the batch dimension of
+  // the original outputs.
+  TensorShapeProto shape;
+  shape.add_dim()->set_size(-1);
+  const auto& output_shapes = batch_node.attr().at("output_shapes").list();
+  if (output_shapes.shape_size() > 0 &&
+      output_shapes.shape(0).dim_size() > 0) {
+    shape.mutable_dim(0)->set_size(output_shapes.shape(0).dim(0).size());
+  }
+  (*new_node.mutable_attr())["output_shapes"].mutable_list()->Clear();
+  *(*new_node.mutable_attr())["output_shapes"].mutable_list()->add_shape() =
+      shape;
+  (*new_node.mutable_attr())["output_types"].mutable_list()->Clear();
+  (*new_node.mutable_attr())["output_types"].mutable_list()->add_type(
+      DT_STRING);
+  return new_node;
+}
+
+NodeDef MakeParseExampleNode(const NodeDef& map_node, const NodeDef& batch_node,
+                             const DenseParse& parse,
+                             const NodeDef& string_batch_node,
+                             MutableGraphView* graph) {
+  NodeDef new_node;
+  new_node.set_op(kFusedOpName);
+  graph_utils::SetUniqueGraphNodeName(kFusedOpName, graph->graph(), &new_node);
+
+  // Set the `input_dataset` input argument.
+  new_node.add_input(string_batch_node.name());
+
+  // Set the `num_parallel_calls` input argument.
+  if (map_node.op() == kParallelMapDatasetV2) {
+    new_node.add_input(map_node.input(map_node.input_size() - 1));
+  } else {
+    NodeDef* tmp = graph_utils::AddScalarConstNode<int64_t>(1, graph);
+    new_node.add_input(tmp->name());
+  }
+
+  // Set the `dense_defaults` input arguments, copying them from the function
+  // body into the graph.
+  for (const NodeDef* dense_default : parse.dense_defaults) {
+    NodeDef node = *dense_default;
+    node.clear_device();
+    graph_utils::SetUniqueGraphNodeName("dense_default", graph->graph(), &node);
+    new_node.add_input(graph->AddNode(std::move(node))->name());
+  }
+
+  // Required attributes.
+  AddNodeAttr("sparse_keys", absl::Span<const string>{}, &new_node);
+  AddNodeAttr("dense_keys", parse.dense_keys, &new_node);
+  AddNodeAttr("sparse_types", absl::Span<const DataType>{}, &new_node);
+  graph_utils::CopyAttribute("Tdense", *parse.parse_node, &new_node);
+  graph_utils::CopyAttribute("dense_shapes", *parse.parse_node, &new_node);
+  graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_node);
+
+  // Optional attributes.
+  if (gtl::FindOrNull(map_node.attr(), "deterministic")) {
+    graph_utils::CopyAttribute("deterministic", map_node, &new_node);
+  }
+  graph_utils::MaybeSetFusedMetadata(map_node, batch_node, &new_node);
+  return new_node;
+}
+
+}  // namespace
+
+Status ParseAndBatchFusion::OptimizeAndCollectStats(Cluster* cluster,
+                                                    const GrapplerItem& item,
+                                                    GraphDef* output,
+                                                    OptimizationStats* stats) {
+  *output = item.graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != "BatchDataset" && node.op() != "BatchDatasetV2") {
+      continue;
+    }
+
+    // Use a more descriptive variable name now that we know the node type.
+    const NodeDef& batch_node = node;
+    NodeDef* map_node = graph_utils::GetInputNode(batch_node, graph);
+
+    // The map may not capture any inputs, and its output must only be batched.
+    const int num_map_inputs = map_node->op() == kMapDataset ? 1 : 2;
+    if ((map_node->op() != kMapDataset &&
+         map_node->op() != kParallelMapDatasetV2) ||
+        map_node->input_size() != num_map_inputs ||
+        graph.NumFanouts(*map_node, /*include_controlled_nodes=*/true) != 1) {
+      continue;
+    }
+    const FunctionDef* function =
+        function_library.Find(map_node->attr().at("f").func().name());
+    DenseParse parse;
+    if (function == nullptr || !GetDenseParse(*function, &parse)) continue;
+
+    NodeDef* string_batch_node =
+        graph.AddNode(MakeStringBatchNode(*map_node, batch_node, &graph));
+    NodeDef* parse_node = graph.AddNode(MakeParseExampleNode(
+        *map_node, batch_node, parse, *string_batch_node, &graph));
+    TF_RETURN_IF_ERROR(
+        graph.UpdateFanouts(batch_node.name(), parse_node->name()));
+
+    // Mark the `Map` and `Batch` nodes for removal.
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(ParseAndBatchFusion, "parse_and_batch_fusion");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,181 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/parse_and_batch_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+using FDH = FunctionDefHelper;
+
+constexpr char kParseFunctionName[] = "ParseSingleExample";
+
+// Returns a function that parses a serialized example into a float feature
+// "a" of shape `a_shape` and a scalar int64 feature "b", and returns them in
+// key order unless `swap_outputs`.
+FunctionDef ParseSingleExample(const PartialTensorShape& a_shape,
+                               bool swap_outputs) {
+  return FDH::Create(
+      kParseFunctionName, {"serialized: string"},
+      swap_outputs ? std::vector<string>{"b: int64", "a: float"}
+                   : std::vector<string>{"a: float", "b: int64"},
+      {},
+      {{{"empty"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<tstring>({}, TensorShape({0}))},
+         {"dtype", DT_STRING}}},
+       {{"dense_keys"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<tstring>({"a", "b"})},
+         {"dtype", DT_STRING}}},
+       {{"default_a"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<float>({0.0f})}, {"dtype", DT_FLOAT}}},
+       {{"default_b"},
+        "Const",
+        {},
+        {{"value", test::AsScalar<int64_t>(0)}, {"dtype", DT_INT64}}},
+       {{"parse"},
+        "ParseExampleV2",
+        {"serialized", "empty:output:0", "empty:output:0",
+         "dense_keys:output:0", "empty:output:0", "default_a:output:0",
+         "default_b:output:0"},
+        {{"Tdense", DataTypeSlice{DT_FLOAT, DT_INT64}},
+         {"num_sparse", 0},
+         {"sparse_types", DataTypeSlice{}},
+         {"ragged_value_types", DataTypeSlice{}},
+         {"ragged_split_types", DataTypeSlice{}},
+         {"dense_shapes",
+          std::vector<PartialTensorShape>{a_shape, TensorShape({})}}}}},
+      {{"a", "parse:dense_values:0"}, {"b", "parse:dense_values:1"}});
+}
+
+GrapplerItem MakeItem(const FunctionDef& function) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"}, {}),
+       graph_tests_utils::MakeMapNode("map", "range",
+                                      function.signature().name()),
+       NDef("batch_size", "Const", {}, {{"value", 32}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", true}, {"dtype", DT_BOOL}}),
+       NDef("batch", "BatchDatasetV2",
+            {"map", "batch_size", "drop_remainder"},
+            {{"parallel_copy", false},
+             {"output_shapes",
+              std::vector<PartialTensorShape>{TensorShape({32, 1}),
+                                              TensorShape({32})}},
+             {"output_types", DataTypeSlice{DT_FLOAT, DT_INT64}}}),
+       NDef("Sink", "Identity", {"batch"}, {})},
+      {function});
+  item.fetch.push_back("Sink");
+  return item;
+}
+
+TEST(ParseAndBatchFusionTest, FusesParseAndBatch) {
+  GrapplerItem item = MakeItem(
+      ParseSingleExample(TensorShape({1}), /*swap_outputs=*/false));
+  ParseAndBatchFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  ASSERT_TRUE(
+      graph_utils::ContainsNodeWithOp("ParseExampleDatasetV2", output));
+  const NodeDef& parse_node = output.node(
+      graph_utils::FindGraphNodeWithOp("ParseExampleDatasetV2", output));
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithName(parse_node.input(0), output));
+  EXPECT_EQ(batch_node.op(), "BatchDatasetV2");
+  EXPECT_EQ(batch_node.input(0), "range");
+  EXPECT_EQ(batch_node.input(1), "batch_size");
+  EXPECT_EQ(batch_node.input(2), "drop_remainder");
+  EXPECT_EQ(batch_node.attr().at("output_types").list().type(0), DT_STRING);
+  EXPECT_EQ(batch_node.attr().at("output_shapes").list().shape(0).dim(0).size(),
+            32);
+
+  // The input dataset, `num_parallel_calls` and the two dense defaults.
+  ASSERT_EQ(parse_node.input_size(), 4);
+  const NodeDef& default_a = output.node(
+      graph_utils::FindGraphNodeWithName(parse_node.input(2), output));
+  EXPECT_EQ(default_a.op(), "Const");
+  EXPECT_EQ(default_a.attr().at("dtype").type(), DT_FLOAT);
+  const auto& dense_keys = parse_node.attr().at("dense_keys").list();
+  ASSERT_EQ(dense_keys.s_size(), 2);
+  EXPECT_EQ(dense_keys.s(0), "a");
+  EXPECT_EQ(dense_keys.s(1), "b");
+  EXPECT_EQ(parse_node.attr().at("sparse_keys").list().s_size(), 0);
+  EXPECT_EQ(parse_node.attr().at("Tdense").list().type_size(), 2);
+  EXPECT_EQ(parse_node.attr().at("output_types").list().type(1), DT_INT64);
+  const NodeDef& sink_node =
+      output.node(graph_utils::FindGraphNodeWithName("Sink", output));
+  EXPECT_EQ(sink_node.input(0), parse_node.name());
+}
+
+TEST(ParseAndBatchFusionTest, DoesNotFuseOutputsOutOfKeyOrder) {
+  GrapplerItem item =
+      MakeItem(ParseSingleExample(TensorShape({1}), /*swap_outputs=*/true));
+  ParseAndBatchFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(ParseAndBatchFusionTest, DoesNotFuseVariableLengthFeatures) {
+  GrapplerItem item = MakeItem(
+      ParseSingleExample(PartialTensorShape({-1}), /*swap_outputs=*/false));
+  ParseAndBatchFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(
+      graph_utils::ContainsNodeWithOp("ParseExampleDatasetV2", output));
+}
+
+TEST(ParseAndBatchFusionTest, DoesNotFuseOtherFunctions) {
+  GrapplerItem item = MakeItem(test::function::XTimesTwo());
+  ParseAndBatchFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -33,8 +33,10 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 // be used to evaluate nodes with a large degree of intra-op parallelism.
 const int kDeviceSimpleThreads = 2;
 
-DeviceSimple::DeviceSimple() : DeviceBase(Env::Default()) {
-  eigen_worker_threads_.num_threads = kDeviceSimpleThreads;
+DeviceSimple::DeviceSimple() : DeviceSimple(kDeviceSimpleThreads) {}
+
+DeviceSimple::DeviceSimple(int num_threads) : DeviceBase(Env::Default()) {
+  eigen_worker_threads_.num_threads = num_threads;
   eigen_worker_threads_.workers = new thread::ThreadPool(
       Env::Default(), "evaluation_utils", eigen_worker_threads_.num_threads);
   eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -36,6 +36,8 @@ namespace grappler {
 class DeviceSimple : public DeviceBase {
  public:
   DeviceSimple();
+  // Runs the kernels on a thread pool of `num_threads` threads.
+  explicit DeviceSimple(int num_threads);
   ~DeviceSimple();
 
   Status MakeTensorFromProto(const TensorProto& tensor_proto,
@@ -0,0 +1,88 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/function_optimization_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace grappler {
+
+/* static */
+FunctionOptimizationCache& FunctionOptimizationCache::Global() {
+  static FunctionOptimizationCache* cache =
+      new FunctionOptimizationCache(kDefaultCapacityBytes);
+  return *cache;
+}
+
+FunctionOptimizationCache::FunctionOptimizationCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+std::shared_ptr<const FunctionOptimizationCache::Entry>
+FunctionOptimizationCache::Lookup(const std::string& name,
+                                  uint64_t fingerprint) const {
+  mutex_lock l(mu_);
+  auto it = entries_.find(Key(name, fingerprint));
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  return it->second.entry;
+}
+
+void FunctionOptimizationCache::Insert(const std::string& name,
+                                       uint64_t fingerprint, Entry entry) {
+  size_t entry_size_bytes = entry.optimized_function.ByteSizeLong();
+  for (const FunctionDef& function : entry.added_functions) {
+    entry_size_bytes += function.ByteSizeLong();
+  }
+  if (entry_size_bytes > capacity_bytes_) {
+    return;
+  }
+  Key key(name, fingerprint);
+  mutex_lock l(mu_);
+  if (entries_.contains(key)) {
+    return;
+  }
+  while (size_bytes_ + entry_size_bytes > capacity_bytes_) {
+    auto it = entries_.find(insertion_order_.front());
+    size_bytes_ -= it->second.size_bytes;
+    entries_.erase(it);
+    insertion_order_.pop_front();
+  }
+  entries_[key] = {std::make_shared<const Entry>(std::move(entry)),
+                   entry_size_bytes};
+  insertion_order_.push_back(std::move(key));
+  size_bytes_ += entry_size_bytes;
+}
+
+size_t FunctionOptimizationCache::num_entries() const {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+size_t FunctionOptimizationCache::size_bytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
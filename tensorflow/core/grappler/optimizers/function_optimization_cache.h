@@ -0,0 +1,104 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZATION_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZATION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A cache of the functions optimized by the meta optimizer, which lets graphs
+// that are optimized again, e.g. when a model is reloaded, skip the
+// optimization of their unchanged functions.
+//
+// Entries are keyed by the name of the function and a fingerprint of
+// everything its optimization depends on: its body, the functions it may
+// call, and the optimization config. The oldest entries are evicted when the
+// cache grows beyond its capacity.
+//
+// This class is thread-safe.
+class FunctionOptimizationCache {
+ public:
+  struct Entry {
+    // The optimized function.
+    FunctionDef optimized_function;
+    // The functions the optimization added to the library, such as
+    // specializations of the functions it calls.
+    std::vector<FunctionDef> added_functions;
+  };
+
+  // The capacity of the process-wide cache.
+  static constexpr size_t kDefaultCapacityBytes = 256 << 20;
+
+  // Returns the process-wide cache.
+  static FunctionOptimizationCache& Global();
+
+  explicit FunctionOptimizationCache(size_t capacity_bytes);
+
+  FunctionOptimizationCache(const FunctionOptimizationCache&) = delete;
+  FunctionOptimizationCache& operator=(const FunctionOptimizationCache&) =
+      delete;
+
+  // Returns the entry of function `name` with `fingerprint`, or nullptr if
+  // there is none.
+  std::shared_ptr<const Entry> Lookup(const std::string& name,
+                                      uint64_t fingerprint) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Adds the entry of function `name` with `fingerprint`. Optimizing the same
+  // function gives the same entry, so an existing entry is kept.
+  void Insert(const std::string& name, uint64_t fingerprint, Entry entry)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of entries in the cache.
+  size_t num_entries() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the estimated size of the entries in the cache.
+  size_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  using Key = std::pair<std::string, uint64_t>;
+
+  struct CachedEntry {
+    std::shared_ptr<const Entry> entry;
+    size_t size_bytes = 0;
+  };
+
+  const size_t capacity_bytes_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<Key, CachedEntry> entries_ TF_GUARDED_BY(mu_);
+  // The keys of `entries_` from the oldest to the newest insertion.
+  std::deque<Key> insertion_order_ TF_GUARDED_BY(mu_);
+  size_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZATION_CACHE_H_
@@ -0,0 +1,91 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/function_optimization_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+FunctionOptimizationCache::Entry MakeEntry(const std::string& name,
+                                           int num_nodes) {
+  FunctionOptimizationCache::Entry entry;
+  entry.optimized_function.mutable_signature()->set_name(name);
+  for (int i = 0; i < num_nodes; ++i) {
+    entry.optimized_function.add_node_def()->set_name(
+        std::string(100, 'a' + i % 26));
+  }
+  return entry;
+}
+
+TEST(FunctionOptimizationCacheTest, LookupByNameAndFingerprint) {
+  FunctionOptimizationCache cache(/*capacity_bytes=*/1 << 20);
+  FunctionOptimizationCache::Entry entry = MakeEntry("f", /*num_nodes=*/2);
+  entry.added_functions.push_back(
+      MakeEntry("f_specialized", /*num_nodes=*/1).optimized_function);
+  cache.Insert("f", /*fingerprint=*/1, entry);
+
+  std::shared_ptr<const FunctionOptimizationCache::Entry> cached =
+      cache.Lookup("f", /*fingerprint=*/1);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->optimized_function.node_def_size(), 2);
+  ASSERT_EQ(cached->added_functions.size(), 1);
+  EXPECT_EQ(cached->added_functions[0].signature().name(), "f_specialized");
+  EXPECT_EQ(cache.Lookup("f", /*fingerprint=*/2), nullptr);
+  EXPECT_EQ(cache.Lookup("g", /*fingerprint=*/1), nullptr);
+}
+
+TEST(FunctionOptimizationCacheTest, KeepsExistingEntry) {
+  FunctionOptimizationCache cache(/*capacity_bytes=*/1 << 20);
+  cache.Insert("f", /*fingerprint=*/1, MakeEntry("f", /*num_nodes=*/2));
+  cache.Insert("f", /*fingerprint=*/1, MakeEntry("f", /*num_nodes=*/3));
+  EXPECT_EQ(cache.num_entries(), 1);
+  std::shared_ptr<const FunctionOptimizationCache::Entry> cached =
+      cache.Lookup("f", /*fingerprint=*/1);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->optimized_function.node_def_size(), 2);
+}
+
+TEST(FunctionOptimizationCacheTest, EvictsOldestEntries) {
+  const size_t entry_size_bytes =
+      MakeEntry("f0", /*num_nodes=*/10).optimized_function.ByteSizeLong();
+  FunctionOptimizationCache cache(/*capacity_bytes=*/3 * entry_size_bytes);
+  for (int i = 0; i < 5; ++i) {
+    const std::string name = "f" + std::to_string(i);
+    cache.Insert(name, /*fingerprint=*/i, MakeEntry(name, /*num_nodes=*/10));
+    EXPECT_LE(cache.size_bytes(), 3 * entry_size_bytes);
+  }
+  EXPECT_EQ(cache.num_entries(), 3);
+  EXPECT_EQ(cache.Lookup("f0", /*fingerprint=*/0), nullptr);
+  EXPECT_EQ(cache.Lookup("f1", /*fingerprint=*/1), nullptr);
+  EXPECT_NE(cache.Lookup("f4", /*fingerprint=*/4), nullptr);
+}
+
+TEST(FunctionOptimizationCacheTest, SkipsEntriesLargerThanCapacity) {
+  FunctionOptimizationCache cache(/*capacity_bytes=*/100);
+  cache.Insert("f", /*fingerprint=*/1, MakeEntry("f", /*num_nodes=*/10));
+  EXPECT_EQ(cache.num_entries(), 0);
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,117 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_profile.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Returns the op of a node from its timeline label, which has the form
+// "[<memory>]<name> = <op>(<inputs>)".
+std::optional<absl::string_view> OpFromTimelineLabel(absl::string_view label) {
+  const size_t op_start = label.find(" = ");
+  if (op_start == absl::string_view::npos) return std::nullopt;
+  label.remove_prefix(op_start + 3);
+  const size_t op_end = label.find('(');
+  if (op_end == absl::string_view::npos || op_end == 0) return std::nullopt;
+  return label.substr(0, op_end);
+}
+
+}  // namespace
+
+/* static */
+absl::StatusOr<FusionProfile> FusionProfile::Load(
+    Env* env, absl::string_view filenames) {
+  FusionProfile profile;
+  for (absl::string_view filename :
+       absl::StrSplit(filenames, ',', absl::SkipWhitespace())) {
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(
+        ReadTextOrBinaryProto(env, std::string(filename), &run_metadata));
+    profile.AddRunMetadata(run_metadata);
+  }
+  if (profile.num_timings() == 0) {
+    return errors::InvalidArgument("Fusion profile ", filenames,
+                                   " has no kernel timings.");
+  }
+  return profile;
+}
+
+void FusionProfile::AddStepStats(const StepStats& step_stats) {
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      std::optional<absl::string_view> op =
+          OpFromTimelineLabel(node_stats.timeline_label());
+      if (!op.has_value()) continue;
+      AddTiming(node_stats.node_name(), *op,
+                node_stats.op_end_rel_micros() -
+                    node_stats.op_start_rel_micros());
+    }
+  }
+}
+
+void FusionProfile::AddCostGraph(const CostGraphDef& cost_graph,
+                                 const GraphDef& graph) {
+  absl::flat_hash_map<absl::string_view, absl::string_view> node_ops;
+  for (const NodeDef& node : graph.node()) {
+    node_ops[node.name()] = node.op();
+  }
+  for (const CostGraphDef::Node& node : cost_graph.node()) {
+    auto it = node_ops.find(node.name());
+    if (it == node_ops.end()) continue;
+    AddTiming(node.name(), it->second, node.compute_cost());
+  }
+}
+
+void FusionProfile::AddRunMetadata(const RunMetadata& run_metadata) {
+  if (run_metadata.has_step_stats() &&
+      run_metadata.step_stats().dev_stats_size() > 0) {
+    AddStepStats(run_metadata.step_stats());
+    return;
+  }
+  for (const GraphDef& graph : run_metadata.partition_graphs()) {
+    AddCostGraph(run_metadata.cost_graph(), graph);
+  }
+}
+
+void FusionProfile::AddTiming(absl::string_view node, absl::string_view op,
+                              int64_t time_us) {
+  if (time_us < 0) return;
+  Timing& timing = timings_[{std::string(node), std::string(op)}];
+  timing.total_time_us += time_us;
+  ++timing.count;
+}
+
+std::optional<double> FusionProfile::MeanTimeUs(absl::string_view node,
+                                                absl::string_view op) const {
+  auto it = timings_.find({std::string(node), std::string(op)});
+  if (it == timings_.end()) return std::nullopt;
+  return static_cast<double>(it->second.total_time_us) / it->second.count;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUSION_PROFILE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUSION_PROFILE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Measured kernel timings of the nodes of a graph, which let the remapper
+// apply a fusion only where the fused kernel was measured to be faster than
+// the kernels it replaces.
+//
+// Timings are keyed by node name and op, so a profile that merges a run with
+// remapping and a run without it has the timings of both the fused node and
+// the nodes it was fused from. The time of a node that was measured more than
+// once is the mean of its measurements.
+class FusionProfile {
+ public:
+  // Loads the profile from a comma-separated list of RunMetadata files, in
+  // binary or text format.
+  static absl::StatusOr<FusionProfile> Load(Env* env,
+                                            absl::string_view filenames);
+
+  // Adds the kernel timings in `step_stats`. The op of a node is taken from
+  // its timeline label.
+  void AddStepStats(const StepStats& step_stats);
+
+  // Adds the compute costs in `cost_graph`. The op of a node is taken from
+  // `graph`, and nodes that are not in `graph` are skipped.
+  void AddCostGraph(const CostGraphDef& cost_graph, const GraphDef& graph);
+
+  // Adds the step stats of `run_metadata`, or its cost graph if it has no
+  // step stats.
+  void AddRunMetadata(const RunMetadata& run_metadata);
+
+  // Adds a measurement of `node` running `op`.
+  void AddTiming(absl::string_view node, absl::string_view op,
+                 int64_t time_us);
+
+  // Returns the mean measured time of `node` running `op`, if it was
+  // measured.
+  std::optional<double> MeanTimeUs(absl::string_view node,
+                                   absl::string_view op) const;
+
+  // Returns the number of measured (node, op) pairs.
+  size_t num_timings() const { return timings_.size(); }
+
+ private:
+  struct Timing {
+    int64_t total_time_us = 0;
+    int64_t count = 0;
+  };
+
+  absl::flat_hash_map<std::pair<std::string, std::string>, Timing> timings_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_FUSION_PROFILE_H_
@@ -0,0 +1,114 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_profile.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+void AddNodeStats(const std::string& name, const std::string& op,
+                  int64_t time_us, StepStats* step_stats) {
+  DeviceStepStats* device_stats = step_stats->dev_stats_size() > 0
+                                      ? step_stats->mutable_dev_stats(0)
+                                      : step_stats->add_dev_stats();
+  NodeExecStats* node_stats = device_stats->add_node_stats();
+  node_stats->set_node_name(name);
+  node_stats->set_timeline_label(absl::StrCat(name, " = ", op, "(x, y)"));
+  node_stats->set_op_start_rel_micros(1);
+  node_stats->set_op_end_rel_micros(1 + time_us);
+}
+
+TEST(FusionProfileTest, AveragesStepStats) {
+  StepStats step_stats;
+  AddNodeStats("conv", "Conv2D", 10, &step_stats);
+  AddNodeStats("bias_add", "BiasAdd", 4, &step_stats);
+  AddNodeStats("bias_add", "_FusedConv2D", 12, &step_stats);
+  AddNodeStats("bias_add", "_FusedConv2D", 8, &step_stats);
+
+  FusionProfile profile;
+  profile.AddStepStats(step_stats);
+  EXPECT_EQ(profile.num_timings(), 3);
+  EXPECT_EQ(profile.MeanTimeUs("conv", "Conv2D"), 10.0);
+  EXPECT_EQ(profile.MeanTimeUs("bias_add", "BiasAdd"), 4.0);
+  EXPECT_EQ(profile.MeanTimeUs("bias_add", "_FusedConv2D"), 10.0);
+  EXPECT_FALSE(profile.MeanTimeUs("conv", "_FusedConv2D").has_value());
+}
+
+TEST(FusionProfileTest, ReadsCostGraphWithPartitionGraphs) {
+  RunMetadata run_metadata;
+  NodeDef* node = run_metadata.add_partition_graphs()->add_node();
+  node->set_name("matmul");
+  node->set_op("MatMul");
+  CostGraphDef::Node* cost_node = run_metadata.mutable_cost_graph()->add_node();
+  cost_node->set_name("matmul");
+  cost_node->set_compute_cost(7);
+  cost_node = run_metadata.mutable_cost_graph()->add_node();
+  cost_node->set_name("unknown");
+  cost_node->set_compute_cost(3);
+
+  FusionProfile profile;
+  profile.AddRunMetadata(run_metadata);
+  EXPECT_EQ(profile.num_timings(), 1);
+  EXPECT_EQ(profile.MeanTimeUs("matmul", "MatMul"), 7.0);
+}
+
+TEST(FusionProfileTest, LoadsRunMetadataFiles) {
+  RunMetadata with_fusion;
+  AddNodeStats("bias_add", "_FusedMatMul", 5, with_fusion.mutable_step_stats());
+  RunMetadata without_fusion;
+  AddNodeStats("matmul", "MatMul", 3, without_fusion.mutable_step_stats());
+  AddNodeStats("bias_add", "BiasAdd", 1, without_fusion.mutable_step_stats());
+
+  const std::string with_fusion_file =
+      io::JoinPath(testing::TmpDir(), "with_fusion.pb");
+  const std::string without_fusion_file =
+      io::JoinPath(testing::TmpDir(), "without_fusion.pbtxt");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), with_fusion_file, with_fusion));
+  TF_ASSERT_OK(
+      WriteTextProto(Env::Default(), without_fusion_file, without_fusion));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      FusionProfile profile,
+      FusionProfile::Load(Env::Default(), absl::StrCat(with_fusion_file, ",",
+                                                       without_fusion_file)));
+  EXPECT_EQ(profile.num_timings(), 3);
+  EXPECT_EQ(profile.MeanTimeUs("bias_add", "_FusedMatMul"), 5.0);
+  EXPECT_EQ(profile.MeanTimeUs("matmul", "MatMul"), 3.0);
+}
+
+TEST(FusionProfileTest, RejectsEmptyProfile) {
+  const std::string filename = io::JoinPath(testing::TmpDir(), "empty.pb");
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), filename, RunMetadata()));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      FusionProfile::Load(Env::Default(), filename).status()));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
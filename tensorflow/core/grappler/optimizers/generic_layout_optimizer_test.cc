@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/clusters/single_machine.h"
@@ -32,8 +33,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/tensor_float_32_utils.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -385,6 +388,64 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
 #endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
 }
 
+TEST_F(GenericLayoutOptimizerTest, CPUDeviceNHWCToNCHW) {
+  if (GetNumAvailableGPUs() > 0) {
+    GTEST_SKIP() << "The conversion is only for CPU only machines.";
+  }
+  using test::function::NDef;
+  TensorShapeProto input_shape;
+  for (int64_t dim : {8, 8, 8, 3}) input_shape.add_dim()->set_size(dim);
+  Tensor filter(DT_FLOAT, TensorShape({2, 2, 3, 4}));
+  test::FillIota<float>(&filter, 1.0f);
+  GrapplerItem item;
+  item.graph = test::function::GDef({
+      NDef("input", "Placeholder", {},
+           {{"dtype", DT_FLOAT}, {"shape", input_shape}}, "/CPU:0"),
+      NDef("filter", "Const", {}, {{"dtype", DT_FLOAT}, {"value", filter}},
+           "/CPU:0"),
+      NDef("conv", "Conv2D", {"input", "filter"},
+           {{"T", DT_FLOAT},
+            {"data_format", "NHWC"},
+            {"strides", std::vector<int>{1, 1, 1, 1}},
+            {"padding", "SAME"}},
+           "/CPU:0"),
+      NDef("relu", "Relu", {"conv"}, {{"T", DT_FLOAT}}, "/CPU:0"),
+      NDef("pool", "MaxPool", {"relu"},
+           {{"T", DT_FLOAT},
+            {"data_format", "NHWC"},
+            {"ksize", std::vector<int>{1, 2, 2, 1}},
+            {"strides", std::vector<int>{1, 2, 2, 1}},
+            {"padding", "VALID"}},
+           "/CPU:0"),
+      NDef("output", "Identity", {"pool"}, {{"T", DT_FLOAT}}, "/CPU:0"),
+  });
+  item.fetch = {"output"};
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHW);
+  GraphDef output;
+  Status status = optimizer.Optimize(virtual_cluster_.get(), item, &output);
+  if (!IsMKLEnabled()) {
+    EXPECT_TRUE(errors::IsAborted(status)) << status;
+    return;
+  }
+  TF_ASSERT_OK(status);
+
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  VerifyDataFormatAttributeMatch(graph_view.GetNode("conv"), "NCHW");
+  VerifyDataFormatAttributeMatch(graph_view.GetNode("pool"), "NCHW");
+  // The chain is transposed at its input and at its output only.
+  int num_transposes = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "Transpose") ++num_transposes;
+  }
+  EXPECT_EQ(num_transposes, 2);
+  auto* relu_node = graph_view.GetNode("relu");
+  ASSERT_NE(relu_node, nullptr);
+  VerifyRegularFaninMatch(relu_node, 0, "conv", 0);
+}
+
 TEST_F(GenericLayoutOptimizerTest, NoOptimizeIntegerConvolution) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto conv = SimpleConv2D<int32>(&s, 4, 2, "VALID", "");
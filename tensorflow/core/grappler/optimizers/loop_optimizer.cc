@@ -18,18 +18,28 @@ limitations under the License.
 #include <algorithm>
 #include <deque>
 #include <limits>
+#include <optional>
+#include <set>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/full_type.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
@@ -715,6 +725,675 @@ Status CheckForDeadFanout(const MutableGraphView& view,
   return absl::OkStatus();
 }
 
+// Hoisting a loop invariant out of a functional While loop adds a loop
+// variable, which costs a Merge, Switch and NextIteration per iteration once
+// the loop is lowered. It only pays off if it saves at least this many ops
+// that do actual work per iteration.
+constexpr int kMinHoistedOpsPerLoopVariable = 1;
+
+// Maximum number of nodes of the body of an unrolled functional While loop.
+constexpr int kMaxUnrolledBodySize = 256;
+
+// Returns true for the ops that are cheap enough to not be worth hoisting out
+// of a loop on their own.
+bool IsCheapOp(const NodeDef& node) {
+  return IsConstant(node) || IsIdentity(node) || IsShape(node) ||
+         IsSize(node) || IsRank(node) || IsReshape(node) || IsSqueeze(node) ||
+         IsStopGradient(node);
+}
+
+// Returns true if the body node computes a pure function of its inputs.
+bool IsPureFunctionNode(const NodeDef& node) {
+  for (const auto& attr : node.attr()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+  }
+  return IsFreeOfSideEffect(node);
+}
+
+// Splits a tensor of a function body, either "<node>:<output>:<index>" or
+// "<input arg>", into the node or arg name and the output.
+std::pair<absl::string_view, absl::string_view> SplitFunctionTensor(
+    absl::string_view tensor) {
+  absl::ConsumePrefix(&tensor, "^");
+  const size_t pos = tensor.find(':');
+  if (pos == absl::string_view::npos) return {tensor, ""};
+  return {tensor.substr(0, pos), tensor.substr(pos + 1)};
+}
+
+// Index of the nodes and input args of a function body.
+class FunctionBodyIndex {
+ public:
+  explicit FunctionBodyIndex(const FunctionDef& function) {
+    for (int i = 0; i < function.signature().input_arg_size(); ++i) {
+      args_[function.signature().input_arg(i).name()] = i;
+    }
+    for (const NodeDef& node : function.node_def()) {
+      nodes_[node.name()] = &node;
+    }
+  }
+
+  // Returns the index of the input arg `tensor` refers to, or -1.
+  int ArgIndex(absl::string_view tensor) const {
+    auto it = args_.find(tensor);
+    return it == args_.end() ? -1 : it->second;
+  }
+
+  // Returns the node `tensor` refers to, or nullptr if it refers to an arg.
+  const NodeDef* Node(absl::string_view tensor) const {
+    auto it = nodes_.find(SplitFunctionTensor(tensor).first);
+    return it == nodes_.end() ? nullptr : it->second;
+  }
+
+  // Returns the tensor that is forwarded to `tensor` by Identity nodes.
+  absl::string_view SkipIdentities(absl::string_view tensor) const {
+    for (const NodeDef* node = Node(tensor);
+         node != nullptr && IsIdentity(*node) && node->input_size() > 0 &&
+         !IsControlInput(node->input(0));
+         node = Node(tensor)) {
+      tensor = node->input(0);
+    }
+    return tensor;
+  }
+
+ private:
+  absl::flat_hash_map<string, int> args_;
+  absl::flat_hash_map<string, const NodeDef*> nodes_;
+};
+
+// Returns the indices of the nodes of `function` in topological order. Nodes
+// in a cycle are left out.
+std::vector<int> FunctionTopologicalOrder(const FunctionDef& function) {
+  absl::flat_hash_map<absl::string_view, int> node_index;
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    node_index[function.node_def(i).name()] = i;
+  }
+  std::vector<int> num_pending_inputs(function.node_def_size(), 0);
+  std::vector<std::vector<int>> fanouts(function.node_def_size());
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    for (const string& input : function.node_def(i).input()) {
+      auto it = node_index.find(SplitFunctionTensor(input).first);
+      if (it == node_index.end()) continue;
+      ++num_pending_inputs[i];
+      fanouts[it->second].push_back(i);
+    }
+  }
+  std::vector<int> order;
+  for (int i = 0; i < function.node_def_size(); ++i) {
+    if (num_pending_inputs[i] == 0) order.push_back(i);
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (int fanout : fanouts[order[i]]) {
+      if (--num_pending_inputs[fanout] == 0) order.push_back(fanout);
+    }
+  }
+  return order;
+}
+
+// Returns the port and type of the output "<output>:<index>" of a node.
+Status FunctionNodeOutput(const NodeDef& function_node,
+                          absl::string_view output, int* port,
+                          DataType* type) {
+  const OpDef* op_def = nullptr;
+  TF_RETURN_IF_ERROR(
+      OpRegistry::Global()->LookUpOpDef(function_node.op(), &op_def));
+  NodeDef node = function_node;
+  AddDefaultsToNodeDef(*op_def, &node);
+  NameRangeMap output_ranges;
+  TF_RETURN_IF_ERROR(NameRangesForNode(node, *op_def, nullptr, &output_ranges));
+  const auto [output_name, index] = SplitFunctionTensor(output);
+  auto range = output_ranges.find(output_name);
+  int offset = 0;
+  if (range == output_ranges.end() ||
+      (!index.empty() && !absl::SimpleAtoi(index, &offset))) {
+    return errors::InvalidArgument("Unknown output ", output, " of ",
+                                   node.name());
+  }
+  *port = range->second.first + offset;
+  return OutputTypeForNode(node, *op_def, *port, type);
+}
+
+// Returns a name starting with `prefix` that is not used in `flib`.
+string UniqueFunctionName(const FunctionLibraryDefinition& flib,
+                          absl::string_view prefix) {
+  string name(prefix);
+  for (int i = 1; flib.Find(name) != nullptr; ++i) {
+    name = StrCat(prefix, "_", i);
+  }
+  return name;
+}
+
+// Returns a name starting with `prefix` that is not in `names`, and adds it to
+// `names`.
+string UniqueName(absl::string_view prefix,
+                  absl::flat_hash_set<string>* names) {
+  string name(prefix);
+  for (int i = 1; !names->insert(name).second; ++i) {
+    name = StrCat(prefix, "_", i);
+  }
+  return name;
+}
+
+// A functional While loop whose cond and body are plain functions.
+struct FunctionalLoop {
+  NodeDef* node;
+  const FunctionDef* cond;
+  const FunctionDef* body;
+  int num_loop_vars;
+
+  // Returns true if the loop variable `i` is passed unchanged to the next
+  // iteration.
+  bool IsInvariant(int i) const {
+    const OpDef& signature = body->signature();
+    auto ret = body->ret().find(signature.output_arg(i).name());
+    return ret != body->ret().end() &&
+           ret->second == signature.input_arg(i).name();
+  }
+};
+
+bool GetFunctionalLoop(NodeDef* node, const FunctionLibraryDefinition& flib,
+                       FunctionalLoop* loop) {
+  if (!IsWhile(*node)) return false;
+  const AttrValue* cond = AttrSlice(*node).Find("cond");
+  const AttrValue* body = AttrSlice(*node).Find("body");
+  const AttrValue* types = AttrSlice(*node).Find("T");
+  if (cond == nullptr || body == nullptr || types == nullptr ||
+      cond->func().attr_size() > 0 || body->func().attr_size() > 0) {
+    return false;
+  }
+  loop->node = node;
+  loop->cond = flib.Find(cond->func().name());
+  loop->body = flib.Find(body->func().name());
+  loop->num_loop_vars = types->list().type_size();
+  if (loop->cond == nullptr || loop->body == nullptr ||
+      NumNonControlInputs(*node) != loop->num_loop_vars) {
+    return false;
+  }
+  for (const FunctionDef* function : {loop->cond, loop->body}) {
+    const OpDef& signature = function->signature();
+    if (signature.attr_size() > 0 ||
+        signature.input_arg_size() != loop->num_loop_vars) {
+      return false;
+    }
+  }
+  return loop->body->signature().output_arg_size() == loop->num_loop_vars;
+}
+
+// Returns the value of the integer scalar constant `node`.
+bool GetIntegerScalar(const NodeDef& node, int64_t* value) {
+  if (!IsConstant(node)) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+  } else if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64_t>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns the value of the integer scalar constant fed to the graph input
+// `input`, looking through Identity nodes.
+bool GetGraphIntegerScalar(const NodeMap& node_map, const string& input,
+                           int64_t* value) {
+  const NodeDef* node = node_map.GetNode(NodeName(input));
+  while (node != nullptr && IsIdentity(*node) && node->input_size() > 0 &&
+         !IsControlInput(node->input(0))) {
+    node = node_map.GetNode(node->input(0));
+  }
+  return node != nullptr && GetIntegerScalar(*node, value);
+}
+
+// Returns the value of the integer scalar function tensor `tensor`, which may
+// be a constant of the function or an invariant loop variable initialized
+// with a constant.
+bool GetLoopIntegerScalar(const FunctionalLoop& loop,
+                          const FunctionBodyIndex& index,
+                          absl::string_view tensor, const NodeMap& node_map,
+                          int64_t* value) {
+  tensor = index.SkipIdentities(tensor);
+  const int arg = index.ArgIndex(tensor);
+  if (arg >= 0) {
+    return loop.IsInvariant(arg) &&
+           GetGraphIntegerScalar(node_map, loop.node->input(arg), value);
+  }
+  const NodeDef* node = index.Node(tensor);
+  return node != nullptr && GetIntegerScalar(*node, value);
+}
+
+// Returns the number of iterations of `loop` if its condition is i < limit or
+// i <= limit, where i is a loop variable initialized with a constant and
+// incremented by a constant by the body, and limit is a constant.
+std::optional<int64_t> GetTripCount(const FunctionalLoop& loop,
+                                    const NodeMap& node_map) {
+  const FunctionDef& cond = *loop.cond;
+  if (cond.signature().output_arg_size() != 1) return std::nullopt;
+  const FunctionBodyIndex cond_index(cond);
+  auto cond_ret = cond.ret().find(cond.signature().output_arg(0).name());
+  if (cond_ret == cond.ret().end()) return std::nullopt;
+  const NodeDef* compare =
+      cond_index.Node(cond_index.SkipIdentities(cond_ret->second));
+  if (compare == nullptr || (!IsLess(*compare) && !IsLessEqual(*compare)) ||
+      compare->input_size() != 2) {
+    return std::nullopt;
+  }
+  const int counter =
+      cond_index.ArgIndex(cond_index.SkipIdentities(compare->input(0)));
+  int64_t limit;
+  if (counter < 0 || !GetLoopIntegerScalar(loop, cond_index, compare->input(1),
+                                           node_map, &limit)) {
+    return std::nullopt;
+  }
+
+  const FunctionDef& body = *loop.body;
+  const FunctionBodyIndex body_index(body);
+  auto body_ret = body.ret().find(body.signature().output_arg(counter).name());
+  if (body_ret == body.ret().end()) return std::nullopt;
+  const NodeDef* increment =
+      body_index.Node(body_index.SkipIdentities(body_ret->second));
+  if (increment == nullptr || !IsAdd(*increment) ||
+      increment->input_size() != 2) {
+    return std::nullopt;
+  }
+  int64_t step = 0;
+  bool found_counter = false;
+  for (int i = 0; i < 2; ++i) {
+    if (body_index.ArgIndex(body_index.SkipIdentities(
+            increment->input(i))) == counter &&
+        GetLoopIntegerScalar(loop, body_index, increment->input(1 - i),
+                             node_map, &step)) {
+      found_counter = true;
+      break;
+    }
+  }
+  int64_t start;
+  if (!found_counter || step <= 0 ||
+      !GetGraphIntegerScalar(node_map, loop.node->input(counter), &start)) {
+    return std::nullopt;
+  }
+  if (IsLessEqual(*compare)) {
+    if (limit == std::numeric_limits<int64_t>::max()) return std::nullopt;
+    ++limit;
+  }
+  if (start >= limit) return 0;
+  return (limit - start + step - 1) / step;
+}
+
+// Renames `function` to `name` and adds input args of the given types to it.
+// Returns the names of the new args.
+std::vector<string> AddFunctionInputs(const std::vector<DataType>& types,
+                                      const string& name,
+                                      FunctionDef* function) {
+  function->mutable_signature()->set_name(name);
+  absl::flat_hash_set<string> names;
+  for (const auto& arg : function->signature().input_arg()) {
+    names.insert(arg.name());
+  }
+  for (const auto& arg : function->signature().output_arg()) {
+    names.insert(arg.name());
+  }
+  for (const NodeDef& node : function->node_def()) names.insert(node.name());
+  std::vector<string> arg_names;
+  for (DataType type : types) {
+    OpDef::ArgDef* arg = function->mutable_signature()->add_input_arg();
+    arg->set_name(UniqueName("hoisted", &names));
+    arg->set_type(type);
+    arg_names.push_back(arg->name());
+  }
+  return arg_names;
+}
+
+// Moves the pure computations of the body of `loop` that only depend on
+// invariant loop variables and constants out of the loop. The hoisted values
+// are passed to the body through new invariant loop variables.
+Status HoistFunctionalLoopInvariants(const FunctionalLoop& loop,
+                                     FunctionLibraryDefinition* flib,
+                                     NodeMap* node_map, GraphDef* graph,
+                                     bool* changed) {
+  const FunctionDef& body = *loop.body;
+  const FunctionBodyIndex index(body);
+  const std::vector<int> order = FunctionTopologicalOrder(body);
+
+  absl::flat_hash_set<string> invariant;
+  for (int i : order) {
+    const NodeDef& node = body.node_def(i);
+    if (!IsPureFunctionNode(node)) continue;
+    bool is_invariant = true;
+    for (const string& input : node.input()) {
+      const int arg = index.ArgIndex(input);
+      if (IsControlInput(input) ||
+          (arg >= 0 ? !loop.IsInvariant(arg)
+                    : !invariant.contains(SplitFunctionTensor(input).first))) {
+        is_invariant = false;
+        break;
+      }
+    }
+    if (is_invariant) invariant.insert(node.name());
+  }
+  if (invariant.empty()) return absl::OkStatus();
+
+  const auto is_hoistable_tensor = [&](absl::string_view tensor) {
+    return !IsControlInput(tensor) && index.ArgIndex(tensor) < 0 &&
+           invariant.contains(SplitFunctionTensor(tensor).first);
+  };
+  // The invariant tensors that are used by the rest of the body.
+  std::set<string> frontier;
+  for (const NodeDef& node : body.node_def()) {
+    if (invariant.contains(node.name())) continue;
+    for (const string& input : node.input()) {
+      if (is_hoistable_tensor(input)) frontier.insert(input);
+    }
+  }
+  for (const auto& ret : body.ret()) {
+    if (is_hoistable_tensor(ret.second)) frontier.insert(ret.second);
+  }
+
+  // Only hoist the tensors that take actual work to compute, and only if the
+  // loop saves enough of it per added loop variable.
+  absl::flat_hash_set<string> hoisted_nodes;
+  std::vector<string> hoisted;
+  for (const string& tensor : frontier) {
+    absl::flat_hash_set<string> ancestors;
+    std::vector<const NodeDef*> to_visit = {index.Node(tensor)};
+    bool has_work = false;
+    while (!to_visit.empty()) {
+      const NodeDef* node = to_visit.back();
+      to_visit.pop_back();
+      if (!ancestors.insert(node->name()).second) continue;
+      has_work |= !IsCheapOp(*node);
+      for (const string& input : node->input()) {
+        if (const NodeDef* input_node = index.Node(input)) {
+          to_visit.push_back(input_node);
+        }
+      }
+    }
+    if (!has_work) continue;
+    hoisted.push_back(tensor);
+    hoisted_nodes.insert(ancestors.begin(), ancestors.end());
+  }
+  int num_hoisted_ops = 0;
+  for (const string& name : hoisted_nodes) {
+    num_hoisted_ops += !IsCheapOp(*index.Node(name));
+  }
+  if (hoisted.empty() ||
+      num_hoisted_ops <
+          kMinHoistedOpsPerLoopVariable * static_cast<int>(hoisted.size())) {
+    return absl::OkStatus();
+  }
+
+  // Copy the hoisted nodes in front of the loop, with the invariant loop
+  // variables replaced by the inputs of the loop.
+  absl::flat_hash_map<string, string> clone_names;
+  const auto graph_tensor = [&](const string& tensor, string* graph_input,
+                                DataType* type) -> Status {
+    const int arg = index.ArgIndex(tensor);
+    if (arg >= 0) {
+      *graph_input = loop.node->input(arg);
+      *type = body.signature().input_arg(arg).type();
+      return absl::OkStatus();
+    }
+    const auto [name, output] = SplitFunctionTensor(tensor);
+    int port;
+    TF_RETURN_IF_ERROR(
+        FunctionNodeOutput(*index.Node(name), output, &port, type));
+    const string& clone_name = clone_names.at(name);
+    *graph_input = port == 0 ? clone_name : StrCat(clone_name, ":", port);
+    return absl::OkStatus();
+  };
+  std::vector<NodeDef> clones;
+  std::vector<string> hoisted_inputs(hoisted.size());
+  std::vector<DataType> hoisted_types(hoisted.size());
+  Status status;
+  for (int i : order) {
+    const NodeDef& node = body.node_def(i);
+    if (!hoisted_nodes.contains(node.name())) continue;
+    NodeDef& clone = clones.emplace_back(node);
+    string clone_name = StrCat(loop.node->name(), "/hoisted/", node.name());
+    for (int j = 1; node_map->NodeExists(clone_name); ++j) {
+      clone_name = StrCat(loop.node->name(), "/hoisted/", node.name(), "_", j);
+    }
+    clone.set_name(clone_name);
+    clone_names[node.name()] = clone_name;
+    if (clone.device().empty()) clone.set_device(loop.node->device());
+    for (string& input : *clone.mutable_input()) {
+      DataType type;
+      string graph_input;
+      status.Update(graph_tensor(input, &graph_input, &type));
+      input = graph_input;
+    }
+  }
+  for (size_t i = 0; i < hoisted.size(); ++i) {
+    status.Update(
+        graph_tensor(hoisted[i], &hoisted_inputs[i], &hoisted_types[i]));
+  }
+  if (!status.ok()) {
+    VLOG(2) << "Not hoisting the loop invariants of " << loop.node->name()
+            << ": " << status;
+    return absl::OkStatus();
+  }
+  VLOG(1) << "Hoisting " << hoisted_nodes.size() << " loop invariant nodes out"
+          << " of " << loop.node->name();
+
+  // Pass the hoisted values to a copy of the body through new invariant loop
+  // variables, and drop the body nodes that are no longer used.
+  FunctionDef new_body = body;
+  const std::vector<string> hoisted_args = AddFunctionInputs(
+      hoisted_types,
+      UniqueFunctionName(*flib, StrCat(body.signature().name(), "_hoisted")),
+      &new_body);
+  // Arg names are unique across the inputs and outputs.
+  absl::flat_hash_set<string> arg_names;
+  for (const auto& arg : new_body.signature().input_arg()) {
+    arg_names.insert(arg.name());
+  }
+  for (const auto& arg : new_body.signature().output_arg()) {
+    arg_names.insert(arg.name());
+  }
+  absl::flat_hash_map<string, string> hoisted_arg_of;
+  for (size_t i = 0; i < hoisted.size(); ++i) {
+    OpDef::ArgDef* arg = new_body.mutable_signature()->add_output_arg();
+    arg->set_name(UniqueName(hoisted_args[i], &arg_names));
+    arg->set_type(hoisted_types[i]);
+    (*new_body.mutable_ret())[arg->name()] = hoisted_args[i];
+    hoisted_arg_of[hoisted[i]] = hoisted_args[i];
+  }
+  const auto replace_hoisted = [&](string* tensor) {
+    auto it = hoisted_arg_of.find(*tensor);
+    if (it != hoisted_arg_of.end()) *tensor = it->second;
+  };
+  absl::flat_hash_set<string> used;
+  std::vector<string> used_to_visit;
+  const auto mark_used = [&](absl::string_view tensor) {
+    const string name(SplitFunctionTensor(tensor).first);
+    if (used.insert(name).second) used_to_visit.push_back(name);
+  };
+  for (NodeDef& node : *new_body.mutable_node_def()) {
+    if (invariant.contains(node.name())) continue;
+    mark_used(node.name());
+    for (string& input : *node.mutable_input()) replace_hoisted(&input);
+  }
+  for (auto& ret : *new_body.mutable_ret()) {
+    replace_hoisted(&ret.second);
+    mark_used(ret.second);
+  }
+  for (const auto& control_ret : new_body.control_ret()) {
+    mark_used(control_ret.second);
+  }
+  while (!used_to_visit.empty()) {
+    const string name = used_to_visit.back();
+    used_to_visit.pop_back();
+    const NodeDef* node = index.Node(name);
+    if (node == nullptr || !invariant.contains(name)) continue;
+    for (const string& input : node->input()) mark_used(input);
+  }
+  new_body.mutable_node_def()->erase(
+      std::remove_if(
+          new_body.mutable_node_def()->begin(),
+          new_body.mutable_node_def()->end(),
+          [&](const NodeDef& node) { return !used.contains(node.name()); }),
+      new_body.mutable_node_def()->end());
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_body));
+
+  // The cond ignores the new loop variables.
+  FunctionDef new_cond = *loop.cond;
+  AddFunctionInputs(hoisted_types,
+                    UniqueFunctionName(
+                        *flib, StrCat(new_cond.signature().name(), "_hoisted")),
+                    &new_cond);
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_cond));
+
+  for (NodeDef& clone : clones) {
+    NodeDef* node = graph->add_node();
+    *node = std::move(clone);
+    node_map->AddNode(node->name(), node);
+    for (const string& input : node->input()) {
+      node_map->AddOutput(NodeName(input), node->name());
+    }
+  }
+  NodeDef* loop_node = loop.node;
+  auto& attr = *loop_node->mutable_attr();
+  attr["body"].mutable_func()->set_name(new_body.signature().name());
+  attr["cond"].mutable_func()->set_name(new_cond.signature().name());
+  const bool has_output_shapes = attr.count("output_shapes") > 0;
+  for (size_t i = 0; i < hoisted.size(); ++i) {
+    attr["T"].mutable_list()->add_type(hoisted_types[i]);
+    if (has_output_shapes) {
+      attr["output_shapes"].mutable_list()->add_shape()->set_unknown_rank(
+          true);
+    }
+    loop_node->add_input(hoisted_inputs[i]);
+    node_map->AddOutput(NodeName(hoisted_inputs[i]), loop_node->name());
+  }
+  attr.erase("_output_shapes");
+  const int num_inputs = loop.num_loop_vars;
+  std::rotate(loop_node->mutable_input()->begin() + num_inputs,
+              loop_node->mutable_input()->end() - hoisted.size(),
+              loop_node->mutable_input()->end());
+  *changed = true;
+  return absl::OkStatus();
+}
+
+// Unrolls the body of `loop` if its trip count is known and divisible by an
+// unroll factor of at most `max_unroll_factor`, so that the per-iteration
+// overhead of the loop is paid once for several iterations.
+Status UnrollFunctionalLoop(const FunctionalLoop& loop, int max_unroll_factor,
+                            const NodeMap& node_map,
+                            FunctionLibraryDefinition* flib, bool* changed) {
+  const FunctionDef& body = *loop.body;
+  if (body.control_ret_size() > 0) return absl::OkStatus();
+  for (const auto& arg : body.signature().output_arg()) {
+    if (body.ret().count(arg.name()) == 0) return absl::OkStatus();
+  }
+  for (const NodeDef& node : body.node_def()) {
+    if (!IsPureFunctionNode(node)) return absl::OkStatus();
+  }
+  const std::optional<int64_t> trip_count = GetTripCount(loop, node_map);
+  if (!trip_count.has_value()) return absl::OkStatus();
+  int factor = std::max(max_unroll_factor, 1);
+  while (factor > 1 &&
+         (*trip_count % factor != 0 ||
+          factor * body.node_def_size() > kMaxUnrolledBodySize)) {
+    --factor;
+  }
+  if (factor < 2) return absl::OkStatus();
+  VLOG(1) << "Unrolling " << loop.node->name() << " with " << *trip_count
+          << " iterations " << factor << " times";
+
+  const FunctionBodyIndex index(body);
+  FunctionDef unrolled;
+  *unrolled.mutable_signature() = body.signature();
+  unrolled.mutable_signature()->set_name(
+      UniqueFunctionName(*flib, StrCat(body.signature().name(), "_unrolled")));
+  *unrolled.mutable_attr() = body.attr();
+  *unrolled.mutable_arg_attr() = body.arg_attr();
+  *unrolled.mutable_resource_arg_unique_id() = body.resource_arg_unique_id();
+  absl::flat_hash_set<string> names;
+  // The tensors holding the loop variables at the start of each copy of the
+  // body.
+  std::vector<string> loop_vars;
+  for (const auto& arg : body.signature().input_arg()) {
+    names.insert(arg.name());
+    loop_vars.push_back(arg.name());
+  }
+  for (const NodeDef& node : body.node_def()) names.insert(node.name());
+
+  for (int copy = 0; copy < factor; ++copy) {
+    absl::flat_hash_map<string, string> copy_names;
+    for (const NodeDef& node : body.node_def()) {
+      copy_names[node.name()] =
+          copy == 0 ? node.name()
+                    : UniqueName(StrCat(node.name(), "_unrolled_", copy),
+                                 &names);
+    }
+    const auto copy_tensor = [&](const string& tensor) {
+      const bool is_control = IsControlInput(tensor);
+      const auto [name, output] = SplitFunctionTensor(tensor);
+      const int arg = index.ArgIndex(name);
+      if (arg >= 0 && output.empty()) {
+        if (!is_control) return loop_vars[arg];
+        return StrCat("^", SplitFunctionTensor(loop_vars[arg]).first);
+      }
+      return StrCat(is_control ? "^" : "", copy_names.at(name),
+                    output.empty() ? "" : ":", output);
+    };
+    for (const NodeDef& node : body.node_def()) {
+      NodeDef* node_copy = unrolled.add_node_def();
+      *node_copy = node;
+      node_copy->set_name(copy_names.at(node.name()));
+      for (string& input : *node_copy->mutable_input()) {
+        input = copy_tensor(input);
+      }
+    }
+    std::vector<string> next_loop_vars;
+    for (const auto& arg : body.signature().output_arg()) {
+      next_loop_vars.push_back(copy_tensor(body.ret().at(arg.name())));
+    }
+    loop_vars = std::move(next_loop_vars);
+  }
+  for (int i = 0; i < body.signature().output_arg_size(); ++i) {
+    (*unrolled.mutable_ret())[body.signature().output_arg(i).name()] =
+        loop_vars[i];
+  }
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(unrolled));
+  (*loop.node->mutable_attr())["body"].mutable_func()->set_name(
+      unrolled.signature().name());
+  *changed = true;
+  return absl::OkStatus();
+}
+
+// Hoists the loop invariants out of the functional While loops of `graph`
+// and unrolls them by at most `max_unroll_factor`.
+Status OptimizeFunctionalLoops(bool hoist_invariants, int max_unroll_factor,
+                               GraphDef* graph) {
+  if (graph->library().function_size() == 0) return absl::OkStatus();
+  FunctionLibraryDefinition flib(OpRegistry::Global(), graph->library());
+  NodeMap node_map(graph);
+  bool changed = false;
+  const int num_nodes = graph->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = graph->mutable_node(i);
+    FunctionalLoop loop;
+    if (hoist_invariants && GetFunctionalLoop(node, flib, &loop)) {
+      TF_RETURN_IF_ERROR(HoistFunctionalLoopInvariants(loop, &flib, &node_map,
+                                                       graph, &changed));
+    }
+    if (max_unroll_factor > 1 && GetFunctionalLoop(node, flib, &loop)) {
+      TF_RETURN_IF_ERROR(UnrollFunctionalLoop(loop, max_unroll_factor,
+                                              node_map, &flib, &changed));
+    }
+  }
+  if (changed) {
+    *graph->mutable_library() = flib.ToProto();
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 LoopOptimizer::LoopOptimizer()
@@ -723,10 +1402,16 @@ LoopOptimizer::LoopOptimizer()
       options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {}
 
 LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
-                             DeviceBase* cpu_device)
+                             DeviceBase* cpu_device,
+                             bool functional_loop_invariant_code_motion,
+                             int max_functional_loop_unroll_factor)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+  options_.enable_functional_loop_invariant_code_motion =
+      functional_loop_invariant_code_motion;
+  options_.max_functional_loop_unroll_factor =
+      max_functional_loop_unroll_factor;
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -734,7 +1419,8 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   if (!options_.enable_loop_invariant_node_motion &&
       !options_.enable_stack_push_removal &&
-      !options_.enable_dead_branch_removal) {
+      !options_.enable_dead_branch_removal &&
+      !options_.optimizes_functional_loops()) {
     return errors::Aborted("Nothing to do.");
   }
   *optimized_graph = item.graph;
@@ -743,6 +1429,11 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
   }
+  if (options_.optimizes_functional_loops()) {
+    TF_RETURN_IF_ERROR(OptimizeFunctionalLoops(
+        options_.enable_functional_loop_invariant_code_motion,
+        options_.max_functional_loop_unroll_factor, optimized_graph));
+  }
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
   }
@@ -33,14 +33,21 @@ class LoopOptimizer : public GraphOptimizer {
  public:
   LoopOptimizer();
 
+  // `functional_loop_invariant_code_motion` and
+  // `max_functional_loop_unroll_factor` enable the optimization of functional
+  // While loops, see LoopOptimizerOptions.
   explicit LoopOptimizer(RewriterConfig::Toggle opt_level,
-                         DeviceBase* cpu_device);
+                         DeviceBase* cpu_device,
+                         bool functional_loop_invariant_code_motion = false,
+                         int max_functional_loop_unroll_factor = 0);
 
   ~LoopOptimizer() override {}
 
   string name() const override { return "loop_optimizer"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  bool UsesFunctionLibrary() const override {
+    return options_.optimizes_functional_loops();
+  }
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -53,6 +60,18 @@ class LoopOptimizer : public GraphOptimizer {
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
+    // Moves the loop invariant computations of the bodies of functional While
+    // loops out of the loops, when they save enough work per iteration.
+    bool enable_functional_loop_invariant_code_motion = false;
+    // Unrolls the small bodies of the functional While loops with a known
+    // trip count by a factor of at most this, which divides the trip count.
+    // Values below 2 disable unrolling.
+    int max_functional_loop_unroll_factor = 0;
+
+    bool optimizes_functional_loops() const {
+      return enable_functional_loop_invariant_code_motion ||
+             max_functional_loop_unroll_factor > 1;
+    }
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
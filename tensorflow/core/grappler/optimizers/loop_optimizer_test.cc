@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/full_type.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -71,6 +73,54 @@ class LoopOptimizerTest : public GrapplerTest {
     optimizer->options_.enable_stack_push_removal = true;
   }
 
+  void EnableOnlyFunctionalLoopOptimization(LoopOptimizer* optimizer,
+                                            bool hoist_invariants,
+                                            int max_unroll_factor) {
+    DisableAllStages(optimizer);
+    optimizer->options_.enable_dead_branch_removal = false;
+    optimizer->options_.enable_functional_loop_invariant_code_motion =
+        hoist_invariants;
+    optimizer->options_.max_functional_loop_unroll_factor = max_unroll_factor;
+  }
+
+  // Returns a graph with a functional While loop that runs 10 iterations of
+  // x = x * exp(w * w), where w is a loop invariant.
+  GraphDef FunctionalLoopGraph() const {
+    using test::function::NDef;
+    using FDH = FunctionDefHelper;
+    FunctionDef cond = FDH::Create(
+        "Cond", {"i: int32", "x: float", "w: float"}, {"c: bool"}, {},
+        {{{"limit"},
+          "Const",
+          {},
+          {{"value", test::AsScalar<int32>(10)}, {"dtype", DT_INT32}}},
+         {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+        {{"c", "less:z:0"}});
+    FunctionDef body = FDH::Create(
+        "Body", {"i: int32", "x: float", "w: float"},
+        {"next_i: int32", "next_x: float", "next_w: float"}, {},
+        {{{"one"},
+          "Const",
+          {},
+          {{"value", test::AsScalar<int32>(1)}, {"dtype", DT_INT32}}},
+         {{"add"}, "AddV2", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+         {{"square"}, "Square", {"w"}, {{"T", DT_FLOAT}}},
+         {{"exp"}, "Exp", {"square:y:0"}, {{"T", DT_FLOAT}}},
+         {{"mul"}, "Mul", {"x", "exp:y:0"}, {{"T", DT_FLOAT}}}},
+        {{"next_i", "add:z:0"}, {"next_x", "mul:z:0"}, {"next_w", "w"}});
+    return test::function::GDef(
+        {NDef("start", "Const", {},
+              {{"value", test::AsScalar<int32>(0)}, {"dtype", DT_INT32}}),
+         NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+         NDef("w", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+         NDef("loop", "While", {"start", "x", "w"},
+              {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+               {"cond", FDH::FunctionRef("Cond")},
+               {"body", FDH::FunctionRef("Body")}}),
+         NDef("y", "Identity", {"loop:1"}, {{"T", DT_FLOAT}})},
+        {cond, body});
+  }
+
  private:
   void DisableAllStages(LoopOptimizer* optimizer) {
     LoopOptimizer::LoopOptimizerOptions options;
@@ -1802,5 +1852,91 @@ versions {
   EXPECT_TRUE(found);
 }
 
+TEST_F(LoopOptimizerTest, HoistFunctionalLoopInvariants) {
+  GrapplerItem item;
+  item.graph = FunctionalLoopGraph();
+  item.fetch = {"y"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalLoopOptimization(&optimizer, /*hoist_invariants=*/true,
+                                       /*max_unroll_factor=*/0);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* square = node_map.GetNode("loop/hoisted/square");
+  ASSERT_NE(square, nullptr);
+  EXPECT_EQ(square->input(0), "w");
+  const NodeDef* exp = node_map.GetNode("loop/hoisted/exp");
+  ASSERT_NE(exp, nullptr);
+  EXPECT_EQ(exp->input(0), "loop/hoisted/square");
+  const NodeDef* loop = node_map.GetNode("loop");
+  ASSERT_NE(loop, nullptr);
+  ASSERT_EQ(loop->input_size(), 4);
+  EXPECT_EQ(loop->input(3), "loop/hoisted/exp");
+  EXPECT_EQ(loop->attr().at("T").list().type_size(), 4);
+
+  FunctionLibraryDefinition flib(OpRegistry::Global(), output.library());
+  const FunctionDef* body = flib.Find(loop->attr().at("body").func().name());
+  ASSERT_NE(body, nullptr);
+  EXPECT_EQ(body->signature().input_arg_size(), 4);
+  EXPECT_EQ(body->signature().output_arg_size(), 4);
+  for (const NodeDef& node : body->node_def()) {
+    EXPECT_NE(node.op(), "Square");
+    EXPECT_NE(node.op(), "Exp");
+    if (node.name() == "mul") EXPECT_EQ(node.input(1), "hoisted");
+  }
+  const FunctionDef* cond = flib.Find(loop->attr().at("cond").func().name());
+  ASSERT_NE(cond, nullptr);
+  EXPECT_EQ(cond->signature().input_arg_size(), 4);
+}
+
+TEST_F(LoopOptimizerTest, UnrollFunctionalLoop) {
+  GrapplerItem item;
+  item.graph = FunctionalLoopGraph();
+  item.fetch = {"y"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalLoopOptimization(&optimizer, /*hoist_invariants=*/false,
+                                       /*max_unroll_factor=*/4);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The loop runs 10 iterations, so it is unrolled twice.
+  NodeMap node_map(&output);
+  const NodeDef* loop = node_map.GetNode("loop");
+  ASSERT_NE(loop, nullptr);
+  FunctionLibraryDefinition flib(OpRegistry::Global(), output.library());
+  const FunctionDef* body = flib.Find(loop->attr().at("body").func().name());
+  ASSERT_NE(body, nullptr);
+  EXPECT_EQ(body->signature().name(), "Body_unrolled");
+  EXPECT_EQ(body->node_def_size(), 10);
+  EXPECT_EQ(body->ret().at("next_i"), "add_unrolled_1:z:0");
+  EXPECT_EQ(body->ret().at("next_x"), "mul_unrolled_1:z:0");
+  EXPECT_EQ(body->ret().at("next_w"), "w");
+  for (const NodeDef& node : body->node_def()) {
+    if (node.name() == "mul_unrolled_1") {
+      EXPECT_EQ(node.input(0), "mul:z:0");
+      EXPECT_EQ(node.input(1), "exp_unrolled_1:y:0");
+    }
+  }
+}
+
+TEST_F(LoopOptimizerTest, DoNotUnrollFunctionalLoopWithUnknownTripCount) {
+  GrapplerItem item;
+  item.graph = FunctionalLoopGraph();
+  // The loop counter is fed, so the trip count is unknown.
+  item.graph.mutable_node(0)->set_op("Placeholder");
+  item.fetch = {"y"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyFunctionalLoopOptimization(&optimizer, /*hoist_invariants=*/false,
+                                       /*max_unroll_factor=*/4);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(output.library().function_size(), 2);
+  VerifyGraphsEqual(item.graph, output, __FUNCTION__);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -16,8 +16,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <queue>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -440,6 +442,18 @@ void RecomputeSubgraph(
   }
 }
 
+// Returns whether `node` is a node whose inputs we may want to recompute. This
+// matches node names that contain `recomputation_targets_name_scope` as a name
+// scope, meaning it either begins with or contains the name scope. Defaults to
+// "gradients/" which will match any node names that begins with "gradients/"
+// or contains "/gradients/".
+bool IsRecomputationTarget(const NodeDef& node,
+                           const string& recomputation_targets_name_scope) {
+  return absl::StartsWith(node.name(), recomputation_targets_name_scope) ||
+         static_cast<int>(
+             node.name().find("/" + recomputation_targets_name_scope)) != -1;
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
                                 GraphDef* graph, const GrapplerItem& item) {
@@ -461,15 +475,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
   }
   std::function<bool(const NodeDef&)> is_target =
       [&recomputation_targets_name_scope](const NodeDef& node) {
-        // Nodes whose inputs we may want to recompute. This matches node names
-        // that contain recomputation_targets_name_scope as a name scope,
-        // meaning it either begins with or contains the name scope.
-        // Defaults to "gradients/" which will match any node names that begins
-        // with "gradients/" or contains "/gradients/".
-        return absl::StartsWith(node.name(),
-                                recomputation_targets_name_scope) ||
-               static_cast<int>(node.name().find(
-                   "/" + recomputation_targets_name_scope)) != -1;
+        return IsRecomputationTarget(node, recomputation_targets_name_scope);
       };
 
   if (optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
@@ -512,6 +518,227 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
   }
 }
 
+// Returns the memory budget of each device of `cluster`: `budget_bytes` if it
+// is positive, and the memory size of the device otherwise. Devices with an
+// unknown memory size have no budget.
+std::unordered_map<string, int64_t> GetMemoryBudgets(const Cluster& cluster,
+                                                     int64_t budget_bytes) {
+  std::unordered_map<string, int64_t> budgets;
+  for (const auto& device : cluster.GetDevices()) {
+    const int64_t budget =
+        budget_bytes > 0 ? budget_bytes : device.second.memory_size();
+    if (budget > 0) {
+      budgets[device.first] = budget;
+    }
+  }
+  return budgets;
+}
+
+// Estimates the peak memory usage of `item` on each device of `budgets`.
+Status EstimatePeakMemoryUsage(
+    Cluster* cluster, const GrapplerItem& item,
+    const std::unordered_map<string, int64_t>& budgets,
+    std::unordered_map<string, GraphMemory::MemoryUsage>* peak_usage) {
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferStatically(cluster->GetDevices()));
+  peak_usage->clear();
+  for (const auto& budget : budgets) {
+    peak_usage->emplace(budget.first, memory.GetPeakMemoryUsage(budget.first));
+  }
+  return absl::OkStatus();
+}
+
+// Returns the sum over the devices of the bytes by which their peak memory
+// usage exceeds their budget.
+int64_t GetMemoryOverBudget(
+    const std::unordered_map<string, int64_t>& budgets,
+    const std::unordered_map<string, GraphMemory::MemoryUsage>& peak_usage) {
+  int64_t over_budget = 0;
+  for (const auto& usage : peak_usage) {
+    const int64_t budget = budgets.at(usage.first);
+    over_budget += std::max<int64_t>(0, usage.second.used_memory - budget);
+  }
+  return over_budget;
+}
+
+// Estimates the execution time of each node of `item` by simulating its
+// execution on the devices of `cluster`.
+Status EstimateNodeExecutionTimes(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::Duration>* execution_times) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  TF_RETURN_IF_ERROR(vcluster.Provision());
+  TF_RETURN_IF_ERROR(vcluster.Initialize(item));
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return s;
+  }
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      (*execution_times)[node_stats.node_name()] = Costs::MicroSeconds(
+          node_stats.op_end_rel_micros() - node_stats.op_start_rel_micros());
+    }
+  }
+  return absl::OkStatus();
+}
+
+// A node that may be recomputed for the target nodes it feeds, instead of
+// keeping its outputs alive until the target nodes run.
+struct RecomputationCandidate {
+  string node;
+  std::vector<string> target_nodes;
+  // Estimated time to recompute the node.
+  Costs::Duration cost;
+  // Memory used by outputs of the node that are live at the peak memory usage
+  // of its device.
+  int64_t memory_at_peak = 0;
+};
+
+// Recomputes each of the `candidates` in `graph`.
+void RecomputeCandidates(
+    const std::vector<const RecomputationCandidate*>& candidates,
+    GraphDef* graph) {
+  TF_CHECK_OK(TopologicalSort(graph));
+  NodeMap node_map(graph);
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < graph->node().size();
+       ++node_number) {
+    topological_numbering[graph->mutable_node(node_number)] =
+        graph->node().size() - node_number - 1;
+  }
+  for (const RecomputationCandidate* candidate : candidates) {
+    std::unordered_set<const NodeDef*> recomputed_nodes = {
+        node_map.GetNode(candidate->node)};
+    std::unordered_set<NodeDef*> target_nodes;
+    for (const string& target_node : candidate->target_nodes) {
+      target_nodes.insert(node_map.GetNode(target_node));
+    }
+    RecomputeSubgraph(recomputed_nodes, target_nodes, node_map,
+                      topological_numbering, graph);
+  }
+}
+
+// Maximum number of sets of recomputed nodes whose peak memory usage is
+// estimated by the budgeted recomputation pass.
+constexpr int kMaxRecomputationEvaluations = 32;
+
+// Chooses nodes to recompute so that the estimated peak memory usage of each
+// device fits in its budget, preferring the nodes that free the most memory at
+// the peak for the least recomputation time. Every recomputation is checked
+// against a new estimate of the peak memory usage, and only kept if it
+// reduces the memory over budget.
+void BudgetedRecomputationPass(
+    Cluster* cluster, const string& recomputation_targets_name_scope,
+    const std::unordered_map<string, int64_t>& budgets,
+    const std::unordered_map<string, GraphMemory::MemoryUsage>& peak_usage,
+    GrapplerItem* item) {
+  int64_t over_budget = GetMemoryOverBudget(budgets, peak_usage);
+  if (over_budget == 0) {
+    return;
+  }
+  std::unordered_map<string, Costs::Duration> execution_times;
+  Status s = EstimateNodeExecutionTimes(cluster, *item, &execution_times);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to estimate execution times: " << s.message();
+    return;
+  }
+
+  // Memory of each output that is live at the peak memory usage of a device
+  // over budget, by node.
+  std::unordered_map<string, int64_t> memory_at_peak;
+  for (const auto& usage : peak_usage) {
+    if (usage.second.used_memory <= budgets.at(usage.first)) continue;
+    for (const GraphMemory::LiveTensor& live_tensor :
+         usage.second.live_tensors) {
+      memory_at_peak[live_tensor.node] += live_tensor.memory_used;
+    }
+  }
+
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+  const auto is_target = [&](const NodeDef& node) {
+    return IsRecomputationTarget(node, recomputation_targets_name_scope);
+  };
+  // Recomputed nodes must give the same outputs as the original ones.
+  const auto is_candidate = [&](const NodeDef& node) {
+    return !is_target(node) && feeds.count(node.name()) == 0 &&
+           node.input_size() > 0 && !IsControlFlow(node) &&
+           IsFreeOfSideEffect(node) && memory_at_peak.count(node.name()) > 0;
+  };
+
+  std::vector<RecomputationCandidate> candidates;
+  {
+    GraphDef* graph = &item->graph;
+    TF_CHECK_OK(TopologicalSort(graph));
+    NodeMap node_map(graph);
+    for (const NodeDef* node : FindCandidateRecomputeNodes(
+             node_map, graph, is_candidate, is_target)) {
+      RecomputationCandidate candidate;
+      candidate.node = node->name();
+      std::set<string> target_nodes;
+      for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+        if (is_target(*output)) target_nodes.insert(output->name());
+      }
+      candidate.target_nodes.assign(target_nodes.begin(), target_nodes.end());
+      auto it = execution_times.find(node->name());
+      candidate.cost = it != execution_times.end() ? it->second
+                                                   : Costs::Duration(0);
+      candidate.memory_at_peak = memory_at_peak.at(node->name());
+      candidates.push_back(std::move(candidate));
+    }
+  }
+  // Sort by decreasing memory freed per unit of recomputation time. The
+  // candidates are compared by cross-multiplying to handle free nodes.
+  std::sort(candidates.begin(), candidates.end(),
+            [](const RecomputationCandidate& a,
+               const RecomputationCandidate& b) {
+              const double a_ratio = static_cast<double>(a.memory_at_peak) *
+                                     (b.cost.count() + 1);
+              const double b_ratio = static_cast<double>(b.memory_at_peak) *
+                                     (a.cost.count() + 1);
+              if (a_ratio != b_ratio) return a_ratio > b_ratio;
+              return a.node < b.node;
+            });
+
+  std::vector<const RecomputationCandidate*> recomputed;
+  GraphDef best_graph;
+  Costs::Duration added_time(0);
+  int num_evaluations = 0;
+  for (const RecomputationCandidate& candidate : candidates) {
+    if (over_budget == 0 || num_evaluations >= kMaxRecomputationEvaluations) {
+      break;
+    }
+    ++num_evaluations;
+    recomputed.push_back(&candidate);
+    GrapplerItem trial_item(*item);
+    RecomputeCandidates(recomputed, &trial_item.graph);
+    std::unordered_map<string, GraphMemory::MemoryUsage> trial_usage;
+    s = EstimatePeakMemoryUsage(cluster, trial_item, budgets, &trial_usage);
+    const int64_t trial_over_budget =
+        s.ok() ? GetMemoryOverBudget(budgets, trial_usage) : over_budget;
+    if (trial_over_budget >= over_budget) {
+      VLOG(2) << "Recomputing " << candidate.node
+              << " does not reduce the memory over budget";
+      recomputed.pop_back();
+      continue;
+    }
+    VLOG(1) << "Will recompute " << candidate.node << ": memory over budget "
+            << over_budget << " -> " << trial_over_budget << " bytes";
+    over_budget = trial_over_budget;
+    added_time += candidate.cost;
+    best_graph.Swap(&trial_item.graph);
+  }
+  if (!recomputed.empty()) {
+    VLOG(1) << "Recomputing " << recomputed.size()
+            << " nodes adds an estimated " << added_time.count()
+            << "ns of computation";
+    item->graph.Swap(&best_graph);
+  }
+}
+
 bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
                     GrapplerItem* item) {
   // Look for AddN nodes (and equivalent) and record input names.
@@ -978,7 +1205,7 @@ struct MemInfo {
 };
 
 static bool IdentifySwappingCandidates(
-    Cluster* cluster, GrapplerItem* item,
+    Cluster* cluster, GrapplerItem* item, int64_t budget_bytes,
     std::unique_ptr<GraphMemory>* memory_ptr,
     std::unordered_set<string>* skip_list,
     std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap) {
@@ -1000,16 +1227,18 @@ static bool IdentifySwappingCandidates(
     if (prop.type() != "GPU") {
       continue;
     }
-    if (prop.memory_size() <= 0) {
+    const int64_t budget =
+        budget_bytes > 0 ? budget_bytes : prop.memory_size();
+    if (budget <= 0) {
       VLOG(1) << "Peak memory usage unknown for device " << name;
       continue;
     }
     const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
 
-    if (mem_usage.used_memory <= prop.memory_size()) {
+    if (mem_usage.used_memory <= budget) {
       continue;
     }
-    int64_t required_savings = mem_usage.used_memory - prop.memory_size();
+    int64_t required_savings = mem_usage.used_memory - budget;
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
     {
@@ -1147,14 +1376,16 @@ static bool IdentifySwappingCandidates(
 }
 
 bool SwappingPass(RewriterConfig::MemOptType optimization_level,
-                  Cluster* cluster, std::unique_ptr<GraphMemory>* memory,
-                  GrapplerItem* item, std::unordered_set<string>* skip_list) {
+                  Cluster* cluster, int64_t budget_bytes,
+                  std::unique_ptr<GraphMemory>* memory, GrapplerItem* item,
+                  std::unordered_set<string>* skip_list) {
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
       optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
-      optimization_level == RewriterConfig::HEURISTICS) {
+      optimization_level == RewriterConfig::HEURISTICS ||
+      optimization_level == RewriterConfig::BUDGETED_HEURISTICS) {
     // Use heuristics to figure out what needs to be swapped;
-    IdentifySwappingCandidates(cluster, item, memory, skip_list,
+    IdentifySwappingCandidates(cluster, item, budget_bytes, memory, skip_list,
                                &nodes_to_swap);
   }
   // Look for manual annotations in the graph.
@@ -1400,6 +1631,24 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                &optimized_item.graph, item);
   }
 
+  // The budgeted pass needs fetches to estimate the peak memory usage.
+  const bool run_budgeted_pass =
+      optimization_level_ == RewriterConfig::BUDGETED_HEURISTICS &&
+      cluster != nullptr && !item.fetch.empty();
+  std::unordered_map<string, int64_t> budgets;
+  std::unordered_map<string, GraphMemory::MemoryUsage> original_peak_usage;
+  if (run_budgeted_pass) {
+    budgets = GetMemoryBudgets(*cluster, memory_budget_bytes_);
+    Status s = EstimatePeakMemoryUsage(cluster, optimized_item, budgets,
+                                       &original_peak_usage);
+    if (s.ok()) {
+      BudgetedRecomputationPass(cluster, recomputation_targets_name_scope_,
+                                budgets, original_peak_usage, &optimized_item);
+    } else {
+      VLOG(1) << "Failed to infer memory usage: " << s.message();
+    }
+  }
+
   std::unordered_set<string> skip_list;
   // Bound the number of rewrite passes to avoid long processing times on graphs
   // that simply won't fit in memory.
@@ -1426,10 +1675,11 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
            optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
            optimization_level_ == RewriterConfig::HEURISTICS ||
+           optimization_level_ == RewriterConfig::BUDGETED_HEURISTICS ||
            optimization_level_ == RewriterConfig::MANUAL) &&
           cluster != nullptr) {
-        if (SwappingPass(optimization_level_, cluster, &memory, &optimized_item,
-                         &skip_list)) {
+        if (SwappingPass(optimization_level_, cluster, memory_budget_bytes_,
+                         &memory, &optimized_item, &skip_list)) {
           // Reset the inferred memory usage since the graph changed.
           memory.reset();
           updated_graph = true;
@@ -1438,6 +1688,19 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
   }
 
+  if (run_budgeted_pass && !original_peak_usage.empty()) {
+    std::unordered_map<string, GraphMemory::MemoryUsage> peak_usage;
+    Status s =
+        EstimatePeakMemoryUsage(cluster, optimized_item, budgets, &peak_usage);
+    for (const auto& usage : original_peak_usage) {
+      LOG(INFO) << "Predicted peak memory usage of " << usage.first << ": "
+                << usage.second.used_memory << " bytes before and "
+                << (s.ok() ? peak_usage.at(usage.first).used_memory : -1)
+                << " bytes after memory optimization, with a budget of "
+                << budgets.at(usage.first) << " bytes";
+    }
+  }
+
   optimized_graph->Swap(&optimized_item.graph);
   return absl::OkStatus();
 }
@@ -448,6 +448,59 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, BudgetedRecomputation) {
+  // "a" is live from the start of the forward pass until "gradients/e" runs,
+  // so recomputing it for "gradients/e" lowers the peak memory usage.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Square(s.WithOpName("b").WithDevice("/gpu:0"), a);
+  Output c = ops::Exp(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::Square(s.WithOpName("gradients/d").WithDevice("/gpu:0"), c);
+  Output e =
+      ops::Mul(s.WithOpName("gradients/e").WithDevice("/gpu:0"), d, a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::BUDGETED_HEURISTICS, "gradients/",
+                            /*memory_budget_bytes=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* recomputed_a = node_map.GetNode("Recomputed/a");
+  ASSERT_NE(recomputed_a, nullptr);
+  EXPECT_EQ("v", recomputed_a->input(0));
+  const NodeDef* new_e = node_map.GetNode("gradients/e");
+  ASSERT_NE(new_e, nullptr);
+  EXPECT_EQ("gradients/d", new_e->input(0));
+  EXPECT_EQ("Recomputed/a", new_e->input(1));
+  // Nodes that feed no recomputation target are never recomputed.
+  EXPECT_EQ(node_map.GetNode("Recomputed/b"), nullptr);
+}
+
+TEST_F(MemoryOptimizerTest, BudgetedRecomputationWithinBudget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v =
+      ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"), {4}, DT_FLOAT);
+  Output a = ops::Sqrt(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Square(s.WithOpName("gradients/b").WithDevice("/gpu:0"), a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/b"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::BUDGETED_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
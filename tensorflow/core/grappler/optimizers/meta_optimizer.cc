@@ -17,10 +17,13 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -39,18 +42,23 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
+#include "tensorflow/core/grappler/optimizers/collective_bucketing.h"
 #include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/function_optimization_cache.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/optimizer_apply_fusion.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimizer_telemetry.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/precision_narrowing.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/shape_optimizer.h"
@@ -62,7 +70,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -106,10 +118,39 @@ int NumIterations(const RewriterConfig& cfg) {
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
-         name == "loop_optimizer" ||
+         name == "loop_optimizer" || name == "precision_narrowing" ||
+         name == "collective_bucketing" || name == "optimizer_apply_fusion" ||
          absl::StartsWith(name, "auto_mixed_precision");
 }
 
+// Check if optimizer may be skipped when it is unprofitable. Function
+// inlining and implementation selection may be needed to run the graph.
+bool IsSkippableOptimizer(const string& name) {
+  return name != "function_optimizer" && name != "implementation_selector";
+}
+
+// Returns a fingerprint of `func` and of the functions in `flib` that it may
+// call. `fingerprints` holds the fingerprints of single function definitions
+// in `flib`, and is extended with the ones that are missing.
+uint64 FunctionFingerprint(const FunctionDef& func,
+                           const FunctionLibraryDefinition& flib,
+                           absl::flat_hash_map<string, uint64>& fingerprints) {
+  uint64 fingerprint = DeterministicProtoHash64(func);
+  const FunctionLibraryDefinition reachable = flib.ReachableDefinitions(func);
+  std::vector<string> names = reachable.ListFunctionNames();
+  std::sort(names.begin(), names.end());
+  for (const string& name : names) {
+    auto it = fingerprints.find(name);
+    if (it == fingerprints.end()) {
+      it = fingerprints
+               .emplace(name, DeterministicProtoHash64(*reachable.Find(name)))
+               .first;
+    }
+    fingerprint = FingerprintCat64(fingerprint, it->second);
+  }
+  return fingerprint;
+}
+
 // Creates a function library stub from a real function library: copy only
 // signatures and attributes of all the function defined in fdef_lib. This stub
 // can be swapped with real function library in a graph, before passing it to
@@ -186,6 +227,18 @@ Status GetGraphDevice(const GraphDef& g_def, std::set<std::string>* devices) {
   return absl::OkStatus();
 }
 
+// The optimization of one function of the library.
+struct FunctionOptimization {
+  string name;
+  GrapplerFunctionItem item;
+  // Fingerprint of the function in the optimization cache.
+  uint64 fingerprint = 0;
+  // The cached optimization of the function, if there is one.
+  std::shared_ptr<const FunctionOptimizationCache::Entry> cached;
+  GraphDef optimized_graph;
+  Status status;
+};
+
 }  // namespace
 
 #define MK_OPT(NAME, CONFIG, VALUE)                                    \
@@ -218,11 +271,14 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new ConstantFolding(
              cpu_device_,
              cfg_.experimental_disable_compressed_tensor_optimization(),
-             !cfg_.experimental_disable_folding_quantization_emulation()));
+             !cfg_.experimental_disable_folding_quantization_emulation(),
+             cfg_.experimental_constant_folding_threads(),
+             cfg_.constant_folding_output_budget_bytes()));
   MK_OPT("shape", "shape_optimization", new ShapeOptimizer());
   MK_OPT("remap", "remapping",
          new Remapper(cfg_.remapping(), cfg_.cpu_layout_conversion(),
-                      xla_auto_clustering_on_));
+                      xla_auto_clustering_on_,
+                      cfg_.experimental_remapper_profile()));
   MK_OPT("layout", "layout_optimizer",
          new GenericLayoutOptimizer(
              /*optimization level*/ cfg_.layout_optimizer(),
@@ -242,16 +298,23 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
 #endif
   MK_OPT("auto_mixed_precision_cpu", "auto_mixed_precision_cpu",
          new AutoMixedPrecision(AutoMixedPrecisionMode::CPU));
+  MK_OPT("precision_narrowing", "precision_narrowing",
+         new PrecisionNarrowing(cfg_.precision_narrowing()));
   MK_OPT("memory", "memory_optimization",
          new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination", "common_subgraph_elimination",
-         new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
+         new CommonSubgraphElimination(
+             cfg_.common_subgraph_elimination(),
+             cfg_.experimental_cross_function_common_subgraph_elimination()));
   MK_OPT("arithmetic", "arithmetic_optimization",
          new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", "auto_parallel",
          new AutoParallel(cfg_.auto_parallel().num_replicas()));
   MK_OPT("loop", "loop_optimization",
-         new LoopOptimizer(cfg_.loop_optimization(), cpu_device_));
+         new LoopOptimizer(
+             cfg_.loop_optimization(), cpu_device_,
+             cfg_.experimental_functional_loop_invariant_code_motion(),
+             cfg_.experimental_max_loop_unroll_factor()));
   MK_OPT("dependency", "dependency_optimization",
          new DependencyOptimizer(cfg_.dependency_optimization()));
   MK_OPT("debug_stripper", "debug_stripper", new DebugStripper());
@@ -260,6 +323,10 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host", "pin_to_host_optimization",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("collective_bucketing", "collective_bucketing",
+         new CollectiveBucketing(cfg_.collective_bucketing()));
+  MK_OPT("optimizer_apply_fusion", "optimizer_apply_fusion",
+         new OptimizerApplyFusion(cfg_.optimizer_apply_fusion()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -347,7 +414,8 @@ Status MetaOptimizer::InitializeOptimizers(
       VLOG(2) << "common_subgraph_elimination is not implemented in TFG yet";
     } else {
       optimizers->push_back(std::make_unique<CommonSubgraphElimination>(
-          cfg_.common_subgraph_elimination()));
+          cfg_.common_subgraph_elimination(),
+          cfg_.experimental_cross_function_common_subgraph_elimination()));
     }
   }
   if (BOTH_ARE_ON(debug_stripper))
@@ -407,6 +475,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         std::make_unique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU));
   }
+  if (cfg_.precision_narrowing().enable()) {
+    optimizers->push_back(
+        std::make_unique<PrecisionNarrowing>(cfg_.precision_narrowing()));
+  }
   if (BOTH_ARE_ON(pin_to_host_optimization))
     optimizers->push_back(std::make_unique<PinToHostOptimizer>());
   else if (BOTH_ARE_EXPERIMENTAL_MLIR(pin_to_host_optimization) ||
@@ -448,7 +520,7 @@ Status MetaOptimizer::InitializeOptimizers(
     if (enable_grappler_pass) {
       optimizers->push_back(std::make_unique<Remapper>(
           cfg_.remapping(), cfg_.cpu_layout_conversion(),
-          xla_auto_clustering_on_));
+          xla_auto_clustering_on_, cfg_.experimental_remapper_profile()));
     }
   }
   if (BOTH_NOT_OFF(loop_optimization)) {
@@ -457,7 +529,9 @@ Status MetaOptimizer::InitializeOptimizers(
       VLOG(2) << "loop_optimization is not implemented in TFG yet";
     } else {
       optimizers->push_back(std::make_unique<LoopOptimizer>(
-          cfg_.loop_optimization(), cpu_device_));
+          cfg_.loop_optimization(), cpu_device_,
+          cfg_.experimental_functional_loop_invariant_code_motion(),
+          cfg_.experimental_max_loop_unroll_factor()));
     }
   }
   if (BOTH_NOT_OFF(dependency_optimization)) {
@@ -475,11 +549,14 @@ Status MetaOptimizer::InitializeOptimizers(
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
           // Use the default target node name prefix "gradients/"
-          std::make_unique<MemoryOptimizer>(cfg_.memory_optimization()));
+          std::make_unique<MemoryOptimizer>(
+              cfg_.memory_optimization(), "gradients/",
+              cfg_.memory_optimizer_budget_bytes()));
     } else {
       optimizers->push_back(std::make_unique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_budget_bytes()));
     }
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
@@ -496,6 +573,14 @@ Status MetaOptimizer::InitializeOptimizers(
     VLOG(2) << "scoped_allocator_optimization is not implemented in TFG yet";
   }
 #endif
+  if (cfg_.collective_bucketing().enable()) {
+    optimizers->push_back(
+        std::make_unique<CollectiveBucketing>(cfg_.collective_bucketing()));
+  }
+  if (cfg_.optimizer_apply_fusion() == RewriterConfig::ON) {
+    optimizers->push_back(std::make_unique<OptimizerApplyFusion>(
+        cfg_.optimizer_apply_fusion()));
+  }
 
 #undef USER_IS_ON
 #undef USER_IS_EXPERIMENTAL_MLIR
@@ -888,7 +973,10 @@ Status MetaOptimizer::OptimizeGraph(
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -919,6 +1007,21 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
 Status MetaOptimizer::RunOptimizer(
     GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
     GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
+  const OptimizerTelemetryOptions& telemetry = cfg_.optimizer_telemetry();
+  const string& model = telemetry.model_name().empty()
+                            ? optimized_item->id
+                            : telemetry.model_name();
+  if (telemetry.disable_unprofitable_optimizers() &&
+      IsSkippableOptimizer(optimizer->name()) &&
+      OptimizerTelemetry::Global()->IsUnprofitable(model, optimizer->name())) {
+    VLOG(1) << "Skipping " << optimizer->name()
+            << ", which was unprofitable on the graphs of " << model;
+    metrics::IncrementGrapplerPassSkippedCount(model, optimizer->name());
+    optimization_result->results.push_back(
+        {optimizer->name(), "skipped as unprofitable", absl::OkStatus()});
+    return absl::OkStatus();
+  }
+
   // If optimizer doesn't need a function library, we will replace it with a
   // stub before running optimization, and will put it back at the end.
   std::unique_ptr<FunctionDefLibrary> optimized_graph_function_library;
@@ -943,7 +1046,8 @@ Status MetaOptimizer::RunOptimizer(
       {kGrapplerCategory, optimizer->name()});
   Status status =
       optimizer->Optimize(cluster, *optimized_item, optimized_graph);
-  auto duration_ms = timings.DurationMicroSec().value() / 1000.0f;
+  const int64_t duration_usecs = timings.DurationMicroSec().value();
+  auto duration_ms = duration_usecs / 1000.0f;
   timings.ReportAndStop();
 
   string message;
@@ -972,6 +1076,31 @@ Status MetaOptimizer::RunOptimizer(
     VLOG(1) << optimizer->name() << ": " << message;
   }
 
+  if (telemetry.enable() || telemetry.disable_unprofitable_optimizers()) {
+    std::optional<int64_t> predicted_cost_delta_usecs;
+    if (!status.ok()) {
+      predicted_cost_delta_usecs = 0;
+    } else if (telemetry.estimate_cost() ||
+               telemetry.disable_unprofitable_optimizers()) {
+      absl::StatusOr<int64_t> cost_before =
+          PredictGraphCostUsecs(*optimized_item);
+      absl::StatusOr<int64_t> cost_after = PredictGraphCostUsecs(
+          optimized_item->WithGraph(GraphDef(*optimized_graph)));
+      if (cost_before.ok() && cost_after.ok()) {
+        predicted_cost_delta_usecs = *cost_after - *cost_before;
+      } else {
+        VLOG(2) << "Failed to predict the cost of the graph optimized by "
+                << optimizer->name();
+      }
+    }
+    OptimizerTelemetry::Global()->RecordRun(
+        model, optimizer->name(), duration_usecs,
+        status.ok() ? static_cast<int64_t>(optimized_graph->node_size()) -
+                          optimized_item->graph.node_size()
+                    : 0,
+        predicted_cost_delta_usecs);
+  }
+
   // Swap function library back into the main graph.
   if (!is_function_library_aware) {
     optimized_graph->set_allocated_library(
@@ -991,6 +1120,61 @@ Status MetaOptimizer::RunOptimizer(
   return absl::OkStatus();
 }
 
+Status MetaOptimizer::OptimizeFunctionBody(Cluster* cluster,
+                                           bool is_tpu_graph,
+                                           GrapplerFunctionItem& func_item,
+                                           GraphDef* optimized_func_graph) {
+  if (is_tpu_graph) {
+    // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+    // passes do not handle TPU functions correctly in a variety of ways
+    // (Note that due to the pre-placement TPU graph rewriting passes, the
+    // TPU-related ops are encapsulated away into functions). For example,
+    // TPU graphs contain TPUReplicateMetadata node that carries relevant
+    // TPU metadata and Grappler passes could prune that away. Grappler
+    // passes could also cause issues around shape inference. Since the
+    // desired and existing behavior is to not optimize TPU functions with
+    // Grappler, this check preserves that. The only exception is
+    // implementation selector what is required to swap in some TPU specific
+    // lowering code and is verified the work correctly on TPUs.
+    ImplementationSelector implementation_selector;
+
+    // Implementation selector needs to have access to valid function
+    // signature and attributes, and it doesn't need actual function body.
+    std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+        func_item.graph.release_library());
+    *func_item.graph.mutable_library() =
+        GetFunctionDefLibraryStub(*func_item_function_library);
+
+    return implementation_selector.Optimize(cluster, func_item,
+                                            optimized_func_graph);
+  }
+  GrapplerFunctionItem func_item_copy = func_item;
+  return OptimizeGraph(cluster, std::move(func_item_copy),
+                       optimized_func_graph);
+}
+
+uint64 MetaOptimizer::FunctionOptimizationContextFingerprint(
+    const Cluster* cluster, int producer, bool is_tpu_graph) const {
+  uint64 fingerprint = DeterministicProtoHash64(config_proto_);
+  fingerprint = FingerprintCat64(fingerprint, producer);
+  fingerprint = FingerprintCat64(fingerprint, is_tpu_graph);
+  if (cluster != nullptr) {
+    const auto& devices = cluster->GetDevices();
+    std::vector<string> device_names;
+    device_names.reserve(devices.size());
+    for (const auto& device : devices) {
+      device_names.push_back(device.first);
+    }
+    std::sort(device_names.begin(), device_names.end());
+    for (const string& device_name : device_names) {
+      fingerprint = FingerprintCat64(fingerprint, Fingerprint64(device_name));
+      fingerprint = FingerprintCat64(
+          fingerprint, DeterministicProtoHash64(devices.at(device_name)));
+    }
+  }
+  return fingerprint;
+}
+
 // Propagates `_tf_data_function` attributes from functions to their callees.
 void PropagateTFDataAttrs(const FunctionLibraryDefinition& flib,
                           FunctionDefLibrary& fdef_lib) {
@@ -1055,7 +1239,10 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       {kGrapplerCategory, "*"});
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.clear();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -1164,11 +1351,117 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // Fingerprints of the function optimizations in this graph that don't
+  // depend on the function.
+  const bool use_cache = cfg_.experimental_cache_function_optimizations();
+  const uint64 context_fingerprint =
+      use_cache ? FunctionOptimizationContextFingerprint(cluster, producer,
+                                                         is_tpu_graph)
+                : 0;
+  // Fingerprints of single function definitions in `flib`.
+  absl::flat_hash_map<string, uint64> function_fingerprints;
+
+  // Makes the optimization of `func` from the functions in `flib`, and looks
+  // it up in the cache.
+  const auto prepare_optimization =
+      [&](const FunctionDef& func,
+          FunctionOptimization& optimization) -> Status {
+    const string& func_name = func.signature().name();
+    optimization.name = func_name;
+    // Make a GrapplerItem from a FunctionDef.
+    GrapplerFunctionItem& func_item = optimization.item;
+    TF_RETURN_IF_ERROR(
+        MakeGrapplerFunctionItem(func, flib, producer, &func_item));
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item.optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item.devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    if (use_cache) {
+      optimization.fingerprint = FingerprintCat64(
+          FingerprintCat64(
+              context_fingerprint,
+              FunctionFingerprint(func, flib, function_fingerprints)),
+          func_item.optimization_options().allow_non_differentiable_rewrites);
+      optimization.cached = FunctionOptimizationCache::Global().Lookup(
+          func_name, optimization.fingerprint);
+      if (optimization.cached != nullptr) {
+        VLOG(3) << "Found optimized function " << func_name << " in cache.";
+      }
+    }
+    return absl::OkStatus();
+  };
+
+  // Replaces the function of `optimization` in `flib` with its optimized
+  // version.
+  const auto finish_optimization =
+      [&](FunctionOptimization& optimization) -> Status {
+    const string& func_name = optimization.name;
+    function_fingerprints.erase(func_name);
+    if (optimization.cached != nullptr) {
+      for (const FunctionDef& func_def :
+           optimization.cached->added_functions) {
+        if (flib.Find(func_def.signature().name()) == nullptr) {
+          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+        }
+      }
+      return flib.ReplaceFunction(func_name,
+                                  optimization.cached->optimized_function);
+    }
+
+    // Function body optimization might have created new specialized
+    // functions for each instantiation context. Add them to the library.
+    FunctionOptimizationCache::Entry entry;
+    for (const FunctionDef& func_def :
+         optimization.optimized_graph.library().function()) {
+      if (flib.Find(func_def.signature().name()) == nullptr) {
+        TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+        if (use_cache) {
+          entry.added_functions.push_back(func_def);
+        }
+      }
+    }
+
+    // Convert optimized graph back to FunctionDef.
+    FunctionDef optimized_func;
+    GrapplerFunctionItem& func_item = optimization.item;
+    func_item.SwapFunctionBody(std::move(optimization.optimized_graph));
+    TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+
+    if (use_cache) {
+      entry.optimized_function = optimized_func;
+      FunctionOptimizationCache::Global().Insert(
+          func_name, optimization.fingerprint, std::move(entry));
+    }
+
+    // Replace optimized function with a new FunctionDef.
+    return flib.ReplaceFunction(func_name, optimized_func);
+  };
+
+  const int num_threads = cfg_.experimental_function_optimization_threads();
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    std::vector<const FunctionDef*> funcs;
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -1200,79 +1493,49 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    std::vector<FunctionOptimization> optimizations(funcs.size());
+    if (num_threads > 1 && funcs.size() > 1) {
+      // All functions of the pass are optimized against the library at the
+      // start of the pass, so they can be optimized concurrently. The results
+      // are applied in library order, which keeps the output deterministic.
+      for (size_t i = 0; i < funcs.size(); ++i) {
+        TF_RETURN_IF_ERROR(prepare_optimization(*funcs[i], optimizations[i]));
       }
-
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+      {
+        thread::ThreadPool pool(
+            Env::Default(), "optimize_functions",
+            std::min<int64_t>(num_threads, optimizations.size()));
+        for (FunctionOptimization& optimization : optimizations) {
+          if (optimization.cached != nullptr) continue;
+          pool.Schedule([&, optimization = &optimization] {
+            optimization->status = OptimizeFunctionBody(
+                cluster, is_tpu_graph, optimization->item,
+                &optimization->optimized_graph);
+          });
+        }
       }
-
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      for (FunctionOptimization& optimization : optimizations) {
+        TF_RETURN_IF_ERROR(optimization.status);
+        TF_RETURN_IF_ERROR(finish_optimization(optimization));
+      }
+    } else {
+      // Each function is optimized against the library with the functions
+      // optimized before it.
+      for (size_t i = 0; i < funcs.size(); ++i) {
+        GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+        FunctionOptimization& optimization = optimizations[i];
+        TF_RETURN_IF_ERROR(prepare_optimization(*funcs[i], optimization));
+        if (optimization.cached == nullptr) {
+          TF_RETURN_IF_ERROR(
+              OptimizeFunctionBody(cluster, is_tpu_graph, optimization.item,
+                                   &optimization.optimized_graph));
         }
+        TF_RETURN_IF_ERROR(finish_optimization(optimization));
+        optimization = FunctionOptimization();
       }
-
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
     }
 
     // If optimized at least one function, update the graph library.
@@ -1321,6 +1584,7 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
+  mutex_lock l(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     absl::StrAppend(&result_string,
                     "Optimization results for grappler item: ", graph_result.id,
@@ -1351,6 +1615,9 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.loop_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.dependency_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.auto_parallel().enable() ||
+         rewrite_cfg.precision_narrowing().enable() ||
+         rewrite_cfg.collective_bucketing().enable() ||
+         rewrite_cfg.optimizer_apply_fusion() == RewriterConfig::ON ||
          rewrite_cfg.memory_optimization() != RewriterConfig::NO_MEM_OPT ||
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
 #ifndef ENABLE_MKL
@@ -0,0 +1,246 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimizer_apply_fusion.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Suffix of the name of the node applying a group, after the name of the
+// first apply of the group.
+constexpr char kGroupSuffix[] = "/multi_apply";
+
+// The inputs of ResourceApplyAdam: var, m and v, the 6 hyperparameters, and
+// grad.
+constexpr int kNumVariableInputs = 3;
+constexpr int kNumHyperparameters = 6;
+constexpr int kNumApplyAdamInputs =
+    kNumVariableInputs + kNumHyperparameters + 1;
+
+struct Group {
+  std::vector<const NodeDef*> applies;
+  // The var, m and v inputs of the applies.
+  absl::flat_hash_set<std::string> variables;
+};
+
+bool IsOnCpu(const NodeDef& node, bool only_cpu_devices) {
+  // Unplaced nodes are placed on CPU if there is no other device.
+  if (node.device().empty()) return only_cpu_devices;
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+         parsed.has_type && parsed.type == DEVICE_CPU;
+}
+
+// Returns a key shared by the applies that may be grouped together, or the
+// empty string if `node` can't be grouped.
+std::string GroupKey(const NodeDef& node, const FrameView& frames,
+                     bool only_cpu_devices) {
+  if (node.op() != "ResourceApplyAdam" ||
+      NumNonControlInputs(node) != kNumApplyAdamInputs ||
+      frames.IsInFrame(node) || !IsOnCpu(node, only_cpu_devices)) {
+    return "";
+  }
+  std::vector<std::string> key = {node.device()};
+  // The hyperparameters are the same tensors, so that the group can use them.
+  for (int i = kNumVariableInputs; i < kNumVariableInputs + kNumHyperparameters;
+       ++i) {
+    key.push_back(node.input(i));
+  }
+  for (const char* attr : {"T", "use_locking", "use_nesterov"}) {
+    auto it = node.attr().find(attr);
+    key.push_back(it == node.attr().end() ? ""
+                                            : SummarizeAttrValue(it->second));
+  }
+  return absl::StrJoin(key, ";");
+}
+
+// Returns whether `node` depends on an apply of `group`, in which case it
+// can't be applied with them.
+bool DependsOnGroup(
+    const NodeDef& node, const Group& group,
+    const absl::flat_hash_map<std::string, const NodeDef*>& nodes,
+    const absl::flat_hash_map<const NodeDef*, int>& topo_index) {
+  absl::flat_hash_set<const NodeDef*> applies(group.applies.begin(),
+                                              group.applies.end());
+  int min_index = topo_index.at(&node);
+  for (const NodeDef* apply : group.applies) {
+    min_index = std::min(min_index, topo_index.at(apply));
+  }
+  std::vector<const NodeDef*> stack = {&node};
+  absl::flat_hash_set<const NodeDef*> visited = {&node};
+  while (!stack.empty()) {
+    const NodeDef* current = stack.back();
+    stack.pop_back();
+    for (const std::string& input : current->input()) {
+      auto it = nodes.find(NodeName(input));
+      if (it == nodes.end()) continue;
+      const NodeDef* fanin = it->second;
+      if (applies.contains(fanin)) return true;
+      // Nodes before the first apply can't depend on it.
+      if (topo_index.at(fanin) > min_index && visited.insert(fanin).second) {
+        stack.push_back(fanin);
+      }
+    }
+  }
+  return false;
+}
+
+// Replaces the applies of `group` by a _ResourceMultiApplyAdam node.
+void RewriteGroup(const Group& group,
+                  const absl::flat_hash_map<std::string, NodeDef*>& outputs,
+                  GraphDef* graph) {
+  const NodeDef& first = *group.applies[0];
+  const int num_applies = group.applies.size();
+
+  NodeDef* multi_apply = graph->add_node();
+  multi_apply->set_name(absl::StrCat(first.name(), kGroupSuffix));
+  multi_apply->set_op("_ResourceMultiApplyAdam");
+  multi_apply->set_device(first.device());
+  for (int i = 0; i < kNumVariableInputs; ++i) {
+    for (const NodeDef* apply : group.applies) {
+      multi_apply->add_input(apply->input(i));
+    }
+  }
+  for (int i = kNumVariableInputs; i < kNumVariableInputs + kNumHyperparameters;
+       ++i) {
+    multi_apply->add_input(first.input(i));
+  }
+  for (const NodeDef* apply : group.applies) {
+    multi_apply->add_input(apply->input(kNumApplyAdamInputs - 1));
+  }
+  absl::flat_hash_set<std::string> control_inputs;
+  for (const NodeDef* apply : group.applies) {
+    for (const std::string& input : apply->input()) {
+      if (IsControlInput(input) && control_inputs.insert(input).second) {
+        multi_apply->add_input(input);
+      }
+    }
+  }
+  *multi_apply->mutable_attr() = first.attr();
+  AddNodeAttr("N", num_applies, multi_apply);
+
+  const std::string control_input = AsControlDependency(multi_apply->name());
+  for (const NodeDef* apply : group.applies) {
+    NodeDef* node = outputs.at(apply->name());
+    node->set_op("NoOp");
+    node->clear_input();
+    node->add_input(control_input);
+    node->clear_attr();
+  }
+}
+
+}  // namespace
+
+Status OptimizerApplyFusion::Optimize(Cluster* cluster,
+                                      const GrapplerItem& item,
+                                      GraphDef* output) {
+  *output = item.graph;
+
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item.graph, &topo_order));
+  absl::flat_hash_map<std::string, const NodeDef*> nodes;
+  absl::flat_hash_map<const NodeDef*, int> topo_index;
+  int num_applies = 0;
+  for (int i = 0; i < topo_order.size(); ++i) {
+    nodes[topo_order[i]->name()] = topo_order[i];
+    topo_index[topo_order[i]] = i;
+    num_applies += topo_order[i]->op() == "ResourceApplyAdam";
+  }
+  if (num_applies < 2) return errors::Aborted("Nothing to do.");
+
+  bool only_cpu_devices = cluster != nullptr;
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      only_cpu_devices &= device.second.type() == DEVICE_CPU;
+    }
+  }
+  FrameView frames;
+  TF_RETURN_IF_ERROR(frames.InferFromGraph(item.graph));
+
+  std::vector<Group> groups;
+  absl::flat_hash_map<std::string, int> open_groups;
+  for (const NodeDef* node : topo_order) {
+    const std::string key = GroupKey(*node, frames, only_cpu_devices);
+    if (key.empty()) continue;
+    auto it = open_groups.find(key);
+    if (it != open_groups.end()) {
+      const Group& group = groups[it->second];
+      bool updates_group_variable = false;
+      for (int i = 0; i < kNumVariableInputs; ++i) {
+        updates_group_variable |= group.variables.contains(node->input(i));
+      }
+      if (updates_group_variable ||
+          DependsOnGroup(*node, group, nodes, topo_index)) {
+        open_groups.erase(it);
+        it = open_groups.end();
+      }
+    }
+    if (it == open_groups.end()) {
+      it = open_groups.emplace(key, groups.size()).first;
+      groups.emplace_back();
+    }
+    Group& group = groups[it->second];
+    group.applies.push_back(node);
+    for (int i = 0; i < kNumVariableInputs; ++i) {
+      group.variables.insert(node->input(i));
+    }
+  }
+
+  absl::flat_hash_map<std::string, NodeDef*> outputs;
+  for (NodeDef& node : *output->mutable_node()) {
+    outputs[node.name()] = &node;
+  }
+  int num_fused = 0;
+  int num_groups = 0;
+  for (const Group& group : groups) {
+    if (group.applies.size() < 2 ||
+        outputs.contains(
+            absl::StrCat(group.applies[0]->name(), kGroupSuffix))) {
+      continue;
+    }
+    RewriteGroup(group, outputs, output);
+    num_fused += group.applies.size();
+    ++num_groups;
+  }
+  if (num_groups == 0) return errors::Aborted("Nothing to do.");
+  VLOG(1) << "Fused " << num_fused << " optimizer applies into " << num_groups
+          << " groups";
+  return absl::OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,52 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_APPLY_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_APPLY_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Groups the ResourceApplyAdam nodes on CPU that share their hyperparameters
+// into _ResourceMultiApplyAdam nodes, which lock all their variables at once
+// and update them in a single parallel loop. With thousands of small
+// variables, this saves most of the per-kernel overhead of the update step.
+//
+// Applies are taken in topological order, and a new group is started when an
+// apply depends on the current group of its kind or updates one of its
+// variables. Each original apply becomes a NoOp with a control dependency on
+// its group, so its consumers are left unchanged.
+class OptimizerApplyFusion : public GraphOptimizer {
+ public:
+  OptimizerApplyFusion() {}
+  explicit OptimizerApplyFusion(RewriterConfig::Toggle opt_level) {}
+
+  ~OptimizerApplyFusion() override {}
+
+  string name() const override { return "optimizer_apply_fusion"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_APPLY_FUSION_H_
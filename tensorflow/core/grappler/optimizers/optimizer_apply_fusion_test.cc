@@ -0,0 +1,172 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimizer_apply_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+constexpr char kCpu[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+NodeDef Variable(const std::string& name) {
+  return NDef(name, "VarHandleOp", {},
+              {{"dtype", DT_FLOAT},
+               {"shape", TensorShape({2})},
+               {"container", ""},
+               {"shared_name", name}},
+              kCpu);
+}
+
+NodeDef Scalar(const std::string& name, float value) {
+  return NDef(name, "Const", {},
+              {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(value)}},
+              kCpu);
+}
+
+// Applies the gradient `grad` to the variable `var` and its slots.
+NodeDef ApplyAdam(const std::string& name, const std::string& var,
+                  const std::string& grad, const std::string& lr = "lr",
+                  const std::string& device = kCpu) {
+  return NDef(name, "ResourceApplyAdam",
+              {var, var + "_m", var + "_v", "beta1_power", "beta2_power", lr,
+               "beta1", "beta2", "epsilon", grad},
+              {{"T", DT_FLOAT},
+               {"use_locking", false},
+               {"use_nesterov", false}},
+              device);
+}
+
+class OptimizerApplyFusionTest : public GrapplerTest {
+ protected:
+  // Variables var0 to var3 with their slots, the hyperparameters, and
+  // gradients grad0 to grad3.
+  std::vector<NodeDef> MakeInputs() {
+    std::vector<NodeDef> nodes = {
+        Scalar("beta1_power", 0.9), Scalar("beta2_power", 0.999),
+        Scalar("lr", 0.1),          Scalar("other_lr", 0.01),
+        Scalar("beta1", 0.9),       Scalar("beta2", 0.999),
+        Scalar("epsilon", 1e-7)};
+    for (int i = 0; i < 4; ++i) {
+      const std::string var = "var" + std::to_string(i);
+      nodes.push_back(Variable(var));
+      nodes.push_back(Variable(var + "_m"));
+      nodes.push_back(Variable(var + "_v"));
+      nodes.push_back(NDef("grad" + std::to_string(i), "Placeholder", {},
+                           {{"dtype", DT_FLOAT}}, kCpu));
+    }
+    return nodes;
+  }
+};
+
+TEST_F(OptimizerApplyFusionTest, FusesAppliesSharingHyperparameters) {
+  std::vector<NodeDef> nodes = MakeInputs();
+  nodes.push_back(ApplyAdam("apply0", "var0", "grad0"));
+  nodes.push_back(ApplyAdam("apply1", "var1", "grad1"));
+  nodes.push_back(ApplyAdam("apply2", "var2", "grad2"));
+  // Another learning rate.
+  nodes.push_back(ApplyAdam("apply3", "var3", "grad3", "other_lr"));
+  nodes.push_back(NDef("train", "NoOp",
+                       {"^apply0", "^apply1", "^apply2", "^apply3"}, {},
+                       kCpu));
+  GrapplerItem item;
+  item.graph = test::function::GDef(nodes);
+  item.fetch = {"train"};
+
+  OptimizerApplyFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* multi_apply = node_map.GetNode("apply0/multi_apply");
+  ASSERT_NE(multi_apply, nullptr);
+  EXPECT_EQ(multi_apply->op(), "_ResourceMultiApplyAdam");
+  EXPECT_EQ(multi_apply->device(), kCpu);
+  EXPECT_EQ(multi_apply->attr().at("N").i(), 3);
+  const std::vector<std::string> expected_inputs = {
+      "var0",        "var1",        "var2",    "var0_m",  "var1_m",
+      "var2_m",      "var0_v",      "var1_v",  "var2_v",  "beta1_power",
+      "beta2_power", "lr",          "beta1",   "beta2",   "epsilon",
+      "grad0",       "grad1",       "grad2"};
+  EXPECT_EQ(std::vector<std::string>(multi_apply->input().begin(),
+                                     multi_apply->input().end()),
+            expected_inputs);
+  for (int i = 0; i < 3; ++i) {
+    const NodeDef* apply = node_map.GetNode("apply" + std::to_string(i));
+    EXPECT_EQ(apply->op(), "NoOp");
+    ASSERT_EQ(apply->input_size(), 1);
+    EXPECT_EQ(apply->input(0), "^apply0/multi_apply");
+  }
+  EXPECT_EQ(node_map.GetNode("apply3")->op(), "ResourceApplyAdam");
+}
+
+TEST_F(OptimizerApplyFusionTest, KeepsDependentAppliesApart) {
+  std::vector<NodeDef> nodes = MakeInputs();
+  nodes.push_back(ApplyAdam("apply0", "var0", "grad0"));
+  // Reads var0 after its update.
+  NodeDef apply1 = ApplyAdam("apply1", "var1", "grad1");
+  apply1.add_input("^apply0");
+  nodes.push_back(apply1);
+  // Updates var0 again.
+  nodes.push_back(ApplyAdam("apply2", "var0", "grad2"));
+  GrapplerItem item;
+  item.graph = test::function::GDef(nodes);
+  item.fetch = {"apply1", "apply2"};
+
+  OptimizerApplyFusion optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Only apply1 and apply2 can be applied together, after apply0.
+  NodeMap node_map(&output);
+  EXPECT_EQ(node_map.GetNode("apply0")->op(), "ResourceApplyAdam");
+  const NodeDef* multi_apply = node_map.GetNode("apply2/multi_apply");
+  ASSERT_NE(multi_apply, nullptr);
+  EXPECT_EQ(multi_apply->attr().at("N").i(), 2);
+  EXPECT_EQ(multi_apply->input(multi_apply->input_size() - 1), "^apply0");
+}
+
+TEST_F(OptimizerApplyFusionTest, SkipsAppliesOffCpu) {
+  std::vector<NodeDef> nodes = MakeInputs();
+  nodes.push_back(ApplyAdam("apply0", "var0", "grad0", "lr", "/device:GPU:0"));
+  nodes.push_back(ApplyAdam("apply1", "var1", "grad1", "lr", "/device:GPU:0"));
+  GrapplerItem item;
+  item.graph = test::function::GDef(nodes);
+  item.fetch = {"apply0", "apply1"};
+
+  OptimizerApplyFusion optimizer;
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimizer_telemetry.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace grappler {
+
+/* static */
+OptimizerTelemetry* OptimizerTelemetry::Global() {
+  static OptimizerTelemetry* telemetry = new OptimizerTelemetry();
+  return telemetry;
+}
+
+void OptimizerTelemetry::RecordRun(
+    const std::string& model, const std::string& pass, int64_t time_usecs,
+    int64_t node_count_delta,
+    std::optional<int64_t> predicted_cost_delta_usecs) {
+  metrics::RecordGrapplerPassRun(model, pass, time_usecs, node_count_delta,
+                                 predicted_cost_delta_usecs);
+  if (!predicted_cost_delta_usecs.has_value()) return;
+  mutex_lock l(mu_);
+  int& num_unprofitable_runs = num_unprofitable_runs_[{model, pass}];
+  if (*predicted_cost_delta_usecs < 0) {
+    num_unprofitable_runs = 0;
+  } else if (time_usecs >= kMinUnprofitableTimeUsecs) {
+    ++num_unprofitable_runs;
+  }
+}
+
+bool OptimizerTelemetry::IsUnprofitable(const std::string& model,
+                                        const std::string& pass) const {
+  mutex_lock l(mu_);
+  auto it = num_unprofitable_runs_.find({model, pass});
+  return it != num_unprofitable_runs_.end() &&
+         it->second >= kUnprofitableRunsToDisable;
+}
+
+absl::StatusOr<int64_t> PredictGraphCostUsecs(const GrapplerItem& item) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(
+      properties.InferStatically(/*assume_valid_feeds=*/false,
+                                 /*aggressive_shape_inference=*/false,
+                                 /*include_tensor_values=*/false));
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  OpLevelCostEstimator estimator;
+  Costs::NanoSeconds execution_time(0);
+  for (const NodeDef& node : item.graph.node()) {
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.op_info = BuildOpInfoWithoutDevice(
+        node, name_to_node, properties.GetInputProperties(node.name()));
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    *op_context.op_info.mutable_device() = GetDeviceInfo(node.device());
+    execution_time += estimator.PredictCosts(op_context).execution_time;
+  }
+  return execution_time.asMicroSeconds().count();
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
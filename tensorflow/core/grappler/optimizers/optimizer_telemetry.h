@@ -0,0 +1,75 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_TELEMETRY_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_TELEMETRY_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Records the runs of the Grappler optimizers on the graphs of each model and
+// exports them as the /tensorflow/core/grappler/pass_* metrics. It also keeps
+// track of the optimizers that consistently take time without reducing the
+// predicted cost of the graphs of a model, so the meta-optimizer can skip them.
+class OptimizerTelemetry {
+ public:
+  // Number of consecutive unprofitable runs after which an optimizer is
+  // considered unprofitable for a model.
+  static constexpr int kUnprofitableRunsToDisable = 3;
+
+  // Runs that take less time than this are never unprofitable.
+  static constexpr int64_t kMinUnprofitableTimeUsecs = 1000;
+
+  // Returns the telemetry of the process.
+  static OptimizerTelemetry* Global();
+
+  // Records a run of the optimizer `pass` on a graph of `model`, see
+  // metrics::RecordGrapplerPassRun. A run is unprofitable if it took at least
+  // kMinUnprofitableTimeUsecs and did not reduce the predicted cost.
+  void RecordRun(const std::string& model, const std::string& pass,
+                 int64_t time_usecs, int64_t node_count_delta,
+                 std::optional<int64_t> predicted_cost_delta_usecs);
+
+  // Returns true if the last kUnprofitableRunsToDisable runs of `pass` on the
+  // graphs of `model` with an estimated cost were unprofitable.
+  bool IsUnprofitable(const std::string& model, const std::string& pass) const;
+
+ private:
+  mutable mutex mu_;
+  // Number of consecutive unprofitable runs of each (model, pass).
+  absl::flat_hash_map<std::pair<std::string, std::string>, int>
+      num_unprofitable_runs_ TF_GUARDED_BY(mu_);
+};
+
+// Returns the run time of the graph of `item` predicted by
+// OpLevelCostEstimator from statically inferred shapes, as the sum of the
+// predicted execution times of its nodes.
+absl::StatusOr<int64_t> PredictGraphCostUsecs(const GrapplerItem& item);
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZER_TELEMETRY_H_
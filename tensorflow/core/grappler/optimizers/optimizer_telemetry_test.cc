@@ -0,0 +1,108 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimizer_telemetry.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using ::tensorflow::monitoring::testing::CellReader;
+
+constexpr int64_t kSlowRunUsecs = OptimizerTelemetry::kMinUnprofitableTimeUsecs;
+
+GrapplerItem MatMulItem(int64_t size) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({size, size}));
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({size, size}));
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"matmul"};
+  return item;
+}
+
+TEST(OptimizerTelemetryTest, ExportsPassRuns) {
+  CellReader<int64_t> runs("/tensorflow/core/grappler/pass_runs");
+  CellReader<int64_t> time("/tensorflow/core/grappler/pass_time_usecs");
+  CellReader<int64_t> nodes_removed(
+      "/tensorflow/core/grappler/pass_nodes_removed");
+  CellReader<int64_t> cost_removed(
+      "/tensorflow/core/grappler/pass_predicted_cost_removed_usecs");
+
+  OptimizerTelemetry telemetry;
+  telemetry.RecordRun("model", "pass", 10, -3, -5);
+  telemetry.RecordRun("model", "pass", 20, -1, std::nullopt);
+  EXPECT_EQ(runs.Delta("model", "pass"), 2);
+  EXPECT_EQ(time.Delta("model", "pass"), 30);
+  EXPECT_EQ(nodes_removed.Delta("model", "pass"), 4);
+  EXPECT_EQ(cost_removed.Delta("model", "pass"), 5);
+}
+
+TEST(OptimizerTelemetryTest, DisablesUnprofitablePass) {
+  OptimizerTelemetry telemetry;
+  for (int i = 0; i < OptimizerTelemetry::kUnprofitableRunsToDisable; ++i) {
+    EXPECT_FALSE(telemetry.IsUnprofitable("model", "pass"));
+    telemetry.RecordRun("model", "pass", kSlowRunUsecs, 0, 0);
+  }
+  EXPECT_TRUE(telemetry.IsUnprofitable("model", "pass"));
+  EXPECT_FALSE(telemetry.IsUnprofitable("other_model", "pass"));
+  EXPECT_FALSE(telemetry.IsUnprofitable("model", "other_pass"));
+}
+
+TEST(OptimizerTelemetryTest, ProfitableRunResetsUnprofitableRuns) {
+  OptimizerTelemetry telemetry;
+  for (int i = 1; i < OptimizerTelemetry::kUnprofitableRunsToDisable; ++i) {
+    telemetry.RecordRun("model", "pass", kSlowRunUsecs, 0, 0);
+  }
+  telemetry.RecordRun("model", "pass", kSlowRunUsecs, 0, -1);
+  telemetry.RecordRun("model", "pass", kSlowRunUsecs, 0, 0);
+  EXPECT_FALSE(telemetry.IsUnprofitable("model", "pass"));
+}
+
+TEST(OptimizerTelemetryTest, KeepsFastAndUnestimatedPasses) {
+  OptimizerTelemetry telemetry;
+  for (int i = 0; i < OptimizerTelemetry::kUnprofitableRunsToDisable; ++i) {
+    telemetry.RecordRun("model", "fast_pass", kSlowRunUsecs - 1, 0, 0);
+    telemetry.RecordRun("model", "unestimated_pass", kSlowRunUsecs, 0,
+                        std::nullopt);
+  }
+  EXPECT_FALSE(telemetry.IsUnprofitable("model", "fast_pass"));
+  EXPECT_FALSE(telemetry.IsUnprofitable("model", "unestimated_pass"));
+}
+
+TEST(OptimizerTelemetryTest, PredictsGraphCost) {
+  TF_ASSERT_OK_AND_ASSIGN(int64_t small_cost,
+                          PredictGraphCostUsecs(MatMulItem(64)));
+  TF_ASSERT_OK_AND_ASSIGN(int64_t large_cost,
+                          PredictGraphCostUsecs(MatMulItem(1024)));
+  EXPECT_GE(small_cost, 0);
+  EXPECT_GT(large_cost, small_cost);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,555 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/precision_narrowing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Suffix of the name of the node that runs a narrowed candidate. The
+// candidate itself is turned into the conversion of its output back to float,
+// so that its consumers and fetches are left unchanged.
+constexpr char kNarrowedSuffix[] = "/narrowed";
+
+using Feed = std::vector<std::pair<std::string, Tensor>>;
+
+std::string TensorKey(absl::string_view node, int index) {
+  return absl::StrCat(node, ":", index);
+}
+
+bool IsNarrowingCandidate(const NodeDef& node) {
+  // The inputs and output of these ops all have type T.
+  static const auto* const kCandidateOps = new absl::flat_hash_set<std::string>{
+      "BatchMatMul", "BatchMatMulV2",         "Conv2D",
+      "Conv3D",      "DepthwiseConv2dNative", "MatMul"};
+  if (!kCandidateOps->contains(node.op())) return false;
+  DataType type;
+  if (!GetNodeAttr(node, "T", &type).ok() || type != DT_FLOAT) return false;
+  DeviceNameUtils::ParsedName device;
+  return node.device().empty() ||
+         (DeviceNameUtils::ParseFullName(node.device(), &device) &&
+          (!device.has_type || device.type == DEVICE_CPU));
+}
+
+// Returns the precisions to try for a candidate, most aggressive first.
+std::vector<DataType> CandidatePrecisions(
+    absl::string_view op, const PrecisionNarrowingOptions& options) {
+  std::vector<DataType> precisions;
+  if (options.enable_int8() && op == "MatMul") {
+    precisions.push_back(DT_QUINT8);
+  }
+  precisions.push_back(DT_BFLOAT16);
+  return precisions;
+}
+
+// Returns the nodes that `fetch` depends on through data edges, in
+// topological order. The inputs of the nodes in `fed_nodes` are not followed.
+absl::StatusOr<std::vector<const NodeDef*>> DataFaninInTopologicalOrder(
+    const GraphDef& graph, const absl::flat_hash_set<std::string>& fed_nodes,
+    const std::vector<std::string>& fetch) {
+  absl::flat_hash_map<absl::string_view, const NodeDef*> nodes;
+  for (const NodeDef& node : graph.node()) {
+    nodes[node.name()] = &node;
+  }
+  auto find_node = [&](absl::string_view tensor) -> const NodeDef* {
+    auto it = nodes.find(ParseTensorName(tensor).node());
+    return it == nodes.end() ? nullptr : it->second;
+  };
+
+  std::vector<const NodeDef*> order;
+  // A node maps to false while its fanin is being visited, and to true once
+  // it is in `order`.
+  absl::flat_hash_map<const NodeDef*, bool> visited;
+  // Nodes to visit, and whether their fanin was already pushed.
+  std::vector<std::pair<const NodeDef*, bool>> stack;
+  for (const std::string& tensor : fetch) {
+    const NodeDef* node = find_node(tensor);
+    if (node == nullptr) {
+      return errors::InvalidArgument("Fetch ", tensor, " is not in the graph.");
+    }
+    stack.emplace_back(node, false);
+  }
+  while (!stack.empty()) {
+    const auto [node, fanin_pushed] = stack.back();
+    stack.pop_back();
+    if (fanin_pushed) {
+      visited[node] = true;
+      order.push_back(node);
+      continue;
+    }
+    auto it = visited.find(node);
+    if (it != visited.end()) {
+      if (!it->second) {
+        return errors::InvalidArgument("The fanin of ", node->name(),
+                                       " has a cycle.");
+      }
+      continue;
+    }
+    visited[node] = false;
+    stack.emplace_back(node, true);
+    if (fed_nodes.contains(node->name())) continue;
+    for (const std::string& input : node->input()) {
+      if (IsControlInput(input)) break;
+      const NodeDef* fanin = find_node(input);
+      if (fanin == nullptr) {
+        return errors::InvalidArgument("Input ", input, " of ", node->name(),
+                                       " is not in the graph.");
+      }
+      stack.emplace_back(fanin, false);
+    }
+  }
+  return order;
+}
+
+absl::flat_hash_set<std::string> FedNodes(const Feed& feed) {
+  absl::flat_hash_set<std::string> fed_nodes;
+  for (const auto& fed : feed) {
+    fed_nodes.insert(std::string(ParseTensorName(fed.first).node()));
+  }
+  return fed_nodes;
+}
+
+// Runs graphs on the CPU, one node at a time.
+class GraphEvaluator {
+ public:
+  // Returns the values of `fetch` in `graph` given the values of `feed`.
+  absl::StatusOr<std::vector<Tensor>> Evaluate(
+      const GraphDef& graph, const Feed& feed,
+      const std::vector<std::string>& fetch);
+
+ private:
+  DeviceSimple device_;
+  ResourceMgr resource_mgr_;
+};
+
+absl::StatusOr<std::vector<Tensor>> GraphEvaluator::Evaluate(
+    const GraphDef& graph, const Feed& feed,
+    const std::vector<std::string>& fetch) {
+  const absl::flat_hash_set<std::string> fed_nodes = FedNodes(feed);
+  TF_ASSIGN_OR_RETURN(std::vector<const NodeDef*> order,
+                      DataFaninInTopologicalOrder(graph, fed_nodes, fetch));
+
+  absl::flat_hash_map<std::string, Tensor> values;
+  for (const auto& [name, value] : feed) {
+    const TensorId id = ParseTensorName(name);
+    values[TensorKey(id.node(), id.index())] = value;
+  }
+  auto find_value = [&](absl::string_view tensor) -> absl::StatusOr<Tensor*> {
+    const TensorId id = ParseTensorName(tensor);
+    auto it = values.find(TensorKey(id.node(), id.index()));
+    if (it == values.end()) {
+      return errors::InvalidArgument("Tensor ", tensor, " is not fed.");
+    }
+    return &it->second;
+  };
+
+  for (const NodeDef* node : order) {
+    if (fed_nodes.contains(node->name())) continue;
+    if (IsConstant(*node)) {
+      Tensor value;
+      if (!value.FromProto(node->attr().at("value").tensor())) {
+        return errors::InvalidArgument("Invalid value of ", node->name());
+      }
+      values[TensorKey(node->name(), 0)] = std::move(value);
+      continue;
+    }
+    const OpDef* op_def;
+    TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node->op(), &op_def));
+    if (op_def->is_stateful()) {
+      return errors::FailedPrecondition("Cannot evaluate the stateful node ",
+                                        node->name());
+    }
+
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    for (const std::string& input : node->input()) {
+      if (IsControlInput(input)) break;
+      TF_ASSIGN_OR_RETURN(Tensor * value, find_value(input));
+      inputs.emplace_back(value);
+    }
+    gtl::InlinedVector<TensorValue, 4> outputs;
+    const Status s =
+        EvaluateNode(*node, inputs, &device_, &resource_mgr_, &outputs);
+    for (int i = 0; i < outputs.size(); ++i) {
+      if (s.ok()) values[TensorKey(node->name(), i)] = *outputs[i].tensor;
+      delete outputs[i].tensor;
+    }
+    TF_RETURN_IF_ERROR(s);
+  }
+
+  std::vector<Tensor> fetched;
+  fetched.reserve(fetch.size());
+  for (const std::string& tensor : fetch) {
+    TF_ASSIGN_OR_RETURN(Tensor * value, find_value(tensor));
+    fetched.push_back(*value);
+  }
+  return fetched;
+}
+
+template <typename T>
+double RelativeError(const Tensor& reference, const Tensor& output) {
+  auto reference_values = reference.flat<T>();
+  auto output_values = output.flat<T>();
+  double max_error = 0.0;
+  double max_magnitude = 0.0;
+  for (int64_t i = 0; i < reference_values.size(); ++i) {
+    const double expected = static_cast<double>(reference_values(i));
+    const double actual = static_cast<double>(output_values(i));
+    if (std::isnan(expected) || std::isnan(actual)) {
+      if (std::isnan(expected) != std::isnan(actual)) {
+        return std::numeric_limits<double>::infinity();
+      }
+      continue;
+    }
+    max_error = std::max(max_error, std::abs(actual - expected));
+    max_magnitude = std::max(max_magnitude, std::abs(expected));
+  }
+  return max_magnitude > 0.0 ? max_error / max_magnitude : max_error;
+}
+
+double MismatchRate(const Tensor& reference, const Tensor& output) {
+  const int64_t num_elements = reference.NumElements();
+  if (num_elements == 0) return 0.0;
+  int64_t num_mismatches = 0;
+  if (reference.dtype() == DT_STRING) {
+    auto reference_values = reference.flat<tstring>();
+    auto output_values = output.flat<tstring>();
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (reference_values(i) != output_values(i)) ++num_mismatches;
+    }
+  } else if (DataTypeCanUseMemcpy(reference.dtype())) {
+    const size_t size = DataTypeSize(reference.dtype());
+    const absl::string_view reference_data = reference.tensor_data();
+    const absl::string_view output_data = output.tensor_data();
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (reference_data.substr(i * size, size) !=
+          output_data.substr(i * size, size)) {
+        ++num_mismatches;
+      }
+    }
+  } else {
+    return std::numeric_limits<double>::infinity();
+  }
+  return static_cast<double>(num_mismatches) / num_elements;
+}
+
+// Returns the error of `output` with respect to `reference`, see
+// PrecisionNarrowingOptions.output_error_tolerance.
+double OutputError(const Tensor& reference, const Tensor& output) {
+  if (reference.dtype() != output.dtype() ||
+      reference.shape() != output.shape()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  switch (reference.dtype()) {
+    case DT_FLOAT:
+      return RelativeError<float>(reference, output);
+    case DT_DOUBLE:
+      return RelativeError<double>(reference, output);
+    case DT_HALF:
+      return RelativeError<Eigen::half>(reference, output);
+    case DT_BFLOAT16:
+      return RelativeError<bfloat16>(reference, output);
+    default:
+      return MismatchRate(reference, output);
+  }
+}
+
+NodeDef* AddNode(const std::string& name, const std::string& op,
+                 const std::string& device, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  node->set_device(device);
+  return node;
+}
+
+// Turns `node` into a Cast of `input` from `src_type` to `dst_type`.
+void SetCast(const std::string& input, DataType src_type, DataType dst_type,
+             NodeDef* node) {
+  node->set_op("Cast");
+  node->clear_input();
+  node->add_input(input);
+  node->clear_attr();
+  auto& attr = *node->mutable_attr();
+  attr["SrcT"].set_type(src_type);
+  attr["DstT"].set_type(dst_type);
+  attr["Truncate"].set_b(false);
+}
+
+bool IsCastOf(const NodeDef& node, DataType src_type, DataType dst_type) {
+  if (!IsCast(node)) return false;
+  DataType src, dst;
+  return GetNodeAttr(node, "SrcT", &src).ok() &&
+         GetNodeAttr(node, "DstT", &dst).ok() && src == src_type &&
+         dst == dst_type;
+}
+
+// Runs `candidate` in bfloat16. The conversion of an input back from bfloat16
+// is skipped, since converting it to bfloat16 again is lossless, so that
+// chains of narrowed nodes stay in bfloat16.
+void NarrowToBfloat16(
+    const absl::flat_hash_map<absl::string_view, const NodeDef*>& nodes,
+    NodeDef* candidate, GraphDef* graph) {
+  const std::string name = candidate->name();
+  NodeDef* narrowed = graph->add_node();
+  *narrowed = *candidate;
+  narrowed->set_name(absl::StrCat(name, kNarrowedSuffix));
+  (*narrowed->mutable_attr())["T"].set_type(DT_BFLOAT16);
+  for (int i = 0; i < narrowed->input_size(); ++i) {
+    const std::string input = narrowed->input(i);
+    if (IsControlInput(input)) break;
+    const TensorId id = ParseTensorName(input);
+    auto it = nodes.find(id.node());
+    if (it != nodes.end() && id.index() == 0 &&
+        IsCastOf(*it->second, DT_BFLOAT16, DT_FLOAT)) {
+      narrowed->set_input(i, it->second->input(0));
+      continue;
+    }
+    NodeDef* cast = AddNode(absl::StrCat(narrowed->name(), "/input_", i),
+                            "Cast", narrowed->device(), graph);
+    SetCast(input, DT_FLOAT, DT_BFLOAT16, cast);
+    narrowed->set_input(i, cast->name());
+  }
+  SetCast(narrowed->name(), DT_BFLOAT16, DT_FLOAT, candidate);
+}
+
+// Runs the MatMul `candidate` on its inputs quantized to 8 bits with the range
+// of their values, and dequantizes its 32-bit result.
+void NarrowToInt8(NodeDef* candidate, GraphDef* graph) {
+  const std::string narrowed_name =
+      absl::StrCat(candidate->name(), kNarrowedSuffix);
+  const std::string& device = candidate->device();
+
+  NodeDef* axes = AddNode(absl::StrCat(narrowed_name, "/axes"), "Const",
+                          device, graph);
+  Tensor axes_value(DT_INT32, TensorShape({2}));
+  axes_value.vec<int32_t>()(0) = 0;
+  axes_value.vec<int32_t>()(1) = 1;
+  (*axes->mutable_attr())["dtype"].set_type(DT_INT32);
+  axes_value.AsProtoTensorContent(
+      (*axes->mutable_attr())["value"].mutable_tensor());
+
+  NodeDef* narrowed = AddNode(narrowed_name, "QuantizedMatMul", device, graph);
+  std::string quantized[2];
+  for (int i = 0; i < 2; ++i) {
+    const std::string prefix = absl::StrCat(narrowed_name, "/input_", i);
+    NodeDef* quantize = AddNode(absl::StrCat(prefix, "/quantize"),
+                                "QuantizeV2", device, graph);
+    quantize->add_input(candidate->input(i));
+    for (const char* reduction : {"Min", "Max"}) {
+      NodeDef* range = AddNode(absl::StrCat(prefix, "/", reduction), reduction,
+                               device, graph);
+      range->add_input(candidate->input(i));
+      range->add_input(axes->name());
+      auto& attr = *range->mutable_attr();
+      attr["T"].set_type(DT_FLOAT);
+      attr["Tidx"].set_type(DT_INT32);
+      attr["keep_dims"].set_b(false);
+      quantize->add_input(range->name());
+    }
+    (*quantize->mutable_attr())["T"].set_type(DT_QUINT8);
+    (*quantize->mutable_attr())["mode"].set_s("MIN_FIRST");
+    quantized[i] = quantize->name();
+  }
+
+  for (int i = 0; i < 2; ++i) narrowed->add_input(quantized[i]);
+  for (int i = 0; i < 2; ++i) {
+    narrowed->add_input(absl::StrCat(quantized[i], ":1"));
+    narrowed->add_input(absl::StrCat(quantized[i], ":2"));
+  }
+  for (int i = 2; i < candidate->input_size(); ++i) {
+    narrowed->add_input(candidate->input(i));
+  }
+  auto& attr = *narrowed->mutable_attr();
+  attr["T1"].set_type(DT_QUINT8);
+  attr["T2"].set_type(DT_QUINT8);
+  attr["Toutput"].set_type(DT_QINT32);
+  attr["Tactivation"].set_type(DT_QUINT8);
+  for (const char* transpose : {"transpose_a", "transpose_b"}) {
+    bool value = false;
+    TryGetNodeAttr(*candidate, transpose, &value);
+    attr[transpose].set_b(value);
+  }
+
+  candidate->set_op("Dequantize");
+  candidate->clear_input();
+  candidate->add_input(narrowed_name);
+  candidate->add_input(absl::StrCat(narrowed_name, ":1"));
+  candidate->add_input(absl::StrCat(narrowed_name, ":2"));
+  candidate->clear_attr();
+  (*candidate->mutable_attr())["T"].set_type(DT_QINT32);
+  (*candidate->mutable_attr())["mode"].set_s("MIN_FIRST");
+}
+
+// Narrows the candidate `name` of `graph` to `precision`.
+Status Narrow(const std::string& name, DataType precision, GraphDef* graph) {
+  absl::flat_hash_map<absl::string_view, const NodeDef*> nodes;
+  NodeDef* candidate = nullptr;
+  for (NodeDef& node : *graph->mutable_node()) {
+    nodes[node.name()] = &node;
+    if (node.name() == name) candidate = &node;
+  }
+  if (candidate == nullptr) {
+    return errors::NotFound("Candidate ", name, " is not in the graph.");
+  }
+  switch (precision) {
+    case DT_BFLOAT16:
+      NarrowToBfloat16(nodes, candidate, graph);
+      return OkStatus();
+    case DT_QUINT8:
+      if (candidate->op() != "MatMul") break;
+      NarrowToInt8(candidate, graph);
+      return OkStatus();
+    default:
+      break;
+  }
+  return errors::InvalidArgument("Cannot narrow ", name, " to ",
+                                 DataTypeString(precision));
+}
+
+}  // namespace
+
+Status PrecisionNarrowing::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                    GraphDef* output) {
+  *output = item.graph;
+  plan_.Clear();
+  if (options_.calibration_data_path().empty()) {
+    return errors::InvalidArgument(
+        "Precision narrowing needs a calibration_data_path.");
+  }
+  if (item.fetch.empty()) return errors::Aborted("Nothing to do.");
+
+  PrecisionCalibrationData calibration_data;
+  TF_RETURN_IF_ERROR(ReadTextOrBinaryProto(
+      Env::Default(), options_.calibration_data_path(), &calibration_data));
+  std::vector<Feed> feeds;
+  for (const PrecisionCalibrationData::Sample& sample :
+       calibration_data.sample()) {
+    Feed& feed = feeds.emplace_back();
+    for (const NamedTensorProto& fed : sample.feed()) {
+      Tensor value;
+      if (!value.FromProto(fed.tensor())) {
+        return errors::InvalidArgument("Invalid calibration value of ",
+                                       fed.name());
+      }
+      feed.emplace_back(fed.name(), std::move(value));
+    }
+  }
+  if (feeds.empty()) {
+    return errors::InvalidArgument("Calibration data ",
+                                   options_.calibration_data_path(),
+                                   " has no samples.");
+  }
+
+  GraphEvaluator evaluator;
+  std::vector<std::vector<Tensor>> references;
+  for (const Feed& feed : feeds) {
+    TF_ASSIGN_OR_RETURN(std::vector<Tensor> reference,
+                        evaluator.Evaluate(item.graph, feed, item.fetch));
+    references.push_back(std::move(reference));
+  }
+  auto output_error = [&](const GraphDef& graph) -> absl::StatusOr<double> {
+    double error = 0.0;
+    for (int i = 0; i < feeds.size(); ++i) {
+      TF_ASSIGN_OR_RETURN(std::vector<Tensor> outputs,
+                          evaluator.Evaluate(graph, feeds[i], item.fetch));
+      for (int j = 0; j < outputs.size(); ++j) {
+        error = std::max(error, OutputError(references[i][j], outputs[j]));
+      }
+    }
+    return error;
+  };
+
+  std::vector<std::pair<std::string, std::string>> candidates;
+  TF_ASSIGN_OR_RETURN(
+      std::vector<const NodeDef*> order,
+      DataFaninInTopologicalOrder(item.graph, FedNodes(feeds[0]), item.fetch));
+  for (const NodeDef* node : order) {
+    if (IsNarrowingCandidate(*node)) {
+      candidates.emplace_back(node->name(), node->op());
+    }
+  }
+
+  GraphDef graph = item.graph;
+  double error = 0.0;
+  bool narrowed_any = false;
+  for (const auto& [name, op] : candidates) {
+    PrecisionPlan::Node* plan_node = plan_.add_node();
+    plan_node->set_name(name);
+    plan_node->set_op(op);
+    plan_node->set_precision(DT_FLOAT);
+    for (DataType precision : CandidatePrecisions(op, options_)) {
+      GraphDef narrowed = graph;
+      TF_RETURN_IF_ERROR(Narrow(name, precision, &narrowed));
+      absl::StatusOr<double> narrowed_error = output_error(narrowed);
+      if (!narrowed_error.ok()) {
+        VLOG(1) << "Cannot run " << name << " in "
+                << DataTypeString(precision) << ": "
+                << narrowed_error.status();
+        continue;
+      }
+      VLOG(2) << "Output error with " << name << " in "
+              << DataTypeString(precision) << ": " << *narrowed_error;
+      if (*narrowed_error > options_.output_error_tolerance()) continue;
+      graph = std::move(narrowed);
+      error = *narrowed_error;
+      plan_node->set_precision(precision);
+      narrowed_any = true;
+      break;
+    }
+    plan_node->set_output_error(error);
+  }
+  plan_.set_output_error(error);
+  VLOG(1) << "Precision plan: " << plan_.DebugString();
+  if (!options_.precision_plan_path().empty()) {
+    TF_RETURN_IF_ERROR(WriteTextProto(
+        Env::Default(), options_.precision_plan_path(), plan_));
+  }
+
+  if (!narrowed_any) return errors::Aborted("Nothing to do.");
+  *output = std::move(graph);
+  return OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,58 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PRECISION_NARROWING_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PRECISION_NARROWING_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/precision_narrowing.pb.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Narrows the float MatMul and convolution nodes placed on the CPU to
+// bfloat16, or MatMul to int8 inputs quantized at run time, where this keeps
+// the fetched outputs of the graph on the calibration data within
+// options.output_error_tolerance(). Unlike AutoMixedPrecision, which decides
+// from fixed op lists, every narrowing is checked by running the graph on the
+// CPU, one node at a time as constant folding does, so the graph must be a
+// stateless inference graph fed through its placeholders.
+class PrecisionNarrowing : public GraphOptimizer {
+ public:
+  explicit PrecisionNarrowing(const PrecisionNarrowingOptions& options)
+      : options_(options) {}
+
+  ~PrecisionNarrowing() override {}
+
+  string name() const override { return "precision_narrowing"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* output) override;
+
+  // The precision plan of the last optimized graph.
+  const PrecisionPlan& plan() const { return plan_; }
+
+ private:
+  const PrecisionNarrowingOptions options_;
+  PrecisionPlan plan_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PRECISION_NARROWING_H_
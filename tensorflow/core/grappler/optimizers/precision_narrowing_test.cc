@@ -0,0 +1,152 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/precision_narrowing.h"
+
+#include <string>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/precision_narrowing.pb.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  return tensor;
+}
+
+// Returns an item that multiplies the fed "x" by two constant matrices.
+GrapplerItem MatMulChainItem() {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({4, 16}));
+  Output w1 = ops::Const(s.WithOpName("w1"), RandomTensor({16, 16}));
+  Output w2 = ops::Const(s.WithOpName("w2"), RandomTensor({16, 8}));
+  Output matmul1 = ops::MatMul(s.WithOpName("matmul1"), x, w1);
+  Output matmul2 = ops::MatMul(s.WithOpName("matmul2"), matmul1, w2);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"matmul2"};
+  return item;
+}
+
+PrecisionNarrowingOptions OptionsWithCalibrationData(float tolerance) {
+  PrecisionCalibrationData calibration_data;
+  for (int i = 0; i < 3; ++i) {
+    NamedTensorProto* feed = calibration_data.add_sample()->add_feed();
+    feed->set_name("x");
+    RandomTensor({4, 16}).AsProtoTensorContent(feed->mutable_tensor());
+  }
+  PrecisionNarrowingOptions options;
+  options.set_enable(true);
+  options.set_calibration_data_path(
+      io::JoinPath(testing::TmpDir(), "calibration_data.pb"));
+  TF_CHECK_OK(WriteBinaryProto(Env::Default(),
+                               options.calibration_data_path(),
+                               calibration_data));
+  options.set_output_error_tolerance(tolerance);
+  return options;
+}
+
+const NodeDef* FindNode(const GraphDef& graph, const std::string& name) {
+  for (const NodeDef& node : graph.node()) {
+    if (node.name() == name) return &node;
+  }
+  return nullptr;
+}
+
+TEST(PrecisionNarrowingTest, NarrowsToBfloat16WithinTolerance) {
+  PrecisionNarrowing optimizer(OptionsWithCalibrationData(0.05));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, MatMulChainItem(), &output));
+
+  ASSERT_EQ(optimizer.plan().node_size(), 2);
+  EXPECT_EQ(optimizer.plan().node(0).name(), "matmul1");
+  EXPECT_EQ(optimizer.plan().node(0).precision(), DT_BFLOAT16);
+  EXPECT_EQ(optimizer.plan().node(1).name(), "matmul2");
+  EXPECT_EQ(optimizer.plan().node(1).precision(), DT_BFLOAT16);
+  EXPECT_LE(optimizer.plan().output_error(), 0.05);
+
+  const NodeDef* matmul2 = FindNode(output, "matmul2");
+  ASSERT_NE(matmul2, nullptr);
+  EXPECT_EQ(matmul2->op(), "Cast");
+  EXPECT_EQ(matmul2->input(0), "matmul2/narrowed");
+  const NodeDef* narrowed = FindNode(output, "matmul2/narrowed");
+  ASSERT_NE(narrowed, nullptr);
+  EXPECT_EQ(narrowed->op(), "MatMul");
+  EXPECT_EQ(narrowed->attr().at("T").type(), DT_BFLOAT16);
+  // The output of matmul1 is not converted back and forth.
+  EXPECT_EQ(narrowed->input(0), "matmul1/narrowed");
+}
+
+TEST(PrecisionNarrowingTest, KeepsFloatOutsideTolerance) {
+  PrecisionNarrowing optimizer(OptionsWithCalibrationData(1e-7));
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(
+      optimizer.Optimize(nullptr, MatMulChainItem(), &output)));
+  ASSERT_EQ(optimizer.plan().node_size(), 2);
+  EXPECT_EQ(optimizer.plan().node(0).precision(), DT_FLOAT);
+  EXPECT_EQ(optimizer.plan().node(1).precision(), DT_FLOAT);
+}
+
+TEST(PrecisionNarrowingTest, TriesInt8First) {
+  PrecisionNarrowingOptions options = OptionsWithCalibrationData(0.25);
+  options.set_enable_int8(true);
+  options.set_precision_plan_path(
+      io::JoinPath(testing::TmpDir(), "precision_plan.pbtxt"));
+  PrecisionNarrowing optimizer(options);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, MatMulChainItem(), &output));
+
+  ASSERT_EQ(optimizer.plan().node_size(), 2);
+  EXPECT_EQ(optimizer.plan().node(0).precision(), DT_QUINT8);
+  const NodeDef* matmul1 = FindNode(output, "matmul1");
+  ASSERT_NE(matmul1, nullptr);
+  EXPECT_EQ(matmul1->op(), "Dequantize");
+  const NodeDef* narrowed = FindNode(output, "matmul1/narrowed");
+  ASSERT_NE(narrowed, nullptr);
+  EXPECT_EQ(narrowed->op(), "QuantizedMatMul");
+
+  PrecisionPlan plan;
+  TF_ASSERT_OK(ReadTextProto(Env::Default(), options.precision_plan_path(),
+                             &plan));
+  EXPECT_EQ(plan.node(0).precision(), DT_QUINT8);
+}
+
+TEST(PrecisionNarrowingTest, RequiresCalibrationData) {
+  PrecisionNarrowingOptions options;
+  options.set_enable(true);
+  PrecisionNarrowing optimizer(options);
+  GraphDef output;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      optimizer.Optimize(nullptr, MatMulChainItem(), &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
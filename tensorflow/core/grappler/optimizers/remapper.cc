@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstdlib>
 #include <map>
+#include <optional>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -32,13 +33,16 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/fusion_profile.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/pattern_utils.h"
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/use_cudnn.h"
@@ -92,6 +96,8 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedResourceSparseSegmentReduce[] =
+    "_FusedResourceSparseSegmentReduce";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMklFusedMish[] = "_MklFusedMish";
 constexpr char kRelu[] = "Relu";
@@ -123,6 +129,9 @@ struct RemapperContext {
   bool inferred_graph_properties;
   RewriterConfig::CpuLayout cpu_layout_conversion;
   bool xla_auto_clustering_on;
+  // Kernel timings that fusions are checked against, if any.
+  const FusionProfile* profile = nullptr;
+  std::vector<Remapper::FusionDecision>* fusion_report = nullptr;
 };
 
 // FusedBatchNorm that can be replaced with a cheaper set of primitives.
@@ -167,6 +176,17 @@ struct TensorToHashBucket {
   int string_to_hash_bucket = kMissingIndex;
 };
 
+// SparseSegmentSum or SparseSegmentMean of the rows read by a ResourceGather,
+// that can be replaced with a _FusedResourceSparseSegmentReduce.
+struct ResourceGatherSparseSegment {
+  ResourceGatherSparseSegment() = default;
+  ResourceGatherSparseSegment(int gather, int sparse_segment)
+      : gather(gather), sparse_segment(sparse_segment) {}
+
+  int gather = kMissingIndex;
+  int sparse_segment = kMissingIndex;
+};
+
 // Pad followed by Conv3D/FusedConv3D
 struct PadWithConv3D {
   PadWithConv3D() = default;
@@ -2618,6 +2638,58 @@ bool FindFusedBatchNormGradEx(const RemapperContext& ctx, int node_index,
   return false;
 }
 
+bool FindResourceGatherSparseSegment(RemapperContext* ctx, int node_index,
+                                     ResourceGatherSparseSegment* matched) {
+  // Root of the pattern must be a SparseSegmentSum or SparseSegmentMean.
+  const auto* node_view = ctx->graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if ((node_def->op() != "SparseSegmentSum" &&
+       node_def->op() != "SparseSegmentMean") ||
+      HasControlFaninOrFanout(*node_view) || !NodeIsOnCpu(node_def) ||
+      node_view->NumRegularFanins() != 3) {
+    return false;
+  }
+  if (!HasDataType(node_def, DT_FLOAT) && !HasDataType(node_def, DT_DOUBLE)) {
+    return false;
+  }
+
+  // Its data must be the only use of a ResourceGather without batch dims.
+  const auto* gather_node_view = node_view->GetRegularFanin(0).node_view();
+  const auto* gather_node_def = gather_node_view->node();
+  int batch_dims;
+  if (gather_node_def->op() != "ResourceGather" ||
+      HasControlFaninOrFanout(*gather_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*gather_node_view) ||
+      IsInPreserveSet(*ctx, gather_node_def) ||
+      gather_node_def->device() != node_def->device() ||
+      !GetNodeAttr(*gather_node_def, "batch_dims", &batch_dims).ok() ||
+      batch_dims != 0) {
+    return false;
+  }
+
+  // The gathered ids must be a vector, so that each row of the data is a row
+  // of the variable.
+  if (!ctx->inferred_graph_properties) {
+    Status s = ctx->graph_properties.InferStatically(
+        /*assume_valid_feeds=*/true,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/false,
+        /*include_output_tensor_values=*/true);
+    if (!s.ok()) return false;
+    ctx->inferred_graph_properties = true;
+  }
+  const auto& props =
+      ctx->graph_properties.GetInputProperties(gather_node_def->name());
+  if (props.size() != 2 || props[1].shape().unknown_rank() ||
+      props[1].shape().dim_size() != 1) {
+    return false;
+  }
+
+  *matched = ResourceGatherSparseSegment(gather_node_view->node_index(),
+                                         node_index);
+  return true;
+}
+
 bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
                             TensorToHashBucket* matched) {
   // Root of the pattern must be a StringToHashBucketFast.
@@ -4308,6 +4380,48 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return absl::OkStatus();
 }
 
+Status AddResourceGatherSparseSegmentNode(
+    RemapperContext* ctx, const ResourceGatherSparseSegment& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& sparse_segment = graph->node(matched.sparse_segment);
+  VLOG(2) << "Fuse ResourceGather with " << sparse_segment.op() << ":"
+          << " gather=" << gather.name()
+          << " sparse_segment=" << sparse_segment.name()
+          << " on device=" << sparse_segment.device();
+
+  NodeDef fused_op;
+  fused_op.set_name(sparse_segment.name());
+  fused_op.set_device(sparse_segment.device());
+  fused_op.set_op(kFusedResourceSparseSegmentReduce);
+  fused_op.add_input(gather.input(0));          // 0: resource
+  fused_op.add_input(gather.input(1));          // 1: ids
+  fused_op.add_input(sparse_segment.input(1));  // 2: indices
+  fused_op.add_input(sparse_segment.input(2));  // 3: segment_ids
+
+  auto* attr = fused_op.mutable_attr();
+  auto& gather_attr = gather.attr();
+  auto& sparse_segment_attr = sparse_segment.attr();
+  (*attr)["dtype"] = gather_attr.at("dtype");
+  (*attr)["Tindices"] = gather_attr.at("Tindices");
+  (*attr)["Tidx"] = sparse_segment_attr.at("Tidx");
+  (*attr)["Tsegmentids"] = sparse_segment_attr.at("Tsegmentids");
+  SetAttrValue(sparse_segment.op() == "SparseSegmentMean" ? "mean" : "sum",
+               &(*attr)["combiner"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.sparse_segment] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+
+  return absl::OkStatus();
+}
+
 Status AddFusedBatchMatMul(RemapperContext* ctx,
                            const std::map<string, int>& matched_nodes_map,
                            const std::set<int>& remove_node_indices,
@@ -4793,6 +4907,58 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
          is_matmul_gelu_exact_fusion_candidate() ||
          is_act_biasadd_matmul_candidate();
 }
+
+// Returns the fused op of a contraction fused with a BiasAdd.
+string FusedContractionOp(const NodeDef& contraction) {
+  if (IsConv2D(contraction)) return kFusedConv2D;
+  if (IsDepthwiseConv2dNative(contraction)) return kFusedDepthwiseConv2dNative;
+  if (IsMatMul(contraction)) return kFusedMatMul;
+  if (IsConv3D(contraction)) return kFusedConv3D;
+  return "";
+}
+
+// Returns whether the nodes `node_indices` should be fused into a node
+// `fused_op` that takes the name of the node `fused_node_index`. Without a
+// profile, or when the profile misses one of the kernels, all fusions are
+// applied. Otherwise, a fusion is only applied if the fused kernel was
+// measured faster than the kernels it replaces.
+bool AcceptFusion(RemapperContext* ctx, const string& pattern,
+                  const std::vector<int>& node_indices, int fused_node_index,
+                  const string& fused_op) {
+  if (ctx->profile == nullptr) return true;
+
+  const GraphDef* graph = ctx->graph_view.graph();
+  Remapper::FusionDecision decision;
+  decision.pattern = pattern;
+  decision.node = graph->node(fused_node_index).name();
+  decision.fused_op = fused_op;
+
+  std::optional<double> fused_time_us =
+      ctx->profile->MeanTimeUs(decision.node, fused_op);
+  double unfused_time_us = 0;
+  bool measured_unfused = true;
+  for (int node_index : node_indices) {
+    const NodeDef& node = graph->node(node_index);
+    std::optional<double> time_us =
+        ctx->profile->MeanTimeUs(node.name(), node.op());
+    if (!time_us.has_value()) {
+      measured_unfused = false;
+      break;
+    }
+    unfused_time_us += *time_us;
+  }
+  if (fused_time_us.has_value()) decision.fused_time_us = *fused_time_us;
+  if (measured_unfused) decision.unfused_time_us = unfused_time_us;
+  decision.accepted = !fused_time_us.has_value() || !measured_unfused ||
+                      *fused_time_us < unfused_time_us;
+
+  VLOG(2) << (decision.accepted ? "Accept " : "Reject ") << pattern
+          << " fusion into " << fused_op << " " << decision.node
+          << ": fused_time_us=" << decision.fused_time_us
+          << " unfused_time_us=" << decision.unfused_time_us;
+  ctx->fusion_report->push_back(std::move(decision));
+  return ctx->fusion_report->back().accepted;
+}
 }  // namespace
 
 Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -4802,6 +4968,16 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   RemapperContext ctx(&mutable_item, &status, cpu_layout_conversion_,
                       xla_auto_clustering_on_);
   TF_RETURN_IF_ERROR(status);
+  fusion_report_.clear();
+  if (!profile_filenames_.empty()) {
+    if (!profile_.has_value()) {
+      TF_ASSIGN_OR_RETURN(profile_,
+                          FusionProfile::Load(Env::Default(),
+                                              profile_filenames_));
+    }
+    ctx.profile = &*profile_;
+    ctx.fusion_report = &fusion_report_;
+  }
   // Processing graph in reverse-topological sorted order allows to remap
   // longer chains of dependent ops in one pass.
   TF_RETURN_IF_ERROR(
@@ -5053,7 +5229,13 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // _Fused{Conv2D,DepthwiseConv2dNative,MatMul}
     ContractionWithBiasAdd contract_with_bias;
     if (allow_non_differentiable_rewrites &&
-        FindContractionWithBias(ctx, i, &contract_with_bias)) {
+        FindContractionWithBias(ctx, i, &contract_with_bias) &&
+        AcceptFusion(&ctx, "ContractionWithBiasAdd",
+                     {contract_with_bias.contraction,
+                      contract_with_bias.bias_add},
+                     contract_with_bias.bias_add,
+                     FusedContractionOp(ctx.graph_view.graph()->node(
+                         contract_with_bias.contraction)))) {
       TF_RETURN_IF_ERROR(AddFusedContractionNode(
           &ctx, contract_with_bias, &invalidated_nodes, &nodes_to_delete));
       continue;
@@ -5064,7 +5246,14 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     ContractionWithBiasAddAndActivation contract_with_bias_and_activation;
     if (allow_non_differentiable_rewrites &&
         FindContractionWithBiasAndActivation(
-            ctx, cluster, i, &contract_with_bias_and_activation)) {
+            ctx, cluster, i, &contract_with_bias_and_activation) &&
+        AcceptFusion(&ctx, "ContractionWithBiasAddAndActivation",
+                     {contract_with_bias_and_activation.contraction,
+                      contract_with_bias_and_activation.bias_add,
+                      contract_with_bias_and_activation.activation},
+                     contract_with_bias_and_activation.activation,
+                     FusedContractionOp(ctx.graph_view.graph()->node(
+                         contract_with_bias_and_activation.contraction)))) {
       TF_RETURN_IF_ERROR(
           AddFusedContractionNode(&ctx, contract_with_bias_and_activation,
                                   &invalidated_nodes, &nodes_to_delete));
@@ -5079,7 +5268,13 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // _FusedConv3D}+Squeeze.
     ContractionWithSqueezeAndBiasAdd contract_with_squeeze_and_bias;
     if (allow_non_differentiable_rewrites &&
-        FindConvWithSqueezeAndBias(ctx, i, &contract_with_squeeze_and_bias)) {
+        FindConvWithSqueezeAndBias(ctx, i, &contract_with_squeeze_and_bias) &&
+        AcceptFusion(&ctx, "ContractionWithSqueezeAndBiasAdd",
+                     {contract_with_squeeze_and_bias.contraction,
+                      contract_with_squeeze_and_bias.bias_add},
+                     contract_with_squeeze_and_bias.contraction,
+                     FusedContractionOp(ctx.graph_view.graph()->node(
+                         contract_with_squeeze_and_bias.contraction)))) {
       TF_RETURN_IF_ERROR(AddFusedConvNode(&ctx, contract_with_squeeze_and_bias,
                                           &invalidated_nodes,
                                           &nodes_to_delete));
@@ -5090,7 +5285,12 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // Remap Conv2D+FusedBatchNorm into the _FusedConv2D;
     ContractionWithBatchNorm contract_with_batch_norm;
     if (allow_non_differentiable_rewrites &&
-        FindConv2DWithBatchNorm(ctx, i, &contract_with_batch_norm)) {
+        FindConv2DWithBatchNorm(ctx, i, &contract_with_batch_norm) &&
+        AcceptFusion(&ctx, "ContractionWithBatchNorm",
+                     {contract_with_batch_norm.contraction,
+                      contract_with_batch_norm.fused_batch_norm},
+                     contract_with_batch_norm.fused_batch_norm,
+                     kFusedConv2D)) {
       TF_RETURN_IF_ERROR(AddFusedConv2DNode(&ctx, contract_with_batch_norm,
                                             &invalidated_nodes,
                                             &nodes_to_delete));
@@ -5102,7 +5302,13 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
         contract_with_batch_norm_and_activation;
     if (allow_non_differentiable_rewrites &&
         FindConv2DWithBatchNormAndActivation(
-            ctx, i, &contract_with_batch_norm_and_activation)) {
+            ctx, i, &contract_with_batch_norm_and_activation) &&
+        AcceptFusion(&ctx, "ContractionWithBatchNormAndActivation",
+                     {contract_with_batch_norm_and_activation.contraction,
+                      contract_with_batch_norm_and_activation.fused_batch_norm,
+                      contract_with_batch_norm_and_activation.activation},
+                     contract_with_batch_norm_and_activation.activation,
+                     kFusedConv2D)) {
       TF_RETURN_IF_ERROR(
           AddFusedConv2DNode(&ctx, contract_with_batch_norm_and_activation,
                              &invalidated_nodes, &nodes_to_delete));
@@ -5136,6 +5342,17 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Reduce the rows of an embedding by segment as they are read.
+    ResourceGatherSparseSegment resource_gather_sparse_segment;
+    if (allow_non_differentiable_rewrites &&
+        FindResourceGatherSparseSegment(&ctx, i,
+                                        &resource_gather_sparse_segment)) {
+      TF_RETURN_IF_ERROR(AddResourceGatherSparseSegmentNode(
+          &ctx, resource_gather_sparse_segment, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
@@ -5145,6 +5362,16 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     }
   }
 
+  if (ctx.profile != nullptr) {
+    int num_accepted = 0;
+    for (const FusionDecision& decision : fusion_report_) {
+      if (decision.accepted) ++num_accepted;
+    }
+    LOG(INFO) << "Applied " << num_accepted << " of " << fusion_report_.size()
+              << " fusions checked against the kernel timings in "
+              << profile_filenames_;
+  }
+
   // Remove invalidated nodes.
   utils::Mutation* mutation = ctx.graph_view.GetMutationBuilder();
   for (int i = 0; i < num_nodes; ++i) {
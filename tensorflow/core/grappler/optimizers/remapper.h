@@ -16,6 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_REMAPPER_H_
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/grappler/optimizers/fusion_profile.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
@@ -26,13 +32,32 @@ namespace grappler {
 // nodes to decrease the amount of operations needed to perform a computation.
 class Remapper : public GraphOptimizer {
  public:
+  // A fusion that was checked against the kernel timings of the profile.
+  struct FusionDecision {
+    // The fused pattern, e.g. "ContractionWithBiasAdd".
+    string pattern;
+    // The name and op of the fused node.
+    string node;
+    string fused_op;
+    // The measured time of the fused node and the sum of the measured times
+    // of the nodes it replaces, or -1 if they were not measured.
+    double fused_time_us = -1;
+    double unfused_time_us = -1;
+    bool accepted = false;
+  };
+
+  // If `profile_filenames` is not empty, it is a comma-separated list of
+  // RunMetadata files with kernel timings, and fusions are only applied where
+  // the fused kernel was measured faster (see FusionProfile).
   explicit Remapper(RewriterConfig::Toggle opt_level,
                     RewriterConfig::CpuLayout cpu_layout_conversion =
                         RewriterConfig::NO_CONVERSION_ON_CPU,
-                    bool xla_auto_clustering_on = false)
+                    bool xla_auto_clustering_on = false,
+                    string profile_filenames = "")
       : opt_level_(opt_level),
         cpu_layout_conversion_(cpu_layout_conversion),
-        xla_auto_clustering_on_(xla_auto_clustering_on) {}
+        xla_auto_clustering_on_(xla_auto_clustering_on),
+        profile_filenames_(std::move(profile_filenames)) {}
 
   ~Remapper() override {}
 
@@ -43,10 +68,20 @@ class Remapper : public GraphOptimizer {
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
 
+  // Returns the fusions of the last optimization that were checked against
+  // the profile.
+  const std::vector<FusionDecision>& fusion_report() const {
+    return fusion_report_;
+  }
+
  private:
   RewriterConfig::Toggle opt_level_;
   RewriterConfig::CpuLayout cpu_layout_conversion_;
   bool xla_auto_clustering_on_;
+  const string profile_filenames_;
+  // Loaded from `profile_filenames_` by the first optimization.
+  std::optional<FusionProfile> profile_;
+  std::vector<FusionDecision> fusion_report_;
 };
 
 }  // end namespace grappler
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/cc/ops/nn_ops_internal.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
@@ -25,7 +27,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/util.h"
 
 #if GOOGLE_CUDA
@@ -736,6 +741,83 @@ TEST_F(RemapperFuseConvWithBias, Conv3D_BF16) {
   RunTest<3, DT_BFLOAT16>();
 }
 
+class RemapperFuseConvWithBiasProfile : public RemapperTest {
+ protected:
+  // Returns the op of "bias_add" after remapping a Conv2D + BiasAdd graph
+  // with a profile where the fused kernel takes `fused_time_us`, and the
+  // Conv2D and BiasAdd kernels take 10us and 5us.
+  string RemapWithProfile(int64_t fused_time_us,
+                          std::vector<Remapper::FusionDecision>* report) {
+    using ::tensorflow::ops::Placeholder;
+
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                             ops::Placeholder::Shape({8, 32, 32, 3}));
+    auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT,
+                              ops::Placeholder::Shape({1, 1, 3, 128}));
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                            ops::Placeholder::Shape({128}));
+    auto conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "SAME");
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), bias_add);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    RunMetadata run_metadata;
+    DeviceStepStats* device_stats =
+        run_metadata.mutable_step_stats()->add_dev_stats();
+    const auto add_node_stats = [&](const string& name, const string& op,
+                                    int64_t time_us) {
+      NodeExecStats* node_stats = device_stats->add_node_stats();
+      node_stats->set_node_name(name);
+      node_stats->set_timeline_label(absl::StrCat(name, " = ", op, "()"));
+      node_stats->set_op_end_rel_micros(time_us);
+    };
+    add_node_stats("conv", "Conv2D", 10);
+    add_node_stats("bias_add", "BiasAdd", 5);
+    add_node_stats("bias_add", "_FusedConv2D", fused_time_us);
+    const string profile = io::JoinPath(
+        testing::TmpDir(), absl::StrCat("remapper_profile_", fused_time_us));
+    TF_CHECK_OK(WriteBinaryProto(Env::Default(), profile, run_metadata));
+
+    Remapper optimizer(RewriterConfig::ON, RewriterConfig::NO_CONVERSION_ON_CPU,
+                       /*xla_auto_clustering_on=*/false, profile);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+    *report = optimizer.fusion_report();
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "bias_add") return node.op();
+    }
+    return "";
+  }
+};
+
+TEST_F(RemapperFuseConvWithBiasProfile, AcceptsFasterFusion) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Test not applicable to oneDNN.";
+  std::vector<Remapper::FusionDecision> report;
+  EXPECT_EQ(RemapWithProfile(/*fused_time_us=*/12, &report), "_FusedConv2D");
+  ASSERT_EQ(report.size(), 1);
+  EXPECT_EQ(report[0].pattern, "ContractionWithBiasAdd");
+  EXPECT_EQ(report[0].node, "bias_add");
+  EXPECT_EQ(report[0].fused_time_us, 12);
+  EXPECT_EQ(report[0].unfused_time_us, 15);
+  EXPECT_TRUE(report[0].accepted);
+}
+
+TEST_F(RemapperFuseConvWithBiasProfile, RejectsSlowerFusion) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Test not applicable to oneDNN.";
+  std::vector<Remapper::FusionDecision> report;
+  EXPECT_EQ(RemapWithProfile(/*fused_time_us=*/20, &report), "BiasAdd");
+  ASSERT_EQ(report.size(), 1);
+  EXPECT_FALSE(report[0].accepted);
+}
+
 class RemapperFuseConvWithBiasAndActivation : public RemapperTest {
  public:
   template <int dim, DataType DTYPE>
@@ -1767,6 +1849,76 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+class RemapperResourceGatherSparseSegmentTest : public RemapperTest {
+ public:
+  void RunTest(bool mean) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto embeddings = ops::Const(s.WithOpName("embeddings"),
+                                 {{0.f, 1.f, 2.f},
+                                  {10.f, 11.f, 12.f},
+                                  {20.f, 21.f, 22.f},
+                                  {30.f, 31.f, 32.f}});
+    auto var =
+        ops::VarHandleOp(s.WithOpName("var"), DT_FLOAT, TensorShape({4, 3}));
+    ops::AssignVariableOp assign(s.WithOpName("assign"), var, embeddings);
+    // The ids, rather than the gather, wait for the variable to be assigned.
+    auto ids = ops::Identity(
+        s.WithOpName("ids").WithControlDependencies(
+            std::vector<Operation>{assign}),
+        ops::Const(s.WithOpName("ids_value"), {3, 1, 2, 1}));
+    auto gather = ops::ResourceGather(s.WithOpName("gather"), var, ids,
+                                      DT_FLOAT);
+    auto indices = ops::Const(s.WithOpName("indices"), {0, 1, 2, 3});
+    auto segment_ids = ops::Const(s.WithOpName("segment_ids"), {0, 0, 2, 2});
+    Output reduce =
+        mean ? ops::SparseSegmentMean(s.WithOpName("reduce"), gather, indices,
+                                      segment_ids)
+                   .output
+             : ops::SparseSegmentSum(s.WithOpName("reduce"), gather, indices,
+                                     segment_ids)
+                   .output;
+    auto fetch = ops::Identity(s.WithOpName("fetch"), reduce);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "gather");
+      if (node.name() == "reduce") {
+        EXPECT_EQ(node.op(), "_FusedResourceSparseSegmentReduce");
+        ASSERT_EQ(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "var");
+        EXPECT_EQ(node.input(1), "ids");
+        EXPECT_EQ(node.input(2), "indices");
+        EXPECT_EQ(node.input(3), "segment_ids");
+        EXPECT_EQ(node.attr().at("combiner").s(), mean ? "mean" : "sum");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+};
+
+TEST_F(RemapperResourceGatherSparseSegmentTest, Sum) { RunTest(false); }
+
+TEST_F(RemapperResourceGatherSparseSegmentTest, Mean) { RunTest(true); }
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
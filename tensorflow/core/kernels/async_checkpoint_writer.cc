@@ -0,0 +1,125 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace checkpoint {
+
+/* static */
+AsyncCheckpointWriter* AsyncCheckpointWriter::Global() {
+  static AsyncCheckpointWriter* writer =
+      new AsyncCheckpointWriter(Env::Default());
+  return writer;
+}
+
+AsyncCheckpointWriter::AsyncCheckpointWriter(Env* env) : env_(env) {}
+
+AsyncCheckpointWriter::~AsyncCheckpointWriter() {
+  std::unique_ptr<Thread> thread;
+  {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) cv_.wait(l);
+    shutdown_ = true;
+    thread = std::move(thread_);
+  }
+  cv_.notify_all();
+  // Joins the thread.
+  thread.reset();
+}
+
+void AsyncCheckpointWriter::Schedule(const std::string& prefix,
+                                     std::function<Status()> write) {
+  {
+    mutex_lock l(mu_);
+    queue_.push_back({prefix, std::move(write)});
+    ++prefixes_[prefix].num_pending;
+    ++num_pending_;
+    if (thread_ == nullptr) {
+      thread_.reset(env_->StartThread(ThreadOptions(),
+                                      "async_checkpoint_writer",
+                                      [this]() { WriteLoop(); }));
+    }
+  }
+  cv_.notify_all();
+}
+
+Status AsyncCheckpointWriter::Wait(absl::string_view prefix) {
+  mutex_lock l(mu_);
+  while (true) {
+    auto it = prefixes_.find(prefix);
+    if (it == prefixes_.end() || it->second.num_pending == 0) break;
+    cv_.wait(l);
+  }
+  return TakeStatusLocked(prefix);
+}
+
+Status AsyncCheckpointWriter::TakeStatus(absl::string_view prefix) {
+  mutex_lock l(mu_);
+  return TakeStatusLocked(prefix);
+}
+
+Status AsyncCheckpointWriter::TakeStatusLocked(absl::string_view prefix) {
+  auto it = prefixes_.find(prefix);
+  if (it == prefixes_.end()) return absl::OkStatus();
+  Status status = std::move(it->second.status);
+  it->second.status = absl::OkStatus();
+  if (it->second.num_pending == 0) prefixes_.erase(it);
+  return status;
+}
+
+void AsyncCheckpointWriter::WaitForAll() {
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) cv_.wait(l);
+}
+
+void AsyncCheckpointWriter::WriteLoop() {
+  while (true) {
+    Write write;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !shutdown_) cv_.wait(l);
+      if (queue_.empty()) return;
+      write = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    const Status status = write.fn();
+    if (!status.ok()) {
+      LOG(ERROR) << "Asynchronous write of checkpoint " << write.prefix
+                 << " failed: " << status;
+    }
+    {
+      mutex_lock l(mu_);
+      PrefixState& state = prefixes_[write.prefix];
+      state.status.Update(status);
+      --state.num_pending;
+      if (state.num_pending == 0 && state.status.ok()) {
+        prefixes_.erase(write.prefix);
+      }
+      --num_pending_;
+    }
+    cv_.notify_all();
+  }
+}
+
+}  // namespace checkpoint
+}  // namespace tensorflow
@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
+#define TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace checkpoint {
+
+// Writes checkpoints in a background thread, for the SaveV2 and
+// MergeV2Checkpoints kernels of sessions with
+// ConfigProto.Experimental.async_checkpoint_saves.
+//
+// Each write is keyed by the prefix of the checkpoint that it writes. Writes
+// run one at a time, in the order in which they are scheduled: a merge
+// scheduled after the saves of its shards thus runs once they are written, and
+// successive writes of a prefix don't interleave.
+//
+// Thread-safe.
+class AsyncCheckpointWriter {
+ public:
+  // The writer shared by the kernels of the process.
+  static AsyncCheckpointWriter* Global();
+
+  explicit AsyncCheckpointWriter(Env* env);
+
+  // Waits for the scheduled writes.
+  ~AsyncCheckpointWriter();
+
+  // Schedules `write` of the checkpoint at `prefix`.
+  void Schedule(const std::string& prefix, std::function<Status()> write);
+
+  // Blocks until the scheduled writes of `prefix` are done, and returns the
+  // first error of the writes of `prefix` that hasn't been returned yet.
+  Status Wait(absl::string_view prefix);
+
+  // Like Wait(), without blocking: the writes of `prefix` that aren't done are
+  // ignored.
+  Status TakeStatus(absl::string_view prefix);
+
+  // Blocks until all the scheduled writes are done.
+  void WaitForAll();
+
+ private:
+  struct Write {
+    std::string prefix;
+    std::function<Status()> fn;
+  };
+
+  // The writes of a prefix that aren't done, and the first error of those
+  // that are. A prefix is dropped once it has neither.
+  struct PrefixState {
+    int64_t num_pending = 0;
+    Status status;
+  };
+
+  Status TakeStatusLocked(absl::string_view prefix)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void WriteLoop();
+
+  Env* const env_;
+
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<Write> queue_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, PrefixState> prefixes_ TF_GUARDED_BY(mu_);
+  // The number of writes that are scheduled or running.
+  int64_t num_pending_ TF_GUARDED_BY(mu_) = 0;
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  // Started on the first write.
+  std::unique_ptr<Thread> thread_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace checkpoint
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
@@ -0,0 +1,101 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace checkpoint {
+namespace {
+
+TEST(AsyncCheckpointWriterTest, WritesInOrder) {
+  AsyncCheckpointWriter writer(Env::Default());
+  Notification start;
+  mutex mu;
+  std::vector<std::string> written;
+  for (const std::string prefix : {"a", "b", "a", "c"}) {
+    writer.Schedule(prefix, [&, prefix]() {
+      start.WaitForNotification();
+      mutex_lock l(mu);
+      written.push_back(prefix);
+      return absl::OkStatus();
+    });
+  }
+  start.Notify();
+  TF_EXPECT_OK(writer.Wait("a"));
+  {
+    mutex_lock l(mu);
+    EXPECT_GE(written.size(), 3);
+    EXPECT_EQ(written[0], "a");
+    EXPECT_EQ(written[1], "b");
+    EXPECT_EQ(written[2], "a");
+  }
+  writer.WaitForAll();
+  mutex_lock l(mu);
+  EXPECT_EQ(written, std::vector<std::string>({"a", "b", "a", "c"}));
+}
+
+TEST(AsyncCheckpointWriterTest, ReportsErrorsOnce) {
+  AsyncCheckpointWriter writer(Env::Default());
+  writer.Schedule("a", []() { return errors::DataLoss("first"); });
+  writer.Schedule("a", []() { return errors::Internal("second"); });
+  writer.Schedule("b", []() { return absl::OkStatus(); });
+  const Status status = writer.Wait("a");
+  EXPECT_TRUE(errors::IsDataLoss(status)) << status;
+  TF_EXPECT_OK(writer.Wait("a"));
+  TF_EXPECT_OK(writer.Wait("b"));
+  // Nothing was written to "c".
+  TF_EXPECT_OK(writer.Wait("c"));
+}
+
+TEST(AsyncCheckpointWriterTest, TakeStatusDoesNotBlock) {
+  AsyncCheckpointWriter writer(Env::Default());
+  Notification start;
+  writer.Schedule("a", [&]() {
+    start.WaitForNotification();
+    return errors::DataLoss("failed");
+  });
+  TF_EXPECT_OK(writer.TakeStatus("a"));
+  start.Notify();
+  writer.WaitForAll();
+  EXPECT_TRUE(errors::IsDataLoss(writer.TakeStatus("a")));
+  TF_EXPECT_OK(writer.TakeStatus("a"));
+}
+
+TEST(AsyncCheckpointWriterTest, DestructorWaits) {
+  bool written = false;
+  {
+    AsyncCheckpointWriter writer(Env::Default());
+    writer.Schedule("a", [&]() {
+      Env::Default()->SleepForMicroseconds(10000);
+      written = true;
+      return absl::OkStatus();
+    });
+  }
+  EXPECT_TRUE(written);
+}
+
+}  // namespace
+}  // namespace checkpoint
+}  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -48,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/threadpool.h"
@@ -143,6 +145,42 @@ static thread::ThreadPool* GetOrCreateBatchThreadsPool() {
   return shared_thread_pool;
 }
 
+// Returns whether the BatchFunction ops that use an adaptive batch scheduler
+// share a single one for the whole process, as set by the environment
+// variable TF_SHARE_ADAPTIVE_BATCH_SCHEDULER.
+bool ShareAdaptiveBatchScheduler() {
+  static const bool share = [] {
+    const char* val = std::getenv("TF_SHARE_ADAPTIVE_BATCH_SCHEDULER");
+    return val != nullptr && (absl::string_view(val) == "1" ||
+                              absl::EqualsIgnoreCase(val, "true"));
+  }();
+  return share;
+}
+
+// Creates an adaptive batch scheduler with `options`, or returns the one shared
+// by the process if ShareAdaptiveBatchScheduler(). The batches of all the
+// models are then scheduled together within a single in-flight batches limit,
+// tuned for throughput, so that many small models on one device keep it busy
+// without each of them running its own batches of few tasks. The shared
+// scheduler is created with the options of the first model to use it.
+Status GetOrCreateAdaptiveBatcher(
+    serving::BatchResourceBase::AdaptiveBatcherT::Options options,
+    std::shared_ptr<serving::BatchResourceBase::AdaptiveBatcherT>* batcher) {
+  using AdaptiveBatcherT = serving::BatchResourceBase::AdaptiveBatcherT;
+  if (!ShareAdaptiveBatchScheduler()) {
+    return AdaptiveBatcherT::Create(options, batcher);
+  }
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* shared_batcher = new std::shared_ptr<AdaptiveBatcherT>();
+  mutex_lock l(mu);
+  if (*shared_batcher == nullptr) {
+    options.tune_in_flight_batches_limit_for_throughput = true;
+    TF_RETURN_IF_ERROR(AdaptiveBatcherT::Create(options, shared_batcher));
+  }
+  *batcher = *shared_batcher;
+  return absl::OkStatus();
+}
+
 // A class encapsulating the state and logic for batching tensors.
 class BatchResource : public serving::BatchResourceBase {
  public:
@@ -219,7 +257,7 @@ class BatchResource : public serving::BatchResourceBase {
       const std::vector<int32>& allowed_batch_sizes,
       std::unique_ptr<BatchResource>* resource) {
     std::shared_ptr<AdaptiveBatcherT> batcher;
-    TF_RETURN_IF_ERROR(AdaptiveBatcherT::Create(
+    TF_RETURN_IF_ERROR(GetOrCreateAdaptiveBatcher(
         adaptive_shared_batch_scheduler_options, &batcher));
 
     resource->reset(new BatchResource(
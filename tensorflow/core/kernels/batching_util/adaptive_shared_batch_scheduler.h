@@ -132,6 +132,14 @@ class AdaptiveSharedBatchScheduler
     // full_batch_scheduling_boost_micros==zero) for backward compatibility of
     // API.
     bool fifo_scheduling = false;
+
+    // If true, in_flight_batches_limit_ is adjusted to maximize the throughput,
+    // i.e. the number of tasks processed per unit of time over each
+    // `batches_to_average_over` batches, instead of to minimize the average
+    // batch latency. Suited to a scheduler shared by the queues of many models
+    // on one device, whose batches take very different times to process, so
+    // that their average latency mostly reflects which models happened to run.
+    bool tune_in_flight_batches_limit_for_throughput = false;
   };
 
   // Ownership is shared between the caller of Create() and any queues created
@@ -212,7 +220,8 @@ class AdaptiveSharedBatchScheduler
 
   void MaybeScheduleClosedBatchesLockedFIFO() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  void MaybeAdjustInflightLimit() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void MaybeAdjustInflightLimit(int64_t now_micros)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Notifies scheduler of non-empty batch which is eligible for processing.
   void AddBatch(const internal::ASBSBatch<TaskType>* batch);
@@ -265,6 +274,10 @@ class AdaptiveSharedBatchScheduler
   struct DelayStats {
     // Sum of processing latency for batches counted by batch_count_.
     int64_t batch_latency_sum = 0;
+    // Sum of the sizes of the batches counted by batch_count_.
+    int64_t batch_size_sum = 0;
+    // Time of the last in_flight_batches_limit_ adjustment.
+    int64_t last_adjustment_time_micros = 0;
     // Average batch latency for previous value of in_flight_batches_limit_.
     double last_avg_latency_ms = 0;
     // Did last_avg_latency_ms decrease from the previous last_avg_latency_ms?
@@ -435,6 +448,7 @@ AdaptiveSharedBatchScheduler<TaskType>::AdaptiveSharedBatchScheduler(
       rand_double_(0.0, 1.0) {
   std::random_device device;
   rand_engine_.seed(device());
+  batch_delay_stats_.last_adjustment_time_micros = GetEnv()->NowMicros();
   if (options.thread_pool == nullptr) {
     owned_batch_thread_pool_ = true;
     batch_thread_pool_ = new thread::ThreadPool(
@@ -642,6 +656,7 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
       profiler::ContextType::kAdaptiveSharedBatchScheduler,
       batch->traceme_context_id());
   const int64_t start_time = batch->creation_time_micros();
+  const int64_t batch_size = batch->size();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64_t end_time = GetEnv()->NowMicros();
@@ -654,14 +669,16 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
   in_flight_batches_--;
   batch_count_++;
   batch_delay_stats_.batch_latency_sum += end_time - start_time;
+  batch_delay_stats_.batch_size_sum += batch_size;
 
-  MaybeAdjustInflightLimit();
+  MaybeAdjustInflightLimit(end_time);
 
   MaybeScheduleNextBatch();
 }
 
 template <typename TaskType>
-void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
+void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit(
+    int64_t now_micros) {
   // Occasionally adjust in_flight_batches_limit_ to minimize average latency.
   // Although the optimal value may depend on the workload, the latency should
   // be a simple convex function of in_flight_batches_limit_, allowing us to
@@ -669,6 +686,14 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
   if (batch_count_ == options_.batches_to_average_over) {
     double current_avg_latency_ms =
         (batch_delay_stats_.batch_latency_sum / 1000.) / batch_count_;
+    if (options_.tune_in_flight_batches_limit_for_throughput) {
+      // Minimize the time per processed task instead, the inverse of the
+      // throughput.
+      current_avg_latency_ms =
+          ((now_micros - batch_delay_stats_.last_adjustment_time_micros) /
+           1000.) /
+          std::max<int64_t>(batch_delay_stats_.batch_size_sum, 1);
+    }
     bool current_latency_decreased =
         current_avg_latency_ms < batch_delay_stats_.last_avg_latency_ms;
     if (current_latency_decreased) {
@@ -700,6 +725,8 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
     batch_delay_stats_.last_latency_decreased = current_latency_decreased;
     batch_count_ = 0;
     batch_delay_stats_.batch_latency_sum = 0;
+    batch_delay_stats_.batch_size_sum = 0;
+    batch_delay_stats_.last_adjustment_time_micros = now_micros;
   }
 }
 
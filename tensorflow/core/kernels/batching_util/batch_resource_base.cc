@@ -213,6 +213,23 @@ void RecordBatchDelayUsV2(int64_t batch_delay_us, const string& model_name,
       ->Add(static_cast<double>(batch_delay_us));
 }
 
+// Tracks the batching delay of the inputs of each priority, when the batcher
+// keeps the low priority inputs in a separate queue.
+void RecordBatchDelayUsByPriority(int64_t batch_delay_us,
+                                  const string& model_name,
+                                  const string& op_name, bool low_priority) {
+  static auto* cell = tensorflow::monitoring::Sampler<3>::New(
+      {"/tensorflow/serving/batching/batch_delay_us_by_priority",
+       "Tracks the batching delay (in microseconds) for inputs by model_name "
+       "(if available) and priority.",
+       "model_name", "op_name", "priority"},
+      // It's 27 buckets with the last bucket being 2^26 to DBL_MAX;
+      // so the limits are [1, 2, 4, 8, ..., 64 * 1024 * 1024, DBL_MAX].
+      monitoring::Buckets::Exponential(1, 2, 27));
+  cell->GetCell(model_name, op_name, low_priority ? "low" : "high")
+      ->Add(static_cast<double>(batch_delay_us));
+}
+
 void RecordBatchParamBatchTimeoutMicros(int64_t batch_timeout_micros,
                                         const string& model_name,
                                         const string& op_name) {
@@ -287,6 +304,41 @@ int GetTotalTaskSize(
   return tasks_size;
 }
 
+// Splits `tensor` along its 0th dimension into pieces of `sizes` rows, like
+// tensor::Split, but as slices that share the buffer of `tensor` when they all
+// stay aligned, so that the outputs of a batch are returned without a copy.
+// The buffer is then only freed once every piece is released.
+Status SplitBatchedTensor(const Tensor& tensor,
+                          const std::vector<int64_t>& sizes,
+                          std::vector<Tensor>* pieces) {
+  const int64_t num_rows = tensor.dim_size(0);
+  const bool can_slice =
+      DataTypeCanUseMemcpy(tensor.dtype()) && num_rows > 0 &&
+      tensor.IsAligned() &&
+      (tensor.NumElements() / num_rows * DataTypeSize(tensor.dtype())) %
+              EIGEN_MAX_ALIGN_BYTES ==
+          0;
+  if (!can_slice) {
+    return tensor::Split(tensor, sizes, pieces);
+  }
+  int64_t total_size = 0;
+  for (const int64_t size : sizes) {
+    total_size += size;
+  }
+  if (total_size != num_rows) {
+    return errors::InvalidArgument(
+        "The values in 'sizes' do not sum to the zeroth-dimension size of "
+        "'tensor'");
+  }
+  pieces->reserve(sizes.size());
+  int64_t position = 0;
+  for (const int64_t size : sizes) {
+    pieces->push_back(tensor.Slice(position, position + size));
+    position += size;
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -689,6 +741,16 @@ Status BatchResourceBase::ConcatInputTensors(
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
 
+  // A batch of a single task without padding is its inputs, which are passed
+  // on without a copy.
+  if (!just_for_warmup && padding_amount == 0 && batch.num_tasks() == 1 &&
+      unbatched_tasks.empty()) {
+    const BatchTask& task = batch.task(0);
+    concatenated_tensors->insert(concatenated_tensors->end(),
+                                 task.inputs.begin(), task.inputs.end());
+    return absl::OkStatus();
+  }
+
   // Process each input one at a time (the typical case has just one). When
   // `just_for_warmup` is true, the real data is not added. Otherwise, the real
   // data is added to the front of each `concatenated_tensor`.
@@ -887,7 +949,7 @@ Status BatchResourceBase::SplitOutputTensors(
     }
 
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
+    const Status split_status = SplitBatchedTensor(
         output_tensor, task_sizes_plus_optional_padding, &split_tensor);
     DCHECK(split_status.ok()) << split_status;
     if (!split_status.ok()) {
@@ -1019,6 +1081,21 @@ void BatchResourceBase::ProcessFuncBatch(
                          model_name, last_task_context->op_kernel().name(),
                          processed_size);
   }
+  if (batcher_queue_options_.enable_priority_queue) {
+    const bool low_priority_batch = IsLowPriorityBatch(*batch);
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      RecordBatchDelayUsByPriority(
+          (current_time - batch->task(i).start_time) * 1e-3, model_name,
+          last_task_context->op_kernel().name(), low_priority_batch);
+    }
+    // The unbatched tasks are the low priority tasks padding the batch.
+    for (const auto& task : unbatched_tasks) {
+      RecordBatchDelayUsByPriority((current_time - task->start_time) * 1e-3,
+                                   model_name,
+                                   last_task_context->op_kernel().name(),
+                                   /*low_priority=*/true);
+    }
+  }
   // Releases the cleanup method here, because the callback of the function
   // library runtime will handle it now.
   finally.release();
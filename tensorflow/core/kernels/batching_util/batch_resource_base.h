@@ -45,6 +45,10 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 
+namespace internal {
+class BatchResourceBaseTestAccess;
+}  // namespace internal
+
 // Base class for resource that encapsulating the state and logic for batching
 // tensors.
 class BatchResourceBase : public ResourceBase {
@@ -257,6 +261,8 @@ class BatchResourceBase : public ResourceBase {
       int64_t processed_size, BatchT& batch);
 
  private:
+  friend class internal::BatchResourceBaseTestAccess;
+
   // Implementation of calling the process batch function.
   virtual void ProcessFuncBatchImpl(
       const BatchResourceBase::BatchTask& last_task,
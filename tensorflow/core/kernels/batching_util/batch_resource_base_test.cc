@@ -16,23 +16,64 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/request_cost.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_factory.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
 #include "tsl/platform/criticality.h"
 
 namespace tensorflow {
 namespace serving {
+namespace internal {
+
+class BatchResourceBaseTestAccess {
+ public:
+  explicit BatchResourceBaseTestAccess(const BatchResourceBase* resource)
+      : resource_(resource) {}
+
+  Status ConcatInputTensors(const BatchResourceBase::BatchT& batch,
+                            OpKernelContext* context,
+                            std::vector<Tensor>* concatenated_tensors) const {
+    std::vector<std::unique_ptr<BatchResourceBase::BatchTask>> unbatched_tasks;
+    return resource_->ConcatInputTensors(batch, unbatched_tasks, context,
+                                         concatenated_tensors);
+  }
+
+  Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
+                            BatchResourceBase::BatchT* batch) const {
+    std::vector<std::unique_ptr<BatchResourceBase::BatchTask>> unbatched_tasks;
+    return resource_->SplitOutputTensors(combined_outputs, batch,
+                                         unbatched_tasks);
+  }
+
+ private:
+  const BatchResourceBase* const resource_;
+};
+
+}  // namespace internal
+
 namespace {
 
 using ::testing::Pair;
@@ -294,6 +335,161 @@ TEST(SplitBatchCostsAndRecordMetricsTest, SplitOnlyNonZeroCostTypes) {
           UnorderedElementsAre(Pair("test_tpu", absl::Milliseconds(100))))));
 }
 
+// A resource that batches without padding and is not run.
+class TestBatchResource : public BatchResourceBase {
+ public:
+  TestBatchResource()
+      : BatchResourceBase(/*has_process_batch_function=*/true,
+                          std::shared_ptr<BatcherT>(),
+                          BatcherT::QueueOptions(),
+                          /*allowed_batch_sizes=*/{}) {}
+
+  string DebugString() const override { return "TestBatchResource"; }
+
+ private:
+  void ProcessFuncBatchImpl(
+      const BatchResourceBase::BatchTask& last_task,
+      absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+      std::function<void(const Status&)> done) const override {
+    done(errors::Unimplemented("TestBatchResource is not run"));
+  }
+};
+
+class BatchResourceBaseCopyTest : public ::testing::Test {
+ protected:
+  BatchResourceBaseCopyTest()
+      : device_(DeviceFactory::NewDevice("CPU", SessionOptions{},
+                                         "/job:a/replica:0/task:0")),
+        access_(&resource_) {
+    NodeDef node_def;
+    NameAttrList f;
+    f.set_name("func_to_batch");
+    TF_CHECK_OK(NodeDefBuilder("batch", "BatchFunction")
+                    .Attr("max_batch_size", 16)
+                    .Attr("num_batch_threads", 1)
+                    .Attr("batch_timeout_micros", 1000)
+                    .Attr("Tin", std::vector<DataType>{DT_FLOAT})
+                    .Input(std::vector<NodeDefBuilder::NodeOut>{
+                        NodeDefBuilder::NodeOut({"input", 0, DT_FLOAT})})
+                    .Attr("Tcaptured", std::vector<DataType>{})
+                    .Input(std::vector<NodeDefBuilder::NodeOut>{})
+                    .Attr("Tout", std::vector<DataType>{DT_FLOAT})
+                    .Attr("f", f)
+                    .Finalize(&node_def));
+    Status status;
+    kernel_ = CreateOpKernel(DEVICE_CPU, device_.get(),
+                             device_->GetAllocator(AllocatorAttributes{}),
+                             node_def, TF_GRAPH_DEF_VERSION, &status);
+    TF_CHECK_OK(status);
+  }
+
+  // Returns a new context of the batch kernel with one output.
+  OpKernelContext* NewContext() {
+    params_.push_back(std::make_unique<OpKernelContext::Params>());
+    params_.back()->device = device_.get();
+    params_.back()->op_kernel = kernel_.get();
+    contexts_.push_back(std::make_unique<OpKernelContext>(params_.back().get(),
+                                                          /*num_outputs=*/1));
+    return contexts_.back().get();
+  }
+
+  // Adds a task with `input` to `batch`, and returns the task's context.
+  OpKernelContext* AddTask(const Tensor& input,
+                           BatchResourceBase::BatchT* batch) {
+    auto task = std::make_unique<BatchResourceBase::BatchTask>();
+    task->inputs.push_back(input);
+    task->context = NewContext();
+    OpKernelContext* context = task->context;
+    batch->AddTask(std::move(task));
+    return context;
+  }
+
+  // Returns a float tensor of `num_rows` rows of `row_size` values, counting
+  // up from `start`.
+  static Tensor Iota(int64_t num_rows, int64_t row_size, float start) {
+    Tensor tensor(DT_FLOAT, TensorShape({num_rows, row_size}));
+    test::FillIota<float>(&tensor, start);
+    return tensor;
+  }
+
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<OpKernel> kernel_;
+  std::vector<std::unique_ptr<OpKernelContext::Params>> params_;
+  std::vector<std::unique_ptr<OpKernelContext>> contexts_;
+  TestBatchResource resource_;
+  internal::BatchResourceBaseTestAccess access_;
+};
+
+TEST_F(BatchResourceBaseCopyTest, SingleTaskSkipsConcat) {
+  BatchResourceBase::BatchT batch;
+  const Tensor input = Iota(/*num_rows=*/3, /*row_size=*/2, /*start=*/0);
+  AddTask(input, &batch);
+  batch.Close();
+
+  std::vector<Tensor> concatenated;
+  TF_ASSERT_OK(access_.ConcatInputTensors(batch, NewContext(), &concatenated));
+  ASSERT_EQ(concatenated.size(), 1);
+  EXPECT_TRUE(concatenated[0].SharesBufferWith(input));
+  test::ExpectTensorEqual<float>(concatenated[0], input);
+}
+
+TEST_F(BatchResourceBaseCopyTest, MultipleTasksAreConcatenated) {
+  BatchResourceBase::BatchT batch;
+  const Tensor input0 = Iota(/*num_rows=*/1, /*row_size=*/2, /*start=*/0);
+  const Tensor input1 = Iota(/*num_rows=*/2, /*row_size=*/2, /*start=*/2);
+  AddTask(input0, &batch);
+  AddTask(input1, &batch);
+  batch.Close();
+
+  std::vector<Tensor> concatenated;
+  TF_ASSERT_OK(access_.ConcatInputTensors(batch, NewContext(), &concatenated));
+  ASSERT_EQ(concatenated.size(), 1);
+  EXPECT_FALSE(concatenated[0].SharesBufferWith(input0));
+  EXPECT_FALSE(concatenated[0].SharesBufferWith(input1));
+  test::ExpectTensorEqual<float>(concatenated[0], Iota(3, 2, 0));
+}
+
+TEST_F(BatchResourceBaseCopyTest, AlignedOutputsAreSliced) {
+  // Rows of 64 bytes keep every slice aligned.
+  constexpr int64_t kRowSize = 16;
+  static_assert(kRowSize * sizeof(float) % EIGEN_MAX_ALIGN_BYTES == 0);
+  BatchResourceBase::BatchT batch;
+  OpKernelContext* context0 = AddTask(Iota(2, kRowSize, 0), &batch);
+  OpKernelContext* context1 = AddTask(Iota(3, kRowSize, 0), &batch);
+  batch.Close();
+
+  const Tensor output = Iota(/*num_rows=*/5, kRowSize, /*start=*/100);
+  TF_ASSERT_OK(access_.SplitOutputTensors({output}, &batch));
+  ASSERT_NE(context0->mutable_output(0), nullptr);
+  ASSERT_NE(context1->mutable_output(0), nullptr);
+  EXPECT_TRUE(context0->mutable_output(0)->SharesBufferWith(output));
+  EXPECT_TRUE(context1->mutable_output(0)->SharesBufferWith(output));
+  test::ExpectTensorEqual<float>(*context0->mutable_output(0),
+                                 Iota(2, kRowSize, 100));
+  test::ExpectTensorEqual<float>(*context1->mutable_output(0),
+                                 Iota(3, kRowSize, 100 + 2 * kRowSize));
+}
+
+TEST_F(BatchResourceBaseCopyTest, UnalignedOutputsAreCopied) {
+  // Rows of 12 bytes leave the second slice unaligned.
+  constexpr int64_t kRowSize = 3;
+  BatchResourceBase::BatchT batch;
+  OpKernelContext* context0 = AddTask(Iota(2, kRowSize, 0), &batch);
+  OpKernelContext* context1 = AddTask(Iota(3, kRowSize, 0), &batch);
+  batch.Close();
+
+  const Tensor output = Iota(/*num_rows=*/5, kRowSize, /*start=*/100);
+  TF_ASSERT_OK(access_.SplitOutputTensors({output}, &batch));
+  ASSERT_NE(context0->mutable_output(0), nullptr);
+  ASSERT_NE(context1->mutable_output(0), nullptr);
+  EXPECT_FALSE(context0->mutable_output(0)->SharesBufferWith(output));
+  EXPECT_FALSE(context1->mutable_output(0)->SharesBufferWith(output));
+  test::ExpectTensorEqual<float>(*context0->mutable_output(0),
+                                 Iota(2, kRowSize, 100));
+  test::ExpectTensorEqual<float>(*context1->mutable_output(0),
+                                 Iota(3, kRowSize, 100 + 2 * kRowSize));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
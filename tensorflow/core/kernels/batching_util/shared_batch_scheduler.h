@@ -25,6 +25,7 @@ limitations under the License.
 #include <functional>
 #include <list>
 #include <memory>
+#include <string>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
+#include "tensorflow/core/kernels/batching_util/slo_batching_policy.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -179,6 +181,19 @@ class SharedBatchScheduler
     // avoid latency spikes.
     int64_t batch_timeout_micros = 0;
 
+    // If positive, the p99 latency that the queue targets for its tasks, in
+    // microseconds, from their enqueueing to the end of the processing of
+    // their batch. The queue then learns the processing time of its batches as
+    // a function of their size, and closes its open batch once the batch is as
+    // large, or its first task has waited as long, as the target allows. This
+    // takes the place of 'batch_timeout_micros', which only applies until
+    // enough batches were processed. See SloBatchingPolicy.
+    int64_t target_latency_micros = 0;
+
+    // The name of the queue in the metrics of its 'target_latency_micros'
+    // decisions.
+    string name;
+
     // The maximum allowable number of enqueued (accepted by Schedule() but
     // not yet being processed on a batch thread) tasks in terms of batches.
     // If this limit is reached, Schedule() will return an UNAVAILABLE error.
@@ -269,6 +284,15 @@ class SharedBatchScheduler
     // effective only when enable_priority_queue is true.
     MixedPriorityBatchingPolicy mixed_priority_batching_policy =
         MixedPriorityBatchingPolicy::kLowPriorityPaddingWithMaxBatchSize;
+
+    // If positive, a low priority batch that is ready to be processed (i.e.
+    // that is full or whose earliest task timed out) is scheduled ahead of the
+    // closed high priority batches once this many high priority batches were
+    // scheduled in a row, so that low priority inputs still get a share of the
+    // batch threads under a sustained high priority load. If zero, the high
+    // priority batches are always scheduled first. It is effective only when
+    // enable_priority_queue is true.
+    size_t high_priority_batches_per_low_priority_batch = 0;
   };
   Status AddQueue(const QueueOptions& options,
                   ProcessBatchCallback process_batch_callback,
@@ -476,11 +500,23 @@ class Queue {
   bool IsOpenBatchSchedulableAfterEagerSplit() const
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Determines whether the open batch, of `open_batch_size` tasks, has waited
+  // for long enough to be scheduled.
+  bool IsOpenBatchTimedOut(size_t open_batch_size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Determines whether the low priority tasks in `low_priority_tasks_` can form
   // a batch on their own. If yes, returns a batch that is ready to be
-  // processed. Otherwise, returns an empty unique_ptr.
-  std::unique_ptr<Batch<TaskType>> ScheduleLowPriorityBatch()
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // processed. Otherwise, returns an empty unique_ptr. Unless
+  // `ahead_of_high_priority_batches` is true, none is formed while there are
+  // high priority tasks in the queue.
+  std::unique_ptr<Batch<TaskType>> ScheduleLowPriorityBatch(
+      bool ahead_of_high_priority_batches) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns true iff a low priority batch is due to be scheduled ahead of the
+  // high priority batches. See
+  // QueueOptions::high_priority_batches_per_low_priority_batch.
+  bool IsLowPriorityBatchDue() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Same as SchedulingCapacity(), but assumes the caller already holds a
   // lock on 'mu_'.
@@ -598,6 +634,15 @@ class Queue {
   // Incremented in ScheduleBatch() and decremented in ProcessBatch().
   int num_batches_being_processed_ TF_GUARDED_BY(mu_) = 0;
 
+  // The number of high priority batches scheduled since the last low priority
+  // batch.
+  size_t num_high_priority_batches_in_a_row_ TF_GUARDED_BY(mu_) = 0;
+
+  // Decides when to close the open batch, iff
+  // 'options_.target_latency_micros' is positive. Learns from the batches
+  // processed by ProcessBatch().
+  std::unique_ptr<SloBatchingPolicy> slo_policy_ TF_GUARDED_BY(mu_);
+
   // Used by CloseAndWaitUntilEmpty() to wait until the queue is empty, for
   // the case in which the queue is not empty when CloseAndWaitUntilEmpty()
   // starts. When ProcessBatch() dequeues the last batch and makes the queue
@@ -702,6 +747,11 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "batch_timeout_micros must be non-negative; was ",
         options.batch_timeout_micros);
   }
+  if (options.target_latency_micros < 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be non-negative; was ",
+        options.target_latency_micros);
+  }
   if (options.max_enqueued_batches == 0) {
     return errors::InvalidArgument(
         "max_enqueued_batches must be positive; was ",
@@ -895,6 +945,11 @@ Queue<TaskType>::Queue(
   } else {
     GetBatches().emplace_back(new Batch<TaskType>);
   }
+  if (options_.target_latency_micros > 0) {
+    slo_policy_ = std::make_unique<SloBatchingPolicy>(
+        options_.name, options_.target_latency_micros,
+        max_execution_batch_size_);
+  }
 }
 
 template <typename TaskType>
@@ -1226,16 +1281,23 @@ Queue<TaskType>::ScheduleBatchWithEagerSplit() {
       StartNewBatch();
     }
 
-    if (batches.size() >= 2) {
+    if (IsLowPriorityBatchDue()) {
+      batch_to_schedule =
+          ScheduleLowPriorityBatch(/*ahead_of_high_priority_batches=*/true);
+    }
+
+    if (batch_to_schedule == nullptr && batches.size() >= 2) {
       // There is at least one closed batch that is ready to be scheduled.
       batch_to_schedule = std::move(batches.front());
       batches.pop_front();
+      ++num_high_priority_batches_in_a_row_;
     }
 
     if (batch_to_schedule == nullptr) {
       // If there was no schedulable batch in the batch queue, try to schedule
       // from the low priority task queue.
-      batch_to_schedule = ScheduleLowPriorityBatch();
+      batch_to_schedule =
+          ScheduleLowPriorityBatch(/*ahead_of_high_priority_batches=*/false);
     }
 
     if (batch_to_schedule == nullptr) {
@@ -1335,6 +1397,11 @@ void Queue<TaskType>::ProcessBatch(
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
 
+  size_t batch_size = batch->size();
+  for (const std::unique_ptr<TaskType>& task : padding_task) {
+    batch_size += task->size();
+  }
+  const uint64 start_time_micros = env_->NowMicros();
   if (std::holds_alternative<ProcessBatchCallbackWithoutPaddingTasks>(
           process_batch_callback_)) {
     std::get<ProcessBatchCallbackWithoutPaddingTasks>(process_batch_callback_)(
@@ -1346,6 +1413,10 @@ void Queue<TaskType>::ProcessBatch(
 
   {
     mutex_lock l(mu_);
+    if (slo_policy_ != nullptr) {
+      slo_policy_->RecordBatch(batch_size,
+                               env_->NowMicros() - start_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -1418,8 +1489,7 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchTimedOut(open_batch->size());
 }
 
 template <typename TaskType>
@@ -1433,12 +1503,34 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchTimedOut(open_batch->size());
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchTimedOut(size_t open_batch_size) const {
+  const uint64 now_micros = env_->NowMicros();
+  if (slo_policy_ != nullptr && slo_policy_->has_estimate()) {
+    const int64_t wait_micros =
+        now_micros > open_batch_start_time_micros_
+            ? now_micros - open_batch_start_time_micros_
+            : 0;
+    return slo_policy_->ShouldClose(open_batch_size, wait_micros);
+  }
+  return now_micros >=
+         open_batch_start_time_micros_ + options_.batch_timeout_micros;
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsLowPriorityBatchDue() const {
+  return options_.enable_priority_queue &&
+         options_.high_priority_batches_per_low_priority_batch > 0 &&
+         num_high_priority_batches_in_a_row_ >=
+             options_.high_priority_batches_per_low_priority_batch;
 }
 
 template <typename TaskType>
-std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleLowPriorityBatch() {
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleLowPriorityBatch(
+    bool ahead_of_high_priority_batches) {
   std::unique_ptr<Batch<TaskType>> batch_to_schedule;
   if (!options_.enable_priority_queue || low_priority_tasks_.empty()) {
     // Return early if priority queue is disabled or there is no low priority
@@ -1454,7 +1546,8 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleLowPriorityBatch() {
     // and the earliest task didn't time out.
     return batch_to_schedule;
   }
-  if (!GetBatches().empty() && !GetBatches().front()->empty()) {
+  if (!ahead_of_high_priority_batches && !GetBatches().empty() &&
+      !GetBatches().front()->empty()) {
     // Return early if there is a non-empty high priority batch in the queue.
     return batch_to_schedule;
   }
@@ -1465,6 +1558,7 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleLowPriorityBatch() {
     batch_to_schedule->AddTask(std::move(task));
   }
   batch_to_schedule->Close();
+  num_high_priority_batches_in_a_row_ = 0;
 
   return batch_to_schedule;
 }
@@ -1016,6 +1016,24 @@ TEST_P(SharedBatchSchedulerTest, InvalidLazySplitOptions) {
                         "enable_large_batch_splitting is enabled."));
 }
 
+TEST_P(SharedBatchSchedulerTest, InvalidTargetLatency) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {
+    // do nothing.
+  };
+
+  auto scheduler = CreateSharedBatchScheduler(2);
+
+  QueueOptions queue_options = CreateQueueOptions(
+      /*max_execution_batch_size=*/10, /*input_batch_size_limit=*/10,
+      /*batch_timeout_micros=*/100 * 1000, /*max_enqueued_batches=*/2);
+  queue_options.target_latency_micros = -1;
+  std::unique_ptr<Queue> queue;
+  EXPECT_THAT(scheduler->AddQueue(queue_options, callback, &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT,
+                                "target_latency_micros must be non-negative; "
+                                "was -1"));
+}
+
 // Tests that queue configured with zero `max_enqueued_batches` get one queue.
 // Note, technically an invalid-argument error should be returned.
 // Since existing models (with very low QPS) rely on the rewrite, retain the
@@ -1602,6 +1620,58 @@ TEST_P(SharedBatchSchedulerPriorityPolicyTest,
   EXPECT_EQ(queue_callback_counter, 2);
 }
 
+TEST_P(SharedBatchSchedulerPriorityPolicyTest,
+       LowPriorityBatchScheduledAheadOfHighPriorityBatches) {
+  Notification processing, proceed;
+  std::vector<bool> low_priority_batches;
+  auto queue_callback = [&](std::unique_ptr<Batch<FakeTask>> batch,
+                            std::vector<std::unique_ptr<FakeTask>> tasks) {
+    low_priority_batches.push_back(batch->task(0).criticality() ==
+                                   tsl::criticality::Criticality::kSheddable);
+    if (!processing.HasBeenNotified()) {
+      processing.Notify();
+    }
+    proceed.WaitForNotification();
+  };
+
+  {
+    std::shared_ptr<Scheduler> scheduler =
+        CreateSharedBatchScheduler(/*num_batch_threads=*/1);
+
+    QueueOptions queue_options = CreateQueueOptions(
+        /*max_execution_batch_size=*/10, /*input_batch_size_limit=*/10,
+        /*batch_timeout_micros=*/1 * 1000 * 1000, /*max_enqueued_batches=*/4,
+        /*enable_priority_queue=*/true);
+    queue_options.low_priority_queue_options.max_execution_batch_size = 10;
+    queue_options.low_priority_queue_options.batch_timeout_micros =
+        1 * 1000 * 1000;
+    queue_options.low_priority_queue_options.input_batch_size_limit = 10;
+    queue_options.low_priority_queue_options.max_enqueued_batches = 2;
+    queue_options.mixed_priority_batching_policy =
+        MixedPriorityBatchingPolicy::kPriorityIsolation;
+    queue_options.high_priority_batches_per_low_priority_batch = 1;
+    std::unique_ptr<Queue> queue =
+        CreateQueue(scheduler, queue_options, queue_callback);
+
+    // Block the batch thread with a first high priority batch.
+    TF_ASSERT_OK(ScheduleTask(10, queue.get(),
+                              tsl::criticality::Criticality::kCriticalPlus));
+    processing.WaitForNotification();
+
+    // The full low priority batch goes ahead of the two high priority batches
+    // enqueued after it, since a high priority batch was just scheduled.
+    TF_ASSERT_OK(ScheduleTask(10, queue.get(),
+                              tsl::criticality::Criticality::kSheddable));
+    TF_ASSERT_OK(ScheduleTask(10, queue.get(),
+                              tsl::criticality::Criticality::kCriticalPlus));
+    TF_ASSERT_OK(ScheduleTask(10, queue.get(),
+                              tsl::criticality::Criticality::kCriticalPlus));
+    proceed.Notify();
+  }
+  EXPECT_THAT(low_priority_batches,
+              ::testing::ElementsAre(false, true, false, false));
+}
+
 // Lazy split is to be removed. The mixed priority batching is only supported
 // when the lazy split is not enabled.
 INSTANTIATE_TEST_SUITE_P(
@@ -0,0 +1,119 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/slo_batching_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/gauge.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The weight of each recorded batch in the fits, against those before it.
+constexpr double kDecay = 0.05;
+// The p99 of the standard normal distribution.
+constexpr double kP99Deviations = 2.33;
+
+auto* slo_max_batch_size = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/serving/batching/slo_max_batch_size",
+    "The size of the largest batch that a queue with a latency target forms, "
+    "as estimated to meet the target.",
+    "queue");
+
+auto* slo_max_batch_timeout_micros = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/serving/batching/slo_max_batch_timeout_micros",
+    "The longest time that a queue with a latency target holds an open batch, "
+    "i.e. one of a single task.",
+    "queue");
+
+}  // namespace
+
+SloBatchingPolicy::SloBatchingPolicy(std::string name,
+                                     int64_t target_latency_micros,
+                                     size_t max_batch_size)
+    : name_(std::move(name)),
+      target_latency_micros_(target_latency_micros),
+      max_batch_size_(max_batch_size),
+      max_batch_size_for_target_(max_batch_size) {}
+
+void SloBatchingPolicy::RecordBatch(size_t batch_size,
+                                    int64_t processing_micros) {
+  const double n = batch_size;
+  const double t = processing_micros;
+  if (num_batches_ > 0) {
+    const double error = t - (intercept_ + slope_ * n);
+    mean_squared_error_ =
+        (1 - kDecay) * mean_squared_error_ + kDecay * error * error;
+  }
+  sum_weights_ = (1 - kDecay) * sum_weights_ + kDecay;
+  sum_n_ = (1 - kDecay) * sum_n_ + kDecay * n;
+  sum_nn_ = (1 - kDecay) * sum_nn_ + kDecay * n * n;
+  sum_t_ = (1 - kDecay) * sum_t_ + kDecay * t;
+  sum_nt_ = (1 - kDecay) * sum_nt_ + kDecay * n * t;
+  ++num_batches_;
+  Update();
+}
+
+void SloBatchingPolicy::Update() {
+  const double mean_n = sum_n_ / sum_weights_;
+  const double mean_t = sum_t_ / sum_weights_;
+  const double variance_n = sum_nn_ / sum_weights_ - mean_n * mean_n;
+  if (variance_n >= 1) {
+    const double covariance = sum_nt_ / sum_weights_ - mean_n * mean_t;
+    slope_ = std::max(0.0, covariance / variance_n);
+    intercept_ = std::max(0.0, mean_t - slope_ * mean_n);
+  } else {
+    // With batches of about one size, the slope can't be fitted, and the
+    // processing time is taken as proportional to the size, which rather
+    // overestimates it for larger batches.
+    slope_ = mean_t / std::max(1.0, mean_n);
+    intercept_ = 0;
+  }
+  margin_ = kP99Deviations * std::sqrt(mean_squared_error_);
+  if (!has_estimate()) return;
+
+  const double budget = target_latency_micros_ - intercept_ - margin_;
+  size_t max_batch_size = max_batch_size_;
+  if (slope_ > 0) {
+    max_batch_size = static_cast<size_t>(
+        std::clamp(std::floor(budget / slope_), 1.0,
+                   static_cast<double>(max_batch_size_)));
+  }
+  max_batch_size_for_target_ = max_batch_size;
+  slo_max_batch_size->GetCell(name_)->Set(max_batch_size);
+  slo_max_batch_timeout_micros->GetCell(name_)->Set(std::max<int64_t>(
+      0, target_latency_micros_ - EstimateProcessingMicros(1)));
+}
+
+int64_t SloBatchingPolicy::EstimateProcessingMicros(size_t batch_size) const {
+  return std::llround(intercept_ + slope_ * batch_size + margin_);
+}
+
+bool SloBatchingPolicy::ShouldClose(size_t batch_size,
+                                    int64_t wait_micros) const {
+  return batch_size >= max_batch_size_for_target_ ||
+         wait_micros + EstimateProcessingMicros(batch_size) >=
+             target_latency_micros_;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,98 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SLO_BATCHING_POLICY_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SLO_BATCHING_POLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tensorflow {
+namespace serving {
+
+// Decides when a batching queue closes its open batch to meet a p99 latency
+// target, from the enqueueing of a task to the end of the processing of its
+// batch. See SharedBatchScheduler::QueueOptions::target_latency_micros.
+//
+// The processing time of a batch is learned from the past batches as a linear
+// function of their size, fitted with exponentially decaying weights, plus a
+// margin of 2.33 standard deviations of the errors of the fit (the p99 of a
+// normal distribution). An open batch is then held for as long as its first
+// task still meets the target once the batch is processed, which makes the
+// batches as large, and thus the throughput as high, as the target allows.
+// The time that closed batches wait for a batch thread isn't accounted for.
+//
+// Not thread-safe.
+class SloBatchingPolicy {
+ public:
+  // `name` labels the metrics of the decisions of the policy, which are
+  // updated with each recorded batch.
+  SloBatchingPolicy(std::string name, int64_t target_latency_micros,
+                    size_t max_batch_size);
+
+  // Records that a batch of `batch_size` tasks took `processing_micros` to
+  // process.
+  void RecordBatch(size_t batch_size, int64_t processing_micros);
+
+  // Whether enough batches were recorded for the policy to make decisions.
+  bool has_estimate() const { return num_batches_ >= kMinBatches; }
+
+  // The estimated p99 processing time of a batch of `batch_size` tasks.
+  // REQUIRES: has_estimate()
+  int64_t EstimateProcessingMicros(size_t batch_size) const;
+
+  // Whether an open batch of `batch_size` tasks, the first of which was
+  // enqueued `wait_micros` ago, is to be closed.
+  // REQUIRES: has_estimate()
+  bool ShouldClose(size_t batch_size, int64_t wait_micros) const;
+
+  // The size of the largest batch whose estimated processing time meets the
+  // target, between 1 and the maximum batch size of the queue.
+  size_t max_batch_size() const { return max_batch_size_for_target_; }
+
+ private:
+  // The number of batches to record before making decisions.
+  static constexpr int kMinBatches = 16;
+
+  // Fits the estimates to the recorded batches and exports the decisions.
+  void Update();
+
+  const std::string name_;
+  const int64_t target_latency_micros_;
+  const size_t max_batch_size_;
+
+  int64_t num_batches_ = 0;
+  // The weighted sums of the recorded batches, of their sizes `n` and
+  // processing times `t`.
+  double sum_weights_ = 0;
+  double sum_n_ = 0;
+  double sum_nn_ = 0;
+  double sum_t_ = 0;
+  double sum_nt_ = 0;
+  // The weighted mean of the squared errors of the estimates.
+  double mean_squared_error_ = 0;
+
+  // The estimated processing time is intercept_ + slope_ * n + margin_.
+  double intercept_ = 0;
+  double slope_ = 0;
+  double margin_ = 0;
+  size_t max_batch_size_for_target_;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SLO_BATCHING_POLICY_H_
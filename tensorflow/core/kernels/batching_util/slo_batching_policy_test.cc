@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/slo_batching_policy.h"
+
+#include <gtest/gtest.h>
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Records batches of sizes 1 to 32 that take 100us plus 10us per task.
+void RecordLinearBatches(SloBatchingPolicy* policy, int num_batches) {
+  for (int i = 0; i < num_batches; ++i) {
+    const int batch_size = i % 32 + 1;
+    policy->RecordBatch(batch_size, 100 + 10 * batch_size);
+  }
+}
+
+TEST(SloBatchingPolicyTest, NoEstimateUntilEnoughBatches) {
+  SloBatchingPolicy policy("queue", 500, 64);
+  RecordLinearBatches(&policy, 1);
+  EXPECT_FALSE(policy.has_estimate());
+  EXPECT_EQ(policy.max_batch_size(), 64);
+  RecordLinearBatches(&policy, 100);
+  EXPECT_TRUE(policy.has_estimate());
+}
+
+TEST(SloBatchingPolicyTest, LearnsProcessingTime) {
+  SloBatchingPolicy policy("queue", 500, 64);
+  RecordLinearBatches(&policy, 1000);
+  EXPECT_NEAR(policy.EstimateProcessingMicros(10), 200, 1);
+  EXPECT_NEAR(policy.EstimateProcessingMicros(64), 740, 1);
+  // (500 - 100) / 10 tasks fit in the target.
+  EXPECT_NEAR(policy.max_batch_size(), 40, 1);
+}
+
+TEST(SloBatchingPolicyTest, MaxBatchSizeIsCapped) {
+  SloBatchingPolicy policy("queue", 100000, 64);
+  RecordLinearBatches(&policy, 1000);
+  EXPECT_EQ(policy.max_batch_size(), 64);
+}
+
+TEST(SloBatchingPolicyTest, ShouldClose) {
+  SloBatchingPolicy policy("queue", 500, 64);
+  RecordLinearBatches(&policy, 1000);
+  // A batch of 10 takes about 200us, and may wait for about 300us.
+  EXPECT_FALSE(policy.ShouldClose(10, 0));
+  EXPECT_FALSE(policy.ShouldClose(10, 250));
+  EXPECT_TRUE(policy.ShouldClose(10, 350));
+  // A larger batch is closed sooner.
+  EXPECT_TRUE(policy.ShouldClose(30, 250));
+  // A batch of the largest size is closed right away.
+  EXPECT_TRUE(policy.ShouldClose(60, 0));
+}
+
+TEST(SloBatchingPolicyTest, SingleBatchSize) {
+  SloBatchingPolicy policy("queue", 500, 64);
+  for (int i = 0; i < 100; ++i) {
+    policy.RecordBatch(8, 80);
+  }
+  // The processing time is taken as proportional to the size.
+  EXPECT_NEAR(policy.EstimateProcessingMicros(16), 160, 1);
+  EXPECT_NEAR(policy.max_batch_size(), 50, 1);
+}
+
+TEST(SloBatchingPolicyTest, MarginGrowsWithNoise) {
+  SloBatchingPolicy exact("exact", 500, 64);
+  SloBatchingPolicy noisy("noisy", 500, 64);
+  for (int i = 0; i < 1000; ++i) {
+    exact.RecordBatch(8 + i % 2, 100);
+    noisy.RecordBatch(8 + i % 2, i % 4 < 2 ? 50 : 150);
+  }
+  EXPECT_GT(noisy.EstimateProcessingMicros(8),
+            exact.EstimateProcessingMicros(8) + 50);
+}
+
+}  // namespace
+
+}  // namespace serving
+}  // namespace tensorflow
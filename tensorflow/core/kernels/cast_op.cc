@@ -127,6 +127,8 @@ Status CpuCastOp::Prepare() {
     work_ = nullptr;  // Identity
     return absl::OkStatus();
   }
+  work_ = GetCpuCastLowPrecision(src_dtype_, dst_dtype_);
+  if (work_ != nullptr) return absl::OkStatus();
   if (src_dtype_ == DT_BOOL) {
     work_ = GetCpuCastFromBool(dst_dtype_);
   } else if (src_dtype_ == DT_UINT8) {
@@ -170,7 +172,7 @@ Status CpuCastOp::Prepare() {
   // TODO(sesse): If CPU casting to or from Eigen::half ever becomes a
   // bottleneck, we could probably implement specialized support for
   // vectorized versions (not the least based on F16C for Haswell
-  // or newer).
+  // or newer), like GetCpuCastLowPrecision does for bfloat16.
 
   return work_ == nullptr ? Unimplemented() : absl::OkStatus();
 }
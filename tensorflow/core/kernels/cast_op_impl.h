@@ -140,6 +140,10 @@ CastFunctorType GetCpuCastFromInt4(DataType dst_dtype);
 
 CastFunctorType GetCpuCastFromUint4(DataType dst_dtype);
 
+// Returns the faster CPU casts of cast_op_impl_low_precision.cc between float
+// and the low precision floating point types, or nullptr.
+CastFunctorType GetCpuCastLowPrecision(DataType src_dtype, DataType dst_dtype);
+
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
     (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
 // Same, for GPU.
@@ -0,0 +1,146 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU casts between float and the low precision floating point types that
+// mixed precision models do the most of. They work on the bits of the values
+// in loops without branches that the compiler vectorizes for the SIMD
+// instructions of the target, and produce the same values as the Eigen casts.
+
+#include <array>
+#include <cstdint>
+
+#include "tensorflow/core/kernels/cast_op_impl.h"
+
+namespace tensorflow {
+
+namespace {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Splits the cast of `n` values into blocks for the threads of the device.
+template <typename In, typename Out, typename Fn>
+void ParallelCast(OpKernelContext* ctx, int64_t n, Fn fn) {
+  const Eigen::TensorOpCost cost(sizeof(In), sizeof(Out), /*compute_cycles=*/1);
+  ctx->eigen_device<CPUDevice>().parallelFor(n, cost, fn);
+}
+
+// Rounds the floats to the nearest bfloat16, ties to even, or truncates them.
+// NaNs become quiet NaNs of the same sign.
+void CastFloatToBfloat16(OpKernelContext* ctx, const Tensor& inp, Tensor* out,
+                         bool truncate) {
+  const uint32_t* in =
+      reinterpret_cast<const uint32_t*>(inp.flat<float>().data());
+  uint16_t* o = reinterpret_cast<uint16_t*>(out->flat<bfloat16>().data());
+  // Masks the rounding bias away when truncating.
+  const uint32_t round_mask = truncate ? 0 : 0xffffffff;
+  auto work = [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const uint32_t u = in[i];
+      const uint32_t bias = (0x7fff + ((u >> 16) & 1)) & round_mask;
+      const uint16_t value = static_cast<uint16_t>((u + bias) >> 16);
+      const uint16_t nan = static_cast<uint16_t>(((u >> 16) & 0x8000) | 0x7fc0);
+      o[i] = (u & 0x7fffffff) > 0x7f800000 ? nan : value;
+    }
+  };
+  ParallelCast<float, bfloat16>(ctx, inp.NumElements(), work);
+}
+
+void CastBfloat16ToFloat(OpKernelContext* ctx, const Tensor& inp, Tensor* out,
+                         bool truncate) {
+  const uint16_t* in =
+      reinterpret_cast<const uint16_t*>(inp.flat<bfloat16>().data());
+  uint32_t* o = reinterpret_cast<uint32_t*>(out->flat<float>().data());
+  auto work = [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      o[i] = static_cast<uint32_t>(in[i]) << 16;
+    }
+  };
+  ParallelCast<bfloat16, float>(ctx, inp.NumElements(), work);
+}
+
+// Returns the casts of the 256 values of the 8 bit type `In` to `Out`, after
+// zeroing the mantissa bits that `Out` doesn't have if `truncate`.
+template <typename In, typename Out, bool truncate>
+const Out* CastTable() {
+  static const std::array<Out, 256>* table = [] {
+    auto* table = new std::array<Out, 256>;
+    for (int i = 0; i < 256; ++i) {
+      In value = Eigen::numext::bit_cast<In>(static_cast<uint8_t>(i));
+      if constexpr (truncate) {
+        value = functor::LSBZeroSetter<In, Out>()(value);
+      }
+      (*table)[i] = Eigen::internal::scalar_cast_op<In, Out>()(value);
+    }
+    return table;
+  }();
+  return table->data();
+}
+
+// Casts from the float8 types look the values up in a table. As in
+// CAST_FUNCTORS, only casts to types with fewer mantissa bits truncate.
+template <typename In, typename Out>
+void CastFromFloat8(OpKernelContext* ctx, const Tensor& inp, Tensor* out,
+                    bool truncate) {
+  static_assert(sizeof(In) == 1);
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(inp.flat<In>().data());
+  Out* o = out->flat<Out>().data();
+  const Out* table = CastTable<In, Out, false>();
+  if constexpr (functor::MantissaWidth<In>() > functor::MantissaWidth<Out>()) {
+    if (truncate) table = CastTable<In, Out, true>();
+  }
+  auto work = [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) o[i] = table[in[i]];
+  };
+  ParallelCast<In, Out>(ctx, inp.NumElements(), work);
+}
+
+template <typename In>
+CastFunctorType GetCpuCastFromFloat8(DataType dst_dtype) {
+  switch (dst_dtype) {
+    case DT_FLOAT:
+      return CastFromFloat8<In, float>;
+    case DT_BFLOAT16:
+      return CastFromFloat8<In, bfloat16>;
+    case DT_HALF:
+      return CastFromFloat8<In, Eigen::half>;
+    case DT_FLOAT8_E5M2:
+      return CastFromFloat8<In, float8_e5m2>;
+    case DT_FLOAT8_E4M3FN:
+      return CastFromFloat8<In, float8_e4m3fn>;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+CastFunctorType GetCpuCastLowPrecision(DataType src_dtype,
+                                       DataType dst_dtype) {
+  if (src_dtype == DT_FLOAT && dst_dtype == DT_BFLOAT16) {
+    return CastFloatToBfloat16;
+  }
+  if (src_dtype == DT_BFLOAT16 && dst_dtype == DT_FLOAT) {
+    return CastBfloat16ToFloat;
+  }
+  if (src_dtype == DT_FLOAT8_E5M2) {
+    return GetCpuCastFromFloat8<float8_e5m2>(dst_dtype);
+  }
+  if (src_dtype == DT_FLOAT8_E4M3FN) {
+    return GetCpuCastFromFloat8<float8_e4m3fn>(dst_dtype);
+  }
+  return nullptr;
+}
+
+}  // namespace tensorflow
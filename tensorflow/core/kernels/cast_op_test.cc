@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -21,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/cast_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -44,6 +48,49 @@ static Graph* Cast(int num) {
   return g;
 }
 
+// Like Cast, for the 8 bit float types that can't be set to random values.
+template <typename Src, typename Dst>
+static Graph* CastFromFloat8(int num) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor data(DataTypeToEnum<Src>::value,
+              TensorShape({64, 64, num / (64 * 64)}));
+  auto flat = data.flat<Src>();
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    flat(i) = Eigen::numext::bit_cast<Src>(static_cast<uint8_t>(i * 37));
+  }
+  test::graph::Cast(g, test::graph::Constant(g, data),
+                    DataTypeToEnum<Dst>::value);
+  return g;
+}
+
+template <typename T>
+uint32_t Bits(T value) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(T));
+  return bits;
+}
+
+// Returns all the values of an 8 or 16 bit type. For floats, returns the
+// values with all upper halves and the lower halves that round differently
+// to bfloat16.
+template <typename T>
+std::vector<T> BitPatterns() {
+  std::vector<T> values;
+  if constexpr (sizeof(T) == 4) {
+    for (uint32_t high = 0; high < 0x10000; ++high) {
+      for (uint32_t low : {0x0000, 0x0001, 0x7fff, 0x8000, 0x8001, 0xffff}) {
+        values.push_back(Eigen::numext::bit_cast<T>(high << 16 | low));
+      }
+    }
+  } else {
+    using UInt = std::conditional_t<sizeof(T) == 1, uint8_t, uint16_t>;
+    for (uint32_t bits = 0; bits < (1u << (8 * sizeof(T))); ++bits) {
+      values.push_back(Eigen::numext::bit_cast<T>(static_cast<UInt>(bits)));
+    }
+  }
+  return values;
+}
+
 class CastOpTest : public OpsTestBase {
  protected:
   void MakeOp(DataType src, DataType dst, bool trunc) {
@@ -78,8 +125,50 @@ class CastOpTest : public OpsTestBase {
                              {OUTPUT(1), OUTPUT(2), OUTPUT(3), OUTPUT(4)});
     test::ExpectTensorEqual<OUTPUT>(expected, *GetOutput(0));
   }
+
+  // Checks that the kernel casts all of BitPatterns<INPUT>() to the same bits
+  // as the scalar casts of Eigen do, NaNs included.
+  template <typename INPUT, typename OUTPUT>
+  void CheckCastBits(bool trunc) {
+    const std::vector<INPUT> values = BitPatterns<INPUT>();
+    MakeOp(DataTypeToEnum<INPUT>::v(), DataTypeToEnum<OUTPUT>::v(), trunc);
+    AddInputFromArray<INPUT>(
+        TensorShape({static_cast<int64_t>(values.size())}), values);
+    TF_ASSERT_OK(RunOpKernel());
+    const auto output = GetOutput(0)->flat<OUTPUT>();
+    for (size_t i = 0; i < values.size(); ++i) {
+      INPUT value = values[i];
+      if constexpr (functor::MantissaWidth<INPUT>() >
+                    functor::MantissaWidth<OUTPUT>()) {
+        if (trunc) value = functor::LSBZeroSetter<INPUT, OUTPUT>()(value);
+      }
+      ASSERT_EQ(Bits(output(i)), Bits(static_cast<OUTPUT>(value)))
+          << "input bits " << Bits(values[i]);
+    }
+  }
 };
 
+#define TEST_CAST_BITS(in, out)                                \
+  TEST_F(CastOpTest, TestCastBits_##in##_##out) {              \
+    CheckCastBits<in, out>(false);                             \
+  }                                                            \
+  TEST_F(CastOpTest, TestCastBitsTruncate_##in##_##out) {      \
+    CheckCastBits<in, out>(true);                              \
+  }
+
+TEST_CAST_BITS(float, bfloat16)
+TEST_CAST_BITS(bfloat16, float)
+TEST_CAST_BITS(float8_e5m2, float)
+TEST_CAST_BITS(float8_e5m2, bfloat16)
+TEST_CAST_BITS(float8_e5m2, half)
+TEST_CAST_BITS(float8_e5m2, float8_e4m3fn)
+TEST_CAST_BITS(float8_e4m3fn, float)
+TEST_CAST_BITS(float8_e4m3fn, bfloat16)
+TEST_CAST_BITS(float8_e4m3fn, half)
+TEST_CAST_BITS(float8_e4m3fn, float8_e5m2)
+
+#undef TEST_CAST_BITS
+
 #define TEST_CAST(in, out)                                                   \
   TEST_F(CastOpTest, TestCast##_##in##_##out) { CheckCast<in, out>(false); } \
   TEST_F(CastOpTest, TestCastTruncate_##_##in##_##out) {                     \
@@ -228,6 +317,25 @@ static void BM_cpu_bfloat16_float(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_cpu_bfloat16_float)->UseRealTime()->Arg(64 << 10)->Arg(32 << 20);
 
+#define BM_CPU_CAST_FROM_FLOAT8(src, dst)                                    \
+  static void BM_cpu_##src##_##dst(::testing::benchmark::State& state) {     \
+    const int num = state.range(0);                                          \
+    test::Benchmark("cpu", CastFromFloat8<src, dst>(num),                    \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * num); \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * num * \
+                            (sizeof(src) + sizeof(dst)));                    \
+  }                                                                          \
+  BENCHMARK(BM_cpu_##src##_##dst)->UseRealTime()->Arg(64 << 10)->Arg(32 << 20);
+
+BM_CPU_CAST_FROM_FLOAT8(float8_e5m2, float);
+BM_CPU_CAST_FROM_FLOAT8(float8_e5m2, bfloat16);
+BM_CPU_CAST_FROM_FLOAT8(float8_e4m3fn, float);
+BM_CPU_CAST_FROM_FLOAT8(float8_e4m3fn, bfloat16);
+BM_CPU_CAST_FROM_FLOAT8(float8_e4m3fn, half);
+#undef BM_CPU_CAST_FROM_FLOAT8
+
 static void BM_cpu_float_half(::testing::benchmark::State& state) {
   const int num = state.range(0);
 
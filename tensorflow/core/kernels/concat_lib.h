@@ -48,6 +48,17 @@ void ConcatCPU(
     const std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>&
         inputs,
     typename TTypes<T, 2>::Matrix* output);
+
+// Splits the `rows` x sum(`output_row_bytes`) matrix of bytes at `input` into
+// the matrices at `outputs`, of `rows` x `output_row_bytes[i]` bytes, along
+// the axis 1: the inverse of ConcatCPU() for types that can be copied with
+// memcpy. The rows are copied on the worker threads of `d`, each in one pass
+// over the outputs, which is what splits into many outputs with small inner
+// dimensions need.
+void SplitCPU(DeviceBase* d, const char* input, int64_t rows,
+              const std::vector<char*>& outputs,
+              const std::vector<int64_t>& output_row_bytes);
+
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
     (defined(TENSORFLOW_USE_ROCM) && TENSORFLOW_USE_ROCM)
 template <typename T>
@@ -17,19 +17,91 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/concat_lib_cpu.h"
 
+#include <cstdint>
+#include <cstring>
 #include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/concat_lib.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif  // __SSE2__
+
 namespace tensorflow {
 
 namespace {
+
+// Copies of at most this many bytes, which wide concats and splits with small
+// inner dimensions do a lot of, are done inline rather than by memcpy calls.
+constexpr size_t kMaxInlineCopyBytes = 32;
+// Outputs of at least this many bytes are written with streaming stores,
+// which don't evict the caches for data that won't be read soon, in the
+// copies that are large enough to fill whole cache lines.
+constexpr int64_t kMinStreamingOutputBytes = 8 << 20;
+constexpr size_t kMinStreamingCopyBytes = 1024;
+
+// Copies `n` <= kMaxInlineCopyBytes bytes with two loads and stores of a fixed
+// size that may overlap.
+inline void CopyInline(char* dst, const char* src, size_t n) {
+  if (n >= 16) {
+    std::memcpy(dst, src, 16);
+    std::memcpy(dst + n - 16, src + n - 16, 16);
+  } else if (n >= 8) {
+    std::memcpy(dst, src, 8);
+    std::memcpy(dst + n - 8, src + n - 8, 8);
+  } else if (n >= 4) {
+    std::memcpy(dst, src, 4);
+    std::memcpy(dst + n - 4, src + n - 4, 4);
+  } else if (n >= 2) {
+    std::memcpy(dst, src, 2);
+    std::memcpy(dst + n - 2, src + n - 2, 2);
+  } else if (n == 1) {
+    *dst = *src;
+  }
+}
+
+// Copies `n` >= 16 bytes with streaming stores where they are available.
+inline void CopyStreaming(char* dst, const char* src, size_t n) {
+#ifdef __SSE2__
+  // Aligns the destination of the streaming stores.
+  const size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+  std::memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  n -= head;
+  for (; n >= 16; n -= 16, dst += 16, src += 16) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+  }
+  std::memcpy(dst, src, n);
+  // Streaming stores are not ordered with the other stores, such as the ones
+  // that tell the consumers of the output that it's ready.
+  _mm_sfence();
+#else
+  std::memcpy(dst, src, n);
+#endif  // __SSE2__
+}
+
+inline void CopyBytes(char* dst, const char* src, size_t n, bool streaming) {
+  if (n <= kMaxInlineCopyBytes) {
+    CopyInline(dst, src, n);
+  } else if (streaming && n >= kMinStreamingCopyBytes) {
+    CopyStreaming(dst, src, n);
+  } else {
+    std::memcpy(dst, src, n);
+  }
+}
+
 template <typename T>
 struct MemCpyCopier {
+  // Whether to write the output with streaming stores.
+  bool streaming = false;
+
   inline void Copy(T* dst, const T* src, int input_index, size_t n) {
     if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
-      memcpy(dst, src, n * sizeof(T));
+      CopyBytes(reinterpret_cast<char*>(dst),
+                reinterpret_cast<const char*>(src), n * sizeof(T), streaming);
     } else {
       for (size_t k = 0; k < n; ++k) {
         *dst++ = *src++;
@@ -39,6 +111,8 @@ struct MemCpyCopier {
 };
 template <>
 struct MemCpyCopier<ResourceHandle> {
+  bool streaming = false;
+
   inline void Copy(ResourceHandle* dst, const ResourceHandle* src,
                    int input_index, size_t n) {
     for (size_t k = 0; k < n; ++k) {
@@ -104,7 +178,32 @@ void ConcatCPU(
         inputs,
     typename TTypes<T, 2>::Matrix* output) {
   int64_t cost_per_unit = EstimateBytesPerElement<T>(inputs);
-  ConcatCPUImpl<T>(d, inputs, cost_per_unit, MemCpyCopier<T>(), output);
+  const int64_t output_bytes = output->size() * sizeof(T);
+  MemCpyCopier<T> copier;
+  copier.streaming = output_bytes >= kMinStreamingOutputBytes;
+  ConcatCPUImpl<T>(d, inputs, cost_per_unit, copier, output);
+}
+
+void SplitCPU(DeviceBase* d, const char* input, int64_t rows,
+              const std::vector<char*>& outputs,
+              const std::vector<int64_t>& output_row_bytes) {
+  int64_t input_row_bytes = 0;
+  for (const int64_t bytes : output_row_bytes) input_row_bytes += bytes;
+  const bool streaming = rows * input_row_bytes >= kMinStreamingOutputBytes;
+  const size_t num_outputs = outputs.size();
+  auto work = [&](int64_t start, int64_t end) {
+    const char* in = input + start * input_row_bytes;
+    for (int64_t row = start; row < end; ++row) {
+      for (size_t i = 0; i < num_outputs; ++i) {
+        const int64_t bytes = output_row_bytes[i];
+        CopyBytes(outputs[i] + row * bytes, in, bytes, streaming);
+        in += bytes;
+      }
+    }
+  };
+  auto worker_threads = d->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, rows,
+        input_row_bytes, work);
 }
 
 #define REGISTER(T)                                                            \
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -20,12 +21,15 @@ limitations under the License.
 #include "absl/base/prefetch.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_factory.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/concat_lib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -156,18 +160,17 @@ BENCHMARK(BM_ConcatDim1bfloat16)
 
 template <typename T>
 static void ConcatManyHelper(::testing::benchmark::State& state,
-                             int concat_dimension, int dim2) {
+                             int concat_dimension, int dim2,
+                             int dim1 = 40000, int num_inputs = 64) {
   Graph* g = new Graph(OpRegistry::Global());
 
   DataType dt = DataTypeToEnum<T>::v();
-  const int kDim1 = 40000;
-  const int kNumInputs = 64;
   Tensor concat_dim(DT_INT32, TensorShape({}));
   concat_dim.scalar<int32>()() = concat_dimension;
   std::vector<NodeBuilder::NodeOut> inputs;
-  inputs.reserve(kNumInputs);
-  for (int i = 0; i < kNumInputs; ++i) {
-    Tensor in(dt, TensorShape({kDim1, dim2}));
+  inputs.reserve(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    Tensor in(dt, TensorShape({dim1, dim2}));
     in.flat<T>().setRandom();
     inputs.push_back(test::graph::Constant(g, in));
   }
@@ -176,12 +179,12 @@ static void ConcatManyHelper(::testing::benchmark::State& state,
   TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Concat")
                   .Input(test::graph::Constant(g, concat_dim))
                   .Input(inputs)
-                  .Attr("N", 64)
+                  .Attr("N", num_inputs)
                   .Attr("T", dt)
                   .Finalize(g, &node));
   test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
-  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * kDim1 *
-                          dim2 * kNumInputs * sizeof(T));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * dim1 *
+                          dim2 * num_inputs * sizeof(T));
 }
 
 void BM_ConcatManyDim1bfloat16(::testing::benchmark::State& state) {
@@ -192,6 +195,16 @@ void BM_ConcatManyDim1bfloat16(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ConcatManyDim1bfloat16)->UseRealTime()->Arg(18)->Arg(34)->Arg(60);
 
+// Concats of hundreds of inputs with small inner dimensions, as in batching.
+void BM_ConcatWideDim1float(::testing::benchmark::State& state) {
+  const int dim2 = state.range(0);
+
+  ConcatManyHelper<float>(state, 1, dim2, /*dim1=*/4096,
+                          /*num_inputs=*/512);
+}
+
+BENCHMARK(BM_ConcatWideDim1float)->UseRealTime()->Arg(1)->Arg(3)->Arg(8);
+
 void MemcpyAlternativeHelper(::testing::benchmark::State& state, int dim2) {
   const int kDim1 = 100;
   std::vector<float> data1(kDim1 * dim2, 1.0f);
@@ -323,5 +336,63 @@ BENCHMARK(MemcpyManyAlternative2)
     ->Arg(64)
     ->Arg(65);
 
+// Concatenates `num_rows` x `widths[i]` byte matrices with ConcatCPU() and
+// splits the result back with SplitCPU().
+void CheckConcatAndSplit(int64_t num_rows, const std::vector<int64_t>& widths) {
+  std::unique_ptr<Device> device =
+      DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0");
+  std::vector<Tensor> inputs;
+  std::vector<std::unique_ptr<TTypes<uint8, 2>::ConstMatrix>> input_matrices;
+  int64_t output_width = 0;
+  for (const int64_t width : widths) {
+    inputs.emplace_back(DT_UINT8, TensorShape({num_rows, width}));
+    inputs.back().flat<uint8>().setRandom();
+    output_width += width;
+  }
+  for (const Tensor& input : inputs) {
+    input_matrices.push_back(std::make_unique<TTypes<uint8, 2>::ConstMatrix>(
+        input.matrix<uint8>()));
+  }
+  Tensor output(DT_UINT8, TensorShape({num_rows, output_width}));
+  auto output_matrix = output.matrix<uint8>();
+  ConcatCPU<uint8>(device.get(), input_matrices, &output_matrix);
+
+  std::vector<Tensor> split;
+  std::vector<char*> split_data;
+  for (const Tensor& input : inputs) {
+    split.emplace_back(DT_UINT8, input.shape());
+    split.back().flat<uint8>().setZero();
+    split_data.push_back(const_cast<char*>(split.back().tensor_data().data()));
+  }
+  SplitCPU(device.get(), output.tensor_data().data(), num_rows, split_data,
+           widths);
+
+  int64_t column = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto input_matrix = inputs[i].matrix<uint8>();
+    for (int64_t row = 0; row < num_rows; ++row) {
+      ASSERT_EQ(std::memcmp(&output_matrix(row, column),
+                            &input_matrix(row, 0), widths[i]),
+                0)
+          << "input " << i << " row " << row;
+    }
+    column += widths[i];
+    test::ExpectTensorEqual<uint8>(split[i], inputs[i]);
+  }
+}
+
+TEST(ConcatCPUTest, ConcatsAndSplitsNarrowInputs) {
+  std::vector<int64_t> widths;
+  for (int width = 1; width <= 40; ++width) widths.push_back(width);
+  CheckConcatAndSplit(/*num_rows=*/100, widths);
+  CheckConcatAndSplit(/*num_rows=*/1, widths);
+}
+
+TEST(ConcatCPUTest, ConcatsAndSplitsLargeOutputs) {
+  // The output is large enough to be written with streaming stores, and the
+  // rows of the inputs are not aligned in it.
+  CheckConcatAndSplit(/*num_rows=*/2048, {1, 1027, 4099, 3000});
+}
+
 }  // namespace
 }  // namespace tensorflow
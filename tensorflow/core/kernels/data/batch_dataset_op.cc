@@ -51,6 +51,60 @@ namespace data {
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
+constexpr char kBatchIntoPreallocatedSlab[] = "batch_into_preallocated_slab";
+
+namespace {
+
+// Allocates one tensor per component of `element` with room for `batch_size`
+// copies of that component.
+Status AllocateBatch(IteratorContext* ctx, const std::vector<Tensor>& element,
+                     int64_t batch_size, std::vector<Tensor>* batch) {
+  batch->reserve(element.size());
+  for (size_t component_index = 0; component_index < element.size();
+       ++component_index) {
+    TensorShape batch_component_shape({batch_size});
+    batch_component_shape.AppendShape(element[component_index].shape());
+    batch->emplace_back(ctx->allocator({}), element[component_index].dtype(),
+                        batch_component_shape);
+    if (!batch->back().IsInitialized()) {
+      return errors::ResourceExhausted(
+          "Failed to allocate memory for the batch of component ",
+          component_index);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Copies the components of `element` into the `index`-th slices of `batch`.
+Status CopyElementToBatch(std::vector<Tensor>&& element, int64_t index,
+                          std::vector<Tensor>* batch) {
+  if (element.size() != batch->size()) {
+    return errors::InvalidArgument(
+        "Cannot batch elements with different numbers of components. First "
+        "element had ",
+        batch->size(), " components and element ", index, " had ",
+        element.size(), ".");
+  }
+  for (size_t component_index = 0; component_index < element.size();
+       ++component_index) {
+    Tensor& batch_component = (*batch)[component_index];
+    TensorShape element_shape = batch_component.shape();
+    element_shape.RemoveDim(0);
+    if (element[component_index].shape() != element_shape ||
+        element[component_index].dtype() != batch_component.dtype()) {
+      return errors::InvalidArgument(
+          "Cannot batch tensors with different shapes in component ",
+          component_index, ". First element had shape ",
+          element_shape.DebugString(), " and element ", index, " had shape ",
+          element[component_index].shape().DebugString(), ".");
+    }
+    TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+        std::move(element[component_index]), &batch_component, index));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
 
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
@@ -66,6 +120,10 @@ class BatchDatasetOp::Dataset : public DatasetBase {
                                      : std::min<int64_t>(batch_size, 1 << 16)),
         drop_remainder_(drop_remainder),
         parallel_copy_(parallel_copy),
+        // Preallocating the batch is only worthwhile for a bounded batch size,
+        // and a parallel copy needs all of the elements at once.
+        batch_into_slab_(!parallel_copy && reserve_size_ == batch_size &&
+                         GetExperiments().contains(kBatchIntoPreallocatedSlab)),
         input_(input),
         op_version_(op_version),
         traceme_metadata_(
@@ -201,6 +259,9 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (dataset()->batch_into_slab_) {
+        return GetNextIntoSlab(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -310,6 +371,65 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Like `GetNextInternal()`, but allocates the output batch as soon as the
+    // first input element arrives and copies each element into its slice
+    // right away. The input elements are released one at a time, instead of
+    // all being held until the batch is complete, and each copy reads an
+    // element that was just produced and is likely still in cache.
+    Status GetNextIntoSlab(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) {
+      std::vector<Tensor> batch;
+      int64_t num_elements = 0;
+      {
+        mutex_lock l(mu_);
+        if (!input_impl_) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        *end_of_sequence = false;
+        IteratorContextWithIndexMapper ctx_with_index_mapper(ctx, this);
+        std::vector<Tensor> batch_element_tuple;
+        while (num_elements < dataset()->batch_size_) {
+          batch_element_tuple.clear();
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx_with_index_mapper.Get(),
+                                                  &batch_element_tuple,
+                                                  end_of_sequence));
+          if (*end_of_sequence) {
+            input_impl_.reset();
+            break;
+          }
+          if (num_elements == 0) {
+            TF_RETURN_IF_ERROR(AllocateBatch(ctx, batch_element_tuple,
+                                             dataset()->batch_size_, &batch));
+          }
+          TF_RETURN_IF_ERROR(CopyElementToBatch(std::move(batch_element_tuple),
+                                                num_elements, &batch));
+          ++num_elements;
+        }
+        ctx_with_index_mapper.MergeCheckpoint();
+      }
+
+      if (num_elements == 0) {
+        DCHECK(*end_of_sequence);
+        return absl::OkStatus();
+      }
+
+      if (num_elements < dataset()->batch_size_) {
+        if (dataset()->drop_remainder_) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        // Only the last batch can be partial; it keeps its full allocation.
+        for (Tensor& batch_component : batch) {
+          batch_component = batch_component.Slice(0, num_elements);
+        }
+      }
+      *out_tensors = std::move(batch);
+      *end_of_sequence = false;
+      return absl::OkStatus();
+    }
+
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
   };
@@ -318,6 +438,10 @@ class BatchDatasetOp::Dataset : public DatasetBase {
   const int64_t reserve_size_;
   const bool drop_remainder_;
   const bool parallel_copy_;
+  // If true, input elements are copied into their slices of a batch that is
+  // allocated up front, as they arrive. Enabled by the
+  // "batch_into_preallocated_slab" tf.data experiment.
+  const bool batch_into_slab_;
   const DatasetBase* const input_;
   const int op_version_;
   std::vector<PartialTensorShape> output_shapes_;
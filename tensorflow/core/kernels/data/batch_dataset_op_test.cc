@@ -11,7 +11,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
+#include <stdlib.h>
+
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/type_inference.h"
 #include "tensorflow/core/data/dataset_test_base.h"
@@ -294,6 +298,177 @@ TEST_F(BatchDatasetOpTest, InvalidBatchSize) {
             absl::StatusCode::kInvalidArgument);
 }
 
+// Runs the tests below with the "batch_into_preallocated_slab" experiment,
+// which copies the elements into a batch allocated up front.
+class BatchDatasetOpSlabTest : public BatchDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+    setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+    setenv("TF_DATA_EXPERIMENT_OPT_IN", "batch_into_preallocated_slab",
+           /*overwrite=*/1);
+  }
+
+  void TearDown() override {
+    unsetenv("TF_JOB_NAME");
+    unsetenv("TF_TASK_ID");
+    unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+  }
+};
+
+// The preallocated batch is not used with `parallel_copy`.
+template <typename T>
+BatchDatasetParams SlabBatchDatasetParams(T input_dataset_params,
+                                          int64_t batch_size,
+                                          bool drop_remainder,
+                                          DataType dtype) {
+  return BatchDatasetParams(std::move(input_dataset_params), batch_size,
+                            drop_remainder,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{dtype},
+                            /*output_shapes=*/{PartialTensorShape({-1})},
+                            /*node_name=*/kNodeName);
+}
+
+TEST_F(BatchDatasetOpSlabTest, FullAndPartialBatches) {
+  auto dataset_params = SlabBatchDatasetParams(
+      RangeDatasetParams(0, 10, 1), /*batch_size=*/3,
+      /*drop_remainder=*/false, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      {CreateTensor<int64_t>(TensorShape({3}), {0, 1, 2}),
+       CreateTensor<int64_t>(TensorShape({3}), {3, 4, 5}),
+       CreateTensor<int64_t>(TensorShape({3}), {6, 7, 8}),
+       CreateTensor<int64_t>(TensorShape({1}), {9})},
+      /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpSlabTest, DropRemainder) {
+  auto dataset_params = SlabBatchDatasetParams(
+      RangeDatasetParams(0, 10, 1), /*batch_size=*/3,
+      /*drop_remainder=*/true, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64_t>(TensorShape({3}),
+                             {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpSlabTest, DropRemainderOfOnlyBatch) {
+  auto dataset_params = SlabBatchDatasetParams(
+      RangeDatasetParams(0, 10, 1), /*batch_size=*/12,
+      /*drop_remainder=*/true, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext({}, /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpSlabTest, SaveAndRestore) {
+  auto dataset_params = SlabBatchDatasetParams(
+      RangeDatasetParams(0, 10, 1), /*batch_size=*/3,
+      /*drop_remainder=*/false, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(),
+      {CreateTensor<int64_t>(TensorShape({3}), {0, 1, 2}),
+       CreateTensor<int64_t>(TensorShape({3}), {3, 4, 5}),
+       CreateTensor<int64_t>(TensorShape({3}), {6, 7, 8}),
+       CreateTensor<int64_t>(TensorShape({1}), {9})},
+      /*breakpoints=*/{0, 1, 5}, /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpSlabTest, StringComponents) {
+  auto dataset_params = SlabBatchDatasetParams(
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<tstring>(
+              TensorShape({5}), {"a", "bb", "ccc", "dddd", "eeeee"})},
+          /*node_name=*/"tensor_slice"),
+      /*batch_size=*/2, /*drop_remainder=*/false, DT_STRING);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      {CreateTensor<tstring>(TensorShape({2}), {"a", "bb"}),
+       CreateTensor<tstring>(TensorShape({2}), {"ccc", "dddd"}),
+       CreateTensor<tstring>(TensorShape({1}), {"eeeee"})},
+      /*compare_order=*/true));
+}
+
+TEST_F(BatchDatasetOpSlabTest, VariantComponents) {
+  std::vector<Tensor> values;
+  for (int64_t i = 0; i < 3; ++i) {
+    values.push_back(CreateTensor<int64_t>(TensorShape({2}), {i, 10 * i}));
+  }
+  auto dataset_params = SlabBatchDatasetParams(
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<Variant>(
+              TensorShape({3}), {values[0], values[1], values[2]})},
+          /*node_name=*/"tensor_slice"),
+      /*batch_size=*/2, /*drop_remainder=*/false, DT_VARIANT);
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  int64_t num_values = 0;
+  bool end_of_sequence = false;
+  while (true) {
+    std::vector<Tensor> out_tensors;
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+    if (end_of_sequence) break;
+    ASSERT_EQ(out_tensors.size(), 1);
+    ASSERT_EQ(out_tensors[0].dtype(), DT_VARIANT);
+    EXPECT_EQ(out_tensors[0].dim_size(0), num_values == 0 ? 2 : 1);
+    for (int64_t i = 0; i < out_tensors[0].dim_size(0); ++i) {
+      const Tensor* value = out_tensors[0].flat<Variant>()(i).get<Tensor>();
+      ASSERT_NE(value, nullptr);
+      TF_EXPECT_OK(ExpectEqual(*value, values[num_values++]));
+    }
+  }
+  EXPECT_EQ(num_values, 3);
+}
+
+TEST_F(BatchDatasetOpSlabTest, DifferentShapes) {
+  auto dataset_params = SlabBatchDatasetParams(
+      ConcatenateDatasetParams(
+          TensorSliceDatasetParams(
+              /*components=*/{CreateTensor<int64_t>(TensorShape{2, 3},
+                                                    {1, 2, 3, 4, 5, 6})},
+              /*node_name=*/"tensor_slice_0"),
+          TensorSliceDatasetParams(
+              /*components=*/{CreateTensor<int64_t>(TensorShape{2, 2},
+                                                    {7, 8, 9, 10})},
+              /*node_name=*/"tensor_slice_1"),
+          /*output_dtypes=*/{DT_INT64},
+          /*output_shapes=*/{PartialTensorShape({-1})},
+          /*node_name=*/"concatenate"),
+      /*batch_size=*/4, /*drop_remainder=*/false, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(BatchDatasetOpSlabTest, DifferentRanks) {
+  auto dataset_params = SlabBatchDatasetParams(
+      ConcatenateDatasetParams(
+          TensorSliceDatasetParams(
+              /*components=*/{CreateTensor<int64_t>(TensorShape{2}, {1, 2})},
+              /*node_name=*/"tensor_slice_0"),
+          TensorSliceDatasetParams(
+              /*components=*/{CreateTensor<int64_t>(TensorShape{2, 1}, {3, 4})},
+              /*node_name=*/"tensor_slice_1"),
+          /*output_dtypes=*/{DT_INT64},
+          /*output_shapes=*/{PartialTensorShape()},
+          /*node_name=*/"concatenate"),
+      /*batch_size=*/4, /*drop_remainder=*/false, DT_INT64);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kInvalidArgument);
+}
+
 // TODO(b/222556529) when Const has type constructor, remove the following
 REGISTER_OP("BatchDatasetOpTest>ConstTypeCtor")
     .Output("output: dtype")
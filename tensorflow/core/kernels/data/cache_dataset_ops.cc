@@ -22,6 +22,12 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/columnar_element_buffer.h"
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/global_shuffle_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -31,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/cache_ops.h"
 #include "tensorflow/core/kernels/data/iterator_ops.h"
+#include "tensorflow/core/kernels/data/mapped_file_cache.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
@@ -68,6 +75,7 @@ constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
+constexpr char kMappedFileCache[] = "mapped_file_cache";
 constexpr char kIncompleteCacheErrorMessage[] =
     "The calling iterator did not fully read the dataset being cached. In "
     "order to avoid unexpected truncation of the dataset, the partially cached "
@@ -149,9 +157,17 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         item_index_padding_size_(StringPaddingSize(kMaxItems)),
         tensor_format_string_(strings::Printf(kKeyStrFormat,
                                               item_index_padding_size_,
-                                              tensor_index_padding_size_)) {
+                                              tensor_index_padding_size_)),
+        use_mapped_cache_(GetExperiments().contains(kMappedFileCache)) {
     input_->Ref();
     DCHECK_EQ(item_index_padding_size_, 7);
+    if (env_->FileExists(MetaFilename(filename_)).ok()) {
+      random_indexing_compatible_ = absl::OkStatus();
+    } else {
+      random_indexing_compatible_ = absl::FailedPreconditionError(
+          absl::StrCat(type_string(), " only supports random access once "
+                                      "the cache file has been written."));
+    }
   }
 
   ~FileDatasetBase() override { input_->Unref(); }
@@ -191,11 +207,54 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  Status Get(OpKernelContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    return Get(AnyContext(ctx), index, out_tensors);
+  }
+
+  Status Get(AnyContext ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_ASSIGN_OR_RETURN(const MappedFileCache* cache, GetMappedCache());
+    return cache->Get(index, out_tensors);
+  }
+
+  absl::Status RandomIndexingCompatible() const override {
+    return random_indexing_compatible_;
+  }
+
  protected:
   const DatasetBase* const input_;
   const tstring filename_;
 
  private:
+  // Returns the memory-mapped view of the completed cache, opening it on
+  // first use.
+  absl::StatusOr<const MappedFileCache*> GetMappedCache() const {
+    mutex_lock l(mapped_cache_mu_);
+    if (mapped_cache_ == nullptr) {
+      if (!env_->FileExists(MetaFilename(filename_)).ok()) {
+        return errors::FailedPrecondition(
+            "The cache file ", filename_,
+            " must be completely written before it can be randomly accessed.");
+      }
+      TF_ASSIGN_OR_RETURN(
+          mapped_cache_, MappedFileCache::Open(env_, filename_, num_tensors_));
+      VLOG(1) << "Opened cache " << filename_ << " with "
+              << mapped_cache_->num_elements() << " elements; "
+              << mapped_cache_->num_mapped_components()
+              << " components are served from the mapping.";
+    }
+    return mapped_cache_.get();
+  }
+
+  BundleWriter::Options WriterOptions() const {
+    BundleWriter::Options options;
+    if (use_mapped_cache_) {
+      options.data_alignment = MappedFileCache::kDataAlignment;
+    }
+    return options;
+  }
+
   static size_t StringPaddingSize(size_t num_tensors) {
     return strings::Printf(kPaddingSizeStrFormat, num_tensors - 1).size();
   }
@@ -208,7 +267,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   class FileIterator : public DatasetIterator<FileDatasetBase> {
    public:
     explicit FileIterator(const Params& params)
-        : DatasetIterator<FileDatasetBase>(params) {
+        : DatasetIterator<FileDatasetBase>(params),
+          global_shuffle_iterator_(params.dataset) {
       if (params.dataset->env_
               ->FileExists(MetaFilename(params.dataset->filename_))
               .ok()) {
@@ -226,6 +286,10 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (ctx->index_mapper() != nullptr) {
+        return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                end_of_sequence);
+      }
       mutex_lock l(mu_);
       return iterator_->GetNext(ctx, out_tensors, end_of_sequence);
     }
@@ -245,6 +309,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     }
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      if (ctx->restored_element_count().has_value()) {
+        return global_shuffle_iterator_.Restore(ctx);
+      }
       mutex_lock l(mu_);
       {
         int64_t temp;
@@ -445,7 +512,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = std::make_unique<BundleWriter>(
+            dataset()->env_, filename_, dataset()->WriterOptions());
         return absl::OkStatus();
       }
 
@@ -507,7 +575,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = std::make_unique<BundleWriter>(
+            dataset()->env_, filename_, dataset()->WriterOptions());
         lockfile_created_ = true;
         return absl::OkStatus();
       }
@@ -569,6 +638,17 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         *end_of_sequence = false;
+        if (dataset()->use_mapped_cache_) {
+          TF_ASSIGN_OR_RETURN(const MappedFileCache* cache,
+                              dataset()->GetMappedCache());
+          if (cur_index_ >= static_cast<size_t>(cache->num_elements())) {
+            *end_of_sequence = true;
+            return absl::OkStatus();
+          }
+          TF_RETURN_IF_ERROR(cache->Get(cur_index_, out_tensors));
+          cur_index_++;
+          return absl::OkStatus();
+        }
         TF_RETURN_IF_ERROR(reader_.status());
         if (!reader_.Valid()) {
           *end_of_sequence = true;
@@ -674,6 +754,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     enum Mode { read, write };
     Mode mode_ TF_GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> iterator_ TF_GUARDED_BY(mu_);
+    // Serves globally shuffled iterations from the completed cache.
+    GlobalShuffleIterator global_shuffle_iterator_;
   };  // FileIterator
 
   Env* const env_;
@@ -682,6 +764,14 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   static constexpr size_t kMaxItems = 10000000;  // 10 million
   const size_t item_index_padding_size_;
   const string tensor_format_string_;
+  // If true, the cache is written with `MappedFileCache::kDataAlignment` and
+  // read back through a `MappedFileCache`. Enabled by the "mapped_file_cache"
+  // tf.data experiment.
+  const bool use_mapped_cache_;
+  absl::Status random_indexing_compatible_;
+  mutable mutex mapped_cache_mu_;
+  mutable std::unique_ptr<MappedFileCache> mapped_cache_
+      TF_GUARDED_BY(mapped_cache_mu_);
 };  // FileDatasetBase
 
 class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
@@ -826,8 +916,13 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       if (cache_->IsCompleted()) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCacheCompleted, ""));
-        TF_RETURN_IF_ERROR(
-            WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
+        if (const ColumnarElementBuffer* columnar = cache_->columnar_data()) {
+          TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+              writer, prefix(), columnar->ToElements()));
+        } else {
+          TF_RETURN_IF_ERROR(
+              WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
+        }
       }
       return SaveInput(ctx, writer, iterator_);
     }
@@ -851,11 +946,19 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
     class MemoryWriterIterator : public DatasetIterator<MemoryDatasetBase> {
      public:
       explicit MemoryWriterIterator(const Params& params, MemoryCache* cache)
-          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {}
+          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {
+        if (GetExperiments().contains("columnar_element_buffers") &&
+            ColumnarElementBuffer::CanStore(params.dataset->output_dtypes(),
+                                            params.dataset->output_shapes())) {
+          temp_columnar_cache_ = std::make_unique<ColumnarElementBuffer>(
+              params.dataset->output_dtypes(),
+              params.dataset->output_shapes());
+        }
+      }
 
       ~MemoryWriterIterator() override {
         mutex_lock l(mu_);
-        if (!temp_cache_.empty() && !cache_->IsCompleted()) {
+        if (TempCacheSize() > 0 && !cache_->IsCompleted()) {
           LOG(WARNING) << kIncompleteCacheErrorMessage;
           cache_->Reset();
         }
@@ -875,16 +978,20 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           if (!cache_->IsCompleted()) {
             VLOG(2) << "Finalizing the cache because EOF has been reached.";
-            cache_->Complete(std::move(temp_cache_));
+            CompleteCache();
           }
           return absl::OkStatus();
         }
         RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
-        if (temp_cache_.size() == dataset()->input_->Cardinality()) {
+        if (temp_columnar_cache_) {
+          TF_RETURN_IF_ERROR(temp_columnar_cache_->Append(*out_tensors));
+        } else {
+          temp_cache_.emplace_back(*out_tensors);
+        }
+        if (TempCacheSize() == dataset()->input_->Cardinality()) {
           VLOG(2) << "Finalizing the cache because its size matches the "
                      "expected input cardinality.";
-          cache_->Complete(std::move(temp_cache_));
+          CompleteCache();
         }
         return absl::OkStatus();
       }
@@ -900,8 +1007,13 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                           IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
         if (!cache_->IsCompleted()) {
-          TF_RETURN_IF_ERROR(
-              WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+          if (temp_columnar_cache_) {
+            TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+                writer, prefix(), temp_columnar_cache_->ToElements()));
+          } else {
+            TF_RETURN_IF_ERROR(
+                WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+          }
         }
         return SaveInput(ctx, writer, input_impl_);
       }
@@ -912,15 +1024,39 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         if (!reader->Contains(prefix(), kCacheCompleted)) {
           TF_RETURN_IF_ERROR(
               ReadElementsFromCheckpoint(ctx, reader, prefix(), &temp_cache_));
+          if (temp_columnar_cache_) {
+            temp_columnar_cache_->Clear();
+            for (const auto& element : temp_cache_) {
+              TF_RETURN_IF_ERROR(temp_columnar_cache_->Append(element));
+            }
+            temp_cache_.clear();
+          }
         }
         return RestoreInput(ctx, reader, input_impl_);
       }
 
      private:
+      size_t TempCacheSize() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return temp_columnar_cache_ ? temp_columnar_cache_->size()
+                                    : temp_cache_.size();
+      }
+
+      void CompleteCache() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (temp_columnar_cache_) {
+          cache_->Complete(std::move(temp_columnar_cache_));
+        } else {
+          cache_->Complete(std::move(temp_cache_));
+        }
+      }
+
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
       std::vector<std::vector<Tensor>> temp_cache_ TF_GUARDED_BY(mu_);
+      // Replaces `temp_cache_` when the "columnar_element_buffers" experiment
+      // is enabled and the elements have small, fixed-size components.
+      std::unique_ptr<ColumnarElementBuffer> temp_columnar_cache_
+          TF_GUARDED_BY(mu_);
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDatasetBase> {
@@ -937,8 +1073,17 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         // is that this is incorrect if there are concurrent instances of this
         // iterator.
         tf_shared_lock l(mu_);
-        for (size_t i = 0; i < cache_->size(); ++i) {
-          RecordBufferEnqueue(ctx, cache_->at(i));
+        if (cache_->columnar_data() == nullptr) {
+          for (size_t i = 0; i < cache_->size(); ++i) {
+            RecordBufferEnqueue(ctx, cache_->at(i));
+          }
+        } else if (ctx->model()) {
+          // Columnar elements are only materialized when they are modeled.
+          for (size_t i = 0; i < cache_->size(); ++i) {
+            std::vector<Tensor> element;
+            cache_->Get(i, &element);
+            RecordBufferEnqueue(ctx, element);
+          }
         }
         return absl::OkStatus();
       }
@@ -948,9 +1093,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         if (index_ < cache_->size()) {
-          const std::vector<Tensor>& cache_tensors = cache_->at(index_);
-          out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
-                              cache_tensors.end());
+          cache_->Get(index_, out_tensors);
           index_++;
           *end_of_sequence = false;
           return absl::OkStatus();
@@ -41,6 +41,14 @@ void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
   }
 }
 
+void MemoryCache::Complete(std::unique_ptr<ColumnarElementBuffer> cache) {
+  mutex_lock l(mu_);
+  if (!completed_) {
+    columnar_cache_ = std::move(cache);
+    completed_ = true;
+  }
+}
+
 bool MemoryCache::IsCompleted() {
   tf_shared_lock l(mu_);
   return completed_;
@@ -50,17 +58,30 @@ void MemoryCache::Reset() {
   mutex_lock l(mu_);
   completed_ = false;
   cache_.clear();
+  columnar_cache_.reset();
 }
 
 const std::vector<Tensor>& MemoryCache::at(int64_t index) {
   tf_shared_lock l(mu_);
+  DCHECK(columnar_cache_ == nullptr);
   DCHECK(index < cache_.size());
   return cache_[index];
 }
 
+void MemoryCache::Get(int64_t index, std::vector<Tensor>* out_tensors) {
+  tf_shared_lock l(mu_);
+  if (columnar_cache_) {
+    columnar_cache_->Get(index, out_tensors);
+    return;
+  }
+  DCHECK(index < cache_.size());
+  out_tensors->insert(out_tensors->end(), cache_[index].begin(),
+                      cache_[index].end());
+}
+
 size_t MemoryCache::size() {
   tf_shared_lock l(mu_);
-  return cache_.size();
+  return columnar_cache_ ? columnar_cache_->size() : cache_.size();
 }
 
 const std::vector<std::vector<Tensor>>& MemoryCache::data() {
@@ -68,6 +89,11 @@ const std::vector<std::vector<Tensor>>& MemoryCache::data() {
   return cache_;
 }
 
+const ColumnarElementBuffer* MemoryCache::columnar_data() {
+  tf_shared_lock l(mu_);
+  return columnar_cache_.get();
+}
+
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
     OpKernelConstruction* ctx)
     : AnonymousResourceOp<MemoryCacheManager>(ctx,
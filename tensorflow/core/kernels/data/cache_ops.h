@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 
+#include <memory>
+
+#include "tensorflow/core/data/columnar_element_buffer.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 
@@ -34,27 +37,42 @@ class MemoryCache {
   // Marks the cache as completed.
   void Complete(std::vector<std::vector<Tensor>>&& cache);
 
+  // Marks the cache as completed, with its elements stored column by column.
+  void Complete(std::unique_ptr<ColumnarElementBuffer> cache);
+
   // Returns whether the cache is completed.
   bool IsCompleted();
 
   // Resets the cache.
   void Reset();
 
-  // Returns the element at the given index.
+  // Returns the element at the given index. Requires that the cache is not
+  // columnar.
   const std::vector<Tensor>& at(int64_t index);
 
+  // Appends the components of the element at the given index to
+  // `out_tensors`. Elements of a columnar cache are materialized as new
+  // tensors.
+  void Get(int64_t index, std::vector<Tensor>* out_tensors);
+
   // Returns the size of the cache.
   size_t size();
 
   // Returns a reference to the cache's data. The returned reference will be
-  // invalidated by any call to Reset().
+  // invalidated by any call to Reset(). Empty if the cache is columnar.
   const std::vector<std::vector<Tensor>>& data();
 
+  // Returns the columnar storage of the cache's data, or nullptr if the cache
+  // is not columnar. The returned pointer will be invalidated by any call to
+  // Reset().
+  const ColumnarElementBuffer* columnar_data();
+
  private:
   mutex mu_;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ TF_GUARDED_BY(mu_) = false;
   std::vector<std::vector<Tensor>> cache_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<ColumnarElementBuffer> columnar_cache_ TF_GUARDED_BY(mu_);
 };
 
 // A resource wrapping a shared instance of a memory cache.
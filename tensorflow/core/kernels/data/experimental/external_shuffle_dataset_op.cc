@@ -0,0 +1,375 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/external_shuffle_dataset_op.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Constants declared in external_shuffle_dataset_op.h and used both here and
+// in test cases.
+/* static */ constexpr const char* const ExternalShuffleDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    ExternalShuffleDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    ExternalShuffleDatasetOp::kMemoryBudget;
+/* static */ constexpr const char* const
+    ExternalShuffleDatasetOp::kSpillDirectory;
+/* static */ constexpr const char* const ExternalShuffleDatasetOp::kSeed;
+/* static */ constexpr const char* const ExternalShuffleDatasetOp::kSeed2;
+/* static */ constexpr const char* const ExternalShuffleDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    ExternalShuffleDatasetOp::kOutputShapes;
+
+// Shuffles a finite input with a bounded amount of memory.
+//
+// The first call to `GetNext` reads the whole input. Elements are buffered
+// until they take up `memory_budget` bytes; the buffer is then shuffled and
+// written to a run file in `spill_directory`. Once the input is exhausted, the
+// runs are merged by repeatedly reading the next element of a run picked with
+// probability proportional to the number of elements it has left, which
+// produces a uniformly random permutation of the whole input. Each run file is
+// deleted as soon as it has been read. An input that fits within the budget
+// is shuffled and served from memory, without touching the file system.
+class ExternalShuffleDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, int64_t memory_budget,
+          tstring spill_directory, int64_t seed, int64_t seed2,
+          const DatasetBase* input)
+      : DatasetBase(DatasetContext(ctx)),
+        memory_budget_(memory_budget),
+        spill_directory_(std::move(spill_directory)),
+        seeds_(seed, seed2),
+        input_(input) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return std::make_unique<Iterator>(
+        Iterator::Params{this,
+                         name_utils::IteratorPrefix(kDatasetType, prefix)},
+        seeds_.first, seeds_.second);
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    return input_->Cardinality(options);
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return absl::OkStatus();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* memory_budget = nullptr;
+    Node* spill_directory = nullptr;
+    Node* seed = nullptr;
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(memory_budget_, &memory_budget));
+    TF_RETURN_IF_ERROR(b->AddScalar(spill_directory_, &spill_directory));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.first, &seed));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.second, &seed2));
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, memory_budget, spill_directory, seed, seed2},
+        output));
+    return absl::OkStatus();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    Iterator(const Params& params, int64_t seed, int64_t seed2)
+        : DatasetIterator<Dataset>(params),
+          seeds_(MaybeOverrideSeeds({seed, seed2})),
+          parent_generator_(seeds_.first, seeds_.second),
+          generator_(&parent_generator_) {}
+
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      DeleteRuns();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      env_ = ctx->env();
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(ReadInput(ctx));
+      }
+      if (runs_.empty()) {
+        if (next_buffered_ == buffer_.size()) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        *out_tensors = std::move(buffer_[next_buffered_++]);
+        *end_of_sequence = false;
+        return absl::OkStatus();
+      }
+      return ReadFromRuns(out_tensors, end_of_sequence);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args),
+                                       /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      return errors::Unimplemented(
+          "Checkpointing is not supported for ExternalShuffleDataset.");
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      return errors::Unimplemented(
+          "Checkpointing is not supported for ExternalShuffleDataset.");
+    }
+
+   private:
+    // A shuffled run of elements that was spilled to a file.
+    struct Run {
+      std::string filename;
+      int64_t num_remaining = 0;
+      std::unique_ptr<snapshot_util::TFRecordReader> reader;
+    };
+
+    // Reads the whole input, spilling shuffled runs whenever the buffered
+    // elements exceed the memory budget.
+    Status ReadInput(IteratorContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64_t buffered_bytes = 0;
+      bool end_of_input = false;
+      while (true) {
+        std::vector<Tensor> element;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) break;
+        buffered_bytes += GetTotalBytes(element);
+        buffer_.push_back(std::move(element));
+        if (buffered_bytes >= dataset()->memory_budget_) {
+          TF_RETURN_IF_ERROR(SpillBuffer());
+          buffered_bytes = 0;
+        }
+      }
+      input_impl_.reset();
+      if (runs_.empty()) {
+        Shuffle();
+        return absl::OkStatus();
+      }
+      if (!buffer_.empty()) {
+        TF_RETURN_IF_ERROR(SpillBuffer());
+      }
+      for (Run& run : runs_) {
+        run.reader = std::make_unique<snapshot_util::TFRecordReader>(
+            run.filename, io::compression::kNone, dataset()->output_dtypes());
+        TF_RETURN_IF_ERROR(run.reader->Initialize(env_));
+      }
+      VLOG(2) << "Merging " << runs_.size() << " runs of "
+              << num_remaining_ << " elements in total.";
+      return absl::OkStatus();
+    }
+
+    // Shuffles the buffered elements and writes them to a new run file.
+    Status SpillBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (runs_.empty()) {
+        TF_RETURN_IF_ERROR(
+            env_->RecursivelyCreateDir(dataset()->spill_directory_));
+        file_prefix_ = strings::StrCat("external_shuffle_", random::New64());
+      }
+      Shuffle();
+      Run run;
+      run.filename = io::JoinPath(
+          dataset()->spill_directory_,
+          strings::StrCat(file_prefix_, "_", runs_.size(), ".tfrecord"));
+      run.num_remaining = buffer_.size();
+      snapshot_util::TFRecordWriter writer(run.filename,
+                                           io::compression::kNone);
+      // Record the run before writing it, so that a partially written file is
+      // deleted along with the others.
+      runs_.push_back(std::move(run));
+      TF_RETURN_IF_ERROR(writer.Initialize(env_));
+      for (const std::vector<Tensor>& element : buffer_) {
+        TF_RETURN_IF_ERROR(writer.WriteTensors(element));
+      }
+      TF_RETURN_IF_ERROR(writer.Close());
+      num_remaining_ += buffer_.size();
+      buffer_.clear();
+      return absl::OkStatus();
+    }
+
+    Status ReadFromRuns(std::vector<Tensor>* out_tensors,
+                        bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (num_remaining_ == 0) {
+        *end_of_sequence = true;
+        return absl::OkStatus();
+      }
+      int64_t pick = Random() % num_remaining_;
+      size_t index = 0;
+      while (pick >= runs_[index].num_remaining) {
+        pick -= runs_[index].num_remaining;
+        ++index;
+      }
+      Run& run = runs_[index];
+      TF_RETURN_IF_ERROR(run.reader->ReadTensors(out_tensors));
+      --run.num_remaining;
+      --num_remaining_;
+      if (run.num_remaining == 0) {
+        run.reader.reset();
+        TF_RETURN_IF_ERROR(env_->DeleteFile(run.filename));
+        run.filename.clear();
+      }
+      *end_of_sequence = false;
+      return absl::OkStatus();
+    }
+
+    // Shuffles `buffer_` in place with a Fisher-Yates shuffle.
+    void Shuffle() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (int64_t i = buffer_.size() - 1; i > 0; --i) {
+        const int64_t j = Random() % (i + 1);
+        std::swap(buffer_[i], buffer_[j]);
+      }
+    }
+
+    // Deletes the files of runs that have not been fully read.
+    void DeleteRuns() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (Run& run : runs_) {
+        run.reader.reset();
+        if (run.filename.empty() || !env_->FileExists(run.filename).ok()) {
+          continue;
+        }
+        const Status s = env_->DeleteFile(run.filename);
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to delete spilled shuffle run "
+                       << run.filename << ": " << s;
+        }
+      }
+      runs_.clear();
+    }
+
+    uint64_t Random() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const uint64_t high = generator_();
+      return (high << 32) | generator_();
+    }
+
+    mutex mu_;
+    const std::pair<int64_t, int64_t> seeds_;
+    Env* env_ = nullptr;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
+    random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        TF_GUARDED_BY(mu_);
+    // Elements held in memory: the input read so far while spilling, or the
+    // whole shuffled input if it fit within the memory budget.
+    std::vector<std::vector<Tensor>> buffer_ TF_GUARDED_BY(mu_);
+    size_t next_buffered_ TF_GUARDED_BY(mu_) = 0;
+    std::string file_prefix_ TF_GUARDED_BY(mu_);
+    std::vector<Run> runs_ TF_GUARDED_BY(mu_);
+    int64_t num_remaining_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  const int64_t memory_budget_;
+  const tstring spill_directory_;
+  const std::pair<int64_t, int64_t> seeds_;
+  const DatasetBase* const input_;
+};  // ExternalShuffleDatasetOp::Dataset
+
+ExternalShuffleDatasetOp::ExternalShuffleDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {}
+
+void ExternalShuffleDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase* input,
+                                           DatasetBase** output) {
+  int64_t memory_budget;
+  tstring spill_directory;
+  int64_t seed;
+  int64_t seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kMemoryBudget,
+                                                   &memory_budget));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kSpillDirectory,
+                                                   &spill_directory));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed, &seed));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed2, &seed2));
+  OP_REQUIRES(ctx, memory_budget > 0,
+              errors::InvalidArgument("memory_budget must be positive, got ",
+                                      memory_budget));
+  OP_REQUIRES(ctx, !spill_directory.empty(),
+              errors::InvalidArgument("spill_directory must not be empty."));
+  OP_REQUIRES(ctx, input->Cardinality() != kInfiniteCardinality,
+              errors::InvalidArgument(
+                  "ExternalShuffleDataset requires a finite input."));
+  *output = new Dataset(ctx, memory_budget, spill_directory, seed, seed2,
+                        input);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("ExternalShuffleDataset").Device(DEVICE_CPU),
+                        ExternalShuffleDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,211 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/external_shuffle_dataset_op.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "external_shuffle_dataset";
+constexpr int64_t kRandomSeed = 42;
+constexpr int64_t kRandomSeed2 = 7;
+constexpr int64_t kNumElements = 10;
+
+class ExternalShuffleDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  ExternalShuffleDatasetParams(T input_dataset_params, int64_t memory_budget,
+                               std::string spill_directory,
+                               DataTypeVector output_dtypes,
+                               std::vector<PartialTensorShape> output_shapes,
+                               string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        memory_budget_(memory_budget),
+        spill_directory_(std::move(spill_directory)) {
+    input_dataset_params_.push_back(std::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<int64_t>(TensorShape({}), {memory_budget_}),
+            CreateTensor<tstring>(TensorShape({}), {spill_directory_}),
+            CreateTensor<int64_t>(TensorShape({}), {kRandomSeed}),
+            CreateTensor<int64_t>(TensorShape({}), {kRandomSeed2})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {ExternalShuffleDatasetOp::kInputDataset,
+                    ExternalShuffleDatasetOp::kMemoryBudget,
+                    ExternalShuffleDatasetOp::kSpillDirectory,
+                    ExternalShuffleDatasetOp::kSeed,
+                    ExternalShuffleDatasetOp::kSeed2};
+    return absl::OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{ExternalShuffleDatasetOp::kOutputTypes, output_dtypes_},
+                    {ExternalShuffleDatasetOp::kOutputShapes, output_shapes_}};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override {
+    return ExternalShuffleDatasetOp::kDatasetType;
+  }
+
+  const std::string& spill_directory() const { return spill_directory_; }
+
+ private:
+  int64_t memory_budget_;
+  std::string spill_directory_;
+};
+
+class ExternalShuffleDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  Status ReadAll(std::vector<int64_t>* values) {
+    bool end_of_sequence = false;
+    while (true) {
+      std::vector<Tensor> next;
+      TF_RETURN_IF_ERROR(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      if (end_of_sequence) return absl::OkStatus();
+      values->push_back(next[0].scalar<int64_t>()());
+    }
+  }
+};
+
+std::string SpillDirectory(const std::string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+// The whole input fits within the budget.
+ExternalShuffleDatasetParams InMemoryParams() {
+  return ExternalShuffleDatasetParams(
+      RangeDatasetParams(0, kNumElements, 1),
+      /*memory_budget=*/1 << 20, SpillDirectory("in_memory"),
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+// Each run holds three int64 scalars, so the input is spilled to four runs.
+ExternalShuffleDatasetParams SpillingParams() {
+  return ExternalShuffleDatasetParams(
+      RangeDatasetParams(0, kNumElements, 1),
+      /*memory_budget=*/3 * sizeof(int64_t), SpillDirectory("spilling"),
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> AllElements() {
+  std::vector<Tensor> elements;
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    elements.push_back(CreateTensor<int64_t>(TensorShape({}), {i}));
+  }
+  return elements;
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, InMemory) {
+  auto dataset_params = InMemoryParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(AllElements(), /*compare_order=*/false));
+  EXPECT_TRUE(errors::IsNotFound(
+      Env::Default()->FileExists(dataset_params.spill_directory())));
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, SpillsAndMerges) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(AllElements(), /*compare_order=*/false));
+  // Every run has been read, so none of them is left behind.
+  std::vector<string> children;
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(dataset_params.spill_directory(), &children));
+  EXPECT_TRUE(children.empty());
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, ShufflesAcrossRuns) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<int64_t> values;
+  TF_ASSERT_OK(ReadAll(&values));
+  ASSERT_EQ(values.size(), kNumElements);
+  // The output is a permutation of the input that does not simply concatenate
+  // the shuffled runs.
+  bool runs_in_order = true;
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    if (values[i] / 3 != i / 3) runs_in_order = false;
+  }
+  EXPECT_FALSE(runs_in_order);
+  std::sort(values.begin(), values.end());
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    EXPECT_EQ(values[i], i);
+  }
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, DeletesRunsOfUnfinishedIterator) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> next;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+  std::vector<string> children;
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(dataset_params.spill_directory(), &children));
+  EXPECT_FALSE(children.empty());
+  iterator_.reset();
+  children.clear();
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(dataset_params.spill_directory(), &children));
+  EXPECT_TRUE(children.empty());
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = InMemoryParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = InMemoryParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(ExternalShuffleDatasetOp::kDatasetType)));
+}
+
+TEST_F(ExternalShuffleDatasetOpTest, Cardinality) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(kNumElements));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
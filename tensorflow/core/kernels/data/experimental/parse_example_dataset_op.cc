@@ -192,6 +192,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                   errors::InvalidArgument("Duplicate key not allowed: ",
                                           ragged_keys_[d]));
     }
+    // Every batch is parsed with a copy of this config, which shares its
+    // feature index.
+    OP_REQUIRES_OK(ctx, example::PrecomputeFeatureIndex(&config));
     int i = 0;
     for (auto it = key_to_output_index.begin(); it != key_to_output_index.end();
          it++) {
@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/time/clock.h"
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/hash_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
@@ -66,6 +67,12 @@ namespace experimental {
 /* static */ constexpr const char* const
     SnapshotDatasetV2Op::kShardFuncTarguments;
 /* static */ constexpr const int SnapshotDatasetV2Op::kFileFormatVersion;
+/* static */ constexpr const int
+    SnapshotDatasetV2Op::kColumnarFileFormatVersion;
+
+// Writes snapshot files with the columnar file format, if the compression
+// supports it.
+constexpr char kColumnarSnapshotFormat[] = "columnar_snapshot_format";
 
 // ==== Snapshot Implementation ====
 
@@ -112,7 +119,13 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
         reader_prefix_(reader_prefix),
         writer_prefix_(writer_prefix),
         reader_func_(std::move(reader_func)),
-        shard_func_(std::move(shard_func)) {
+        shard_func_(std::move(shard_func)),
+        file_format_version_(
+            GetExperiments().contains(kColumnarSnapshotFormat) &&
+                    (compression == io::compression::kNone ||
+                     compression == io::compression::kSnappy)
+                ? kColumnarFileFormatVersion
+                : kFileFormatVersion) {
     input_->Ref();
   }
 
@@ -234,6 +247,9 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
 
   std::unique_ptr<CapturedFunction> reader_func_;
   std::unique_ptr<CapturedFunction> shard_func_;
+  // The version of the files that are written. Readers use the version in the
+  // snapshot metadata instead.
+  const int file_format_version_;
 
   class Reader : public DatasetIterator<Dataset> {
    public:
@@ -416,7 +432,8 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
           auto writer = std::make_unique<snapshot_util::AsyncWriter>(
               ctx->env(), shard_index, snapshot_shard_directory,
               current_checkpoint_id_, dataset()->compression_,
-              kFileFormatVersion, dataset()->output_dtypes(), [this](Status s) {
+              dataset()->file_format_version_, dataset()->output_dtypes(),
+              [this](Status s) {
                 if (!s.ok()) {
                   LOG(ERROR) << "AsyncWriter in snapshot writer failed: " << s;
                   mutex_lock l(writer_status_mu_);
@@ -499,7 +516,7 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
       metadata.set_creation_timestamp(EnvTime::NowMicros());
       metadata.set_graph_hash(strings::StrCat(dataset()->hash_));
       metadata.set_run_id(strings::StrCat(run_id_));
-      metadata.set_version(kFileFormatVersion);
+      metadata.set_version(dataset()->file_format_version_);
       for (const auto& output_dtype : dataset()->output_dtypes()) {
         metadata.add_dtype(output_dtype);
       }
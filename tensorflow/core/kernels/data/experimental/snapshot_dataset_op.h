@@ -71,6 +71,9 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
 
  private:
   static constexpr const int kFileFormatVersion = 2;
+  // Written instead of `kFileFormatVersion` by the "columnar_snapshot_format"
+  // tf.data experiment.
+  static constexpr const int kColumnarFileFormatVersion = 3;
 
   class Dataset;
 
@@ -0,0 +1,190 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/mapped_file_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/byte_order.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// A tensor buffer that points into a memory-mapped cache file, and keeps the
+// mapping alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mapped_file_cache");
+  }
+  // The mapping is read-only, so kernels must never forward this buffer to
+  // one of their outputs.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<MappedFileCache>> MappedFileCache::Open(
+    Env* env, const std::string& prefix, size_t num_components) {
+  if (num_components == 0) {
+    return errors::InvalidArgument("Cache elements must have components.");
+  }
+  auto reader = std::make_unique<BundleReader>(env, prefix);
+  TF_RETURN_IF_ERROR(reader->status());
+  reader->Seek(kHeaderEntryKey);
+  if (!reader->Valid() || reader->key() != kHeaderEntryKey) {
+    return errors::DataLoss("Cache ", prefix, " has no header entry.");
+  }
+  BundleHeaderProto header;
+  if (!header.ParseFromArray(reader->value().data(), reader->value().size())) {
+    return errors::DataLoss("Failed to parse the header of cache ", prefix);
+  }
+  const bool native_endianness =
+      (header.endianness() == BundleHeaderProto::LITTLE) == port::kLittleEndian;
+
+  // Map every data file. A file system that does not support mapping leaves
+  // its shards to `reader`.
+  std::vector<std::shared_ptr<ReadOnlyMemoryRegion>> shards(
+      header.num_shards());
+  for (int i = 0; i < header.num_shards(); ++i) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    const Status s = env->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix, i, header.num_shards()), &region);
+    if (s.ok()) {
+      shards[i] = std::move(region);
+    } else {
+      VLOG(1) << "Reading shard " << i << " of cache " << prefix
+              << " without memory mapping: " << s;
+    }
+  }
+
+  std::vector<Component> components;
+  int64_t num_mapped_components = 0;
+  for (reader->Next(); reader->Valid(); reader->Next()) {
+    BundleEntryProto entry;
+    if (!entry.ParseFromArray(reader->value().data(),
+                              reader->value().size())) {
+      return errors::DataLoss("Failed to parse the entry for key ",
+                              reader->key(), " of cache ", prefix);
+    }
+    Component component;
+    component.dtype = entry.dtype();
+    TF_RETURN_IF_ERROR(
+        TensorShape::BuildTensorShape(entry.shape(), &component.shape));
+    const int64_t expected_size =
+        DataTypeCanUseMemcpy(entry.dtype())
+            ? component.shape.num_elements() * DataTypeSize(entry.dtype())
+            : -1;
+    const ReadOnlyMemoryRegion* region =
+        entry.shard_id() >= 0 && entry.shard_id() < header.num_shards()
+            ? shards[entry.shard_id()].get()
+            : nullptr;
+    bool mapped = native_endianness && entry.slices_size() == 0 &&
+                  expected_size >= 0 && entry.size() == expected_size &&
+                  region != nullptr && entry.offset() >= 0 &&
+                  static_cast<uint64_t>(entry.offset() + entry.size()) <=
+                      region->length();
+    if (mapped && entry.size() > 0) {
+      const char* data =
+          static_cast<const char*>(region->data()) + entry.offset();
+      mapped = reinterpret_cast<uintptr_t>(data) % kDataAlignment == 0;
+      component.data = data;
+      component.shard = entry.shard_id();
+    }
+    if (mapped) {
+      ++num_mapped_components;
+    } else {
+      component.data = nullptr;
+      component.key = std::string(reader->key());
+    }
+    components.push_back(std::move(component));
+  }
+  TF_RETURN_IF_ERROR(reader->status());
+  if (components.size() % num_components != 0) {
+    return errors::DataLoss("Cache ", prefix, " has ", components.size(),
+                            " tensors, which is not a multiple of the ",
+                            num_components, " components of each element.");
+  }
+
+  std::unique_ptr<MappedFileCache> cache(
+      new MappedFileCache(num_components, std::move(reader)));
+  cache->num_elements_ = components.size() / num_components;
+  cache->num_mapped_components_ = num_mapped_components;
+  cache->components_ = std::move(components);
+  cache->shards_ = std::move(shards);
+  return cache;
+}
+
+MappedFileCache::MappedFileCache(size_t num_components,
+                                 std::unique_ptr<BundleReader> reader)
+    : num_components_(num_components), reader_(std::move(reader)) {}
+
+Status MappedFileCache::Get(int64_t index,
+                            std::vector<Tensor>* out_tensors) const {
+  if (index < 0 || index >= num_elements_) {
+    return errors::OutOfRange("Index out of range [0, ", num_elements_,
+                              "):", index);
+  }
+  out_tensors->clear();
+  out_tensors->reserve(num_components_);
+  for (size_t i = 0; i < num_components_; ++i) {
+    const Component& component = components_[index * num_components_ + i];
+    if (!component.key.empty()) {
+      Tensor tensor;
+      {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader_->Lookup(component.key, &tensor));
+      }
+      out_tensors->push_back(std::move(tensor));
+    } else if (component.data == nullptr) {
+      out_tensors->emplace_back(component.dtype, component.shape);
+    } else {
+      core::RefCountPtr<TensorBuffer> buffer(new MappedTensorBuffer(
+          shards_[component.shard], component.data,
+          component.shape.num_elements() * DataTypeSize(component.dtype)));
+      out_tensors->emplace_back(component.dtype, component.shape,
+                                std::move(buffer));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
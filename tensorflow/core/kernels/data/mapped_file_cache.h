@@ -0,0 +1,102 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_MAPPED_FILE_CACHE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_MAPPED_FILE_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace data {
+
+// Random access to the elements of a completed `CacheDataset` file cache.
+//
+// The cache is a tensor bundle whose entries hold the components of each
+// element in order, so the `i`-th entry after the header is component
+// `i % num_components` of element `i / num_components`. On open, the index of
+// the bundle is read once into memory and its data files are memory-mapped.
+// Components of POD types whose data is suitably aligned, which is the case
+// for caches written with `kDataAlignment`, are returned as tensors that point
+// into the mapping, without any copy or deserialization; the mapping stays
+// alive as long as any such tensor does. Other components are read through a
+// `BundleReader`.
+//
+// Data read from the mapping is not checked against the checksums in the
+// index, since that would require touching every byte of the cache on open.
+//
+// This class is thread-safe.
+class MappedFileCache {
+ public:
+  // The data alignment with which cache files should be written for their
+  // tensors to be served from the mapping.
+  static constexpr int kDataAlignment = Allocator::kAllocatorAlignment;
+
+  // Opens the completed cache with the given bundle prefix, whose elements
+  // have `num_components` components each.
+  static absl::StatusOr<std::unique_ptr<MappedFileCache>> Open(
+      Env* env, const std::string& prefix, size_t num_components);
+
+  MappedFileCache(const MappedFileCache&) = delete;
+  void operator=(const MappedFileCache&) = delete;
+
+  int64_t num_elements() const { return num_elements_; }
+
+  // Returns the components of the element at `index`, or an `OutOfRange`
+  // error if `index` is not in [0, num_elements()).
+  Status Get(int64_t index, std::vector<Tensor>* out_tensors) const;
+
+  // The number of components that are served from the mapping.
+  int64_t num_mapped_components() const { return num_mapped_components_; }
+
+ private:
+  struct Component {
+    DataType dtype;
+    TensorShape shape;
+    // Only set for components that are served from the mapping.
+    const char* data = nullptr;
+    int32_t shard = 0;
+    // Only set for components that are read through `reader_`.
+    std::string key;
+  };
+
+  MappedFileCache(size_t num_components, std::unique_ptr<BundleReader> reader);
+
+  const size_t num_components_;
+  int64_t num_elements_ = 0;
+  int64_t num_mapped_components_ = 0;
+  std::vector<Component> components_;
+  std::vector<std::shared_ptr<ReadOnlyMemoryRegion>> shards_;
+
+  mutable mutex mu_;
+  const std::unique_ptr<BundleReader> reader_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_MAPPED_FILE_CACHE_H_
@@ -0,0 +1,142 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/mapped_file_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr int kNumElements = 10;
+
+std::string Prefix(const std::string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+std::string Key(int element, int component) {
+  return strings::Printf("%07d_%d", element, component);
+}
+
+// Writes a cache whose elements are a float vector of length 3 and an int64
+// scalar, both derived from the element index.
+void WriteNumericCache(const std::string& prefix, int data_alignment) {
+  BundleWriter::Options options;
+  options.data_alignment = data_alignment;
+  BundleWriter writer(Env::Default(), prefix, options);
+  for (int i = 0; i < kNumElements; ++i) {
+    TF_ASSERT_OK(writer.Add(
+        Key(i, 0), test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i})));
+    TF_ASSERT_OK(writer.Add(Key(i, 1), test::AsScalar<int64_t>(i)));
+  }
+  TF_ASSERT_OK(writer.Finish());
+}
+
+TEST(MappedFileCacheTest, ServesAlignedCacheFromMapping) {
+  const std::string prefix = Prefix("aligned");
+  WriteNumericCache(prefix, MappedFileCache::kDataAlignment);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<MappedFileCache> cache,
+      MappedFileCache::Open(Env::Default(), prefix, /*num_components=*/2));
+  EXPECT_EQ(cache->num_elements(), kNumElements);
+  EXPECT_EQ(cache->num_mapped_components(), 2 * kNumElements);
+
+  for (int i : {7, 0, 9, 3}) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(cache->Get(i, &element));
+    ASSERT_EQ(element.size(), 2);
+    test::ExpectTensorEqual<float>(
+        element[0], test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i}));
+    test::ExpectTensorEqual<int64_t>(element[1], test::AsScalar<int64_t>(i));
+    EXPECT_FALSE(element[0].RefCountIsOne());
+  }
+  std::vector<Tensor> element;
+  EXPECT_TRUE(errors::IsOutOfRange(cache->Get(kNumElements, &element)));
+}
+
+TEST(MappedFileCacheTest, ReadsUnalignedCache) {
+  const std::string prefix = Prefix("unaligned");
+  WriteNumericCache(prefix, /*data_alignment=*/1);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<MappedFileCache> cache,
+      MappedFileCache::Open(Env::Default(), prefix, /*num_components=*/2));
+  EXPECT_LT(cache->num_mapped_components(), 2 * kNumElements);
+  for (int i = 0; i < kNumElements; ++i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(cache->Get(i, &element));
+    test::ExpectTensorEqual<float>(
+        element[0], test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i}));
+    test::ExpectTensorEqual<int64_t>(element[1], test::AsScalar<int64_t>(i));
+  }
+}
+
+TEST(MappedFileCacheTest, ReadsStrings) {
+  const std::string prefix = Prefix("strings");
+  {
+    BundleWriter writer(Env::Default(), prefix);
+    for (int i = 0; i < kNumElements; ++i) {
+      TF_ASSERT_OK(writer.Add(
+          Key(i, 0), test::AsTensor<tstring>({strings::StrCat("s", i)})));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<MappedFileCache> cache,
+      MappedFileCache::Open(Env::Default(), prefix, /*num_components=*/1));
+  EXPECT_EQ(cache->num_mapped_components(), 0);
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(cache->Get(4, &element));
+  test::ExpectTensorEqual<tstring>(element[0],
+                                   test::AsTensor<tstring>({"s4"}));
+}
+
+TEST(MappedFileCacheTest, TensorsOutliveCache) {
+  const std::string prefix = Prefix("outlive");
+  WriteNumericCache(prefix, MappedFileCache::kDataAlignment);
+  std::vector<Tensor> element;
+  {
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<MappedFileCache> cache,
+        MappedFileCache::Open(Env::Default(), prefix, /*num_components=*/2));
+    TF_ASSERT_OK(cache->Get(5, &element));
+  }
+  test::ExpectTensorEqual<float>(element[0],
+                                 test::AsTensor<float>({5.0f, 10.0f, 15.0f}));
+}
+
+TEST(MappedFileCacheTest, RejectsMismatchedComponents) {
+  const std::string prefix = Prefix("mismatched");
+  WriteNumericCache(prefix, MappedFileCache::kDataAlignment);
+  EXPECT_TRUE(errors::IsDataLoss(
+      MappedFileCache::Open(Env::Default(), prefix, /*num_components=*/3)
+          .status()));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <utility>
 
 #include "absl/time/time.h"
@@ -25,19 +27,23 @@ limitations under the License.
 #include "tensorflow/core/data/metric_utils.h"
 #include "tensorflow/core/data/root_dataset.h"
 #include "tensorflow/core/data/unbounded_thread_pool.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/data/iterator_ops.h"
+#include "tensorflow/core/kernels/data/prefetch_autotuner.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
@@ -50,6 +56,7 @@ const char kAnonymousMultiDeviceIteratorV3[] = "AnonymousMultiDeviceIteratorV3";
 const char kDevices[] = "devices";
 const char kOutputShapes[] = "output_shapes";
 const char kOutputTypes[] = "output_types";
+const char kPinnedBuffers[] = "multi_device_iterator_pinned_buffers";
 
 struct HostBufferElement {
   Status status;
@@ -182,7 +189,21 @@ class MultiDeviceIterator : public ResourceBase {
           max_buffer_size_(max_buffer_size),
           incarnation_id_(incarnation_id),
           host_iterator_(std::move(host_iterator)),
-          parent_(parent) {}
+          parent_(parent) {
+      if (max_buffer_size_ == model::kAutotune) {
+        // The buffers of all devices share one budget, so that together they
+        // hold at most the default share of the available RAM.
+        auto ram_budget_manager = std::make_shared<model::RamBudgetManager>(
+            model::kRamBudgetShare * port::AvailableRam());
+        for (HostBuffer& buffer : buffer_) {
+          buffer.auto_tuner = std::make_unique<PrefetchAutotuner>(
+              model::kAutotune, /*buffer_size_min=*/1, ram_budget_manager);
+        }
+      }
+      if (GetExperiments().contains(kPinnedBuffers)) {
+        pinned_allocator_ = GetPinnedAllocator(parent_->flr_->device());
+      }
+    }
 
     ~MultiDeviceBuffer() {
       {
@@ -234,15 +255,24 @@ class MultiDeviceIterator : public ResourceBase {
 
         EnsureBackgroundThreadStarted(ctx);
 
-        if (!buffer_[shard_num].data.empty()) {
+        HostBuffer& buffer = buffer_[shard_num];
+        if (!buffer.data.empty()) {
           produced_output = true;
-          std::swap(elem, buffer_[shard_num].data.front());
-          buffer_[shard_num].data.pop_front();
-          // Wake up background thread if it is blocked on this element.
-          if (buffer_[shard_num].data.size() == max_buffer_size_ - 1) {
-            buffer_[shard_num].cond_var.notify_all();
+          if (buffer.auto_tuner) {
+            buffer.auto_tuner->RecordConsumption(buffer.data.size());
+          }
+          std::swap(elem, buffer.data.front());
+          buffer.data.pop_front();
+          // Wake up background thread if it is blocked on this element. An
+          // autotuned buffer may also have grown.
+          if (buffer.auto_tuner ||
+              buffer.data.size() == max_buffer_size_ - 1) {
+            buffer.cond_var.notify_all();
           }
         } else {
+          if (buffer.auto_tuner) {
+            buffer.auto_tuner->RecordEmpty();
+          }
           if (end_of_iterator_) {
             produced_output = true;
             elem.end_of_sequence = true;
@@ -295,6 +325,44 @@ class MultiDeviceIterator : public ResourceBase {
       }
     }
 
+    // Returns the allocator of pinned host memory of `device`, or null if
+    // it has none.
+    static Allocator* GetPinnedAllocator(DeviceBase* device) {
+      AllocatorAttributes host_attr;
+      host_attr.set_on_host(true);
+      AllocatorAttributes pinned_attr = host_attr;
+      pinned_attr.set_gpu_compatible(true);
+      Allocator* pinned_allocator = device->GetAllocator(pinned_attr);
+      if (pinned_allocator == device->GetAllocator(host_attr)) {
+        return nullptr;
+      }
+      return pinned_allocator;
+    }
+
+    // Copies the components of `element` into pinned host memory, so that
+    // their copies to the devices are DMA transfers that do not stage through
+    // pageable memory. Components that cannot be copied are left unchanged.
+    void CopyToPinnedMemory(std::vector<Tensor>* element) {
+      for (Tensor& component : *element) {
+        if (!DataTypeCanUseMemcpy(component.dtype()) ||
+            component.TotalBytes() == 0) {
+          continue;
+        }
+        Tensor pinned(pinned_allocator_, component.dtype(), component.shape());
+        if (!pinned.IsInitialized()) {
+          continue;
+        }
+        std::memcpy(pinned.data(), component.data(), component.TotalBytes());
+        component = std::move(pinned);
+      }
+    }
+
+    // Returns the number of elements to keep in the buffer of `shard_num`.
+    int64_t BufferLimit(int shard_num) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const auto& auto_tuner = buffer_[shard_num].auto_tuner;
+      return auto_tuner ? auto_tuner->buffer_limit() : max_buffer_size_;
+    }
+
     void RunPendingCallbacks() TF_LOCKS_EXCLUDED(mu_) {
       // Run all remaining callbacks.
 
@@ -354,7 +422,8 @@ class MultiDeviceIterator : public ResourceBase {
         {
           mutex_lock l(mu_);
           while (!cancellation_manager_.IsCancelled() &&
-                 buffer_[shard_to_fetch].data.size() >= max_buffer_size_ &&
+                 buffer_[shard_to_fetch].data.size() >=
+                     BufferLimit(shard_to_fetch) &&
                  buffer_[shard_to_fetch].callbacks.empty()) {
             buffer_[shard_to_fetch].cond_var.wait(l);
           }
@@ -371,6 +440,8 @@ class MultiDeviceIterator : public ResourceBase {
 
         if (elem.status.ok() && elem.end_of_sequence) {
           end_of_iterator = true;
+        } else if (elem.status.ok() && pinned_allocator_ != nullptr) {
+          CopyToPinnedMemory(&elem.value);
         }
 
         std::shared_ptr<HostBuffer::CallbackContainer> callback_container;
@@ -392,7 +463,12 @@ class MultiDeviceIterator : public ResourceBase {
               }
             }
           } else {
-            buffer_[shard_to_fetch].data.push_back(std::move(elem));
+            HostBuffer& buffer = buffer_[shard_to_fetch];
+            if (buffer.auto_tuner && !buffer.auto_tuner->HasElementSize() &&
+                !end_of_iterator) {
+              buffer.auto_tuner->SetElementSize(GetAllocatedBytes(elem.value));
+            }
+            buffer.data.push_back(std::move(elem));
             elem = HostBufferElement();
           }
         }
@@ -435,6 +511,8 @@ class MultiDeviceIterator : public ResourceBase {
       };
       // The CallbackContainer is shared with the cancellation callback.
       std::deque<std::shared_ptr<CallbackContainer>> callbacks;
+      // Tunes the size of `data` if the buffer size is autotuned.
+      std::unique_ptr<PrefetchAutotuner> auto_tuner;
     };
 
     mutex mu_;
@@ -451,6 +529,9 @@ class MultiDeviceIterator : public ResourceBase {
     CancellationManager cancellation_manager_;
     const std::unique_ptr<IteratorBase> host_iterator_;
     MultiDeviceIterator* const parent_;  // Not owned.
+    // Allocator of the pinned host memory that elements are copied into, or
+    // null if elements stay where the host iterator produced them.
+    Allocator* pinned_allocator_ = nullptr;  // Not owned.
     std::unique_ptr<Thread> background_thread_ TF_GUARDED_BY(mu_);
   };
 
@@ -364,6 +364,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           num_parallel_calls_(std::make_shared<model::SharedState>(
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
+          cycle_length_cond_var_(std::make_shared<condition_variable>()),
+          active_cycle_length_(std::make_shared<model::SharedState>(
+              TunesCycleLength(*params.dataset, deterministic)
+                  ? model::kAutotune
+                  : params.dataset->cycle_length_,
+              mu_, cycle_length_cond_var_)),
           deterministic_(deterministic),
           current_elements_(params.dataset->cycle_length_) {}
 
@@ -400,6 +406,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         num_parallel_calls_->value = std::min(
             GetAutotuneDefaultParallelism(ctx), dataset()->cycle_length_);
       }
+      if (active_cycle_length_->value == model::kAutotune) {
+        active_cycle_length_->value = dataset()->cycle_length_;
+      }
+      applied_cycle_length_ = active_cycle_length_->value;
       cancellation_manager_ = std::make_unique<CancellationManager>();
       IteratorContext::Params params(ctx);
       params.interleave_depth += 1;
@@ -426,6 +436,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         EnsureInitialElementsCreated(ctx);
         EnsureThreadsStarted(ctx);
+        ApplyCycleLength(ctx);
         while (!cancelled_ && !Consume(ctx, &result)) {
           RecordStop(ctx);
           if (deterministic_) {
@@ -479,8 +490,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           std::move(args),
           {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/min,
                                 /*max=*/dataset()->cycle_length_),
-           model::MakeNonTunableParameter(kCycleLength,
-                                          dataset()->cycle_length_),
+           active_cycle_length_->tunable
+               ? model::MakeParameter(kCycleLength, active_cycle_length_,
+                                      /*min=*/1,
+                                      /*max=*/dataset()->cycle_length_)
+               : model::MakeNonTunableParameter(kCycleLength,
+                                                dataset()->cycle_length_),
            model::MakeNonTunableParameter(kDeterministic,
                                           deterministic_ ? 1.0 : 0.0),
            model::MakeNonTunableParameter(
@@ -625,6 +640,15 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Returns whether autotuning may change the number of input elements that
+    // are open at the same time. This changes the order of the outputs, so it
+    // is only done when outputs need not be deterministic.
+    static bool TunesCycleLength(const Dataset& dataset, bool deterministic) {
+      return !deterministic &&
+             dataset.input_cycle_length_ == model::kAutotune &&
+             GetExperiments().contains("autotune_interleave_cycle_length");
+    }
+
     // Represents the result of fetching an element from a dataset.
     struct Result {
       explicit Result(IteratorContext* ctx)
@@ -710,7 +734,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     void EnsureInitialElementsCreated(IteratorContext* ctx)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (!initial_elements_created_) {
-        for (int i = 0; i < dataset()->cycle_length_; ++i) {
+        for (int i = 0; i < applied_cycle_length_; ++i) {
           current_elements_[i] = MakeElement(ctx);
           if (!current_elements_[i]) {
             break;
@@ -814,8 +838,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         // We've consumed all results from the element. Get a new element from
         // future_elements, or create a new element if no future elements are
-        // available.
-        if (!future_elements_.empty()) {
+        // available. Elements past the end of a cycle that autotuning shrank
+        // are not replaced.
+        if (cycle_index_ >= applied_cycle_length_) {
+          current_elements_[cycle_index_].reset();
+          UpdateLastValidCurrentElement();
+        } else if (!future_elements_.empty()) {
           std::shared_ptr<Element> future_element =
               std::move(future_elements_.front());
           future_elements_.pop_front();
@@ -836,15 +864,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
             element->cycle_index = cycle_index_;
             current_workers_cond_var_.notify_one();
           }
-          while (last_valid_current_element_ >= 0 &&
-                 !current_elements_[last_valid_current_element_]) {
-            last_valid_current_element_--;
-            if (cycle_index_ > last_valid_current_element_) {
-              // We are about to move the cycle index below in
-              // AdvanceToNextInCycle().
-              cycle_index_ = last_valid_current_element_;
-            }
-          }
+          UpdateLastValidCurrentElement();
         }
         if (last_valid_current_element_ != -1) {
           AdvanceToNextInCycle();
@@ -852,6 +872,65 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Moves `last_valid_current_element_` back past null elements.
+    void UpdateLastValidCurrentElement() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (last_valid_current_element_ >= 0 &&
+             !current_elements_[last_valid_current_element_]) {
+        last_valid_current_element_--;
+        if (cycle_index_ > last_valid_current_element_) {
+          // We are about to move the cycle index below in
+          // AdvanceToNextInCycle().
+          cycle_index_ = last_valid_current_element_;
+        }
+      }
+    }
+
+    // Applies the latest cycle length chosen by autotuning. Growing the cycle
+    // fills its new slots with future elements or new elements right away,
+    // while shrinking it leaves the elements past its end to be exhausted
+    // without replacing them.
+    void ApplyCycleLength(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64_t cycle_length =
+          static_cast<int64_t>(active_cycle_length_->value);
+      if (cycle_length == applied_cycle_length_) {
+        return;
+      }
+      const int64_t previous_cycle_length = applied_cycle_length_;
+      applied_cycle_length_ = cycle_length;
+      if (cycle_length < previous_cycle_length ||
+          last_valid_current_element_ == -1) {
+        return;
+      }
+      VLOG(2) << "Growing the interleave cycle from " << previous_cycle_length
+              << " to " << cycle_length << " elements";
+      for (int64_t i = previous_cycle_length; i < cycle_length; ++i) {
+        if (current_elements_[i]) {
+          continue;
+        }
+        if (!future_elements_.empty()) {
+          current_elements_[i] = std::move(future_elements_.front());
+          future_elements_.pop_front();
+          if (current_elements_[i]->iterator) {
+            EnableAutotune(ctx, current_elements_[i]->iterator.get());
+          }
+          future_workers_cond_var_.notify_one();
+        } else {
+          current_elements_[i] = MakeElement(ctx);
+          if (!current_elements_[i]) {
+            break;
+          }
+        }
+        current_elements_[i]->cycle_index = i;
+        if (!current_elements_[i]->active) {
+          elements_to_process_.push_back(i);
+          current_workers_cond_var_.notify_one();
+        }
+        last_valid_current_element_ =
+            std::max<int64_t>(last_valid_current_element_, i);
+      }
+    }
+
     // Creates a new element.
     std::shared_ptr<Element> MakeElement(IteratorContext* ctx)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1661,6 +1740,17 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Identifies the maximum number of parallel calls.
     const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+    // Notified whenever autotuning changes `active_cycle_length_`. The change
+    // takes effect on the next `GetNext` call, so no thread waits on it.
+    std::shared_ptr<condition_variable> cycle_length_cond_var_;
+
+    // Identifies the number of input elements that are open at the same time,
+    // which is at most the `cycle_length` of the dataset.
+    const std::shared_ptr<model::SharedState> active_cycle_length_;
+
+    // The cycle length that the current elements follow.
+    int64_t applied_cycle_length_ TF_GUARDED_BY(mu_) = 0;
+
     // The number of current workers currently alive or scheduled to be started.
     // This includes current workers which are blocked waiting for work.
     int num_current_workers_ TF_GUARDED_BY(mu_) = 0;
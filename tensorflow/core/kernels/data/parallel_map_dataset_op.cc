@@ -312,6 +312,32 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       return ProcessResult(ctx, result, out_tensors, end_of_sequence);
     }
 
+    // Registers the call instead of waiting for a result, and completes it
+    // from the thread that finishes the corresponding invocation.
+    void GetNextAsyncInternal(IteratorContext* ctx,
+                              std::vector<Tensor>* out_tensors,
+                              bool* end_of_sequence,
+                              GetNextDoneCallback done) override {
+      std::shared_ptr<InvocationResult> result;
+      {
+        mutex_lock l(*mu_);
+        EnsureThreadsStarted(ctx);
+        // Calls that arrive while others are pending queue up behind them, so
+        // that results are handed out in the order of the calls.
+        if (!cancelled_ &&
+            (!pending_calls_.empty() || !TakeCompletedResult(&result))) {
+          pending_calls_.push_back(
+              {ctx, out_tensors, end_of_sequence, std::move(done)});
+          return;
+        }
+      }
+      if (!result) {
+        done(errors::Cancelled("Iterator was cancelled"));
+        return;
+      }
+      done(ProcessResult(ctx, result, out_tensors, end_of_sequence));
+    }
+
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
@@ -451,14 +477,29 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       MemoryCheckpoint checkpoint;
     };
 
+    // A `GetNextAsync` call that is waiting for a result.
+    struct PendingCall {
+      IteratorContext* ctx;
+      std::vector<Tensor>* out_tensors;
+      bool* end_of_sequence;
+      GetNextDoneCallback done;
+    };
+
     void CancelThreads(bool wait) TF_LOCKS_EXCLUDED(mu_) {
       cancellation_manager_->StartCancel();
-      mutex_lock l(*mu_);
-      cancelled_ = true;
-      cond_var_->notify_all();
-      // Wait for all in-flight calls to complete.
-      while (wait && num_calls_ > 0) {
-        cond_var_->wait(l);
+      std::vector<std::function<void()>> callbacks;
+      {
+        mutex_lock l(*mu_);
+        cancelled_ = true;
+        cond_var_->notify_all();
+        callbacks = ServePendingCalls();
+        // Wait for all in-flight calls to complete.
+        while (wait && num_calls_ > 0) {
+          cond_var_->wait(l);
+        }
+      }
+      for (const auto& callback : callbacks) {
+        callback();
       }
     }
 
@@ -480,10 +521,17 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     void CallCompleted(const std::shared_ptr<IteratorContext>& ctx,
                        const std::shared_ptr<InvocationResult>& result)
         TF_LOCKS_EXCLUDED(*mu_) {
-      mutex_lock l(*mu_);
-      num_calls_--;
-      result->notification.Notify();
-      cond_var_->notify_all();
+      std::vector<std::function<void()>> callbacks;
+      {
+        mutex_lock l(*mu_);
+        num_calls_--;
+        result->notification.Notify();
+        cond_var_->notify_all();
+        callbacks = ServePendingCalls();
+      }
+      for (const auto& callback : callbacks) {
+        callback();
+      }
     }
 
     void CallFunction(const std::shared_ptr<IteratorContext>& ctx,
@@ -647,6 +695,50 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       return true;
     }
 
+    // Takes the next result that is ready to be returned without waiting, if
+    // any. Follows the same order as `ShouldWait`.
+    bool TakeCompletedResult(std::shared_ptr<InvocationResult>* result)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      for (auto it = invocation_results_.begin();
+           it != invocation_results_.end(); ++it) {
+        if (!(*it)->notification.HasBeenNotified()) {
+          if (deterministic_) return false;
+          continue;
+        }
+        if (deterministic_ || it == invocation_results_.begin() ||
+            !(*it)->end_of_input) {
+          std::swap(*result, *it);
+          invocation_results_.erase(it);
+          cond_var_->notify_all();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Completes the pending calls for which a result is ready, in the order
+    // they were made, or all of them if the iterator has been cancelled.
+    // Returns the callbacks to invoke once `mu_` has been released.
+    std::vector<std::function<void()>> ServePendingCalls()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      std::vector<std::function<void()>> callbacks;
+      while (!pending_calls_.empty()) {
+        std::shared_ptr<InvocationResult> result;
+        if (!cancelled_ && !TakeCompletedResult(&result)) break;
+        callbacks.push_back(
+            [this, call = std::move(pending_calls_.front()), result]() {
+              if (!result) {
+                call.done(errors::Cancelled("Iterator was cancelled"));
+                return;
+              }
+              call.done(ProcessResult(call.ctx, result, call.out_tensors,
+                                      call.end_of_sequence));
+            });
+        pending_calls_.pop_front();
+      }
+      return callbacks;
+    }
+
     void StatsThread(const std::shared_ptr<IteratorContext>& ctx)
         TF_LOCKS_EXCLUDED(*mu_) {
       for (int64_t step = 0;; ++step) {
@@ -732,6 +824,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     // destroyed first.
     std::unique_ptr<IteratorBase> input_impl_;
     // Buffer for storing the invocation results.
+    std::deque<PendingCall> pending_calls_ TF_GUARDED_BY(*mu_);
     std::deque<std::shared_ptr<InvocationResult>> invocation_results_
         TF_GUARDED_BY(*mu_);
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
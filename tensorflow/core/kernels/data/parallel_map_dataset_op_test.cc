@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
 namespace data {
@@ -411,6 +412,29 @@ TEST_F(ParallelMapDatasetOpTest, InvalidNumParallelCalls) {
             absl::StatusCode::kInvalidArgument);
 }
 
+TEST_F(ParallelMapDatasetOpTest, GetNextAsync) {
+  auto dataset_params = ParallelMapDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> out_tensors;
+    Status status;
+    Notification done;
+    iterator_->GetNextAsync(iterator_ctx_.get(), &out_tensors,
+                            &end_of_sequence, [&](Status s) {
+                              status = s;
+                              done.Notify();
+                            });
+    done.WaitForNotification();
+    TF_ASSERT_OK(status);
+    outputs.insert(outputs.end(), out_tensors.begin(), out_tensors.end());
+  }
+  TF_EXPECT_OK(ExpectEqual(
+      outputs, CreateTensors<int64_t>(TensorShape{}, {{0}, {12}, {24}, {36}}),
+      /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -16,8 +16,11 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "tensorflow/core/data/dataset_utils.h"
@@ -249,6 +252,38 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       return input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
     }
 
+    // Registers the call instead of waiting for the buffer to fill, and
+    // completes it from the prefetch thread.
+    void GetNextAsyncInternal(IteratorContext* ctx,
+                              std::vector<Tensor>* out_tensors,
+                              bool* end_of_sequence,
+                              GetNextDoneCallback done) override {
+      Status s;
+      {
+        mutex_lock l(*mu_);
+        s = EnsureThreadsStarted(ctx);
+        // Calls that arrive while others are pending queue up behind them, so
+        // that elements are handed out in the order of the calls.
+        if (s.ok() && buffer_limit() != 0 && !prefetch_thread_finished_ &&
+            (buffer_.empty() || !pending_calls_.empty())) {
+          if (legacy_autotune_ && buffer_.empty()) {
+            auto_tuner_->RecordEmpty();
+            buffer_size_->value = auto_tuner_->buffer_limit();
+          }
+          pending_calls_.push_back(
+              {ctx, out_tensors, end_of_sequence, std::move(done)});
+          return;
+        }
+      }
+      if (!s.ok()) {
+        done(s);
+        return;
+      }
+      // The buffer has an element, the input is exhausted, or prefetching is
+      // disabled. In the latter case the input is read on this thread.
+      done(GetNextInternal(ctx, out_tensors, end_of_sequence));
+    }
+
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
@@ -375,6 +410,36 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       MemoryCheckpoint checkpoint;
     };
 
+    // A `GetNextAsync` call that is waiting for the buffer to fill.
+    struct PendingCall {
+      IteratorContext* ctx;
+      std::vector<Tensor>* out_tensors;
+      bool* end_of_sequence;
+      GetNextDoneCallback done;
+    };
+
+    // Completes the pending calls that can be served from the buffer, in the
+    // order they were made. Returns the callbacks to invoke once `mu_` has
+    // been released.
+    std::vector<std::function<void()>> ServePendingCalls()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      std::vector<std::function<void()>> callbacks;
+      while (!pending_calls_.empty() &&
+             (!buffer_.empty() || prefetch_thread_finished_)) {
+        PendingCall call = std::move(pending_calls_.front());
+        pending_calls_.pop_front();
+        Status s;
+        if (!buffer_.empty()) {
+          s = Consume(call.ctx, call.out_tensors, call.end_of_sequence);
+        } else {
+          *call.end_of_sequence = true;
+        }
+        callbacks.push_back(
+            [done = std::move(call.done), s]() { done(s); });
+      }
+      return callbacks;
+    }
+
     Status RestoreBuffer(IteratorContext* const ctx,
                          IteratorStateReader* const reader)
         TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
@@ -519,6 +584,11 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // Keep track of where we are in an iteration "burst"
       int num_produced = 0;
       while (true) {
+        // Completes `GetNextAsync` calls once all locks have been released.
+        std::vector<std::function<void()>> callbacks;
+        auto run_callbacks = gtl::MakeCleanup([&callbacks] {
+          for (const auto& callback : callbacks) callback();
+        });
         // 1. Wait for a slot in the buffer.
         {
           mutex_lock l(*mu_);
@@ -531,6 +601,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           if (cancelled_) {
             prefetch_thread_finished_ = true;
             cond_var_->notify_all();
+            callbacks = ServePendingCalls();
             return;
           }
         }
@@ -566,6 +637,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           mutex_lock l(*mu_);
           prefetch_thread_finished_ = true;
           cond_var_->notify_all();
+          callbacks = ServePendingCalls();
           return;
         }
 
@@ -576,6 +648,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           buffer_element.created_us = EnvTime::NowMicros();
           buffer_.push_back(std::move(buffer_element));
           cond_var_->notify_all();
+          callbacks = ServePendingCalls();
         }
         ++num_produced;
       }
@@ -636,6 +709,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     const int64_t buffer_size_min_;
     std::unique_ptr<PrefetchAutotuner> auto_tuner_ TF_GUARDED_BY(*mu_);
     std::deque<BufferElement> buffer_ TF_GUARDED_BY(*mu_);
+    std::deque<PendingCall> pending_calls_ TF_GUARDED_BY(*mu_);
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
     bool prefetch_thread_finished_ TF_GUARDED_BY(*mu_) = false;
     const bool legacy_autotune_;
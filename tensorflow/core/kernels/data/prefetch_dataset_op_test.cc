@@ -13,6 +13,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
 #include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
 namespace data {
@@ -331,6 +332,31 @@ TEST_F(PrefetchDatasetOpTest, InvalidBufferSize) {
   EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
 }
 
+TEST_F(PrefetchDatasetOpTest, GetNextAsync) {
+  auto dataset_params = PrefetchDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> outputs;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> out_tensors;
+    Status status;
+    Notification done;
+    iterator_->GetNextAsync(iterator_ctx_.get(), &out_tensors,
+                            &end_of_sequence, [&](Status s) {
+                              status = s;
+                              done.Notify();
+                            });
+    done.WaitForNotification();
+    TF_ASSERT_OK(status);
+    outputs.insert(outputs.end(), out_tensors.begin(), out_tensors.end());
+  }
+  TF_EXPECT_OK(ExpectEqual(
+      outputs,
+      CreateTensors<int64_t>(
+          TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/columnar_element_buffer.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
@@ -205,9 +206,22 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
+      // Symbolic checkpoints are updated incrementally from the elements that
+      // changed, which would require materializing columnar elements at every
+      // checkpoint.
+      if (!ctx->symbolic_checkpoint() &&
+          GetExperiments().contains("columnar_element_buffers") &&
+          ColumnarElementBuffer::CanStore(dataset()->output_dtypes(),
+                                          dataset()->output_shapes())) {
+        columnar_buffer_ = std::make_unique<ColumnarElementBuffer>(
+            dataset()->output_dtypes(), dataset()->output_shapes());
+        columnar_buffer_->Resize(buffer_->size());
+        buffer_->clear();
+        buffer_->shrink_to_fit();
+      }
       // Initialize checkpoint_indices_ to the entire buffer.
       if (ctx->symbolic_checkpoint()) {
-        for (int64_t i = 0; i < buffer_->size(); ++i) {
+        for (int64_t i = 0; i < BufferSize(); ++i) {
           checkpoint_indices_.insert(i);
         }
       }
@@ -232,13 +246,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       // slice, and then remove the element from the slice.
       int64_t offset =
           Random() % (slices_.front()->end - slices_.front()->start);
-      int64_t index = (slices_.front()->start + offset) % buffer_->size();
-      *out_tensors = std::move(buffer_->at(index));
+      int64_t index = (slices_.front()->start + offset) % BufferSize();
+      TakeFromBuffer(index, out_tensors);
       this->RecordBufferDequeue(ctx, *out_tensors);
-      std::swap(buffer_->at(index),
-                buffer_->at(slices_.front()->start % buffer_->size()));
+      SwapInBuffer(index, slices_.front()->start % BufferSize());
       checkpoint_indices_.insert(index);
-      checkpoint_indices_.insert(slices_.front()->start % buffer_->size());
+      checkpoint_indices_.insert(slices_.front()->start % BufferSize());
       slices_.front()->start++;
       num_elements_--;
       return absl::OkStatus();
@@ -284,7 +297,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(prefix(), kNumElements, num_elements_));
       const std::string key_prefix = absl::StrCat(prefix(), kColon, "buffer");
-      if (ctx->symbolic_checkpoint()) {
+      if (columnar_buffer_) {
+        TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+            writer, key_prefix, columnar_buffer_->ToElements()));
+      } else if (ctx->symbolic_checkpoint()) {
         // When symbolic checkpointing is turned on, `writer`
         // already contains checkpoint of the shuffle buffer created by the
         // previous invocation of this instance and the indices that need to be
@@ -370,7 +386,21 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       for (const auto& element : *buffer_) {
         RecordBufferEnqueue(ctx, element);
       }
-      if (!IsShuffleAll()) {
+      if (columnar_buffer_) {
+        columnar_buffer_->Clear();
+        for (const auto& element : *buffer_) {
+          if (element.empty()) {
+            // An unused slot of a checkpoint written without the experiment.
+            columnar_buffer_->Resize(columnar_buffer_->size() + 1);
+          } else {
+            TF_RETURN_IF_ERROR(columnar_buffer_->Append(element));
+          }
+        }
+        buffer_->clear();
+        if (!IsShuffleAll()) {
+          columnar_buffer_->Resize(dataset()->buffer_size_);
+        }
+      } else if (!IsShuffleAll()) {
         buffer_->resize(dataset()->buffer_size_);
       }
       slices_.clear();
@@ -463,7 +493,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           slices_.back()->reached_end_of_sequence = true;
         }
         if (!end_of_input_sequence) {
-          AddToShuffleBuffer(ctx, std::move(input_element));
+          TF_RETURN_IF_ERROR(
+              AddToShuffleBuffer(ctx, std::move(input_element)));
           continue;
         }
         input_impl_.reset();
@@ -500,7 +531,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // we need to add to the buffer.
         return true;
       }
-      return num_elements_ < buffer_->size();
+      return num_elements_ < BufferSize();
     }
 
     Status PrepareNextEpoch(IteratorContext* ctx)
@@ -520,7 +551,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return absl::OkStatus();
     }
 
-    void AddToShuffleBuffer(IteratorContext* ctx, std::vector<Tensor>&& element)
+    Status AddToShuffleBuffer(IteratorContext* ctx,
+                              std::vector<Tensor>&& element)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       data_produced_ = true;
       if (num_elements_ == 0) {
@@ -528,17 +560,50 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                 << BufferSizeString();
       }
       this->RecordBufferEnqueue(ctx, element);
-      if (num_elements_ == buffer_->size()) {
+      if (num_elements_ == BufferSize()) {
         DCHECK(IsShuffleAll());
-        checkpoint_indices_.insert(buffer_->size());
-        buffer_->push_back(element);
+        checkpoint_indices_.insert(BufferSize());
+        if (columnar_buffer_) {
+          TF_RETURN_IF_ERROR(columnar_buffer_->Append(element));
+        } else {
+          buffer_->push_back(element);
+        }
       } else {
-        size_t index = slices_.back()->end % buffer_->size();
+        size_t index = slices_.back()->end % BufferSize();
         checkpoint_indices_.insert(index);
-        buffer_->at(index) = std::move(element);
+        if (columnar_buffer_) {
+          TF_RETURN_IF_ERROR(columnar_buffer_->Set(index, element));
+        } else {
+          buffer_->at(index) = std::move(element);
+        }
       }
       num_elements_++;
       slices_.back()->end++;
+      return absl::OkStatus();
+    }
+
+    size_t BufferSize() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return columnar_buffer_ ? columnar_buffer_->size() : buffer_->size();
+    }
+
+    // Moves the element at `index` out of the buffer, or materializes it if the
+    // buffer is columnar.
+    void TakeFromBuffer(int64_t index, std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (columnar_buffer_) {
+        out_tensors->clear();
+        columnar_buffer_->Get(index, out_tensors);
+      } else {
+        *out_tensors = std::move(buffer_->at(index));
+      }
+    }
+
+    void SwapInBuffer(int64_t i, int64_t j) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (columnar_buffer_) {
+        columnar_buffer_->Swap(i, j);
+      } else {
+        std::swap(buffer_->at(i), buffer_->at(j));
+      }
     }
 
     void ClearEmptySlices() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -560,6 +625,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
+    // Replaces `buffer_` when the "columnar_element_buffers" experiment is
+    // enabled and the elements have small, fixed-size components.
+    std::unique_ptr<ColumnarElementBuffer> columnar_buffer_ TF_GUARDED_BY(mu_);
     // Holds the indices of `buffer_` that have changed since the previous
     // `SaveInternal()` and need to be updated in the MemoryCheckpoint
     // (if symbolic checkpointing is used) in the next `SaveInternal()`.
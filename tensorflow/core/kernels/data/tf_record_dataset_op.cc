@@ -14,6 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -45,6 +53,14 @@ constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64_t kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64_t kS3BlockSize = kCloudTpuBlockSize;
+constexpr char kParallelTFRecordReads[] = "parallel_tfrecord_reads";
+// The number of files that are read ahead of the consumer when the
+// "parallel_tfrecord_reads" experiment is enabled.
+constexpr int kNumReadaheadFiles = 8;
+// The bytes of records that are buffered for each file that is read ahead.
+constexpr int64_t kReadaheadBufferBytes = 4LL << 20;  // 4MB.
+// The minimum size of the blocks read from each file that is read ahead.
+constexpr int64_t kReadaheadBlockSize = 1LL << 20;  // 1MB.
 
 bool is_cloud_tpu_gcs_fs() {
 #if (defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)) || \
@@ -54,6 +70,97 @@ bool is_cloud_tpu_gcs_fs() {
   return false;
 }
 
+namespace {
+
+// Reads the records of one file on a background thread into a bounded buffer,
+// from which `GetNext()` returns them in order. Records are checksummed on the
+// background thread as they are read.
+class FileReadahead {
+ public:
+  FileReadahead(std::string filename, uint64 offset,
+                const io::RecordReaderOptions& options)
+      : filename_(std::move(filename)), offset_(offset), options_(options) {}
+
+  ~FileReadahead() {
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+    }
+    cond_var_.notify_all();
+    thread_.reset();
+  }
+
+  void Start(IteratorContext* ctx) {
+    Env* env = ctx->env();
+    thread_ = ctx->StartThread("tf_data_tf_record_readahead",
+                               [this, env]() { Read(env); });
+  }
+
+  // Blocks until the next record of the file is available, and returns it
+  // together with the file offset right after it. Returns `OutOfRange` at the
+  // end of the file, or the error that ended reading it.
+  Status GetNext(tstring* record, uint64* end_offset) {
+    mutex_lock l(mu_);
+    while (records_.empty() && !done_) {
+      cond_var_.wait(l);
+    }
+    if (records_.empty()) {
+      return status_;
+    }
+    buffered_bytes_ -= records_.front().first.size();
+    *record = std::move(records_.front().first);
+    *end_offset = records_.front().second;
+    records_.pop_front();
+    cond_var_.notify_all();
+    return absl::OkStatus();
+  }
+
+ private:
+  void Read(Env* env) {
+    std::unique_ptr<RandomAccessFile> file;
+    std::unique_ptr<io::SequentialRecordReader> reader;
+    Status s = env->NewRandomAccessFile(filename_, &file);
+    if (s.ok()) {
+      reader =
+          std::make_unique<io::SequentialRecordReader>(file.get(), options_);
+      s = reader->SeekOffset(offset_);
+    }
+    while (s.ok()) {
+      tstring record;
+      s = reader->ReadRecord(&record);
+      if (!s.ok()) break;
+      mutex_lock l(mu_);
+      while (!cancelled_ && buffered_bytes_ >= kReadaheadBufferBytes) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) return;
+      buffered_bytes_ += record.size();
+      records_.emplace_back(std::move(record), reader->TellOffset());
+      cond_var_.notify_all();
+    }
+    mutex_lock l(mu_);
+    status_ = s;
+    done_ = true;
+    cond_var_.notify_all();
+  }
+
+  const std::string filename_;
+  const uint64 offset_;
+  const io::RecordReaderOptions options_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  // Records that have been read but not consumed, with their end offsets.
+  std::deque<std::pair<tstring, uint64>> records_ TF_GUARDED_BY(mu_);
+  int64_t buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  bool done_ TF_GUARDED_BY(mu_) = false;
+  Status status_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+};
+
+}  // namespace
+
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
@@ -65,10 +172,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
             compression_type)),
         byte_offsets_(std::move(byte_offsets)),
-        op_version_(op_version) {
+        op_version_(op_version),
+        readahead_(GetExperiments().contains(kParallelTFRecordReads)) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
+    readahead_options_ = options_;
+    readahead_options_.buffer_size =
+        std::max(options_.buffer_size, kReadaheadBlockSize);
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -132,6 +243,9 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
                            bool* end_of_sequence) override {
       out_tensors->reserve(1);
       mutex_lock l(mu_);
+      if (dataset()->readahead_) {
+        return GetNextFromReadaheadLocked(ctx, out_tensors, end_of_sequence);
+      }
       do {
         // We are currently processing a file, so try to read the next record.
         if (reader_) {
@@ -177,6 +291,10 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
                         bool* end_of_sequence, int* num_skipped) override {
       *num_skipped = 0;
       mutex_lock l(mu_);
+      if (dataset()->readahead_) {
+        return SkipFromReadaheadLocked(ctx, num_to_skip, end_of_sequence,
+                                       num_skipped);
+      }
       do {
         // We are currently processing a file, so try to skip reading
         // the next (num_to_skip - *num_skipped) record.
@@ -226,6 +344,10 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCurrentFileIndex,
                                              current_file_index_));
 
+      if (!readahead_.empty()) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            prefix(), kOffset, static_cast<int64_t>(readahead_offset_)));
+      }
       if (reader_) {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(prefix(), kOffset, reader_->TellOffset()));
@@ -244,6 +366,15 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       if (reader->Contains(prefix(), kOffset)) {
         int64_t offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(prefix(), kOffset, &offset));
+        if (dataset()->readahead_) {
+          if (current_file_index_ >= dataset()->filenames_.size()) {
+            return errors::InvalidArgument(
+                "current_file_index_:", current_file_index_,
+                " >= filenames_.size():", dataset()->filenames_.size());
+          }
+          StartReadaheadLocked(ctx, offset);
+          return absl::OkStatus();
+        }
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
         TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
       }
@@ -251,6 +382,99 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Like `GetNextInternal()`, but consumes the records of files that are
+    // read ahead on background threads.
+    Status GetNextFromReadaheadLocked(IteratorContext* ctx,
+                                      std::vector<Tensor>* out_tensors,
+                                      bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (current_file_index_ < dataset()->filenames_.size()) {
+        StartReadaheadLocked(ctx, StartOffset(current_file_index_));
+        tstring record;
+        Status s = readahead_.front()->GetNext(&record, &readahead_offset_);
+        if (s.ok()) {
+          static monitoring::CounterCell* bytes_counter =
+              metrics::GetTFDataBytesReadCounter(kDatasetType);
+          bytes_counter->IncrementBy(record.size());
+          out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
+                                    TensorShape({}));
+          out_tensors->back().scalar<tstring>()() = std::move(record);
+          *end_of_sequence = false;
+          return absl::OkStatus();
+        }
+        // As in `GetNextInternal()`, errors other than the end of the file
+        // still move on to the next file, so that they work with
+        // `ignore_errors`.
+        NextReadaheadFileLocked();
+        if (!errors::IsOutOfRange(s)) {
+          return s;
+        }
+      }
+      *end_of_sequence = true;
+      return absl::OkStatus();
+    }
+
+    Status SkipFromReadaheadLocked(IteratorContext* ctx, int num_to_skip,
+                                   bool* end_of_sequence, int* num_skipped)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (current_file_index_ < dataset()->filenames_.size()) {
+        StartReadaheadLocked(ctx, StartOffset(current_file_index_));
+        Status s;
+        tstring record;
+        while (*num_skipped < num_to_skip &&
+               (s = readahead_.front()->GetNext(&record, &readahead_offset_))
+                   .ok()) {
+          ++*num_skipped;
+        }
+        if (s.ok()) {
+          *end_of_sequence = false;
+          return absl::OkStatus();
+        }
+        NextReadaheadFileLocked();
+        if (!errors::IsOutOfRange(s)) {
+          return s;
+        }
+      }
+      *end_of_sequence = true;
+      return absl::OkStatus();
+    }
+
+    // Moves on from the file at `current_file_index_` to the next one.
+    void NextReadaheadFileLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      readahead_.pop_front();
+      ++current_file_index_;
+      if (current_file_index_ < dataset()->filenames_.size()) {
+        readahead_offset_ = StartOffset(current_file_index_);
+      }
+    }
+
+    // Returns the offset at which reading the file at `file_index` starts.
+    uint64 StartOffset(size_t file_index) const {
+      return dataset()->byte_offsets_.empty()
+                 ? 0
+                 : dataset()->byte_offsets_[file_index];
+    }
+
+    // Starts reading ahead the files after `current_file_index_`, up to
+    // `kNumReadaheadFiles` files, reading the current file from `offset` if
+    // it is not being read yet.
+    void StartReadaheadLocked(IteratorContext* ctx, uint64 offset)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (readahead_.empty()) {
+        readahead_offset_ = offset;
+      }
+      while (readahead_.size() < static_cast<size_t>(kNumReadaheadFiles) &&
+             current_file_index_ + readahead_.size() <
+                 dataset()->filenames_.size()) {
+        const size_t file_index = current_file_index_ + readahead_.size();
+        readahead_.push_back(std::make_unique<FileReadahead>(
+            TranslateFileName(dataset()->filenames_[file_index]),
+            readahead_.empty() ? offset : StartOffset(file_index),
+            dataset()->readahead_options_));
+        readahead_.back()->Start(ctx);
+      }
+    }
+
     // Sets up reader streams to read from the file at `current_file_index_`.
     Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (current_file_index_ >= dataset()->filenames_.size()) {
@@ -276,6 +500,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
       file_.reset();
+      readahead_.clear();
     }
 
     mutex mu_;
@@ -285,6 +510,12 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // The files being read ahead, starting with the file at
+    // `current_file_index_`, and the offset in that file right after the last
+    // record that was consumed. Only used if the dataset reads ahead.
+    std::deque<std::unique_ptr<FileReadahead>> readahead_ TF_GUARDED_BY(mu_);
+    uint64 readahead_offset_ TF_GUARDED_BY(mu_) = 0;
   };
 
   const std::vector<string> filenames_;
@@ -292,6 +523,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
   io::RecordReaderOptions options_;
   const std::vector<int64_t> byte_offsets_;
   const int op_version_;
+  // If true, the iterator reads up to `kNumReadaheadFiles` files ahead on
+  // background threads, in blocks of at least `kReadaheadBlockSize` bytes.
+  // Enabled by the "parallel_tfrecord_reads" tf.data experiment.
+  const bool readahead_;
+  io::RecordReaderOptions readahead_options_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
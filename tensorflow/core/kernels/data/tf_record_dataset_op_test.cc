@@ -354,6 +354,70 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(TFRecordDatasetOpTest, TFRecordDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+class TFRecordDatasetOpReadaheadTest : public TFRecordDatasetOpTest {
+ protected:
+  void SetUp() override {
+    setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+    setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+    setenv("TF_DATA_EXPERIMENT_OPT_IN", "parallel_tfrecord_reads",
+           /*overwrite=*/1);
+  }
+
+  void TearDown() override {
+    unsetenv("TF_JOB_NAME");
+    unsetenv("TF_TASK_ID");
+    unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+  }
+};
+
+TEST_F(TFRecordDatasetOpReadaheadTest, GetNext) {
+  auto dataset_params = TFRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}),
+                             {{"1"}, {"22"}, {"333"}, {"a"}, {"bb"}, {"ccc"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(TFRecordDatasetOpReadaheadTest, GetNextFromByteOffsets) {
+  auto dataset_params = TFRecordDatasetParams4();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(
+          TensorShape({}), {{"1"}, {"22"}, {"333"}, {"bb"}, {"ccc"}, {"zzz"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(TFRecordDatasetOpReadaheadTest, Skip) {
+  auto dataset_params = TFRecordDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSkip(
+      /*num_to_skip=*/4, /*expected_num_skipped=*/4, /*get_next=*/true,
+      CreateTensors<tstring>(TensorShape({}), {{"bb"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(TFRecordDatasetOpReadaheadTest, SaveAndRestore) {
+  auto dataset_params = TFRecordDatasetParams2();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_params.iterator_prefix(),
+      CreateTensors<tstring>(TensorShape({}),
+                             {{"1"}, {"22"}, {"333"}, {"a"}, {"bb"}, {"ccc"}}),
+      /*breakpoints=*/{0, 1, 3, 5, 7}, /*compare_order=*/true));
+}
+
+TEST_F(TFRecordDatasetOpReadaheadTest, InvalidByteOffsetsToSeek) {
+  auto dataset_params = InvalidByteOffsets();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kDataLoss);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -15,7 +15,10 @@ limitations under the License.
 
 // See docs in ../ops/parsing_ops.cc.
 
+#include <algorithm>
+#include <memory>
 #include <numeric>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -30,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 #include "tensorflow/core/util/example_proto_helper.h"
@@ -89,6 +93,7 @@ class ParseExampleOp : public OpKernel {
 
     example::FastParseExampleConfig config =
         MakeConfig(dense_keys_t, sparse_keys_t, ragged_keys_t, dense_defaults);
+    OP_REQUIRES_OK(ctx, SetFeatureIndex(&config));
 
     example::Result result;
     if (TensorShapeUtils::IsVector(serialized->shape())) {
@@ -234,6 +239,30 @@ class ParseExampleOp : public OpKernel {
     return config;
   }
 
+  // Sets the feature index of `config`. The index of the previous call is
+  // reused if it had the same keys, as they are usually constants.
+  Status SetFeatureIndex(example::FastParseExampleConfig* config) {
+    std::vector<StringPiece> keys;
+    for (const auto& dense : config->dense) keys.push_back(dense.feature_name);
+    for (const auto& sparse : config->sparse) {
+      keys.push_back(sparse.feature_name);
+    }
+    for (const auto& ragged : config->ragged) {
+      keys.push_back(ragged.feature_name);
+    }
+    mutex_lock l(mu_);
+    if (feature_index_ != nullptr &&
+        std::equal(keys.begin(), keys.end(), feature_index_keys_.begin(),
+                   feature_index_keys_.end())) {
+      config->feature_index = feature_index_;
+      return absl::OkStatus();
+    }
+    TF_RETURN_IF_ERROR(example::PrecomputeFeatureIndex(config));
+    feature_index_ = config->feature_index;
+    feature_index_keys_.assign(keys.begin(), keys.end());
+    return absl::OkStatus();
+  }
+
   // Parses a single example.
   Status ParseExampleScalar(const example::FastParseExampleConfig& config,
                             const Tensor* serialized, OpKernelContext* ctx,
@@ -290,6 +319,12 @@ class ParseExampleOp : public OpKernel {
   ParseExampleAttrs attrs_;
   int op_version_;
   absl::once_flag flag_;
+
+  mutex mu_;
+  // The keys of the cached feature index, dense then sparse then ragged.
+  std::vector<std::string> feature_index_keys_ TF_GUARDED_BY(mu_);
+  std::shared_ptr<const example::FeatureIndex> feature_index_
+      TF_GUARDED_BY(mu_);
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParseExample").Device(DEVICE_CPU),
@@ -303,6 +338,19 @@ class ParseSingleExampleOp : public OpKernel {
     OP_REQUIRES_OK(ctx, attrs_.Init(ctx));
     metrics::RecordParseDenseFeature(attrs_.dense_keys.size());
     metrics::RecordParseSparseFeature(attrs_.sparse_keys.size());
+
+    // The keys are attributes, so the feature index is built once. It only
+    // depends on the feature names.
+    example::FastParseExampleConfig config;
+    config.dense.resize(attrs_.dense_keys.size());
+    for (int d = 0; d < attrs_.dense_keys.size(); ++d) {
+      config.dense[d].feature_name = attrs_.dense_keys[d];
+    }
+    for (int d = 0; d < attrs_.sparse_keys.size(); ++d) {
+      config.sparse.push_back({attrs_.sparse_keys[d], attrs_.sparse_types[d]});
+    }
+    OP_REQUIRES_OK(ctx, example::PrecomputeFeatureIndex(&config));
+    feature_index_ = config.feature_index;
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -353,8 +401,8 @@ class ParseSingleExampleOp : public OpKernel {
 
     example::Result result;
 
-    // TODO(mrry): Build the configuration once and cache it.
     example::FastParseExampleConfig config;
+    config.feature_index = feature_index_;
     for (int d = 0; d < attrs_.dense_keys.size(); ++d) {
       config.dense.push_back({attrs_.dense_keys[d], attrs_.dense_types[d],
                               attrs_.dense_shapes[d], dense_defaults[d],
@@ -390,6 +438,7 @@ class ParseSingleExampleOp : public OpKernel {
 
  protected:
   ParseSingleExampleAttrs attrs_;
+  std::shared_ptr<const example::FeatureIndex> feature_index_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParseSingleExample").Device(DEVICE_CPU),
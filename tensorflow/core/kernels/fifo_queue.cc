@@ -48,8 +48,50 @@ void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
   }
 }
 
+bool FIFOQueue::TryEnqueueWithoutBlocking(const Tuple& tuple,
+                                          OpKernelContext* ctx,
+                                          DoneCallback callback) {
+  bool flush;
+  {
+    mutex_lock l(mu_);
+    // An enqueue may only skip the line of pending enqueues (and closes) if
+    // there are none.
+    if (closed_ || !enqueue_attempts_.empty() ||
+        queues_[0].size() >= static_cast<size_t>(capacity_) ||
+        ctx->cancellation_manager()->IsCancelled()) {
+      return false;
+    }
+    for (int i = 0; i < num_components(); ++i) {
+      queues_[i].push_back(tuple[i]);
+    }
+    flush = !dequeue_attempts_.empty();
+  }
+  if (flush) FlushUnlocked();
+  callback();
+  return true;
+}
+
+bool FIFOQueue::TryDequeueWithoutBlocking(OpKernelContext* ctx,
+                                          CallbackWithTuple callback) {
+  Tuple tuple;
+  bool flush;
+  {
+    mutex_lock l(mu_);
+    if (!dequeue_attempts_.empty() || queues_[0].empty() ||
+        ctx->cancellation_manager()->IsCancelled()) {
+      return false;
+    }
+    DequeueLocked(ctx, &tuple);
+    flush = !enqueue_attempts_.empty();
+  }
+  if (flush) FlushUnlocked();
+  callback(tuple);
+  return true;
+}
+
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
+  if (TryEnqueueWithoutBlocking(tuple, ctx, callback)) return;
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -153,6 +195,7 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 }
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
+  if (TryDequeueWithoutBlocking(ctx, callback)) return;
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
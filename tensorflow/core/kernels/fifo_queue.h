@@ -61,6 +61,17 @@ class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Enqueue and dequeue of a single element that complete right away, and
+  // run `callback`, if no other attempts wait ahead of them and the queue
+  // isn't full or empty. Otherwise they return false and the caller
+  // registers a blocking attempt. This saves the registration with the
+  // cancellation manager and the Attempt in the common case.
+  bool TryEnqueueWithoutBlocking(const Tuple& tuple, OpKernelContext* ctx,
+                                 DoneCallback callback) TF_LOCKS_EXCLUDED(mu_);
+  bool TryDequeueWithoutBlocking(OpKernelContext* ctx,
+                                 CallbackWithTuple callback)
+      TF_LOCKS_EXCLUDED(mu_);
+
   static Status GetElementComponentFromBatch(const Tuple& tuple, int64_t index,
                                              int component,
                                              OpKernelContext* ctx,
@@ -0,0 +1,166 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Gathers rows of a resource variable and reduces them by segment in one pass.
+// See the documentation of _FusedResourceSparseSegmentReduce.
+
+#define EIGEN_USE_THREADS
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T, typename Index, typename Tidx, typename SegmentId>
+class FusedResourceSparseSegmentReduceOp : public OpKernel {
+ public:
+  explicit FusedResourceSparseSegmentReduceOp(OpKernelConstruction* c)
+      : OpKernel(c) {
+    std::string combiner;
+    OP_REQUIRES_OK(c, c->GetAttr("combiner", &combiner));
+    is_mean_ = combiner == "mean";
+  }
+
+  void Compute(OpKernelContext* c) override {
+    core::RefCountPtr<Var> v;
+    OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
+    OP_REQUIRES_OK(c, EnsureSparseVariableAccess<CPUDevice, T>(c, v.get()));
+    // As in ResourceGather, the lock is held for the whole op rather than
+    // taking a reference to the buffer, which would make writers copy it, and
+    // frozen variables need no lock.
+    std::optional<tf_shared_lock> ml;
+    if (!v->frozen.load()) ml.emplace(*v->mu());
+    const Tensor& params = *v->tensor();
+    const Tensor& ids = c->input(1);
+    const Tensor& indices = c->input(2);
+    const Tensor& segment_ids = c->input(3);
+    OP_REQUIRES(
+        c, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+        errors::InvalidArgument("params must be at least 1 dimensional"));
+    OP_REQUIRES(c, TensorShapeUtils::IsVector(ids.shape()),
+                errors::InvalidArgument("ids should be a vector."));
+    OP_REQUIRES(c, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector."));
+    OP_REQUIRES(c, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64_t num_indices = indices.NumElements();
+    OP_REQUIRES(c, num_indices == segment_ids.NumElements(),
+                errors::InvalidArgument(
+                    "segment_ids and indices should have same size."));
+
+    const auto ids_flat = ids.flat<Index>();
+    const auto indices_flat = indices.flat<Tidx>();
+    const auto segment_flat = segment_ids.flat<SegmentId>();
+    const int64_t num_segments =
+        num_indices > 0 ? int64_t{segment_flat(num_indices - 1)} + 1 : 0;
+    OP_REQUIRES(c, num_segments >= 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+
+    TensorShape output_shape = params.shape();
+    output_shape.set_dim(0, num_segments);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(c, c->allocate_output(0, output_shape, &output));
+    if (num_segments == 0) return;
+
+    const int64_t num_rows = params.dim_size(0);
+    const int64_t row_size = num_rows > 0 ? params.NumElements() / num_rows : 0;
+    const auto params_flat = params.shaped<T, 2>({num_rows, row_size});
+    auto output_flat = output->shaped<T, 2>({num_segments, row_size});
+    output_flat.setZero();
+
+    using Row = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+    using ConstRow = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+    const int64_t num_ids = ids.NumElements();
+    // Each segment is accumulated in turn, by going over its run of indices.
+    int64_t start = 0;
+    int64_t previous_segment = -1;
+    while (start < num_indices) {
+      const int64_t segment = segment_flat(start);
+      OP_REQUIRES(c, segment > previous_segment && segment < num_segments,
+                  errors::InvalidArgument("segment ids are not increasing"));
+      Row out(&output_flat(segment, 0), row_size);
+      int64_t end = start;
+      for (; end < num_indices && segment_flat(end) == segment; ++end) {
+        const int64_t index = indices_flat(end);
+        OP_REQUIRES(c, index >= 0 && index < num_ids,
+                    errors::InvalidArgument("indices[", end, "] = ", index,
+                                            " is out of range [0, ", num_ids,
+                                            ")"));
+        const int64_t id = ids_flat(index);
+        OP_REQUIRES(c, id >= 0 && id < num_rows,
+                    errors::InvalidArgument("ids[", index, "] = ", id,
+                                            " is not in [0, ", num_rows, ")"));
+        out += ConstRow(&params_flat(id, 0), row_size);
+      }
+      if (is_mean_ && end - start > 1) {
+        out /= static_cast<T>(end - start);
+      }
+      previous_segment = segment;
+      start = end;
+    }
+  }
+
+ private:
+  bool is_mean_;
+};
+
+#define REGISTER_KERNEL(type, index_type, idx_type, segment_type)      \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("_FusedResourceSparseSegmentReduce")                        \
+          .Device(DEVICE_CPU)                                          \
+          .TypeConstraint<type>("dtype")                               \
+          .TypeConstraint<index_type>("Tindices")                      \
+          .TypeConstraint<idx_type>("Tidx")                            \
+          .TypeConstraint<segment_type>("Tsegmentids"),                \
+      FusedResourceSparseSegmentReduceOp<type, index_type, idx_type,   \
+                                         segment_type>)
+
+#define REGISTER_KERNELS_FOR_SEGMENT_TYPE(type, index_type, idx_type) \
+  REGISTER_KERNEL(type, index_type, idx_type, int32);                 \
+  REGISTER_KERNEL(type, index_type, idx_type, int64_t)
+
+#define REGISTER_KERNELS_FOR_IDX_TYPE(type, index_type)               \
+  REGISTER_KERNELS_FOR_SEGMENT_TYPE(type, index_type, int32);         \
+  REGISTER_KERNELS_FOR_SEGMENT_TYPE(type, index_type, int64_t)
+
+#define REGISTER_CPU_KERNELS(type)                 \
+  REGISTER_KERNELS_FOR_IDX_TYPE(type, int32);      \
+  REGISTER_KERNELS_FOR_IDX_TYPE(type, int64_t)
+
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS_FOR_IDX_TYPE
+#undef REGISTER_KERNELS_FOR_SEGMENT_TYPE
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
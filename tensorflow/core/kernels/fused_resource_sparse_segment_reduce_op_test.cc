@@ -0,0 +1,91 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedResourceSparseSegmentReduceOpTest : public OpsTestBase {
+ protected:
+  void Init(const std::string& combiner) {
+    TF_ASSERT_OK(NodeDefBuilder("op", "_FusedResourceSparseSegmentReduce")
+                     .Input(FakeInput(DT_RESOURCE))
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("dtype", DT_FLOAT)
+                     .Attr("combiner", combiner)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    // A variable of 4 rows of 2.
+    Var* var = new Var(DT_FLOAT);
+    *var->tensor() =
+        test::AsTensor<float>({0, 1, 10, 11, 20, 21, 30, 31}, {4, 2});
+    var->is_initialized = true;
+    AddResourceInput("", "var", var);
+  }
+};
+
+TEST_F(FusedResourceSparseSegmentReduceOpTest, Sum) {
+  Init("sum");
+  AddInputFromArray<int64_t>(TensorShape({3}), {3, 1, 2});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 1, 2, 0});
+  AddInputFromArray<int32>(TensorShape({4}), {0, 0, 2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+  // Rows 3 + 1, none, then 2 + 3.
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({40, 42, 0, 0, 50, 52}, {3, 2}));
+}
+
+TEST_F(FusedResourceSparseSegmentReduceOpTest, Mean) {
+  Init("mean");
+  AddInputFromArray<int64_t>(TensorShape({3}), {3, 1, 2});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 2});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 0, 1});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({20, 21, 20, 21}, {2, 2}));
+}
+
+TEST_F(FusedResourceSparseSegmentReduceOpTest, IdOutOfRange) {
+  Init("sum");
+  AddInputFromArray<int64_t>(TensorShape({2}), {0, 4});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedResourceSparseSegmentReduceOpTest, UnsortedSegmentIds) {
+  Init("sum");
+  AddInputFromArray<int64_t>(TensorShape({2}), {0, 1});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 1, 0});
+  AddInputFromArray<int32>(TensorShape({3}), {1, 0, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
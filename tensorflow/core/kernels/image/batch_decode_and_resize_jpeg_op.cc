@@ -0,0 +1,275 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the largest DCT scaling denominator with which libjpeg decodes a
+// crop of `crop_height` x `crop_width` pixels to at least `height` x `width`
+// pixels, so that the resize never upsamples a downscaled decode.
+int ChooseRatio(int crop_height, int crop_width, int height, int width) {
+  for (int ratio : {8, 4, 2}) {
+    if (crop_height / ratio >= height && crop_width / ratio >= width) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+// The source pixels and weight of an output coordinate of a bilinear resize.
+struct Interpolation {
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+// Computes the interpolations of `out_size` output coordinates sampling
+// [`begin`, `begin` + `length`) in an input of `in_size` pixels, with half
+// pixel centers as in ResizeBilinear.
+std::vector<Interpolation> ComputeInterpolations(int64_t out_size,
+                                                 int64_t in_size, float begin,
+                                                 float length) {
+  std::vector<Interpolation> interpolations(out_size);
+  const float scale = length / out_size;
+  for (int64_t i = 0; i < out_size; ++i) {
+    const float in = std::min<float>(
+        std::max(begin + (i + 0.5f) * scale - 0.5f, 0.0f), in_size - 1);
+    interpolations[i].lower = static_cast<int64_t>(std::floor(in));
+    interpolations[i].upper =
+        std::min(interpolations[i].lower + 1, in_size - 1);
+    interpolations[i].lerp = in - interpolations[i].lower;
+  }
+  return interpolations;
+}
+
+// Decodes the crop window `window` (y, x, height, width) of the JPEG image
+// `contents` and resizes it bilinearly to `height` x `width` into `output`.
+// libjpeg downscales the crop in the DCT domain first, by the largest factor
+// that keeps it at least as large as the output.
+Status DecodeAndResizeJpeg(const tstring& contents, const int32* window,
+                           jpeg::UncompressFlags flags, int height, int width,
+                           float* output) {
+  int image_width;
+  int image_height;
+  if (!jpeg::GetImageInfo(contents.data(), contents.size(), &image_width,
+                          &image_height, nullptr)) {
+    return errors::InvalidArgument("Invalid JPEG data, size ",
+                                   contents.size());
+  }
+  int64_t crop_y = window[0];
+  int64_t crop_x = window[1];
+  int64_t crop_height = window[2];
+  int64_t crop_width = window[3];
+  if (crop_height == 0 && crop_width == 0) {
+    crop_y = 0;
+    crop_x = 0;
+    crop_height = image_height;
+    crop_width = image_width;
+  }
+  if (crop_y < 0 || crop_x < 0 || crop_height <= 0 || crop_width <= 0 ||
+      crop_y + crop_height > image_height ||
+      crop_x + crop_width > image_width) {
+    return errors::InvalidArgument(
+        "Crop window [", crop_y, ", ", crop_x, ", ", crop_height, ", ",
+        crop_width, "] is outside of the image of size ", image_height, "x",
+        image_width);
+  }
+
+  // libjpeg decodes the image to ceil(size / ratio) pixels, and takes the crop
+  // window of the decode in those, rounded out to whole pixels.
+  const int ratio = ChooseRatio(crop_height, crop_width, height, width);
+  const int64_t scaled_height = (image_height + ratio - 1) / ratio;
+  const int64_t scaled_width = (image_width + ratio - 1) / ratio;
+  const int64_t y0 = crop_y / ratio;
+  const int64_t x0 = crop_x / ratio;
+  const int64_t y1 =
+      std::min(scaled_height, (crop_y + crop_height + ratio - 1) / ratio);
+  const int64_t x1 =
+      std::min(scaled_width, (crop_x + crop_width + ratio - 1) / ratio);
+  flags.ratio = ratio;
+  if (y0 > 0 || x0 > 0 || y1 < scaled_height || x1 < scaled_width) {
+    flags.crop = true;
+    flags.crop_y = y0;
+    flags.crop_x = x0;
+    flags.crop_height = y1 - y0;
+    flags.crop_width = x1 - x0;
+  }
+
+  std::unique_ptr<uint8[]> decoded;
+  int decoded_height = 0;
+  int decoded_width = 0;
+  const uint8* pixels = jpeg::Uncompress(
+      contents.data(), contents.size(), flags, nullptr /* nwarn */,
+      [&](int width, int height, int channels) -> uint8* {
+        decoded_height = height;
+        decoded_width = width;
+        decoded.reset(new uint8[static_cast<int64_t>(height) * width *
+                                channels]);
+        return decoded.get();
+      });
+  if (pixels == nullptr) {
+    return errors::InvalidArgument(
+        "jpeg::Uncompress failed. Invalid JPEG data or crop window.");
+  }
+
+  // The crop window in the pixels of the decode, which start at (y0, x0).
+  const std::vector<Interpolation> ys = ComputeInterpolations(
+      height, decoded_height, static_cast<float>(crop_y) / ratio - y0,
+      static_cast<float>(crop_height) / ratio);
+  const std::vector<Interpolation> xs = ComputeInterpolations(
+      width, decoded_width, static_cast<float>(crop_x) / ratio - x0,
+      static_cast<float>(crop_width) / ratio);
+  const int channels = flags.components;
+  const int64_t row_size = static_cast<int64_t>(decoded_width) * channels;
+  for (int64_t i = 0; i < height; ++i) {
+    const uint8* upper_row = pixels + ys[i].lower * row_size;
+    const uint8* lower_row = pixels + ys[i].upper * row_size;
+    const float y_lerp = ys[i].lerp;
+    for (int64_t j = 0; j < width; ++j) {
+      const int64_t left = xs[j].lower * channels;
+      const int64_t right = xs[j].upper * channels;
+      const float x_lerp = xs[j].lerp;
+      for (int c = 0; c < channels; ++c) {
+        const float top = upper_row[left + c] +
+                          (upper_row[right + c] - upper_row[left + c]) * x_lerp;
+        const float bottom =
+            lower_row[left + c] +
+            (lower_row[right + c] - lower_row[left + c]) * x_lerp;
+        *output++ = top + (bottom - top) * y_lerp;
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+class BatchDecodeAndResizeJpegOp : public OpKernel {
+ public:
+  explicit BatchDecodeAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &flags_.components));
+    OP_REQUIRES(context, flags_.components == 1 || flags_.components == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        flags_.components));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("acceptable_fraction",
+                                    &flags_.min_acceptable_fraction));
+    std::string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    // As in DecodeJpeg, the default is IFAST.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& crop_windows = context->input(1);
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be 1-D, got shape ",
+                                        contents.shape().DebugString()));
+    const int64_t batch = contents.NumElements();
+    OP_REQUIRES(context,
+                crop_windows.dims() == 2 &&
+                    crop_windows.dim_size(0) == batch &&
+                    crop_windows.dim_size(1) == 4,
+                errors::InvalidArgument(
+                    "crop_windows must have shape [", batch, ", 4], got ",
+                    crop_windows.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(size.shape()) &&
+                    size.NumElements() == 2,
+                errors::InvalidArgument("size must have two elements, got ",
+                                        size.shape().DebugString()));
+    const int height = size.vec<int32>()(0);
+    const int width = size.vec<int32>()(1);
+    OP_REQUIRES(context, height > 0 && width > 0,
+                errors::InvalidArgument("size must be positive, got ", height,
+                                        "x", width));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, TensorShape({batch, height, width, flags_.components}),
+            &output));
+    if (batch == 0) return;
+    const auto contents_flat = contents.flat<tstring>();
+    const int32* windows = crop_windows.matrix<int32>().data();
+    float* images = output->flat<float>().data();
+    const int64_t image_size =
+        static_cast<int64_t>(height) * width * flags_.components;
+
+    // Decoding dominates the cost, so that each image is a shard.
+    std::vector<Status> statuses(batch);
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, batch,
+          /*cost_per_unit=*/1 << 24, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              statuses[i] = DecodeAndResizeJpeg(
+                  contents_flat(i), windows + 4 * i, flags_, height, width,
+                  images + i * image_size);
+            }
+          });
+    for (int64_t i = 0; i < batch; ++i) {
+      OP_REQUIRES(context, statuses[i].ok(),
+                  errors::CreateWithUpdatedMessage(
+                      statuses[i], absl::StrCat("Image ", i, " of the batch: ",
+                                                statuses[i].message())));
+    }
+  }
+
+ private:
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("BatchDecodeAndResizeJpeg").Device(DEVICE_CPU),
+                        BatchDecodeAndResizeJpegOp);
+
+}  // namespace tensorflow
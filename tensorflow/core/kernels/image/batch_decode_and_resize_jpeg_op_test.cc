@@ -0,0 +1,97 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class BatchDecodeAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("decode_op", "BatchDecodeAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("channels", 1)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns a 64x64 grayscale JPEG whose left half is 50 and right half 200.
+  tstring MakeJpeg() {
+    std::vector<uint8> pixels(64 * 64);
+    for (int y = 0; y < 64; ++y) {
+      for (int x = 0; x < 64; ++x) pixels[y * 64 + x] = x < 32 ? 50 : 200;
+    }
+    jpeg::CompressFlags flags;
+    flags.format = jpeg::FORMAT_GRAYSCALE;
+    flags.quality = 100;
+    tstring jpeg;
+    EXPECT_TRUE(jpeg::Compress(pixels.data(), 64, 64, flags, &jpeg));
+    return jpeg;
+  }
+};
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, ResizesWholeImagesAndCrops) {
+  MakeOp();
+  const tstring jpeg = MakeJpeg();
+  AddInputFromArray<tstring>(TensorShape({2}), {jpeg, jpeg});
+  // The whole image, and its right half.
+  AddInputFromArray<int32>(TensorShape({2, 4}), {0, 0, 0, 0, 0, 32, 32, 32});
+  AddInputFromArray<int32>(TensorShape({2}), {4, 4});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const Tensor& images = *GetOutput(0);
+  ASSERT_EQ(images.shape(), TensorShape({2, 4, 4, 1}));
+  const auto values = images.tensor<float, 4>();
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      EXPECT_NEAR(values(0, y, x, 0), x < 2 ? 50 : 200, 3);
+      EXPECT_NEAR(values(1, y, x, 0), 200, 3);
+    }
+  }
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, FailsForCropOutsideOfImage) {
+  MakeOp();
+  AddInputFromArray<tstring>(TensorShape({1}), {MakeJpeg()});
+  AddInputFromArray<int32>(TensorShape({1, 4}), {16, 16, 64, 8});
+  AddInputFromArray<int32>(TensorShape({2}), {4, 4});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, FailsForMismatchedBatches) {
+  MakeOp();
+  const tstring jpeg = MakeJpeg();
+  AddInputFromArray<tstring>(TensorShape({2}), {jpeg, jpeg});
+  AddInputFromArray<int32>(TensorShape({1, 4}), {0, 0, 0, 0});
+  AddInputFromArray<int32>(TensorShape({2}), {4, 4});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
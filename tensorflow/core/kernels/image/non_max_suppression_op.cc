@@ -19,9 +19,11 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/image/non_max_suppression_op.h"
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <optional>
 #include <queue>
 #include <vector>
 
@@ -192,6 +194,144 @@ static inline std::function<T(int, int)> CreateOverlapSimilarityFn(
                    std::placeholders::_2);
 }
 
+// The number of candidates from which hard NMS by IOU bins the selected boxes
+// into a SelectedBoxGrid.
+constexpr int kMinCandidatesForGrid = 1024;
+
+// Bins the boxes that hard NMS selects into a grid of cells by their extent.
+// A box suppresses a candidate only if their IOU exceeds a threshold >= 0,
+// which takes an intersection of positive area, so that a candidate only
+// needs to be compared with the selected boxes in the cells that it covers.
+// That makes the same selections as comparing it with all of them.
+template <typename T>
+class SelectedBoxGrid {
+ public:
+  explicit SelectedBoxGrid(typename TTypes<T, 2>::ConstTensor boxes)
+      : boxes_(boxes), checked_(boxes.dimension(0), -1) {}
+
+  // Returns false if the boxes can't be binned. That is if their coordinates
+  // or areas aren't finite, for which the IOU may be NaN, which suppresses a
+  // box without exceeding the threshold.
+  bool Init() {
+    const int num_boxes = boxes_.dimension(0);
+    if (num_boxes == 0) return false;
+    float y_min = std::numeric_limits<float>::infinity();
+    float x_min = y_min;
+    float y_max = -y_min;
+    float x_max = -y_min;
+    for (int i = 0; i < num_boxes; ++i) {
+      for (int k = 0; k < 4; k += 2) {
+        const float y = static_cast<float>(boxes_(i, k));
+        const float x = static_cast<float>(boxes_(i, k + 1));
+        if (!std::isfinite(y) || !std::isfinite(x)) return false;
+        y_min = std::min(y_min, y);
+        y_max = std::max(y_max, y);
+        x_min = std::min(x_min, x);
+        x_max = std::max(x_max, x);
+      }
+    }
+    if (!std::isfinite(2 * (y_max - y_min) * (x_max - x_min))) return false;
+    size_ = std::clamp(static_cast<int>(std::sqrt(num_boxes) / 4), 1, 256);
+    y_min_ = y_min;
+    x_min_ = x_min;
+    y_scale_ = Scale(y_max - y_min);
+    x_scale_ = Scale(x_max - x_min);
+    cells_.resize(size_ * size_);
+    return true;
+  }
+
+  // Returns true if `fn(j)` returns true for any selected box j that may
+  // intersect box `i`, calling it for each of those boxes at most once.
+  template <typename Fn>
+  bool AnySelected(int i, Fn fn) {
+    const CellRange range = Cells(i);
+    if (range.size() > kMaxCellsPerBox) {
+      return std::any_of(selected_.begin(), selected_.end(), fn);
+    }
+    ++query_;
+    for (int y = range.y_begin; y <= range.y_end; ++y) {
+      for (int x = range.x_begin; x <= range.x_end; ++x) {
+        for (int j : cells_[y * size_ + x]) {
+          if (checked_[j] == query_) continue;
+          checked_[j] = query_;
+          if (fn(j)) return true;
+        }
+      }
+    }
+    return std::any_of(large_.begin(), large_.end(), fn);
+  }
+
+  // Adds the selected box `i`.
+  void Add(int i) {
+    selected_.push_back(i);
+    const CellRange range = Cells(i);
+    if (range.size() > kMaxCellsPerBox) {
+      large_.push_back(i);
+      return;
+    }
+    for (int y = range.y_begin; y <= range.y_end; ++y) {
+      for (int x = range.x_begin; x <= range.x_end; ++x) {
+        cells_[y * size_ + x].push_back(i);
+      }
+    }
+  }
+
+ private:
+  // Boxes that cover more cells are compared with all candidates instead.
+  static constexpr int kMaxCellsPerBox = 16;
+
+  // The cells that a box covers, inclusive.
+  struct CellRange {
+    int y_begin;
+    int y_end;
+    int x_begin;
+    int x_end;
+    int size() const { return (y_end - y_begin + 1) * (x_end - x_begin + 1); }
+  };
+
+  // Returns the scale from coordinates to cells for a range of coordinates,
+  // or 0 to put all boxes into the first cell.
+  float Scale(float range) const {
+    const float scale = size_ / range;
+    return range > 0 && std::isfinite(scale) ? scale : 0;
+  }
+
+  // Cells are monotonic in the coordinates, so that boxes that intersect
+  // share a cell.
+  int Cell(float value, float min, float scale) const {
+    if (scale == 0) return 0;
+    return static_cast<int>(
+        std::min<float>(std::max<float>((value - min) * scale, 0), size_ - 1));
+  }
+
+  CellRange Cells(int i) const {
+    const float y0 = static_cast<float>(boxes_(i, 0));
+    const float x0 = static_cast<float>(boxes_(i, 1));
+    const float y1 = static_cast<float>(boxes_(i, 2));
+    const float x1 = static_cast<float>(boxes_(i, 3));
+    return {Cell(std::min(y0, y1), y_min_, y_scale_),
+            Cell(std::max(y0, y1), y_min_, y_scale_),
+            Cell(std::min(x0, x1), x_min_, x_scale_),
+            Cell(std::max(x0, x1), x_min_, x_scale_)};
+  }
+
+  typename TTypes<T, 2>::ConstTensor boxes_;
+  int size_ = 1;  // The number of cells along each axis.
+  float y_min_ = 0;
+  float x_min_ = 0;
+  float y_scale_ = 0;
+  float x_scale_ = 0;
+  std::vector<std::vector<int>> cells_;
+  std::vector<int> large_;
+  std::vector<int> selected_;
+  // The last query that compared each box, to compare it once per query.
+  std::vector<int> checked_;
+  int query_ = 0;
+};
+
+// If `boxes` isn't null, `similarity_fn` must be the IOU of `boxes`, with
+// which hard NMS of many candidates compares them only with the selected
+// boxes they may intersect.
 template <typename T>
 void DoNonMaxSuppressionOp(OpKernelContext* context, const Tensor& scores,
                            int num_boxes, const Tensor& max_output_size,
@@ -200,7 +340,8 @@ void DoNonMaxSuppressionOp(OpKernelContext* context, const Tensor& scores,
                            const std::function<float(int, int)>& similarity_fn,
                            bool return_scores_tensor = false,
                            bool pad_to_max_output_size = false,
-                           int* ptr_num_valid_outputs = nullptr) {
+                           int* ptr_num_valid_outputs = nullptr,
+                           const Tensor* boxes = nullptr) {
   const int output_size = max_output_size.scalar<int>()();
   OP_REQUIRES(context, output_size >= 0,
               errors::InvalidArgument("output size must be non-negative"));
@@ -240,6 +381,14 @@ void DoNonMaxSuppressionOp(OpKernelContext* context, const Tensor& scores,
                                                       : static_cast<T>(0.0);
   };
 
+  std::optional<SelectedBoxGrid<T>> grid;
+  if (boxes != nullptr && !is_soft_nms &&
+      similarity_threshold >= static_cast<T>(0.0) &&
+      candidate_priority_queue.size() >= kMinCandidatesForGrid) {
+    grid.emplace(boxes->tensor<T, 2>());
+    if (!grid->Init()) grid.reset();
+  }
+
   std::vector<int> selected;
   std::vector<T> selected_scores;
   float similarity;
@@ -251,6 +400,22 @@ void DoNonMaxSuppressionOp(OpKernelContext* context, const Tensor& scores,
     original_score = next_candidate.score;
     candidate_priority_queue.pop();
 
+    if (grid) {
+      // Without soft suppression, a candidate keeps its score unless a
+      // selected box suppresses it.
+      const bool suppressed =
+          grid->AnySelected(next_candidate.box_index, [&](int j) {
+            return static_cast<T>(similarity_fn(next_candidate.box_index,
+                                                j)) > similarity_threshold;
+          });
+      if (!suppressed) {
+        selected.push_back(next_candidate.box_index);
+        selected_scores.push_back(next_candidate.score);
+        grid->Add(next_candidate.box_index);
+      }
+      continue;
+    }
+
     // Overlapping boxes are likely to have similar scores, therefore we
     // iterate through the previously selected boxes backwards in order to
     // see if `next_candidate` should be suppressed. We also enforce a property
@@ -654,7 +819,10 @@ class NonMaxSuppressionOp : public OpKernel {
     const float dummy_soft_nms_sigma = static_cast<float>(0.0);
     DoNonMaxSuppressionOp<float>(context, scores, num_boxes, max_output_size,
                                  iou_threshold_, score_threshold_val,
-                                 dummy_soft_nms_sigma, similarity_fn);
+                                 dummy_soft_nms_sigma, similarity_fn,
+                                 /*return_scores_tensor=*/false,
+                                 /*pad_to_max_output_size=*/false,
+                                 /*ptr_num_valid_outputs=*/nullptr, &boxes);
   }
 
  private:
@@ -701,7 +869,10 @@ class NonMaxSuppressionV2Op : public OpKernel {
     const T dummy_soft_nms_sigma = static_cast<T>(0.0);
     DoNonMaxSuppressionOp<T>(context, scores, num_boxes, max_output_size,
                              iou_threshold_val, score_threshold_val,
-                             dummy_soft_nms_sigma, similarity_fn);
+                             dummy_soft_nms_sigma, similarity_fn,
+                             /*return_scores_tensor=*/false,
+                             /*pad_to_max_output_size=*/false,
+                             /*ptr_num_valid_outputs=*/nullptr, &boxes);
   }
 };
 
@@ -756,7 +927,10 @@ class NonMaxSuppressionV3Op : public OpKernel {
     const T dummy_soft_nms_sigma = static_cast<T>(0.0);
     DoNonMaxSuppressionOp<T>(context, scores, num_boxes, max_output_size,
                              iou_threshold_val, score_threshold_val,
-                             dummy_soft_nms_sigma, similarity_fn);
+                             dummy_soft_nms_sigma, similarity_fn,
+                             /*return_scores_tensor=*/false,
+                             /*pad_to_max_output_size=*/false,
+                             /*ptr_num_valid_outputs=*/nullptr, &boxes);
   }
 };
 
@@ -813,7 +987,8 @@ class NonMaxSuppressionV4Op : public OpKernel {
     DoNonMaxSuppressionOp<T>(
         context, scores, num_boxes, max_output_size, iou_threshold_val,
         score_threshold_val, dummy_soft_nms_sigma, similarity_fn,
-        return_scores_tensor_, pad_to_max_output_size_, &num_valid_outputs);
+        return_scores_tensor_, pad_to_max_output_size_, &num_valid_outputs,
+        &boxes);
     if (!context->status().ok()) {
       return;
     }
@@ -893,7 +1068,8 @@ class NonMaxSuppressionV5Op : public OpKernel {
     DoNonMaxSuppressionOp<T>(
         context, scores, num_boxes, max_output_size, iou_threshold_val,
         score_threshold_val, soft_nms_sigma_val, similarity_fn,
-        return_scores_tensor_, pad_to_max_output_size_, &num_valid_outputs);
+        return_scores_tensor_, pad_to_max_output_size_, &num_valid_outputs,
+        &boxes);
     if (!context->status().ok()) {
       return;
     }
@@ -13,6 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
@@ -769,6 +774,80 @@ TEST_F(NonMaxSuppressionV5OpTest, TestSelectFromThreeClustersWithSoftNMS) {
   test::ExpectTensorEqual<int>(expected_num_valid, *GetOutput(2));
 }
 
+// Returns the IOU of boxes i and j of `boxes`, as the kernels compute it.
+static float NaiveIOU(const std::vector<float>& boxes, int i, int j) {
+  const float* a = &boxes[4 * i];
+  const float* b = &boxes[4 * j];
+  const float area_a =
+      (std::max(a[0], a[2]) - std::min(a[0], a[2])) *
+      (std::max(a[1], a[3]) - std::min(a[1], a[3]));
+  const float area_b =
+      (std::max(b[0], b[2]) - std::min(b[0], b[2])) *
+      (std::max(b[1], b[3]) - std::min(b[1], b[3]));
+  if (area_a <= 0 || area_b <= 0) return 0;
+  const float height = std::min(std::max(a[0], a[2]), std::max(b[0], b[2])) -
+                       std::max(std::min(a[0], a[2]), std::min(b[0], b[2]));
+  const float width = std::min(std::max(a[1], a[3]), std::max(b[1], b[3])) -
+                      std::max(std::min(a[1], a[3]), std::min(b[1], b[3]));
+  const float intersection =
+      std::max(height, 0.0f) * std::max(width, 0.0f);
+  return intersection / (area_a + area_b - intersection);
+}
+
+TEST_F(NonMaxSuppressionV5OpTest, TestManyBoxesMatchGreedySelection) {
+  // Enough boxes for the kernel to bin the selected boxes, some of them
+  // flipped, large or empty, with tied scores.
+  constexpr int kNumBoxes = 3000;
+  constexpr float kIOUThreshold = 0.4f;
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> position(0, 500);
+  std::uniform_int_distribution<int> size(0, 40);
+  std::uniform_int_distribution<int> score(1, 200);
+  std::vector<float> boxes;
+  std::vector<float> scores;
+  for (int i = 0; i < kNumBoxes; ++i) {
+    const float y = position(rng);
+    const float x = position(rng);
+    const float height = i % 100 == 0 ? 300 : size(rng);
+    const float width = size(rng);
+    if (i % 3 == 0) {
+      boxes.insert(boxes.end(), {y + height, x + width, y, x});
+    } else {
+      boxes.insert(boxes.end(), {y, x, y + height, x + width});
+    }
+    scores.push_back(score(rng) / 200.0f);
+  }
+
+  std::vector<int> order(kNumBoxes);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int i, int j) { return scores[i] > scores[j]; });
+  std::vector<int> expected;
+  for (int i : order) {
+    if (std::none_of(expected.begin(), expected.end(), [&](int j) {
+          return NaiveIOU(boxes, i, j) > kIOUThreshold;
+        })) {
+      expected.push_back(i);
+    }
+  }
+
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({kNumBoxes, 4}), boxes);
+  AddInputFromArray<float>(TensorShape({kNumBoxes}), scores);
+  AddInputFromArray<int>(TensorShape({}), {kNumBoxes});
+  AddInputFromArray<float>(TensorShape({}), {kIOUThreshold});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  AddInputFromArray<float>(TensorShape({}), {0.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const int num_valid = GetOutput(2)->scalar<int>()();
+  ASSERT_EQ(num_valid, static_cast<int>(expected.size()));
+  const auto indices = GetOutput(0)->vec<int>();
+  for (int i = 0; i < num_valid; ++i) {
+    EXPECT_EQ(indices(i), expected[i]) << i;
+  }
+}
+
 //
 // NonMaxSuppressionWithOverlapsOp Tests
 //
@@ -19,12 +19,16 @@ limitations under the License.
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace {
@@ -100,5 +104,71 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+TEST_F(LookupOpsTest, MutableStripedHashTable_ConcurrentInsertAndFind) {
+  TF_ASSERT_OK(NodeDefBuilder("striped_table", "MutableStripedHashTable")
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_INT64)
+                   .Attr("num_shards", 4)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+  const ResourceHandle& handle = GetOutput(0)->scalar<ResourceHandle>()();
+  lookup::LookupInterface* table = nullptr;
+  TF_ASSERT_OK(device_->resource_manager()->Lookup(handle.container(),
+                                                   handle.name(), &table));
+  core::ScopedUnref unref(table);
+
+  const int kNumThreads = 8;
+  const int kKeysPerThread = 1000;
+  const Tensor default_value = test::AsScalar<int64_t>(-1);
+  {
+    thread::ThreadPool pool(Env::Default(), "striped_table", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([table, &default_value, t]() {
+        Tensor keys(DT_INT64, TensorShape({kKeysPerThread}));
+        Tensor values(DT_INT64, TensorShape({kKeysPerThread}));
+        for (int i = 0; i < kKeysPerThread; ++i) {
+          keys.flat<int64_t>()(i) = t * kKeysPerThread + i;
+          values.flat<int64_t>()(i) = 2 * (t * kKeysPerThread + i);
+        }
+        TF_ASSERT_OK(table->Insert(nullptr, keys, values));
+        // The keys of the next thread may or may not be inserted yet.
+        for (int i = 0; i < kKeysPerThread; ++i) {
+          keys.flat<int64_t>()(i) =
+              ((t + 1) % kNumThreads) * kKeysPerThread + i;
+        }
+        Tensor found(DT_INT64, TensorShape({kKeysPerThread}));
+        TF_ASSERT_OK(table->Find(nullptr, keys, &found, default_value));
+        for (int i = 0; i < kKeysPerThread; ++i) {
+          const int64_t value = found.flat<int64_t>()(i);
+          EXPECT_TRUE(value == -1 || value == 2 * keys.flat<int64_t>()(i));
+        }
+      });
+    }
+  }
+  EXPECT_EQ(table->size(), kNumThreads * kKeysPerThread);
+
+  // Keys of all shards are found in one batch, in the order of the batch.
+  Tensor keys = test::AsTensor<int64_t>({7999, 3, -5, 4242, 3});
+  Tensor found(DT_INT64, TensorShape({5}));
+  TF_ASSERT_OK(table->Find(nullptr, keys, &found, default_value));
+  test::ExpectTensorEqual<int64_t>(
+      found, test::AsTensor<int64_t>({15998, 6, -1, 8484, 6}));
+
+  TF_ASSERT_OK(table->Remove(nullptr, test::AsTensor<int64_t>({3, 4242})));
+  EXPECT_EQ(table->size(), kNumThreads * kKeysPerThread - 2);
+  TF_ASSERT_OK(table->Find(nullptr, keys, &found, default_value));
+  test::ExpectTensorEqual<int64_t>(
+      found, test::AsTensor<int64_t>({15998, -1, -1, -1, -1}));
+
+  // Importing replaces the whole table.
+  TF_ASSERT_OK(table->ImportValues(nullptr, test::AsTensor<int64_t>({3, 5}),
+                                   test::AsTensor<int64_t>({30, 50})));
+  EXPECT_EQ(table->size(), 2);
+  TF_ASSERT_OK(table->Find(nullptr, keys, &found, default_value));
+  test::ExpectTensorEqual<int64_t>(
+      found, test::AsTensor<int64_t>({-1, 30, -1, -1, 30}));
+}
+
 }  // namespace
 }  // namespace tensorflow
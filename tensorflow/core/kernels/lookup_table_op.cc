@@ -16,9 +16,15 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -408,6 +414,285 @@ class MutableHashTableOfTensors final : public LookupInterface {
   std::unordered_map<K, ValueArray> table_ TF_GUARDED_BY(mu_);
 };
 
+// Lookup table that behaves like MutableHashTableOfScalars, except that its
+// entries are spread over num_shards shards, each with its own lock, so that
+// lookups and inserts of different threads rarely contend. A batch of keys is
+// grouped by shard first, so that each shard is locked once per batch, and
+// the keys of a shard are probed in one go in its flat_hash_map.
+template <class K, class V>
+class MutableStripedHashTable final : public LookupInterface {
+ public:
+  MutableStripedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards_));
+    OP_REQUIRES(ctx, num_shards_ > 0,
+                errors::InvalidArgument("num_shards must be positive, got ",
+                                        num_shards_));
+    shards_ = std::make_unique<Shard[]>(num_shards_);
+  }
+
+  size_t size() const override {
+    size_t size = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      size += shards_[s].table.size();
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const auto default_flat = default_value.flat<V>();
+    // All keys share default_flat(0), unless each has its own default.
+    const bool is_full_size_default =
+        (value_values.size() == default_flat.size());
+
+    std::vector<int64_t> order;
+    std::vector<int64_t> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      const Shard& shard = shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+        const int64_t i = order[j];
+        auto it = shard.table.find(SubtleMustCopyIfIntegral(key_values(i)));
+        if (it != shard.table.end()) {
+          value_values(i) = it->second;
+        } else {
+          value_values(i) =
+              is_full_size_default ? default_flat(i) : default_flat(0);
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    std::vector<int64_t> order;
+    std::vector<int64_t> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    if (clear) {
+      // The table is replaced at once, under the locks of all shards.
+      LockAll();
+      for (int64_t s = 0; s < num_shards_; ++s) {
+        shards_[s].table.clear();
+        InsertIntoShard(key_values, value_values, order, offsets, s);
+      }
+      UnlockAll();
+      return absl::OkStatus();
+    }
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      mutex_lock l(shards_[s].mu);
+      InsertIntoShard(key_values, value_values, order, offsets, s);
+    }
+    return absl::OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return DoInsert(false, keys, values);
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    std::vector<int64_t> order;
+    std::vector<int64_t> offsets;
+    GroupByShard(key_values, &order, &offsets);
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      if (offsets[s] == offsets[s + 1]) continue;
+      Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+        shard.table.erase(SubtleMustCopyIfIntegral(key_values(order[j])));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return DoInsert(true, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    LockAllShared();
+    int64_t size = SizeLocked();
+    Tensor* keys;
+    Tensor* values;
+    Status s = ctx->allocate_output("keys", TensorShape({size}), &keys);
+    if (s.ok()) {
+      s = ctx->allocate_output("values", TensorShape({size}), &values);
+    }
+    if (s.ok()) {
+      ExportKeysAndValues(keys, values);
+    }
+    UnlockAllShared();
+    return s;
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64_t MemoryUsed() const override {
+    int64_t ret = sizeof(MutableStripedHashTable) + num_shards_ * sizeof(Shard);
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      // Each slot holds a key, a value and a control byte.
+      ret += shards_[s].table.capacity() * (sizeof(K) + sizeof(V) + 1);
+    }
+    return ret;
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    LockAllShared();
+    int64_t size = SizeLocked();
+    Tensor keys(key_dtype(), TensorShape({size}));
+    Tensor values(value_dtype(), TensorShape({size}));
+    ExportKeysAndValues(&keys, &values);
+    UnlockAllShared();
+
+    // We set use_node_name_sharing with a unique node name so that the resource
+    // can outlive the MutableStripedHashTable kernel, like
+    // MutableHashTableOfScalars does.
+    Node* table = ops::SourceOp(
+        "MutableStripedHashTable",
+        builder->opts()
+            .WithName(UniqueNodeName("MutableStripedHashTableFromGraphDef"))
+            .WithAttr("use_node_name_sharing", true)
+            .WithAttr("key_dtype", key_dtype())
+            .WithAttr("value_dtype", value_dtype())
+            .WithAttr("num_shards", num_shards_));
+    Node* keys_node = ops::SourceOp(
+        "Const",
+        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
+    Node* values_node =
+        ops::SourceOp("Const", builder->opts()
+                                   .WithAttr("dtype", value_dtype())
+                                   .WithAttr("value", values));
+    Node* import_table =
+        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                       builder->opts()
+                           .WithAttr("Tin", key_dtype())
+                           .WithAttr("Tout", value_dtype()));
+    *out = ops::UnaryOp("Identity", table,
+                        builder->opts().WithControlInput(import_table));
+    return absl::OkStatus();
+  }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const K& key) const {
+      if constexpr (std::is_same_v<K, tstring>) {
+        return Hash64(key);
+      } else {
+        return absl::Hash<K>()(key);
+      }
+    }
+  };
+
+  // Shards are padded to a cache line, so that the locks of neighbouring
+  // shards don't share one.
+  struct alignas(ABSL_CACHELINE_SIZE) Shard {
+    mutable mutex mu;
+    absl::flat_hash_map<K, V, KeyHash> table TF_GUARDED_BY(mu);
+  };
+
+  int64_t ShardIndex(const K& key) const {
+    // The hash is mixed again, so that the keys of a shard don't share the
+    // low bits the flat_hash_map probes with.
+    return Hash64Combine(0x5bd1e995, KeyHash()(key)) % num_shards_;
+  }
+
+  // Orders the indices of `keys` by shard, the keys of shard s being
+  // order[offsets[s]] to order[offsets[s + 1] - 1], in their original order.
+  void GroupByShard(typename TTypes<K>::ConstFlat keys,
+                    std::vector<int64_t>* order,
+                    std::vector<int64_t>* offsets) const {
+    std::vector<int64_t> shard_of(keys.size());
+    offsets->assign(num_shards_ + 1, 0);
+    for (int64_t i = 0; i < keys.size(); ++i) {
+      shard_of[i] = ShardIndex(SubtleMustCopyIfIntegral(keys(i)));
+      ++(*offsets)[shard_of[i] + 1];
+    }
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      (*offsets)[s + 1] += (*offsets)[s];
+    }
+    std::vector<int64_t> next(offsets->begin(), offsets->end() - 1);
+    order->resize(keys.size());
+    for (int64_t i = 0; i < keys.size(); ++i) {
+      (*order)[next[shard_of[i]]++] = i;
+    }
+  }
+
+  void InsertIntoShard(typename TTypes<K>::ConstFlat keys,
+                       typename TTypes<V>::ConstFlat values,
+                       const std::vector<int64_t>& order,
+                       const std::vector<int64_t>& offsets, int64_t s)
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    Shard& shard = shards_[s];
+    for (int64_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+      const int64_t i = order[j];
+      gtl::InsertOrUpdate(&shard.table, SubtleMustCopyIfIntegral(keys(i)),
+                          SubtleMustCopyIfIntegral(values(i)));
+    }
+  }
+
+  // The locks of all shards are taken in shard order.
+  void LockAll() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int64_t s = 0; s < num_shards_; ++s) shards_[s].mu.lock();
+  }
+
+  void UnlockAll() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int64_t s = 0; s < num_shards_; ++s) shards_[s].mu.unlock();
+  }
+
+  void LockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int64_t s = 0; s < num_shards_; ++s) shards_[s].mu.lock_shared();
+  }
+
+  void UnlockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int64_t s = 0; s < num_shards_; ++s) shards_[s].mu.unlock_shared();
+  }
+
+  // Requires the locks of all shards.
+  int64_t SizeLocked() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    int64_t size = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) size += shards_[s].table.size();
+    return size;
+  }
+
+  // Writes all keys and values into `keys` and `values`, which must have
+  // SizeLocked() elements. Requires the locks of all shards.
+  void ExportKeysAndValues(Tensor* keys, Tensor* values) const
+      TF_NO_THREAD_SAFETY_ANALYSIS {
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64_t i = 0;
+    for (int64_t s = 0; s < num_shards_; ++s) {
+      for (const auto& entry : shards_[s].table) {
+        keys_data(i) = entry.first;
+        values_data(i) = entry.second;
+        ++i;
+      }
+    }
+  }
+
+  int64_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
 namespace {
 
 template <typename T>
@@ -1160,6 +1445,33 @@ REGISTER_KERNEL(tstring, int64_t);
 
 #undef REGISTER_KERNEL
 
+// Register the MutableStripedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableStripedHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::MutableStripedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(int64_t, tstring);
+REGISTER_KERNEL(int64_t, Variant);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64_t);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableHashTableOfTensors op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                                \
   REGISTER_KERNEL_BUILDER(                                                     \
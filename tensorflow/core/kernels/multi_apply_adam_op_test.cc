@@ -0,0 +1,116 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class MultiApplyAdamOpTest : public OpsTestBase {
+ protected:
+  void Init(int num_vars) {
+    TF_ASSERT_OK(NodeDefBuilder("op", "_ResourceMultiApplyAdam")
+                     .Input(FakeInput(num_vars, DT_RESOURCE))
+                     .Input(FakeInput(num_vars, DT_RESOURCE))
+                     .Input(FakeInput(num_vars, DT_RESOURCE))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_vars, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  Var* AddVariable(const std::string& name, const Tensor& value) {
+    Var* var = new Var(DT_FLOAT);
+    *var->tensor() = value;
+    var->is_initialized = true;
+    // The resource manager owns one reference.
+    var->Ref();
+    AddResourceInput("", name, var);
+    return var;
+  }
+};
+
+TEST_F(MultiApplyAdamOpTest, UpdatesAllVariables) {
+  Init(2);
+  // The second variable spans several blocks of the kernel.
+  const std::vector<TensorShape> shapes = {TensorShape({3}),
+                                           TensorShape({40000})};
+  std::vector<Var*> vars;
+  for (const std::string& kind : {"var", "m", "v"}) {
+    for (int i = 0; i < shapes.size(); ++i) {
+      Tensor value(DT_FLOAT, shapes[i]);
+      value.flat<float>().setConstant(kind == "var" ? 1.0f : 0.0f);
+      Var* var = AddVariable(absl::StrCat(kind, i), value);
+      if (kind == "var") {
+        vars.push_back(var);
+      } else {
+        var->Unref();
+      }
+    }
+  }
+  AddInputFromArray<float>(TensorShape({}), {0.9f});    // beta1_power
+  AddInputFromArray<float>(TensorShape({}), {0.999f});  // beta2_power
+  AddInputFromArray<float>(TensorShape({}), {0.1f});    // lr
+  AddInputFromArray<float>(TensorShape({}), {0.9f});    // beta1
+  AddInputFromArray<float>(TensorShape({}), {0.999f});  // beta2
+  AddInputFromArray<float>(TensorShape({}), {1e-8f});   // epsilon
+  for (int i = 0; i < shapes.size(); ++i) {
+    AddInput<float>(shapes[i], [i](int) { return i == 0 ? 1.0f : -2.0f; });
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The first step of Adam moves each element by lr against its gradient.
+  for (int i = 0; i < shapes.size(); ++i) {
+    Tensor expected(DT_FLOAT, shapes[i]);
+    expected.flat<float>().setConstant(i == 0 ? 0.9f : 1.1f);
+    test::ExpectTensorNear<float>(*vars[i]->tensor(), expected, 1e-5);
+    vars[i]->Unref();
+  }
+}
+
+TEST_F(MultiApplyAdamOpTest, FailsOnShapeMismatch) {
+  Init(1);
+  for (const std::string& kind : {"var", "m", "v"}) {
+    AddVariable(kind, Tensor(DT_FLOAT, TensorShape({2})))->Unref();
+  }
+  for (int i = 0; i < 6; ++i) {
+    AddInputFromArray<float>(TensorShape({}), {0.5f});
+  }
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+}  // namespace
+}  // namespace tensorflow
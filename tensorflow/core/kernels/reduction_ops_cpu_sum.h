@@ -0,0 +1,245 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_REDUCTION_OPS_CPU_SUM_H_
+#define TENSORFLOW_CORE_KERNELS_REDUCTION_OPS_CPU_SUM_H_
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/kernels/reduction_ops.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Sums of float and double tensors on CPU that don't depend on the number of
+// threads. Eigen's thread pool reductions split their input by the number of
+// threads, so that their rounding does too. These split the reduced dimension
+// into blocks of a fixed size instead, sum each block with SIMD accumulators
+// and add up the sums of the blocks in a tree, which also bounds the rounding
+// error of large sums.
+namespace cpu_sum {
+
+// The number of elements of a row that one task sums.
+constexpr int64_t kBlockSize = 8192;
+// The number of rows and columns that one task of a column reduction sums.
+constexpr int64_t kRowBlockSize = 64;
+constexpr int64_t kColumnBlockSize = 2048;
+
+// Returns the sum of `size` values with four packets of accumulators.
+template <typename T>
+T SumBlock(const T* data, int64_t size) {
+  using Packet = typename Eigen::internal::packet_traits<T>::type;
+  constexpr int64_t kPacketSize = Eigen::internal::packet_traits<T>::size;
+  int64_t i = 0;
+  T sum(0);
+  if (size >= 4 * kPacketSize) {
+    Packet sum0 = Eigen::internal::pset1<Packet>(T(0));
+    Packet sum1 = sum0;
+    Packet sum2 = sum0;
+    Packet sum3 = sum0;
+    for (; i + 4 * kPacketSize <= size; i += 4 * kPacketSize) {
+      sum0 = Eigen::internal::padd(
+          sum0, Eigen::internal::ploadu<Packet>(data + i));
+      sum1 = Eigen::internal::padd(
+          sum1, Eigen::internal::ploadu<Packet>(data + i + kPacketSize));
+      sum2 = Eigen::internal::padd(
+          sum2, Eigen::internal::ploadu<Packet>(data + i + 2 * kPacketSize));
+      sum3 = Eigen::internal::padd(
+          sum3, Eigen::internal::ploadu<Packet>(data + i + 3 * kPacketSize));
+    }
+    sum = Eigen::internal::predux(Eigen::internal::padd(
+        Eigen::internal::padd(sum0, sum1), Eigen::internal::padd(sum2, sum3)));
+  }
+  for (; i < size; ++i) sum += data[i];
+  return sum;
+}
+
+// Returns the sum of `size` > 0 values, adding halves recursively.
+template <typename T>
+T PairwiseSum(const T* values, int64_t size) {
+  if (size == 1) return values[0];
+  const int64_t half = size / 2;
+  return PairwiseSum(values, half) + PairwiseSum(values + half, size - half);
+}
+
+// Sets `out[r]` to the sum of row `r` of the `rows` x `cols` matrix `in`.
+template <typename T>
+void SumRows(const Eigen::ThreadPoolDevice& d, const T* in, int64_t rows,
+             int64_t cols, T* out) {
+  if (cols == 0) {
+    std::fill(out, out + rows, T(0));
+    return;
+  }
+  const int64_t blocks_per_row = Eigen::divup(cols, kBlockSize);
+  if (blocks_per_row == 1) {
+    const Eigen::TensorOpCost cost(cols * sizeof(T), sizeof(T), cols);
+    d.parallelFor(rows, cost, [=](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index r = begin; r < end; ++r) {
+        out[r] = SumBlock(in + r * cols, cols);
+      }
+    });
+    return;
+  }
+  std::vector<T> partials(rows * blocks_per_row);
+  T* partials_data = partials.data();
+  const Eigen::TensorOpCost cost(kBlockSize * sizeof(T), sizeof(T),
+                                 kBlockSize);
+  d.parallelFor(rows * blocks_per_row, cost,
+                [=](Eigen::Index begin, Eigen::Index end) {
+                  for (Eigen::Index i = begin; i < end; ++i) {
+                    const int64_t col = (i % blocks_per_row) * kBlockSize;
+                    partials_data[i] =
+                        SumBlock(in + (i / blocks_per_row) * cols + col,
+                                 std::min(kBlockSize, cols - col));
+                  }
+                });
+  for (int64_t r = 0; r < rows; ++r) {
+    out[r] = PairwiseSum(partials_data + r * blocks_per_row, blocks_per_row);
+  }
+}
+
+// Sets `out[c]` to the sum of column `c` of the `rows` x `cols` matrix `in`.
+template <typename T>
+void SumColumns(const Eigen::ThreadPoolDevice& d, const T* in, int64_t rows,
+                int64_t cols, T* out) {
+  if (rows == 0) {
+    std::fill(out, out + cols, T(0));
+    return;
+  }
+  // Each task sums a block of rows of a block of columns into a row of
+  // `partials`, with independent additions on the columns that vectorize.
+  const int64_t row_blocks = Eigen::divup(rows, kRowBlockSize);
+  const int64_t column_blocks = Eigen::divup(cols, kColumnBlockSize);
+  std::vector<T> buffer(row_blocks > 1 ? row_blocks * cols : 0);
+  T* partials = row_blocks > 1 ? buffer.data() : out;
+  const Eigen::TensorOpCost cost(kRowBlockSize * kColumnBlockSize * sizeof(T),
+                                 kColumnBlockSize * sizeof(T),
+                                 kRowBlockSize * kColumnBlockSize);
+  d.parallelFor(
+      row_blocks * column_blocks, cost,
+      [=](Eigen::Index begin, Eigen::Index end) {
+        for (Eigen::Index i = begin; i < end; ++i) {
+          const int64_t row_begin = (i / column_blocks) * kRowBlockSize;
+          const int64_t row_end = std::min(rows, row_begin + kRowBlockSize);
+          const int64_t col_begin = (i % column_blocks) * kColumnBlockSize;
+          const int64_t col_end = std::min(cols, col_begin + kColumnBlockSize);
+          T* sums = partials + (i / column_blocks) * cols;
+          std::copy(in + row_begin * cols + col_begin,
+                    in + row_begin * cols + col_end, sums + col_begin);
+          for (int64_t r = row_begin + 1; r < row_end; ++r) {
+            const T* row = in + r * cols;
+            for (int64_t c = col_begin; c < col_end; ++c) sums[c] += row[c];
+          }
+        }
+      });
+  if (row_blocks == 1) return;
+
+  // Adds up the rows of `partials` in a tree, a block of columns at a time.
+  const Eigen::TensorOpCost combine_cost(
+      row_blocks * kColumnBlockSize * sizeof(T), kColumnBlockSize * sizeof(T),
+      row_blocks * kColumnBlockSize);
+  d.parallelFor(column_blocks, combine_cost,
+                [=](Eigen::Index begin, Eigen::Index end) {
+                  const int64_t col_begin = begin * kColumnBlockSize;
+                  const int64_t col_end =
+                      std::min(cols, end * kColumnBlockSize);
+                  for (int64_t stride = 1; stride < row_blocks; stride *= 2) {
+                    for (int64_t r = 0; r + stride < row_blocks;
+                         r += 2 * stride) {
+                      T* sums = partials + r * cols;
+                      const T* other = partials + (r + stride) * cols;
+                      for (int64_t c = col_begin; c < col_end; ++c) {
+                        sums[c] += other[c];
+                      }
+                    }
+                  }
+                  std::copy(partials + col_begin, partials + col_end,
+                            out + col_begin);
+                });
+}
+
+// Sums `in` over `ReductionAxes` into `out` and returns true if that's one of
+// the reductions ReductionOp reshapes its inputs to that these handle: a full
+// reduction of a vector, or a reduction of a matrix along either dimension.
+template <typename OUT_T, typename IN_T, typename ReductionAxes>
+bool Sum(const Eigen::ThreadPoolDevice& d, OUT_T out, IN_T in,
+         const ReductionAxes& reduction_axes) {
+  if constexpr (IN_T::NumDimensions == 1 && OUT_T::NumDimensions == 0) {
+    SumRows(d, in.data(), 1, in.dimension(0), out.data());
+    return true;
+  } else if constexpr (IN_T::NumDimensions == 2 &&
+                       OUT_T::NumDimensions == 1 &&
+                       std::is_same<ReductionAxes, Eigen::IndexList<
+                                                       Eigen::type2index<1>>>::
+                           value) {
+    SumRows(d, in.data(), in.dimension(0), in.dimension(1), out.data());
+    return true;
+  } else if constexpr (IN_T::NumDimensions == 2 &&
+                       OUT_T::NumDimensions == 1 &&
+                       std::is_same<ReductionAxes, Eigen::IndexList<
+                                                       Eigen::type2index<0>>>::
+                           value) {
+    SumColumns(d, in.data(), in.dimension(0), in.dimension(1), out.data());
+    return true;
+  } else {
+    return false;
+  }
+}
+
+}  // namespace cpu_sum
+
+#define CPU_SUM_SPECIALIZATION(T)                                            \
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>           \
+  struct ReduceEigenImpl<Eigen::ThreadPoolDevice, OUT_T, IN_T,               \
+                         ReductionAxes, Eigen::internal::SumReducer<T>> {    \
+    void operator()(const Eigen::ThreadPoolDevice& d, OUT_T out, IN_T in,    \
+                    const ReductionAxes& reduction_axes,                     \
+                    const Eigen::internal::SumReducer<T>& reducer) {         \
+      if (!cpu_sum::Sum(d, out, in, reduction_axes)) {                       \
+        out.device(d) = in.reduce(reduction_axes, reducer);                  \
+      }                                                                      \
+    }                                                                        \
+  };                                                                         \
+                                                                             \
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>           \
+  struct ReduceEigenImpl<Eigen::ThreadPoolDevice, OUT_T, IN_T,               \
+                         ReductionAxes, functor::MeanReducer<T>> {           \
+    void operator()(const Eigen::ThreadPoolDevice& d, OUT_T out, IN_T in,    \
+                    const ReductionAxes& reduction_axes,                     \
+                    const functor::MeanReducer<T>& reducer) {                \
+      const T count = static_cast<T>(in.size() / out.size());                \
+      if (cpu_sum::Sum(d, out, in, reduction_axes)) {                        \
+        out.device(d) = out / count;                                         \
+      } else {                                                               \
+        Eigen::internal::SumReducer<T> sum_reducer;                          \
+        out.device(d) = in.reduce(reduction_axes, sum_reducer) / count;      \
+      }                                                                      \
+    }                                                                        \
+  };
+
+CPU_SUM_SPECIALIZATION(float);
+CPU_SUM_SPECIALIZATION(double);
+#undef CPU_SUM_SPECIALIZATION
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_REDUCTION_OPS_CPU_SUM_H_
@@ -13,11 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/reduction_ops_cpu_sum.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -256,4 +261,62 @@ static void BM_Mean2DToScalarCPUBF16(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_Mean2DToScalarCPUBF16)->RangePair(2048, 8192, 2048, 8192);
 
+// Sums a `rows` x `cols` matrix along both dimensions and in full with
+// `num_threads` threads.
+static void CpuSums(const Tensor& data, int num_threads,
+                    std::vector<float>* row_sums,
+                    std::vector<float>* column_sums, float* total) {
+  thread::ThreadPool pool(Env::Default(), "cpu_sum", num_threads);
+  Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), num_threads);
+  const int64_t rows = data.dim_size(0);
+  const int64_t cols = data.dim_size(1);
+  const float* values = data.flat<float>().data();
+  row_sums->resize(rows);
+  column_sums->resize(cols);
+  functor::cpu_sum::SumRows(device, values, rows, cols, row_sums->data());
+  functor::cpu_sum::SumColumns(device, values, rows, cols,
+                               column_sums->data());
+  functor::cpu_sum::SumRows(device, values, 1, rows * cols, total);
+}
+
+TEST(CpuSumTest, MatchesDoubleSumsForAnyNumberOfThreads) {
+  // Enough rows and columns for several blocks in both dimensions.
+  const int64_t rows = 300;
+  const int64_t cols = 20000;
+  Tensor data(DT_FLOAT, TensorShape({rows, cols}));
+  data.flat<float>().setRandom();
+  const auto matrix = data.matrix<float>();
+
+  std::vector<float> row_sums, column_sums;
+  float total;
+  CpuSums(data, 1, &row_sums, &column_sums, &total);
+  std::vector<double> expected_columns(cols, 0.0);
+  double expected_total = 0;
+  for (int64_t r = 0; r < rows; ++r) {
+    double expected_row = 0;
+    for (int64_t c = 0; c < cols; ++c) {
+      expected_row += matrix(r, c);
+      expected_columns[c] += matrix(r, c);
+    }
+    EXPECT_NEAR(row_sums[r], expected_row, 1e-5 * expected_row);
+    expected_total += expected_row;
+  }
+  for (int64_t c = 0; c < cols; ++c) {
+    EXPECT_NEAR(column_sums[c], expected_columns[c],
+                1e-5 * expected_columns[c]);
+  }
+  EXPECT_NEAR(total, expected_total, 1e-5 * expected_total);
+
+  // The sums are bitwise identical with other numbers of threads.
+  for (int num_threads : {2, 3, 8}) {
+    std::vector<float> other_row_sums, other_column_sums;
+    float other_total;
+    CpuSums(data, num_threads, &other_row_sums, &other_column_sums,
+            &other_total);
+    EXPECT_EQ(other_row_sums, row_sums);
+    EXPECT_EQ(other_column_sums, column_sums);
+    EXPECT_EQ(other_total, total);
+  }
+}
+
 }  // end namespace tensorflow
@@ -22,10 +22,14 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
 
+// The rough cost of matching a regex against a short string, in cycles.
+constexpr int64_t kCostPerString = 1000;
+
 // Execute the specified regex using the given context.
 // Context requirements:
 //  - "input" string Tensor at input_index=0
@@ -48,17 +52,25 @@ Status InternalCompute(const RE2& regex, const string& rewrite,
     output_tensor->flat<tstring>() = input_tensor->flat<tstring>();
   }
   auto output_flat = output_tensor->flat<tstring>();
-  for (size_t i = 0; i < output_flat.size(); ++i) {
-    // TODO(dero): Mitigate copy; Global and GlobalReplace below currently only
-    // accept std::string.
-    string buf = output_flat(i);
-    if (replace_global) {
-      RE2::GlobalReplace(&buf, regex, rewrite);
-    } else {
-      RE2::Replace(&buf, regex, rewrite);
-    }
-    output_flat(i) = std::move(buf);
-  }
+  // The strings are sharded over the intra-op threads, each reusing a buffer,
+  // and only the strings that have a match are rewritten.
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, output_flat.size(),
+        kCostPerString, [&](int64_t start, int64_t limit) {
+          // TODO(dero): Mitigate copy; Global and GlobalReplace below
+          // currently only accept std::string.
+          string buf;
+          for (int64_t i = start; i < limit; ++i) {
+            buf.assign(output_flat(i).data(), output_flat(i).size());
+            const bool replaced =
+                replace_global ? RE2::GlobalReplace(&buf, regex, rewrite) > 0
+                               : RE2::Replace(&buf, regex, rewrite);
+            if (replaced) {
+              output_flat(i).assign(buf.data(), buf.size());
+            }
+          }
+        });
   return absl::OkStatus();
 }
 }  // namespace
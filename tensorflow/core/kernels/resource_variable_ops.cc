@@ -57,10 +57,13 @@ limitations under the License.
 #include "tensorflow/core/platform/stream_executor.h"
 #endif
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <type_traits>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -155,12 +158,15 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
                   "Debug info: container=", handle.container(),
                   ", status error message=", status.message()));
 
-  tf_shared_lock ml(*variable->mu());
   // We're acquiring a reference to the underlying buffer while
   // holding a shared lock to guarantee ordering of reads and
-  // writes when in copy-on-write mode.
+  // writes when in copy-on-write mode. Frozen variables are never
+  // written, so they're aliased without a lock.
+  const bool frozen = variable->frozen.load();
+  std::optional<tf_shared_lock> ml;
+  if (!frozen) ml.emplace(*variable->mu());
   const Tensor* t = variable->tensor();
-  if (!variable->copy_on_read_mode.load()) {
+  if (frozen || !variable->copy_on_read_mode.load()) {
     OP_REQUIRES(
         ctx, dtype_ == t->dtype(),
         errors::InvalidArgument(
@@ -207,15 +213,17 @@ void ReadVariablesOp::Compute(OpKernelContext* ctx) {
   for (size_t i = 0; i < dtypes_.size(); ++i) {
     // We're acquiring a reference to the underlying buffer while
     // holding a shared lock to guarantee ordering of reads and
-    // writes.
-    tf_shared_lock ml(*variables[i]->mu());
+    // writes, unless the variable is frozen.
+    const bool frozen = variables[i]->frozen.load();
+    std::optional<tf_shared_lock> ml;
+    if (!frozen) ml.emplace(*variables[i]->mu());
     OP_REQUIRES(ctx, dtypes_[i] == variables[i]->tensor()->dtype(),
                 errors::InvalidArgument(
                     "Trying to read variable ", handles[i]->name(),
                     " from Container: ", handles[i]->container(),
                     " with wrong dtype. Expected ", DataTypeString(dtypes_[i]),
                     " got ", DataTypeString(variables[i]->tensor()->dtype())));
-    if (variables[i]->copy_on_read_mode.load()) {
+    if (!frozen && variables[i]->copy_on_read_mode.load()) {
       OP_REQUIRES_OK(ctx, CopyVariable(i, ctx, variables[i]->tensor()));
     } else {
       const Tensor& t = *variables[i]->tensor();
@@ -435,6 +443,8 @@ class AssignVariableOp : public OpKernel {
                                   return absl::OkStatus();
                                 }));
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, CheckVariableIsNotFrozen(
+                                *variable, HandleFromInput(context, 0)));
     // (variable->tensor()->dtype() == DT_INVALID && !variable->is_initialized)
     // check below is to allow an XLA specific situation wherein update can
     // happen first by the AssignVariableOp,
@@ -523,6 +533,8 @@ class AssignVariableOp<Device, Variant> : public OpKernel {
         attr);
 
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, CheckVariableIsNotFrozen(
+                                *variable, HandleFromInput(context, 0)));
     OP_REQUIRES(context, variable->tensor()->dtype() == DT_VARIANT,
                 errors::InvalidArgument(
                     "Trying to assign variable with wrong dtype. Expected ",
@@ -615,6 +627,8 @@ class AssignUpdateVariableOp : public OpKernel {
     // PrepareToUpdateVariable() for commutative operations like Op ==
     // ADD if value's refcount was 1.
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context, CheckVariableIsNotFrozen(
+                                *variable, HandleFromInput(context, 0)));
     Tensor* var_tensor = variable->tensor();
     OP_REQUIRES_OK(context, ValidateAssignUpdateVariableOpShapes(
                                 var_tensor->shape(), value.shape()));
@@ -715,6 +729,8 @@ class ResourceGatherOp : public OpKernel {
     OP_REQUIRES(c, batch_dims_ >= 0,
                 absl::InvalidArgumentError(absl::StrCat(
                     "batch_dims is negative (", batch_dims_, ")")));
+    OP_REQUIRES_OK(c,
+                   c->GetAttr("deduplicate_indices", &deduplicate_indices_));
   }
 
   void Compute(OpKernelContext* c) override {
@@ -725,8 +741,10 @@ class ResourceGatherOp : public OpKernel {
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
     // reference count greater than one and make a copy of the
-    // (potentially very large) tensor buffer.
-    tf_shared_lock ml(*v->mu());
+    // (potentially very large) tensor buffer. Frozen variables are
+    // never written, so they need no lock.
+    std::optional<tf_shared_lock> ml;
+    if (!v->frozen.load()) ml.emplace(*v->mu());
     const Tensor& params = *v->tensor();
     const Tensor& indices = c->input(1);
     OP_REQUIRES(
@@ -799,6 +817,12 @@ class ResourceGatherOp : public OpKernel {
       const auto indices_flat = op_indices->flat<Index>();
       auto out_flat = out->shaped<T, 3>({1, N, out->NumElements() / N});
 
+      if (deduplicate_indices_ && batch_dims_ == 0 &&
+          std::is_same<Device, CPUDevice>::value) {
+        GatherUnique(c, params_flat, indices.shape(), indices_flat, out_flat);
+        return;
+      }
+
       functor::GatherFunctor<Device, T, Index> functor;
       int64_t bad_i = functor(c, params_flat, indices_flat, out_flat);
 
@@ -838,7 +862,63 @@ class ResourceGatherOp : public OpKernel {
     }
   }
 
+  // Gathers the row of each distinct index once, then copies it to the
+  // outputs of the other occurrences of the index. This reads fewer rows of
+  // a large variable when ids repeat within a batch.
+  void GatherUnique(OpKernelContext* c,
+                    typename TTypes<T, 3>::ConstTensor params,
+                    const TensorShape& indices_shape,
+                    typename TTypes<Index>::ConstFlat indices,
+                    typename TTypes<T, 3>::Tensor out) {
+    const int64_t N = indices.size();
+    Tensor unique_indices;
+    OP_REQUIRES_OK(c, c->allocate_temp(DataTypeToEnum<Index>::v(),
+                                       TensorShape({N}), &unique_indices));
+    auto unique_flat = unique_indices.flat<Index>();
+    // The position of the first occurrence of each index in unique_indices.
+    std::vector<int64_t> positions(N);
+    absl::flat_hash_map<Index, int64_t> position_of;
+    position_of.reserve(N);
+    int64_t num_unique = 0;
+    for (int64_t i = 0; i < N; ++i) {
+      auto it = position_of.try_emplace(indices(i), num_unique).first;
+      if (it->second == num_unique) unique_flat(num_unique++) = indices(i);
+      positions[i] = it->second;
+    }
+
+    const int64_t inner_size = out.dimension(2);
+    Tensor unique_rows;
+    OP_REQUIRES_OK(c, c->allocate_temp(DataTypeToEnum<T>::v(),
+                                       TensorShape({num_unique, inner_size}),
+                                       &unique_rows));
+    auto unique_rows_flat =
+        unique_rows.shaped<T, 3>({1, num_unique, inner_size});
+    functor::GatherFunctor<CPUDevice, T, Index> functor;
+    int64_t bad_i = functor(
+        c, params,
+        typename TTypes<Index>::ConstFlat(unique_flat.data(), num_unique),
+        unique_rows_flat);
+    if (bad_i >= 0) {
+      // Report the first occurrence of the bad index.
+      bad_i = std::find(positions.begin(), positions.end(), bad_i) -
+              positions.begin();
+      OP_REQUIRES(c, false,
+                  errors::InvalidArgument(
+                      "indices", SliceDebugString(indices_shape, bad_i), " = ",
+                      indices(bad_i), " is not in [0, ", params.dimension(1),
+                      ")"));
+    }
+
+    const T* unique_base = unique_rows_flat.data();
+    T* out_base = out.data();
+    for (int64_t i = 0; i < N; ++i) {
+      std::copy_n(unique_base + positions[i] * inner_size, inner_size,
+                  out_base + i * inner_size);
+    }
+  }
+
   int32 batch_dims_ = 0;
+  bool deduplicate_indices_ = false;
 };
 
 #define REGISTER_GATHER_FULL(dev, type, index_type)                    \
@@ -903,8 +983,10 @@ class ResourceGatherNdOp : public OpKernel {
     // of increasing the reference count of v->tensor() to avoid a
     // situation where a write to the same variable will see a
     // reference count greater than one and make a copy of the
-    // (potentially very large) tensor buffer.
-    tf_shared_lock ml(*v->mu());
+    // (potentially very large) tensor buffer. Frozen variables are
+    // never written, so they need no lock.
+    std::optional<tf_shared_lock> ml;
+    if (!v->frozen.load()) ml.emplace(*v->mu());
     const Tensor& params = *v->tensor();
     const Tensor& indices = c->input(1);
 
@@ -1129,10 +1211,12 @@ class ResourceScatterUpdateOp : public OpKernel {
                                   c->input_dtype(0) == DT_VARIANT;
     if (is_non_pod_dtype || use_exclusive_lock_) {
       mutex_lock ml(*v->mu());
+      OP_REQUIRES_OK(c, CheckVariableIsNotFrozen(*v, HandleFromInput(c, 0)));
       DoCompute(c);
     } else {
       // For POD dtypes, we can safely run the update without the mutex.
       tf_shared_lock ml(*v->mu());
+      OP_REQUIRES_OK(c, CheckVariableIsNotFrozen(*v, HandleFromInput(c, 0)));
       DoCompute(c);
     }
   }
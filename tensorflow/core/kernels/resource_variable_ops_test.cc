@@ -0,0 +1,79 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FrozenVariableTest : public OpsTestBase {
+ protected:
+  // Adds a frozen variable in copy-on-read mode as the first input.
+  Var* AddFrozenVariable() {
+    Var* var = new Var(DT_FLOAT);
+    *var->tensor() = test::AsTensor<float>({1, 2, 3});
+    var->is_initialized = true;
+    var->copy_on_read_mode.store(true);
+    // The resource manager owns one reference.
+    var->Ref();
+    AddResourceInput("", "var", var);
+    ResourceMgr* rm = device_->resource_manager();
+    TF_EXPECT_OK(rm->FreezeContainer(rm->default_container()));
+    return var;
+  }
+};
+
+TEST_F(FrozenVariableTest, ReadAliasesVariable) {
+  TF_ASSERT_OK(NodeDefBuilder("op", "ReadVariableOp")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  Var* var = AddFrozenVariable();
+  TF_ASSERT_OK(RunOpKernel());
+  // Without the freeze, the read would copy a variable in copy-on-read mode.
+  EXPECT_EQ(GetOutput(0)->data(), var->tensor()->data());
+  test::ExpectTensorEqual<float>(*GetOutput(0),
+                                 test::AsTensor<float>({1, 2, 3}));
+  var->Unref();
+}
+
+TEST_F(FrozenVariableTest, AssignFails) {
+  TF_ASSERT_OK(NodeDefBuilder("op", "AssignVariableOp")
+                   .Input(FakeInput(DT_RESOURCE))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  Var* var = AddFrozenVariable();
+  AddInputFromArray<float>(TensorShape({3}), {4, 5, 6});
+  EXPECT_TRUE(errors::IsFailedPrecondition(RunOpKernel()));
+  test::ExpectTensorEqual<float>(*var->tensor(),
+                                 test::AsTensor<float>({1, 2, 3}));
+  var->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
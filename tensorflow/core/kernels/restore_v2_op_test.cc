@@ -26,18 +26,26 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/lib/monitoring/test_utils.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
 
+using ::tensorflow::monitoring::testing::CellReader;
+using ::tensorflow::monitoring::testing::Histogram;
+
 // Make an input tensor with filled results.
 template <typename T>
 Tensor MakeInput(const TensorShape& shape,
@@ -356,5 +364,35 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+TEST_F(RestoreV2OpTest, RecordsRestoreMetrics) {
+  constexpr char kTask[] = "/job:a/replica:0/task:0";
+  CellReader<int64_t> bytes("/tensorflow/core/checkpoint/restore/bytes");
+  CellReader<int64_t> time_usecs(
+      "/tensorflow/core/checkpoint/restore/time_usecs");
+  CellReader<Histogram> throughput(
+      "/tensorflow/core/checkpoint/restore/throughput");
+
+  const string prefix = io::JoinPath(testing::TmpDir(), "restore_metrics");
+  const Tensor tensor = MakeInput<float>(
+      TensorShape({16, 16}), [](int x) -> float { return x; });
+  {
+    BundleWriter writer(Env::Default(), prefix);
+    TF_ASSERT_OK(writer.Add("tensor", tensor));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  MakeRestoreOp(DT_FLOAT);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  AddInputFromArray<tstring>(TensorShape({1}), {"tensor"});
+  AddInputFromArray<tstring>(TensorShape({1}), {""});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(*GetOutput(0), tensor);
+
+  EXPECT_EQ(bytes.Delta(kTask), static_cast<int64_t>(tensor.TotalBytes()));
+  const int64_t restore_time_usecs = time_usecs.Delta(kTask);
+  EXPECT_GE(restore_time_usecs, 0);
+  // The throughput is only sampled for restores that took some time.
+  EXPECT_FLOAT_EQ(throughput.Delta(kTask).num(), restore_time_usecs > 0);
+}
+
 }  // namespace
 }  // namespace tensorflow
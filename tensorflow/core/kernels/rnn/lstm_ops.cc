@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/rnn/lstm_ops.h"
 
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -41,32 +42,17 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+// Computes the LSTM cell from `gates`, which must hold xh * w + b.
 template <typename T, GateLayout gate_layout>
-void LSTMBlockCellFpropWithEigen(
-    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
-    const float forget_bias, const float cell_clip, bool use_peephole,
-    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
-    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
-    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
-    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
-    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+void LSTMBlockCellGatesWithEigen(
+    const LSTMBlockCell& cell, const CPUDevice& d, const float forget_bias,
+    const float cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix cs_prev, typename TTypes<T>::ConstVec wci,
+    typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,
+    typename TTypes<T>::Matrix gates, typename TTypes<T>::Matrix i,
     typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
     typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
-    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix gates,
-    typename TTypes<T>::Matrix h) {
-  // Concat xh = [x, h].
-  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
-  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
-
-  // states1 = xh * w + b
-  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
-  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
-      ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), const_xh,
-      w, typename gemm_compute_type<T>::type(0.f), gates);
-  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
-  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
-  gates.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
-
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix h) {
   Eigen::array<Eigen::DenseIndex, 2> p_shape({1, cell.cell_size()});
   Eigen::array<Eigen::DenseIndex, 2> p_broadcast_shape({cell.batch_size(), 1});
 
@@ -126,6 +112,38 @@ void LSTMBlockCellFpropWithEigen(
   h.device(d) = o * co;
 }
 
+template <typename T, GateLayout gate_layout>
+void LSTMBlockCellFpropWithEigen(
+    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
+    const float forget_bias, const float cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
+    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
+    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
+    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
+    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+    typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
+    typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix gates,
+    typename TTypes<T>::Matrix h) {
+  // Concat xh = [x, h].
+  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
+  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
+
+  // states1 = xh * w + b
+  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
+  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+      ctx, d, false, false, typename gemm_compute_type<T>::type(1.f), const_xh,
+      w, typename gemm_compute_type<T>::type(0.f), gates);
+  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
+  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
+  gates.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
+
+  LSTMBlockCellGatesWithEigen<T, gate_layout>(cell, d, forget_bias, cell_clip,
+                                              use_peephole, cs_prev, wci, wcf,
+                                              wco, gates, i, cs, f, o, ci, co,
+                                              h);
+}
+
 template <typename Device, typename T, GateLayout gate_layout>
 void LSTMBlockCellBpropWithEigen(
     const LSTMBlockCell& cell, OpKernelContext* ctx, const Device& d,
@@ -887,6 +905,100 @@ class SliceHelper {
   const Device& device_;
 };
 
+// Runs the first `seq_len_max` time steps of BlockLSTM on CPU. Rather than
+// concatenating [x, h] and multiplying it with all of w at every time step,
+// this computes the input projection x * w[:input_size] + b of all the time
+// steps with one large GEMM up front, so that each time step only multiplies
+// h with the recurrent weights w[input_size:], which stay in cache.
+template <typename T, GateLayout gate_layout>
+void BlockLSTMFpropOnCpu(OpKernelContext* ctx, const float forget_bias,
+                         const float cell_clip, bool use_peephole,
+                         int64_t seq_len_max, const Tensor& x,
+                         const Tensor& cs_prev, const Tensor& h_prev,
+                         const Tensor& w, const Tensor& wci, const Tensor& wcf,
+                         const Tensor& wco, const Tensor& b, Tensor* i_out,
+                         Tensor* cs_out, Tensor* f_out, Tensor* o_out,
+                         Tensor* ci_out, Tensor* co_out, Tensor* h_out) {
+  if (seq_len_max == 0) return;
+  const int64_t batch_size = x.dim_size(1);
+  const int64_t input_size = x.dim_size(2);
+  const int64_t cell_size = cs_prev.dim_size(1);
+  const functor::LSTMBlockCell cell(batch_size, input_size, cell_size);
+  const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+
+  // Slices of the first dimension that start at 0 are always aligned.
+  const Tensor x_seq = x.Slice(0, seq_len_max);
+  const Tensor w_x = w.Slice(0, input_size);
+  Tensor x_gates;
+  OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                          DataTypeToEnum<T>::v(),
+                          TensorShape({seq_len_max, batch_size, cell_size * 4}),
+                          &x_gates));
+  auto x_gates_matrix =
+      x_gates.shaped<T, 2>({seq_len_max * batch_size, cell_size * 4});
+  functor::TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+      ctx, device, false, false, typename gemm_compute_type<T>::type(1.f),
+      x_seq.shaped<T, 2>({seq_len_max * batch_size, input_size}),
+      w_x.matrix<T>(), typename gemm_compute_type<T>::type(0.f),
+      x_gates_matrix);
+  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, cell_size * 4});
+  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape(
+      {seq_len_max * batch_size, 1});
+  x_gates_matrix.device(device) +=
+      b.vec<T>().reshape(b_shape).broadcast(broadcast_shape);
+
+  // The recurrent weights are copied once if they aren't aligned.
+  Tensor w_h_tensor = w.Slice(input_size, input_size + cell_size);
+  if (!w_h_tensor.IsAligned()) {
+    Tensor aligned;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                           w_h_tensor.shape(), &aligned));
+    functor::TensorCopyUnaligned<CPUDevice, T>()(
+        device, w_h_tensor.unaligned_flat<T>(), aligned.flat<T>());
+    w_h_tensor = aligned;
+  }
+  const Tensor& w_h = w_h_tensor;
+
+  Tensor gates_tensor;
+  OP_REQUIRES_OK(ctx,
+                 ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                    TensorShape({batch_size, cell_size * 4}),
+                                    &gates_tensor));
+  auto gates = gates_tensor.matrix<T>();
+
+  SliceHelper<CPUDevice, T> slicer(ctx);
+  for (int64_t t = 0; t < seq_len_max; ++t) {
+    const Tensor x_gates_tensor = slicer.InputSlice(x_gates, t, "x_gates");
+    const Tensor& cs_prev_tensor =
+        t == 0 ? cs_prev : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+    const Tensor& h_prev_tensor =
+        t == 0 ? h_prev : slicer.OutputSlice(h_out, t - 1, "h_prev");
+
+    Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
+    Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
+    Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
+    Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
+    Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
+    Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
+    Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
+
+    // gates = x_gates[t] + h_prev * w_h
+    gates.device(device) = x_gates_tensor.matrix<T>();
+    functor::TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+        ctx, device, false, false, typename gemm_compute_type<T>::type(1.f),
+        h_prev_tensor.matrix<T>(), w_h.matrix<T>(),
+        typename gemm_compute_type<T>::type(1.f), gates);
+    functor::LSTMBlockCellGatesWithEigen<T, gate_layout>(
+        cell, device, forget_bias, cell_clip, use_peephole,
+        cs_prev_tensor.matrix<T>(), wci.vec<T>(), wcf.vec<T>(), wco.vec<T>(),
+        gates, i_tensor.matrix<T>(), cs_tensor.matrix<T>(),
+        f_tensor.matrix<T>(), o_tensor.matrix<T>(), ci_tensor.matrix<T>(),
+        co_tensor.matrix<T>(), h_tensor.matrix<T>());
+
+    slicer.FinishTimeStep();
+  }
+}
+
 }  // namespace
 
 template <typename Device, typename T, bool USE_CUBLAS, GateLayout gate_layout>
@@ -1023,6 +1135,50 @@ class BlockLSTMOp : public OpKernel {
     Tensor* h_out;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("h", batch_cell_shape, &h_out));
 
+    const Device& device = ctx->eigen_device<Device>();
+
+    const int64_t seq_len_max = seq_len_max_tensor->scalar<int64_t>()();
+    OP_REQUIRES(ctx, seq_len_max >= 0 && seq_len_max <= timelen,
+                errors::InvalidArgument("seq_len_max must be in [0, ",
+                                        timelen, "], got ", seq_len_max));
+    if constexpr (std::is_same<Device, CPUDevice>::value) {
+      BlockLSTMFpropOnCpu<T, gate_layout>(
+          ctx, forget_bias_, cell_clip_, use_peephole_, seq_len_max, *x,
+          *cs_prev_tensor, *h_prev_tensor, *w_tensor, *wci_tensor, *wcf_tensor,
+          *wco_tensor, *b_tensor, i_out, cs_out, f_out, o_out, ci_out, co_out,
+          h_out);
+    } else {
+      ComputeTimeSteps(ctx, seq_len_max, *x, *cs_prev_tensor, *h_prev_tensor,
+                       *w_tensor, *wci_tensor, *wcf_tensor, *wco_tensor,
+                       *b_tensor, i_out, cs_out, f_out, o_out, ci_out, co_out,
+                       h_out);
+    }
+    if (!ctx->status().ok()) return;
+
+    if (seq_len_max < timelen) {
+      Tensor cs_tensor = cs_out->Slice(seq_len_max, timelen);
+      Tensor h_tensor = h_out->Slice(seq_len_max, timelen);
+
+      functor::TensorUnalignedZero<Device, T>()(device,
+                                                cs_tensor.unaligned_flat<T>());
+      functor::TensorUnalignedZero<Device, T>()(device,
+                                                h_tensor.unaligned_flat<T>());
+    }
+  }
+
+ private:
+  // Runs the first `seq_len_max` time steps one LSTMBlockCell at a time.
+  void ComputeTimeSteps(OpKernelContext* ctx, int64_t seq_len_max,
+                        const Tensor& x, const Tensor& cs_prev,
+                        const Tensor& h_prev, const Tensor& w,
+                        const Tensor& wci, const Tensor& wcf,
+                        const Tensor& wco, const Tensor& b, Tensor* i_out,
+                        Tensor* cs_out, Tensor* f_out, Tensor* o_out,
+                        Tensor* ci_out, Tensor* co_out, Tensor* h_out) {
+    const int64_t batch_size = x.dim_size(1);
+    const int64_t input_size = x.dim_size(2);
+    const int64_t cell_size = cs_prev.dim_size(1);
+
     Tensor xh_tensor;
     OP_REQUIRES_OK(ctx, ctx->allocate_temp(
                             DataTypeToEnum<T>::v(),
@@ -1036,16 +1192,13 @@ class BlockLSTMOp : public OpKernel {
                                       &gates_tensor));
 
     const Device& device = ctx->eigen_device<Device>();
-
-    const int64_t seq_len_max = seq_len_max_tensor->scalar<int64_t>()();
     SliceHelper<Device, T> slicer(ctx);
     for (int64_t t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
-      const Tensor& cs_prev_tensor2 =
-          t == 0 ? *cs_prev_tensor
-                 : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
-      const Tensor& h_prev_tensor2 =
-          t == 0 ? *h_prev_tensor : slicer.OutputSlice(h_out, t - 1, "h_prev");
+      const Tensor x_tensor = slicer.InputSlice(x, t, "x");
+      const Tensor& cs_prev_tensor =
+          t == 0 ? cs_prev : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+      const Tensor& h_prev_tensor =
+          t == 0 ? h_prev : slicer.OutputSlice(h_out, t - 1, "h_prev");
 
       Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
       Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
@@ -1058,31 +1211,19 @@ class BlockLSTMOp : public OpKernel {
       functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS, gate_layout>(
           batch_size, input_size, cell_size)(
           ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
-          wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+          x_tensor.matrix<T>(), cs_prev_tensor.matrix<T>(),
+          h_prev_tensor.matrix<T>(), w.matrix<T>(), wci.vec<T>(), wcf.vec<T>(),
+          wco.vec<T>(), b.vec<T>(), xh_tensor.matrix<T>(),
+          i_tensor.matrix<T>(), cs_tensor.matrix<T>(), f_tensor.matrix<T>(),
+          o_tensor.matrix<T>(), ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
           gates_tensor.matrix<T>(), h_tensor.matrix<T>());
 
       if (!ctx->status().ok()) return;
 
       slicer.FinishTimeStep();
     }
-
-    if (seq_len_max < timelen) {
-      Tensor cs_tensor = cs_out->Slice(seq_len_max, timelen);
-      Tensor h_tensor = h_out->Slice(seq_len_max, timelen);
-
-      functor::TensorUnalignedZero<Device, T>()(device,
-                                                cs_tensor.unaligned_flat<T>());
-      functor::TensorUnalignedZero<Device, T>()(device,
-                                                h_tensor.unaligned_flat<T>());
-    }
   }
 
- private:
   float forget_bias_;
   float cell_clip_;
   bool use_peephole_;
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -356,6 +357,8 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  // Whether the tensor was already restored with planned reads.
+  bool restored = false;
 
   ::tensorflow::Status status;
 };
@@ -405,11 +408,59 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  const int num_restore_threads =
+      context->session_config() != nullptr &&
+              context->session_config()->intra_op_parallelism_threads() > 0
+          ? context->session_config()->intra_op_parallelism_threads()
+          : 8;
+
+  // With mmap_restored_tensors, the full tensors alias the mapped data files
+  // where possible. See BundleReader::LookupMapped().
+  if (context->session_config() != nullptr &&
+      context->session_config()->experimental().mmap_restored_tensors()) {
+    for (RestoreOp& restore_op : restore_ops) {
+      if (!restore_op.shape_and_slice.empty()) continue;
+      Tensor restored_tensor;
+      TF_RETURN_IF_ERROR(default_reader.LookupMapped(restore_op.tensor_name,
+                                                     &restored_tensor));
+      context->set_output(restore_op.idx, restored_tensor);
+      restore_op.restored = true;
+    }
+  }
+
+  // If TF_RESTORE_PLANNED_READ_SIZE_IN_MB is set, the full tensors are read at
+  // once with planned reads of about that size, straight into the outputs.
+  // Only the slices are then left to restore.
+  int64_t planned_read_size_in_mb = 0;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_PLANNED_READ_SIZE_IN_MB",
+                                         0, &planned_read_size_in_mb));
+  if (planned_read_size_in_mb > 0) {
+    std::vector<string> keys;
+    std::vector<Tensor*> tensors;
+    for (RestoreOp& restore_op : restore_ops) {
+      if (restore_op.restored || !restore_op.shape_and_slice.empty()) continue;
+      TensorShape restored_full_shape;
+      TF_RETURN_IF_ERROR(default_reader.LookupTensorShape(
+          restore_op.tensor_name, &restored_full_shape));
+      Tensor* restored_tensor;
+      TF_RETURN_IF_ERROR(context->allocate_output(
+          restore_op.idx, restored_full_shape, &restored_tensor));
+      keys.push_back(restore_op.tensor_name);
+      tensors.push_back(restored_tensor);
+      restore_op.restored = true;
+    }
+    thread::ThreadPool reader_pool(tsl::Env::Default(), "restore_tensors",
+                                   num_restore_threads);
+    TF_RETURN_IF_ERROR(default_reader.LookupMany(
+        keys, tensors, &reader_pool, planned_read_size_in_mb << 20));
+  }
+
   // Split restore ops into two groups: large and small. We schedule
   // large ops first, to prevent them from waiting on the small op.
   std::vector<RestoreOp*> large_restore_ops;
   std::vector<RestoreOp*> small_restore_ops;
   for (RestoreOp& restore_op : restore_ops) {
+    if (restore_op.restored) continue;
     if (restore_op.is_large_shape(&default_reader)) {
       large_restore_ops.push_back(&restore_op);
     } else {
@@ -422,8 +473,7 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     // If an explicit restore parallelism is specified, we use it to run
     // run both small and large restore ops in parallel.
     auto reader_pool = std::make_unique<thread::ThreadPool>(
-        tsl::Env::Default(), "restore_tensors",
-        context->session_config()->intra_op_parallelism_threads());
+        tsl::Env::Default(), "restore_tensors", num_restore_threads);
 
     // Schedule large ops first, followed by the small.
     for (auto* op : large_restore_ops) {
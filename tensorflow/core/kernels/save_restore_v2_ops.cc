@@ -18,25 +18,36 @@ limitations under the License.
 #include <cstddef>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
 #include "tensorflow/core/kernels/checkpoint_callback_manager.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"  // IWYU pragma: keep
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -93,10 +104,27 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
+//
+// With ConfigProto.Experimental.async_checkpoint_saves, the tensors are copied
+// and written by the AsyncCheckpointWriter, and the op returns right away.
+// Each save first waits for the previous save of the op to be written, which
+// bounds the memory of the copies, and returns its error if it failed.
+//
+// With ConfigProto.Experimental.max_delta_checkpoints, the op keeps a hash of
+// each row of the large tensors it saves. The tensors of the next save with few
+// changed rows are then written as deltas of the previous save.
 class SaveV2 : public OpKernel {
  public:
   explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
 
+  ~SaveV2() override {
+    mutex_lock l(mu_);
+    if (last_async_prefix_.empty()) return;
+    const Status status =
+        checkpoint::AsyncCheckpointWriter::Global()->Wait(last_async_prefix_);
+    if (!status.ok()) LOG(ERROR) << status;
+  }
+
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
     const Tensor& tensor_names = context->input(1);
@@ -111,34 +139,219 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<SaveItem> items(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-      VLOG(2) << "Starting save of " << tensor_name;
-
+      SaveItem& item = items[i];
+      item.name = tensor_names_flat(i);
+      item.tensor = context->input(i + kFixedInputs);
       if (!shape_and_slices_flat(i).empty()) {
         const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
+        item.slice = TensorSlice(item.tensor.dims());
         TensorShape slice_shape;
 
         OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
+                                    shape_spec, &item.shape, &item.slice,
+                                    &slice_shape));
+        OP_REQUIRES(context, slice_shape.IsSameSize(item.tensor.shape()),
                     errors::InvalidArgument("Slice in shape_and_slice "
                                             "specification does not match the "
                                             "shape of the tensor to  save: ",
                                             shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
+                                            item.tensor.shape().DebugString()));
+        item.is_slice = true;
+      }
+    }
 
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
+    core::RefCountPtr<checkpoint::CheckpointCallbackManager>
+        checkpoint_callback_manager;
+    ResourceMgr* resource_manager = context->resource_manager();
+    if (resource_manager != nullptr) {
+      checkpoint::CheckpointCallbackManager* manager;
+      OP_REQUIRES_OK(
+          context,
+          resource_manager
+              ->LookupOrCreate<checkpoint::CheckpointCallbackManager>(
+                  resource_manager->default_container(),
+                  std::string(
+                      checkpoint::kCheckpointCallbackManagerResourceName),
+                  &manager,
+                  [](checkpoint::CheckpointCallbackManager** out) {
+                    *out = new checkpoint::CheckpointCallbackManager();
+                    return absl::OkStatus();
+                  }));
+      checkpoint_callback_manager.reset(manager);
+    }
+
+    const ConfigProto* config = context->session_config();
+    const bool async =
+        config != nullptr && config->experimental().async_checkpoint_saves();
+    const int max_deltas =
+        config != nullptr ? config->experimental().max_delta_checkpoints() : 0;
+    if (!async && max_deltas <= 0) {
+      OP_REQUIRES_OK(context,
+                     WriteBundle(prefix_string, /*base_prefix=*/"", items,
+                                 checkpoint_callback_manager.get()));
+      return;
+    }
+
+    checkpoint::AsyncCheckpointWriter* writer =
+        checkpoint::AsyncCheckpointWriter::Global();
+    mutex_lock l(mu_);
+    if (!last_async_prefix_.empty()) {
+      const Status status = writer->Wait(last_async_prefix_);
+      last_async_prefix_.clear();
+      if (!status.ok()) {
+        // The next save can't be a delta of a save that wasn't written.
+        ResetDeltas();
+        context->SetStatus(status);
+        return;
+      }
+    }
+    string base_prefix;
+    if (max_deltas > 0) {
+      base_prefix = TrackChanges(context, prefix_string, max_deltas, &items);
+    }
+    if (!async) {
+      const Status status = WriteBundle(prefix_string, base_prefix, items,
+                                        checkpoint_callback_manager.get());
+      if (!status.ok()) ResetDeltas();
+      OP_REQUIRES_OK(context, status);
+      return;
+    }
+
+    // The inputs may be updated in place once the op is done, e.g. reference
+    // variables.
+    for (SaveItem& item : items) {
+      item.tensor = tensor::DeepCopy(item.tensor);
+    }
+    // Released by the write.
+    checkpoint::CheckpointCallbackManager* manager =
+        checkpoint_callback_manager.release();
+    writer->Schedule(prefix_string, [prefix_string, base_prefix,
+                                     items = std::move(items), manager]() {
+      core::RefCountPtr<checkpoint::CheckpointCallbackManager> unref(manager);
+      return WriteBundle(prefix_string, base_prefix, items, manager);
+    });
+    last_async_prefix_ = prefix_string;
+  }
+
+ private:
+  struct SaveItem {
+    string name;
+    Tensor tensor;
+    // The full shape and the slice, if the tensor is a slice.
+    bool is_slice = false;
+    TensorShape shape;
+    TensorSlice slice;
+    // The rows that changed since the base, if the tensor is a delta.
+    bool is_delta = false;
+    std::vector<int64_t> changed_rows;
+  };
+
+  struct RowHashes {
+    DataType dtype;
+    TensorShape shape;
+    std::vector<uint64> hashes;
+  };
+
+  // Smaller tensors are always written in full.
+  static constexpr int64_t kMinDeltaBytes = 1 << 20;
+
+  // Hashes the rows of the tensors of `items` that are large enough, and turns
+  // those with at most half of their rows changed since the last save into
+  // deltas, unless the save is to be written in full. Returns the base prefix
+  // of the deltas, or an empty string for a full save.
+  string TrackChanges(OpKernelContext* context, const string& prefix,
+                      int max_deltas, std::vector<SaveItem>* items)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const bool full_save = last_prefix_.empty() || last_prefix_ == prefix ||
+                           num_deltas_ >= max_deltas;
+    absl::flat_hash_map<string, RowHashes> row_hashes;
+    for (SaveItem& item : *items) {
+      const Tensor& tensor = item.tensor;
+      if (item.is_slice || tensor.dims() == 0 ||
+          !DataTypeCanUseMemcpy(tensor.dtype()) ||
+          tensor.TotalBytes() < kMinDeltaBytes) {
+        continue;
+      }
+      RowHashes& hashes = row_hashes[item.name];
+      hashes.dtype = tensor.dtype();
+      hashes.shape = tensor.shape();
+      HashRows(context, tensor, &hashes.hashes);
+      if (full_save) continue;
+      const auto it = row_hashes_.find(item.name);
+      if (it == row_hashes_.end() || it->second.dtype != hashes.dtype ||
+          it->second.shape != hashes.shape) {
+        continue;
+      }
+      const std::vector<uint64>& last_hashes = it->second.hashes;
+      for (int64_t row = 0; row < last_hashes.size(); ++row) {
+        if (hashes.hashes[row] != last_hashes[row]) {
+          item.changed_rows.push_back(row);
+        }
+      }
+      if (item.changed_rows.size() * 2 > last_hashes.size()) {
+        item.changed_rows.clear();
+        continue;
+      }
+      item.is_delta = true;
+    }
+    row_hashes_ = std::move(row_hashes);
+    string base_prefix = full_save ? "" : last_prefix_;
+    num_deltas_ = full_save ? 0 : num_deltas_ + 1;
+    last_prefix_ = prefix;
+    return base_prefix;
+  }
+
+  void ResetDeltas() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    row_hashes_.clear();
+    last_prefix_.clear();
+    num_deltas_ = 0;
+  }
+
+  static void HashRows(OpKernelContext* context, const Tensor& tensor,
+                       std::vector<uint64>* hashes) {
+    const int64_t num_rows = tensor.dim_size(0);
+    hashes->resize(num_rows);
+    if (num_rows == 0) return;
+    const int64_t row_bytes = tensor.TotalBytes() / num_rows;
+    const char* data = tensor.tensor_data().data();
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          row_bytes, [&](int64_t start, int64_t limit) {
+            for (int64_t row = start; row < limit; ++row) {
+              (*hashes)[row] = Hash64(data + row * row_bytes, row_bytes);
+            }
+          });
+  }
+
+  // Writes `items` to the bundle at `prefix`, a delta of the bundle at
+  // `base_prefix` if not empty, and triggers the save callbacks of
+  // `checkpoint_callback_manager`, if not null.
+  static Status WriteBundle(
+      const string& prefix, const string& base_prefix,
+      const std::vector<SaveItem>& items,
+      checkpoint::CheckpointCallbackManager* checkpoint_callback_manager) {
+    BundleWriter::Options options;
+    options.base_prefix = base_prefix;
+    BundleWriter writer(Env::Default(), prefix, options);
+    TF_RETURN_IF_ERROR(writer.status());
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+    for (const SaveItem& item : items) {
+      const Tensor& tensor = item.tensor;
+      VLOG(2) << "Starting save of " << item.name;
+      if (item.is_slice) {
+        TF_RETURN_IF_ERROR(
+            writer.AddSlice(item.name, item.shape, item.slice, tensor));
+      } else if (item.is_delta) {
+        VLOG(2) << "Saving " << item.changed_rows.size() << " changed rows of "
+                << tensor.dim_size(0);
+        TF_RETURN_IF_ERROR(
+            writer.AddDelta(item.name, tensor, item.changed_rows));
       } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+        TF_RETURN_IF_ERROR(writer.Add(item.name, tensor));
       }
 
       if (VLOG_IS_ON(5)) {
@@ -158,30 +371,25 @@ class SaveV2 : public OpKernel {
         }
       }
 
-      VLOG(2) << "Done save of " << tensor_name;
+      VLOG(2) << "Done save of " << item.name;
     }
-    OP_REQUIRES_OK(context, writer.Finish());
-    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
+    TF_RETURN_IF_ERROR(writer.Finish());
+    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix;
 
-    ResourceMgr* resource_manager = context->resource_manager();
-    if (resource_manager != nullptr) {
-      checkpoint::CheckpointCallbackManager* checkpoint_callback_manager;
-      OP_REQUIRES_OK(
-          context,
-          resource_manager
-              ->LookupOrCreate<checkpoint::CheckpointCallbackManager>(
-                  resource_manager->default_container(),
-                  std::string(
-                      checkpoint::kCheckpointCallbackManagerResourceName),
-                  &checkpoint_callback_manager,
-                  [](checkpoint::CheckpointCallbackManager** out) {
-                    *out = new checkpoint::CheckpointCallbackManager();
-                    return absl::OkStatus();
-                  }));
-      checkpoint_callback_manager->Save(prefix_string);
-      checkpoint_callback_manager->Unref();
+    if (checkpoint_callback_manager != nullptr) {
+      checkpoint_callback_manager->Save(prefix);
     }
+    return absl::OkStatus();
   }
+
+  mutex mu_;
+  // The prefix of the last asynchronous save, if any.
+  string last_async_prefix_ TF_GUARDED_BY(mu_);
+  // The row hashes of the large tensors of the last save, its prefix, and the
+  // number of deltas since the last full save.
+  absl::flat_hash_map<string, RowHashes> row_hashes_ TF_GUARDED_BY(mu_);
+  string last_prefix_ TF_GUARDED_BY(mu_);
+  int num_deltas_ TF_GUARDED_BY(mu_) = 0;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -205,13 +413,17 @@ class RestoreV2 : public OpKernel {
     if (!context->status().ok()) return;
 
     const string& prefix_string = prefix.scalar<tstring>()();
+    // The checkpoint may still be being written by an asynchronous save.
+    OP_REQUIRES_OK(context, checkpoint::AsyncCheckpointWriter::Global()->Wait(
+                                prefix_string));
 
     VLOG(2) << "Started Restore at prefix: " << prefix_string;
+    Env* env = Env::Default();
+    const uint64 start_micros = env->NowMicros();
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
     // We here attempt to read a V1 checkpoint, if "prefix_string" does not
     // refer to a V2 checkpoint.
-    Env* env = Env::Default();
     std::vector<string> paths;
     if (!env->GetMatchingPaths(MetaFilename(prefix_string), &paths).ok() ||
         paths.empty()) {
@@ -231,6 +443,7 @@ class RestoreV2 : public OpKernel {
     // If found, invokes the V2 reader.
     OP_REQUIRES_OK(context, RestoreTensorsV2(context, prefix, tensor_names,
                                              shape_and_slices, dtypes_));
+    RecordRestore(context, env->NowMicros() - start_micros);
 
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
@@ -254,12 +467,35 @@ class RestoreV2 : public OpKernel {
   }
 
  private:
+  // Records the throughput of the restore for the task of the op. The restores
+  // of the tasks of a sharded checkpoint run in parallel, so the slowest task
+  // bounds the restore time.
+  void RecordRestore(OpKernelContext* context, uint64 duration_usecs) {
+    int64_t num_bytes = 0;
+    for (int i = 0; i < context->num_outputs(); ++i) {
+      num_bytes += context->mutable_output(i)->TotalBytes();
+    }
+    DeviceNameUtils::ParsedName device;
+    string task;
+    if (!DeviceNameUtils::ParseFullName(context->device()->name(), &device) ||
+        !DeviceNameUtils::GetTaskName(device, &task)) {
+      task = "localhost";
+    }
+    VLOG(1) << "Restored " << num_bytes << " bytes in " << duration_usecs
+            << " us on " << task;
+    metrics::RecordCheckpointRestore(task, num_bytes, duration_usecs);
+  }
+
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
 // The final step in saving sharded V2 checkpoints: merges metadata files.
+//
+// With ConfigProto.Experimental.async_checkpoint_saves, the merge is written by
+// the AsyncCheckpointWriter after the asynchronous saves of the inputs, and
+// fails if any of them failed.
 class MergeV2Checkpoints : public OpKernel {
  public:
   explicit MergeV2Checkpoints(OpKernelConstruction* context)
@@ -270,6 +506,14 @@ class MergeV2Checkpoints : public OpKernel {
                                              &allow_missing_files_));
   }
 
+  ~MergeV2Checkpoints() override {
+    mutex_lock l(mu_);
+    if (last_async_prefix_.empty()) return;
+    const Status status =
+        checkpoint::AsyncCheckpointWriter::Global()->Wait(last_async_prefix_);
+    if (!status.ok()) LOG(ERROR) << status;
+  }
+
   void Compute(OpKernelContext* context) override {
     const Tensor& checkpoint_prefixes = context->input(0);
     const Tensor& destination_prefix = context->input(1);
@@ -285,11 +529,64 @@ class MergeV2Checkpoints : public OpKernel {
 
     const absl::Span<const tstring> input_prefixes =
         absl::Span<const tstring>(checkpoint_prefixes.flat<tstring>());
-    Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<tstring>()();
-    OP_REQUIRES_OK(context,
-                   tensorflow::MergeBundles(env, input_prefixes, merged_prefix,
-                                            allow_missing_files_));
+    checkpoint::AsyncCheckpointWriter* writer =
+        checkpoint::AsyncCheckpointWriter::Global();
+    if (context->session_config() == nullptr ||
+        !context->session_config()->experimental().async_checkpoint_saves()) {
+      for (const string& input_prefix : input_prefixes) {
+        OP_REQUIRES_OK(context, writer->Wait(input_prefix));
+      }
+      mutex_lock l(mu_);
+      const Status status =
+          Merge(std::vector<tstring>(input_prefixes.begin(),
+                                     input_prefixes.end()),
+                merged_prefix, BasePrefix(merged_prefix));
+      last_merged_prefix_ = status.ok() ? merged_prefix : "";
+      OP_REQUIRES_OK(context, status);
+      return;
+    }
+
+    mutex_lock l(mu_);
+    if (!last_async_prefix_.empty()) {
+      const Status status = writer->Wait(last_async_prefix_);
+      last_async_prefix_.clear();
+      if (!status.ok()) {
+        last_merged_prefix_.clear();
+        context->SetStatus(status);
+        return;
+      }
+    }
+    // Runs after the saves of the inputs, which were scheduled before.
+    writer->Schedule(
+        merged_prefix,
+        [this, writer, merged_prefix, base_prefix = BasePrefix(merged_prefix),
+         input_prefixes = std::vector<tstring>(input_prefixes.begin(),
+                                               input_prefixes.end())]() {
+          for (const string& input_prefix : input_prefixes) {
+            TF_RETURN_IF_ERROR(writer->TakeStatus(input_prefix));
+          }
+          return Merge(input_prefixes, merged_prefix, base_prefix);
+        });
+    last_async_prefix_ = merged_prefix;
+    last_merged_prefix_ = merged_prefix;
+  }
+
+ private:
+  // The shards of a checkpoint written with
+  // ConfigProto.Experimental.max_delta_checkpoints may be deltas of the shards
+  // of the previous one: the merged checkpoint is then a delta of the previous
+  // merged one.
+  string BasePrefix(const string& merged_prefix) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return last_merged_prefix_ == merged_prefix ? "" : last_merged_prefix_;
+  }
+
+  Status Merge(const std::vector<tstring>& input_prefixes,
+               const string& merged_prefix, const string& base_prefix) const {
+    Env* env = Env::Default();
+    TF_RETURN_IF_ERROR(tensorflow::MergeBundles(
+        env, input_prefixes, merged_prefix, allow_missing_files_, base_prefix));
 
     if (delete_old_dirs_) {
       const string merged_dir(io::Dirname(merged_prefix));
@@ -302,9 +599,15 @@ class MergeV2Checkpoints : public OpKernel {
         if (!status.ok()) VLOG(1) << status;
       }
     }
+    return absl::OkStatus();
   }
 
- private:
+  mutex mu_;
+  // The destination prefix of the last asynchronous merge, if any.
+  string last_async_prefix_ TF_GUARDED_BY(mu_);
+  // The destination prefix of the last merge, unless it failed.
+  string last_merged_prefix_ TF_GUARDED_BY(mu_);
+
   // On merge, whether or not to delete the input (temporary) directories.
   bool delete_old_dirs_;
 
@@ -18,7 +18,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 #define TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include "tensorflow/core/framework/op_requires.h"
 #include "tensorflow/core/platform/types.h"
@@ -43,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -77,6 +80,19 @@ Status ValidateSparseSegmentReduction(OpKernelContext* context,
                                       const Tensor& indices,
                                       const Tensor& segment_ids,
                                       bool has_num_segments);
+
+// The reducer of the pieces of a segment that is split between threads, and
+// of those pieces: means are summed, and divided once the pieces are combined.
+template <typename Reducer>
+struct SegmentPieceReducer {
+  using type = Reducer;
+  static constexpr bool kIsMean = false;
+};
+template <typename T>
+struct SegmentPieceReducer<Eigen::internal::MeanReducer<T>> {
+  using type = Eigen::internal::SumReducer<T>;
+  static constexpr bool kIsMean = true;
+};
 }  // namespace internal
 
 // This operator handles reducing segments along the first dimension.
@@ -126,6 +142,19 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_partitions = std::min<int64_t>(
+        {worker_threads.num_threads, num_indices,
+         num_indices * num_col / kMinElementsPerPartition});
+    if (num_partitions > 1) {
+      OP_REQUIRES_OK(context,
+                     ValidateSegmentIds(segment_vec, num_indices, output_rows));
+      ComputePartitioned(worker_threads, input_flat, segment_vec,
+                         num_partitions, output_flat);
+      return;
+    }
+
     Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
     Index start = 0, end = 1;
 
@@ -202,6 +231,160 @@ class SegmentReductionOp : public OpKernel {
       out_index = next_index;
     }
   }
+
+ private:
+  using PieceReducer = internal::SegmentPieceReducer<Reducer>;
+  using ConstRows = Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+                                     Eigen::Unaligned>;
+  using Row =
+      Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>, Eigen::Unaligned>;
+
+  // The number of input elements below which a thread of its own does not pay
+  // off.
+  static constexpr int64_t kMinElementsPerPartition = 1 << 15;
+
+  // Returns the error that the sequential implementation reports, if any. Since
+  // the last segment id is the last output row, only the first one can be out
+  // of range once they are increasing.
+  static Status ValidateSegmentIds(
+      const typename TTypes<Index>::ConstVec& segment_vec,
+      const int64_t num_indices, const Index output_rows) {
+    const auto check_bounds = [output_rows](const Index out_index) -> Status {
+      if (!FastBoundsCheck(out_index, output_rows)) {
+        return errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), possibly because 'segment_ids' input is not sorted.");
+      }
+      return OkStatus();
+    };
+    Index out_index = internal::SubtleMustCopy(segment_vec(0));
+    bool first_segment = true;
+    for (int64_t i = 1; i < num_indices; ++i) {
+      const Index next_index = internal::SubtleMustCopy(segment_vec(i));
+      if (next_index == out_index) continue;
+      if (!(out_index < next_index)) {
+        return errors::InvalidArgument("segment ids are not increasing");
+      }
+      if (first_segment) TF_RETURN_IF_ERROR(check_bounds(out_index));
+      first_segment = false;
+      out_index = next_index;
+    }
+    return first_segment ? check_bounds(out_index) : OkStatus();
+  }
+
+  // Reduces the input rows [start, end) into `out`.
+  template <typename R>
+  static void ReduceRows(const typename TTypes<T, 2>::ConstTensor& input_flat,
+                         const int64_t start, const int64_t end, T* out) {
+    const int64_t num_col = input_flat.dimension(1);
+    Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
+    Row out_row(out, num_col);
+    out_row = ConstRows(&input_flat(start, 0), end - start, num_col)
+                  .reduce(dims_to_reduce, R());
+  }
+
+  // Splits the input in partitions of as many rows, reduced by a thread each,
+  // so that long segments do not hold up a single thread. A segment that
+  // crosses the boundary of a partition is reduced in pieces, one per
+  // partition, which are then combined.
+  static void ComputePartitioned(
+      const DeviceBase::CpuWorkerThreads& worker_threads,
+      const typename TTypes<T, 2>::ConstTensor& input_flat,
+      const typename TTypes<Index>::ConstVec& segment_vec,
+      const int64_t num_partitions, typename TTypes<T, 2>::Tensor output_flat) {
+    const int64_t num_indices = segment_vec.size();
+    const int64_t num_col = input_flat.dimension(1);
+    const Index output_rows = output_flat.dimension(0);
+    const auto partition_start = [&](int64_t p) {
+      return p * num_indices / num_partitions;
+    };
+    // The first and last runs of every partition may be pieces of a split
+    // segment, of which the segment id and row count are recorded here.
+    struct Piece {
+      Index segment = 0;
+      int64_t count = 0;
+    };
+    std::vector<Piece> pieces(2 * num_partitions);
+    Tensor piece_rows_tensor(DataTypeToEnum<T>::value,
+                             TensorShape({2 * num_partitions, num_col}));
+    auto piece_rows = piece_rows_tensor.matrix<T>();
+
+    const auto reduce_partition = [&](int64_t p) {
+      const int64_t begin = partition_start(p);
+      const int64_t end = partition_start(p + 1);
+      // The output row from which the output is not set by this partition.
+      Index uninitialized_index =
+          p == 0 ? 0 : internal::SubtleMustCopy(segment_vec(begin - 1)) + 1;
+      for (int64_t start = begin; start < end;) {
+        const Index out_index = internal::SubtleMustCopy(segment_vec(start));
+        int64_t run_end = start + 1;
+        while (run_end < end && segment_vec(run_end) == out_index) ++run_end;
+        // The segment ids were validated, but may be changed concurrently.
+        if (!FastBoundsCheck(out_index, output_rows)) return;
+        if (out_index > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              out_index - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(T(default_value));
+        }
+        const bool continues_before =
+            start == begin && p > 0 && segment_vec(begin - 1) == out_index;
+        const bool continues_after = run_end == end && end < num_indices &&
+                                     segment_vec(end) == out_index;
+        if (continues_before || continues_after) {
+          const int64_t slot = 2 * p + (start == begin ? 0 : 1);
+          pieces[slot] = {out_index, run_end - start};
+          ReduceRows<typename PieceReducer::type>(input_flat, start, run_end,
+                                                  &piece_rows(slot, 0));
+        } else {
+          ReduceRows<Reducer>(input_flat, start, run_end,
+                              &output_flat(out_index, 0));
+        }
+        uninitialized_index = std::max(uninitialized_index, out_index + 1);
+        start = run_end;
+      }
+    };
+    const double row_cost = num_col * Eigen::TensorOpCost::AddCost<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          static_cast<int64_t>(row_cost * num_indices / num_partitions),
+          [&](int64_t start, int64_t limit) {
+            for (int64_t p = start; p < limit; ++p) reduce_partition(p);
+          });
+
+    // Combines the pieces of every split segment, which come in a row.
+    Eigen::IndexList<Eigen::type2index<0> > dims_to_reduce;
+    std::vector<int64_t> group;
+    for (int64_t i = 0; i < 2 * num_partitions;) {
+      if (pieces[i].count == 0) {
+        ++i;
+        continue;
+      }
+      const Index segment = pieces[i].segment;
+      int64_t count = 0;
+      group.clear();
+      for (; i < 2 * num_partitions; ++i) {
+        if (pieces[i].count == 0) continue;
+        if (pieces[i].segment != segment) break;
+        group.push_back(i);
+        count += pieces[i].count;
+      }
+      const int64_t group_size = group.size();
+      Tensor group_tensor(DataTypeToEnum<T>::value,
+                          TensorShape({group_size, num_col}));
+      auto group_rows = group_tensor.matrix<T>();
+      for (int64_t g = 0; g < group_size; ++g) {
+        group_rows.template chip<0>(g) = piece_rows.template chip<0>(group[g]);
+      }
+      Row out_row(&output_flat(segment, 0), num_col);
+      out_row = ConstRows(group_rows.data(), group_size, num_col)
+                    .reduce(dims_to_reduce, typename PieceReducer::type());
+      if (PieceReducer::kIsMean) {
+        out_row = out_row / out_row.constant(T(count));
+      }
+    }
+  }
 };
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -155,10 +155,11 @@ class CSRMatMulOp : public OpKernel {
 
 // CPU Kernel to compute sparse-dense matrix multiplication.
 //
-// Uses Eigen SparseMatrix to compute the sparse-dense multiplication between
-// a CSR SparseMatrix `a` and dense Tensor `b`. If intra-op parallelism is
-// available, the implementation parallelizes the computation across each row
-// of the sparse matrix.
+// Computes the sparse-dense multiplication between a CSR SparseMatrix `a` and
+// dense Tensor `b`, by accumulating rows of `b` or with Eigen SparseMatrix if
+// `a` is transposed. If intra-op parallelism is available, the implementation
+// parallelizes the computation across the rows of the sparse matrix, in
+// shards with about the same number of nonzeros.
 template <typename T>
 class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
   using SparseMatrix = Eigen::SparseMatrix<T, Eigen::RowMajor>;
@@ -291,54 +292,114 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
         csr_matrix.values_vec<T>(batch_index).data() + row_offset);
   }
 
+  // Returns the boundaries of `num_shards` contiguous ranges of
+  // [0, batch_size * num_rows), the rows of all the batches of `csr_matrix`,
+  // such that the rows of each range have about as many nonzeros in total.
+  // A row also costs one, for writing it. Rows of very different lengths,
+  // e.g. the adjacency matrices of power-law graphs, then don't leave a few
+  // shards with most of the work, as splitting by number of rows would.
+  std::vector<int64_t> NnzBalancedRowBoundaries(
+      const CSRSparseMatrix& csr_matrix, const int64_t batch_size,
+      const int64_t num_rows, const int64_t num_shards) {
+    // The cost of the rows before each batch.
+    std::vector<int64_t> batch_costs(batch_size + 1, 0);
+    for (int64_t batch_idx = 0; batch_idx < batch_size; ++batch_idx) {
+      batch_costs[batch_idx + 1] =
+          batch_costs[batch_idx] +
+          csr_matrix.row_pointers_vec(batch_idx)(num_rows) + num_rows;
+    }
+    const int64_t total_cost = batch_costs[batch_size];
+    std::vector<int64_t> boundaries = {0};
+    int64_t batch_idx = 0;
+    for (int64_t shard = 1; shard < num_shards; ++shard) {
+      const int64_t cost = total_cost * shard / num_shards;
+      while (batch_costs[batch_idx + 1] <= cost) ++batch_idx;
+      // The first row of the batch at which the cost of the rows before it
+      // reaches `cost`.
+      const auto row_ptrs = csr_matrix.row_pointers_vec(batch_idx);
+      const int64_t batch_cost = cost - batch_costs[batch_idx];
+      int64_t low = 0;
+      int64_t high = num_rows;
+      while (low < high) {
+        const int64_t mid = low + (high - low) / 2;
+        if (row_ptrs(mid) + mid < batch_cost) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      boundaries.push_back(
+          std::max(boundaries.back(), batch_idx * num_rows + low));
+    }
+    boundaries.push_back(batch_size * num_rows);
+    return boundaries;
+  }
+
+  // Returns the number of shards of a product whose sparse operand has
+  // `num_rows` rows per batch, which is zero if it has no rows.
+  int64_t NumShards(const int32_t num_threads, const int64_t batch_size,
+                    const int64_t num_rows) {
+    return std::min<int64_t>(
+        batch_size * num_rows,
+        std::max(kMaxShards, kNumShardsPerThread * num_threads));
+  }
+
   // Sparse-Dense Matrix Multiplication between a CSRSparseMatrix (LHS) and a
   // dense Tensor (RHS).
+  //
+  // Each row of the output is the sum of the rows of the RHS selected by the
+  // nonzeros of the corresponding row of the LHS, scaled by their values. The
+  // rows are accumulated as Eigen arrays, so the adds are vectorized across
+  // the columns of the RHS.
   void SparseDenseMatMulWithoutTransposedLHS(OpKernelContext* ctx,
                                              const int64_t batch_size,
                                              const int64_t num_lhs_rows,
                                              const CSRSparseMatrix& lhs,
                                              const Tensor& rhs,
                                              Tensor* output) {
+    using Row = Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>>;
+    using ConstRow = Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>;
     // Parallelize matrix multiplication across batch dimensions and across
-    // rows in each batch.
+    // rows in each batch, in shards of about the same number of nonzeros.
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
-    const int32_t num_threads = worker_threads.num_threads;
-    const int64_t block_size =
-        num_lhs_rows / std::max(kMaxShards, kNumShardsPerThread * num_threads);
+    const int64_t num_shards =
+        NumShards(worker_threads.num_threads, batch_size, num_lhs_rows);
+    const std::vector<int64_t> boundaries =
+        NnzBalancedRowBoundaries(lhs, batch_size, num_lhs_rows, num_shards);
     const int64_t num_rhs_rows = rhs.dim_size(rhs.dims() - 2);
     const int64_t num_rhs_cols = rhs.dim_size(rhs.dims() - 1);
     worker_threads.workers->ParallelFor(
-        batch_size * num_lhs_rows /* total */,
+        num_shards /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64_t batch_and_row_begin, int64_t batch_and_row_end) {
-          HandleBatchAndRowRange(
-              num_lhs_rows, batch_and_row_begin, batch_and_row_end,
-              [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
-                const int64_t num_shard_rows = row_end - row_begin;
-
-                // Define an Eigen::SparseMatrix over the row range:
-                // [row_begin, row_end) of the CSR SparseMatrix A.
-                std::vector<int32> row_ptrs;
-                auto sparse_matrix = GetSparseMatrixRef(
-                    lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
-
-                // Map the corresponding rows of the rhs.
-                ConstMatrixMap rhs_map(rhs.flat<T>().data() + batch_idx *
-                                                                  num_rhs_rows *
-                                                                  num_rhs_cols,
-                                       num_rhs_rows, num_rhs_cols);
-
-                // Write to the corresponding rows of the output matrix.
-                MatrixMap output_map(
-                    output->flat<T>().data() +
-                        batch_idx * num_lhs_rows * num_rhs_cols +
-                        row_begin * num_rhs_cols,
-                    num_shard_rows, num_rhs_cols);
-                output_map.noalias() = sparse_matrix * rhs_map;
-              });
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64_t shard_begin, int64_t shard_end) {
+          for (int64_t shard = shard_begin; shard < shard_end; ++shard) {
+            HandleBatchAndRowRange(
+                num_lhs_rows, boundaries[shard], boundaries[shard + 1],
+                [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
+                  const auto row_ptrs = lhs.row_pointers_vec(batch_idx);
+                  const auto col_indices = lhs.col_indices_vec(batch_idx);
+                  const auto values = lhs.values_vec<T>(batch_idx);
+                  const T* rhs_data = rhs.flat<T>().data() +
+                                      batch_idx * num_rhs_rows * num_rhs_cols;
+                  T* output_data = output->flat<T>().data() +
+                                   batch_idx * num_lhs_rows * num_rhs_cols;
+                  for (int64_t row = row_begin; row < row_end; ++row) {
+                    Row output_row(output_data + row * num_rhs_cols,
+                                   num_rhs_cols);
+                    output_row.setZero();
+                    for (int64_t i = row_ptrs(row); i < row_ptrs(row + 1);
+                         ++i) {
+                      output_row +=
+                          values(i) *
+                          ConstRow(rhs_data + col_indices(i) * num_rhs_cols,
+                                   num_rhs_cols);
+                    }
+                  }
+                });
+          }
         });
   }
 
@@ -375,52 +436,56 @@ class CSRMatMulCPUOp : public CSRMatMulOp<CPUDevice, T> {
     set_zero(device, matmul_result_buffer.flat<T>());
 
     // Parallelize matrix multiplication across batch dimensions and across
-    // columns of A^T in each batch. These correspond to rows of A.
-    const int64_t block_size =
-        num_lhs_cols / std::max(kMaxShards, kNumShardsPerThread * num_threads);
+    // columns of A^T in each batch, in shards of about the same number of
+    // nonzeros. These correspond to rows of A.
+    const int64_t num_shards = NumShards(num_threads, batch_size, num_lhs_cols);
+    const std::vector<int64_t> boundaries =
+        NnzBalancedRowBoundaries(lhs, batch_size, num_lhs_cols, num_shards);
     worker_threads.workers->ParallelForWithWorkerId(
-        batch_size * num_lhs_cols /* total */,
+        num_shards /* total */,
         thread::ThreadPool::SchedulingParams(
             thread::ThreadPool::SchedulingStrategy::
                 kFixedBlockSize /* strategy */,
-            absl::nullopt /* cost_per_unit */, block_size),
-        [&](int64_t batch_and_row_begin, int64_t batch_and_row_end, int tid) {
-          HandleBatchAndRowRange(
-              num_lhs_cols, batch_and_row_begin, batch_and_row_end,
-              [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
-                const int64_t num_shard_rows = row_end - row_begin;
-
-                // Define a new sparse sub-matrix from the row range
-                // [row_begin, row_end) of the sparse matrix A.
-                std::vector<int32> row_ptrs;
-                auto sparse_matrix = GetSparseMatrixRef(
-                    lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
-
-                // Map the corresponding `num_shard_rows` columns of B^T.
-                // This is the same as taking the `num_shard_rows` rows of B.
-                ConstMatrixMap b_dense_map(
-                    rhs.flat<T>().data() +
-                        batch_idx * num_rhs_rows * num_rhs_cols +
-                        row_begin * num_rhs_cols,
-                    num_shard_rows, num_rhs_cols);
-
-                // Map to the corresponding rows of the output.
-                MatrixMap output_map(
-                    matmul_result_buffer.flat<T>().data() +
-                        tid * batch_size * num_lhs_rows * num_rhs_cols +
-                        batch_idx * num_lhs_rows * num_rhs_cols,
-                    num_lhs_rows, num_rhs_cols);
-
-                // Compute the product C^T = B^T * A; restricted to the row
-                // range in the current shard.
-                if (this->conjugate_a_) {
-                  output_map.transpose().noalias() +=
-                      b_dense_map.transpose() * sparse_matrix.conjugate();
-                } else {
-                  output_map.transpose().noalias() +=
-                      b_dense_map.transpose() * sparse_matrix;
-                }
-              });
+            absl::nullopt /* cost_per_unit */, 1 /* block_size */),
+        [&](int64_t shard_begin, int64_t shard_end, int tid) {
+          for (int64_t shard = shard_begin; shard < shard_end; ++shard) {
+            HandleBatchAndRowRange(
+                num_lhs_cols, boundaries[shard], boundaries[shard + 1],
+                [&](int64_t batch_idx, int64_t row_begin, int64_t row_end) {
+                  const int64_t num_shard_rows = row_end - row_begin;
+
+                  // Define a new sparse sub-matrix from the row range
+                  // [row_begin, row_end) of the sparse matrix A.
+                  std::vector<int32> row_ptrs;
+                  auto sparse_matrix = GetSparseMatrixRef(
+                      lhs, batch_idx, row_begin, num_shard_rows, &row_ptrs);
+
+                  // Map the corresponding `num_shard_rows` columns of B^T.
+                  // This is the same as taking the `num_shard_rows` rows of B.
+                  ConstMatrixMap b_dense_map(
+                      rhs.flat<T>().data() +
+                          batch_idx * num_rhs_rows * num_rhs_cols +
+                          row_begin * num_rhs_cols,
+                      num_shard_rows, num_rhs_cols);
+
+                  // Map to the corresponding rows of the output.
+                  MatrixMap output_map(
+                      matmul_result_buffer.flat<T>().data() +
+                          tid * batch_size * num_lhs_rows * num_rhs_cols +
+                          batch_idx * num_lhs_rows * num_rhs_cols,
+                      num_lhs_rows, num_rhs_cols);
+
+                  // Compute the product C^T = B^T * A; restricted to the row
+                  // range in the current shard.
+                  if (this->conjugate_a_) {
+                    output_map.transpose().noalias() +=
+                        b_dense_map.transpose() * sparse_matrix.conjugate();
+                  } else {
+                    output_map.transpose().noalias() +=
+                        b_dense_map.transpose() * sparse_matrix;
+                  }
+                });
+          }
         });
 
     // Sum across each thread's matmul result.
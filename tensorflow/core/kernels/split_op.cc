@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/concat_lib.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -244,6 +245,25 @@ class SplitOpCPU : public SplitOpBase<CPUDevice, T> {
           context, input_reshaped, input_shape, split_dim, prefix_dim_size,
           split_dim_size, suffix_dim_size, make_sizes, reshape_result,
           num_split, split_dim_output_size);
+    } else if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v()) &&
+               prefix_dim_size >= context->device()
+                                      ->tensorflow_cpu_worker_threads()
+                                      ->num_threads) {
+      // Copies each row of the input to all the outputs, rather than going
+      // over the input once per output.
+      TensorShape output_shape(input_shape);
+      output_shape.set_dim(split_dim, split_dim_output_size);
+      std::vector<char*> outputs(num_split);
+      for (int i = 0; i < num_split; ++i) {
+        Tensor* result = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(i, output_shape, &result));
+        outputs[i] = const_cast<char*>(result->tensor_data().data());
+      }
+      const std::vector<int64_t> output_row_bytes(
+          num_split, split_dim_output_size * suffix_dim_size * sizeof(T));
+      SplitCPU(context->device(), input.tensor_data().data(), prefix_dim_size,
+               outputs, output_row_bytes);
     } else {
       auto input_reshaped = input.shaped<T, 3>(
           {prefix_dim_size, split_dim_size, suffix_dim_size});
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/concat_lib.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -349,6 +350,25 @@ class SplitVOpCPU : public SplitVOpBase<CPUDevice, T, Tlen> {
           context, input_reshaped, split_start_points, input_shape, split_dim,
           prefix_dim_size, split_dim_size, suffix_dim_size, split_sizes_vec,
           make_sizes, reshape_result);
+    } else if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v()) &&
+               prefix_dim_size >= context->device()
+                                      ->tensorflow_cpu_worker_threads()
+                                      ->num_threads) {
+      // Copies each row of the input to all the outputs, rather than going
+      // over the input once per output.
+      std::vector<char*> outputs(num_split);
+      std::vector<int64_t> output_row_bytes(num_split);
+      for (int i = 0; i < num_split; ++i) {
+        TensorShape output_shape(input_shape);
+        output_shape.set_dim(split_dim, split_sizes_vec[i]);
+        Tensor* result = nullptr;
+        OP_REQUIRES_OK(context,
+                       context->allocate_output(i, output_shape, &result));
+        outputs[i] = const_cast<char*>(result->tensor_data().data());
+        output_row_bytes[i] = split_sizes_vec[i] * suffix_dim_size * sizeof(T);
+      }
+      SplitCPU(context->device(), input.tensor_data().data(), prefix_dim_size,
+               outputs, output_row_bytes);
     } else {
       auto input_reshaped = input.shaped<T, 3>(
           {prefix_dim_size, split_dim_size, suffix_dim_size});
@@ -16,6 +16,7 @@ limitations under the License.
 #include <cstddef>
 #include <cstdlib>
 #include <string>
+#include <utility>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/bounds_check.h"
@@ -29,8 +30,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/string_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/bcast.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -71,61 +74,37 @@ class SubstrOp : public OpKernel {
                      context->allocate_output("output", input_tensor.shape(),
                                               &output_tensor));
       auto output = output_tensor->flat<tstring>();
-      if (is_scalar) {
-        // Perform Op with scalar pos/len
-        const T pos =
-            tensorflow::internal::SubtleMustCopy(pos_tensor.scalar<T>()());
-        const T len =
-            tensorflow::internal::SubtleMustCopy(len_tensor.scalar<T>()());
-        for (size_t i = 0; i < input_tensor.NumElements(); ++i) {
-          StringPiece in(input(i));
-          T byte_pos = pos;
-          T byte_len = len;
-          switch (unit_) {
-            case CharUnit::UTF8_CHAR:
-              OP_REQUIRES(
-                  context, UpdatePosAndLenForUtf8(in, &byte_pos, &byte_len),
-                  errors::InvalidArgument("pos ", pos, " out of range for ",
-                                          "string at index ", i));
-              break;
-            case CharUnit::BYTE:
-              byte_pos = AdjustedPosIndex(byte_pos, in);
-              OP_REQUIRES(
-                  context, FastBoundsCheck(byte_pos, in.size() + 1),
-                  errors::InvalidArgument("pos ", pos, " out of range for ",
-                                          "string b'", in, "' at index ", i));
-          }
-          StringPiece sub_in = in.substr(byte_pos, byte_len);
-          output(i).assign(sub_in.data(), sub_in.size());
-        }
-      } else {
-        // Perform Op element-wise with tensor pos/len
-        auto pos_flat = pos_tensor.flat<T>();
-        auto len_flat = len_tensor.flat<T>();
-        for (size_t i = 0; i < input_tensor.NumElements(); ++i) {
-          StringPiece in(input(i));
-          const T pos = tensorflow::internal::SubtleMustCopy(pos_flat(i));
-          const T len = tensorflow::internal::SubtleMustCopy(len_flat(i));
-          T byte_pos = pos;
-          T byte_len = len;
-          switch (unit_) {
-            case CharUnit::UTF8_CHAR:
-              OP_REQUIRES(
-                  context, UpdatePosAndLenForUtf8(in, &byte_pos, &byte_len),
-                  errors::InvalidArgument("pos ", pos, " out of range for ",
-                                          "string at index ", i));
-              break;
-            case CharUnit::BYTE:
-              byte_pos = AdjustedPosIndex(byte_pos, in);
-              OP_REQUIRES(
-                  context, FastBoundsCheck(byte_pos, in.size() + 1),
-                  errors::InvalidArgument("pos ", pos, " out of range for ",
-                                          "string b'", in, "' at index ", i));
-          }
-          StringPiece sub_in = in.substr(byte_pos, byte_len);
-          output(i).assign(sub_in.data(), sub_in.size());
-        }
-      }
+      // Perform Op element-wise, with pos/len either scalar or of the shape of
+      // input, sharded over the intra-op threads. The error reported is the
+      // one of the first string that is out of range.
+      auto pos_flat = pos_tensor.flat<T>();
+      auto len_flat = len_tensor.flat<T>();
+      const int64_t num_elements = input_tensor.NumElements();
+      mutex mu;
+      int64_t error_index = num_elements;
+      Status error;
+      const DeviceBase::CpuWorkerThreads& worker_threads =
+          *context->device()->tensorflow_cpu_worker_threads();
+      Shard(worker_threads.num_threads, worker_threads.workers, num_elements,
+            kCostPerString, [&](int64_t start, int64_t limit) {
+              for (int64_t i = start; i < limit; ++i) {
+                const int64_t pos_index = is_scalar ? 0 : i;
+                const T pos =
+                    tensorflow::internal::SubtleMustCopy(pos_flat(pos_index));
+                const T len =
+                    tensorflow::internal::SubtleMustCopy(len_flat(pos_index));
+                Status s = Substr(input(i), pos, len, i, &output(i));
+                if (!s.ok()) {
+                  mutex_lock l(mu);
+                  if (i < error_index) {
+                    error_index = i;
+                    error = std::move(s);
+                  }
+                  return;
+                }
+              }
+            });
+      OP_REQUIRES_OK(context, error);
     } else {
       // Perform op with broadcasting
       // TODO: Use ternary broadcasting for once available in Eigen. Current
@@ -266,6 +245,35 @@ class SubstrOp : public OpKernel {
   }
 
  private:
+  // The rough cost of taking a short substring, in cycles.
+  static constexpr int64_t kCostPerString = 100;
+
+  // Assigns the substring of `in` at `pos` of length `len` to `out`, the
+  // string being the one at `index` in the input.
+  Status Substr(const StringPiece in, const T pos, const T len,
+                const int64_t index, tstring* out) const {
+    T byte_pos = pos;
+    T byte_len = len;
+    switch (unit_) {
+      case CharUnit::UTF8_CHAR:
+        if (!UpdatePosAndLenForUtf8(in, &byte_pos, &byte_len)) {
+          return errors::InvalidArgument("pos ", pos, " out of range for ",
+                                         "string at index ", index);
+        }
+        break;
+      case CharUnit::BYTE:
+        byte_pos = AdjustedPosIndex(byte_pos, in);
+        if (!FastBoundsCheck(byte_pos, in.size() + 1)) {
+          return errors::InvalidArgument("pos ", pos, " out of range for ",
+                                         "string b'", in, "' at index ",
+                                         index);
+        }
+    }
+    StringPiece sub_in = in.substr(byte_pos, byte_len);
+    out->assign(sub_in.data(), sub_in.size());
+    return absl::OkStatus();
+  }
+
   // This adjusts the requested position. Note it does not perform any bound
   // checks.
   static inline T AdjustedPosIndex(const T pos_requested, const StringPiece s) {
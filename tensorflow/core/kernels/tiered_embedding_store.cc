@@ -0,0 +1,367 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/tiered_embedding_store.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+
+namespace tensorflow {
+
+Status TieredEmbeddingStore::Create(
+    const Options& options, std::unique_ptr<TieredEmbeddingStore>* store) {
+  if (options.row_bytes <= 0) {
+    return errors::InvalidArgument("row_bytes must be positive, got ",
+                                   options.row_bytes);
+  }
+  if (options.cache_capacity <= 0) {
+    return errors::InvalidArgument("cache_capacity must be positive, got ",
+                                   options.cache_capacity);
+  }
+  if (options.segment_bytes <
+      options.row_bytes + static_cast<int64_t>(sizeof(int64_t))) {
+    return errors::InvalidArgument("segment_bytes (", options.segment_bytes,
+                                   ") must hold at least one row of ",
+                                   options.row_bytes, " bytes and its key");
+  }
+  if (options.directory.empty()) {
+    return errors::InvalidArgument("The directory of the store is empty");
+  }
+  TF_RETURN_IF_ERROR(options.env->IsDirectory(options.directory));
+  store->reset(new TieredEmbeddingStore(options));
+  if (options.compaction_interval_micros > 0) {
+    TieredEmbeddingStore* s = store->get();
+    s->compaction_thread_.reset(options.env->StartThread(
+        ThreadOptions(), "tiered_embedding_store_compaction",
+        [s]() { s->CompactionLoop(); }));
+  }
+  return absl::OkStatus();
+}
+
+TieredEmbeddingStore::TieredEmbeddingStore(const Options& options)
+    : options_(options),
+      record_bytes_(sizeof(int64_t) + options.row_bytes),
+      file_prefix_(io::JoinPath(options.directory,
+                                absl::StrCat("tiered_embedding_store_",
+                                             absl::Hex(random::New64())))) {
+  mutex_lock l(mu_);
+  segments_[active_segment_].filename =
+      absl::StrCat(file_prefix_, "_", active_segment_, ".log");
+}
+
+TieredEmbeddingStore::~TieredEmbeddingStore() {
+  {
+    mutex_lock l(mu_);
+    shutdown_ = true;
+  }
+  shutdown_cv_.notify_all();
+  compaction_thread_.reset();
+  mutex_lock l(mu_);
+  while (segments_.begin()->first != active_segment_) {
+    DeleteSegment(segments_.begin()->first);
+  }
+}
+
+const char* TieredEmbeddingStore::Record(const Location& location) const {
+  if (location.segment == active_segment_) {
+    return active_buffer_.data() + location.offset;
+  }
+  return static_cast<const char*>(
+             segments_.at(location.segment).region->data()) +
+         location.offset;
+}
+
+Status TieredEmbeddingStore::Lookup(const int64_t* keys, int64_t num_keys,
+                                    char* rows, std::vector<bool>* found) {
+  found->assign(num_keys, false);
+  Stats batch;
+  Status s;
+  {
+    mutex_lock l(mu_);
+    for (int64_t i = 0; i < num_keys && s.ok(); ++i) {
+      bool key_found;
+      s = LookupLocked(keys[i], rows + i * options_.row_bytes, &key_found,
+                       &batch);
+      (*found)[i] = key_found;
+    }
+    stats_.cache_hits += batch.cache_hits;
+    stats_.store_hits += batch.store_hits;
+    stats_.misses += batch.misses;
+  }
+  metrics::RecordTieredLookupTableLookups(batch.cache_hits, batch.store_hits,
+                                          batch.misses);
+  return s;
+}
+
+Status TieredEmbeddingStore::Insert(const int64_t* keys, int64_t num_keys,
+                                    const char* rows) {
+  mutex_lock l(mu_);
+  for (int64_t i = 0; i < num_keys; ++i) {
+    TF_RETURN_IF_ERROR(InsertLocked(keys[i], rows + i * options_.row_bytes));
+  }
+  return absl::OkStatus();
+}
+
+Status TieredEmbeddingStore::LookupLocked(int64_t key, char* row, bool* found,
+                                          Stats* stats) {
+  auto cached = cache_index_.find(key);
+  if (cached != cache_index_.end()) {
+    cache_.splice(cache_.begin(), cache_, cached->second);
+    std::memcpy(row, cached->second->row.data(), options_.row_bytes);
+    ++stats->cache_hits;
+    *found = true;
+    return absl::OkStatus();
+  }
+  auto indexed = log_index_.find(key);
+  if (indexed == log_index_.end()) {
+    ++stats->misses;
+    *found = false;
+    return absl::OkStatus();
+  }
+  std::memcpy(row, Record(indexed->second) + sizeof(int64_t),
+              options_.row_bytes);
+  ++stats->store_hits;
+  *found = true;
+  return AddToCache(key, row, /*dirty=*/false);
+}
+
+Status TieredEmbeddingStore::InsertLocked(int64_t key, const char* row) {
+  auto cached = cache_index_.find(key);
+  if (cached != cache_index_.end()) {
+    CacheEntry& entry = *cached->second;
+    entry.row.assign(row, options_.row_bytes);
+    if (!entry.dirty) {
+      entry.dirty = true;
+      DropRecord(key);
+    }
+    cache_.splice(cache_.begin(), cache_, cached->second);
+    return absl::OkStatus();
+  }
+  if (log_index_.contains(key)) {
+    DropRecord(key);
+  } else {
+    ++size_;
+  }
+  return AddToCache(key, row, /*dirty=*/true);
+}
+
+void TieredEmbeddingStore::Remove(int64_t key) {
+  mutex_lock l(mu_);
+  bool present = false;
+  auto cached = cache_index_.find(key);
+  if (cached != cache_index_.end()) {
+    cache_.erase(cached->second);
+    cache_index_.erase(cached);
+    present = true;
+  }
+  if (log_index_.contains(key)) {
+    DropRecord(key);
+    present = true;
+  }
+  if (present) --size_;
+}
+
+Status TieredEmbeddingStore::Clear() {
+  mutex_lock l(mu_);
+  cache_.clear();
+  cache_index_.clear();
+  log_index_.clear();
+  while (segments_.begin()->first != active_segment_) {
+    DeleteSegment(segments_.begin()->first);
+  }
+  Segment& active = segments_[active_segment_];
+  active.num_records = 0;
+  active.num_live_records = 0;
+  active_buffer_.clear();
+  size_ = 0;
+  return absl::OkStatus();
+}
+
+Status TieredEmbeddingStore::ForEach(
+    const std::function<void(int64_t, const char*)>& fn) {
+  mutex_lock l(mu_);
+  for (const CacheEntry& entry : cache_) {
+    fn(entry.key, entry.row.data());
+  }
+  for (const auto& indexed : log_index_) {
+    if (!cache_index_.contains(indexed.first)) {
+      fn(indexed.first, Record(indexed.second) + sizeof(int64_t));
+    }
+  }
+  return absl::OkStatus();
+}
+
+Status TieredEmbeddingStore::AddToCache(int64_t key, const char* row,
+                                        bool dirty) {
+  cache_.push_front({key, std::string(row, options_.row_bytes), dirty});
+  cache_index_[key] = cache_.begin();
+  while (static_cast<int64_t>(cache_.size()) > options_.cache_capacity) {
+    CacheEntry& victim = cache_.back();
+    // A clean row is still indexed in the log.
+    if (victim.dirty) {
+      TF_RETURN_IF_ERROR(Append(victim.key, victim.row.data()));
+    }
+    cache_index_.erase(victim.key);
+    cache_.pop_back();
+  }
+  return absl::OkStatus();
+}
+
+Status TieredEmbeddingStore::Append(int64_t key, const char* row) {
+  if (static_cast<int64_t>(active_buffer_.size()) + record_bytes_ >
+      options_.segment_bytes) {
+    TF_RETURN_IF_ERROR(SealActiveSegment());
+  }
+  const int64_t offset = active_buffer_.size();
+  active_buffer_.append(reinterpret_cast<const char*>(&key), sizeof(key));
+  active_buffer_.append(row, options_.row_bytes);
+  Segment& active = segments_[active_segment_];
+  ++active.num_records;
+  ++active.num_live_records;
+  log_index_[key] = {active_segment_, offset};
+  return absl::OkStatus();
+}
+
+void TieredEmbeddingStore::DropRecord(int64_t key) {
+  auto indexed = log_index_.find(key);
+  if (indexed == log_index_.end()) return;
+  const int64_t segment = indexed->second.segment;
+  log_index_.erase(indexed);
+  if (--segments_[segment].num_live_records == 0 &&
+      segment != active_segment_) {
+    DeleteSegment(segment);
+  }
+}
+
+Status TieredEmbeddingStore::SealActiveSegment() {
+  const int64_t sealed = active_segment_;
+  {
+    Segment& segment = segments_[sealed];
+    TF_RETURN_IF_ERROR(
+        WriteStringToFile(options_.env, segment.filename, active_buffer_));
+    TF_RETURN_IF_ERROR(options_.env->NewReadOnlyMemoryRegionFromFile(
+        segment.filename, &segment.region));
+  }
+  // The records of the sealed segment are read from the mapped file from now
+  // on.
+  ++active_segment_;
+  segments_[active_segment_].filename =
+      absl::StrCat(file_prefix_, "_", active_segment_, ".log");
+  active_buffer_.clear();
+  ++stats_.num_segments;
+  if (segments_[sealed].num_live_records == 0) {
+    DeleteSegment(sealed);
+  }
+  return absl::OkStatus();
+}
+
+void TieredEmbeddingStore::DeleteSegment(int64_t segment) {
+  auto it = segments_.find(segment);
+  it->second.region.reset();
+  Status s = options_.env->DeleteFile(it->second.filename);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete " << it->second.filename << ": " << s;
+  }
+  segments_.erase(it);
+  --stats_.num_segments;
+}
+
+Status TieredEmbeddingStore::Compact() {
+  mutex_lock l(mu_);
+  std::vector<int64_t> to_compact;
+  for (const auto& segment : segments_) {
+    if (segment.first == active_segment_) continue;
+    const double garbage_fraction =
+        1.0 - static_cast<double>(segment.second.num_live_records) /
+                  segment.second.num_records;
+    if (garbage_fraction > options_.max_garbage_fraction) {
+      to_compact.push_back(segment.first);
+    }
+  }
+  for (int64_t id : to_compact) {
+    // The segment may have been deleted when its last live record became
+    // garbage.
+    auto it = segments_.find(id);
+    if (it == segments_.end()) continue;
+    const char* data = static_cast<const char*>(it->second.region->data());
+    const int64_t num_records = it->second.num_records;
+    for (int64_t r = 0; r < num_records; ++r) {
+      const int64_t offset = r * record_bytes_;
+      int64_t key;
+      std::memcpy(&key, data + offset, sizeof(key));
+      auto indexed = log_index_.find(key);
+      if (indexed == log_index_.end() || indexed->second.segment != id ||
+          indexed->second.offset != offset) {
+        continue;
+      }
+      // Appending reindexes the key, so the record is only dropped from this
+      // segment once it is rewritten.
+      TF_RETURN_IF_ERROR(Append(key, data + offset + sizeof(int64_t)));
+      --segments_[id].num_live_records;
+    }
+    DeleteSegment(id);
+    ++stats_.num_compacted_segments;
+  }
+  return absl::OkStatus();
+}
+
+void TieredEmbeddingStore::CompactionLoop() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (!shutdown_) {
+        shutdown_cv_.wait_for(
+            l, std::chrono::microseconds(options_.compaction_interval_micros));
+      }
+      if (shutdown_) return;
+    }
+    Status s = Compact();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to compact the tiered embedding store: " << s;
+    }
+  }
+}
+
+size_t TieredEmbeddingStore::size() const {
+  tf_shared_lock l(mu_);
+  return size_;
+}
+
+int64_t TieredEmbeddingStore::MemoryUsed() const {
+  tf_shared_lock l(mu_);
+  return sizeof(TieredEmbeddingStore) +
+         cache_.size() * (sizeof(CacheEntry) + options_.row_bytes) +
+         cache_index_.capacity() *
+             (sizeof(int64_t) + sizeof(CacheList::iterator)) +
+         log_index_.capacity() * (sizeof(int64_t) + sizeof(Location)) +
+         active_buffer_.capacity();
+}
+
+TieredEmbeddingStore::Stats TieredEmbeddingStore::stats() const {
+  tf_shared_lock l(mu_);
+  Stats stats = stats_;
+  stats.num_cached_rows = cache_.size();
+  return stats;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,191 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_TIERED_EMBEDDING_STORE_H_
+#define TENSORFLOW_CORE_KERNELS_TIERED_EMBEDDING_STORE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// A map from int64 keys to fixed-size rows that holds the recently used rows
+// in memory and the others on local disk, so that it can hold more rows than
+// fit in RAM.
+//
+// At most `cache_capacity` rows are cached in memory, in LRU order. Evicted
+// rows that were modified since they were read are appended to a log on disk,
+// made of segments of `segment_bytes`. The segment being appended to is kept
+// in memory; once full, it is written to `directory` and memory-mapped. An
+// in-memory index maps each key that isn't cached to its record in the log,
+// so that a lookup reads at most one record.
+//
+// Rewriting or removing a row leaves its old record as garbage. Compact()
+// rewrites the live records of the segments that are mostly garbage and
+// deletes their files. It runs every `compaction_interval_micros` in a
+// background thread, if positive.
+//
+// Thread-safe.
+class TieredEmbeddingStore {
+ public:
+  struct Options {
+    Env* env = Env::Default();
+    // The directory of the segment files, which must exist.
+    std::string directory;
+    // The size in bytes of every row.
+    int64_t row_bytes = 0;
+    // The number of rows cached in memory.
+    int64_t cache_capacity = 0;
+    // The size in bytes of a segment of the log.
+    int64_t segment_bytes = 64 << 20;
+    // Segments with a larger fraction of garbage are compacted.
+    double max_garbage_fraction = 0.5;
+    int64_t compaction_interval_micros = 0;
+  };
+
+  struct Stats {
+    int64_t cache_hits = 0;
+    int64_t store_hits = 0;
+    int64_t misses = 0;
+    int64_t num_cached_rows = 0;
+    // The number of sealed segments, on disk.
+    int64_t num_segments = 0;
+    int64_t num_compacted_segments = 0;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<TieredEmbeddingStore>* store);
+
+  // Deletes the segment files.
+  ~TieredEmbeddingStore();
+
+  // Looks up the `num_keys` keys at `keys`. The row of keys[i] is copied to
+  // rows + i * row_bytes and (*found)[i] is set, or (*found)[i] is false if
+  // there is no row for keys[i].
+  Status Lookup(const int64_t* keys, int64_t num_keys, char* rows,
+                std::vector<bool>* found);
+
+  // Inserts or replaces the rows of the `num_keys` keys at `keys`, the row of
+  // keys[i] being at rows + i * row_bytes.
+  Status Insert(const int64_t* keys, int64_t num_keys, const char* rows);
+
+  void Remove(int64_t key);
+
+  // Removes all rows.
+  Status Clear();
+
+  // Calls `fn` with every key and row, in no particular order.
+  Status ForEach(const std::function<void(int64_t, const char*)>& fn);
+
+  // Rewrites the live records of the segments that are mostly garbage.
+  Status Compact();
+
+  size_t size() const;
+
+  // The bytes of memory used by the cache, the index and the segment being
+  // written.
+  int64_t MemoryUsed() const;
+
+  Stats stats() const;
+
+ private:
+  // The location of a record in the log.
+  struct Location {
+    int64_t segment;
+    int64_t offset;
+  };
+
+  struct Segment {
+    std::string filename;
+    // The memory-mapped file once the segment is sealed.
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    int64_t num_records = 0;
+    int64_t num_live_records = 0;
+  };
+
+  struct CacheEntry {
+    int64_t key;
+    std::string row;
+    // Whether the row differs from its record in the log, if any.
+    bool dirty;
+  };
+  using CacheList = std::list<CacheEntry>;
+
+  explicit TieredEmbeddingStore(const Options& options);
+
+  Status LookupLocked(int64_t key, char* row, bool* found, Stats* stats)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Status InsertLocked(int64_t key, const char* row)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the record at `location`.
+  const char* Record(const Location& location) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Caches `row`, evicting the least recently used row if the cache is full.
+  Status AddToCache(int64_t key, const char* row, bool dirty)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Appends a record of `key` and `row` to the log, and indexes it.
+  Status Append(int64_t key, const char* row) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Marks the indexed record of `key`, if any, as garbage and unindexes it.
+  void DropRecord(int64_t key) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Writes the active segment to disk and maps it.
+  Status SealActiveSegment() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void DeleteSegment(int64_t segment) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void CompactionLoop();
+
+  const Options options_;
+  const int64_t record_bytes_;
+  // Prefix of the names of the segment files of this store.
+  const std::string file_prefix_;
+
+  mutable mutex mu_;
+  CacheList cache_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<int64_t, CacheList::iterator> cache_index_
+      TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<int64_t, Location> log_index_ TF_GUARDED_BY(mu_);
+  // Segments by id, the active one being the last.
+  std::map<int64_t, Segment> segments_ TF_GUARDED_BY(mu_);
+  int64_t active_segment_ TF_GUARDED_BY(mu_) = 0;
+  std::string active_buffer_ TF_GUARDED_BY(mu_);
+  // The number of keys that are cached or indexed.
+  int64_t size_ TF_GUARDED_BY(mu_) = 0;
+  Stats stats_ TF_GUARDED_BY(mu_);
+
+  bool shutdown_ TF_GUARDED_BY(mu_) = false;
+  condition_variable shutdown_cv_;
+  std::unique_ptr<Thread> compaction_thread_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_TIERED_EMBEDDING_STORE_H_
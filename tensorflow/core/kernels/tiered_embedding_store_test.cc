@@ -0,0 +1,192 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/tiered_embedding_store.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Rows of two floats.
+constexpr int64_t kRowBytes = 2 * sizeof(float);
+// Segments of four records.
+constexpr int64_t kSegmentBytes = 4 * (sizeof(int64_t) + kRowBytes);
+
+class TieredEmbeddingStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = io::JoinPath(testing::TmpDir(), "tiered_embedding_store");
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(directory_));
+    TieredEmbeddingStore::Options options;
+    options.directory = directory_;
+    options.row_bytes = kRowBytes;
+    options.cache_capacity = 2;
+    options.segment_bytes = kSegmentBytes;
+    TF_ASSERT_OK(TieredEmbeddingStore::Create(options, &store_));
+  }
+
+  Status Insert(int64_t key, float value) {
+    const float row[2] = {value, -value};
+    return store_->Insert(&key, 1, reinterpret_cast<const char*>(row));
+  }
+
+  // Returns the first value of the row of `key`, or 0 if it is absent.
+  float Lookup(int64_t key) {
+    float row[2] = {0, 0};
+    std::vector<bool> found;
+    TF_CHECK_OK(
+        store_->Lookup(&key, 1, reinterpret_cast<char*>(row), &found));
+    if (!found[0]) return 0;
+    EXPECT_EQ(row[1], -row[0]);
+    return row[0];
+  }
+
+  int NumFiles() {
+    std::vector<string> children;
+    TF_CHECK_OK(Env::Default()->GetChildren(directory_, &children));
+    return children.size();
+  }
+
+  std::string directory_;
+  std::unique_ptr<TieredEmbeddingStore> store_;
+};
+
+TEST_F(TieredEmbeddingStoreTest, EvictsRowsToDisk) {
+  const int files_before = NumFiles();
+  for (int64_t key = 0; key < 20; ++key) {
+    TF_ASSERT_OK(Insert(key, key + 1));
+  }
+  EXPECT_EQ(store_->size(), 20);
+  // 18 rows were evicted, 16 of which fill 4 sealed segments.
+  EXPECT_EQ(store_->stats().num_segments, 4);
+  EXPECT_EQ(NumFiles(), files_before + 4);
+  for (int64_t key = 0; key < 20; ++key) {
+    EXPECT_EQ(Lookup(key), key + 1);
+  }
+  EXPECT_EQ(Lookup(20), 0);
+  TieredEmbeddingStore::Stats stats = store_->stats();
+  EXPECT_EQ(stats.store_hits, 20);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.num_cached_rows, 2);
+
+  // The last rows are cached.
+  EXPECT_EQ(Lookup(19), 20);
+  EXPECT_EQ(store_->stats().cache_hits, 1);
+
+  store_.reset();
+  EXPECT_EQ(NumFiles(), files_before);
+}
+
+TEST_F(TieredEmbeddingStoreTest, LooksUpBatches) {
+  for (int64_t key = 0; key < 10; ++key) {
+    TF_ASSERT_OK(Insert(key, key + 1));
+  }
+  const std::vector<int64_t> keys = {9, 42, 0, 5};
+  std::vector<float> rows(2 * keys.size());
+  std::vector<bool> found;
+  TF_ASSERT_OK(store_->Lookup(keys.data(), keys.size(),
+                              reinterpret_cast<char*>(rows.data()), &found));
+  EXPECT_EQ(found, std::vector<bool>({true, false, true, true}));
+  EXPECT_EQ(rows[0], 10);
+  EXPECT_EQ(rows[4], 1);
+  EXPECT_EQ(rows[5], -1);
+  EXPECT_EQ(rows[6], 6);
+}
+
+TEST_F(TieredEmbeddingStoreTest, OverwritesAndRemovesRows) {
+  for (int64_t key = 0; key < 10; ++key) {
+    TF_ASSERT_OK(Insert(key, key + 1));
+  }
+  for (int64_t key = 0; key < 10; ++key) {
+    TF_ASSERT_OK(Insert(key, 100 + key));
+  }
+  store_->Remove(3);
+  store_->Remove(42);
+  EXPECT_EQ(store_->size(), 9);
+  for (int64_t key = 0; key < 10; ++key) {
+    EXPECT_EQ(Lookup(key), key == 3 ? 0 : 100 + key);
+  }
+
+  absl::flat_hash_map<int64_t, float> rows;
+  TF_ASSERT_OK(store_->ForEach([&rows](int64_t key, const char* row) {
+    rows[key] = reinterpret_cast<const float*>(row)[0];
+  }));
+  EXPECT_EQ(rows.size(), 9);
+  EXPECT_EQ(rows[9], 109);
+  EXPECT_FALSE(rows.contains(3));
+}
+
+TEST_F(TieredEmbeddingStoreTest, CompactsSegments) {
+  for (int64_t key = 0; key < 10; ++key) {
+    TF_ASSERT_OK(Insert(key, key + 1));
+  }
+  // Rewrites all but one row of every sealed segment.
+  for (int64_t key = 0; key < 10; ++key) {
+    if (key % 4 != 0) {
+      TF_ASSERT_OK(Insert(key, 100 + key));
+    }
+  }
+  // Evicts the rewritten rows that are still cached.
+  for (int64_t key = 20; key < 22; ++key) {
+    TF_ASSERT_OK(Insert(key, key));
+  }
+  const int64_t segments_before = store_->stats().num_segments;
+  TF_ASSERT_OK(store_->Compact());
+  TieredEmbeddingStore::Stats stats = store_->stats();
+  EXPECT_GT(stats.num_compacted_segments, 0);
+  EXPECT_LT(stats.num_segments, segments_before);
+  for (int64_t key = 0; key < 10; ++key) {
+    EXPECT_EQ(Lookup(key), key % 4 == 0 ? key + 1 : 100 + key);
+  }
+  EXPECT_EQ(store_->size(), 12);
+}
+
+TEST_F(TieredEmbeddingStoreTest, Clear) {
+  const int files_before = NumFiles();
+  for (int64_t key = 0; key < 10; ++key) {
+    TF_ASSERT_OK(Insert(key, key + 1));
+  }
+  TF_ASSERT_OK(store_->Clear());
+  EXPECT_EQ(store_->size(), 0);
+  EXPECT_EQ(NumFiles(), files_before);
+  EXPECT_EQ(Lookup(1), 0);
+  TF_ASSERT_OK(Insert(1, 5));
+  EXPECT_EQ(Lookup(1), 5);
+}
+
+TEST(TieredEmbeddingStoreOptionsTest, RejectsTooSmallSegments) {
+  TieredEmbeddingStore::Options options;
+  options.directory = testing::TmpDir();
+  options.row_bytes = 16;
+  options.cache_capacity = 1;
+  options.segment_bytes = 16;
+  std::unique_ptr<TieredEmbeddingStore> store;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      TieredEmbeddingStore::Create(options, &store)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,167 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/tiered_embedding_store.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// Lookup table from int64 keys to vectors, like MutableHashTableOfTensors,
+// that keeps the recently used rows in memory and the others in a
+// TieredEmbeddingStore in `storage_directory`, so that it can grow larger
+// than the host memory. The store's files are deleted with the table.
+template <class V>
+class TieredHashTableOfTensors final : public LookupInterface {
+ public:
+  TieredHashTableOfTensors(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(value_shape_),
+        errors::InvalidArgument("Default value must be a vector, got shape ",
+                                value_shape_.DebugString()));
+    TieredEmbeddingStore::Options options;
+    int64_t compaction_interval_secs;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "storage_directory",
+                                    &options.directory));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "cache_capacity",
+                                    &options.cache_capacity));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "segment_bytes",
+                                    &options.segment_bytes));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "compaction_interval_secs",
+                                    &compaction_interval_secs));
+    options.row_bytes = value_shape_.num_elements() * sizeof(V);
+    options.compaction_interval_micros = compaction_interval_secs * 1000000;
+    OP_REQUIRES_OK(ctx, TieredEmbeddingStore::Create(options, &store_));
+  }
+
+  size_t size() const override { return store_->size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat_inner_dims<V, 2>();
+    const auto key_values = key.flat<int64_t>();
+    auto value_values = value->flat_inner_dims<V, 2>();
+    const int64_t value_dim = value_shape_.dim_size(0);
+    // All keys share the first default, unless each has its own.
+    const bool is_full_size_default =
+        (value_values.size() == default_flat.size());
+
+    std::vector<bool> found;
+    TF_RETURN_IF_ERROR(store_->Lookup(key_values.data(), key_values.size(),
+                                      reinterpret_cast<char*>(value->data()),
+                                      &found));
+    for (int64_t i = 0; i < key_values.size(); ++i) {
+      if (found[i]) continue;
+      for (int64_t j = 0; j < value_dim; ++j) {
+        value_values(i, j) =
+            is_full_size_default ? default_flat(i, j) : default_flat(0, j);
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return store_->Insert(keys.flat<int64_t>().data(), keys.NumElements(),
+                          reinterpret_cast<const char*>(values.data()));
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<int64_t>();
+    for (int64_t i = 0; i < key_values.size(); ++i) {
+      store_->Remove(key_values(i));
+    }
+    return absl::OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    TF_RETURN_IF_ERROR(store_->Clear());
+    return Insert(ctx, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64_t row_bytes = value_shape_.num_elements() * sizeof(V);
+    std::vector<int64_t> keys;
+    std::string rows;
+    TF_RETURN_IF_ERROR(store_->ForEach(
+        [&keys, &rows, row_bytes](int64_t key, const char* row) {
+          keys.push_back(key);
+          rows.append(row, row_bytes);
+        }));
+    const int64_t size = keys.size();
+    Tensor* keys_tensor;
+    Tensor* values_tensor;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys_tensor));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({size, value_shape_.dim_size(0)}),
+        &values_tensor));
+    std::copy(keys.begin(), keys.end(), keys_tensor->flat<int64_t>().data());
+    std::memcpy(values_tensor->data(), rows.data(), rows.size());
+    return absl::OkStatus();
+  }
+
+  DataType key_dtype() const override { return DT_INT64; }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64_t MemoryUsed() const override {
+    return sizeof(TieredHashTableOfTensors) + store_->MemoryUsed();
+  }
+
+ private:
+  TensorShape value_shape_;
+  std::unique_ptr<TieredEmbeddingStore> store_;
+};
+
+}  // namespace lookup
+
+#define REGISTER_KERNEL(value_dtype)                                         \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("TieredHashTableOfTensors")                                       \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<int64_t>("key_dtype")                              \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::TieredHashTableOfTensors<value_dtype>, int64_t, \
+                    value_dtype>)
+
+REGISTER_KERNEL(double);
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(int32);
+REGISTER_KERNEL(int64_t);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
@@ -129,6 +129,54 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// Orders the columns of a row by decreasing value, then increasing index.
+template <typename T, typename Tidx>
+struct StableGreater {
+  bool operator()(const Tidx a, const Tidx b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+  const T* input_data;
+};
+
+// Pushes the columns [begin, end) of a row into `filter`, in order. Once the
+// filter is full, a column that is not greater than the smallest value it
+// holds would be dropped, coming after it; such columns are skipped a block at
+// a time, with a comparison loop that vectorizes.
+template <typename T, typename Tidx, typename Filter>
+void PushColumns(const T* input_data, const int64_t begin, const int64_t end,
+                 Filter* filter) {
+  int64_t c = begin;
+  for (; c < end && filter->size() < filter->limit(); ++c) {
+    filter->push(static_cast<Tidx>(c));
+  }
+  if (c == end) return;
+  constexpr int64_t kBlockSize = 64;
+  T threshold = input_data[filter->peek_bottom()];
+  while (c < end) {
+    const int64_t block_end = std::min(end, c + kBlockSize);
+    bool any_greater = false;
+    for (int64_t i = c; i < block_end; ++i) {
+      // NaNs compare as greater here, and are left to the filter.
+      any_greater |= !(input_data[i] <= threshold);
+    }
+    if (any_greater) {
+      for (int64_t i = c; i < block_end; ++i) {
+        if (!(input_data[i] <= threshold)) {
+          filter->push(static_cast<Tidx>(i));
+          threshold = input_data[filter->peek_bottom()];
+        }
+      }
+    }
+    c = block_end;
+  }
+}
+
 template <typename T, typename Tidx>
 struct TopKFunctor<CPUDevice, T, Tidx> {
   static EIGEN_ALWAYS_INLINE Status Compute(
@@ -161,6 +209,15 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
       return OkStatus();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64_t num_partitions =
+        NumColumnPartitions(k, num_rows, num_cols, worker_threads.num_threads);
+    if (num_partitions > 1) {
+      PartitionedTopK(worker_threads, sorted, k, input, num_rows, num_cols,
+                      num_partitions, values, indices);
+      return OkStatus();
+    }
+
     auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
       for (int32_t b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
@@ -208,9 +265,7 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
           // Use the TopN heap object to sort.
           gtl::TopN<Tidx, decltype(stable_comp)> filter(k, stable_comp);
           filter.reserve(num_cols);
-          for (Tidx c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
+          PushColumns<T, Tidx>(input_data, 0, num_cols, &filter);
 
           int32_t i = 0;
           if (sorted) {
@@ -247,12 +302,85 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
     const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return OkStatus();
   }
+
+ private:
+  // Columns per partition below which splitting a row does not pay off.
+  static constexpr int64_t kMinColumnsPerPartition = 1 << 15;
+
+  // The number of partitions to split each row in, when there are too few
+  // rows to keep the threads busy and the rows are long next to k.
+  static int64_t NumColumnPartitions(const int k, const int64_t num_rows,
+                                     const int64_t num_cols,
+                                     const int num_threads) {
+    if (k == num_cols || num_rows >= num_threads) return 1;
+    const int64_t max_partitions =
+        num_cols / std::max(kMinColumnsPerPartition, 8 * int64_t{k});
+    return std::min(max_partitions, Eigen::divup(num_threads, num_rows));
+  }
+
+  // Computes the top k of every partition of the rows in parallel, then merges
+  // the candidates of each row. Since the columns are ordered by value and
+  // then index, the result is the one of a single pass.
+  static void PartitionedTopK(
+      const DeviceBase::CpuWorkerThreads& worker_threads, const bool sorted,
+      const int k, const typename TTypes<T, 2>::ConstTensor& input,
+      const int64_t num_rows, const int64_t num_cols,
+      const int64_t num_partitions, typename TTypes<T, 2>::Tensor values,
+      typename TTypes<Tidx, 2>::Tensor indices) {
+    using Filter = gtl::TopN<Tidx, StableGreater<T, Tidx>>;
+    const int64_t partition_size = Eigen::divup(num_cols, num_partitions);
+    // Every partition has more than k columns, and fills its k candidates.
+    std::vector<Tidx> candidates(num_rows * num_partitions * k);
+    const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<Tidx>() +
+                            Eigen::TensorOpCost::AddCost<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_partitions,
+          static_cast<int64_t>(cmp_cost * partition_size),
+          [&](int64_t start, int64_t limit) {
+            for (int64_t u = start; u < limit; ++u) {
+              const int64_t b = u / num_partitions;
+              const int64_t begin = (u % num_partitions) * partition_size;
+              const int64_t end = std::min(num_cols, begin + partition_size);
+              const T* input_data = &input(b, 0);
+              Filter filter(k, StableGreater<T, Tidx>{input_data});
+              filter.reserve(k + 1);
+              PushColumns<T, Tidx>(input_data, begin, end, &filter);
+              std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+                        candidates.begin() + u * k);
+            }
+          });
+    const int64_t num_candidates = num_partitions * k;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          static_cast<int64_t>(4 * cmp_cost * num_candidates *
+                               Eigen::numext::log2(static_cast<float>(k + 1))),
+          [&](int64_t start, int64_t limit) {
+            for (int64_t b = start; b < limit; ++b) {
+              Filter filter(k, StableGreater<T, Tidx>{&input(b, 0)});
+              filter.reserve(k + 1);
+              const auto row_candidates =
+                  candidates.begin() + b * num_candidates;
+              for (auto it = row_candidates;
+                   it != row_candidates + num_candidates; ++it) {
+                filter.push(*it);
+              }
+              if (sorted) {
+                std::unique_ptr<std::vector<Tidx>> top_k(filter.Extract());
+                std::copy(top_k->begin(), top_k->end(), &indices(b, 0));
+              } else {
+                std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+                          &indices(b, 0));
+              }
+              std::transform(
+                  &indices(b, 0), &indices(b, k), &values(b, 0),
+                  [b, &input](const Tidx loc) { return input(b, loc); });
+            }
+          });
+  }
 };
 
 }  // namespace functor
@@ -18,6 +18,14 @@ limitations under the License.
 
 namespace tensorflow {
 
+Status CheckVariableIsNotFrozen(const Var& var, const ResourceHandle& handle) {
+  if (var.frozen.load()) {
+    return errors::FailedPrecondition(
+        "Can't write variable ", handle.name(), " of container ",
+        handle.container(), ", it's frozen");
+  }
+  return OkStatus();
+}
 
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output) {
@@ -27,6 +27,10 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Returns FailedPrecondition if `var`, the variable of `handle`, is frozen
+// (see ResourceMgr::FreezeContainer), before writing it.
+Status CheckVariableIsNotFrozen(const Var& var, const ResourceHandle& handle);
+
 // Must be called before performing a sparse operation on a variable. Ensures
 // that no concurrent dense operations can happen while holding the variable's
 // lock.
@@ -44,7 +48,8 @@ namespace tensorflow {
 template <typename Device, typename T>
 Status EnsureSparseVariableAccess(OpKernelContext* ctx, Var* var,
                                   bool lock_held = false) {
-  if (var->copy_on_read_mode.load()) {
+  // Frozen variables are never written, so their readers can alias them.
+  if (var->copy_on_read_mode.load() || var->frozen.load()) {
     return absl::OkStatus();
   }
 
@@ -265,7 +270,9 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
                                   bool lock_held, bool sparse, Tensor* out) {
   if (ctx->input_dtype(input) == DT_RESOURCE) {
     core::RefCountPtr<Var> var;
-    TF_RETURN_IF_ERROR(LookupResource(ctx, HandleFromInput(ctx, input), &var));
+    const ResourceHandle& handle = HandleFromInput(ctx, input);
+    TF_RETURN_IF_ERROR(LookupResource(ctx, handle, &var));
+    TF_RETURN_IF_ERROR(CheckVariableIsNotFrozen(*var, handle));
     if (sparse) {
       TF_RETURN_IF_ERROR(EnsureSparseVariableAccess<Device, T>(ctx, var.get()));
       *out = *var->tensor();
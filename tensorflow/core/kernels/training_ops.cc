@@ -17,7 +17,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_ops.h"
 
 #include <algorithm>  // NOLINT
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -25,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
@@ -40,6 +47,19 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// The number of locks shared by the rows of all the variables updated by
+// sparse applies with use_row_locking.
+constexpr int kNumRowLockStripes = 1024;
+
+// Returns the lock of the stripe of row `row` of the variable whose buffer
+// starts at `data`.
+mutex* RowLockStripe(const void* data, int64_t row) {
+  static mutex* stripes = new mutex[kNumRowLockStripes];
+  const uint64 hash = Hash64Combine(reinterpret_cast<uintptr_t>(data),
+                                    static_cast<uint64>(row));
+  return &stripes[hash % kNumRowLockStripes];
+}
 }  // namespace
 
 namespace functor {
@@ -242,6 +262,80 @@ struct SparseApplyAdagrad<CPUDevice, T, Tindex, has_epsilon> {
   }
 };
 
+// Like SparseApplyAdagrad on CPU, for applies with use_row_locking, which
+// only hold shared locks of var and accum. The gradients of duplicate indices
+// are summed first, and each row of var and accum is then updated under the
+// lock of its stripe, so that concurrent applies to the same variable don't
+// race on rows.
+template <typename T, typename Tindex, bool has_epsilon>
+Status SparseApplyAdagradWithRowLocks(OpKernelContext* ctx,
+                                      typename TTypes<T>::Matrix var,
+                                      typename TTypes<T>::Matrix accum,
+                                      const T lr, const T epsilon,
+                                      typename TTypes<T>::ConstMatrix grad,
+                                      typename TTypes<Tindex>::ConstVec indices,
+                                      int64_t inner_dim, bool update_slots) {
+  const Tindex N = static_cast<Tindex>(indices.dimension(0));
+  if (N == 0) return OkStatus();
+  const Tindex first_dim_size = static_cast<Tindex>(var.dimension(0));
+  std::vector<Tindex> rows;
+  std::vector<Tindex> positions(N);
+  absl::flat_hash_map<Tindex, Tindex> row_positions;
+  row_positions.reserve(N);
+  for (Tindex i = 0; i < N; ++i) {
+    const Tindex index = internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(index, first_dim_size)) {
+      return errors::InvalidArgument(
+          strings::StrCat("Index ", index, " at offset ", i,
+                          " in indices is out of range"));
+    }
+    auto inserted = row_positions.try_emplace(index, rows.size());
+    if (inserted.second) rows.push_back(index);
+    positions[i] = inserted.first->second;
+  }
+
+  const Tindex num_rows = rows.size();
+  Tensor summed_grad;
+  const T* row_grad_data = grad.data();
+  if (num_rows < N) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({num_rows, inner_dim}),
+        &summed_grad));
+    typename TTypes<T>::Matrix summed = summed_grad.matrix<T>();
+    summed.setZero();
+    for (Tindex i = 0; i < N; ++i) {
+      summed.template chip<0>(positions[i]) += grad.template chip<0>(i);
+    }
+    row_grad_data = summed_grad.flat<T>().data();
+  }
+  typename TTypes<T>::ConstMatrix row_grad(row_grad_data, num_rows, inner_dim);
+
+  const int in_bytes = inner_dim * sizeof(T) * 3;
+  const int out_bytes = inner_dim * sizeof(T) * 2;
+  const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 2 +
+                                  Eigen::TensorOpCost::MulCost<T>() * 2);
+  const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
+  const auto shard = [&](Tindex start, Tindex end) -> void {
+    for (Tindex i = start; i < end; ++i) {
+      const Tindex index = rows[i];
+      auto a = accum.template chip<0>(index);
+      auto g = row_grad.template chip<0>(i);
+      auto v = var.template chip<0>(index);
+      mutex_lock lock(*RowLockStripe(var.data(), index));
+      if (update_slots) {
+        a += g.square();
+      }
+      if (has_epsilon) {
+        v -= g.constant(lr) * g / (a.sqrt() + a.constant(epsilon));
+      } else {
+        v -= g.constant(lr) * g * a.rsqrt();
+      }
+    }
+  };
+  ctx->eigen_device<CPUDevice>().parallelFor(num_rows, cost, shard);
+  return OkStatus();
+}
+
 template <typename T>
 struct ApplyProximalAdagrad<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
@@ -771,6 +865,28 @@ struct SparseApplyAdadelta<CPUDevice, T, Tindex> {
   }
 };
 
+// Applies the Adam update to `size` elements, with `alpha` the step size
+// corrected for the bias of the moments.
+template <typename T>
+void ApplyAdamToSlice(T* var_ptr, T* m_ptr, T* v_ptr, const T* g_ptr,
+                      Index size, T alpha, T beta1, T beta2, T epsilon,
+                      bool use_nesterov) {
+  auto var = typename TTypes<T>::UnalignedTensor(var_ptr, size);
+  auto m = typename TTypes<T>::UnalignedTensor(m_ptr, size);
+  auto v = typename TTypes<T>::UnalignedTensor(v_ptr, size);
+  auto g = typename TTypes<T>::UnalignedConstTensor(g_ptr, size);
+
+  if (use_nesterov) {
+    m += (g - m) * (T(1) - beta1);
+    v += (g.square() - v) * (T(1) - beta2);
+    var -= ((g * (T(1) - beta1) + beta1 * m) * alpha) / (v.sqrt() + epsilon);
+  } else {
+    m += (g - m) * (T(1) - beta1);
+    v += (g.square() - v) * (T(1) - beta2);
+    var -= (m * alpha) / (v.sqrt() + epsilon);
+  }
+}
+
 template <typename Device, typename T>
 struct ApplyAdamNonCuda {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -806,21 +922,9 @@ struct ApplyAdamNonCuda {
                   use_nesterov, packet_size](int begin, int end) {
       int t_size = (end - begin) * packet_size;
       begin = begin * packet_size;
-      auto var = typename TTypes<T>::UnalignedTensor(var_ptr + begin, t_size);
-      auto m = typename TTypes<T>::UnalignedTensor(m_ptr + begin, t_size);
-      auto v = typename TTypes<T>::UnalignedTensor(v_ptr + begin, t_size);
-      auto g = typename TTypes<T>::UnalignedConstTensor(g_ptr + begin, t_size);
-
-      if (use_nesterov) {
-        m += (g - m) * (T(1) - beta1());
-        v += (g.square() - v) * (T(1) - beta2());
-        var -= ((g * (T(1) - beta1()) + beta1() * m) * alpha) /
-               (v.sqrt() + epsilon());
-      } else {
-        m += (g - m) * (T(1) - beta1());
-        v += (g.square() - v) * (T(1) - beta2());
-        var -= (m * alpha) / (v.sqrt() + epsilon());
-      }
+      ApplyAdamToSlice<T>(var_ptr + begin, m_ptr + begin, v_ptr + begin,
+                          g_ptr + begin, t_size, alpha, beta1(), beta2(),
+                          epsilon(), use_nesterov);
     };
 
     // Input data: var, v, m, grad.
@@ -1884,18 +1988,26 @@ class SparseApplyAdagradOp : public OpKernel {
   explicit SparseApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    // Only the resource ops have the attr, and it's ignored off CPU.
+    use_row_locking_ = false;
+    if (ctx->HasAttr("use_row_locking")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    }
+    use_row_locking_ &= std::is_same<Device, CPUDevice>::value;
   }
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
+    // Row locks replace the exclusive locks of the variables.
+    const bool exclusive_lock = use_exclusive_lock_ && !use_row_locking_;
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+        ctx, exclusive_lock, sparse, {0, 1});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
-                            ctx, 0, use_exclusive_lock_, sparse, &var));
+                            ctx, 0, exclusive_lock, sparse, &var));
     Tensor accum;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
-                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+                            ctx, 1, exclusive_lock, sparse, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1938,6 +2050,15 @@ class SparseApplyAdagradOp : public OpKernel {
                 errors::InvalidArgument(
                     "Inner dimension should be greater than zero."));
 
+    if (use_row_locking_) {
+      OP_REQUIRES_OK(ctx, functor::SparseApplyAdagradWithRowLocks<
+                              T, Tindex, /*has_epsilon=*/false>(
+                              ctx, var.flat_outer_dims<T>(),
+                              accum.flat_outer_dims<T>(), lr.scalar<T>()(),
+                              T(0), grad.flat_outer_dims<T>(),
+                              indices.vec<Tindex>(), inner_dim, update_slots_));
+      return;
+    }
     const Device& device = ctx->template eigen_device<Device>();
     OP_REQUIRES_OK(
         ctx, functor::SparseApplyAdagrad<Device, T, Tindex,
@@ -1953,6 +2074,7 @@ class SparseApplyAdagradOp : public OpKernel {
  private:
   bool use_exclusive_lock_;
   bool update_slots_;
+  bool use_row_locking_;
 };
 
 #define REGISTER_KERNELS(D, T, Tindices)                                 \
@@ -2014,18 +2136,26 @@ class SparseApplyAdagradV2Op : public OpKernel {
   explicit SparseApplyAdagradV2Op(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    // Only the resource ops have the attr, and it's ignored off CPU.
+    use_row_locking_ = false;
+    if (ctx->HasAttr("use_row_locking")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_row_locking", &use_row_locking_));
+    }
+    use_row_locking_ &= std::is_same<Device, CPUDevice>::value;
   }
 
   void Compute(OpKernelContext* ctx) override TF_NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
+    // Row locks replace the exclusive locks of the variables.
+    const bool exclusive_lock = use_exclusive_lock_ && !use_row_locking_;
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+        ctx, exclusive_lock, sparse, {0, 1});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
-                            ctx, 0, use_exclusive_lock_, sparse, &var));
+                            ctx, 0, exclusive_lock, sparse, &var));
     Tensor accum;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
-                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+                            ctx, 1, exclusive_lock, sparse, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2072,6 +2202,15 @@ class SparseApplyAdagradV2Op : public OpKernel {
                 errors::InvalidArgument(
                     "Inner dimension should be greater than zero."));
 
+    if (use_row_locking_) {
+      OP_REQUIRES_OK(ctx, functor::SparseApplyAdagradWithRowLocks<
+                              T, Tindex, /*has_epsilon=*/true>(
+                              ctx, var.flat_outer_dims<T>(),
+                              accum.flat_outer_dims<T>(), lr.scalar<T>()(),
+                              epsilon.scalar<T>()(), grad.flat_outer_dims<T>(),
+                              indices.vec<Tindex>(), inner_dim, update_slots_));
+      return;
+    }
     const Device& device = ctx->template eigen_device<Device>();
     OP_REQUIRES_OK(
         ctx, functor::SparseApplyAdagrad<Device, T, Tindex,
@@ -2086,6 +2225,7 @@ class SparseApplyAdagradV2Op : public OpKernel {
  private:
   bool use_exclusive_lock_;
   bool update_slots_;
+  bool use_row_locking_;
 };
 
 #define REGISTER_KERNELS(D, T, Tindices)                                   \
@@ -3654,6 +3794,130 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Applies Adam to a list of variables sharing their hyperparameters, as
+// grouped by the optimizer_apply_fusion grappler pass. All the locks are taken
+// at once, and the updates run in a single parallel loop over blocks of the
+// variables, instead of paying the overhead of a kernel per variable.
+template <typename T>
+class MultiApplyAdamOp : public OpKernel {
+ public:
+  explicit MultiApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_vars_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    // The var, m and v handles are the first inputs.
+    std::vector<int> resource_inputs(3 * num_vars_);
+    std::iota(resource_inputs.begin(), resource_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, sparse, resource_inputs);
+
+    std::vector<Tensor> tensors(3 * num_vars_);
+    for (int i : resource_inputs) {
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                              ctx, i, use_exclusive_lock_, sparse,
+                              &tensors[i]));
+      OP_REQUIRES(ctx, tensors[i].IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      requested_input(i)));
+    }
+
+    const int scalars_begin = 3 * num_vars_;
+    static constexpr const char* kScalarNames[] = {
+        "beta1_power", "beta2_power", "lr", "beta1", "beta2", "epsilon"};
+    T scalars[6];
+    for (int i = 0; i < 6; ++i) {
+      const Tensor& scalar = ctx->input(scalars_begin + i);
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                  errors::InvalidArgument(kScalarNames[i], " is not a scalar: ",
+                                          scalar.shape().DebugString()));
+      scalars[i] = scalar.scalar<T>()();
+    }
+    const T beta1_power = scalars[0];
+    const T beta2_power = scalars[1];
+    const T alpha = scalars[2] * Eigen::numext::sqrt(T(1) - beta2_power) /
+                    (T(1) - beta1_power);
+
+    struct Block {
+      int var;
+      Index begin;
+      Index size;
+    };
+    std::vector<Block> blocks;
+    const int grads_begin = scalars_begin + 6;
+    for (int i = 0; i < num_vars_; ++i) {
+      const Tensor& var = tensors[i];
+      const Tensor& m = tensors[num_vars_ + i];
+      const Tensor& v = tensors[2 * num_vars_ + i];
+      const Tensor& grad = ctx->input(grads_begin + i);
+      OP_REQUIRES(
+          ctx,
+          var.shape().IsSameSize(m.shape()) &&
+              var.shape().IsSameSize(v.shape()) &&
+              var.shape().IsSameSize(grad.shape()),
+          errors::InvalidArgument(
+              "var, m, v and grad ", i, " do not have the same shape: ",
+              var.shape().DebugString(), " ", m.shape().DebugString(), " ",
+              v.shape().DebugString(), " ", grad.shape().DebugString()));
+      for (Index begin = 0; begin < var.NumElements(); begin += kBlockSize) {
+        blocks.push_back(
+            {i, begin, std::min(kBlockSize, var.NumElements() - begin)});
+      }
+    }
+
+    auto shard = [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        const Block& block = blocks[b];
+        ApplyAdamToSliceOf(block.var, block.begin, block.size, tensors,
+                           ctx->input(grads_begin + block.var), alpha,
+                           scalars[3], scalars[4], scalars[5]);
+      }
+    };
+    // Input data: var, m, v, grad. Output data: var, m, v.
+    const Eigen::TensorOpCost cost(
+        kBlockSize * sizeof(T) * 4, kBlockSize * sizeof(T) * 3,
+        (Eigen::TensorOpCost::AddCost<T>() * 10 +
+         Eigen::TensorOpCost::MulCost<T>() * 6 +
+         Eigen::TensorOpCost::DivCost<T>()) *
+            kBlockSize);
+    ctx->eigen_device<CPUDevice>().parallelFor(blocks.size(), cost, shard);
+  }
+
+ private:
+  // The number of elements updated by a unit of work, which keeps the work
+  // of a large variable spread over the threads.
+  static constexpr Index kBlockSize = 16 * 1024;
+
+  void ApplyAdamToSliceOf(int i, Index begin, Index size,
+                          std::vector<Tensor>& tensors, const Tensor& grad,
+                          T alpha, T beta1, T beta2, T epsilon) const {
+    T* var = tensors[i].flat<T>().data();
+    T* m = tensors[num_vars_ + i].flat<T>().data();
+    T* v = tensors[2 * num_vars_ + i].flat<T>().data();
+    functor::ApplyAdamToSlice<T>(var + begin, m + begin, v + begin,
+                                 grad.flat<T>().data() + begin, size, alpha,
+                                 beta1, beta2, epsilon, use_nesterov_);
+  }
+
+  int num_vars_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_CPU_KERNELS(T)                           \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceMultiApplyAdam") \
+                              .Device(DEVICE_CPU)         \
+                              .TypeConstraint<T>("T"),    \
+                          MultiApplyAdamOp<T>);
+
+TF_CALL_FLOAT_TYPES(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdamWithAmsgradOp : public OpKernel {
  public:
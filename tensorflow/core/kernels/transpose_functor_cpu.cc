@@ -15,12 +15,13 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
+#include <cstdint>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/tensor.h"
-#include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
@@ -32,40 +33,151 @@ namespace tensorflow {
 namespace {
 
 template <typename T, bool conjugate>
-void TransposeSimple(const CPUDevice& device, const Tensor& in,
-                     const absl::Span<const int32> perm, Tensor* out) {
-  const int ndims = in.dims();
-  gtl::InlinedVector<int64_t, 8> in_strides =
-      ComputeStride<int64_t>(in.shape());
-  gtl::InlinedVector<int64_t, 8> out_strides =
-      ComputeStride<int64_t>(out->shape());
-  const T* p = reinterpret_cast<const T*>(in.tensor_data().data());
-  T* q = reinterpret_cast<T*>(const_cast<char*>((out->tensor_data().data())));
-  auto transpose_fn = [=, &in_strides, &out_strides, &perm](int64_t begin,
-                                                            int64_t end) {
-    for (int64_t o_idx = begin; o_idx < end; ++o_idx) {
-      int64_t i_idx = 0;
-      int64_t t = o_idx;
-      for (int i = 0; i < ndims; ++i) {
-        const int64_t ratio = t / out_strides[i];
-        t -= ratio * out_strides[i];
-        i_idx += ratio * in_strides[perm[i]];
+inline T MaybeConjugate(const T& x) {
+  if constexpr (conjugate) {
+    return Eigen::numext::conj(x);
+  } else {
+    return x;
+  }
+}
+
+// The side of the square blocks that the tiled transposes work on, small
+// enough for a block of the input and of the output to stay in L1.
+constexpr int64_t kBlockSize = 32;
+
+// Sets out[c * out_stride + r] to in[r * in_stride + c] for the `rows` x
+// `cols` block of `in`.
+template <typename T, bool conjugate>
+void TransposeBlock(const T* in, int64_t in_stride, T* out, int64_t out_stride,
+                    int64_t rows, int64_t cols) {
+  int64_t r = 0;
+  if constexpr (!conjugate && sizeof(T) == sizeof(float)) {
+    // Transposes tiles of as many rows and columns as a float packet has
+    // lanes in registers. Loads, stores and shuffles keep the bits of the
+    // values, so this holds for any 32 bit type.
+    using Packet = typename Eigen::internal::packet_traits<float>::type;
+    constexpr int kPacketSize = Eigen::internal::packet_traits<float>::size;
+    if constexpr (kPacketSize > 1) {
+      for (; r + kPacketSize <= rows; r += kPacketSize) {
+        int64_t c = 0;
+        for (; c + kPacketSize <= cols; c += kPacketSize) {
+          Eigen::internal::PacketBlock<Packet, kPacketSize> tile;
+          for (int i = 0; i < kPacketSize; ++i) {
+            tile.packet[i] = Eigen::internal::ploadu<Packet>(
+                reinterpret_cast<const float*>(in + (r + i) * in_stride + c));
+          }
+          Eigen::internal::ptranspose(tile);
+          for (int i = 0; i < kPacketSize; ++i) {
+            Eigen::internal::pstoreu(
+                reinterpret_cast<float*>(out + (c + i) * out_stride + r),
+                tile.packet[i]);
+          }
+        }
+        for (; c < cols; ++c) {
+          for (int i = 0; i < kPacketSize; ++i) {
+            out[c * out_stride + r + i] = in[(r + i) * in_stride + c];
+          }
+        }
+      }
+    }
+  }
+  for (; r < rows; ++r) {
+    for (int64_t c = 0; c < cols; ++c) {
+      out[c * out_stride + r] =
+          MaybeConjugate<T, conjugate>(in[r * in_stride + c]);
+    }
+  }
+}
+
+// Transposes `in` of shape `dims` by `perm`, where `dims` and `perm` were
+// reduced by ReduceTransposeDimensions so that no two consecutive input
+// dimensions stay consecutive in the output.
+//
+// If the innermost dimension stays innermost, this copies its contiguous
+// runs. Otherwise the innermost dimensions of the input and of the output
+// form a matrix, for all values of the other dimensions, which is transposed
+// a block of kBlockSize x kBlockSize at a time.
+template <typename T, bool conjugate>
+void TransposeBlocked(const CPUDevice& device, const T* in,
+                      const internal::TransposeDimsVec& dims,
+                      const internal::TransposePermsVec& perm, T* out) {
+  const int ndims = dims.size();
+  internal::TransposeDimsVec in_strides(ndims);
+  internal::TransposeDimsVec out_strides(ndims);  // Of the input dimensions.
+  int64_t num_elements = 1;
+  for (int i = ndims - 1; i >= 0; --i) {
+    in_strides[i] = num_elements;
+    num_elements *= dims[i];
+  }
+  for (int64_t i = ndims - 1, stride = 1; i >= 0; --i) {
+    out_strides[perm[i]] = stride;
+    stride *= dims[perm[i]];
+  }
+
+  const int inner = ndims - 1;
+  if (perm[ndims - 1] == inner) {
+    // Copies the runs of the innermost dimension, in the order of the output.
+    const int64_t run = dims[inner];
+    auto copy_runs = [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; ++j) {
+        int64_t in_offset = 0;
+        for (int64_t i = ndims - 2, t = j; i >= 0; --i) {
+          in_offset += (t % dims[perm[i]]) * in_strides[perm[i]];
+          t /= dims[perm[i]];
+        }
+        const T* src = in + in_offset;
+        T* dst = out + j * run;
+        for (int64_t k = 0; k < run; ++k) {
+          dst[k] = MaybeConjugate<T, conjugate>(src[k]);
+        }
       }
-      if (conjugate) {
-        q[o_idx] = Eigen::numext::conj(p[i_idx]);
-      } else {
-        q[o_idx] = p[i_idx];
+    };
+    const Eigen::TensorOpCost cost(run * sizeof(T), run * sizeof(T),
+                                   run + ndims * 4);
+    device.parallelFor(num_elements / run, cost, copy_runs);
+    return;
+  }
+
+  // The rows of the matrix are the input dimension that is innermost in the
+  // output, and its columns the innermost input dimension.
+  const int rows_dim = perm[ndims - 1];
+  const int64_t rows = dims[rows_dim];
+  const int64_t cols = dims[inner];
+  internal::TransposeDimsVec outer_dims;
+  for (int i = 0; i < ndims; ++i) {
+    if (i != rows_dim && i != inner) outer_dims.push_back(i);
+  }
+  const int64_t row_blocks = Eigen::divup(rows, kBlockSize);
+  const int64_t col_blocks = Eigen::divup(cols, kBlockSize);
+  const int64_t blocks_per_matrix = row_blocks * col_blocks;
+  auto transpose_blocks = [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      int64_t in_offset = 0;
+      int64_t out_offset = 0;
+      for (int64_t i = static_cast<int64_t>(outer_dims.size()) - 1,
+                   t = b / blocks_per_matrix;
+           i >= 0; --i) {
+        const int dim = outer_dims[i];
+        const int64_t index = t % dims[dim];
+        t /= dims[dim];
+        in_offset += index * in_strides[dim];
+        out_offset += index * out_strides[dim];
       }
+      const int64_t row = (b % blocks_per_matrix) / col_blocks * kBlockSize;
+      const int64_t col = (b % col_blocks) * kBlockSize;
+      TransposeBlock<T, conjugate>(
+          in + in_offset + row * in_strides[rows_dim] + col,
+          in_strides[rows_dim],
+          out + out_offset + col * out_strides[inner] + row,
+          out_strides[inner], std::min(kBlockSize, rows - row),
+          std::min(kBlockSize, cols - col));
     }
   };
-  double cycles_per_element =
-      (conjugate ? 1 : 0) +
-      ndims * (Eigen::TensorOpCost::DivCost<int64_t>() +
-               2 * Eigen::TensorOpCost::MulCost<int64_t>() +
-               2 * Eigen::TensorOpCost::AddCost<int64_t>());
-  Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T),
-                           /*bytes_stored=*/sizeof(T), cycles_per_element);
-  device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
+  const Eigen::TensorOpCost cost(kBlockSize * kBlockSize * sizeof(T),
+                                 kBlockSize * kBlockSize * sizeof(T),
+                                 kBlockSize * kBlockSize + ndims * 4);
+  device.parallelFor(num_elements / (rows * cols) * blocks_per_matrix, cost,
+                     transpose_blocks);
 }
 
 }  // namespace
@@ -74,39 +186,30 @@ template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const absl::Span<const int32> perm, Tensor* out) {
-    switch (in.dims()) {
-      case 2:
-        internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 3:
-        internal::TransposeUsingEigen<CPUDevice, T, 3>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 4:
-        internal::TransposeUsingEigen<CPUDevice, T, 4>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 5:
-        internal::TransposeUsingEigen<CPUDevice, T, 5>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 6:
-        internal::TransposeUsingEigen<CPUDevice, T, 6>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 7:
-        internal::TransposeUsingEigen<CPUDevice, T, 7>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      case 8:
-        internal::TransposeUsingEigen<CPUDevice, T, 8>(d, in, perm, conjugate,
-                                                       out);
-        break;
-      default:
-        TransposeSimple<T, conjugate>(d, in, perm, out);
-        break;
+    const T* p = reinterpret_cast<const T*>(in.tensor_data().data());
+    T* q = reinterpret_cast<T*>(const_cast<char*>((out->tensor_data().data())));
+    if (in.NumElements() == 0) return;
+    if (in.dims() == 0) {
+      q[0] = MaybeConjugate<T, conjugate>(p[0]);
+      return;
+    }
+    // Merging the dimensions that stay consecutive leaves fewer, larger
+    // dimensions to permute.
+    internal::TransposePermsVec new_perm;
+    internal::TransposeDimsVec new_dims;
+    if (in.dims() == 1) {
+      new_perm = {0};
+      new_dims = {in.dim_size(0)};
+    } else {
+      // This gives the output position of each merged input dimension, the
+      // inverse of the permutation of the merged dimensions.
+      internal::TransposePermsVec positions;
+      internal::ReduceTransposeDimensions(in.shape(), perm, &positions,
+                                          &new_dims);
+      new_perm.resize(positions.size());
+      for (size_t i = 0; i < positions.size(); ++i) new_perm[positions[i]] = i;
     }
+    TransposeBlocked<T, conjugate>(d, p, new_dims, new_perm, q);
   }
 };
 
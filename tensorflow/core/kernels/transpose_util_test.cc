@@ -13,10 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -130,4 +138,63 @@ TEST_F(TransposeUtilTest, NonSingletonDimensionAlignment) {
                                                      {0, 1, 2, 5, 4, 3}));
 }
 
+// Transposes `in` by `perm` one element at a time.
+template <typename T>
+Tensor NaiveTranspose(const Tensor& in, const std::vector<int32>& perm,
+                      bool conjugate) {
+  TensorShape out_shape;
+  for (int32 p : perm) out_shape.AddDim(in.dim_size(p));
+  Tensor out(in.dtype(), out_shape);
+  const auto in_flat = in.flat<T>();
+  auto out_flat = out.flat<T>();
+  std::vector<int64_t> index(in.dims());
+  for (int64_t o = 0; o < out.NumElements(); ++o) {
+    int64_t t = o;
+    for (int d = 0; d < in.dims(); ++d) {
+      int64_t stride = 1;
+      for (int k = d + 1; k < in.dims(); ++k) stride *= out.dim_size(k);
+      index[perm[d]] = t / stride;
+      t %= stride;
+    }
+    int64_t i = 0;
+    for (int d = 0; d < in.dims(); ++d) i = i * in.dim_size(d) + index[d];
+    out_flat(o) = conjugate ? Eigen::numext::conj(in_flat(i)) : in_flat(i);
+  }
+  return out;
+}
+
+TEST(TransposeCpuTest, MatchesNaiveTranspose) {
+  thread::ThreadPool pool(Env::Default(), "transpose", 4);
+  Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), 4);
+  // Covers copies of contiguous runs, matrix transposes smaller and larger
+  // than a block with partial blocks, and higher rank permutations.
+  const std::vector<std::pair<TensorShape, std::vector<int32>>> cases = {
+      {{7}, {0}},
+      {{37, 70}, {1, 0}},
+      {{3, 5, 7}, {0, 2, 1}},
+      {{2, 33, 41}, {2, 1, 0}},
+      {{4, 9, 6, 8}, {0, 2, 1, 3}},
+      {{3, 4, 1, 5}, {1, 3, 0, 2}},
+      {{2, 3, 4, 5, 6}, {4, 2, 0, 3, 1}},
+      {{2, 3, 2, 3, 2, 3, 2, 3, 2}, {8, 1, 6, 3, 4, 5, 2, 7, 0}},
+  };
+  for (const auto& [shape, perm] : cases) {
+    Tensor in(DT_FLOAT, shape);
+    in.flat<float>().setRandom();
+    TensorShape out_shape;
+    for (int32 p : perm) out_shape.AddDim(shape.dim_size(p));
+    Tensor out(DT_FLOAT, out_shape);
+    TF_ASSERT_OK(DoTranspose(device, in, perm, &out));
+    test::ExpectTensorEqual<float>(out, NaiveTranspose<float>(in, perm, false));
+
+    Tensor complex_in(DT_COMPLEX64, shape);
+    complex_in.flat<complex64>().setRandom();
+    Tensor complex_out(DT_COMPLEX64, out_shape);
+    TF_ASSERT_OK(
+        DoConjugateTranspose(device, complex_in, perm, &complex_out));
+    test::ExpectTensorEqual<complex64>(
+        complex_out, NaiveTranspose<complex64>(complex_in, perm, true));
+  }
+}
+
 }  // namespace tensorflow
@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -149,6 +153,12 @@ class UniqueOp : public OpKernel {
       // to them as in the general case.
       auto Tin = input.flat<T>();
       const int64_t N = static_cast<int64_t>(Tin.size());
+      if (N >= kParallelMinSize &&
+          context->device()->tensorflow_cpu_worker_threads()->num_threads >
+              1) {
+        ComputeParallel(context, input, axis, idx);
+        return;
+      }
 
       typename UniqueOpHashMap<T, TIndex>::map_type uniq;
       uniq.reserve(2 * N);
@@ -237,6 +247,159 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Vectors of at least this many elements are uniquified by all the intra-op
+  // threads.
+  static constexpr int64_t kParallelMinSize = 1 << 20;
+  static constexpr int kMaxPartitions = 64;
+  // Marks, in the partition of an element, its first occurrence.
+  static constexpr uint8 kFirstOccurrence = 0x80;
+
+  // Uniquifies the vector `input`, with the same outputs as the sequential
+  // implementation. The elements are partitioned by hash, and each partition
+  // is uniquified by a thread of its own, in the order of the input. The
+  // unique elements are then numbered by their first occurrence: that is the
+  // order in which they come in the input, once marked.
+  void ComputeParallel(OpKernelContext* context, const Tensor& input,
+                       int64_t axis, Tensor* idx) {
+    using MapType = typename UniqueOpHashMap<T, TIndex>::map_type;
+    auto Tin = input.flat<T>();
+    auto idx_vec = idx->template vec<TIndex>();
+    const int64_t N = static_cast<int64_t>(Tin.size());
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int num_partitions =
+        std::min(worker_threads.num_threads, kMaxPartitions);
+    // The input is split in blocks so that the positions of each partition
+    // can be listed in parallel, and in order.
+    const int64_t num_blocks = 4 * num_partitions;
+    const int64_t block_size = Eigen::divup(N, num_blocks);
+    const auto for_each_block = [&](int64_t cost_per_element,
+                                    const std::function<void(int64_t, int64_t,
+                                                             int64_t)>& fn) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            block_size * cost_per_element, [&](int64_t start, int64_t limit) {
+              for (int64_t b = start; b < limit; ++b) {
+                fn(b, std::min(N, b * block_size),
+                   std::min(N, (b + 1) * block_size));
+              }
+            });
+    };
+
+    // Partitions by a remix of the hash, since the maps take their buckets
+    // from its bits.
+    const typename MapType::hasher hasher;
+    std::vector<uint8> partition(N);
+    // The number of elements of every partition in every block, then their
+    // offset in `positions`.
+    std::vector<int64_t> offsets(num_blocks * num_partitions, 0);
+    for_each_block(50, [&](int64_t b, int64_t begin, int64_t end) {
+      int64_t* counts = &offsets[b * num_partitions];
+      for (int64_t i = begin; i < end; ++i) {
+        const uint64 h =
+            static_cast<uint64>(hasher(Tin(i))) * 0x9E3779B97F4A7C15ull;
+        const uint8 p = static_cast<uint8>(((h >> 32) * num_partitions) >> 32);
+        partition[i] = p;
+        ++counts[p];
+      }
+    });
+    std::vector<int64_t> partition_starts(num_partitions + 1);
+    int64_t offset = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_starts[p] = offset;
+      for (int64_t b = 0; b < num_blocks; ++b) {
+        const int64_t count = offsets[b * num_partitions + p];
+        offsets[b * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+    partition_starts[num_partitions] = N;
+    // The positions of the elements, partition by partition, in increasing
+    // order within each. The input has fewer than 2^31 elements.
+    std::vector<int32> positions(N);
+    for_each_block(5, [&](int64_t b, int64_t begin, int64_t end) {
+      int64_t* block_offsets = &offsets[b * num_partitions];
+      for (int64_t i = begin; i < end; ++i) {
+        positions[block_offsets[partition[i]]++] = static_cast<int32>(i);
+      }
+    });
+
+    // Each partition numbers its unique elements in their order of first
+    // occurrence, in `idx_vec`, and counts them.
+    std::vector<std::vector<TIndex>> partition_counts(num_partitions);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          Eigen::divup(N, int64_t{num_partitions}) * 200,
+          [&](int64_t start, int64_t limit) {
+            for (int64_t p = start; p < limit; ++p) {
+              std::vector<TIndex>& counts = partition_counts[p];
+              MapType uniq;
+              uniq.reserve(2 * (partition_starts[p + 1] - partition_starts[p]));
+              for (int64_t k = partition_starts[p];
+                   k < partition_starts[p + 1]; ++k) {
+                const int64_t i = positions[k];
+                auto it = uniq.emplace(Tin(i),
+                                       static_cast<TIndex>(counts.size()));
+                if (it.second) {
+                  partition[i] |= kFirstOccurrence;
+                  counts.push_back(0);
+                }
+                idx_vec(i) = it.first->second;
+                ++counts[it.first->second];
+              }
+            }
+          });
+
+    // The first unique element of every block.
+    std::vector<int64_t> block_starts(num_blocks + 1, 0);
+    for_each_block(1, [&](int64_t b, int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        block_starts[b + 1] += (partition[i] & kFirstOccurrence) != 0;
+      }
+    });
+    for (int64_t b = 0; b < num_blocks; ++b) {
+      block_starts[b + 1] += block_starts[b];
+    }
+    const int64_t uniq_size = block_starts[num_blocks];
+
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+    TIndex* count_data = nullptr;
+    if (num_outputs() > 2) {
+      Tensor* count_output = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &count_output));
+      count_data = count_output->template flat<TIndex>().data();
+    }
+
+    std::vector<std::vector<TIndex>> partition_ids(num_partitions);
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_ids[p].resize(partition_counts[p].size());
+    }
+    for_each_block(5, [&](int64_t b, int64_t begin, int64_t end) {
+      TIndex id = static_cast<TIndex>(block_starts[b]);
+      for (int64_t i = begin; i < end; ++i) {
+        if ((partition[i] & kFirstOccurrence) == 0) continue;
+        const int p = partition[i] & ~kFirstOccurrence;
+        const TIndex local_id = idx_vec(i);
+        partition_ids[p][local_id] = id;
+        Tout(id) = Tin(i);
+        if (count_data != nullptr) {
+          count_data[id] = partition_counts[p][local_id];
+        }
+        ++id;
+      }
+    });
+    for_each_block(2, [&](int64_t b, int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        idx_vec(i) =
+            partition_ids[partition[i] & ~kFirstOccurrence][idx_vec(i)];
+      }
+    });
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                      \
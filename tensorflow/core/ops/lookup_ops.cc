@@ -411,6 +411,17 @@ REGISTER_OP("AnonymousMutableHashTable")
     .SetIsStateful()
     .SetShapeFn(MutableHashTableShapeFn);
 
+REGISTER_OP("MutableStripedHashTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("num_shards: int >= 1 = 64")
+    .SetIsStateful()
+    .SetShapeFn(MutableHashTableShapeFn);
+
 REGISTER_OP("MutableHashTableOfTensors")
     .Output("table_handle: Ref(string)")
     .Attr("container: string = ''")
@@ -441,6 +452,21 @@ REGISTER_OP("AnonymousMutableHashTableOfTensors")
     .SetIsStateful()
     .SetShapeFn(MutableHashTableOfTensorsShapeFn);
 
+REGISTER_OP("TieredHashTableOfTensors")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: {int64}")
+    .Attr("value_dtype: {double, float, int32, int64}")
+    .Attr("value_shape: shape = {}")
+    .Attr("storage_directory: string")
+    .Attr("cache_capacity: int >= 1")
+    .Attr("segment_bytes: int = 67108864")
+    .Attr("compaction_interval_secs: int = 60")
+    .SetIsStateful()
+    .SetShapeFn(MutableHashTableOfTensorsShapeFn);
+
 REGISTER_OP("MutableDenseHashTable")
     .Input("empty_key: key_dtype")
     .Output("table_handle: Ref(string)")
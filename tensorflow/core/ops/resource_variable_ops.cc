@@ -256,6 +256,7 @@ REGISTER_OP("ResourceGather")
     .Input("indices: Tindices")
     .Attr("batch_dims: int = 0")
     .Attr("validate_indices: bool = true")
+    .Attr("deduplicate_indices: bool = false")
     .Output("output: dtype")
     .Attr("dtype: type")
     .Attr("Tindices: {int32,int64}")
@@ -310,6 +311,50 @@ REGISTER_OP("ResourceGather")
       return absl::OkStatus();
     });
 
+REGISTER_OP("_FusedResourceSparseSegmentReduce")
+    .Input("resource: resource")
+    .Input("ids: Tindices")
+    .Input("indices: Tidx")
+    .Input("segment_ids: Tsegmentids")
+    .Output("output: dtype")
+    .Attr("dtype: {float, double}")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .Attr("Tsegmentids: {int32, int64} = DT_INT32")
+    .Attr("combiner: {'sum', 'mean'}")
+    .SetShapeFn([](InferenceContext* c) {
+      std::vector<ShapeAndType> handle_shape_and_type;
+      TF_RETURN_IF_ERROR(shape_inference::ValidateVariableResourceHandle(
+          c, &handle_shape_and_type));
+      ShapeHandle params_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(handle_shape_and_type[0].shape, 1,
+                                            &params_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      ShapeHandle indices_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &indices_shape));
+      TF_RETURN_IF_ERROR(c->Merge(indices_shape, c->input(3), &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(params_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->Vector(InferenceContext::kUnknownDim), subshape, &out));
+      c->set_output(0, out);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Internal operation which is a composition of ResourceGather (with batch_dims 0)
+and SparseSegmentSum or SparseSegmentMean, depending on `combiner`: reserved
+for internal use.
+
+The rows of the variable are read and accumulated into their segment directly,
+without materializing the gathered tensor.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("ResourceGatherNd")
     .Input("resource: resource")
     .Input("indices: Tindices")
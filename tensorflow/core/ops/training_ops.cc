@@ -305,6 +305,7 @@ REGISTER_OP("ResourceSparseApplyAdagrad")
     .Attr("Tindices: {int32, int64}")
     .Attr("use_locking: bool = false")
     .Attr("update_slots: bool = true")
+    .Attr("use_row_locking: bool = false")
     .SetShapeFn(ApplyAdagradShapeFn</*is_sparse=*/true, /*is_resource=*/true>);
 
 template <bool is_sparse, bool is_resource>
@@ -374,6 +375,7 @@ REGISTER_OP("ResourceSparseApplyAdagradV2")
     .Attr("Tindices: {int32, int64}")
     .Attr("use_locking: bool = false")
     .Attr("update_slots: bool = true")
+    .Attr("use_row_locking: bool = false")
     .SetShapeFn(
         ApplyAdagradV2ShapeFn</*is_sparse=*/true, /*is_resource=*/true>);
 
@@ -831,6 +833,41 @@ REGISTER_OP("ResourceApplyAdam")
     .Attr("use_nesterov: bool = false")
     .SetShapeFn(ApplyAdamShapeFn</*is_resource=*/true>);
 
+// ResourceApplyAdam of N variables sharing their hyperparameters at once,
+// created by the optimizer_apply_fusion grappler pass.
+REGISTER_OP("_ResourceMultiApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      ShapeHandle unused;
+      for (int i = 3 * n; i < 3 * n + 6; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      for (int i = 0; i < n; ++i) {
+        ShapeHandle s = ShapeOrHandleShape</*is_resource=*/true>(c, i);
+        TF_RETURN_IF_ERROR(c->Merge(
+            s, ShapeOrHandleShape</*is_resource=*/true>(c, n + i), &s));
+        TF_RETURN_IF_ERROR(c->Merge(
+            s, ShapeOrHandleShape</*is_resource=*/true>(c, 2 * n + i), &s));
+        TF_RETURN_IF_ERROR(c->Merge(s, c->input(3 * n + 6 + i), &s));
+      }
+      return absl::OkStatus();
+    });
+
 template <bool is_resource>
 static Status ApplyAdamWithAmsgradShapeFn(InferenceContext* c) {
   ShapeHandle unused;
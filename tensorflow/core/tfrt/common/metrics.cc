@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "absl/strings/str_cat.h"
+#include "tsl/lib/monitoring/gauge.h"
 #include "tsl/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -45,5 +46,15 @@ tsl::monitoring::SamplerCell* GetTfrtDeviceExecutionLatency(
   return cell->GetCell(model_name, absl::StrCat(model_version));
 }
 
+tsl::monitoring::GaugeCell<int64_t>* GetIfrtVariableLoadLatencyGauge(
+    const std::string& variable_name) {
+  static auto* gauge = tsl::monitoring::Gauge<int64_t, 1>::New(
+      "/tfrt/ifrt/variable_load_latency",
+      "Tracks the time (in microseconds) to restore a variable and load it "
+      "onto its devices with IFRT.",
+      "variable_name");
+  return gauge->GetCell(variable_name);
+}
+
 }  // namespace tfrt_metrics
 }  // namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 #include <string>
 
+#include "tsl/lib/monitoring/gauge.h"
 #include "tsl/lib/monitoring/sampler.h"
 
 namespace tensorflow {
@@ -31,6 +32,12 @@ tsl::monitoring::SamplerCell* GetTfrtGraphExecutorLatencySampler(
 tsl::monitoring::SamplerCell* GetTfrtDeviceExecutionLatency(
     const std::string& model_name, int64_t model_version);
 
+// Returns the gauge of the time it took to load the variable `variable_name`
+// onto its devices with IFRT, from the load being requested at model load until
+// the variable was ready on the devices. This includes restoring the variable.
+tsl::monitoring::GaugeCell<int64_t>* GetIfrtVariableLoadLatencyGauge(
+    const std::string& variable_name);
+
 }  // namespace tfrt_metrics
 }  // namespace tensorflow
 
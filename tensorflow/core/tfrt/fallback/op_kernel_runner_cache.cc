@@ -14,15 +14,47 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner_cache.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/base/casts.h"
+#include "absl/hash/hash.h"
 
 namespace tensorflow {
 namespace tfrt_stub {
+namespace {
+
+// An entry of the per-thread memo of the runners returned by the caches.
+struct MemoEntry {
+  // 0 for the empty entries, as the cache ids start at 1.
+  uint64_t cache_id = 0;
+  const void* handler = nullptr;
+  decltype(tfrt::Location::data) data = 0;
+  OpKernelRunner* runner = nullptr;
+};
+
+// The memo is direct-mapped: an entry is overwritten by the next op that maps
+// to it, which merely sends that op back to the map.
+constexpr size_t kMemoSize = 256;
+
+MemoEntry& GetMemoEntry(uint64_t cache_id, tfrt::Location loc) {
+  thread_local MemoEntry memo[kMemoSize];
+  return memo[absl::HashOf(cache_id, OpLocationKey(loc)) % kMemoSize];
+}
+
+uint64_t NextCacheId() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+OpKernelRunnerCache::OpKernelRunnerCache() : id_(NextCacheId()) {}
 
 StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     tfrt::Location loc, absl::string_view op_name,
@@ -31,6 +63,31 @@ StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreate(
     const tensorflow::DeviceMgr& device_manager,
     const tensorflow::ProcessFunctionLibraryRuntime&
         process_function_library_runtime) {
+  MemoEntry& entry = GetMemoEntry(id_, loc);
+  if (entry.cache_id == id_ && entry.handler == loc.GetHandler() &&
+      entry.data == loc.data) {
+    DCHECK_EQ(entry.runner->op_kernel()->def().op(), op_name);
+    return entry.runner;
+  }
+
+  TF_ASSIGN_OR_RETURN(
+      auto* runner,
+      GetOrCreateSlow(loc, op_name, device_name, num_args, attr_builder,
+                      device_manager, process_function_library_runtime));
+  entry.cache_id = id_;
+  entry.handler = loc.GetHandler();
+  entry.data = loc.data;
+  entry.runner = runner;
+  return runner;
+}
+
+StatusOr<OpKernelRunner*> OpKernelRunnerCache::GetOrCreateSlow(
+    tfrt::Location loc, absl::string_view op_name,
+    absl::string_view device_name, int num_args,
+    const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
+    const tensorflow::DeviceMgr& device_manager,
+    const tensorflow::ProcessFunctionLibraryRuntime&
+        process_function_library_runtime) {
   OpLocationKey key(loc);
   {
     tf_shared_lock lock(mu_);
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_FALLBACK_OP_KERNEL_RUNNER_CACHE_H_
 #define TENSORFLOW_CORE_TFRT_FALLBACK_OP_KERNEL_RUNNER_CACHE_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -47,9 +48,13 @@ class OpLocationKey {
 };
 
 // OpKernelRunnerCache is similar to OpKernelRunnerTable but thread-safe.
+//
+// Runners are never removed from the cache, so each thread memoizes the
+// runners it looked up, and the lookups of an op it already ran take neither
+// the lock nor the map.
 class OpKernelRunnerCache {
  public:
-  OpKernelRunnerCache() = default;
+  OpKernelRunnerCache();
 
   StatusOr<OpKernelRunner*> GetOrCreate(
       tfrt::Location loc, absl::string_view op_name,
@@ -60,6 +65,18 @@ class OpKernelRunnerCache {
           process_function_library_runtime);
 
  private:
+  StatusOr<OpKernelRunner*> GetOrCreateSlow(
+      tfrt::Location loc, absl::string_view op_name,
+      absl::string_view device_name, int num_args,
+      const std::function<Status(tensorflow::AttrValueMap*)>& attr_builder,
+      const tensorflow::DeviceMgr& device_manager,
+      const tensorflow::ProcessFunctionLibraryRuntime&
+          process_function_library_runtime);
+
+  // Identifies the cache in the per-thread memos. Unlike the address of the
+  // cache, it is never reused, so the memos outliving a cache are harmless.
+  const uint64_t id_;
+
   mutable mutex mu_;
   absl::flat_hash_map<OpLocationKey, std::unique_ptr<OpKernelRunner>> map_
       TF_GUARDED_BY(mu_);
@@ -126,6 +126,44 @@ TEST(OpKernelRunnerTest, OpKernelRunnerCache) {
   EXPECT_EQ(runner->op_kernel()->name(), "TestOp_100_0");
 }
 
+TEST(OpKernelRunnerTest, OpKernelRunnerCachesDoNotShareRunners) {
+  tensorflow::SessionOptions session_options;
+  tensorflow::FunctionDefLibrary fdef_lib;
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state,
+                          FallbackState::Create(session_options, fdef_lib));
+
+  tfrt::Location loc(/*handler=*/nullptr, /*data=*/100);
+  auto get_or_create = [&](OpKernelRunnerCache& cache) {
+    return cache.GetOrCreate(
+        loc,
+        /*op_name=*/"TestOp",
+        /*device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0",
+        /*num_args=*/1,
+        /*attr_builder=*/
+        [](tensorflow::AttrValueMap*) { return absl::OkStatus(); },
+        fallback_state->device_manager(),
+        fallback_state->process_function_library_runtime());
+  };
+
+  OpKernelRunnerCache cache;
+  TF_ASSERT_OK_AND_ASSIGN(auto* runner, get_or_create(cache));
+  TF_ASSERT_OK_AND_ASSIGN(auto* memoized_runner, get_or_create(cache));
+  EXPECT_EQ(memoized_runner, runner);
+
+  // A cache doesn't return the runners memoized for another cache at the same
+  // location, even one that was destroyed.
+  auto other_cache = std::make_unique<OpKernelRunnerCache>();
+  TF_ASSERT_OK_AND_ASSIGN(auto* other_runner, get_or_create(*other_cache));
+  EXPECT_NE(other_runner, runner);
+  other_cache.reset();
+  other_cache = std::make_unique<OpKernelRunnerCache>();
+  TF_ASSERT_OK_AND_ASSIGN(other_runner, get_or_create(*other_cache));
+  TF_ASSERT_OK_AND_ASSIGN(auto* other_memoized_runner,
+                          get_or_create(*other_cache));
+  EXPECT_EQ(other_memoized_runner, other_runner);
+  EXPECT_EQ(other_runner->op_kernel()->name(), "TestOp_100_0");
+}
+
 TEST(OpKernelRunnerTest, OpKernelRunState) {
   SessionOptions options;
   auto* device_count = options.config.mutable_device_count();
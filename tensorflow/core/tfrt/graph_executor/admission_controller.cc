@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/graph_executor/admission_controller.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+// The weight of the cost of each finished request in the estimate of its
+// signature, against the requests before it.
+constexpr double kDecay = 0.1;
+
+}  // namespace
+
+struct AdmissionController::SignatureCost {
+  // Zero until a request of the signature finished.
+  absl::Duration estimate;
+};
+
+AdmissionController::AdmissionController(const Options& options)
+    : options_(options),
+      capacity_(options.horizon * options.num_cpus *
+                options.target_utilization) {}
+
+AdmissionController::~AdmissionController() = default;
+
+absl::StatusOr<AdmissionController::Ticket> AdmissionController::Admit(
+    absl::string_view signature) {
+  absl::MutexLock lock(&mu_);
+  auto& signature_cost = signature_costs_[signature];
+  if (signature_cost == nullptr) {
+    signature_cost = std::make_unique<SignatureCost>();
+  }
+
+  const absl::Duration estimated_cost = signature_cost->estimate;
+  if (num_in_flight_ > 0 && in_flight_cost_ + estimated_cost > capacity_) {
+    return absl::UnavailableError(absl::StrCat(
+        "Rejected a request of ", signature, " as the server is overloaded: ",
+        num_in_flight_, " requests in flight, taking an estimated ",
+        absl::FormatDuration(in_flight_cost_), " of CPU time, over ",
+        options_.num_cpus, " CPUs and ",
+        absl::FormatDuration(options_.horizon), "."));
+  }
+
+  in_flight_cost_ += estimated_cost;
+  ++num_in_flight_;
+  Ticket ticket;
+  ticket.signature_cost = signature_cost.get();
+  ticket.estimated_cost = estimated_cost;
+  return ticket;
+}
+
+void AdmissionController::Finish(const Ticket& ticket,
+                                 std::optional<absl::Duration> cost) {
+  absl::MutexLock lock(&mu_);
+  in_flight_cost_ -= ticket.estimated_cost;
+  --num_in_flight_;
+  if (!cost.has_value()) return;
+
+  auto& estimate = ticket.signature_cost->estimate;
+  if (estimate == absl::ZeroDuration()) {
+    estimate = *cost;
+  } else {
+    estimate = (1 - kDecay) * estimate + kDecay * *cost;
+  }
+}
+
+absl::Duration AdmissionController::EstimatedCost(
+    absl::string_view signature) const {
+  absl::MutexLock lock(&mu_);
+  auto it = signature_costs_.find(signature);
+  if (it == signature_costs_.end()) return absl::ZeroDuration();
+  return it->second->estimate;
+}
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_ADMISSION_CONTROLLER_H_
+#define TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_ADMISSION_CONTROLLER_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+
+// AdmissionController rejects the requests that would overload the CPUs,
+// which keeps the latency of the admitted requests flat, instead of letting
+// every request queue up for the threads.
+//
+// It keeps a moving estimate of the cost of the requests of each signature,
+// and the sum of the estimated costs of the requests in flight. A request is
+// rejected when the in-flight work, with its own, would take more than
+// `target_utilization` of the `num_cpus` CPUs over the next `horizon`. A
+// request is always admitted when none is in flight, so that a signature
+// costlier than the horizon still runs.
+//
+// Thread-safe.
+class AdmissionController {
+ private:
+  struct SignatureCost;
+
+ public:
+  struct Options {
+    // The fraction of the CPUs that the in-flight work may take, e.g. 0.9.
+    double target_utilization = 1.0;
+    // The number of CPUs that run the requests.
+    int num_cpus = 1;
+    // The time over which the in-flight work is projected, which roughly
+    // bounds the time that an admitted request waits for the requests ahead
+    // of it.
+    absl::Duration horizon = absl::Milliseconds(100);
+  };
+
+  // The admission of a request, to be passed back to Finish().
+  class Ticket {
+   private:
+    friend class AdmissionController;
+    SignatureCost* signature_cost = nullptr;
+    absl::Duration estimated_cost;
+  };
+
+  explicit AdmissionController(const Options& options);
+  ~AdmissionController();
+
+  // Admits a request of `signature`, or returns an Unavailable error when
+  // admitting it would exceed the target utilization.
+  absl::StatusOr<Ticket> Admit(absl::string_view signature);
+
+  // Marks the request admitted with `ticket` as finished. `cost` is what the
+  // request took, which refines the estimate of its signature; a request that
+  // failed may pass std::nullopt to leave the estimate alone.
+  void Finish(const Ticket& ticket, std::optional<absl::Duration> cost);
+
+  // The estimated cost of a request of `signature`, zero before any request of
+  // the signature finished.
+  absl::Duration EstimatedCost(absl::string_view signature) const;
+
+ private:
+  const Options options_;
+  const absl::Duration capacity_;
+
+  mutable absl::Mutex mu_;
+  // The costs by signature, which are never removed, so that the tickets can
+  // point to them. For pointer stability of the values, additional
+  // `std::unique_ptr<>` is necessary.
+  absl::flat_hash_map<std::string, std::unique_ptr<SignatureCost>>
+      signature_costs_ ABSL_GUARDED_BY(mu_);
+  // The sum of the estimated costs of the requests in flight.
+  absl::Duration in_flight_cost_ ABSL_GUARDED_BY(mu_);
+  int num_in_flight_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_ADMISSION_CONTROLLER_H_
@@ -0,0 +1,105 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/graph_executor/admission_controller.h"
+
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/status_matchers.h"
+#include "tsl/platform/statusor.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+using ::tsl::testing::StatusIs;
+
+AdmissionController::Options TestOptions() {
+  AdmissionController::Options options;
+  options.target_utilization = 0.5;
+  options.num_cpus = 4;
+  options.horizon = absl::Milliseconds(100);
+  // The in-flight work may take 200ms of CPU time.
+  return options;
+}
+
+TEST(AdmissionControllerTest, LearnsCostBySignature) {
+  AdmissionController controller(TestOptions());
+  EXPECT_EQ(controller.EstimatedCost("a"), absl::ZeroDuration());
+
+  TF_ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit("a"));
+  controller.Finish(ticket, absl::Milliseconds(10));
+  EXPECT_EQ(controller.EstimatedCost("a"), absl::Milliseconds(10));
+  EXPECT_EQ(controller.EstimatedCost("b"), absl::ZeroDuration());
+
+  for (int i = 0; i < 100; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+    controller.Finish(ticket, absl::Milliseconds(20));
+  }
+  EXPECT_NEAR(absl::ToDoubleMilliseconds(controller.EstimatedCost("a")), 20,
+              0.1);
+
+  // Failed requests don't change the estimate.
+  TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+  controller.Finish(ticket, std::nullopt);
+  EXPECT_NEAR(absl::ToDoubleMilliseconds(controller.EstimatedCost("a")), 20,
+              0.1);
+}
+
+TEST(AdmissionControllerTest, RejectsRequestsBeyondTargetUtilization) {
+  AdmissionController controller(TestOptions());
+  TF_ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit("a"));
+  controller.Finish(ticket, absl::Milliseconds(50));
+
+  std::vector<AdmissionController::Ticket> tickets;
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+    tickets.push_back(ticket);
+  }
+  EXPECT_THAT(controller.Admit("a"), StatusIs(absl::StatusCode::kUnavailable));
+
+  // A signature without an estimate yet is still admitted.
+  TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("b"));
+  controller.Finish(ticket, absl::Milliseconds(10));
+
+  // Requests are admitted again once the ones in flight finish.
+  controller.Finish(tickets.back(), absl::Milliseconds(50));
+  tickets.pop_back();
+  TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+  tickets.push_back(ticket);
+  for (const auto& in_flight_ticket : tickets) {
+    controller.Finish(in_flight_ticket, absl::Milliseconds(50));
+  }
+}
+
+TEST(AdmissionControllerTest, AdmitsCostlyRequestWhenIdle) {
+  AdmissionController controller(TestOptions());
+  TF_ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit("a"));
+  controller.Finish(ticket, absl::Seconds(1));
+
+  TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+  EXPECT_THAT(controller.Admit("a"), StatusIs(absl::StatusCode::kUnavailable));
+  controller.Finish(ticket, absl::Seconds(1));
+  TF_ASSERT_OK_AND_ASSIGN(ticket, controller.Admit("a"));
+  controller.Finish(ticket, absl::Seconds(1));
+}
+
+}  // namespace
+}  // namespace tfrt_stub
+}  // namespace tensorflow
@@ -15,10 +15,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_GRAPH_EXECUTION_OPTIONS_H_
 #define TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_GRAPH_EXECUTION_OPTIONS_H_
 
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
@@ -100,6 +102,43 @@ struct GraphExecutionOptions {
 
   CostAnalysisOptions cost_analysis_options;
 
+  // Admission control of GraphExecutor::Run(), which rejects the requests with
+  // an Unavailable error once the estimated CPU cost of the requests in flight
+  // exceeds a target utilization. See AdmissionController.
+  struct AdmissionControlOptions {
+    // The fraction of the CPUs that the requests in flight may take over
+    // `horizon`. Admission control is disabled if it is not positive.
+    double target_utilization = 0;
+    // The number of CPUs. If not positive, the parallelism level of the work
+    // queue of the runtime.
+    int num_cpus = 0;
+    absl::Duration horizon = absl::Milliseconds(100);
+  };
+
+  AdmissionControlOptions admission_control_options;
+
+  // Shape bucketing in GraphExecutor::Run(). The inputs of a request are
+  // padded along their leading dimension, by repeating their first row, to the
+  // smallest bucket that fits, and each bucket gets its own graph compiled for
+  // the static shapes of its inputs, on which the shape computations are
+  // constant-folded. The leading dimension of the outputs is then sliced back.
+  //
+  // It is only correct for graphs that compute each row of their inputs
+  // independently, like the ones that BatchFunction ops run. The requests
+  // whose inputs don't share their leading dimension, or whose leading
+  // dimension is larger than all the buckets, run the unspecialized graph.
+  struct ShapeBucketingOptions {
+    // The sizes of the leading dimension to pad to, in increasing order.
+    // Shape bucketing is disabled if it is empty.
+    std::vector<int64_t> batch_sizes;
+    // The maximum number of specialized graphs kept, across the buckets and
+    // the shapes of the other dimensions. The least recently used ones are
+    // evicted.
+    int max_num_specialized_graphs = 16;
+  };
+
+  ShapeBucketingOptions shape_bucketing_options;
+
   // If true, the MLRT interpreter will be used instead of the BEF executor.
   // This option is experimental.
   bool enable_mlrt = false;
@@ -136,6 +175,17 @@ struct GraphExecutionRunOptions {
 
   std::function<void(absl::flat_hash_map<std::string, tensorflow::Tensor>)>
       streamed_output_callback;
+
+  // An alternative to `streamed_output_callback` that receives the streamed
+  // outputs in batches, to bound the per-delivery overhead (e.g. of an RPC to
+  // the client) of graphs that stream many outputs, like token-by-token
+  // decoding. The first output is delivered right away, and the later ones
+  // once `streamed_output_flush_interval` passed since the previous delivery,
+  // or at the end of the request. At most one of the callbacks may be set.
+  std::function<void(
+      std::vector<absl::flat_hash_map<std::string, tensorflow::Tensor>>)>
+      batched_streamed_output_callback;
+  absl::Duration streamed_output_flush_interval = absl::ZeroDuration();
 };
 
 // Creates the default `SessionOptions` from a `GraphExecutionOptions`.
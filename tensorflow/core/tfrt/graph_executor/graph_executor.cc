@@ -26,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -60,6 +61,8 @@ limitations under the License.
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/errors.h"
@@ -345,15 +348,32 @@ tensorflow::Status GraphExecutionRunOnFunction(
         deadline, request_info->tfrt_request_context);
   }
 
+  // Declared before `scoped_stream_callback`, so that the pending batched
+  // outputs are delivered once the callback is unregistered, which waits for
+  // its outstanding invocations.
+  std::shared_ptr<StreamedResultBatcher> streamed_output_batcher;
+  auto flush_streamed_outputs = tensorflow::gtl::MakeCleanup([&]() {
+    if (streamed_output_batcher != nullptr) streamed_output_batcher->Flush();
+  });
   ScopedStreamCallback scoped_stream_callback;
 
-  if (run_options.streamed_output_callback && !stream_callback_id.has_value()) {
+  if (run_options.streamed_output_callback &&
+      run_options.batched_streamed_output_callback) {
+    return absl::InvalidArgumentError(
+        "At most one of streamed_output_callback and "
+        "batched_streamed_output_callback may be set.");
+  }
+  const bool has_streamed_output_callback =
+      run_options.streamed_output_callback ||
+      run_options.batched_streamed_output_callback;
+
+  if (has_streamed_output_callback && !stream_callback_id.has_value()) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Signature '", signature_name, "' does not support streaming."));
   }
 
   if (stream_callback_id.has_value()) {
-    if (!run_options.streamed_output_callback) {
+    if (!has_streamed_output_callback) {
       return absl::InvalidArgumentError(
           absl::StrCat("Signature '", signature_name,
                        "' contains streaming ops but is called using Predict "
@@ -361,13 +381,27 @@ tensorflow::Status GraphExecutionRunOnFunction(
     }
   }
 
-  if (run_options.streamed_output_callback) {
+  if (has_streamed_output_callback) {
     if (!stream_callback_id.has_value()) {
       return absl::InvalidArgumentError(absl::StrCat(
           "Signature ", signature_name, " does not support streaming."));
     }
 
-    auto streamed_output_callback = run_options.streamed_output_callback;
+    absl::AnyInvocable<void(
+        absl::flat_hash_map<std::string, tensorflow::Tensor>)>
+        streamed_output_callback;
+    if (run_options.batched_streamed_output_callback) {
+      streamed_output_batcher = std::make_shared<StreamedResultBatcher>(
+          run_options.streamed_output_flush_interval,
+          run_options.batched_streamed_output_callback);
+      streamed_output_callback =
+          [batcher = streamed_output_batcher](
+              absl::flat_hash_map<std::string, tensorflow::Tensor> output) {
+            batcher->Add(std::move(output));
+          };
+    } else {
+      streamed_output_callback = run_options.streamed_output_callback;
+    }
 
     TF_ASSIGN_OR_RETURN(
         scoped_stream_callback,
@@ -488,6 +522,19 @@ GraphExecutor::GraphExecutor(
       kernel_registry_(std::move(kernel_registry)),
       resource_context_(std::move(resource_context)) {
   DCHECK(resource_context_);
+  const auto& admission_control_options = options_.admission_control_options;
+  if (admission_control_options.target_utilization > 0) {
+    AdmissionController::Options admission_controller_options;
+    admission_controller_options.target_utilization =
+        admission_control_options.target_utilization;
+    admission_controller_options.num_cpus =
+        admission_control_options.num_cpus > 0
+            ? admission_control_options.num_cpus
+            : options_.runtime->work_queue()->GetParallelismLevel();
+    admission_controller_options.horizon = admission_control_options.horizon;
+    admission_controller_ =
+        std::make_unique<AdmissionController>(admission_controller_options);
+  }
   SetSessionCreatedMetric();
 }
 
@@ -550,6 +597,58 @@ void CreateSortedNamesAndOriginalIndices(absl::Span<const std::string> names,
   }
 }
 
+// Returns the smallest of the sorted `batch_sizes` that fits the leading
+// dimension of `inputs`, or std::nullopt if the inputs don't share a non-zero
+// leading dimension or none of `batch_sizes` fits it.
+std::optional<int64_t> GetBatchSizeBucket(
+    absl::Span<const std::pair<std::string, tensorflow::Tensor>> inputs,
+    absl::Span<const int64_t> batch_sizes) {
+  if (inputs.empty()) return std::nullopt;
+  const tensorflow::Tensor& first_input = inputs.front().second;
+  if (first_input.dims() == 0 || first_input.dim_size(0) == 0) {
+    return std::nullopt;
+  }
+  const int64_t batch_size = first_input.dim_size(0);
+  for (const auto& input : inputs) {
+    if (input.second.dims() == 0 || input.second.dim_size(0) != batch_size) {
+      return std::nullopt;
+    }
+  }
+  auto it = std::lower_bound(batch_sizes.begin(), batch_sizes.end(),
+                             batch_size);
+  if (it == batch_sizes.end()) return std::nullopt;
+  return *it;
+}
+
+// Pads the leading dimension of `tensor` to `batch_size` by repeating its
+// first row.
+absl::StatusOr<tensorflow::Tensor> PadToBatchSize(
+    const tensorflow::Tensor& tensor, int64_t batch_size) {
+  const int64_t num_padding_rows = batch_size - tensor.dim_size(0);
+  if (num_padding_rows == 0) return tensor;
+  std::vector<tensorflow::Tensor> pieces;
+  pieces.reserve(num_padding_rows + 1);
+  pieces.push_back(tensor);
+  pieces.resize(num_padding_rows + 1, tensor.Slice(0, 1));
+  tensorflow::Tensor padded_tensor;
+  TF_RETURN_IF_ERROR(tensorflow::tensor::Concat(pieces, &padded_tensor));
+  return padded_tensor;
+}
+
+// The format of the joined name is illustrated as in the following example:
+// input1-input2^output1-output2^target1-target2
+std::string JoinClientGraphName(
+    absl::Span<const std::string> input_tensor_names,
+    absl::Span<const std::string> output_tensor_names,
+    absl::Span<const std::string> target_tensor_names) {
+  return absl::StrCat(
+      absl::StrJoin(input_tensor_names, kTensorNameJoiningDelimiter),
+      kArgumentTypeJoiningDelimiter,
+      absl::StrJoin(output_tensor_names, kTensorNameJoiningDelimiter),
+      kArgumentTypeJoiningDelimiter,
+      absl::StrJoin(target_tensor_names, kTensorNameJoiningDelimiter));
+}
+
 }  // namespace
 
 tensorflow::Status GraphExecutor::Run(
@@ -589,13 +688,46 @@ tensorflow::Status GraphExecutor::Run(
                                                     target_tensor_names.end());
   std::sort(sorted_target_node_names.begin(), sorted_target_node_names.end());
 
-  // Load the client graph.
-  TF_ASSIGN_OR_RETURN(
-      LoadedClientGraph & loaded_client_graph,
-      GetOrCreateLoadedClientGraph(
-          run_options, sorted_input_names, sorted_input_dtypes,
-          sorted_output_names, sorted_target_node_names, run_options.work_queue,
-          /*graph_name=*/{}, inputs));
+  // Pad the inputs to their shape bucket, if any, in the sorted order.
+  const auto& batch_size_buckets = options_.shape_bucketing_options.batch_sizes;
+  std::optional<int64_t> batch_size_bucket;
+  if (!batch_size_buckets.empty()) {
+    batch_size_bucket = GetBatchSizeBucket(inputs, batch_size_buckets);
+  }
+  int64_t batch_size = 0;
+  std::vector<std::pair<std::string, tensorflow::Tensor>> padded_inputs;
+  if (batch_size_bucket.has_value()) {
+    batch_size = inputs.front().second.dim_size(0);
+    padded_inputs.reserve(inputs.size());
+    for (int original_index : input_original_indices) {
+      const auto& [name, tensor] = inputs[original_index];
+      TF_ASSIGN_OR_RETURN(auto padded_tensor,
+                          PadToBatchSize(tensor, *batch_size_bucket));
+      padded_inputs.push_back({name, std::move(padded_tensor)});
+    }
+  }
+
+  // Load the client graph. A specialized one is shared with the cache, which
+  // may evict it during the request.
+  std::shared_ptr<LoadedClientGraph> specialized_client_graph;
+  LoadedClientGraph* loaded_client_graph_ptr = nullptr;
+  if (batch_size_bucket.has_value()) {
+    TF_ASSIGN_OR_RETURN(specialized_client_graph,
+                        GetOrCreateSpecializedClientGraph(
+                            run_options, sorted_output_names,
+                            sorted_target_node_names, run_options.work_queue,
+                            padded_inputs));
+    loaded_client_graph_ptr = specialized_client_graph.get();
+  } else {
+    TF_ASSIGN_OR_RETURN(
+        LoadedClientGraph & unspecialized_client_graph,
+        GetOrCreateLoadedClientGraph(
+            run_options, sorted_input_names, sorted_input_dtypes,
+            sorted_output_names, sorted_target_node_names,
+            run_options.work_queue, /*graph_name=*/{}, inputs));
+    loaded_client_graph_ptr = &unspecialized_client_graph;
+  }
+  LoadedClientGraph& loaded_client_graph = *loaded_client_graph_ptr;
 
   // Get a shared_ptr of the executable so that during the current request the
   // executable to use is guaranteed to be alive.
@@ -610,13 +742,33 @@ tensorflow::Status GraphExecutor::Run(
   }
   DCHECK(func || loaded_executable);
 
+  std::optional<AdmissionController::Ticket> admission_ticket;
+  if (admission_controller_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(
+        admission_ticket,
+        admission_controller_->Admit(loaded_client_graph.name()));
+  }
+  // The cost of a successful request, to refine the estimate of its graph.
+  std::optional<absl::Duration> admission_cost;
+  auto finish_admission = tensorflow::gtl::MakeCleanup([&]() {
+    if (admission_ticket.has_value()) {
+      admission_controller_->Finish(*admission_ticket, admission_cost);
+    }
+  });
+
   // Create the actual arguments to the compiled function, which are sorted
   // according to the input tensor names.
   std::vector<tensorflow::Tensor> flat_inputs;
   if (!loaded_client_graph.is_restore()) {
     flat_inputs.reserve(inputs.size());
-    for (int original_index : input_original_indices) {
-      flat_inputs.push_back(inputs.at(original_index).second);
+    if (batch_size_bucket.has_value()) {
+      for (auto& padded_input : padded_inputs) {
+        flat_inputs.push_back(std::move(padded_input.second));
+      }
+    } else {
+      for (int original_index : input_original_indices) {
+        flat_inputs.push_back(inputs.at(original_index).second);
+      }
     }
   }
 
@@ -660,10 +812,19 @@ tensorflow::Status GraphExecutor::Run(
     (*outputs)[original_index] = std::move(*flat_output_iter);
     ++flat_output_iter;
   }
+  // Remove the padding of the outputs.
+  if (batch_size_bucket.has_value() && batch_size < *batch_size_bucket) {
+    for (auto& output : *outputs) {
+      if (output.dims() > 0 && output.dim_size(0) == *batch_size_bucket) {
+        output = output.Slice(0, batch_size);
+      }
+    }
+  }
   absl::Time end = absl::Now() + simulated_duration_;
   absl::Duration elapsed_duration = end - now;
   loaded_client_graph.latency_sampler()->Add(
       absl::ToDoubleMicroseconds(elapsed_duration));
+  admission_cost = elapsed_duration;
   return OkStatus();
 }
 
@@ -926,18 +1087,11 @@ GraphExecutor::GetOrCreateLoadedClientGraph(
     tensorflow::tfrt_stub::WorkQueueInterface* work_queue,
     absl::string_view graph_name,
     absl::Span<const std::pair<std::string, tensorflow::Tensor>> inputs) {
-  // The format of the joined name is illustrated as in the following example:
-  // input1-input2^output1-output2^target1-target2
   const std::string joined_name =
       !graph_name.empty()
           ? std::string(graph_name)
-          : absl::StrCat(
-                absl::StrJoin(input_tensor_names, kTensorNameJoiningDelimiter),
-                kArgumentTypeJoiningDelimiter,
-                absl::StrJoin(output_tensor_names, kTensorNameJoiningDelimiter),
-                kArgumentTypeJoiningDelimiter,
-                absl::StrJoin(target_tensor_names,
-                              kTensorNameJoiningDelimiter));
+          : JoinClientGraphName(input_tensor_names, output_tensor_names,
+                                target_tensor_names);
 
   tensorflow::mutex_lock l(loaded_client_graphs_mu_);
 
@@ -978,6 +1132,79 @@ GraphExecutor::GetOrCreateLoadedClientGraph(
   return {*loaded_client_graph_ptr};
 }
 
+absl::StatusOr<std::shared_ptr<GraphExecutor::LoadedClientGraph>>
+GraphExecutor::GetOrCreateSpecializedClientGraph(
+    const RunOptions& run_options,
+    absl::Span<const std::string> output_tensor_names,
+    absl::Span<const std::string> target_tensor_names,
+    tensorflow::tfrt_stub::WorkQueueInterface* work_queue,
+    absl::Span<const std::pair<std::string, tensorflow::Tensor>> inputs) {
+  std::vector<std::string> input_tensor_names;
+  std::vector<std::string> input_shapes;
+  input_tensor_names.reserve(inputs.size());
+  input_shapes.reserve(inputs.size());
+  for (const auto& [name, tensor] : inputs) {
+    input_tensor_names.push_back(name);
+    input_shapes.push_back(tensor.shape().DebugString());
+  }
+  // The joined name of the unspecialized graph, followed by the input shapes,
+  // e.g. input1-input2^output1^^[8,16]-[8]
+  const std::string joined_name = absl::StrCat(
+      JoinClientGraphName(input_tensor_names, output_tensor_names,
+                          target_tensor_names),
+      kArgumentTypeJoiningDelimiter,
+      absl::StrJoin(input_shapes, kTensorNameJoiningDelimiter));
+
+  tensorflow::mutex_lock l(specialized_client_graphs_mu_);
+
+  // Cache hit; mark it as the most recently used and return.
+  const auto iter = specialized_client_graph_index_.find(joined_name);
+  if (iter != specialized_client_graph_index_.end()) {
+    specialized_client_graphs_.splice(specialized_client_graphs_.begin(),
+                                      specialized_client_graphs_,
+                                      iter->second);
+    return iter->second->second;
+  }
+
+  if (run_options.disable_compilation) {
+    return tensorflow::errors::InvalidArgument(
+        absl::StrCat("GraphExecutor: compilation is disabled in execution but "
+                     "the compiled graph is not found for ",
+                     joined_name));
+  }
+
+  // Cache miss; populate a `ClientGraph` with the static input shapes and
+  // load it.
+  tensorflow::GraphImportConfig::InputArrays input_nodes;
+  for (const auto& [name, tensor] : inputs) {
+    tensorflow::ArrayInfo array_info;
+    array_info.imported_dtype = tensor.dtype();
+    tensor.shape().AsProto(&array_info.shape);
+    input_nodes[name] = array_info;
+  }
+  ClientGraph client_graph{
+      joined_name,
+      std::move(input_nodes),
+      {output_tensor_names.begin(), output_tensor_names.end()},
+      {target_tensor_names.begin(), target_tensor_names.end()}};
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<LoadedClientGraph> loaded_client_graph,
+                      LoadClientGraph(client_graph, work_queue, inputs));
+
+  // Store the new loaded client graph in cache, evicting the least recently
+  // used ones beyond the limit.
+  specialized_client_graphs_.emplace_front(joined_name, loaded_client_graph);
+  specialized_client_graph_index_[joined_name] =
+      specialized_client_graphs_.begin();
+  const size_t max_num_specialized_graphs = std::max(
+      1, options_.shape_bucketing_options.max_num_specialized_graphs);
+  while (specialized_client_graphs_.size() > max_num_specialized_graphs) {
+    specialized_client_graph_index_.erase(
+        specialized_client_graphs_.back().first);
+    specialized_client_graphs_.pop_back();
+  }
+  return loaded_client_graph;
+}
+
 tensorflow::Status GraphExecutor::RunWithSyncInterpreter(
     const std::string& graph_name, absl::Span<mlrt::Value> input_values,
     absl::Span<const std::string> input_names,
@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_GRAPH_EXECUTOR_H_
 
 #include <functional>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
@@ -46,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/fallback/cost_recorder.h"
 #include "tensorflow/core/tfrt/fallback/fallback_state.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
+#include "tensorflow/core/tfrt/graph_executor/admission_controller.h"
 #include "tensorflow/core/tfrt/graph_executor/executable_context.h"
 #include "tensorflow/core/tfrt/graph_executor/graph_execution_options.h"
 #include "tensorflow/core/tfrt/graph_executor/sync_resource_state.h"
@@ -354,6 +356,19 @@ class GraphExecutor {
       absl::Span<const std::pair<std::string, tensorflow::Tensor>> inputs = {})
       TF_LOCKS_EXCLUDED(loaded_client_graphs_mu_);
 
+  // Returns the `LoadedClientGraph` specialized for the shapes of `inputs`,
+  // which are sorted by their names. If there is none yet, creates one first,
+  // evicting the least recently used one beyond the limit of
+  // `ShapeBucketingOptions`.
+  StatusOr<std::shared_ptr<GraphExecutor::LoadedClientGraph>>
+  GetOrCreateSpecializedClientGraph(
+      const RunOptions& run_options,
+      absl::Span<const std::string> output_tensor_names,
+      absl::Span<const std::string> target_tensor_names,
+      tensorflow::tfrt_stub::WorkQueueInterface* work_queue,
+      absl::Span<const std::pair<std::string, tensorflow::Tensor>> inputs)
+      TF_LOCKS_EXCLUDED(specialized_client_graphs_mu_);
+
   Options options_;
   std::unique_ptr<FallbackState> fallback_state_;
 
@@ -362,6 +377,9 @@ class GraphExecutor {
 
   tfrt::RequestDeadlineTracker req_deadline_tracker_;
 
+  // Null if admission control is disabled.
+  std::unique_ptr<AdmissionController> admission_controller_;
+
   tensorflow::mutex loaded_client_graphs_mu_;
   // Caches `LoadedClientGraph` by the joined name.
   // For pointer stability of values in `absl::flat_hash_map<>`, additional
@@ -370,6 +388,19 @@ class GraphExecutor {
                       std::unique_ptr<LoadedClientGraph>>
       loaded_client_graphs_ TF_GUARDED_BY(loaded_client_graphs_mu_);
 
+  tensorflow::mutex specialized_client_graphs_mu_;
+  // The `LoadedClientGraph`s specialized for shape buckets, from the most to
+  // the least recently used, with their joined names. They are shared with
+  // the requests running them, which keep them alive once evicted.
+  using SpecializedClientGraphList =
+      std::list<std::pair<std::string, std::shared_ptr<LoadedClientGraph>>>;
+  SpecializedClientGraphList specialized_client_graphs_
+      TF_GUARDED_BY(specialized_client_graphs_mu_);
+  absl::flat_hash_map<std::string /*joined_name*/,
+                      SpecializedClientGraphList::iterator>
+      specialized_client_graph_index_
+          TF_GUARDED_BY(specialized_client_graphs_mu_);
+
   std::unique_ptr<mlrt::KernelRegistry> kernel_registry_;
 
   std::unique_ptr<tfrt::ResourceContext> resource_context_;
@@ -129,6 +129,63 @@ TEST_P(GraphExecutorTest, Vanilla) {
               ::testing::ElementsAreArray({2}));
 }
 
+TEST_P(GraphExecutorTest, ShapeBucketing) {
+  GraphDef graph_def;
+  {
+    auto scope = tensorflow::Scope::NewRootScope().WithDevice("/device:CPU:0");
+    auto input = ops::Placeholder(scope.WithOpName("input"), DT_INT32);
+    auto output = ops::Identity(scope.WithOpName("output"), input);
+    auto shape = ops::Shape(scope.WithOpName("shape"), input);
+    TF_ASSERT_OK(scope.ToGraphDef(&graph_def));
+  }
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  GraphExecutor::Options options(runtime.get());
+  options.enable_mlrt = GetParam();
+  options.shape_bucketing_options.batch_sizes = {2, 4};
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto fallback_state,
+      tensorflow::tfrt_stub::FallbackState::Create(
+          CreateDefaultSessionOptions(options), graph_def.library()))
+  auto resource_context = std::make_unique<tfrt::ResourceContext>();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto graph_executor,
+      GraphExecutor::Create(std::move(options), std::move(fallback_state),
+                            std::move(resource_context), graph_def,
+                            GetKernelRegistry()));
+
+  // A batch of 3 is padded to 4, which the outputs are sliced back from.
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  inputs.push_back(
+      {"input", CreateTfTensor<int32_t>(/*shape=*/{3, 2},
+                                        /*data=*/{1, 2, 3, 4, 5, 6})});
+  std::vector<tensorflow::Tensor> outputs;
+  TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                   /*output_tensor_names=*/{"output", "shape"},
+                                   /*target_tensor_names=*/{}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+              ::testing::ElementsAreArray({1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(outputs[0].shape(), TensorShape({3, 2}));
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[1]),
+              ::testing::ElementsAreArray({4, 2}));
+
+  // A batch larger than all the buckets runs the unspecialized graph.
+  inputs.clear();
+  inputs.push_back(
+      {"input", CreateTfTensor<int32_t>(/*shape=*/{5, 1},
+                                        /*data=*/{1, 2, 3, 4, 5})});
+  TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                   /*output_tensor_names=*/{"output", "shape"},
+                                   /*target_tensor_names=*/{}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+              ::testing::ElementsAreArray({1, 2, 3, 4, 5}));
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[1]),
+              ::testing::ElementsAreArray({5, 1}));
+}
+
 TEST_P(GraphExecutorTest, OnlineCostAnalysisOptionsOverrideToOnce) {
   GraphDef graph_def;
   TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
@@ -3108,8 +3108,11 @@ TEST(KernelTest, PromiseReturnNotScheduleImmediately) {
   EXPECT_EQ(output.Get<int32_t>(), 100);
 }
 
+// The benchmarks report the number of kernels executed per second, which
+// tracks the per-kernel overhead of the interpreter.
 void BM_SequentialAdd(::testing::benchmark::State& state) {
-  auto buffer = CreateSequentialAddExecutable(99);
+  const int num_add = state.range(0);
+  auto buffer = CreateSequentialAddExecutable(num_add);
 
   bc::Executable executable(buffer.data());
 
@@ -3137,7 +3140,7 @@ void BM_SequentialAdd(::testing::benchmark::State& state) {
 
   Execute(execution_context);
   notification.WaitForNotification();
-  CHECK_EQ(result.Get<int32_t>(), 100);
+  CHECK_EQ(result.Get<int32_t>(), num_add + 1);
 
   for (auto s : state) {
     absl::Notification notification;
@@ -3150,11 +3153,15 @@ void BM_SequentialAdd(::testing::benchmark::State& state) {
     Execute(execution_context);
     notification.WaitForNotification();
   }
+
+  // The adds and the return.
+  state.SetItemsProcessed(state.iterations() * (num_add + 1));
 }
-BENCHMARK(BM_SequentialAdd);
+BENCHMARK(BM_SequentialAdd)->Arg(99)->Arg(999);
 
 void BM_SequentialAddAttributes(::testing::benchmark::State& state) {
-  auto buffer = CreateSequentialAddAttributesExecutable(99);
+  const int num_add = state.range(0);
+  auto buffer = CreateSequentialAddAttributesExecutable(num_add);
 
   bc::Executable executable(buffer.data());
 
@@ -3181,7 +3188,7 @@ void BM_SequentialAddAttributes(::testing::benchmark::State& state) {
                          absl::Span<Value>(&result, 1));
   Execute(execution_context);
   notification.WaitForNotification();
-  CHECK_EQ(result.Get<int32_t>(), 100);
+  CHECK_EQ(result.Get<int32_t>(), num_add + 1);
 
   for (auto s : state) {
     absl::Notification notification;
@@ -3195,8 +3202,11 @@ void BM_SequentialAddAttributes(::testing::benchmark::State& state) {
     Execute(execution_context);
     notification.WaitForNotification();
   }
+
+  // The adds and the return.
+  state.SetItemsProcessed(state.iterations() * (num_add + 1));
 }
-BENCHMARK(BM_SequentialAddAttributes);
+BENCHMARK(BM_SequentialAddAttributes)->Arg(99)->Arg(999);
 
 }  // namespace
 }  // namespace mlrt
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -39,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/platform/protobuf.h"  // IWYU pragma: keep
+#include "tensorflow/core/tfrt/common/metrics.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_config.pb.h"
 #include "tensorflow/core/tfrt/ifrt/ifrt_loaded_variable_registry.h"
@@ -52,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/mlrt/kernel/kernel_runner_utils.h"
 #include "tensorflow/core/tfrt/utils/fallback_tensor.h"
 #include "tsl/concurrency/ref_count.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/tstring.h"
@@ -309,6 +312,8 @@ absl::Status MlrtIfrtLoadVariableKernel::InvokeHelper() {
         "LoadVariableOp: failed to fetch IfrtModelContext: ");
   }
 
+  const uint64_t load_start_micros = tsl::Env::Default()->NowMicros();
+
   // TODO(b/319045348): remove name() attribute. we now gets name from variable
   // handle.
   std::string runtime_name = GetRuntimeNameFromVarHandle(variable());
@@ -343,7 +348,7 @@ absl::Status MlrtIfrtLoadVariableKernel::InvokeHelper() {
   restored_tensor_future.OnReady(
       [ifrt_model_context = *ifrt_model_context,
        sharding_config = std::string(sharding_config_proto_text()),
-       runtime_name = runtime_name,
+       runtime_name = runtime_name, load_start_micros,
        loaded_variable_promise = std::move(loaded_variable_promise)](
           absl::StatusOr<tensorflow::Tensor> restored_tensor) mutable {
         if (!restored_tensor.ok()) {
@@ -354,7 +359,7 @@ absl::Status MlrtIfrtLoadVariableKernel::InvokeHelper() {
         // Transfer tensor to array in a separate thread.
         ifrt_model_context->checkpoint_loader_queue()->AddTask(
             [ifrt_model_context, runtime_name = std::move(runtime_name),
-             sharding_config = std::move(sharding_config),
+             load_start_micros, sharding_config = std::move(sharding_config),
              restored_tensor = std::move(*restored_tensor),
              loaded_variable_promise =
                  std::move(loaded_variable_promise)]() mutable {
@@ -362,6 +367,14 @@ absl::Status MlrtIfrtLoadVariableKernel::InvokeHelper() {
                   variable_array =
                       LoadIfrtVariable(*ifrt_model_context, restored_tensor,
                                        sharding_config, runtime_name);
+              if (variable_array.ok()) {
+                const int64_t load_micros =
+                    tsl::Env::Default()->NowMicros() - load_start_micros;
+                VLOG(1) << "Loaded variable " << runtime_name << " in "
+                        << load_micros << "us";
+                tfrt_metrics::GetIfrtVariableLoadLatencyGauge(runtime_name)
+                    ->Set(load_micros);
+              }
               loaded_variable_promise.Set(std::move(variable_array));
             });
       });
@@ -156,8 +156,31 @@ ThreadWorkSource::~ThreadWorkSource() {
   }
 }
 
+// Removes the most recently queued waiter from `queue_head`, or returns null if
+// there is none.
+Waiter* PopWaiter(Waiter* queue_head, tensorflow::mutex* mutex) {
+  tensorflow::mutex_lock l(*mutex);
+  if (queue_head->next == queue_head) {
+    return nullptr;
+  }
+  // Remove waiter from the LIFO queue
+  Waiter* w = queue_head->next;
+
+  CHECK(w->prev != w);  // Crash OK.
+  CHECK(w->next != w);  // Crash OK.
+
+  w->next->prev = w->prev;
+  w->prev->next = w->next;
+
+  // Use `w->next == &w` to indicate that the waiter has been removed
+  // from the queue.
+  w->next = w;
+  w->prev = w;
+  return w;
+}
+
 Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
-                                   bool enable_wake_up) {
+                                   bool enable_wake_up, int thread_id) {
   uint64_t id = t.f->trace_id;
   tensorflow::profiler::TraceMe activity(
       [id, is_blocking] {
@@ -170,7 +193,9 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
   thread_local int64_t closure_counter = 0;
 
   if (!is_blocking) {
-    int queue_index = ++closure_counter % non_blocking_work_sharding_factor_;
+    int queue_index =
+        thread_id >= 0 ? thread_id % non_blocking_work_sharding_factor_
+                       : ++closure_counter % non_blocking_work_sharding_factor_;
     task_queue = &(non_blocking_work_queues_[queue_index]->queue);
     mu = &non_blocking_work_queues_[queue_index]->queue_op_mu;
   } else {
@@ -209,22 +234,16 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
       waiter_queue = sub_thread_pool_waiter_;
       waiter_queue_mu = sub_thread_pool_waiter_mu_;
     }
-    {
-      tensorflow::mutex_lock l(*waiter_queue_mu);
-      if (waiter_queue->next != waiter_queue) {
-        // Remove waiter from the LIFO queue
-        w = waiter_queue->next;
-
-        CHECK(w->prev != w);  // Crash OK.
-        CHECK(w->next != w);  // Crash OK.
-
-        w->next->prev = w->prev;
-        w->prev->next = w->next;
-
-        // Use `w->next == &w` to indicate that the waiter has been removed
-        // from the queue.
-        w->next = w;
-        w->prev = w;
+    w = PopWaiter(waiter_queue, waiter_queue_mu);
+    if (w == nullptr && stealing_waiters_ != nullptr) {
+      // All the threads of the sub thread pool are busy, wake up an idle thread
+      // of another one, which searches the tasks of all requests once it is
+      // done with those of its own sub thread pool.
+      for (int i = 0; i < stealing_waiters_->size() && w == nullptr; ++i) {
+        Waiter* stealing_queue = &(*stealing_waiters_)[i];
+        if (stealing_queue != waiter_queue) {
+          w = PopWaiter(stealing_queue, &(*stealing_waiters_mu_)[i]);
+        }
       }
     }
     if (w != nullptr) {
@@ -275,6 +294,13 @@ int64_t ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64_t value) { traceme_id_ = value; }
 
+void ThreadWorkSource::SetStealingWaiters(
+    Eigen::MaxSizeVector<Waiter>* waiters,
+    Eigen::MaxSizeVector<tensorflow::mutex>* waiters_mu) {
+  stealing_waiters_ = waiters;
+  stealing_waiters_mu_ = waiters_mu;
+}
+
 void ThreadWorkSource::SetWaiter(uint64_t version, Waiter* waiter,
                                  tensorflow::mutex* mutex) {
   {
@@ -420,7 +446,8 @@ void RunHandlerThreadPool::StartOneThreadForTesting() {
 void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
                                           bool is_blocking, TaskFunction fn) {
   Task t = env_.CreateTask(std::move(fn));
-  t = tws->EnqueueTask(std::move(t), is_blocking, enable_wake_up_);
+  t = tws->EnqueueTask(std::move(t), is_blocking, enable_wake_up_,
+                       CurrentThreadId());
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
             << tws->GetTracemeId();
@@ -564,11 +591,18 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
                    &task_from_blocking_queue, &tws);
       if (!t.f) {
         // Search from all requests if the thread cannot find tasks from
-        // requests that belong to its own sub thread pool.
+        // requests that belong to its own sub thread pool. The requests are
+        // sorted by priority, and this search starts from the first one so
+        // that the higher priority requests get their work stolen first,
+        // without moving the round robin position of the search in the sub
+        // thread pool.
+        const int current_index = thread_data_[thread_id].current_index;
+        thread_data_[thread_id].current_index = 0;
         t = FindTask(0, active_requests, thread_id, sub_thread_pool_id,
                      kMaxBlockingInflight,
                      /*may_steal_blocking_work=*/true, *thread_work_sources,
                      &task_from_blocking_queue, &tws);
+        thread_data_[thread_id].current_index = current_index;
       }
     } else {
       // For non-blocking threads, it will always search from all pending
@@ -743,16 +777,18 @@ class RunHandlerPool::Impl {
     VLOG(1) << "Creating a RunHandlerPool with max handlers: " << max_handlers_;
     free_handlers_.reserve(max_handlers_);
     handlers_.reserve(max_handlers_);
-    for (int i = 0; i < max_handlers_; ++i) {
-      handlers_.emplace_back(new RunHandler::Impl(this));
-      free_handlers_.push_back(handlers_.back().get());
-    }
     queue_waiters_.resize(options.num_sub_thread_pool);
     waiters_mu_.resize(options.num_sub_thread_pool);
     for (auto& queue_waiter : queue_waiters_) {
       queue_waiter.next = &queue_waiter;
       queue_waiter.prev = &queue_waiter;
     }
+    for (int i = 0; i < max_handlers_; ++i) {
+      handlers_.emplace_back(new RunHandler::Impl(this));
+      handlers_.back()->tws()->SetStealingWaiters(&queue_waiters_,
+                                                  &waiters_mu_);
+      free_handlers_.push_back(handlers_.back().get());
+    }
     run_handler_thread_pool_->Start();
   }
 
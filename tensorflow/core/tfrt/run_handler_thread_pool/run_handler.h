@@ -227,7 +227,12 @@ class ThreadWorkSource {
 
   ~ThreadWorkSource();
 
-  Task EnqueueTask(Task t, bool is_blocking, bool enable_wake_up);
+  // Enqueues `t`. A non-blocking task enqueued by the pool thread `thread_id`,
+  // typically a continuation of the task that it is running, goes to the
+  // non-blocking queue that this thread searches first, so that it likely runs
+  // on the same thread, while idle threads can still steal it from there.
+  Task EnqueueTask(Task t, bool is_blocking, bool enable_wake_up,
+                   int thread_id = -1);
 
   Task PopBlockingTask();
 
@@ -241,6 +246,13 @@ class ThreadWorkSource {
 
   void SetWaiter(uint64_t version, Waiter* waiter, tensorflow::mutex* mutex);
 
+  // Sets the waiting queues of all the sub thread pools. When no thread of the
+  // sub thread pool of this work source is waiting for work, enqueueing a task
+  // wakes up a waiting thread of another sub thread pool instead, which steals
+  // the task rather than leaving it queued while the thread stays idle.
+  void SetStealingWaiters(Eigen::MaxSizeVector<Waiter>* waiters,
+                          Eigen::MaxSizeVector<tensorflow::mutex>* waiters_mu);
+
   int64_t GetInflightTaskCount(bool is_blocking);
 
   void IncrementInflightTaskCount(bool is_blocking);
@@ -286,6 +298,10 @@ class ThreadWorkSource {
   tensorflow::mutex* sub_thread_pool_waiter_mu_
       TF_GUARDED_BY(run_handler_waiter_mu_);
   Waiter* sub_thread_pool_waiter_ TF_GUARDED_BY(run_handler_waiter_mu_);
+
+  // Set once, before any task is enqueued.
+  Eigen::MaxSizeVector<Waiter>* stealing_waiters_ = nullptr;
+  Eigen::MaxSizeVector<tensorflow::mutex>* stealing_waiters_mu_ = nullptr;
 };
 
 class RunHandlerThreadPool {
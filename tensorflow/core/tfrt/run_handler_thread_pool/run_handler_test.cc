@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tfrt/host_context/task_function.h"  // from @tf_runtime
 
 namespace tfrt {
@@ -647,6 +650,102 @@ INSTANTIATE_TEST_SUITE_P(Parameter, RunHandlerThreadPoolTest,
                          testing::Combine(::testing::Bool(),
                                           ::testing::Bool()));
 
+// Spins for `micros` to simulate the work of a closure.
+void SpinForMicros(int64_t micros) {
+  const uint64_t end = tensorflow::Env::Default()->NowMicros() + micros;
+  while (tensorflow::Env::Default()->NowMicros() < end) {
+  }
+}
+
+// Runs link `link` of a chain of `chain_length` inter-op closures of `handler`,
+// each of which also schedules 2 intra-op closures, then the next link.
+void RunChain(RunHandler* handler, int link, int chain_length,
+              std::shared_ptr<tensorflow::BlockingCounter> done) {
+  constexpr int64_t kClosureMicros = 20;
+  for (int j = 0; j < 2; ++j) {
+    handler->AsIntraThreadPoolInterface()->Schedule([done] {
+      SpinForMicros(kClosureMicros);
+      done->DecrementCount();
+    });
+  }
+  SpinForMicros(kClosureMicros);
+  if (link + 1 < chain_length) {
+    handler->ScheduleInterOpClosure(
+        TaskFunction([handler, link, chain_length, done] {
+          RunChain(handler, link + 1, chain_length, done);
+        }));
+  }
+  done->DecrementCount();
+}
+
+// Issues bursts of `state.range(0)` concurrent requests of various priorities,
+// each of which runs a chain of `state.range(1)` links (see RunChain()),
+// separated by idle gaps. Reports the median and tail
+// latency of the requests in the label.
+void BM_RunHandlerBurstyLoad(::testing::benchmark::State& state) {
+  const int burst_size = state.range(0);
+  const int chain_length = state.range(1);
+  constexpr int64_t kIdleMicros = 2000;
+
+  RunHandlerPool::Options pool_options;
+  pool_options.num_inter_op_threads = 4;
+  pool_options.num_intra_op_threads = 4;
+  pool_options.num_sub_thread_pool = 2;
+  pool_options.num_threads_in_sub_thread_pool = {2, 4};
+  pool_options.sub_thread_request_percentage = {0.5, 1};
+  pool_options.max_concurrent_handler = burst_size;
+  RunHandlerPool pool(pool_options);
+  tensorflow::thread::ThreadPool clients(tensorflow::Env::Default(), "clients",
+                                         burst_size);
+
+  std::vector<double> latencies;
+  tensorflow::mutex mu;
+  for (auto s : state) {
+    tensorflow::BlockingCounter burst_done(burst_size);
+    for (int i = 0; i < burst_size; ++i) {
+      clients.Schedule([&, i] {
+        const uint64_t start = tensorflow::Env::Default()->NowMicros();
+        RunHandlerOptions options;
+        options.priority = i % 3;
+        auto handler = pool.Get(/*step_id=*/i, /*timeout_in_ms=*/0, options);
+        auto request_done =
+            std::make_shared<tensorflow::BlockingCounter>(3 * chain_length);
+        RunHandler* handler_ptr = handler.get();
+        handler->ScheduleInterOpClosure(
+            TaskFunction([handler_ptr, chain_length, request_done] {
+              RunChain(handler_ptr, /*link=*/0, chain_length, request_done);
+            }));
+        request_done->Wait();
+        handler.reset();
+        const uint64_t end = tensorflow::Env::Default()->NowMicros();
+        {
+          tensorflow::mutex_lock l(mu);
+          latencies.push_back(end - start);
+        }
+        burst_done.DecrementCount();
+      });
+    }
+    burst_done.Wait();
+    state.PauseTiming();
+    tensorflow::Env::Default()->SleepForMicroseconds(kIdleMicros);
+    state.ResumeTiming();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              static_cast<size_t>(p * latencies.size()))];
+  };
+  state.SetItemsProcessed(state.iterations() * burst_size);
+  state.SetLabel(tensorflow::strings::StrCat(
+      "p50_us=", percentile(0.5), " p99_us=", percentile(0.99)));
+}
+BENCHMARK(BM_RunHandlerBurstyLoad)
+    ->UseRealTime()
+    ->ArgPair(4, 8)
+    ->ArgPair(16, 8)
+    ->ArgPair(64, 8);
+
 }  // namespace
 }  // namespace tf
 }  // namespace tfrt
@@ -222,6 +222,29 @@ void ScopedStreamCallback::Unregister() {
   callback_id_.reset();
 }
 
+void StreamedResultBatcher::Add(
+    absl::flat_hash_map<std::string, tensorflow::Tensor> result) {
+  absl::MutexLock lock(&mu_);
+  results_.push_back(std::move(result));
+  const absl::Time now = absl::Now();
+  if (now - last_flush_time_ >= flush_interval_) {
+    last_flush_time_ = now;
+    FlushLocked();
+  }
+}
+
+void StreamedResultBatcher::Flush() {
+  absl::MutexLock lock(&mu_);
+  FlushLocked();
+}
+
+void StreamedResultBatcher::FlushLocked() {
+  if (results_.empty()) return;
+  // The callback is invoked under the lock to deliver the results in order.
+  callback_(std::move(results_));
+  results_.clear();
+}
+
 StreamInterfaceFactory& GetGlobalStreamInterfaceFactory() {
   static auto* stream_interface_factory = new StreamInterfaceFactory;
   return *stream_interface_factory;
@@ -253,6 +253,38 @@ StreamCallbackRegistry& GetGlobalStreamCallbackRegistry();
 absl::StatusOr<std::optional<StreamCallbackId>> CreateStreamCallbackId(
     absl::string_view model_name, mlir::ModuleOp module);
 
+// Batches the streamed results of a request, to bound the number of times that
+// they are sent to the client. The first result is delivered right away, and
+// each later one with the first result that arrives at least `flush_interval`
+// after the previous delivery, or with Flush() at the end of the request.
+//
+// This class is thread-safe.
+class StreamedResultBatcher {
+ public:
+  using Callback = absl::AnyInvocable<void(
+      std::vector<absl::flat_hash_map<std::string, tensorflow::Tensor>>)>;
+
+  StreamedResultBatcher(absl::Duration flush_interval, Callback callback)
+      : flush_interval_(flush_interval), callback_(std::move(callback)) {}
+
+  // Adds a streamed result, and delivers the pending ones if it's time to.
+  void Add(absl::flat_hash_map<std::string, tensorflow::Tensor> result);
+
+  // Delivers the pending results, if any.
+  void Flush();
+
+ private:
+  void FlushLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const absl::Duration flush_interval_;
+
+  absl::Mutex mu_;
+  Callback callback_ ABSL_GUARDED_BY(mu_);
+  std::vector<absl::flat_hash_map<std::string, tensorflow::Tensor>> results_
+      ABSL_GUARDED_BY(mu_);
+  absl::Time last_flush_time_ ABSL_GUARDED_BY(mu_) = absl::InfinitePast();
+};
+
 // Implements an RAII object that registers a callback to be called on receiving
 // streamed tensors.
 class ScopedStreamCallback {
@@ -41,6 +41,7 @@ namespace {
 
 using ::tensorflow::test::AsTensor;
 using ::testing::AnyOf;
+using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
@@ -142,6 +143,48 @@ TEST(StreamTest, MultipleWriters) {
   }
 }
 
+TEST(StreamedResultBatcherTest, BatchesByFlushInterval) {
+  std::vector<std::vector<int32_t>> batches;
+  StreamedResultBatcher batcher(
+      absl::Hours(1),
+      [&](std::vector<absl::flat_hash_map<std::string, tensorflow::Tensor>>
+              results) {
+        std::vector<int32_t> batch;
+        for (auto& result : results) {
+          batch.push_back(GetTfTensorData<int32_t>(result["a"])[0]);
+        }
+        batches.push_back(std::move(batch));
+      });
+
+  // The first result is delivered right away, and the later ones within the
+  // interval on Flush().
+  batcher.Add({{"a", AsTensor<int32_t>({1})}});
+  batcher.Add({{"a", AsTensor<int32_t>({2})}});
+  batcher.Add({{"a", AsTensor<int32_t>({3})}});
+  EXPECT_THAT(batches, ElementsAre(ElementsAre(1)));
+  batcher.Flush();
+  EXPECT_THAT(batches, ElementsAre(ElementsAre(1), ElementsAre(2, 3)));
+  batcher.Flush();
+  EXPECT_EQ(batches.size(), 2);
+}
+
+TEST(StreamedResultBatcherTest, ZeroFlushInterval) {
+  int num_batches = 0;
+  StreamedResultBatcher batcher(
+      absl::ZeroDuration(),
+      [&](std::vector<absl::flat_hash_map<std::string, tensorflow::Tensor>>
+              results) {
+        EXPECT_EQ(results.size(), 1);
+        ++num_batches;
+      });
+  for (int i = 0; i < 3; ++i) {
+    batcher.Add({{"a", AsTensor<int32_t>({i})}});
+  }
+  EXPECT_EQ(num_batches, 3);
+}
+
+}
+
 }  // namespace
 }  // namespace tfrt_stub
 }  // namespace tensorflow
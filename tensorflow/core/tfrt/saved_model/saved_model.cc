@@ -21,6 +21,7 @@ limitations under the License.
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -35,16 +36,19 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
+#include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "mlir/Dialect/Func/Extensions/AllExtensions.h"  // from @llvm-project
 #include "mlir/IR/DialectRegistry.h"  // from @llvm-project
 #include "mlir/IR/MLIRContext.h"  // from @llvm-project
 #include "mlir/IR/OwningOpRef.h"  // from @llvm-project
+#include "tensorflow/cc/saved_model/fingerprinting.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/mlir/tensorflow/translate/import_model.h"
 #include "tensorflow/compiler/mlir/tensorflow/translate/mlir_roundtrip_flags.h"
 #include "tensorflow/compiler/mlir/tensorflow/translate/tf_mlir_translate.h"
+#include "tensorflow/compiler/mlir/tensorflow/utils/serialize_mlir_module_utils.h"
 #include "tensorflow/compiler/mlir/tfrt/saved_model/saved_model.h"
 #include "tensorflow/compiler/mlir/tfrt/transforms/mlrt/import_model.h"
 #include "tensorflow/compiler/mlir/tfrt/translate/import_model.h"
@@ -64,6 +68,7 @@ limitations under the License.
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/runtime_fallback/kernel/kernel_fallback_compat_request_state.h"
 #include "tensorflow/core/tfrt/fallback/fallback_state.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
@@ -80,7 +85,10 @@ limitations under the License.
 #include "tensorflow/core/tfrt/saved_model/utils/serialize_utils.h"
 #include "tensorflow/core/tfrt/stubs/model_config_stub.h"
 #include "tensorflow/core/tfrt/utils/utils.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/statusor.h"
 #include "tfrt/bef/bef_buffer.h"  // from @tf_runtime
 #include "tfrt/bef_executor/bef_file.h"  // from @tf_runtime
@@ -354,6 +362,77 @@ bool AotPackageExists(absl::string_view saved_model_dir) {
          env->FileExists(aot_bef_path).ok();
 }
 
+// Returns the directory of the compilation cache entry of the saved model,
+// keyed by its fingerprint and by what affects its compilation.
+absl::StatusOr<std::string> GetCompilationCacheEntryDir(
+    const SavedModel::Options& options,
+    const tensorflow::MetaGraphDef& meta_graph_def,
+    absl::string_view saved_model_dir) {
+  TF_ASSIGN_OR_RETURN(
+      const std::string singleprint,
+      tensorflow::saved_model::fingerprinting::Singleprint(saved_model_dir));
+  std::vector<std::string> tags(meta_graph_def.meta_info_def().tags().begin(),
+                                meta_graph_def.meta_info_def().tags().end());
+  std::sort(tags.begin(), tags.end());
+  const GraphExecutionOptions& graph_execution_options =
+      options.graph_execution_options;
+  std::ostringstream key;
+  key << singleprint << ";" << TF_VERSION_STRING << ";"
+      << absl::StrJoin(tags, ",") << ";" << graph_execution_options.enable_mlrt
+      << ";" << graph_execution_options.run_placer_grappler_on_functions << ";"
+      << graph_execution_options.enable_grappler_function_optimizer << ";"
+      << graph_execution_options.compile_options;
+  return tsl::io::JoinPath(
+      options.compilation_cache_dir,
+      absl::StrCat(absl::Hex(tsl::Fingerprint64(key.str()), absl::kZeroPad16)));
+}
+
+bool CompilationCacheEntryExists(const std::string& entry_dir,
+                                 bool enable_mlrt) {
+  Env* env = Env::Default();
+  const std::string aot_package_path = GetAotPackagePath(entry_dir);
+  return env->FileExists(GetMlirFilePath(aot_package_path)).ok() &&
+         env->FileExists(enable_mlrt
+                             ? GetMlrtByteCodeFilePath(aot_package_path)
+                             : GetBefFilePath(aot_package_path))
+             .ok();
+}
+
+// Writes the entry to a temporary directory, renamed once complete, so that
+// loads in other processes never see a partial entry.
+absl::Status WriteCompilationCacheEntry(const std::string& entry_dir,
+                                        const std::string& mlir_module,
+                                        const tfrt::BefBuffer& bef,
+                                        const mlrt::bc::Buffer& bytecode) {
+  Env* env = Env::Default();
+  std::string tmp_dir = entry_dir;
+  if (!env->CreateUniqueFileName(&tmp_dir, ".tmp")) {
+    return absl::InternalError(
+        absl::StrCat("Failed to create a temporary name for ", entry_dir));
+  }
+  const std::string aot_package_path = GetAotPackagePath(tmp_dir);
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(aot_package_path));
+  absl::Status status = tsl::WriteStringToFile(
+      env, GetMlirFilePath(aot_package_path), mlir_module);
+  if (status.ok()) {
+    status = !bytecode.empty()
+                 ? SerializeMLRTBytecode(
+                       bytecode, GetMlrtByteCodeFilePath(aot_package_path))
+                 : SerializeBEF(bef, GetBefFilePath(aot_package_path));
+  }
+  // Fails if another process added the entry first.
+  if (status.ok()) status = env->RenameFile(tmp_dir, entry_dir);
+  if (!status.ok()) {
+    int64_t undeleted_files, undeleted_dirs;
+    env->DeleteRecursively(tmp_dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    if (CompilationCacheEntryExists(entry_dir, !bytecode.empty())) {
+      return absl::OkStatus();
+    }
+  }
+  return status;
+}
+
 }  // namespace
 
 SavedModel::~SavedModel() = default;  // Out-of-line C++ key function.
@@ -459,7 +538,42 @@ SavedModelImpl::LoadSavedModel(Options options,
   const bool aot_exist = AotPackageExists(saved_model_dir);
   options.enable_lazy_loading = options.enable_lazy_loading && !aot_exist;
 
-  if (aot_exist || options.aot_generation) {
+  // The compilation cache keeps the same artifacts as an AOT package, in a
+  // directory laid out like a saved model directory.
+  std::string cache_entry_dir;
+  if (!aot_exist && !options.aot_generation &&
+      !options.compilation_cache_dir.empty() && !options.enable_lazy_loading &&
+      options.graph_execution_options.compile_options.device_target !=
+          TfrtDeviceInfraTarget::kGpu) {
+    // The artifacts don't depend on where the saved model is.
+    options.graph_execution_options.compile_options.saved_model_dir = "";
+    auto entry_dir =
+        GetCompilationCacheEntryDir(options, meta_graph_def, saved_model_dir);
+    if (entry_dir.ok()) {
+      cache_entry_dir = *std::move(entry_dir);
+    } else {
+      LOG(WARNING) << "Not using the compilation cache for " << saved_model_dir
+                   << ": " << entry_dir.status();
+    }
+  }
+  const bool cache_hit =
+      !cache_entry_dir.empty() &&
+      CompilationCacheEntryExists(cache_entry_dir,
+                                  options.graph_execution_options.enable_mlrt);
+  const bool populate_cache = !cache_entry_dir.empty() && !cache_hit;
+  // Whether the artifacts are loaded, from the AOT package or the cache.
+  const bool load_aot_package = aot_exist || cache_hit;
+  // Whether the artifacts are compiled as for an AOT package.
+  const bool aot_compiled =
+      load_aot_package || options.aot_generation || populate_cache;
+  const std::string aot_model_dir =
+      aot_exist ? std::string(saved_model_dir) : cache_entry_dir;
+  if (cache_hit) {
+    LOG(INFO) << "Found " << saved_model_dir << " in compilation cache "
+              << cache_entry_dir;
+  }
+
+  if (aot_compiled) {
     options.graph_execution_options.compile_options.saved_model_dir = "";
   } else {
     options.graph_execution_options.compile_options.saved_model_dir =
@@ -468,7 +582,7 @@ SavedModelImpl::LoadSavedModel(Options options,
 
   // Register TFRT dialects
   mlir::DialectRegistry registry;
-  if (aot_exist) {
+  if (load_aot_package) {
     LOG(INFO) << "Found AOT package. Register required dialects.";
     RegisterTfrtDialectsForAot(registry);
   }
@@ -509,11 +623,11 @@ SavedModelImpl::LoadSavedModel(Options options,
   }
 
   mlir::OwningOpRef<mlir::ModuleOp> mlir_module;
-  if (aot_exist) {
+  if (load_aot_package) {
     LOG(INFO) << "Found AOT package. Load and deserialize MLIR module.";
 
     TF_RETURN_IF_ERROR(
-        DeserializeAoTMlirModule(saved_model_dir, &context, &mlir_module));
+        DeserializeAoTMlirModule(aot_model_dir, &context, &mlir_module));
   } else {
     ASSIGN_OR_RETURN_IN_IMPORT(
         mlir_module,
@@ -534,10 +648,16 @@ SavedModelImpl::LoadSavedModel(Options options,
   LOG(INFO) << "TFRT finished importing savedmodel. Took "
             << absl::ToInt64Milliseconds(import_duration) << " ms.";
 
+  // The compilation lowers the module in place.
+  std::string serialized_mlir_module;
+  if (populate_cache) {
+    serialized_mlir_module = SerializeMlirModule(mlir_module.get());
+  }
+
   // Step 2: Compile the MLIR module from TF dialect to TFRT dialect (in BEF).
   const auto compile_start_time = absl::Now();
   InitializersAndSignatures initializers_and_signatures;
-  if (aot_exist || options.aot_generation) {
+  if (aot_compiled) {
     ASSIGN_OR_RETURN_IN_COMPILE(
         initializers_and_signatures,
         GetInitializersAndSignatures(mlir_module.get(), saved_model_dir));
@@ -578,15 +698,19 @@ SavedModelImpl::LoadSavedModel(Options options,
 
   mlrt::bc::Buffer bytecode;
   tfrt::BefBuffer bef;
-  if (aot_exist) {
+  if (load_aot_package) {
     LOG(INFO) << "Found AoT package. Load and deserialize BEF.";
+    if (cache_hit) {
+      tensorflow::tf_mlrt::RegisterTfMlrtKernels(*kernel_registry);
+      tensorflow::tf_mlrt::RegisterTfMlrtBatchKernels(*kernel_registry);
+    }
     if (options.graph_execution_options.enable_mlrt) {
       LOG(INFO) << "Found AoT package. Load and deserialize MLRT Bytecode.";
 
       ASSIGN_OR_RETURN_IN_COMPILE(
           bytecode,
           LoadMlrtAndMlir(options.graph_execution_options.compile_options,
-                          mlir_module.get(), saved_model_dir_string,
+                          mlir_module.get(), aot_model_dir,
                           fallback_state.get()));
 
     } else {
@@ -594,7 +718,7 @@ SavedModelImpl::LoadSavedModel(Options options,
 
       ASSIGN_OR_RETURN_IN_COMPILE(
           bef, LoadBefAndMlir(options.graph_execution_options.compile_options,
-                              mlir_module.get(), saved_model_dir_string,
+                              mlir_module.get(), aot_model_dir,
                               fallback_state.get()));
       metrics::UpdateAotBefMlirLoadCount();
     }
@@ -618,6 +742,15 @@ SavedModelImpl::LoadSavedModel(Options options,
             bef, options.graph_execution_options.compile_options.aot_bef_file));
       }
     }
+    if (populate_cache) {
+      const Status status = WriteCompilationCacheEntry(
+          cache_entry_dir, serialized_mlir_module, bef, bytecode);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to add " << saved_model_dir
+                     << " to compilation cache " << cache_entry_dir << ": "
+                     << status;
+      }
+    }
   }
 
   ASSIGN_OR_RETURN_WITH_STAGE_INFO(
@@ -657,14 +790,14 @@ SavedModelImpl::LoadSavedModel(Options options,
         graph_executor->options(), initializers_and_signatures,
         *loaded_executable, &graph_executor->resource_context(),
         runner_table.get(), resource_array.get(),
-        graph_executor->fallback_state(), aot_exist || options.aot_generation));
+        graph_executor->fallback_state(), aot_compiled));
   } else {
     DCHECK(bef_file);
     RETURN_IF_ERROR_IN_INIT(RunBefInitializers(
         graph_executor->options(), initializers_and_signatures, bef_file.get(),
         &graph_executor->resource_context(), runner_table.get(),
         resource_array.get(), graph_executor->fallback_state(),
-        aot_exist || options.aot_generation));
+        aot_compiled));
   }
 
   const auto init_duration = absl::Now() - init_start_time;
@@ -687,13 +820,20 @@ SavedModelImpl::LoadSavedModel(Options options,
   }
 
   // Finally, create the saved model.
-  return {std::make_unique<SavedModelImpl>(
+  auto saved_model = std::make_unique<SavedModelImpl>(
       std::move(options), std::move(symbol_uids), std::move(meta_graph_def),
       std::move(bef), std::move(bef_file), std::move(bytecode),
       std::move(loaded_executable),
       std::move(initializers_and_signatures.signature_map),
       std::move(runner_table), std::move(resource_array),
-      std::move(graph_executor))};
+      std::move(graph_executor));
+  const Options& saved_model_options = saved_model->options_;
+  if (saved_model_options.enable_lazy_loading &&
+      saved_model_options.lazy_loading_warmup_in_background &&
+      !saved_model_options.lazy_loading_use_graph_executor) {
+    saved_model->StartLazyLoadingWarmup();
+  }
+  return {std::move(saved_model)};
 }
 
 SavedModelImpl::SavedModelImpl(
@@ -718,6 +858,37 @@ SavedModelImpl::SavedModelImpl(
       runner_table_(std::move(runner_table)),
       resource_array_(std::move(resource_array)) {}
 
+SavedModelImpl::~SavedModelImpl() {
+  stop_lazy_loading_warmup_ = true;
+  // Joins the thread.
+  lazy_loading_warmup_thread_.reset();
+}
+
+void SavedModelImpl::StartLazyLoadingWarmup() {
+  std::vector<std::string> names = GetFunctionNames();
+  std::sort(names.begin(), names.end());
+  lazy_loading_warmup_thread_.reset(tensorflow::Env::Default()->StartThread(
+      tensorflow::ThreadOptions(), "tfrt_lazy_loading_warmup",
+      [this, names = std::move(names)]() {
+        const auto start_time = absl::Now();
+        for (const std::string& name : names) {
+          if (stop_lazy_loading_warmup_) return;
+          // A signature that failed to load is loaded again on its first call,
+          // which reports the error.
+          const auto loading_result =
+              GetOrCreateLoadingResult(RunOptions(), {name});
+          if (!loading_result.ok()) {
+            LOG(WARNING) << "TFRT failed to warm up signature " << name << ": "
+                         << loading_result.status();
+          }
+        }
+        LOG(INFO) << "TFRT finished warming up " << names.size()
+                  << " signatures. Took "
+                  << absl::ToInt64Milliseconds(absl::Now() - start_time)
+                  << " ms.";
+      }));
+}
+
 std::vector<std::string> SavedModelImpl::GetFunctionNames() const {
   std::vector<std::string> result;
   for (const auto& entry : signatures_) {
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_SAVED_MODEL_SAVED_MODEL_H_
 #define TENSORFLOW_CORE_TFRT_SAVED_MODEL_SAVED_MODEL_H_
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <limits>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
@@ -96,6 +98,15 @@ class SavedModel {
     // the individual signatures will be loaded along with the saved model.
     bool enable_lazy_loading = false;
 
+    // If true and `enable_lazy_loading` is true, the signatures are loaded one
+    // at a time in a background thread once the saved model is loaded, so that
+    // a server can take requests right away while the signatures that it
+    // hasn't called yet get ready. A call of a signature that isn't loaded yet
+    // loads it, as without this option.
+    //
+    // This has no effect with `lazy_loading_use_graph_executor`.
+    bool lazy_loading_warmup_in_background = false;
+
     // If true, we'll attempt to find MLArchive within the given loading path.
     // If not found, will use the path as a normal SavedModel directory.
     //
@@ -110,6 +121,16 @@ class SavedModel {
     // True if and only if SavedModel is being loaded to generate AOT results.
     bool aot_generation = false;
 
+    // If not empty, the directory of a cache of the compiled saved models,
+    // which may be shared by several processes. A saved model without an AOT
+    // package is then compiled as for an AOT package on its first load, and
+    // the results are added to the cache for the later loads. The cache is
+    // keyed by the fingerprint of the saved model, the TF version and the
+    // compilation options.
+    //
+    // This has no effect with `enable_lazy_loading` or for GPU models.
+    std::string compilation_cache_dir;
+
     GraphExecutionOptions graph_execution_options;
   };
 
@@ -228,7 +249,8 @@ class SavedModelImpl final : public SavedModel {
       std::unique_ptr<tfd::FallbackResourceArray> resource_array,
       std::unique_ptr<GraphExecutor> graph_executor);
 
-  ~SavedModelImpl() override = default;
+  // Stops the background warmup, if any, after the signature being loaded.
+  ~SavedModelImpl() override;
 
   SavedModelImpl(const SavedModelImpl&) = delete;
   SavedModelImpl& operator=(const SavedModelImpl&) = delete;
@@ -302,6 +324,10 @@ class SavedModelImpl final : public SavedModel {
                            absl::Span<const std::string> names)
       TF_LOCKS_EXCLUDED(loading_result_cache_mu_);
 
+  // Starts loading the signatures in the background, for
+  // `Options::lazy_loading_warmup_in_background`.
+  void StartLazyLoadingWarmup();
+
   SymbolUids symbol_uids_;
   // `meta_graph_def_` only contains metadata of the model. The graph_def field
   // is removed.
@@ -326,6 +352,9 @@ class SavedModelImpl final : public SavedModel {
   absl::flat_hash_map<std::string /*joined_name*/,
                       std::unique_ptr<LoadingResult>>
       loading_result_cache_ TF_GUARDED_BY(loading_result_cache_mu_);
+
+  std::atomic<bool> stop_lazy_loading_warmup_{false};
+  std::unique_ptr<tensorflow::Thread> lazy_loading_warmup_thread_;
 };
 
 class SavedModelMiraImpl;
@@ -127,6 +127,8 @@ std::string GetBefFilePath(std::string aot_package_directory);
 
 std::string GetMlirFilePath(const std::string& aot_package_directory);
 
+std::string GetMlrtByteCodeFilePath(const std::string& aot_package_directory);
+
 // TODO(b/295241000): Implement MLIR deserialization to skip it AoT and remove
 // redundant steps
 absl::StatusOr<tfrt::BefBuffer> LoadBefAndMlir(
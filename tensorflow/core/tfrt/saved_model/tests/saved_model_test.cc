@@ -46,6 +46,8 @@ limitations under the License.
 #include "tensorflow/core/tfrt/saved_model/saved_model_testutil.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model_util.h"
 #include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
 #include "tfrt/host_context/concurrent_work_queue.h"  // from @tf_runtime
@@ -181,6 +183,66 @@ TEST_P(SavedModelTest, OnlineCostAnalysis) {
               ::testing::ElementsAreArray({6}));
 }
 
+TEST(SavedModelTest, LazyLoadingWarmupInBackground) {
+  std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
+      "tensorflow/core/tfrt/saved_model/tests/toy_v1/1");
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  auto options = DefaultSavedModelOptions(runtime.get());
+  options.enable_lazy_loading = true;
+  options.lazy_loading_warmup_in_background = true;
+
+  auto saved_model = SavedModelImpl::LoadSavedModel(options, saved_model_dir,
+                                                    /*tags=*/{"serve"});
+  TF_CHECK_OK(saved_model.status());
+
+  // Set input 'x' to [[1, 1, 1]]
+  std::vector<tensorflow::Tensor> inputs;
+  inputs.push_back(
+      CreateTfTensor<int32_t>(/*shape=*/{1, 3}, /*data=*/{1, 1, 1}));
+
+  // The call either waits for the warmup to load the signature, or loads it.
+  std::vector<tensorflow::Tensor> outputs;
+  TF_ASSERT_OK((*saved_model)->Run({}, "toy", inputs, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+              ::testing::ElementsAreArray({6}));
+}
+
+TEST(SavedModelTest, CompilationCache) {
+  std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
+      "tensorflow/core/tfrt/saved_model/tests/toy_v1/1");
+  const std::string cache_dir =
+      tsl::io::JoinPath(::testing::TempDir(), "compilation_cache");
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  auto options = DefaultSavedModelOptions(runtime.get());
+  options.compilation_cache_dir = cache_dir;
+
+  // Set input 'x' to [[1, 1, 1]]
+  std::vector<tensorflow::Tensor> inputs;
+  inputs.push_back(
+      CreateTfTensor<int32_t>(/*shape=*/{1, 3}, /*data=*/{1, 1, 1}));
+
+  // The first load adds the saved model to the cache, and the second loads it
+  // from the cache.
+  for (int i = 0; i < 2; ++i) {
+    auto saved_model = SavedModelImpl::LoadSavedModel(options, saved_model_dir,
+                                                      /*tags=*/{"serve"});
+    TF_ASSERT_OK(saved_model.status());
+
+    std::vector<std::string> entries;
+    TF_ASSERT_OK(tsl::Env::Default()->GetChildren(cache_dir, &entries));
+    EXPECT_EQ(entries.size(), 1);
+
+    std::vector<tensorflow::Tensor> outputs;
+    TF_ASSERT_OK((*saved_model)->Run({}, "toy", inputs, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+                ::testing::ElementsAreArray({6}));
+  }
+}
+
 TEST(SavedModelTest, BasicInlineExecution) {
   // SavedModel toy contains a graph of a single 'tf.AddV2' op. It is generated
   // using the following python code:
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -1131,23 +1132,40 @@ void CopySparseBufferToTensor(DataType dtype, size_t offset, SparseBuffer* src,
 
 }  // namespace
 
-Status FastParseExample(const Config& config,
-                        gtl::ArraySlice<tstring> serialized,
-                        gtl::ArraySlice<tstring> example_names,
-                        thread::ThreadPool* thread_pool, Result* result) {
-  DCHECK(result != nullptr);
-  // Check config so we can safely CHECK(false) in switches on config.*.dtype
-  TF_RETURN_IF_ERROR(CheckConfigDataTypes(config));
+// The hashes of the feature names of a config are unique, as the seed of the
+// hasher is changed until they are, so a lookup in the index is a single
+// probe of the cuckoo map followed by one name comparison.
+struct FeatureIndex {
+  explicit FeatureIndex(const Config& config)
+      : num_dense(config.dense.size()),
+        num_sparse(config.sparse.size()),
+        num_ragged(config.ragged.size()),
+        config_index(num_dense + num_sparse + num_ragged) {}
+
+  // Whether the index was built for a config of the shape of `config`.
+  bool Matches(const Config& config) const {
+    return num_dense == config.dense.size() &&
+           num_sparse == config.sparse.size() &&
+           num_ragged == config.ragged.size();
+  }
+
+  const size_t num_dense;
+  const size_t num_sparse;
+  const size_t num_ragged;
+  SeededHasher hasher;
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index;
+};
 
-  if (config.collect_feature_stats) {
-    result->feature_stats.resize(serialized.size());
-  }
+namespace {
 
-  size_t config_size =
+Status BuildFeatureIndex(const Config& config,
+                         std::shared_ptr<const FeatureIndex>* index) {
+  auto new_index = std::make_shared<FeatureIndex>(config);
+  const size_t config_size =
       config.dense.size() + config.sparse.size() + config.ragged.size();
-  SeededHasher hasher;
-  // Build config index.
-  PresizedCuckooMap<std::pair<size_t, Type>> config_index(config_size);
+  SeededHasher& hasher = new_index->hasher;
+  PresizedCuckooMap<std::pair<size_t, Type>>& config_index =
+      new_index->config_index;
   bool ok = true;
   for (size_t i = 0; i < 1000; ++i) {
     for (size_t d = 0; d < config.dense.size(); ++d) {
@@ -1173,6 +1191,44 @@ Status FastParseExample(const Config& config,
     return errors::Internal(
         "Could not avoid collision. This should not happen.");
   }
+  *index = std::move(new_index);
+  return absl::OkStatus();
+}
+
+// Returns the precomputed index of `config`, or builds one.
+Status GetFeatureIndex(const Config& config,
+                       std::shared_ptr<const FeatureIndex>* index) {
+  if (config.feature_index != nullptr &&
+      config.feature_index->Matches(config)) {
+    *index = config.feature_index;
+    return absl::OkStatus();
+  }
+  return BuildFeatureIndex(config, index);
+}
+
+}  // namespace
+
+Status PrecomputeFeatureIndex(Config* config) {
+  config->feature_index.reset();
+  return BuildFeatureIndex(*config, &config->feature_index);
+}
+
+Status FastParseExample(const Config& config,
+                        gtl::ArraySlice<tstring> serialized,
+                        gtl::ArraySlice<tstring> example_names,
+                        thread::ThreadPool* thread_pool, Result* result) {
+  DCHECK(result != nullptr);
+  // Check config so we can safely CHECK(false) in switches on config.*.dtype
+  TF_RETURN_IF_ERROR(CheckConfigDataTypes(config));
+
+  if (config.collect_feature_stats) {
+    result->feature_stats.resize(serialized.size());
+  }
+
+  std::shared_ptr<const FeatureIndex> index;
+  TF_RETURN_IF_ERROR(GetFeatureIndex(config, &index));
+  const auto& config_index = index->config_index;
+  const SeededHasher& hasher = index->hasher;
 
   // Allocate dense output for fixed length dense values
   // (variable-length dense and sparse and ragged have to be buffered).
@@ -1457,37 +1513,10 @@ Status FastParseSingleExample(const Config& config, StringPiece serialized,
     stats = &result->feature_stats.back();
   }
 
-  // TODO(mrry): Cache the construction of this map at Op construction time.
-  size_t config_size =
-      config.dense.size() + config.sparse.size() + config.ragged.size();
-  SeededHasher hasher;
-  // Build config index.
-  PresizedCuckooMap<std::pair<size_t, Type>> config_index(config_size);
-  bool ok = true;
-  for (size_t i = 0; i < 1000; ++i) {
-    for (size_t d = 0; d < config.dense.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.dense[d].feature_name),
-                                      {d, Type::Dense});
-    }
-    for (size_t d = 0; d < config.sparse.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.sparse[d].feature_name),
-                                      {d, Type::Sparse});
-    }
-    for (size_t d = 0; d < config.ragged.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.ragged[d].feature_name),
-                                      {d, Type::Ragged});
-    }
-    if (ok) break;
-    LOG(WARNING) << "Collision found. This should happen only if you have "
-                    "around 2^32 entries in your config.";
-    hasher.seed++;
-    config_index.Clear(config_size);
-    ok = true;
-  }
-  if (!ok) {
-    return errors::Internal(
-        "Could not avoid collision. This should not happen.");
-  }
+  std::shared_ptr<const FeatureIndex> index;
+  TF_RETURN_IF_ERROR(GetFeatureIndex(config, &index));
+  const auto& config_index = index->config_index;
+  const SeededHasher& hasher = index->hasher;
 
   result->sparse_indices.reserve(config.sparse.size());
   result->sparse_values.reserve(config.sparse.size());
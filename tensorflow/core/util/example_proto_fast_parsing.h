@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
 #define TENSORFLOW_CORE_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -35,6 +36,9 @@ limitations under the License.
 namespace tensorflow {
 namespace example {
 
+// An index from feature names to the sub-configs of a FastParseExampleConfig.
+struct FeatureIndex;
+
 // FastParseExampleConfig defines how to parse features in Example.
 // Each sub-config is responsible for one feature identified with feature_name.
 // FastParseExampleConfig can't have two sub-configs with the same feature_name.
@@ -96,8 +100,19 @@ struct FastParseExampleConfig {
   // If `true`, `Result::feature_stats` will contain one
   // `PerExampleFeatureStats` for each serialized example in the input.
   bool collect_feature_stats = false;
+
+  // The index of the features above, set by PrecomputeFeatureIndex(). If it is
+  // null, each call to FastParse[Single]Example() builds one. It must be
+  // recomputed if the feature names change.
+  std::shared_ptr<const FeatureIndex> feature_index;
 };
 
+// Builds the index of the features of `config`, which is then shared by its
+// copies. Kernels that parse many batches with the same features should call
+// it once, rather than have every FastParse[Single]Example() call hash all
+// the feature names of the config.
+Status PrecomputeFeatureIndex(FastParseExampleConfig* config);
+
 // Statistics about the features in each example passed to
 // `FastParse[Single]Example()`.
 //
@@ -139,7 +154,6 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         gtl::ArraySlice<tstring> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
-// TODO(mrry): Move the hash table construction into the config object.
 typedef FastParseExampleConfig FastParseSingleExampleConfig;
 
 Status FastParseSingleExample(const FastParseSingleExampleConfig& config,
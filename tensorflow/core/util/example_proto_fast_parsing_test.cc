@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -327,6 +328,51 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+TEST(FastParse, PrecomputedFeatureIndex) {
+  std::vector<tstring> serialized(3, ExampleWithSomeFeatures());
+
+  FastParseExampleConfig config;
+  AddDenseFeature("bytes_list", DT_STRING, {2}, false, 2, &config);
+  AddDenseFeature("float_list", DT_FLOAT, {-1}, true, 1, &config);
+  AddSparseFeature("int64_list", DT_INT64, &config);
+  AddSparseFeature("missing", DT_INT64, &config);
+
+  FastParseExampleConfig precomputed_config = config;
+  TF_ASSERT_OK(PrecomputeFeatureIndex(&precomputed_config));
+  ASSERT_NE(precomputed_config.feature_index, nullptr);
+  // Copies of the config share the index.
+  FastParseExampleConfig copied_config = precomputed_config;
+  EXPECT_EQ(copied_config.feature_index, precomputed_config.feature_index);
+
+  Result expected;
+  TF_ASSERT_OK(FastParseExample(config, serialized, {}, nullptr, &expected));
+  Result result;
+  TF_ASSERT_OK(
+      FastParseExample(copied_config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(result.dense_values.size(), 2);
+  ASSERT_EQ(result.sparse_values.size(), 2);
+  for (int d = 0; d < 2; ++d) {
+    EXPECT_EQ(result.dense_values[d].DebugString(/*num_values=*/100),
+              expected.dense_values[d].DebugString(/*num_values=*/100));
+    EXPECT_EQ(result.sparse_values[d].DebugString(/*num_values=*/100),
+              expected.sparse_values[d].DebugString(/*num_values=*/100));
+  }
+  EXPECT_EQ(result.sparse_values[0].NumElements(), 9);
+  EXPECT_EQ(result.sparse_values[1].NumElements(), 0);
+
+  Result single_result;
+  TF_ASSERT_OK(
+      FastParseSingleExample(copied_config, serialized[0], &single_result));
+  EXPECT_EQ(single_result.sparse_values[0].NumElements(), 3);
+
+  // An index for a config with fewer features isn't used.
+  copied_config.sparse.pop_back();
+  Result fewer_result;
+  TF_ASSERT_OK(FastParseExample(copied_config, serialized, {}, nullptr,
+                                &fewer_result));
+  EXPECT_EQ(fewer_result.sparse_values.size(), 1);
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -15,10 +15,14 @@ limitations under the License.
 #include "tensorflow/core/util/memmapped_file_system.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -97,12 +101,26 @@ Status MemmappedFileSystem::FileExists(const string& fname,
     return errors::FailedPrecondition("MemmappedEnv is not initialized");
   }
   const auto dir_element = directory_.find(fname);
-  if (dir_element != directory_.end()) {
+  if (dir_element != directory_.end() || subdirectories_.count(fname) > 0) {
     return absl::OkStatus();
   }
   return errors::NotFound(fname, " not found");
 }
 
+Status MemmappedFileSystem::IsDirectory(const string& fname,
+                                        TransactionToken* token) {
+  if (!mapped_memory_) {
+    return errors::FailedPrecondition("MemmappedEnv is not initialized");
+  }
+  if (subdirectories_.count(fname) > 0) {
+    return absl::OkStatus();
+  }
+  if (directory_.find(fname) != directory_.end()) {
+    return errors::FailedPrecondition(fname, " is not a directory");
+  }
+  return errors::NotFound(fname, " not found");
+}
+
 Status MemmappedFileSystem::NewRandomAccessFile(
     const string& filename, TransactionToken* token,
     std::unique_ptr<RandomAccessFile>* result) {
@@ -150,6 +168,11 @@ Status MemmappedFileSystem::GetFileSize(const string& filename,
 
 Status MemmappedFileSystem::Stat(const string& fname, TransactionToken* token,
                                  FileStatistics* stat) {
+  if (mapped_memory_ && subdirectories_.count(fname) > 0) {
+    stat->length = 0;
+    stat->is_directory = true;
+    return absl::OkStatus();
+  }
   uint64 size;
   auto status = GetFileSize(fname, token, &size);
   if (status.ok()) {
@@ -173,7 +196,19 @@ Status MemmappedFileSystem::NewAppendableFile(
 Status MemmappedFileSystem::GetChildren(const string& filename,
                                         TransactionToken* token,
                                         std::vector<string>* strings) {
-  return errors::Unimplemented("memmapped format doesn't support GetChildren");
+  TF_RETURN_IF_ERROR(IsDirectory(filename, token));
+  const string prefix = absl::StrCat(filename, "/");
+  const auto add_child = [&](const string& name) {
+    if (absl::StartsWith(name, prefix) &&
+        name.find('/', prefix.size()) == string::npos) {
+      strings->push_back(name.substr(prefix.size()));
+    }
+  };
+  strings->clear();
+  for (const auto& element : directory_) add_child(element.first);
+  for (const string& subdirectory : subdirectories_) add_child(subdirectory);
+  std::sort(strings->begin(), strings->end());
+  return absl::OkStatus();
 }
 
 Status MemmappedFileSystem::GetMatchingPaths(const string& pattern,
@@ -216,6 +251,7 @@ Status MemmappedFileSystem::InitializeFromFile(Env* env,
   TF_RETURN_IF_ERROR(
       env->NewReadOnlyMemoryRegionFromFile(filename, &mapped_memory_));
   directory_.clear();
+  subdirectories_.clear();
   if (mapped_memory_->length() <= sizeof(uint64)) {
     return errors::DataLoss("Corrupted memmapped model file: ", filename,
                             " Invalid package size");
@@ -240,8 +276,11 @@ Status MemmappedFileSystem::InitializeFromFile(Env* env,
   uint64 prev_element_offset = directory_offset;
   for (auto element_iter = proto_directory.element().rbegin();
        element_iter != proto_directory.element().rend(); ++element_iter) {
-    // Check that the element offset is in the right range.
-    if (element_iter->offset() >= prev_element_offset) {
+    // Check that the element offset is in the right range. Empty elements may
+    // share their offset with the next one.
+    if (element_iter->offset() > prev_element_offset ||
+        (element_iter->offset() == prev_element_offset &&
+         element_iter->length() != 0)) {
       return errors::DataLoss("Corrupted memmapped model file: ", filename,
                               " Invalid offset of internal component");
     }
@@ -254,6 +293,12 @@ Status MemmappedFileSystem::InitializeFromFile(Env* env,
                               " Duplicate name of internal component ",
                               element_iter->name());
     }
+    // Every prefix of the name up to a '/' is a directory.
+    const string& name = element_iter->name();
+    for (size_t pos = name.find('/', strlen(kMemmappedPackagePrefix));
+         pos != string::npos; pos = name.find('/', pos + 1)) {
+      subdirectories_.insert(name.substr(0, pos));
+    }
     prev_element_offset = element_iter->offset();
   }
   return absl::OkStatus();
@@ -266,7 +311,8 @@ bool MemmappedFileSystem::IsMemmappedPackageFilename(const string& filename) {
 namespace {
 bool IsValidRegionChar(char c) {
   return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
-         (c >= '0' && c <= '9') || c == '_' || c == '.';
+         (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-' ||
+         c == '/';
 }
 }  // namespace
 
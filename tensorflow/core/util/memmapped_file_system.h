@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/platform/env.h"
@@ -46,6 +47,12 @@ namespace tensorflow {
 // kMemmappedPackagePrefix. The default graph usually has name
 // kMemmappedPackageDefaultGraphDef;
 //
+// Regions named like paths, e.g. "memmapped_package://model/saved_model.pb",
+// make up directories, so that a whole directory saved with
+// MemmappedFileSystemWriter::SaveDirectory, like a SavedModel with its
+// variables and assets, can be read from the package. Its files are then served
+// from the mapped memory without copies.
+//
 // A "frozen" GraphDef can be converted into this format using
 // tensorflow/contrib/util/convert_graphdef_memmapped_format
 class MemmappedFileSystem : public FileSystem {
@@ -78,8 +85,6 @@ class MemmappedFileSystem : public FileSystem {
                          std::unique_ptr<WritableFile>* result) override;
   Status NewAppendableFile(const string& fname, TransactionToken* token,
                            std::unique_ptr<WritableFile>* result) override;
-  Status GetChildren(const string& dir, TransactionToken* token,
-                     std::vector<string>* r) override;
   Status GetMatchingPaths(const string& pattern, TransactionToken* token,
                           std::vector<string>* results) override;
   Status DeleteFile(const string& f, TransactionToken* token) override;
@@ -89,9 +94,12 @@ class MemmappedFileSystem : public FileSystem {
                     TransactionToken* token) override;
 
   // These functions are implemented.
+  Status GetChildren(const string& dir, TransactionToken* token,
+                     std::vector<string>* r) override;
+  Status IsDirectory(const string& fname, TransactionToken* token) override;
   Status GetFileSize(const string& f, TransactionToken* token,
                      uint64* s) override;
-  // Currently just returns size.
+  // Currently just returns size, or whether `fname` is a directory.
   Status Stat(const string& fname, TransactionToken* token,
               FileStatistics* stat) override;
 
@@ -117,6 +125,8 @@ class MemmappedFileSystem : public FileSystem {
 
   std::unique_ptr<ReadOnlyMemoryRegion> mapped_memory_;
   DirectoryType directory_;
+  // The directories made up by the region names.
+  std::unordered_set<string> subdirectories_;
 
   MemmappedFileSystem(const MemmappedFileSystem&) = delete;
   void operator=(const MemmappedFileSystem&) = delete;
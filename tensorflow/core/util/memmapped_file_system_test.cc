@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/util/memmapped_file_system.h"
 
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -116,6 +117,63 @@ TEST(MemmappedFileSystemTest, SimpleTest) {
             memmapped_env.FileExists("bla-bla-bla").code());
 }
 
+TEST(MemmappedFileSystemTest, SavedDirectory) {
+  Env* env = Env::Default();
+  const string src_dir = io::JoinPath(testing::TmpDir(), "memmapped_env_dir");
+  const string variables_dir = io::JoinPath(src_dir, "variables");
+  TF_ASSERT_OK(env->RecursivelyCreateDir(variables_dir));
+  TF_ASSERT_OK(WriteStringToFile(env, io::JoinPath(src_dir, "saved_model.pb"),
+                                 "model"));
+  TF_ASSERT_OK(WriteStringToFile(
+      env, io::JoinPath(variables_dir, "variables.data-00000-of-00001"),
+      "data"));
+  TF_ASSERT_OK(
+      WriteStringToFile(env, io::JoinPath(variables_dir, "empty"), ""));
+
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "memmapped_env_dir_test");
+  MemmappedFileSystemWriter writer;
+  TF_ASSERT_OK(writer.InitializeToFile(env, filename));
+  TF_ASSERT_OK(
+      writer.SaveDirectory(env, src_dir, "memmapped_package://model"));
+  TF_ASSERT_OK(writer.FlushAndClose());
+
+  MemmappedEnv memmapped_env(env);
+  TF_ASSERT_OK(memmapped_env.InitializeFromFile(filename));
+  std::vector<string> children;
+  TF_ASSERT_OK(
+      memmapped_env.GetChildren("memmapped_package://model", &children));
+  EXPECT_THAT(children, ::testing::ElementsAre("saved_model.pb", "variables"));
+  TF_ASSERT_OK(memmapped_env.GetChildren("memmapped_package://model/variables",
+                                         &children));
+  EXPECT_THAT(children, ::testing::ElementsAre(
+                            "empty", "variables.data-00000-of-00001"));
+
+  TF_EXPECT_OK(memmapped_env.IsDirectory("memmapped_package://model"));
+  EXPECT_EQ(
+      error::FAILED_PRECONDITION,
+      memmapped_env.IsDirectory("memmapped_package://model/saved_model.pb")
+          .code());
+  FileStatistics stat;
+  TF_ASSERT_OK(
+      memmapped_env.Stat("memmapped_package://model/variables", &stat));
+  EXPECT_TRUE(stat.is_directory);
+
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      &memmapped_env, "memmapped_package://model/saved_model.pb", &contents));
+  EXPECT_EQ("model", contents);
+  TF_ASSERT_OK(ReadFileToString(
+      &memmapped_env,
+      "memmapped_package://model/variables/variables.data-00000-of-00001",
+      &contents));
+  EXPECT_EQ("data", contents);
+  uint64 file_size;
+  TF_ASSERT_OK(memmapped_env.GetFileSize(
+      "memmapped_package://model/variables/empty", &file_size));
+  EXPECT_EQ(0, file_size);
+}
+
 TEST(MemmappedFileSystemTest, NotInitialized) {
   MemmappedEnv memmapped_env(Env::Default());
   std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
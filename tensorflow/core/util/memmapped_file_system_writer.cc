@@ -15,6 +15,12 @@ limitations under the License.
 #include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 #include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/io/path.h"
 
 namespace tensorflow {
 
@@ -33,13 +39,7 @@ Status MemmappedFileSystemWriter::SaveTensor(const Tensor& tensor,
     return errors::FailedPrecondition(
         "MemmappedEnvWritter: saving tensor into not opened file");
   }
-  if (!MemmappedFileSystem::IsWellFormedMemmappedPackageFilename(
-          element_name)) {
-    return errors::InvalidArgument(
-        "MemmappedEnvWritter: element_name is invalid: must have memmapped ",
-        "package prefix ", MemmappedFileSystem::kMemmappedPackagePrefix,
-        " and include [A-Za-z0-9_.]");
-  }
+  TF_RETURN_IF_ERROR(CheckElementName(element_name));
   const auto tensor_data = tensor.tensor_data();
   if (tensor_data.empty()) {
     return errors::InvalidArgument(
@@ -61,14 +61,7 @@ Status MemmappedFileSystemWriter::SaveProtobuf(
     return errors::FailedPrecondition(
         "MemmappedEnvWritter: saving protobuf into not opened file");
   }
-  if (!MemmappedFileSystem::IsWellFormedMemmappedPackageFilename(
-          element_name)) {
-    return errors::InvalidArgument(
-        "MemmappedEnvWritter: element_name is invalid: must have memmapped "
-        "package prefix ",
-        MemmappedFileSystem::kMemmappedPackagePrefix,
-        " and include [A-Za-z0-9_.]");
-  }
+  TF_RETURN_IF_ERROR(CheckElementName(element_name));
   const string encoded = message.SerializeAsString();
   AddToDirectoryElement(element_name, encoded.size());
   const auto res = output_file_->Append(encoded);
@@ -78,6 +71,67 @@ Status MemmappedFileSystemWriter::SaveProtobuf(
   return res;
 }
 
+Status MemmappedFileSystemWriter::SaveFile(Env* env, const string& filename,
+                                           const string& element_name) {
+  if (!output_file_) {
+    return errors::FailedPrecondition(
+        "MemmappedEnvWritter: saving file into not opened file");
+  }
+  TF_RETURN_IF_ERROR(CheckElementName(element_name));
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  // Adds pad, so that tensors at aligned offsets in the file, if any, are
+  // aligned after memmapping.
+  TF_RETURN_IF_ERROR(AdjustAlignment(Allocator::kAllocatorAlignment));
+  AddToDirectoryElement(element_name, file_size);
+  static constexpr uint64 kCopyBufferSize = 1 << 20;
+  std::unique_ptr<char[]> scratch(
+      new char[std::min(file_size, kCopyBufferSize)]);
+  for (uint64 offset = 0; offset < file_size;) {
+    StringPiece data;
+    TF_RETURN_IF_ERROR(file->Read(offset,
+                                  std::min(file_size - offset, kCopyBufferSize),
+                                  &data, scratch.get()));
+    TF_RETURN_IF_ERROR(output_file_->Append(data));
+    offset += data.size();
+    output_file_offset_ += data.size();
+  }
+  return absl::OkStatus();
+}
+
+Status MemmappedFileSystemWriter::SaveDirectory(Env* env, const string& dirname,
+                                                const string& element_dirname) {
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(env->GetChildren(dirname, &children));
+  // Keeps the package contents deterministic.
+  std::sort(children.begin(), children.end());
+  for (const string& child : children) {
+    const string path = io::JoinPath(dirname, child);
+    const string element_name = absl::StrCat(element_dirname, "/", child);
+    if (env->IsDirectory(path).ok()) {
+      TF_RETURN_IF_ERROR(SaveDirectory(env, path, element_name));
+    } else {
+      TF_RETURN_IF_ERROR(SaveFile(env, path, element_name));
+    }
+  }
+  return absl::OkStatus();
+}
+
+Status MemmappedFileSystemWriter::CheckElementName(
+    const string& element_name) const {
+  if (!MemmappedFileSystem::IsWellFormedMemmappedPackageFilename(
+          element_name)) {
+    return errors::InvalidArgument(
+        "MemmappedEnvWritter: element_name is invalid: must have memmapped "
+        "package prefix ",
+        MemmappedFileSystem::kMemmappedPackagePrefix,
+        " and include [A-Za-z0-9_./-], got ", element_name);
+  }
+  return absl::OkStatus();
+}
+
 namespace {
 
 StringPiece EncodeUint64LittleEndian(uint64 val, char* output_buffer) {
@@ -35,10 +35,19 @@ class MemmappedFileSystemWriter {
   Status SaveTensor(const Tensor& tensor, const string& element_name);
   Status SaveProtobuf(const protobuf::MessageLite& message,
                       const string& element_name);
+  // Saves the contents of the file `filename` of `env`.
+  Status SaveFile(Env* env, const string& filename,
+                  const string& element_name);
+  // Saves the files under the directory `dirname` of `env`, e.g. a SavedModel,
+  // as elements named `element_dirname`/<relative path of the file>. Each file
+  // starts at an aligned offset.
+  Status SaveDirectory(Env* env, const string& dirname,
+                       const string& element_dirname);
   // Writes out the directory of regions and closes the output file.
   Status FlushAndClose();
 
  private:
+  Status CheckElementName(const string& element_name) const;
   Status AdjustAlignment(uint64 alignment);
   void AddToDirectoryElement(const string& element_name, uint64 length);
   MemmappedFileSystemDirectory directory_;
@@ -17,12 +17,16 @@ limitations under the License.
 
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <tuple>
 #include <utility>
 
 #include "absl/base/call_once.h"
 #include "absl/synchronization/mutex.h"
 #include "xla/tsl/util/byte_swap_array.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -41,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mem.h"
@@ -424,6 +429,31 @@ Status PadAlignment(tsl::BufferedWritableFile* out, int alignment,
   return status;
 }
 
+// A tensor buffer that points into a memory-mapped data file, and keeps the
+// mapping alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mapped_tensor_bundle");
+  }
+  // The mapping is read-only, so kernels must never forward this buffer to
+  // one of their outputs.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
@@ -447,6 +477,10 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
   std::unique_ptr<WritableFile> wrapper;
   status_ = env_->NewWritableFile(data_path_, &wrapper);
   if (!status_.ok()) return;
+  // The data file isn't read back while training, so it shouldn't evict the
+  // input pipeline's data from the page cache.
+  status_ = wrapper->AvoidPageCache();
+  if (!status_.ok()) return;
   out_ = std::make_unique<tsl::BufferedWritableFile>(
       std::move(wrapper), 8 << 20 /* 8MB write buffer */);
 
@@ -531,6 +565,58 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   return status_;
 }
 
+Status BundleWriter::AddDelta(StringPiece key, const Tensor& val,
+                              absl::Span<const int64_t> changed_rows) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  if (options_.base_prefix.empty()) {
+    return errors::FailedPrecondition("Cannot add a delta of ", key,
+                                      " to a bundle without a base.");
+  }
+  if (val.dims() == 0 || !DataTypeCanUseMemcpy(val.dtype())) {
+    return errors::InvalidArgument("Cannot add a delta of ", key, " of type ",
+                                   DataTypeString(val.dtype()), " and shape ",
+                                   val.shape().DebugString());
+  }
+  const int64_t num_rows = val.dim_size(0);
+  for (size_t i = 0; i < changed_rows.size(); ++i) {
+    if (changed_rows[i] < 0 || changed_rows[i] >= num_rows ||
+        (i > 0 && changed_rows[i] <= changed_rows[i - 1])) {
+      return errors::InvalidArgument("The changed rows of ", key,
+                                     " must be sorted, unique and in [0, ",
+                                     num_rows, ")");
+    }
+  }
+  const string key_string(key);
+  if (entries_.find(key_string) != entries_.end()) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+    return status_;
+  }
+
+  BundleEntryProto* entry = &entries_[key_string];
+  entry->set_dtype(val.dtype());
+  val.shape().AsProto(entry->mutable_shape());
+  entry->set_delta(true);
+  // Each range of consecutive rows is added as a slice.
+  size_t begin = 0;
+  while (begin < changed_rows.size()) {
+    size_t end = begin + 1;
+    while (end < changed_rows.size() &&
+           changed_rows[end] == changed_rows[end - 1] + 1) {
+      ++end;
+    }
+    TensorSlice rows(val.dims());
+    rows.set_start(0, changed_rows[begin]);
+    rows.set_length(0, end - begin);
+    rows.AsProto(entry->add_slices());
+    status_ = Add(checkpoint::EncodeTensorNameSlice(key_string, rows),
+                  val.Slice(changed_rows[begin], changed_rows[end - 1] + 1));
+    if (!status_.ok()) return status_;
+    begin = end;
+  }
+  return status_;
+}
+
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
@@ -565,6 +651,7 @@ Status BundleWriter::Finish() {
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
     version->set_min_consumer(kTensorBundleMinConsumer);
+    header.set_base_prefix(options_.base_prefix);
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -599,6 +686,8 @@ struct MergeState {
   bool seen_first_bundle = false;
   BundleHeaderProto_Endianness endianness;
   VersionDef version;
+  // Whether any of the bundles is a delta.
+  bool has_delta = false;
 
   // Tensor key -> BundleEntryProto.
   std::map<string, BundleEntryProto> entries;
@@ -636,6 +725,7 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     if (!s.ok()) return CorruptFileError(s, filename, "unable to parse header");
 
     merge_state->num_shards += header.num_shards();
+    if (!header.base_prefix().empty()) merge_state->has_delta = true;
     if (!merge_state->seen_first_bundle) {
       merge_state->seen_first_bundle = true;
       merge_state->endianness = header.endianness();
@@ -668,7 +758,7 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
 
     // Illegal: the duplicated entry is a non-slice tensor.
     if (entry_iter != merge_state->entries.end() &&
-        entry_iter->second.slices().empty()) {
+        (entry_iter->second.slices().empty() || entry_iter->second.delta())) {
       return errors::InvalidArgument(
           "Duplicate tensor keyed by ", key,
           " encountered, when merging prefix: ", prefix);
@@ -708,7 +798,8 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
 }
 
 Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
-                    StringPiece merged_prefix, bool allow_missing_files) {
+                    StringPiece merged_prefix, bool allow_missing_files,
+                    StringPiece base_prefix) {
   // Merges all metadata tables.
   // TODO(zhifengc): KeyValue sorter if it becomes too big.
   MergeState merge;
@@ -729,6 +820,13 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
     return errors::InvalidArgument(
         "At least one prefix checkpoint file must exist, but none existed.");
   }
+  if (merge.has_delta &&
+      (base_prefix.empty() || base_prefix == merged_prefix)) {
+    return errors::FailedPrecondition(
+        "Merging delta bundles into ", merged_prefix,
+        " requires the prefix of another bundle as base, got '", base_prefix,
+        "'");
+  }
   // Renames data files to contain the merged bundle prefix.
   for (const auto& p : merge.shard_ids) {
     VLOG(1) << "Renaming " << p.first << " to "
@@ -749,6 +847,7 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
     header.set_num_shards(merge.num_shards);
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    if (merge.has_delta) header.set_base_prefix(string(base_prefix));
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -837,6 +936,11 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
   }
   status_ = CheckVersions(header.version(), kTensorBundleVersion,
                           kTensorBundleMinProducer, "Checkpoint", "checkpoint");
+  if (!status_.ok()) return;
+  base_prefix_ = header.base_prefix();
+  if (base_prefix_ == prefix_) {
+    status_ = errors::DataLoss("Bundle ", prefix_, " is a delta of itself");
+  }
 }
 
 BundleReader::~BundleReader() {
@@ -1024,7 +1128,9 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   BundleEntryProto entry;
   TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
 
-  if (entry.slices().empty()) {
+  if (entry.delta()) {
+    return GetDeltaValue(key, entry, val);
+  } else if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
     return GetSliceValue(
@@ -1033,6 +1139,199 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape shape(entry.shape());
+
+  const ReadOnlyMemoryRegion* region = nullptr;
+  if (entry.slices().empty() && !entry.delta() &&
+      DataTypeCanUseMemcpy(entry.dtype()) && !need_to_swap_bytes_ &&
+      entry.size() > 0) {
+    auto it = mapped_data_.find(entry.shard_id());
+    if (it == mapped_data_.end()) {
+      std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+      const std::string filename =
+          DataFilename(prefix_, entry.shard_id(), num_shards_);
+      const Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &mapped);
+      if (!s.ok()) {
+        VLOG(1) << "Reading " << filename << " without memory mapping: " << s;
+      }
+      it = mapped_data_.emplace(entry.shard_id(), std::move(mapped)).first;
+    }
+    region = it->second.get();
+  }
+  const char* data = nullptr;
+  if (region != nullptr) {
+    const int64_t expected_size =
+        shape.num_elements() * DataTypeSize(entry.dtype());
+    if (entry.size() != expected_size) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                              "; stored size ", entry.size(),
+                              "; expected size ", expected_size);
+    }
+    if (entry.offset() < 0 ||
+        static_cast<uint64_t>(entry.offset() + entry.size()) >
+            region->length()) {
+      return errors::DataLoss("Bundle entry ", key, " at offset ",
+                              entry.offset(), " is past the end of shard ",
+                              entry.shard_id(), " of ", prefix_);
+    }
+    data = static_cast<const char*>(region->data()) + entry.offset();
+    if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment !=
+        0) {
+      data = nullptr;
+    }
+  }
+  if (data == nullptr) {
+    *val = Tensor(entry.dtype(), shape);
+    return Lookup(key, val);
+  }
+
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the mapped bytes ", actual_crc32c);
+  }
+  core::RefCountPtr<TensorBuffer> buffer(new MappedTensorBuffer(
+      mapped_data_[entry.shard_id()], data, entry.size()));
+  *val = Tensor(entry.dtype(), shape, std::move(buffer));
+  return OkStatus();
+}
+
+Status BundleReader::LookupMany(absl::Span<const std::string> keys,
+                                absl::Span<Tensor* const> vals,
+                                thread::ThreadPool* pool, int64_t read_size) {
+  if (keys.size() != vals.size()) {
+    return errors::InvalidArgument("LookupMany got ", keys.size(),
+                                   " keys but ", vals.size(), " tensors");
+  }
+  read_size = std::max<int64_t>(read_size, 1);
+  // A range of a data file, read into "buffer".
+  struct Chunk {
+    int32_t shard_id;
+    int64_t offset;
+    int64_t size;
+    char* buffer;
+  };
+  std::vector<Chunk> chunks;
+  // The entries read in chunks, with their index in "vals".
+  std::vector<std::pair<BundleEntryProto, size_t>> planned;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    CHECK(vals[i] != nullptr);
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty() || entry.delta() ||
+        !DataTypeCanUseMemcpy(entry.dtype()) ||
+        need_to_swap_bytes_ || vals[i]->NumElements() == 0) {
+      TF_RETURN_IF_ERROR(Lookup(keys[i], vals[i]));
+      continue;
+    }
+    if (entry.dtype() != vals[i]->dtype() ||
+        !TensorShape(entry.shape()).IsSameSize(vals[i]->shape())) {
+      return errors::InvalidArgument(
+          "Tensor ", keys[i], " of ", DataTypeString(entry.dtype()), " ",
+          TensorShape(entry.shape()).DebugString(), " cannot be read into a ",
+          DataTypeString(vals[i]->dtype()), " ",
+          vals[i]->shape().DebugString());
+    }
+    if (entry.size() != vals[i]->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", vals[i]->TotalBytes());
+    }
+    char* buffer = const_cast<char*>(vals[i]->tensor_data().data());
+    for (int64_t offset = 0; offset < entry.size(); offset += read_size) {
+      chunks.push_back(
+          {entry.shard_id(), entry.offset() + offset,
+           std::min<int64_t>(read_size, entry.size() - offset),
+           buffer + offset});
+    }
+    planned.emplace_back(std::move(entry), i);
+  }
+
+  absl::c_sort(chunks, [](const Chunk& a, const Chunk& b) {
+    return std::tie(a.shard_id, a.offset) < std::tie(b.shard_id, b.offset);
+  });
+  // Neighbouring chunks of a file are read by the same task, in order, up to
+  // about "read_size" bytes.
+  std::vector<std::pair<size_t, size_t>> reads;
+  for (size_t begin = 0; begin < chunks.size();) {
+    size_t end = begin + 1;
+    int64_t bytes = chunks[begin].size;
+    while (end < chunks.size() &&
+           chunks[end].shard_id == chunks[begin].shard_id &&
+           bytes + chunks[end].size <= read_size) {
+      bytes += chunks[end].size;
+      ++end;
+    }
+    reads.emplace_back(begin, end);
+    begin = end;
+  }
+
+  const auto run_all = [pool](size_t n, const std::function<void(size_t)>& fn) {
+    BlockingCounter counter(n);
+    for (size_t i = 0; i < n; ++i) {
+      pool->Schedule([&fn, &counter, i]() {
+        fn(i);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  };
+  std::vector<Status> statuses(reads.size());
+  run_all(reads.size(), [&](size_t r) {
+    for (size_t c = reads[r].first; c < reads[r].second; ++c) {
+      const Chunk& chunk = chunks[c];
+      RandomAccessFile* file = nullptr;
+      Status status = cache_->GetFile(
+          DataFilename(prefix_, chunk.shard_id, num_shards_), &file);
+      StringPiece sp;
+      if (status.ok()) {
+        status = file->Read(chunk.offset, chunk.size, &sp, chunk.buffer);
+      }
+      if (!status.ok()) {
+        statuses[r] = status;
+        return;
+      }
+      if (sp.size() != chunk.size) {
+        statuses[r] = errors::DataLoss("Requested ", chunk.size,
+                                       " bytes but read ", sp.size(),
+                                       " bytes from shard ", chunk.shard_id);
+        return;
+      }
+      if (sp.data() != chunk.buffer) {
+        memmove(chunk.buffer, sp.data(), chunk.size);
+      }
+    }
+  });
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  statuses.assign(planned.size(), OkStatus());
+  run_all(planned.size(), [&](size_t p) {
+    const BundleEntryProto& entry = planned[p].first;
+    const uint32 actual_crc32c = crc32c::Value(
+        vals[planned[p].second]->tensor_data().data(), entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      statuses[p] = errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+  });
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return OkStatus();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1042,7 +1341,9 @@ Status BundleReader::ReadCurrent(Tensor* val) {
                             entry.shape().ShortDebugString());
   }
 
-  if (entry.slices().empty()) {
+  if (entry.delta()) {
+    return GetDeltaValue(iter_->key(), entry, val);
+  } else if (entry.slices().empty()) {
     return GetValue(entry, val);
   } else {
     return GetSliceValue(
@@ -1056,6 +1357,8 @@ Status BundleReader::LookupTensorSlices(StringPiece key,
   slices->clear();
   BundleEntryProto entry;
   TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  // The slices of a delta are the changed rows of a full tensor.
+  if (entry.delta()) return OkStatus();
   slices->reserve(entry.slices_size());
   for (const auto& slice : entry.slices()) {
     slices->emplace_back(slice);
@@ -1068,9 +1371,67 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
   CHECK(val != nullptr);
   BundleEntryProto entry;
   TF_RETURN_IF_ERROR(GetBundleEntryProto(full_tensor_key, &entry));
+  if (entry.delta()) {
+    return errors::Unimplemented("Cannot read slice ", slice_spec.DebugString(),
+                                 " of ", full_tensor_key, ", which is stored "
+                                 "as a delta in ", prefix_);
+  }
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
+Status BundleReader::GetDeltaValue(StringPiece key,
+                                   const BundleEntryProto& entry,
+                                   Tensor* val) {
+  // "key" may point into the iterator, which the lookups below move.
+  const string key_string(key);
+  const TensorShape shape(entry.shape());
+  if (base_prefix_.empty() || shape.dims() == 0) {
+    return errors::DataLoss("Invalid delta entry for ", key_string, " in ",
+                            prefix_);
+  }
+  if (base_ == nullptr) {
+    base_ = std::make_unique<BundleReader>(
+        env_, base_prefix_,
+        Options{cache_, enable_multi_threading_for_testing_});
+  }
+  TF_RETURN_IF_ERROR(base_->status());
+  TF_RETURN_IF_ERROR(base_->Lookup(key_string, val));
+  if (val->dtype() != entry.dtype() || val->shape() != shape) {
+    return errors::DataLoss("Delta of ", key_string, " in ", prefix_, " is a ",
+                            DataTypeString(entry.dtype()), " ",
+                            shape.DebugString(), " tensor, but its base in ",
+                            base_prefix_, " is a ",
+                            DataTypeString(val->dtype()), " ",
+                            val->shape().DebugString(), " tensor");
+  }
+
+  for (const TensorSliceProto& slice_proto : entry.slices()) {
+    const TensorSlice rows(slice_proto);
+    bool valid = rows.dims() == shape.dims() && !rows.IsFullAt(0) &&
+                 rows.start(0) >= 0 && rows.length(0) > 0 &&
+                 rows.end(0) <= shape.dim_size(0);
+    for (int d = 1; d < rows.dims(); ++d) valid = valid && rows.IsFullAt(d);
+    if (!valid) {
+      return errors::DataLoss("Invalid rows ", rows.DebugString(),
+                              " in the delta of ", key_string, " in ",
+                              prefix_);
+    }
+    BundleEntryProto rows_entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(
+        checkpoint::EncodeTensorNameSlice(key_string, rows), &rows_entry));
+    if (rows_entry.dtype() != entry.dtype()) {
+      return errors::DataLoss("Invalid dtype for rows ", rows.DebugString(),
+                              " in the delta of ", key_string, " in ",
+                              prefix_);
+    }
+    // Reads the rows in place.
+    Tensor rows_tensor = val->Slice(rows.start(0), rows.end(0));
+    TF_RETURN_IF_ERROR(GetValue(rows_entry, &rows_tensor));
+  }
+  Seek(key_string);
+  return OkStatus();
+}
+
 Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
                                    const BundleEntryProto& full_tensor_entry,
                                    const TensorSlice& slice_spec, Tensor* val) {
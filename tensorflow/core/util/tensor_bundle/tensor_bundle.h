@@ -72,6 +72,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
@@ -84,6 +85,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
@@ -119,6 +121,10 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+
+    // If set, the bundle is a delta of the bundle at this prefix, which
+    // readers then need for the tensors added by AddDelta().
+    std::string base_prefix;
   };
   BundleWriter(Env* env, absl::string_view prefix,
                const Options& options = Options());
@@ -147,6 +153,17 @@ class BundleWriter {
                   const TensorShape& full_tensor_shape,
                   const TensorSlice& slice_spec, const Tensor& slice_tensor);
 
+  // Delta bundles support.
+  // Adds "val" under key "key" as the tensor of the same key in the base
+  // bundle with the rows in "changed_rows", which must be sorted, replaced by
+  // those of "val". Only the changed rows are written, as slices of ranges of
+  // rows.
+  //
+  // REQUIRES: Options::base_prefix is set, and "val" has at least 1 dimension
+  // and a type that can be memcpy'd.
+  Status AddDelta(absl::string_view key, const Tensor& val,
+                  absl::Span<const int64_t> changed_rows);
+
   // Finishes the writer and flushes.
   Status Finish() TF_MUST_USE_RESULT;
 
@@ -190,9 +207,14 @@ class BundleWriter {
 //
 // Returns a NotFoundError when "allow_missing_files" is set to false and
 // any data file named in "prefixes" does not exist.
+//
+// "base_prefix": If any of "prefixes" is a delta bundle, the merged bundle is a
+// delta of the bundle at "base_prefix", which must then be set. It is ignored
+// otherwise.
 Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
                     absl::string_view merged_prefix,
-                    bool allow_missing_files = false);
+                    bool allow_missing_files = false,
+                    absl::string_view base_prefix = "");
 
 class BundleCache;
 
@@ -200,6 +222,10 @@ class BundleCache;
 // "prefix".  If caller intends to call any function afterwards, "status()"
 // must be checked.
 // All threads accessing the same BundleReader must synchronize.
+//
+// The tensors of a delta bundle (see BundleWriter::AddDelta()) are read from
+// their base bundles, which are opened on demand, and patched with the rows
+// stored in the delta. Reading a slice of such a tensor is not supported.
 class BundleReader {
  public:
   BundleReader(Env* const env, absl::string_view prefix,
@@ -291,6 +317,37 @@ class BundleReader {
                      const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys" into "vals", allocated as for
+  // "Lookup()", with reads that are planned up front. The entries that can be
+  // read as raw bytes are sorted by data file offset and split or coalesced
+  // into reads of about "read_size" bytes, which run in parallel on "pool".
+  // Each read goes straight into the buffers of its tensors, and the checksums
+  // are then validated in parallel as well. The other entries, e.g. strings or
+  // partitioned tensors, are read with "Lookup()".
+  //
+  // On error, "vals" may contain nonsense data.
+  // REQUIRES: status().ok()
+  Status LookupMany(absl::Span<const std::string> keys,
+                    absl::Span<Tensor* const> vals, thread::ThreadPool* pool,
+                    int64_t read_size) TF_MUST_USE_RESULT;
+
+  // Looks up the tensor keyed by "key" as for "Lookup()", but into a tensor
+  // that aliases the memory-mapped data file instead of a copy of it, when the
+  // tensor isn't partitioned, its type can be memcpy'd, and its bytes are
+  // aligned to Allocator::kAllocatorAlignment in the mapping, e.g. when the
+  // bundle is written with BundleWriter::Options::data_alignment. Otherwise,
+  // or if the file system can't map files, "val" is set to a newly allocated
+  // copy. Each data file is mapped once, and unmapped once the reader and all
+  // of its tensors are gone.
+  //
+  // The mapping is read-only, so the tensor must never be written to. Its
+  // buffer doesn't own its memory, which keeps kernels from forwarding it to
+  // their outputs.
+  //
+  // Validates the stored crc32c checksum against the mapped bytes.
+  // REQUIRES: status().ok()
+  Status LookupMapped(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Seeks to the first position in the bundle whose key is no less than "key".
   // REQUIRES: status().ok()
   void Seek(absl::string_view key) { return iter_->Seek(key); }
@@ -330,6 +387,12 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the tensor of the delta entry "entry" keyed by "key", from the base
+  // bundle and the rows stored in this bundle.
+  // REQUIRES: entry.delta()
+  Status GetDeltaValue(absl::string_view key, const BundleEntryProto& entry,
+                       Tensor* val) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const std::string prefix_;
   std::unique_ptr<BundleCache> owned_cache_;  // may be null
@@ -344,6 +407,11 @@ class BundleReader {
   // Owned InputBuffer objects. cache_ owns the underlying RandomAccessFiles.
   std::unordered_map<int32_t, io::InputBuffer*> data_;
 
+  // The data files mapped by "LookupMapped()", or nullptr for those that can't
+  // be mapped.
+  std::unordered_map<int32_t, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
   std::unordered_map<std::string, checkpoint::TensorSliceSet*> tensor_slices_;
@@ -352,6 +420,11 @@ class BundleReader {
   // the header entry in the metadata table.
   int num_shards_;
 
+  // The prefix of the bundle this bundle is a delta of, if any, and its
+  // reader once opened.
+  std::string base_prefix_;
+  std::unique_ptr<BundleReader> base_;
+
   // Flag that this class sets to true when the endianness of the target bundle
   // differs from that of the current system's processor architecture.
   bool need_to_swap_bytes_;
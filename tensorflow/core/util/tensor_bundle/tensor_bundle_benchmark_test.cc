@@ -0,0 +1,315 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of saving and restoring synthetic bundles of a few layouts: many
+// small variables, a few huge ones, and variables partitioned into slices.
+//
+// Besides the time per iteration and the throughput, each benchmark reports
+// percentiles of the latency of its iterations in its label. The bundles are
+// written under testing::TmpDir(), or under $TF_BUNDLE_BENCHMARK_DIR if it is
+// set, which may be on any file system, e.g. a remote one.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+// The size of the reads of LookupMany(), as in RestoreV2.
+constexpr int64_t kReadSize = 16 << 20;
+
+std::string Prefix(const std::string& name) {
+  std::string dir;
+  TF_CHECK_OK(
+      ReadStringFromEnvVar("TF_BUNDLE_BENCHMARK_DIR", testing::TmpDir(), &dir));
+  TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(dir));
+  return io::JoinPath(dir, name);
+}
+
+std::string VarName(int i) { return strings::StrCat("var_", i); }
+
+Tensor Variable(int64_t num_elements, float value) {
+  Tensor t(DT_FLOAT, TensorShape({num_elements}));
+  t.flat<float>().setConstant(value);
+  return t;
+}
+
+// Records the latency of each iteration of a benchmark, and reports its
+// percentiles in the label of the benchmark.
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(::testing::benchmark::State& state)
+      : state_(state) {}
+
+  ~LatencyRecorder() {
+    if (latencies_.empty()) return;
+    std::sort(latencies_.begin(), latencies_.end());
+    auto percentile = [this](int p) {
+      return latencies_[(latencies_.size() - 1) * p / 100];
+    };
+    state_.SetLabel(strings::StrCat("p50=", percentile(50), "us p90=",
+                                    percentile(90), "us p99=", percentile(99),
+                                    "us max=", latencies_.back(), "us"));
+  }
+
+  void Start() { start_micros_ = Env::Default()->NowMicros(); }
+  void Stop() {
+    latencies_.push_back(Env::Default()->NowMicros() - start_micros_);
+  }
+
+ private:
+  ::testing::benchmark::State& state_;
+  uint64_t start_micros_ = 0;
+  std::vector<uint64_t> latencies_;
+};
+
+void WriteBundle(const std::string& prefix, int num_vars,
+                 int64_t num_elements) {
+  const Tensor t = Variable(num_elements, 42.0f);
+  BundleWriter writer(Env::Default(), prefix);
+  for (int i = 0; i < num_vars; ++i) {
+    TF_CHECK_OK(writer.Add(VarName(i), t));
+  }
+  TF_CHECK_OK(writer.Finish());
+}
+
+// Writes a variable of "num_rows" rows of "row_size" that is partitioned into
+// "num_slices" slices along its rows.
+void WriteSlicedBundle(const std::string& prefix, int64_t num_rows,
+                       int64_t row_size, int num_slices) {
+  const TensorShape full_shape({num_rows, row_size});
+  BundleWriter writer(Env::Default(), prefix);
+  for (int i = 0; i < num_slices; ++i) {
+    const int64_t start = num_rows * i / num_slices;
+    const int64_t length = num_rows * (i + 1) / num_slices - start;
+    Tensor slice(DT_FLOAT, TensorShape({length, row_size}));
+    slice.flat<float>().setConstant(i);
+    TF_CHECK_OK(writer.AddSlice(
+        "var", full_shape, TensorSlice({{start, length}, {0, row_size}}),
+        slice));
+  }
+  TF_CHECK_OK(writer.Finish());
+}
+
+// Args: the number of variables, and the number of floats in each.
+static void BM_BundleSave(::testing::benchmark::State& state) {
+  const int num_vars = state.range(0);
+  const int64_t num_elements = state.range(1);
+  const std::string prefix = Prefix("save");
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      WriteBundle(prefix, num_vars, num_elements);
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_vars * num_elements *
+                          sizeof(float));
+}
+
+// Many small variables, then a few huge ones.
+BENCHMARK(BM_BundleSave)
+    ->UseRealTime()
+    ->ArgPair(10000, 256)
+    ->ArgPair(100000, 16)
+    ->ArgPair(4, 16 << 20)
+    ->ArgPair(1, 256 << 20);
+
+// Restores each variable with Lookup(), as RestoreV2 does on its own thread.
+// Args: the number of variables, the number of floats in each, and whether
+// the readers share a BundleCache.
+static void BM_BundleRestore(::testing::benchmark::State& state) {
+  const int num_vars = state.range(0);
+  const int64_t num_elements = state.range(1);
+  const bool shared_cache = state.range(2);
+  const std::string prefix = Prefix("restore");
+  WriteBundle(prefix, num_vars, num_elements);
+  BundleCache cache(Env::Default());
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      BundleReader::Options options;
+      if (shared_cache) options.cache = &cache;
+      BundleReader reader(Env::Default(), prefix, options);
+      TF_CHECK_OK(reader.status());
+      for (int i = 0; i < num_vars; ++i) {
+        Tensor t;
+        TF_CHECK_OK(reader.Lookup(VarName(i), &t));
+      }
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_vars * num_elements *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_BundleRestore)
+    ->UseRealTime()
+    ->Args({10000, 256, 0})
+    ->Args({10000, 256, 1})
+    ->Args({100000, 16, 0})
+    ->Args({100000, 16, 1})
+    ->Args({4, 16 << 20, 0})
+    ->Args({4, 16 << 20, 1})
+    ->Args({1, 256 << 20, 0})
+    ->Args({1, 256 << 20, 1});
+
+// Restores all the variables at once with LookupMany(), on a pool of
+// "state.range(3)" threads.
+static void BM_BundleRestoreMany(::testing::benchmark::State& state) {
+  const int num_vars = state.range(0);
+  const int64_t num_elements = state.range(1);
+  const bool shared_cache = state.range(2);
+  const int num_threads = state.range(3);
+  const std::string prefix = Prefix("restore_many");
+  WriteBundle(prefix, num_vars, num_elements);
+  std::vector<std::string> keys;
+  for (int i = 0; i < num_vars; ++i) keys.push_back(VarName(i));
+  thread::ThreadPool pool(Env::Default(), "restore_many", num_threads);
+  BundleCache cache(Env::Default());
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      BundleReader::Options options;
+      if (shared_cache) options.cache = &cache;
+      BundleReader reader(Env::Default(), prefix, options);
+      TF_CHECK_OK(reader.status());
+      std::vector<Tensor> tensors(num_vars);
+      std::vector<Tensor*> vals;
+      for (Tensor& t : tensors) vals.push_back(&t);
+      TF_CHECK_OK(reader.LookupMany(keys, vals, &pool, kReadSize));
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_vars * num_elements *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_BundleRestoreMany)
+    ->UseRealTime()
+    ->Args({10000, 256, 0, 8})
+    ->Args({10000, 256, 1, 8})
+    ->Args({4, 16 << 20, 0, 1})
+    ->Args({4, 16 << 20, 0, 8})
+    ->Args({1, 256 << 20, 0, 8});
+
+// The sliced benchmarks write a variable of rows of kSlicedRowSize floats.
+// Args: the number of rows, and the number of slices.
+constexpr int64_t kSlicedRowSize = 1024;
+
+static void BM_BundleSaveSliced(::testing::benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  const int num_slices = state.range(1);
+  const std::string prefix = Prefix("save_sliced");
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      WriteSlicedBundle(prefix, num_rows, kSlicedRowSize, num_slices);
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_rows * kSlicedRowSize *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_BundleSaveSliced)
+    ->UseRealTime()
+    ->ArgPair(1 << 14, 4)
+    ->ArgPair(1 << 14, 64)
+    ->ArgPair(1 << 16, 16);
+
+// Restores the full variable from its slices, as when the variable is
+// restored unpartitioned.
+static void BM_BundleRestoreSliced(::testing::benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  const int num_slices = state.range(1);
+  const std::string prefix = Prefix("restore_sliced");
+  WriteSlicedBundle(prefix, num_rows, kSlicedRowSize, num_slices);
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      BundleReader reader(Env::Default(), prefix);
+      TF_CHECK_OK(reader.status());
+      Tensor t;
+      TF_CHECK_OK(reader.Lookup("var", &t));
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_rows * kSlicedRowSize *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_BundleRestoreSliced)
+    ->UseRealTime()
+    ->ArgPair(1 << 14, 4)
+    ->ArgPair(1 << 14, 64)
+    ->ArgPair(1 << 16, 16);
+
+// Restores each slice on its own with LookupSlice(), as when the variable is
+// restored with the same partitioning.
+static void BM_BundleRestoreEachSlice(::testing::benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  const int num_slices = state.range(1);
+  const std::string prefix = Prefix("restore_each_slice");
+  WriteSlicedBundle(prefix, num_rows, kSlicedRowSize, num_slices);
+  {
+    LatencyRecorder latencies(state);
+    for (auto s : state) {
+      latencies.Start();
+      BundleReader reader(Env::Default(), prefix);
+      TF_CHECK_OK(reader.status());
+      for (int i = 0; i < num_slices; ++i) {
+        const int64_t start = num_rows * i / num_slices;
+        const int64_t length = num_rows * (i + 1) / num_slices - start;
+        Tensor t(DT_FLOAT, TensorShape({length, kSlicedRowSize}));
+        TF_CHECK_OK(reader.LookupSlice(
+            "var", TensorSlice({{start, length}, {0, kSlicedRowSize}}), &t));
+      }
+      latencies.Stop();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * num_rows * kSlicedRowSize *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_BundleRestoreEachSlice)
+    ->UseRealTime()
+    ->ArgPair(1 << 14, 4)
+    ->ArgPair(1 << 14, 64)
+    ->ArgPair(1 << 16, 16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #endif  // _WIN32
 
 #include "absl/status/status.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -954,6 +955,213 @@ TEST(TensorBundleTest, SortForSequentialAccess) {
                           "tensor-1-2", "tensor-1-1", "tensor-1-0"));
 }
 
+TEST(TensorBundleTest, LookupMany) {
+  Env* env = Env::Default();
+  BundleWriter writer0(env, Prefix("lookup_many0"));
+  TF_EXPECT_OK(writer0.Add("a", Constant_100x100<float>(1.f)));
+  TF_EXPECT_OK(writer0.Add("b", Constant_2x3<int64_t>(2)));
+  TF_EXPECT_OK(writer0.Add("s", test::AsTensor<tstring>({"hello", "world"})));
+  TF_ASSERT_OK(writer0.Finish());
+  BundleWriter writer1(env, Prefix("lookup_many1"));
+  TF_EXPECT_OK(writer1.Add("c", Constant_100x100<double>(3.)));
+  TF_EXPECT_OK(writer1.Add("d", Constant_2x3<float>(4.f)));
+  TF_ASSERT_OK(writer1.Finish());
+  TF_ASSERT_OK(MergeBundles(
+      env, {Prefix("lookup_many0"), Prefix("lookup_many1")},
+      Prefix("lookup_many")));
+
+  BundleReader reader(env, Prefix("lookup_many"));
+  TF_ASSERT_OK(reader.status());
+  thread::ThreadPool pool(env, "lookup_many", 4);
+  // Reads of 1000 bytes split the large tensors and coalesce the small ones.
+  const std::vector<std::string> keys = {"d", "s", "a", "c", "b"};
+  Tensor d(DT_FLOAT, TensorShape({2, 3}));
+  Tensor str(DT_STRING, TensorShape({2}));
+  Tensor a(DT_FLOAT, TensorShape({100, 100}));
+  Tensor c(DT_DOUBLE, TensorShape({100, 100}));
+  Tensor b(DT_INT64, TensorShape({2, 3}));
+  TF_ASSERT_OK(reader.LookupMany(keys, {&d, &str, &a, &c, &b}, &pool,
+                                 /*read_size=*/1000));
+  test::ExpectTensorEqual<float>(a, Constant_100x100<float>(1.f));
+  test::ExpectTensorEqual<int64_t>(b, Constant_2x3<int64_t>(2));
+  test::ExpectTensorEqual<double>(c, Constant_100x100<double>(3.));
+  test::ExpectTensorEqual<float>(d, Constant_2x3<float>(4.f));
+  test::ExpectTensorEqual<tstring>(str,
+                                   test::AsTensor<tstring>({"hello", "world"}));
+
+  Tensor wrong_shape(DT_FLOAT, TensorShape({3, 2, 1}));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      reader.LookupMany({"d"}, {&wrong_shape}, &pool, 1000)));
+  EXPECT_TRUE(errors::IsNotFound(reader.LookupMany({"e"}, {&d}, &pool, 1000)));
+
+  // Corrupts a byte of "a".
+  const std::string datafile = DataFilename(Prefix("lookup_many"), 0, 2);
+  std::string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  data[100] = ~data[100];
+  TF_ASSERT_OK(WriteStringToFile(env, datafile, data));
+  BundleReader corrupted_reader(env, Prefix("lookup_many"));
+  TF_ASSERT_OK(corrupted_reader.status());
+  Status status = corrupted_reader.LookupMany({"a"}, {&a}, &pool, 1000);
+  EXPECT_TRUE(errors::IsDataLoss(status));
+  EXPECT_TRUE(absl::StrContains(status.ToString(), "Checksum does not match"));
+}
+
+TEST(TensorBundleTest, LookupMapped) {
+  Env* env = Env::Default();
+  BundleWriter::Options options;
+  options.data_alignment = Allocator::kAllocatorAlignment;
+  {
+    BundleWriter writer(env, Prefix("lookup_mapped"), options);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.f)));
+    TF_EXPECT_OK(writer.Add("b", Constant_100x100<double>(2.)));
+    TF_EXPECT_OK(writer.Add("s", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor a, b, str;
+  {
+    BundleReader reader(env, Prefix("lookup_mapped"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.LookupMapped("a", &a));
+    TF_ASSERT_OK(reader.LookupMapped("b", &b));
+    TF_ASSERT_OK(reader.LookupMapped("s", &str));
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMapped("c", &a)));
+  }
+  // The mapped tensors outlive the reader.
+  test::ExpectTensorEqual<float>(a, Constant_2x3<float>(1.f));
+  test::ExpectTensorEqual<double>(b, Constant_100x100<double>(2.));
+  test::ExpectTensorEqual<tstring>(str,
+                                   test::AsTensor<tstring>({"hello", "world"}));
+  // Only the strings are copied.
+  EXPECT_FALSE(a.RefCountIsOne());
+  EXPECT_FALSE(b.RefCountIsOne());
+  EXPECT_TRUE(str.RefCountIsOne());
+
+  // Entries that aren't aligned are copied.
+  {
+    BundleWriter writer(env, Prefix("lookup_mapped_unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<int8>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(env, Prefix("lookup_mapped_unaligned"));
+  TF_ASSERT_OK(reader.status());
+  TF_ASSERT_OK(reader.LookupMapped("b", &b));
+  test::ExpectTensorEqual<float>(b, Constant_2x3<float>(2.f));
+  EXPECT_TRUE(b.RefCountIsOne());
+
+  // Corrupts a byte of "b", once the file is no longer mapped.
+  a = Tensor();
+  const std::string datafile = DataFilename(Prefix("lookup_mapped"), 0, 1);
+  std::string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  data[options.data_alignment] = ~data[options.data_alignment];
+  TF_ASSERT_OK(WriteStringToFile(env, datafile, data));
+  BundleReader corrupted_reader(env, Prefix("lookup_mapped"));
+  TF_ASSERT_OK(corrupted_reader.status());
+  Status status = corrupted_reader.LookupMapped("b", &b);
+  EXPECT_TRUE(errors::IsDataLoss(status));
+  EXPECT_TRUE(absl::StrContains(status.ToString(), "Checksum does not match"));
+}
+
+TEST(TensorBundleTest, Deltas) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("delta_base"));
+    TF_EXPECT_OK(writer.Add("a", test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7},
+                                                       {4, 2})));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<int32>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleWriter::Options options;
+  options.base_prefix = Prefix("delta_base");
+  {
+    BundleWriter writer(env, Prefix("delta_1"), options);
+    // Rows 0, 2 and 3 of "a" changed, while "b" is written in full.
+    TF_EXPECT_OK(writer.AddDelta(
+        "a", test::AsTensor<float>({10, 11, 2, 3, 14, 15, 16, 17}, {4, 2}),
+        {0, 2, 3}));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<int32>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  options.base_prefix = Prefix("delta_1");
+  {
+    BundleWriter writer(env, Prefix("delta_2"), options);
+    TF_EXPECT_OK(writer.AddDelta(
+        "a", test::AsTensor<float>({10, 11, 22, 23, 14, 15, 16, 17}, {4, 2}),
+        {1}));
+    // Nothing changed in "b".
+    TF_EXPECT_OK(writer.AddDelta("b", Constant_2x3<int32>(2), {}));
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        writer.AddDelta("c", Constant_2x3<int32>(2), {1, 0})));
+    EXPECT_TRUE(errors::IsInvalidArgument(writer.AddDelta(
+        "s", test::AsTensor<tstring>({"hello", "world"}), {0})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader reader(env, Prefix("delta_2"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "a",
+                test::AsTensor<float>({10, 11, 22, 23, 14, 15, 16, 17}, {4, 2}));
+  Expect<int32>(&reader, "b", Constant_2x3<int32>(2));
+  std::vector<TensorSlice> slices;
+  TF_EXPECT_OK(reader.LookupTensorSlices("a", &slices));
+  EXPECT_TRUE(slices.empty());
+  Tensor slice(DT_FLOAT, TensorShape({1, 2}));
+  EXPECT_TRUE(errors::IsUnimplemented(
+      reader.LookupSlice("a", TensorSlice::ParseOrDie("0,1:-"), &slice)));
+
+  // Without its base, a delta can't be read.
+  TF_ASSERT_OK(env->DeleteFile(MetaFilename(Prefix("delta_base"))));
+  BundleReader broken_reader(env, Prefix("delta_2"));
+  TF_ASSERT_OK(broken_reader.status());
+  Expect<int32>(&broken_reader, "b", Constant_2x3<int32>(2));
+  Tensor a(DT_FLOAT, TensorShape({4, 2}));
+  EXPECT_FALSE(broken_reader.Lookup("a", &a).ok());
+
+  // A bundle without a base doesn't take deltas.
+  BundleWriter writer(env, Prefix("delta_no_base"));
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      writer.AddDelta("a", Constant_2x3<float>(1.f), {0})));
+}
+
+TEST(TensorBundleTest, MergeDeltas) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("merge_delta_base"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.f)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleWriter::Options options;
+  // The base of the shards is ignored by the merge.
+  options.base_prefix = Prefix("merge_delta_previous_shard");
+  {
+    BundleWriter writer(env, Prefix("merge_delta_shard0"), options);
+    TF_EXPECT_OK(writer.AddDelta(
+        "a", test::AsTensor<float>({1, 1, 1, 3, 3, 3}, {2, 3}), {1}));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(env, Prefix("merge_delta_shard1"));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(4.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const std::vector<tstring> shards = {Prefix("merge_delta_shard0"),
+                                       Prefix("merge_delta_shard1")};
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      MergeBundles(env, shards, Prefix("merge_delta"))));
+  TF_ASSERT_OK(MergeBundles(env, shards, Prefix("merge_delta"),
+                            /*allow_missing_files=*/false,
+                            Prefix("merge_delta_base")));
+
+  BundleReader reader(env, Prefix("merge_delta"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "a",
+                test::AsTensor<float>({1, 1, 1, 3, 3, 3}, {2, 3}));
+  Expect<float>(&reader, "b", Constant_2x3<float>(4.f));
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
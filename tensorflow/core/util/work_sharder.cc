@@ -16,11 +16,17 @@ limitations under the License.
 #include "tensorflow/core/util/work_sharder.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
+#include <memory>
+#include <typeindex>
 
+#include "absl/container/flat_hash_map.h"
 #include "xla/tsl/util/env_var.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tsl/profiler/lib/traceme.h"
 
 namespace tensorflow {
@@ -43,6 +49,39 @@ bool UseEigenParallelFor() {
   return result;
 }
 
+std::atomic<bool>& AdaptiveSharding() {
+  static std::atomic<bool>* enabled = []() {
+    bool result = false;
+    if (!tsl::ReadBoolFromEnvVar("TF_ADAPTIVE_WORK_SHARDER",
+                                 /*default_val=*/false, &result)
+             .ok()) {
+      result = false;
+    }
+    return new std::atomic<bool>(result);
+  }();
+  return *enabled;
+}
+
+void ParallelShard(int max_parallelism, thread::ThreadPool* workers,
+                   int64_t total, int64_t cost_per_unit,
+                   const Sharder::Work& work) {
+  if (UseEigenParallelFor() && max_parallelism >= workers->NumThreads()) {
+    tsl::profiler::TraceMe trace_me([=, num_threads = workers->NumThreads()]() {
+      return tsl::profiler::TraceMeEncode("ParallelFor",
+                                          {{"cost_per_unit", cost_per_unit},
+                                           {"total", total},
+                                           {"max_parallelism", max_parallelism},
+                                           {"num_threads", num_threads}});
+    });
+    workers->ParallelFor(total, cost_per_unit, work);
+    return;
+  }
+  Sharder::Do(
+      total, cost_per_unit, work,
+      [&workers](Sharder::Closure c) { workers->Schedule(c); },
+      max_parallelism);
+}
+
 }  // namespace
 
 /* ABSL_CONST_INIT */ thread_local int per_thread_max_parallelism = 1000000;
@@ -54,6 +93,55 @@ void SetPerThreadMaxParallelism(int max_parallelism) {
 
 int GetPerThreadMaxParallelism() { return per_thread_max_parallelism; }
 
+void SetAdaptiveSharding(bool enabled) {
+  AdaptiveSharding().store(enabled, std::memory_order_relaxed);
+}
+
+bool GetAdaptiveSharding() {
+  return AdaptiveSharding().load(std::memory_order_relaxed);
+}
+
+int64_t ShardCostCorrection::Adjust(int64_t cost_per_unit) const {
+  const double correction =
+      std::exp2(log2_correction_.load(std::memory_order_relaxed));
+  const double cost =
+      static_cast<double>(std::max(int64_t{1}, cost_per_unit)) * correction;
+  return static_cast<int64_t>(std::clamp(cost, 1.0, 1e18));
+}
+
+void ShardCostCorrection::Record(int64_t total, int64_t cost_per_unit,
+                                 int64_t nanos) {
+  if (total <= 0 || nanos <= 0) return;
+  const double nanos_per_unit = static_cast<double>(nanos) / total;
+  const double sample = std::clamp(
+      std::log2(nanos_per_unit / std::max(int64_t{1}, cost_per_unit)),
+      -kMaxLog2Correction, kMaxLog2Correction);
+  // Concurrent calls may lose updates, which only slows down the learning.
+  const double current = log2_correction_.load(std::memory_order_relaxed);
+  log2_correction_.store(current + kUpdateWeight * (sample - current),
+                         std::memory_order_relaxed);
+}
+
+ShardCostCorrection* ShardCostCorrection::ForCallSite(
+    const Sharder::Work& work) {
+  static mutex* mu = new mutex();
+  static auto* corrections =
+      new absl::flat_hash_map<std::type_index,
+                              std::unique_ptr<ShardCostCorrection>>();
+  const std::type_index call_site(work.target_type());
+  {
+    tf_shared_lock l(*mu);
+    auto it = corrections->find(call_site);
+    if (it != corrections->end()) return it->second.get();
+  }
+  mutex_lock l(*mu);
+  std::unique_ptr<ShardCostCorrection>& correction = (*corrections)[call_site];
+  if (correction == nullptr) {
+    correction = std::make_unique<ShardCostCorrection>();
+  }
+  return correction.get();
+}
+
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
            int64_t cost_per_unit, std::function<void(int64_t, int64_t)> work) {
   CHECK_GE(total, 0);
@@ -66,21 +154,23 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
     work(0, total);
     return;
   }
-  if (UseEigenParallelFor() && max_parallelism >= workers->NumThreads()) {
-    tsl::profiler::TraceMe trace_me([=, num_threads = workers->NumThreads()]() {
-      return tsl::profiler::TraceMeEncode("ParallelFor",
-                                          {{"cost_per_unit", cost_per_unit},
-                                           {"total", total},
-                                           {"max_parallelism", max_parallelism},
-                                           {"num_threads", num_threads}});
-    });
-    workers->ParallelFor(total, cost_per_unit, work);
+  if (GetAdaptiveSharding()) {
+    // Times the shards, including the ones run inline, so that both
+    // overestimated and underestimated costs are corrected.
+    ShardCostCorrection* correction = ShardCostCorrection::ForCallSite(work);
+    std::atomic<int64_t> nanos(0);
+    const Sharder::Work timed_work = [&work, &nanos](int64_t start,
+                                                     int64_t limit) {
+      const uint64 begin = EnvTime::NowNanos();
+      work(start, limit);
+      nanos.fetch_add(EnvTime::NowNanos() - begin, std::memory_order_relaxed);
+    };
+    ParallelShard(max_parallelism, workers, total,
+                  correction->Adjust(cost_per_unit), timed_work);
+    correction->Record(total, cost_per_unit, nanos.load());
     return;
   }
-  Sharder::Do(
-      total, cost_per_unit, work,
-      [&workers](Sharder::Closure c) { workers->Schedule(c); },
-      max_parallelism);
+  ParallelShard(max_parallelism, workers, total, cost_per_unit, work);
 }
 
 // DEPRECATED: Prefer threadpool->ParallelFor with SchedulingStrategy, which
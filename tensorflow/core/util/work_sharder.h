@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -52,6 +53,10 @@ namespace tensorflow {
 // call SetMaxParallelism() so that all Shard() calls later limits the
 // thread parallelism.
 //
+// With adaptive sharding, Shard() times the shards of each call site and
+// scales "cost_per_unit" by how far off it was in the previous calls of the
+// call site, which are told apart by the type of "work".
+//
 // REQUIRES: max_parallelism >= 0
 // REQUIRES: workers != nullptr
 // REQUIRES: total >= 0
@@ -70,6 +75,11 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
 void SetPerThreadMaxParallelism(int max_parallelism);
 int GetPerThreadMaxParallelism();
 
+// Enables or disables adaptive sharding in Shard(). It is enabled by default
+// if the TF_ADAPTIVE_WORK_SHARDER environment variable is true.
+void SetAdaptiveSharding(bool enabled);
+bool GetAdaptiveSharding();
+
 // Helper to set and unset per-thread max parallelism.
 class ScopedPerThreadMaxParallelism {
  public:
@@ -98,6 +108,31 @@ class Sharder {
                  const Runner& runner, int max_parallelism);
 };
 
+// The cost correction of the Shard() calls of a call site for adaptive
+// sharding: a moving average of the ratio of the nanoseconds that the units
+// of work took to their estimated cost.
+class ShardCostCorrection {
+ public:
+  // Returns `cost_per_unit` scaled by the correction.
+  int64_t Adjust(int64_t cost_per_unit) const;
+
+  // Records that `total` units with an estimated `cost_per_unit` took
+  // `nanos` nanoseconds in all.
+  void Record(int64_t total, int64_t cost_per_unit, int64_t nanos);
+
+  // Returns the correction for the call site of `work`.
+  static ShardCostCorrection* ForCallSite(const Sharder::Work& work);
+
+ private:
+  static constexpr double kMaxLog2Correction = 6;
+  // The weight of a new measurement in the moving average.
+  static constexpr double kUpdateWeight = 0.25;
+
+  // The log2 of the correction, which is kept within 2^-kMaxLog2Correction
+  // and 2^kMaxLog2Correction.
+  std::atomic<double> log2_correction_{0};
+};
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
@@ -93,6 +93,54 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(Shard, Adaptive) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  SetAdaptiveSharding(true);
+  // Runs each configuration a few times for the costs to be corrected.
+  for (int i = 0; i < 3; ++i) {
+    for (auto workers : {0, 1, 2, 7, 100}) {
+      for (auto total : {0, 1, 10, 256, 9999}) {
+        for (auto cost_per_unit : {0, 1, 102, 1000007}) {
+          for (auto maxp : {1, 4, 100}) {
+            ScopedPerThreadMaxParallelism s(maxp);
+            RunSharding(workers, total, cost_per_unit, maxp, &threads);
+          }
+        }
+      }
+    }
+  }
+  SetAdaptiveSharding(false);
+}
+
+TEST(ShardCostCorrection, LearnsFromTimes) {
+  ShardCostCorrection correction;
+  EXPECT_EQ(correction.Adjust(10), 10);
+  EXPECT_EQ(correction.Adjust(0), 1);
+
+  // The units take 8 times their estimated cost.
+  for (int i = 0; i < 30; ++i) {
+    correction.Record(/*total=*/100, /*cost_per_unit=*/10,
+                      /*nanos=*/100 * 80);
+  }
+  EXPECT_NEAR(correction.Adjust(10), 80, 1);
+  EXPECT_NEAR(correction.Adjust(1000), 8000, 10);
+
+  // The units take a tiny fraction of their estimated cost, and the
+  // correction is bounded.
+  for (int i = 0; i < 100; ++i) {
+    correction.Record(/*total=*/100, /*cost_per_unit=*/1000000, /*nanos=*/1);
+  }
+  EXPECT_NEAR(correction.Adjust(6400), 100, 1);
+}
+
+TEST(ShardCostCorrection, ForCallSite) {
+  auto work1 = [](int64_t start, int64_t limit) {};
+  auto work2 = [](int64_t start, int64_t limit) {};
+  ShardCostCorrection* correction1 = ShardCostCorrection::ForCallSite(work1);
+  EXPECT_EQ(ShardCostCorrection::ForCallSite(work1), correction1);
+  EXPECT_NE(ShardCostCorrection::ForCallSite(work2), correction1);
+}
+
 void BM_Sharding(::testing::benchmark::State& state) {
   const int arg = state.range(0);
 
@@ -106,5 +154,36 @@ void BM_Sharding(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_Sharding)->Range(1, 128);
 
+// Shards work whose units take about 100ns with an estimated cost per unit of
+// `state.range(1)`, with adaptive sharding if `state.range(0)` is 1.
+void BM_ShardingMisestimatedCost(::testing::benchmark::State& state) {
+  const bool adaptive = state.range(0) == 1;
+  const int64_t cost_per_unit = state.range(1);
+
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  const int64_t total = 1 << 14;
+  std::vector<float> values(total, 1.0f);
+  auto lambda = [&values](int64_t start, int64_t limit) {
+    for (int64_t i = start; i < limit; ++i) {
+      float value = values[i];
+      for (int j = 0; j < 64; ++j) value = value * 0.999f + 0.001f;
+      values[i] = value;
+    }
+  };
+  SetAdaptiveSharding(adaptive);
+  for (auto s : state) {
+    Shard(16, &threads, total, cost_per_unit, lambda);
+  }
+  SetAdaptiveSharding(false);
+  state.SetItemsProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_ShardingMisestimatedCost)
+    ->ArgPair(0, 1)
+    ->ArgPair(1, 1)
+    ->ArgPair(0, 100)
+    ->ArgPair(1, 100)
+    ->ArgPair(0, 100000)
+    ->ArgPair(1, 100000);
+
 }  // namespace
 }  // namespace tensorflow
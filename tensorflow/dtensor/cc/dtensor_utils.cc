@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/dtensor/cc/dtensor_utils.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <string>
 #include <vector>
@@ -81,6 +82,18 @@ int LayoutPropagationMaxSteps() {
   return 500;
 }
 
+int64_t LayoutPropagationMaxLocalTensorBytes() {
+  int64_t max_bytes;
+  absl::Status status = tsl::ReadInt64FromEnvVar(
+      "DTENSOR_LAYOUT_PROPAGATION_MAX_LOCAL_TENSOR_BYTES", 0, &max_bytes);
+  if (!status.ok() || max_bytes < 0) {
+    LOG(WARNING) << "Invalid DTENSOR_LAYOUT_PROPAGATION_MAX_LOCAL_TENSOR_"
+                    "BYTES, using the default value 0.";
+    return 0;
+  }
+  return max_bytes;
+}
+
 bool EnableMixedPrecisionReduce() {
   char* dtensor_enable_mixed_precision_reduce_str =
       std::getenv("DTENSOR_ENABLE_MIXED_PRECISION_REDUCE");
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_DTENSOR_CC_DTENSOR_UTILS_H_
 #define TENSORFLOW_DTENSOR_CC_DTENSOR_UTILS_H_
 
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -42,6 +43,12 @@ bool LogOpByOp(absl::string_view op_name);
 // of steps exceeds this amount, layout propagation will fail.
 int LayoutPropagationMaxSteps();
 
+// Returns the maximum number of bytes of a local tensor that layout propagation
+// aims for on each device, or 0 if there is no limit. Values whose merged
+// layout exceeds it are laid out by the cost model of layout_cost_model.h
+// instead.
+int64_t LayoutPropagationMaxLocalTensorBytes();
+
 // Returns whether to upcast bfloat16 reduction inputs to float32 for
 // sufficient reduction group size.
 bool EnableMixedPrecisionReduce();
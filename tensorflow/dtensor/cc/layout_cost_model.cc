@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/dtensor/cc/layout_cost_model.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+
+#include "absl/types/span.h"
+#include "tensorflow/dtensor/cc/tensor_layout.h"
+
+namespace tensorflow {
+namespace dtensor {
+namespace {
+
+// Returns the number of shards of tensor dimension `dim` of `layout`, taking
+// dimensions that aren't sharded over a mesh dimension as unsharded.
+int64_t NumShards(const Layout& layout, int dim) {
+  const std::string& spec = layout.sharding_spec(dim);
+  if (!Layout::IsShardedDimension(spec)) return 1;
+  StatusOr<int64_t> dim_size = layout.mesh().dim_size(spec);
+  return dim_size.ok() ? *dim_size : 1;
+}
+
+}  // namespace
+
+int64_t LocalTensorBytes(const Layout& layout,
+                         absl::Span<const int64_t> global_shape,
+                         int64_t element_size) {
+  int64_t bytes = element_size;
+  for (int i = 0; i < global_shape.size(); ++i) {
+    bytes *= global_shape[i] / NumShards(layout, i);
+  }
+  return bytes;
+}
+
+int64_t RelayoutBytesPerDevice(const Layout& from, const Layout& to,
+                               absl::Span<const int64_t> global_shape,
+                               int64_t element_size) {
+  // The local tensors once the dimensions `to` shards differently are
+  // gathered, from which each device slices its part of `to`.
+  int64_t gathered_bytes = element_size;
+  for (int i = 0; i < global_shape.size(); ++i) {
+    const bool gathered = Layout::IsShardedDimension(from.sharding_spec(i)) &&
+                          to.sharding_spec(i) != Layout::kAny &&
+                          to.sharding_spec(i) != from.sharding_spec(i);
+    gathered_bytes *=
+        gathered ? global_shape[i] : global_shape[i] / NumShards(from, i);
+  }
+  return gathered_bytes - LocalTensorBytes(from, global_shape, element_size);
+}
+
+int ChooseLayout(absl::Span<const Layout> candidates,
+                 const std::optional<Layout>& producer,
+                 absl::Span<const Layout> consumers,
+                 absl::Span<const int64_t> global_shape, int64_t element_size,
+                 int64_t max_local_tensor_bytes) {
+  int best = -1;
+  int64_t best_cost = std::numeric_limits<int64_t>::max();
+  int smallest = 0;
+  int64_t smallest_bytes = std::numeric_limits<int64_t>::max();
+  for (int i = 0; i < candidates.size(); ++i) {
+    const Layout& candidate = candidates[i];
+    const int64_t bytes =
+        LocalTensorBytes(candidate, global_shape, element_size);
+    if (bytes < smallest_bytes) {
+      smallest = i;
+      smallest_bytes = bytes;
+    }
+    if (bytes > max_local_tensor_bytes) continue;
+    int64_t cost = 0;
+    if (producer.has_value()) {
+      cost += RelayoutBytesPerDevice(*producer, candidate, global_shape,
+                                     element_size);
+    }
+    for (const Layout& consumer : consumers) {
+      cost += RelayoutBytesPerDevice(candidate, consumer, global_shape,
+                                     element_size);
+    }
+    if (cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  return best >= 0 ? best : smallest;
+}
+
+}  // namespace dtensor
+}  // namespace tensorflow
@@ -0,0 +1,61 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_DTENSOR_CC_LAYOUT_COST_MODEL_H_
+#define TENSORFLOW_DTENSOR_CC_LAYOUT_COST_MODEL_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "absl/types/span.h"
+#include "tensorflow/dtensor/cc/tensor_layout.h"
+
+namespace tensorflow {
+namespace dtensor {
+
+// A cost model of the layouts of a tensor over a mesh, estimating the memory
+// each device spends on the tensor and the communication relayouts of it take.
+// Shapes are global and static, and sizes are in bytes.
+
+// Returns the size of the local tensors of a tensor of `global_shape` with
+// elements of `element_size` bytes laid out with `layout`.
+int64_t LocalTensorBytes(const Layout& layout,
+                         absl::Span<const int64_t> global_shape,
+                         int64_t element_size);
+
+// Returns an estimate of the bytes each device receives to relayout a tensor of
+// `global_shape` from `from` to `to`. The tensor dimensions sharded in `from`
+// and not over the same mesh dimension in `to` are all-gathered, while sharding
+// a dimension only slices the local tensors and is free.
+int64_t RelayoutBytesPerDevice(const Layout& from, const Layout& to,
+                               absl::Span<const int64_t> global_shape,
+                               int64_t element_size);
+
+// Returns the index of the layout of `candidates` for a tensor of
+// `global_shape` that minimizes the bytes received to relayout it from
+// `producer`, if any, and to each layout of `consumers`, among the candidates
+// whose local tensors take at most `max_local_tensor_bytes`. If none does,
+// returns the index of the candidate with the smallest local tensors. All the
+// layouts have the rank of `global_shape`, and `candidates` isn't empty.
+int ChooseLayout(absl::Span<const Layout> candidates,
+                 const std::optional<Layout>& producer,
+                 absl::Span<const Layout> consumers,
+                 absl::Span<const int64_t> global_shape, int64_t element_size,
+                 int64_t max_local_tensor_bytes);
+
+}  // namespace dtensor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DTENSOR_CC_LAYOUT_COST_MODEL_H_
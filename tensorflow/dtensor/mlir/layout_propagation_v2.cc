@@ -58,6 +58,7 @@ limitations under the License.
 #include "tensorflow/core/util/debug_data_dumper.h"
 #include "tensorflow/dtensor/cc/constants.h"
 #include "tensorflow/dtensor/cc/dtensor_utils.h"
+#include "tensorflow/dtensor/cc/layout_cost_model.h"
 #include "tensorflow/dtensor/cc/tensor_layout.h"
 #include "tensorflow/dtensor/mlir/dtensor_dialect/ir/dialect.h"
 #include "tensorflow/dtensor/mlir/dtensor_dialect/ir/dtensor_attributes.h"
@@ -311,6 +312,56 @@ StatusOr<Layout> MergeLayouts(
   return Layout::GetLayout(producer->type(), proposed_specs, mesh);
 }
 
+// Returns `merged`, the merged layout of `value`, unless its local tensors take
+// more than LayoutPropagationMaxLocalTensorBytes(). Then returns the layout
+// among `merged` and the producer and consumer layouts that fits and costs the
+// least communication, as estimated by ChooseLayout().
+Layout FitLayoutToMemoryLimit(
+    const mlir::Value& value, const absl::optional<Layout>& producer,
+    const mlir::DenseMap<mlir::OpOperand*, Layout>& consumers,
+    const Layout& merged) {
+  const int64_t max_local_tensor_bytes =
+      LayoutPropagationMaxLocalTensorBytes();
+  auto type = value.getType().dyn_cast<mlir::RankedTensorType>();
+  if (max_local_tensor_bytes == 0 || !type || !type.hasStaticShape() ||
+      !type.getElementType().isIntOrFloat() || type.getRank() != merged.rank())
+    return merged;
+  const int64_t element_size = (type.getElementTypeBitWidth() + 7) / 8;
+  const llvm::ArrayRef<int64_t> shape = type.getShape();
+  if (LocalTensorBytes(merged, shape, element_size) <= max_local_tensor_bytes)
+    return merged;
+
+  std::vector<Layout> candidates = {merged};
+  auto add_candidate = [&](const Layout& layout) {
+    if (layout.rank() != merged.rank() || layout.mesh() != merged.mesh())
+      return;
+    std::vector<std::string> specs = layout.sharding_spec_strs();
+    FilterkAnySpecs(specs);
+    StatusOr<Layout> candidate = Layout::GetLayout(specs, layout.mesh());
+    if (candidate.ok()) candidates.push_back(*candidate);
+  };
+  std::optional<Layout> producer_layout;
+  if (producer && producer->rank() == merged.rank() &&
+      !IsProducerResourceOpWithEmptyLayout(value, *producer)) {
+    producer_layout = *producer;
+    add_candidate(*producer);
+  }
+  std::vector<Layout> consumer_layouts;
+  for (const auto& consumer : consumers) {
+    consumer_layouts.push_back(consumer.second);
+    add_candidate(consumer.second);
+  }
+  const int chosen =
+      ChooseLayout(candidates, producer_layout, consumer_layouts, shape,
+                   element_size, max_local_tensor_bytes);
+  if (chosen != 0) {
+    VLOG(2) << "Laying out " << mlir::debugString(value) << " as "
+            << candidates[chosen].ToString() << " instead of "
+            << merged.ToString() << " to fit the local tensor memory limit";
+  }
+  return candidates[chosen];
+}
+
 mlir::LogicalResult InsertLayoutsForDTensorLayout(
     mlir::ModuleOp& module,
     llvm::DenseMap<mlir::Value, std::optional<Layout>>& producer_request,
@@ -473,6 +524,8 @@ mlir::LogicalResult MergeAndGetUpdatedLayouts(
         MergeLayouts(value, producer_layout, consumer_requests[value]);
     if (!merged.ok())
       return value.getDefiningOp()->emitOpError() << merged.status().message();
+    merged = FitLayoutToMemoryLimit(value, producer_layout,
+                                    consumer_requests[value], *merged);
 
     auto current_layout = merged_layouts.find(value);
     if (current_layout == merged_layouts.end() ||
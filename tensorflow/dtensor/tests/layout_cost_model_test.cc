@@ -0,0 +1,82 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/dtensor/cc/layout_cost_model.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/dtensor/cc/tensor_layout.h"
+
+namespace tensorflow {
+namespace dtensor {
+namespace {
+
+constexpr int64_t kShape[] = {8, 4};
+constexpr int64_t kFloatSize = 4;
+
+Layout MakeLayout(const std::string& sharding_specs) {
+  return Layout::FromString(absl::StrCat("sharding_specs:", sharding_specs,
+                                         ", mesh:|x=4,y=2|*TPU"))
+      .value();
+}
+
+TEST(LayoutCostModelTest, LocalTensorBytes) {
+  EXPECT_EQ(LocalTensorBytes(MakeLayout("unsharded,unsharded"), kShape,
+                             kFloatSize),
+            128);
+  EXPECT_EQ(LocalTensorBytes(MakeLayout("x,y"), kShape, kFloatSize), 16);
+}
+
+TEST(LayoutCostModelTest, RelayoutBytesPerDevice) {
+  const Layout replicated = MakeLayout("unsharded,unsharded");
+  const Layout sharded = MakeLayout("x,unsharded");
+  // Gathering the shards of all the other devices along x.
+  EXPECT_EQ(RelayoutBytesPerDevice(sharded, replicated, kShape, kFloatSize),
+            96);
+  // Slicing the local tensors.
+  EXPECT_EQ(RelayoutBytesPerDevice(replicated, sharded, kShape, kFloatSize),
+            0);
+  EXPECT_EQ(RelayoutBytesPerDevice(sharded, sharded, kShape, kFloatSize), 0);
+  EXPECT_EQ(
+      RelayoutBytesPerDevice(sharded, MakeLayout("any,y"), kShape, kFloatSize),
+      0);
+}
+
+TEST(LayoutCostModelTest, ChooseLayoutUnderMemoryLimit) {
+  const Layout replicated = MakeLayout("unsharded,unsharded");
+  const Layout sharded = MakeLayout("x,unsharded");
+  const Layout candidates[] = {replicated, sharded};
+  const Layout consumers[] = {replicated, sharded};
+  // Without a constraint, replicating avoids communication.
+  EXPECT_EQ(ChooseLayout(candidates, std::nullopt, consumers, kShape,
+                         kFloatSize, /*max_local_tensor_bytes=*/1000),
+            0);
+  // Only the sharded layout fits.
+  EXPECT_EQ(ChooseLayout(candidates, std::nullopt, consumers, kShape,
+                         kFloatSize, /*max_local_tensor_bytes=*/64),
+            1);
+  // No layout fits, the smallest is chosen.
+  EXPECT_EQ(ChooseLayout(candidates, replicated, consumers, kShape, kFloatSize,
+                         /*max_local_tensor_bytes=*/1),
+            1);
+}
+
+}  // namespace
+}  // namespace dtensor
+}  // namespace tensorflow
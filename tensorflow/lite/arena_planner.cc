@@ -17,9 +17,11 @@ limitations under the License.
 #include <stddef.h>
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -37,7 +39,8 @@ constexpr int32_t kScalarTensorBytes = 4;
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_all_tensors, int tensor_alignment,
-                           int subgraph_index)
+                           int subgraph_index,
+                           int planning_time_budget_micros)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment, subgraph_index),
@@ -45,7 +48,8 @@ ArenaPlanner::ArenaPlanner(TfLiteContext* context,
       persistent_arena_(kDefaultArenaAlignment, subgraph_index),
       preserve_all_tensors_(preserve_all_tensors),
       tensor_alignment_(tensor_alignment),
-      last_active_node_(kLastActiveNodeUndefined) {}
+      last_active_node_(kLastActiveNodeUndefined),
+      planning_time_budget_micros_(planning_time_budget_micros) {}
 
 ArenaPlanner::~ArenaPlanner() {
   arena_.ReleaseBuffer();
@@ -333,9 +337,39 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   }
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
+
+  // Nodes of a group may run in any order, so each tensor must be live for
+  // the whole of the groups of its first and last nodes.
+  if (!concurrent_group_starts_.empty()) {
+    for (int i = 0; i < static_cast<int>(num_tensors); ++i) {
+      if (alloc_node_[i] != kNodeNotAssigned) {
+        alloc_node_[i] = GroupStart(alloc_node_[i]);
+      }
+      if (dealloc_node_[i] != kNodeNotAssigned) {
+        dealloc_node_[i] = GroupEnd(dealloc_node_[i]);
+      }
+    }
+  }
   return kTfLiteOk;
 }
 
+int32_t ArenaPlanner::GroupStart(int32_t node) const {
+  if (concurrent_group_starts_.empty()) return node;
+  auto it = std::upper_bound(concurrent_group_starts_.begin(),
+                             concurrent_group_starts_.end(), node);
+  return it == concurrent_group_starts_.begin() ? node : *(it - 1);
+}
+
+int32_t ArenaPlanner::GroupEnd(int32_t node) const {
+  if (concurrent_group_starts_.empty()) return node;
+  auto it = std::upper_bound(concurrent_group_starts_.begin(),
+                             concurrent_group_starts_.end(), node);
+  if (it == concurrent_group_starts_.end()) {
+    return std::max<int32_t>(node, graph_info_->num_execution_nodes() - 1);
+  }
+  return *it - 1;
+}
+
 TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   // Grow the size of `allocs_` if necessary. This allows allocating temporary
   // tensors in op's `prepare` function.
@@ -352,10 +386,10 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     TfLiteIntArray* node_temporaries = node.temporaries;
     for (int j = 0; j < node_temporaries->size; ++j) {
       int tensor_index = node_temporaries->data[j];
-      alloc_node_[tensor_index] = i;
+      alloc_node_[tensor_index] = GroupStart(i);
       nodes_to_tensors_[i].insert(tensor_index);
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = GroupEnd(i);
       }
     }
   }
@@ -471,6 +505,98 @@ void ArenaPlanner::CreateTensorAllocationVector(
             tensor_compare);
 }
 
+void ArenaPlanner::SearchTensorAllocationOrder(
+    std::vector<int32_t>* tensors_to_allocate) {
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::microseconds(planning_time_budget_micros_);
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  // Only the order of the tensors that take space in arena_ matters; the rest
+  // are moved to the back, keeping their order.
+  std::vector<int32_t> order;
+  std::vector<int32_t> others;
+  for (int32_t tensor_index : *tensors_to_allocate) {
+    if (tensors[tensor_index].allocation_type == kTfLiteArenaRw &&
+        tensors[tensor_index].bytes > 0 &&
+        actual_tensor_id_.find(tensor_index) == actual_tensor_id_.end()) {
+      order.push_back(tensor_index);
+    } else {
+      others.push_back(tensor_index);
+    }
+  }
+  if (order.size() < 2) return;
+
+  // No order needs less than the current arena, or than the most bytes live
+  // at once, so the search stops early once it gets there.
+  std::vector<std::pair<int64_t, int64_t>> events;
+  events.reserve(2 * order.size());
+  for (int32_t tensor_index : order) {
+    const int64_t bytes = tensors[tensor_index].bytes;
+    events.emplace_back(alloc_node_[tensor_index], bytes);
+    events.emplace_back(static_cast<int64_t>(dealloc_node_[tensor_index]) + 1,
+                        -bytes);
+  }
+  std::sort(events.begin(), events.end());
+  int64_t live_bytes = 0;
+  int64_t lower_bound = arena_.RequiredBufferSize();
+  for (const auto& event : events) {
+    live_bytes += event.second;
+    lower_bound = std::max(lower_bound, live_bytes);
+  }
+
+  SimpleMemoryArena scratch_arena(kDefaultArenaAlignment);
+  const size_t initial_size = CalculateArenaSize(order, &scratch_arena);
+  size_t best_size = initial_size;
+  std::vector<int32_t> candidate = order;
+  // A fixed seed keeps the plan, and so the arena size, reproducible.
+  std::minstd_rand rng(order.size());
+  std::uniform_int_distribution<size_t> position(0, order.size() - 1);
+  while (best_size > static_cast<size_t>(lower_bound) &&
+         std::chrono::steady_clock::now() < deadline) {
+    // Move one tensor to another place in the order. Moves that don't make
+    // the arena larger are kept, so that the search can cross plateaus.
+    const size_t from = position(rng);
+    const size_t to = position(rng);
+    if (from == to) continue;
+    if (from < to) {
+      std::rotate(candidate.begin() + from, candidate.begin() + from + 1,
+                  candidate.begin() + to + 1);
+    } else {
+      std::rotate(candidate.begin() + to, candidate.begin() + from,
+                  candidate.begin() + from + 1);
+    }
+    const size_t size = CalculateArenaSize(candidate, &scratch_arena);
+    if (size <= best_size) {
+      best_size = size;
+      order = candidate;
+    } else {
+      candidate = order;
+    }
+  }
+  // Only replace the greedy order if it actually saves memory.
+  if (best_size < initial_size) {
+    order.insert(order.end(), others.begin(), others.end());
+    *tensors_to_allocate = std::move(order);
+  }
+}
+
+size_t ArenaPlanner::CalculateArenaSize(const std::vector<int32_t>& tensors,
+                                        SimpleMemoryArena* scratch_arena) {
+  scratch_arena->CopyPlanFrom(arena_);
+  const TfLiteTensor* graph_tensors = graph_info_->tensors();
+  ArenaAllocWithUsageInterval alloc;
+  for (int32_t tensor_index : tensors) {
+    if (scratch_arena->Allocate(context_, tensor_alignment_,
+                                graph_tensors[tensor_index].bytes,
+                                tensor_index, alloc_node_[tensor_index],
+                                dealloc_node_[tensor_index],
+                                &alloc) != kTfLiteOk) {
+      return std::numeric_limits<size_t>::max();
+    }
+  }
+  return scratch_arena->RequiredBufferSize();
+}
+
 std::vector<int32_t> ArenaPlanner::GetTensorsToAllocate(int first_node,
                                                         int last_node) {
   int num_tensors = static_cast<int>(graph_info_->num_tensors());
@@ -518,6 +644,9 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
     arena_.PurgeActiveAllocs(first_node);
   }
   CreateTensorAllocationVector(tensors_allocated);
+  if (planning_time_budget_micros_ > 0) {
+    SearchTensorAllocationOrder(tensors_allocated);
+  }
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : *tensors_allocated) {
     TfLiteTensor& tensor = tensors[tensor_index];
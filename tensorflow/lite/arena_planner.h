@@ -20,6 +20,7 @@ limitations under the License.
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
@@ -50,10 +51,12 @@ class ArenaPlanner : public MemoryPlanner {
   // Ownership of 'context' is not taken and it must remain util the
   // ArenaPlanner is destroyed. The inputs to the graph will not share
   // memory with any other tensor, effectively preserving them until the end
-  // of inference.
+  // of inference. A positive 'planning_time_budget_micros' lets the planner
+  // search, for up to that long each time it calculates allocations, for an
+  // allocation order that needs a smaller arena than the greedy one.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_all_tensors, int tensor_alignment,
-               int subgraph_index = 0);
+               int subgraph_index = 0, int planning_time_budget_micros = 0);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -72,6 +75,15 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Splits the nodes into groups of consecutive nodes that may run
+  // concurrently, 'group_starts' being the first node of each group in
+  // increasing order. The tensors of a node then live for the whole of its
+  // group, so that no two nodes of a group share memory. Must be called before
+  // PlanAllocations().
+  void SetConcurrentNodeGroups(std::vector<int> group_starts) {
+    concurrent_group_starts_ = std::move(group_starts);
+  }
+
  private:
   // Check whether the input tensor's memory may be shared the output tensor.
   // tensor_changed: true if the output tensor modifies the tensor data. For
@@ -109,6 +121,16 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ResolveTensorAllocation(int32_t tensor_index,
                                        TfLiteTensor* tensors);
 
+  // Reorders the kTfLiteArenaRw tensors at the front of 'tensors_to_allocate'
+  // by local search to reduce the size of the arena, for up to
+  // planning_time_budget_micros_. The order is kept if no better one is found.
+  void SearchTensorAllocationOrder(std::vector<int32_t>* tensors_to_allocate);
+
+  // Returns the arena size that allocating 'tensors' in order on top of the
+  // current plan of arena_ would need.
+  size_t CalculateArenaSize(const std::vector<int32_t>& tensors,
+                            SimpleMemoryArena* scratch_arena);
+
   // Register an allocation for all internal (temporary) tensors of
   // 'node_index'.
   TfLiteStatus CalculateAllocationOfInternalTensors(int node_index);
@@ -120,6 +142,11 @@ class ArenaPlanner : public MemoryPlanner {
   // Return the index of the tensor owing `tensor_index's` buffer.
   int FindSharedTensor(int tensor_index);
 
+  // Return the first and the last node of the concurrent group of 'node', or
+  // 'node' itself if there are no groups.
+  int32_t GroupStart(int32_t node) const;
+  int32_t GroupEnd(int32_t node) const;
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -159,6 +186,13 @@ class ArenaPlanner : public MemoryPlanner {
   // Index of the last node whose tensors were allocated.
   int last_active_node_;
 
+  // Time allowed for SearchTensorAllocationOrder. Zero disables the search.
+  int planning_time_budget_micros_;
+
+  // First node of each group of nodes that may run concurrently. Empty if
+  // nodes run one at a time.
+  std::vector<int> concurrent_group_starts_;
+
   // Holds index of original tensor if the tensor is sharing underlined
   // data with another tensor.
   // NOLINTNEXTLINE - absl::flat_hash_map increases binary size by 106kB.
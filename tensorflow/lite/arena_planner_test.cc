@@ -208,12 +208,14 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false) {
+  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false,
+                int planning_time_budget_micros = 0) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_ = std::make_unique<ArenaPlanner>(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_all_tensors, kTensorAlignment);
+        preserve_all_tensors, kTensorAlignment, /*subgraph_index=*/0,
+        planning_time_budget_micros);
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -411,6 +413,85 @@ TEST_F(ArenaPlannerTest, SimpleGraphWithTemporary) {
   EXPECT_EQ(GetOffset(1), 4);
 }
 
+TEST_F(ArenaPlannerTest, PlanningSearchShrinksArena) {
+  auto make_graph = [] {
+    constexpr int kNone = kTfLiteInplaceOpNone;
+    auto graph = std::make_unique<TestGraph>(
+        std::initializer_list<int>{5},
+        std::initializer_list<TestOp>{
+            /* in, out, tmp */
+            {{5}, {1, 2}, {}, kTfLiteBuiltinAdd, kNone},
+            {{}, {}, {}, kTfLiteBuiltinAdd, kNone},
+            {{2}, {3}, {}, kTfLiteBuiltinAdd, kNone},
+            {{3}, {0, 4}, {}, kTfLiteBuiltinAdd, kNone},
+            {{0, 4, 1}, {6}, {}, kTfLiteBuiltinAdd, kNone},
+        },
+        std::initializer_list<int>{6});
+    std::vector<TfLiteTensor>& tensors = *graph->tensors();
+    for (int i : {5, 6}) tensors[i].bytes = 0;
+    tensors[0].bytes = 12;
+    tensors[1].bytes = 16;
+    tensors[2].bytes = 20;
+    tensors[3].bytes = 20;
+    tensors[4].bytes = 12;
+    return graph;
+  };
+  size_t arena_size, arena_persist_size;
+
+  // Largest first, 2 is placed at 0, 3 at 20 and 1 at 40. 0 then takes the
+  // space freed by 2, but 4 only fits above 1.
+  auto greedy_graph = make_graph();
+  SetGraph(greedy_graph.get());
+  Execute(0, greedy_graph->nodes().size() - 1);
+  planner_->GetAllocInfo(&arena_size, &arena_persist_size);
+  EXPECT_EQ(arena_size, 68);
+
+  auto graph = make_graph();
+  SetGraph(graph.get(), /*preserve_all_tensors=*/false,
+           /*planning_time_budget_micros=*/1000000);
+  Execute(0, graph->nodes().size() - 1);
+  planner_->GetAllocInfo(&arena_size, &arena_persist_size);
+  // 60 bytes are live while node 3 runs.
+  EXPECT_EQ(arena_size, 60);
+  // Tensors that are live at the same time must not overlap.
+  const std::vector<std::pair<int, int>> live_together = {
+      {1, 2}, {1, 3}, {2, 3}, {1, 0}, {1, 4}, {3, 0}, {3, 4}, {0, 4}};
+  for (const auto& [a, b] : live_together) {
+    EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(b) ||
+                GetOffsetAfter(b) <= GetOffset(a))
+        << a << " and " << b << " overlap";
+  }
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodeGroups) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First op
+                      {{1}, {2}, {5}},    // Second op, with temporary
+                      {{0}, {3}, {}},     // Third op, concurrent with second
+                      {{2, 3}, {4}, {}},  // Fourth op
+                  },
+                  {4});
+  graph_ = &graph;
+  context_.ReportError = ReportError;
+  planner_ = std::make_unique<ArenaPlanner>(
+      &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(&graph)),
+      /*preserve_all_tensors=*/false, kTensorAlignment);
+  planner_->SetConcurrentNodeGroups({0, 1, 3});
+  ASSERT_EQ(planner_->ResetAllocations(), kTfLiteOk);
+  ASSERT_EQ(planner_->PlanAllocations(), kTfLiteOk);
+  Execute(0, graph.nodes().size() - 1);
+
+  // 1 dies in the second op, but the third op may run at the same time, so
+  // neither 3 nor the temporary may reuse its memory.
+  for (int a : {1, 2, 5}) {
+    EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(3) ||
+                GetOffsetAfter(3) <= GetOffset(a))
+        << a << " and 3 overlap";
+  }
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphWithInplaceReshape) {
   TestGraph graph(
       {0, 1},
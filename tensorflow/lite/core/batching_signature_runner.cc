@@ -0,0 +1,166 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/batching_signature_runner.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/signature_runner.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+
+BatchingSignatureRunner::BatchingSignatureRunner(impl::SignatureRunner* runner,
+                                                 const Options& options)
+    : runner_(runner), options_(options) {}
+
+TfLiteStatus BatchingSignatureRunner::Invoke(
+    int batch_size, const std::vector<const void*>& inputs,
+    std::vector<std::vector<char>>* outputs) {
+  if (batch_size <= 0 || inputs.size() != runner_->input_size() ||
+      outputs == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                    "Invalid request of %d items with %zu inputs.", batch_size,
+                    inputs.size());
+    return kTfLiteError;
+  }
+  Request request{batch_size, &inputs, outputs,
+                  std::chrono::steady_clock::now()};
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_back(&request);
+  queued_items_ += batch_size;
+  changed_.notify_all();
+  while (!request.done) {
+    if (has_leader_) {
+      changed_.wait(lock);
+      continue;
+    }
+    // The request is still queued, so this caller runs the next batch, which
+    // may or may not include it.
+    has_leader_ = true;
+    const std::vector<Request*> batch = GatherBatch(lock);
+    lock.unlock();
+    const TfLiteStatus status = RunBatch(batch);
+    lock.lock();
+    for (Request* batched : batch) {
+      batched->status = status;
+      batched->done = true;
+    }
+    ++num_batches_;
+    has_leader_ = false;
+    changed_.notify_all();
+  }
+  return request.status;
+}
+
+int64_t BatchingSignatureRunner::num_batches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_batches_;
+}
+
+std::vector<BatchingSignatureRunner::Request*>
+BatchingSignatureRunner::GatherBatch(std::unique_lock<std::mutex>& lock) {
+  const auto deadline = queue_.front()->arrival_time + options_.batch_timeout;
+  changed_.wait_until(lock, deadline, [this] {
+    return queued_items_ >= options_.max_batch_size;
+  });
+  std::vector<Request*> batch;
+  int batch_size = 0;
+  while (!queue_.empty() &&
+         (batch.empty() || batch_size + queue_.front()->batch_size <=
+                               options_.max_batch_size)) {
+    batch.push_back(queue_.front());
+    batch_size += queue_.front()->batch_size;
+    queued_items_ -= queue_.front()->batch_size;
+    queue_.pop_front();
+  }
+  return batch;
+}
+
+TfLiteStatus BatchingSignatureRunner::RunBatch(
+    const std::vector<Request*>& batch) {
+  int batch_size = 0;
+  for (const Request* request : batch) {
+    batch_size += request->batch_size;
+  }
+  TF_LITE_ENSURE_STATUS(ResizeInputs(batch_size));
+
+  const std::vector<const char*>& input_names = runner_->input_names();
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    TfLiteTensor* tensor = runner_->input_tensor(input_names[i]);
+    const size_t item_bytes = tensor->bytes / batch_size;
+    char* data = tensor->data.raw;
+    for (const Request* request : batch) {
+      const size_t bytes = item_bytes * request->batch_size;
+      std::memcpy(data, (*request->inputs)[i], bytes);
+      data += bytes;
+    }
+  }
+
+  TF_LITE_ENSURE_STATUS(runner_->Invoke());
+
+  const std::vector<const char*>& output_names = runner_->output_names();
+  for (Request* request : batch) {
+    request->outputs->resize(output_names.size());
+  }
+  for (size_t i = 0; i < output_names.size(); ++i) {
+    const TfLiteTensor* tensor = runner_->output_tensor(output_names[i]);
+    if (tensor->dims->size == 0 || tensor->dims->data[0] != batch_size ||
+        tensor->data.raw_const == nullptr) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "Output %s doesn't have the batch of %d items as its "
+                      "first dimension.",
+                      output_names[i], batch_size);
+      return kTfLiteError;
+    }
+    const size_t item_bytes = tensor->bytes / batch_size;
+    const char* data = tensor->data.raw_const;
+    for (Request* request : batch) {
+      const size_t bytes = item_bytes * request->batch_size;
+      (*request->outputs)[i].assign(data, data + bytes);
+      data += bytes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchingSignatureRunner::ResizeInputs(int batch_size) {
+  for (const char* name : runner_->input_names()) {
+    const TfLiteTensor* tensor = runner_->input_tensor(name);
+    if (tensor->dims->size == 0 || tensor->type == kTfLiteString ||
+        tensor->type == kTfLiteResource || tensor->type == kTfLiteVariant) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "Input %s can't be batched, it must have a fixed size "
+                      "type and the batch as its first dimension.",
+                      name);
+      return kTfLiteError;
+    }
+    if (tensor->dims->data[0] == batch_size) continue;
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    dims[0] = batch_size;
+    TF_LITE_ENSURE_STATUS(runner_->ResizeInputTensor(name, dims));
+  }
+  // Does nothing if no input was resized since the last batch.
+  return runner_->AllocateTensors();
+}
+
+}  // namespace tflite
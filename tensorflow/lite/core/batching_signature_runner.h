@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_BATCHING_SIGNATURE_RUNNER_H_
+#define TENSORFLOW_LITE_CORE_BATCHING_SIGNATURE_RUNNER_H_
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/signature_runner.h"
+
+namespace tflite {
+
+/// Coalesces concurrent requests to a SignatureRunner into batches. Every
+/// input and output of the signature must have the batch as its first
+/// dimension, e.g. [batch, features]. The requests that arrive while a batch
+/// is gathered or runs are concatenated along that dimension, up to
+/// `max_batch_size` items, and the outputs are split back between them.
+///
+/// A batch runs once it has `max_batch_size` items, or `batch_timeout` after
+/// its oldest request arrived. There is no thread of its own: one of the
+/// waiting callers gathers and runs each batch.
+///
+/// Usage:
+///
+/// <pre><code>
+/// tflite::BatchingSignatureRunner batcher(
+///     interpreter->GetSignatureRunner("serving_default"), {});
+/// // From any number of threads:
+/// std::vector<std::vector<char>> outputs;
+/// if (batcher.Invoke(/*batch_size=*/1, {input_data}, &outputs) !=
+///     kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// The signature runner must not be used directly while the batcher is in
+/// use, and must outlive it. Only tensors of fixed size types are supported,
+/// i.e. not strings.
+///
+/// WARNING: This is an experimental API and subject to change.
+class BatchingSignatureRunner {
+ public:
+  struct Options {
+    /// The most items in a batch. A single request with more items runs in a
+    /// batch of its own.
+    int max_batch_size = 8;
+    /// How long a request may wait for others to be batched with.
+    std::chrono::microseconds batch_timeout{1000};
+  };
+
+  BatchingSignatureRunner(impl::SignatureRunner* runner,
+                          const Options& options);
+
+  BatchingSignatureRunner(const BatchingSignatureRunner&) = delete;
+  BatchingSignatureRunner& operator=(const BatchingSignatureRunner&) = delete;
+
+  /// Runs the signature on a request of `batch_size` items, as part of a
+  /// batch. `inputs[i]` is the data of the input named `input_names()[i]` of
+  /// the signature runner for the items. On success, `outputs[i]` is set to
+  /// the data of the output named `output_names()[i]` for the items.
+  /// Thread-safe, blocks until the batch ran. If it fails, all the requests
+  /// of the batch fail.
+  TfLiteStatus Invoke(int batch_size, const std::vector<const void*>& inputs,
+                      std::vector<std::vector<char>>* outputs);
+
+  /// The number of batches that ran, e.g. to check how well requests are
+  /// coalesced.
+  int64_t num_batches() const;
+
+ private:
+  struct Request {
+    int batch_size;
+    const std::vector<const void*>* inputs;
+    std::vector<std::vector<char>>* outputs;
+    std::chrono::steady_clock::time_point arrival_time;
+    TfLiteStatus status = kTfLiteOk;
+    bool done = false;
+  };
+
+  // Takes the requests of the next batch from the front of the queue, once it
+  // is full or timed out.
+  std::vector<Request*> GatherBatch(std::unique_lock<std::mutex>& lock);
+  // Concatenates the inputs of `batch`, invokes the signature runner and
+  // splits the outputs.
+  TfLiteStatus RunBatch(const std::vector<Request*>& batch);
+  // Resizes the inputs to `batch_size` items, and reallocates if needed.
+  TfLiteStatus ResizeInputs(int batch_size);
+
+  impl::SignatureRunner* const runner_;
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  // The requests that aren't part of a batch yet, in arrival order.
+  std::deque<Request*> queue_;
+  int queued_items_ = 0;
+  // Whether a caller is gathering or running a batch.
+  bool has_leader_ = false;
+  int64_t num_batches_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_BATCHING_SIGNATURE_RUNNER_H_
@@ -0,0 +1,123 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/batching_signature_runner.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/core/model_builder.h"
+#include "tensorflow/lite/core/signature_runner.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+// The "add" signature of the model adds 2 to its input "x" of shape [batch].
+class BatchingSignatureRunnerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_signatures.bin", &reporter_);
+    ASSERT_TRUE(model_);
+    ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(InterpreterBuilder(*model_, resolver)(&interpreter_), kTfLiteOk);
+    runner_ = interpreter_->GetSignatureRunner("add");
+    ASSERT_NE(runner_, nullptr);
+  }
+
+  // Invokes `batcher` from a thread per request, the items of request i being
+  // 10 * i + j for j < `batch_sizes[i]`, and checks the outputs.
+  void InvokeConcurrently(BatchingSignatureRunner& batcher,
+                          const std::vector<int>& batch_sizes) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < static_cast<int>(batch_sizes.size()); ++i) {
+      threads.emplace_back([&batcher, i, batch_size = batch_sizes[i]] {
+        std::vector<float> input;
+        for (int j = 0; j < batch_size; ++j) {
+          input.push_back(10 * i + j);
+        }
+        std::vector<std::vector<char>> outputs;
+        ASSERT_EQ(batcher.Invoke(batch_size, {input.data()}, &outputs),
+                  kTfLiteOk);
+        ASSERT_EQ(outputs.size(), 1);
+        ASSERT_EQ(outputs[0].size(), batch_size * sizeof(float));
+        std::vector<float> output(batch_size);
+        std::memcpy(output.data(), outputs[0].data(), outputs[0].size());
+        for (int j = 0; j < batch_size; ++j) {
+          EXPECT_EQ(output[j], input[j] + 2);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+
+  TestErrorReporter reporter_;
+  std::unique_ptr<FlatBufferModel> model_;
+  std::unique_ptr<Interpreter> interpreter_;
+  impl::SignatureRunner* runner_ = nullptr;
+};
+
+TEST_F(BatchingSignatureRunnerTest, CoalescesConcurrentRequests) {
+  // Long enough that the batch only runs once full.
+  BatchingSignatureRunner batcher(
+      runner_, {/*max_batch_size=*/8, std::chrono::seconds(60)});
+  InvokeConcurrently(batcher, {1, 2, 1, 3, 1});
+  EXPECT_EQ(batcher.num_batches(), 1);
+}
+
+TEST_F(BatchingSignatureRunnerTest, SplitsRequestsIntoBatches) {
+  BatchingSignatureRunner batcher(
+      runner_, {/*max_batch_size=*/4, std::chrono::seconds(60)});
+  InvokeConcurrently(batcher, {2, 2, 2, 2, 2, 2});
+  EXPECT_EQ(batcher.num_batches(), 3);
+}
+
+TEST_F(BatchingSignatureRunnerTest, RunsPartialBatchAfterTimeout) {
+  BatchingSignatureRunner batcher(
+      runner_, {/*max_batch_size=*/8, std::chrono::milliseconds(1)});
+  InvokeConcurrently(batcher, {3});
+  InvokeConcurrently(batcher, {1});
+  EXPECT_EQ(batcher.num_batches(), 2);
+}
+
+TEST_F(BatchingSignatureRunnerTest, RunsLargeRequestAlone) {
+  BatchingSignatureRunner batcher(
+      runner_, {/*max_batch_size=*/4, std::chrono::milliseconds(1)});
+  InvokeConcurrently(batcher, {10});
+  EXPECT_EQ(batcher.num_batches(), 1);
+}
+
+TEST_F(BatchingSignatureRunnerTest, RejectsInvalidRequests) {
+  BatchingSignatureRunner batcher(runner_, {});
+  const float input = 1;
+  std::vector<std::vector<char>> outputs;
+  EXPECT_EQ(batcher.Invoke(0, {&input}, &outputs), kTfLiteError);
+  EXPECT_EQ(batcher.Invoke(1, {&input, &input}, &outputs), kTfLiteError);
+  EXPECT_EQ(batcher.Invoke(1, {&input}, nullptr), kTfLiteError);
+  EXPECT_EQ(batcher.num_batches(), 0);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -181,6 +181,8 @@ void TfLiteQuantizationFree(TfLiteQuantization* quantization) {
       q_params->zero_point = nullptr;
     }
     free(q_params);
+  } else if (quantization->type == kTfLiteBlockwiseQuantization) {
+    free(quantization->params);
   }
   quantization->params = nullptr;
   quantization->type = kTfLiteNoQuantization;
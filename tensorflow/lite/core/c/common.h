@@ -313,6 +313,11 @@ typedef enum TfLiteQuantizationType {
   /// Affine quantization (with support for per-channel quantization).
   /// Corresponds to TfLiteAffineQuantization.
   kTfLiteAffineQuantization = 1,
+  /// Symmetric quantization in blocks along a dimension, with a scale per
+  /// block. Corresponds to TfLiteBlockwiseQuantization.
+  ///
+  /// WARNING: This is an experimental type and subject to change.
+  kTfLiteBlockwiseQuantization = 2,
 } TfLiteQuantizationType;
 
 /// Structure specifying the quantization used by the tensor, if-any.
@@ -338,6 +343,24 @@ typedef struct TfLiteAffineQuantization {
   int32_t quantized_dimension;
 } TfLiteAffineQuantization;
 
+/// Parameters for quantization in blocks of `blocksize` consecutive values
+/// along `quantized_dimension`, each with its own scale. This is typically used
+/// for 4-bit weights, with blocks of 32 or 64 values.
+/// `scale` is the index of a float32 tensor holding the scales, with the shape
+/// of the quantized tensor except that `quantized_dimension` has one entry per
+/// block. `zero_point` is the index of a tensor of zero points of that shape,
+/// or -1 if the quantization is symmetric.
+/// Quantized values can be converted back to float using:
+///     `real_value = scale[block] * (quantized_value - zero_point[block])`
+///
+/// WARNING: This is an experimental type and subject to change.
+typedef struct TfLiteBlockwiseQuantization {
+  int32_t scale;
+  int32_t zero_point;
+  int32_t blocksize;
+  int32_t quantized_dimension;
+} TfLiteBlockwiseQuantization;
+
 /// A union of pointers that points to memory for a given tensor.
 ///
 /// Do not access these members directly, if possible, use
@@ -0,0 +1,104 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
+
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+
+namespace tflite {
+
+InterOpThreadPool::InterOpThreadPool(int num_threads)
+    : num_threads_(num_threads > 1 ? num_threads : 1) {
+  threads_.reserve(num_threads_ - 1);
+  for (int thread = 1; thread < num_threads_; ++thread) {
+    threads_.emplace_back([this, thread] { WorkerLoop(thread); });
+  }
+}
+
+InterOpThreadPool::~InterOpThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void InterOpThreadPool::ParallelFor(int num_tasks,
+                                    const std::function<void(int, int)>& fn) {
+  if (num_tasks <= 0) return;
+  if (threads_.empty() || num_tasks == 1) {
+    for (int task = 0; task < num_tasks; ++task) fn(task, 0);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // A thread that woke up too late for the previous call may still be
+    // looking at it.
+    work_done_.wait(lock, [this] { return num_active_threads_ == 0; });
+    fn_ = &fn;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    num_unfinished_tasks_ = num_tasks;
+    ++generation_;
+  }
+  work_available_.notify_all();
+  RunTasks(/*thread=*/0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] { return num_unfinished_tasks_ == 0; });
+  fn_ = nullptr;
+}
+
+void InterOpThreadPool::WorkerLoop(int thread) {
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(
+          lock, [&] { return stop_ || generation_ != generation; });
+      if (stop_) return;
+      generation = generation_;
+      ++num_active_threads_;
+    }
+    RunTasks(thread);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --num_active_threads_;
+    }
+    work_done_.notify_all();
+  }
+}
+
+void InterOpThreadPool::RunTasks(int thread) {
+  while (true) {
+    int task;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (next_task_ >= num_tasks_) return;
+      task = next_task_++;
+    }
+    (*fn_)(task, thread);
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done = --num_unfinished_tasks_ == 0;
+    }
+    if (done) work_done_.notify_all();
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,71 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
+#define TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace tflite {
+
+// A fixed set of threads for running independent nodes of a subgraph
+// concurrently. The thread that calls `ParallelFor` runs tasks as well, so a
+// pool of `num_threads` starts `num_threads - 1` threads of its own.
+class InterOpThreadPool {
+ public:
+  explicit InterOpThreadPool(int num_threads);
+  ~InterOpThreadPool();
+
+  InterOpThreadPool(const InterOpThreadPool&) = delete;
+  InterOpThreadPool& operator=(const InterOpThreadPool&) = delete;
+
+  int num_threads() const { return num_threads_; }
+
+  // Calls `fn(task, thread)` for every `task` in [0, num_tasks), and returns
+  // once all the calls have returned. `thread`, in [0, num_threads()), tells
+  // which thread of the pool runs the task; the calling thread is 0. Must not
+  // be called concurrently, or from one of the tasks.
+  void ParallelFor(int num_tasks, const std::function<void(int, int)>& fn);
+
+ private:
+  void WorkerLoop(int thread);
+  // Runs tasks of the current ParallelFor until there are none left.
+  void RunTasks(int thread);
+
+  const int num_threads_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  // Incremented by each ParallelFor, to wake the threads up.
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+  // The current ParallelFor. Only changed while no thread is in RunTasks.
+  const std::function<void(int, int)>* fn_ = nullptr;
+  int num_tasks_ = 0;
+  int next_task_ = 0;
+  int num_unfinished_tasks_ = 0;
+  // Number of threads in RunTasks, other than the calling one.
+  int num_active_threads_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_INTER_OP_THREAD_POOL_H_
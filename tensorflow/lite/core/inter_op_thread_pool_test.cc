@@ -0,0 +1,72 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
+
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+TEST(InterOpThreadPoolTest, RunsEveryTaskOnce) {
+  InterOpThreadPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int num_tasks : {0, 1, 3, 100}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    pool.ParallelFor(num_tasks, [&](int task, int thread) {
+      EXPECT_GE(thread, 0);
+      EXPECT_LT(thread, 4);
+      ++runs[task];
+    });
+    for (int task = 0; task < num_tasks; ++task) {
+      EXPECT_EQ(runs[task].load(), 1) << task;
+    }
+  }
+}
+
+TEST(InterOpThreadPoolTest, RunsTasksConcurrently) {
+  InterOpThreadPool pool(2);
+  // Each task waits for the other to start, so they can only finish if they
+  // run at the same time.
+  std::atomic<int> num_started = 0;
+  std::set<int> threads;
+  std::mutex mutex;
+  pool.ParallelFor(2, [&](int /*task*/, int thread) {
+    ++num_started;
+    while (num_started < 2) {
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.insert(thread);
+  });
+  EXPECT_EQ(threads, (std::set<int>{0, 1}));
+}
+
+TEST(InterOpThreadPoolTest, SingleThread) {
+  InterOpThreadPool pool(0);
+  EXPECT_EQ(pool.num_threads(), 1);
+  int sum = 0;
+  pool.ParallelFor(10, [&](int task, int thread) {
+    EXPECT_EQ(thread, 0);
+    sum += task;
+  });
+  EXPECT_EQ(sum, 45);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
@@ -59,6 +60,14 @@ namespace tflite {
 
 namespace {
 
+// The number of nodes ahead of the running one whose streamed weights are
+// prefetched.
+constexpr int kWeightPrefetchDistance = 2;
+
+// The CPU backend context for the kernels run by this thread, while it runs
+// nodes of a subgraph concurrently with other threads.
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
 struct TfLiteQuantizationDeleter {
   void operator()(TfLiteQuantization* q) {
     if (q) TfLiteQuantizationFree(q);
@@ -89,6 +98,152 @@ TfLiteStatus ReportOpError(TfLiteContext* context, const TfLiteNode& node,
   return kTfLiteError;
 }
 
+// Returns the fused activation of a conv or fully connected node, or nullptr
+// for other nodes.
+TfLiteFusedActivation* GetFusableActivation(
+    const TfLiteRegistration& registration, TfLiteNode* node) {
+  if (node->builtin_data == nullptr) return nullptr;
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinConv2d:
+      return &static_cast<TfLiteConvParams*>(node->builtin_data)->activation;
+    case kTfLiteBuiltinDepthwiseConv2d:
+      return &static_cast<TfLiteDepthwiseConvParams*>(node->builtin_data)
+                  ->activation;
+    case kTfLiteBuiltinFullyConnected:
+      return &static_cast<TfLiteFullyConnectedParams*>(node->builtin_data)
+                  ->activation;
+    default:
+      return nullptr;
+  }
+}
+
+// True if the conv and fully connected kernels apply `activation` as a clamp.
+bool IsClampActivation(TfLiteFusedActivation activation) {
+  return activation == kTfLiteActNone || activation == kTfLiteActRelu ||
+         activation == kTfLiteActRelu6 || activation == kTfLiteActReluN1To1;
+}
+
+// True if the tensor `bias_index`, added to the output of the conv or fully
+// connected `node`, is a constant with one value per output channel that the
+// node can add as its bias instead.
+bool IsFoldableBias(const TfLiteTensor* tensors,
+                    const TfLiteRegistration& registration,
+                    const TfLiteNode& node, int bias_index) {
+  if (node.inputs->size < 2 ||
+      (node.inputs->size > 2 &&
+       node.inputs->data[2] != kTfLiteOptionalTensor)) {
+    // The node has a bias already.
+    return false;
+  }
+  const TfLiteTensor& filter = tensors[node.inputs->data[1]];
+  const TfLiteTensor& output = tensors[node.outputs->data[0]];
+  const TfLiteTensor& bias = tensors[bias_index];
+  if (bias.type != kTfLiteFloat32 || bias.allocation_type != kTfLiteMmapRo ||
+      bias.dims == nullptr || filter.dims == nullptr ||
+      output.dims == nullptr) {
+    return false;
+  }
+  // The depthwise filter has the output channels last.
+  const int channel_dim =
+      registration.builtin_code == kTfLiteBuiltinDepthwiseConv2d ? 3 : 0;
+  // The addition must not broadcast the output to more dimensions.
+  if (filter.dims->size <= channel_dim || bias.dims->size == 0 ||
+      bias.dims->size > output.dims->size) {
+    return false;
+  }
+  for (int i = 0; i < bias.dims->size - 1; ++i) {
+    if (bias.dims->data[i] != 1) return false;
+  }
+  return bias.dims->data[bias.dims->size - 1] ==
+         filter.dims->data[channel_dim];
+}
+
+// Fuses `epilogue`, the only reader of the output of the conv or fully
+// connected `node`, into `node` if it's an activation or a bias addition.
+// Returns false, leaving the nodes unchanged, otherwise.
+bool FuseEpilogue(const TfLiteTensor* tensors,
+                  const TfLiteRegistration& registration, TfLiteNode* node,
+                  const TfLiteRegistration& epilogue_registration,
+                  const TfLiteNode& epilogue) {
+  TfLiteFusedActivation activation;
+  int bias_index = kTfLiteOptionalTensor;
+  switch (epilogue_registration.builtin_code) {
+    case kTfLiteBuiltinRelu:
+      activation = kTfLiteActRelu;
+      break;
+    case kTfLiteBuiltinRelu6:
+      activation = kTfLiteActRelu6;
+      break;
+    case kTfLiteBuiltinReluN1To1:
+      activation = kTfLiteActReluN1To1;
+      break;
+    case kTfLiteBuiltinAdd: {
+      if (epilogue.builtin_data == nullptr || epilogue.inputs->size != 2) {
+        return false;
+      }
+      activation =
+          static_cast<const TfLiteAddParams*>(epilogue.builtin_data)
+              ->activation;
+      const int output = node->outputs->data[0];
+      bias_index = epilogue.inputs->data[0] == output
+                       ? epilogue.inputs->data[1]
+                       : epilogue.inputs->data[0];
+      if (!IsClampActivation(activation) ||
+          bias_index == kTfLiteOptionalTensor ||
+          !IsFoldableBias(tensors, registration, *node, bias_index)) {
+        return false;
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+  if (bias_index == kTfLiteOptionalTensor && epilogue.inputs->size != 1) {
+    return false;
+  }
+
+  if (bias_index != kTfLiteOptionalTensor) {
+    TfLiteIntArray* inputs = TfLiteIntArrayCreate(3);
+    inputs->data[0] = node->inputs->data[0];
+    inputs->data[1] = node->inputs->data[1];
+    inputs->data[2] = bias_index;
+    TfLiteIntArrayFree(node->inputs);
+    node->inputs = inputs;
+  }
+  *GetFusableActivation(registration, node) = activation;
+  node->outputs->data[0] = epilogue.outputs->data[0];
+  return true;
+}
+
+// How a node handles float16 activations.
+enum class Float16Support {
+  kNone,
+  // Reads and writes float16 or float32 values, computing in float32.
+  kConverts,
+  // Moves the values of its first input to its output, which must then have
+  // the same type.
+  kPassesThrough,
+};
+
+Float16Support GetFloat16Support(const TfLiteRegistration& registration,
+                                 const TfLiteNode& node) {
+  if (node.delegate != nullptr || node.outputs->size != 1) {
+    return Float16Support::kNone;
+  }
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinMul:
+      return Float16Support::kConverts;
+    case kTfLiteBuiltinReshape:
+    case kTfLiteBuiltinSqueeze:
+    case kTfLiteBuiltinExpandDims:
+      return node.inputs->size >= 1 ? Float16Support::kPassesThrough
+                                     : Float16Support::kNone;
+    default:
+      return Float16Support::kNone;
+  }
+}
+
 // Stub method which returns kTfLiteError when the function is forbidden.
 // We're registering this function to several different function to save
 // compiled binary size. Please note the restrictions:
@@ -615,6 +770,10 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext &&
+      inter_op_cpu_backend_context != nullptr) {
+    return inter_op_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -1007,10 +1166,23 @@ TfLiteStatus Subgraph::AllocateTensors() {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
 
-  TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
+  // If only inputs were resized, only the nodes that depend on them need to
+  // be prepared again.
+  if (!resized_input_tensors_.empty()) {
+    changed_tensors_.assign(tensors_.size(), false);
+    for (int tensor_index : resized_input_tensors_) {
+      changed_tensors_[tensor_index] = true;
+    }
+    resized_input_tensors_.clear();
+  }
+  const TfLiteStatus prepare_status = PrepareOpsAndTensors();
+  changed_tensors_.clear();
+  TF_LITE_ENSURE_STATUS(prepare_status);
 
   state_ = kStateInvokable;
 
+  PlanWeightStreaming();
+
   // Reset the variable tensors to zero after (re)allocating the tensors.
   // Developers shouldn't rely on the side effect of this function to reset
   // variable tensors. They should call `ResetVariableTensors` directly
@@ -1079,6 +1251,7 @@ TfLiteStatus Subgraph::AddNodeWithParameters(
     return kTfLiteError;
   }
   state_ = kStateUninvokable;
+  resized_input_tensors_.clear();
 
   TF_LITE_ENSURE_OK(&context_, CheckTensorIndices("node inputs", inputs.data(),
                                                   inputs.size()));
@@ -1195,6 +1368,15 @@ TfLiteStatus Subgraph::ResizeInputTensor(int tensor_index,
     // Undo delegation if it resulted in the graph being immutable.
     TF_LITE_ENSURE_STATUS(UndoAllDelegates());
   }
+  // Keep track of the resized inputs for as long as they are the only change
+  // since the graph was last invokable.
+  if (ShouldPrepareOnlyResizedNodes() && delegates_applied_.empty() &&
+      !has_dynamic_tensors_ &&
+      (state_ != kStateUninvokable || !resized_input_tensors_.empty())) {
+    resized_input_tensors_.push_back(tensor_index);
+  } else {
+    resized_input_tensors_.clear();
+  }
   state_ = kStateUninvokable;
   return ResizeTensorImpl(tensor, ConvertVectorToTfLiteIntArray(dims));
 }
@@ -1231,6 +1413,7 @@ TfLiteStatus Subgraph::ResizeInputTensorStrict(int tensor_index,
 
 TfLiteStatus Subgraph::ReleaseNonPersistentMemory() {
   state_ = kStateUninvokable;
+  resized_input_tensors_.clear();
   if (memory_planner_) {
     TF_LITE_ENSURE_STATUS(memory_planner_->ReleaseNonPersistentMemory());
   }
@@ -1239,6 +1422,7 @@ TfLiteStatus Subgraph::ReleaseNonPersistentMemory() {
 
 TfLiteStatus Subgraph::ReleaseMemory() {
   state_ = kStateUninvokable;
+  resized_input_tensors_.clear();
   ReleaseNonPersistentMemory();
 
   // Free dynamic input tensors.
@@ -1462,6 +1646,25 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
         nodes_and_registration_[node_index].second;
+    // Shapes of the node's outputs before it is prepared, to find out which of
+    // them change. Only needed when preparing just the changed nodes.
+    std::vector<std::vector<int>> output_shapes;
+    if (!changed_tensors_.empty()) {
+      if (!ReadsChangedTensor(node)) {
+        // The node was prepared with the same inputs before.
+        *last_execution_plan_index_prepared = execution_plan_index;
+        continue;
+      }
+      for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+        const TfLiteTensor* output = tensor(tensor_index);
+        if (output != nullptr && output->dims != nullptr) {
+          output_shapes.emplace_back(output->dims->data,
+                                     output->dims->data + output->dims->size);
+        } else {
+          output_shapes.emplace_back();
+        }
+      }
+    }
     EnsureTensorsVectorCapacity();
 #ifdef TF_LITE_TENSORFLOW_PROFILER
     tflite::OnTfLiteOpPrepare(GetTFLiteOpName(registration), subgraph_index_,
@@ -1473,6 +1676,9 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
                     "failed to prepare");
       return op_prepare_status;
     }
+    if (!changed_tensors_.empty()) {
+      MarkChangedOutputs(node, output_shapes);
+    }
 
     *last_execution_plan_index_prepared = execution_plan_index;
 
@@ -1487,7 +1693,46 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
   return kTfLiteOk;
 }
 
+bool Subgraph::ReadsChangedTensor(const TfLiteNode& node) const {
+  for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    // Tensors added since the changes were recorded are taken as changed.
+    if (static_cast<size_t>(tensor_index) >= changed_tensors_.size() ||
+        changed_tensors_[tensor_index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Subgraph::MarkChangedOutputs(
+    const TfLiteNode& node,
+    const std::vector<std::vector<int>>& output_shapes) {
+  for (int i = 0; i < node.outputs->size; ++i) {
+    const int tensor_index = node.outputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor ||
+        static_cast<size_t>(tensor_index) >= changed_tensors_.size()) {
+      continue;
+    }
+    const TfLiteTensor& output = tensors_[tensor_index];
+    // Persistent read-only outputs are computed in Prepare, e.g. by SHAPE, so
+    // their values may change even if their shapes don't.
+    if (output.allocation_type == kTfLitePersistentRo ||
+        i >= output_shapes.size() ||
+        !EqualArrayAndTfLiteIntArray(output.dims, output_shapes[i].size(),
+                                     output_shapes[i].data())) {
+      changed_tensors_[tensor_index] = true;
+    }
+  }
+}
+
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
+  // No node has been prepared before the memory planner is created.
+  if (!memory_planner_) {
+    FuseBuiltinEpilogues();
+    StoreActivationsInFloat16();
+  }
+
   // Prepare original execution plan if any applied delegate wants it.
   // If any of the delegates is immutable, this won't be triggered
   // post-delegation (since we undo/redo delegation). For all other cases, other
@@ -1518,12 +1763,17 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
 
   if (!memory_planner_) {
+    PlanInterOpGroups();
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
+    // Every tensor has a buffer of its own, so nodes may run concurrently.
     memory_planner_.reset(new SimplePlanner(&context_, CreateGraphInfo()));
 #else
-    memory_planner_ = std::make_unique<ArenaPlanner>(
+    auto arena_planner = std::make_unique<ArenaPlanner>(
         &context_, CreateGraphInfo(), ShouldPreserveAllTensors(),
-        kDefaultTensorAlignment, subgraph_index_);
+        kDefaultTensorAlignment, subgraph_index_,
+        GetArenaPlanningTimeBudgetMicros());
+    arena_planner->SetConcurrentNodeGroups(inter_op_group_starts_);
+    memory_planner_ = std::move(arena_planner);
 #endif
     memory_planner_->PlanAllocations();
   }
@@ -1582,6 +1832,356 @@ TfLiteStatus Subgraph::Invoke() {
   telemetry::TelemetryReportEvent(&context_, "Invoke", status);
   return status;
 }
+
+TfLiteStatus Subgraph::EnsureNodeInputsAreReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+void Subgraph::FuseBuiltinEpilogues() {
+  if (!ShouldFuseBuiltinEpilogues() || ShouldPreserveAllTensors()) return;
+  // The number of nodes and subgraph outputs that read each tensor, and the
+  // last node that reads it.
+  std::vector<int> num_readers(tensors_.size(), 0);
+  std::vector<int> reader(tensors_.size(), -1);
+  for (int node_index : execution_plan_) {
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      ++num_readers[tensor_index];
+      reader[tensor_index] = node_index;
+    }
+  }
+  for (int tensor_index : outputs_) {
+    if (tensor_index == kTfLiteOptionalTensor) continue;
+    ++num_readers[tensor_index];
+  }
+
+  // NOLINTNEXTLINE - absl::flat_hash_set increases binary size by 106kB.
+  std::unordered_set<int> fused_nodes;
+  for (int node_index : execution_plan_) {
+    auto& [node, registration] = nodes_and_registration_[node_index];
+    TfLiteFusedActivation* activation =
+        GetFusableActivation(registration, &node);
+    if (activation == nullptr || node.delegate != nullptr ||
+        node.outputs->size != 1) {
+      continue;
+    }
+    // A node whose output is clamped can't take a bias anymore, so epilogues
+    // are fused until the node has an activation.
+    while (*activation == kTfLiteActNone) {
+      const int output = node.outputs->data[0];
+      if (output == kTfLiteOptionalTensor || num_readers[output] != 1 ||
+          reader[output] < 0) {
+        break;
+      }
+      const TfLiteTensor& output_tensor = tensors_[output];
+      if (output_tensor.type != kTfLiteFloat32 ||
+          output_tensor.allocation_type != kTfLiteArenaRw ||
+          output_tensor.is_variable) {
+        break;
+      }
+      const auto& [epilogue, epilogue_registration] =
+          nodes_and_registration_[reader[output]];
+      if (epilogue.delegate != nullptr || epilogue.outputs->size != 1 ||
+          epilogue.outputs->data[0] == kTfLiteOptionalTensor ||
+          tensors_[epilogue.outputs->data[0]].type != kTfLiteFloat32 ||
+          !FuseEpilogue(tensors_.data(), registration, &node,
+                        epilogue_registration, epilogue)) {
+        break;
+      }
+      fused_nodes.insert(reader[output]);
+    }
+  }
+  if (fused_nodes.empty()) return;
+
+  auto remove_fused_nodes = [&fused_nodes](std::vector<int>* plan) {
+    plan->erase(std::remove_if(plan->begin(), plan->end(),
+                               [&fused_nodes](int node_index) {
+                                 return fused_nodes.count(node_index) > 0;
+                               }),
+                plan->end());
+  };
+  remove_fused_nodes(&execution_plan_);
+  remove_fused_nodes(&pre_delegation_execution_plan_);
+  TFLITE_LOG(tflite::TFLITE_LOG_INFO,
+             "Fused %d nodes into conv and fully connected nodes.",
+             static_cast<int>(fused_nodes.size()));
+}
+
+void Subgraph::StoreActivationsInFloat16() {
+  if (!ShouldStoreActivationsInFloat16() || ShouldPreserveAllTensors()) return;
+  // A tensor may be stored in float16 if it's a float32 activation written by
+  // a node of the execution plan, and all the nodes that write or read it
+  // support float16.
+  std::vector<bool> is_float16(tensors_.size(), false);
+  for (int node_index : execution_plan_) {
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      is_float16[tensor_index] = tensor.type == kTfLiteFloat32 &&
+                                 tensor.allocation_type == kTfLiteArenaRw &&
+                                 !tensor.is_variable;
+    }
+  }
+  for (const std::vector<int>* tensors : {&inputs_, &outputs_, &variables_}) {
+    for (int tensor_index : *tensors) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      is_float16[tensor_index] = false;
+    }
+  }
+  // The nodes replaced by delegates run again if the delegates are undone.
+  std::vector<int> pass_through_nodes;
+  for (const std::vector<int>* plan :
+       {&execution_plan_, &pre_delegation_execution_plan_}) {
+    for (int node_index : *plan) {
+      const auto& [node, registration] = nodes_and_registration_[node_index];
+      const Float16Support support = GetFloat16Support(registration, node);
+      if (support == Float16Support::kConverts) continue;
+      if (support == Float16Support::kPassesThrough) {
+        pass_through_nodes.push_back(node_index);
+        continue;
+      }
+      for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+        for (int tensor_index : TfLiteIntArrayView(tensors)) {
+          if (tensor_index == kTfLiteOptionalTensor) continue;
+          is_float16[tensor_index] = false;
+        }
+      }
+    }
+  }
+  // The input and output of the nodes that pass values through must keep the
+  // same type, which may in turn change the type of the tensors they share
+  // with other such nodes.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int node_index : pass_through_nodes) {
+      const TfLiteNode& node = nodes_and_registration_[node_index].first;
+      const int input = node.inputs->data[0];
+      const int output = node.outputs->data[0];
+      if (input == kTfLiteOptionalTensor || output == kTfLiteOptionalTensor) {
+        continue;
+      }
+      if (is_float16[input] != is_float16[output]) {
+        is_float16[input] = false;
+        is_float16[output] = false;
+        changed = true;
+      }
+    }
+  }
+
+  int num_float16_tensors = 0;
+  for (int i = 0; i < is_float16.size(); ++i) {
+    if (!is_float16[i]) continue;
+    TfLiteTensor& tensor = tensors_[i];
+    tensor.type = kTfLiteFloat16;
+    if (tensor.dims != nullptr) {
+      size_t bytes;
+      if (tflite::BytesRequired(tensor.type, tensor.dims->data,
+                                tensor.dims->size, &bytes,
+                                &context_) == kTfLiteOk) {
+        tensor.bytes = bytes;
+      }
+    }
+    ++num_float16_tensors;
+  }
+  if (num_float16_tensors > 0) {
+    TFLITE_LOG(tflite::TFLITE_LOG_INFO, "Stored %d activations in float16.",
+               num_float16_tensors);
+  }
+}
+
+void Subgraph::PlanWeightStreaming() {
+  weight_streamer_.reset();
+  const size_t budget_bytes = GetWeightStreamingBudgetBytes();
+  if (budget_bytes == 0 || allocation_ == nullptr ||
+      allocation_->type() != Allocation::Type::kMMap) {
+    return;
+  }
+  // Only the weights in the file mapping can be read again once paged out.
+  const char* mapping_begin = static_cast<const char*>(allocation_->base());
+  const char* mapping_end = mapping_begin + allocation_->bytes();
+  std::vector<WeightStreamer::Region> regions;
+  std::vector<std::vector<int>> node_regions(execution_plan_.size());
+  std::vector<int> region_of_tensor(tensors_.size(), -1);
+  for (int i = 0; i < execution_plan_.size(); ++i) {
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    // Delegates read the weights at Prepare, if at all.
+    if (node.delegate != nullptr) continue;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      if (tensor.allocation_type != kTfLiteMmapRo ||
+          tensor.data.raw_const < mapping_begin ||
+          tensor.data.raw_const + tensor.bytes > mapping_end) {
+        continue;
+      }
+      if (region_of_tensor[tensor_index] < 0) {
+        region_of_tensor[tensor_index] = regions.size();
+        regions.push_back({tensor.data.raw_const, tensor.bytes});
+      }
+      node_regions[i].push_back(region_of_tensor[tensor_index]);
+    }
+  }
+  auto weight_streamer = std::make_unique<WeightStreamer>(
+      budget_bytes, kWeightPrefetchDistance, std::move(regions),
+      std::move(node_regions));
+  if (weight_streamer->total_bytes() <= budget_bytes) return;
+  // Ops may have read the weights at Prepare.
+  weight_streamer->ReleaseAll();
+  weight_streamer_ = std::move(weight_streamer);
+}
+
+void Subgraph::PlanInterOpGroups() {
+  inter_op_group_starts_.clear();
+  if (GetNumInterOpThreads() <= 1 || !delegates_applied_.empty()) return;
+  // The group whose nodes write each tensor, so far.
+  std::vector<int> producer_group(tensors_.size(), -1);
+  int group = -1;
+  // True if the current group can't take any more nodes.
+  bool group_is_closed = true;
+  for (int i = 0; i < execution_plan_.size(); ++i) {
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    // Nodes that may have side effects, such as control flow, or that update
+    // variables run on their own.
+    bool runs_alone = node.might_have_side_effect || node.delegate != nullptr;
+    bool reads_group_output = false;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      runs_alone |= tensors_[tensor_index].is_variable;
+      reads_group_output |= producer_group[tensor_index] == group;
+    }
+    if (group_is_closed || runs_alone || reads_group_output) {
+      ++group;
+      inter_op_group_starts_.push_back(i);
+    }
+    group_is_closed = runs_alone;
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      producer_group[tensor_index] = group;
+    }
+  }
+  if (inter_op_group_starts_.size() == execution_plan_.size()) {
+    // Every node has a group of its own.
+    inter_op_group_starts_.clear();
+  }
+}
+
+bool Subgraph::CanInvokeConcurrently() const {
+  return !inter_op_group_starts_.empty() && !profiler_ &&
+         delegates_applied_.empty() && !has_dynamic_tensors_ &&
+         next_execution_plan_index_to_prepare_ == execution_plan_.size();
+}
+
+TfLiteStatus Subgraph::InvokeConcurrently() {
+  const int num_threads = GetNumInterOpThreads();
+  if (!inter_op_thread_pool_ ||
+      inter_op_thread_pool_->num_threads() != num_threads) {
+    inter_op_thread_pool_ = std::make_unique<InterOpThreadPool>(num_threads);
+    inter_op_cpu_backend_contexts_.clear();
+    for (int i = 0; i < inter_op_thread_pool_->num_threads(); ++i) {
+      inter_op_cpu_backend_contexts_.push_back(
+          std::make_unique<ExternalCpuBackendContext>());
+    }
+  }
+  // Kernels of concurrent nodes share the interpreter's threads evenly.
+  const int num_intra_op_threads =
+      std::max(1, context_.recommended_num_threads / num_threads);
+  std::vector<TfLiteStatus> statuses;
+  for (int group = 0; group < inter_op_group_starts_.size(); ++group) {
+    const int first = inter_op_group_starts_[group];
+    const int last = group + 1 < inter_op_group_starts_.size()
+                         ? inter_op_group_starts_[group + 1]
+                         : execution_plan_.size();
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+    if (continue_invocation_ && !continue_invocation_->test_and_set()) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteCancelled;
+    }
+    EnsureTensorsVectorCapacity();
+    if (weight_streamer_) {
+      weight_streamer_->BeginNodes(first, last);
+    }
+    if (last - first == 1) {
+      // A node on its own keeps all the threads of the interpreter.
+      TF_LITE_ENSURE_STATUS(InvokeNodeOfGroup(first));
+      continue;
+    }
+    statuses.assign(last - first, kTfLiteOk);
+    inter_op_thread_pool_->ParallelFor(
+        last - first, [&](int task, int thread) {
+          ExternalCpuBackendContext* cpu_backend_context =
+              inter_op_cpu_backend_contexts_[thread].get();
+          TfLiteExternalContext* previous_cpu_backend_context =
+              inter_op_cpu_backend_context;
+          inter_op_cpu_backend_context = cpu_backend_context;
+          statuses[task] = InvokeNodeOfGroup(first + task);
+          inter_op_cpu_backend_context = previous_cpu_backend_context;
+          // Kernels create the backend context on first use, with as many
+          // threads as the interpreter has.
+          if (TfLiteInternalBackendContext* backend_context =
+                  cpu_backend_context->internal_backend_context()) {
+            backend_context->SetMaxNumThreads(num_intra_op_threads);
+          }
+        });
+    for (TfLiteStatus status : statuses) {
+      TF_LITE_ENSURE_STATUS(status);
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::InvokeNodeOfGroup(int execution_plan_index) {
+  const int node_index = execution_plan_[execution_plan_index];
+  TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+  TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node, registration));
+  if (auto s = OpInvoke(registration, &node); s != kTfLiteOk) {
+    auto err = ReportOpError(&context_, node, registration, node_index,
+                             "failed to invoke");
+    return s == kTfLiteCancelled ? s : err;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::InvokeImpl() {
   if (!consistent_) {
     ReportError("Invoke called on model that is not consistent.");
@@ -1602,6 +2202,14 @@ TfLiteStatus Subgraph::InvokeImpl() {
       tflite::OnTfLiteSubgraphInvoke(name_.c_str(), subgraph_index_);
 #endif  // TF_LITE_TENSORFLOW_PROFILER
 
+  if (CanInvokeConcurrently()) {
+    status = InvokeConcurrently();
+#ifdef TF_LITE_TENSORFLOW_PROFILER
+    tflite::OnTfLiteSubgraphInvokeEnd(trace_subgraph);
+#endif  // TF_LITE_TENSORFLOW_PROFILER
+    return status;
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1636,37 +2244,7 @@ TfLiteStatus Subgraph::InvokeImpl() {
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(
         profile_op ? profiler_.get() : nullptr, op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node, registration));
     // Allocate dynamic tensors which memory is required to be allocated
     // before executing the node.
     MayAllocateOpOutput(&node);
@@ -1684,6 +2262,9 @@ TfLiteStatus Subgraph::InvokeImpl() {
     }
 
     EnsureTensorsVectorCapacity();
+    if (weight_streamer_) {
+      weight_streamer_->BeginNode(execution_plan_index);
+    }
     tensor_resized_since_op_invoke_ = false;
     if (auto s = OpInvoke(registration, &node); s != kTfLiteOk) {
       auto err = ReportOpError(&context_, node, registration, node_index,
@@ -1885,6 +2466,7 @@ TfLiteStatus Subgraph::SetTensorParametersReadOnly(
     tensor.allocation = allocation;
   } else {
     state_ = kStateUninvokable;
+    resized_input_tensors_.clear();
     TfLiteTensorReset(type, name, ConvertArrayToTfLiteIntArray(ndims, dims),
                       GetLegacyQuantization(quantization),
                       const_cast<char*>(buffer), bytes, kTfLiteMmapRo,
@@ -2155,6 +2737,7 @@ TfLiteStatus Subgraph::UndoAllDelegates() {
 
   // After undoing delegates, the graph is uninvokable, but mutable.
   state_ = kStateUninvokable;
+  resized_input_tensors_.clear();
 
   delegates_undone_ = true;
   return kTfLiteOk;
@@ -2207,6 +2790,7 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    resized_input_tensors_.clear();
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
@@ -2259,6 +2843,7 @@ TfLiteStatus Subgraph::ModifyGraphWithDelegateImpl(TfLiteDelegate* delegate) {
     // tensors.
     // Reset the state to force tensor/op reallocation.
     state_ = kStateUninvokable;
+    resized_input_tensors_.clear();
   } else if (!delegate_supports_dynamic_shapes) {
     // Check if graph has dynamic tensors by preparing ops.
     int last_execution_plan_index_prepared;
@@ -2299,6 +2884,7 @@ TfLiteStatus Subgraph::ModifyGraphWithDelegateImpl(TfLiteDelegate* delegate) {
     // CASE 1: Current delegate does not support dynamic shapes.
     // Reset the state to force tensor/op reallocation.
     state_ = kStateUninvokable;
+    resized_input_tensors_.clear();
     TF_LITE_ENSURE_STATUS(
         reset_delegation_if_not_ok(EnsureMemoryAllocations()));
     // After using a delegate which doesn't support dynamic tensors, make the
@@ -33,9 +33,12 @@ limitations under the License.
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/inter_op_thread_pool.h"
 #include "tensorflow/lite/core/macros.h"
+#include "tensorflow/lite/core/weight_streamer.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/memory_planner.h"
@@ -448,6 +451,46 @@ class Subgraph {
     return (options_ && options_->GetPreserveAllTensors());
   }
 
+  // WARNING: This is an experimental API and subject to change.
+  // The time the arena planner may spend searching for a smaller plan.
+  int GetArenaPlanningTimeBudgetMicros() const {
+    return options_ ? options_->GetArenaPlanningTimeBudgetMicros() : 0;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // The number of threads that may run independent nodes concurrently.
+  int GetNumInterOpThreads() const {
+    return options_ ? options_->GetNumInterOpThreads() : 1;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // True if elementwise nodes should be fused into the conv or fully
+  // connected nodes producing their input.
+  bool ShouldFuseBuiltinEpilogues() const {
+    return (options_ && options_->GetFuseBuiltinEpilogues());
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // The bytes of streamed weights that may be resident, zero if weights
+  // aren't streamed.
+  size_t GetWeightStreamingBudgetBytes() const {
+    return options_ ? options_->GetWeightStreamingBudgetBytes() : 0;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // True if activations read and written only by kernels that support float16
+  // should be stored in float16.
+  bool ShouldStoreActivationsInFloat16() const {
+    return (options_ && options_->GetStoreActivationsInFloat16());
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // True if only the nodes affected by ResizeInputTensor should be prepared
+  // again.
+  bool ShouldPrepareOnlyResizedNodes() const {
+    return (options_ && options_->GetPrepareOnlyResizedNodes());
+  }
+
   // WARNING: This is an experimental API and subject to change.
   // True if all intermediate dynamic tensors should be released once they are
   // not used by the model.
@@ -688,6 +731,14 @@ class Subgraph {
                                     const std::vector<int>& execution_plan,
                                     int* last_execution_plan_index_prepared);
 
+  // True if any input of 'node' is marked in `changed_tensors_`.
+  bool ReadsChangedTensor(const TfLiteNode& node) const;
+
+  // Marks in `changed_tensors_` the outputs of 'node' that changed from
+  // 'output_shapes' when it was prepared.
+  void MarkChangedOutputs(const TfLiteNode& node,
+                          const std::vector<std::vector<int>>& output_shapes);
+
   // Tensors needed by the interpreter. Use `AddTensors` to add more blank
   // tensor entries. Note, `tensors_.data()` needs to be synchronized to the
   // `context_` whenever this std::vector is reallocated. Currently this
@@ -713,6 +764,39 @@ class Subgraph {
   // Does not report invoke status through profiler.
   TfLiteStatus InvokeImpl();
 
+  // Makes sure the inputs of 'node' have data that the CPU can read.
+  TfLiteStatus EnsureNodeInputsAreReadable(
+      const TfLiteNode& node, const TfLiteRegistration& registration);
+
+  // Fuses the activations and bias additions that follow conv and fully
+  // connected builtin nodes into them, and removes the fused nodes from the
+  // execution plans. Must be called before the nodes are first prepared.
+  void FuseBuiltinEpilogues();
+
+  // Changes the type of the float32 arena tensors that are written and read
+  // only by builtin nodes that support float16 activations to float16. Must be
+  // called before the nodes are first prepared.
+  void StoreActivationsInFloat16();
+
+  // Creates `weight_streamer_` for the memory-mapped constant tensors read
+  // by the non-delegated nodes of the execution plan, if they take more than
+  // the streaming budget.
+  void PlanWeightStreaming();
+
+  // Splits the execution plan into `inter_op_group_starts_`, groups of
+  // consecutive nodes none of which reads the outputs of another.
+  void PlanInterOpGroups();
+
+  // True if InvokeImpl may run the nodes of each inter-op group concurrently.
+  bool CanInvokeConcurrently() const;
+
+  // Invokes the execution plan one inter-op group at a time, running the
+  // nodes of a group concurrently on `inter_op_thread_pool_`.
+  TfLiteStatus InvokeConcurrently();
+
+  // Invokes the node at 'execution_plan_index', on any thread.
+  TfLiteStatus InvokeNodeOfGroup(int execution_plan_index);
+
   // Allow a delegate to look at the graph and modify the graph to handle
   // parts of the graph themselves. After this is called, the graph may
   // contain new nodes that replace 1 more nodes.
@@ -1054,6 +1138,22 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // The execution plan index of the first node of each group of nodes that
+  // may run concurrently. Empty if the nodes are to run one at a time.
+  std::vector<int> inter_op_group_starts_;
+
+  // Runs the nodes of an inter-op group, created on first use.
+  std::unique_ptr<InterOpThreadPool> inter_op_thread_pool_;
+
+  // CPU backend context used by the kernels run by each thread of
+  // `inter_op_thread_pool_`, as the one of the interpreter isn't thread-safe.
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
+  // Pages the weights in and out around the nodes that read them, if they
+  // are streamed.
+  std::unique_ptr<WeightStreamer> weight_streamer_;
+
   // Maps tensor index to custom allocation for all applicable tensors.
   std::map<int, TfLiteCustomAllocation> custom_allocations_;
 
@@ -1077,6 +1177,15 @@ class Subgraph {
   // The value is invalid before `PrepareOpStartingAt` is called.
   bool has_dynamic_tensors_ = true;
 
+  // Input tensors resized since the graph was last invokable, when nothing
+  // else changed in between. Set only if `ShouldPrepareOnlyResizedNodes()`.
+  std::vector<int> resized_input_tensors_;
+
+  // While `AllocateTensors` prepares only the nodes affected by
+  // `resized_input_tensors_`, marks the tensors whose shape may have changed.
+  // Empty when all nodes are to be prepared.
+  std::vector<bool> changed_tensors_;
+
   // WARNING: This is an experimental interface that is subject to change.
   // This is the index of dynamic tensor which was checked at
   // PrepareOpsStartingAt() when `has_dynamic_tensors_` is set. This information
@@ -0,0 +1,118 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/weight_streamer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__APPLE__) || defined(__linux__) || defined(__Fuchsia__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define TFLITE_WEIGHT_STREAMER_HAS_MADVISE
+#endif
+
+namespace tflite {
+namespace {
+
+// Hints that [data, data + bytes) will be read soon, or not for a while. Pages
+// are paged out only if they hold nothing but the range, as the neighbouring
+// weights may still be in use.
+void Advise(const char* data, size_t bytes, bool will_need) {
+#ifdef TFLITE_WEIGHT_STREAMER_HAS_MADVISE
+  static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  uintptr_t end = begin + bytes;
+  if (will_need) {
+    begin = begin / page_size * page_size;
+    end = (end + page_size - 1) / page_size * page_size;
+  } else {
+    begin = (begin + page_size - 1) / page_size * page_size;
+    end = end / page_size * page_size;
+  }
+  if (begin < end) {
+    // The kernel may ignore the hint, which is harmless.
+    madvise(reinterpret_cast<void*>(begin), end - begin,
+            will_need ? MADV_WILLNEED : MADV_DONTNEED);
+  }
+#endif
+}
+
+}  // namespace
+
+WeightStreamer::WeightStreamer(size_t budget_bytes, int prefetch_distance,
+                               std::vector<Region> regions,
+                               std::vector<std::vector<int>> node_regions)
+    : budget_bytes_(budget_bytes),
+      prefetch_distance_(std::max(0, prefetch_distance)),
+      regions_(std::move(regions)),
+      node_regions_(std::move(node_regions)),
+      last_use_(regions_.size(), 0) {
+  for (const Region& region : regions_) {
+    total_bytes_ += region.bytes;
+  }
+}
+
+void WeightStreamer::BeginNodes(int first, int last) {
+  const int num_nodes = node_regions_.size();
+  if (num_nodes == 0 || first < 0 || first >= last) return;
+  ++time_;
+  const int end = std::min(last + prefetch_distance_, first + num_nodes);
+  for (int i = first; i < end; ++i) {
+    for (int region : node_regions_[i % num_nodes]) {
+      if (last_use_[region] == time_) continue;
+      if (last_use_[region] == 0) {
+        PageIn(region);
+      } else {
+        resident_.erase({last_use_[region], region});
+      }
+      last_use_[region] = time_;
+      resident_.insert({time_, region});
+    }
+  }
+  // The weights of the nodes about to run stay, even over the budget.
+  while (resident_bytes_ > budget_bytes_ && !resident_.empty() &&
+         resident_.begin()->first < time_) {
+    PageOut(resident_.begin()->second);
+  }
+}
+
+void WeightStreamer::ReleaseAll() {
+  for (size_t region = 0; region < regions_.size(); ++region) {
+    Advise(regions_[region].data, regions_[region].bytes,
+           /*will_need=*/false);
+    last_use_[region] = 0;
+  }
+  resident_.clear();
+  resident_bytes_ = 0;
+}
+
+void WeightStreamer::PageIn(int region) {
+  Advise(regions_[region].data, regions_[region].bytes, /*will_need=*/true);
+  resident_bytes_ += regions_[region].bytes;
+  ++num_page_ins_;
+}
+
+void WeightStreamer::PageOut(int region) {
+  Advise(regions_[region].data, regions_[region].bytes, /*will_need=*/false);
+  resident_.erase({last_use_[region], region});
+  last_use_[region] = 0;
+  resident_bytes_ -= regions_[region].bytes;
+  ++num_page_outs_;
+}
+
+}  // namespace tflite
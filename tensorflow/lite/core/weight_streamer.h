@@ -0,0 +1,93 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_WEIGHT_STREAMER_H_
+#define TENSORFLOW_LITE_CORE_WEIGHT_STREAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+
+// Keeps the memory-mapped constant tensors read by the nodes of an execution
+// plan within a budget of resident bytes. Before nodes run, the weights of the
+// next few nodes are prefetched, and the weights used the longest time ago
+// are paged out while the budget is exceeded. The weights must be read-only
+// pages of a file mapping, which are read again from the file when they're
+// used after being paged out.
+//
+// On platforms without madvise, only the accounting is done.
+class WeightStreamer {
+ public:
+  struct Region {
+    const char* data;
+    size_t bytes;
+  };
+
+  // `node_regions[i]` are the indices in `regions` of the weights read by the
+  // node at execution plan index `i`. The weights of the nodes up to
+  // `prefetch_distance` nodes ahead are prefetched, wrapping around to the
+  // start of the plan for the next invocation.
+  WeightStreamer(size_t budget_bytes, int prefetch_distance,
+                 std::vector<Region> regions,
+                 std::vector<std::vector<int>> node_regions);
+
+  WeightStreamer(const WeightStreamer&) = delete;
+  WeightStreamer& operator=(const WeightStreamer&) = delete;
+
+  // Makes sure the weights of the nodes at execution plan indices in
+  // [first, last) are paged in, before they run. Not thread-safe.
+  void BeginNodes(int first, int last);
+  void BeginNode(int execution_plan_index) {
+    BeginNodes(execution_plan_index, execution_plan_index + 1);
+  }
+
+  // Pages out all the weights.
+  void ReleaseAll();
+
+  // The bytes of all the weights, and of the weights that are paged in.
+  size_t total_bytes() const { return total_bytes_; }
+  size_t resident_bytes() const { return resident_bytes_; }
+  // The number of times weights were prefetched and paged out.
+  int64_t num_page_ins() const { return num_page_ins_; }
+  int64_t num_page_outs() const { return num_page_outs_; }
+
+ private:
+  void PageIn(int region);
+  void PageOut(int region);
+
+  const size_t budget_bytes_;
+  const int prefetch_distance_;
+  const std::vector<Region> regions_;
+  const std::vector<std::vector<int>> node_regions_;
+  size_t total_bytes_ = 0;
+  size_t resident_bytes_ = 0;
+  int64_t num_page_ins_ = 0;
+  int64_t num_page_outs_ = 0;
+
+  // Incremented by each BeginNodes. The weights of the nodes about to run
+  // were used at the current time, and aren't paged out.
+  uint64_t time_ = 0;
+  // The time each weight was last used, 0 if it isn't resident.
+  std::vector<uint64_t> last_use_;
+  // The resident weights, by the time they were last used.
+  std::set<std::pair<uint64_t, int>> resident_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_WEIGHT_STREAMER_H_
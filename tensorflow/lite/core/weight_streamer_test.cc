@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/weight_streamer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+// A few pages, so that paging out has an effect.
+constexpr size_t kWeightBytes = 3 * 4096;
+
+// Four weights in a mapped file, the node at execution plan index i reads
+// weight i.
+class WeightStreamerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    const std::string path = testing::TempDir() + "/weights";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    const std::vector<char> data(4 * kWeightBytes, 7);
+    ASSERT_EQ(std::fwrite(data.data(), 1, data.size(), file), data.size());
+    ASSERT_EQ(std::fclose(file), 0);
+    const int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    data_ = static_cast<char*>(mmap(nullptr, 4 * kWeightBytes, PROT_READ,
+                                    MAP_PRIVATE, fd, 0));
+    close(fd);
+    std::remove(path.c_str());
+    ASSERT_NE(data_, MAP_FAILED);
+  }
+
+  void TearDown() override { munmap(data_, 4 * kWeightBytes); }
+
+  WeightStreamer Create(size_t budget_bytes, int prefetch_distance) {
+    std::vector<WeightStreamer::Region> regions;
+    std::vector<std::vector<int>> node_regions;
+    for (int i = 0; i < 4; ++i) {
+      regions.push_back({data_ + i * kWeightBytes, kWeightBytes});
+      node_regions.push_back({i});
+    }
+    return WeightStreamer(budget_bytes, prefetch_distance, std::move(regions),
+                          std::move(node_regions));
+  }
+
+  char* data_ = nullptr;
+};
+
+TEST_F(WeightStreamerTest, StaysWithinBudget) {
+  WeightStreamer streamer = Create(2 * kWeightBytes, /*prefetch_distance=*/1);
+  EXPECT_EQ(streamer.total_bytes(), 4 * kWeightBytes);
+  EXPECT_EQ(streamer.resident_bytes(), 0);
+
+  // Node 0 and the prefetched node 1.
+  streamer.BeginNode(0);
+  EXPECT_EQ(streamer.resident_bytes(), 2 * kWeightBytes);
+  EXPECT_EQ(streamer.num_page_ins(), 2);
+  EXPECT_EQ(streamer.num_page_outs(), 0);
+  for (int i = 1; i < 4; ++i) {
+    streamer.BeginNode(i);
+    EXPECT_EQ(streamer.resident_bytes(), 2 * kWeightBytes);
+  }
+  // Node 3 prefetched node 0, for the next invocation.
+  EXPECT_EQ(streamer.num_page_ins(), 5);
+  EXPECT_EQ(streamer.num_page_outs(), 3);
+  streamer.BeginNode(0);
+  EXPECT_EQ(streamer.num_page_ins(), 6);
+
+  // The data is still there once paged out.
+  for (size_t i = 0; i < 4 * kWeightBytes; ++i) {
+    ASSERT_EQ(data_[i], 7);
+  }
+  streamer.ReleaseAll();
+  EXPECT_EQ(streamer.resident_bytes(), 0);
+}
+
+TEST_F(WeightStreamerTest, KeepsWeightsOfRunningNodesOverBudget) {
+  WeightStreamer streamer = Create(kWeightBytes, /*prefetch_distance=*/0);
+  streamer.BeginNodes(0, 3);
+  EXPECT_EQ(streamer.resident_bytes(), 3 * kWeightBytes);
+  streamer.BeginNode(3);
+  EXPECT_EQ(streamer.resident_bytes(), kWeightBytes);
+  EXPECT_EQ(streamer.num_page_outs(), 3);
+}
+
+TEST_F(WeightStreamerTest, KeepsEverythingWithinBudget) {
+  WeightStreamer streamer = Create(4 * kWeightBytes, /*prefetch_distance=*/2);
+  for (int invocation = 0; invocation < 3; ++invocation) {
+    for (int i = 0; i < 4; ++i) {
+      streamer.BeginNode(i);
+    }
+  }
+  EXPECT_EQ(streamer.num_page_ins(), 4);
+  EXPECT_EQ(streamer.num_page_outs(), 0);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -23,6 +23,7 @@ limitations under the License.
 #else
 extern "C" {
 typedef struct AHardwareBuffer AHardwareBuffer;
+typedef struct ARect ARect;
 
 // struct is a copy of the Android NDK AHardwareBuffer_Desc struct in the link
 // below
@@ -53,6 +54,8 @@ namespace tflite::gpu {
 //   - function AHardwareBuffer_acquire
 //   - function AHardwareBuffer_release
 //   - function AHardwareBuffer_describe
+//   - function AHardwareBuffer_lock
+//   - function AHardwareBuffer_unlock
 //   - library libnativewindow.so (for the above features)
 //
 // For documentation on these features, see
@@ -105,6 +108,21 @@ class OptionalAndroidHardwareBuffer {
     return describe_(buffer, desc);
   }
 
+  // Like AHardwareBuffer_lock.
+  // Caller must check that Supported() returns true before calling this
+  // function.
+  int Lock(AHardwareBuffer* buffer, uint64_t usage, int32_t fence,
+           const ARect* rect, void** out_virtual_address) {
+    return lock_(buffer, usage, fence, rect, out_virtual_address);
+  }
+
+  // Like AHardwareBuffer_unlock.
+  // Caller must check that Supported() returns true before calling this
+  // function.
+  int Unlock(AHardwareBuffer* buffer, int32_t* fence) {
+    return unlock_(buffer, fence);
+  }
+
  private:
   void* dlopen_handle_;
   int (*is_supported_)(const AHardwareBuffer_Desc* desc);
@@ -112,6 +130,9 @@ class OptionalAndroidHardwareBuffer {
   void (*acquire_)(AHardwareBuffer* buffer);
   void (*release_)(AHardwareBuffer* buffer);
   void (*describe_)(AHardwareBuffer* buffer, AHardwareBuffer_Desc* desc);
+  int (*lock_)(AHardwareBuffer* buffer, uint64_t usage, int32_t fence,
+               const ARect* rect, void** out_virtual_address);
+  int (*unlock_)(AHardwareBuffer* buffer, int32_t* fence);
   bool supported_;
 
   OptionalAndroidHardwareBuffer();
@@ -189,7 +189,8 @@ absl::Status ClOperation::RestoreDeserialized(const ProgramCache& program_cache,
 }
 
 absl::Status ClOperation::Tune(TuningType tuning_type, const GpuInfo& gpu_info,
-                               ProfilingCommandQueue* profiling_queue) {
+                               ProfilingCommandQueue* profiling_queue,
+                               ProgramCache* program_cache) {
   std::vector<GPUOperation::DispatchInfo> possible_dispatches;
   operation_->GetPossibleDispatches(tuning_type, gpu_info, kernel_.info_,
                                     &possible_dispatches);
@@ -207,6 +208,14 @@ absl::Status ClOperation::Tune(TuningType tuning_type, const GpuInfo& gpu_info,
       work_group_sizes[i] = possible_dispatches[i].work_group_size;
       work_groups_counts[i] = possible_dispatches[i].work_groups_count;
     }
+    int3 tuned_work_group_size;
+    if (program_cache && program_cache->GetTunedWorkGroupSize(
+                             kernel_fingerprint_, work_groups_counts,
+                             work_group_sizes, &tuned_work_group_size)) {
+      operation_->work_group_size_ = tuned_work_group_size;
+      operation_->RecalculateWorkGroupsCount();
+      return absl::OkStatus();
+    }
     RETURN_IF_ERROR(cl_args_.Bind(kernel_.kernel()));
     int best_work_group_index;
     RETURN_IF_ERROR(profiling_queue->GetBestWorkGroupIndex(
@@ -214,6 +223,11 @@ absl::Status ClOperation::Tune(TuningType tuning_type, const GpuInfo& gpu_info,
         &best_work_group_index));
     operation_->work_group_size_ = work_group_sizes[best_work_group_index];
     operation_->RecalculateWorkGroupsCount();
+    if (program_cache) {
+      program_cache->AddTunedWorkGroupSize(kernel_fingerprint_,
+                                           work_groups_counts, work_group_sizes,
+                                           operation_->work_group_size_);
+    }
     return absl::OkStatus();
   }
 }
@@ -110,8 +110,11 @@ class ClOperation {
                                  operation_->work_group_size_, n, flush_period);
   }
 
+  // Reuses the work group size tuned in `program_cache` for the same kernel and
+  // dispatches if any, and otherwise adds the tuned one to it.
   absl::Status Tune(TuningType tuning_type, const GpuInfo& gpu_info,
-                    ProfilingCommandQueue* profiling_queue);
+                    ProfilingCommandQueue* profiling_queue,
+                    ProgramCache* program_cache = nullptr);
 
   absl::Status Compile(const CreationContext& creation_context);
 
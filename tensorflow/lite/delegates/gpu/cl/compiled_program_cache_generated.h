@@ -35,6 +35,9 @@ namespace data {
 struct Program;
 struct ProgramBuilder;
 
+struct TunedWorkGroupSize;
+struct TunedWorkGroupSizeBuilder;
+
 struct CompiledCache;
 struct CompiledCacheBuilder;
 
@@ -101,11 +104,83 @@ inline ::flatbuffers::Offset<Program> CreateProgramDirect(
       binary__);
 }
 
+struct TunedWorkGroupSize FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
+  typedef TunedWorkGroupSizeBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_FINGERPRINT = 4,
+    VT_X = 6,
+    VT_Y = 8,
+    VT_Z = 10
+  };
+  uint64_t fingerprint() const {
+    return GetField<uint64_t>(VT_FINGERPRINT, 0);
+  }
+  int32_t x() const {
+    return GetField<int32_t>(VT_X, 0);
+  }
+  int32_t y() const {
+    return GetField<int32_t>(VT_Y, 0);
+  }
+  int32_t z() const {
+    return GetField<int32_t>(VT_Z, 0);
+  }
+  bool Verify(::flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_FINGERPRINT, 8) &&
+           VerifyField<int32_t>(verifier, VT_X, 4) &&
+           VerifyField<int32_t>(verifier, VT_Y, 4) &&
+           VerifyField<int32_t>(verifier, VT_Z, 4) &&
+           verifier.EndTable();
+  }
+};
+
+struct TunedWorkGroupSizeBuilder {
+  typedef TunedWorkGroupSize Table;
+  ::flatbuffers::FlatBufferBuilder &fbb_;
+  ::flatbuffers::uoffset_t start_;
+  void add_fingerprint(uint64_t fingerprint) {
+    fbb_.AddElement<uint64_t>(TunedWorkGroupSize::VT_FINGERPRINT, fingerprint, 0);
+  }
+  void add_x(int32_t x) {
+    fbb_.AddElement<int32_t>(TunedWorkGroupSize::VT_X, x, 0);
+  }
+  void add_y(int32_t y) {
+    fbb_.AddElement<int32_t>(TunedWorkGroupSize::VT_Y, y, 0);
+  }
+  void add_z(int32_t z) {
+    fbb_.AddElement<int32_t>(TunedWorkGroupSize::VT_Z, z, 0);
+  }
+  explicit TunedWorkGroupSizeBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ::flatbuffers::Offset<TunedWorkGroupSize> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = ::flatbuffers::Offset<TunedWorkGroupSize>(end);
+    return o;
+  }
+};
+
+inline ::flatbuffers::Offset<TunedWorkGroupSize> CreateTunedWorkGroupSize(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t fingerprint = 0,
+    int32_t x = 0,
+    int32_t y = 0,
+    int32_t z = 0) {
+  TunedWorkGroupSizeBuilder builder_(_fbb);
+  builder_.add_fingerprint(fingerprint);
+  builder_.add_z(z);
+  builder_.add_y(y);
+  builder_.add_x(x);
+  return builder_.Finish();
+}
+
 struct CompiledCache FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef CompiledCacheBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_DRIVER_VERSION = 4,
-    VT_PROGRAMS = 6
+    VT_PROGRAMS = 6,
+    VT_TUNED_WORK_GROUP_SIZES = 8
   };
   const ::flatbuffers::String *driver_version() const {
     return GetPointer<const ::flatbuffers::String *>(VT_DRIVER_VERSION);
@@ -113,6 +188,9 @@ struct CompiledCache FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   const ::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>> *programs() const {
     return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>> *>(VT_PROGRAMS);
   }
+  const ::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>> *tuned_work_group_sizes() const {
+    return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>> *>(VT_TUNED_WORK_GROUP_SIZES);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_DRIVER_VERSION) &&
@@ -120,6 +198,9 @@ struct CompiledCache FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
            VerifyOffset(verifier, VT_PROGRAMS) &&
            verifier.VerifyVector(programs()) &&
            verifier.VerifyVectorOfTables(programs()) &&
+           VerifyOffset(verifier, VT_TUNED_WORK_GROUP_SIZES) &&
+           verifier.VerifyVector(tuned_work_group_sizes()) &&
+           verifier.VerifyVectorOfTables(tuned_work_group_sizes()) &&
            verifier.EndTable();
   }
 };
@@ -134,6 +215,9 @@ struct CompiledCacheBuilder {
   void add_programs(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>>> programs) {
     fbb_.AddOffset(CompiledCache::VT_PROGRAMS, programs);
   }
+  void add_tuned_work_group_sizes(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>>> tuned_work_group_sizes) {
+    fbb_.AddOffset(CompiledCache::VT_TUNED_WORK_GROUP_SIZES, tuned_work_group_sizes);
+  }
   explicit CompiledCacheBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -148,8 +232,10 @@ struct CompiledCacheBuilder {
 inline ::flatbuffers::Offset<CompiledCache> CreateCompiledCache(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     ::flatbuffers::Offset<::flatbuffers::String> driver_version = 0,
-    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>>> programs = 0) {
+    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>>> programs = 0,
+    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>>> tuned_work_group_sizes = 0) {
   CompiledCacheBuilder builder_(_fbb);
+  builder_.add_tuned_work_group_sizes(tuned_work_group_sizes);
   builder_.add_programs(programs);
   builder_.add_driver_version(driver_version);
   return builder_.Finish();
@@ -158,13 +244,16 @@ inline ::flatbuffers::Offset<CompiledCache> CreateCompiledCache(
 inline ::flatbuffers::Offset<CompiledCache> CreateCompiledCacheDirect(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     const char *driver_version = nullptr,
-    const std::vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>> *programs = nullptr) {
+    const std::vector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>> *programs = nullptr,
+    const std::vector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>> *tuned_work_group_sizes = nullptr) {
   auto driver_version__ = driver_version ? _fbb.CreateString(driver_version) : 0;
   auto programs__ = programs ? _fbb.CreateVector<::flatbuffers::Offset<tflite::gpu::cl::data::Program>>(*programs) : 0;
+  auto tuned_work_group_sizes__ = tuned_work_group_sizes ? _fbb.CreateVector<::flatbuffers::Offset<tflite::gpu::cl::data::TunedWorkGroupSize>>(*tuned_work_group_sizes) : 0;
   return tflite::gpu::cl::data::CreateCompiledCache(
       _fbb,
       driver_version__,
-      programs__);
+      programs__,
+      tuned_work_group_sizes__);
 }
 
 inline const tflite::gpu::cl::data::CompiledCache *GetCompiledCache(const void *buf) {
@@ -16,15 +16,99 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/recordable_queue.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/delegates/gpu/cl/cl_command_buffer.h"
+#include "tensorflow/lite/delegates/gpu/cl/cl_command_queue.h"
+#include "tensorflow/lite/delegates/gpu/cl/cl_context.h"
+#include "tensorflow/lite/delegates/gpu/cl/cl_device.h"
+#include "tensorflow/lite/delegates/gpu/cl/cl_event.h"
+#include "tensorflow/lite/delegates/gpu/cl/cl_operation.h"
+#include "tensorflow/lite/delegates/gpu/cl/opencl_wrapper.h"
+#include "tensorflow/lite/delegates/gpu/common/status.h"
 
 namespace tflite {
 namespace gpu {
 namespace cl {
+namespace {
+
+bool SupportsSimultaneousUse(const CLDevice& device) {
+  cl_device_command_buffer_capabilities_khr capabilities = 0;
+  const cl_int error = clGetDeviceInfo(
+      device.id(), CL_DEVICE_COMMAND_BUFFER_CAPABILITIES_KHR,
+      sizeof(capabilities), &capabilities, nullptr);
+  return error == CL_SUCCESS &&
+         (capabilities & CL_COMMAND_BUFFER_CAPABILITY_SIMULTANEOUS_USE_KHR);
+}
+
+// Records the kernels of all operations into a cl_khr_command_buffer on the
+// first execution, and replays it on the next ones, instead of setting the
+// arguments and enqueueing every kernel again. Only valid while the arguments
+// of the operations don't change, i.e. without mutable external tensors.
+class CommandBufferQueue : public RecordableQueue {
+ public:
+  CommandBufferQueue(const std::vector<ClOperation*>& ops,
+                     bool simultaneous_use)
+      : ops_(ops), simultaneous_use_(simultaneous_use) {}
+
+  bool IsSupported() const override { return !recording_failed_; }
+
+  absl::Status Execute(CLCommandQueue* queue) const override {
+    if (queue->queue() != recorded_queue_) {
+      const absl::Status status = Record(queue);
+      if (!status.ok()) {
+        // The caller falls back to enqueueing the operations one by one.
+        recording_failed_ = true;
+        return status;
+      }
+    }
+    if (simultaneous_use_) {
+      return command_buffer_.Enqueue(queue);
+    }
+    // Without simultaneous use, the command buffer can't be enqueued again
+    // while its previous execution is pending.
+    if (prev_execution_.is_valid()) {
+      prev_execution_.Wait();
+    }
+    return command_buffer_.Enqueue(queue, &prev_execution_);
+  }
+
+ private:
+  absl::Status Record(CLCommandQueue* queue) const {
+    prev_execution_ = CLEvent();
+    recorded_queue_ = nullptr;
+    CLCommandBuffer command_buffer;
+    RETURN_IF_ERROR(command_buffer.Init(queue, simultaneous_use_));
+    for (ClOperation* op : ops_) {
+      RETURN_IF_ERROR(op->AddToCommanBuffer(command_buffer.GetCommandBuffer()));
+    }
+    RETURN_IF_ERROR(command_buffer.Finalize());
+    command_buffer_ = std::move(command_buffer);
+    recorded_queue_ = queue->queue();
+    return absl::OkStatus();
+  }
+
+  std::vector<ClOperation*> ops_;
+  bool simultaneous_use_;
+  mutable CLCommandBuffer command_buffer_;
+  mutable cl_command_queue recorded_queue_ = nullptr;
+  mutable CLEvent prev_execution_;
+  mutable bool recording_failed_ = false;
+};
+
+}  // namespace
 
 std::unique_ptr<RecordableQueue> CreateRecordableQueue(
     const std::vector<ClOperation*>& ops, const CLDevice& device,
     const CLContext& context) {
-  return std::make_unique<RecordableQueue>(RecordableQueue());
+  if (ops.empty() ||
+      !device.GetInfo().SupportsExtension("cl_khr_command_buffer") ||
+      !clCreateCommandBufferKHR || !clCommandNDRangeKernelKHR) {
+    return std::make_unique<RecordableQueue>(RecordableQueue());
+  }
+  return std::make_unique<CommandBufferQueue>(ops,
+                                              SupportsSimultaneousUse(device));
 }
 
 }  // namespace cl
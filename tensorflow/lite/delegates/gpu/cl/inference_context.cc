@@ -357,8 +357,8 @@ absl::Status InferenceContext::InitFromGpuModel(
       tuning_type = TuningType::kFast;
     }
   }
-  RETURN_IF_ERROR(
-      Tune(tuning_type, env->device().GetInfo(), env->profiling_queue()));
+  RETURN_IF_ERROR(Tune(tuning_type, env->device().GetInfo(),
+                       env->profiling_queue(), env->program_cache()));
   if (external_mutable_tensors_.empty()) {
     // using recordable queue only when no mutable external tensors
     InitRecordableQueue(env);
@@ -753,7 +753,8 @@ absl::Status InferenceContext::Compile(
 
 absl::Status InferenceContext::Tune(TuningType tuning_type,
                                     const GpuInfo& gpu_info,
-                                    ProfilingCommandQueue* profiling_queue) {
+                                    ProfilingCommandQueue* profiling_queue,
+                                    ProgramCache* program_cache) {
   // Cache tuned CL operations. Multiple CL operations might share the
   // same kernel but use different inputs, which might require different working
   // group setups. Therefore, we store a vector of tuned cl operations for each
@@ -780,8 +781,8 @@ absl::Status InferenceContext::Tune(TuningType tuning_type,
     if (found_cached_cl_op) {
       continue;
     }
-    RETURN_IF_ERROR(
-        node.cl_operation.Tune(tuning_type, gpu_info, profiling_queue));
+    RETURN_IF_ERROR(node.cl_operation.Tune(tuning_type, gpu_info,
+                                           profiling_queue, program_cache));
     tuned_ops[fingerprint].emplace_back(std::cref(node.cl_operation));
   }
   return absl::OkStatus();
@@ -842,7 +843,12 @@ void InferenceContext::PrepareExternal() {
 
 absl::Status InferenceContext::AddToQueue(CLCommandQueue* queue) {
   if (recordable_queue_ && recordable_queue_->IsSupported()) {
-    return recordable_queue_->Execute(queue);
+    const absl::Status status = recordable_queue_->Execute(queue);
+    // A queue that fails to record is no longer supported, and the nodes are
+    // enqueued one by one instead.
+    if (status.ok() || recordable_queue_->IsSupported()) {
+      return status;
+    }
   }
   if (execution_hints_.need_manual_release) {
     if (execution_hints_.prev_enqueue_start_point.is_valid()) {
@@ -18,12 +18,14 @@ limitations under the License.
 #include <cstdint>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
 #include "tensorflow/lite/delegates/gpu/cl/compiled_program_cache_generated.h"
 #include "tensorflow/lite/delegates/gpu/cl/util.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
+#include "tensorflow/lite/delegates/gpu/common/types.h"
 #include <farmhash.h>
 
 namespace tflite {
@@ -53,6 +55,23 @@ uint64_t GetProgramFingerprint(const std::string& code,
   return CombineFingerprints(code_fingerprint, options_fingerprint);
 }
 
+uint64_t GetTuningFingerprint(uint64_t kernel_fingerprint,
+                              const std::vector<int3>& work_groups_counts,
+                              const std::vector<int3>& work_group_sizes) {
+  std::vector<int> dispatches;
+  dispatches.reserve(6 * work_group_sizes.size());
+  for (int i = 0; i < work_group_sizes.size(); ++i) {
+    dispatches.insert(dispatches.end(),
+                      {work_groups_counts[i].x, work_groups_counts[i].y,
+                       work_groups_counts[i].z, work_group_sizes[i].x,
+                       work_group_sizes[i].y, work_group_sizes[i].z});
+  }
+  const uint64_t dispatches_fingerprint =
+      ::util::Fingerprint64(reinterpret_cast<const char*>(dispatches.data()),
+                            dispatches.size() * sizeof(int));
+  return CombineFingerprints(kernel_fingerprint, dispatches_fingerprint);
+}
+
 std::string GetDriverVersion(const CLDevice& device) {
   return device.GetPlatformVersion() + "_jet_version_0";
 }
@@ -67,11 +86,14 @@ ProgramCache::ProgramDescriptor::ProgramDescriptor(uint64_t fingerprints)
     : fingerprint(fingerprints) {}
 
 ProgramCache::ProgramCache(ProgramCache&& program_cache)
-    : programs_(std::move(program_cache.programs_)) {}
+    : programs_(std::move(program_cache.programs_)),
+      tuned_work_group_sizes_(
+          std::move(program_cache.tuned_work_group_sizes_)) {}
 
 ProgramCache& ProgramCache::operator=(ProgramCache&& program_cache) {
   if (this != &program_cache) {
     programs_ = std::move(program_cache.programs_);
+    tuned_work_group_sizes_ = std::move(program_cache.tuned_work_group_sizes_);
   }
   return *this;
 }
@@ -145,6 +167,26 @@ absl::Status ProgramCache::GetProgramBinary(
   return it->second.GetBinary(program_binary);
 }
 
+void ProgramCache::AddTunedWorkGroupSize(
+    uint64_t kernel_fingerprint, const std::vector<int3>& work_groups_counts,
+    const std::vector<int3>& work_group_sizes, const int3& work_group_size) {
+  tuned_work_group_sizes_[GetTuningFingerprint(
+      kernel_fingerprint, work_groups_counts, work_group_sizes)] =
+      work_group_size;
+}
+
+bool ProgramCache::GetTunedWorkGroupSize(
+    uint64_t kernel_fingerprint, const std::vector<int3>& work_groups_counts,
+    const std::vector<int3>& work_group_sizes, int3* work_group_size) const {
+  auto it = tuned_work_group_sizes_.find(GetTuningFingerprint(
+      kernel_fingerprint, work_groups_counts, work_group_sizes));
+  if (it == tuned_work_group_sizes_.end()) {
+    return false;
+  }
+  *work_group_size = it->second;
+  return true;
+}
+
 absl::Status ProgramCache::AddSerializedCache(
     const CLContext& context, const CLDevice& device,
     absl::Span<const uint8_t> serialized_cache) {
@@ -163,6 +205,13 @@ absl::Status ProgramCache::AddSerializedCache(
         "OpenCL driver changed, cache invalid, should be regenerated");
   }
 
+  if (model->tuned_work_group_sizes()) {
+    for (auto tuned : *model->tuned_work_group_sizes()) {
+      tuned_work_group_sizes_.insert(
+          {tuned->fingerprint(), int3(tuned->x(), tuned->y(), tuned->z())});
+    }
+  }
+
   for (auto serialized_program : *model->programs()) {
     auto binary_span = absl::MakeSpan(serialized_program->binary()->data(),
                                       serialized_program->binary()->size());
@@ -185,11 +234,20 @@ absl::Status ProgramCache::GetSerializedCache(
     program_builder.add_binary(binary_offset);
     serialized_programs.push_back(program_builder.Finish());
   }
+  std::vector<flatbuffers::Offset<data::TunedWorkGroupSize>>
+      serialized_work_group_sizes;
+  for (auto& tuned : tuned_work_group_sizes_) {
+    serialized_work_group_sizes.push_back(data::CreateTunedWorkGroupSize(
+        builder, tuned.first, tuned.second.x, tuned.second.y,
+        tuned.second.z));
+  }
   auto driver_version = builder.CreateString(GetDriverVersion(device));
   auto programs_s = builder.CreateVector(serialized_programs);
+  auto work_group_sizes_s = builder.CreateVector(serialized_work_group_sizes);
   data::CompiledCacheBuilder cache_builder(builder);
   cache_builder.add_driver_version(driver_version);
   cache_builder.add_programs(programs_s);
+  cache_builder.add_tuned_work_group_sizes(work_group_sizes_s);
   data::FinishCompiledCacheBuffer(builder, cache_builder.Finish());
   size_t next_element = serialized_cache->size();
   serialized_cache->resize(serialized_cache->size() + builder.GetSize());
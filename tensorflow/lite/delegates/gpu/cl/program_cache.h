@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/cl_kernel.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_program.h"
 #include "tensorflow/lite/delegates/gpu/common/status.h"
+#include "tensorflow/lite/delegates/gpu/common/types.h"
 
 namespace tflite {
 namespace gpu {
@@ -62,6 +63,20 @@ class ProgramCache {
   absl::Status GetProgramBinary(uint64_t fingerprint,
                                 std::vector<uint8_t>* program_binary) const;
 
+  // Work group sizes chosen by tuning a kernel, among the given dispatches
+  // (work groups counts and sizes) of the kernel. They are serialized with the
+  // programs, so that the kernels of another model, or process, with the same
+  // dispatches don't need to be tuned again.
+  void AddTunedWorkGroupSize(uint64_t kernel_fingerprint,
+                             const std::vector<int3>& work_groups_counts,
+                             const std::vector<int3>& work_group_sizes,
+                             const int3& work_group_size);
+  // Returns false if the kernel wasn't tuned with these dispatches.
+  bool GetTunedWorkGroupSize(uint64_t kernel_fingerprint,
+                             const std::vector<int3>& work_groups_counts,
+                             const std::vector<int3>& work_group_sizes,
+                             int3* work_group_size) const;
+
   absl::Status AddSerializedCache(const CLContext& context,
                                   const CLDevice& device,
                                   absl::Span<const uint8_t> serialized_cache);
@@ -92,6 +107,8 @@ class ProgramCache {
   absl::flat_hash_map<ProgramDescriptor, CLProgram, ProgramDescriptorHasher,
                       ProgramDescriptorEqual>
       programs_;
+  // Keyed by the fingerprints of the kernels and of their dispatches.
+  absl::flat_hash_map<uint64_t, int3> tuned_work_group_sizes_;
 };
 
 }  // namespace cl
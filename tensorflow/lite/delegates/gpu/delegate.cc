@@ -123,6 +123,10 @@ using delegates::SerializationParams;
 using tflite::TFLITE_LOG_WARNING;
 
 constexpr char kSerializedDataPrefix[] = "gpuv2_data_";
+// The shared kernel cache doesn't depend on the model. The key has the version
+// of its format.
+constexpr char kSharedKernelCacheToken[] = "gpuv2_shared";
+constexpr char kSharedKernelCacheKey[] = "gpuv2_kernel_cache_v1";
 
 #if defined(__ANDROID__)
 // Xeno API does not impose alignment or padding requirements.
@@ -252,10 +256,19 @@ class Delegate {
       telemetry_settings_ =
           std::make_unique<TfLiteTelemetryGpuDelegateSettings>();
     }
+    if (options_.experimental_flags &
+            TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SHARED_KERNEL_CACHE &&
+        options_.serialization_dir) {
+      SerializationParams params;
+      params.model_token = kSharedKernelCacheToken;
+      params.cache_dir = options_.serialization_dir;
+      shared_kernel_cache_ = std::make_unique<Serialization>(params);
+    }
   }
 
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
   Serialization* serialization() { return serialization_.get(); }
+  Serialization* shared_kernel_cache() { return shared_kernel_cache_.get(); }
   const TfLiteGpuDelegateOptionsV2& options() const { return options_; }
   bool async() const { return async_; }
 
@@ -277,6 +290,7 @@ class Delegate {
   std::atomic<int> num_delegate_kernels_ = 0;
 
   std::unique_ptr<Serialization> serialization_;
+  std::unique_ptr<Serialization> shared_kernel_cache_;
 
   std::unique_ptr<TfLiteTelemetryGpuDelegateSettings> telemetry_settings_;
 
@@ -348,6 +362,15 @@ class DelegateKernelCore {
       cl::InferenceOptions* options, Serialization* serialization,
       const std::vector<uint8_t>& serialized_model);
 
+  // Reads the shared kernel cache, if enabled, into `data`.
+  void MaybeReadSharedKernelCache(TfLiteContext* context, std::string* data);
+
+  // Saves the programs and tuned work group sizes of `cl_environment_` to the
+  // shared kernel cache, if enabled and if there are more than in
+  // `previous_data`.
+  void MaybeUpdateSharedKernelCache(TfLiteContext* context,
+                                    const std::string& previous_data);
+
   // The Delegate instance that's shared across all DelegateKernel instances.
   Delegate* const delegate_;  // doesn't own the memory.
 
@@ -548,6 +571,13 @@ absl::Status DelegateKernelCore::InitializeOpenClApi(
   options.gpu_invoke_loop_times = delegate_options.gpu_invoke_loop_times;
 #endif
 
+  // Must outlive the environment, which reads it in NewInferenceBuilder.
+  std::string shared_kernel_cache;
+  MaybeReadSharedKernelCache(context, &shared_kernel_cache);
+  env_options.serialized_binary_cache = absl::MakeConstSpan(
+      reinterpret_cast<const uint8_t*>(shared_kernel_cache.data()),
+      shared_kernel_cache.size());
+
   if (!serialization) {
     // This path is faster when there is no serialization involved.
     RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
@@ -555,6 +585,7 @@ absl::Status DelegateKernelCore::InitializeOpenClApi(
     *graph_is_destroyed = true;
     RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
         options, std::move(*graph), builder));
+    MaybeUpdateSharedKernelCache(context, shared_kernel_cache);
   } else {
     // If serialization data is found, initialize CL from it & return early.
     if (MaybeInitializeSerializedOpenCL(context, delegate_params, builder,
@@ -575,6 +606,7 @@ absl::Status DelegateKernelCore::InitializeOpenClApi(
 
     RETURN_IF_ERROR(SaveSerializedOpenCL(context, delegate_params, &options,
                                          serialization, serialized_model));
+    MaybeUpdateSharedKernelCache(context, shared_kernel_cache);
   }
 
   TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
@@ -674,6 +706,33 @@ absl::Status DelegateKernelCore::SaveSerializedOpenCL(
   return absl::OkStatus();
 }
 
+void DelegateKernelCore::MaybeReadSharedKernelCache(TfLiteContext* context,
+                                                    std::string* data) {
+  Serialization* shared_kernel_cache = delegate_->shared_kernel_cache();
+  if (!shared_kernel_cache) return;
+  // Not keyed by the context, so that all models share the cache.
+  auto data_key = shared_kernel_cache->GetEntryForDelegate(
+      kSharedKernelCacheKey, /*context=*/nullptr);
+  if (data_key.GetData(context, data) != kTfLiteOk) {
+    data->clear();
+  }
+}
+
+void DelegateKernelCore::MaybeUpdateSharedKernelCache(
+    TfLiteContext* context, const std::string& previous_data) {
+  Serialization* shared_kernel_cache = delegate_->shared_kernel_cache();
+  if (!shared_kernel_cache) return;
+  const std::vector<uint8_t> data = cl_environment_->GetSerializedBinaryCache();
+  // The cache only grows, unless it was discarded.
+  if (data.empty() || data.size() == previous_data.size()) return;
+  auto data_key = shared_kernel_cache->GetEntryForDelegate(
+      kSharedKernelCacheKey, /*context=*/nullptr);
+  if (data_key.SetData(context, reinterpret_cast<const char*>(data.data()),
+                       data.size()) != kTfLiteOk) {
+    TFLITE_LOG_PROD(TFLITE_LOG_WARNING, "Failed to save the GPU kernel cache.");
+  }
+}
+
 // Represent the execution of a subset of nodes on GPU.
 class DelegateKernel {
  public:
@@ -71,6 +71,17 @@ enum TfLiteGpuExperimentalFlags {
   // TfLiteGpuDelegateOptionsV2.
   // Currently works only if CL backend is used.
   TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION = 1 << 3,
+  // Keeps the compiled programs and the tuned work group sizes of all models
+  // in one cache in serialization_dir, which is read before the kernels are
+  // compiled and tuned, and updated if new ones were. Unlike serialization,
+  // the cache is shared by different models, and versions of a model, with
+  // the same kernels, as well as by the apps that use the same directory.
+  // It is discarded when the GPU driver changes.
+  //
+  // NOTE: User also needs to set serialization_dir, but not model_token, in
+  // TfLiteGpuDelegateOptionsV2.
+  // Currently works only if CL backend is used.
+  TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SHARED_KERNEL_CACHE = 1 << 4,
 };
 
 // IMPORTANT: Always use TfLiteGpuDelegateOptionsV2Default() method to create
@@ -0,0 +1,297 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/stderr_reporter.h"
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+constexpr uint64_t kFileMagic = 0x48434143574e4e58;  // "XNNWCACH"
+constexpr uint64_t kFileVersion = 1;
+
+// The file starts with a header, padded to kAlignment, followed by the
+// packed weights at aligned offsets, and ends with the entry table.
+struct FileHeader {
+  uint64_t magic;
+  uint64_t version;
+  uint64_t fingerprint;
+  uint64_t num_entries;
+  uint64_t entries_offset;
+};
+
+struct FileEntry {
+  uint64_t seed;
+  uint64_t kernel_id;
+  uint64_t bias_id;
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(sizeof(FileHeader) <= MMapWeightCache::kAlignment,
+              "The header must fit before the first packed weights.");
+
+size_t AlignUp(size_t value) {
+  return (value + MMapWeightCache::kAlignment - 1) &
+         ~(MMapWeightCache::kAlignment - 1);
+}
+
+uint64_t Mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+}  // namespace
+
+MMapWeightCache::MMapWeightCache(std::string path, uint64_t fingerprint)
+    : path_(std::move(path)), fingerprint_(fingerprint) {
+  if (!Load()) {
+    allocation_.reset();
+    file_size_ = 0;
+    entries_.clear();
+  }
+}
+
+bool MMapWeightCache::Load() {
+  if (path_.empty() || !MMAPAllocation::IsSupported()) {
+    return false;
+  }
+  // A missing file is the usual first startup, and not worth an error.
+  FILE* file = std::fopen(path_.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::fclose(file);
+
+  allocation_ =
+      std::make_unique<MMAPAllocation>(path_.c_str(), DefaultErrorReporter());
+  if (!allocation_->valid() || allocation_->bytes() < sizeof(FileHeader)) {
+    return false;
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(allocation_->base());
+  const size_t file_size = allocation_->bytes();
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (header.magic != kFileMagic || header.version != kFileVersion ||
+      header.fingerprint != fingerprint_) {
+    TFLITE_LOG_PROD(TFLITE_LOG_INFO,
+                    "Ignoring XNNPACK weight cache '%s' of other options.",
+                    path_.c_str());
+    return false;
+  }
+  if (header.entries_offset > file_size ||
+      header.num_entries >
+          (file_size - header.entries_offset) / sizeof(FileEntry)) {
+    TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                    "Ignoring truncated XNNPACK weight cache '%s'.",
+                    path_.c_str());
+    return false;
+  }
+  for (uint64_t i = 0; i < header.num_entries; ++i) {
+    FileEntry entry;
+    std::memcpy(&entry, base + header.entries_offset + i * sizeof(FileEntry),
+                sizeof(entry));
+    if (entry.offset % kAlignment != 0 ||
+        entry.offset > header.entries_offset ||
+        entry.size > header.entries_offset - entry.offset) {
+      TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                      "Ignoring corrupted XNNPACK weight cache '%s'.",
+                      path_.c_str());
+      return false;
+    }
+    PackIdentifier id;
+    id.seed = entry.seed;
+    id.kernel_id = entry.kernel_id;
+    id.bias_id = entry.bias_id;
+    entries_[id] = Entry{static_cast<size_t>(entry.offset),
+                         static_cast<size_t>(entry.size), /*used=*/false};
+  }
+  file_size_ = file_size;
+  return true;
+}
+
+void MMapWeightCache::RegisterBuffer(const void* data, size_t size) {
+  // The identifier is reset, as the memory may have been reused.
+  buffers_[data] = Buffer{size, 0};
+}
+
+uint64_t MMapWeightCache::GetBufferIdentifier(const void* data) {
+  auto it = buffers_.find(data);
+  if (it == buffers_.end()) {
+    return 0;
+  }
+  if (it->second.id == 0) {
+    // 0 stands for no buffer.
+    it->second.id = std::max<uint64_t>(1, Fingerprint(data, it->second.size));
+  }
+  return it->second.id;
+}
+
+size_t MMapWeightCache::LookUp(const PackIdentifier& id) {
+  if (id.kernel_id == 0) {
+    return kNotFound;
+  }
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return kNotFound;
+  }
+  it->second.used = true;
+  return it->second.offset;
+}
+
+void* MMapWeightCache::ReserveSpace(size_t size) {
+  if (finalized_) {
+    return nullptr;
+  }
+  const size_t offset = AlignUp(builder_size_);
+  const size_t required = offset + size + kAlignment;
+  if (builder_.size() < required) {
+    // Offsets stay valid as the packed weights are moved to the new buffer.
+    std::vector<uint8_t> builder(std::max(required, 2 * builder_.size()));
+    uint8_t* base = reinterpret_cast<uint8_t*>(
+        AlignUp(reinterpret_cast<uintptr_t>(builder.data())));
+    if (builder_size_ > 0) {
+      std::memcpy(base, builder_base_, builder_size_);
+    }
+    builder_ = std::move(builder);
+    builder_base_ = base;
+  }
+  return builder_base_ + offset;
+}
+
+size_t MMapWeightCache::LookUpOrInsert(const PackIdentifier& id, void* ptr,
+                                       size_t size) {
+  const size_t cached_offset = LookUp(id);
+  if (cached_offset != kNotFound || ptr == nullptr || finalized_) {
+    return cached_offset;
+  }
+  const size_t builder_offset = static_cast<uint8_t*>(ptr) - builder_base_;
+  builder_size_ = builder_offset + size;
+  const size_t offset = file_size_ + builder_offset;
+  // Weights packed from unregistered buffers can't be looked up later.
+  if (id.kernel_id != 0) {
+    entries_[id] = Entry{offset, size, /*used=*/true};
+    dirty_ = true;
+  }
+  return offset;
+}
+
+void* MMapWeightCache::OffsetToAddr(size_t offset) {
+  if (offset < file_size_) {
+    return const_cast<uint8_t*>(
+               static_cast<const uint8_t*>(allocation_->base())) +
+           offset;
+  }
+  return builder_base_ + (offset - file_size_);
+}
+
+bool MMapWeightCache::Finalize() {
+  if (finalized_) {
+    return true;
+  }
+  finalized_ = true;
+  if (!dirty_ || path_.empty() || !MMAPAllocation::IsSupported()) {
+    return true;
+  }
+  // Written next to the file and renamed over it, as it may be mapped.
+  const std::string temp_path = path_ + ".tmp";
+  if (!Write(temp_path) || std::rename(temp_path.c_str(), path_.c_str())) {
+    TFLITE_LOG_PROD(TFLITE_LOG_WARNING,
+                    "Failed to write XNNPACK weight cache '%s'.",
+                    path_.c_str());
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool MMapWeightCache::Write(const std::string& path) {
+  std::vector<FileEntry> file_entries;
+  size_t offset = kAlignment;
+  for (const auto& [id, entry] : entries_) {
+    if (!entry.used) continue;
+    FileEntry file_entry;
+    file_entry.seed = id.seed;
+    file_entry.kernel_id = id.kernel_id;
+    file_entry.bias_id = id.bias_id;
+    // The packed weights themselves are looked up by their current offset.
+    file_entry.offset = entry.offset;
+    file_entry.size = entry.size;
+    file_entries.push_back(file_entry);
+    offset = AlignUp(offset + entry.size);
+  }
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = true;
+  std::vector<uint8_t> header(kAlignment, 0);
+  const FileHeader file_header = {kFileMagic, kFileVersion, fingerprint_,
+                                  file_entries.size(), offset};
+  std::memcpy(header.data(), &file_header, sizeof(file_header));
+  ok &= std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+  const std::vector<uint8_t> padding(kAlignment, 0);
+  size_t file_offset = kAlignment;
+  for (FileEntry& file_entry : file_entries) {
+    const void* data = OffsetToAddr(file_entry.offset);
+    ok &= std::fwrite(data, 1, file_entry.size, file) == file_entry.size;
+    file_entry.offset = file_offset;
+    const size_t end = file_offset + file_entry.size;
+    file_offset = AlignUp(end);
+    ok &= std::fwrite(padding.data(), 1, file_offset - end, file) ==
+          file_offset - end;
+  }
+  const size_t entries_bytes = file_entries.size() * sizeof(FileEntry);
+  ok &= std::fwrite(file_entries.data(), 1, entries_bytes, file) ==
+        entries_bytes;
+  ok &= std::fclose(file) == 0;
+  return ok;
+}
+
+uint64_t MMapWeightCache::Fingerprint(const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t h = Mix(size ^ 0x9e3779b97f4a7c15ull);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    h = (h ^ Mix(word)) * 0x9e3779b97f4a7c15ull;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, size - i);
+  return Mix(h ^ Mix(tail));
+}
+
+}  // namespace xnnpack
+}  // namespace tflite
@@ -0,0 +1,143 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
+#define TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/lite/allocation.h"
+
+namespace tflite {
+namespace xnnpack {
+
+// Identifies a buffer of packed weights: the seed that XNNPACK derives from
+// the packing parameters, and the identifiers of the kernel and bias buffers
+// that were packed.
+struct PackIdentifier {
+  uint64_t seed = 0;
+  uint64_t kernel_id = 0;
+  uint64_t bias_id = 0;
+
+  bool operator==(const PackIdentifier& other) const {
+    return seed == other.seed && kernel_id == other.kernel_id &&
+           bias_id == other.bias_id;
+  }
+
+  struct Hash {
+    size_t operator()(const PackIdentifier& id) const {
+      return id.seed ^ (id.kernel_id * 31) ^ (id.bias_id * 961);
+    }
+  };
+};
+
+// A cache of packed weights, backed by a file so that later interpreter
+// startups skip the packing.
+//
+// A valid cache file is mapped into memory, and the packed weights are used
+// in place. The entries are keyed by fingerprints of the contents of the
+// buffers they were packed from, so entries of a changed model are missed,
+// packed again, and written back on `Finalize`, along with the reused ones.
+//
+// Packed weights are placed at offsets that stay valid as the cache grows;
+// `OffsetToAddr` returns their address once the cache is finalized.
+class MMapWeightCache {
+ public:
+  static constexpr size_t kNotFound = SIZE_MAX;
+  // The alignment of packed weights, in memory and in the file.
+  static constexpr size_t kAlignment = 64;
+
+  // Loads the cache file at `path` if it exists and matches `fingerprint`,
+  // e.g. packing options that aren't part of the pack identifiers.
+  MMapWeightCache(std::string path, uint64_t fingerprint);
+
+  // Returns whether a cache file was loaded.
+  bool loaded() const { return allocation_ != nullptr; }
+
+  // Makes `size` bytes at `data` identifiable by their contents. Weights
+  // packed from a buffer that isn't registered aren't written to the file.
+  void RegisterBuffer(const void* data, size_t size);
+
+  // Returns the identifier of a registered buffer, or 0 if there's none at
+  // `data`. The contents are fingerprinted on first use.
+  uint64_t GetBufferIdentifier(const void* data);
+
+  // Returns the offset of the packed weights for `id`, or kNotFound.
+  size_t LookUp(const PackIdentifier& id);
+
+  // Returns space for `size` bytes of weights to be packed, valid until the
+  // next call. Returns nullptr once the cache is finalized.
+  void* ReserveSpace(size_t size);
+
+  // Returns the offset of the packed weights for `id`, adding the `size`
+  // bytes at `ptr`, from the last ReserveSpace, if there are none yet.
+  size_t LookUpOrInsert(const PackIdentifier& id, void* ptr, size_t size);
+
+  void* OffsetToAddr(size_t offset);
+
+  bool IsFinalized() const { return finalized_; }
+
+  // Freezes the cache, writing it to the file if weights were packed.
+  // Returns false if the file couldn't be written; the cache is still usable.
+  bool Finalize();
+
+  // Returns a fingerprint of `size` bytes at `data`.
+  static uint64_t Fingerprint(const void* data, size_t size);
+
+ private:
+  struct Entry {
+    size_t offset;
+    size_t size;
+    // Whether this startup used the entry, which is then written back.
+    bool used;
+  };
+
+  struct Buffer {
+    size_t size;
+    uint64_t id;
+  };
+
+  // Reads and validates the cache file. Returns false if it's missing or
+  // invalid.
+  bool Load();
+  bool Write(const std::string& path);
+
+  std::string path_;
+  uint64_t fingerprint_;
+  bool finalized_ = false;
+  // Whether weights were packed that the file is missing.
+  bool dirty_ = false;
+
+  std::unordered_map<const void*, Buffer> buffers_;
+  std::unordered_map<PackIdentifier, Entry, PackIdentifier::Hash> entries_;
+
+  // The mapped cache file. Offsets below its size are in the file.
+  std::unique_ptr<Allocation> allocation_;
+  size_t file_size_ = 0;
+
+  // Weights packed at this startup, at offsets from `file_size_` up.
+  std::vector<uint8_t> builder_;
+  uint8_t* builder_base_ = nullptr;
+  size_t builder_size_ = 0;
+};
+
+}  // namespace xnnpack
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_XNNPACK_WEIGHT_CACHE_H_
@@ -0,0 +1,202 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+constexpr uint64_t kFingerprint = 42;
+
+class MMapWeightCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = testing::TempDir() + "/" +
+            testing::UnitTest::GetInstance()->current_test_info()->name() +
+            ".xnnpack_cache";
+    std::remove(path_.c_str());
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  // Packs `kernel` into the cache, the packed weights being the kernel with
+  // every byte incremented.
+  size_t Pack(MMapWeightCache& cache, const std::vector<uint8_t>& kernel,
+              uint64_t seed = 1) {
+    PackIdentifier id;
+    id.seed = seed;
+    id.kernel_id = cache.GetBufferIdentifier(kernel.data());
+    const size_t offset = cache.LookUp(id);
+    if (offset != MMapWeightCache::kNotFound) {
+      return offset;
+    }
+    uint8_t* packed = static_cast<uint8_t*>(cache.ReserveSpace(kernel.size()));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(packed) %
+                  MMapWeightCache::kAlignment,
+              0);
+    for (size_t i = 0; i < kernel.size(); ++i) {
+      packed[i] = kernel[i] + 1;
+    }
+    ++num_packed_;
+    return cache.LookUpOrInsert(id, packed, kernel.size());
+  }
+
+  void ExpectPacked(MMapWeightCache& cache, size_t offset,
+                    const std::vector<uint8_t>& kernel) {
+    const uint8_t* packed =
+        static_cast<const uint8_t*>(cache.OffsetToAddr(offset));
+    for (size_t i = 0; i < kernel.size(); ++i) {
+      ASSERT_EQ(packed[i], static_cast<uint8_t>(kernel[i] + 1));
+    }
+  }
+
+  std::string path_;
+  int num_packed_ = 0;
+};
+
+TEST_F(MMapWeightCacheTest, ReloadsPackedWeights) {
+  const std::vector<uint8_t> kernel1(100, 3);
+  const std::vector<uint8_t> kernel2(1000, 7);
+  {
+    MMapWeightCache cache(path_, kFingerprint);
+    EXPECT_FALSE(cache.loaded());
+    cache.RegisterBuffer(kernel1.data(), kernel1.size());
+    cache.RegisterBuffer(kernel2.data(), kernel2.size());
+    const size_t offset1 = Pack(cache, kernel1);
+    const size_t offset2 = Pack(cache, kernel2);
+    EXPECT_EQ(num_packed_, 2);
+    EXPECT_EQ(Pack(cache, kernel1), offset1);
+    EXPECT_EQ(num_packed_, 2);
+    EXPECT_TRUE(cache.Finalize());
+    EXPECT_TRUE(cache.IsFinalized());
+    EXPECT_EQ(cache.ReserveSpace(10), nullptr);
+    ExpectPacked(cache, offset1, kernel1);
+    ExpectPacked(cache, offset2, kernel2);
+  }
+
+  // Buffers at other addresses, as in another process.
+  const std::vector<uint8_t> reloaded_kernel1 = kernel1;
+  const std::vector<uint8_t> reloaded_kernel2 = kernel2;
+  MMapWeightCache cache(path_, kFingerprint);
+  ASSERT_TRUE(cache.loaded());
+  cache.RegisterBuffer(reloaded_kernel1.data(), reloaded_kernel1.size());
+  cache.RegisterBuffer(reloaded_kernel2.data(), reloaded_kernel2.size());
+  num_packed_ = 0;
+  const size_t offset1 = Pack(cache, reloaded_kernel1);
+  const size_t offset2 = Pack(cache, reloaded_kernel2);
+  EXPECT_EQ(num_packed_, 0);
+  EXPECT_TRUE(cache.Finalize());
+  ExpectPacked(cache, offset1, kernel1);
+  ExpectPacked(cache, offset2, kernel2);
+  // The seed tells apart packings of one buffer.
+  EXPECT_EQ(cache.LookUp({2, cache.GetBufferIdentifier(kernel1.data()), 0}),
+            MMapWeightCache::kNotFound);
+}
+
+TEST_F(MMapWeightCacheTest, IgnoresFileOfOtherFingerprint) {
+  const std::vector<uint8_t> kernel(100, 3);
+  {
+    MMapWeightCache cache(path_, kFingerprint);
+    cache.RegisterBuffer(kernel.data(), kernel.size());
+    Pack(cache, kernel);
+    EXPECT_TRUE(cache.Finalize());
+  }
+  MMapWeightCache cache(path_, kFingerprint + 1);
+  EXPECT_FALSE(cache.loaded());
+}
+
+TEST_F(MMapWeightCacheTest, RewritesFileForChangedWeights) {
+  const std::vector<uint8_t> kernel1(100, 3);
+  const std::vector<uint8_t> kernel2(200, 5);
+  {
+    MMapWeightCache cache(path_, kFingerprint);
+    cache.RegisterBuffer(kernel1.data(), kernel1.size());
+    Pack(cache, kernel1);
+    EXPECT_TRUE(cache.Finalize());
+  }
+  {
+    // kernel1 is replaced by kernel2.
+    MMapWeightCache cache(path_, kFingerprint);
+    ASSERT_TRUE(cache.loaded());
+    cache.RegisterBuffer(kernel2.data(), kernel2.size());
+    num_packed_ = 0;
+    const size_t offset = Pack(cache, kernel2);
+    EXPECT_EQ(num_packed_, 1);
+    EXPECT_TRUE(cache.Finalize());
+    ExpectPacked(cache, offset, kernel2);
+  }
+  MMapWeightCache cache(path_, kFingerprint);
+  ASSERT_TRUE(cache.loaded());
+  cache.RegisterBuffer(kernel1.data(), kernel1.size());
+  cache.RegisterBuffer(kernel2.data(), kernel2.size());
+  // The unused kernel1 was dropped from the file.
+  EXPECT_EQ(cache.LookUp({1, cache.GetBufferIdentifier(kernel1.data()), 0}),
+            MMapWeightCache::kNotFound);
+  num_packed_ = 0;
+  const size_t offset = Pack(cache, kernel2);
+  EXPECT_EQ(num_packed_, 0);
+  ExpectPacked(cache, offset, kernel2);
+}
+
+TEST_F(MMapWeightCacheTest, UnregisteredBuffersArentPersisted) {
+  const std::vector<uint8_t> kernel(100, 3);
+  {
+    MMapWeightCache cache(path_, kFingerprint);
+    const size_t offset = Pack(cache, kernel);
+    EXPECT_EQ(num_packed_, 1);
+    EXPECT_TRUE(cache.Finalize());
+    ExpectPacked(cache, offset, kernel);
+  }
+  MMapWeightCache cache(path_, kFingerprint);
+  EXPECT_FALSE(cache.loaded());
+}
+
+TEST_F(MMapWeightCacheTest, OffsetsSurviveGrowth) {
+  MMapWeightCache cache(path_, kFingerprint);
+  std::vector<std::vector<uint8_t>> kernels;
+  for (int i = 0; i < 20; ++i) {
+    kernels.emplace_back(1000 * (i + 1), i);
+  }
+  std::vector<size_t> offsets;
+  for (const std::vector<uint8_t>& kernel : kernels) {
+    cache.RegisterBuffer(kernel.data(), kernel.size());
+    offsets.push_back(Pack(cache, kernel));
+  }
+  EXPECT_TRUE(cache.Finalize());
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    ExpectPacked(cache, offsets[i], kernels[i]);
+  }
+}
+
+TEST(MMapWeightCacheFingerprintTest, DependsOnContents) {
+  std::vector<uint8_t> data(37, 1);
+  const uint64_t fingerprint = MMapWeightCache::Fingerprint(data.data(), 37);
+  EXPECT_EQ(MMapWeightCache::Fingerprint(data.data(), 37), fingerprint);
+  EXPECT_NE(MMapWeightCache::Fingerprint(data.data(), 36), fingerprint);
+  data[36] = 2;
+  EXPECT_NE(MMapWeightCache::Fingerprint(data.data(), 37), fingerprint);
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
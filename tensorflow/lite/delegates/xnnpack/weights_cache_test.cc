@@ -178,6 +178,49 @@ TEST(XNNPACK_WEIGHTS_CACHE, SoftFinalization) {
   ASSERT_EQ(kTfLiteOk, interpreter2->Invoke());
 }
 
+TEST(XNNPACK_WEIGHTS_CACHE, SharedAcrossInterpreters) {
+  std::vector<char> buffer = Conv2DTester().CreateTfLiteModel();
+  const Model* model = GetModel(buffer.data());
+  DummyOpResolver resolver;
+
+  TfLiteXNNPackDelegateOptions delegate_options =
+      TfLiteXNNPackDelegateOptionsDefault();
+  delegate_options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHTS_CACHE;
+
+  // The cache is finalized by the first invocation, not by the caller.
+  std::unique_ptr<Interpreter> interpreter1;
+  ASSERT_EQ(kTfLiteOk, InterpreterBuilder(model, resolver)(&interpreter1));
+  ASSERT_EQ(kTfLiteOk, interpreter1->AllocateTensors());
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      delegate1(TfLiteXNNPackDelegateCreate(&delegate_options),
+                TfLiteXNNPackDelegateDelete);
+  ASSERT_EQ(kTfLiteOk, interpreter1->ModifyGraphWithDelegate(delegate1.get()));
+  ASSERT_EQ(kTfLiteOk, interpreter1->Invoke());
+
+  // A second interpreter of the model hits the finalized cache.
+  std::unique_ptr<Interpreter> interpreter2;
+  ASSERT_EQ(kTfLiteOk, InterpreterBuilder(model, resolver)(&interpreter2));
+  ASSERT_EQ(kTfLiteOk, interpreter2->AllocateTensors());
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      delegate2(TfLiteXNNPackDelegateCreate(&delegate_options),
+                TfLiteXNNPackDelegateDelete);
+  ASSERT_EQ(kTfLiteOk, interpreter2->ModifyGraphWithDelegate(delegate2.get()));
+  ASSERT_EQ(kTfLiteOk, interpreter2->Invoke());
+
+  // Another model buffer gets a cache of its own.
+  std::vector<char> other_buffer = Conv2DTester().CreateTfLiteModel();
+  const Model* other_model = GetModel(other_buffer.data());
+  std::unique_ptr<Interpreter> interpreter3;
+  ASSERT_EQ(kTfLiteOk,
+            InterpreterBuilder(other_model, resolver)(&interpreter3));
+  ASSERT_EQ(kTfLiteOk, interpreter3->AllocateTensors());
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      delegate3(TfLiteXNNPackDelegateCreate(&delegate_options),
+                TfLiteXNNPackDelegateDelete);
+  ASSERT_EQ(kTfLiteOk, interpreter3->ModifyGraphWithDelegate(delegate3.get()));
+  ASSERT_EQ(kTfLiteOk, interpreter3->Invoke());
+}
+
 // Dummy class to use with parameterized test.
 class WeightsCacheTest : public testing::TestWithParam<size_t> {};
 
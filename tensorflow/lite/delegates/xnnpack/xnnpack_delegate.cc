@@ -26,6 +26,7 @@ limitations under the License.
 #include <memory>
 #include <mutex>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -38,6 +39,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/delegates/xnnpack/quantization_util.h"
+#include "tensorflow/lite/delegates/xnnpack/weight_cache.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -48,6 +50,21 @@ limitations under the License.
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/tools/optimize/reduced_precision_support.h"
 
+#if defined(__ANDROID__)
+#include <android/hardware_buffer.h>
+#include <unistd.h>
+
+#include "tensorflow/lite/async/backend_async_kernel_interface.h"
+#include "tensorflow/lite/core/async/c/task.h"
+#include "tensorflow/lite/core/async/interop/c/attribute_map.h"
+#include "tensorflow/lite/core/async/interop/c/constants.h"
+#include "tensorflow/lite/core/async/interop/c/types.h"
+#include "tensorflow/lite/delegates/gpu/android_hardware_buffer.h"
+#include "tensorflow/lite/delegates/utils/async_type_helpers.h"
+#include "tensorflow/lite/delegates/utils/ret_macros.h"
+#include "tensorflow/lite/delegates/utils/sync_fence.h"
+#endif  // defined(__ANDROID__)
+
 struct TfLiteXNNPackDelegateWeightsCache;
 
 namespace tflite {
@@ -486,6 +503,88 @@ class VariableHolder {
   std::map<uint32_t, const TfLiteTensor*> global_id_to_dims_and_type_;
 };
 
+// A weights cache shared by the delegate instances that use
+// TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHTS_CACHE.
+struct SharedWeightsCache {
+  ~SharedWeightsCache() { TfLiteXNNPackDelegateWeightsCacheDelete(cache); }
+
+  TfLiteXNNPackDelegateWeightsCache* cache = nullptr;
+  bool finalized = false;
+};
+
+// The first and last byte of the static weights of a subgraph, and the
+// delegate flags.
+using SharedWeightsCacheKey = std::tuple<const char*, const char*, uint32_t>;
+
+std::mutex& SharedWeightsCacheMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+// Returns the cache for `key`, creating it if no delegate holds one.
+std::shared_ptr<SharedWeightsCache> GetSharedWeightsCache(
+    const SharedWeightsCacheKey& key) {
+  static auto* caches =
+      new std::map<SharedWeightsCacheKey, std::weak_ptr<SharedWeightsCache>>();
+  std::lock_guard<std::mutex> lock(SharedWeightsCacheMutex());
+  std::weak_ptr<SharedWeightsCache>& entry = (*caches)[key];
+  std::shared_ptr<SharedWeightsCache> cache = entry.lock();
+  if (cache == nullptr) {
+    cache = std::make_shared<SharedWeightsCache>();
+    cache->cache = TfLiteXNNPackDelegateWeightsCacheCreate();
+    if (cache->cache == nullptr) {
+      return nullptr;
+    }
+    entry = cache;
+  }
+  return cache;
+}
+
+// Adapts a MMapWeightCache to the XNNPACK weights cache interface. Weights
+// are identified by the contents of the buffers XNNPACK packs them from.
+PackIdentifier GetPackIdentifier(MMapWeightCache* cache,
+                                 const xnn_weights_cache_look_up_key* key) {
+  PackIdentifier id;
+  id.seed = key->seed;
+  id.kernel_id = cache->GetBufferIdentifier(key->kernel);
+  if (key->bias != nullptr) {
+    id.bias_id = cache->GetBufferIdentifier(key->bias);
+    if (id.bias_id == 0) {
+      // Not identifiable, so not cached across startups.
+      id.kernel_id = 0;
+    }
+  }
+  return id;
+}
+
+size_t WeightCacheLookUp(void* context,
+                         const xnn_weights_cache_look_up_key* key) {
+  auto* cache = static_cast<MMapWeightCache*>(context);
+  return cache->LookUp(GetPackIdentifier(cache, key));
+}
+
+void* WeightCacheReserveSpace(void* context, size_t n) {
+  return static_cast<MMapWeightCache*>(context)->ReserveSpace(n);
+}
+
+size_t WeightCacheLookUpOrInsert(void* context,
+                                 const xnn_weights_cache_look_up_key* key,
+                                 void* ptr, size_t size) {
+  auto* cache = static_cast<MMapWeightCache*>(context);
+  return cache->LookUpOrInsert(GetPackIdentifier(cache, key), ptr, size);
+}
+
+bool WeightCacheIsFinalized(void* context) {
+  return static_cast<MMapWeightCache*>(context)->IsFinalized();
+}
+
+void* WeightCacheOffsetToAddr(void* context, size_t offset) {
+  return static_cast<MMapWeightCache*>(context)->OffsetToAddr(offset);
+}
+
+// The cache is owned by the delegate.
+xnn_status WeightCacheDelete(void* context) { return xnn_status_success; }
+
 class Delegate {
   friend class Subgraph;
 
@@ -524,6 +623,24 @@ class Delegate {
         options != nullptr ? *options : TfLiteXNNPackDelegateOptionsDefault();
     delegate_.flags = GetXNNPackDelegateFlags();
     workspace_.reset(workspace);
+
+    if (options_.weights_cache == nullptr &&
+        options_.weight_cache_file_path != nullptr &&
+        options_.weight_cache_file_path[0] != '\0') {
+      // The file is only valid for the options that change the packing.
+      weight_cache_file_ = std::make_unique<MMapWeightCache>(
+          options_.weight_cache_file_path, options_.flags);
+      weight_cache_provider_ = std::make_unique<xnn_weights_cache_provider>();
+      weight_cache_provider_->context = weight_cache_file_.get();
+      weight_cache_provider_->look_up = WeightCacheLookUp;
+      weight_cache_provider_->reserve_space = WeightCacheReserveSpace;
+      weight_cache_provider_->look_up_or_insert = WeightCacheLookUpOrInsert;
+      weight_cache_provider_->is_finalized = WeightCacheIsFinalized;
+      weight_cache_provider_->offset_to_addr = WeightCacheOffsetToAddr;
+      weight_cache_provider_->delete_cache = WeightCacheDelete;
+    }
+    // The path is only valid during the call.
+    options_.weight_cache_file_path = nullptr;
   }
 
   TfLiteIntArray* PrepareOpsToDelegate(TfLiteContext* context);
@@ -609,14 +726,113 @@ class Delegate {
 #endif
   }
 
+  bool async_kernel() const {
+    return (options_.flags & TFLITE_XNNPACK_DELEGATE_FLAG_ASYNC_KERNEL) != 0;
+  }
+
+  bool use_shared_weights_cache() const {
+    return options_.weights_cache == nullptr && weight_cache_file_ == nullptr &&
+           (options_.flags &
+            TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHTS_CACHE) != 0;
+  }
+
   xnn_weights_cache_t weights_cache() const {
-    if (options_.weights_cache == nullptr) {
-      return nullptr;
-    } else {
+    if (options_.weights_cache != nullptr) {
       return reinterpret_cast<xnn_weights_cache_t>(options_.weights_cache);
+    } else if (weight_cache_provider_ != nullptr) {
+      return weight_cache_provider_.get();
+    } else if (active_shared_weights_cache_ != nullptr) {
+      return reinterpret_cast<xnn_weights_cache_t>(
+          active_shared_weights_cache_->cache);
+    } else {
+      return nullptr;
     }
   }
 
+  // Selects the shared weights cache for the subgraph of `context`, which
+  // kernels created by the next DelegatePrepare pack their weights into.
+  void SelectSharedWeightsCache(TfLiteContext* context) {
+    active_shared_weights_cache_ = nullptr;
+    // Weights unpacked by the delegate aren't shared between instances.
+    if (!use_shared_weights_cache() || !static_unpacked_data_.empty()) {
+      return;
+    }
+    const char* weights_begin = nullptr;
+    const char* weights_end = nullptr;
+    for (size_t t = 0; t < context->tensors_size; ++t) {
+      const TfLiteTensor& tensor = context->tensors[t];
+      if (tensor.allocation_type != kTfLiteMmapRo ||
+          tensor.data.raw_const == nullptr) {
+        continue;
+      }
+      const char* begin = tensor.data.raw_const;
+      const char* end = begin + tensor.bytes;
+      if (weights_begin == nullptr || begin < weights_begin) {
+        weights_begin = begin;
+      }
+      if (weights_end == nullptr || end > weights_end) {
+        weights_end = end;
+      }
+    }
+    if (weights_begin == nullptr) {
+      return;
+    }
+    std::shared_ptr<SharedWeightsCache> cache = GetSharedWeightsCache(
+        SharedWeightsCacheKey(weights_begin, weights_end, options_.flags));
+    if (cache == nullptr) {
+      TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                      "Failed to create a shared XNNPACK weights cache.");
+      return;
+    }
+    active_shared_weights_cache_ = cache.get();
+    shared_weights_caches_.push_back(std::move(cache));
+  }
+
+  // Makes the static weights of the subgraph of `context`, including the ones
+  // unpacked by the delegate, identifiable by the weight cache file.
+  void RegisterWeightCacheBuffers(TfLiteContext* context) {
+    if (weight_cache_file_ == nullptr) {
+      return;
+    }
+    for (size_t t = 0; t < context->tensors_size; ++t) {
+      const TfLiteTensor& tensor = context->tensors[t];
+      if (tensor.allocation_type == kTfLiteMmapRo &&
+          tensor.data.raw_const != nullptr) {
+        weight_cache_file_->RegisterBuffer(tensor.data.raw_const,
+                                           tensor.bytes);
+      }
+    }
+    for (const auto& [t, offset] : static_unpacked_data_map_) {
+      weight_cache_file_->RegisterBuffer(static_unpacked_data_.data() + offset,
+                                         context->tensors[t].bytes);
+    }
+  }
+
+  // Finalizes the weights caches, which must be done before the runtimes
+  // using them can be set up: the weight cache file is written, and the
+  // shared weights caches are soft-finalized.
+  bool FinalizeWeightsCaches() {
+    if (weight_cache_file_ != nullptr) {
+      // The cache is still usable if the file can't be written.
+      weight_cache_file_->Finalize();
+    }
+    if (shared_weights_caches_.empty()) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(SharedWeightsCacheMutex());
+    for (const std::shared_ptr<SharedWeightsCache>& cache :
+         shared_weights_caches_) {
+      if (!cache->finalized) {
+        cache->finalized =
+            TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(cache->cache);
+        if (!cache->finalized) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
   xnn_workspace_t workspace() const { return workspace_.get(); }
 
   TfLiteStatus AssociateVariableWithTensor(int local_id,
@@ -710,6 +926,13 @@ class Delegate {
   TfLiteXNNPackDelegateOptions options_{};
   VariableHolder variable_holder_;
   std::mutex workspace_mutex_;
+  // The shared weights caches of the delegated subgraphs, and the one of the
+  // subgraph being delegated.
+  std::vector<std::shared_ptr<SharedWeightsCache>> shared_weights_caches_;
+  SharedWeightsCache* active_shared_weights_cache_ = nullptr;
+  // The weights cache backed by options_.weight_cache_file_path, if any.
+  std::unique_ptr<MMapWeightCache> weight_cache_file_;
+  std::unique_ptr<xnn_weights_cache_provider> weight_cache_provider_;
 };
 
 class Subgraph {
@@ -1120,6 +1343,11 @@ class Subgraph {
   TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node,
                        bool enable_subgraph_reshaping, Delegate* delegate) {
     std::lock_guard<std::mutex> lock(delegate->workspace_mutex_);
+    if (!delegate->FinalizeWeightsCaches()) {
+      TF_LITE_KERNEL_LOG(context,
+                         "XNNPack delegate failed to finalize weights cache");
+      return kTfLiteError;
+    }
     if (enable_subgraph_reshaping) {
       xnn_status status = xnn_status_invalid_state;
       for (int i = 0; i < inputs_.size(); ++i) {
@@ -1175,15 +1403,26 @@ class Subgraph {
     }
   }
 
-  TfLiteStatus Invoke(TfLiteContext* context, bool enable_subgraph_reshaping,
-                      Delegate* delegate) {
+  // Runs the subgraph. `external_data`, if given, maps tensors to buffers
+  // to use in place of their TFLite data.
+  TfLiteStatus Invoke(
+      TfLiteContext* context, bool enable_subgraph_reshaping,
+      Delegate* delegate,
+      const std::unordered_map<int, void*>* external_data = nullptr) {
     std::lock_guard<std::mutex> lock(delegate->workspace_mutex_);
     bool any_pointers_changed = false;
     for (std::pair<int, void*> io_info : externals_) {
       const TfLiteTensor& tensor = context->tensors[io_info.first];
+      void* tensor_data = tensor.data.raw;
+      if (external_data != nullptr) {
+        auto it = external_data->find(io_info.first);
+        if (it != external_data->end()) {
+          tensor_data = it->second;
+        }
+      }
       void* data_pointer = &dummy_data_;
-      if (tensor.data.raw != nullptr) {
-        data_pointer = tensor.data.raw;
+      if (tensor_data != nullptr) {
+        data_pointer = tensor_data;
       } else {
         if (tensor.bytes != 0) {
           TF_LITE_KERNEL_LOG(
@@ -6712,6 +6951,431 @@ class Subgraph {
   Delegate* delegate_;
 };
 
+#if defined(__ANDROID__)
+using ::tflite::delegates::utils::BufferAttributes;
+using ::tflite::delegates::utils::BufferType;
+using ::tflite::delegates::utils::ReadBufferAttrs;
+using ::tflite::delegates::utils::ReadSyncAttrs;
+using ::tflite::delegates::utils::SyncAttributes;
+using ::tflite::delegates::utils::SyncType;
+using ::tflite::delegates::utils::WriteBufferAttrs;
+using ::tflite::delegates::utils::WriteSyncAttrs;
+using ::tflite::gpu::OptionalAndroidHardwareBuffer;
+
+// Runs a delegated subgraph for the async API, on AHardwareBuffers that are
+// mapped into CPU memory and bound to the XNNPACK runtime in place.
+//
+// Eval is synchronous. Locking the buffers for CPU access waits on the input
+// sync fences, and the fences from unlocking the output buffers are returned
+// as the output sync objects, for the next stage to wait on.
+class SubgraphAsyncKernel
+    : public ::tflite::delegates::BackendAsyncKernelInterface {
+ public:
+  explicit SubgraphAsyncKernel(Subgraph* subgraph) : subgraph_(subgraph) {}
+
+  Subgraph* subgraph() const { return subgraph_.get(); }
+
+  // Buffer operations
+  TfLiteStatus RegisterBuffer(TfLiteOpaqueContext* opaque_context,
+                              TfLiteIoType io_type,
+                              const TfLiteBackendBuffer* buffer,
+                              const TfLiteAttributeMap* attrs,
+                              TfLiteBufferHandle handle) override;
+  TfLiteStatus RegisterBufferSlice(TfLiteOpaqueContext* context,
+                                   TfLiteBufferHandle buffer_pool,
+                                   const TfLiteAttributeMap* attrs,
+                                   TfLiteBufferHandle handle) override {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                    "XNNPack delegate doesn't support buffer slices");
+    return kTfLiteError;
+  }
+  TfLiteStatus UnregisterBuffer(TfLiteOpaqueContext* opaque_context,
+                                TfLiteBufferHandle handle) override;
+
+  // Reconciliations
+  const std::vector<const char*>& SupportedBufferTypes(
+      TfLiteIoType io_type) const override {
+    return supported_buffer_types_;
+  }
+  const std::vector<const char*>& SupportedSynchronizations(
+      TfLiteIoType io_type) const override {
+    return supported_synchronizations_;
+  }
+  bool ReconcileRestrictions(const TfLiteOpaqueContext* opaque_context,
+                             const TfLiteOpaqueNode* opaque_node,
+                             int tensor_index,
+                             const TfLiteAttributeMap* user_provided_attributes,
+                             TfLiteAttributeMap* merged,
+                             TfLiteAttributeMap* conflict) const override;
+  TfLiteStatus SetAttributes(TfLiteOpaqueContext* opaque_context,
+                             TfLiteOpaqueNode* opaque_node, int tensor_index,
+                             const TfLiteAttributeMap* attrs) override;
+  TfLiteStatus SetBufferAttributes(const TfLiteBackendBuffer* buffer,
+                                   const TfLiteAttributeMap* attrs) override {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                    "XNNPack delegate doesn't support SetBufferAttributes");
+    return kTfLiteError;
+  }
+  TfLiteStatus GetBufferAttributes(const TfLiteBackendBuffer* buffer,
+                                   TfLiteAttributeMap* attrs) override;
+  TfLiteStatus Prepare(TfLiteOpaqueContext* opaque_context,
+                       TfLiteOpaqueNode* opaque_node) override {
+    return kTfLiteOk;
+  }
+
+  // Execution methods
+  TfLiteStatus Eval(TfLiteOpaqueContext* opaque_context,
+                    TfLiteOpaqueNode* opaque_node,
+                    TfLiteExecutionTask* task) override;
+  TfLiteStatus Wait(TfLiteOpaqueContext* opaque_context,
+                    TfLiteExecutionTask* task) override {
+    // Eval is synchronous, so Wait is a no-op.
+    return kTfLiteOk;
+  }
+  TfLiteStatus Finish(TfLiteOpaqueContext* opaque_context,
+                      TfLiteExecutionTask* task) override {
+    // Eval is synchronous, so Finish is a no-op.
+    return kTfLiteOk;
+  }
+
+ private:
+  using UniquePtrAHardwareBuffer =
+      std::unique_ptr<AHardwareBuffer, void (*)(AHardwareBuffer*)>;
+
+  struct RegisteredBuffer {
+    UniquePtrAHardwareBuffer ahwb;
+    // The usable size of the buffer, in bytes.
+    size_t size;
+  };
+
+  // A registered buffer for the duration of Eval.
+  struct LockedBuffer {
+    AHardwareBuffer* ahwb;
+    uint64_t usage;
+    // The fence to wait on before the CPU reads the buffer, or -1.
+    int fence;
+    void* data;
+  };
+
+  // Returns the size of a BLOB AHardwareBuffer, or 0 for other formats.
+  static size_t BlobSize(AHardwareBuffer* ahwb) {
+    AHardwareBuffer_Desc desc = {};
+    OptionalAndroidHardwareBuffer::Instance().Describe(ahwb, &desc);
+    return desc.format == AHARDWAREBUFFER_FORMAT_BLOB ? desc.width : 0;
+  }
+
+  static int FenceFd(TfLiteSynchronization* sync) {
+    if (sync == nullptr) {
+      return -1;
+    }
+    void* sync_obj = TfLiteSynchronizationGetPtr(sync);
+    if (sync_obj == nullptr) {
+      return -1;
+    }
+    return *(reinterpret_cast<int*>(sync_obj));
+  }
+
+  // Adds the buffer bound to `tensor_index` in `task`, if any, to `locked`.
+  TfLiteStatus AddTaskBuffer(
+      TfLiteContext* context, TfLiteExecutionTask* task, int tensor_index,
+      uint64_t usage, size_t extra_bytes,
+      std::unordered_map<TfLiteBufferHandle, LockedBuffer>& locked,
+      std::unordered_map<int, TfLiteBufferHandle>& handle_by_tensor);
+
+  std::unique_ptr<Subgraph> subgraph_;
+
+  const std::vector<const char*> supported_buffer_types_ = {
+      ::tflite::delegates::utils::kBufferTypeAHardwareBufferBlob};
+  const std::vector<const char*> supported_synchronizations_ = {
+      kTfLiteSyncTypeNoSyncObj,
+      ::tflite::delegates::utils::kSyncTypeSyncFenceFd};
+
+  std::mutex mutex_;
+  std::unordered_map<TfLiteBufferHandle, RegisteredBuffer> buffers_;
+  std::unordered_map<AHardwareBuffer*, BufferAttributes> attributes_by_buffer_;
+  std::unordered_map<int, SyncType> sync_type_by_tensor_index_;
+};
+
+TfLiteStatus SubgraphAsyncKernel::RegisterBuffer(
+    TfLiteOpaqueContext* opaque_context, TfLiteIoType io_type,
+    const TfLiteBackendBuffer* buffer, const TfLiteAttributeMap* attrs,
+    TfLiteBufferHandle handle) {
+  TFLITE_RET_CHECK_STATUS(
+      OptionalAndroidHardwareBuffer::Instance().Supported(),
+      "calling RegisterBuffer on device without AHardwareBuffer support");
+  TFLITE_RET_CHECK_STATUS(
+      attrs != nullptr && TfLiteAttributeMapIsBufferAttributeMap(attrs),
+      "calling RegisterBuffer with invalid attribute map type");
+  const BufferAttributes buffer_attrs = ReadBufferAttrs(attrs);
+  TFLITE_RET_CHECK_STATUS(
+      buffer_attrs.buffer_type.value_or(BufferType::kAHardwareBufferBlob) ==
+          BufferType::kAHardwareBufferBlob,
+      "calling RegisterBuffer with unsupported buffer type");
+  TFLITE_RET_CHECK_STATUS(buffer_attrs.offset.value_or(0) == 0,
+                          "calling RegisterBuffer with non-zero offset");
+
+  auto* ahwb =
+      reinterpret_cast<AHardwareBuffer*>(TfLiteBackendBufferGetPtr(buffer));
+  TFLITE_RET_CHECK_STATUS(ahwb != nullptr,
+                          "calling RegisterBuffer with nullptr buffer");
+  const size_t blob_size = BlobSize(ahwb);
+  TFLITE_RET_CHECK_STATUS(blob_size != 0,
+                          "calling RegisterBuffer with an AHardwareBuffer of "
+                          "format other than BLOB is not supported");
+  const size_t size = buffer_attrs.size.value_or(blob_size);
+  TFLITE_RET_CHECK_STATUS(size <= blob_size,
+                          "calling RegisterBuffer with buffer size larger "
+                          "than the actual AHardwareBuffer size");
+
+  OptionalAndroidHardwareBuffer::Instance().Acquire(ahwb);
+  UniquePtrAHardwareBuffer uptr_ahwb(ahwb, [](AHardwareBuffer* b) {
+    OptionalAndroidHardwareBuffer::Instance().Release(b);
+  });
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto [it, inserted] = buffers_.try_emplace(
+      handle, RegisteredBuffer{std::move(uptr_ahwb), size});
+  TFLITE_RET_CHECK_STATUS(inserted,
+                          "RegisterBuffer called with duplicate handle");
+  attributes_by_buffer_[ahwb] = buffer_attrs;
+  return kTfLiteOk;
+}
+
+TfLiteStatus SubgraphAsyncKernel::UnregisterBuffer(
+    TfLiteOpaqueContext* opaque_context, TfLiteBufferHandle handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = buffers_.find(handle);
+  TFLITE_RET_CHECK_STATUS(it != buffers_.end(),
+                          "UnregisterBuffer called with unknown handle");
+  attributes_by_buffer_.erase(it->second.ahwb.get());
+  buffers_.erase(it);
+  return kTfLiteOk;
+}
+
+bool SubgraphAsyncKernel::ReconcileRestrictions(
+    const TfLiteOpaqueContext* opaque_context,
+    const TfLiteOpaqueNode* opaque_node, int tensor_index,
+    const TfLiteAttributeMap* user_provided_attributes,
+    TfLiteAttributeMap* merged, TfLiteAttributeMap* conflict) const {
+  // The following cast is safe only because this code is part of the
+  // TF Lite runtime implementation.
+  const auto* context = reinterpret_cast<const TfLiteContext*>(opaque_context);
+  if (TfLiteAttributeMapIsBufferAttributeMap(user_provided_attributes)) {
+    if (!TfLiteAttributeMapIsBufferAttributeMap(merged)) {
+      return false;
+    }
+    const BufferAttributes user = ReadBufferAttrs(user_provided_attributes);
+    BufferAttributes merged_attrs{};
+    BufferAttributes conflict_attrs{};
+    bool ok = true;
+    if (user.buffer_type.value_or(BufferType::kAHardwareBufferBlob) !=
+        BufferType::kAHardwareBufferBlob) {
+      conflict_attrs.buffer_type = BufferType::kAHardwareBufferBlob;
+      ok = false;
+    }
+    if (user.offset.value_or(0) != 0) {
+      conflict_attrs.offset = 0;
+      ok = false;
+    }
+    merged_attrs.buffer_type = BufferType::kAHardwareBufferBlob;
+    merged_attrs.alignment = user.alignment;
+    merged_attrs.padding = user.padding;
+    // XNNPACK may read past the end of its inputs.
+    merged_attrs.size = std::max(user.size.value_or(0),
+                                 context->tensors[tensor_index].bytes +
+                                     static_cast<size_t>(XNN_EXTRA_BYTES));
+    WriteBufferAttrs(merged_attrs, merged);
+    if (conflict != nullptr &&
+        TfLiteAttributeMapIsBufferAttributeMap(conflict)) {
+      WriteBufferAttrs(conflict_attrs, conflict);
+    }
+    return ok;
+  }
+  if (TfLiteAttributeMapIsSyncAttributeMap(user_provided_attributes)) {
+    if (!TfLiteAttributeMapIsSyncAttributeMap(merged)) {
+      return false;
+    }
+    const SyncAttributes user = ReadSyncAttrs(user_provided_attributes);
+    SyncAttributes merged_attrs{};
+    SyncAttributes conflict_attrs{};
+    const SyncType sync_type = user.sync_type.value_or(SyncType::kNoSyncObj);
+    const bool ok = sync_type != SyncType::kUnknown;
+    merged_attrs.sync_type = ok ? sync_type : SyncType::kNoSyncObj;
+    if (!ok) {
+      conflict_attrs.sync_type = SyncType::kNoSyncObj;
+    }
+    WriteSyncAttrs(merged_attrs, merged);
+    if (conflict != nullptr && TfLiteAttributeMapIsSyncAttributeMap(conflict)) {
+      WriteSyncAttrs(conflict_attrs, conflict);
+    }
+    return ok;
+  }
+  TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "unknown type of user_provided_attributes");
+  return false;
+}
+
+TfLiteStatus SubgraphAsyncKernel::SetAttributes(
+    TfLiteOpaqueContext* opaque_context, TfLiteOpaqueNode* opaque_node,
+    int tensor_index, const TfLiteAttributeMap* attrs) {
+  // Only sync attributes affect the execution.
+  TFLITE_RET_CHECK_STATUS(
+      TfLiteAttributeMapIsSyncAttributeMap(attrs),
+      "calling SetAttributes with an invalid attribute map type");
+  const SyncAttributes sync_attrs = ReadSyncAttrs(attrs);
+  TFLITE_RET_CHECK_STATUS(
+      sync_attrs.sync_type.has_value() &&
+          sync_attrs.sync_type.value() != SyncType::kUnknown,
+      "calling SetAttributes with unknown sync object type");
+  std::lock_guard<std::mutex> lock(mutex_);
+  sync_type_by_tensor_index_[tensor_index] = sync_attrs.sync_type.value();
+  return kTfLiteOk;
+}
+
+TfLiteStatus SubgraphAsyncKernel::GetBufferAttributes(
+    const TfLiteBackendBuffer* buffer, TfLiteAttributeMap* attrs) {
+  TFLITE_RET_CHECK_STATUS(
+      attrs != nullptr && TfLiteAttributeMapIsBufferAttributeMap(attrs),
+      "calling GetBufferAttributes with an invalid attribute map type");
+  auto* ahwb =
+      reinterpret_cast<AHardwareBuffer*>(TfLiteBackendBufferGetPtr(buffer));
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = attributes_by_buffer_.find(ahwb);
+  TFLITE_RET_CHECK_STATUS(it != attributes_by_buffer_.end(),
+                          "Unable to find the buffer.");
+  WriteBufferAttrs(it->second, attrs);
+  return kTfLiteOk;
+}
+
+TfLiteStatus SubgraphAsyncKernel::AddTaskBuffer(
+    TfLiteContext* context, TfLiteExecutionTask* task, int tensor_index,
+    uint64_t usage, size_t extra_bytes,
+    std::unordered_map<TfLiteBufferHandle, LockedBuffer>& locked,
+    std::unordered_map<int, TfLiteBufferHandle>& handle_by_tensor) {
+  const TfLiteBufferHandle handle =
+      TfLiteExecutionTaskGetBufferByIndex(task, tensor_index);
+  if (handle < 0) {
+    // The tensor's own data is used.
+    return kTfLiteOk;
+  }
+  auto it = buffers_.find(handle);
+  TFLITE_RET_CHECK_STATUS(it != buffers_.end(),
+                          "Eval called with unknown buffer handle");
+  TFLITE_RET_CHECK_STATUS(
+      it->second.size >= context->tensors[tensor_index].bytes + extra_bytes,
+      "Eval called with buffer smaller than the tensor");
+  LockedBuffer& buffer =
+      locked
+          .try_emplace(handle,
+                       LockedBuffer{it->second.ahwb.get(), 0, -1, nullptr})
+          .first->second;
+  buffer.usage |= usage;
+  handle_by_tensor[tensor_index] = handle;
+  return kTfLiteOk;
+}
+
+TfLiteStatus SubgraphAsyncKernel::Eval(TfLiteOpaqueContext* opaque_context,
+                                       TfLiteOpaqueNode* opaque_node,
+                                       TfLiteExecutionTask* task) {
+  // The following cast is safe only because this code is part of the
+  // TF Lite runtime implementation.
+  auto* context = reinterpret_cast<TfLiteContext*>(opaque_context);
+  auto* node = reinterpret_cast<TfLiteNode*>(opaque_node);
+  TFLITE_RET_CHECK_STATUS(
+      OptionalAndroidHardwareBuffer::Instance().Supported(),
+      "calling Eval on device without AHardwareBuffer support");
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::unordered_map<TfLiteBufferHandle, LockedBuffer> locked;
+  std::unordered_map<int, TfLiteBufferHandle> handle_by_tensor;
+  // Fences that aren't waited on by locking a buffer.
+  std::vector<int> cpu_fences;
+  for (int i = 0; i < node->inputs->size; ++i) {
+    const int t = node->inputs->data[i];
+    if (t == kTfLiteOptionalTensor) continue;
+    TF_LITE_ENSURE_STATUS(AddTaskBuffer(
+        context, task, t, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN,
+        XNN_EXTRA_BYTES, locked, handle_by_tensor));
+    const int fence = FenceFd(TfLiteExecutionTaskGetSyncByIndex(task, t));
+    if (fence == -1) continue;
+    auto it = handle_by_tensor.find(t);
+    if (it != handle_by_tensor.end() && locked.at(it->second).fence == -1) {
+      locked.at(it->second).fence = fence;
+    } else {
+      cpu_fences.push_back(fence);
+    }
+  }
+  for (int i = 0; i < node->outputs->size; ++i) {
+    TF_LITE_ENSURE_STATUS(AddTaskBuffer(
+        context, task, node->outputs->data[i],
+        AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, 0, locked, handle_by_tensor));
+  }
+  TFLITE_RET_CHECK_STATUS(
+      ::tflite::delegates::utils::WaitForAllFds(cpu_fences).has_value(),
+      "wait for input fds");
+
+  // Locking waits on the fence, and takes ownership of it, so it's passed a
+  // duplicate of the task's.
+  TfLiteStatus status = kTfLiteOk;
+  std::vector<AHardwareBuffer*> to_unlock;
+  for (auto& [handle, buffer] : locked) {
+    const int fence = buffer.fence == -1 ? -1 : dup(buffer.fence);
+    if (OptionalAndroidHardwareBuffer::Instance().Lock(
+            buffer.ahwb, buffer.usage, fence, /*rect=*/nullptr,
+            &buffer.data) != 0) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "failed to lock AHardwareBuffer for CPU access");
+      status = kTfLiteError;
+      break;
+    }
+    to_unlock.push_back(buffer.ahwb);
+  }
+
+  if (status == kTfLiteOk) {
+    std::unordered_map<int, void*> external_data;
+    for (const auto& [tensor_index, handle] : handle_by_tensor) {
+      external_data[tensor_index] = locked.at(handle).data;
+    }
+    status = subgraph_->Invoke(context, subgraph_->EnableSubgraphReshaping(),
+                               subgraph_->GetDelegate(), &external_data);
+  }
+
+  // Unlocking a written buffer returns the fence to wait on before reading
+  // it, or -1 if it's readable already.
+  std::unordered_map<AHardwareBuffer*, int> output_fences;
+  for (AHardwareBuffer* ahwb : to_unlock) {
+    int fence = -1;
+    if (OptionalAndroidHardwareBuffer::Instance().Unlock(ahwb, &fence) != 0) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "failed to unlock AHardwareBuffer");
+      status = kTfLiteError;
+    }
+    output_fences[ahwb] = fence;
+  }
+  if (status == kTfLiteOk) {
+    for (int i = 0; i < node->outputs->size; ++i) {
+      const int t = node->outputs->data[i];
+      auto sync_type = sync_type_by_tensor_index_.find(t);
+      if (sync_type == sync_type_by_tensor_index_.end() ||
+          sync_type->second != SyncType::kSyncFenceFd) {
+        continue;
+      }
+      TfLiteSynchronization* sync = TfLiteExecutionTaskGetSyncByIndex(task, t);
+      if (sync == nullptr) continue;
+      int fence = -1;
+      auto handle = handle_by_tensor.find(t);
+      if (handle != handle_by_tensor.end()) {
+        fence = output_fences[locked.at(handle->second).ahwb];
+        fence = fence == -1 ? -1 : dup(fence);
+      }
+      TfLiteSynchronizationSetPtr(sync, new int{fence});
+      TfLiteExecutionTaskSetSyncByIndex(task, t, sync);
+    }
+  }
+  for (const auto& [ahwb, fence] : output_fences) {
+    if (fence != -1) close(fence);
+  }
+  return status;
+}
+#endif  // defined(__ANDROID__)
+
 TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   // Clear previous data, in case the delegate is reused without re-creation.
   static_unpacked_data_map_.clear();
@@ -7150,16 +7814,92 @@ const TfLiteRegistration kSubgraphRegistration = {
     /*.version=*/2,
 };
 
+#if defined(__ANDROID__)
+void* AsyncSubgraphInit(TfLiteContext* context, const char* buffer,
+                        size_t length) {
+  Subgraph* subgraph =
+      static_cast<Subgraph*>(SubgraphInit(context, buffer, length));
+  if (subgraph == nullptr) {
+    return nullptr;
+  }
+  return static_cast<void*>(new SubgraphAsyncKernel(subgraph));
+}
+
+TfLiteStatus AsyncSubgraphPrepare(TfLiteContext* context, TfLiteNode* node) {
+  if (node->user_data == nullptr) {
+    return kTfLiteError;
+  }
+
+  Subgraph* subgraph =
+      static_cast<SubgraphAsyncKernel*>(node->user_data)->subgraph();
+  return subgraph->Prepare(context, node, subgraph->EnableSubgraphReshaping(),
+                           subgraph->GetDelegate());
+}
+
+// The subgraph can still be invoked synchronously, on the TFLite tensors.
+TfLiteStatus AsyncSubgraphInvoke(TfLiteContext* context, TfLiteNode* node) {
+  if (node->user_data == nullptr) {
+    return kTfLiteError;
+  }
+
+  Subgraph* subgraph =
+      static_cast<SubgraphAsyncKernel*>(node->user_data)->subgraph();
+  return subgraph->Invoke(context, subgraph->EnableSubgraphReshaping(),
+                          subgraph->GetDelegate());
+}
+
+void AsyncSubgraphFree(TfLiteContext* context, void* buffer) {
+  if (buffer != nullptr) {
+    delete static_cast<SubgraphAsyncKernel*>(buffer);
+  }
+}
+
+TfLiteAsyncKernel* AsyncSubgraphAsyncKernel(TfLiteContext* context,
+                                            TfLiteNode* node) {
+  if (node->user_data == nullptr) {
+    return nullptr;
+  }
+  return static_cast<SubgraphAsyncKernel*>(node->user_data)->kernel();
+}
+
+const TfLiteRegistration kAsyncSubgraphRegistration = {
+    /*.init=*/AsyncSubgraphInit,
+    /*.free=*/AsyncSubgraphFree,
+    /*.prepare=*/AsyncSubgraphPrepare,
+    /*.invoke=*/AsyncSubgraphInvoke,
+    /*.profiling_string=*/nullptr,
+    /*.builtin_code=*/0,
+    /*.custom_name=*/"TfLiteXNNPackDelegate",
+    /*.version=*/2,
+    /*.registration_external=*/nullptr,
+    /*.async_kernel=*/AsyncSubgraphAsyncKernel,
+};
+#endif  // defined(__ANDROID__)
+
 TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate) {
+  auto* xnnpack_delegate =
+      static_cast<::tflite::xnnpack::Delegate*>(delegate->data_);
   TfLiteIntArray* ops_to_replace =
-      static_cast<::tflite::xnnpack::Delegate*>(delegate->data_)
-          ->PrepareOpsToDelegate(context);
+      xnnpack_delegate->PrepareOpsToDelegate(context);
   if (ops_to_replace == nullptr) {
     return kTfLiteError;
   }
+  xnnpack_delegate->SelectSharedWeightsCache(context);
+  xnnpack_delegate->RegisterWeightCacheBuffers(context);
 
+#if defined(__ANDROID__)
+  const TfLiteRegistration& registration = xnnpack_delegate->async_kernel()
+                                               ? kAsyncSubgraphRegistration
+                                               : kSubgraphRegistration;
+#else
+  if (xnnpack_delegate->async_kernel()) {
+    TFLITE_LOG_PROD_ONCE(TFLITE_LOG_WARNING,
+                         "XNNPack async kernel is only supported on Android.");
+  }
+  const TfLiteRegistration& registration = kSubgraphRegistration;
+#endif  // defined(__ANDROID__)
   const TfLiteStatus status = context->ReplaceNodeSubsetsWithDelegateKernels(
-      context, kSubgraphRegistration, ops_to_replace, delegate);
+      context, registration, ops_to_replace, delegate);
   TfLiteIntArrayFree(ops_to_replace);
   return status;
 }
@@ -45,6 +45,20 @@ extern "C" {
 // Enable XNNPack subgraph reshaping. This means that models with dynamic
 // tensors are supported and that inputs may be efficiently resized.
 #define TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING 0x00000080
+// Share packed weights with the other delegate instances in the process that
+// use this flag, when no weights_cache is set. Each subgraph gets a weights
+// cache keyed by its static weights buffers and the delegate flags, so that
+// interpreters created from the same model pack their weights only once. The
+// cache is soft-finalized when a delegated subgraph is first prepared, so
+// later instances must delegate the same operators. Ignored for subgraphs
+// with weights unpacked by the delegate, e.g. FP16 or sparse weights.
+#define TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHTS_CACHE 0x00000100
+// Implement the async kernel interface, for use with the async signature
+// runner (Android only). Inputs and outputs may then be AHardwareBuffers of
+// BLOB format, which are mapped into CPU memory and used without copies,
+// and sync fence fds are accepted on inputs and returned on outputs. The
+// delegated subgraph still runs synchronously with Invoke.
+#define TFLITE_XNNPACK_DELEGATE_FLAG_ASYNC_KERNEL 0x00000200
 
 struct TfLiteXNNPackDelegateWeightsCache;
 
@@ -61,6 +75,8 @@ typedef struct {
   // - TFLITE_XNNPACK_DELEGATE_FLAG_TRANSIENT_INDIRECTION_BUFFER
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_LATEST_OPERATORS
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING
+  // - TFLITE_XNNPACK_DELEGATE_FLAG_SHARED_WEIGHTS_CACHE
+  // - TFLITE_XNNPACK_DELEGATE_FLAG_ASYNC_KERNEL
   uint32_t flags;
   // Cache for packed weights, can be shared between multiple instances of
   // delegates.
@@ -70,6 +86,16 @@ typedef struct {
   bool handle_variable_ops;
   // Enable adaptive optimization for AVX CPUs.
   bool experimental_adaptive_avx_optimization;
+  // Path of a file to cache packed weights in, e.g. next to the model, when
+  // no weights_cache is set. The packed weights are written to the file when
+  // a delegated subgraph is first prepared, and later delegate instances map
+  // the file and use its packed weights in place instead of packing. Entries
+  // are keyed by fingerprints of the weights they were packed from, so a
+  // changed model is packed again and the file rewritten. The file must be
+  // deleted when the XNNPACK library changes, e.g. on an app update.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  const char* weight_cache_file_path;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
@@ -0,0 +1,182 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/c_api_types.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace resource {
+
+TfLiteStatus PagedCacheBuffer::Initialize(int num_blocks, int block_size,
+                                          int entry_size, TfLiteType type) {
+  const size_t type_size = TfLiteTypeGetSize(type);
+  if (num_blocks <= 0 || block_size <= 0 || entry_size <= 0 ||
+      type_size == 0) {
+    return kTfLiteError;
+  }
+  block_size_ = block_size;
+  entry_size_ = entry_size;
+  entry_bytes_ = type_size * entry_size;
+  block_bytes_ = entry_bytes_ * block_size;
+  keys_.assign(block_bytes_ * num_blocks, 0);
+  values_.assign(block_bytes_ * num_blocks, 0);
+  ref_counts_.assign(num_blocks, 0);
+  free_blocks_.clear();
+  // Hand out the blocks in order, lowest first.
+  for (int block = num_blocks - 1; block >= 0; --block) {
+    free_blocks_.push_back(block);
+  }
+  sequences_.clear();
+  return kTfLiteOk;
+}
+
+int PagedCacheBuffer::AllocateBlock() {
+  const int block = free_blocks_.back();
+  free_blocks_.pop_back();
+  ref_counts_[block] = 1;
+  return block;
+}
+
+void PagedCacheBuffer::ReleaseBlock(int block) {
+  if (--ref_counts_[block] == 0) {
+    free_blocks_.push_back(block);
+  }
+}
+
+TfLiteStatus PagedCacheBuffer::AddSequence(int sequence_id) {
+  if (!IsInitialized()) return kTfLiteError;
+  return sequences_.emplace(sequence_id, Sequence()).second ? kTfLiteOk
+                                                            : kTfLiteError;
+}
+
+TfLiteStatus PagedCacheBuffer::ForkSequence(int parent_id, int sequence_id) {
+  auto parent = sequences_.find(parent_id);
+  if (parent == sequences_.end() || sequences_.count(sequence_id)) {
+    return kTfLiteError;
+  }
+  // Copied first, as the insertion may invalidate `parent`.
+  Sequence sequence = parent->second;
+  for (int block : sequence.block_table) {
+    ++ref_counts_[block];
+  }
+  sequences_.emplace(sequence_id, std::move(sequence));
+  return kTfLiteOk;
+}
+
+void PagedCacheBuffer::RemoveSequence(int sequence_id) {
+  auto it = sequences_.find(sequence_id);
+  if (it == sequences_.end()) return;
+  for (int block : it->second.block_table) {
+    ReleaseBlock(block);
+  }
+  sequences_.erase(it);
+}
+
+TfLiteStatus PagedCacheBuffer::Append(int sequence_id, const void* keys,
+                                      const void* values, int num_entries) {
+  auto it = sequences_.find(sequence_id);
+  if (it == sequences_.end() || num_entries < 0) return kTfLiteError;
+  if (num_entries == 0) return kTfLiteOk;
+  Sequence& sequence = it->second;
+  std::vector<int>& block_table = sequence.block_table;
+
+  // A partly filled last block that other sequences share is copied before
+  // it's written to.
+  const int last_block_entries = sequence.num_entries % block_size_;
+  const bool copy_last_block =
+      last_block_entries > 0 && ref_counts_[block_table.back()] > 1;
+  const int num_total_entries = sequence.num_entries + num_entries;
+  const int num_new_blocks =
+      (num_total_entries + block_size_ - 1) / block_size_ -
+      static_cast<int>(block_table.size()) + (copy_last_block ? 1 : 0);
+  if (num_new_blocks > static_cast<int>(free_blocks_.size())) {
+    return kTfLiteError;
+  }
+
+  if (copy_last_block) {
+    const int shared = block_table.back();
+    const int block = AllocateBlock();
+    const size_t num_bytes = last_block_entries * entry_bytes_;
+    std::memcpy(GetKeyBlock(block), GetKeyBlock(shared), num_bytes);
+    std::memcpy(GetValueBlock(block), GetValueBlock(shared), num_bytes);
+    ReleaseBlock(shared);
+    block_table.back() = block;
+  }
+
+  const uint8_t* key_data = static_cast<const uint8_t*>(keys);
+  const uint8_t* value_data = static_cast<const uint8_t*>(values);
+  while (sequence.num_entries < num_total_entries) {
+    const int offset = sequence.num_entries % block_size_;
+    if (offset == 0) {
+      block_table.push_back(AllocateBlock());
+    }
+    const int count = std::min(block_size_ - offset,
+                               num_total_entries - sequence.num_entries);
+    const size_t num_bytes = count * entry_bytes_;
+    const size_t block_offset = offset * entry_bytes_;
+    const int block = block_table.back();
+    uint8_t* key_block = static_cast<uint8_t*>(GetKeyBlock(block));
+    uint8_t* value_block = static_cast<uint8_t*>(GetValueBlock(block));
+    std::memcpy(key_block + block_offset, key_data, num_bytes);
+    std::memcpy(value_block + block_offset, value_data, num_bytes);
+    key_data += num_bytes;
+    value_data += num_bytes;
+    sequence.num_entries += count;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus PagedCacheBuffer::Gather(int sequence_id, void* keys,
+                                      void* values) const {
+  auto it = sequences_.find(sequence_id);
+  if (it == sequences_.end()) return kTfLiteError;
+  const Sequence& sequence = it->second;
+  uint8_t* key_data = static_cast<uint8_t*>(keys);
+  uint8_t* value_data = static_cast<uint8_t*>(values);
+  int remaining = sequence.num_entries;
+  for (int block : sequence.block_table) {
+    const size_t num_bytes = std::min(remaining, block_size_) * entry_bytes_;
+    std::memcpy(key_data, GetKeyBlock(block), num_bytes);
+    std::memcpy(value_data, GetValueBlock(block), num_bytes);
+    key_data += num_bytes;
+    value_data += num_bytes;
+    remaining -= block_size_;
+  }
+  return kTfLiteOk;
+}
+
+int PagedCacheBuffer::GetNumEntries(int sequence_id) const {
+  auto it = sequences_.find(sequence_id);
+  return it == sequences_.end() ? -1 : it->second.num_entries;
+}
+
+const std::vector<int>* PagedCacheBuffer::GetBlockTable(
+    int sequence_id) const {
+  auto it = sequences_.find(sequence_id);
+  return it == sequences_.end() ? nullptr : &it->second.block_table;
+}
+
+}  // namespace resource
+}  // namespace tflite
@@ -0,0 +1,129 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/experimental/resource/resource_base.h"
+
+namespace tflite {
+namespace resource {
+
+/// WARNING: Experimental interface, subject to change.
+// A paged cache for the keys and values of a transformer attention mechanism,
+// shared by several decode sequences.
+//
+// Unlike CacheBuffer, which holds one contiguous buffer sized for the longest
+// context, the memory is split into fixed-size blocks of `block_size` entries,
+// each entry being `entry_size` elements (e.g. num_heads * head_dim). Each
+// sequence has a block table, mapping its entries to blocks in order, and
+// takes blocks from a shared pool as it grows. A forked sequence shares the
+// blocks of its parent, e.g. a common prompt, and a shared block is copied
+// only when one of the sequences appends to it.
+//
+// Attention kernels read the entries of a sequence through its block table:
+// entry `i` is at offset `(i % block_size) * entry_size` of block
+// `block_table[i / block_size]`.
+class PagedCacheBuffer : public ResourceBase {
+ public:
+  PagedCacheBuffer() = default;
+  PagedCacheBuffer(const PagedCacheBuffer&) = delete;
+  PagedCacheBuffer& operator=(const PagedCacheBuffer&) = delete;
+
+  // Allocates `num_blocks` blocks for the keys and as many for the values.
+  TfLiteStatus Initialize(int num_blocks, int block_size, int entry_size,
+                          TfLiteType type);
+
+  bool IsInitialized() override { return !keys_.empty(); }
+
+  size_t GetMemoryUsage() override { return keys_.size() + values_.size(); }
+
+  // Adds an empty sequence. Fails if the id is in use.
+  TfLiteStatus AddSequence(int sequence_id);
+
+  // Adds a sequence holding the same entries as `parent_id`, sharing its
+  // blocks.
+  TfLiteStatus ForkSequence(int parent_id, int sequence_id);
+
+  // Removes a sequence, returning the blocks no other sequence uses to the
+  // pool.
+  void RemoveSequence(int sequence_id);
+
+  // Appends `num_entries` entries to a sequence, copying them from `keys` and
+  // `values`, each `num_entries * entry_size` elements. Fails, leaving the
+  // sequence as is, if the pool hasn't enough free blocks.
+  TfLiteStatus Append(int sequence_id, const void* keys, const void* values,
+                      int num_entries);
+
+  // Copies the entries of a sequence into the contiguous `keys` and `values`,
+  // for kernels that don't read through the block table.
+  TfLiteStatus Gather(int sequence_id, void* keys, void* values) const;
+
+  // Returns the number of entries in a sequence, or -1 if there's none with
+  // that id.
+  int GetNumEntries(int sequence_id) const;
+
+  // Returns the block table of a sequence, or nullptr if there's none with
+  // that id.
+  const std::vector<int>* GetBlockTable(int sequence_id) const;
+
+  void* GetKeyBlock(int block) {
+    return keys_.data() + static_cast<size_t>(block) * block_bytes_;
+  }
+  void* GetValueBlock(int block) {
+    return values_.data() + static_cast<size_t>(block) * block_bytes_;
+  }
+  const void* GetKeyBlock(int block) const {
+    return keys_.data() + static_cast<size_t>(block) * block_bytes_;
+  }
+  const void* GetValueBlock(int block) const {
+    return values_.data() + static_cast<size_t>(block) * block_bytes_;
+  }
+
+  int GetNumFreeBlocks() const { return free_blocks_.size(); }
+  int block_size() const { return block_size_; }
+  int entry_size() const { return entry_size_; }
+
+ private:
+  struct Sequence {
+    std::vector<int> block_table;
+    int num_entries = 0;
+  };
+
+  // The block allocator: blocks are reference counted, so that forked
+  // sequences can share them, and free blocks are kept in a stack.
+  int AllocateBlock();
+  void ReleaseBlock(int block);
+
+  int block_size_ = 0;
+  int entry_size_ = 0;
+  size_t entry_bytes_ = 0;
+  size_t block_bytes_ = 0;
+  std::vector<uint8_t> keys_;
+  std::vector<uint8_t> values_;
+  std::vector<int> ref_counts_;
+  std::vector<int> free_blocks_;
+  std::unordered_map<int, Sequence> sequences_;
+};
+
+}  // namespace resource
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_PAGED_CACHE_BUFFER_H_
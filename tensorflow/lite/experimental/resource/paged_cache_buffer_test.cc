@@ -0,0 +1,152 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/resource/paged_cache_buffer.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace resource {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+// Entries of two floats, the key entry `i` being {i, i} and the value
+// {-i, -i}.
+void MakeEntries(int first, int num_entries, std::vector<float>* keys,
+                 std::vector<float>* values) {
+  keys->clear();
+  values->clear();
+  for (int i = first; i < first + num_entries; ++i) {
+    keys->insert(keys->end(), {1.0f * i, 1.0f * i});
+    values->insert(values->end(), {-1.0f * i, -1.0f * i});
+  }
+}
+
+TfLiteStatus AppendEntries(PagedCacheBuffer* cache, int sequence_id, int first,
+                           int num_entries) {
+  std::vector<float> keys, values;
+  MakeEntries(first, num_entries, &keys, &values);
+  return cache->Append(sequence_id, keys.data(), values.data(), num_entries);
+}
+
+void ExpectEntries(const PagedCacheBuffer& cache, int sequence_id, int first,
+                   int num_entries) {
+  ASSERT_EQ(cache.GetNumEntries(sequence_id), num_entries);
+  std::vector<float> keys(num_entries * 2), values(num_entries * 2);
+  ASSERT_EQ(cache.Gather(sequence_id, keys.data(), values.data()), kTfLiteOk);
+  std::vector<float> expected_keys, expected_values;
+  MakeEntries(first, num_entries, &expected_keys, &expected_values);
+  EXPECT_THAT(keys, ElementsAreArray(expected_keys));
+  EXPECT_THAT(values, ElementsAreArray(expected_values));
+}
+
+TEST(PagedCacheBufferTest, Initialize) {
+  PagedCacheBuffer cache;
+  EXPECT_FALSE(cache.IsInitialized());
+  EXPECT_EQ(cache.AddSequence(0), kTfLiteError);
+  ASSERT_EQ(cache.Initialize(8, 4, 2, kTfLiteFloat32), kTfLiteOk);
+  EXPECT_TRUE(cache.IsInitialized());
+  EXPECT_EQ(cache.GetMemoryUsage(), 2 * 8 * 4 * 2 * sizeof(float));
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 8);
+  EXPECT_EQ(cache.Initialize(0, 4, 2, kTfLiteFloat32), kTfLiteError);
+}
+
+TEST(PagedCacheBufferTest, GrowsByBlocks) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(8, 4, 2, kTfLiteFloat32), kTfLiteOk);
+  ASSERT_EQ(cache.AddSequence(7), kTfLiteOk);
+  EXPECT_EQ(cache.AddSequence(7), kTfLiteError);
+
+  ASSERT_EQ(AppendEntries(&cache, 7, 0, 3), kTfLiteOk);
+  EXPECT_THAT(*cache.GetBlockTable(7), ElementsAre(0));
+  ASSERT_EQ(AppendEntries(&cache, 7, 3, 6), kTfLiteOk);
+  EXPECT_THAT(*cache.GetBlockTable(7), ElementsAre(0, 1, 2));
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 5);
+  ExpectEntries(cache, 7, 0, 9);
+
+  // Entry 5 is the second of block 1.
+  const int block = (*cache.GetBlockTable(7))[1];
+  const float* key_block = static_cast<const float*>(cache.GetKeyBlock(block));
+  EXPECT_EQ(key_block[2], 5);
+
+  cache.RemoveSequence(7);
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 8);
+  EXPECT_EQ(cache.GetNumEntries(7), -1);
+  EXPECT_EQ(cache.GetBlockTable(7), nullptr);
+}
+
+TEST(PagedCacheBufferTest, FailsWhenOutOfBlocks) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(2, 4, 2, kTfLiteFloat32), kTfLiteOk);
+  ASSERT_EQ(cache.AddSequence(0), kTfLiteOk);
+  ASSERT_EQ(AppendEntries(&cache, 0, 0, 6), kTfLiteOk);
+  EXPECT_EQ(AppendEntries(&cache, 0, 6, 3), kTfLiteError);
+  ExpectEntries(cache, 0, 0, 6);
+  EXPECT_EQ(AppendEntries(&cache, 0, 6, 2), kTfLiteOk);
+  ExpectEntries(cache, 0, 0, 8);
+  EXPECT_EQ(AppendEntries(&cache, 1, 0, 1), kTfLiteError);
+}
+
+TEST(PagedCacheBufferTest, ForkSharesBlocks) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(8, 4, 2, kTfLiteFloat32), kTfLiteOk);
+  ASSERT_EQ(cache.AddSequence(0), kTfLiteOk);
+  // A prompt of a full block and a partly filled one.
+  ASSERT_EQ(AppendEntries(&cache, 0, 0, 6), kTfLiteOk);
+  ASSERT_EQ(cache.ForkSequence(0, 1), kTfLiteOk);
+  EXPECT_EQ(cache.ForkSequence(0, 1), kTfLiteError);
+  EXPECT_EQ(cache.ForkSequence(2, 3), kTfLiteError);
+  EXPECT_EQ(*cache.GetBlockTable(1), *cache.GetBlockTable(0));
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 6);
+
+  // Appending to the fork copies the partly filled block only.
+  ASSERT_EQ(AppendEntries(&cache, 1, 6, 1), kTfLiteOk);
+  EXPECT_THAT(*cache.GetBlockTable(0), ElementsAre(0, 1));
+  EXPECT_THAT(*cache.GetBlockTable(1), ElementsAre(0, 2));
+  ExpectEntries(cache, 1, 0, 7);
+  ExpectEntries(cache, 0, 0, 6);
+
+  // The parent now owns its last block, and writes to it in place.
+  ASSERT_EQ(AppendEntries(&cache, 0, 100, 1), kTfLiteOk);
+  EXPECT_THAT(*cache.GetBlockTable(0), ElementsAre(0, 1));
+  ExpectEntries(cache, 1, 0, 7);
+
+  cache.RemoveSequence(0);
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 6);
+  ExpectEntries(cache, 1, 0, 7);
+  cache.RemoveSequence(1);
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 8);
+}
+
+TEST(PagedCacheBufferTest, ForkOfFullBlocksCopiesNothing) {
+  PagedCacheBuffer cache;
+  ASSERT_EQ(cache.Initialize(8, 4, 2, kTfLiteFloat32), kTfLiteOk);
+  ASSERT_EQ(cache.AddSequence(0), kTfLiteOk);
+  ASSERT_EQ(AppendEntries(&cache, 0, 0, 8), kTfLiteOk);
+  ASSERT_EQ(cache.ForkSequence(0, 1), kTfLiteOk);
+  ASSERT_EQ(AppendEntries(&cache, 1, 8, 1), kTfLiteOk);
+  EXPECT_THAT(*cache.GetBlockTable(1), ElementsAre(0, 1, 2));
+  EXPECT_EQ(cache.GetNumFreeBlocks(), 5);
+  ExpectEntries(cache, 1, 0, 9);
+}
+
+}  // namespace
+}  // namespace resource
+}  // namespace tflite
@@ -88,6 +88,9 @@ LookupInterface* CreateStaticHashtable(TfLiteType key_type,
     return new StaticHashtable<std::int64_t, std::string>(key_type, value_type);
   } else if (key_type == kTfLiteString && value_type == kTfLiteInt64) {
     return new StaticHashtable<std::string, std::int64_t>(key_type, value_type);
+  } else if (key_type == kTfLiteInt64 && value_type == kTfLiteInt64) {
+    return new StaticHashtable<std::int64_t, std::int64_t>(key_type,
+                                                           value_type);
   }
   return nullptr;
 }
@@ -19,6 +19,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_INTERPRETER_OPTIONS_H_
 #define TENSORFLOW_LITE_INTERPRETER_OPTIONS_H_
 
+#include <cstddef>
+
 namespace tflite {
 
 /// Options class for `Interpreter`.
@@ -103,12 +105,138 @@ class InterpreterOptions {
     return experimental_cache_constant_cast_op_;
   }
 
+  // Lets the arena planner spend up to `value` microseconds, each time it
+  // plans the arena, searching for an allocation order that needs a smaller
+  // arena than the default greedy one. The default of zero disables the
+  // search.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanningTimeBudgetMicros(int value) {
+    experimental_arena_planning_time_budget_micros_ = value;
+  }
+
+  // Returns the time budget, in microseconds, of the arena planning search.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int GetArenaPlanningTimeBudgetMicros() const {
+    return experimental_arena_planning_time_budget_micros_;
+  }
+
+  // If set to `true`, `AllocateTensors` after `ResizeInputTensor` only
+  // prepares again the nodes that read a tensor whose shape changed, following
+  // the changes through the graph, as long as nothing else about the graph
+  // changed since the last `AllocateTensors`. Ops whose `Prepare` depends on
+  // anything other than their input tensors, such as the number of threads,
+  // are not prepared again when that changes.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetPrepareOnlyResizedNodes(bool value = true) {
+    experimental_prepare_only_resized_nodes_ = value;
+  }
+
+  // Returns if the `experimental_prepare_only_resized_nodes_` feature is
+  // enabled.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  bool GetPrepareOnlyResizedNodes() const {
+    return experimental_prepare_only_resized_nodes_;
+  }
+
+  // Runs independent nodes of a subgraph concurrently on up to `value`
+  // threads, when the subgraph has no delegates and no dynamic tensors and no
+  // profiler is set. Each thread gets its own CPU backend context, limited to
+  // an even share of the interpreter's threads. The kernels of the model must
+  // be safe to run concurrently, and the arena grows, as the tensors of the
+  // nodes that may run together can't share memory. The default of 1 runs one
+  // node at a time. Must be set before `AllocateTensors` is first called.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int value) {
+    experimental_num_inter_op_threads_ = value;
+  }
+
+  // Returns the number of threads that may run nodes concurrently.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  int GetNumInterOpThreads() const {
+    return experimental_num_inter_op_threads_;
+  }
+
+  // If set to `true`, a float32 RELU, RELU6 or RELU_N1_TO_1 node, or an ADD
+  // of a constant per-channel vector, that follows a CONV_2D,
+  // DEPTHWISE_CONV_2D or FULLY_CONNECTED node is fused into that node as its
+  // activation or bias, when it's the only reader of the node's output. The
+  // fused nodes are removed from the execution plan before it's first
+  // prepared, and the intermediate tensors are no longer written. Has no
+  // effect when all tensors are preserved.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetFuseBuiltinEpilogues(bool value = true) {
+    experimental_fuse_builtin_epilogues_ = value;
+  }
+
+  // Returns if the `experimental_fuse_builtin_epilogues_` feature is enabled.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  bool GetFuseBuiltinEpilogues() const {
+    return experimental_fuse_builtin_epilogues_;
+  }
+
+  // Streams the weights of a memory-mapped model whose constant tensors take
+  // more than `value` bytes: the weights of the next nodes are prefetched
+  // with madvise before they run, and the weights used the longest time ago
+  // are paged out while more than `value` bytes of them are resident. A model
+  // larger than the device memory can then run, at the cost of reading the
+  // weights from the file again. Only the weights read by the interpreter's
+  // own kernels are streamed, not the ones of delegated nodes. The default of
+  // zero disables streaming.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetWeightStreamingBudgetBytes(size_t value) {
+    experimental_weight_streaming_budget_bytes_ = value;
+  }
+
+  // Returns the resident weight budget, zero if weights aren't streamed.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  size_t GetWeightStreamingBudgetBytes() const {
+    return experimental_weight_streaming_budget_bytes_;
+  }
+
+  // If set to `true`, the float32 activations that are written and read only
+  // by the interpreter's own ADD, MUL, RESHAPE, SQUEEZE and EXPAND_DIMS
+  // kernels are stored in float16 instead, halving their memory and the
+  // bandwidth used to read and write them. The kernels still compute in
+  // float32. The inputs and outputs of the model, variables, and the tensors
+  // read or written by delegates keep their types. Has no effect when all
+  // tensors are preserved. Must be set before `AllocateTensors` is first
+  // called.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  void SetStoreActivationsInFloat16(bool value = true) {
+    experimental_store_activations_in_float16_ = value;
+  }
+
+  // Returns if the `experimental_store_activations_in_float16_` feature is
+  // enabled.
+  //
+  // WARNING: This is an experimental API and subject to change.
+  bool GetStoreActivationsInFloat16() const {
+    return experimental_store_activations_in_float16_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_ = false;
   bool experimental_ensure_dynamic_tensors_are_released_ = false;
   int experimental_optimize_memory_for_large_tensors_ = 0;
   bool experimental_disable_delegate_clustering_ = false;
   bool experimental_cache_constant_cast_op_ = false;
+  int experimental_arena_planning_time_budget_micros_ = 0;
+  bool experimental_prepare_only_resized_nodes_ = false;
+  int experimental_num_inter_op_threads_ = 1;
+  bool experimental_fuse_builtin_epilogues_ = false;
+  size_t experimental_weight_streaming_budget_bytes_ = 0;
+  bool experimental_store_activations_in_float16_ = false;
 };
 
 }  // namespace tflite
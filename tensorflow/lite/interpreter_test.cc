@@ -20,6 +20,10 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
@@ -1127,6 +1131,275 @@ TEST(BasicInterpreter, ReleaseDynamicTensors) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 6 * 6);
 }
 
+// Number of times the nodes of PrepareOnlyResizedNodes were prepared, by output
+// tensor.
+int g_num_prepares[6];
+
+TEST(BasicInterpreter, PrepareOnlyResizedNodes) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(6), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0, 1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3, 5}), kTfLiteOk);
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {2}, TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  std::fill(std::begin(g_num_prepares), std::end(g_num_prepares), 0);
+
+  // Ops whose output has the shape of their input, or a single element.
+  TfLiteRegistration copy_shape = {nullptr, nullptr, nullptr, nullptr};
+  copy_shape.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++g_num_prepares[node->outputs->data[0]];
+    const TfLiteTensor* input;
+    TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 0, &input));
+    TfLiteTensor* output;
+    TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(input->dims));
+  };
+  TfLiteRegistration reduce = {nullptr, nullptr, nullptr, nullptr};
+  reduce.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    ++g_num_prepares[node->outputs->data[0]];
+    TfLiteTensor* output;
+    TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+    TfLiteIntArray* dims = TfLiteIntArrayCreate(1);
+    dims->data[0] = 1;
+    return context->ResizeTensor(context, output, dims);
+  };
+  // 0 -> copy_shape -> 2 -> reduce -> 4 -> copy_shape -> 5
+  // 1 -> copy_shape -> 3
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr,
+                                              &copy_shape),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1}, {3}, nullptr, 0, nullptr,
+                                              &copy_shape),
+            kTfLiteOk);
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({2}, {4}, nullptr, 0, nullptr, &reduce),
+      kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({4}, {5}, nullptr, 0, nullptr,
+                                              &copy_shape),
+            kTfLiteOk);
+
+  InterpreterOptions options;
+  options.SetPrepareOnlyResizedNodes();
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(g_num_prepares[2], 1);
+  EXPECT_EQ(g_num_prepares[3], 1);
+  EXPECT_EQ(g_num_prepares[4], 1);
+  EXPECT_EQ(g_num_prepares[5], 1);
+
+  // Only the nodes along 0 are prepared again, up to where the shape stops
+  // changing.
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {8}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(g_num_prepares[2], 2);
+  EXPECT_EQ(g_num_prepares[3], 1);
+  EXPECT_EQ(g_num_prepares[4], 2);
+  EXPECT_EQ(g_num_prepares[5], 1);
+  EXPECT_EQ(interpreter.tensor(2)->bytes, 8 * sizeof(float));
+  EXPECT_EQ(interpreter.tensor(5)->bytes, sizeof(float));
+
+  // Anything else that makes the graph uninvokable prepares all nodes.
+  ASSERT_EQ(interpreter.ReleaseNonPersistentMemory(), kTfLiteOk);
+  ASSERT_EQ(interpreter.ResizeInputTensor(1, {4}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(g_num_prepares[2], 3);
+  EXPECT_EQ(g_num_prepares[3], 2);
+  EXPECT_EQ(g_num_prepares[4], 3);
+  EXPECT_EQ(g_num_prepares[5], 2);
+}
+
+// Number of the first two nodes of RunsIndependentNodesConcurrently that
+// started running, and that saw the other one running.
+std::atomic<int> g_num_started_nodes;
+std::atomic<int> g_num_nodes_seeing_both;
+
+TEST(BasicInterpreter, RunsIndependentNodesConcurrently) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(
+                  i, kTfLiteFloat32, "", {1}, TfLiteQuantizationParams()),
+              kTfLiteOk);
+  }
+  // Adds one to its first input and the others. The first two nodes wait for
+  // each other, so they only see each other if they run concurrently.
+  TfLiteRegistration add_one = {nullptr, nullptr, nullptr, nullptr};
+  add_one.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* output;
+    TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+    return context->ResizeTensor(context, output, TfLiteIntArrayCreate(1));
+  };
+  add_one.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    float sum = 1;
+    for (int i = 0; i < node->inputs->size; ++i) {
+      sum += GetInput(context, node, i)->data.f[0];
+    }
+    GetOutput(context, node, 0)->data.f[0] = sum;
+    if (node->inputs->size == 1) {
+      ++g_num_started_nodes;
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while (g_num_started_nodes < 2 &&
+             std::chrono::steady_clock::now() < deadline) {
+      }
+      if (g_num_started_nodes == 2) ++g_num_nodes_seeing_both;
+    }
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &add_one),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr,
+                                              &add_one),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1, 2}, {3}, nullptr, 0, nullptr,
+                                              &add_one),
+            kTfLiteOk);
+
+  InterpreterOptions options;
+  options.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  g_num_started_nodes = 0;
+  g_num_nodes_seeing_both = 0;
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(g_num_nodes_seeing_both, 2);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 5);
+}
+
+// Builds FULLY_CONNECTED, then ADD of a constant, then RELU, and runs them on
+// the input {1, -1}, with epilogue fusion enabled or not.
+void RunFullyConnectedAddRelu(bool fuse_epilogues,
+                              std::vector<float>* output, int* num_nodes) {
+  static const float filter[] = {1, 2, 3, 4, -5, 6};
+  static const float bias[] = {0.5, 0.5, 20};
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(6), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({5}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  ASSERT_EQ(interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "",
+                                                     {1, 2}, quant),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadOnly(
+                1, kTfLiteFloat32, "", {3, 2}, quant,
+                reinterpret_cast<const char*>(filter), sizeof(filter)),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.SetTensorParametersReadOnly(
+                2, kTfLiteFloat32, "", {3}, quant,
+                reinterpret_cast<const char*>(bias), sizeof(bias)),
+            kTfLiteOk);
+  for (int i = 3; i < 6; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1, 3}, quant),
+              kTfLiteOk);
+  }
+
+  auto* fc_params = static_cast<TfLiteFullyConnectedParams*>(
+      calloc(1, sizeof(TfLiteFullyConnectedParams)));
+  fc_params->activation = kTfLiteActNone;
+  ASSERT_EQ(interpreter.AddNodeWithParameters(
+                {0, 1, kTfLiteOptionalTensor}, {3}, nullptr, 0, fc_params,
+                ops::builtin::Register_FULLY_CONNECTED()),
+            kTfLiteOk);
+  auto* add_params =
+      static_cast<TfLiteAddParams*>(calloc(1, sizeof(TfLiteAddParams)));
+  add_params->activation = kTfLiteActNone;
+  ASSERT_EQ(interpreter.AddNodeWithParameters({2, 3}, {4}, nullptr, 0,
+                                              add_params,
+                                              ops::builtin::Register_ADD()),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({4}, {5}, nullptr, 0, nullptr,
+                                              ops::builtin::Register_RELU()),
+            kTfLiteOk);
+
+  InterpreterOptions options;
+  options.SetFuseBuiltinEpilogues(fuse_epilogues);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  interpreter.typed_tensor<float>(0)[1] = -1;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  const float* data = interpreter.typed_tensor<float>(5);
+  output->assign(data, data + 3);
+  *num_nodes = interpreter.execution_plan().size();
+}
+
+TEST(BasicInterpreter, FusesBuiltinEpilogues) {
+  std::vector<float> output;
+  int num_nodes;
+  RunFullyConnectedAddRelu(/*fuse_epilogues=*/false, &output, &num_nodes);
+  EXPECT_EQ(num_nodes, 3);
+  EXPECT_THAT(output, testing::ElementsAre(0, 0, 9));
+
+  RunFullyConnectedAddRelu(/*fuse_epilogues=*/true, &output, &num_nodes);
+  EXPECT_EQ(num_nodes, 1);
+  EXPECT_THAT(output, testing::ElementsAre(0, 0, 9));
+}
+
+TEST(BasicInterpreter, StoresActivationsInFloat16) {
+  static const float addend[] = {0.5, 1, 2};
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(5), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({4}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  ASSERT_EQ(interpreter.SetTensorParametersReadOnly(
+                1, kTfLiteFloat32, "", {3}, quant,
+                reinterpret_cast<const char*>(addend), sizeof(addend)),
+            kTfLiteOk);
+  for (int i : {0, 2, 3, 4}) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1, 3}, quant),
+              kTfLiteOk);
+  }
+  // 2 = ADD(0, 1), 3 = MUL(2, 2), and 4 = RELU(3).
+  auto* add_params =
+      static_cast<TfLiteAddParams*>(calloc(1, sizeof(TfLiteAddParams)));
+  add_params->activation = kTfLiteActNone;
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0, 1}, {2}, nullptr, 0,
+                                              add_params,
+                                              ops::builtin::Register_ADD()),
+            kTfLiteOk);
+  auto* mul_params =
+      static_cast<TfLiteMulParams*>(calloc(1, sizeof(TfLiteMulParams)));
+  mul_params->activation = kTfLiteActNone;
+  ASSERT_EQ(interpreter.AddNodeWithParameters({2, 2}, {3}, nullptr, 0,
+                                              mul_params,
+                                              ops::builtin::Register_MUL()),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({3}, {4}, nullptr, 0, nullptr,
+                                              ops::builtin::Register_RELU()),
+            kTfLiteOk);
+
+  InterpreterOptions options;
+  options.SetStoreActivationsInFloat16();
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  // Only the output of ADD is both written and read by nodes that support
+  // float16.
+  EXPECT_EQ(interpreter.tensor(2)->type, kTfLiteFloat16);
+  EXPECT_EQ(interpreter.tensor(2)->bytes, 3 * sizeof(uint16_t));
+  EXPECT_EQ(interpreter.tensor(3)->type, kTfLiteFloat32);
+  EXPECT_EQ(interpreter.tensor(4)->type, kTfLiteFloat32);
+
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  interpreter.typed_tensor<float>(0)[1] = -2;
+  interpreter.typed_tensor<float>(0)[2] = -0.5;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  const float* output = interpreter.typed_tensor<float>(4);
+  EXPECT_THAT(std::vector<float>(output, output + 3),
+              testing::ElementsAre(2.25, 1, 2.25));
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/float16_activations.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 #include "tensorflow/lite/kernels/internal/optimized/neon_check.h"
@@ -104,8 +105,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context,
                     GetOutputSafe(context, node, kOutputTensor, &output));
 
-  TF_LITE_ENSURE_TYPES_EQ(context, input1->type, input2->type);
-  output->type = input2->type;
+  if (HasFloat16(input1, input2, output)) {
+    // Activations stored in float16 are added in float32.
+    TF_LITE_ENSURE(context, AreFloat32OrFloat16(input1, input2, output));
+  } else {
+    TF_LITE_ENSURE_TYPES_EQ(context, input1->type, input2->type);
+    output->type = input2->type;
+  }
 
   const bool requires_broadcast = !HaveSameShapes(input1, input2);
 
@@ -417,6 +423,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_OK(context,
                     GetOutputSafe(context, node, kOutputTensor, &output));
 
+  if (HasFloat16(input1, input2, output)) {
+    return EvalFloat16Binary(context, input1, input2, output,
+                             params->activation,
+                             [](float a, float b) { return a + b; });
+  }
   if (output->type == kTfLiteFloat32 || output->type == kTfLiteInt32 ||
       output->type == kTfLiteInt64 ||
       (output->quantization.type == kTfLiteNoQuantization &&
@@ -39,7 +39,9 @@ limitations under the License.
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/densify.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -71,6 +73,10 @@ const int kTensorNotAllocated = -1;
 
 static constexpr size_t kMaxIm2colBufferSizeMobile = 1024 * 1024 * 1024;  // 1GB
 
+// The sparse kernel is only faster than the dense one when at most this
+// fraction of the filter is in non-zero blocks.
+static constexpr float kMaxSparseKernelDensity = 0.5f;
+
 struct OpData {
   // IDs are the arbitrary identifiers used by TF Lite to identify and access
   // memory buffers.
@@ -82,6 +88,7 @@ struct OpData {
   int accum_scratch_id = kTensorNotAllocated;
   // Row sums are used to cache filter sums for hybrid zero-point calculations.
   int row_sums_id = kTensorNotAllocated;
+  int densified_filter_id = kTensorNotAllocated;
 
   TfLitePaddingValues padding;
   // The scaling factor from input to output (aka the 'real multiplier') can
@@ -106,6 +113,7 @@ struct OpData {
   int32_t accum_scratch_index;
   int32_t input_offset_index;
   int32_t row_sums_index;
+  int32_t densified_filter_index;
 
   bool need_hwcn_weights = false;
   bool have_weights_been_transposed = false;
@@ -115,6 +123,16 @@ struct OpData {
   // >= kMaxIm2colBufferSize);
   bool im2col_oversized = false;
 
+  // A sparse filter either runs on the sparse kernel of fully connected layers,
+  // for 1x1 convolutions with a filter of 1x4 blocks, or is densified once.
+  // `sparse_fc_weights` is the sparsity of the filter as the
+  // [channels_out, channels_in] weights of a fully connected layer.
+  bool use_sparse_kernel = false;
+  TfLiteDimensionMetadata sparse_fc_dim_metadata[3];
+  TfLiteSparsity sparse_fc_weights;
+  bool need_densified_filter = false;
+  bool has_filter_been_densified = false;
+
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
@@ -217,6 +235,54 @@ bool IsIm2ColRequired(const TfLiteTensor* input, TfLiteConvParams* params,
   }
 }
 
+// Returns whether the sparse `filter` of a 1x1 convolution has 1x4 blocks along
+// the input channels, and sets `density` to the fraction of the filter in
+// non-zero blocks.
+bool IsSparse1x1FilterOf1x4Blocks(const TfLiteTensor* filter, float* density) {
+  const TfLiteSparsity& sparsity = *filter->sparsity;
+  const int channels_out = filter->dims->data[0];
+  const int channels_in = filter->dims->data[3];
+  if (filter->dims->data[1] != 1 || filter->dims->data[2] != 1 ||
+      channels_in % 4 != 0 || sparsity.dim_metadata_size != 5 ||
+      sparsity.traversal_order == nullptr ||
+      sparsity.traversal_order->size != 5 || sparsity.block_map == nullptr ||
+      sparsity.block_map->size != 1 || sparsity.block_map->data[0] != 3) {
+    return false;
+  }
+  for (int i = 0; i < 5; ++i) {
+    if (sparsity.traversal_order->data[i] != i) return false;
+  }
+  const TfLiteDimensionMetadata* dim_metadata = sparsity.dim_metadata;
+  if (dim_metadata[0].format != kTfLiteDimDense ||
+      dim_metadata[1].format != kTfLiteDimDense ||
+      dim_metadata[2].format != kTfLiteDimDense ||
+      dim_metadata[3].format != kTfLiteDimSparseCSR ||
+      dim_metadata[4].format != kTfLiteDimDense ||
+      dim_metadata[1].dense_size != 1 || dim_metadata[2].dense_size != 1 ||
+      dim_metadata[4].dense_size != 4) {
+    return false;
+  }
+  const TfLiteIntArray* segments = dim_metadata[3].array_segments;
+  const TfLiteIntArray* indices = dim_metadata[3].array_indices;
+  if (segments == nullptr || indices == nullptr ||
+      segments->size != channels_out + 1 || segments->data[0] != 0 ||
+      segments->data[channels_out] != indices->size ||
+      filter->bytes < indices->size * 4 * sizeof(float)) {
+    return false;
+  }
+  for (int i = 0; i < channels_out; ++i) {
+    if (segments->data[i] > segments->data[i + 1]) return false;
+  }
+  for (int i = 0; i < indices->size; ++i) {
+    if (indices->data[i] < 0 || indices->data[i] >= channels_in / 4) {
+      return false;
+    }
+  }
+  *density = static_cast<float>(indices->size) * 4 /
+             (static_cast<float>(channels_out) * channels_in);
+  return true;
+}
+
 // Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
@@ -277,6 +343,14 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(
     }
     ++temporaries_count;
   }
+  if (data->need_densified_filter) {
+    data->densified_filter_index = temporaries_count;
+    if (data->densified_filter_id == kTensorNotAllocated) {
+      TF_LITE_ENSURE_OK(context, context->AddTensors(
+                                     context, 1, &data->densified_filter_id));
+    }
+    ++temporaries_count;
+  }
 
   if (is_hybrid) {
     // Allocate tensor to store the on-the-fly quantized inputs.
@@ -441,6 +515,35 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) && !IsDynamicTensor(filter);
 
+  data->use_sparse_kernel = false;
+  data->need_densified_filter = false;
+  if (filter->sparsity != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, input_type, kTfLiteFloat32);
+    TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteFloat32);
+    TF_LITE_ENSURE(context, IsConstantTensor(filter));
+    // The multi-threaded kernel would transpose the compressed filter.
+    data->supports_multithreaded_kernel = false;
+    float density = 1;
+    data->use_sparse_kernel =
+        kernel_type != kReference && data->groups == 1 &&
+        params->stride_width == 1 && params->stride_height == 1 &&
+        IsSparse1x1FilterOf1x4Blocks(filter, &density) &&
+        density <= kMaxSparseKernelDensity;
+    if (data->use_sparse_kernel) {
+      const TfLiteDimensionMetadata* dim_metadata =
+          filter->sparsity->dim_metadata;
+      data->sparse_fc_dim_metadata[0] = dim_metadata[0];
+      data->sparse_fc_dim_metadata[1] = dim_metadata[3];
+      data->sparse_fc_dim_metadata[2] = dim_metadata[4];
+      data->sparse_fc_weights.traversal_order = nullptr;
+      data->sparse_fc_weights.block_map = nullptr;
+      data->sparse_fc_weights.dim_metadata = data->sparse_fc_dim_metadata;
+      data->sparse_fc_weights.dim_metadata_size = 3;
+    } else {
+      data->need_densified_filter = true;
+    }
+  }
+
   int channels_in = filter->dims->data[3];
   int channels_out = filter->dims->data[0];
   int width = input->dims->data[2];
@@ -553,6 +656,24 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     data->have_weights_been_transposed = false;
   }
 
+  if (data->need_densified_filter) {
+    node->temporaries->data[data->densified_filter_index] =
+        data->densified_filter_id;
+    TfLiteTensor* densified_filter;
+    TF_LITE_ENSURE_OK(
+        context, GetTemporarySafe(context, node, data->densified_filter_index,
+                                  &densified_filter));
+    densified_filter->type = kTfLiteFloat32;
+    densified_filter->name = "Conv_densified_filter";
+    densified_filter->allocation_type = kTfLiteArenaRwPersistent;
+    if (!TfLiteIntArrayEqual(densified_filter->dims, filter->dims)) {
+      TF_LITE_ENSURE_OK(
+          context, context->ResizeTensor(context, densified_filter,
+                                         TfLiteIntArrayCopy(filter->dims)));
+    }
+    data->has_filter_been_densified = false;
+  }
+
   if (is_hybrid) {
     node->temporaries->data[data->input_quantized_index] =
         data->input_quantized_id;
@@ -911,6 +1032,26 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
+  if (data->use_sparse_kernel) {
+    // A 1x1 convolution with unit strides is a fully connected layer applied
+    // to each pixel.
+    const int channels_in = SizeOfDimension(filter, 3);
+    const int channels_out = SizeOfDimension(filter, 0);
+    const int pixels = NumElements(input) / channels_in;
+    FullyConnectedParams op_params;
+    op_params.float_activation_min = output_activation_min;
+    op_params.float_activation_max = output_activation_max;
+    optimized_ops::FullyConnectedSparseWeight1x4(
+        data->sparse_fc_weights, op_params,
+        RuntimeShape({pixels, channels_in}), GetTensorData<float>(input),
+        RuntimeShape({channels_out, channels_in}),
+        GetTensorData<float>(filter), GetTensorShape(bias),
+        GetTensorData<float>(bias), RuntimeShape({pixels, channels_out}),
+        GetTensorData<float>(output),
+        CpuBackendContext::GetFromContext(context));
+    return;
+  }
+
   KernelType effective_kernel_type = kernel_type;
   // Fall back to the optimized path if multi-threaded conv is unsupported.
   if ((kernel_type == kMultithreadOptimized) &&
@@ -1212,6 +1353,20 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
+  if (data->need_densified_filter) {
+    TfLiteTensor* densified_filter =
+        &context
+             ->tensors[node->temporaries->data[data->densified_filter_index]];
+    if (!data->has_filter_been_densified) {
+      reference_ops::Densify(filter->sparsity, GetTensorShape(filter),
+                             GetTensorData<float>(filter),
+                             GetTensorShape(densified_filter),
+                             GetTensorData<float>(densified_filter), context);
+      data->has_filter_been_densified = true;
+    }
+    filter = densified_filter;
+  }
+
   if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
     TransposeFloatTensor(filter, hwcn_weights);
     data->have_weights_been_transposed = true;
@@ -473,6 +473,111 @@ TEST_P(ConvolutionOpTest, PointwiseFloat32) {
                              }));
 }
 
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input, const TensorData& filter,
+                           const std::vector<float>& filter_data,
+                           int stride_width = 1, int stride_height = 1) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    bias_ = AddInput({TensorType_FLOAT32, {filter.shape[0]}});
+    output_ = AddOutput({TensorType_FLOAT32, {}});
+
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID, stride_width,
+                                     stride_height)
+                     .Union());
+
+    resolver_ = std::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                   registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)});
+  }
+
+  void SetBias(std::initializer_list<float> f) { PopulateTensor(bias_, f); }
+
+  void SetInput(std::initializer_list<float> data) {
+    PopulateTensor(input_, data);
+  }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, SparsePointwise1x4Float32) {
+  // A third of the filter is in non-zero blocks, so the optimized kernels run
+  // on the sparse filter.
+  TensorData filter = {TensorType_FLOAT32, {3, 1, 1, 8}};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {3};
+  filter.block_size = {4};
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {1, 2, 2, 8}}, filter,
+                             {
+                                 1, 2, 3, 4, 0, 0,  0, 0,  // first filter
+                                 0, 0, 0, 0, 0, 0,  0, 0,  // second filter
+                                 0, 0, 0, 0, -1, 1, -1, 1,  // third filter
+                             });
+
+  m.SetInput({
+      1,  1,  1,  1,  1, 1, 1, 1,  // column = 1, row = 1
+      1,  2,  3,  4,  5, 6, 7, 8,  // column = 2, row = 1
+      0,  0,  0,  0,  1, 2, 3, 4,  // column = 1, row = 2
+      -1, -1, -1, -1, 2, 0, 0, 0,  // column = 2, row = 2
+  });
+  m.SetBias({1, 2, 3});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 11, 2, 3,  // column = 1, row = 1
+                                 31, 2, 5,  // column = 2, row = 1
+                                 1, 2, 5,   // column = 1, row = 2
+                                 -9, 2, 1,  // column = 2, row = 2
+                             }));
+}
+
+TEST_P(ConvolutionOpTest, SparseTestFloat32) {
+  // The filter isn't 1x1, so it is densified.
+  TensorData filter = {TensorType_FLOAT32, {3, 2, 2, 1}};
+  filter.traversal_order = {0, 1, 2, 3};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  SparseConvolutionOpModel m(GetRegistration(),
+                             {TensorType_FLOAT32, {2, 2, 4, 1}}, filter,
+                             {
+                                 1, 2, 3, 4,    // first 2x2 filter
+                                 -1, 0, -1, 0,  // second 2x2 filter
+                                 0, 0, 1, 1,    // third 2x2 filter
+                             },
+                             /*stride_width=*/2, /*stride_height=*/2);
+
+  m.SetInput({
+      // First batch
+      1, 1, 1, 1,  // row = 1
+      2, 2, 2, 2,  // row = 2
+      // Second batch
+      1, 2, 3, 4,  // row = 1
+      1, 2, 3, 4,  // row = 2
+  });
+  m.SetBias({1, 2, 3});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({
+                                 18, -1, 7,  // first batch, left
+                                 18, -1, 7,  // first batch, right
+                                 17, 0, 6,   // second batch, left
+                                 37, -4, 10,  // second batch, right
+                             }));
+}
+
 // TODO(alanchiao): this passes locally, but fails on continuous build system.
 // Re-enable when root cause found.
 TEST_P(ConvolutionOpTest, DISABLED_PointwiseMultifilterFloat32) {
@@ -135,6 +135,11 @@ CpuBackendContext::CpuBackendContext()
 #else
   SetUseCaching(false);
 #endif
+#ifdef TFLITE_WITH_GEMM_AUTOTUNING
+  SetUseGemmAutotuning(true);
+#else
+  SetUseGemmAutotuning(false);
+#endif
 }
 
 CpuBackendContext::~CpuBackendContext() {}
@@ -28,6 +28,7 @@ limitations under the License.
 #include "ruy/context.h"  // from @ruy
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_autotune_cache.h"
 
 namespace tflite {
 
@@ -54,6 +55,19 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
 
   bool use_caching() const { return use_caching_; }
 
+  // If set, cpu_backend_gemm::Gemm measures the candidate backends the first
+  // time it sees a GEMM shape, and then uses the fastest one for that shape.
+  // Has no effect on GEMMs that must use ruy, e.g. when caching is enabled.
+  void SetUseGemmAutotuning(bool flag) { use_gemm_autotuning_ = flag; }
+
+  bool use_gemm_autotuning() const { return use_gemm_autotuning_; }
+
+  // The backends chosen by autotuning, which may be saved and loaded so that
+  // later runs don't autotune again.
+  cpu_backend_gemm::GemmAutotuneCache* gemm_autotune_cache() {
+    return &gemm_autotune_cache_;
+  }
+
   pthreadpool_t get_xnnpack_threadpool();
 
   void ClearCaches() override { ruy_context_->ClearPrepackedCache(); }
@@ -118,6 +132,9 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   // (currently the Ruy library only).
   bool use_caching_;
 
+  bool use_gemm_autotuning_;
+  cpu_backend_gemm::GemmAutotuneCache gemm_autotune_cache_;
+
   // A smart pointer for the xnnpack threadpool. Is created by a call from the
   // interpreter, and then consumed by xnnpack, possibly via a TFLite kernel.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)>
@@ -16,10 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_H_
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstdint>
 
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_gemm_autotune_cache.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_custom_gemv.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_ruy.h"
@@ -109,6 +111,130 @@ struct GemmImpl<float, float, float, float, QuantizationFlavor::kFloatingPoint>
 
 #endif  // not TFLITE_WITH_RUY and TFLITE_X86_PLATFORM
 
+/* Autotuning between the backends */
+
+namespace detail {
+
+template <typename Scalar>
+struct AutotuneScalarCode;
+template <>
+struct AutotuneScalarCode<float> {
+  static constexpr int kValue = 1;
+};
+template <>
+struct AutotuneScalarCode<std::uint8_t> {
+  static constexpr int kValue = 2;
+};
+template <>
+struct AutotuneScalarCode<std::int8_t> {
+  static constexpr int kValue = 3;
+};
+template <>
+struct AutotuneScalarCode<std::int16_t> {
+  static constexpr int kValue = 4;
+};
+template <>
+struct AutotuneScalarCode<std::int32_t> {
+  static constexpr int kValue = 5;
+};
+
+// Identifies the types of a GEMM in GemmAutotuneCache::Key. The values are
+// persisted, so they must not change.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+constexpr int AutotuneTypeId() {
+  return AutotuneScalarCode<LhsScalar>::kValue |
+         AutotuneScalarCode<RhsScalar>::kValue << 4 |
+         AutotuneScalarCode<AccumScalar>::kValue << 8 |
+         AutotuneScalarCode<DstScalar>::kValue << 12 |
+         static_cast<int>(quantization_flavor) << 16;
+}
+
+// Runs the GEMM with `path`. Returns false if the path doesn't support it.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+bool RunGemmPath(
+    GemmPath path, const MatrixParams<LhsScalar>& lhs_params,
+    const LhsScalar* lhs_data, const MatrixParams<RhsScalar>& rhs_params,
+    const RhsScalar* rhs_data, const MatrixParams<DstScalar>& dst_params,
+    DstScalar* dst_data,
+    const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+    CpuBackendContext* context) {
+  switch (path) {
+    case GemmPath::kRuy:
+      GemmImplUsingRuy<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+                       quantization_flavor>::Run(lhs_params, lhs_data,
+                                                 rhs_params, rhs_data,
+                                                 dst_params, dst_data, params,
+                                                 context);
+      return true;
+    case GemmPath::kCustomGemv:
+      return dst_params.cols == 1 &&
+             CustomGemv(lhs_params, lhs_data, rhs_params, rhs_data,
+                        dst_params, dst_data, params, context);
+    case GemmPath::kDefault:
+      GemmImpl<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+               quantization_flavor>::Run(lhs_params, lhs_data, rhs_params,
+                                         rhs_data, dst_params, dst_data,
+                                         params, context);
+      return true;
+  }
+  return false;
+}
+
+// Runs the GEMM with the fastest path for its shape, types and number of
+// threads. The first time these are seen, every path runs the GEMM a few
+// times, and the fastest one is added to the context's autotune cache.
+template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
+          typename DstScalar, QuantizationFlavor quantization_flavor>
+void AutotunedGemm(
+    const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
+    const MatrixParams<RhsScalar>& rhs_params, const RhsScalar* rhs_data,
+    const MatrixParams<DstScalar>& dst_params, DstScalar* dst_data,
+    const GemmParams<AccumScalar, DstScalar, quantization_flavor>& params,
+    CpuBackendContext* context) {
+  constexpr int kNumTimedRuns = 3;
+  const GemmAutotuneCache::Key key = {
+      dst_params.rows, dst_params.cols, lhs_params.cols,
+      AutotuneTypeId<LhsScalar, RhsScalar, AccumScalar, DstScalar,
+                     quantization_flavor>(),
+      context->max_num_threads()};
+  GemmPath best_path;
+  if (!context->gemm_autotune_cache()->Lookup(key, &best_path)) {
+    ruy::profiler::ScopeLabel label("cpu_backend_gemm::Gemm: autotuning");
+    best_path = GemmPath::kDefault;
+    auto best_time = std::chrono::steady_clock::duration::max();
+    for (GemmPath path :
+         {GemmPath::kCustomGemv, GemmPath::kRuy, GemmPath::kDefault}) {
+      // The first run tells if the path supports the GEMM, and warms up the
+      // caches and the threads.
+      if (!RunGemmPath(path, lhs_params, lhs_data, rhs_params, rhs_data,
+                       dst_params, dst_data, params, context)) {
+        continue;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kNumTimedRuns; ++i) {
+        RunGemmPath(path, lhs_params, lhs_data, rhs_params, rhs_data,
+                    dst_params, dst_data, params, context);
+      }
+      const auto time = std::chrono::steady_clock::now() - start;
+      if (time < best_time) {
+        best_time = time;
+        best_path = path;
+      }
+    }
+    context->gemm_autotune_cache()->Insert(key, best_path);
+  }
+  // The result comes from the chosen path, as it will for later calls.
+  if (!RunGemmPath(best_path, lhs_params, lhs_data, rhs_params, rhs_data,
+                   dst_params, dst_data, params, context)) {
+    RunGemmPath(GemmPath::kDefault, lhs_params, lhs_data, rhs_params,
+                rhs_data, dst_params, dst_data, params, context);
+  }
+}
+
+}  // namespace detail
+
 /* Public entry point */
 
 template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
@@ -154,6 +280,11 @@ void Gemm(const MatrixParams<LhsScalar>& lhs_params, const LhsScalar* lhs_data,
                                                        params, context);
     return;
   }
+  if (context->use_gemm_autotuning()) {
+    detail::AutotunedGemm(lhs_params, lhs_data, rhs_params, rhs_data,
+                          dst_params, dst_data, params, context);
+    return;
+  }
   // If we did not choose to force usage of ruy above, then we may now consider
   // using custom GEMV code for the matrix*vector cases.
   const bool try_custom_gemv = (dst_params.cols == 1);
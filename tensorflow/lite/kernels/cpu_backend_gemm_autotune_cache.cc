@@ -0,0 +1,105 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/cpu_backend_gemm_autotune_cache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+
+namespace cpu_backend_gemm {
+
+namespace {
+
+// The first line of a saved cache.
+constexpr char kFileHeader[] = "tflite_gemm_autotune_cache 1";
+
+}  // namespace
+
+size_t GemmAutotuneCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = 0;
+  for (int value :
+       {key.rows, key.cols, key.depth, key.type, key.num_threads}) {
+    hash = hash * 31 + static_cast<size_t>(value);
+  }
+  return hash;
+}
+
+bool GemmAutotuneCache::Lookup(const Key& key, GemmPath* path) const {
+  auto it = paths_.find(key);
+  if (it == paths_.end()) {
+    return false;
+  }
+  *path = it->second;
+  return true;
+}
+
+void GemmAutotuneCache::Insert(const Key& key, GemmPath path) {
+  paths_[key] = path;
+}
+
+bool GemmAutotuneCache::Save(const std::string& path) const {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = std::fprintf(file, "%s\n", kFileHeader) > 0;
+  for (const auto& [key, gemm_path] : paths_) {
+    ok &= std::fprintf(file, "%d %d %d %d %d %d\n", key.rows, key.cols,
+                       key.depth, key.type, key.num_threads,
+                       static_cast<int>(gemm_path)) > 0;
+  }
+  ok &= std::fclose(file) == 0;
+  return ok;
+}
+
+bool GemmAutotuneCache::Load(const std::string& path) {
+  FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char header[sizeof(kFileHeader) + 1] = {};
+  bool ok = std::fgets(header, sizeof(header), file) != nullptr &&
+            std::string(header) == std::string(kFileHeader) + "\n";
+  // Entries are only added once the whole file was read.
+  std::vector<std::pair<Key, GemmPath>> entries;
+  while (ok) {
+    Key key;
+    int gemm_path;
+    const int num_read =
+        std::fscanf(file, "%d %d %d %d %d %d", &key.rows, &key.cols,
+                    &key.depth, &key.type, &key.num_threads, &gemm_path);
+    if (num_read == EOF) break;
+    ok = num_read == 6 && gemm_path >= 0 &&
+         gemm_path <= static_cast<int>(GemmPath::kCustomGemv);
+    entries.push_back({key, static_cast<GemmPath>(gemm_path)});
+  }
+  std::fclose(file);
+  if (!ok) {
+    return false;
+  }
+  for (const auto& [key, gemm_path] : entries) {
+    paths_[key] = gemm_path;
+  }
+  return true;
+}
+
+}  // namespace cpu_backend_gemm
+
+}  // namespace tflite
@@ -0,0 +1,80 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_AUTOTUNE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace tflite {
+
+namespace cpu_backend_gemm {
+
+// The implementations that cpu_backend_gemm::Gemm can choose from.
+// The values are persisted, so they must not change.
+enum class GemmPath : std::uint8_t {
+  // The backend of the platform, see GemmImpl in cpu_backend_gemm.h.
+  kDefault = 0,
+  kRuy = 1,
+  kCustomGemv = 2,
+};
+
+// The fastest GemmPath measured for each GEMM shape, type and number of
+// threads.
+class GemmAutotuneCache {
+ public:
+  struct Key {
+    int rows;
+    int cols;
+    int depth;
+    // Identifies the scalar types and quantization flavor.
+    int type;
+    int num_threads;
+
+    bool operator==(const Key& other) const {
+      return rows == other.rows && cols == other.cols &&
+             depth == other.depth && type == other.type &&
+             num_threads == other.num_threads;
+    }
+  };
+
+  // Returns true and sets `path` if `key` was autotuned.
+  bool Lookup(const Key& key, GemmPath* path) const;
+  void Insert(const Key& key, GemmPath path);
+
+  size_t size() const { return paths_.size(); }
+  void Clear() { paths_.clear(); }
+
+  // Writes the cache to the file at `path`, and adds the entries of such a
+  // file to the cache, so that later runs don't have to autotune again.
+  // Return false if the file can't be written or read, or is malformed.
+  bool Save(const std::string& path) const;
+  bool Load(const std::string& path);
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  std::unordered_map<Key, GemmPath, KeyHash> paths_;
+};
+
+}  // namespace cpu_backend_gemm
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_AUTOTUNE_CACHE_H_
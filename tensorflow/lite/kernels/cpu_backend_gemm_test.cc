@@ -366,12 +366,14 @@ void ReferenceGemm(
 template <typename LhsScalar, typename RhsScalar, typename AccumScalar,
           typename DstScalar>
 void TestSomeGemm(int rows, int depth, int cols,
-                  const std::vector<DstScalar>& golden) {
+                  const std::vector<DstScalar>& golden,
+                  bool use_autotuning = false) {
   CpuBackendContext cpu_backend_context;
   std::default_random_engine random_engine;
   cpu_backend_context.SetMaxNumThreads(1 + (random_engine() % 8));
   bool use_caching = static_cast<bool>(random_engine() % 2);
-  cpu_backend_context.SetUseCaching(use_caching);
+  cpu_backend_context.SetUseCaching(use_caching && !use_autotuning);
+  cpu_backend_context.SetUseGemmAutotuning(use_autotuning);
   const bool use_golden = !golden.empty();
 
   std::vector<LhsScalar> lhs_data;
@@ -627,6 +629,60 @@ TEST(CpuBackendGemmInvalidGemmTest, Float) {
 #endif
 }
 
+TEST(CpuBackendGemmSimpleTestAgainstGolden, FloatAutotuned) {
+  TestSomeGemm<float, float, float, float>(2, 3, 4,
+                                           {15, 34, 33, 79, 51, 124, 69, 169},
+                                           /*use_autotuning=*/true);
+}
+
+TEST(CpuBackendGemmAutotuneTest, CachesAndPersistsChoices) {
+  CpuBackendContext cpu_backend_context;
+  cpu_backend_context.SetUseGemmAutotuning(true);
+  std::vector<float> lhs_data(8 * 16, 1.0f);
+  std::vector<float> rhs_data(16, 2.0f);
+  std::vector<float> dst_data(8);
+  MatrixParams<float> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = 8;
+  lhs_params.cols = 16;
+  MatrixParams<float> rhs_params;
+  rhs_params.order = cpu_backend_gemm::Order::kColMajor;
+  rhs_params.rows = 16;
+  rhs_params.cols = 1;
+  MatrixParams<float> dst_params;
+  dst_params.order = cpu_backend_gemm::Order::kColMajor;
+  dst_params.rows = 8;
+  dst_params.cols = 1;
+  GemmParams<float, float> params;
+  for (int i = 0; i < 2; ++i) {
+    Gemm(lhs_params, lhs_data.data(), rhs_params, rhs_data.data(), dst_params,
+         dst_data.data(), params, &cpu_backend_context);
+    for (float value : dst_data) {
+      EXPECT_EQ(value, 32.0f);
+    }
+  }
+  cpu_backend_gemm::GemmAutotuneCache* cache =
+      cpu_backend_context.gemm_autotune_cache();
+  ASSERT_EQ(cache->size(), 1);
+
+  const std::string path = testing::TempDir() + "/gemm_autotune_cache";
+  ASSERT_TRUE(cache->Save(path));
+  cpu_backend_gemm::GemmAutotuneCache loaded_cache;
+  ASSERT_TRUE(loaded_cache.Load(path));
+  EXPECT_EQ(loaded_cache.size(), 1);
+  cpu_backend_gemm::GemmAutotuneCache::Key key = {
+      8, 1, 16,
+      cpu_backend_gemm::detail::AutotuneTypeId<
+          float, float, float, float, QuantizationFlavor::kFloatingPoint>(),
+      cpu_backend_context.max_num_threads()};
+  cpu_backend_gemm::GemmPath cached_path, loaded_path;
+  ASSERT_TRUE(cache->Lookup(key, &cached_path));
+  ASSERT_TRUE(loaded_cache.Lookup(key, &loaded_path));
+  EXPECT_EQ(loaded_path, cached_path);
+  key.cols = 2;
+  EXPECT_FALSE(loaded_cache.Lookup(key, &loaded_path));
+}
+
 TEST(CpuBackendGemmSimpleTestAgainstGolden, Int8Int16) {
   TestSomeGemm<std::int8_t, std::int8_t, std::int32_t, std::int16_t>(
       3, 5, 4, {19, 48, 77, 48, 149, 250, 76, 249, 422, 105, 350, 595});
@@ -642,7 +698,8 @@ struct TypesTuple {
 };
 
 template <typename TypesTupleType>
-void TestRandomGemms(const std::vector<std::tuple<int, int, int>>& shapes) {
+void TestRandomGemms(const std::vector<std::tuple<int, int, int>>& shapes,
+                     bool use_autotuning = false) {
   using LhsScalar = typename TypesTupleType::LhsScalar;
   using RhsScalar = typename TypesTupleType::RhsScalar;
   using AccumScalar = typename TypesTupleType::AccumScalar;
@@ -651,8 +708,8 @@ void TestRandomGemms(const std::vector<std::tuple<int, int, int>>& shapes) {
     int rows = std::get<0>(shape);
     int depth = std::get<1>(shape);
     int cols = std::get<2>(shape);
-    TestSomeGemm<LhsScalar, RhsScalar, AccumScalar, DstScalar>(rows, depth,
-                                                               cols, {});
+    TestSomeGemm<LhsScalar, RhsScalar, AccumScalar, DstScalar>(
+        rows, depth, cols, {}, use_autotuning);
   }
 }
 
@@ -742,6 +799,15 @@ TYPED_TEST(CpuBackendGemmTest, InnerProduct) {
   TestRandomGemms<TypeParam>(shapes);
 }
 
+TYPED_TEST(CpuBackendGemmTest, Autotuned) {
+  std::vector<std::tuple<int, int, int>> shapes;
+  for (int size = 1; size < 50; size += 7) {
+    shapes.push_back(std::make_tuple(size, size, 1));
+    shapes.push_back(std::make_tuple(size, size + 3, size + 1));
+  }
+  TestRandomGemms<TypeParam>(shapes, /*use_autotuning=*/true);
+}
+
 TYPED_TEST(CpuBackendGemmTest, OuterProduct) {
   std::vector<std::tuple<int, int, int>> shapes;
   for (int size = 1; size < 100; size++) {
@@ -0,0 +1,166 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_FLOAT16_ACTIVATIONS_H_
+#define TENSORFLOW_LITE_KERNELS_FLOAT16_ACTIVATIONS_H_
+
+#include <algorithm>
+#include <initializer_list>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "tensorflow/lite/core/c/builtin_op_data.h"
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/runtime_shape.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace ops {
+namespace builtin {
+
+// The interpreter may store the float activations read and written by some
+// kernels in float16, see `InterpreterOptions::SetStoreActivationsInFloat16`.
+// These kernels compute in float32, converting each value as it's read or
+// written, so that their inputs and outputs may have either type.
+
+// True if any of the tensors has float16 values.
+inline bool HasFloat16(const TfLiteTensor* input1, const TfLiteTensor* input2,
+                       const TfLiteTensor* output) {
+  return input1->type == kTfLiteFloat16 || input2->type == kTfLiteFloat16 ||
+         output->type == kTfLiteFloat16;
+}
+
+// True if all the tensors have float32 or float16 values.
+inline bool AreFloat32OrFloat16(const TfLiteTensor* input1,
+                                const TfLiteTensor* input2,
+                                const TfLiteTensor* output) {
+  for (const TfLiteTensor* tensor : {input1, input2, output}) {
+    if (tensor->type != kTfLiteFloat32 && tensor->type != kTfLiteFloat16) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace float16_activations {
+
+inline float ToFloat(float value) { return value; }
+inline float ToFloat(Eigen::half value) {
+  return Eigen::half_impl::half_to_float(value);
+}
+
+template <typename T>
+T FromFloat(float value);
+template <>
+inline float FromFloat<float>(float value) {
+  return value;
+}
+template <>
+inline Eigen::half FromFloat<Eigen::half>(float value) {
+  return Eigen::half_impl::float_to_half_rtne(value);
+}
+
+template <typename R, typename T1, typename T2, typename Op>
+void BroadcastBinary(const TfLiteTensor* input1, const TfLiteTensor* input2,
+                     TfLiteTensor* output, float activation_min,
+                     float activation_max, Op op) {
+  constexpr int kMaxDims = 6;
+  const RuntimeShape output_shape =
+      RuntimeShape::ExtendedShape(kMaxDims, GetTensorShape(output));
+  NdArrayDesc<kMaxDims> desc1;
+  NdArrayDesc<kMaxDims> desc2;
+  NdArrayDescsForElementwiseBroadcast(GetTensorShape(input1),
+                                      GetTensorShape(input2), &desc1, &desc2);
+  const T1* input1_data = GetTensorData<T1>(input1);
+  const T2* input2_data = GetTensorData<T2>(input2);
+  R* output_data = GetTensorData<R>(output);
+  const int flat_size = output_shape.FlatSize();
+  int subscript[kMaxDims] = {};
+  int index1 = 0;
+  int index2 = 0;
+  for (int i = 0; i < flat_size; ++i) {
+    const float value =
+        op(ToFloat(input1_data[index1]), ToFloat(input2_data[index2]));
+    output_data[i] = FromFloat<R>(
+        std::min(std::max(value, activation_min), activation_max));
+    // Moves to the next output element, innermost dimension first.
+    for (int d = kMaxDims - 1; d >= 0; --d) {
+      index1 += desc1.strides[d];
+      index2 += desc2.strides[d];
+      if (++subscript[d] < output_shape.Dims(d)) break;
+      index1 -= desc1.strides[d] * subscript[d];
+      index2 -= desc2.strides[d] * subscript[d];
+      subscript[d] = 0;
+    }
+  }
+}
+
+template <typename R, typename T1, typename Op>
+void DispatchInput2Type(const TfLiteTensor* input1,
+                        const TfLiteTensor* input2, TfLiteTensor* output,
+                        float activation_min, float activation_max, Op op) {
+  if (input2->type == kTfLiteFloat16) {
+    BroadcastBinary<R, T1, Eigen::half>(input1, input2, output, activation_min,
+                                        activation_max, op);
+  } else {
+    BroadcastBinary<R, T1, float>(input1, input2, output, activation_min,
+                                  activation_max, op);
+  }
+}
+
+template <typename R, typename Op>
+void DispatchInput1Type(const TfLiteTensor* input1,
+                        const TfLiteTensor* input2, TfLiteTensor* output,
+                        float activation_min, float activation_max, Op op) {
+  if (input1->type == kTfLiteFloat16) {
+    DispatchInput2Type<R, Eigen::half>(input1, input2, output, activation_min,
+                                       activation_max, op);
+  } else {
+    DispatchInput2Type<R, float>(input1, input2, output, activation_min,
+                                 activation_max, op);
+  }
+}
+
+}  // namespace float16_activations
+
+// Computes `op(input1, input2)` elementwise, with broadcasting, and applies
+// `activation`. Each tensor may have float32 or float16 values, and up to 6
+// dimensions.
+template <typename Op>
+TfLiteStatus EvalFloat16Binary(TfLiteContext* context,
+                               const TfLiteTensor* input1,
+                               const TfLiteTensor* input2, TfLiteTensor* output,
+                               TfLiteFusedActivation activation, Op op) {
+  TF_LITE_ENSURE(context, AreFloat32OrFloat16(input1, input2, output));
+  TF_LITE_ENSURE(context, NumDimensions(input1) <= 6);
+  TF_LITE_ENSURE(context, NumDimensions(input2) <= 6);
+  TF_LITE_ENSURE(context, NumDimensions(output) <= 6);
+  float activation_min, activation_max;
+  CalculateActivationRange(activation, &activation_min, &activation_max);
+  if (output->type == kTfLiteFloat16) {
+    float16_activations::DispatchInput1Type<Eigen::half>(
+        input1, input2, output, activation_min, activation_max, op);
+  } else {
+    float16_activations::DispatchInput1Type<float>(
+        input1, input2, output, activation_min, activation_max, op);
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace builtin
+}  // namespace ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_FLOAT16_ACTIVATIONS_H_
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/4bit/blockwise_fully_connected.h"
 #include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
@@ -353,6 +354,83 @@ TfLiteStatus PrepareImpl4Bit(TfLiteContext* context, TfLiteNode* node,
                           cols);
 }
 
+// Returns the quantization of `filter` if it's quantized in blocks, nullptr
+// otherwise.
+const TfLiteBlockwiseQuantization* GetBlockwiseQuantization(
+    const TfLiteTensor* filter) {
+  if (filter->quantization.type != kTfLiteBlockwiseQuantization) {
+    return nullptr;
+  }
+  return reinterpret_cast<const TfLiteBlockwiseQuantization*>(
+      filter->quantization.params);
+}
+
+// Prepares a node with float inputs and outputs, and int4 weights that are
+// symmetrically quantized in blocks along the depth. The weights are
+// dequantized on the fly by optimized_4bit::BlockwiseFullyConnected.
+TfLiteStatus PrepareBlockwise(TfLiteContext* context, TfLiteNode* node) {
+  auto* params =
+      reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data);
+  TF_LITE_ENSURE(context, node->inputs->size == 2 || node->inputs->size == 3);
+  TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
+  TF_LITE_ENSURE_EQ(context, params->weights_format,
+                    kTfLiteFullyConnectedWeightsFormatDefault);
+  TF_LITE_ENSURE(context, params->activation == kTfLiteActNone ||
+                              params->activation == kTfLiteActRelu ||
+                              params->activation == kTfLiteActReluN1To1 ||
+                              params->activation == kTfLiteActRelu6);
+
+  const TfLiteTensor* input;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputTensor, &input));
+  const TfLiteTensor* filter;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kWeightsTensor, &filter));
+  const TfLiteTensor* bias =
+      (node->inputs->size == 3)
+          ? GetOptionalInputTensor(context, node, kBiasTensor)
+          : nullptr;
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt4);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(filter), 2);
+  TF_LITE_ENSURE(context, filter->sparsity == nullptr);
+  const int num_units = SizeOfDimension(filter, 0);
+  const int depth = SizeOfDimension(filter, 1);
+  if (bias) {
+    TF_LITE_ENSURE_TYPES_EQ(context, bias->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_EQ(context, NumElements(bias), num_units);
+  }
+
+  const TfLiteBlockwiseQuantization* quantization =
+      GetBlockwiseQuantization(filter);
+  TF_LITE_ENSURE(context, quantization);
+  TF_LITE_ENSURE_EQ(context, quantization->quantized_dimension, 1);
+  TF_LITE_ENSURE_MSG(context, quantization->zero_point == -1,
+                     "Only symmetric blockwise quantization is supported.");
+  // Each block starts on a byte of the packed weights.
+  const int blocksize = quantization->blocksize;
+  TF_LITE_ENSURE(context, blocksize > 0 && blocksize % 2 == 0);
+  TF_LITE_ENSURE(context, depth > 0);
+  TF_LITE_ENSURE_EQ(context, depth % blocksize, 0);
+  TF_LITE_ENSURE(context, quantization->scale >= 0 &&
+                              quantization->scale < context->tensors_size);
+  const TfLiteTensor* scales = &context->tensors[quantization->scale];
+  TF_LITE_ENSURE_TYPES_EQ(context, scales->type, kTfLiteFloat32);
+  TF_LITE_ENSURE(context, IsConstantTensor(scales));
+  TF_LITE_ENSURE_EQ(context, NumDimensions(scales), 2);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(scales, 0), num_units);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(scales, 1), depth / blocksize);
+
+  const int input_size = NumElements(input);
+  TF_LITE_ENSURE_EQ(context, input_size % depth, 0);
+  return UpdateOutputSize(context, params, input, output, input_size / depth,
+                          num_units, depth);
+}
+
 TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node,
                          KernelType kernel_type) {
   auto* params =
@@ -645,6 +723,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const bool is_hybrid = is_quantized && (input->type == kTfLiteFloat32);
   const bool is_pie = kernel_type == kLegacyPie;
 
+  if (GetBlockwiseQuantization(filter)) {
+    return PrepareBlockwise(context, node);
+  }
+
   // Pie and hybrid path supports all kinds of fused activations, otherwise only
   // clipping activations are supported.
   if (!is_pie && !is_hybrid) {
@@ -1591,6 +1673,33 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+template <KernelType kernel_type>
+TfLiteStatus EvalBlockwise(TfLiteContext* context, TfLiteNode* node,
+                           TfLiteFullyConnectedParams* params,
+                           const TfLiteTensor* input,
+                           const TfLiteTensor* filter, const TfLiteTensor* bias,
+                           TfLiteTensor* output) {
+  const TfLiteBlockwiseQuantization* quantization =
+      GetBlockwiseQuantization(filter);
+  const TfLiteTensor* scales = &context->tensors[quantization->scale];
+  const int num_units = SizeOfDimension(filter, 0);
+  const int depth = SizeOfDimension(filter, 1);
+  float output_activation_min, output_activation_max;
+  CalculateActivationRange(params->activation, &output_activation_min,
+                           &output_activation_max);
+  const auto blockwise_fully_connected =
+      kernel_type == kReference
+          ? optimized_4bit::BlockwiseFullyConnectedReference
+          : optimized_4bit::BlockwiseFullyConnected;
+  blockwise_fully_connected(
+      GetTensorData<float>(input), NumElements(input) / depth, depth,
+      GetTensorData<int8_t>(filter), GetTensorData<float>(scales),
+      quantization->blocksize, num_units,
+      bias ? GetTensorData<float>(bias) : nullptr, output_activation_min,
+      output_activation_max, GetTensorData<float>(output));
+  return kTfLiteOk;
+}
+
 template <KernelType kernel_type>
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
@@ -1619,6 +1728,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteOk;
   }
 
+  if (GetBlockwiseQuantization(filter)) {
+    return EvalBlockwise<kernel_type>(context, node, params, input, filter,
+                                      bias, output);
+  }
+
   switch (filter->type) {
     case kTfLiteFloat32:
       return EvalFloat<kernel_type>(context, node, params, data, input, filter,
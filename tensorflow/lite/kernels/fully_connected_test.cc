@@ -482,6 +482,67 @@ class HybridFullyConnectedOpModel : public SingleOpModel {
   int input_size_;
 };
 
+// FullyConnected with int4 weights that are quantized in blocks along the
+// depth. The flatbuffer schema has no blockwise quantization, so it's set on
+// the weights of the built interpreter.
+class BlockwiseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  BlockwiseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                          int units, int batches, int depth,
+                                          int blocksize,
+                                          const std::vector<float>& scales)
+      : scales_(scales) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, depth}});
+    weights_ = AddInput({TensorType_INT4, {units, depth}});
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput({TensorType_FLOAT32});
+
+    SetBuiltinOp(BuiltinOperator_FULLY_CONNECTED,
+                 BuiltinOptions_FullyConnectedOptions,
+                 CreateFullyConnectedOptions(builder_).Union());
+    resolver_ = std::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     /*num_threads=*/-1, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false, /*allocate_and_delegate=*/false);
+
+    int scales_index;
+    interpreter_->AddTensors(1, &scales_index);
+    interpreter_->SetTensorParametersReadOnly(
+        scales_index, kTfLiteFloat32, "scales", {units, depth / blocksize},
+        TfLiteQuantization{kTfLiteNoQuantization, nullptr},
+        reinterpret_cast<const char*>(scales_.data()),
+        scales_.size() * sizeof(float));
+    auto* quantization = static_cast<TfLiteBlockwiseQuantization*>(
+        malloc(sizeof(TfLiteBlockwiseQuantization)));
+    quantization->scale = scales_index;
+    quantization->zero_point = -1;
+    quantization->blocksize = blocksize;
+    quantization->quantized_dimension = 1;
+    TfLiteTensor* weights = interpreter_->tensor(weights_);
+    TfLiteQuantizationFree(&weights->quantization);
+    weights->quantization = {kTfLiteBlockwiseQuantization, quantization};
+    AllocateAndDelegate(/*apply_delegate=*/false);
+  }
+
+  // The weights are the quantized values, in [-8, 7].
+  void SetWeights(const std::vector<int8_t>& values) {
+    PopulateTensor4bit(weights_, /*offset=*/0, values.data(),
+                       values.data() + values.size());
+  }
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  const std::vector<float> scales_;
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
 const auto kKernelMap = new std::map<string, TfLiteRegistration*>({
     {"Reference", ops::builtin::Register_FULLY_CONNECTED_REF()},
     {"GenericOptimized", ops::builtin::Register_FULLY_CONNECTED_GENERIC_OPT()},
@@ -1630,6 +1691,62 @@ INSTANTIATE_TEST_SUITE_P(
     QuantizedFullyConnectedOpTest, QuantizedFullyConnectedOpTest,
     ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMapNoPie)));
 
+class BlockwiseQuantizedFullyConnectedOpTest : public SingleOpTest {
+ protected:
+  const std::map<string, TfLiteRegistration*>& GetKernelMap() override {
+    return *kKernelMap;
+  }
+};
+
+// Block sizes 32 and 64 use the SIMD kernels where available, 6 doesn't.
+TEST_P(BlockwiseQuantizedFullyConnectedOpTest, MatchesDequantizedWeights) {
+  constexpr int kUnits = 3;
+  constexpr int kBatches = 2;
+  constexpr int kDepth = 192;
+  for (int blocksize : {6, 32, 64}) {
+    const int num_blocks = kDepth / blocksize;
+    std::vector<float> scales(kUnits * num_blocks);
+    for (size_t i = 0; i < scales.size(); ++i) {
+      scales[i] = 0.25f * (1 + i % 3);
+    }
+    BlockwiseQuantizedFullyConnectedOpModel m(
+        GetRegistration(), kUnits, kBatches, kDepth, blocksize, scales);
+
+    std::vector<int8_t> weights(kUnits * kDepth);
+    for (size_t i = 0; i < weights.size(); ++i) {
+      weights[i] = static_cast<int>(i * 7 % 16) - 8;
+    }
+    std::vector<float> input(kBatches * kDepth);
+    for (size_t i = 0; i < input.size(); ++i) {
+      input[i] = 0.5f * (i % 5) - 1.0f;
+    }
+    const std::vector<float> bias = {1, 2, 3};
+    m.SetWeights(weights);
+    m.SetBias(bias);
+    m.SetInput(input);
+    ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+    std::vector<float> expected;
+    for (int b = 0; b < kBatches; ++b) {
+      for (int u = 0; u < kUnits; ++u) {
+        float sum = bias[u];
+        for (int d = 0; d < kDepth; ++d) {
+          sum += input[b * kDepth + d] * weights[u * kDepth + d] *
+                 scales[u * num_blocks + d / blocksize];
+        }
+        expected.push_back(sum);
+      }
+    }
+    EXPECT_THAT(m.GetOutputShape(), ElementsAre(kBatches, kUnits));
+    EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear(expected)));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BlockwiseQuantizedFullyConnectedOpTest,
+    BlockwiseQuantizedFullyConnectedOpTest,
+    ::testing::ValuesIn(SingleOpTest::GetKernelTags(*kKernelMap)));
+
 // TODO(ahentz): Reconsider this test. Having arbitrary weights makes it hard
 // to debug errors and doesn't necessarily test all the important details.
 TEST_P(FloatFullyConnectedOpTest, BlackBoxTest) {
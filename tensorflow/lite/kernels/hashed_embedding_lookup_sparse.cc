@@ -0,0 +1,378 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Op that looks up the embeddings of sparse, hashed features, such as the
+// categorical features of an on-device recommender, and combines the
+// embeddings of each example, in one pass.
+//
+// Each id is mapped to a row of the params:
+//   * If a hash table is given, and has the id, to the row the table maps it
+//     to, which must be below num_rows - num_buckets.
+//   * Otherwise, to one of the last num_buckets rows, as
+//       num_rows - num_buckets + Fingerprint64(id) % num_buckets
+//     where int64 ids are hashed as their decimal string, like
+//     tf.feature_column.categorical_column_with_hash_bucket does. Ids are
+//     dropped if there are no hash buckets.
+//
+// Options:
+//   combiner: "sum" (default), "mean" or "sqrtn".
+//     * sum computes the weighted sum of the embeddings of an example.
+//     * mean is the weighted sum divided by the total weight.
+//     * sqrtn is the weighted sum divided by the square root of the sum of the
+//       squares of the weights.
+//   num_buckets: The number of hash buckets at the end of the params.
+//   num_segments: The number of examples. If zero or missing, the output has
+//     as many rows as the last segment id plus one.
+//
+// Input:
+//   Tensor[0]: Ids, 1-D, int64 or string.
+//   Tensor[1]: Segment ids, 1-D int32, of the same size as the ids and
+//              non-decreasing: the example of each id.
+//   Tensor[2]: Params, [num_rows, embedding_dim], float32, float16, or int8
+//              quantized per tensor or per row.
+//   Tensor[3]: Optional weights of the ids, 1-D float32. All weights are one
+//              if missing.
+//   Tensor[4]: Optional hash table resource, from int64 or string ids to the
+//              int64 rows of the params.
+//
+// Output:
+//   The combined embeddings, [num_segments, embedding_dim] float32. Examples
+//   without ids have zero embeddings.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/string_util.h"
+#include <farmhash.h>
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace hashed_embedding_lookup_sparse {
+
+constexpr int kIdsTensor = 0;
+constexpr int kSegmentIdsTensor = 1;
+constexpr int kParamsTensor = 2;
+constexpr int kWeightsTensor = 3;
+constexpr int kHashtableTensor = 4;
+constexpr int kOutputTensor = 0;
+
+// The temporaries of the hash table lookup.
+constexpr int kRowsTemporary = 0;
+constexpr int kDefaultRowTemporary = 1;
+
+enum class Combiner { kSum, kMean, kSqrtn };
+
+struct OpData {
+  Combiner combiner = Combiner::kSum;
+  int num_buckets = 0;
+  int num_segments = 0;
+  int scratch_tensor_index;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  auto* op_data = new OpData;
+  const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+  const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
+  const std::string combiner = m["combiner"].AsString().str();
+  if (combiner == "mean") {
+    op_data->combiner = Combiner::kMean;
+  } else if (combiner == "sqrtn") {
+    op_data->combiner = Combiner::kSqrtn;
+  }
+  op_data->num_buckets = m["num_buckets"].AsInt32();
+  op_data->num_segments = m["num_segments"].AsInt32();
+  context->AddTensors(context, 2, &op_data->scratch_tensor_index);
+  return op_data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  TF_LITE_ENSURE(context, NumInputs(node) >= 3 && NumInputs(node) <= 5);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  TF_LITE_ENSURE(context, op_data->num_buckets >= 0);
+  TF_LITE_ENSURE(context, op_data->num_segments >= 0);
+
+  const TfLiteTensor* ids;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kIdsTensor, &ids));
+  TF_LITE_ENSURE_EQ(context, NumDimensions(ids), 1);
+  TF_LITE_ENSURE(context,
+                 ids->type == kTfLiteInt64 || ids->type == kTfLiteString);
+
+  const TfLiteTensor* segment_ids;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kSegmentIdsTensor,
+                                          &segment_ids));
+  TF_LITE_ENSURE_EQ(context, NumDimensions(segment_ids), 1);
+  TF_LITE_ENSURE_TYPES_EQ(context, segment_ids->type, kTfLiteInt32);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(segment_ids, 0),
+                    SizeOfDimension(ids, 0));
+
+  const TfLiteTensor* params;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kParamsTensor, &params));
+  TF_LITE_ENSURE_EQ(context, NumDimensions(params), 2);
+  TF_LITE_ENSURE(context, op_data->num_buckets <= SizeOfDimension(params, 0));
+  if (params->type == kTfLiteInt8) {
+    TF_LITE_ENSURE_EQ(context, params->quantization.type,
+                      kTfLiteAffineQuantization);
+    const auto* quantization = reinterpret_cast<TfLiteAffineQuantization*>(
+        params->quantization.params);
+    TF_LITE_ENSURE(context, quantization != nullptr &&
+                                quantization->scale != nullptr &&
+                                quantization->zero_point != nullptr);
+    const int num_scales = quantization->scale->size;
+    TF_LITE_ENSURE(context, num_scales == 1 ||
+                                (quantization->quantized_dimension == 0 &&
+                                 num_scales == SizeOfDimension(params, 0)));
+    TF_LITE_ENSURE_EQ(context, quantization->zero_point->size, num_scales);
+  } else {
+    TF_LITE_ENSURE(context, params->type == kTfLiteFloat32 ||
+                                params->type == kTfLiteFloat16);
+  }
+
+  const TfLiteTensor* weights = GetOptionalInputTensor(context, node,
+                                                       kWeightsTensor);
+  if (weights != nullptr) {
+    TF_LITE_ENSURE_EQ(context, NumDimensions(weights), 1);
+    TF_LITE_ENSURE_TYPES_EQ(context, weights->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_EQ(context, SizeOfDimension(weights, 0),
+                      SizeOfDimension(ids, 0));
+  }
+
+  const TfLiteTensor* hashtable = GetOptionalInputTensor(context, node,
+                                                         kHashtableTensor);
+  TfLiteIntArrayFree(node->temporaries);
+  if (hashtable != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, hashtable->type, kTfLiteResource);
+    TF_LITE_ENSURE_EQ(context, NumElements(hashtable), 1);
+    // The rows of the ids, and the row of the ids missing from the table.
+    node->temporaries = TfLiteIntArrayCreate(2);
+    node->temporaries->data[kRowsTemporary] = op_data->scratch_tensor_index;
+    node->temporaries->data[kDefaultRowTemporary] =
+        op_data->scratch_tensor_index + 1;
+    TfLiteTensor* rows;
+    TF_LITE_ENSURE_OK(context,
+                      GetTemporarySafe(context, node, kRowsTemporary, &rows));
+    rows->type = kTfLiteInt64;
+    rows->allocation_type = kTfLiteArenaRw;
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, rows,
+                                            TfLiteIntArrayCopy(ids->dims)));
+    TfLiteTensor* default_row;
+    TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node,
+                                                kDefaultRowTemporary,
+                                                &default_row));
+    default_row->type = kTfLiteInt64;
+    default_row->allocation_type = kTfLiteArenaRw;
+    TfLiteIntArray* default_row_size = TfLiteIntArrayCreate(1);
+    default_row_size->data[0] = 1;
+    TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, default_row,
+                                                     default_row_size));
+  } else {
+    node->temporaries = TfLiteIntArrayCreate(0);
+  }
+
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+  if (op_data->num_segments == 0) {
+    SetTensorToDynamic(output);
+    return kTfLiteOk;
+  }
+  TfLiteIntArray* output_size = TfLiteIntArrayCreate(2);
+  output_size->data[0] = op_data->num_segments;
+  output_size->data[1] = SizeOfDimension(params, 1);
+  return context->ResizeTensor(context, output, output_size);
+}
+
+// Returns the hash bucket of the id at `index`.
+int64_t GetBucket(const TfLiteTensor* ids, int index, int num_buckets) {
+  uint64_t fingerprint;
+  if (ids->type == kTfLiteString) {
+    const StringRef id = GetString(ids, index);
+    fingerprint = ::util::Fingerprint64(id.str, id.len);
+  } else {
+    const std::string id = std::to_string(GetTensorData<int64_t>(ids)[index]);
+    fingerprint = ::util::Fingerprint64(id.data(), id.size());
+  }
+  return fingerprint % num_buckets;
+}
+
+// Adds `weight` times the row of the params to `output`.
+void AccumulateRow(const TfLiteTensor* params, int64_t row, float weight,
+                   float* output) {
+  const int dim = SizeOfDimension(params, 1);
+  switch (params->type) {
+    case kTfLiteFloat32: {
+      const float* values = GetTensorData<float>(params) + row * dim;
+      for (int i = 0; i < dim; ++i) {
+        output[i] += weight * values[i];
+      }
+      break;
+    }
+    case kTfLiteFloat16: {
+      const Eigen::half* values =
+          reinterpret_cast<const Eigen::half*>(params->data.f16) + row * dim;
+      for (int i = 0; i < dim; ++i) {
+        output[i] += weight * Eigen::half_impl::half_to_float(values[i]);
+      }
+      break;
+    }
+    case kTfLiteInt8: {
+      const auto* quantization = reinterpret_cast<TfLiteAffineQuantization*>(
+          params->quantization.params);
+      const int channel = quantization->scale->size == 1 ? 0 : row;
+      const float scaled_weight = weight * quantization->scale->data[channel];
+      const int32_t zero_point = quantization->zero_point->data[channel];
+      const int8_t* values = GetTensorData<int8_t>(params) + row * dim;
+      for (int i = 0; i < dim; ++i) {
+        output[i] += scaled_weight * (values[i] - zero_point);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  const TfLiteTensor* ids;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kIdsTensor, &ids));
+  const TfLiteTensor* segment_ids;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kSegmentIdsTensor,
+                                          &segment_ids));
+  const TfLiteTensor* params;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kParamsTensor, &params));
+  const TfLiteTensor* weights = GetOptionalInputTensor(context, node,
+                                                       kWeightsTensor);
+  const TfLiteTensor* hashtable = GetOptionalInputTensor(context, node,
+                                                         kHashtableTensor);
+  TfLiteTensor* output;
+  TF_LITE_ENSURE_OK(context,
+                    GetOutputSafe(context, node, kOutputTensor, &output));
+
+  const int num_ids = SizeOfDimension(ids, 0);
+  const int32_t* segments = GetTensorData<int32_t>(segment_ids);
+  for (int i = 1; i < num_ids; ++i) {
+    TF_LITE_ENSURE(context, segments[i - 1] <= segments[i]);
+  }
+  if (num_ids > 0) {
+    TF_LITE_ENSURE(context, segments[0] >= 0);
+  }
+  if (op_data->num_segments == 0) {
+    TfLiteIntArray* output_size = TfLiteIntArrayCreate(2);
+    output_size->data[0] = num_ids > 0 ? segments[num_ids - 1] + 1 : 0;
+    output_size->data[1] = SizeOfDimension(params, 1);
+    TF_LITE_ENSURE_OK(context,
+                      context->ResizeTensor(context, output, output_size));
+  }
+  const int num_segments = SizeOfDimension(output, 0);
+  TF_LITE_ENSURE(context, num_ids == 0 || segments[num_ids - 1] < num_segments);
+
+  // Finds the rows of all the ids in the hash table at once.
+  const int64_t* table_rows = nullptr;
+  if (hashtable != nullptr) {
+    Subgraph* subgraph = reinterpret_cast<Subgraph*>(context->impl_);
+    auto* lookup = resource::GetHashtableResource(&subgraph->resources(),
+                                                  hashtable->data.i32[0]);
+    TF_LITE_ENSURE(context, lookup != nullptr);
+    TfLiteTensor* rows;
+    TF_LITE_ENSURE_OK(context,
+                      GetTemporarySafe(context, node, kRowsTemporary, &rows));
+    TfLiteTensor* default_row;
+    TF_LITE_ENSURE_OK(context, GetTemporarySafe(context, node,
+                                                kDefaultRowTemporary,
+                                                &default_row));
+    TF_LITE_ENSURE_STATUS(lookup->CheckKeyAndValueTypes(context, ids, rows));
+    default_row->data.i64[0] = -1;
+    TF_LITE_ENSURE_STATUS(lookup->Lookup(context, ids, rows, default_row));
+    table_rows = rows->data.i64;
+  }
+
+  const int num_rows = SizeOfDimension(params, 0);
+  const int num_table_rows = num_rows - op_data->num_buckets;
+  const int dim = SizeOfDimension(params, 1);
+  float* output_data = GetTensorData<float>(output);
+  std::memset(output_data, 0, NumElements(output) * sizeof(float));
+  // Combines the embeddings of each segment once all its ids are added.
+  float weight_sum = 0;
+  float squared_weight_sum = 0;
+  for (int i = 0; i < num_ids; ++i) {
+    int64_t row = table_rows != nullptr ? table_rows[i] : -1;
+    if (row >= 0) {
+      TF_LITE_ENSURE(context, row < num_table_rows);
+    } else if (op_data->num_buckets > 0) {
+      row = num_table_rows + GetBucket(ids, i, op_data->num_buckets);
+    }
+    float* segment_output = output_data + segments[i] * dim;
+    if (row >= 0) {
+      const float weight = weights != nullptr ? weights->data.f[i] : 1.0f;
+      AccumulateRow(params, row, weight, segment_output);
+      weight_sum += weight;
+      squared_weight_sum += weight * weight;
+    }
+
+    const bool is_last_of_segment =
+        i + 1 == num_ids || segments[i + 1] != segments[i];
+    if (!is_last_of_segment) continue;
+    float scale = 1.0f;
+    if (op_data->combiner == Combiner::kMean && weight_sum > 0) {
+      scale = 1.0f / weight_sum;
+    } else if (op_data->combiner == Combiner::kSqrtn &&
+               squared_weight_sum > 0) {
+      scale = 1.0f / std::sqrt(squared_weight_sum);
+    }
+    if (scale != 1.0f) {
+      for (int j = 0; j < dim; ++j) {
+        segment_output[j] *= scale;
+      }
+    }
+    weight_sum = 0;
+    squared_weight_sum = 0;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace hashed_embedding_lookup_sparse
+
+TfLiteRegistration* Register_HASHED_EMBEDDING_LOOKUP_SPARSE() {
+  static TfLiteRegistration r = {hashed_embedding_lookup_sparse::Init,
+                                 hashed_embedding_lookup_sparse::Free,
+                                 hashed_embedding_lookup_sparse::Prepare,
+                                 hashed_embedding_lookup_sparse::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,196 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+
+TfLiteRegistration* Register_HASHED_EMBEDDING_LOOKUP_SPARSE();
+
+}  // namespace custom
+}  // namespace ops
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+constexpr int kTableId = 7;
+
+class HashedEmbeddingLookupSparseOpModel : public SingleOpModel {
+ public:
+  HashedEmbeddingLookupSparseOpModel(const std::string& combiner,
+                                     int num_buckets, int num_segments,
+                                     int num_ids, const TensorData& params,
+                                     bool has_weights, bool has_hashtable) {
+    ids_ = AddInput({TensorType_INT64, {num_ids}});
+    segment_ids_ = AddInput({TensorType_INT32, {num_ids}});
+    params_ = AddInput(params);
+    weights_ = has_weights ? AddInput({TensorType_FLOAT32, {num_ids}})
+                           : AddNullInput();
+    if (has_hashtable) {
+      hashtable_ = AddInput({TensorType_RESOURCE, {1}});
+    }
+    output_ = AddOutput(TensorType_FLOAT32);
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      fbb.String("combiner", combiner);
+      fbb.Int("num_buckets", num_buckets);
+      fbb.Int("num_segments", num_segments);
+    });
+    fbb.Finish();
+    SetCustomOp("HashedEmbeddingLookupSparse", fbb.GetBuffer(),
+                ops::custom::Register_HASHED_EMBEDDING_LOOKUP_SPARSE);
+    BuildInterpreter({GetShape(ids_), GetShape(segment_ids_),
+                      GetShape(params_)});
+  }
+
+  void SetIds(std::initializer_list<int64_t> ids,
+              std::initializer_list<int32_t> segment_ids) {
+    PopulateTensor(ids_, ids);
+    PopulateTensor(segment_ids_, segment_ids);
+  }
+
+  void SetWeights(std::initializer_list<float> weights) {
+    PopulateTensor(weights_, weights);
+  }
+
+  template <typename T>
+  void SetParams(std::initializer_list<T> params) {
+    PopulateTensor(params_, params);
+  }
+
+  // Maps the ids `keys` to the rows `rows` in the hash table of the op.
+  void SetHashtable(const std::vector<int64_t>& keys,
+                    const std::vector<int64_t>& rows) {
+    TfLiteTensor* resource = interpreter_->tensor(hashtable_);
+    TfLiteTensorRealloc(sizeof(int32_t), resource);
+    resource->bytes = sizeof(int32_t);
+    if (resource->dims) TfLiteIntArrayFree(resource->dims);
+    resource->dims = TfLiteIntArrayCreate(1);
+    resource->dims->data[0] = 1;
+    resource->data.i32[0] = kTableId;
+
+    auto& resources = interpreter_->primary_subgraph().resources();
+    resource::CreateHashtableResourceIfNotAvailable(&resources, kTableId,
+                                                    kTfLiteInt64, kTfLiteInt64);
+    TfLiteTensor key_tensor = CreateInt64Tensor(keys);
+    TfLiteTensor row_tensor = CreateInt64Tensor(rows);
+    TfLiteContext context;
+    resource::GetHashtableResource(&resources, kTableId)
+        ->Import(&context, &key_tensor, &row_tensor);
+    TfLiteTensorFree(&key_tensor);
+    TfLiteTensorFree(&row_tensor);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  static TfLiteTensor CreateInt64Tensor(const std::vector<int64_t>& values) {
+    TfLiteTensor tensor = {};
+    tensor.type = kTfLiteInt64;
+    tensor.allocation_type = kTfLiteDynamic;
+    tensor.dims = TfLiteIntArrayCreate(1);
+    tensor.dims->data[0] = values.size();
+    tensor.bytes = values.size() * sizeof(int64_t);
+    tensor.data.raw = static_cast<char*>(malloc(tensor.bytes));
+    std::copy(values.begin(), values.end(), tensor.data.i64);
+    return tensor;
+  }
+
+  int ids_;
+  int segment_ids_;
+  int params_;
+  int weights_;
+  int hashtable_ = kTfLiteOptionalTensor;
+  int output_;
+};
+
+TEST(HashedEmbeddingLookupSparseOpTest, MeanOfTableRowsAndHashBucket) {
+  // Rows 0 and 1 are in the table, row 2 is the only hash bucket.
+  HashedEmbeddingLookupSparseOpModel m(
+      "mean", /*num_buckets=*/1, /*num_segments=*/3, /*num_ids=*/4,
+      {TensorType_FLOAT32, {3, 2}}, /*has_weights=*/false,
+      /*has_hashtable=*/true);
+  m.SetParams<float>({1, 2, 3, 4, 5, 6});
+  m.SetHashtable({10, 20}, {0, 1});
+  m.SetIds({10, 99, 20, 20}, {0, 0, 1, 1});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(3, 2));
+  // The last example has no ids.
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray({3, 4, 3, 4, 0, 0}));
+}
+
+TEST(HashedEmbeddingLookupSparseOpTest, FailsOnTableRowInHashBuckets) {
+  HashedEmbeddingLookupSparseOpModel m(
+      "sum", /*num_buckets=*/1, /*num_segments=*/1, /*num_ids=*/1,
+      {TensorType_FLOAT32, {2, 2}}, /*has_weights=*/false,
+      /*has_hashtable=*/true);
+  m.SetParams<float>({1, 2, 3, 4});
+  m.SetHashtable({10}, {1});
+  m.SetIds({10}, {0});
+  EXPECT_EQ(m.Invoke(), kTfLiteError);
+}
+
+TEST(HashedEmbeddingLookupSparseOpTest, WeightedSumOfQuantizedParams) {
+  // Without a hash table, all the ids are hashed to the only bucket.
+  HashedEmbeddingLookupSparseOpModel m(
+      "sum", /*num_buckets=*/1, /*num_segments=*/0, /*num_ids=*/3,
+      {TensorType_INT8, {1, 2}, 0, 0, /*scale=*/0.5, /*zero_point=*/1},
+      /*has_weights=*/true, /*has_hashtable=*/false);
+  m.SetParams<int8_t>({3, -3});
+  m.SetWeights({1, 2, 4});
+  m.SetIds({7, 8, 9}, {0, 0, 1});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  // The output has as many rows as the last segment id plus one.
+  EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 2));
+  EXPECT_THAT(m.GetOutput(),
+              Pointwise(FloatNear(1e-6), {3.0f, -6.0f, 4.0f, -8.0f}));
+}
+
+TEST(HashedEmbeddingLookupSparseOpTest, SqrtnOfWeights) {
+  HashedEmbeddingLookupSparseOpModel m(
+      "sqrtn", /*num_buckets=*/1, /*num_segments=*/1, /*num_ids=*/2,
+      {TensorType_FLOAT32, {1, 1}}, /*has_weights=*/true,
+      /*has_hashtable=*/false);
+  m.SetParams<float>({10});
+  m.SetWeights({3, 4});
+  m.SetIds({1, 2}, {0, 0});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+  // (3 + 4) * 10 / sqrt(3 * 3 + 4 * 4).
+  EXPECT_THAT(m.GetOutput(), Pointwise(FloatNear(1e-5), {14.0f}));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -42,6 +42,8 @@ TfLiteStatus PrepareHashtable(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, (params->key_dtype == kTfLiteInt64 &&
                            params->value_dtype == kTfLiteString) ||
                               (params->key_dtype == kTfLiteString &&
+                               params->value_dtype == kTfLiteInt64) ||
+                              (params->key_dtype == kTfLiteInt64 &&
                                params->value_dtype == kTfLiteInt64));
 
   TfLiteTensor* resource_handle_tensor;
@@ -54,6 +54,8 @@ TfLiteStatus PrepareHashtableFind(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, (key_tensor->type == kTfLiteInt64 &&
                            output_tensor->type == kTfLiteString) ||
                               (key_tensor->type == kTfLiteString &&
+                               output_tensor->type == kTfLiteInt64) ||
+                              (key_tensor->type == kTfLiteInt64 &&
                                output_tensor->type == kTfLiteInt64));
   return context->ResizeTensor(context, output_tensor,
                                TfLiteIntArrayCopy(key_tensor->dims));
@@ -48,6 +48,8 @@ TfLiteStatus PrepareHashtableImport(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, (key_tensor->type == kTfLiteInt64 &&
                            value_tensor->type == kTfLiteString) ||
                               (key_tensor->type == kTfLiteString &&
+                               value_tensor->type == kTfLiteInt64) ||
+                              (key_tensor->type == kTfLiteInt64 &&
                                value_tensor->type == kTfLiteInt64));
   // TODO(b/144731295): Tensorflow lookup ops support 1-D vector in storing
   // values.
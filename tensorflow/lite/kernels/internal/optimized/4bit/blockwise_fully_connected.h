@@ -0,0 +1,223 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_4BIT_BLOCKWISE_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_4BIT_BLOCKWISE_FULLY_CONNECTED_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define TFLITE_BLOCKWISE_4BIT_AVX2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TFLITE_BLOCKWISE_4BIT_NEON
+#endif
+
+namespace tflite {
+namespace optimized_4bit {
+
+// Fully connected layer with float inputs and outputs, and signed 4-bit
+// weights that are symmetrically quantized in blocks along the depth:
+//
+//   output[b, u] = bias[u] +
+//       sum_d input[b, d] * scales[u, d / blocksize] * filter[u, d]
+//
+// `filter` holds the [num_units, depth] weights packed two per byte, the
+// first of each pair in the low nibble, as in
+// tensor_utils::UnpackDenseInt4IntoInt8. `depth` must be a multiple of
+// `blocksize`, which must be even, so that each block starts on a byte.
+// `bias` is optional.
+//
+// The weights are widened to float one block at a time, so no dequantized
+// copy of the filter is ever written.
+inline void BlockwiseFullyConnectedReference(
+    const float* input, int batch_size, int depth, const int8_t* filter,
+    const float* scales, int blocksize, int num_units, const float* bias,
+    float output_activation_min, float output_activation_max, float* output) {
+  const int num_blocks = depth / blocksize;
+  for (int b = 0; b < batch_size; ++b) {
+    const float* input_row = input + b * depth;
+    for (int u = 0; u < num_units; ++u) {
+      const int8_t* filter_row = filter + u * depth / 2;
+      const float* row_scales = scales + u * num_blocks;
+      float total = bias ? bias[u] : 0.0f;
+      for (int block = 0; block < num_blocks; ++block) {
+        float acc = 0.0f;
+        for (int d = block * blocksize; d < (block + 1) * blocksize; d += 2) {
+          const int8_t byte = filter_row[d / 2];
+          const int8_t lower = static_cast<int8_t>(byte << 4) >> 4;
+          const int8_t higher = byte >> 4;
+          acc += input_row[d] * lower + input_row[d + 1] * higher;
+        }
+        total += acc * row_scales[block];
+      }
+      output[b * num_units + u] =
+          std::min(std::max(total, output_activation_min),
+                   output_activation_max);
+    }
+  }
+}
+
+namespace blockwise_internal {
+
+// The number of weights widened per step of the SIMD kernels.
+constexpr int kStep = 16;
+
+#if defined(TFLITE_BLOCKWISE_4BIT_AVX2)
+
+inline float ReduceAdd(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  return _mm_cvtss_f32(sum);
+}
+
+// Returns sum_i input[i] * filter[i] over the kStep weights of the 8 bytes at
+// `filter`.
+inline __m256 DotStep(const float* input, const int8_t* filter, __m256 acc) {
+  const __m128i bytes = _mm_cvtepi8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(filter)));
+  // Sign extends each nibble, then restores the order of the weights.
+  const __m128i lower = _mm_srai_epi16(_mm_slli_epi16(bytes, 12), 12);
+  const __m128i higher = _mm_srai_epi16(bytes, 4);
+  const __m256 first = _mm256_cvtepi32_ps(
+      _mm256_cvtepi16_epi32(_mm_unpacklo_epi16(lower, higher)));
+  const __m256 second = _mm256_cvtepi32_ps(
+      _mm256_cvtepi16_epi32(_mm_unpackhi_epi16(lower, higher)));
+  acc = _mm256_fmadd_ps(_mm256_loadu_ps(input), first, acc);
+  return _mm256_fmadd_ps(_mm256_loadu_ps(input + 8), second, acc);
+}
+
+inline float BlockwiseDot(const float* input, const int8_t* filter,
+                          const float* scales, int num_blocks, int blocksize) {
+  __m256 total = _mm256_setzero_ps();
+  for (int block = 0; block < num_blocks; ++block) {
+    __m256 acc = _mm256_setzero_ps();
+    for (int d = 0; d < blocksize; d += kStep) {
+      acc = DotStep(input + d, filter + d / 2, acc);
+    }
+    total = _mm256_fmadd_ps(acc, _mm256_set1_ps(scales[block]), total);
+    input += blocksize;
+    filter += blocksize / 2;
+  }
+  return ReduceAdd(total);
+}
+
+#elif defined(TFLITE_BLOCKWISE_4BIT_NEON)
+
+inline float32x4_t MultiplyAdd(float32x4_t acc, float32x4_t a, float32x4_t b) {
+#ifdef __aarch64__
+  return vfmaq_f32(acc, a, b);
+#else
+  return vmlaq_f32(acc, a, b);
+#endif
+}
+
+inline float ReduceAdd(float32x4_t v) {
+#ifdef __aarch64__
+  return vaddvq_f32(v);
+#else
+  const float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+}
+
+// Returns sum_i input[i] * filter[i] over the kStep weights of the 8 bytes at
+// `filter`.
+inline float32x4_t DotStep(const float* input, const int8_t* filter,
+                           float32x4_t acc) {
+  const int8x8_t bytes = vld1_s8(filter);
+  // Sign extends each nibble, then restores the order of the weights.
+  const int8x8_t lower = vshr_n_s8(vshl_n_s8(bytes, 4), 4);
+  const int8x8_t higher = vshr_n_s8(bytes, 4);
+  const int8x8x2_t weights = vzip_s8(lower, higher);
+  const int16x8_t first = vmovl_s8(weights.val[0]);
+  const int16x8_t second = vmovl_s8(weights.val[1]);
+  acc = MultiplyAdd(acc, vld1q_f32(input),
+                    vcvtq_f32_s32(vmovl_s16(vget_low_s16(first))));
+  acc = MultiplyAdd(acc, vld1q_f32(input + 4),
+                    vcvtq_f32_s32(vmovl_s16(vget_high_s16(first))));
+  acc = MultiplyAdd(acc, vld1q_f32(input + 8),
+                    vcvtq_f32_s32(vmovl_s16(vget_low_s16(second))));
+  return MultiplyAdd(acc, vld1q_f32(input + 12),
+                     vcvtq_f32_s32(vmovl_s16(vget_high_s16(second))));
+}
+
+inline float BlockwiseDot(const float* input, const int8_t* filter,
+                          const float* scales, int num_blocks, int blocksize) {
+  float32x4_t total = vdupq_n_f32(0.0f);
+  for (int block = 0; block < num_blocks; ++block) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int d = 0; d < blocksize; d += kStep) {
+      acc = DotStep(input + d, filter + d / 2, acc);
+    }
+    total = MultiplyAdd(total, acc, vdupq_n_f32(scales[block]));
+    input += blocksize;
+    filter += blocksize / 2;
+  }
+  return ReduceAdd(total);
+}
+
+#endif
+
+}  // namespace blockwise_internal
+
+// Returns true if BlockwiseFullyConnected has a SIMD kernel for `blocksize`
+// on this platform, e.g. for the common block sizes 32 and 64.
+inline bool HasBlockwiseSimdKernel(int blocksize) {
+#if defined(TFLITE_BLOCKWISE_4BIT_AVX2) || defined(TFLITE_BLOCKWISE_4BIT_NEON)
+  return blocksize % blockwise_internal::kStep == 0;
+#else
+  (void)blocksize;
+  return false;
+#endif
+}
+
+// Same as BlockwiseFullyConnectedReference, using the AVX2 or NEON kernel
+// when HasBlockwiseSimdKernel(blocksize).
+inline void BlockwiseFullyConnected(
+    const float* input, int batch_size, int depth, const int8_t* filter,
+    const float* scales, int blocksize, int num_units, const float* bias,
+    float output_activation_min, float output_activation_max, float* output) {
+#if defined(TFLITE_BLOCKWISE_4BIT_AVX2) || defined(TFLITE_BLOCKWISE_4BIT_NEON)
+  if (HasBlockwiseSimdKernel(blocksize)) {
+    const int num_blocks = depth / blocksize;
+    for (int b = 0; b < batch_size; ++b) {
+      for (int u = 0; u < num_units; ++u) {
+        const float total =
+            (bias ? bias[u] : 0.0f) +
+            blockwise_internal::BlockwiseDot(
+                input + b * depth, filter + u * depth / 2,
+                scales + u * num_blocks, num_blocks, blocksize);
+        output[b * num_units + u] =
+            std::min(std::max(total, output_activation_min),
+                     output_activation_max);
+      }
+    }
+    return;
+  }
+#endif
+  BlockwiseFullyConnectedReference(input, batch_size, depth, filter, scales,
+                                   blocksize, num_units, bias,
+                                   output_activation_min,
+                                   output_activation_max, output);
+}
+
+}  // namespace optimized_4bit
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_4BIT_BLOCKWISE_FULLY_CONNECTED_H_
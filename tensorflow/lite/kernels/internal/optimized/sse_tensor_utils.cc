@@ -149,6 +149,32 @@ float GetFloatVectorElement(__m128 v) {
   return _mm_cvtss_f32(v);
 }
 
+// Horizontally add each of 4 XMM registers with 4 float values, pack result
+// into a single XMM register.
+static inline __m128 ReduceFloat32x4x4(__m128 a, __m128 b, __m128 c,
+                                       __m128 d) {
+  const __m128 a_b_lo_half = _mm_unpacklo_ps(a, b);  // [a0, b0, a1, b1]
+  const __m128 a_b_hi_half = _mm_unpackhi_ps(a, b);  // [a2, b2, a3, b3]
+  const __m128 a_plus_b =
+      _mm_add_ps(a_b_lo_half, a_b_hi_half);  // [a0+a2, b0+b2, a1+a3, b1+b3]
+  const __m128 c_d_lo_half = _mm_unpacklo_ps(c, d);  // [c0, d0, c1, d1]
+  const __m128 c_d_hi_half = _mm_unpackhi_ps(c, d);  // [c2, d2, c3, d3]
+  const __m128 c_plus_d =
+      _mm_add_ps(c_d_lo_half, c_d_hi_half);  // [c0+c2, d0+d2, c1+c3, d1+d3]
+  const __m128 all_evns =
+      _mm_movelh_ps(a_plus_b, c_plus_d);  // [a02, b02, c02, d02]
+  const __m128 all_odds =
+      _mm_movehl_ps(c_plus_d, a_plus_b);  // [a13, b13, c13, d13]
+  return _mm_add_ps(all_evns, all_odds);  // [a0123, b0123, c0123, d0123]
+}
+
+// Horizontally add the 4 float values of a XMM register.
+static inline float ReduceFloat32x4(__m128 v) {
+  const __m128 sum_2 = _mm_add_ps(v, _mm_movehl_ps(v, v));  // [v02, v13, ...]
+  const __m128 sum_1 = _mm_add_ss(sum_2, _mm_shuffle_ps(sum_2, sum_2, 1));
+  return _mm_cvtss_f32(sum_1);
+}
+
 }  // namespace
 
 #ifdef __AVX2__
@@ -632,6 +658,58 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
   }  // for batch
 }
 
+void SseSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const float* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const float* __restrict__ vector, int n_batch, float* __restrict__ result) {
+  constexpr int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  int batch = 0;
+  // Each block of the matrix is loaded once for 4 batches.
+  for (; batch + 4 <= n_batch; batch += 4) {
+    const float* vector0 = vector + batch * m_cols;
+    const float* vector1 = vector0 + m_cols;
+    const float* vector2 = vector1 + m_cols;
+    const float* vector3 = vector2 + m_cols;
+    float* result0 = result + batch * m_rows;
+    const float* matrix_ptr = matrix;
+    for (int row = 0; row < m_rows; ++row) {
+      __m128 acc0 = _mm_setzero_ps();
+      __m128 acc1 = _mm_setzero_ps();
+      __m128 acc2 = _mm_setzero_ps();
+      __m128 acc3 = _mm_setzero_ps();
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int col = indices[i] * kBlockSize;
+        const __m128 block = _mm_loadu_ps(matrix_ptr);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(block, _mm_loadu_ps(vector0 + col)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(block, _mm_loadu_ps(vector1 + col)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(block, _mm_loadu_ps(vector2 + col)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(block, _mm_loadu_ps(vector3 + col)));
+        matrix_ptr += kBlockSize;
+      }
+      const __m128 dot_prods = ReduceFloat32x4x4(acc0, acc1, acc2, acc3);
+      result0[row] += GetFloatVectorElement<0>(dot_prods);
+      result0[m_rows + row] += GetFloatVectorElement<1>(dot_prods);
+      result0[2 * m_rows + row] += GetFloatVectorElement<2>(dot_prods);
+      result0[3 * m_rows + row] += GetFloatVectorElement<3>(dot_prods);
+    }
+  }
+  for (; batch < n_batch; ++batch) {
+    const float* vector_in_batch = vector + batch * m_cols;
+    const float* matrix_ptr = matrix;
+    for (int row = 0; row < m_rows; ++row) {
+      __m128 acc = _mm_setzero_ps();
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int col = indices[i] * kBlockSize;
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(matrix_ptr),
+                                         _mm_loadu_ps(vector_in_batch + col)));
+        matrix_ptr += kBlockSize;
+      }
+      result[batch * m_rows + row] += ReduceFloat32x4(acc);
+    }
+  }
+}
+
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size) {
   static constexpr std::intptr_t kBlockSize = 16;
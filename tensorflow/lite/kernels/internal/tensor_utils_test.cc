@@ -1557,6 +1557,46 @@ TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
               ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
 }
 
+TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulate1x4Test) {
+  const int kRow = 3;
+  const int kCol = 12;
+  // Covers both the 4 batch and the single batch loops of the optimized
+  // kernels.
+  const int kBatch = 5;
+  /* clang-format off */
+  const float matrix[kRow * kCol] = {
+      /* 1st row */
+      1.1, 2.2, 3.3, 4.4, 0.0, 0.0, 0.0, 0.0, 9.9, -10.1, 11.11, -12.12,
+      /* 2nd row */
+      0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      /* 3rd row */
+      0.0, 0.0, 0.0, 0.0, -5.5, 6.6, 0.0, 8.8, 0.0, 0.0, 0.0, 0.0};
+  // 1x4 block sparse format of the above matrix.
+  const float matrix_values[] = {
+      1.1, 2.2, 3.3, 4.4, 9.9, -10.1, 11.11, -12.12,  // 1st row
+      -5.5, 6.6, 0.0, 8.8};                          // 3rd row
+  const int32_t segments[kRow + 1] = {0, 2, 2, 3};
+  const int32_t indices[] = {0, 2, 1};
+  /* clang-format on */
+
+  std::vector<float> vector(kBatch * kCol);
+  for (int i = 0; i < vector.size(); ++i) {
+    vector[i] = (i % 7) - 3.5f;
+  }
+
+  std::vector<float> dense_output(kRow * kBatch, 1.0);
+  MatrixBatchVectorMultiplyAccumulate(matrix, kRow, kCol, vector.data(),
+                                      kBatch, dense_output.data());
+
+  std::vector<float> sparse_output(kRow * kBatch, 1.0);
+  SparseMatrixBatchVectorMultiplyAccumulate1x4(
+      matrix_values, segments, indices, kRow, kCol, vector.data(), kBatch,
+      sparse_output.data());
+
+  EXPECT_THAT(sparse_output,
+              ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
+}
+
 #ifdef __ANDROID__
 TEST(uKernels,
      SparseMatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
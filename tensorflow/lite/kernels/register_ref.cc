@@ -29,6 +29,7 @@ TfLiteRegistration* Register_NUMERIC_VERIFY_REF();
 TfLiteRegistration* Register_AUDIO_SPECTROGRAM();
 TfLiteRegistration* Register_MFCC();
 TfLiteRegistration* Register_DETECTION_POSTPROCESS();
+TfLiteRegistration* Register_HASHED_EMBEDDING_LOOKUP_SPARSE();
 
 }  // namespace custom
 
@@ -569,6 +570,8 @@ BuiltinRefOpResolver::BuiltinRefOpResolver() {
             tflite::ops::custom::Register_AUDIO_SPECTROGRAM());
   AddCustom("TFLite_Detection_PostProcess",
             tflite::ops::custom::Register_DETECTION_POSTPROCESS());
+  AddCustom("HashedEmbeddingLookupSparse",
+            tflite::ops::custom::Register_HASHED_EMBEDDING_LOOKUP_SPARSE());
 }
 
 }  // namespace builtin
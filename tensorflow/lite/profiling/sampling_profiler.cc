@@ -0,0 +1,290 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/sampling_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/telemetry/c/telemetry_setting_internal.h"
+#include "tensorflow/lite/profiling/telemetry/profiler.h"
+#include "tensorflow/lite/profiling/telemetry/telemetry_status.h"
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+constexpr uint32_t kInvalidEventHandle = UINT32_MAX;
+// Op event handles are the indices of the in-flight events, below this.
+constexpr uint32_t kInvocationEventHandle = UINT32_MAX - 1;
+
+constexpr int32_t kPendingIndex = -1;
+constexpr int32_t kDroppedIndex = -2;
+
+int FloorLog2(uint64_t value) {
+  int log2 = 0;
+  while (value >>= 1) ++log2;
+  return log2;
+}
+
+uint64_t Hash(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  return key;
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(uint32_t sampling_period,
+                                   size_t max_num_ops)
+    : sampling_period_(std::max<uint32_t>(sampling_period, 1)),
+      max_num_ops_(max_num_ops) {
+  // At most half full, so that probing stays short.
+  num_slots_ = 1;
+  while (num_slots_ < 2 * max_num_ops_) num_slots_ *= 2;
+  slots_ = std::make_unique<Slot[]>(num_slots_);
+  histograms_ = std::make_unique<Histogram[]>(max_num_ops_);
+}
+
+SamplingProfiler::~SamplingProfiler() = default;
+
+bool SamplingProfiler::IsOpEvent(EventType event_type) {
+  return event_type == EventType::OPERATOR_INVOKE_EVENT ||
+         event_type == EventType::DELEGATE_OPERATOR_INVOKE_EVENT ||
+         event_type == EventType::DELEGATE_PROFILED_OPERATOR_INVOKE_EVENT;
+}
+
+bool SamplingProfiler::IsInvocationEvent(const char* tag,
+                                         EventType event_type) {
+  if (tag == nullptr) return false;
+  return (event_type == EventType::GENERAL_RUNTIME_INSTRUMENTATION_EVENT &&
+          std::strcmp(tag, "invoke") == 0) ||
+         (event_type == EventType::DEFAULT && std::strcmp(tag, "Invoke") == 0);
+}
+
+uint32_t SamplingProfiler::BeginEvent(const char* tag, EventType event_type,
+                                      int64_t event_metadata1,
+                                      int64_t event_metadata2) {
+  if (IsOpEvent(event_type)) {
+    if (!sampling_.load(std::memory_order_relaxed)) return kInvalidEventHandle;
+    Histogram* histogram =
+        GetHistogram(tag, event_type, event_metadata1, event_metadata2);
+    if (histogram == nullptr) return kInvalidEventHandle;
+    const uint32_t handle =
+        next_in_flight_.fetch_add(1, std::memory_order_relaxed) %
+        kNumInFlightEvents;
+    InFlightEvent& event = in_flight_[handle];
+    event.begin_us.store(time::NowMicros(), std::memory_order_relaxed);
+    event.histogram.store(histogram, std::memory_order_release);
+    return handle;
+  }
+  if (IsInvocationEvent(tag, event_type)) {
+    if (invocation_depth_.fetch_add(1, std::memory_order_relaxed) == 0) {
+      const uint64_t invocation =
+          num_invocations_.fetch_add(1, std::memory_order_relaxed);
+      sampling_.store(invocation % sampling_period_ == 0,
+                      std::memory_order_relaxed);
+    }
+    return kInvocationEventHandle;
+  }
+  return kInvalidEventHandle;
+}
+
+void SamplingProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kInvocationEventHandle) {
+    if (invocation_depth_.fetch_sub(1, std::memory_order_relaxed) == 1) {
+      sampling_.store(false, std::memory_order_relaxed);
+    }
+    return;
+  }
+  if (event_handle >= kNumInFlightEvents) return;
+  InFlightEvent& event = in_flight_[event_handle];
+  Histogram* histogram =
+      event.histogram.exchange(nullptr, std::memory_order_acquire);
+  if (histogram == nullptr) return;
+  const uint64_t begin_us = event.begin_us.load(std::memory_order_relaxed);
+  const uint64_t end_us = time::NowMicros();
+  Record(histogram, end_us > begin_us ? end_us - begin_us : 0);
+}
+
+void SamplingProfiler::AddEvent(const char* tag, EventType event_type,
+                                uint64_t metric, int64_t event_metadata1,
+                                int64_t event_metadata2) {
+  // Delegates that measure their ops report the elapsed time directly.
+  if (!IsOpEvent(event_type) || !sampling_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  Histogram* histogram =
+      GetHistogram(tag, event_type, event_metadata1, event_metadata2);
+  if (histogram != nullptr) Record(histogram, metric);
+}
+
+SamplingProfiler::Histogram* SamplingProfiler::GetHistogram(
+    const char* tag, EventType event_type, int64_t op_index,
+    int64_t subgraph_index) {
+  // The event type is a single bit below 1 << 8, so the key is never 0.
+  const uint64_t key = (static_cast<uint64_t>(event_type) << 56) ^
+                       (static_cast<uint64_t>(subgraph_index) << 32) ^
+                       static_cast<uint32_t>(op_index);
+  for (size_t i = Hash(key) & (num_slots_ - 1), probes = 0;
+       probes < num_slots_; i = (i + 1) & (num_slots_ - 1), ++probes) {
+    Slot& slot = slots_[i];
+    uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+    if (slot_key == 0) {
+      if (slot.key.compare_exchange_strong(slot_key, key,
+                                           std::memory_order_acq_rel)) {
+        // This thread claimed the slot, and assigns the histogram.
+        const int32_t index =
+            num_histograms_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= static_cast<int32_t>(max_num_ops_)) {
+          slot.index.store(kDroppedIndex, std::memory_order_release);
+          num_dropped_ops_.fetch_add(1, std::memory_order_relaxed);
+          return nullptr;
+        }
+        Histogram& histogram = histograms_[index];
+        histogram.event_type = event_type;
+        histogram.op_index = op_index;
+        histogram.subgraph_index = subgraph_index;
+        histogram.tag.store(tag, std::memory_order_release);
+        slot.index.store(index, std::memory_order_release);
+        return &histogram;
+      }
+      // Another thread claimed the slot, for `slot_key`.
+    }
+    if (slot_key != key) continue;
+    int32_t index;
+    while ((index = slot.index.load(std::memory_order_acquire)) ==
+           kPendingIndex) {
+    }
+    return index == kDroppedIndex ? nullptr : &histograms_[index];
+  }
+  num_dropped_ops_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void SamplingProfiler::Record(Histogram* histogram, uint64_t us) {
+  histogram->buckets[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+  histogram->total_us.fetch_add(us, std::memory_order_relaxed);
+}
+
+int SamplingProfiler::BucketOf(uint64_t us) {
+  if (us < kNumLinearBuckets) return static_cast<int>(us);
+  const int exponent = FloorLog2(us);
+  if (exponent >= kMaxExponent) return kNumBuckets - 1;
+  const int sub_bucket = static_cast<int>(us >> (exponent - kSubBucketsLog2)) &
+                         ((1 << kSubBucketsLog2) - 1);
+  return kNumLinearBuckets + ((exponent - 4) << kSubBucketsLog2) + sub_bucket;
+}
+
+uint64_t SamplingProfiler::BucketLowerBound(int bucket) {
+  if (bucket < kNumLinearBuckets) return bucket;
+  const int exponent = 4 + ((bucket - kNumLinearBuckets) >> kSubBucketsLog2);
+  const uint64_t sub_bucket =
+      (bucket - kNumLinearBuckets) & ((1 << kSubBucketsLog2) - 1);
+  return ((uint64_t{1} << kSubBucketsLog2) + sub_bucket)
+         << (exponent - kSubBucketsLog2);
+}
+
+uint64_t SamplingProfiler::BucketUpperBound(int bucket) {
+  if (bucket < kNumLinearBuckets) return bucket;
+  if (bucket == kNumBuckets - 1) return UINT64_MAX;
+  return BucketLowerBound(bucket + 1) - 1;
+}
+
+uint64_t SamplingProfiler::Percentile(const Histogram& histogram,
+                                      uint64_t count, int percentile) {
+  // The rank of the sample at the percentile, from 1.
+  const uint64_t rank = std::max<uint64_t>(1, (count * percentile + 99) / 100);
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < kNumBuckets; ++bucket) {
+    seen += histogram.buckets[bucket].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      if (bucket == kNumBuckets - 1) return BucketLowerBound(bucket);
+      const uint64_t lower = BucketLowerBound(bucket);
+      return lower + (BucketUpperBound(bucket) - lower) / 2;
+    }
+  }
+  return 0;
+}
+
+std::vector<SamplingProfiler::OpLatency> SamplingProfiler::GetOpLatencies()
+    const {
+  std::vector<OpLatency> latencies;
+  const int32_t num_histograms =
+      std::min<int32_t>(num_histograms_.load(std::memory_order_relaxed),
+                        static_cast<int32_t>(max_num_ops_));
+  for (int32_t i = 0; i < num_histograms; ++i) {
+    const Histogram& histogram = histograms_[i];
+    // Skips a histogram that is still being assigned.
+    const char* tag = histogram.tag.load(std::memory_order_acquire);
+    if (tag == nullptr) continue;
+    uint64_t count = 0;
+    for (const auto& bucket : histogram.buckets) {
+      count += bucket.load(std::memory_order_relaxed);
+    }
+    if (count == 0) continue;
+    OpLatency latency;
+    latency.tag = tag;
+    latency.event_type = histogram.event_type;
+    latency.op_index = histogram.op_index;
+    latency.subgraph_index = histogram.subgraph_index;
+    latency.num_samples = count;
+    latency.total_us = histogram.total_us.load(std::memory_order_relaxed);
+    latency.p50_us = Percentile(histogram, count, 50);
+    latency.p90_us = Percentile(histogram, count, 90);
+    latency.p99_us = Percentile(histogram, count, 99);
+    latencies.push_back(latency);
+  }
+  return latencies;
+}
+
+void SamplingProfiler::ReportTo(
+    telemetry::TelemetryProfiler* telemetry_profiler) const {
+  if (telemetry_profiler == nullptr) return;
+  TfLiteTelemetryOpLatencySettings op_latencies;
+  for (const OpLatency& latency : GetOpLatencies()) {
+    op_latencies.ops.push_back({latency.tag, latency.op_index,
+                                latency.subgraph_index, latency.num_samples,
+                                latency.p50_us, latency.p90_us,
+                                latency.p99_us});
+  }
+  TfLiteTelemetrySettings settings;
+  settings.source =
+      static_cast<uint32_t>(telemetry::TelemetrySource::TFLITE_INTERPRETER);
+  settings.data = &op_latencies;
+  telemetry_profiler->ReportSettings(kOpLatencySettingName, &settings);
+}
+
+void SamplingProfiler::Reset() {
+  const int32_t num_histograms =
+      std::min<int32_t>(num_histograms_.load(std::memory_order_relaxed),
+                        static_cast<int32_t>(max_num_ops_));
+  for (int32_t i = 0; i < num_histograms; ++i) {
+    for (auto& bucket : histograms_[i].buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    histograms_[i].total_us.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace profiling
+}  // namespace tflite
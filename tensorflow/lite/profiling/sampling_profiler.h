@@ -0,0 +1,164 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_SAMPLING_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_SAMPLING_PROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/telemetry/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// The name of the setting reported by `SamplingProfiler::ReportTo`, with
+// `TfLiteTelemetryOpLatencySettings` data.
+constexpr char kOpLatencySettingName[] = "op_latency";
+
+// A profiler for always-on use in production, which measures the ops of one
+// in `sampling_period` invocations and aggregates the latencies into a
+// histogram per op.
+//
+// The overhead is constant: an invocation that isn't sampled costs a few
+// atomic operations, and each of its ops an atomic load. Recording a sampled
+// op is lock-free, so ops that run concurrently are measured correctly. The
+// histograms have 8 buckets per power of two, so the reported percentiles are
+// within 1/16 of the actual latencies.
+//
+// Invocations are delimited by the interpreter's "invoke" runtime event, or
+// by the outermost subgraph "Invoke" event when a signature runner is used.
+class SamplingProfiler : public Profiler {
+ public:
+  struct OpLatency {
+    // The tag of the op's events, e.g. its name.
+    const char* tag;
+    EventType event_type;
+    int64_t op_index;
+    int64_t subgraph_index;
+    uint64_t num_samples;
+    uint64_t total_us;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+  };
+
+  // Profiles one in `sampling_period` invocations, starting with the first.
+  // The latencies of at most `max_num_ops` distinct ops are kept; later ops
+  // are dropped.
+  explicit SamplingProfiler(uint32_t sampling_period,
+                            size_t max_num_ops = 256);
+  ~SamplingProfiler() override;
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override;
+  void AddEvent(const char* tag, EventType event_type, uint64_t metric,
+                int64_t event_metadata1, int64_t event_metadata2) override;
+
+  uint64_t num_invocations() const {
+    return num_invocations_.load(std::memory_order_relaxed);
+  }
+  uint64_t num_dropped_ops() const {
+    return num_dropped_ops_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the latencies of the ops sampled so far, in the order they were
+  // first seen. May be called while invocations are being profiled.
+  std::vector<OpLatency> GetOpLatencies() const;
+
+  // Reports the op latencies to `telemetry_profiler` as the
+  // kOpLatencySettingName setting.
+  void ReportTo(telemetry::TelemetryProfiler* telemetry_profiler) const;
+
+  // Clears the histograms, e.g. after they were reported.
+  void Reset();
+
+  // Returns the histogram bucket of `us`, and the lowest and the highest
+  // values in a bucket. Exposed for testing.
+  static int BucketOf(uint64_t us);
+  static uint64_t BucketLowerBound(int bucket);
+  static uint64_t BucketUpperBound(int bucket);
+
+ private:
+  static constexpr int kNumLinearBuckets = 16;
+  static constexpr int kSubBucketsLog2 = 3;
+  // Latencies above 2^kMaxExponent us, over 9 hours, go to the last bucket.
+  static constexpr int kMaxExponent = 35;
+  static constexpr int kNumBuckets =
+      kNumLinearBuckets + (kMaxExponent - 4) * (1 << kSubBucketsLog2);
+  // The number of op events that may be in progress at once.
+  static constexpr uint32_t kNumInFlightEvents = 64;
+
+  struct Histogram {
+    std::atomic<const char*> tag{nullptr};
+    EventType event_type = EventType::DEFAULT;
+    int64_t op_index = 0;
+    int64_t subgraph_index = 0;
+    std::atomic<uint64_t> total_us{0};
+    std::array<std::atomic<uint32_t>, kNumBuckets> buckets{};
+  };
+
+  // An entry of the open-addressing table from op keys to histograms.
+  struct Slot {
+    std::atomic<uint64_t> key{0};
+    // The index of the histogram, kPendingIndex while it's being assigned,
+    // or kDroppedIndex if there was none left.
+    std::atomic<int32_t> index{-1};
+  };
+
+  struct InFlightEvent {
+    std::atomic<Histogram*> histogram{nullptr};
+    std::atomic<uint64_t> begin_us{0};
+  };
+
+  static bool IsOpEvent(EventType event_type);
+  static bool IsInvocationEvent(const char* tag, EventType event_type);
+  // Returns the histogram of the op, creating it on first use, or nullptr
+  // if there are too many ops.
+  Histogram* GetHistogram(const char* tag, EventType event_type,
+                          int64_t op_index, int64_t subgraph_index);
+  void Record(Histogram* histogram, uint64_t us);
+  static uint64_t Percentile(const Histogram& histogram, uint64_t count,
+                             int percentile);
+
+  const uint32_t sampling_period_;
+  const size_t max_num_ops_;
+
+  std::atomic<uint64_t> num_invocations_{0};
+  // The depth of nested invocation events, whose outermost one decides
+  // whether the invocation is sampled.
+  std::atomic<int32_t> invocation_depth_{0};
+  std::atomic<bool> sampling_{false};
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t num_slots_;
+  std::unique_ptr<Histogram[]> histograms_;
+  std::atomic<int32_t> num_histograms_{0};
+  std::atomic<uint64_t> num_dropped_ops_{0};
+
+  std::array<InFlightEvent, kNumInFlightEvents> in_flight_;
+  std::atomic<uint32_t> next_in_flight_{0};
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_SAMPLING_PROFILER_H_
@@ -0,0 +1,183 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/sampling_profiler.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/profiling/telemetry/c/telemetry_setting.h"
+#include "tensorflow/lite/profiling/telemetry/profiler.h"
+#include "tensorflow/lite/profiling/telemetry/telemetry_status.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+using ::testing::_;
+using ::testing::StrEq;
+
+using EventType = Profiler::EventType;
+
+// Runs an invocation, in which op `op_index` of subgraph 0 takes `us`.
+void Invoke(SamplingProfiler* profiler, int64_t op_index, uint64_t us) {
+  ScopedRuntimeInstrumentationProfile invoke(profiler, "invoke");
+  TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler, "Invoke");
+  profiler->AddEvent("op", EventType::OPERATOR_INVOKE_EVENT, us, op_index,
+                     /*event_metadata2=*/0);
+}
+
+TEST(SamplingProfilerTest, Buckets) {
+  for (uint64_t us : {0, 1, 15, 16, 17, 100, 1000, 123456789}) {
+    const int bucket = SamplingProfiler::BucketOf(us);
+    EXPECT_LE(SamplingProfiler::BucketLowerBound(bucket), us);
+    EXPECT_GE(SamplingProfiler::BucketUpperBound(bucket), us);
+    EXPECT_EQ(SamplingProfiler::BucketOf(
+                  SamplingProfiler::BucketUpperBound(bucket) + 1),
+              bucket + 1);
+  }
+  EXPECT_EQ(SamplingProfiler::BucketOf(7), 7);
+  EXPECT_EQ(SamplingProfiler::BucketLowerBound(SamplingProfiler::BucketOf(16)),
+            16);
+  EXPECT_EQ(SamplingProfiler::BucketUpperBound(SamplingProfiler::BucketOf(16)),
+            17);
+}
+
+TEST(SamplingProfilerTest, SamplesOneInN) {
+  SamplingProfiler profiler(/*sampling_period=*/4);
+  for (int i = 0; i < 10; ++i) {
+    Invoke(&profiler, /*op_index=*/0, /*us=*/10);
+  }
+  // Ops outside of an invocation aren't profiled.
+  profiler.AddEvent("op", EventType::OPERATOR_INVOKE_EVENT, 10, 0, 0);
+  EXPECT_EQ(profiler.num_invocations(), 10);
+  const std::vector<SamplingProfiler::OpLatency> latencies =
+      profiler.GetOpLatencies();
+  ASSERT_EQ(latencies.size(), 1);
+  // Invocations 0, 4 and 8.
+  EXPECT_EQ(latencies[0].num_samples, 3);
+  EXPECT_EQ(latencies[0].total_us, 30);
+  EXPECT_STREQ(latencies[0].tag, "op");
+}
+
+TEST(SamplingProfilerTest, Percentiles) {
+  SamplingProfiler profiler(/*sampling_period=*/1);
+  for (int i = 1; i <= 100; ++i) {
+    Invoke(&profiler, /*op_index=*/3, /*us=*/i);
+    Invoke(&profiler, /*op_index=*/5, /*us=*/1000);
+  }
+  const std::vector<SamplingProfiler::OpLatency> latencies =
+      profiler.GetOpLatencies();
+  ASSERT_EQ(latencies.size(), 2);
+  EXPECT_EQ(latencies[0].op_index, 3);
+  EXPECT_EQ(latencies[0].num_samples, 100);
+  // Within 1/16 of the actual percentiles.
+  EXPECT_NEAR(latencies[0].p50_us, 50, 50 / 16.0);
+  EXPECT_NEAR(latencies[0].p90_us, 90, 90 / 16.0);
+  EXPECT_NEAR(latencies[0].p99_us, 99, 99 / 16.0);
+  EXPECT_EQ(latencies[1].op_index, 5);
+  EXPECT_NEAR(latencies[1].p50_us, 1000, 1000 / 16.0);
+  EXPECT_EQ(latencies[1].p50_us, latencies[1].p99_us);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.GetOpLatencies().empty());
+}
+
+TEST(SamplingProfilerTest, MeasuresOpEvents) {
+  SamplingProfiler profiler(/*sampling_period=*/1);
+  {
+    ScopedRuntimeInstrumentationProfile invoke(&profiler, "invoke");
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(&profiler, "op", 1);
+    TFLITE_SCOPED_DELEGATE_OPERATOR_PROFILE(&profiler, "delegate_op", 1);
+  }
+  const std::vector<SamplingProfiler::OpLatency> latencies =
+      profiler.GetOpLatencies();
+  ASSERT_EQ(latencies.size(), 2);
+  EXPECT_EQ(latencies[0].event_type, EventType::OPERATOR_INVOKE_EVENT);
+  EXPECT_EQ(latencies[1].event_type,
+            EventType::DELEGATE_OPERATOR_INVOKE_EVENT);
+  EXPECT_EQ(latencies[1].num_samples, 1);
+}
+
+TEST(SamplingProfilerTest, DropsOpsOverLimit) {
+  SamplingProfiler profiler(/*sampling_period=*/1, /*max_num_ops=*/2);
+  for (int op_index = 0; op_index < 4; ++op_index) {
+    Invoke(&profiler, op_index, /*us=*/1);
+  }
+  Invoke(&profiler, /*op_index=*/1, /*us=*/1);
+  EXPECT_EQ(profiler.GetOpLatencies().size(), 2);
+  EXPECT_EQ(profiler.GetOpLatencies()[1].num_samples, 2);
+  EXPECT_EQ(profiler.num_dropped_ops(), 2);
+}
+
+class MockTelemetryProfiler : public telemetry::TelemetryProfiler {
+ public:
+  MOCK_METHOD(void, ReportTelemetryEvent,
+              (const char* event_name, telemetry::TelemetryStatusCode status),
+              (override));
+  MOCK_METHOD(void, ReportTelemetryOpEvent,
+              (const char* event_name, int64_t op_idx, int64_t subgraph_idx,
+               telemetry::TelemetryStatusCode status),
+              (override));
+  MOCK_METHOD(void, ReportSettings,
+              (const char* setting_name,
+               const TfLiteTelemetrySettings* settings),
+              (override));
+  MOCK_METHOD(uint32_t, ReportBeginOpInvokeEvent,
+              (const char* op_name, int64_t op_idx, int64_t subgraph_idx),
+              (override));
+  MOCK_METHOD(void, ReportEndOpInvokeEvent, (uint32_t event_handle),
+              (override));
+  MOCK_METHOD(void, ReportOpInvokeEvent,
+              (const char* op_name, uint64_t elapsed_time, int64_t op_idx,
+               int64_t subgraph_idx),
+              (override));
+};
+
+TEST(SamplingProfilerTest, ReportsToTelemetry) {
+  SamplingProfiler profiler(/*sampling_period=*/1);
+  Invoke(&profiler, /*op_index=*/7, /*us=*/100);
+  MockTelemetryProfiler telemetry_profiler;
+  EXPECT_CALL(telemetry_profiler, ReportSettings(StrEq(kOpLatencySettingName),
+                                                 _))
+      .WillOnce([](const char*, const TfLiteTelemetrySettings* settings) {
+        EXPECT_EQ(settings->source,
+                  static_cast<uint32_t>(
+                      telemetry::TelemetrySource::TFLITE_INTERPRETER));
+        const auto* op_latencies =
+            static_cast<const TfLiteTelemetryOpLatencySettings*>(
+                settings->data);
+        ASSERT_EQ(TfLiteTelemetryOpLatencySettingsGetNumOps(op_latencies), 1);
+        EXPECT_STREQ(
+            TfLiteTelemetryOpLatencySettingsGetOpName(op_latencies, 0), "op");
+        EXPECT_EQ(TfLiteTelemetryOpLatencySettingsGetOpIndex(op_latencies, 0),
+                  7);
+        EXPECT_EQ(
+            TfLiteTelemetryOpLatencySettingsGetNumSamples(op_latencies, 0), 1);
+        EXPECT_NEAR(TfLiteTelemetryOpLatencySettingsGetLatencyPercentileUs(
+                        op_latencies, 0, 99),
+                    100, 100 / 16.0);
+        EXPECT_EQ(TfLiteTelemetryOpLatencySettingsGetLatencyPercentileUs(
+                      op_latencies, 0, 75),
+                  0);
+      });
+  profiler.ReportTo(&telemetry_profiler);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
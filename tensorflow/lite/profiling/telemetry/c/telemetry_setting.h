@@ -34,7 +34,8 @@ typedef struct TfLiteTelemetrySettings {
 
   // Settings data. Interpretation based on `source`.
   // If `source` is TFLITE_INTERPRETER, the type of `data` will
-  // be `TelemetryInterpreterSettings`.
+  // be `TelemetryInterpreterSettings`, or `TfLiteTelemetryOpLatencySettings`
+  // for the "op_latency" setting.
   // Otherwise, the data is provided by the individual delegate.
   // Owned by the caller that exports TelemetrySettings (e.g. Interpreter).
   const void* data;
@@ -84,6 +85,32 @@ size_t TfLiteTelemetryGpuDelegateSettingsGetNumNodesDelegated(
 int TfLiteTelemetryGpuDelegateSettingsGetBackend(
     const TfLiteTelemetryGpuDelegateSettings* settings);
 
+// Latency percentiles of the ops, measured over sampled invocations.
+typedef struct TfLiteTelemetryOpLatencySettings
+    TfLiteTelemetryOpLatencySettings;
+
+size_t TfLiteTelemetryOpLatencySettingsGetNumOps(
+    const TfLiteTelemetryOpLatencySettings* settings);
+
+// The following take the index of an op, below the number of ops.
+const char* TfLiteTelemetryOpLatencySettingsGetOpName(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index);
+
+int64_t TfLiteTelemetryOpLatencySettingsGetOpIndex(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index);
+
+int64_t TfLiteTelemetryOpLatencySettingsGetSubgraphIndex(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index);
+
+uint64_t TfLiteTelemetryOpLatencySettingsGetNumSamples(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index);
+
+// Returns the `percentile`th percentile of the latency, in microseconds.
+// `percentile` is one of 50, 90 and 99; other values return 0.
+uint64_t TfLiteTelemetryOpLatencySettingsGetLatencyPercentileUs(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index,
+    int percentile);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -72,4 +72,51 @@ int TfLiteTelemetryGpuDelegateSettingsGetBackend(
   return settings->backend;
 }
 
+size_t TfLiteTelemetryOpLatencySettingsGetNumOps(
+    const TfLiteTelemetryOpLatencySettings* settings) {
+  if (settings == nullptr) return 0;
+  return settings->ops.size();
+}
+
+const char* TfLiteTelemetryOpLatencySettingsGetOpName(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index) {
+  if (settings == nullptr || index >= settings->ops.size()) return nullptr;
+  return settings->ops[index].op_name;
+}
+
+int64_t TfLiteTelemetryOpLatencySettingsGetOpIndex(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index) {
+  if (settings == nullptr || index >= settings->ops.size()) return -1;
+  return settings->ops[index].op_index;
+}
+
+int64_t TfLiteTelemetryOpLatencySettingsGetSubgraphIndex(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index) {
+  if (settings == nullptr || index >= settings->ops.size()) return -1;
+  return settings->ops[index].subgraph_index;
+}
+
+uint64_t TfLiteTelemetryOpLatencySettingsGetNumSamples(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index) {
+  if (settings == nullptr || index >= settings->ops.size()) return 0;
+  return settings->ops[index].num_samples;
+}
+
+uint64_t TfLiteTelemetryOpLatencySettingsGetLatencyPercentileUs(
+    const TfLiteTelemetryOpLatencySettings* settings, size_t index,
+    int percentile) {
+  if (settings == nullptr || index >= settings->ops.size()) return 0;
+  const auto& op = settings->ops[index];
+  switch (percentile) {
+    case 50:
+      return op.p50_us;
+    case 90:
+      return op.p90_us;
+    case 99:
+      return op.p99_us;
+    default:
+      return 0;
+  }
+}
+
 }  // extern "C"
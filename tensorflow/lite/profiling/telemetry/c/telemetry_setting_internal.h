@@ -51,6 +51,19 @@ struct TfLiteTelemetryGpuDelegateSettings {
   Backend backend;
 };
 
+struct TfLiteTelemetryOpLatencySettings {
+  struct OpLatency {
+    const char* op_name;
+    int64_t op_index;
+    int64_t subgraph_index;
+    uint64_t num_samples;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+  };
+  std::vector<OpLatency> ops;
+};
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -160,6 +160,16 @@ class SimpleMemoryArena {
 
   size_t GetBufferSize() const { return underlying_buffer_.GetSize(); }
 
+  // Size the buffer needs to be to hold all allocations made so far.
+  size_t RequiredBufferSize() const { return high_water_mark_; }
+
+  // Replaces the allocation plan, but not the buffer, with that of `other`.
+  // This lets a scratch arena try out allocations on top of an existing plan.
+  void CopyPlanFrom(const SimpleMemoryArena& other) {
+    high_water_mark_ = other.high_water_mark_;
+    active_allocs_ = other.active_allocs_;
+  }
+
   std::intptr_t BasePointer() const {
     return reinterpret_cast<std::intptr_t>(underlying_buffer_.GetPtr());
   }
@@ -0,0 +1,259 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_multi_model.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/memory_usage_monitor.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+// Exposes the steps of BenchmarkModel::Run(), so that the requests can be
+// driven from outside.
+class ScenarioModel : public BenchmarkTfLiteModel {
+ public:
+  using BenchmarkTfLiteModel::PrepareInputData;
+  using BenchmarkTfLiteModel::ResetInputsAndOutputs;
+};
+
+// The latencies of the requests of `model` until `end_us`.
+struct ModelRun {
+  ScenarioModel* model;
+  std::vector<int64_t> latencies_us;
+  TfLiteStatus status = kTfLiteOk;
+};
+
+void DriveModel(int64_t start_us, int64_t end_us, ModelRun* run) {
+  const float rate = run->model->mutable_params()->Get<float>("run_frequency");
+  const double interval_us = rate > 0 ? 1e6 / rate : 0;
+  // When the next request is due. Requests are due right away when the model
+  // runs back to back, or falls behind its rate.
+  double due_us = start_us;
+  while (due_us < end_us) {
+    const int64_t now_us = profiling::time::NowMicros();
+    if (now_us >= end_us) break;
+    if (now_us < due_us) {
+      profiling::time::SleepForMicros(static_cast<uint64_t>(due_us - now_us));
+    }
+    const int64_t request_start_us =
+        rate > 0 ? static_cast<int64_t>(due_us) : profiling::time::NowMicros();
+    run->model->ResetInputsAndOutputs();
+    run->status = run->model->RunImpl();
+    const int64_t request_end_us = profiling::time::NowMicros();
+    if (run->status != kTfLiteOk) return;
+    run->latencies_us.push_back(request_end_us - request_start_us);
+    due_us = rate > 0 ? due_us + interval_us : request_end_us;
+  }
+}
+
+float ToMegabytes(int64_t kilobytes) { return kilobytes / 1024.0f; }
+
+}  // namespace
+
+TfLiteStatus ParseScenario(const std::string& scenario,
+                           std::vector<std::vector<std::string>>* model_flags) {
+  model_flags->clear();
+  std::istringstream lines(scenario);
+  std::string line;
+  while (std::getline(lines, line)) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream words(line);
+    std::vector<std::string> flags;
+    for (std::string flag; words >> flag;) {
+      flags.push_back(flag);
+    }
+    if (!flags.empty()) {
+      model_flags->push_back(std::move(flags));
+    }
+  }
+  if (model_flags->empty()) {
+    TFLITE_LOG(ERROR) << "The scenario has no models.";
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+LatencySummary SummarizeLatencies(std::vector<int64_t> latencies_us) {
+  LatencySummary summary;
+  if (latencies_us.empty()) return summary;
+  std::sort(latencies_us.begin(), latencies_us.end());
+  const auto percentile = [&latencies_us](int p) {
+    // The nearest rank.
+    const size_t rank = (p * latencies_us.size() + 99) / 100;
+    return latencies_us[std::max<size_t>(rank, 1) - 1];
+  };
+  summary.count = latencies_us.size();
+  summary.avg_us =
+      std::accumulate(latencies_us.begin(), latencies_us.end(), 0.0) /
+      latencies_us.size();
+  summary.p50_us = percentile(50);
+  summary.p90_us = percentile(90);
+  summary.p99_us = percentile(99);
+  summary.max_us = latencies_us.back();
+  return summary;
+}
+
+TfLiteStatus BenchmarkMultiModel::Run(
+    const std::vector<std::vector<std::string>>& model_flags,
+    const Options& options, Results* results) {
+  std::vector<std::unique_ptr<ScenarioModel>> models;
+  for (const std::vector<std::string>& flags : model_flags) {
+    models.push_back(std::make_unique<ScenarioModel>());
+    ScenarioModel* model = models.back().get();
+    std::vector<std::string> args = {"benchmark_model"};
+    args.insert(args.end(), flags.begin(), flags.end());
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+      argv.push_back(&arg[0]);
+    }
+    int argc = argv.size();
+    TF_LITE_ENSURE_STATUS(model->ParseFlags(&argc, argv.data()));
+    if (argc > 1) {
+      TFLITE_LOG(ERROR) << "Unknown flags for model " << models.size() << ": "
+                        << Flags::ArgsToString(
+                               argc, const_cast<const char**>(argv.data()));
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(model->ValidateParams());
+    TF_LITE_ENSURE_STATUS(model->Init());
+    TF_LITE_ENSURE_STATUS(model->PrepareInputData());
+    const int warmup_runs =
+        model->mutable_params()->Get<int32_t>("warmup_runs");
+    for (int i = 0; i < warmup_runs; ++i) {
+      TF_LITE_ENSURE_STATUS(model->ResetInputsAndOutputs());
+      TF_LITE_ENSURE_STATUS(model->RunImpl());
+    }
+  }
+
+  std::vector<ModelRun> runs;
+  for (const auto& model : models) {
+    runs.push_back({model.get()});
+  }
+  profiling::memory::MemoryUsageMonitor memory_monitor(
+      options.memory_footprint_check_interval_ms);
+  memory_monitor.Start();
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t end_us =
+      start_us + static_cast<int64_t>(options.duration_secs * 1e6);
+  std::vector<std::thread> threads;
+  for (ModelRun& run : runs) {
+    threads.emplace_back(DriveModel, start_us, end_us, &run);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const double elapsed_secs = (profiling::time::NowMicros() - start_us) * 1e-6;
+  memory_monitor.Stop();
+
+  *results = Results();
+  int64_t num_requests = 0;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    if (runs[i].status != kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Model " << i + 1 << " failed to run.";
+      return runs[i].status;
+    }
+    ModelResults model_results;
+    model_results.graph =
+        models[i]->mutable_params()->Get<std::string>("graph");
+    model_results.latency = SummarizeLatencies(std::move(runs[i].latencies_us));
+    model_results.requests_per_second =
+        model_results.latency.count / elapsed_secs;
+    num_requests += model_results.latency.count;
+    results->models.push_back(std::move(model_results));
+  }
+  results->requests_per_second = num_requests / elapsed_secs;
+  results->peak_mem_mb = memory_monitor.GetPeakMemUsageInMB();
+  if (profiling::memory::MemoryUsage::IsSupported()) {
+    results->mem_footprint_high_water_mb =
+        ToMegabytes(profiling::memory::GetMemoryUsage().mem_footprint_kb);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkMultiModel::Run(int argc, char** argv) {
+  std::string scenario_path;
+  Options options;
+  std::vector<Flag> flags = {
+      Flag::CreateFlag("scenario", &scenario_path,
+                       "Path to the scenario file, with the benchmark_model "
+                       "flags of one model per line."),
+      Flag::CreateFlag("duration_secs", &options.duration_secs,
+                       "How long the models run concurrently."),
+      Flag::CreateFlag("memory_footprint_check_interval_ms",
+                       &options.memory_footprint_check_interval_ms,
+                       "The interval at which the peak memory footprint is "
+                       "sampled."),
+  };
+  if (!Flags::Parse(&argc, const_cast<const char**>(argv), flags) ||
+      scenario_path.empty()) {
+    TFLITE_LOG(ERROR) << Flags::Usage(argv[0], flags);
+    return kTfLiteError;
+  }
+  std::ifstream file(scenario_path);
+  if (!file) {
+    TFLITE_LOG(ERROR) << "Failed to read " << scenario_path;
+    return kTfLiteError;
+  }
+  std::stringstream scenario;
+  scenario << file.rdbuf();
+  std::vector<std::vector<std::string>> model_flags;
+  TF_LITE_ENSURE_STATUS(ParseScenario(scenario.str(), &model_flags));
+
+  Results results;
+  TF_LITE_ENSURE_STATUS(Run(model_flags, options, &results));
+  for (size_t i = 0; i < results.models.size(); ++i) {
+    const ModelResults& model = results.models[i];
+    TFLITE_LOG(INFO) << "Model " << i + 1 << " (" << model.graph
+                     << "): count=" << model.latency.count
+                     << " requests/s=" << model.requests_per_second
+                     << " latency (ms): avg=" << model.latency.avg_us / 1e3
+                     << " p50=" << model.latency.p50_us / 1e3
+                     << " p90=" << model.latency.p90_us / 1e3
+                     << " p99=" << model.latency.p99_us / 1e3
+                     << " max=" << model.latency.max_us / 1e3;
+  }
+  TFLITE_LOG(INFO) << "Total throughput (requests/s): "
+                   << results.requests_per_second;
+  if (results.peak_mem_mb > 0) {
+    TFLITE_LOG(INFO) << "Peak memory footprint (MB) while running: "
+                     << results.peak_mem_mb;
+  }
+  if (results.mem_footprint_high_water_mb > 0) {
+    TFLITE_LOG(INFO) << "Memory footprint high-water mark (MB): "
+                     << results.mem_footprint_high_water_mb;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Parses a multi-model scenario. Each line has the benchmark_model flags of a
+// model, e.g.
+//
+//   # A detector at 30 requests per second, and a classifier as fast as it
+//   # goes, each on its own interpreter.
+//   --graph=/data/detector.tflite --num_threads=2 --run_frequency=30
+//   --graph=/data/classifier.tflite --use_xnnpack=true
+//
+// Empty lines, and the rest of a line after '#', are ignored. The same model
+// may appear on several lines, to simulate several clients.
+TfLiteStatus ParseScenario(const std::string& scenario,
+                           std::vector<std::vector<std::string>>* model_flags);
+
+// The latencies of the requests to a model.
+struct LatencySummary {
+  int64_t count = 0;
+  double avg_us = 0;
+  int64_t p50_us = 0;
+  int64_t p90_us = 0;
+  int64_t p99_us = 0;
+  int64_t max_us = 0;
+};
+
+LatencySummary SummarizeLatencies(std::vector<int64_t> latencies_us);
+
+// Benchmarks several models that run concurrently in one process, each on its
+// own interpreter and thread, to measure the effect of contention for cores,
+// caches, memory bandwidth and accelerators. The models are driven open-loop
+// at their --run_frequency if it is set, or else back to back; the latency of
+// a request is measured from the time it was due, so that it includes the
+// time spent waiting for a model that falls behind its rate.
+class BenchmarkMultiModel {
+ public:
+  struct ModelResults {
+    std::string graph;
+    LatencySummary latency;
+    double requests_per_second = 0;
+  };
+
+  struct Results {
+    std::vector<ModelResults> models;
+    double requests_per_second = 0;
+    // The peak memory footprint while the models ran, as sampled every
+    // `memory_footprint_check_interval_ms`, and the high-water mark of the
+    // process, i.e. its maximum resident set size on Linux. Negative if not
+    // supported.
+    float peak_mem_mb = -1;
+    float mem_footprint_high_water_mb = -1;
+  };
+
+  struct Options {
+    float duration_secs = 10;
+    int memory_footprint_check_interval_ms = 50;
+  };
+
+  // Runs the scenario of the --scenario flag, and logs the results.
+  TfLiteStatus Run(int argc, char** argv);
+
+  // Runs the models with the given benchmark_model flags concurrently.
+  TfLiteStatus Run(const std::vector<std::vector<std::string>>& model_flags,
+                   const Options& options, Results* results);
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
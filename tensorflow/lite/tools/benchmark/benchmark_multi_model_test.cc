@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_multi_model.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace {
+std::string* g_model_path = nullptr;
+}  // namespace
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+TEST(ParseScenarioTest, ParsesFlagsOfEachModel) {
+  std::vector<std::vector<std::string>> model_flags;
+  ASSERT_EQ(ParseScenario("# Two models.\n"
+                          "--graph=a.tflite --num_threads=2  # Detector.\n"
+                          "\n"
+                          "  --graph=b.tflite\t--run_frequency=30\n",
+                          &model_flags),
+            kTfLiteOk);
+  ASSERT_EQ(model_flags.size(), 2);
+  EXPECT_EQ(model_flags[0],
+            std::vector<std::string>({"--graph=a.tflite", "--num_threads=2"}));
+  EXPECT_EQ(model_flags[1], std::vector<std::string>(
+                                {"--graph=b.tflite", "--run_frequency=30"}));
+}
+
+TEST(ParseScenarioTest, FailsWithoutModels) {
+  std::vector<std::vector<std::string>> model_flags;
+  EXPECT_EQ(ParseScenario("# Nothing.\n\n", &model_flags), kTfLiteError);
+}
+
+TEST(SummarizeLatenciesTest, ComputesNearestRankPercentiles) {
+  std::vector<int64_t> latencies_us;
+  for (int i = 100; i > 0; --i) {
+    latencies_us.push_back(i);
+  }
+  const LatencySummary summary = SummarizeLatencies(latencies_us);
+  EXPECT_EQ(summary.count, 100);
+  EXPECT_DOUBLE_EQ(summary.avg_us, 50.5);
+  EXPECT_EQ(summary.p50_us, 50);
+  EXPECT_EQ(summary.p90_us, 90);
+  EXPECT_EQ(summary.p99_us, 99);
+  EXPECT_EQ(summary.max_us, 100);
+
+  EXPECT_EQ(SummarizeLatencies({7}).p50_us, 7);
+  EXPECT_EQ(SummarizeLatencies({}).count, 0);
+}
+
+TEST(BenchmarkMultiModelTest, RunsModelsConcurrently) {
+  ASSERT_NE(g_model_path, nullptr);
+  const std::string graph = "--graph=" + *g_model_path;
+  BenchmarkMultiModel::Options options;
+  options.duration_secs = 0.5f;
+  BenchmarkMultiModel::Results results;
+  ASSERT_EQ(BenchmarkMultiModel().Run(
+                {{graph}, {graph, "--num_threads=2", "--run_frequency=20"}},
+                options, &results),
+            kTfLiteOk);
+
+  ASSERT_EQ(results.models.size(), 2);
+  EXPECT_EQ(results.models[0].graph, *g_model_path);
+  EXPECT_GT(results.models[0].latency.count, 0);
+  // About 10 requests at 20 per second.
+  EXPECT_GT(results.models[1].latency.count, 0);
+  EXPECT_LE(results.models[1].latency.count, 11);
+  EXPECT_LE(results.models[1].latency.p50_us, results.models[1].latency.max_us);
+  EXPECT_GT(results.requests_per_second, results.models[1].requests_per_second);
+}
+
+TEST(BenchmarkMultiModelTest, FailsOnUnknownFlags) {
+  ASSERT_NE(g_model_path, nullptr);
+  BenchmarkMultiModel::Results results;
+  EXPECT_EQ(BenchmarkMultiModel().Run({{"--graph=" + *g_model_path, "--foo=1"}},
+                                      {}, &results),
+            kTfLiteError);
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  std::string model_path;
+  std::vector<tflite::Flag> flags = {
+      tflite::Flag::CreateFlag("graph", &model_path, "Path to a model file."),
+  };
+  g_model_path = &model_path;
+  const bool parse_result =
+      tflite::Flags::Parse(&argc, const_cast<const char**>(argv), flags);
+  if (!parse_result) {
+    std::cerr << tflite::Flags::Usage(argv[0], flags);
+    return 1;
+  }
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
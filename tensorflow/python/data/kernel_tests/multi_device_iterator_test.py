@@ -14,6 +14,8 @@
 # ==============================================================================
 """Tests for the `MultiDeviceIterator` and `OwnedMultiDeviceIterator` API."""
 
+import time
+
 from absl.testing import parameterized
 import numpy as np
 
@@ -147,7 +149,8 @@ class MultiDeviceIteratorTest(test_base.DatasetTestBase,
       combinations.times(
           test_base.default_test_combinations(),
           combinations.combine(
-              max_buffer_size=[0, 1, 10], prefetch_buffer_size=[0, 1, 10])))
+              max_buffer_size=[0, 1, 10, dataset_ops.AUTOTUNE],
+              prefetch_buffer_size=[0, 1, 10])))
   def testBasic(self, prefetch_buffer_size, max_buffer_size):
     dataset = dataset_ops.Dataset.range(10)
     multi_device_iterator = multi_device_iterator_ops.MultiDeviceIterator(
@@ -266,6 +269,43 @@ class MultiDeviceIteratorTest(test_base.DatasetTestBase,
       self.evaluate(elem_on_1)
       self.evaluate(elem_on_2)
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testAutotuneBufferSize(self):
+    produced = [0]
+
+    def generator():
+      for i in range(1000):
+        # Slower than the consumer, so that it can find the buffers empty.
+        time.sleep(0.02)
+        produced[0] += 1
+        yield i
+
+    dataset = dataset_ops.Dataset.from_generator(
+        generator, output_signature=tensor_spec.TensorSpec([], dtypes.int64))
+    options = options_lib.Options()
+    options.autotune.enabled = False
+    options.experimental_optimization.inject_prefetch = False
+    dataset = dataset.with_options(options)
+    # Without device prefetching, only the host buffers run ahead of the
+    # consumer.
+    multi_device_iterator = multi_device_iterator_ops.MultiDeviceIterator(
+        dataset, [self._devices[1], self._devices[2]],
+        max_buffer_size=dataset_ops.AUTOTUNE,
+        prefetch_buffer_size=0)
+
+    consumed = 0
+    for _ in range(4):
+      # Lets the buffers fill up, then drains them, which grows them.
+      time.sleep(1)
+      for _ in range(20):
+        elem_on_1, elem_on_2 = multi_device_iterator.get_next()
+        self.assertEqual(consumed, self.evaluate(elem_on_1))
+        self.assertEqual(consumed + 1, self.evaluate(elem_on_2))
+        consumed += 2
+    time.sleep(2)
+    # A buffer of a fixed size of 1 would hold one element per device.
+    self.assertGreaterEqual(produced[0] - consumed, 2 * 4)
+
   @combinations.generate(test_base.graph_only_combinations())
   def testMultipleInitializationsGraph(self):
     dataset1 = dataset_ops.Dataset.range(1000)
@@ -328,7 +368,8 @@ class OwnedMultiDeviceIteratorTest(test_base.DatasetTestBase,
       combinations.times(
           test_base.eager_only_combinations(),
           combinations.combine(
-              max_buffer_size=[0, 1, 10], prefetch_buffer_size=[0, 1, 10])))
+              max_buffer_size=[0, 1, 10, dataset_ops.AUTOTUNE],
+              prefetch_buffer_size=[0, 1, 10])))
   def testBasic(self, max_buffer_size, prefetch_buffer_size):
     dataset = dataset_ops.Dataset.range(1000)
 
@@ -24,6 +24,8 @@ class Flags:
     enable_nested_function_shape_inference: Flag
     enable_quantized_dtypes_training: Flag
     enable_tf2min_ici_weight: Flag
+    enable_transfer_aware_placement: Flag
+    inline_small_function_calls: Flag
     graph_building_optimization: Flag
     more_stack_traces: Flag
     op_building_optimization: Flag
@@ -166,6 +166,17 @@ class UniqueTest(test.TestCase):
     self.assertAllEqual(tf_y, true_y)
     self.assertAllEqual(tf_idx, true_idx)
 
+  def testLargeOrderedByAppearance(self):
+    # Large enough to be uniquified by several threads.
+    x = np.random.randint(0, high=100000, size=(1 << 21) + 3)
+    _, first, inverse = np.unique(x, return_index=True, return_inverse=True)
+    order = np.argsort(first)
+    rank = np.argsort(order)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+    self.assertAllEqual(tf_y, x[first[order]])
+    self.assertAllEqual(tf_idx, rank[inverse])
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -313,6 +324,18 @@ class UniqueWithCountsTest(test.TestCase):
     self.assertAllEqual(tf_idx, true_idx)
     self.assertAllEqual(tf_count, true_count)
 
+  def testLargeOrderedByAppearance(self):
+    x = np.random.randint(0, high=100000, size=(1 << 21) + 3)
+    _, first, inverse, counts = np.unique(
+        x, return_index=True, return_inverse=True, return_counts=True)
+    order = np.argsort(first)
+    rank = np.argsort(order)
+    y, idx, count = array_ops.unique_with_counts(x, out_idx=dtypes.int64)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+    self.assertAllEqual(tf_y, x[first[order]])
+    self.assertAllEqual(tf_idx, rank[inverse])
+    self.assertAllEqual(tf_count, counts[order])
+
 
 if __name__ == '__main__':
   test.main()
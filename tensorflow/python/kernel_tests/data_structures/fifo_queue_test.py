@@ -1278,6 +1278,32 @@ class FIFOQueueParallelTests(test.TestCase):
       self.assertEqual([50.0], self.evaluate(dequeued_t))
       thread.join()
 
+  def testEnqueueDoesNotOvertakeBlockedEnqueue(self):
+    # We need each thread to keep its own device stack or the device scopes
+    # won't be properly nested.
+    ops.get_default_graph().switch_to_thread_local()
+    with self.cached_session() as sess:
+      q = data_flow_ops.FIFOQueue(1, dtypes_lib.float32)
+      enqueue_ops = [q.enqueue((elem,)) for elem in [10.0, 20.0, 30.0]]
+      dequeued_t = q.dequeue()
+
+      enqueue_ops[0].run()
+
+      def blocking_enqueue(i):
+        self.evaluate(enqueue_ops[i])
+
+      threads = []
+      for i in [1, 2]:
+        threads.append(self.checkedThread(target=blocking_enqueue, args=(i,)))
+        threads[-1].start()
+        # Each enqueue should block before the next one starts.
+        # TODO(mrry): Figure out how to do this without sleeping.
+        time.sleep(0.1)
+      for elem in [10.0, 20.0, 30.0]:
+        self.assertEqual([elem], self.evaluate(dequeued_t))
+      for thread in threads:
+        thread.join()
+
   def testBlockingEnqueueManyToFullQueue(self):
     # We need each thread to keep its own device stack or the device scopes
     # won't be properly nested.
@@ -563,6 +563,25 @@ class CSRSparseMatrixOpsTest(test.TestCase, parameterized.TestCase):
       expected_c_value = a_sparse_mat.dot(b)
       self.assertAllClose(expected_c_value, c_value)
 
+  @test_util.run_in_graph_and_eager_modes
+  def testSparseMatrixMatMulSkewedRows(self):
+    # A few dense rows hold most of the nonzeros, as in power-law graphs, so
+    # that shards balanced by nonzeros split the batch unevenly by rows.
+    for transpose_a in [False, True]:
+      a_dense = np.zeros((3, 300, 200), dtype=np.float32)
+      a_dense[:, [0, 7, 150], :] = np.random.randn(3, 3, 200)
+      a_dense[:, 200:, 5] = 1.0
+      b = np.random.randn(3, 300 if transpose_a else 200, 16).astype(
+          np.float32)
+
+      a_sm = dense_to_csr_sparse_matrix(a_dense)
+      c = sparse_csr_matrix_ops.sparse_matrix_mat_mul(
+          a=a_sm, b=b, transpose_a=transpose_a)
+      c_value = self.evaluate(c)
+
+      a_op = np.transpose(a_dense, [0, 2, 1]) if transpose_a else a_dense
+      self.assertAllClose(np.matmul(a_op, b), c_value, rtol=1e-4, atol=1e-4)
+
   @test_util.run_in_graph_and_eager_modes
   def testSparseMatrixMatMulConjugateOutput(self):
     for shapes in [[(5, 6), (6, 1)], [(5, 6), (6, 2)]]:
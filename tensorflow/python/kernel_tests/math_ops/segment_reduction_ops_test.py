@@ -146,6 +146,29 @@ class SegmentReductionOpTest(SegmentReductionHelper, parameterized.TestCase):
             # and may therefore vary dynamically.
             self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
+  def testSkewedSegments(self):
+    # Large enough to be split across threads, with segments that span several
+    # partitions, holes, and runs of short segments.
+    lengths = [60000, 3, 1, 25000, 1, 1, 7, 9000, 2, 5000]
+    ids = np.array([0, 2, 3, 4, 7, 8, 9, 12, 13, 14])
+    indices = np.repeat(ids, lengths)
+    x = np.random.uniform(-1, 1, size=(indices.size, 4))
+    signs = np.where(x > 0, 1, -1).astype(np.int32)
+    ends = np.cumsum(lengths)
+    starts = ends - lengths
+    for tf_op, np_op, data, empty_value in [
+        (math_ops.segment_sum, np.sum, x, 0),
+        (math_ops.segment_mean, np.mean, x, 0),
+        (math_ops.segment_min, np.min, x, 0),
+        (math_ops.segment_max, np.max, x, 0),
+        (math_ops.segment_prod, np.prod, signs, 1)]:
+      expected = np.full((ids[-1] + 1, 4), empty_value, dtype=data.dtype)
+      for segment, start, end in zip(ids, starts, ends):
+        expected[segment] = np_op(data[start:end], axis=0)
+      with self.cached_session(use_gpu=False):
+        result = self.evaluate(tf_op(data=data, segment_ids=indices))
+      self.assertAllClose(expected, result)
+
   @test_util.run_deprecated_v1
   def testSegmentIdsShape(self):
     shape = [4, 4]
@@ -195,6 +195,24 @@ class TopKTest(test.TestCase):
       values = -np.sort(-inputs, axis=1)[:, :k]
       self._validateTopK(inputs, k, values, indices)
 
+  def testLongRowsStableSort(self):
+    # Rows long enough to be split across threads, with repeated values.
+    b = 2
+    n = 300000
+    for k, is_sorted in [(1000, True), (1000, False), (100, True)]:
+      inputs = np.random.randint(0, 5000, size=(b, n)).astype(np.int32)
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      with self.cached_session():
+        values_op, indices_op = nn_ops.top_k(inputs, k, sorted=is_sorted)
+        tf_values, tf_indices = self.evaluate([values_op, indices_op])
+      if not is_sorted:
+        order = np.lexsort((tf_indices, -tf_values))
+        tf_values = np.take_along_axis(tf_values, order, axis=1)
+        tf_indices = np.take_along_axis(tf_indices, order, axis=1)
+      self.assertAllEqual(values, tf_values)
+      self.assertAllEqual(indices, tf_indices)
+
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 4, [[0.4, 0.3, 0.2, 0.1], [0.3, 0.3, 0.2, 0.1]],
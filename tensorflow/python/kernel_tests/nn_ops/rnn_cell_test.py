@@ -1468,6 +1468,45 @@ class LSTMTest(test.TestCase):
           )
       )
 
+  @test_util.run_in_graph_and_eager_modes
+  def testBlockLSTMMatchesLSTMBlockCells(self):
+    # Odd sizes make the time slices unaligned.
+    time_len, seq_len_max, batch_size, input_size, cell_size = 5, 4, 3, 7, 5
+    np.random.seed(1)
+    x = constant_op.constant(
+        np.random.randn(time_len, batch_size, input_size), dtypes.float32)
+    cs_prev = constant_op.constant(
+        np.random.randn(batch_size, cell_size), dtypes.float32)
+    h_prev = constant_op.constant(
+        np.random.randn(batch_size, cell_size), dtypes.float32)
+    w = constant_op.constant(
+        np.random.randn(input_size + cell_size, 4 * cell_size) * 0.5,
+        dtypes.float32)
+    wci, wcf, wco = [
+        constant_op.constant(np.random.randn(cell_size), dtypes.float32)
+        for _ in range(3)
+    ]
+    b = constant_op.constant(np.random.randn(4 * cell_size), dtypes.float32)
+
+    block = gen_rnn_ops.block_lstm(
+        seq_len_max=constant_op.constant(seq_len_max, dtypes.int64),
+        x=x, cs_prev=cs_prev, h_prev=h_prev, w=w, wci=wci, wcf=wcf, wco=wco,
+        b=b, forget_bias=1.0, cell_clip=3.0, use_peephole=True)
+    cells = []
+    for t in range(seq_len_max):
+      cell = gen_rnn_ops.lstm_block_cell(
+          x=x[t], cs_prev=cs_prev, h_prev=h_prev, w=w, wci=wci, wcf=wcf,
+          wco=wco, b=b, forget_bias=1.0, cell_clip=3.0, use_peephole=True)
+      cells.append(cell)
+      cs_prev, h_prev = cell.cs, cell.h
+
+    block, cells = self.evaluate([block, cells])
+    for name, outputs in zip(block._fields, block):
+      expected = np.stack([getattr(cell, name) for cell in cells])
+      self.assertAllClose(expected, outputs[:seq_len_max], atol=1e-5)
+    self.assertAllEqual(np.zeros([batch_size, cell_size]), block.h[-1])
+    self.assertAllEqual(np.zeros([batch_size, cell_size]), block.cs[-1])
+
 
 class BidirectionalRNNTest(test.TestCase):
 
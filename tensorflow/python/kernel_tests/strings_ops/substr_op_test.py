@@ -375,6 +375,28 @@ class SubstrOpTest(test.TestCase, parameterized.TestCase):
       with self.assertRaises(errors_impl.InvalidArgumentError):
         self.evaluate(substr_op)
 
+  @parameterized.parameters(
+      (np.int32, "BYTE"),
+      (np.int64, "BYTE"),
+      (np.int32, "UTF8_CHAR"),
+      (np.int64, "UTF8_CHAR"),
+  )
+  def testOutOfRangeError_ManyStrings(self, dtype, unit):
+    # Enough strings to be sharded, of which the first too short is reported.
+    test_string = [b"good"] * 100000
+    test_string[70000] = b"ba"
+    test_string[30000] = b"b"
+    position = np.array(3, dtype)
+    length = np.array(1, dtype)
+    with self.assertRaisesRegex(errors_impl.InvalidArgumentError,
+                                "at index 30000"):
+      self.evaluate(
+          string_ops.substr(test_string, position, length, unit=unit))
+    self.assertAllEqual(
+        self.evaluate(
+            string_ops.substr(test_string[:30000], position, length,
+                              unit=unit)), [b"d"] * 30000)
+
   @parameterized.parameters(
       (np.int32, "BYTE"),
       (np.int64, "BYTE"),
@@ -1775,6 +1775,38 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase,
           var.handle, indices, dtype=dtype)
     self.assertAllEqual(expected, result)
 
+  @test_util.run_in_graph_and_eager_modes
+  def testGatherDeduplicateIndices(self):
+    var = resource_variable_ops.ResourceVariable(
+        [[0., 1.], [2., 3.], [4., 5.]], name="var0")
+    self.evaluate(var.initializer)
+    indices = constant_op.constant([[2, 0], [2, 2]])
+    with backprop.GradientTape() as tape:
+      tape.watch(var.handle)
+      result = resource_variable_ops.resource_gather(
+          var.handle, indices, dtype=dtypes.float32, deduplicate_indices=True)
+      loss = math_ops.reduce_sum(result * [1., 10.])
+    self.assertAllEqual([[[4., 5.], [0., 1.]], [[4., 5.], [4., 5.]]],
+                        self.evaluate(result))
+    grad = tape.gradient(loss, var.handle)
+    self.assertIsInstance(grad, indexed_slices.IndexedSlices)
+    # One slice per distinct index, in order of first occurrence.
+    self.assertAllEqual([2, 0], self.evaluate(grad.indices))
+    self.assertAllEqual([[3., 30.], [1., 10.]], self.evaluate(grad.values))
+
+  @test_util.run_in_graph_and_eager_modes
+  def testGatherDeduplicateIndicesOutOfRange(self):
+    with ops.device("/cpu:0"):
+      var = resource_variable_ops.ResourceVariable([1., 2.], name="var0")
+      self.evaluate(var.initializer)
+      with self.assertRaisesRegex(errors.InvalidArgumentError,
+                                  r"indices\[2\] = 5 is not in \[0, 2\)"):
+        self.evaluate(
+            resource_variable_ops.resource_gather(
+                var.handle, [1, 1, 5, 5],
+                dtype=dtypes.float32,
+                deduplicate_indices=True))
+
   @test_util.run_v2_only
   def testUninitializedVariableMemoryUsage(self):
     if test_util.is_gpu_available():
@@ -48,6 +48,7 @@ from tensorflow.python.framework import tensor_conversion_registry
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_array_ops
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gen_resource_variable_ops
 from tensorflow.python.ops import gen_state_ops
 from tensorflow.python.ops import handle_data_util
@@ -2540,6 +2541,12 @@ def _GatherGrad(op, grad):
   values_shape = array_ops.concat([size, params_shape[1:]], 0)
   values = array_ops.reshape(grad, values_shape)
   indices = array_ops.reshape(indices, size)
+  if op.get_attr("deduplicate_indices"):
+    # Aggregate the slices of repeated indices, so that the update touches
+    # each row once.
+    indices, positions = array_ops.unique(indices)
+    values = gen_math_ops.unsorted_segment_sum(
+        values, positions, array_ops.shape(indices)[0])
   return (indexed_slices.IndexedSlices(values, indices, params_shape), None)
 
 
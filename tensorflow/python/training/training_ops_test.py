@@ -506,6 +506,50 @@ class TrainingOpsTest(TensorFlowTestCase):
     thread1.join()
     thread2.join()
 
+  @test_util.run_v2_only
+  def testResourceSparseApplyAdagradWithRowLocking(self):
+    dtype = np.float32
+    x = np.arange(12).reshape(4, 3).astype(dtype)
+    y = np.ones((4, 3), dtype=dtype)
+    lr = np.array(0.1, dtype=dtype)
+    grad = np.array([[1, 2, 3], [4, 5, 6], [7, 8, 9]], dtype=dtype)
+    indices = np.array([0, 2, 0], dtype=np.int32)
+    num_threads = 4
+    num_iter = 50
+    with ops.device('/cpu:0'):
+      var = variables.Variable(x)
+      accum = variables.Variable(y)
+
+    @def_function.function
+    def apply_adagrad():
+      for _ in math_ops.range(num_iter):
+        gen_training_ops.resource_sparse_apply_adagrad(
+            var.handle, accum.handle, lr, grad, indices,
+            use_row_locking=True)
+
+    threads = [
+        threading.Thread(target=lambda: self.evaluate(apply_adagrad()))
+        for _ in range(num_threads)
+    ]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+
+    # The gradients of duplicate indices are summed, and all the updates of a
+    # row are the same, so their order doesn't matter.
+    summed_grad = np.zeros_like(x)
+    np.add.at(summed_grad, indices, grad)
+    expected_var = x.copy()
+    expected_accum = y.copy()
+    for _ in range(num_threads * num_iter):
+      for row in (0, 2):
+        expected_accum[row] += summed_grad[row] * summed_grad[row]
+        expected_var[row] -= (
+            lr * summed_grad[row] / np.sqrt(expected_accum[row]))
+    self.assertAllClose(expected_var, self.evaluate(var), rtol=1e-4)
+    self.assertAllClose(expected_accum, self.evaluate(accum), rtol=1e-4)
+
 
 if __name__ == '__main__':
   googletest.main()
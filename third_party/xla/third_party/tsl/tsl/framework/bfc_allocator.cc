@@ -505,6 +505,17 @@ int64_t BFCAllocator::LargestFreeChunk() {
   return 0;
 }
 
+std::string BFCAllocator::FreeBytesByBin() {
+  std::string result;
+  for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
+    const Bin* b = BinFromIndex(bin_num);
+    if (b->free_bytes == 0) continue;
+    strings::StrAppend(&result, result.empty() ? "" : ",", b->bin_size, ":",
+                       b->free_bytes);
+  }
+  return result;
+}
+
 double BFCAllocator::GetFragmentation() {
   int64_t bytes_available = *stats_.pool_bytes - stats_.bytes_in_use;
   DCHECK_GE(bytes_available, 0);
@@ -539,6 +550,8 @@ void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
                                {"bytes_allocated", stats_.bytes_in_use},
                                {"bytes_available", bytes_available},
                                {"fragmentation", GetFragmentation()},
+                               {"largest_free_chunk", LargestFreeChunk()},
+                               {"free_bytes_by_bin", FreeBytesByBin()},
                                {"peak_bytes_in_use", stats_.peak_bytes_in_use},
                                {"requested_bytes", req_bytes},
                                {"allocation_bytes", alloc_bytes},
@@ -772,6 +785,7 @@ void BFCAllocator::InsertFreeChunkIntoBin(BFCAllocator::ChunkHandle h) {
   Bin* new_bin = BinFromIndex(bin_num);
   c->bin_num = bin_num;
   new_bin->free_chunks.insert(h);
+  new_bin->free_bytes += c->size;
 }
 
 void BFCAllocator::RemoveFreeChunkIterFromBin(
@@ -781,6 +795,7 @@ void BFCAllocator::RemoveFreeChunkIterFromBin(
   Chunk* c = ChunkFromHandle(h);
   CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
   free_chunks->erase(citer);
+  BinFromIndex(c->bin_num)->free_bytes -= c->size;
   c->bin_num = kInvalidBinNum;
 }
 
@@ -789,6 +804,7 @@ void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
   CHECK_GT(BinFromIndex(c->bin_num)->free_chunks.erase(h), 0)
       << "Could not find chunk in bin";
+  BinFromIndex(c->bin_num)->free_bytes -= c->size;
   c->bin_num = kInvalidBinNum;
 }
 
@@ -1157,6 +1173,8 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
     const BinDebugInfo& bin_info = bin_infos[bin_num];
     DCHECK_EQ(b->free_chunks.size(),
               bin_info.total_chunks_in_bin - bin_info.total_chunks_in_use);
+    DCHECK_EQ(b->free_bytes,
+              bin_info.total_bytes_in_bin - bin_info.total_bytes_in_use);
     tensorflow::BinSummary* bs = md.add_bin_summary();
     bs->set_bin(bin_num);
     bs->set_total_bytes_in_use(bin_info.total_bytes_in_use);
@@ -1207,7 +1225,9 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  stats.largest_free_block_bytes = LargestFreeChunk();
+  return stats;
 }
 
 bool BFCAllocator::ClearStats() {
@@ -141,6 +141,10 @@ class BFCAllocator : public Allocator {
   // The free chunks are sorted by size (and then address) in a bin.
   int64_t LargestFreeChunk() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns the free bytes of each non-empty bin as "bin_size:free_bytes"
+  // pairs separated by commas, a histogram of the free memory by chunk size.
+  std::string FreeBytesByBin() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Add TraceMe (in memory allocation and deallocation) for memory stats
   // profiling. The chunk_ptr is passed to get information such as address,
   // chunk size and requested_size.
@@ -270,6 +274,8 @@ class BFCAllocator : public Allocator {
     // List of free chunks within the bin, sorted by chunk size.
     // Chunk * not owned.
     FreeChunkSet free_chunks;
+    // The total size of the chunks in free_chunks.
+    size_t free_bytes = 0;
     Bin(BFCAllocator* allocator, size_t bs)
         : bin_size(bs), free_chunks(ChunkComparator(allocator)) {}
   };
@@ -94,6 +94,8 @@ class BufferedWritableFile : public WritableFile {
 
   Status Sync() override { return file_->Sync(); }
 
+  tsl::Status AvoidPageCache() override { return file_->AvoidPageCache(); }
+
   // For compatibilty with the TensorBundle writer, we expose CRC32 checksums.
   uint32_t crc32() const { return crc32_; }
   void reset_crc32() { crc32_ = 0; }
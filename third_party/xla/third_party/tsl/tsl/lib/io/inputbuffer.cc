@@ -42,6 +42,10 @@ Status InputBuffer::FillBuffer() {
   pos_ = buf_;
   limit_ = pos_ + data.size();
   file_pos_ += data.size();
+  if (s.ok()) {
+    // Let the file start reading the next buffer in the background.
+    file_->Prefetch(file_pos_, size_).IgnoreError();
+  }
   return s;
 }
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tsl/lib/io/inputbuffer.h"
 
+#include <utility>
 #include <vector>
 
 #include "tsl/lib/core/status_test_util.h"
@@ -30,6 +31,36 @@ limitations under the License.
 namespace tsl {
 namespace {
 
+// A file of `contents` recording the ranges it was asked to prefetch.
+class PrefetchRecordingFile : public RandomAccessFile {
+ public:
+  explicit PrefetchRecordingFile(string contents)
+      : contents_(std::move(contents)) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    if (offset >= contents_.size()) {
+      *result = StringPiece();
+      return errors::OutOfRange("EOF");
+    }
+    *result = StringPiece(contents_).substr(offset, n);
+    return result->size() < n ? errors::OutOfRange("EOF") : OkStatus();
+  }
+
+  Status Prefetch(uint64 offset, size_t n) const override {
+    prefetches_.emplace_back(offset, n);
+    return OkStatus();
+  }
+
+  const std::vector<std::pair<uint64, size_t>>& prefetches() const {
+    return prefetches_;
+  }
+
+ private:
+  const string contents_;
+  mutable std::vector<std::pair<uint64, size_t>> prefetches_;
+};
+
 static std::vector<int> BufferSizes() {
   return {1,  2,  3,  4,  5,  6,  7,  8,  9,  10,   11,
           12, 13, 14, 15, 16, 17, 18, 19, 20, 65536};
@@ -378,6 +409,21 @@ TEST(InputBuffer, ReadVarint64) {
   }
 }
 
+TEST(InputBuffer, PrefetchesNextBuffer) {
+  PrefetchRecordingFile file("0123456789");
+  io::InputBuffer in(&file, 4);
+  string read;
+  TF_ASSERT_OK(in.ReadNBytes(6, &read));
+  EXPECT_EQ(read, "012345");
+  // Each full buffer asks the file for the one after it.
+  EXPECT_EQ(file.prefetches(),
+            (std::vector<std::pair<uint64, size_t>>{{4, 4}, {8, 4}}));
+  // The last buffer reaches the end of the file.
+  TF_ASSERT_OK(in.ReadNBytes(4, &read));
+  EXPECT_EQ(read, "6789");
+  EXPECT_EQ(file.prefetches().size(), 2);
+}
+
 TEST(InputBuffer, Hint) {
   Env* env = Env::Default();
   string fname;
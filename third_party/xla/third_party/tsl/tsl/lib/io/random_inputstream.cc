@@ -19,6 +19,13 @@ limitations under the License.
 
 namespace tsl {
 namespace io {
+namespace {
+
+// Reads of at least this many bytes are taken to come from a buffered reader
+// going through the file, which will read as many bytes next.
+constexpr int64_t kMinPrefetchBytes = 64 * 1024;
+
+}  // namespace
 
 RandomAccessInputStream::RandomAccessInputStream(RandomAccessFile* file,
                                                  bool owns_file)
@@ -47,6 +54,9 @@ Status RandomAccessInputStream::ReadNBytes(int64_t bytes_to_read,
   if (s.ok() || errors::IsOutOfRange(s)) {
     pos_ += data.size();
   }
+  if (s.ok() && bytes_to_read >= kMinPrefetchBytes) {
+    file_->Prefetch(pos_, bytes_to_read).IgnoreError();
+  }
   return s;
 }
 
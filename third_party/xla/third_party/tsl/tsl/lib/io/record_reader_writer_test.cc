@@ -343,6 +343,49 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestParallelGzip) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_parallel_gzip_test";
+
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, string(i % 50, 'x')));
+  }
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions("GZIP");
+    options.compression_threads = 4;
+    // Records span several blocks.
+    options.compression_block_bytes = 100;
+    io::RecordWriter writer(file.get(), options);
+    for (int i = 0; i < records.size(); ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(records[i]));
+      // Flushing ends the current block early.
+      if (i == 500) TF_EXPECT_OK(writer.Flush());
+    }
+    TF_EXPECT_OK(writer.Close());
+    TF_EXPECT_OK(file->Close());
+  }
+
+  {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReader reader(
+        read_file.get(),
+        io::RecordReaderOptions::CreateRecordReaderOptions("GZIP"));
+    uint64 offset = 0;
+    tstring record;
+    for (const string& expected : records) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(expected, record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+  }
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
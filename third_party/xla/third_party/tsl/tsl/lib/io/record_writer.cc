@@ -65,7 +65,13 @@ RecordWriter::RecordWriter(WritableFile* dest,
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (IsZlibCompressed(options)) {
+  if (IsZlibCompressed(options) && options.compression_threads > 1 &&
+      options.zlib_options.window_bits > MAX_WBITS) {
+    dest_ = new ParallelZlibOutputBuffer(dest, options.compression_threads,
+                                         options.compression_block_bytes,
+                                         options.zlib_options);
+  } else if (IsZlibCompressed(options)) {
+    // ZLIB output is a single stream, so is always compressed sequentially.
     ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
         dest, options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options);
@@ -52,6 +52,11 @@ struct RecordWriterOptions {
   // Options specific to compression.
   io::ZlibCompressionOptions zlib_options;
   io::SnappyCompressionOptions snappy_options;
+
+  // With more than one thread, GZIP output is compressed in parallel, in
+  // blocks of `compression_block_bytes` (see ParallelZlibOutputBuffer).
+  int compression_threads = 1;
+  size_t compression_block_bytes = 1 << 20;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tsl/lib/io/zlib_outputbuffer.h"
 
+#include <algorithm>
+#include <memory>
+#include <string>
+
 #include "tsl/platform/errors.h"
 
 namespace tsl {
@@ -242,5 +246,171 @@ Status ZlibOutputBuffer::Tell(int64_t* position) {
   return file_->Tell(position);
 }
 
+ParallelZlibOutputBuffer::ParallelZlibOutputBuffer(
+    WritableFile* file, int num_threads, size_t block_bytes,
+    const ZlibCompressionOptions& zlib_options)
+    : file_(file),
+      block_bytes_(block_bytes),
+      // Enough blocks for the threads to keep compressing while the first one
+      // is written.
+      max_pending_blocks_(2 * num_threads),
+      zlib_options_(zlib_options),
+      thread_pool_(new thread::ThreadPool(Env::Default(), "zlib_compression",
+                                          num_threads)) {
+  DCHECK_GT(block_bytes_, 0);
+  DCHECK_GT(zlib_options_.window_bits, MAX_WBITS)
+      << "Only GZIP output can be compressed in parallel";
+}
+
+ParallelZlibOutputBuffer::~ParallelZlibOutputBuffer() {
+  if (!closed_) {
+    LOG(WARNING)
+        << "ParallelZlibOutputBuffer::Close() not called. Possible data loss";
+  }
+  // Waits for the blocks being compressed.
+  thread_pool_.reset();
+}
+
+Status ParallelZlibOutputBuffer::Append(StringPiece data) {
+  if (closed_) {
+    return errors::FailedPrecondition("Append after Close");
+  }
+  while (!data.empty()) {
+    const size_t n = std::min(block_bytes_ - input_.size(), data.size());
+    input_.append(data.data(), n);
+    data.remove_prefix(n);
+    if (input_.size() == block_bytes_) {
+      TF_RETURN_IF_ERROR(CompressInput());
+    }
+  }
+  return OkStatus();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ParallelZlibOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return OkStatus();
+}
+#endif
+
+Status ParallelZlibOutputBuffer::CompressInput() {
+  auto block = std::make_unique<Block>();
+  block->input.swap(input_);
+  started_block_ = true;
+  Block* block_ptr = block.get();
+  size_t num_pending;
+  {
+    mutex_lock l(mu_);
+    pending_.push_back(std::move(block));
+    num_pending = pending_.size();
+  }
+  thread_pool_->Schedule([this, block_ptr]() {
+    Compress(block_ptr);
+    mutex_lock l(mu_);
+    block_ptr->done = true;
+    block_done_.notify_all();
+  });
+  if (num_pending > max_pending_blocks_) {
+    return WriteFirstBlock();
+  }
+  return OkStatus();
+}
+
+void ParallelZlibOutputBuffer::Compress(Block* block) const {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  int error =
+      deflateInit2(&stream, zlib_options_.compression_level,
+                   zlib_options_.compression_method, zlib_options_.window_bits,
+                   zlib_options_.mem_level, zlib_options_.compression_strategy);
+  if (error != Z_OK) {
+    block->status =
+        errors::InvalidArgument("deflateInit failed with status", error);
+    return;
+  }
+  block->output.resize(deflateBound(&stream, block->input.size()));
+  stream.next_in = reinterpret_cast<Bytef*>(block->input.data());
+  stream.avail_in = block->input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(block->output.data());
+  stream.avail_out = block->output.size();
+  // The output fits in the bound, so a single call compresses the block.
+  error = deflate(&stream, Z_FINISH);
+  if (error == Z_STREAM_END) {
+    block->output.resize(stream.total_out);
+  } else {
+    string error_string =
+        strings::StrCat("deflate() failed with error ", error);
+    if (stream.msg != nullptr) {
+      strings::StrAppend(&error_string, ": ", stream.msg);
+    }
+    block->status = errors::DataLoss(error_string);
+  }
+  deflateEnd(&stream);
+  // Releases the input while the block waits to be written.
+  std::string().swap(block->input);
+}
+
+Status ParallelZlibOutputBuffer::WriteFirstBlock() {
+  std::unique_ptr<Block> block;
+  {
+    mutex_lock l(mu_);
+    while (!pending_.front()->done) {
+      block_done_.wait(l);
+    }
+    block = std::move(pending_.front());
+    pending_.pop_front();
+  }
+  TF_RETURN_IF_ERROR(block->status);
+  return file_->Append(block->output);
+}
+
+Status ParallelZlibOutputBuffer::WriteAll() {
+  if (!input_.empty()) {
+    TF_RETURN_IF_ERROR(CompressInput());
+  }
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (pending_.empty()) break;
+    }
+    TF_RETURN_IF_ERROR(WriteFirstBlock());
+  }
+  return OkStatus();
+}
+
+Status ParallelZlibOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition("Flush after Close");
+  }
+  TF_RETURN_IF_ERROR(WriteAll());
+  return file_->Flush();
+}
+
+Status ParallelZlibOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ParallelZlibOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ParallelZlibOutputBuffer::Close() {
+  if (closed_) return OkStatus();
+  if (!started_block_ && input_.empty()) {
+    // Writes an empty gzip member.
+    TF_RETURN_IF_ERROR(CompressInput());
+  }
+  TF_RETURN_IF_ERROR(WriteAll());
+  closed_ = true;
+  return OkStatus();
+}
+
+Status ParallelZlibOutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
 }  // namespace io
 }  // namespace tsl
@@ -18,14 +18,19 @@ limitations under the License.
 
 #include <zlib.h>
 
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "tsl/lib/io/zlib_compression_options.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/file_system.h"
 #include "tsl/platform/macros.h"
+#include "tsl/platform/mutex.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/stringpiece.h"
+#include "tsl/platform/thread_annotations.h"
+#include "tsl/platform/threadpool.h"
 #include "tsl/platform/types.h"
 
 namespace tsl {
@@ -153,6 +158,91 @@ class ZlibOutputBuffer : public WritableFile {
   void operator=(const ZlibOutputBuffer&) = delete;
 };
 
+// Writes GZIP output like ZlibOutputBuffer, but compresses the data on
+// `num_threads` threads. The input is cut into blocks of `block_bytes` that are
+// each compressed into a separate gzip member, and the members are written to
+// the file in order. GZIP readers, including ZlibInputStream, read the
+// concatenated members as a single stream.
+//
+// `zlib_options` must have GZIP window bits. Flush() and Sync() end the current
+// block, so flushing often makes the output larger.
+//
+// A given instance of a ParallelZlibOutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class ParallelZlibOutputBuffer : public WritableFile {
+ public:
+  // Does not take ownership of `file`.
+  ParallelZlibOutputBuffer(WritableFile* file, int num_threads,
+                           size_t block_bytes,
+                           const ZlibCompressionOptions& zlib_options);
+
+  ~ParallelZlibOutputBuffer() override;
+
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses any cached input and writes all output to file.
+  Status Flush() override;
+
+  // Like `Flush()`, but does not flush the file. After calling this, any
+  // further calls to `Append()` or `Flush()` will fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Compresses any cached input, writes all output to file and syncs it.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  Status Tell(int64_t* position) override;
+
+ private:
+  struct Block {
+    std::string input;
+    std::string output;
+    Status status;
+    bool done = false;
+  };
+
+  // Starts compressing `input_` as a block, and writes the blocks compressed
+  // before it if too many are in flight.
+  Status CompressInput();
+
+  // Compresses `block->input` into `block->output` as a gzip member.
+  void Compress(Block* block) const;
+
+  // Waits for the first pending block to be compressed and writes it to file.
+  Status WriteFirstBlock();
+
+  // Compresses `input_` and writes all the pending blocks to file.
+  Status WriteAll();
+
+  WritableFile* file_;  // Not owned
+  const size_t block_bytes_;
+  const size_t max_pending_blocks_;
+  ZlibCompressionOptions const zlib_options_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  // The input not compressed yet.
+  std::string input_;
+  // True once a block was compressed, as an empty file is not valid GZIP.
+  bool started_block_ = false;
+  bool closed_ = false;
+
+  mutex mu_;
+  condition_variable block_done_;
+  // The blocks being compressed, in file order.
+  std::deque<std::unique_ptr<Block>> pending_ TF_GUARDED_BY(mu_);
+
+  ParallelZlibOutputBuffer(const ParallelZlibOutputBuffer&) = delete;
+  void operator=(const ParallelZlibOutputBuffer&) = delete;
+};
+
 }  // namespace io
 }  // namespace tsl
 
@@ -62,6 +62,10 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets the number of blocks fetched ahead of
+// sequential reads through the block cache, in parallel ranged reads. A value
+// of 0 (the default) means blocks are only fetched when read.
+constexpr char kReadaheadBlocks[] = "GCS_READ_CACHE_READAHEAD_BLOCKS";
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -415,6 +419,9 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The number of blocks the block cache fetches ahead of sequential reads.
+  size_t readahead_blocks_ = 0;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
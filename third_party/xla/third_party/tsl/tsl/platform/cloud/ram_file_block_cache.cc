@@ -16,12 +16,20 @@ limitations under the License.
 #include "tsl/platform/cloud/ram_file_block_cache.h"
 
 #include <cstring>
+#include <iterator>
 #include <memory>
 
 #include "absl/cleanup/cleanup.h"
 #include "tsl/platform/env.h"
 
 namespace tsl {
+namespace {
+
+// The number of files whose last read offset is kept for readahead. Past it,
+// the offsets are forgotten, which only costs a missed readahead.
+constexpr size_t kMaxReadaheadFiles = 1024;
+
+}  // namespace
 
 bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
   mutex_lock l(block->mu);
@@ -41,13 +49,18 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
       if (cache_stats_ != nullptr) {
         cache_stats_->RecordCacheHitBlockSize(entry->second->data.size());
       }
+      entry->second->prefetched = false;
       return entry->second;
     } else {
       // Remove the stale block and continue.
       RemoveFile_Locked(key.first);
     }
   }
+  return InsertBlock_Locked(key);
+}
 
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::InsertBlock_Locked(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -60,6 +73,39 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
   return new_entry;
 }
 
+void RamFileBlockCache::Prefetch(const string& filename, size_t offset,
+                                 size_t n, size_t start, size_t finish) {
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> blocks;
+  {
+    mutex_lock lock(mu_);
+    auto it = next_read_offsets_.find(filename);
+    if (it != next_read_offsets_.end() && it->second == offset) {
+      finish += readahead_blocks_ * block_size_;
+    }
+    if (it == next_read_offsets_.end() &&
+        next_read_offsets_.size() >= kMaxReadaheadFiles) {
+      next_read_offsets_.clear();
+    }
+    next_read_offsets_[filename] = offset + n;
+    // The reader fetches the first block itself.
+    for (size_t pos = start + block_size_; pos < finish; pos += block_size_) {
+      Key key = std::make_pair(filename, pos);
+      if (block_map_.find(key) != block_map_.end()) continue;
+      std::shared_ptr<Block> block = InsertBlock_Locked(key);
+      block->prefetched = true;
+      blocks.emplace_back(std::move(key), std::move(block));
+    }
+  }
+  for (auto& [key, block] : blocks) {
+    readahead_pool_->Schedule([this, key = std::move(key),
+                               block = std::move(block)]() {
+      if (MaybeFetch(key, block).ok()) {
+        UpdateLRU(key, block).IgnoreError();
+      }
+    });
+  }
+}
+
 // Remove blocks from the cache until we do not exceed our maximum size.
 void RamFileBlockCache::Trim() {
   while (!lru_list_.empty() && cache_size_ > max_bytes_) {
@@ -88,6 +134,12 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
     auto fcmp = block_map_.upper_bound(fmax);
+    // The blocks fetched ahead of a partial block are past the end of the
+    // file.
+    while (fcmp != block_map_.begin() && key < std::prev(fcmp)->first &&
+           std::prev(fcmp)->second->prefetched) {
+      RemoveBlock(std::prev(fcmp));
+    }
     if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
       return errors::Internal("Block cache contents are inconsistent.");
     }
@@ -184,6 +236,9 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (readahead_pool_ != nullptr) {
+    Prefetch(filename, offset, n, start, finish);
+  }
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -270,9 +325,15 @@ void RamFileBlockCache::Prune() {
 
 void RamFileBlockCache::Flush() {
   mutex_lock lock(mu_);
+  // Like RemoveBlock, keep the blocks still being fetched from being
+  // reinserted.
+  for (auto& [key, block] : block_map_) {
+    block->timestamp = 0;
+  }
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  next_read_offsets_.clear();
   cache_size_ = 0;
 }
 
@@ -282,6 +343,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  next_read_offsets_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tsl/platform/status.h"
 #include "tsl/platform/stringpiece.h"
 #include "tsl/platform/thread_annotations.h"
+#include "tsl/platform/threadpool.h"
 #include "tsl/platform/types.h"
 
 namespace tsl {
@@ -50,22 +51,34 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// If `readahead_blocks` is positive, the blocks of a read past its first
+  /// one are fetched in parallel, and a read that starts where the previous
+  /// read of the same file ended also fetches the next `readahead_blocks`
+  /// blocks in the background.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t readahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        readahead_blocks_(readahead_blocks) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (readahead_blocks_ > 0 && IsCacheEnabled()) {
+      readahead_pool_ = std::make_unique<thread::ThreadPool>(
+          env_, "TF_readahead_FBC", readahead_blocks_);
+    }
     VLOG(1) << "GCS file block cache is "
             << (IsCacheEnabled() ? "enabled" : "disabled");
   }
 
   ~RamFileBlockCache() override {
+    // Destroying readahead_pool_ waits for the fetches it runs.
+    readahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -131,6 +144,8 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The number of blocks fetched ahead of sequential reads.
+  const size_t readahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -175,6 +190,9 @@ class RamFileBlockCache : public FileBlockCache {
     std::list<Key>::iterator lra_iterator;
     /// The timestamp (seconds since epoch) at which the block was cached.
     uint64 timestamp;
+    /// True if the block was inserted to be fetched ahead of a read, until a
+    /// read looks it up. Guarded by the block-cache-wide mu_.
+    bool prefetched = false;
     /// Mutex to guard state variable
     mutex mu;
     /// The state of the block.
@@ -197,6 +215,16 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
 
+  /// Insert a new empty block for `key`.
+  std::shared_ptr<Block> InsertBlock_Locked(const Key& key)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Fetch, in readahead_pool_, the blocks in [start + block_size_, finish)
+  /// that a read of `n` bytes at `offset` of `filename` needs, and the next
+  /// readahead_blocks_ ones if the read continues the previous one.
+  void Prefetch(const string& filename, size_t offset, size_t n, size_t start,
+                size_t finish) TF_LOCKS_EXCLUDED(mu_);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       TF_LOCKS_EXCLUDED(mu_);
 
@@ -243,6 +271,12 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64_t> file_signature_map_ TF_GUARDED_BY(mu_);
+
+  /// A filename->offset map of where the last read of each file ended.
+  std::map<string, size_t> next_read_offsets_ TF_GUARDED_BY(mu_);
+
+  /// The threads fetching the blocks of Prefetch, if readahead is enabled.
+  std::unique_ptr<thread::ThreadPool> readahead_pool_;
 };
 
 }  // namespace tsl
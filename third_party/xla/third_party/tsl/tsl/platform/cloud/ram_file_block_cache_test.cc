@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "tsl/platform/cloud/ram_file_block_cache.h"
 
+#include <algorithm>
 #include <cstring>
+#include <map>
 
 #include "tsl/lib/core/status_test_util.h"
 #include "tsl/platform/blocking_counter.h"
 #include "tsl/platform/cloud/now_seconds_env.h"
 #include "tsl/platform/env.h"
+#include "tsl/platform/mutex.h"
 #include "tsl/platform/notification.h"
 #include "tsl/platform/test.h"
 
@@ -547,6 +550,86 @@ TEST(RamFileBlockCacheTest, CoalesceConcurrentReads) {
   EXPECT_EQ(1, num_requests);
 }
 
+TEST(RamFileBlockCacheTest, ParallelRangedReads) {
+  // The blocks of a single read are fetched concurrently, in one call of the
+  // fetcher each.
+  const int num_blocks = 4;
+  BlockingCounter counter(num_blocks);
+  auto fetcher = [&counter](const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+    counter.DecrementCount();
+    if (!counter.WaitFor(std::chrono::seconds(10))) {
+      return errors::FailedPrecondition("desired concurrency not reached");
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return OkStatus();
+  };
+  const size_t block_size = 16;
+  RamFileBlockCache cache(block_size, num_blocks * block_size, 0, fetcher,
+                          Env::Default(), /*readahead_blocks=*/num_blocks);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, num_blocks * block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(num_blocks * block_size, 'x'));
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadOfSequentialReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::map<size_t, int> fetches;
+  Notification third_block_fetched;
+  auto fetcher = [&](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      ++fetches[offset];
+    }
+    if (offset == 2 * block_size) third_block_fetched.Notify();
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return OkStatus();
+  };
+  RamFileBlockCache cache(block_size, 8 * block_size, 0, fetcher,
+                          Env::Default(), /*readahead_blocks=*/2);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  // The second read continues the first one, so the two blocks after it are
+  // fetched in the background.
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  EXPECT_TRUE(WaitForNotificationWithTimeout(&third_block_fetched,
+                                             10 * 1000 * 1000));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 2 * block_size, block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(block_size, 'x'));
+  mutex_lock l(mu);
+  EXPECT_EQ(fetches[2 * block_size], 1);
+}
+
+TEST(RamFileBlockCacheTest, ReadaheadPastEndOfFile) {
+  // Tests sequential reads of a 24-byte file with block size 16.
+  const size_t block_size = 16;
+  const size_t file_size = 24;
+  auto fetcher = [&](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    size_t bytes_to_copy = offset < file_size ? std::min(n, file_size - offset)
+                                              : 0;
+    memset(buffer, 'x', bytes_to_copy);
+    *bytes_transferred = bytes_to_copy;
+    return OkStatus();
+  };
+  RamFileBlockCache cache(block_size, 8 * block_size, 0, fetcher,
+                          Env::Default(), /*readahead_blocks=*/4);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  // The blocks read ahead past the end of the file don't make the partial
+  // block look inconsistent.
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  EXPECT_EQ(out.size(), file_size - block_size);
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, 2 * block_size, &out));
+  EXPECT_EQ(out.size(), file_size);
+  Status status = ReadCache(&cache, "a", 3 * block_size, block_size, &out);
+  EXPECT_EQ(status.code(), error::OUT_OF_RANGE);
+}
+
 TEST(RamFileBlockCacheTest, Flush) {
   int calls = 0;
   auto fetcher = [&calls](const string& filename, size_t offset, size_t n,
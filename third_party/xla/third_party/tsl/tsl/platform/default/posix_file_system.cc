@@ -18,6 +18,8 @@ limitations under the License.
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 
 #if defined(__linux__)
@@ -45,6 +47,23 @@ using ::tsl::errors::IOError;
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+#if defined(__linux__)
+// The amount of data written back at once by the files that avoid the page
+// cache.
+constexpr int64_t kPosixWritebackChunkSize = 8 * 1024 * 1024;
+
+// Returns true if the files hinted with AvoidPageCache() evict their pages,
+// as set by the TF_POSIX_AVOID_PAGE_CACHE environment variable.
+bool AvoidPageCacheEnabled() {
+  static const bool enabled = [] {
+    const char* value = getenv("TF_POSIX_AVOID_PAGE_CACHE");
+    return value != nullptr &&
+           (strcmp(value, "1") == 0 || strcmp(value, "true") == 0);
+  }();
+  return enabled;
+}
+#endif
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -97,6 +116,18 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  absl::Status Prefetch(uint64 offset, size_t n) const override {
+#if defined(__linux__)
+    // The kernel queues the reads of the range without waiting for them.
+    int err = posix_fadvise(fd_, static_cast<off_t>(offset),
+                            static_cast<off_t>(n), POSIX_FADV_WILLNEED);
+    if (err != 0) {
+      return IOError(filename_, err);
+    }
+#endif
+    return absl::OkStatus();
+  }
+
 #if defined(TF_CORD_SUPPORT)
   absl::Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {
@@ -147,7 +178,7 @@ class PosixWritableFile : public WritableFile {
     if (r != data.size()) {
       return IOError(filename_, errno);
     }
-    return absl::OkStatus();
+    return MaybeWriteBack(data.size());
   }
 
 #if defined(TF_CORD_SUPPORT)
@@ -159,7 +190,7 @@ class PosixWritableFile : public WritableFile {
         return IOError(filename_, errno);
       }
     }
-    return absl::OkStatus();
+    return MaybeWriteBack(cord.size());
   }
 #endif
 
@@ -168,6 +199,10 @@ class PosixWritableFile : public WritableFile {
       return IOError(filename_, EBADF);
     }
     absl::Status result;
+    if (avoid_page_cache_) {
+      // The pages still cached are dropped once written back.
+      result = DropWrittenPages(written_end_);
+    }
     if (fclose(file_) != 0) {
       result = IOError(filename_, errno);
     }
@@ -205,6 +240,81 @@ class PosixWritableFile : public WritableFile {
 
     return s;
   }
+
+  absl::Status AvoidPageCache() override {
+#if defined(__linux__)
+    if (!AvoidPageCacheEnabled() || avoid_page_cache_) {
+      return absl::OkStatus();
+    }
+    int64_t position;
+    TF_RETURN_IF_ERROR(Tell(&position));
+    avoid_page_cache_ = true;
+    dropped_end_ = position;
+    writeback_begin_ = position;
+    written_end_ = position;
+#endif
+    return absl::OkStatus();
+  }
+
+ private:
+  // Once a chunk of data was appended since the last writeback, starts writing
+  // it back and drops the chunk written back before from the page cache.
+  // Waiting for one chunk while the next one is being written keeps the disk
+  // busy without letting the dirty pages pile up.
+  absl::Status MaybeWriteBack(size_t bytes_appended) {
+    if (!avoid_page_cache_) {
+      return absl::OkStatus();
+    }
+    written_end_ += bytes_appended;
+#if defined(__linux__)
+    if (written_end_ - writeback_begin_ < kPosixWritebackChunkSize) {
+      return absl::OkStatus();
+    }
+    TF_RETURN_IF_ERROR(DropWrittenPages(writeback_begin_));
+    if (sync_file_range(fileno(file_), writeback_begin_,
+                        written_end_ - writeback_begin_,
+                        SYNC_FILE_RANGE_WRITE) != 0) {
+      return IOError(filename_, errno);
+    }
+    writeback_begin_ = written_end_;
+#endif
+    return absl::OkStatus();
+  }
+
+  // Waits for the data before `end` to be written back and drops it from the
+  // page cache.
+  absl::Status DropWrittenPages(int64_t end) {
+#if defined(__linux__)
+    if (fflush(file_) != 0) {
+      return IOError(filename_, errno);
+    }
+    if (end <= dropped_end_) {
+      return absl::OkStatus();
+    }
+    const int fd = fileno(file_);
+    if (sync_file_range(fd, dropped_end_, end - dropped_end_,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                            SYNC_FILE_RANGE_WAIT_AFTER) != 0) {
+      return IOError(filename_, errno);
+    }
+    int err = posix_fadvise(fd, dropped_end_, end - dropped_end_,
+                            POSIX_FADV_DONTNEED);
+    if (err != 0) {
+      return IOError(filename_, err);
+    }
+    dropped_end_ = end;
+#endif
+    return absl::OkStatus();
+  }
+
+  // True once AvoidPageCache() took effect.
+  bool avoid_page_cache_ = false;
+  // The file offsets up to which the appended data was dropped from the page
+  // cache, from which it wasn't written back yet, and up to which it was
+  // appended.
+  int64_t dropped_end_ = 0;
+  int64_t writeback_begin_ = 0;
+  int64_t written_end_ = 0;
 };
 
 class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
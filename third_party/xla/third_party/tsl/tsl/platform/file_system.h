@@ -771,6 +771,17 @@ class RandomAccessFile {
   virtual tsl::Status Read(uint64 offset, size_t n, StringPiece* result,
                            char* scratch) const = 0;
 
+  /// \brief Hints that `n` bytes starting at `offset` will be read soon.
+  ///
+  /// Filesystems may start reading them in the background, so that the next
+  /// reads of sequential readers find them in memory. This is an optional
+  /// operation, which does nothing by default.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual tsl::Status Prefetch(uint64 offset, size_t n) const {
+    return tsl::OkStatus();
+  }
+
 #if defined(TF_CORD_SUPPORT)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
   virtual tsl::Status Read(uint64 offset, size_t n, absl::Cord* cord) const {
@@ -854,6 +865,13 @@ class WritableFile {
     return errors::Unimplemented("This filesystem does not support Tell()");
   }
 
+  /// \brief Hints that the data appended from now on won't be read back soon.
+  ///
+  /// Filesystems may then keep it out of the page cache, e.g. for large
+  /// checkpoints and snapshots that would otherwise evict the data being
+  /// read. This is an optional operation, which does nothing by default.
+  virtual tsl::Status AvoidPageCache() { return tsl::OkStatus(); }
+
  private:
   WritableFile(const WritableFile&) = delete;
   void operator=(const WritableFile&) = delete;
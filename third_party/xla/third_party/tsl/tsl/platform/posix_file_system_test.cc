@@ -0,0 +1,110 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/test.h"
+
+namespace tsl {
+namespace {
+
+// Returns `size` bytes of a pattern that differs between 8MB chunks, so that
+// pages written back to the wrong offsets would be noticed.
+std::string MakeData(size_t size, size_t offset) {
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    const size_t pos = offset + i;
+    data[i] = static_cast<char>((pos * 31 + (pos >> 23)) & 0xff);
+  }
+  return data;
+}
+
+class PosixFileSystemTest : public ::testing::Test {
+ protected:
+  PosixFileSystemTest() {
+    // Read once, by the first file that is hinted.
+    setenv("TF_POSIX_AVOID_PAGE_CACHE", "1", /*overwrite=*/1);
+    env_ = Env::Default();
+    EXPECT_TRUE(env_->LocalTempFilename(&filename_));
+  }
+
+  ~PosixFileSystemTest() override {
+    env_->DeleteFile(filename_).IgnoreError();
+  }
+
+  // Appends the data from `*offset` up to `end` to `file` in unaligned
+  // pieces.
+  void AppendUpTo(WritableFile* file, size_t end, size_t* offset) {
+    size_t piece = 4093;
+    while (*offset < end) {
+      const size_t size = std::min(piece, end - *offset);
+      TF_ASSERT_OK(file->Append(MakeData(size, *offset)));
+      *offset += size;
+      piece = piece * 3 + 1;
+    }
+  }
+
+  void ExpectFileContents(size_t size) {
+    std::string contents;
+    TF_ASSERT_OK(ReadFileToString(env_, filename_, &contents));
+    ASSERT_EQ(contents.size(), size);
+    EXPECT_TRUE(contents == MakeData(size, 0));
+  }
+
+  Env* env_;
+  std::string filename_;
+};
+
+TEST_F(PosixFileSystemTest, WritesFileAvoidingPageCache) {
+  constexpr size_t kSize = 20 * 1024 * 1024 + 12345;
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(env_->NewWritableFile(filename_, &file));
+  TF_ASSERT_OK(file->AvoidPageCache());
+  size_t offset = 0;
+  AppendUpTo(file.get(), kSize, &offset);
+  TF_ASSERT_OK(file->Close());
+  ExpectFileContents(kSize);
+}
+
+TEST_F(PosixFileSystemTest, AppendsToFileAvoidingPageCache) {
+  constexpr size_t kInitialSize = 3 * 1024 * 1024 + 777;
+  constexpr size_t kSize = kInitialSize + 17 * 1024 * 1024 + 4321;
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(env_->NewWritableFile(filename_, &file));
+  size_t offset = 0;
+  AppendUpTo(file.get(), kInitialSize, &offset);
+  TF_ASSERT_OK(file->Close());
+
+  // The data is written back from the end of the existing file.
+  TF_ASSERT_OK(env_->NewAppendableFile(filename_, &file));
+  TF_ASSERT_OK(file->AvoidPageCache());
+  int64_t position;
+  TF_ASSERT_OK(file->Tell(&position));
+  EXPECT_EQ(position, static_cast<int64_t>(kInitialSize));
+  AppendUpTo(file.get(), kSize, &offset);
+  TF_ASSERT_OK(file->Close());
+  ExpectFileContents(kSize);
+}
+
+}  // namespace
+}  // namespace tsl